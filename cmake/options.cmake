@@ -17,4 +17,7 @@
 
 option(WITH_WARNINGS         "Show all warnings during compile"                           0)
 option(WITH_CORE_DEBUG       "Include additional debug-code in core"                      1)
-option(WITH_HEADLESS_DEBUG   "Include Headless Players"                     		      1)
\ No newline at end of file
+option(WITH_HEADLESS_DEBUG   "Build headless client load generator (with WITH_TOOLS)"      1)
+option(WITH_IO_URING         "Use io_uring for socket reads and writes (Linux only)"       0)
+option(WITH_TOOLS            "Build tools such as the binary log decoder"                  1)
+option(WITH_PROFILER         "Include profile zones which can be dumped as Chrome/Perfetto traces" 0)
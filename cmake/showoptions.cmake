@@ -33,8 +33,32 @@ else()
 endif()
 
 if( WITH_HEADLESS_DEBUG )
-  message("* Enable Headless Players       : Yes")
+  message("* Build headless load generator : Yes (default)")
   add_definitions(-DHEADLESS_DEBUG)
 else()
-  message("* Enable Headless Players      : No  (default)")
-endif()
\ No newline at end of file
+  message("* Build headless load generator : No")
+endif()
+
+if( WITH_IO_URING )
+  if( CMAKE_SYSTEM_NAME STREQUAL "Linux" )
+    message("* Use io_uring socket backend  : Yes")
+    add_definitions(-DSTEERSTONE_IO_URING)
+  else()
+    message("* Use io_uring socket backend  : No  (Linux only)")
+  endif()
+else()
+  message("* Use io_uring socket backend  : No  (default)")
+endif()
+
+if( WITH_PROFILER )
+  message("* Include profile zones        : Yes")
+  add_definitions(-DSTEERSTONE_PROFILER)
+else()
+  message("* Include profile zones        : No  (default)")
+endif()
+
+if( WITH_TOOLS )
+  message("* Build tools                  : Yes (default)")
+else()
+  message("* Build tools                  : No")
+endif()
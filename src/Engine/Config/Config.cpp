@@ -30,6 +30,7 @@ namespace SteerStone { namespace Core { namespace Configuration {
     //////////////////////////////////////////////////////////////////////////
 
     Base::Base()
+        : m_Generation(0)
     {
     }
     Base::~Base()
@@ -52,13 +53,11 @@ namespace SteerStone { namespace Core { namespace Configuration {
     {
         return m_FileName;
     }
-    /// Reload File
+    /// Reload File, readers keep using the previous entries until the new ones are published
     bool Base::Reload()
     {
-        Utils::ObjectWriteGuard<Base> l_Guard(this);
-
-        /// Reset
-        m_Entries.clear();
+        /// Readers never take this, only concurrent reloads wait
+        std::lock_guard<std::mutex> l_Guard(m_ReloadMutex);
 
         std::ifstream l_Stream(m_FileName, std::ifstream::in);
         
@@ -68,7 +67,7 @@ namespace SteerStone { namespace Core { namespace Configuration {
             return false;
         }
 
-        ConfigMap l_NewEntries;
+        auto l_Snapshot = std::make_shared<ConfigSnapshot>();
 
         do
         {
@@ -93,10 +92,29 @@ namespace SteerStone { namespace Core { namespace Configuration {
             auto const l_Entry = boost::algorithm::trim_copy(boost::algorithm::to_lower_copy(l_Line.substr(0, l_Equals)));
             auto const l_Value = boost::algorithm::trim_copy_if(boost::algorithm::trim_copy(l_Line.substr(l_Equals + 1)), boost::algorithm::is_any_of("\""));
 
-            l_NewEntries[l_Entry] = l_Value;
+            /// Parse once here instead of on every read
+            ConfigValue l_Parsed;
+            l_Parsed.String = l_Value;
+
+            const std::string l_ValueLower = boost::algorithm::to_lower_copy(l_Value);
+            l_Parsed.Bool = l_ValueLower == "true" || l_ValueLower == "1" || l_ValueLower == "yes";
+
+            char* l_End = nullptr;
+            const long l_Int = strtol(l_Value.c_str(), &l_End, 10);
+            l_Parsed.IsInt  = l_End != l_Value.c_str();
+            l_Parsed.Int    = l_Parsed.IsInt ? static_cast<int32>(l_Int) : 0;
+
+            const float l_Float = strtof(l_Value.c_str(), &l_End);
+            l_Parsed.IsFloat    = l_End != l_Value.c_str();
+            l_Parsed.Float      = l_Parsed.IsFloat ? l_Float : 0.0f;
+
+            l_Snapshot->Entries[l_Entry] = std::move(l_Parsed);
         } while (l_Stream.good());
 
-        m_Entries = std::move(l_NewEntries);
+        l_Snapshot->Generation = m_Generation.load(std::memory_order_relaxed) + 1;
+
+        std::atomic_store_explicit(&m_Snapshot, std::shared_ptr<ConfigSnapshot const>(std::move(l_Snapshot)), std::memory_order_release);
+        m_Generation.fetch_add(1, std::memory_order_acq_rel);
 
         return true;
     }
@@ -104,10 +122,43 @@ namespace SteerStone { namespace Core { namespace Configuration {
     /// @p_File : File name
     bool Base::IsSet(std::string const& p_File)
     {
-        Utils::ObjectReadGuard<Base> l_Guard(this);
+        std::shared_ptr<ConfigSnapshot const> l_Snapshot;
+        return Find(p_File, l_Snapshot) != nullptr;
+    }
 
-        auto const l_NameLower = boost::algorithm::to_lower_copy(p_File);
-        return m_Entries.find(l_NameLower) != m_Entries.cend();
+    /// Get current entries, they never change once published
+    std::shared_ptr<ConfigSnapshot const> Base::GetSnapshot() const
+    {
+        return std::atomic_load_explicit(&m_Snapshot, std::memory_order_acquire);
+    }
+    /// Find an entry in a snapshot
+    /// @p_Snapshot : Snapshot
+    /// @p_Name     : Name of entry, any case
+    ConfigValue const* Base::Find(ConfigSnapshot const& p_Snapshot, std::string_view const p_Name)
+    {
+        ConfigMap::const_iterator l_Entry;
+
+        if (p_Name.size() <= CONFIG_MAX_KEY_LENGTH)
+        {
+            char l_NameLower[CONFIG_MAX_KEY_LENGTH];
+            for (std::size_t l_I = 0; l_I < p_Name.size(); l_I++)
+                l_NameLower[l_I] = static_cast<char>(::tolower(static_cast<unsigned char>(p_Name[l_I])));
+
+            l_Entry = p_Snapshot.Entries.find(std::string_view(l_NameLower, p_Name.size()));
+        }
+        else
+            l_Entry = p_Snapshot.Entries.find(boost::algorithm::to_lower_copy(std::string(p_Name)));
+
+        return l_Entry == p_Snapshot.Entries.cend() ? nullptr : &l_Entry->second;
+    }
+    /// Get entry of current snapshot
+    /// @p_Name : Name of entry
+    /// @p_Snapshot : Holds the snapshot the entry belongs to
+    ConfigValue const* Base::Find(std::string_view const p_Name, std::shared_ptr<ConfigSnapshot const>& p_Snapshot) const
+    {
+        p_Snapshot = GetSnapshot();
+
+        return p_Snapshot ? Find(*p_Snapshot, p_Name) : nullptr;
     }
 
     //////////////////////////////////////////////////////////////////////////
@@ -118,43 +169,40 @@ namespace SteerStone { namespace Core { namespace Configuration {
     /// @p_Default  :  Default value
     std::string Base::GetString(std::string const& p_Name, std::string const& p_Default /*= std::string()*/)
     {
-        Utils::ObjectReadGuard<Base> l_Guard(this);
-
-        auto const l_NameLower = boost::algorithm::to_lower_copy(p_Name);
+        std::shared_ptr<ConfigSnapshot const> l_Snapshot;
+        ConfigValue const* l_Entry = Find(p_Name, l_Snapshot);
 
-        auto const l_Entry = m_Entries.find(l_NameLower);
-
-        return l_Entry == m_Entries.cend() ? p_Default : l_Entry->second;
+        return l_Entry ? l_Entry->String : p_Default;
     }
     /// Get Bool configuration
     /// @p_Name     :  Name of entry we are looking for
     /// @p_Default  :  Default value
     bool Base::GetBool(std::string const& p_Name, bool const& p_Default)
     {
-        auto const l_Value = GetString(p_Name, p_Default ? "true" : "false");
-
-        std::string l_ValueLower;
-        std::transform(l_Value.cbegin(), l_Value.cend(), std::back_inserter(l_ValueLower), ::tolower);
+        std::shared_ptr<ConfigSnapshot const> l_Snapshot;
+        ConfigValue const* l_Entry = Find(p_Name, l_Snapshot);
 
-        return l_ValueLower == "true" || l_ValueLower == "1" || l_ValueLower == "yes";
+        return l_Entry ? l_Entry->Bool : p_Default;
     }
     /// Get Int configuration
     /// @p_Name     :  Name of entry we are looking for
     /// @p_Default  :  Default value
     int32 Base::GetInt(std::string const& p_Name, int32 const& p_Default)
     {
-        auto const l_Value = GetString(p_Name, std::to_string(p_Default));
+        std::shared_ptr<ConfigSnapshot const> l_Snapshot;
+        ConfigValue const* l_Entry = Find(p_Name, l_Snapshot);
 
-        return std::stoi(l_Value);
+        return l_Entry && l_Entry->IsInt ? l_Entry->Int : p_Default;
     }
     /// Get Float configuration
     /// @p_Name     :  Name of entry we are looking for
     /// @p_Default  :  Default value
     float Base::GetFloat(std::string const& p_Name, float const& p_Default)
     {
-        auto const l_Value = GetString(p_Name, std::to_string(p_Default));
+        std::shared_ptr<ConfigSnapshot const> l_Snapshot;
+        ConfigValue const* l_Entry = Find(p_Name, l_Snapshot);
 
-        return std::stof(l_Value);
+        return l_Entry && l_Entry->IsFloat ? l_Entry->Float : p_Default;
     }
 
 } ///< Configuration
@@ -18,24 +18,39 @@
 
 #pragma once
 #include <PCH/Precompiled.hpp>
+#include <atomic>
+#include <memory>
 
 #include "Singleton/Singleton.hpp"
-#include "Utility/UtiLockable.hpp"
-#include "Utility/UtiObjectGuard.hpp"
+
+#define CONFIG_MAX_KEY_LENGTH   128     ///< Keys up to this length are looked up without allocating
 
 namespace SteerStone { namespace Core { namespace Configuration {
 
-    /// Configuration Map
-    using ConfigMap = std::unordered_map<std::string, std::string>;
+    /// Entry value, parsed once when the file is loaded
+    struct ConfigValue
+    {
+        std::string String;             ///< Raw value
+        bool        Bool;               ///< Value as boolean, "true", "1" or "yes"
+        int32       Int;                ///< Value as integer, valid if IsInt
+        float       Float;              ///< Value as float, valid if IsFloat
+        bool        IsInt;              ///< Value starts with an integer
+        bool        IsFloat;            ///< Value starts with a float
+    };
 
-    /// Base
-    class Base : private Utils::LockableReadWrite
+    /// Configuration Map, keys are lower case
+    using ConfigMap = std::map<std::string, ConfigValue, std::less<>>;
+
+    /// Immutable entries of one load of the file
+    struct ConfigSnapshot
     {
-        /// Allow access to lock / unlock methods
-        friend class Utils::ObjectGuard<Base>;
-        friend class Utils::ObjectReadGuard<Base>;
-        friend class Utils::ObjectWriteGuard<Base>;
+        ConfigMap   Entries;            ///< Entries inside file
+        uint32      Generation;         ///< Reload which built the snapshot
+    };
 
+    /// Base
+    class Base
+    {
         SINGLETON_P_D(Base);
 
         //////////////////////////////////////////////////////////////////////////
@@ -50,9 +65,21 @@ namespace SteerStone { namespace Core { namespace Configuration {
             /// Check if entry exists
             /// @p_File : File name
             bool IsSet(std::string const& p_File);
-            /// Reload File
+            /// Reload File, readers keep using the previous entries until the new ones are published
             bool Reload();
 
+            /// Get current entries, they never change once published
+            std::shared_ptr<ConfigSnapshot const> GetSnapshot() const;
+            /// Get amount of successful loads, changes every time a reload is published
+            uint32 GetGeneration() const
+            {
+                return m_Generation.load(std::memory_order_acquire);
+            }
+            /// Find an entry in a snapshot
+            /// @p_Snapshot : Snapshot
+            /// @p_Name     : Name of entry, any case
+            static ConfigValue const* Find(ConfigSnapshot const& p_Snapshot, std::string_view const p_Name);
+
             //////////////////////////////////////////////////////////////////////////
             //////////////////////////////////////////////////////////////////////////
 
@@ -78,8 +105,87 @@ namespace SteerStone { namespace Core { namespace Configuration {
         //////////////////////////////////////////////////////////////////////////
 
         private:
-            std::string m_FileName;         ///< Name of file
-            ConfigMap m_Entries;            ///< Entries inside file
+            /// Get entry of current snapshot
+            /// @p_Name : Name of entry
+            /// @p_Snapshot : Holds the snapshot the entry belongs to
+            ConfigValue const* Find(std::string_view const p_Name, std::shared_ptr<ConfigSnapshot const>& p_Snapshot) const;
+
+        private:
+            std::string m_FileName;                             ///< Name of file
+            std::shared_ptr<ConfigSnapshot const> m_Snapshot;   ///< Published entries, accessed atomically
+            std::atomic<uint32> m_Generation;                   ///< Generation of published entries
+            std::mutex m_ReloadMutex;                           ///< One reload at a time
+    };
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Cached typed entry, a read is one atomic load until a reload publishes new entries
+    /// Safe to share between threads, such as a static inside a packet handler
+    template<typename T> class ConfigHandle
+    {
+        static_assert(std::is_same<T, bool>::value || std::is_same<T, int32>::value || std::is_same<T, uint32>::value || std::is_same<T, float>::value,
+            "ConfigHandle holds bool, int32, uint32 or float, use GetString for strings");
+
+        DISALLOW_COPY_AND_ASSIGN(ConfigHandle);
+
+        public:
+            /// Constructor
+            /// @p_Name     : Name of entry
+            /// @p_Default  : Value if entry is not set or not valid
+            ConfigHandle(std::string const& p_Name, T p_Default)
+                : m_Name(p_Name), m_Default(p_Default), m_Value(p_Default), m_Generation(0)
+            {
+            }
+
+            /// Get value
+            T Get() const
+            {
+                const uint32 l_Generation = Base::GetSingleton()->GetGeneration();
+
+                if (l_Generation != m_Generation.load(std::memory_order_acquire))
+                    Refresh(l_Generation);
+
+                return m_Value.load(std::memory_order_relaxed);
+            }
+            /// Get value
+            operator T() const
+            {
+                return Get();
+            }
+
+        private:
+            /// Read value from published entries
+            /// @p_Generation : Generation seen
+            void Refresh(uint32 p_Generation) const
+            {
+                const std::shared_ptr<ConfigSnapshot const> l_Snapshot = Base::GetSingleton()->GetSnapshot();
+                T l_Value = m_Default;
+
+                if (l_Snapshot)
+                {
+                    if (ConfigValue const* l_Entry = Base::Find(*l_Snapshot, m_Name))
+                    {
+                        if constexpr (std::is_same<T, bool>::value)
+                            l_Value = l_Entry->Bool;
+                        else if constexpr (std::is_same<T, float>::value)
+                            l_Value = l_Entry->IsFloat ? l_Entry->Float : m_Default;
+                        else
+                            l_Value = l_Entry->IsInt ? static_cast<T>(l_Entry->Int) : m_Default;
+                    }
+
+                    p_Generation = l_Snapshot->Generation;
+                }
+
+                m_Value.store(l_Value, std::memory_order_relaxed);
+                m_Generation.store(p_Generation, std::memory_order_release);
+            }
+
+        private:
+            std::string                 m_Name;             ///< Name of entry
+            T                           m_Default;          ///< Default value
+            mutable std::atomic<T>      m_Value;            ///< Cached value
+            mutable std::atomic<uint32> m_Generation;       ///< Generation m_Value has been read from
     };
 
 }   ///< Configuration
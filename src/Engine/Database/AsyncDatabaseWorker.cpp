@@ -0,0 +1,337 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "AsyncDatabaseWorker.hpp"
+
+#ifdef DATABASE_NONBLOCKING
+
+#include "Database/MYSQLPreparedStatement.hpp"
+#include "Database/PreparedResultSet.hpp"
+#include "Operator.hpp"
+#include "CircuitBreaker.hpp"
+#include "Logger/LogDefines.hpp"
+#include "Utility/UtiString.hpp"
+#include "Diagnostic/DiaFlightRecorder.hpp"
+
+namespace SteerStone { namespace Core { namespace Database {
+
+    /// Constructor
+    /// @p_Service : IO Service of worker
+    /// @p_Handle  : MySQL connection
+    AsyncDatabaseWorker::Connection::Connection(boost::asio::io_service& p_Service, std::shared_ptr<MYSQLPreparedStatement> p_Handle)
+        : Handle(p_Handle), Socket(p_Service, p_Handle->GetSocket()), Timer(p_Service), Current(nullptr), State(Step::Idle), Result(0),
+        Metadata(nullptr), FieldCount(0), Wait(0), ExecuteTime(0)
+    {
+    }
+    /// Deconstructor
+    AsyncDatabaseWorker::Connection::~Connection()
+    {
+        /// Socket belongs to the MySQL connection
+        Socket.release();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    /// @p_WorkerThread : Worker thread number spawned
+    /// @p_Connections  : Connections owned by the worker, set up with the non blocking API
+    /// @p_Breaker      : Circuit breaker outcomes are recorded into
+    AsyncDatabaseWorker::AsyncDatabaseWorker(uint8 const& p_WorkerThread, std::vector<std::shared_ptr<MYSQLPreparedStatement>> const& p_Connections, CircuitBreaker* p_Breaker)
+        : m_Worker(new boost::asio::io_service::work(m_Service)), m_Queue(ASYNC_DATABASE_WORKER_QUEUE_CAPACITY), m_DrainPosted(false), m_Size(0), m_Stopping(false), m_Breaker(p_Breaker)
+    {
+        for (auto const& l_Connection : p_Connections)
+            m_Connections[l_Connection.get()] = std::make_unique<Connection>(m_Service, l_Connection);
+
+        std::function<bool()> l_Service = [this]() -> bool {
+            this->m_Service.run();
+            this->m_Stopped.set_value();
+
+            /// Ending the task retires our worker from its own thread, running again would set our promise twice
+            return false;
+        };
+
+        l_Task = sThreadManager->PushTask(Utils::StringBuilder("DATABASE_ASYNC_WORKER_THREAD_%0", p_WorkerThread), Threading::TaskType::Dedicated, -1, l_Service, p_WorkerThread);
+    }
+    /// Deconstructor
+    AsyncDatabaseWorker::~AsyncDatabaseWorker()
+    {
+        /// Operators still queued or in flight are executed, the event loop must be done with us before we go
+        m_Service.post([this]() -> void {
+            m_Stopping = true;
+            CheckStopped();
+        });
+
+        /// The event loop ends the task itself, popping it from here while it does would deadlock on the join
+        m_Stopped.get_future().wait();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Add Operator, safe to call from any thread
+    /// @p_Operator : Operater being added
+    void AsyncDatabaseWorker::AddOperator(Operator* p_Operator)
+    {
+        m_Size.fetch_add(1, std::memory_order_relaxed);
+        m_Queue.Push(p_Operator);
+
+        /// One drain per burst, Drain clears the flag before taking operators
+        if (!m_DrainPosted.exchange(true, std::memory_order_acq_rel))
+            m_Service.post(std::bind(&AsyncDatabaseWorker::Drain, this));
+    }
+
+    /// Get amount of operators queued or in flight
+    const std::size_t AsyncDatabaseWorker::GetSize() const
+    {
+        return m_Size.load(std::memory_order_relaxed);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Take queued operators and hand them to their connection
+    void AsyncDatabaseWorker::Drain()
+    {
+        m_DrainPosted.store(false, std::memory_order_release);
+
+        Operator* l_Operators[ASYNC_DATABASE_WORKER_BATCH_SIZE];
+
+        while (const std::size_t l_Count = m_Queue.TryPopBatch(l_Operators, ASYNC_DATABASE_WORKER_BATCH_SIZE))
+        {
+            for (std::size_t l_I = 0; l_I < l_Count; l_I++)
+            {
+                Operator* l_Operator = l_Operators[l_I];
+                PreparedStatement* l_Statement = l_Operator->GetPreparedStatement();
+
+                if (l_Statement)
+                    l_Statement->RecordQueueWait(l_Operator->GetQueueWait());
+
+                auto l_Itr = l_Statement ? m_Connections.find(l_Statement->GetConnection()) : m_Connections.end();
+
+                /// Operators without a statement of ours can only be executed blocking
+                if (l_Itr == m_Connections.end())
+                {
+                    const auto l_Start = std::chrono::steady_clock::now();
+
+                    Diagnostic::FlightRecorder::Record(Diagnostic::FlightEvent::OperatorStart, "Database::Execute", l_Operator->GetId());
+                    l_Operator->Execute();
+                    Diagnostic::FlightRecorder::Record(Diagnostic::FlightEvent::OperatorEnd, "Database::Execute", l_Operator->GetId());
+
+                    m_Breaker->Record(l_Operator->HasFailed(), std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - l_Start).count());
+
+                    delete l_Operator;
+                    m_Size.fetch_sub(1, std::memory_order_relaxed);
+                    continue;
+                }
+
+                l_Itr->second->Pending.push_back(l_Operator);
+                StartNext(l_Itr->second.get());
+            }
+        }
+
+        CheckStopped();
+    }
+
+    /// Start next pending operator of connection
+    /// @p_Connection : Connection
+    void AsyncDatabaseWorker::StartNext(Connection* p_Connection)
+    {
+        if (p_Connection->State != Step::Idle || p_Connection->Pending.empty())
+            return;
+
+        /// A statement is being prepared on the connection from another thread, MySQL connections are not thread safe
+        if (!p_Connection->Handle->TryLockConnection())
+        {
+            p_Connection->State = Step::Locking;
+            p_Connection->Timer.expires_from_now(std::chrono::milliseconds(ASYNC_DATABASE_WORKER_LOCK_RETRY));
+            p_Connection->Timer.async_wait([this, p_Connection](boost::system::error_code const& p_ErrorCode) -> void {
+                if (p_ErrorCode == boost::asio::error::operation_aborted)
+                    return;
+
+                p_Connection->State = Step::Idle;
+                StartNext(p_Connection);
+            });
+            return;
+        }
+
+        p_Connection->Current = p_Connection->Pending.front();
+        p_Connection->Pending.pop_front();
+
+        Diagnostic::FlightRecorder::Record(Diagnostic::FlightEvent::OperatorStart, "Database::ExecuteStart", p_Connection->Current->GetId());
+
+        PreparedStatement* l_Statement = p_Connection->Current->GetPreparedStatement();
+
+        if (!l_Statement->PrepareExecution())
+        {
+            Finish(p_Connection, nullptr);
+            return;
+        }
+
+        p_Connection->State = Step::Execute;
+        p_Connection->Started = std::chrono::steady_clock::now();
+        Advance(p_Connection, p_Connection->Handle->ExecuteStart(l_Statement->GetStatement(), p_Connection->Result));
+    }
+    /// Advance operator in flight until the API has to wait
+    /// @p_Connection : Connection
+    /// @p_Status     : MYSQL_WAIT_* events the API is waiting for, 0 if current step is complete
+    void AsyncDatabaseWorker::Advance(Connection* p_Connection, int32 p_Status)
+    {
+        if (p_Status)
+        {
+            WaitFor(p_Connection, p_Status);
+            return;
+        }
+
+        PreparedStatement* l_Statement = p_Connection->Current->GetPreparedStatement();
+        MYSQL_STMT* l_Stmt = l_Statement->GetStatement();
+
+        if (p_Connection->State == Step::Execute)
+        {
+            if (p_Connection->Result)
+            {
+                LOG_ERROR("Database", "Failed to execute statement. Error: %0", mysql_stmt_error(l_Stmt));
+                Finish(p_Connection, nullptr);
+                return;
+            }
+
+            p_Connection->Metadata   = mysql_stmt_result_metadata(l_Stmt);
+            p_Connection->FieldCount = mysql_stmt_field_count(l_Stmt);
+
+            const auto l_Now = std::chrono::steady_clock::now();
+            p_Connection->ExecuteTime = std::chrono::duration_cast<std::chrono::nanoseconds>(l_Now - p_Connection->Started).count();
+            p_Connection->Started = l_Now;
+
+            /// Statement does not return rows, nothing to store
+            if (!p_Connection->Metadata)
+            {
+                Finish(p_Connection, l_Statement->CompleteExecution(nullptr, p_Connection->FieldCount, p_Connection->Current->FreesStatementAutomatically(), p_Connection->ExecuteTime));
+                return;
+            }
+
+            p_Connection->State = Step::StoreResult;
+            Advance(p_Connection, p_Connection->Handle->StoreResultStart(l_Stmt, p_Connection->Result));
+            return;
+        }
+
+        if (p_Connection->Result)
+        {
+            LOG_ERROR("Database", "mysql_stmt_store_result: Cannot store result from MySQL Server. Error: %0", mysql_stmt_error(l_Stmt));
+
+            mysql_free_result(p_Connection->Metadata);
+            p_Connection->Metadata = nullptr;
+
+            Finish(p_Connection, l_Statement->CompleteExecution(nullptr, 0, p_Connection->Current->FreesStatementAutomatically()));
+            return;
+        }
+
+        /// Time waiting on the socket is part of storing, rows streamed in while we waited
+        const uint64 l_StoreTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - p_Connection->Started).count();
+
+        Finish(p_Connection, l_Statement->CompleteExecution(p_Connection->Metadata, p_Connection->FieldCount, p_Connection->Current->FreesStatementAutomatically(),
+            p_Connection->ExecuteTime, l_StoreTime));
+    }
+    /// Wait for events the API asked for
+    /// @p_Connection : Connection
+    /// @p_Status     : MYSQL_WAIT_* events to wait for
+    void AsyncDatabaseWorker::WaitFor(Connection* p_Connection, int32 p_Status)
+    {
+        const uint32 l_Wait = ++p_Connection->Wait;
+
+        auto l_Waiter = [this, p_Connection, l_Wait](int32 p_Event) {
+            return [this, p_Connection, l_Wait, p_Event](boost::system::error_code const& p_ErrorCode) -> void {
+                if (p_ErrorCode == boost::asio::error::operation_aborted)
+                    return;
+
+                OnEvent(p_Connection, l_Wait, p_Event);
+            };
+        };
+
+        if (p_Status & MYSQL_WAIT_READ)
+            p_Connection->Socket.async_wait(boost::asio::posix::stream_descriptor::wait_read, l_Waiter(MYSQL_WAIT_READ));
+        if (p_Status & MYSQL_WAIT_WRITE)
+            p_Connection->Socket.async_wait(boost::asio::posix::stream_descriptor::wait_write, l_Waiter(MYSQL_WAIT_WRITE));
+        if (p_Status & MYSQL_WAIT_EXCEPT)
+            p_Connection->Socket.async_wait(boost::asio::posix::stream_descriptor::wait_error, l_Waiter(MYSQL_WAIT_EXCEPT));
+        if (p_Status & MYSQL_WAIT_TIMEOUT)
+        {
+            p_Connection->Timer.expires_from_now(std::chrono::milliseconds(p_Connection->Handle->GetTimeout()));
+            p_Connection->Timer.async_wait(l_Waiter(MYSQL_WAIT_TIMEOUT));
+        }
+    }
+    /// Called when one of the waited events occured
+    /// @p_Connection : Connection
+    /// @p_Wait       : Sequence of wait
+    /// @p_Event      : MYSQL_WAIT_* event which occured
+    void AsyncDatabaseWorker::OnEvent(Connection* p_Connection, uint32 p_Wait, int32 p_Event)
+    {
+        /// Another event of the same wait already continued the operator
+        if (p_Wait != p_Connection->Wait)
+            return;
+
+        p_Connection->Wait++;
+
+        boost::system::error_code l_ErrorCode;
+        p_Connection->Socket.cancel(l_ErrorCode);
+        p_Connection->Timer.cancel(l_ErrorCode);
+
+        MYSQL_STMT* l_Stmt = p_Connection->Current->GetPreparedStatement()->GetStatement();
+
+        if (p_Connection->State == Step::Execute)
+            Advance(p_Connection, p_Connection->Handle->ExecuteContinue(l_Stmt, p_Connection->Result, p_Event));
+        else
+            Advance(p_Connection, p_Connection->Handle->StoreResultContinue(l_Stmt, p_Connection->Result, p_Event));
+    }
+    /// Complete operator in flight and start the next one
+    /// @p_Connection : Connection
+    /// @p_Result     : Result set, nullptr if execution failed
+    void AsyncDatabaseWorker::Finish(Connection* p_Connection, std::unique_ptr<PreparedResultSet> p_Result)
+    {
+        Operator* l_Operator = p_Connection->Current;
+
+        Diagnostic::FlightRecorder::Record(Diagnostic::FlightEvent::OperatorEnd, "Database::ExecuteStart", l_Operator->GetId());
+
+        p_Connection->Current    = nullptr;
+        p_Connection->Metadata   = nullptr;
+        p_Connection->FieldCount = 0;
+        p_Connection->State      = Step::Idle;
+        p_Connection->Handle->UnlockConnection();
+
+        l_Operator->Complete(std::move(p_Result));
+
+        m_Breaker->Record(l_Operator->HasFailed(), p_Connection->ExecuteTime);
+
+        delete l_Operator;
+        m_Size.fetch_sub(1, std::memory_order_relaxed);
+
+        StartNext(p_Connection);
+        CheckStopped();
+    }
+
+    /// Let the event loop exit once all operators are done
+    void AsyncDatabaseWorker::CheckStopped()
+    {
+        if (m_Stopping && m_Size.load(std::memory_order_relaxed) == 0)
+            m_Worker.reset();
+    }
+
+}   ///< namespace Database
+}   ///< namespace Core
+}   ///< namespace SteerStone
+
+#endif
@@ -0,0 +1,155 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include "Core/Core.hpp"
+#include "Database/SQLCommon.hpp"
+
+#ifdef DATABASE_NONBLOCKING
+
+#include "Utility/UtiBoundedQueue.hpp"
+#include "Threading/ThrTaskManager.hpp"
+
+#include <boost/asio.hpp>
+#include <future>
+#include <deque>
+
+#define ASYNC_DATABASE_WORKER_QUEUE_CAPACITY    8192    ///< Operators queued per worker before producers have to wait
+#define ASYNC_DATABASE_WORKER_BATCH_SIZE        64      ///< Operators taken from queue at once
+#define ASYNC_DATABASE_WORKER_LOCK_RETRY        1       ///< Milliseconds before retrying a connection held by a blocking call
+
+namespace SteerStone { namespace Core { namespace Database {
+
+    class Operator;
+    class MYSQLPreparedStatement;
+    class PreparedStatement;
+    class PreparedResultSet;
+    class CircuitBreaker;
+
+    /// Database worker driving its connections through the MariaDB non blocking API
+    /// A single thread keeps one statement in flight on every connection it owns,
+    /// operators of a busy connection wait in the connection queue
+    class AsyncDatabaseWorker
+    {
+    DISALLOW_COPY_AND_ASSIGN(AsyncDatabaseWorker);
+
+    /// Step of the operator in flight on a connection
+    enum class Step
+    {
+        Idle,               ///< Nothing in flight
+        Locking,            ///< Connection is held by a blocking call, waiting to retry
+        Execute,            ///< Waiting on mysql_stmt_execute
+        StoreResult         ///< Waiting on mysql_stmt_store_result
+    };
+
+    /// Connection owned by the worker
+    struct Connection
+    {
+        /// Constructor
+        /// @p_Service : IO Service of worker
+        /// @p_Handle  : MySQL connection
+        Connection(boost::asio::io_service& p_Service, std::shared_ptr<MYSQLPreparedStatement> p_Handle);
+        /// Deconstructor
+        ~Connection();
+
+        std::shared_ptr<MYSQLPreparedStatement> Handle;     ///< MySQL connection
+        boost::asio::posix::stream_descriptor Socket;       ///< Socket of connection, only used to wait for readiness
+        boost::asio::steady_timer Timer;                    ///< Timeout of current wait, also retries a held connection
+        std::deque<Operator*> Pending;                      ///< Operators waiting for the connection
+        Operator* Current;                                  ///< Operator in flight
+        Step State;                                         ///< Step of operator in flight
+        int32 Result;                                       ///< Return code of current step
+        MYSQL_RES* Metadata;                                ///< Result metadata of operator in flight
+        uint32 FieldCount;                                  ///< Field count of operator in flight
+        uint32 Wait;                                        ///< Sequence of current wait, stale completions are ignored
+        std::chrono::steady_clock::time_point Started;      ///< Start of current step of operator in flight
+        uint64 ExecuteTime;                                 ///< Nanoseconds the operator in flight took to execute
+    };
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    public:
+        /// Constructor
+        /// @p_WorkerThread : Worker thread number spawned
+        /// @p_Connections  : Connections owned by the worker, set up with the non blocking API
+        /// @p_Breaker      : Circuit breaker outcomes are recorded into
+        AsyncDatabaseWorker(uint8 const& p_WorkerThread, std::vector<std::shared_ptr<MYSQLPreparedStatement>> const& p_Connections, CircuitBreaker* p_Breaker);
+        /// Deconstructor
+        ~AsyncDatabaseWorker();
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+        /// Add Operator, safe to call from any thread
+        /// @p_Operator : Operater being added
+        void AddOperator(Operator* p_Operator);
+
+        /// Get amount of operators queued or in flight
+        const std::size_t GetSize() const;
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    private:
+        /// Take queued operators and hand them to their connection
+        void Drain();
+
+        /// Start next pending operator of connection
+        /// @p_Connection : Connection
+        void StartNext(Connection* p_Connection);
+        /// Advance operator in flight until the API has to wait
+        /// @p_Connection : Connection
+        /// @p_Status     : MYSQL_WAIT_* events the API is waiting for, 0 if current step is complete
+        void Advance(Connection* p_Connection, int32 p_Status);
+        /// Wait for events the API asked for
+        /// @p_Connection : Connection
+        /// @p_Status     : MYSQL_WAIT_* events to wait for
+        void WaitFor(Connection* p_Connection, int32 p_Status);
+        /// Called when one of the waited events occured
+        /// @p_Connection : Connection
+        /// @p_Wait       : Sequence of wait
+        /// @p_Event      : MYSQL_WAIT_* event which occured
+        void OnEvent(Connection* p_Connection, uint32 p_Wait, int32 p_Event);
+        /// Complete operator in flight and start the next one
+        /// @p_Connection : Connection
+        /// @p_Result     : Result set, nullptr if execution failed
+        void Finish(Connection* p_Connection, std::unique_ptr<PreparedResultSet> p_Result);
+
+        /// Let the event loop exit once all operators are done
+        void CheckStopped();
+
+    private:
+        boost::asio::io_service m_Service;                                              ///< Event loop
+        std::unique_ptr<boost::asio::io_service::work> m_Worker;                        ///< Keeps event loop running
+        std::unordered_map<MYSQLPreparedStatement*, std::unique_ptr<Connection>> m_Connections;  ///< Connections owned by worker
+        Utils::MPSCQueue<Operator*> m_Queue;                                            ///< Operators to execute, pushed by any thread
+        std::atomic<bool> m_DrainPosted;                                                ///< Drain has been posted to the event loop
+        std::atomic<std::size_t> m_Size;                                                ///< Operators queued or in flight
+        bool m_Stopping;                                                                ///< Deconstructor is waiting for the event loop
+        std::promise<void> m_Stopped;                                                   ///< Set once event loop returned
+        CircuitBreaker* m_Breaker;                                                      ///< Outcomes of executions are recorded into
+        Threading::Task::Ptr l_Task;
+    };
+
+}   ///< namespace Database
+}   ///< namespace Core
+}   ///< namespace SteerStone
+
+#endif
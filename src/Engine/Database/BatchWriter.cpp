@@ -0,0 +1,238 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BatchWriter.hpp"
+#include "Database.hpp"
+#include "Logger/LogDefines.hpp"
+
+namespace SteerStone { namespace Core { namespace Database {
+
+    /// Constructor
+    /// @p_Database      : Database rows are written to
+    /// @p_Table         : Table name
+    /// @p_Columns       : Column names
+    /// @p_MaxRows       : Rows per statement, a full batch is flushed straight away
+    /// @p_FlushInterval : Milliseconds a row may stay buffered
+    /// @p_KeyColumns    : Upsert mode if not 0, amount of leading columns forming the key, other columns are updated
+    BatchWriter::BatchWriter(Base* p_Database, std::string const& p_Table, std::vector<std::string> const& p_Columns, uint32 p_MaxRows, uint32 p_FlushInterval, uint32 p_KeyColumns)
+        : m_Database(p_Database), m_Table(p_Table), m_Columns(p_Columns), m_MaxRows(std::max<uint32>(p_MaxRows, 1)), m_FlushInterval(p_FlushInterval),
+        m_KeyColumns(p_KeyColumns), m_ShardKey(0), m_WrittenCount(0), m_StatementCount(0), m_CoalescedCount(0)
+    {
+        LOG_ASSERT(!m_Columns.empty(), "Database", "BatchWriter for table %0 has no columns", m_Table);
+        LOG_ASSERT(m_KeyColumns < m_Columns.size(), "Database", "BatchWriter for table %0 has no column left to update", m_Table);
+
+        /// Keep every statement under the placeholder limit of the server
+        m_MaxRows = std::min<uint32>(m_MaxRows, static_cast<uint32>(BATCH_WRITER_MAX_PLACEHOLDERS / m_Columns.size()));
+
+        /// Full batches always send the same text, so their handle is reused from the statement cache of the connection
+        m_FullQuery = BuildQuery(m_MaxRows);
+
+        /// Keyed operators of one key execute in queue order, the query names our table and columns
+        m_ShardKey = std::hash<std::string>()(m_FullQuery);
+
+        m_Task = sThreadManager->PushTask(Utils::StringBuilder("DATABASE_BATCH_WRITER_%0", m_Table), Threading::TaskType::Normal, std::max<uint32>(p_FlushInterval / 2, 1), std::bind(&BatchWriter::Update, this));
+    }
+    /// Deconstructor, buffered rows are flushed
+    BatchWriter::~BatchWriter()
+    {
+        sThreadManager->PopTask(m_Task);
+        Flush();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Buffer row, safe to call from any thread
+    /// @p_Row : Values in column order
+    void BatchWriter::Add(Row p_Row)
+    {
+        LOG_ASSERT(p_Row.size() == m_Columns.size(), "Database", "BatchWriter for table %0 expects %1 values but row has %2", m_Table, m_Columns.size(), p_Row.size());
+
+        {
+            std::lock_guard<std::mutex> l_Guard(m_Mutex);
+
+            if (m_Rows.empty())
+                m_FirstRowTime = std::chrono::steady_clock::now();
+
+            if (m_KeyColumns)
+            {
+                auto l_Result = m_Keys.emplace(BuildKey(p_Row), m_Rows.size());
+
+                /// A newer value of a buffered key replaces it in place
+                if (!l_Result.second)
+                {
+                    m_Rows[l_Result.first->second] = std::move(p_Row);
+                    m_CoalescedCount++;
+                    return;
+                }
+            }
+
+            m_Rows.push_back(std::move(p_Row));
+
+            if (m_Rows.size() < m_MaxRows)
+                return;
+        }
+
+        /// Rows added meanwhile go out with the full batch, Write splits them
+        Flush();
+    }
+    /// Write buffered rows now
+    void BatchWriter::Flush()
+    {
+        /// Two flushes must not queue their batches in the opposite order they took them
+        std::lock_guard<std::mutex> l_WriteGuard(m_WriteMutex);
+
+        std::vector<Row> l_Rows;
+
+        {
+            std::lock_guard<std::mutex> l_Guard(m_Mutex);
+            l_Rows.swap(m_Rows);
+            m_Keys.clear();
+        }
+
+        if (!l_Rows.empty())
+            Write(l_Rows);
+    }
+
+    /// Get amount of rows buffered
+    std::size_t BatchWriter::GetPendingCount() const
+    {
+        std::lock_guard<std::mutex> l_Guard(m_Mutex);
+        return m_Rows.size();
+    }
+    /// Get amount of rows written
+    uint64 BatchWriter::GetWrittenCount() const
+    {
+        return m_WrittenCount;
+    }
+    /// Get amount of statements sent
+    uint64 BatchWriter::GetStatementCount() const
+    {
+        return m_StatementCount;
+    }
+    /// Get amount of rows replaced by a newer row of the same key before being written
+    uint64 BatchWriter::GetCoalescedCount() const
+    {
+        return m_CoalescedCount;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Flush if the oldest buffered row waited long enough, called by our task
+    bool BatchWriter::Update()
+    {
+        bool l_Expired = false;
+
+        {
+            std::lock_guard<std::mutex> l_Guard(m_Mutex);
+            l_Expired = !m_Rows.empty() && std::chrono::steady_clock::now() - m_FirstRowTime >= m_FlushInterval;
+        }
+
+        if (l_Expired)
+            Flush();
+
+        return true;
+    }
+    /// Build query for an amount of rows
+    /// @p_Rows : Amount of rows
+    std::string BatchWriter::BuildQuery(std::size_t p_Rows) const
+    {
+        std::string l_Row = "(";
+        std::string l_Query = "INSERT INTO `" + m_Table + "` (";
+
+        for (std::size_t l_I = 0; l_I < m_Columns.size(); l_I++)
+        {
+            l_Query += (l_I ? ", `" : "`") + m_Columns[l_I] + "`";
+            l_Row   += l_I ? ", ?" : "?";
+        }
+
+        l_Row += ")";
+        l_Query += ") VALUES ";
+        l_Query.reserve(l_Query.size() + p_Rows * (l_Row.size() + 2) + 64 * m_Columns.size());
+
+        for (std::size_t l_I = 0; l_I < p_Rows; l_I++)
+        {
+            if (l_I)
+                l_Query += ", ";
+
+            l_Query += l_Row;
+        }
+
+        if (m_KeyColumns)
+        {
+            l_Query += " ON DUPLICATE KEY UPDATE ";
+
+            for (std::size_t l_I = m_KeyColumns; l_I < m_Columns.size(); l_I++)
+            {
+                if (l_I != m_KeyColumns)
+                    l_Query += ", ";
+
+                l_Query += "`" + m_Columns[l_I] + "` = VALUES(`" + m_Columns[l_I] + "`)";
+            }
+        }
+
+        return l_Query;
+    }
+    /// Build key of a row, its key columns serialized
+    /// @p_Row : Row
+    std::string BatchWriter::BuildKey(Row const& p_Row) const
+    {
+        std::string l_Key;
+
+        for (uint32 l_I = 0; l_I < m_KeyColumns; l_I++)
+            p_Row[l_I].AppendKey(l_Key);
+
+        return l_Key;
+    }
+    /// Send rows as statements of at most m_MaxRows rows, must be called while holding m_WriteMutex
+    /// @p_Rows : Rows to send
+    void BatchWriter::Write(std::vector<Row>& p_Rows)
+    {
+        for (std::size_t l_Offset = 0; l_Offset < p_Rows.size(); l_Offset += m_MaxRows)
+        {
+            const std::size_t l_Count = std::min<std::size_t>(m_MaxRows, p_Rows.size() - l_Offset);
+
+            PreparedStatement* l_PreparedStatement = m_Database->GetPrepareStatement();
+            if (!l_PreparedStatement)
+            {
+                LOG_ERROR("Database", "BatchWriter for table %0 could not get a statement, %1 rows are lost", m_Table, p_Rows.size() - l_Offset);
+                return;
+            }
+
+            if (l_Count == m_MaxRows)
+                l_PreparedStatement->PrepareStatement(m_FullQuery.c_str());
+            else
+                l_PreparedStatement->PrepareStatement(BuildQuery(l_Count).c_str());
+
+            uint16 l_Index = 0;
+            for (std::size_t l_I = l_Offset; l_I < l_Offset + l_Count; l_I++)
+                for (SQLBindData& l_Value : p_Rows[l_I])
+                    l_PreparedStatement->SetData(l_Index++, std::move(l_Value));
+
+            /// Nobody waits on the result, the statement is freed with it
+            m_Database->PrepareOperator(l_PreparedStatement, m_ShardKey);
+
+            m_WrittenCount += l_Count;
+            m_StatementCount++;
+        }
+    }
+
+}   ///< namespace Database
+}   ///< namespace Core
+}   ///< namespace SteerStone
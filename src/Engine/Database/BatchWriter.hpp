@@ -0,0 +1,118 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+#include "Database/BindData.hpp"
+#include "Threading/ThrTaskManager.hpp"
+
+#include <chrono>
+
+#define BATCH_WRITER_MAX_PLACEHOLDERS   65535   ///< Placeholders MySQL accepts in a single statement
+
+namespace SteerStone { namespace Core { namespace Database {
+
+    class Base;
+
+    /// Buffers small writes to a table and flushes them as multi row statements
+    /// INSERT INTO `Table` (`A`, `B`) VALUES (?, ?), (?, ?) ... [ON DUPLICATE KEY UPDATE `B` = VALUES(`B`)]
+    ///
+    /// A flush is triggered once p_MaxRows rows are buffered or p_FlushInterval milliseconds after the first
+    /// buffered row. In upsert mode the first p_KeyColumns columns are the key, a row replaces a buffered row
+    /// with the same key so only the latest value of each key is written (position saves)
+    ///
+    /// Every batch of a writer goes to the same worker in the order it was taken, an older row never lands after a newer one
+    class BatchWriter
+    {
+        DISALLOW_COPY_AND_ASSIGN(BatchWriter);
+
+        public:
+            /// Row values, one per column in column order
+            using Row = std::vector<SQLBindData>;
+
+        public:
+            /// Constructor
+            /// @p_Database      : Database rows are written to
+            /// @p_Table         : Table name
+            /// @p_Columns       : Column names
+            /// @p_MaxRows       : Rows per statement, a full batch is flushed straight away
+            /// @p_FlushInterval : Milliseconds a row may stay buffered
+            /// @p_KeyColumns    : Upsert mode if not 0, amount of leading columns forming the key, other columns are updated
+            BatchWriter(Base* p_Database, std::string const& p_Table, std::vector<std::string> const& p_Columns, uint32 p_MaxRows, uint32 p_FlushInterval, uint32 p_KeyColumns = 0);
+            /// Deconstructor, buffered rows are flushed
+            ~BatchWriter();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Buffer row, safe to call from any thread
+            /// @p_Row : Values in column order
+            void Add(Row p_Row);
+            /// Write buffered rows now
+            void Flush();
+
+            /// Get amount of rows buffered
+            std::size_t GetPendingCount() const;
+            /// Get amount of rows written
+            uint64 GetWrittenCount() const;
+            /// Get amount of statements sent
+            uint64 GetStatementCount() const;
+            /// Get amount of rows replaced by a newer row of the same key before being written
+            uint64 GetCoalescedCount() const;
+
+        private:
+            /// Flush if the oldest buffered row waited long enough, called by our task
+            bool Update();
+            /// Build query for an amount of rows
+            /// @p_Rows : Amount of rows
+            std::string BuildQuery(std::size_t p_Rows) const;
+            /// Build key of a row, its key columns serialized
+            /// @p_Row : Row
+            std::string BuildKey(Row const& p_Row) const;
+            /// Send rows as statements of at most m_MaxRows rows, must be called while holding m_WriteMutex
+            /// @p_Rows : Rows to send
+            void Write(std::vector<Row>& p_Rows);
+
+        private:
+            Base* m_Database;                                               ///< Database rows are written to
+            std::string m_Table;                                            ///< Table name
+            std::vector<std::string> m_Columns;                             ///< Column names
+            uint32 m_MaxRows;                                               ///< Rows per statement
+            std::chrono::milliseconds m_FlushInterval;                      ///< Time a row may stay buffered
+            uint32 m_KeyColumns;                                            ///< Leading key columns in upsert mode, 0 otherwise
+            std::string m_FullQuery;                                        ///< Query of a full batch, built once
+            uint64 m_ShardKey;                                              ///< Key every batch is queued with, hash of table and columns
+
+            std::mutex m_WriteMutex;                                        ///< Held from taking buffered rows until they are queued, taken before m_Mutex
+
+            mutable std::mutex m_Mutex;                                     ///< Guards buffered rows
+            std::vector<Row> m_Rows;                                        ///< Buffered rows
+            std::unordered_map<std::string, std::size_t> m_Keys;            ///< Index in m_Rows of each buffered key, upsert mode only
+            std::chrono::steady_clock::time_point m_FirstRowTime;           ///< Time the oldest buffered row was added
+
+            std::atomic<uint64> m_WrittenCount;                             ///< Rows written
+            std::atomic<uint64> m_StatementCount;                           ///< Statements sent
+            std::atomic<uint64> m_CoalescedCount;                           ///< Rows replaced before being written
+            Threading::Task::Ptr m_Task;                                    ///< Flush timer
+    };
+
+}   ///< namespace Database
+}   ///< namespace Core
+}   ///< namespace SteerStone
@@ -44,6 +44,13 @@ namespace SteerStone { namespace Core { namespace Database {
         FIELD_NONE
     };
 
+    /// Memory owned by the caller, bound without a copy
+    struct ViewType
+    {
+        char const* Data;
+        std::size_t Length;
+    };
+
     union DataType
     {
         bool Boolean;
@@ -57,13 +64,38 @@ namespace SteerStone { namespace Core { namespace Database {
         int64 Int64;
         float Float;
         double Double;
+        ViewType View;
     };
 
     class SQLBindData
     {
     public:
+        /// Unset value, bound as NULL
+        SQLBindData() : m_Type(FieldType::FIELD_NONE), m_Borrowed(false) { m_BinaryData.Uint64 = 0; }
         template<typename T>
-        SQLBindData(T p_Data) { Set(p_Data); }
+        SQLBindData(T p_Data) : m_Borrowed(false) { Set(std::move(p_Data)); }
+
+        /// Bind a string without copying it, p_Data must stay valid until the statement has executed
+        /// @p_Data : String
+        static SQLBindData View(std::string_view p_Data)
+        {
+            SQLBindData l_Data;
+            l_Data.m_Type = FieldType::FIELD_STRING;
+            l_Data.m_Borrowed = true;
+            l_Data.m_BinaryData.View = ViewType{ p_Data.data(), p_Data.size() };
+            return l_Data;
+        }
+        /// Bind bytes without copying them, p_Data must stay valid until the statement has executed
+        /// @p_Data   : Bytes
+        /// @p_Length : Amount of bytes
+        static SQLBindData Binary(void const* p_Data, std::size_t p_Length)
+        {
+            SQLBindData l_Data;
+            l_Data.m_Type = FieldType::FIELD_BINARY;
+            l_Data.m_Borrowed = true;
+            l_Data.m_BinaryData.View = ViewType{ static_cast<char const*>(p_Data), p_Length };
+            return l_Data;
+        }
 
     public:
         enum_field_types GetFieldType(uint8& p_Unsigned) const
@@ -84,6 +116,7 @@ namespace SteerStone { namespace Core { namespace Database {
             case FieldType::FIELD_FLOAT:  l_DataType = enum_field_types::MYSQL_TYPE_FLOAT;                    break;
             case FieldType::FIELD_DOUBLE: l_DataType = enum_field_types::MYSQL_TYPE_DOUBLE;                   break;
             case FieldType::FIELD_STRING: l_DataType = enum_field_types::MYSQL_TYPE_STRING;                   break;
+            case FieldType::FIELD_BINARY: l_DataType = enum_field_types::MYSQL_TYPE_BLOB;                     break;
             }
 
             return l_DataType;
@@ -105,18 +138,61 @@ namespace SteerStone { namespace Core { namespace Database {
             case FieldType::FIELD_I64:     return sizeof(int64);
             case FieldType::FIELD_FLOAT:   return sizeof(float);
             case FieldType::FIELD_DOUBLE:  return sizeof(double);
-            case FieldType::FIELD_STRING:  return m_StringData.length();
+            case FieldType::FIELD_STRING:  return m_Borrowed ? m_BinaryData.View.Length : m_StringData.length();
+            case FieldType::FIELD_BINARY:  return m_BinaryData.View.Length;
 
             default:
                 throw std::runtime_error("unrecognized type of SqlStmtFieldType obtained");
             }
         }
 
+        FieldType GetType() const
+        {
+            return m_Type;
+        }
+
         void* GetBuffer() const
         {
+            if (m_Borrowed)
+                return (void*)m_BinaryData.View.Data;
+
             return m_Type == FIELD_STRING ? (void*)m_StringData.c_str() : (void*)&m_BinaryData;
         }
 
+        /// Append type and value, used to build lookup keys out of bound values
+        /// @p_Key : Key being built
+        void AppendKey(std::string& p_Key) const
+        {
+            const uint32 l_Size = static_cast<uint32>(GetSize());
+
+            /// Length prefix keeps string values from running into each other
+            p_Key.push_back(static_cast<char>(m_Type));
+            p_Key.append(reinterpret_cast<char const*>(&l_Size), sizeof(l_Size));
+            p_Key.append(static_cast<char const*>(GetBuffer()), l_Size);
+        }
+
+        /// Get value as text, used in logs
+        std::string ToString() const
+        {
+            switch (m_Type)
+            {
+            case FieldType::FIELD_BOOL:    return m_BinaryData.Boolean ? "true" : "false";
+            case FieldType::FIELD_UI8:     return std::to_string(m_BinaryData.Uint8);
+            case FieldType::FIELD_UI16:    return std::to_string(m_BinaryData.Uint16);
+            case FieldType::FIELD_UI32:    return std::to_string(m_BinaryData.Uint32);
+            case FieldType::FIELD_UI64:    return std::to_string(m_BinaryData.Uint64);
+            case FieldType::FIELD_I8:      return std::to_string(m_BinaryData.Int8);
+            case FieldType::FIELD_I16:     return std::to_string(m_BinaryData.Int16);
+            case FieldType::FIELD_I32:     return std::to_string(m_BinaryData.Int32);
+            case FieldType::FIELD_I64:     return std::to_string(m_BinaryData.Int64);
+            case FieldType::FIELD_FLOAT:   return std::to_string(m_BinaryData.Float);
+            case FieldType::FIELD_DOUBLE:  return std::to_string(m_BinaryData.Double);
+            case FieldType::FIELD_STRING:  return "'" + std::string(static_cast<char const*>(GetBuffer()), GetSize()) + "'";
+            case FieldType::FIELD_BINARY:  return "<" + std::to_string(GetSize()) + " bytes>";
+            default:                       return "NULL";
+            }
+        }
+
     public:
         inline void Set(bool p_Data)        { m_Type = FieldType::FIELD_BOOL;   m_BinaryData.Boolean = p_Data; }
         inline void Set(uint8 p_Data)       { m_Type = FieldType::FIELD_UI8;    m_BinaryData.Uint8 = p_Data; }
@@ -129,10 +205,11 @@ namespace SteerStone { namespace Core { namespace Database {
         inline void Set(int64 p_Data)       { m_Type = FieldType::FIELD_I64;    m_BinaryData.Int64 = p_Data; }
         inline void Set(float p_Data)       { m_Type = FieldType::FIELD_FLOAT;  m_BinaryData.Float = p_Data; }
         inline void Set(double p_Data)      { m_Type = FieldType::FIELD_DOUBLE; m_BinaryData.Double = p_Data; }
-        inline void Set(std::string p_Data) { m_Type = FieldType::FIELD_STRING; m_StringData = p_Data; }
+        inline void Set(std::string p_Data) { m_Type = FieldType::FIELD_STRING; m_StringData = std::move(p_Data); }
 
     private:
         FieldType m_Type;
+        bool m_Borrowed;                ///< Value is m_BinaryData.View, owned by the caller
         DataType m_BinaryData;
         std::string m_StringData;
     };
@@ -0,0 +1,141 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CircuitBreaker.hpp"
+#include "Logger/Base.hpp"
+#include "Logger/LogDefines.hpp"
+
+#include <chrono>
+
+namespace SteerStone { namespace Core { namespace Database {
+
+    /// Get steady milliseconds
+    static uint64 GetSteadyTime()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    CircuitBreaker::CircuitBreaker()
+        : m_State(static_cast<uint32>(BreakerState::Closed)), m_Failures(0), m_OpenedAt(0), m_TripCount(0)
+    {
+        SetLimits(DEFAULT_BREAKER_FAILURES, DEFAULT_BREAKER_SLOW_TIME, DEFAULT_BREAKER_OPEN_TIME);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Set limits
+    /// @p_Failures : Consecutive failed or slow executions tripping the breaker, 0 disables the breaker
+    /// @p_SlowTime : Milliseconds an execution may take before it counts as a failure, 0 only counts failures
+    /// @p_OpenTime : Milliseconds the breaker stays open before letting a trial through
+    void CircuitBreaker::SetLimits(uint32 p_Failures, uint32 p_SlowTime, uint32 p_OpenTime)
+    {
+        m_FailureLimit  = p_Failures;
+        m_SlowTime      = static_cast<uint64>(p_SlowTime) * 1000000;
+        m_OpenTime      = p_OpenTime;
+    }
+
+    /// Check an operator may be queued, an open breaker lets one trial through every open time
+    bool CircuitBreaker::Allow()
+    {
+        if (m_State.load(std::memory_order_acquire) == static_cast<uint32>(BreakerState::Closed))
+            return true;
+
+        const uint64 l_Now = GetSteadyTime();
+        uint64 l_OpenedAt = m_OpenedAt.load(std::memory_order_relaxed);
+
+        if (l_Now - l_OpenedAt < m_OpenTime)
+            return false;
+
+        /// Only one caller wins the trial, a trial which never comes back lets another through next open time
+        if (!m_OpenedAt.compare_exchange_strong(l_OpenedAt, l_Now, std::memory_order_relaxed))
+            return false;
+
+        m_State.store(static_cast<uint32>(BreakerState::HalfOpen), std::memory_order_release);
+        return true;
+    }
+    /// Record outcome of an execution, called by database workers
+    /// @p_Failed      : Execution failed
+    /// @p_ExecuteTime : Nanoseconds execution took
+    void CircuitBreaker::Record(bool p_Failed, uint64 p_ExecuteTime)
+    {
+        if (!m_FailureLimit)
+            return;
+
+        if (!p_Failed && (!m_SlowTime || p_ExecuteTime < m_SlowTime))
+        {
+            m_Failures.store(0, std::memory_order_relaxed);
+
+            if (m_State.exchange(static_cast<uint32>(BreakerState::Closed), std::memory_order_acq_rel) != static_cast<uint32>(BreakerState::Closed))
+                LOG_INFO("Database", "Circuit breaker closed, database is answering again");
+
+            return;
+        }
+
+        const uint32 l_Failures = m_Failures.fetch_add(1, std::memory_order_relaxed) + 1;
+        const uint32 l_State = m_State.load(std::memory_order_acquire);
+
+        /// Failures while open keep it open for another open time, a failed trial opens it again
+        if (l_State != static_cast<uint32>(BreakerState::Closed))
+        {
+            m_OpenedAt.store(GetSteadyTime(), std::memory_order_relaxed);
+            m_State.store(static_cast<uint32>(BreakerState::Open), std::memory_order_release);
+        }
+        else if (l_Failures >= m_FailureLimit)
+            Trip();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get state
+    BreakerState CircuitBreaker::GetState() const
+    {
+        return static_cast<BreakerState>(m_State.load(std::memory_order_relaxed));
+    }
+    /// Get amount of times breaker tripped
+    uint64 CircuitBreaker::GetTripCount() const
+    {
+        return m_TripCount.load(std::memory_order_relaxed);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Open breaker
+    void CircuitBreaker::Trip()
+    {
+        uint32 l_Expected = static_cast<uint32>(BreakerState::Closed);
+
+        m_OpenedAt.store(GetSteadyTime(), std::memory_order_relaxed);
+
+        if (!m_State.compare_exchange_strong(l_Expected, static_cast<uint32>(BreakerState::Open), std::memory_order_acq_rel))
+            return;
+
+        m_TripCount.fetch_add(1, std::memory_order_relaxed);
+
+        LOG_ERROR("Database", "Circuit breaker tripped after %0 failed or slow executions, failing fast for %1 ms", m_Failures.load(std::memory_order_relaxed), m_OpenTime);
+    }
+
+}   ///< namespace Database
+}   ///< namespace Core
+}   ///< namespace SteerStone
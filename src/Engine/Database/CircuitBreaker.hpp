@@ -0,0 +1,90 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <atomic>
+
+#include "Core/Core.hpp"
+
+#define DEFAULT_BREAKER_FAILURES    20      ///< Consecutive failed or slow executions tripping the breaker
+#define DEFAULT_BREAKER_SLOW_TIME   5000    ///< Milliseconds an execution may take before it counts as a failure
+#define DEFAULT_BREAKER_OPEN_TIME   5000    ///< Milliseconds the breaker stays open before letting a trial through
+
+namespace SteerStone { namespace Core { namespace Database {
+
+    /// States of circuit breaker
+    enum class BreakerState : uint32
+    {
+        Closed,                 ///< Database is healthy, operators are queued
+        Open,                   ///< Database is failing, operators which may fail fast are rejected
+        HalfOpen                ///< One trial operator has been let through, its outcome closes or opens the breaker
+    };
+
+    /// Trips once executions keep failing or taking too long so callers fail fast instead of queueing behind a stalled server
+    /// Only operators queued with a policy allowing to fail are held back, blocking operators still reach the server
+    /// and their outcomes are recorded as well
+    class CircuitBreaker
+    {
+        DISALLOW_COPY_AND_ASSIGN(CircuitBreaker);
+
+        public:
+            /// Constructor
+            CircuitBreaker();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Set limits
+            /// @p_Failures : Consecutive failed or slow executions tripping the breaker, 0 disables the breaker
+            /// @p_SlowTime : Milliseconds an execution may take before it counts as a failure, 0 only counts failures
+            /// @p_OpenTime : Milliseconds the breaker stays open before letting a trial through
+            void SetLimits(uint32 p_Failures, uint32 p_SlowTime, uint32 p_OpenTime);
+
+            /// Check an operator may be queued, an open breaker lets one trial through every open time
+            bool Allow();
+            /// Record outcome of an execution, called by database workers
+            /// @p_Failed      : Execution failed
+            /// @p_ExecuteTime : Nanoseconds execution took
+            void Record(bool p_Failed, uint64 p_ExecuteTime);
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Get state
+            BreakerState GetState() const;
+            /// Get amount of times breaker tripped
+            uint64 GetTripCount() const;
+
+        private:
+            /// Open breaker
+            void Trip();
+
+        private:
+            std::atomic<uint32> m_State;                ///< BreakerState
+            std::atomic<uint32> m_Failures;             ///< Consecutive failed or slow executions
+            std::atomic<uint64> m_OpenedAt;             ///< Steady milliseconds breaker opened or last let a trial through
+            std::atomic<uint64> m_TripCount;            ///< Times breaker tripped
+            uint32 m_FailureLimit;                      ///< Consecutive failures tripping the breaker, 0 disables it
+            uint64 m_SlowTime;                          ///< Nanoseconds an execution may take
+            uint32 m_OpenTime;                          ///< Milliseconds between trials
+    };
+
+}   ///< namespace Database
+}   ///< namespace Core
+}   ///< namespace SteerStone
@@ -0,0 +1,108 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Database/CompletionQueue.hpp"
+
+namespace SteerStone { namespace Core { namespace Database {
+
+    /// Constructor
+    /// @p_Notify : Called from the database worker when the queue stops being empty, lets an executor
+    ///             schedule Process instead of calling it every tick, may be nullptr
+    CompletionQueue::CompletionQueue(std::function<void()> p_Notify)
+        : m_Notify(std::move(p_Notify))
+    {
+    }
+    /// Deconstructor, callbacks not processed are dropped and their results freed
+    CompletionQueue::~CompletionQueue()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Post result of a statement, called by database worker
+    /// @p_Callback : Callback
+    /// @p_Result   : Result
+    void CompletionQueue::Post(ResultCallback const& p_Callback, std::unique_ptr<PreparedResultSet> p_Result)
+    {
+        Push(Completion{ p_Callback, std::move(p_Result), nullptr });
+    }
+    /// Post callback with its result bound in, called by database worker
+    /// @p_Function : Callback
+    void CompletionQueue::Post(std::function<void()> p_Function)
+    {
+        Push(Completion{ nullptr, nullptr, std::move(p_Function) });
+    }
+
+    /// Run every completed callback, called by the owner
+    /// Returns amount of callbacks run
+    std::size_t CompletionQueue::Process()
+    {
+        {
+            std::lock_guard<std::mutex> l_Guard(m_Mutex);
+
+            if (m_Completions.empty())
+                return 0;
+
+            m_Processing.swap(m_Completions);
+        }
+
+        /// Callbacks run without the mutex, they may queue new operators completing into us
+        for (Completion& l_Completion : m_Processing)
+        {
+            if (l_Completion.Function)
+                l_Completion.Function();
+            else if (l_Completion.Callback)
+                l_Completion.Callback(std::move(l_Completion.Result));
+        }
+
+        const std::size_t l_Count = m_Processing.size();
+        m_Processing.clear();
+
+        return l_Count;
+    }
+    /// Get amount of completions waiting
+    std::size_t CompletionQueue::GetSize() const
+    {
+        std::lock_guard<std::mutex> l_Guard(m_Mutex);
+        return m_Completions.size();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Queue completion
+    /// @p_Completion : Completion
+    void CompletionQueue::Push(Completion&& p_Completion)
+    {
+        bool l_WasEmpty = false;
+
+        {
+            std::lock_guard<std::mutex> l_Guard(m_Mutex);
+
+            l_WasEmpty = m_Completions.empty();
+            m_Completions.push_back(std::move(p_Completion));
+        }
+
+        if (l_WasEmpty && m_Notify)
+            m_Notify();
+    }
+
+}   ///< namespace Database
+}   ///< namespace Core
+}   ///< namespace SteerStone
@@ -0,0 +1,90 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+#include "Database/PreparedResultSet.hpp"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace SteerStone { namespace Core { namespace Database {
+
+    /// Completed database operators waiting to call back on their owner (room, network thread, world tick)
+    /// Database workers post into the queue once an operator is done, the owner runs the callbacks from its
+    /// own thread. Only completed operators are ever touched, pending ones cost nothing
+    class CompletionQueue
+    {
+        DISALLOW_COPY_AND_ASSIGN(CompletionQueue);
+
+        public:
+            /// Callback of a statement
+            using ResultCallback = std::function<void(std::unique_ptr<PreparedResultSet>)>;
+
+        private:
+            /// Completed operator
+            struct Completion
+            {
+                ResultCallback Callback;                    ///< Callback of a statement
+                std::unique_ptr<PreparedResultSet> Result;  ///< Result of statement
+                std::function<void()> Function;             ///< Callback of any other operator, result bound in
+            };
+
+        public:
+            /// Constructor
+            /// @p_Notify : Called from the database worker when the queue stops being empty, lets an executor
+            ///             schedule Process instead of calling it every tick, may be nullptr
+            explicit CompletionQueue(std::function<void()> p_Notify = nullptr);
+            /// Deconstructor, callbacks not processed are dropped and their results freed
+            ~CompletionQueue();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Post result of a statement, called by database worker
+            /// @p_Callback : Callback
+            /// @p_Result   : Result
+            void Post(ResultCallback const& p_Callback, std::unique_ptr<PreparedResultSet> p_Result);
+            /// Post callback with its result bound in, called by database worker
+            /// @p_Function : Callback
+            void Post(std::function<void()> p_Function);
+
+            /// Run every completed callback, called by the owner
+            /// Returns amount of callbacks run
+            std::size_t Process();
+            /// Get amount of completions waiting
+            std::size_t GetSize() const;
+
+        private:
+            /// Queue completion
+            /// @p_Completion : Completion
+            void Push(Completion&& p_Completion);
+
+        private:
+            std::function<void()> m_Notify;             ///< Called when the queue stops being empty
+            mutable std::mutex m_Mutex;                 ///< Guards m_Completions
+            std::vector<Completion> m_Completions;      ///< Completions in arrival order
+            std::vector<Completion> m_Processing;       ///< Completions being run, kept to reuse its storage
+    };
+
+}   ///< namespace Database
+}   ///< namespace Core
+}   ///< namespace SteerStone
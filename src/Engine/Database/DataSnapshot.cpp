@@ -0,0 +1,435 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Database/DataSnapshot.hpp"
+#include "Database/Database.hpp"
+#include "Logger/LogDefines.hpp"
+
+#ifdef _WIN32
+# include <Windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+namespace SteerStone { namespace Core { namespace Database {
+
+    /// Round offset up to the section alignment
+    /// @p_Offset : Offset
+    static uint64 AlignSection(uint64 p_Offset)
+    {
+        return (p_Offset + DATA_SNAPSHOT_ALIGNMENT - 1) & ~static_cast<uint64>(DATA_SNAPSHOT_ALIGNMENT - 1);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    /// @p_Layout      : Version of the records, bumped by the owner when a struct changes
+    /// @p_DataVersion : Version of the database the records were loaded from
+    DataSnapshotWriter::DataSnapshotWriter(uint32 p_Layout, uint64 p_DataVersion)
+        : m_Layout(p_Layout), m_DataVersion(p_DataVersion)
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Add section of raw records
+    /// @p_Id         : Id of section
+    /// @p_RecordSize : sizeof of one record
+    /// @p_Data       : Records
+    /// @p_Count      : Amount of records
+    void DataSnapshotWriter::AddSection(uint32 p_Id, uint32 p_RecordSize, void const* p_Data, std::size_t p_Count)
+    {
+        LOG_ASSERT(p_Id != DATA_SNAPSHOT_STRING_SECTION, "Database", "Snapshot section id %0 is reserved for the string pool", p_Id);
+
+        PendingSection l_Section;
+        l_Section.Id            = p_Id;
+        l_Section.RecordSize    = p_RecordSize;
+        l_Section.Count         = p_Count;
+        l_Section.Data.assign(static_cast<uint8 const*>(p_Data), static_cast<uint8 const*>(p_Data) + static_cast<std::size_t>(p_RecordSize) * p_Count);
+
+        m_Sections.push_back(std::move(l_Section));
+    }
+    /// Add string to the string pool
+    /// @p_String : String
+    DataSnapshotString DataSnapshotWriter::AddString(std::string_view p_String)
+    {
+        DataSnapshotString l_String;
+        l_String.Offset = static_cast<uint32>(m_Strings.size());
+        l_String.Length = static_cast<uint32>(p_String.size());
+
+        /// Terminated so the records can hand out C strings too
+        m_Strings.append(p_String.data(), p_String.size());
+        m_Strings.push_back('\0');
+
+        return l_String;
+    }
+
+    /// Write snapshot, written next to the path first and renamed so a crash never leaves half a file
+    /// @p_Path : Path of snapshot
+    bool DataSnapshotWriter::Write(std::string const& p_Path) const
+    {
+        const uint32 l_SectionCount = static_cast<uint32>(m_Sections.size() + (m_Strings.empty() ? 0 : 1));
+
+        std::vector<DataSnapshotSection> l_Table;
+        l_Table.reserve(l_SectionCount);
+
+        uint64 l_Offset = AlignSection(sizeof(DataSnapshotHeader) + sizeof(DataSnapshotSection) * l_SectionCount);
+
+        for (PendingSection const& l_Section : m_Sections)
+        {
+            l_Table.push_back(DataSnapshotSection{ l_Section.Id, l_Section.RecordSize, l_Offset, l_Section.Count });
+            l_Offset = AlignSection(l_Offset + l_Section.Data.size());
+        }
+
+        if (!m_Strings.empty())
+        {
+            l_Table.push_back(DataSnapshotSection{ DATA_SNAPSHOT_STRING_SECTION, 1, l_Offset, m_Strings.size() });
+            l_Offset += m_Strings.size();
+        }
+
+        /// Build the whole image so the checksum is computed over exactly what lands on disk
+        std::vector<uint8> l_Image(static_cast<std::size_t>(l_Offset), 0);
+
+        std::memcpy(l_Image.data() + sizeof(DataSnapshotHeader), l_Table.data(), l_Table.size() * sizeof(DataSnapshotSection));
+
+        for (std::size_t l_I = 0; l_I < m_Sections.size(); l_I++)
+        {
+            if (!m_Sections[l_I].Data.empty())
+                std::memcpy(l_Image.data() + l_Table[l_I].Offset, m_Sections[l_I].Data.data(), m_Sections[l_I].Data.size());
+        }
+
+        if (!m_Strings.empty())
+            std::memcpy(l_Image.data() + l_Table.back().Offset, m_Strings.data(), m_Strings.size());
+
+        DataSnapshotHeader l_Header;
+        l_Header.Magic          = DATA_SNAPSHOT_MAGIC;
+        l_Header.Format         = DATA_SNAPSHOT_FORMAT;
+        l_Header.Layout         = m_Layout;
+        l_Header.SectionCount   = l_SectionCount;
+        l_Header.DataVersion    = m_DataVersion;
+        l_Header.FileSize       = l_Image.size();
+        l_Header.Checksum       = DataSnapshot::ComputeChecksum(l_Image.data() + sizeof(DataSnapshotHeader), l_Image.size() - sizeof(DataSnapshotHeader));
+
+        std::memcpy(l_Image.data(), &l_Header, sizeof(DataSnapshotHeader));
+
+        const std::string l_TempPath = p_Path + ".tmp";
+
+        {
+            std::ofstream l_File(l_TempPath, std::ios::binary | std::ios::trunc);
+            if (!l_File.is_open())
+            {
+                LOG_ERROR("Database", "Could not create snapshot %0", l_TempPath);
+                return false;
+            }
+
+            l_File.write(reinterpret_cast<char const*>(l_Image.data()), l_Image.size());
+            if (!l_File.good())
+            {
+                LOG_ERROR("Database", "Could not write snapshot %0", l_TempPath);
+                return false;
+            }
+        }
+
+        /// Rename does not replace an existing file on every platform
+        std::remove(p_Path.c_str());
+
+        if (std::rename(l_TempPath.c_str(), p_Path.c_str()) != 0)
+        {
+            LOG_ERROR("Database", "Could not move snapshot %0 to %1", l_TempPath, p_Path);
+            return false;
+        }
+
+        LOG_INFO("Database", "Wrote snapshot %0, %1 sections, %2 bytes, data version %3", p_Path, l_SectionCount, l_Image.size(), m_DataVersion);
+        return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get version of the data in the database by a query returning a single unsigned BIGINT, e.g. a content
+    /// version row bumped by the tools, or CAST(UNIX_TIMESTAMP(MAX(UPDATE_TIME)) AS UNSIGNED) of information_schema.TABLES
+    /// @p_Database : Database
+    /// @p_Query    : Query
+    /// @p_Version  : Version
+    /// Returns false if the query failed
+    bool DataSnapshot::QueryDataVersion(Base* p_Database, char const* p_Query, uint64& p_Version)
+    {
+        PreparedStatement* l_PreparedStatement = p_Database->GetPrepareStatement();
+        if (!l_PreparedStatement)
+            return false;
+
+        l_PreparedStatement->PrepareStatement(p_Query);
+
+        std::unique_ptr<PreparedResultSet> l_PreparedResultSet = l_PreparedStatement->ExecuteStatement(true);
+        if (!l_PreparedResultSet)
+        {
+            /// Failed executions are not handed to a result set, give the statement back ourselves
+            p_Database->FreePrepareStatement(l_PreparedStatement);
+            return false;
+        }
+
+        if (!l_PreparedResultSet->GetRowCount() || !l_PreparedResultSet->GetFieldCount())
+            return false;
+
+        p_Version = (*l_PreparedResultSet)[0].GetUInt64();
+        return true;
+    }
+    /// Compute checksum of a block
+    /// @p_Data   : Data
+    /// @p_Length : Length of data
+    uint64 DataSnapshot::ComputeChecksum(uint8 const* p_Data, std::size_t p_Length)
+    {
+        /// FNV-1a over 8 byte words, only guards against truncated or damaged files
+        uint64 l_Hash = 0xCBF29CE484222325ULL;
+        std::size_t l_I = 0;
+
+        for (; l_I + sizeof(uint64) <= p_Length; l_I += sizeof(uint64))
+        {
+            uint64 l_Word;
+            std::memcpy(&l_Word, p_Data + l_I, sizeof(uint64));
+
+            l_Hash = (l_Hash ^ l_Word) * 0x100000001B3ULL;
+        }
+
+        for (; l_I < p_Length; l_I++)
+            l_Hash = (l_Hash ^ p_Data[l_I]) * 0x100000001B3ULL;
+
+        return l_Hash;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    DataSnapshot::DataSnapshot()
+        : m_Data(nullptr), m_Size(0), m_Sections(nullptr), m_Strings(nullptr), m_StringSize(0)
+    #ifdef _WIN32
+        , m_File(INVALID_HANDLE_VALUE), m_Mapping(nullptr)
+    #endif
+    {
+    }
+    /// Deconstructor
+    DataSnapshot::~DataSnapshot()
+    {
+        Close();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Map snapshot and check it against the expected versions
+    /// @p_Path        : Path of snapshot
+    /// @p_Layout      : Version of the records expected by the caller
+    /// @p_DataVersion : Version of the database, the snapshot is refused if it was taken from another
+    /// Returns false if file is missing, corrupt or stale, the caller loads from the database and writes a new one
+    bool DataSnapshot::Open(std::string const& p_Path, uint32 p_Layout, uint64 p_DataVersion)
+    {
+        Close();
+
+    #ifdef _WIN32
+        m_File = CreateFileA(p_Path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (m_File == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER l_Size;
+        if (!GetFileSizeEx(m_File, &l_Size) || l_Size.QuadPart < static_cast<LONGLONG>(sizeof(DataSnapshotHeader)))
+        {
+            Close();
+            return false;
+        }
+
+        m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!m_Mapping)
+        {
+            Close();
+            return false;
+        }
+
+        m_Data = static_cast<uint8 const*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+        m_Size = static_cast<std::size_t>(l_Size.QuadPart);
+    #else
+        const int l_File = open(p_Path.c_str(), O_RDONLY);
+        if (l_File < 0)
+            return false;
+
+        struct stat l_Stat;
+        if (fstat(l_File, &l_Stat) != 0 || l_Stat.st_size < static_cast<off_t>(sizeof(DataSnapshotHeader)))
+        {
+            close(l_File);
+            return false;
+        }
+
+        void* l_Mapping = mmap(nullptr, static_cast<std::size_t>(l_Stat.st_size), PROT_READ, MAP_PRIVATE, l_File, 0);
+
+        /// The mapping keeps the file alive
+        close(l_File);
+
+        if (l_Mapping != MAP_FAILED)
+        {
+            /// The checksum touches every page anyway, read ahead
+            madvise(l_Mapping, static_cast<std::size_t>(l_Stat.st_size), MADV_WILLNEED);
+
+            m_Data = static_cast<uint8 const*>(l_Mapping);
+            m_Size = static_cast<std::size_t>(l_Stat.st_size);
+        }
+    #endif
+
+        if (!m_Data)
+        {
+            Close();
+            return false;
+        }
+
+        if (!Validate(p_Layout, p_DataVersion))
+        {
+            Close();
+            return false;
+        }
+
+        m_Sections = reinterpret_cast<DataSnapshotSection const*>(m_Data + sizeof(DataSnapshotHeader));
+
+        if (DataSnapshotSection const* l_Strings = FindSection(DATA_SNAPSHOT_STRING_SECTION))
+        {
+            m_Strings       = reinterpret_cast<char const*>(m_Data + l_Strings->Offset);
+            m_StringSize    = static_cast<std::size_t>(l_Strings->Count);
+        }
+
+        LOG_INFO("Database", "Mapped snapshot %0, %1 bytes, data version %2", p_Path, m_Size, p_DataVersion);
+        return true;
+    }
+    /// Unmap snapshot
+    void DataSnapshot::Close()
+    {
+    #ifdef _WIN32
+        if (m_Data)
+            UnmapViewOfFile(m_Data);
+        if (m_Mapping)
+            CloseHandle(m_Mapping);
+        if (m_File != INVALID_HANDLE_VALUE)
+            CloseHandle(m_File);
+
+        m_Mapping   = nullptr;
+        m_File      = INVALID_HANDLE_VALUE;
+    #else
+        if (m_Data)
+            munmap(const_cast<uint8*>(m_Data), m_Size);
+    #endif
+
+        m_Data          = nullptr;
+        m_Size          = 0;
+        m_Sections      = nullptr;
+        m_Strings       = nullptr;
+        m_StringSize    = 0;
+    }
+    /// Check if a snapshot is mapped
+    bool DataSnapshot::IsOpen() const
+    {
+        return m_Data != nullptr;
+    }
+
+    /// Get string of the string pool
+    /// @p_String : String
+    std::string_view DataSnapshot::GetString(DataSnapshotString const& p_String) const
+    {
+        if (!m_Strings || static_cast<std::size_t>(p_String.Offset) + p_String.Length > m_StringSize)
+            return std::string_view();
+
+        return std::string_view(m_Strings + p_String.Offset, p_String.Length);
+    }
+    /// Get version of the database the snapshot was taken from
+    uint64 DataSnapshot::GetDataVersion() const
+    {
+        return m_Data ? reinterpret_cast<DataSnapshotHeader const*>(m_Data)->DataVersion : 0;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Find section
+    /// @p_Id : Id of section
+    DataSnapshotSection const* DataSnapshot::FindSection(uint32 p_Id) const
+    {
+        if (!m_Sections)
+            return nullptr;
+
+        const uint32 l_Count = reinterpret_cast<DataSnapshotHeader const*>(m_Data)->SectionCount;
+
+        for (uint32 l_I = 0; l_I < l_Count; l_I++)
+        {
+            if (m_Sections[l_I].Id == p_Id)
+                return &m_Sections[l_I];
+        }
+
+        return nullptr;
+    }
+    /// Check header, section table and checksum of the mapping
+    /// @p_Layout      : Version of the records expected
+    /// @p_DataVersion : Version of the database expected
+    bool DataSnapshot::Validate(uint32 p_Layout, uint64 p_DataVersion) const
+    {
+        DataSnapshotHeader const* l_Header = reinterpret_cast<DataSnapshotHeader const*>(m_Data);
+
+        if (l_Header->Magic != DATA_SNAPSHOT_MAGIC || l_Header->Format != DATA_SNAPSHOT_FORMAT)
+        {
+            LOG_WARNING("Database", "Snapshot is not of format %0, ignoring it", DATA_SNAPSHOT_FORMAT);
+            return false;
+        }
+
+        if (l_Header->Layout != p_Layout || l_Header->DataVersion != p_DataVersion)
+        {
+            LOG_INFO("Database", "Snapshot is stale (layout %0, data version %1), expected layout %2, data version %3", l_Header->Layout, l_Header->DataVersion, p_Layout, p_DataVersion);
+            return false;
+        }
+
+        if (l_Header->FileSize != m_Size || (m_Size - sizeof(DataSnapshotHeader)) / sizeof(DataSnapshotSection) < l_Header->SectionCount)
+        {
+            LOG_WARNING("Database", "Snapshot is truncated, ignoring it");
+            return false;
+        }
+
+        DataSnapshotSection const* l_Sections = reinterpret_cast<DataSnapshotSection const*>(m_Data + sizeof(DataSnapshotHeader));
+
+        for (uint32 l_I = 0; l_I < l_Header->SectionCount; l_I++)
+        {
+            DataSnapshotSection const& l_Section = l_Sections[l_I];
+
+            if (l_Section.Offset % DATA_SNAPSHOT_ALIGNMENT || l_Section.Offset > m_Size
+                || (l_Section.RecordSize && l_Section.Count > (m_Size - l_Section.Offset) / l_Section.RecordSize))
+            {
+                LOG_WARNING("Database", "Snapshot section %0 is out of bounds, ignoring it", l_Section.Id);
+                return false;
+            }
+        }
+
+        if (ComputeChecksum(m_Data + sizeof(DataSnapshotHeader), m_Size - sizeof(DataSnapshotHeader)) != l_Header->Checksum)
+        {
+            LOG_WARNING("Database", "Snapshot checksum does not match, ignoring it");
+            return false;
+        }
+
+        return true;
+    }
+
+}   ///< namespace Database
+}   ///< namespace Core
+}   ///< namespace SteerStone
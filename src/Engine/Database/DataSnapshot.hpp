@@ -0,0 +1,233 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <type_traits>
+
+#include "Core/Core.hpp"
+
+#define DATA_SNAPSHOT_MAGIC             0x50414E53      ///< "SNAP", reads differently on a machine of other byte order
+#define DATA_SNAPSHOT_FORMAT            1               ///< Version of the file layout itself
+#define DATA_SNAPSHOT_ALIGNMENT         64              ///< Alignment of every section in the file
+#define DATA_SNAPSHOT_STRING_SECTION    0xFFFFFFFF      ///< Id of the section holding the string pool
+
+namespace SteerStone { namespace Core { namespace Database {
+
+    class Base;
+
+    /// Start of a snapshot file
+    struct DataSnapshotHeader
+    {
+        uint32 Magic;                       ///< DATA_SNAPSHOT_MAGIC
+        uint32 Format;                      ///< DATA_SNAPSHOT_FORMAT
+        uint32 Layout;                      ///< Version of the records, bumped by the owner when a struct changes
+        uint32 SectionCount;                ///< Amount of sections following the header
+        uint64 DataVersion;                 ///< Version of the database the snapshot was taken from
+        uint64 FileSize;                    ///< Size of the whole file
+        uint64 Checksum;                    ///< Checksum of everything after the header
+    };
+
+    /// Entry of the section table following the header
+    struct DataSnapshotSection
+    {
+        uint32 Id;                          ///< Id chosen by the owner
+        uint32 RecordSize;                  ///< sizeof of one record, checked against the type it is read as
+        uint64 Offset;                      ///< Offset of first record from start of file
+        uint64 Count;                       ///< Amount of records
+    };
+
+    /// String stored in the string pool, records hold these instead of std::string
+    struct DataSnapshotString
+    {
+        uint32 Offset;                      ///< Offset in string pool
+        uint32 Length;                      ///< Length, without the terminator
+    };
+
+    /// Read only view of the records of a section, points straight into the mapping
+    template<typename T> class DataSnapshotSpan
+    {
+        public:
+            /// Constructor
+            /// @p_Data  : First record
+            /// @p_Count : Amount of records
+            DataSnapshotSpan(T const* p_Data = nullptr, std::size_t p_Count = 0)
+                : m_Data(p_Data), m_Count(p_Count)
+            {
+            }
+
+            /// Get first record
+            T const* begin() const { return m_Data; }
+            /// Get end of records
+            T const* end() const { return m_Data + m_Count; }
+            /// Get amount of records
+            std::size_t size() const { return m_Count; }
+            /// Check if there are no records
+            bool empty() const { return m_Count == 0; }
+            /// [] Operator
+            /// @p_Index : Index of record
+            T const& operator[](std::size_t p_Index) const { return m_Data[p_Index]; }
+
+        private:
+            T const* m_Data;                ///< First record
+            std::size_t m_Count;            ///< Amount of records
+    };
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Collects records after a successful load from the database and writes them as a snapshot
+    /// Records must be trivially copyable and hold no pointers, strings go through AddString
+    class DataSnapshotWriter
+    {
+        DISALLOW_COPY_AND_ASSIGN(DataSnapshotWriter);
+
+        private:
+            /// Section waiting to be written
+            struct PendingSection
+            {
+                uint32 Id;                          ///< Id chosen by the owner
+                uint32 RecordSize;                  ///< sizeof of one record
+                uint64 Count;                       ///< Amount of records
+                std::vector<uint8> Data;            ///< Records
+            };
+
+        public:
+            /// Constructor
+            /// @p_Layout      : Version of the records, bumped by the owner when a struct changes
+            /// @p_DataVersion : Version of the database the records were loaded from
+            DataSnapshotWriter(uint32 p_Layout, uint64 p_DataVersion);
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Add section of records
+            /// @p_Id      : Id of section
+            /// @p_Records : Records
+            template<typename T> void AddSection(uint32 p_Id, std::vector<T> const& p_Records)
+            {
+                static_assert(std::is_trivially_copyable<T>::value, "Snapshot records are used in place and must be trivially copyable");
+
+                AddSection(p_Id, static_cast<uint32>(sizeof(T)), p_Records.data(), p_Records.size());
+            }
+            /// Add section of raw records
+            /// @p_Id         : Id of section
+            /// @p_RecordSize : sizeof of one record
+            /// @p_Data       : Records
+            /// @p_Count      : Amount of records
+            void AddSection(uint32 p_Id, uint32 p_RecordSize, void const* p_Data, std::size_t p_Count);
+            /// Add string to the string pool
+            /// @p_String : String
+            DataSnapshotString AddString(std::string_view p_String);
+
+            /// Write snapshot, written next to the path first and renamed so a crash never leaves half a file
+            /// @p_Path : Path of snapshot
+            bool Write(std::string const& p_Path) const;
+
+        private:
+            uint32 m_Layout;                                ///< Version of the records
+            uint64 m_DataVersion;                           ///< Version of the database
+            std::vector<PendingSection> m_Sections;         ///< Sections in order added
+            std::string m_Strings;                          ///< String pool
+    };
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Snapshot of static data mapped read only into memory, records are used in place without parsing
+    /// Spans and strings stay valid as long as the snapshot is open
+    class DataSnapshot
+    {
+        DISALLOW_COPY_AND_ASSIGN(DataSnapshot);
+
+        public:
+            /// Get version of the data in the database by a query returning a single unsigned BIGINT, e.g. a content
+            /// version row bumped by the tools, or CAST(UNIX_TIMESTAMP(MAX(UPDATE_TIME)) AS UNSIGNED) of information_schema.TABLES
+            /// @p_Database : Database
+            /// @p_Query    : Query
+            /// @p_Version  : Version
+            /// Returns false if the query failed
+            static bool QueryDataVersion(Base* p_Database, char const* p_Query, uint64& p_Version);
+            /// Compute checksum of a block
+            /// @p_Data   : Data
+            /// @p_Length : Length of data
+            static uint64 ComputeChecksum(uint8 const* p_Data, std::size_t p_Length);
+
+        public:
+            /// Constructor
+            DataSnapshot();
+            /// Deconstructor
+            ~DataSnapshot();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Map snapshot and check it against the expected versions
+            /// @p_Path        : Path of snapshot
+            /// @p_Layout      : Version of the records expected by the caller
+            /// @p_DataVersion : Version of the database, the snapshot is refused if it was taken from another
+            /// Returns false if file is missing, corrupt or stale, the caller loads from the database and writes a new one
+            bool Open(std::string const& p_Path, uint32 p_Layout, uint64 p_DataVersion);
+            /// Unmap snapshot
+            void Close();
+            /// Check if a snapshot is mapped
+            bool IsOpen() const;
+
+            /// Get records of a section
+            /// @p_Id : Id of section
+            /// Returns an empty span if section is missing or its records are not of this size
+            template<typename T> DataSnapshotSpan<T> Get(uint32 p_Id) const
+            {
+                static_assert(std::is_trivially_copyable<T>::value, "Snapshot records are used in place and must be trivially copyable");
+
+                DataSnapshotSection const* l_Section = FindSection(p_Id);
+                if (!l_Section || l_Section->RecordSize != sizeof(T))
+                    return DataSnapshotSpan<T>();
+
+                return DataSnapshotSpan<T>(reinterpret_cast<T const*>(m_Data + l_Section->Offset), static_cast<std::size_t>(l_Section->Count));
+            }
+            /// Get string of the string pool
+            /// @p_String : String
+            std::string_view GetString(DataSnapshotString const& p_String) const;
+            /// Get version of the database the snapshot was taken from
+            uint64 GetDataVersion() const;
+
+        private:
+            /// Find section
+            /// @p_Id : Id of section
+            DataSnapshotSection const* FindSection(uint32 p_Id) const;
+            /// Check header, section table and checksum of the mapping
+            /// @p_Layout      : Version of the records expected
+            /// @p_DataVersion : Version of the database expected
+            bool Validate(uint32 p_Layout, uint64 p_DataVersion) const;
+
+        private:
+            uint8 const* m_Data;                            ///< Start of mapping
+            std::size_t m_Size;                             ///< Size of mapping
+            DataSnapshotSection const* m_Sections;          ///< Section table, in mapping
+            char const* m_Strings;                          ///< String pool, in mapping
+            std::size_t m_StringSize;                       ///< Size of string pool
+    #ifdef _WIN32
+            void* m_File;                                   ///< File handle
+            void* m_Mapping;                                ///< Mapping handle
+    #endif
+    };
+
+}   ///< namespace Database
+}   ///< namespace Core
+}   ///< namespace SteerStone
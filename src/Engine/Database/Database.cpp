@@ -18,20 +18,32 @@
 
 #include "Database/Database.hpp"
 #include "Database/SQLCommon.hpp"
+#include "Database/TransactionOperator.hpp"
 #include "Utility/UtiString.hpp"
+#include "Utility/UtiTokenizer.hpp"
 #include "Threading/ThrTaskManager.hpp"
+#include "Threading/ThrThisThread.hpp"
+#include "Logger/LogDefines.hpp"
+#include "Metrics/MetRegistry.hpp"
 
 namespace SteerStone { namespace Core { namespace Database {
 
     /// Constructor
     Base::Base()
+        : m_Replicas(this), m_WorkerQueueLimit(0), m_GlobalQueueLimit(0), m_RejectedCount(0), m_DroppedCount(0)
     {
     }
 
     /// Deconstructor
     Base::~Base()
     {
+        for (uint64 l_Id : m_MetricsCallbacks)
+            sMetrics->RemoveCallback(l_Id);
+
         m_Workers.clear();
+#ifdef DATABASE_NONBLOCKING
+        m_AsyncWorkers.clear();
+#endif
     }
 
     //////////////////////////////////////////////////////////////////////////
@@ -41,7 +53,8 @@ namespace SteerStone { namespace Core { namespace Database {
     /// @p_InfoString : Database user details; username, password, host, database, l_Port
     /// @p_PoolSize : How many pool connections database will launch
     /// @p_WorkerThreads : Amount of workers to spawn
-    bool Base::Start(char const* p_InfoString, uint32 p_PoolSize, uint32 p_WorkerThreads)
+    /// @p_NonBlocking : Drive connections through the non blocking API, each worker keeps all of its connections busy
+    bool Base::Start(std::string_view const p_InfoString, uint32 p_PoolSize, uint32 p_WorkerThreads, bool p_NonBlocking)
     {
         /// Check if pool size is within our requirements
         if (p_PoolSize < MIN_CONNECTION_POOL_SIZE)
@@ -49,31 +62,57 @@ namespace SteerStone { namespace Core { namespace Database {
         else if (p_PoolSize > MAX_CONNECTION_POOL_SIZE)
             p_PoolSize = MAX_CONNECTION_POOL_SIZE;
 
-        std::string l_Username;
-        std::string l_Password;
-        std::string l_Database;
-        std::string l_Host;
-        std::string l_Port;
-
-        std::vector<std::string> l_Tokens = Utils::SplitAll(p_InfoString, ";", false);
+        /// host;port;username;password;database
+        std::array<std::string_view, 5> l_Tokens;
+        Utils::SplitInto(p_InfoString, ";", l_Tokens);
 
-        auto& l_Itr = l_Tokens.begin();
+        uint32 l_Port = 0;
+        if (!Utils::ParseNumber(l_Tokens[1], l_Port))
+        {
+            LOG_ERROR("Database", "Invalid port \"%0\" in database info string", l_Tokens[1]);
+            return false;
+        }
 
-        if (l_Itr != l_Tokens.end())
-            l_Host = *l_Itr++;
-        if (l_Itr != l_Tokens.end())
-            l_Port = *l_Itr++;
-        if (l_Itr != l_Tokens.end())
-            l_Username = *l_Itr++;
-        if (l_Itr != l_Tokens.end())
-            l_Password = *l_Itr++;
-        if (l_Itr != l_Tokens.end())
-            l_Database = *l_Itr++;
+#ifndef DATABASE_NONBLOCKING
+        if (p_NonBlocking)
+        {
+            LOG_WARNING("Database", "MySQL client library has no non blocking API, using blocking workers");
+            p_NonBlocking = false;
+        }
+#endif
 
-        if (!Connect(l_Username, l_Password, std::stoi(l_Port), l_Host, l_Database, p_PoolSize, this))
+        if (!Connect(std::string(l_Tokens[2]), std::string(l_Tokens[3]), l_Port, std::string(l_Tokens[0]), std::string(l_Tokens[4]), p_PoolSize, this, p_NonBlocking))
         {
+#ifdef DATABASE_NONBLOCKING
+            if (p_NonBlocking && GetConnections().front()->IsNonBlocking())
+            {
+                /// More workers than connections would leave workers without anything to drive
+                const uint32 l_WorkerCount = std::max<uint32>(1, std::min<uint32>(p_WorkerThreads, static_cast<uint32>(GetConnections().size())));
+                std::vector<std::vector<std::shared_ptr<MYSQLPreparedStatement>>> l_Connections(l_WorkerCount);
+
+                for (std::size_t l_I = 0; l_I < GetConnections().size(); l_I++)
+                    l_Connections[l_I % l_WorkerCount].push_back(GetConnections()[l_I]);
+
+                for (uint32 l_I = 0; l_I < l_WorkerCount; l_I++)
+                {
+                    m_AsyncWorkers.push_back(std::make_unique<AsyncDatabaseWorker>(l_I, l_Connections[l_I], &m_Breaker));
+
+                    for (auto const& l_Connection : l_Connections[l_I])
+                        m_AsyncRoutes[l_Connection.get()] = m_AsyncWorkers.back().get();
+                }
+
+                LOG_INFO("Database", "Driving %0 connections from %1 non blocking workers", GetConnections().size(), l_WorkerCount);
+
+                RegisterMetrics(std::string(l_Tokens[4]));
+
+                return true;
+            }
+#endif
+
             for (uint8 l_I = 0; l_I < p_WorkerThreads; l_I++)
-                m_Workers.push_back(std::make_unique<DatabaseWorker>(l_I));
+                m_Workers.push_back(std::make_unique<DatabaseWorker>(l_I, &m_Breaker));
+
+            RegisterMetrics(std::string(l_Tokens[4]));
 
             return true;
         }
@@ -81,11 +120,108 @@ namespace SteerStone { namespace Core { namespace Database {
             return false;
     }
 
+    /// Start read only pools of replicas, must be called after Start, replicas which fail to connect are skipped
+    /// Their statements execute on our workers, blocking on non blocking workers
+    /// @p_InfoStrings : Database user details of each replica, separated by a comma; host, port, username, password, database
+    /// @p_PoolSize : How many pool connections each replica will launch
+    /// Returns amount of replicas started
+    uint32 Base::StartReplicas(std::string const& p_InfoStrings, uint32 p_PoolSize)
+    {
+        uint32 l_Started = 0;
+
+        for (std::string_view const l_InfoString : Utils::Split(p_InfoStrings, ","))
+        {
+            const std::string l_Host(*Utils::Split(l_InfoString, ";").begin());
+
+            std::unique_ptr<Base> l_Replica = std::make_unique<Base>();
+            CopyLimits(*l_Replica);
+
+            /// No workers, the primary executes the statements
+            if (!l_Replica->Start(l_InfoString, p_PoolSize, 0))
+            {
+                LOG_WARNING("Database", "Failed to connect to replica %0, skipping", l_Host);
+                continue;
+            }
+
+            m_Replicas.Add(std::move(l_Replica), l_Host);
+            l_Started++;
+        }
+
+        m_Replicas.Start();
+
+        return l_Started;
+    }
+    /// Set replica lag limits, must be called before StartReplicas
+    /// @p_MaxLag            : Milliseconds a replica may trail the primary and still serve reads
+    /// @p_HeartbeatInterval : Milliseconds between heartbeats
+    /// @p_HeartbeatTable    : Table heartbeats are written to
+    /// @p_HeartbeatId       : Row of the heartbeat table owned by this server
+    void Base::SetReplicaLimits(uint32 p_MaxLag, uint32 p_HeartbeatInterval, std::string const& p_HeartbeatTable, uint32 p_HeartbeatId)
+    {
+        m_Replicas.SetLimits(p_MaxLag, p_HeartbeatInterval, p_HeartbeatTable, p_HeartbeatId);
+    }
+
+    /// Set queue limits, operators over them are handled by the policy they were queued with
+    /// @p_WorkerLimit : Operators queued on one worker, 0 only bounds by the queue capacity
+    /// @p_GlobalLimit : Operators queued over all workers, 0 for no limit
+    void Base::SetQueueLimits(uint32 p_WorkerLimit, uint32 p_GlobalLimit)
+    {
+        m_WorkerQueueLimit = p_WorkerLimit;
+        m_GlobalQueueLimit = p_GlobalLimit;
+    }
+    /// Get amount of operators queued or being executed over all workers
+    std::size_t Base::GetQueueDepth() const
+    {
+        std::size_t l_Depth = 0;
+
+        for (auto const& l_Worker : m_Workers)
+            l_Depth += l_Worker->GetSize();
+#ifdef DATABASE_NONBLOCKING
+        for (auto const& l_Worker : m_AsyncWorkers)
+            l_Depth += l_Worker->GetSize();
+#endif
+
+        return l_Depth;
+    }
+
     /// Returns a Prepare Statement from Pool
     PreparedStatement* Base::GetPrepareStatement()
     {
        return Prepare();
     }
+    /// Returns a Prepare Statement from Pool, prepared with a statement of the catalog
+    /// Read only statements come from a replica within lag if there is one
+    /// @p_StatementId : Id of statement in catalog
+    PreparedStatement* Base::GetPrepareStatement(uint32 p_StatementId)
+    {
+        if (m_Replicas.GetReplicaCount() && IsReadOnlyStatement(p_StatementId))
+            if (PreparedStatement* l_ReplicaStatement = m_Replicas.GetReadStatement(p_StatementId, false, 0))
+                return l_ReplicaStatement;
+
+        PreparedStatement* l_PreparedStatement = Prepare();
+
+        if (l_PreparedStatement)
+            l_PreparedStatement->PrepareCatalogStatement(p_StatementId);
+
+        return l_PreparedStatement;
+    }
+    /// Returns a Prepare Statement from Pool, prepared with a statement of the catalog
+    /// Read only statements come from a replica which has the recent writes of the session
+    /// @p_StatementId : Id of statement in catalog
+    /// @p_SessionKey : Shard key the session writes with (user id, room id)
+    PreparedStatement* Base::GetPrepareStatement(uint32 p_StatementId, uint64 p_SessionKey)
+    {
+        if (m_Replicas.GetReplicaCount() && IsReadOnlyStatement(p_StatementId))
+            if (PreparedStatement* l_ReplicaStatement = m_Replicas.GetReadStatement(p_StatementId, true, p_SessionKey))
+                return l_ReplicaStatement;
+
+        PreparedStatement* l_PreparedStatement = Prepare();
+
+        if (l_PreparedStatement)
+            l_PreparedStatement->PrepareCatalogStatement(p_StatementId);
+
+        return l_PreparedStatement;
+    }
     /// @p_PreparedStatement : Connection we are freeing
     void Base::FreePrepareStatement(PreparedStatement* p_PreparedStatement)
     {
@@ -95,16 +231,123 @@ namespace SteerStone { namespace Core { namespace Database {
 
     /// Execute query on worker thread
     /// @p_PrepareStatementHolder : PrepareStatement which will be executed on database worker thread
-    CallBackOperator Base::PrepareOperator(PreparedStatement* p_PrepareStatementHolder)
+    /// @p_Policy : What happens when queues are over their limits or the circuit breaker is open
+    CallBackOperator Base::PrepareOperator(PreparedStatement* p_PrepareStatementHolder, QueuePolicy p_Policy)
     {
+        /// Recorded before queueing, the statement may be executed and freed once queued
+        if (m_WorkloadCapture.IsEnabled())
+            m_WorkloadCapture.Record(p_PrepareStatementHolder, WorkloadRoute::Load);
+
         /// PrepareStatement keeps reference of MYSQLConnection -- keep note
         PrepareStatementOperator* l_PrepareStatementOperator = new PrepareStatementOperator(p_PrepareStatementHolder);
 
+        /// Taken before queueing, a rejected operator is gone once EnqueueOperator returns
+        std::future<std::unique_ptr<PreparedResultSet>> l_Future = l_PrepareStatementOperator->GetFuture();
+
         /// Keep reference of statement operator to execute query
-        EnqueueOperator(l_PrepareStatementOperator);
+        EnqueueOperator(l_PrepareStatementOperator, p_Policy);
 
         /// Return our CallBackOperator which gets the result from database worker thread
-        return CallBackOperator(std::move(l_PrepareStatementOperator->GetFuture()));
+        return CallBackOperator(std::move(l_Future));
+    }
+    /// Execute query on the worker owning a shard key, operators of one key execute in the order they were queued
+    /// @p_PrepareStatementHolder : PrepareStatement which will be executed on database worker thread
+    /// @p_ShardKey : Key writes are ordered by (user id, room id)
+    /// @p_Policy : What happens when queues are over their limits or the circuit breaker is open
+    CallBackOperator Base::PrepareOperator(PreparedStatement* p_PrepareStatementHolder, uint64 p_ShardKey, QueuePolicy p_Policy)
+    {
+        /// Reads of the session go to the primary until replicas have caught up with this write
+        if (!p_PrepareStatementHolder->IsReadOnly())
+            m_Replicas.OnWrite(p_ShardKey);
+
+        if (m_WorkloadCapture.IsEnabled())
+            m_WorkloadCapture.Record(p_PrepareStatementHolder, WorkloadRoute::Keyed, p_ShardKey);
+
+        PrepareStatementOperator* l_PrepareStatementOperator = new PrepareStatementOperator(p_PrepareStatementHolder);
+        std::future<std::unique_ptr<PreparedResultSet>> l_Future = l_PrepareStatementOperator->GetFuture();
+
+        EnqueueOperator(l_PrepareStatementOperator, p_Policy, true, p_ShardKey);
+
+        return CallBackOperator(std::move(l_Future));
+    }
+    /// Execute query on worker thread, the callback is posted to the completion queue of the caller once done
+    /// @p_PrepareStatementHolder : PrepareStatement which will be executed on database worker thread
+    /// @p_Queue : Completion queue of the owner, must outlive the query
+    /// @p_Callback : Callback run by the owner with the result
+    /// @p_Policy : What happens when queues are over their limits or the circuit breaker is open
+    void Base::PrepareOperator(PreparedStatement* p_PrepareStatementHolder, CompletionQueue* p_Queue, CompletionQueue::ResultCallback p_Callback, QueuePolicy p_Policy)
+    {
+        if (m_WorkloadCapture.IsEnabled())
+            m_WorkloadCapture.Record(p_PrepareStatementHolder, WorkloadRoute::Load);
+
+        EnqueueOperator(new PrepareStatementOperator(p_PrepareStatementHolder, p_Queue, std::move(p_Callback)), p_Policy);
+    }
+    /// Execute query on the worker owning a shard key, the callback is posted to the completion queue of the caller once done
+    /// @p_PrepareStatementHolder : PrepareStatement which will be executed on database worker thread
+    /// @p_ShardKey : Key writes are ordered by (user id, room id)
+    /// @p_Queue : Completion queue of the owner, must outlive the query
+    /// @p_Callback : Callback run by the owner with the result
+    /// @p_Policy : What happens when queues are over their limits or the circuit breaker is open
+    void Base::PrepareOperator(PreparedStatement* p_PrepareStatementHolder, uint64 p_ShardKey, CompletionQueue* p_Queue, CompletionQueue::ResultCallback p_Callback, QueuePolicy p_Policy)
+    {
+        if (!p_PrepareStatementHolder->IsReadOnly())
+            m_Replicas.OnWrite(p_ShardKey);
+
+        if (m_WorkloadCapture.IsEnabled())
+            m_WorkloadCapture.Record(p_PrepareStatementHolder, WorkloadRoute::Keyed, p_ShardKey);
+
+        EnqueueOperator(new PrepareStatementOperator(p_PrepareStatementHolder, p_Queue, std::move(p_Callback)), p_Policy, true, p_ShardKey);
+    }
+
+    /// Start a transaction, holds one statement of the pool until it is done
+    /// Returns nullptr if no statement was freed within the wait timeout
+    std::unique_ptr<Transaction> Base::BeginTransaction()
+    {
+        PreparedStatement* l_Reservation = Prepare();
+
+        if (!l_Reservation)
+            return nullptr;
+
+        return std::make_unique<Transaction>(l_Reservation);
+    }
+    /// Execute every step of the transaction on worker thread in one dispatch
+    /// @p_Transaction : Transaction being executed
+    /// @p_Policy : What happens when queues are over their limits or the circuit breaker is open
+    /// Returns future set to true once committed, false if rolled back
+    std::future<bool> Base::CommitTransaction(std::unique_ptr<Transaction> p_Transaction, QueuePolicy p_Policy)
+    {
+        TransactionOperator* l_TransactionOperator = new TransactionOperator(std::move(p_Transaction));
+        std::future<bool> l_Future = l_TransactionOperator->GetFuture();
+
+        /// Runs blocking on its connection, non blocking workers execute it in place as well
+        EnqueueOperator(l_TransactionOperator, p_Policy);
+
+        return l_Future;
+    }
+    /// Execute every step of the transaction on the worker owning a shard key
+    /// @p_Transaction : Transaction being executed
+    /// @p_ShardKey : Key writes are ordered by (user id, room id)
+    /// @p_Policy : What happens when queues are over their limits or the circuit breaker is open
+    /// Returns future set to true once committed, false if rolled back
+    std::future<bool> Base::CommitTransaction(std::unique_ptr<Transaction> p_Transaction, uint64 p_ShardKey, QueuePolicy p_Policy)
+    {
+        m_Replicas.OnWrite(p_ShardKey);
+
+        TransactionOperator* l_TransactionOperator = new TransactionOperator(std::move(p_Transaction));
+        std::future<bool> l_Future = l_TransactionOperator->GetFuture();
+
+        EnqueueOperator(l_TransactionOperator, p_Policy, true, p_ShardKey);
+
+        return l_Future;
+    }
+    /// Execute every step of the transaction on worker thread, the callback is posted to the completion queue of the caller
+    /// @p_Transaction : Transaction being executed
+    /// @p_Queue : Completion queue of the owner, must outlive the transaction
+    /// @p_Callback : Callback run by the owner, true once committed
+    /// @p_Policy : What happens when queues are over their limits or the circuit breaker is open
+    void Base::CommitTransaction(std::unique_ptr<Transaction> p_Transaction, CompletionQueue* p_Queue, std::function<void(bool)> p_Callback, QueuePolicy p_Policy)
+    {
+        EnqueueOperator(new TransactionOperator(std::move(p_Transaction), p_Queue, std::move(p_Callback)), p_Policy);
     }
 
     //////////////////////////////////////////////////////////////////////////
@@ -112,20 +355,107 @@ namespace SteerStone { namespace Core { namespace Database {
 
     /// Pass operator to worker thread
     /// @p_Operator : Operator we are adding to be processed on database worker thread
-    void Base::EnqueueOperator(Operator* p_Operator)
+    /// @p_Policy : What happens when queues are over their limits or the circuit breaker is open
+    /// @p_Keyed : Route by p_ShardKey instead of load
+    /// @p_ShardKey : Key operator is ordered by
+    void Base::EnqueueOperator(Operator* p_Operator, QueuePolicy p_Policy, bool p_Keyed, uint64 p_ShardKey)
     {
-        auto l_Worker = SelectWorker();
+        p_Operator->SetQueueTime();
+
+#ifdef DATABASE_NONBLOCKING
+        if (!m_AsyncWorkers.empty())
+        {
+            /// Statements run on the worker owning their connection, each connection executes in queue order
+            /// so shard keys add nothing here: ordering follows the connection the statement was taken from
+            PreparedStatement* l_Statement = p_Operator->GetPreparedStatement();
+            auto l_Itr = l_Statement ? m_AsyncRoutes.find(l_Statement->GetConnection()) : m_AsyncRoutes.end();
+            AsyncDatabaseWorker* l_Worker = l_Itr != m_AsyncRoutes.end() ? l_Itr->second : SelectAsyncWorker();
+
+            if (Admit(p_Operator, p_Policy, l_Worker))
+                l_Worker->AddOperator(p_Operator);
 
-        l_Worker->AddOperator(p_Operator);
+            return;
+        }
+#endif
+
+        /// A worker executes its queue in order, so one key always landing on the same worker keeps its writes ordered
+        auto l_Worker = p_Keyed ? SelectWorker(p_ShardKey) : SelectWorker();
+
+        if (Admit(p_Operator, p_Policy, l_Worker))
+            l_Worker->AddOperator(p_Operator);
+    }
+    /// Check operator may be queued on a worker, blocking operators wait until it may
+    /// @p_Operator : Operator being queued
+    /// @p_Policy : Policy operator was queued with
+    /// @p_Worker : Worker operator is queued on
+    /// Returns false if operator has been rejected and deleted
+    template<typename Worker> bool Base::Admit(Operator* p_Operator, QueuePolicy p_Policy, Worker* p_Worker)
+    {
+        if (p_Policy == QueuePolicy::Block)
+        {
+            /// Full worker queues block in AddOperator already, soft limits are waited out here
+            while (IsOverLimit(p_Worker->GetSize()))
+                Threading::ThisThread::SleepFor(1);
+
+            return true;
+        }
+
+        /// Limits are checked first, an open breaker letting a trial through must see it queued
+        if (!IsOverLimit(p_Worker->GetSize()) && m_Breaker.Allow())
+            return true;
+
+        if (p_Policy == QueuePolicy::FailFast)
+            m_RejectedCount.fetch_add(1, std::memory_order_relaxed);
+        else
+            m_DroppedCount.fetch_add(1, std::memory_order_relaxed);
+
+        p_Operator->Reject(p_Policy == QueuePolicy::FailFast);
+        delete p_Operator;
+
+        return false;
+    }
+    /// Check queues are over their limits
+    /// @p_WorkerSize : Size of worker the operator is queued on
+    bool Base::IsOverLimit(std::size_t p_WorkerSize) const
+    {
+        if (m_WorkerQueueLimit && p_WorkerSize >= m_WorkerQueueLimit)
+            return true;
+
+        return m_GlobalQueueLimit && GetQueueDepth() >= m_GlobalQueueLimit;
+    }
+
+    /// Register queue depth and admission series of workers, called once workers are spawned
+    /// @p_Database : Database name series are labelled with
+    void Base::RegisterMetrics(std::string const& p_Database)
+    {
+        for (std::size_t l_I = 0; l_I < m_Workers.size(); l_I++)
+        {
+            DatabaseWorker* l_Worker = m_Workers[l_I].get();
+            m_MetricsCallbacks.push_back(sMetrics->AddCallback("steerstone_database_worker_queue", "Operators queued or being executed on a database worker", Metrics::MetricType::Gauge,
+                { { "database", p_Database }, { "worker", std::to_string(l_I) } }, [l_Worker]() { return static_cast<double>(l_Worker->GetSize()); }));
+        }
+#ifdef DATABASE_NONBLOCKING
+        for (std::size_t l_I = 0; l_I < m_AsyncWorkers.size(); l_I++)
+        {
+            AsyncDatabaseWorker* l_Worker = m_AsyncWorkers[l_I].get();
+            m_MetricsCallbacks.push_back(sMetrics->AddCallback("steerstone_database_worker_queue", "Operators queued or being executed on a database worker", Metrics::MetricType::Gauge,
+                { { "database", p_Database }, { "worker", std::to_string(l_I) } }, [l_Worker]() { return static_cast<double>(l_Worker->GetSize()); }));
+        }
+#endif
+
+        m_MetricsCallbacks.push_back(sMetrics->AddCallback("steerstone_database_rejected_total", "Operators failed fast because queues were full or the circuit breaker was open", Metrics::MetricType::Counter,
+            { { "database", p_Database } }, [this]() { return static_cast<double>(m_RejectedCount.load(std::memory_order_relaxed)); }));
+        m_MetricsCallbacks.push_back(sMetrics->AddCallback("steerstone_database_dropped_total", "Operators dropped because queues were full or the circuit breaker was open", Metrics::MetricType::Counter,
+            { { "database", p_Database } }, [this]() { return static_cast<double>(m_DroppedCount.load(std::memory_order_relaxed)); }));
     }
 
     /// Select the worker with lowest storage size (equal distrubition)
     DatabaseWorker* Base::SelectWorker() const
     {
-        std::size_t l_MinimumSize = m_Workers.size();
-        int32 l_Index = 0;
+        std::size_t l_MinimumSize = m_Workers[0]->GetSize();
+        std::size_t l_Index = 0;
 
-        for (std::size_t l_I = 0; l_I < m_Workers.size(); l_I++)
+        for (std::size_t l_I = 1; l_I < m_Workers.size() && l_MinimumSize; l_I++)
         {
             const std::size_t l_Size = m_Workers[l_I]->GetSize();
 
@@ -138,6 +468,31 @@ namespace SteerStone { namespace Core { namespace Database {
 
         return m_Workers[l_Index].get();
     }
+    /// Select the worker owning a shard key, fixed for the life of the workers
+    /// @p_ShardKey : Key
+    DatabaseWorker* Base::SelectWorker(uint64 p_ShardKey) const
+    {
+        /// Fibonacci hashing spreads sequential ids over every worker
+        const uint64 l_Hash = (p_ShardKey * 0x9E3779B97F4A7C15ULL) >> 32;
+
+        return m_Workers[static_cast<std::size_t>(l_Hash % m_Workers.size())].get();
+    }
+
+#ifdef DATABASE_NONBLOCKING
+    /// Select the non blocking worker with lowest storage size
+    AsyncDatabaseWorker* Base::SelectAsyncWorker() const
+    {
+        AsyncDatabaseWorker* l_Worker = m_AsyncWorkers.front().get();
+
+        for (auto const& l_Itr : m_AsyncWorkers)
+        {
+            if (l_Itr->GetSize() < l_Worker->GetSize())
+                l_Worker = l_Itr.get();
+        }
+
+        return l_Worker;
+    }
+#endif
 
 }   ///< namespace Database
 }   ///< namespace Core
@@ -18,7 +18,14 @@
 
 #pragma once
 #include "DatabaseWorker.hpp"
+#include "AsyncDatabaseWorker.hpp"
 #include "Database/PreparedStatements.hpp"
+#include "Database/QueryProfiler.hpp"
+#include "Database/CircuitBreaker.hpp"
+#include "Database/ReplicaSet.hpp"
+#include "Database/WorkloadCapture.hpp"
+#include "Database/Transaction.hpp"
+#include "Database/RowMapper.hpp"
 
 namespace SteerStone { namespace Core { namespace Database {
 
@@ -42,17 +49,124 @@ namespace SteerStone { namespace Core { namespace Database {
         /// @p_InfoString : Database user details; username, password, host, database, l_Port
         /// @p_PoolSize : How many pool connections database will launch
         /// @p_WorkerThreads : Amount of workers to spawn
-        bool Start(char const* p_InfoString, uint32 p_PoolSize, uint32 p_WorkerThreads);
+        /// @p_NonBlocking : Drive connections through the non blocking API, each worker keeps all of its connections busy
+        bool Start(std::string_view const p_InfoString, uint32 p_PoolSize, uint32 p_WorkerThreads, bool p_NonBlocking = false);
+        /// Start read only pools of replicas, must be called after Start, replicas which fail to connect are skipped
+        /// Their statements execute on our workers, blocking on non blocking workers
+        /// @p_InfoStrings : Database user details of each replica, separated by a comma; host, port, username, password, database
+        /// @p_PoolSize : How many pool connections each replica will launch
+        /// Returns amount of replicas started
+        uint32 StartReplicas(std::string const& p_InfoStrings, uint32 p_PoolSize);
+        /// Set replica lag limits, must be called before StartReplicas
+        /// @p_MaxLag            : Milliseconds a replica may trail the primary and still serve reads
+        /// @p_HeartbeatInterval : Milliseconds between heartbeats
+        /// @p_HeartbeatTable    : Table heartbeats are written to
+        /// @p_HeartbeatId       : Row of the heartbeat table owned by this server
+        void SetReplicaLimits(uint32 p_MaxLag, uint32 p_HeartbeatInterval, std::string const& p_HeartbeatTable, uint32 p_HeartbeatId);
 
         /// Returns a Prepare Statement from Pool
         PreparedStatement* GetPrepareStatement();
+        /// Returns a Prepare Statement from Pool, prepared with a statement of the catalog
+        /// Read only statements come from a replica within lag if there is one
+        /// @p_StatementId : Id of statement in catalog
+        PreparedStatement* GetPrepareStatement(uint32 p_StatementId);
+        /// Returns a Prepare Statement from Pool, prepared with a statement of the catalog
+        /// Read only statements come from a replica which has the recent writes of the session
+        /// @p_StatementId : Id of statement in catalog
+        /// @p_SessionKey : Shard key the session writes with (user id, room id)
+        PreparedStatement* GetPrepareStatement(uint32 p_StatementId, uint64 p_SessionKey);
         /// Free Prepare Statement
         /// @p_PreparedStatement : Connection we are freeing
         void FreePrepareStatement(PreparedStatement* p_PreparedStatement);
 
         /// Execute query on worker thread
         /// @p_PrepareStatementHolder : PrepareStatement which will be executed on database worker thread
-        CallBackOperator PrepareOperator(PreparedStatement* p_PrepareStatementHolder);
+        /// @p_Policy : What happens when queues are over their limits or the circuit breaker is open
+        CallBackOperator PrepareOperator(PreparedStatement* p_PrepareStatementHolder, QueuePolicy p_Policy = QueuePolicy::Block);
+        /// Execute query on the worker owning a shard key, operators of one key execute in the order they were queued
+        /// @p_PrepareStatementHolder : PrepareStatement which will be executed on database worker thread
+        /// @p_ShardKey : Key writes are ordered by (user id, room id)
+        /// @p_Policy : What happens when queues are over their limits or the circuit breaker is open
+        CallBackOperator PrepareOperator(PreparedStatement* p_PrepareStatementHolder, uint64 p_ShardKey, QueuePolicy p_Policy = QueuePolicy::Block);
+        /// Execute query on worker thread, the callback is posted to the completion queue of the caller once done
+        /// @p_PrepareStatementHolder : PrepareStatement which will be executed on database worker thread
+        /// @p_Queue : Completion queue of the owner, must outlive the query
+        /// @p_Callback : Callback run by the owner with the result
+        /// @p_Policy : What happens when queues are over their limits or the circuit breaker is open
+        void PrepareOperator(PreparedStatement* p_PrepareStatementHolder, CompletionQueue* p_Queue, CompletionQueue::ResultCallback p_Callback, QueuePolicy p_Policy = QueuePolicy::Block);
+        /// Execute query on the worker owning a shard key, the callback is posted to the completion queue of the caller once done
+        /// @p_PrepareStatementHolder : PrepareStatement which will be executed on database worker thread
+        /// @p_ShardKey : Key writes are ordered by (user id, room id)
+        /// @p_Queue : Completion queue of the owner, must outlive the query
+        /// @p_Callback : Callback run by the owner with the result
+        /// @p_Policy : What happens when queues are over their limits or the circuit breaker is open
+        void PrepareOperator(PreparedStatement* p_PrepareStatementHolder, uint64 p_ShardKey, CompletionQueue* p_Queue, CompletionQueue::ResultCallback p_Callback, QueuePolicy p_Policy = QueuePolicy::Block);
+        /// Execute query on calling thread and decode its rows into a struct described by DATABASE_ROW_FIELDS
+        /// @p_PrepareStatementHolder : PrepareStatement, freed once its rows are decoded
+        /// @p_Rows : Decoded rows are appended here
+        /// Returns false if the query failed or its columns do not match the row
+        template<typename Row> bool Query(PreparedStatement* p_PrepareStatementHolder, std::vector<Row>& p_Rows)
+        {
+            return RowMapper<Row>::Execute(p_PrepareStatementHolder, p_Rows);
+        }
+
+        /// Start a transaction, holds one statement of the pool until it is done
+        /// Returns nullptr if no statement was freed within the wait timeout
+        std::unique_ptr<Transaction> BeginTransaction();
+        /// Execute every step of the transaction on worker thread in one dispatch
+        /// @p_Transaction : Transaction being executed
+        /// @p_Policy : What happens when queues are over their limits or the circuit breaker is open
+        /// Returns future set to true once committed, false if rolled back
+        std::future<bool> CommitTransaction(std::unique_ptr<Transaction> p_Transaction, QueuePolicy p_Policy = QueuePolicy::Block);
+        /// Execute every step of the transaction on the worker owning a shard key
+        /// @p_Transaction : Transaction being executed
+        /// @p_ShardKey : Key writes are ordered by (user id, room id)
+        /// @p_Policy : What happens when queues are over their limits or the circuit breaker is open
+        /// Returns future set to true once committed, false if rolled back
+        std::future<bool> CommitTransaction(std::unique_ptr<Transaction> p_Transaction, uint64 p_ShardKey, QueuePolicy p_Policy = QueuePolicy::Block);
+        /// Execute every step of the transaction on worker thread, the callback is posted to the completion queue of the caller
+        /// @p_Transaction : Transaction being executed
+        /// @p_Queue : Completion queue of the owner, must outlive the transaction
+        /// @p_Callback : Callback run by the owner, true once committed
+        /// @p_Policy : What happens when queues are over their limits or the circuit breaker is open
+        void CommitTransaction(std::unique_ptr<Transaction> p_Transaction, CompletionQueue* p_Queue, std::function<void(bool)> p_Callback, QueuePolicy p_Policy = QueuePolicy::Block);
+
+        /// Set queue limits, operators over them are handled by the policy they were queued with
+        /// @p_WorkerLimit : Operators queued on one worker, 0 only bounds by the queue capacity
+        /// @p_GlobalLimit : Operators queued over all workers, 0 for no limit
+        void SetQueueLimits(uint32 p_WorkerLimit, uint32 p_GlobalLimit);
+        /// Get circuit breaker, its limits may be set before Start
+        CircuitBreaker& GetCircuitBreaker() { return m_Breaker; }
+        /// Get amount of operators queued or being executed over all workers
+        std::size_t GetQueueDepth() const;
+        /// Get amount of operators failed fast on full queues or an open breaker
+        uint64 GetRejectedCount() const { return m_RejectedCount.load(std::memory_order_relaxed); }
+        /// Get amount of operators dropped on full queues or an open breaker
+        uint64 GetDroppedCount() const { return m_DroppedCount.load(std::memory_order_relaxed); }
+
+        /// Pool limits, must be set before Start
+        using PreparedStatements::SetPoolLimits;
+        /// Connection timeout and retries, must be set before Start
+        using PreparedStatements::SetConnectLimits;
+        /// Statement catalog, must be set before Start
+        using PreparedStatements::SetCatalog;
+
+        /// Pool metrics
+        using PreparedStatements::GetPoolCapacity;
+        using PreparedStatements::GetPoolInUse;
+        using PreparedStatements::GetPoolPeakInUse;
+        using PreparedStatements::GetPoolUtilization;
+        using PreparedStatements::GetPoolExhaustedCount;
+        using PreparedStatements::GetPoolTimeoutCount;
+        using PreparedStatements::GetPoolOfflineCount;
+        using PreparedStatements::GetPoolWaitHistogram;
+
+        /// Get per statement profile and slow query log
+        QueryProfiler& GetQueryProfiler() { return m_QueryProfiler; }
+        /// Get capture of statements queued through PrepareOperator, for replaying them later
+        WorkloadCapture& GetWorkloadCapture() { return m_WorkloadCapture; }
+        /// Get replicas read only statements are routed to
+        ReplicaSet const& GetReplicas() const { return m_Replicas; }
 
     //////////////////////////////////////////////////////////////////////////
     //////////////////////////////////////////////////////////////////////////
@@ -60,13 +174,50 @@ namespace SteerStone { namespace Core { namespace Database {
     private:
         /// Pass operator to worker thread
         /// @p_Operator : Operator we are adding to be processed on database worker thread
-        void EnqueueOperator(Operator* p_Operator);
+        /// @p_Policy : What happens when queues are over their limits or the circuit breaker is open
+        /// @p_Keyed : Route by p_ShardKey instead of load
+        /// @p_ShardKey : Key operator is ordered by
+        void EnqueueOperator(Operator* p_Operator, QueuePolicy p_Policy, bool p_Keyed = false, uint64 p_ShardKey = 0);
+        /// Check operator may be queued on a worker, blocking operators wait until it may
+        /// @p_Operator : Operator being queued
+        /// @p_Policy : Policy operator was queued with
+        /// @p_Worker : Worker operator is queued on
+        /// Returns false if operator has been rejected and deleted
+        template<typename Worker> bool Admit(Operator* p_Operator, QueuePolicy p_Policy, Worker* p_Worker);
+        /// Check queues are over their limits
+        /// @p_WorkerSize : Size of worker the operator is queued on
+        bool IsOverLimit(std::size_t p_WorkerSize) const;
+
+        /// Register queue depth and admission series of workers, called once workers are spawned
+        /// @p_Database : Database name series are labelled with
+        void RegisterMetrics(std::string const& p_Database);
 
         /// Select the worker with lowest storage size (equal distrubition)
         DatabaseWorker* SelectWorker() const;
+        /// Select the worker owning a shard key, fixed for the life of the workers
+        /// @p_ShardKey : Key
+        DatabaseWorker* SelectWorker(uint64 p_ShardKey) const;
+
+#ifdef DATABASE_NONBLOCKING
+        /// Select the non blocking worker with lowest storage size
+        AsyncDatabaseWorker* SelectAsyncWorker() const;
+#endif
 
     private:
+        QueryProfiler m_QueryProfiler;                                                          ///< Per statement profile, outlives the workers recording into it
+        ReplicaSet m_Replicas;                                                                  ///< Replica pools, outlive the workers executing their statements
+        CircuitBreaker m_Breaker;                                                               ///< Trips on sustained failures, outlives the workers recording into it
+        WorkloadCapture m_WorkloadCapture;                                                      ///< Statements queued through PrepareOperator, while capturing
+        uint32 m_WorkerQueueLimit;                                                              ///< Operators queued on one worker, 0 for no limit
+        uint32 m_GlobalQueueLimit;                                                              ///< Operators queued over all workers, 0 for no limit
+        std::atomic<uint64> m_RejectedCount;                                                    ///< Operators failed fast
+        std::atomic<uint64> m_DroppedCount;                                                     ///< Operators dropped
         std::vector<std::unique_ptr<DatabaseWorker>> m_Workers;
+        std::vector<uint64> m_MetricsCallbacks;                                                 ///< Series read on scrape, removed before the workers go
+#ifdef DATABASE_NONBLOCKING
+        std::vector<std::unique_ptr<AsyncDatabaseWorker>> m_AsyncWorkers;                       ///< Non blocking workers, replace m_Workers when enabled
+        std::unordered_map<MYSQLPreparedStatement*, AsyncDatabaseWorker*> m_AsyncRoutes;        ///< Worker owning each connection, built once in Start
+#endif
     };
 
 }   ///< namespace Database
@@ -18,34 +18,44 @@
 
 #include "DatabaseWorker.hpp"
 #include "Operator.hpp"
+#include "PreparedStatement.hpp"
+#include "CircuitBreaker.hpp"
 #include "Utility/UtiString.hpp"
+#include "Diagnostic/DiaProfiler.hpp"
+#include "Diagnostic/DiaFlightRecorder.hpp"
+#include "Metrics/MetRegistry.hpp"
 
 namespace SteerStone { namespace Core { namespace Database {
     
     /// Constructor
     /// @p_WorkerThread : Worker thread number spawned
-    DatabaseWorker::DatabaseWorker(uint8 const& p_WorkerThread)
+    /// @p_Breaker : Circuit breaker outcomes are recorded into
+    DatabaseWorker::DatabaseWorker(uint8 const& p_WorkerThread, CircuitBreaker* p_Breaker)
+        : m_Queue(DATABASE_WORKER_QUEUE_CAPACITY), m_Depth(0), m_Breaker(p_Breaker)
     {
-        l_Task = sThreadManager->PushTask(Utils::StringBuilder("DATABASE_WORKER_THREAD_%0", p_WorkerThread), Threading::TaskType::Moderate, -1, std::bind(&DatabaseWorker::Update, this));
+        l_Task = sThreadManager->PushTask(Utils::StringBuilder("DATABASE_WORKER_THREAD_%0", p_WorkerThread), Threading::TaskType::Dedicated, -1, std::bind(&DatabaseWorker::Update, this), p_WorkerThread);
     }
     /// Deconstructor
     DatabaseWorker::~DatabaseWorker()
     {
-        m_Producer.ShutDown();
-        sThreadManager->PopTask(l_Task);
+        /// Operators still queued are executed, Update must be done with us before we go
+        /// Update ends the task itself, popping it from here while it does would deadlock on the join
+        m_Queue.Close();
+        m_Stopped.get_future().wait();
     }
 
     /// Add Operator
     /// @p_Operator : Operater being added
     void DatabaseWorker::AddOperator(Operator* p_Operator)
     {
-        m_Producer.Push(p_Operator);
+        m_Depth.fetch_add(1, std::memory_order_relaxed);
+        m_Queue.Push(p_Operator);
     }
 
-    /// Get size of producer
+    /// Get amount of operators queued or being executed
     const std::size_t DatabaseWorker::GetSize()
     {
-        return m_Producer.GetSize();
+        return m_Depth.load(std::memory_order_relaxed);
     }
 
     //////////////////////////////////////////////////////////////////////////
@@ -53,19 +63,49 @@ namespace SteerStone { namespace Core { namespace Database {
 
     bool DatabaseWorker::Update()
     {
-        while (true)
-        {
-            Operator* l_Operator = nullptr;
-            m_Producer.WaitAndPop(l_Operator);
+        /// Nanoseconds, 100us to 10s
+        static const std::vector<uint64> sl_Bounds = { 100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000, 25000000, 50000000, 100000000, 250000000, 500000000, 1000000000, 10000000000 };
+        static Metrics::Histogram& sl_QueueWait = sMetrics->GetHistogram("steerstone_database_queue_wait_seconds", "Time operators waited in a worker queue", sl_Bounds, 1e-9);
+        static Metrics::Histogram& sl_Execute   = sMetrics->GetHistogram("steerstone_database_execute_seconds", "Time operators took to execute", sl_Bounds, 1e-9);
+
+        Operator* l_Operators[DATABASE_WORKER_BATCH_SIZE];
 
-            if (l_Operator)
+        while (const std::size_t l_Count = m_Queue.WaitPopBatch(l_Operators, DATABASE_WORKER_BATCH_SIZE))
+        {
+            for (std::size_t l_I = 0; l_I < l_Count; l_I++)
             {
-                l_Operator->Execute();
+                const uint64 l_QueueWait = l_Operators[l_I]->GetQueueWait();
+                sl_QueueWait.Observe(l_QueueWait);
+
+                if (PreparedStatement* l_Statement = l_Operators[l_I]->GetPreparedStatement())
+                    l_Statement->RecordQueueWait(l_QueueWait);
+
+                PROFILE_ELAPSED("Database::Queue", l_QueueWait);
+
+                const auto l_Start = std::chrono::steady_clock::now();
 
-                delete l_Operator;
+                Diagnostic::FlightRecorder::Record(Diagnostic::FlightEvent::OperatorStart, "Database::Execute", l_Operators[l_I]->GetId());
+
+                {
+                    PROFILE_ZONE("Database::Execute");
+                    l_Operators[l_I]->Execute();
+                }
+
+                Diagnostic::FlightRecorder::Record(Diagnostic::FlightEvent::OperatorEnd, "Database::Execute", l_Operators[l_I]->GetId());
+
+                const uint64 l_Elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - l_Start).count();
+                sl_Execute.Observe(l_Elapsed);
+
+                m_Breaker->Record(l_Operators[l_I]->HasFailed(), l_Elapsed);
+
+                delete l_Operators[l_I];
+                m_Depth.fetch_sub(1, std::memory_order_relaxed);
             }
         }
 
+        m_Stopped.set_value();
+
+        /// Ending the task retires our worker from its own thread, running again would set our promise twice
         return false;
     }
 
@@ -19,12 +19,18 @@
 #pragma once
 #include <PCH/Precompiled.hpp>
 #include "Core/Core.hpp"
-#include "Database/ProducerQueue.hpp"
+#include "Utility/UtiBoundedQueue.hpp"
 #include "Threading/ThrTaskManager.hpp"
 
+#include <future>
+
+#define DATABASE_WORKER_QUEUE_CAPACITY  8192    ///< Operators queued per worker before producers have to wait
+#define DATABASE_WORKER_BATCH_SIZE      64      ///< Operators taken from queue at once
+
 namespace SteerStone { namespace Core { namespace Database {
 
     class Operator;
+    class CircuitBreaker;
 
     class DatabaseWorker
     {
@@ -36,7 +42,8 @@ namespace SteerStone { namespace Core { namespace Database {
     public:
         /// Constructor
         /// @p_WorkerThread : Worker thread number spawned
-        DatabaseWorker(uint8 const& p_WorkerThread);
+        /// @p_Breaker : Circuit breaker outcomes are recorded into
+        DatabaseWorker(uint8 const& p_WorkerThread, CircuitBreaker* p_Breaker);
         /// Deconstructor
         ~DatabaseWorker();
 
@@ -47,7 +54,7 @@ namespace SteerStone { namespace Core { namespace Database {
         /// @p_Operator : Operater being added
         void AddOperator(Operator* p_Operator);
 
-        /// Get size of producer
+        /// Get amount of operators queued or being executed
         const std::size_t GetSize();
 
     //////////////////////////////////////////////////////////////////////////
@@ -57,7 +64,10 @@ namespace SteerStone { namespace Core { namespace Database {
         bool Update();
 
     private:
-        ProducerQueue<Operator*> m_Producer;
+        Utils::MPSCQueue<Operator*> m_Queue;        ///< Operators to execute, pushed by any thread
+        std::atomic<std::size_t> m_Depth;           ///< Operators queued or being executed, a batch in hand still counts
+        std::promise<void> m_Stopped;               ///< Set once Update returned
+        CircuitBreaker* m_Breaker;                  ///< Outcomes of executions are recorded into
         Threading::Task::Ptr l_Task;
     };
 
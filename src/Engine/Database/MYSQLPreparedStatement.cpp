@@ -24,20 +24,26 @@ namespace SteerStone { namespace Core { namespace Database {
     /// Constructor
     /// @p_Base : Database
     MYSQLPreparedStatement::MYSQLPreparedStatement(Base* p_Base) 
-        : m_Base(p_Base)
+        : m_Base(p_Base), m_NonBlocking(false), m_Catalog(nullptr), m_CacheHits(0), m_CacheMisses(0)
     {
         #ifdef STEERSTONE_CORE_DEBUG
             LOG_INFO("PreparedStatements", "MYSQLPreparedStatement Initialized");
         #endif
 
         m_Connection = nullptr;
-
-        for (uint32 l_I = 0; l_I < MAX_PREPARED_STATEMENTS; l_I++)
-            m_Statements[l_I] = nullptr;
     }
     /// Deconstructor
     MYSQLPreparedStatement::~MYSQLPreparedStatement()
     {
+        for (CachedStatement& l_Cached : m_Cache)
+            m_Evicted.push_back(l_Cached.Stmt);
+
+        for (auto& l_Handles : m_CatalogHandles)
+            for (CatalogHandle const& l_Handle : l_Handles)
+                m_Evicted.push_back(l_Handle.Stmt);
+
+        CloseEvicted();
+
         mysql_close(m_Connection);
     }
 
@@ -47,8 +53,9 @@ namespace SteerStone { namespace Core { namespace Database {
     /// @p_Port     : Port we are connecting to
     /// @p_Host     : Address we are connecting to
     /// @p_Database : Database we are querying to
-    /// @p_PoolSize : Amount of MYSQL connections we are spawning
-    uint32 MYSQLPreparedStatement::Connect(std::string const p_Username, std::string const p_Password, uint32 const p_Port, std::string const p_Host, std::string const p_Database)
+    /// @p_StatementCount : Amount of prepared statements of connection
+    /// @p_NonBlocking : Enable the non blocking API on the connection
+    uint32 MYSQLPreparedStatement::Connect(std::string const p_Username, std::string const p_Password, uint32 const p_Port, std::string const p_Host, std::string const p_Database, uint32 const p_StatementCount, uint32 const p_ConnectTimeout, bool const p_NonBlocking)
     {
         /// Initialize connection
         MYSQL* l_Connection = mysql_init(NULL);
@@ -62,25 +69,39 @@ namespace SteerStone { namespace Core { namespace Database {
         /// We handle data by utf8 - so do same for database
         mysql_options(l_Connection, MYSQL_SET_CHARSET_NAME, "utf8");
 
+        /// Client library takes whole seconds, round up so a short timeout never becomes none
+        if (p_ConnectTimeout)
+        {
+            const unsigned int l_Timeout = (p_ConnectTimeout + 999) / 1000;
+            mysql_options(l_Connection, MYSQL_OPT_CONNECT_TIMEOUT, &l_Timeout);
+        }
+
+#ifdef DATABASE_NONBLOCKING
+        /// Must be set before connecting, blocking calls keep working on the connection
+        if (p_NonBlocking)
+            m_NonBlocking = mysql_options(l_Connection, MYSQL_OPT_NONBLOCK, 0) == 0;
+#endif
+
         /// Connect to database
         m_Connection = mysql_real_connect(l_Connection, p_Host.c_str(), p_Username.c_str(), p_Password.c_str(), p_Database.c_str(), p_Port, NULL, NULL);
 
         if (m_Connection)
         {
-            static bool l_Logged = false;
+            /// Connections are opened in parallel, only the first one logs
+            static std::atomic<bool> l_Logged(false);
 
-            if (!l_Logged)
+            if (!l_Logged.exchange(true))
             {
                 LOG_INFO("Database", "MySQL Client Library: %0", mysql_get_client_info());
                 LOG_INFO("Database", "MySQL Server Version: %0", mysql_get_server_info(m_Connection));
                 LOG_INFO("Database", "Connected to MYSQL Database at %0", m_Connection->host);
-
-                l_Logged = true;
             }
 
             /// Set up prepare statements
-            for (uint32 l_I = 0; l_I < MAX_PREPARED_STATEMENTS; l_I++)
-                m_Statements[l_I] = new PreparedStatement(shared_from_this());
+            m_Statements.reserve(p_StatementCount);
+
+            for (uint32 l_I = 0; l_I < p_StatementCount; l_I++)
+                m_Statements.push_back(new PreparedStatement(shared_from_this()));
 
             mysql_set_character_set(m_Connection, "utf8");
 
@@ -88,59 +109,136 @@ namespace SteerStone { namespace Core { namespace Database {
         }
         else
         {
+            /// Read error before the connection is freed
+            const uint32 l_Error = mysql_errno(l_Connection);
+
             /// Free connection and report error
             mysql_close(l_Connection);
-            return mysql_errno(l_Connection);
+            return l_Error ? l_Error : 2000; ///< CR_UNKNOWN_ERROR
         }
     }
-    /// Prepare the statement
+    /// Prepare the statement, reuses a cached handle of the same query if any
     /// @p_StatementHolder : Statement being prepared
     bool MYSQLPreparedStatement::Prepare(PreparedStatement* p_StatementHolder)
     {
         Utils::ObjectGuard l_Guard(this);
 
-        p_StatementHolder->m_Stmt = mysql_stmt_init(m_Connection);
+        CloseEvicted();
 
-        if (!p_StatementHolder->m_Stmt)
+        if (AcquireStatement(p_StatementHolder))
+            m_CacheHits.fetch_add(1, std::memory_order_relaxed);
+        else
         {
-            LOG_INFO("Database", "Failed in initializing MYSQL. Error: %0", mysql_error(m_Connection));
-            return true;
+            m_CacheMisses.fetch_add(1, std::memory_order_relaxed);
+
+            p_StatementHolder->m_Stmt = CreateStatement(p_StatementHolder->m_Query, p_StatementHolder->m_ParametersCount);
+            p_StatementHolder->m_BoundStmt = nullptr;
+
+            if (!p_StatementHolder->m_Stmt)
+                return true;
         }
 
-        /// Set buffer max value
-        bool l_Temp = true;
-        mysql_stmt_attr_set(p_StatementHolder->m_Stmt, STMT_ATTR_UPDATE_MAX_LENGTH, &l_Temp);
+        /// Storage keeps its capacity between prepares, binds of the last layout stay set when the holder binds the same handle again
+        if (p_StatementHolder->m_BoundStmt != p_StatementHolder->m_Stmt)
+        {
+            p_StatementHolder->m_Bind.assign(p_StatementHolder->m_ParametersCount, MYSQL_BIND());
+            p_StatementHolder->m_BoundStmt = nullptr;
+        }
+
+        p_StatementHolder->m_Binds.resize(p_StatementHolder->m_ParametersCount);
+        p_StatementHolder->m_Lengths.resize(p_StatementHolder->m_ParametersCount);
+
+        p_StatementHolder->m_Prepared = true;
+
+        return false;
+    }
+    /// Give handle of a statement back to the cache, safe to call while the connection is in use
+    /// @p_StatementHolder : Statement releasing its handle
+    void MYSQLPreparedStatement::ReleaseStatement(PreparedStatement* p_StatementHolder)
+    {
+        std::lock_guard<std::mutex> l_Guard(m_CacheMutex);
 
-        if (mysql_stmt_prepare(p_StatementHolder->m_Stmt, p_StatementHolder->m_Query.c_str(), static_cast<unsigned long>(p_StatementHolder->m_Query.length())))
+        /// Catalog handles are kept for the lifetime of the connection
+        if (CatalogStatement const* l_Catalog = p_StatementHolder->m_CatalogStatement)
         {
-            LOG_ERROR("Database", "%0 on %1", mysql_error(m_Connection), p_StatementHolder->m_Query);
+            m_CatalogHandles[l_Catalog->Id].push_back(CatalogHandle{ p_StatementHolder->m_Stmt, p_StatementHolder });
+            return;
+        }
 
-            mysql_stmt_close(p_StatementHolder->m_Stmt);
+        const uint64 l_Hash = std::hash<std::string>()(p_StatementHolder->m_Query);
 
-            return true;
+        /// Another statement of ours already cached a handle of this query, keep the one we have
+        if (m_CacheIndex.find(l_Hash) != m_CacheIndex.end())
+        {
+            m_Evicted.push_back(p_StatementHolder->m_Stmt);
+            return;
         }
 
-        p_StatementHolder->m_ParametersCount = mysql_stmt_param_count(p_StatementHolder->m_Stmt);
+        m_Cache.push_front(CachedStatement{ l_Hash, p_StatementHolder->m_Query, p_StatementHolder->m_Stmt, p_StatementHolder->m_ParametersCount, p_StatementHolder });
+        m_CacheIndex[l_Hash] = m_Cache.begin();
 
-        if (p_StatementHolder->m_ParametersCount)
+        if (m_Cache.size() > STATEMENT_CACHE_SIZE)
         {
-            p_StatementHolder->m_Bind = new MYSQL_BIND[p_StatementHolder->m_ParametersCount];
-            memset(p_StatementHolder->m_Bind, 0, sizeof(MYSQL_BIND) * p_StatementHolder->m_ParametersCount);
+            m_Evicted.push_back(m_Cache.back().Stmt);
+            m_CacheIndex.erase(m_Cache.back().Hash);
+            m_Cache.pop_back();
         }
+    }
+    /// Prepare one handle of every catalog statement
+    /// @p_Catalog : Catalog
+    /// Returns 0 on success, MySQL error otherwise
+    uint32 MYSQLPreparedStatement::PrepareCatalog(StatementCatalog const* p_Catalog)
+    {
+        Utils::ObjectGuard l_Guard(this);
 
-        p_StatementHolder->m_Prepared = true;
+        m_Catalog = p_Catalog;
+        m_CatalogHandles.resize(p_Catalog->GetSize());
 
-        return false;
+        for (uint32 l_I = 0; l_I < p_Catalog->GetSize(); l_I++)
+        {
+            CatalogStatement const* l_Statement = p_Catalog->Get(l_I);
+
+            if (!l_Statement)
+                continue;
+
+            uint32 l_ParametersCount = 0;
+            MYSQL_STMT* l_Stmt = CreateStatement(l_Statement->Query, l_ParametersCount);
+
+            if (!l_Stmt)
+            {
+                LOG_ERROR("Database", "Catalog statement %0 failed to prepare", l_Statement->Name);
+                return mysql_errno(m_Connection) ? mysql_errno(m_Connection) : 2000; ///< CR_UNKNOWN_ERROR
+            }
+
+            if (l_ParametersCount != l_Statement->Parameters.size())
+            {
+                LOG_ERROR("Database", "Catalog statement %0 declares %1 parameters, server counts %2", l_Statement->Name, static_cast<uint32>(l_Statement->Parameters.size()), l_ParametersCount);
+
+                mysql_stmt_close(l_Stmt);
+                return 2000; ///< CR_UNKNOWN_ERROR
+            }
+
+            m_CatalogHandles[l_I].push_back(CatalogHandle{ l_Stmt, nullptr });
+        }
+
+        return 0;
     }
     /// Execute the statement
     /// @p_Stmt : Statement being executed
     /// @p_Result : Result set
     /// @p_FieldCount : Field count
-    bool MYSQLPreparedStatement::Execute(MYSQL_STMT* p_Stmt, MYSQL_RES ** p_Result, uint32 * p_FieldCount)
+    /// @p_ExecuteTime : Nanoseconds until the server answered, connection lock wait excluded
+    bool MYSQLPreparedStatement::Execute(MYSQL_STMT* p_Stmt, MYSQL_RES ** p_Result, uint32 * p_FieldCount, uint64* p_ExecuteTime)
     {
         Utils::ObjectGuard l_Guard(this);
 
-        if (mysql_stmt_execute(p_Stmt))
+        const auto l_Start = std::chrono::steady_clock::now();
+        const int l_Error = mysql_stmt_execute(p_Stmt);
+
+        if (p_ExecuteTime)
+            *p_ExecuteTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - l_Start).count();
+
+        if (l_Error)
         {
             LOG_ASSERT(false, "Database", "Failed to execute statement. Error: %0",mysql_stmt_error(p_Stmt));
             return false;
@@ -152,11 +250,238 @@ namespace SteerStone { namespace Core { namespace Database {
         return true;
     }
 
+    /// Execute statements prepared on this connection as one transaction, the connection is held throughout
+    /// @p_Statements : Statements in execution order, their results are discarded
+    /// Returns true if committed, rolled back otherwise
+    bool MYSQLPreparedStatement::ExecuteTransaction(std::vector<std::unique_ptr<PreparedStatement>> const& p_Statements)
+    {
+        Utils::ObjectGuard l_Guard(this);
+
+        if (mysql_query(m_Connection, "START TRANSACTION"))
+        {
+            LOG_ERROR("Database", "Failed to start transaction. Error: %0", mysql_error(m_Connection));
+            return false;
+        }
+
+        for (auto const& l_Statement : p_Statements)
+        {
+            if (!l_Statement->PrepareExecution() || mysql_stmt_execute(l_Statement->GetStatement()))
+            {
+                LOG_ERROR("Database", "Rolling back transaction, failed to execute %0. Error: %1", l_Statement->m_Query,
+                    l_Statement->GetStatement() ? mysql_stmt_error(l_Statement->GetStatement()) : "statement is not prepared");
+
+                mysql_rollback(m_Connection);
+                return false;
+            }
+
+            /// Nothing reads the rows, drop them so the next step can be sent
+            mysql_stmt_free_result(l_Statement->GetStatement());
+        }
+
+        if (mysql_commit(m_Connection))
+        {
+            LOG_ERROR("Database", "Failed to commit transaction. Error: %0", mysql_error(m_Connection));
+
+            mysql_rollback(m_Connection);
+            return false;
+        }
+
+        return true;
+    }
+
     /// Returns database
     Base* MYSQLPreparedStatement::GetDatabase() const
     {
         return m_Base;
     }
+    /// Returns catalog prepared on connection, nullptr if none
+    StatementCatalog const* MYSQLPreparedStatement::GetCatalog() const
+    {
+        return m_Catalog;
+    }
+    /// Get amount of prepares served by a cached handle
+    uint64 MYSQLPreparedStatement::GetStatementCacheHits() const
+    {
+        return m_CacheHits.load(std::memory_order_relaxed);
+    }
+    /// Get amount of prepares which had to prepare on the server
+    uint64 MYSQLPreparedStatement::GetStatementCacheMisses() const
+    {
+        return m_CacheMisses.load(std::memory_order_relaxed);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Create and prepare a handle on the server, connection must be locked
+    /// @p_Query : Query
+    /// @p_ParametersCount : Parameter count of handle
+    /// Returns nullptr on failure
+    MYSQL_STMT* MYSQLPreparedStatement::CreateStatement(std::string const& p_Query, uint32& p_ParametersCount)
+    {
+        MYSQL_STMT* l_Stmt = mysql_stmt_init(m_Connection);
+
+        if (!l_Stmt)
+        {
+            LOG_INFO("Database", "Failed in initializing MYSQL. Error: %0", mysql_error(m_Connection));
+            return nullptr;
+        }
+
+        /// Set buffer max value
+        bool l_Temp = true;
+        mysql_stmt_attr_set(l_Stmt, STMT_ATTR_UPDATE_MAX_LENGTH, &l_Temp);
+
+        if (mysql_stmt_prepare(l_Stmt, p_Query.c_str(), static_cast<unsigned long>(p_Query.length())))
+        {
+            LOG_ERROR("Database", "%0 on %1", mysql_error(m_Connection), p_Query);
+
+            mysql_stmt_close(l_Stmt);
+            return nullptr;
+        }
+
+        p_ParametersCount = mysql_stmt_param_count(l_Stmt);
+
+        return l_Stmt;
+    }
+    /// Take cached handle of query, connection must be locked
+    /// @p_StatementHolder : Statement being prepared
+    bool MYSQLPreparedStatement::AcquireStatement(PreparedStatement* p_StatementHolder)
+    {
+        /// Catalog statements take one of their idle handles, the catalog is sized once at connect
+        if (CatalogStatement const* l_Catalog = p_StatementHolder->m_CatalogStatement)
+        {
+            {
+                std::lock_guard<std::mutex> l_Guard(m_CacheMutex);
+
+                std::vector<CatalogHandle>& l_Handles = m_CatalogHandles[l_Catalog->Id];
+
+                if (l_Handles.empty())
+                    return false;
+
+                /// Prefer the handle we bound last, its parameters may not need binding again
+                std::size_t l_Index = l_Handles.size() - 1;
+                for (std::size_t l_I = 0; l_I < l_Handles.size(); l_I++)
+                {
+                    if (l_Handles[l_I].Binder == p_StatementHolder && l_Handles[l_I].Stmt == p_StatementHolder->m_BoundStmt)
+                    {
+                        l_Index = l_I;
+                        break;
+                    }
+                }
+
+                p_StatementHolder->m_Stmt = l_Handles[l_Index].Stmt;
+                p_StatementHolder->m_ParametersCount = static_cast<uint32>(l_Catalog->Parameters.size());
+
+                /// Another statement bound the handle since, whatever we bound is gone
+                if (l_Handles[l_Index].Binder != p_StatementHolder)
+                    p_StatementHolder->m_BoundStmt = nullptr;
+
+                l_Handles[l_Index] = l_Handles.back();
+                l_Handles.pop_back();
+            }
+
+            mysql_stmt_free_result(p_StatementHolder->m_Stmt);
+            return true;
+        }
+
+        const uint64 l_Hash = std::hash<std::string>()(p_StatementHolder->m_Query);
+
+        {
+            std::lock_guard<std::mutex> l_Guard(m_CacheMutex);
+
+            auto l_Itr = m_CacheIndex.find(l_Hash);
+
+            if (l_Itr == m_CacheIndex.end() || l_Itr->second->Query != p_StatementHolder->m_Query)
+                return false;
+
+            p_StatementHolder->m_Stmt = l_Itr->second->Stmt;
+            p_StatementHolder->m_ParametersCount = l_Itr->second->ParametersCount;
+
+            if (l_Itr->second->Binder != p_StatementHolder)
+                p_StatementHolder->m_BoundStmt = nullptr;
+
+            m_Cache.erase(l_Itr->second);
+            m_CacheIndex.erase(l_Itr);
+        }
+
+        /// Result of previous use is stored client side, freeing it is local
+        mysql_stmt_free_result(p_StatementHolder->m_Stmt);
+
+        return true;
+    }
+    /// Close handles evicted from the cache, connection must be locked
+    void MYSQLPreparedStatement::CloseEvicted()
+    {
+        std::vector<MYSQL_STMT*> l_Evicted;
+
+        {
+            std::lock_guard<std::mutex> l_Guard(m_CacheMutex);
+            l_Evicted.swap(m_Evicted);
+        }
+
+        for (MYSQL_STMT* l_Stmt : l_Evicted)
+            mysql_stmt_close(l_Stmt);
+    }
+
+#ifdef DATABASE_NONBLOCKING
+    /// Attempt to take the connection for a non blocking execution, held until UnlockConnection
+    bool MYSQLPreparedStatement::TryLockConnection()
+    {
+        return TryLock();
+    }
+    /// Release the connection taken by TryLockConnection
+    void MYSQLPreparedStatement::UnlockConnection()
+    {
+        Unlock();
+    }
+
+    /// Connection was set up for the non blocking API
+    bool MYSQLPreparedStatement::IsNonBlocking() const
+    {
+        return m_NonBlocking;
+    }
+    /// Get socket of connection
+    int32 MYSQLPreparedStatement::GetSocket() const
+    {
+        return static_cast<int32>(mysql_get_socket(m_Connection));
+    }
+    /// Get timeout in milliseconds when the API asked to wait for MYSQL_WAIT_TIMEOUT
+    uint32 MYSQLPreparedStatement::GetTimeout() const
+    {
+        return mysql_get_timeout_value_ms(m_Connection);
+    }
+
+    /// Start executing the statement, the connection must be locked
+    /// @p_Stmt : Statement being executed
+    /// @p_Result : Return code of mysql_stmt_execute, set once complete
+    int32 MYSQLPreparedStatement::ExecuteStart(MYSQL_STMT* p_Stmt, int32& p_Result)
+    {
+        return mysql_stmt_execute_start(&p_Result, p_Stmt);
+    }
+    /// Continue executing the statement
+    /// @p_Stmt : Statement being executed
+    /// @p_Result : Return code of mysql_stmt_execute, set once complete
+    /// @p_Events : MYSQL_WAIT_* events which occured
+    int32 MYSQLPreparedStatement::ExecuteContinue(MYSQL_STMT* p_Stmt, int32& p_Result, int32 p_Events)
+    {
+        return mysql_stmt_execute_cont(&p_Result, p_Stmt, p_Events);
+    }
+    /// Start storing the result of the statement, the connection must be locked
+    /// @p_Stmt : Statement executed
+    /// @p_Result : Return code of mysql_stmt_store_result, set once complete
+    int32 MYSQLPreparedStatement::StoreResultStart(MYSQL_STMT* p_Stmt, int32& p_Result)
+    {
+        return mysql_stmt_store_result_start(&p_Result, p_Stmt);
+    }
+    /// Continue storing the result of the statement
+    /// @p_Stmt : Statement executed
+    /// @p_Result : Return code of mysql_stmt_store_result, set once complete
+    /// @p_Events : MYSQL_WAIT_* events which occured
+    int32 MYSQLPreparedStatement::StoreResultContinue(MYSQL_STMT* p_Stmt, int32& p_Result, int32 p_Events)
+    {
+        return mysql_stmt_store_result_cont(&p_Result, p_Stmt, p_Events);
+    }
+#endif
 
 }   ///< namespace Database
 }   ///< namespace Core
@@ -22,6 +22,7 @@
 #include "Core/Core.hpp"
 #include "Database/PreparedStatement.hpp"
 #include "Database/SQLCommon.hpp"
+#include "Database/StatementCatalog.hpp"
 #include "Utility/UtiLockable.hpp"
 #include "Utility/UtiObjectGuard.hpp"
 
@@ -31,6 +32,22 @@ namespace SteerStone { namespace Core { namespace Database {
 
     class MYSQLPreparedStatement : public std::enable_shared_from_this<MYSQLPreparedStatement>, private Utils::LockableReadWrite
     {
+        /// Idle prepared handle kept for reuse
+        struct CachedStatement
+        {
+            uint64 Hash;                    ///< Hash of query
+            std::string Query;              ///< Query, compared on lookup so colliding hashes never share a handle
+            MYSQL_STMT* Stmt;               ///< Prepared handle
+            uint32 ParametersCount;         ///< Parameter count of handle
+            PreparedStatement const* Binder;///< Statement which last bound parameters on handle
+        };
+        /// Idle prepared handle of a catalog statement
+        struct CatalogHandle
+        {
+            MYSQL_STMT* Stmt;               ///< Prepared handle
+            PreparedStatement const* Binder;///< Statement which last bound parameters on handle
+        };
+
         /// Allow access to lock / unlock methods
         friend class Utils::ObjectGuard<MYSQLPreparedStatement>;
         friend class Utils::ObjectReadGuard<MYSQLPreparedStatement>;
@@ -57,28 +74,108 @@ namespace SteerStone { namespace Core { namespace Database {
         /// @p_Port     : Port we are connecting to
         /// @p_Host     : Address we are connecting to
         /// @p_Database : Database we are querying to
+        /// @p_StatementCount : Amount of prepared statements of connection
+        /// @p_ConnectTimeout : Milliseconds the connection attempt may take, 0 uses the client library default
+        /// @p_NonBlocking : Enable the non blocking API on the connection
         uint32 Connect(std::string const p_Username, std::string const p_Password,
-            uint32 const p_Port, std::string const p_Host, std::string const p_Database);
+            uint32 const p_Port, std::string const p_Host, std::string const p_Database, uint32 const p_StatementCount, uint32 const p_ConnectTimeout, bool const p_NonBlocking = false);
 
-        /// Prepare the statement
+        /// Prepare the statement, reuses a cached handle of the same query if any
         /// @p_StatementHolder : Statement being prepared
         bool Prepare(PreparedStatement* p_StatementHolder);
+        /// Give handle of a statement back to the cache, safe to call while the connection is in use
+        /// @p_StatementHolder : Statement releasing its handle
+        void ReleaseStatement(PreparedStatement* p_StatementHolder);
+        /// Prepare one handle of every catalog statement
+        /// @p_Catalog : Catalog
+        /// Returns 0 on success, MySQL error otherwise
+        uint32 PrepareCatalog(StatementCatalog const* p_Catalog);
         /// Execute the statement
         /// @p_Stmt : Statement being executed
         /// @p_Result : Result set
         /// @p_FieldCount : Field count
-        bool Execute(MYSQL_STMT* p_Stmt, MYSQL_RES ** p_Result, uint32* p_FieldCount);
+        /// @p_ExecuteTime : Nanoseconds until the server answered, connection lock wait excluded
+        bool Execute(MYSQL_STMT* p_Stmt, MYSQL_RES ** p_Result, uint32* p_FieldCount, uint64* p_ExecuteTime = nullptr);
+        /// Execute statements prepared on this connection as one transaction, the connection is held throughout
+        /// @p_Statements : Statements in execution order, their results are discarded
+        /// Returns true if committed, rolled back otherwise
+        bool ExecuteTransaction(std::vector<std::unique_ptr<PreparedStatement>> const& p_Statements);
 
         /// Returns database
         Base* GetDatabase() const;
+        /// Returns catalog prepared on connection, nullptr if none
+        StatementCatalog const* GetCatalog() const;
+        /// Get amount of prepares served by a cached handle
+        uint64 GetStatementCacheHits() const;
+        /// Get amount of prepares which had to prepare on the server
+        uint64 GetStatementCacheMisses() const;
+
+#ifdef DATABASE_NONBLOCKING
+        /// Attempt to take the connection for a non blocking execution, held until UnlockConnection
+        bool TryLockConnection();
+        /// Release the connection taken by TryLockConnection
+        void UnlockConnection();
+
+        /// Connection was set up for the non blocking API
+        bool IsNonBlocking() const;
+        /// Get socket of connection
+        int32 GetSocket() const;
+        /// Get timeout in milliseconds when the API asked to wait for MYSQL_WAIT_TIMEOUT
+        uint32 GetTimeout() const;
+
+        /// Start executing the statement, the connection must be locked
+        /// @p_Stmt : Statement being executed
+        /// @p_Result : Return code of mysql_stmt_execute, set once complete
+        /// Returns MYSQL_WAIT_* events to wait for, 0 once complete
+        int32 ExecuteStart(MYSQL_STMT* p_Stmt, int32& p_Result);
+        /// Continue executing the statement
+        /// @p_Stmt : Statement being executed
+        /// @p_Result : Return code of mysql_stmt_execute, set once complete
+        /// @p_Events : MYSQL_WAIT_* events which occured
+        /// Returns MYSQL_WAIT_* events to wait for, 0 once complete
+        int32 ExecuteContinue(MYSQL_STMT* p_Stmt, int32& p_Result, int32 p_Events);
+        /// Start storing the result of the statement, the connection must be locked
+        /// @p_Stmt : Statement executed
+        /// @p_Result : Return code of mysql_stmt_store_result, set once complete
+        /// Returns MYSQL_WAIT_* events to wait for, 0 once complete
+        int32 StoreResultStart(MYSQL_STMT* p_Stmt, int32& p_Result);
+        /// Continue storing the result of the statement
+        /// @p_Stmt : Statement executed
+        /// @p_Result : Return code of mysql_stmt_store_result, set once complete
+        /// @p_Events : MYSQL_WAIT_* events which occured
+        /// Returns MYSQL_WAIT_* events to wait for, 0 once complete
+        int32 StoreResultContinue(MYSQL_STMT* p_Stmt, int32& p_Result, int32 p_Events);
+#endif
 
     //////////////////////////////////////////////////////////////////////////
     //////////////////////////////////////////////////////////////////////////
 
+    private:
+        /// Create and prepare a handle on the server, connection must be locked
+        /// @p_Query : Query
+        /// @p_ParametersCount : Parameter count of handle
+        /// Returns nullptr on failure
+        MYSQL_STMT* CreateStatement(std::string const& p_Query, uint32& p_ParametersCount);
+        /// Take cached handle of query, connection must be locked
+        /// @p_StatementHolder : Statement being prepared
+        bool AcquireStatement(PreparedStatement* p_StatementHolder);
+        /// Close handles evicted from the cache, connection must be locked
+        void CloseEvicted();
+
     private:
         MYSQL* m_Connection;                                       ///< MYSQL Connection
-        PreparedStatement* m_Statements[MAX_PREPARED_STATEMENTS];  ///< Prepared Statements storage
+        std::vector<PreparedStatement*> m_Statements;              ///< Prepared Statements storage
         Base* m_Base;                                              ///< Database
+        bool m_NonBlocking;                                        ///< Connection was set up for the non blocking API
+
+        std::mutex m_CacheMutex;                                                            ///< Guards cache, taken without the connection lock
+        std::list<CachedStatement> m_Cache;                                                 ///< Idle handles, most recently released first
+        std::unordered_map<uint64, std::list<CachedStatement>::iterator> m_CacheIndex;      ///< Idle handles by query hash
+        std::vector<MYSQL_STMT*> m_Evicted;                                                 ///< Handles to close once the connection is locked
+        StatementCatalog const* m_Catalog;                                                  ///< Catalog prepared on connection
+        std::vector<std::vector<CatalogHandle>> m_CatalogHandles;                           ///< Idle handles of each catalog statement, never evicted
+        std::atomic<uint64> m_CacheHits;                                                    ///< Prepares served from cache
+        std::atomic<uint64> m_CacheMisses;                                                  ///< Prepares sent to the server
     };
 
 }   ///< namespace Database
@@ -20,13 +20,28 @@
 #include <PCH/Precompiled.hpp>
 #include "Core/Core.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <memory>
+
 namespace SteerStone { namespace Core { namespace Database {
 
+    class PreparedStatement;
+    class PreparedResultSet;
+
+    /// What happens to an operator queued while database queues are over their limits or the circuit breaker is open
+    enum class QueuePolicy
+    {
+        Block,                  ///< Wait for room, never rejected
+        FailFast,               ///< Complete right away as failed, result is nullptr or false
+        Drop                    ///< Discard, futures get nullptr and callbacks are not run (best effort writes, visit logs)
+    };
+
     class Operator
     {
     public:
         /// Constructor
-        Operator() {}
+        Operator() : m_Id(NextId()), m_Failed(false) {}
 
         /// Virtual Deconstructor
         virtual ~Operator() {}
@@ -38,6 +53,44 @@ namespace SteerStone { namespace Core { namespace Database {
         /// Execute
         /// Execute Query
         virtual bool Execute() = 0;
+
+        /// Get statement executed by the operator, operators without one are executed through Execute
+        virtual PreparedStatement* GetPreparedStatement() const { return nullptr; }
+        /// Free the prepared statement once the result set is released
+        virtual bool FreesStatementAutomatically() const { return false; }
+        /// Complete operator once a non blocking worker executed the statement
+        /// @p_Result : Result set, nullptr if execution failed
+        virtual void Complete(std::unique_ptr<PreparedResultSet> p_Result) {}
+        /// Complete operator without executing it, its statement is freed
+        /// @p_Notify : Deliver failure to the caller, callbacks are skipped otherwise
+        virtual void Reject(bool p_Notify) = 0;
+
+        /// Check execution failed, recorded by the circuit breaker
+        bool HasFailed() const { return m_Failed; }
+        /// Get id of operator, unique for the process, written to flight recorder dumps
+        uint64 GetId() const { return m_Id; }
+
+        /// Stamp time operator was queued, queue wait is measured from here
+        void SetQueueTime() { m_QueueTime = std::chrono::steady_clock::now(); }
+        /// Get nanoseconds since operator was queued
+        uint64 GetQueueWait() const { return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_QueueTime).count(); }
+
+    protected:
+        /// Mark execution as failed
+        void SetFailed() { m_Failed = true; }
+
+    private:
+        /// Take next operator id
+        static uint64 NextId()
+        {
+            static std::atomic<uint64> sl_NextId(0);
+            return sl_NextId.fetch_add(1, std::memory_order_relaxed) + 1;
+        }
+
+    private:
+        std::chrono::steady_clock::time_point m_QueueTime;     ///< Time operator was queued
+        uint64 m_Id;                                           ///< Id of operator
+        bool m_Failed;                                         ///< Execution failed
     };
 
 }   ///< namespace Database
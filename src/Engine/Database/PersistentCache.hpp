@@ -0,0 +1,351 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+#include "Database/BatchWriter.hpp"
+#include "Logger/Base.hpp"
+#include "Logger/LogDefines.hpp"
+#include "Threading/ThrTaskManager.hpp"
+#include "Utility/UtiString.hpp"
+
+#include <list>
+
+#define PERSISTENT_CACHE_MAX_FIELDS     64      ///< Field groups an entity may be split into, one bit each in the dirty mask
+
+namespace SteerStone { namespace Core { namespace Database {
+
+    /// Write behind cache of entities (users, rooms, items)
+    /// Entities are loaded on first access and modified in memory, every modification marks a field group dirty.
+    /// Dirty groups are handed to the batch writer of their group periodically, when the entity is evicted and
+    /// when the cache is destroyed. Each group has its own writer so moving an item only writes its position.
+    ///
+    /// Entities are shared, references stay valid after eviction. They must only be modified through Modify,
+    /// which serializes against the flush reading them. Rows reach the writers in the order they were serialized,
+    /// a newer version of an entity is never coalesced away by an older one.
+    template<typename Key, typename Entity> class PersistentCache
+    {
+        DISALLOW_COPY_AND_ASSIGN(PersistentCache);
+
+        public:
+            /// Load entity from database, nullptr if it does not exist
+            using Loader        = std::function<std::shared_ptr<Entity>(Key const&)>;
+            /// Build row of a field group, values in column order of its writer
+            using Serializer    = std::function<BatchWriter::Row(Key const&, Entity const&)>;
+
+        private:
+            /// Cached entity
+            struct Entry
+            {
+                Key Id;                             ///< Key of entity
+                std::shared_ptr<Entity> Value;      ///< Entity
+                uint64 DirtyMask;                   ///< Field groups modified since last flush
+            };
+
+            /// Writer of a field group
+            struct FieldGroup
+            {
+                BatchWriter* Writer;                ///< Writer rows are handed to
+                Serializer Serialize;               ///< Builds the row
+            };
+
+            using EntryList = std::list<Entry>;
+
+        public:
+            /// Constructor
+            /// @p_Name          : Name of cache, used for its flush task
+            /// @p_Loader        : Loads entities which are not cached
+            /// @p_Capacity      : Entities kept, least recently used ones are evicted past it
+            /// @p_FlushInterval : Milliseconds between flushes of dirty entities
+            PersistentCache(std::string const& p_Name, Loader p_Loader, std::size_t p_Capacity, uint32 p_FlushInterval)
+                : m_Loader(std::move(p_Loader)), m_Capacity(std::max<std::size_t>(p_Capacity, 1)), m_Fields(PERSISTENT_CACHE_MAX_FIELDS), m_FlushCount(0), m_EvictCount(0)
+            {
+                m_Task = sThreadManager->PushTask(Utils::StringBuilder("PERSISTENT_CACHE_%0", p_Name), Threading::TaskType::Normal, p_FlushInterval, [this]() -> bool
+                {
+                    Flush();
+                    return true;
+                });
+            }
+            /// Deconstructor, dirty entities are flushed, writers must outlive the cache
+            ~PersistentCache()
+            {
+                sThreadManager->PopTask(m_Task);
+                Flush();
+
+                for (FieldGroup const& l_Group : m_Fields)
+                {
+                    if (l_Group.Writer)
+                        l_Group.Writer->Flush();
+                }
+            }
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Set writer of a field group, must be called before entities are modified
+            /// @p_Field      : Field group, below PERSISTENT_CACHE_MAX_FIELDS
+            /// @p_Writer     : Upsert writer of the group, must outlive the cache
+            /// @p_Serializer : Builds the row of the group
+            void SetFieldGroup(uint32 p_Field, BatchWriter* p_Writer, Serializer p_Serializer)
+            {
+                LOG_ASSERT(p_Field < PERSISTENT_CACHE_MAX_FIELDS, "Database", "Field group %0 is out of range", p_Field);
+
+                std::lock_guard<std::mutex> l_Guard(m_Mutex);
+                m_Fields[p_Field] = FieldGroup{ p_Writer, std::move(p_Serializer) };
+            }
+
+            /// Get entity, loaded from database if not cached
+            /// @p_Key : Key of entity
+            /// Returns nullptr if it does not exist
+            std::shared_ptr<Entity> Get(Key const& p_Key)
+            {
+                if (std::shared_ptr<Entity> l_Entity = Find(p_Key))
+                    return l_Entity;
+
+                /// Load without holding the cache, a concurrent load of the same key keeps whichever was cached first
+                std::shared_ptr<Entity> l_Loaded = m_Loader(p_Key);
+                if (!l_Loaded)
+                    return nullptr;
+
+                return Emplace(p_Key, std::move(l_Loaded), 0);
+            }
+            /// Get entity if cached
+            /// @p_Key : Key of entity
+            std::shared_ptr<Entity> Find(Key const& p_Key)
+            {
+                std::lock_guard<std::mutex> l_Guard(m_Mutex);
+
+                auto l_Itr = m_Index.find(p_Key);
+                if (l_Itr == m_Index.end())
+                    return nullptr;
+
+                m_Entries.splice(m_Entries.begin(), m_Entries, l_Itr->second);
+                return l_Itr->second->Value;
+            }
+            /// Add an entity loaded elsewhere (an asynchronous query), nothing is written until it is modified
+            /// @p_Key    : Key of entity
+            /// @p_Entity : Entity
+            /// Returns the entity cached under the key, which is the one already cached if there was one
+            std::shared_ptr<Entity> Add(Key const& p_Key, std::shared_ptr<Entity> p_Entity)
+            {
+                return Emplace(p_Key, std::move(p_Entity), 0);
+            }
+            /// Add an entity which is not in database yet, every field group is written on next flush
+            /// @p_Key    : Key of entity
+            /// @p_Entity : Entity
+            std::shared_ptr<Entity> Insert(Key const& p_Key, std::shared_ptr<Entity> p_Entity)
+            {
+                return Emplace(p_Key, std::move(p_Entity), ~uint64(0));
+            }
+            /// Modify entity and mark a field group dirty
+            /// @p_Key      : Key of entity
+            /// @p_Field    : Field group being modified
+            /// @p_Function : Modifies the entity
+            /// Returns false if entity is not cached
+            template<typename Function> bool Modify(Key const& p_Key, uint32 p_Field, Function p_Function)
+            {
+                std::lock_guard<std::mutex> l_Guard(m_Mutex);
+
+                auto l_Itr = m_Index.find(p_Key);
+                if (l_Itr == m_Index.end())
+                    return false;
+
+                p_Function(*l_Itr->second->Value);
+                MarkDirty(*l_Itr->second, uint64(1) << p_Field);
+
+                return true;
+            }
+            /// Remove entity from cache, its dirty field groups are written
+            /// @p_Key : Key of entity
+            void Evict(Key const& p_Key)
+            {
+                std::lock_guard<std::mutex> l_WriteGuard(m_WriteMutex);
+                std::vector<std::pair<BatchWriter*, BatchWriter::Row>> l_Rows;
+
+                {
+                    std::lock_guard<std::mutex> l_Guard(m_Mutex);
+
+                    auto l_Itr = m_Index.find(p_Key);
+                    if (l_Itr == m_Index.end())
+                        return;
+
+                    Remove(l_Itr->second, l_Rows);
+                }
+
+                Write(l_Rows);
+            }
+            /// Hand dirty field groups of every entity to their writers
+            void Flush()
+            {
+                std::lock_guard<std::mutex> l_WriteGuard(m_WriteMutex);
+                std::vector<std::pair<BatchWriter*, BatchWriter::Row>> l_Rows;
+
+                {
+                    std::lock_guard<std::mutex> l_Guard(m_Mutex);
+
+                    for (Key const& l_Key : m_Dirty)
+                    {
+                        auto l_Itr = m_Index.find(l_Key);
+
+                        /// Evicted entities were written when they left
+                        if (l_Itr != m_Index.end())
+                            Serialize(*l_Itr->second, l_Rows);
+                    }
+
+                    m_Dirty.clear();
+                }
+
+                if (!l_Rows.empty())
+                    m_FlushCount++;
+
+                Write(l_Rows);
+            }
+
+            /// Get amount of cached entities
+            std::size_t GetSize() const
+            {
+                std::lock_guard<std::mutex> l_Guard(m_Mutex);
+                return m_Entries.size();
+            }
+            /// Get amount of entities waiting for a flush
+            std::size_t GetDirtyCount() const
+            {
+                std::lock_guard<std::mutex> l_Guard(m_Mutex);
+                return m_Dirty.size();
+            }
+            /// Get amount of flushes which wrote anything
+            uint64 GetFlushCount() const
+            {
+                return m_FlushCount;
+            }
+            /// Get amount of entities evicted past capacity
+            uint64 GetEvictCount() const
+            {
+                return m_EvictCount;
+            }
+
+        private:
+            /// Cache entity, an entity already cached under the key wins
+            /// @p_Key       : Key of entity
+            /// @p_Entity    : Entity
+            /// @p_DirtyMask : Field groups to write
+            std::shared_ptr<Entity> Emplace(Key const& p_Key, std::shared_ptr<Entity> p_Entity, uint64 p_DirtyMask)
+            {
+                std::lock_guard<std::mutex> l_WriteGuard(m_WriteMutex);
+                std::vector<std::pair<BatchWriter*, BatchWriter::Row>> l_Rows;
+                std::shared_ptr<Entity> l_Entity;
+
+                {
+                    std::lock_guard<std::mutex> l_Guard(m_Mutex);
+
+                    auto l_Itr = m_Index.find(p_Key);
+                    if (l_Itr != m_Index.end())
+                    {
+                        m_Entries.splice(m_Entries.begin(), m_Entries, l_Itr->second);
+                        return l_Itr->second->Value;
+                    }
+
+                    m_Entries.push_front(Entry{ p_Key, std::move(p_Entity), 0 });
+                    m_Index.emplace(p_Key, m_Entries.begin());
+                    MarkDirty(m_Entries.front(), p_DirtyMask);
+
+                    l_Entity = m_Entries.front().Value;
+
+                    /// Least recently used entities leave past capacity, written on the way out
+                    while (m_Entries.size() > m_Capacity)
+                    {
+                        Remove(std::prev(m_Entries.end()), l_Rows);
+                        m_EvictCount++;
+                    }
+                }
+
+                Write(l_Rows);
+
+                return l_Entity;
+            }
+            /// Mark field groups of an entry dirty, cache must be locked
+            /// @p_Entry     : Entry
+            /// @p_DirtyMask : Field groups
+            void MarkDirty(Entry& p_Entry, uint64 p_DirtyMask)
+            {
+                if (!p_DirtyMask)
+                    return;
+
+                if (!p_Entry.DirtyMask)
+                    m_Dirty.push_back(p_Entry.Id);
+
+                p_Entry.DirtyMask |= p_DirtyMask;
+            }
+            /// Remove an entry, its dirty field groups are serialized, cache must be locked
+            /// @p_Itr  : Entry
+            /// @p_Rows : Rows to write
+            void Remove(typename EntryList::iterator p_Itr, std::vector<std::pair<BatchWriter*, BatchWriter::Row>>& p_Rows)
+            {
+                Serialize(*p_Itr, p_Rows);
+
+                m_Index.erase(p_Itr->Id);
+                m_Entries.erase(p_Itr);
+            }
+            /// Serialize dirty field groups of an entry, cache must be locked
+            /// @p_Entry : Entry
+            /// @p_Rows  : Rows to write
+            void Serialize(Entry& p_Entry, std::vector<std::pair<BatchWriter*, BatchWriter::Row>>& p_Rows)
+            {
+                for (uint32 l_I = 0; l_I < PERSISTENT_CACHE_MAX_FIELDS && p_Entry.DirtyMask; l_I++)
+                {
+                    const uint64 l_Bit = uint64(1) << l_I;
+
+                    if (!(p_Entry.DirtyMask & l_Bit))
+                        continue;
+
+                    p_Entry.DirtyMask &= ~l_Bit;
+
+                    if (m_Fields[l_I].Writer)
+                        p_Rows.emplace_back(m_Fields[l_I].Writer, m_Fields[l_I].Serialize(p_Entry.Id, *p_Entry.Value));
+                }
+            }
+            /// Hand rows to their writers, called without the cache locked as a full batch sends straight away
+            /// Must be called while holding m_WriteMutex, taken before serializing so rows are added in the order they were serialized
+            /// @p_Rows : Rows to write
+            void Write(std::vector<std::pair<BatchWriter*, BatchWriter::Row>>& p_Rows)
+            {
+                for (auto& l_Row : p_Rows)
+                    l_Row.first->Add(std::move(l_Row.second));
+            }
+
+        private:
+            Loader m_Loader;                                                            ///< Loads entities which are not cached
+            std::size_t m_Capacity;                                                     ///< Entities kept
+            std::vector<FieldGroup> m_Fields;                                           ///< Writer of each field group
+
+            std::mutex m_WriteMutex;                                                    ///< Held from serializing rows until they are handed to writers, taken before m_Mutex
+            mutable std::mutex m_Mutex;                                                 ///< Guards entries and the entities themselves
+            EntryList m_Entries;                                                        ///< Entries, most recently used first
+            std::unordered_map<Key, typename EntryList::iterator> m_Index;              ///< Entries by key
+            std::vector<Key> m_Dirty;                                                   ///< Keys of entries with dirty field groups
+
+            std::atomic<uint64> m_FlushCount;                                           ///< Flushes which wrote anything
+            std::atomic<uint64> m_EvictCount;                                           ///< Entities evicted past capacity
+            Threading::Task::Ptr m_Task;                                                ///< Flush timer
+    };
+
+}   ///< namespace Database
+}   ///< namespace Core
+}   ///< namespace SteerStone
@@ -22,10 +22,18 @@ namespace SteerStone { namespace Core { namespace Database {
 
     /// Constructor
     /// @p_PrepareStatementHolder : Keep reference of statement to be accessed later
-    PrepareStatementOperator::PrepareStatementOperator(PreparedStatement * p_PreparedStatementHolder) : m_PreparedStatementHolder(p_PreparedStatementHolder)
+    PrepareStatementOperator::PrepareStatementOperator(PreparedStatement * p_PreparedStatementHolder) : m_PreparedStatementHolder(p_PreparedStatementHolder), m_Queue(nullptr)
     {
         m_PromiseResultSet = new std::promise<std::unique_ptr<PreparedResultSet>>();
     }
+    /// Constructor, result is posted to a completion queue instead of a future
+    /// @p_PrepareStatementHolder : Keep reference of statement to be accessed later
+    /// @p_Queue : Queue of the owner the callback runs on
+    /// @p_Callback : Callback
+    PrepareStatementOperator::PrepareStatementOperator(PreparedStatement* p_PreparedStatementHolder, CompletionQueue* p_Queue, CompletionQueue::ResultCallback p_Callback)
+        : m_PreparedStatementHolder(p_PreparedStatementHolder), m_PromiseResultSet(nullptr), m_Queue(p_Queue), m_Callback(std::move(p_Callback))
+    {
+    }
     /// Deconstructor
     PrepareStatementOperator::~PrepareStatementOperator()
     {
@@ -45,11 +53,55 @@ namespace SteerStone { namespace Core { namespace Database {
     /// Execute Query
     bool PrepareStatementOperator::Execute()
     {
-        m_PromiseResultSet->set_value(m_PreparedStatementHolder->ExecuteStatement(true));
+        Deliver(m_PreparedStatementHolder->ExecuteStatement(true));
 
         return true;
     }
 
+    /// Get statement executed by the operator
+    PreparedStatement* PrepareStatementOperator::GetPreparedStatement() const
+    {
+        return m_PreparedStatementHolder;
+    }
+    /// Free the prepared statement once the result set is released
+    bool PrepareStatementOperator::FreesStatementAutomatically() const
+    {
+        return true;
+    }
+    /// Complete operator once a non blocking worker executed the statement
+    /// @p_Result : Result set, nullptr if execution failed
+    void PrepareStatementOperator::Complete(std::unique_ptr<PreparedResultSet> p_Result)
+    {
+        Deliver(std::move(p_Result));
+    }
+
+    /// Complete operator without executing it, its statement is freed
+    /// @p_Notify : Deliver failure to the caller, callbacks are skipped otherwise
+    void PrepareStatementOperator::Reject(bool p_Notify)
+    {
+        m_PreparedStatementHolder->Clear();
+
+        /// Futures are always set, a promise going away unset would throw on the caller
+        if (p_Notify || !m_Queue)
+            Deliver(nullptr);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Hand result to future or completion queue
+    /// @p_Result : Result set, nullptr if execution failed
+    void PrepareStatementOperator::Deliver(std::unique_ptr<PreparedResultSet> p_Result)
+    {
+        if (!p_Result)
+            SetFailed();
+
+        if (m_Queue)
+            m_Queue->Post(m_Callback, std::move(p_Result));
+        else
+            m_PromiseResultSet->set_value(std::move(p_Result));
+    }
+
 }   ///< namespace Database
 }   ///< namespace Core
 }   ///< namespace SteerStone
\ No newline at end of file
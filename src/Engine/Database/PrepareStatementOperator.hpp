@@ -20,7 +20,9 @@
 #include <PCH/Precompiled.hpp>
 #include "Core/Core.hpp"
 #include "Database/Operator.hpp"
+#include "Memory/MemObjectPool.hpp"
 #include "Database/PreparedResultSet.hpp"
+#include "Database/CompletionQueue.hpp"
 #include <future>
 
 namespace SteerStone { namespace Core { namespace Database {
@@ -30,9 +32,17 @@ namespace SteerStone { namespace Core { namespace Database {
     class PrepareStatementOperator : public Operator
     {
     public:
+        /// Operators come from a pool, the database worker deletes them once executed
+        MEMORY_POOL_OPERATORS(PrepareStatementOperator)
+
         /// Constructor
         /// @p_PrepareStatementHolder : Keep reference of statement to be accessed later
         PrepareStatementOperator(PreparedStatement* p_PreparedStatementHolder);
+        /// Constructor, result is posted to a completion queue instead of a future
+        /// @p_PrepareStatementHolder : Keep reference of statement to be accessed later
+        /// @p_Queue : Queue of the owner the callback runs on
+        /// @p_Callback : Callback
+        PrepareStatementOperator(PreparedStatement* p_PreparedStatementHolder, CompletionQueue* p_Queue, CompletionQueue::ResultCallback p_Callback);
         /// Deconstructor
         ~PrepareStatementOperator() override;
 
@@ -44,9 +54,27 @@ namespace SteerStone { namespace Core { namespace Database {
         /// Execute Query
         virtual bool Execute() override;
 
+        /// Get statement executed by the operator
+        PreparedStatement* GetPreparedStatement() const override;
+        /// Free the prepared statement once the result set is released
+        bool FreesStatementAutomatically() const override;
+        /// Complete operator once a non blocking worker executed the statement
+        /// @p_Result : Result set, nullptr if execution failed
+        void Complete(std::unique_ptr<PreparedResultSet> p_Result) override;
+        /// Complete operator without executing it, its statement is freed
+        /// @p_Notify : Deliver failure to the caller, callbacks are skipped otherwise
+        void Reject(bool p_Notify) override;
+
+    private:
+        /// Hand result to future or completion queue
+        /// @p_Result : Result set, nullptr if execution failed
+        void Deliver(std::unique_ptr<PreparedResultSet> p_Result);
+
     private:
         PreparedStatement* m_PreparedStatementHolder;                         ///< Holds query and stores result set if any
         std::promise<std::unique_ptr<PreparedResultSet>>* m_PromiseResultSet; ///< Promise which the non database worker thread will hold, database worker thread holds the future
+        CompletionQueue* m_Queue;                                             ///< Queue result is posted to, nullptr if delivered through the promise
+        CompletionQueue::ResultCallback m_Callback;                           ///< Callback posted with the result
     };
 
 }   ///< namespace Database
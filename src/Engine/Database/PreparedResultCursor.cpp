@@ -0,0 +1,220 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Database/PreparedResultCursor.hpp"
+#include "Database/MYSQLPreparedStatement.hpp"
+#include "Database/SQLCommon.hpp"
+#include "Logger/LogDefines.hpp"
+
+namespace SteerStone { namespace Core { namespace Database {
+
+    /// Check if field type has a variable length
+    /// @p_Type : MySQL Type
+    static bool IsVariableLength(enum_field_types p_Type)
+    {
+        switch (p_Type)
+        {
+        case enum_field_types::MYSQL_TYPE_TINY_BLOB:
+        case enum_field_types::MYSQL_TYPE_MEDIUM_BLOB:
+        case enum_field_types::MYSQL_TYPE_LONG_BLOB:
+        case enum_field_types::MYSQL_TYPE_BLOB:
+        case enum_field_types::MYSQL_TYPE_STRING:
+        case enum_field_types::MYSQL_TYPE_VAR_STRING:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor, executes the statement on the calling thread
+    /// @p_Statement : Prepared statement, freed with the cursor
+    PreparedResultCursor::PreparedResultCursor(PreparedStatement* p_Statement)
+        : m_Guard(p_Statement->GetConnection()), m_PreparedStatement(p_Statement), m_Result(nullptr), m_Fields(nullptr), m_FieldCount(0), m_FetchedCount(0), m_Valid(false),
+        m_Bind(nullptr), m_Length(nullptr), m_IsNull(nullptr), m_Row(nullptr)
+    {
+        MYSQL_STMT* l_Stmt = m_PreparedStatement->GetStatement();
+
+        if (!m_PreparedStatement->PrepareExecution())
+            return;
+
+        if (mysql_stmt_execute(l_Stmt))
+        {
+            LOG_ERROR("Database", "Failed to execute statement. Error: %0", mysql_stmt_error(l_Stmt));
+            return;
+        }
+
+        m_Result = mysql_stmt_result_metadata(l_Stmt);
+        m_FieldCount = mysql_stmt_field_count(l_Stmt);
+
+        if (!m_Result)
+            return;
+
+        m_Fields = mysql_fetch_fields(m_Result);
+        m_Variable.resize(m_FieldCount);
+
+        /// Rows are not stored, so max_length is unknown. Fixed size values share one arena with the binds,
+        /// variable length ones start small and grow on truncation
+        std::vector<std::size_t> l_Offsets(m_FieldCount);
+
+        std::size_t l_Size = ArenaAlign(sizeof(MYSQL_BIND) * m_FieldCount + (sizeof(unsigned long) + sizeof(my_bool)) * m_FieldCount);
+        const std::size_t l_RowOffset = l_Size;
+        l_Size += ArenaAlign(sizeof(ResultSet) * m_FieldCount);
+
+        for (std::size_t l_I = 0; l_I < m_FieldCount; l_I++)
+        {
+            if (IsVariableLength(m_Fields[l_I].type))
+            {
+                m_Variable[l_I].resize(std::min<std::size_t>(m_Fields[l_I].length, RESULT_CURSOR_STRING_SIZE) + 1);
+                continue;
+            }
+
+            l_Offsets[l_I] = l_Size;
+            l_Size += ArenaAlign(SizeForType(&m_Fields[l_I]));
+        }
+
+        m_Arena = Memory::AllocatePoolBuffer(l_Size);
+        memset(m_Arena.get(), 0, l_RowOffset);
+
+        m_Bind   = reinterpret_cast<MYSQL_BIND*>(m_Arena.get());
+        m_Length = reinterpret_cast<unsigned long*>(m_Bind + m_FieldCount);
+        m_IsNull = reinterpret_cast<my_bool*>(m_Length + m_FieldCount);
+        m_Row    = reinterpret_cast<ResultSet*>(m_Arena.get() + l_RowOffset);
+
+        for (std::size_t l_I = 0; l_I < m_FieldCount; l_I++)
+        {
+            new (&m_Row[l_I]) ResultSet();
+
+            const bool l_Variable = !m_Variable[l_I].empty();
+
+            m_Bind[l_I].buffer_type = m_Fields[l_I].type;
+            m_Bind[l_I].buffer = l_Variable ? m_Variable[l_I].data() : m_Arena.get() + l_Offsets[l_I];
+            m_Bind[l_I].buffer_length = l_Variable ? static_cast<unsigned long>(m_Variable[l_I].size()) : SizeForType(&m_Fields[l_I]);
+            m_Bind[l_I].length = &m_Length[l_I];
+            m_Bind[l_I].is_null = &m_IsNull[l_I];
+            m_Bind[l_I].error = nullptr;
+            m_Bind[l_I].is_unsigned = m_Fields[l_I].flags & UNSIGNED_FLAG;
+        }
+
+        if (mysql_stmt_bind_result(l_Stmt, m_Bind))
+        {
+            LOG_ERROR("Database", "mysql_stmt_bind_result: Cannot bind result from MySQL server. Error: %0", mysql_stmt_error(l_Stmt));
+            return;
+        }
+
+        m_Valid = true;
+    }
+    /// Deconstructor, rows not read are discarded
+    PreparedResultCursor::~PreparedResultCursor()
+    {
+        if (MYSQL_STMT* l_Stmt = m_PreparedStatement->GetStatement())
+            mysql_stmt_free_result(l_Stmt);
+
+        if (m_Result)
+            mysql_free_result(m_Result);
+
+        m_Arena.reset();
+
+        /// Statement goes back to the pool while we still hold its connection, the guard is released right after
+        m_PreparedStatement->Clear();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Fetch next row, must be called before reading the first row
+    /// Returns false once every row has been read
+    bool PreparedResultCursor::Next()
+    {
+        if (!m_Valid)
+            return false;
+
+        int32 l_Code = mysql_stmt_fetch(m_PreparedStatement->GetStatement());
+
+        if (l_Code == MYSQL_DATA_TRUNCATED && !FetchTruncated())
+            l_Code = 1;
+
+        if (l_Code != 0 && l_Code != MYSQL_DATA_TRUNCATED)
+        {
+            if (l_Code != MYSQL_NO_DATA)
+                LOG_ERROR("Database", "Failed to fetch row. Error: %0", mysql_stmt_error(m_PreparedStatement->GetStatement()));
+
+            m_Valid = false;
+            return false;
+        }
+
+        for (std::size_t l_I = 0; l_I < m_FieldCount; l_I++)
+        {
+            char* l_Buffer = static_cast<char*>(m_Bind[l_I].buffer);
+
+            /// Variable length values always have room for a null terminator after FetchTruncated
+            if (!m_Variable[l_I].empty() && !m_IsNull[l_I])
+                l_Buffer[m_Length[l_I]] = '\0';
+
+            m_Row[l_I].SetValue(m_IsNull[l_I] ? nullptr : l_Buffer, MySQLTypeToFieldType(m_Fields[l_I].type, m_Fields[l_I].flags & UNSIGNED_FLAG ? true : false), m_Length[l_I]);
+        }
+
+        m_FetchedCount++;
+
+        return true;
+    }
+    /// Get field of current row
+    /// @p_Index : Index of field
+    ResultSet const& PreparedResultCursor::operator[](std::size_t p_Index) const
+    {
+        LOG_ASSERT(m_FetchedCount, "Database", "Next must be called before reading a row!");
+        LOG_ASSERT(p_Index < m_FieldCount, "Database", "Index is higher than field count!");
+        return m_Row[p_Index];
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Fetch columns which did not fit their buffer again into grown buffers
+    bool PreparedResultCursor::FetchTruncated()
+    {
+        MYSQL_STMT* l_Stmt = m_PreparedStatement->GetStatement();
+        bool l_Grown = false;
+
+        for (uint32 l_I = 0; l_I < m_FieldCount; l_I++)
+        {
+            if (m_Variable[l_I].empty() || m_IsNull[l_I] || m_Length[l_I] < m_Bind[l_I].buffer_length)
+                continue;
+
+            m_Variable[l_I].resize(m_Length[l_I] + 1);
+            m_Bind[l_I].buffer = m_Variable[l_I].data();
+            m_Bind[l_I].buffer_length = static_cast<unsigned long>(m_Variable[l_I].size());
+
+            if (mysql_stmt_fetch_column(l_Stmt, &m_Bind[l_I], l_I, 0))
+            {
+                LOG_ERROR("Database", "Failed to fetch column %0. Error: %1", l_I, mysql_stmt_error(l_Stmt));
+                return false;
+            }
+
+            l_Grown = true;
+        }
+
+        /// Rows after this one are fetched straight into the grown buffers
+        return !l_Grown || !mysql_stmt_bind_result(l_Stmt, m_Bind);
+    }
+
+}   ///< namespace Database
+}   ///< namespace Core
+}   ///< namespace SteerStone
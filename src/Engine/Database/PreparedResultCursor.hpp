@@ -0,0 +1,90 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+#include "Database/ResultSet.hpp"
+#include "Utility/UtiObjectGuard.hpp"
+#include "Memory/MemPoolResource.hpp"
+
+#include <memory>
+
+#define RESULT_CURSOR_STRING_SIZE   256     ///< Initial buffer of variable length columns, grown when a value does not fit
+
+namespace SteerStone { namespace Core { namespace Database {
+
+    class PreparedStatement;
+    class MYSQLPreparedStatement;
+
+    /// Streams rows of a statement one at a time without storing the result client side
+    /// Only the current row is held in memory. The connection stays locked for the life of the cursor,
+    /// as the server keeps sending rows over it, so cursors are meant for bulk loads read straight through
+    class PreparedResultCursor
+    {
+        DISALLOW_COPY_AND_ASSIGN(PreparedResultCursor);
+
+    public:
+        /// Constructor, executes the statement on the calling thread
+        /// @p_Statement : Prepared statement, freed with the cursor
+        explicit PreparedResultCursor(PreparedStatement* p_Statement);
+        /// Deconstructor, rows not read are discarded
+        ~PreparedResultCursor();
+
+        //////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////////////////////////////////////
+
+    public:
+        /// Statement executed and returned a result
+        bool IsValid() const { return m_Valid; }
+        /// Fetch next row, must be called before reading the first row
+        /// Returns false once every row has been read
+        bool Next();
+        /// Get amount of rows read
+        uint64 GetFetchedCount() const { return m_FetchedCount; }
+        /// Get Field count
+        uint32 GetFieldCount() const { return m_FieldCount; }
+        /// Get field of current row
+        /// @p_Index : Index of field
+        ResultSet const& operator[](std::size_t p_Index) const;
+
+    private:
+        /// Fetch columns which did not fit their buffer again into grown buffers
+        bool FetchTruncated();
+
+    private:
+        Utils::ObjectGuard<MYSQLPreparedStatement> m_Guard;    ///< Connection is busy until the result is drained
+        PreparedStatement* m_PreparedStatement;                 ///< Prepare Statement
+        MYSQL_RES* m_Result;                                    ///< Result metadata
+        MYSQL_FIELD* m_Fields;                                  ///< Field
+        uint32 m_FieldCount;                                    ///< Field count
+        uint64 m_FetchedCount;                                  ///< Rows read
+        bool m_Valid;                                           ///< Statement executed and returned a result
+
+        Memory::PoolBuffer m_Arena;                             ///< Single allocation holding binds, cells and fixed size values of a row
+        MYSQL_BIND* m_Bind;                                     ///< Bind, in arena
+        unsigned long* m_Length;                                ///< Bind Length, in arena
+        my_bool* m_IsNull;                                      ///< Bind Null, in arena
+        ResultSet* m_Row;                                       ///< Cells of current row, in arena
+        std::vector<std::vector<char>> m_Variable;              ///< Buffers of variable length columns, empty for fixed size ones
+    };
+
+}   ///< namespace Database
+}   ///< namespace Core
+}   ///< namespace SteerStone
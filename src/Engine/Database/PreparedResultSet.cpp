@@ -18,6 +18,7 @@
 
 #include "Database/PreparedStatement.hpp"
 #include "Database/SQLCommon.hpp"
+#include "Memory/MemArena.hpp"
 
 #include <assert.h>
 
@@ -29,68 +30,73 @@ namespace SteerStone { namespace Core { namespace Database {
     /// @p_Result : Result
     /// @p_FieldCount : Field count
     /// @p_FreeAutomatically : Free the preparedstatement on PreparedResultSet deconstructor
-    PreparedResultSet::PreparedResultSet(PreparedStatement* p_Statement, MYSQL_RES* p_Result, uint32 p_FieldCount)
-        : m_PreparedStatement(p_Statement), m_Result(p_Result), m_Fields(nullptr), m_Bind(nullptr), m_RowCount(0), m_FieldCount(p_FieldCount), m_RowPosition(0)
+    /// @p_Stored : Result has already been stored by a non blocking worker
+    PreparedResultSet::PreparedResultSet(PreparedStatement* p_Statement, MYSQL_RES* p_Result, uint32 p_FieldCount, bool p_Stored)
+        : m_PreparedStatement(p_Statement), m_Result(p_Result), m_Fields(nullptr), m_RowCount(0), m_FieldCount(p_FieldCount),
+        m_ArenaSize(0), m_IsNull(nullptr), m_Length(nullptr), m_Bind(nullptr), m_RowPosition(0), m_Results(nullptr)
     {
         if (!m_Result)
             return;
 
-        /// IsNull and mLength is deleted at end of constructor when buffer is loaded into our storage
-        m_IsNull = new my_bool[m_FieldCount];
-        m_Length = new unsigned long[m_FieldCount];
-        m_Bind = new MYSQL_BIND[m_FieldCount];
+        MYSQL_STMT* l_Stmt = m_PreparedStatement->GetStatement();
 
-        memset(m_IsNull, 0, sizeof(bool) * m_FieldCount);
-        memset(m_Length, 0, sizeof(unsigned long) * m_FieldCount);
-        memset(m_Bind, 0, sizeof(MYSQL_BIND) * m_FieldCount);
-
-        if (mysql_stmt_store_result(m_PreparedStatement->GetStatement()))
+        if (!p_Stored && mysql_stmt_store_result(l_Stmt))
         {
-            LOG_ERROR("Database", "mysql_stmt_store_result: Cannot store result from MySQL Server. Error: %0"), mysql_stmt_error(m_PreparedStatement->GetStatement());            
-            delete[] m_Bind;
-            delete[] m_IsNull;
-            delete[] m_Length;
+            LOG_ERROR("Database", "mysql_stmt_store_result: Cannot store result from MySQL Server. Error: %0", mysql_stmt_error(l_Stmt));
             return;
         }
 
         m_Fields = mysql_fetch_fields(m_Result);
 
-        m_RowCount = mysql_stmt_num_rows(m_PreparedStatement->GetStatement());
+        m_RowCount = mysql_stmt_num_rows(l_Stmt);
+
+        /// One allocation holds binds, result cells and the values, each column stored contiguously
+        char l_ScratchBuffer[512];
+        Memory::Arena l_Scratch(l_ScratchBuffer, sizeof(l_ScratchBuffer));
+        std::pmr::vector<std::size_t> l_ColumnOffsets(m_FieldCount, &l_Scratch);
+
+        std::size_t l_Size = ArenaAlign(sizeof(MYSQL_BIND) * m_FieldCount + (sizeof(unsigned long) + sizeof(my_bool)) * m_FieldCount);
+        const std::size_t l_ResultsOffset = l_Size;
+        l_Size += ArenaAlign(sizeof(ResultSet) * std::size_t(m_RowCount) * m_FieldCount);
 
-        std::size_t l_SizeType = 0;
         for (std::size_t l_I = 0; l_I < m_FieldCount; l_I++)
         {
-            std::size_t l_Size = SizeForType(&m_Fields[l_I]);
-            l_SizeType += l_Size;
+            l_ColumnOffsets[l_I] = l_Size;
+            l_Size += ArenaAlign(SizeForType(&m_Fields[l_I]) * std::size_t(m_RowCount));
+        }
+
+        m_Arena = Memory::AllocatePoolBuffer(l_Size);
+        m_ArenaSize = l_Size;
+        memset(m_Arena.get(), 0, l_ResultsOffset);
 
+        m_Bind    = reinterpret_cast<MYSQL_BIND*>(m_Arena.get());
+        m_Length  = reinterpret_cast<unsigned long*>(m_Bind + m_FieldCount);
+        m_IsNull  = reinterpret_cast<my_bool*>(m_Length + m_FieldCount);
+        m_Results = reinterpret_cast<ResultSet*>(m_Arena.get() + l_ResultsOffset);
+
+        for (std::size_t l_I = 0; l_I < std::size_t(m_RowCount) * m_FieldCount; l_I++)
+            new (&m_Results[l_I]) ResultSet();
+
+        for (std::size_t l_I = 0; l_I < m_FieldCount; l_I++)
+        {
             m_Bind[l_I].buffer_type = m_Fields[l_I].type;
-            m_Bind[l_I].buffer_length = l_Size;
+            m_Bind[l_I].buffer = m_Arena.get() + l_ColumnOffsets[l_I];
+            m_Bind[l_I].buffer_length = SizeForType(&m_Fields[l_I]);
             m_Bind[l_I].length = &m_Length[l_I];
             m_Bind[l_I].is_null = &m_IsNull[l_I];
             m_Bind[l_I].error = nullptr;
             m_Bind[l_I].is_unsigned = m_Fields[l_I].flags & UNSIGNED_FLAG;
         }
 
-        /// m_Bind handles the deletion of the buffer
-        char* l_DataBuffer = new char[l_SizeType * m_RowCount];
-        for (std::size_t l_I = 0, l_Offset = 0; l_I < m_FieldCount; l_I++)
+        if (mysql_stmt_bind_result(l_Stmt, m_Bind))
         {
-            m_Bind[l_I].buffer = l_DataBuffer + l_Offset;
-            l_Offset += m_Bind[l_I].buffer_length;
-        }
-
-        if (mysql_stmt_bind_result(m_PreparedStatement->GetStatement(), m_Bind))
-        {
-            LOG_ERROR("mysql_stmt_bind_result: Cannot bind result from MySQL server. Error: %0", mysql_stmt_error(m_PreparedStatement->GetStatement()));
-            mysql_stmt_free_result(m_PreparedStatement->GetStatement());
-            CleanUp();
-            delete[] m_IsNull;
-            delete[] m_Length;
+            LOG_ERROR("Database", "mysql_stmt_bind_result: Cannot bind result from MySQL server. Error: %0", mysql_stmt_error(l_Stmt));
+            mysql_stmt_free_result(l_Stmt);
+            m_RowCount = 0;
             return;
         }
 
         /// Buffer all rows in result
-        m_Results.resize(uint32(m_RowCount) * m_FieldCount);
         while (NextRow())
         {
             for (std::size_t l_I = 0; l_I < m_FieldCount; ++l_I)
@@ -98,11 +104,11 @@ namespace SteerStone { namespace Core { namespace Database {
                 unsigned long l_BufferLength = m_Bind[l_I].buffer_length;
                 unsigned long l_FetchedLength = *m_Bind[l_I].length;
 
+                /// Retrieve our buffer
+                char* l_Buffer = static_cast<char*>(l_Stmt->bind[l_I].buffer);
+
                 if (!*m_Bind[l_I].is_null)
                 {
-                    /// Retrieve our buffer
-                    void* l_Buffer = m_PreparedStatement->GetStatement()->bind[l_I].buffer;
-
                     switch (m_Bind[l_I].buffer_type)
                     {
                     case enum_field_types::MYSQL_TYPE_TINY_BLOB:
@@ -115,7 +121,7 @@ namespace SteerStone { namespace Core { namespace Database {
                         /// If our Fetched length is less than buffer length then we assume
                         /// there's no null terminator, so add null terminator at end of buffer
                         if (l_FetchedLength < l_BufferLength)
-                            *((char*)l_Buffer + l_FetchedLength) = '\0';
+                            *(l_Buffer + l_FetchedLength) = '\0';
                     }
                     break;
                     default:
@@ -123,18 +129,18 @@ namespace SteerStone { namespace Core { namespace Database {
                     }
 
                     /// Insert buffer into storage
-                    m_Results[uint32(m_RowPosition) * m_FieldCount + l_I].SetValue(l_Buffer, MySQLTypeToFieldType(m_Bind[l_I].buffer_type, m_Fields[l_I].flags & UNSIGNED_FLAG ? false : true),
+                    m_Results[uint32(m_RowPosition) * m_FieldCount + l_I].SetValue(l_Buffer, MySQLTypeToFieldType(m_Bind[l_I].buffer_type, m_Fields[l_I].flags & UNSIGNED_FLAG ? true : false),
                         l_FetchedLength);
-
-                    /// Move buffer pointer to next part
-                    m_PreparedStatement->GetStatement()->bind[l_I].buffer = (char*)l_Buffer + l_SizeType;
                 }
                 else
                 {
                     /// Insert buffer into storage
-                    m_Results[m_RowPosition * m_FieldCount + l_I].SetValue(nullptr, MySQLTypeToFieldType(m_Bind[l_I].buffer_type, m_Fields[l_I].flags & UNSIGNED_FLAG ? false : true),
+                    m_Results[uint32(m_RowPosition) * m_FieldCount + l_I].SetValue(nullptr, MySQLTypeToFieldType(m_Bind[l_I].buffer_type, m_Fields[l_I].flags & UNSIGNED_FLAG ? true : false),
                         l_FetchedLength);
                 }
+
+                /// Next row of the column
+                l_Stmt->bind[l_I].buffer = l_Buffer + l_BufferLength;
             }
 
             m_RowPosition++;
@@ -143,7 +149,7 @@ namespace SteerStone { namespace Core { namespace Database {
         m_RowPosition = 0;
 
         /// All data is buffered, let go of mysql c api structures
-        mysql_stmt_free_result(m_PreparedStatement->GetStatement());
+        mysql_stmt_free_result(l_Stmt);
     }
     /// Deconstructor
     PreparedResultSet::~PreparedResultSet() 
@@ -168,6 +174,33 @@ namespace SteerStone { namespace Core { namespace Database {
         return m_Results[m_RowPosition * m_FieldCount + p_Index];
     }
 
+    /// Get field of any row, does not move the row position so detached results can be shared
+    /// @p_Row : Index of row
+    /// @p_Index : Index of field
+    ResultSet const& PreparedResultSet::Get(std::size_t p_Row, std::size_t p_Index) const
+    {
+        LOG_ASSERT(p_Row < m_RowCount, "Database", "Row is higher than Row count!");
+        LOG_ASSERT(p_Index < m_FieldCount, "Database", "Index is higher than field count!");
+        return m_Results[p_Row * m_FieldCount + p_Index];
+    }
+
+    /// Free the prepared statement now, the rows stay readable as they live in our arena
+    void PreparedResultSet::Detach()
+    {
+        if (m_Result)
+        {
+            mysql_free_result(m_Result);
+            m_Result = nullptr;
+            m_Fields = nullptr;
+        }
+
+        if (m_PreparedStatement)
+        {
+            m_PreparedStatement->Clear();
+            m_PreparedStatement = nullptr;
+        }
+    }
+
     /// Get Next Row
     bool PreparedResultSet::GetNextRow()
     {
@@ -186,14 +219,13 @@ namespace SteerStone { namespace Core { namespace Database {
         if (m_Result)
             mysql_free_result(m_Result);
 
-        if (m_Bind)
-        {
-            delete[](char*)m_Bind->buffer;
-            delete[] m_Bind;
-            m_Bind = nullptr;
-        }
-        
-        m_PreparedStatement->Clear();
+        /// Binds, cells and values all live in the arena
+        m_Arena.reset();
+        m_Bind = nullptr;
+        m_Results = nullptr;
+
+        if (m_PreparedStatement)
+            m_PreparedStatement->Clear();
     }
     /// Get Next Row
     bool PreparedResultSet::NextRow()
@@ -21,11 +21,16 @@
 
 #include "Core/Core.hpp"
 #include "Database/ResultSet.hpp"
+#include "Memory/MemPoolResource.hpp"
+
+#include <memory>
 
 namespace SteerStone { namespace Core { namespace Database {
 
     class PreparedStatement;
 
+    /// Result of a statement, every row is stored client side then copied into a single arena
+    /// Values of a column are contiguous in the arena, the statement is freed with the result set
     class PreparedResultSet
     {
         DISALLOW_COPY_AND_ASSIGN(PreparedResultSet);
@@ -34,11 +39,15 @@ namespace SteerStone { namespace Core { namespace Database {
         //////////////////////////////////////////////////////////////////////////
 
     public:
+        /// Result sets come from a pool, one is created for every query with a result
+        MEMORY_POOL_OPERATORS(PreparedResultSet)
+
         /// Constructor
         /// @p_Statement : Prepare Statement
         /// @p_Result : Result
         /// @p_FieldCount : Field count
-        PreparedResultSet(PreparedStatement* p_Statement, MYSQL_RES* p_Result, uint32 p_FieldCount);
+        /// @p_Stored : Result has already been stored by a non blocking worker
+        PreparedResultSet(PreparedStatement* p_Statement, MYSQL_RES* p_Result, uint32 p_FieldCount, bool p_Stored = false);
         /// Deconstructor
         ~PreparedResultSet();
 
@@ -53,7 +62,19 @@ namespace SteerStone { namespace Core { namespace Database {
         /// Get Total Row Count
         uint64 GetRowCount() const { return m_RowCount; }
 
-        /// Get Prepare Statement
+        /// Get Field count
+        uint32 GetFieldCount() const { return m_FieldCount; }
+        /// Get field of any row, does not move the row position so detached results can be shared
+        /// @p_Row : Index of row
+        /// @p_Index : Index of field
+        ResultSet const& Get(std::size_t p_Row, std::size_t p_Index) const;
+        /// Get bytes held by the result
+        std::size_t GetMemorySize() const { return sizeof(PreparedResultSet) + m_ArenaSize; }
+
+        /// Free the prepared statement now, the rows stay readable as they live in our arena
+        void Detach();
+
+        /// Get Prepare Statement, nullptr once detached
         PreparedStatement* GetPreparedStatement() { return m_PreparedStatement; }
         /// [] Operator
         ResultSet const& operator[](std::size_t p_Index) const;
@@ -74,12 +95,14 @@ namespace SteerStone { namespace Core { namespace Database {
         uint64 m_RowCount;                      ///< Row count
         uint32 m_FieldCount;                    ///< Field count
 
-        my_bool* m_IsNull;                      ///< Bind Null
-        unsigned long* m_Length;                ///< Bind Length
-        MYSQL_BIND* m_Bind;                     ///< Bind
+        Memory::PoolBuffer m_Arena;             ///< Single allocation holding binds, cells and values
+        std::size_t m_ArenaSize;                ///< Size of arena
+        my_bool* m_IsNull;                      ///< Bind Null, in arena
+        unsigned long* m_Length;                ///< Bind Length, in arena
+        MYSQL_BIND* m_Bind;                     ///< Bind, in arena
 
         uint32 m_RowPosition;                   ///< Row Position
-        std::vector<ResultSet> m_Results;       ///< Result set
+        ResultSet* m_Results;                   ///< Cells of every row, in arena
 
         bool m_FreeAutomatically;               ///< Free the prepared statement on deconstructor
     };
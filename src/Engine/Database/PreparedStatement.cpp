@@ -17,6 +17,7 @@
 */
 
 #include "Database/MYSQLPreparedStatement.hpp"
+#include "Database/PreparedResultCursor.hpp"
 #include "Database.hpp"
 #include "Database/SQLCommon.hpp"
 #include "Logger/LogDefines.hpp"
@@ -26,7 +27,7 @@ namespace SteerStone { namespace Core { namespace Database {
     /// Constructor
     /// @p_MYSQLPreparedStatement : Reference
     PreparedStatement::PreparedStatement(std::shared_ptr<MYSQLPreparedStatement> p_MySQLPreparedStatement) 
-        : m_MYSQLPreparedStatement(p_MySQLPreparedStatement), m_Stmt(nullptr), m_Bind(nullptr), m_PrepareError(false), m_Prepared(false), m_ParametersCount(0)
+        : m_MYSQLPreparedStatement(p_MySQLPreparedStatement), m_Stmt(nullptr), m_BoundStmt(nullptr), m_PrepareError(false), m_Prepared(false), m_ParametersCount(0), m_CatalogStatement(nullptr), m_Profile(nullptr)
     {
         #ifdef STEERSTONE_CORE_DEBUG
             LOG_INFO("PreparedStatement", "PreparedStatement initialized!");
@@ -42,17 +43,6 @@ namespace SteerStone { namespace Core { namespace Database {
     //////////////////////////////////////////////////////////////////////////
     //////////////////////////////////////////////////////////////////////////
 
-    /// Attempt to lock
-    bool PreparedStatement::TryLockMutex()
-    {
-        return m_Mutex.try_lock();
-    }
-    /// Allow to be accessed
-    void PreparedStatement::UnlockMutex()
-    {
-        m_Mutex.unlock();
-    }
-
     /// Prepare the statement
     /// @p_Query : Query which will be executed to database
     void PreparedStatement::PrepareStatement(char const* p_Query)
@@ -64,23 +54,64 @@ namespace SteerStone { namespace Core { namespace Database {
             LOG_ASSERT(false, "Database", "Failed in Preparing Statement!");
         }
     }
+    /// Prepare a statement of the catalog, its handle has been prepared when the connection was set up
+    /// @p_StatementId : Id of statement in catalog
+    void PreparedStatement::PrepareCatalogStatement(uint32 p_StatementId)
+    {
+        StatementCatalog const* l_Catalog = m_MYSQLPreparedStatement->GetCatalog();
+        CatalogStatement const* l_Statement = l_Catalog ? l_Catalog->Get(p_StatementId) : nullptr;
+
+        if (!l_Statement)
+        {
+            m_PrepareError = true;
+
+            LOG_ASSERT(false, "Database", "Statement %0 is not registered in the catalog!", p_StatementId);
+            return;
+        }
+
+        if (m_Prepared)
+        {
+            LOG_ASSERT(false, "Database", "Trying to prepare a statement but statement is already in use!");
+            return;
+        }
+
+        RemoveBinds();
+
+        m_Query = l_Statement->Query;
+        m_CatalogStatement = l_Statement;
+        m_Profile = m_MYSQLPreparedStatement->GetDatabase()->GetQueryProfiler().GetProfile(m_Query, l_Statement->Name);
+
+        if (m_MYSQLPreparedStatement->Prepare(this))
+        {
+            m_PrepareError = true;
+
+            LOG_ASSERT(false, "Database", "Failed in Preparing Statement %0!", l_Statement->Name);
+        }
+    }
     /// ExecuteStatement
     /// Execute the statement
     /// @p_FreeStatementAutomatically : Free the prepared statement when PreparedResultSet deconstructors
     std::unique_ptr<PreparedResultSet> PreparedStatement::ExecuteStatement(bool p_FreeStatementAutomatically)
     {
-        if (m_PrepareError)
+        if (!PrepareExecution())
             return nullptr;
             
         MYSQL_RES* l_Result = nullptr;
         uint32 l_FieldCount = 0;
+        uint64 l_ExecuteTime = 0;
 
-        BindParameters();
-
-        if (m_MYSQLPreparedStatement->Execute(m_Stmt, &l_Result, &l_FieldCount))
+        if (m_MYSQLPreparedStatement->Execute(m_Stmt, &l_Result, &l_FieldCount, &l_ExecuteTime))
         {
+            const auto l_FetchStart = std::chrono::steady_clock::now();
+
             std::unique_ptr<PreparedResultSet> l_PreparedResultSet = std::make_unique<PreparedResultSet>(this, l_Result, l_FieldCount);
 
+            /// Recorded before the result set may free us, binds are still set for the slow query log
+            if (m_Profile)
+                m_MYSQLPreparedStatement->GetDatabase()->GetQueryProfiler().RecordExecution(this, m_Profile, l_ExecuteTime,
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - l_FetchStart).count(),
+                    l_PreparedResultSet->GetRowCount(), l_PreparedResultSet->GetMemorySize());
+
             if (l_PreparedResultSet && l_PreparedResultSet->GetRowCount() || p_FreeStatementAutomatically)
                 return std::move(l_PreparedResultSet);
         }
@@ -88,19 +119,69 @@ namespace SteerStone { namespace Core { namespace Database {
         return nullptr;
     }
 
+    /// Execute the statement on the calling thread and stream its rows, nothing is stored client side
+    /// The statement is freed with the cursor, returns nullptr if execution failed
+    std::unique_ptr<PreparedResultCursor> PreparedStatement::ExecuteCursor()
+    {
+        std::unique_ptr<PreparedResultCursor> l_Cursor = std::make_unique<PreparedResultCursor>(this);
+
+        if (!l_Cursor->IsValid())
+            return nullptr;
+
+        return l_Cursor;
+    }
+
+    /// Bind parameters before a non blocking worker executes the statement
+    /// Returns false if the statement failed to prepare
+    bool PreparedStatement::PrepareExecution()
+    {
+        if (m_PrepareError)
+            return false;
+
+        BindParameters();
+
+        return true;
+    }
+    /// Build result set once a non blocking worker executed the statement and stored its result
+    /// @p_Result : Result metadata
+    /// @p_FieldCount : Field count
+    /// @p_FreeStatementAutomatically : Free the prepared statement when PreparedResultSet deconstructors
+    /// @p_ExecuteTime : Nanoseconds the worker waited for the server to answer
+    /// @p_StoreTime : Nanoseconds the worker spent storing the result
+    std::unique_ptr<PreparedResultSet> PreparedStatement::CompleteExecution(MYSQL_RES* p_Result, uint32 p_FieldCount, bool p_FreeStatementAutomatically, uint64 p_ExecuteTime, uint64 p_StoreTime)
+    {
+        const auto l_FetchStart = std::chrono::steady_clock::now();
+
+        std::unique_ptr<PreparedResultSet> l_PreparedResultSet = std::make_unique<PreparedResultSet>(this, p_Result, p_FieldCount, true);
+
+        if (m_Profile)
+            m_MYSQLPreparedStatement->GetDatabase()->GetQueryProfiler().RecordExecution(this, m_Profile, p_ExecuteTime,
+                p_StoreTime + std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - l_FetchStart).count(),
+                l_PreparedResultSet->GetRowCount(), l_PreparedResultSet->GetMemorySize());
+
+        if (l_PreparedResultSet->GetRowCount() || p_FreeStatementAutomatically)
+            return l_PreparedResultSet;
+
+        return nullptr;
+    }
+
+    /// Record time the operator executing us waited for a worker
+    /// @p_Nanoseconds : Time waited
+    void PreparedStatement::RecordQueueWait(uint64 p_Nanoseconds)
+    {
+        if (m_Profile)
+            m_MYSQLPreparedStatement->GetDatabase()->GetQueryProfiler().RecordQueueWait(m_Profile, p_Nanoseconds);
+    }
+
     /// Clear Prepare Statement
     void PreparedStatement::Clear()
     {
-        if (m_Stmt->bind_result_done)
-        {
-            if (m_Stmt->bind->length)
-                delete m_Stmt->bind->length;
-            if( m_Stmt->bind->is_null)
-                delete m_Stmt->bind->is_null;
-        }
-
+        /// Result binds belong to the arena of the result set, nothing to free here
         m_Prepared = false;
 
+        /// Hand our handle back to the connection cache straight away so other statements can reuse it
+        RemoveBinds();
+
         /// Free the statement
         m_MYSQLPreparedStatement->GetDatabase()->FreePrepareStatement(this);
     }
@@ -109,6 +190,16 @@ namespace SteerStone { namespace Core { namespace Database {
     {
         return m_Stmt;
     }
+    /// Return connection the statement is prepared on
+    MYSQLPreparedStatement* PreparedStatement::GetConnection() const
+    {
+        return m_MYSQLPreparedStatement.get();
+    }
+    /// Check statement is a catalog statement registered as read only
+    bool PreparedStatement::IsReadOnly() const
+    {
+        return m_CatalogStatement && m_CatalogStatement->ReadOnly;
+    }
 
     //////////////////////////////////////////////////////////////////////////
     //////////////////////////////////////////////////////////////////////////
@@ -126,45 +217,92 @@ namespace SteerStone { namespace Core { namespace Database {
         RemoveBinds();
 
         m_Query = p_Query;
+        m_Profile = m_MYSQLPreparedStatement->GetDatabase()->GetQueryProfiler().GetProfile(m_Query, std::string());
 
         return m_MYSQLPreparedStatement->Prepare(this);
     }
 
+    /// Store value of a parameter, checked against the registered type for catalog statements
+    /// @p_Index : Index of parameter
+    /// @p_Data : Value
+    void PreparedStatement::AddBind(uint16 p_Index, SQLBindData&& p_Data)
+    {
+        if (m_CatalogStatement)
+        {
+            const FieldType l_Registered = p_Index < m_CatalogStatement->Parameters.size() ? m_CatalogStatement->Parameters[p_Index] : FieldType::FIELD_NONE;
+
+            /// SetBool binds a tiny integer
+            LOG_ASSERT(l_Registered == p_Data.GetType() || (l_Registered == FieldType::FIELD_BOOL && p_Data.GetType() == FieldType::FIELD_UI8), "Database",
+                "Parameter %0 of %1 does not match its registered type", p_Index, m_CatalogStatement->Name);
+        }
+
+        if (p_Index >= m_Binds.size())
+        {
+            LOG_ASSERT(m_PrepareError, "Database", "Parameter %0 is out of range of %1", p_Index, m_Query);
+            return;
+        }
+
+        m_Binds[p_Index] = std::move(p_Data);
+    }
+
     /// BindParameters
     /// Bind parameters from storage into SQL
     void PreparedStatement::BindParameters()
     {
-        for (auto l_Itr = m_Binds.cbegin(); l_Itr != m_Binds.cend(); l_Itr++)   
+        bool l_Changed = m_BoundStmt != m_Stmt;
+
+        for (uint32 l_I = 0; l_I < m_ParametersCount; l_I++)
         {
+            SQLBindData const& l_Data = m_Binds[l_I];
+            MYSQL_BIND& l_Bind = m_Bind[l_I];
+
             uint8 l_Unsigned = 0;
-            m_Bind[l_Itr->first].buffer_type = l_Itr->second.GetFieldType(l_Unsigned);
-            m_Bind[l_Itr->first].is_unsigned = l_Unsigned;
-            m_Bind[l_Itr->first].buffer = l_Itr->second.GetBuffer();
-            m_Bind[l_Itr->first].length = nullptr;
-            m_Bind[l_Itr->first].buffer_length = l_Itr->second.GetSize();
+            const enum_field_types l_Type = l_Data.GetFieldType(l_Unsigned);
+            void* l_Buffer = l_Data.GetBuffer();
+
+            /// Client reads the length through the pointer when executing, a new length alone needs no rebind
+            m_Lengths[l_I] = static_cast<unsigned long>(l_Data.GetSize());
+
+            if (l_Bind.buffer_type != l_Type || l_Bind.is_unsigned != l_Unsigned || l_Bind.buffer != l_Buffer || l_Bind.length != &m_Lengths[l_I])
+            {
+                l_Bind.buffer_type = l_Type;
+                l_Bind.is_unsigned = l_Unsigned;
+                l_Bind.buffer = l_Buffer;
+                l_Bind.length = &m_Lengths[l_I];
+                l_Changed = true;
+            }
+
+            l_Bind.buffer_length = m_Lengths[l_I];
         }
 
-        if (mysql_stmt_bind_param(m_Stmt, m_Bind))
+        /// Numbers and short strings live at fixed addresses inside m_Binds, only their value changed
+        if (!l_Changed)
+            return;
+
+        if (mysql_stmt_bind_param(m_Stmt, m_Bind.data()))
+        {
             LOG_ERROR("Database", "Cannot bind parameters on %0", m_Query);
+            m_BoundStmt = nullptr;
+            return;
+        }
+
+        m_BoundStmt = m_Stmt;
     }
 
     /// Remove previous binds
     void PreparedStatement::RemoveBinds()
     {
-        if (!m_Stmt)
-            return;
-
-        if (m_ParametersCount)
-        {
-            delete[] m_Bind;
-            m_Bind = nullptr;
-            m_Binds.clear();
-        }
+        /// m_Bind and m_Lengths keep their layout, binding the same handle again may skip mysql_stmt_bind_param
+        /// Handle stays prepared on the server, next prepare of the same query on our connection reuses it
+        if (m_Stmt)
+            m_MYSQLPreparedStatement->ReleaseStatement(this);
 
+        m_Binds.clear();
+        m_CatalogStatement = nullptr;
+        m_Profile = nullptr;
         m_PrepareError = false;
         m_ParametersCount = 0;
         m_Query.clear();
-        mysql_stmt_close(m_Stmt);
         m_Stmt = nullptr;
     }
 
@@ -27,10 +27,15 @@
 namespace SteerStone { namespace Core { namespace Database {
 
     class MYSQLPreparedStatement;
+    class PreparedResultCursor;
+    struct CatalogStatement;
+    struct QueryProfile;
 
     class PreparedStatement
     {
         friend class MYSQLPreparedStatement;
+        friend class QueryProfiler;
+        friend class WorkloadCapture;
 
     public:
         /// Constructor
@@ -43,44 +48,73 @@ namespace SteerStone { namespace Core { namespace Database {
         //////////////////////////////////////////////////////////////////////////
         //////////////////////////////////////////////////////////////////////////
 
-        /// Attempt to lock
-        bool TryLockMutex();
-        /// Allow to be accessed
-        void UnlockMutex();
-
         /// Prepare the statement
         /// @p_Query : Query which will be executed to database
         void PrepareStatement(char const* p_Query);
+        /// Prepare a statement of the catalog, its handle has been prepared when the connection was set up
+        /// @p_StatementId : Id of statement in catalog
+        void PrepareCatalogStatement(uint32 p_StatementId);
         /// ExecuteStatement
         /// Execute the statement
         /// @p_FreeStatementAutomatically : Free the prepared statement when PreparedResultSet deconstructors
         std::unique_ptr<PreparedResultSet> ExecuteStatement(bool p_FreeStatementAutomatically = false);
+        /// Execute the statement on the calling thread and stream its rows, nothing is stored client side
+        /// The statement is freed with the cursor, returns nullptr if execution failed
+        std::unique_ptr<PreparedResultCursor> ExecuteCursor();
+
+        /// Bind parameters before a non blocking worker executes the statement
+        /// Returns false if the statement failed to prepare
+        bool PrepareExecution();
+        /// Build result set once a non blocking worker executed the statement and stored its result
+        /// @p_Result : Result metadata
+        /// @p_FieldCount : Field count
+        /// @p_FreeStatementAutomatically : Free the prepared statement when PreparedResultSet deconstructors
+        /// @p_ExecuteTime : Nanoseconds the worker waited for the server to answer
+        /// @p_StoreTime : Nanoseconds the worker spent storing the result
+        std::unique_ptr<PreparedResultSet> CompleteExecution(MYSQL_RES* p_Result, uint32 p_FieldCount, bool p_FreeStatementAutomatically, uint64 p_ExecuteTime = 0, uint64 p_StoreTime = 0);
+        /// Record time the operator executing us waited for a worker
+        /// @p_Nanoseconds : Time waited
+        void RecordQueueWait(uint64 p_Nanoseconds);
         
         /// Clear Prepared Statements
         void Clear();
 
         /// Return statement
         MYSQL_STMT* GetStatement();
+        /// Return connection the statement is prepared on
+        MYSQLPreparedStatement* GetConnection() const;
+        /// Check statement is a catalog statement registered as read only
+        bool IsReadOnly() const;
 
         /// Set our prepared values
-        void SetBool(uint8 p_Index, uint8 p_Value)         { m_Binds.push_back(std::make_pair(p_Index, SQLBindData(p_Value))); }
-        void SetUint8(uint8 p_Index, uint8 p_Value)        { m_Binds.push_back(std::make_pair(p_Index, SQLBindData(p_Value))); }
-        void SetUint16(uint8 p_Index, uint16 p_Value)      { m_Binds.push_back(std::make_pair(p_Index, SQLBindData(p_Value))); }
-        void SetUint32(uint8 p_Index, uint32 p_Value)      { m_Binds.push_back(std::make_pair(p_Index, SQLBindData(p_Value))); }
-        void SetUint64(uint8 p_Index, uint64 p_Value)      { m_Binds.push_back(std::make_pair(p_Index, SQLBindData(p_Value))); }
-        void SetInt8(uint8 p_Index, int8 p_Value)          { m_Binds.push_back(std::make_pair(p_Index, SQLBindData(p_Value))); }
-        void SetInt16(uint8 p_Index, int16 p_Value)        { m_Binds.push_back(std::make_pair(p_Index, SQLBindData(p_Value))); }
-        void SetInt32(uint8 p_Index, int32 p_Value)        { m_Binds.push_back(std::make_pair(p_Index, SQLBindData(p_Value))); }
-        void SetInt64(uint8 p_Index, int64 p_Value)        { m_Binds.push_back(std::make_pair(p_Index, SQLBindData(p_Value))); }
-        void SetFloat(uint8 p_Index, float p_Value)        { m_Binds.push_back(std::make_pair(p_Index, SQLBindData(p_Value))); }
-        void SetDouble(uint8 p_Index, double p_Value)      { m_Binds.push_back(std::make_pair(p_Index, SQLBindData(p_Value))); }
-        void SetString(uint8 p_Index, std::string p_Value) { m_Binds.push_back(std::make_pair(p_Index, SQLBindData(p_Value))); }
+        void SetBool(uint8 p_Index, uint8 p_Value)         { AddBind(p_Index, SQLBindData(p_Value)); }
+        void SetUint8(uint8 p_Index, uint8 p_Value)        { AddBind(p_Index, SQLBindData(p_Value)); }
+        void SetUint16(uint8 p_Index, uint16 p_Value)      { AddBind(p_Index, SQLBindData(p_Value)); }
+        void SetUint32(uint8 p_Index, uint32 p_Value)      { AddBind(p_Index, SQLBindData(p_Value)); }
+        void SetUint64(uint8 p_Index, uint64 p_Value)      { AddBind(p_Index, SQLBindData(p_Value)); }
+        void SetInt8(uint8 p_Index, int8 p_Value)          { AddBind(p_Index, SQLBindData(p_Value)); }
+        void SetInt16(uint8 p_Index, int16 p_Value)        { AddBind(p_Index, SQLBindData(p_Value)); }
+        void SetInt32(uint8 p_Index, int32 p_Value)        { AddBind(p_Index, SQLBindData(p_Value)); }
+        void SetInt64(uint8 p_Index, int64 p_Value)        { AddBind(p_Index, SQLBindData(p_Value)); }
+        void SetFloat(uint8 p_Index, float p_Value)        { AddBind(p_Index, SQLBindData(p_Value)); }
+        void SetDouble(uint8 p_Index, double p_Value)      { AddBind(p_Index, SQLBindData(p_Value)); }
+        void SetString(uint8 p_Index, std::string p_Value) { AddBind(p_Index, SQLBindData(std::move(p_Value))); }
+        /// Bind a string or bytes without copying them, memory must stay valid until the statement has executed
+        void SetStringView(uint8 p_Index, std::string_view p_Value)                  { AddBind(p_Index, SQLBindData::View(p_Value)); }
+        void SetBinary(uint8 p_Index, void const* p_Data, std::size_t p_Length)      { AddBind(p_Index, SQLBindData::Binary(p_Data, p_Length)); }
+        /// Set value of any type, indices above 255 are only reachable through here
+        void SetData(uint16 p_Index, SQLBindData p_Value)  { AddBind(p_Index, std::move(p_Value)); }
 
     private:
         /// Prepare the query
         /// @p_Query : Query which will be executed to database
         bool Prepare(char const * p_Query);
 
+        /// Store value of a parameter, checked against the registered type for catalog statements
+        /// @p_Index : Index of parameter
+        /// @p_Data : Value
+        void AddBind(uint16 p_Index, SQLBindData&& p_Data);
+
         /// BindParameters
         /// Bind parameters from storage into SQL
         void BindParameters();
@@ -91,14 +125,17 @@ namespace SteerStone { namespace Core { namespace Database {
 
     private:
         MYSQL_STMT* m_Stmt;
-        MYSQL_BIND* m_Bind;
+        std::vector<MYSQL_BIND> m_Bind;                 ///< Parameter binds, sized from the parameter count on prepare
+        std::vector<unsigned long> m_Lengths;           ///< Length of each parameter, read by the client when executing
+        MYSQL_STMT* m_BoundStmt;                        ///< Handle m_Bind was last bound on, rebinding it is skipped while nothing moved
         std::shared_ptr<MYSQLPreparedStatement> m_MYSQLPreparedStatement;
         uint32 m_ParametersCount;
         std::string m_Query;
         bool m_PrepareError;
         bool m_Prepared;
-        std::vector<std::pair<uint8, SQLBindData>> m_Binds;
-        std::mutex m_Mutex;
+        std::vector<SQLBindData> m_Binds;               ///< Value of each parameter, unset parameters are NULL
+        CatalogStatement const* m_CatalogStatement;
+        QueryProfile* m_Profile;
     };
 
 }   ///< namespace Database
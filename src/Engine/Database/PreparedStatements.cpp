@@ -19,21 +19,60 @@
 #include "Database/Database.hpp"
 #include "Logger/Base.hpp"
 #include "SQLCommon.hpp"
+#include "Threading/ThrTaskManager.hpp"
+#include "Threading/ThrThisThread.hpp"
 
 namespace SteerStone { namespace Core { namespace Database {
 
     /// Constructor
     PreparedStatements::PreparedStatements()
+        : m_Capacity(0), m_StatementsPerConnection(DEFAULT_PREPARED_STATEMENTS), m_WaitTimeout(DEFAULT_POOL_WAIT_TIMEOUT), m_Catalog(nullptr),
+        m_ConnectTimeout(DEFAULT_CONNECT_TIMEOUT), m_ConnectRetries(DEFAULT_CONNECT_RETRIES), m_ReconnectInterval(DEFAULT_RECONNECT_INTERVAL), m_Waiting(0),
+        m_InUse(0), m_PeakInUse(0), m_ExhaustedCount(0), m_TimeoutCount(0)
     {
     }
     /// Deconstructor
     PreparedStatements::~PreparedStatements()
     {
+        if (m_ReconnectTask)
+            sThreadManager->PopTask(m_ReconnectTask);
     }
 
     //////////////////////////////////////////////////////////////////////////
     //////////////////////////////////////////////////////////////////////////
 
+    /// Set pool limits, must be called before Connect
+    /// @p_StatementsPerConnection : Amount of prepared statements of each connection
+    /// @p_WaitTimeout             : Milliseconds a caller waits for an idle statement, 0 waits forever
+    void PreparedStatements::SetPoolLimits(uint32 p_StatementsPerConnection, uint32 p_WaitTimeout)
+    {
+        if (p_StatementsPerConnection < MIN_PREPARED_STATEMENTS)
+            p_StatementsPerConnection = MIN_PREPARED_STATEMENTS;
+        else if (p_StatementsPerConnection > MAX_PREPARED_STATEMENTS)
+            p_StatementsPerConnection = MAX_PREPARED_STATEMENTS;
+
+        m_StatementsPerConnection   = p_StatementsPerConnection;
+        m_WaitTimeout               = p_WaitTimeout;
+    }
+
+    /// Set connection limits, must be called before Connect
+    /// @p_ConnectTimeout    : Milliseconds a connection attempt may take
+    /// @p_ConnectRetries    : Attempts of each connection at start before it is left to the background
+    /// @p_ReconnectInterval : Milliseconds between background attempts of connections which failed at start
+    void PreparedStatements::SetConnectLimits(uint32 p_ConnectTimeout, uint32 p_ConnectRetries, uint32 p_ReconnectInterval)
+    {
+        m_ConnectTimeout    = p_ConnectTimeout;
+        m_ConnectRetries    = std::max<uint32>(p_ConnectRetries, 1);
+        m_ReconnectInterval = std::max<uint32>(p_ReconnectInterval, 1);
+    }
+
+    /// Set catalog prepared on every connection, must be called before Connect
+    /// @p_Catalog : Catalog, must outlive the pool
+    void PreparedStatements::SetCatalog(StatementCatalog const* p_Catalog)
+    {
+        m_Catalog = p_Catalog;
+    }
+
     /// @p_Username : Name of user
     /// @p_Password : Password of user
     /// @p_Port     : Port we are connecting to
@@ -41,55 +80,326 @@ namespace SteerStone { namespace Core { namespace Database {
     /// @p_Database : Database we are querying to
     /// @p_PoolSize : Amount of MYSQL connections we are spawning
     /// @p_Base     : Database
+    /// @p_NonBlocking : Enable the non blocking API on the connections
     uint32 PreparedStatements::Connect(std::string const p_Username, std::string const p_Password, uint32 const p_Port, std::string const p_Host, 
-        std::string const p_Database, uint32 const p_PoolSize, Base* p_Base)
+        std::string const p_Database, uint32 const p_PoolSize, Base* p_Base, bool const p_NonBlocking)
     {
+        m_ConnectionInfo = ConnectionInfo{ p_Username, p_Password, p_Port, p_Host, p_Database, p_NonBlocking };
+
+        std::vector<std::shared_ptr<MYSQLPreparedStatement>> l_Connections;
+        l_Connections.reserve(p_PoolSize);
+
+        for (uint32 l_I = 0; l_I < p_PoolSize; l_I++)
+            l_Connections.push_back(std::make_shared<MYSQLPreparedStatement>(p_Base));
+
+        /// Each connection pays its own round trips (handshake, catalog prepares), open them all at once
+        std::vector<uint32> l_Errors(p_PoolSize, 0);
+        std::vector<uint8> l_CatalogErrors(p_PoolSize, 0);
+
+        sThreadManager->ParallelFor(std::size_t(0), l_Connections.size(), std::size_t(1), [this, &l_Connections, &l_Errors, &l_CatalogErrors](std::size_t p_Index) {
+            bool l_Catalog = false;
+            l_Errors[p_Index] = OpenConnection(l_Connections[p_Index].get(), m_ConnectRetries, l_Catalog);
+            l_CatalogErrors[p_Index] = l_Catalog;
+        });
+
+        uint32 l_LastError = 0;
+
         for (uint32 l_I = 0; l_I < p_PoolSize; l_I++)
         {
-            std::shared_ptr<MYSQLPreparedStatement> l_PreparedStatement = std::make_shared<MYSQLPreparedStatement>(p_Base);
+            /// A bad statement fails the same way on every connection
+            if (l_CatalogErrors[l_I])
+            {
+                LOG_ERROR("Database", "Failed to prepare statement catalog. MySQL Error: %0.", l_Errors[l_I]);
+                return l_Errors[l_I];
+            }
 
-            uint32 l_Success = l_PreparedStatement->Connect(p_Username, p_Password, p_Port, p_Host, p_Database);
-            
-            /// If > 0 - Failed to connect
-            if (l_Success)
+            if (l_Errors[l_I])
             {
-                LOG_ERROR("Database", "Failed to create connection. MySQL Error: %0. Please refer to MYSQL Documentation.", l_Success);
-                return l_Success;
+                l_LastError = l_Errors[l_I];
+                m_Offline.push_back(l_Connections[l_I]);
             }
+            else
+                m_ConnectionPool.push_back(l_Connections[l_I]);
+        }
+
+        if (m_ConnectionPool.empty())
+        {
+            LOG_ERROR("Database", "Failed to create connection. MySQL Error: %0. Please refer to MYSQL Documentation.", l_LastError);
+            return l_LastError;
+        }
+
+        if (m_Catalog)
+            LOG_INFO("Database", "Prepared statement catalog of %0 statements on %1 connections", m_Catalog->GetSize(), static_cast<uint32>(m_ConnectionPool.size()));
 
-            m_ConnectionPool.push_back(l_PreparedStatement);
+        /// Sized for the whole pool so connections coming back later fit
+        m_Capacity = static_cast<uint32>(m_ConnectionPool.size()) * m_StatementsPerConnection;
+        m_FreeList.reset(new Utils::MPMCQueue<PreparedStatement*>(p_PoolSize * m_StatementsPerConnection));
+
+        /// Interleave connections so consecutive checkouts spread over all of them
+        for (uint32 l_I = 0; l_I < m_StatementsPerConnection; l_I++)
+        {
+            for (auto const& l_Connection : m_ConnectionPool)
+                m_FreeList->TryPush(l_Connection->m_Statements[l_I]);
+        }
+
+        if (!m_Offline.empty())
+        {
+            LOG_WARNING("Database", "%0 of %1 connections failed (MySQL Error: %2), retrying every %3 ms in the background",
+                static_cast<uint32>(m_Offline.size()), p_PoolSize, l_LastError, m_ReconnectInterval);
+
+            m_ReconnectTask = sThreadManager->PushTask("DATABASE_RECONNECT", Threading::TaskType::Normal, m_ReconnectInterval, [this]() -> bool
+            {
+                Reconnect();
+                return true;
+            });
         }
 
         return 0;
     }
 
-    /// Attempt to get a Prepared Statement
+    /// Get an idle Prepared Statement, waits for one to be freed if pool is exhausted
+    /// Returns nullptr if none was freed within the wait timeout
     PreparedStatement * PreparedStatements::Prepare()
     {
-        for(;;)
+        PreparedStatement* l_PrepareStatement = nullptr;
+
+        /// Fast path, only taken when nobody is queued so waiters are not overtaken
+        if (m_Waiting.load(std::memory_order_seq_cst) == 0 && m_FreeList->TryPop(l_PrepareStatement))
         {
-            for (auto l_Itr : m_ConnectionPool)
-            {
-                std::shared_ptr<MYSQLPreparedStatement> l_PreparedStatement = l_Itr;
+            OnCheckout();
+            return l_PrepareStatement;
+        }
 
-                for (uint32 l_I = 0; l_I < MAX_PREPARED_STATEMENTS; l_I++)
-                {
-                    PreparedStatement* l_PrepareStatement = l_PreparedStatement->m_Statements[l_I];
+        m_ExhaustedCount.fetch_add(1, std::memory_order_relaxed);
 
-                    if (l_PrepareStatement->TryLockMutex())
-                        return l_PrepareStatement;
-                }
-            }
+        const auto l_Start = std::chrono::steady_clock::now();
+        const auto l_Deadline = l_Start + std::chrono::milliseconds(m_WaitTimeout);
+
+        Waiter l_Waiter;
+        std::unique_lock<std::mutex> l_Guard(m_WaitMutex);
+
+        m_Waiters.push_back(&l_Waiter);
+
+        /// Announce ourself before checking, Free publishing after our check sees us
+        m_Waiting.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        bool l_TimedOut = false;
+
+        while (true)
+        {
+            if (m_Waiters.front() == &l_Waiter && m_FreeList->TryPop(l_PrepareStatement))
+                break;
+
+            if (l_TimedOut)
+                break;
+
+            if (!m_WaitTimeout)
+                l_Waiter.Condition.wait(l_Guard);
+            else if (l_Waiter.Condition.wait_until(l_Guard, l_Deadline) == std::cv_status::timeout)
+                l_TimedOut = true;    ///< Last attempt, a statement may have been freed along with the timeout
+        }
+
+        m_Waiters.erase(std::find(m_Waiters.begin(), m_Waiters.end(), &l_Waiter));
+        m_Waiting.fetch_sub(1, std::memory_order_relaxed);
+
+        m_WaitHistogram.Record(std::chrono::steady_clock::now() - l_Start);
+
+        /// Several statements may have been freed, or we gave up our turn
+        WakeFront();
+
+        l_Guard.unlock();
 
-            LOG_WARNING("PreparedStatements", "Could not get a prepare statement... trying again!");
+        if (!l_PrepareStatement)
+        {
+            m_TimeoutCount.fetch_add(1, std::memory_order_relaxed);
+
+            LOG_WARNING("PreparedStatements", "No prepare statement was freed within %0 ms, pool of %1 statements is exhausted", m_WaitTimeout, GetPoolCapacity());
+            return nullptr;
         }
 
-        return nullptr;
+        OnCheckout();
+        return l_PrepareStatement;
     }
     /// Release Prepare statement to be used again
     void PreparedStatements::Free(PreparedStatement* p_PrepareStatement)
     {
-        p_PrepareStatement->UnlockMutex();
+        m_InUse.fetch_sub(1, std::memory_order_relaxed);
+
+        /// Free list holds every statement of the pool, never full
+        m_FreeList->TryPush(p_PrepareStatement);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (m_Waiting.load(std::memory_order_seq_cst) == 0)
+            return;
+
+        std::lock_guard<std::mutex> l_Guard(m_WaitMutex);
+        WakeFront();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get amount of statements in pool
+    uint32 PreparedStatements::GetPoolCapacity() const
+    {
+        return m_Capacity.load(std::memory_order_relaxed);
+    }
+    /// Get amount of statements checked out
+    uint32 PreparedStatements::GetPoolInUse() const
+    {
+        return m_InUse.load(std::memory_order_relaxed);
+    }
+    /// Get highest amount of statements checked out at once
+    uint32 PreparedStatements::GetPoolPeakInUse() const
+    {
+        return m_PeakInUse.load(std::memory_order_relaxed);
+    }
+    /// Get share of statements checked out, from 0 to 1
+    float PreparedStatements::GetPoolUtilization() const
+    {
+        const uint32 l_Capacity = GetPoolCapacity();
+        return l_Capacity ? static_cast<float>(GetPoolInUse()) / static_cast<float>(l_Capacity) : 0.0f;
+    }
+    /// Get amount of times a caller found the pool exhausted and had to wait
+    uint64 PreparedStatements::GetPoolExhaustedCount() const
+    {
+        return m_ExhaustedCount.load(std::memory_order_relaxed);
+    }
+    /// Get amount of times a caller gave up waiting
+    uint64 PreparedStatements::GetPoolTimeoutCount() const
+    {
+        return m_TimeoutCount.load(std::memory_order_relaxed);
+    }
+    /// Get amount of connections which failed at start and are still being retried
+    uint32 PreparedStatements::GetPoolOfflineCount() const
+    {
+        std::lock_guard<std::mutex> l_Guard(m_ReconnectMutex);
+        return static_cast<uint32>(m_Offline.size());
+    }
+    /// Get time callers waited for an idle statement, only callers which had to wait are recorded
+    Diagnostic::LatencyHistogram const& PreparedStatements::GetPoolWaitHistogram() const
+    {
+        return m_WaitHistogram;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get connections of pool
+    std::vector<std::shared_ptr<MYSQLPreparedStatement>> const& PreparedStatements::GetConnections() const
+    {
+        return m_ConnectionPool;
+    }
+    /// Copy pool limits, connection limits and catalog to another pool before it connects
+    /// @p_Other : Pool
+    void PreparedStatements::CopyLimits(PreparedStatements& p_Other) const
+    {
+        p_Other.SetPoolLimits(m_StatementsPerConnection, m_WaitTimeout);
+        p_Other.SetConnectLimits(m_ConnectTimeout, m_ConnectRetries, m_ReconnectInterval);
+        p_Other.SetCatalog(m_Catalog);
+    }
+    /// Check a statement of the catalog is registered as read only
+    /// @p_StatementId : Id of statement in catalog
+    bool PreparedStatements::IsReadOnlyStatement(uint32 p_StatementId) const
+    {
+        CatalogStatement const* l_Statement = m_Catalog ? m_Catalog->Get(p_StatementId) : nullptr;
+
+        return l_Statement && l_Statement->ReadOnly;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Open a connection and prepare the catalog on it
+    /// @p_Connection : Connection
+    /// @p_Attempts   : Attempts made before giving up
+    /// @p_Catalog    : Set to true if the catalog failed to prepare, retrying would not help
+    /// Returns 0 on success, MySQL error otherwise
+    uint32 PreparedStatements::OpenConnection(MYSQLPreparedStatement* p_Connection, uint32 p_Attempts, bool& p_Catalog)
+    {
+        ConnectionInfo const& l_Info = m_ConnectionInfo;
+        uint32 l_Error = 0;
+
+        p_Catalog = false;
+
+        for (uint32 l_Attempt = 0; l_Attempt < p_Attempts; l_Attempt++)
+        {
+            /// Back off a little more on every attempt, a failing over server needs a moment
+            if (l_Attempt)
+                Threading::ThisThread::SleepFor(std::min<uint64>(100ull << (l_Attempt - 1), m_ReconnectInterval));
+
+            l_Error = p_Connection->Connect(l_Info.Username, l_Info.Password, l_Info.Port, l_Info.Host, l_Info.Database, m_StatementsPerConnection, m_ConnectTimeout, l_Info.NonBlocking);
+
+            if (!l_Error)
+                break;
+        }
+
+        if (l_Error || !m_Catalog)
+            return l_Error;
+
+        l_Error = p_Connection->PrepareCatalog(m_Catalog);
+        p_Catalog = l_Error != 0;
+
+        return l_Error;
+    }
+    /// Retry connections which failed at start, runs on a task worker
+    void PreparedStatements::Reconnect()
+    {
+        std::vector<std::shared_ptr<MYSQLPreparedStatement>> l_Offline;
+
+        {
+            std::lock_guard<std::mutex> l_Guard(m_ReconnectMutex);
+            l_Offline = m_Offline;
+        }
+
+        if (l_Offline.empty())
+            return;
+
+        for (auto const& l_Connection : l_Offline)
+        {
+            bool l_Catalog = false;
+            if (const uint32 l_Error = OpenConnection(l_Connection.get(), 1, l_Catalog))
+            {
+                LOG_WARNING("Database", "Reconnect failed. MySQL Error: %0.", l_Error);
+                continue;
+            }
+
+            {
+                std::lock_guard<std::mutex> l_Guard(m_ReconnectMutex);
+
+                m_Offline.erase(std::find(m_Offline.begin(), m_Offline.end(), l_Connection));
+                m_Recovered.push_back(l_Connection);
+            }
+
+            m_Capacity.fetch_add(m_StatementsPerConnection, std::memory_order_relaxed);
+
+            /// Same path as a free, wakes anyone waiting on an exhausted pool
+            for (PreparedStatement* l_Statement : l_Connection->m_Statements)
+            {
+                m_InUse.fetch_add(1, std::memory_order_relaxed);
+                Free(l_Statement);
+            }
+
+            LOG_INFO("Database", "Connection re-established, pool holds %0 statements", GetPoolCapacity());
+        }
+    }
+    /// Account a statement being checked out
+    void PreparedStatements::OnCheckout()
+    {
+        const uint32 l_InUse = m_InUse.fetch_add(1, std::memory_order_relaxed) + 1;
+        uint32 l_Peak = m_PeakInUse.load(std::memory_order_relaxed);
+
+        while (l_InUse > l_Peak && !m_PeakInUse.compare_exchange_weak(l_Peak, l_InUse, std::memory_order_relaxed))
+        {
+        }
+    }
+    /// Wake waiter at front of queue, wait mutex must be held
+    void PreparedStatements::WakeFront()
+    {
+        if (!m_Waiters.empty())
+            m_Waiters.front()->Condition.notify_one();
     }
 
 }   ///< namespace Database
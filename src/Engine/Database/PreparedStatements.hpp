@@ -21,15 +21,42 @@
 
 #include "Core/Core.hpp"
 #include "Database/MYSQLPreparedStatement.hpp"
+#include "Diagnostic/DiaHistogram.hpp"
+#include "Threading/ThrTask.hpp"
+#include "Utility/UtiBoundedQueue.hpp"
+
+#include <condition_variable>
+#include <deque>
 
 namespace SteerStone { namespace Core { namespace Database {
 
     class Base;
 
+    /// Pool of prepared statements over all connections
+    /// Idle statements sit in a lock free free list, callers finding it empty queue up and are
+    /// woken in arrival order as statements are freed, waiting at most the configured timeout
+    /// Connections are opened and warmed up in parallel, the ones failing at start are retried in the background
     class PreparedStatements
     {
         DISALLOW_COPY_AND_ASSIGN(PreparedStatements);
 
+        /// Caller waiting for an idle statement
+        struct Waiter
+        {
+            std::condition_variable Condition;      ///< Signaled when the waiter reached the front and a statement was freed
+        };
+
+        /// Details connections are opened with, kept for background reconnects
+        struct ConnectionInfo
+        {
+            std::string Username;                   ///< Name of user
+            std::string Password;                   ///< Password of user
+            uint32 Port;                            ///< Port we are connecting to
+            std::string Host;                       ///< Address we are connecting to
+            std::string Database;                   ///< Database we are querying to
+            bool NonBlocking;                       ///< Enable the non blocking API on the connections
+        };
+
         //////////////////////////////////////////////////////////////////////////
         //////////////////////////////////////////////////////////////////////////
 
@@ -43,6 +70,19 @@ namespace SteerStone { namespace Core { namespace Database {
         //////////////////////////////////////////////////////////////////////////
         //////////////////////////////////////////////////////////////////////////
 
+        /// Set pool limits, must be called before Connect
+        /// @p_StatementsPerConnection : Amount of prepared statements of each connection
+        /// @p_WaitTimeout             : Milliseconds a caller waits for an idle statement, 0 waits forever
+        void SetPoolLimits(uint32 p_StatementsPerConnection, uint32 p_WaitTimeout);
+        /// Set connection limits, must be called before Connect
+        /// @p_ConnectTimeout    : Milliseconds a connection attempt may take
+        /// @p_ConnectRetries    : Attempts of each connection at start before it is left to the background
+        /// @p_ReconnectInterval : Milliseconds between background attempts of connections which failed at start
+        void SetConnectLimits(uint32 p_ConnectTimeout, uint32 p_ConnectRetries, uint32 p_ReconnectInterval);
+        /// Set catalog prepared on every connection, must be called before Connect
+        /// @p_Catalog : Catalog, must outlive the pool
+        void SetCatalog(StatementCatalog const* p_Catalog);
+
         /// @p_Username : Name of user
         /// @p_Password : Password of user
         /// @p_Port     : Port we are connecting to
@@ -50,21 +90,91 @@ namespace SteerStone { namespace Core { namespace Database {
         /// @p_Database : Database we are querying to
         /// @p_PoolSize : Amount of MYSQL connections we are spawning
         /// @p_Base     : Database
+        /// @p_NonBlocking : Enable the non blocking API on the connections
+        /// Returns 0 once at least one connection is up, MySQL error otherwise
         uint32 Connect(std::string const p_Username, std::string const p_Password,
-            uint32 const p_Port, std::string const p_Host, std::string const p_Database, uint32 const p_PoolSize, Base* p_Base);
+            uint32 const p_Port, std::string const p_Host, std::string const p_Database, uint32 const p_PoolSize, Base* p_Base, bool const p_NonBlocking = false);
 
-        /// Attempt to get a Prepared Statement
+        /// Get an idle Prepared Statement, waits for one to be freed if pool is exhausted
+        /// Returns nullptr if none was freed within the wait timeout
         PreparedStatement* Prepare();
         /// FreePrepareStatement
         /// Release Prepare statement to be used again
         void Free(PreparedStatement* p_PrepareStatement);
 
+        //////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////////////////////////////////////
+
+        /// Get amount of statements in pool
+        uint32 GetPoolCapacity() const;
+        /// Get amount of statements checked out
+        uint32 GetPoolInUse() const;
+        /// Get highest amount of statements checked out at once
+        uint32 GetPoolPeakInUse() const;
+        /// Get share of statements checked out, from 0 to 1
+        float GetPoolUtilization() const;
+        /// Get amount of times a caller found the pool exhausted and had to wait
+        uint64 GetPoolExhaustedCount() const;
+        /// Get amount of times a caller gave up waiting
+        uint64 GetPoolTimeoutCount() const;
+        /// Get amount of connections which failed at start and are still being retried
+        uint32 GetPoolOfflineCount() const;
+        /// Get time callers waited for an idle statement, only callers which had to wait are recorded
+        Diagnostic::LatencyHistogram const& GetPoolWaitHistogram() const;
+
     //////////////////////////////////////////////////////////////////////////
     //////////////////////////////////////////////////////////////////////////
 
+    protected:
+        /// Get connections of pool
+        std::vector<std::shared_ptr<MYSQLPreparedStatement>> const& GetConnections() const;
+        /// Copy pool limits, connection limits and catalog to another pool before it connects
+        /// @p_Other : Pool
+        void CopyLimits(PreparedStatements& p_Other) const;
+        /// Check a statement of the catalog is registered as read only
+        /// @p_StatementId : Id of statement in catalog
+        bool IsReadOnlyStatement(uint32 p_StatementId) const;
+
+    private:
+        /// Open a connection and prepare the catalog on it
+        /// @p_Connection : Connection
+        /// @p_Attempts   : Attempts made before giving up
+        /// @p_Catalog    : Set to true if the catalog failed to prepare, retrying would not help
+        /// Returns 0 on success, MySQL error otherwise
+        uint32 OpenConnection(MYSQLPreparedStatement* p_Connection, uint32 p_Attempts, bool& p_Catalog);
+        /// Retry connections which failed at start, runs on a task worker
+        void Reconnect();
+        /// Account a statement being checked out
+        void OnCheckout();
+        /// Wake waiter at front of queue, wait mutex must be held
+        void WakeFront();
+
     private:
         std::vector<std::shared_ptr<MYSQLPreparedStatement>> m_ConnectionPool;    ///< Storage for Prepare Statements
+        std::unique_ptr<Utils::MPMCQueue<PreparedStatement*>> m_FreeList;         ///< Idle statements
+        std::atomic<uint32> m_Capacity;                                             ///< Amount of statements in pool, grows as connections come back
+        uint32 m_StatementsPerConnection;                                           ///< Amount of prepared statements of each connection
+        uint32 m_WaitTimeout;                                                       ///< Milliseconds a caller waits, 0 waits forever
+        StatementCatalog const* m_Catalog;                                          ///< Catalog prepared on every connection
+
+        ConnectionInfo m_ConnectionInfo;                                            ///< Details connections are opened with
+        uint32 m_ConnectTimeout;                                                    ///< Milliseconds a connection attempt may take
+        uint32 m_ConnectRetries;                                                    ///< Attempts of each connection at start
+        uint32 m_ReconnectInterval;                                                 ///< Milliseconds between background attempts
+        mutable std::mutex m_ReconnectMutex;                                        ///< Guards m_Offline and m_Recovered
+        std::vector<std::shared_ptr<MYSQLPreparedStatement>> m_Offline;            ///< Connections which failed at start
+        std::vector<std::shared_ptr<MYSQLPreparedStatement>> m_Recovered;          ///< Connections opened in the background, m_ConnectionPool is fixed once Connect returns
+        Threading::Task::Ptr m_ReconnectTask;                                       ///< Task retrying m_Offline
+
+        std::mutex m_WaitMutex;                                                     ///< Guards m_Waiters and m_WaitHistogram
+        std::deque<Waiter*> m_Waiters;                                              ///< Callers waiting, in arrival order
+        std::atomic<uint32> m_Waiting;                                              ///< Size of m_Waiters, read without the mutex
 
+        std::atomic<uint32> m_InUse;                                                ///< Statements checked out
+        std::atomic<uint32> m_PeakInUse;                                            ///< Highest amount of statements checked out
+        std::atomic<uint64> m_ExhaustedCount;                                       ///< Callers which had to wait
+        std::atomic<uint64> m_TimeoutCount;                                         ///< Callers which gave up waiting
+        Diagnostic::LatencyHistogram m_WaitHistogram;                               ///< Time waited by callers which had to wait
     };
 
 }   ///< namespace Database
@@ -0,0 +1,292 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Database/QueryCache.hpp"
+#include "Database/Database.hpp"
+#include "Logger/LogDefines.hpp"
+
+namespace SteerStone { namespace Core { namespace Database {
+
+    /// Constructor
+    /// @p_Database : Database queries are sent to
+    /// @p_MaxBytes : Memory budget of cached results
+    /// @p_TTL      : Milliseconds a result is served
+    QueryCache::QueryCache(Base* p_Database, std::size_t p_MaxBytes, uint32 p_TTL)
+        : m_Database(p_Database), m_ShardBytes(std::max<std::size_t>(p_MaxBytes / QUERY_CACHE_SHARDS, 1)), m_TTL(p_TTL),
+        m_HitCount(0), m_MissCount(0), m_EvictionCount(0), m_ExpiredCount(0), m_Bytes(0)
+    {
+    }
+    /// Deconstructor
+    QueryCache::~QueryCache()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get result of a catalog statement, sent to the database on a miss
+    /// @p_StatementId : Id of statement in catalog
+    /// @p_Parameters  : Parameters in order
+    /// @p_Queue       : Completion queue of the caller, a miss calls back through it
+    /// @p_Callback    : Callback
+    void QueryCache::Query(uint32 p_StatementId, std::vector<SQLBindData> const& p_Parameters, CompletionQueue* p_Queue, Callback p_Callback)
+    {
+        std::string l_Key = BuildKey(p_StatementId, p_Parameters);
+        Shard& l_Shard = GetShard(l_Key);
+
+        Result l_Hit;
+
+        {
+            std::lock_guard<std::mutex> l_Guard(l_Shard.Mutex);
+
+            auto l_Itr = l_Shard.Index.find(l_Key);
+            if (l_Itr != l_Shard.Index.end())
+            {
+                if (std::chrono::steady_clock::now() < l_Itr->second->Expiry)
+                {
+                    l_Shard.Entries.splice(l_Shard.Entries.begin(), l_Shard.Entries, l_Itr->second);
+                    l_Hit = l_Itr->second->Value;
+                }
+                else
+                {
+                    Erase(l_Shard, l_Itr->second);
+                    m_ExpiredCount++;
+                }
+            }
+
+            if (!l_Hit)
+            {
+                auto l_Pending = l_Shard.InFlight.find(l_Key);
+
+                /// Same query is on its way, ride along
+                if (l_Pending != l_Shard.InFlight.end())
+                {
+                    l_Pending->second.Waiters.push_back(Waiter{ p_Queue, std::move(p_Callback) });
+                    m_HitCount++;
+                    return;
+                }
+
+                l_Shard.InFlight.emplace(l_Key, Pending{ p_StatementId, false, {} });
+            }
+        }
+
+        if (l_Hit)
+        {
+            m_HitCount++;
+            p_Callback(std::move(l_Hit));
+            return;
+        }
+
+        m_MissCount++;
+
+        PreparedStatement* l_PreparedStatement = m_Database->GetPrepareStatement(p_StatementId);
+        if (!l_PreparedStatement)
+        {
+            LOG_ERROR("Database", "QueryCache could not get a statement for statement %0", p_StatementId);
+            OnResult(l_Key, nullptr);
+            p_Callback(nullptr);
+            return;
+        }
+
+        for (std::size_t l_I = 0; l_I < p_Parameters.size(); l_I++)
+            l_PreparedStatement->SetData(static_cast<uint16>(l_I), p_Parameters[l_I]);
+
+        m_Database->PrepareOperator(l_PreparedStatement, p_Queue, [this, l_Key, l_Callback = std::move(p_Callback)](std::unique_ptr<PreparedResultSet> p_Result)
+        {
+            /// Give the statement back to the pool, the rows live in the arena of the result
+            if (p_Result)
+                p_Result->Detach();
+
+            Result l_Result(std::move(p_Result));
+
+            OnResult(l_Key, l_Result);
+            l_Callback(std::move(l_Result));
+        });
+    }
+
+    /// Drop the result of a statement for one set of parameters
+    /// @p_StatementId : Id of statement in catalog
+    /// @p_Parameters  : Parameters in order
+    void QueryCache::Invalidate(uint32 p_StatementId, std::vector<SQLBindData> const& p_Parameters)
+    {
+        const std::string l_Key = BuildKey(p_StatementId, p_Parameters);
+        Shard& l_Shard = GetShard(l_Key);
+
+        std::lock_guard<std::mutex> l_Guard(l_Shard.Mutex);
+
+        auto l_Itr = l_Shard.Index.find(l_Key);
+        if (l_Itr != l_Shard.Index.end())
+            Erase(l_Shard, l_Itr->second);
+
+        /// A result already on its way may predate the write
+        auto l_Pending = l_Shard.InFlight.find(l_Key);
+        if (l_Pending != l_Shard.InFlight.end())
+            l_Pending->second.Invalidated = true;
+    }
+    /// Drop every result of a statement
+    /// @p_StatementId : Id of statement in catalog
+    void QueryCache::InvalidateStatement(uint32 p_StatementId)
+    {
+        for (Shard& l_Shard : m_Shards)
+        {
+            std::lock_guard<std::mutex> l_Guard(l_Shard.Mutex);
+
+            for (auto l_Itr = l_Shard.Entries.begin(); l_Itr != l_Shard.Entries.end();)
+            {
+                auto l_Next = std::next(l_Itr);
+
+                if (l_Itr->StatementId == p_StatementId)
+                    Erase(l_Shard, l_Itr);
+
+                l_Itr = l_Next;
+            }
+
+            for (auto& l_Pending : l_Shard.InFlight)
+            {
+                if (l_Pending.second.StatementId == p_StatementId)
+                    l_Pending.second.Invalidated = true;
+            }
+        }
+    }
+    /// Drop every result
+    void QueryCache::Clear()
+    {
+        for (Shard& l_Shard : m_Shards)
+        {
+            std::lock_guard<std::mutex> l_Guard(l_Shard.Mutex);
+
+            while (!l_Shard.Entries.empty())
+                Erase(l_Shard, l_Shard.Entries.begin());
+
+            for (auto& l_Pending : l_Shard.InFlight)
+                l_Pending.second.Invalidated = true;
+        }
+    }
+
+    /// Get amount of queries served from cache
+    uint64 QueryCache::GetHitCount() const
+    {
+        return m_HitCount;
+    }
+    /// Get amount of queries sent to the database
+    uint64 QueryCache::GetMissCount() const
+    {
+        return m_MissCount;
+    }
+    /// Get amount of results dropped to stay in the memory budget
+    uint64 QueryCache::GetEvictionCount() const
+    {
+        return m_EvictionCount;
+    }
+    /// Get amount of results dropped because they outlived the TTL
+    uint64 QueryCache::GetExpiredCount() const
+    {
+        return m_ExpiredCount;
+    }
+    /// Get memory held by cached results
+    std::size_t QueryCache::GetMemorySize() const
+    {
+        return m_Bytes;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Build key of a query
+    /// @p_StatementId : Id of statement in catalog
+    /// @p_Parameters  : Parameters in order
+    std::string QueryCache::BuildKey(uint32 p_StatementId, std::vector<SQLBindData> const& p_Parameters)
+    {
+        std::string l_Key(reinterpret_cast<char const*>(&p_StatementId), sizeof(p_StatementId));
+
+        for (SQLBindData const& l_Parameter : p_Parameters)
+            l_Parameter.AppendKey(l_Key);
+
+        return l_Key;
+    }
+    /// Get shard of a key
+    /// @p_Key : Key
+    QueryCache::Shard& QueryCache::GetShard(std::string const& p_Key)
+    {
+        return m_Shards[std::hash<std::string>()(p_Key) % QUERY_CACHE_SHARDS];
+    }
+    /// Store result of a query and wake callers who joined it, called on the thread of the first caller
+    /// @p_Key    : Key
+    /// @p_Result : Result
+    void QueryCache::OnResult(std::string const& p_Key, Result p_Result)
+    {
+        Shard& l_Shard = GetShard(p_Key);
+        std::vector<Waiter> l_Waiters;
+
+        {
+            std::lock_guard<std::mutex> l_Guard(l_Shard.Mutex);
+
+            auto l_Pending = l_Shard.InFlight.find(p_Key);
+            if (l_Pending == l_Shard.InFlight.end())
+                return;
+
+            l_Waiters = std::move(l_Pending->second.Waiters);
+
+            /// Failed queries are retried by the next caller, invalidated ones may be stale
+            if (p_Result && !l_Pending->second.Invalidated)
+            {
+                auto l_Itr = l_Shard.Index.find(p_Key);
+                if (l_Itr != l_Shard.Index.end())
+                    Erase(l_Shard, l_Itr->second);
+
+                const std::size_t l_Size = p_Result->GetMemorySize() + p_Key.size();
+
+                l_Shard.Entries.push_front(Entry{ p_Key, l_Pending->second.StatementId, p_Result, std::chrono::steady_clock::now() + m_TTL });
+                l_Shard.Index[p_Key] = l_Shard.Entries.begin();
+                l_Shard.Bytes += l_Size;
+                m_Bytes += l_Size;
+
+                /// Least recently used results leave past the budget, a single result larger than the budget is not kept
+                while (l_Shard.Bytes > m_ShardBytes && !l_Shard.Entries.empty())
+                {
+                    Erase(l_Shard, std::prev(l_Shard.Entries.end()));
+                    m_EvictionCount++;
+                }
+            }
+
+            l_Shard.InFlight.erase(l_Pending);
+        }
+
+        for (Waiter& l_Waiter : l_Waiters)
+        {
+            Callback l_Function = std::move(l_Waiter.Function);
+            l_Waiter.Queue->Post([l_Function, p_Result]() { l_Function(p_Result); });
+        }
+    }
+    /// Remove entry, shard must be locked
+    /// @p_Shard : Shard
+    /// @p_Itr   : Entry
+    void QueryCache::Erase(Shard& p_Shard, EntryList::iterator p_Itr)
+    {
+        const std::size_t l_Size = p_Itr->Value->GetMemorySize() + p_Itr->Key.size();
+
+        p_Shard.Bytes -= l_Size;
+        m_Bytes -= l_Size;
+
+        p_Shard.Index.erase(p_Itr->Key);
+        p_Shard.Entries.erase(p_Itr);
+    }
+
+}   ///< namespace Database
+}   ///< namespace Core
+}   ///< namespace SteerStone
@@ -0,0 +1,157 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <atomic>
+#include <chrono>
+
+#include "Core/Core.hpp"
+#include "Database/BindData.hpp"
+#include "Database/CompletionQueue.hpp"
+
+#define QUERY_CACHE_SHARDS      16      ///< Shards of the cache, each has its own lock and share of the memory budget
+
+namespace SteerStone { namespace Core { namespace Database {
+
+    class Base;
+
+    /// Read through cache of catalog statement results, keyed by statement id and bound parameters
+    /// Results are detached from their statement on arrival so they hold no pool statement, and are shared
+    /// read only between every caller, read them with PreparedResultSet::Get. Concurrent misses of one key
+    /// share a single query. Write paths keep the cache honest with Invalidate / InvalidateStatement
+    class QueryCache
+    {
+        DISALLOW_COPY_AND_ASSIGN(QueryCache);
+
+        public:
+            /// Shared read only result, nullptr if the query failed
+            using Result    = std::shared_ptr<PreparedResultSet const>;
+            /// Called with the result on the completion queue of the caller, or straight away on a hit
+            using Callback  = std::function<void(Result)>;
+
+        private:
+            /// Cached result
+            struct Entry
+            {
+                std::string Key;                                        ///< Statement id and parameters
+                uint32 StatementId;                                     ///< Statement id
+                Result Value;                                           ///< Result
+                std::chrono::steady_clock::time_point Expiry;           ///< Time entry stops being served
+            };
+
+            /// Caller of a query in flight
+            struct Waiter
+            {
+                CompletionQueue* Queue;                                 ///< Queue callback is posted to
+                Callback Function;                                      ///< Callback
+            };
+
+            /// Query in flight
+            struct Pending
+            {
+                uint32 StatementId;                                     ///< Statement id
+                bool Invalidated;                                       ///< Invalidated while in flight, the result is delivered but not cached
+                std::vector<Waiter> Waiters;                            ///< Callers joining the query after it was sent
+            };
+
+            using EntryList = std::list<Entry>;
+
+            /// Part of the cache
+            struct Shard
+            {
+                std::mutex Mutex;                                                       ///< Guards shard
+                EntryList Entries;                                                      ///< Entries, most recently used first
+                std::unordered_map<std::string, EntryList::iterator> Index;             ///< Entries by key
+                std::unordered_map<std::string, Pending> InFlight;                      ///< Queries in flight by key
+                std::size_t Bytes = 0;                                                  ///< Memory held by entries
+            };
+
+        public:
+            /// Constructor
+            /// @p_Database : Database queries are sent to
+            /// @p_MaxBytes : Memory budget of cached results
+            /// @p_TTL      : Milliseconds a result is served
+            QueryCache(Base* p_Database, std::size_t p_MaxBytes, uint32 p_TTL);
+            /// Deconstructor
+            ~QueryCache();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Get result of a catalog statement, sent to the database on a miss
+            /// @p_StatementId : Id of statement in catalog
+            /// @p_Parameters  : Parameters in order
+            /// @p_Queue       : Completion queue of the caller, a miss calls back through it
+            /// @p_Callback    : Callback
+            void Query(uint32 p_StatementId, std::vector<SQLBindData> const& p_Parameters, CompletionQueue* p_Queue, Callback p_Callback);
+
+            /// Drop the result of a statement for one set of parameters
+            /// @p_StatementId : Id of statement in catalog
+            /// @p_Parameters  : Parameters in order
+            void Invalidate(uint32 p_StatementId, std::vector<SQLBindData> const& p_Parameters);
+            /// Drop every result of a statement
+            /// @p_StatementId : Id of statement in catalog
+            void InvalidateStatement(uint32 p_StatementId);
+            /// Drop every result
+            void Clear();
+
+            /// Get amount of queries served from cache
+            uint64 GetHitCount() const;
+            /// Get amount of queries sent to the database
+            uint64 GetMissCount() const;
+            /// Get amount of results dropped to stay in the memory budget
+            uint64 GetEvictionCount() const;
+            /// Get amount of results dropped because they outlived the TTL
+            uint64 GetExpiredCount() const;
+            /// Get memory held by cached results
+            std::size_t GetMemorySize() const;
+
+        private:
+            /// Build key of a query
+            /// @p_StatementId : Id of statement in catalog
+            /// @p_Parameters  : Parameters in order
+            static std::string BuildKey(uint32 p_StatementId, std::vector<SQLBindData> const& p_Parameters);
+            /// Get shard of a key
+            /// @p_Key : Key
+            Shard& GetShard(std::string const& p_Key);
+            /// Store result of a query and wake callers who joined it, called on the thread of the first caller
+            /// @p_Key    : Key
+            /// @p_Result : Result
+            void OnResult(std::string const& p_Key, Result p_Result);
+            /// Remove entry, shard must be locked
+            /// @p_Shard : Shard
+            /// @p_Itr   : Entry
+            void Erase(Shard& p_Shard, EntryList::iterator p_Itr);
+
+        private:
+            Base* m_Database;                                   ///< Database queries are sent to
+            std::size_t m_ShardBytes;                           ///< Memory budget of each shard
+            std::chrono::milliseconds m_TTL;                    ///< Time a result is served
+            Shard m_Shards[QUERY_CACHE_SHARDS];                 ///< Shards
+
+            std::atomic<uint64> m_HitCount;                     ///< Queries served from cache
+            std::atomic<uint64> m_MissCount;                    ///< Queries sent to the database
+            std::atomic<uint64> m_EvictionCount;                ///< Results dropped for the memory budget
+            std::atomic<uint64> m_ExpiredCount;                 ///< Results dropped for the TTL
+            std::atomic<std::size_t> m_Bytes;                   ///< Memory held by cached results
+    };
+
+}   ///< namespace Database
+}   ///< namespace Core
+}   ///< namespace SteerStone
@@ -0,0 +1,323 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Database/QueryProfiler.hpp"
+#include "Database/PreparedStatement.hpp"
+#include "Logger/LogDefines.hpp"
+#include "Threading/ThrTaskManager.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+namespace SteerStone { namespace Core { namespace Database {
+
+    /// Check if text ends with a suffix
+    /// @p_Text   : Text
+    /// @p_Suffix : Suffix
+    static bool EndsWith(std::string const& p_Text, std::string_view p_Suffix)
+    {
+        return p_Text.size() >= p_Suffix.size() && std::string_view(p_Text).substr(p_Text.size() - p_Suffix.size()) == p_Suffix;
+    }
+
+    /// Normalize query, literals become placeholders, whitespace and placeholder lists are folded
+    /// @p_Query : Query
+    std::string QueryProfiler::Normalize(std::string const& p_Query)
+    {
+        std::string l_Out;
+        l_Out.reserve(p_Query.size());
+
+        bool l_Space = false;
+
+        auto l_Emit = [&l_Out, &l_Space](std::string_view p_Token)
+        {
+            if (l_Space && !l_Out.empty() && l_Out.back() != '(' && p_Token[0] != ',' && p_Token[0] != ')')
+                l_Out.push_back(' ');
+
+            l_Space = false;
+
+            /// "?, ?, ?" folds into "?"
+            if (p_Token == "?" && EndsWith(l_Out, "?, "))
+            {
+                l_Out.resize(l_Out.size() - 2);
+                return;
+            }
+
+            l_Out.append(p_Token.data(), p_Token.size());
+
+            /// "(?), (?)" folds into "(?)", so multi row inserts of any size match
+            if (p_Token == ")" && EndsWith(l_Out, "(?), (?)"))
+                l_Out.resize(l_Out.size() - 5);
+            else if (p_Token == ",")
+                l_Space = true;
+        };
+
+        const std::size_t l_Length = p_Query.size();
+
+        for (std::size_t l_I = 0; l_I < l_Length;)
+        {
+            const char l_Char = p_Query[l_I];
+
+            if (std::isspace(static_cast<unsigned char>(l_Char)))
+            {
+                l_Space = true;
+                l_I++;
+            }
+            else if (l_Char == '\'' || l_Char == '"')
+            {
+                /// Skip string literal, backslash escapes and doubled quotes stay inside it
+                for (l_I++; l_I < l_Length; l_I++)
+                {
+                    if (p_Query[l_I] == '\\')
+                        l_I++;
+                    else if (p_Query[l_I] == l_Char)
+                    {
+                        if (l_I + 1 < l_Length && p_Query[l_I + 1] == l_Char)
+                            l_I++;
+                        else
+                            break;
+                    }
+                }
+
+                l_I++;
+                l_Emit("?");
+            }
+            else if (l_Char == '`')
+            {
+                /// Quoted identifier is kept as is
+                const std::size_t l_End = p_Query.find('`', l_I + 1);
+                const std::size_t l_Next = l_End == std::string::npos ? l_Length : l_End + 1;
+
+                l_Emit(std::string_view(p_Query).substr(l_I, l_Next - l_I));
+                l_I = l_Next;
+            }
+            else if (std::isdigit(static_cast<unsigned char>(l_Char))
+                && (l_Out.empty() || l_Space || !(std::isalnum(static_cast<unsigned char>(l_Out.back())) || l_Out.back() == '_')))
+            {
+                /// Number, hex and decimals included
+                while (l_I < l_Length && (std::isxdigit(static_cast<unsigned char>(p_Query[l_I])) || p_Query[l_I] == '.' || p_Query[l_I] == 'x' || p_Query[l_I] == 'X'))
+                    l_I++;
+
+                l_Emit("?");
+            }
+            else if (std::isalnum(static_cast<unsigned char>(l_Char)) || l_Char == '_')
+            {
+                const std::size_t l_Start = l_I;
+
+                while (l_I < l_Length && (std::isalnum(static_cast<unsigned char>(p_Query[l_I])) || p_Query[l_I] == '_'))
+                    l_I++;
+
+                l_Emit(std::string_view(p_Query).substr(l_Start, l_I - l_Start));
+            }
+            else
+            {
+                l_Emit(std::string_view(p_Query).substr(l_I, 1));
+                l_I++;
+            }
+        }
+
+        return l_Out;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    QueryProfiler::QueryProfiler()
+        : m_SlowThreshold(0)
+    {
+    }
+    /// Deconstructor
+    QueryProfiler::~QueryProfiler()
+    {
+        if (m_ReportTask)
+            sThreadManager->PopTask(m_ReportTask);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Set execution time above which a query is logged with its parameters
+    /// @p_Threshold : Milliseconds, 0 disables the slow query log
+    void QueryProfiler::SetSlowQueryThreshold(uint32 p_Threshold)
+    {
+        m_SlowThreshold = static_cast<uint64>(p_Threshold) * 1000000;
+    }
+    /// Log the statements taking most database time periodically
+    /// @p_Interval : Milliseconds between reports, 0 disables
+    void QueryProfiler::SetReportInterval(uint32 p_Interval)
+    {
+        if (m_ReportTask)
+        {
+            sThreadManager->PopTask(m_ReportTask);
+            m_ReportTask.reset();
+        }
+
+        if (!p_Interval)
+            return;
+
+        m_ReportTask = sThreadManager->PushTask("DATABASE_QUERY_REPORT", Threading::TaskType::Normal, p_Interval, [this]() -> bool
+        {
+            LogReport();
+            Reset();
+            return true;
+        });
+    }
+
+    /// Get profile of a query, created on first use and kept for the lifetime of the profiler
+    /// @p_Query : Query as prepared
+    /// @p_Name  : Catalog name, empty for ad hoc queries
+    QueryProfile* QueryProfiler::GetProfile(std::string const& p_Query, std::string const& p_Name)
+    {
+        std::lock_guard<std::mutex> l_Guard(m_Mutex);
+
+        auto l_Itr = m_ByQuery.find(p_Query);
+        if (l_Itr != m_ByQuery.end())
+            return l_Itr->second;
+
+        const std::string l_Normalized = Normalize(p_Query);
+
+        std::unique_ptr<QueryProfile>& l_Profile = m_Profiles[l_Normalized];
+        if (!l_Profile)
+            l_Profile = std::make_unique<QueryProfile>(p_Name.empty() ? l_Normalized : p_Name, l_Normalized);
+
+        /// Ad hoc queries with inline values would grow this map forever, only remember queries with placeholders
+        if (!p_Name.empty() || p_Query == l_Normalized)
+            m_ByQuery[p_Query] = l_Profile.get();
+
+        return l_Profile.get();
+    }
+
+    /// Record time an operator waited for a worker
+    /// @p_Profile     : Profile
+    /// @p_Nanoseconds : Time waited
+    void QueryProfiler::RecordQueueWait(QueryProfile* p_Profile, uint64 p_Nanoseconds)
+    {
+        std::lock_guard<std::mutex> l_Guard(p_Profile->Mutex);
+        p_Profile->QueueWait.Record(p_Nanoseconds);
+    }
+    /// Record execution of a statement, logs it if it was slow
+    /// @p_Statement   : Statement executed, its binds are still set
+    /// @p_Profile     : Profile
+    /// @p_ExecuteTime : Nanoseconds until the server answered
+    /// @p_FetchTime   : Nanoseconds storing and decoding the rows
+    /// @p_Rows        : Rows returned
+    /// @p_Bytes       : Bytes of result set
+    void QueryProfiler::RecordExecution(PreparedStatement const* p_Statement, QueryProfile* p_Profile, uint64 p_ExecuteTime, uint64 p_FetchTime, uint64 p_Rows, uint64 p_Bytes)
+    {
+        {
+            std::lock_guard<std::mutex> l_Guard(p_Profile->Mutex);
+
+            p_Profile->Execute.Record(p_ExecuteTime);
+            p_Profile->Fetch.Record(p_FetchTime);
+        }
+
+        p_Profile->Count.fetch_add(1, std::memory_order_relaxed);
+        p_Profile->Rows.fetch_add(p_Rows, std::memory_order_relaxed);
+        p_Profile->Bytes.fetch_add(p_Bytes, std::memory_order_relaxed);
+
+        const uint64 l_Threshold = m_SlowThreshold.load(std::memory_order_relaxed);
+        if (!l_Threshold || p_ExecuteTime + p_FetchTime < l_Threshold)
+            return;
+
+        p_Profile->SlowCount.fetch_add(1, std::memory_order_relaxed);
+
+        std::string l_Parameters;
+
+        for (std::size_t l_Index = 0; l_Index < p_Statement->m_Binds.size(); l_Index++)
+        {
+            std::string l_Value = p_Statement->m_Binds[l_Index].ToString();
+            if (l_Value.size() > QUERY_PROFILER_SLOW_PARAMETER_LENGTH)
+                l_Value = l_Value.substr(0, QUERY_PROFILER_SLOW_PARAMETER_LENGTH) + "...";
+
+            if (!l_Parameters.empty())
+                l_Parameters += ", ";
+
+            l_Parameters += std::to_string(l_Index) + "=" + l_Value;
+        }
+
+        LOG_WARNING("SlowQuery", "%0 took %1 ms (execute %2 ms, fetch %3 ms, %4 rows, %5 bytes): %6 [%7]", p_Profile->Name,
+            (p_ExecuteTime + p_FetchTime) / 1000000, p_ExecuteTime / 1000000, p_FetchTime / 1000000, p_Rows, p_Bytes, p_Statement->m_Query, l_Parameters);
+    }
+
+    /// Visit every profile
+    /// @p_Function : Function called with each profile
+    void QueryProfiler::ForEach(std::function<void(QueryProfile const&)> const& p_Function) const
+    {
+        std::lock_guard<std::mutex> l_Guard(m_Mutex);
+
+        for (auto const& l_Itr : m_Profiles)
+            p_Function(*l_Itr.second);
+    }
+    /// Log the statements taking most database time
+    /// @p_Count : Amount of statements listed
+    void QueryProfiler::LogReport(std::size_t p_Count) const
+    {
+        std::vector<std::pair<uint64, QueryProfile const*>> l_Profiles;
+
+        ForEach([&l_Profiles](QueryProfile const& p_Profile)
+        {
+            const uint64 l_Time = p_Profile.Execute.GetMean() * p_Profile.Execute.GetCount() + p_Profile.Fetch.GetMean() * p_Profile.Fetch.GetCount();
+
+            if (l_Time)
+                l_Profiles.emplace_back(l_Time, &p_Profile);
+        });
+
+        if (l_Profiles.empty())
+            return;
+
+        const std::size_t l_Count = std::min(p_Count, l_Profiles.size());
+
+        std::partial_sort(l_Profiles.begin(), l_Profiles.begin() + l_Count, l_Profiles.end(),
+            [](std::pair<uint64, QueryProfile const*> const& p_Left, std::pair<uint64, QueryProfile const*> const& p_Right) { return p_Left.first > p_Right.first; });
+
+        LOG_INFO("Database", "Top %0 of %1 statements by database time", l_Count, l_Profiles.size());
+
+        /// Profiles are never removed, pointers stay valid after ForEach let go of the lock
+        for (std::size_t l_I = 0; l_I < l_Count; l_I++)
+        {
+            QueryProfile const* l_Profile = l_Profiles[l_I].second;
+
+            LOG_INFO("Database", "%0 ms total, %1 calls, queue p99 %2 us, execute p50 %3 us p99 %4 us, fetch p99 %5 us, %6 rows, %7 bytes, %8 slow: %9",
+                l_Profiles[l_I].first / 1000000, l_Profile->Count.load(std::memory_order_relaxed), l_Profile->QueueWait.GetP99() / 1000,
+                l_Profile->Execute.GetP50() / 1000, l_Profile->Execute.GetP99() / 1000, l_Profile->Fetch.GetP99() / 1000,
+                l_Profile->Rows.load(std::memory_order_relaxed), l_Profile->Bytes.load(std::memory_order_relaxed),
+                l_Profile->SlowCount.load(std::memory_order_relaxed), l_Profile->Name);
+        }
+    }
+    /// Clear every profile, for periodic reporting
+    void QueryProfiler::Reset()
+    {
+        std::lock_guard<std::mutex> l_Guard(m_Mutex);
+
+        for (auto const& l_Itr : m_Profiles)
+        {
+            QueryProfile& l_Profile = *l_Itr.second;
+
+            l_Profile.QueueWait.Reset();
+            l_Profile.Execute.Reset();
+            l_Profile.Fetch.Reset();
+            l_Profile.Count.store(0, std::memory_order_relaxed);
+            l_Profile.Rows.store(0, std::memory_order_relaxed);
+            l_Profile.Bytes.store(0, std::memory_order_relaxed);
+            l_Profile.SlowCount.store(0, std::memory_order_relaxed);
+        }
+    }
+
+}   ///< namespace Database
+}   ///< namespace Core
+}   ///< namespace SteerStone
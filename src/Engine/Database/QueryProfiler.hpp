@@ -0,0 +1,123 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <atomic>
+#include <memory>
+
+#include "Core/Core.hpp"
+#include "Diagnostic/DiaHistogram.hpp"
+#include "Threading/ThrTask.hpp"
+
+#define QUERY_PROFILER_SLOW_PARAMETER_LENGTH    64      ///< String parameters are cut to this length in the slow query log
+#define QUERY_PROFILER_REPORT_SIZE              10      ///< Statements listed in a periodic report
+
+namespace SteerStone { namespace Core { namespace Database {
+
+    class PreparedStatement;
+
+    /// Counters of one statement, shared by every query normalizing to the same text
+    struct QueryProfile
+    {
+        /// Constructor
+        /// @p_Name  : Catalog name, or the normalized query
+        /// @p_Query : Normalized query
+        QueryProfile(std::string const& p_Name, std::string const& p_Query)
+            : Name(p_Name), Query(p_Query), Count(0), Rows(0), Bytes(0), SlowCount(0)
+        {
+        }
+
+        std::string Name;                           ///< Catalog name, or the normalized query
+        std::string Query;                          ///< Normalized query
+        std::mutex Mutex;                           ///< Histograms take one writer at a time, workers take turns
+        Diagnostic::LatencyHistogram QueueWait;     ///< Operator queued until a worker picked it up
+        Diagnostic::LatencyHistogram Execute;       ///< Statement sent until the server answered
+        Diagnostic::LatencyHistogram Fetch;         ///< Rows stored and decoded into the result set
+        std::atomic<uint64> Count;                  ///< Executions
+        std::atomic<uint64> Rows;                   ///< Rows returned
+        std::atomic<uint64> Bytes;                  ///< Bytes of result sets
+        std::atomic<uint64> SlowCount;              ///< Executions above the slow query threshold
+    };
+
+    /// Per statement execution profile of a database and the slow query log
+    /// Queries are grouped by their normalized text, literals become placeholders and lists of placeholders fold
+    /// into one, so a batch of any size and a query built with inline values land on the same profile
+    class QueryProfiler
+    {
+        DISALLOW_COPY_AND_ASSIGN(QueryProfiler);
+
+        public:
+            /// Normalize query, literals become placeholders, whitespace and placeholder lists are folded
+            /// @p_Query : Query
+            static std::string Normalize(std::string const& p_Query);
+
+        public:
+            /// Constructor
+            QueryProfiler();
+            /// Deconstructor
+            ~QueryProfiler();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Set execution time above which a query is logged with its parameters
+            /// @p_Threshold : Milliseconds, 0 disables the slow query log
+            void SetSlowQueryThreshold(uint32 p_Threshold);
+            /// Log the statements taking most database time periodically
+            /// @p_Interval : Milliseconds between reports, 0 disables
+            void SetReportInterval(uint32 p_Interval);
+
+            /// Get profile of a query, created on first use and kept for the lifetime of the profiler
+            /// @p_Query : Query as prepared
+            /// @p_Name  : Catalog name, empty for ad hoc queries
+            QueryProfile* GetProfile(std::string const& p_Query, std::string const& p_Name);
+
+            /// Record time an operator waited for a worker
+            /// @p_Profile     : Profile
+            /// @p_Nanoseconds : Time waited
+            void RecordQueueWait(QueryProfile* p_Profile, uint64 p_Nanoseconds);
+            /// Record execution of a statement, logs it if it was slow
+            /// @p_Statement   : Statement executed, its binds are still set
+            /// @p_Profile     : Profile
+            /// @p_ExecuteTime : Nanoseconds until the server answered
+            /// @p_FetchTime   : Nanoseconds storing and decoding the rows
+            /// @p_Rows        : Rows returned
+            /// @p_Bytes       : Bytes of result set
+            void RecordExecution(PreparedStatement const* p_Statement, QueryProfile* p_Profile, uint64 p_ExecuteTime, uint64 p_FetchTime, uint64 p_Rows, uint64 p_Bytes);
+
+            /// Visit every profile
+            /// @p_Function : Function called with each profile
+            void ForEach(std::function<void(QueryProfile const&)> const& p_Function) const;
+            /// Log the statements taking most database time
+            /// @p_Count : Amount of statements listed
+            void LogReport(std::size_t p_Count = QUERY_PROFILER_REPORT_SIZE) const;
+            /// Clear every profile, for periodic reporting
+            void Reset();
+
+        private:
+            mutable std::mutex m_Mutex;                                                 ///< Guards maps
+            std::unordered_map<std::string, QueryProfile*> m_ByQuery;                   ///< Profiles by query as prepared, saves normalizing again
+            std::unordered_map<std::string, std::unique_ptr<QueryProfile>> m_Profiles;  ///< Profiles by normalized query
+            std::atomic<uint64> m_SlowThreshold;                                        ///< Nanoseconds, 0 disables the slow query log
+            Threading::Task::Ptr m_ReportTask;                                          ///< Periodic report
+    };
+
+}   ///< namespace Database
+}   ///< namespace Core
+}   ///< namespace SteerStone
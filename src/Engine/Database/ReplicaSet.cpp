@@ -0,0 +1,285 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ReplicaSet.hpp"
+#include "Database.hpp"
+#include "Utility/UtiString.hpp"
+#include "Logger/LogDefines.hpp"
+
+#include <chrono>
+
+namespace SteerStone { namespace Core { namespace Database {
+
+    /// Get steady milliseconds, session writes are compared against it
+    static uint64 GetSteadyTime()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    /// Get wall clock milliseconds, heartbeats are compared across servers
+    static uint64 GetWallTime()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+    /// Get slot of a session
+    /// @p_SessionKey : Shard key of the session
+    static std::size_t GetSessionSlot(uint64 p_SessionKey)
+    {
+        return static_cast<std::size_t>(((p_SessionKey * 0x9E3779B97F4A7C15ULL) >> 32) % REPLICA_SESSION_SLOTS);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    /// @p_Primary : Database writes go to
+    ReplicaSet::ReplicaSet(Base* p_Primary)
+        : m_Primary(p_Primary), m_MaxLag(DEFAULT_REPLICA_MAX_LAG), m_HeartbeatInterval(DEFAULT_REPLICA_HEARTBEAT), m_HeartbeatId(1),
+        m_LastWrites(new std::atomic<uint64>[REPLICA_SESSION_SLOTS]), m_ReplicaReadCount(0), m_FallbackCount(0), m_SessionReadCount(0)
+    {
+        for (std::size_t l_I = 0; l_I < REPLICA_SESSION_SLOTS; l_I++)
+            m_LastWrites[l_I].store(0, std::memory_order_relaxed);
+
+        SetLimits(m_MaxLag, m_HeartbeatInterval, "replication_heartbeat", m_HeartbeatId);
+    }
+    /// Deconstructor
+    ReplicaSet::~ReplicaSet()
+    {
+        if (m_HeartbeatTask)
+            sThreadManager->PopTask(m_HeartbeatTask);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Set lag limits, must be called before Start
+    /// @p_MaxLag            : Milliseconds a replica may trail the primary and still serve reads
+    /// @p_HeartbeatInterval : Milliseconds between heartbeats
+    /// @p_HeartbeatTable    : Table heartbeats are written to
+    /// @p_HeartbeatId       : Row of the heartbeat table owned by this server
+    void ReplicaSet::SetLimits(uint32 p_MaxLag, uint32 p_HeartbeatInterval, std::string const& p_HeartbeatTable, uint32 p_HeartbeatId)
+    {
+        m_MaxLag            = p_MaxLag;
+        m_HeartbeatInterval = std::max<uint32>(p_HeartbeatInterval, 1);
+        m_HeartbeatId       = p_HeartbeatId;
+        m_HeartbeatWrite    = Utils::StringBuilder("INSERT INTO `%0` (`id`, `ts`) VALUES (?, ?) ON DUPLICATE KEY UPDATE `ts` = VALUES(`ts`)", p_HeartbeatTable);
+        m_HeartbeatRead     = Utils::StringBuilder("SELECT `ts` FROM `%0` WHERE `id` = ?", p_HeartbeatTable);
+    }
+    /// Add a replica, must be called before Start
+    /// @p_Pool : Started read only pool of the replica
+    /// @p_Host : Address, for logging
+    void ReplicaSet::Add(std::unique_ptr<Base> p_Pool, std::string const& p_Host)
+    {
+        std::unique_ptr<Replica> l_Replica = std::make_unique<Replica>();
+        l_Replica->Pool = std::move(p_Pool);
+        l_Replica->Host = p_Host;
+        l_Replica->Lag.store(0, std::memory_order_relaxed);
+        l_Replica->Healthy.store(false, std::memory_order_relaxed);
+
+        m_Replicas.push_back(std::move(l_Replica));
+    }
+    /// Measure lag of the replicas and start the heartbeat
+    void ReplicaSet::Start()
+    {
+        if (m_Replicas.empty())
+            return;
+
+        /// Replicas serve no read until a heartbeat has measured them
+        Heartbeat();
+
+        m_HeartbeatTask = sThreadManager->PushTask("DATABASE_REPLICA_HEARTBEAT", Threading::TaskType::Normal, m_HeartbeatInterval, [this]() -> bool
+        {
+            Heartbeat();
+            return true;
+        });
+
+        LOG_INFO("Database", "Routing read only statements to %0 replicas, max lag %1 ms", m_Replicas.size(), m_MaxLag);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get a statement of a read only catalog entry from the least busy replica within lag
+    /// @p_StatementId : Id of statement in catalog
+    /// @p_Session     : Check the read against last write of p_SessionKey
+    /// @p_SessionKey  : Shard key of the session reading
+    /// Returns nullptr if the read must go to the primary
+    PreparedStatement* ReplicaSet::GetReadStatement(uint32 p_StatementId, bool p_Session, uint64 p_SessionKey)
+    {
+        if (m_Replicas.empty())
+            return nullptr;
+
+        /// Milliseconds since the session last wrote, replicas must trail less than that to have the write
+        const uint64 l_LastWrite    = p_Session ? m_LastWrites[GetSessionSlot(p_SessionKey)].load(std::memory_order_acquire) : 0;
+        const uint64 l_SinceWrite   = l_LastWrite ? GetSteadyTime() - l_LastWrite : UINT64_MAX;
+
+        Replica* l_Selected = nullptr;
+        bool l_Available = false;
+
+        for (auto const& l_Replica : m_Replicas)
+        {
+            if (!IsAvailable(*l_Replica))
+                continue;
+
+            l_Available = true;
+
+            /// Lag is only as fresh as the last heartbeat, allow a whole interval of slack
+            if (l_SinceWrite <= static_cast<uint64>(l_Replica->Lag.load(std::memory_order_relaxed)) + m_HeartbeatInterval)
+                continue;
+
+            if (!l_Selected || l_Replica->Pool->GetPoolInUse() < l_Selected->Pool->GetPoolInUse())
+                l_Selected = l_Replica.get();
+        }
+
+        if (!l_Selected)
+        {
+            if (l_Available)
+                m_SessionReadCount.fetch_add(1, std::memory_order_relaxed);
+            else
+                m_FallbackCount.fetch_add(1, std::memory_order_relaxed);
+
+            return nullptr;
+        }
+
+        /// Exhausted replica falls back to the primary instead of failing the read
+        PreparedStatement* l_PreparedStatement = l_Selected->Pool->GetPrepareStatement(p_StatementId);
+        if (!l_PreparedStatement)
+        {
+            m_FallbackCount.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        m_ReplicaReadCount.fetch_add(1, std::memory_order_relaxed);
+        return l_PreparedStatement;
+    }
+    /// Record a write of a session, its reads go to the primary until replicas have caught up
+    /// @p_SessionKey : Shard key of the session writing
+    void ReplicaSet::OnWrite(uint64 p_SessionKey)
+    {
+        if (!m_Replicas.empty())
+            m_LastWrites[GetSessionSlot(p_SessionKey)].store(GetSteadyTime(), std::memory_order_release);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get amount of replicas started
+    uint32 ReplicaSet::GetReplicaCount() const
+    {
+        return static_cast<uint32>(m_Replicas.size());
+    }
+    /// Get amount of replicas currently serving reads
+    uint32 ReplicaSet::GetAvailableCount() const
+    {
+        uint32 l_Count = 0;
+
+        for (auto const& l_Replica : m_Replicas)
+            if (IsAvailable(*l_Replica))
+                l_Count++;
+
+        return l_Count;
+    }
+    /// Get highest lag of the replicas, in milliseconds
+    uint32 ReplicaSet::GetMaxLag() const
+    {
+        uint32 l_Lag = 0;
+
+        for (auto const& l_Replica : m_Replicas)
+            l_Lag = std::max<uint32>(l_Lag, l_Replica->Lag.load(std::memory_order_relaxed));
+
+        return l_Lag;
+    }
+    /// Get amount of reads served by replicas
+    uint64 ReplicaSet::GetReplicaReadCount() const
+    {
+        return m_ReplicaReadCount.load(std::memory_order_relaxed);
+    }
+    /// Get amount of read only statements sent to the primary because no replica was caught up
+    uint64 ReplicaSet::GetFallbackCount() const
+    {
+        return m_FallbackCount.load(std::memory_order_relaxed);
+    }
+    /// Get amount of read only statements sent to the primary to read a recent write of their session
+    uint64 ReplicaSet::GetSessionReadCount() const
+    {
+        return m_SessionReadCount.load(std::memory_order_relaxed);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Measure lag of every replica, runs on a task worker
+    void ReplicaSet::Heartbeat()
+    {
+        /// A failed write leaves the row behind, replicas then show growing lag and stop serving reads
+        PreparedStatement* l_Write = m_Primary->GetPrepareStatement();
+        if (l_Write)
+        {
+            l_Write->PrepareStatement(m_HeartbeatWrite.c_str());
+            l_Write->SetUint32(0, m_HeartbeatId);
+            l_Write->SetUint64(1, GetWallTime());
+
+            if (!l_Write->ExecuteStatement(true))
+            {
+                LOG_WARNING("Database", "Failed to write replication heartbeat");
+                m_Primary->FreePrepareStatement(l_Write);
+            }
+        }
+
+        for (auto const& l_Replica : m_Replicas)
+        {
+            bool l_Healthy = false;
+
+            PreparedStatement* l_Read = l_Replica->Pool->GetPrepareStatement();
+            if (l_Read)
+            {
+                l_Read->PrepareStatement(m_HeartbeatRead.c_str());
+                l_Read->SetUint32(0, m_HeartbeatId);
+
+                std::unique_ptr<PreparedResultSet> l_PreparedResultSet = l_Read->ExecuteStatement(true);
+                if (!l_PreparedResultSet)
+                    l_Replica->Pool->FreePrepareStatement(l_Read);
+                else if (l_PreparedResultSet->GetRowCount() && l_PreparedResultSet->GetFieldCount())
+                {
+                    const uint64 l_Timestamp = (*l_PreparedResultSet)[0].GetUInt64();
+                    const uint64 l_Now       = GetWallTime();
+
+                    /// Clock of the primary host may run ahead of ours
+                    l_Replica->Lag.store(static_cast<uint32>(std::min<uint64>(l_Now > l_Timestamp ? l_Now - l_Timestamp : 0, UINT32_MAX)), std::memory_order_relaxed);
+                    l_Healthy = true;
+                }
+            }
+
+            if (l_Replica->Healthy.exchange(l_Healthy, std::memory_order_relaxed) != l_Healthy)
+            {
+                if (l_Healthy)
+                    LOG_INFO("Database", "Replica %0 is serving reads, lag %1 ms", l_Replica->Host, l_Replica->Lag.load(std::memory_order_relaxed));
+                else
+                    LOG_WARNING("Database", "Replica %0 failed its heartbeat, reads fall back to primary", l_Replica->Host);
+            }
+        }
+    }
+    /// Check a replica may serve reads
+    /// @p_Replica : Replica
+    bool ReplicaSet::IsAvailable(Replica const& p_Replica) const
+    {
+        return p_Replica.Healthy.load(std::memory_order_relaxed) && p_Replica.Lag.load(std::memory_order_relaxed) <= m_MaxLag;
+    }
+
+}   ///< namespace Database
+}   ///< namespace Core
+}   ///< namespace SteerStone
@@ -0,0 +1,129 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <atomic>
+#include <memory>
+
+#include "Core/Core.hpp"
+#include "Threading/ThrTaskManager.hpp"
+
+namespace SteerStone { namespace Core { namespace Database {
+
+    class Base;
+    class PreparedStatement;
+
+    /// Read only pools of replicas, read only catalog statements are served here while the replica is caught up
+    ///
+    /// Lag is measured by a heartbeat: the primary upserts the current time into the heartbeat table, every replica
+    /// reads the row back and trails the primary by the difference. A replica is skipped once its lag goes above the
+    /// maximum or its heartbeat fails, reads fall back to the primary until it catches up again.
+    /// Reads of a session which wrote within the lag window go to the primary so the session sees its own writes,
+    /// the session is the shard key writes are ordered by.
+    ///
+    /// Heartbeat table: CREATE TABLE `replication_heartbeat` (`id` INT UNSIGNED PRIMARY KEY, `ts` BIGINT UNSIGNED NOT NULL)
+    class ReplicaSet
+    {
+        DISALLOW_COPY_AND_ASSIGN(ReplicaSet);
+
+        private:
+            /// Replica of the primary
+            struct Replica
+            {
+                std::unique_ptr<Base> Pool;         ///< Read only pool, its statements execute on workers of the primary
+                std::string Host;                   ///< Address, for logging
+                std::atomic<uint32> Lag;            ///< Milliseconds behind the primary, as of last heartbeat
+                std::atomic<bool> Healthy;          ///< Last heartbeat succeeded
+            };
+
+        public:
+            /// Constructor
+            /// @p_Primary : Database writes go to
+            ReplicaSet(Base* p_Primary);
+            /// Deconstructor
+            ~ReplicaSet();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Set lag limits, must be called before Start
+            /// @p_MaxLag            : Milliseconds a replica may trail the primary and still serve reads
+            /// @p_HeartbeatInterval : Milliseconds between heartbeats
+            /// @p_HeartbeatTable    : Table heartbeats are written to
+            /// @p_HeartbeatId       : Row of the heartbeat table owned by this server
+            void SetLimits(uint32 p_MaxLag, uint32 p_HeartbeatInterval, std::string const& p_HeartbeatTable, uint32 p_HeartbeatId);
+            /// Add a replica, must be called before Start
+            /// @p_Pool : Started read only pool of the replica
+            /// @p_Host : Address, for logging
+            void Add(std::unique_ptr<Base> p_Pool, std::string const& p_Host);
+            /// Measure lag of the replicas and start the heartbeat
+            void Start();
+
+            /// Get a statement of a read only catalog entry from the least busy replica within lag
+            /// @p_StatementId : Id of statement in catalog
+            /// @p_Session     : Check the read against last write of p_SessionKey
+            /// @p_SessionKey  : Shard key of the session reading
+            /// Returns nullptr if the read must go to the primary
+            PreparedStatement* GetReadStatement(uint32 p_StatementId, bool p_Session, uint64 p_SessionKey);
+            /// Record a write of a session, its reads go to the primary until replicas have caught up
+            /// @p_SessionKey : Shard key of the session writing
+            void OnWrite(uint64 p_SessionKey);
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Get amount of replicas started
+            uint32 GetReplicaCount() const;
+            /// Get amount of replicas currently serving reads
+            uint32 GetAvailableCount() const;
+            /// Get highest lag of the replicas, in milliseconds
+            uint32 GetMaxLag() const;
+            /// Get amount of reads served by replicas
+            uint64 GetReplicaReadCount() const;
+            /// Get amount of read only statements sent to the primary because no replica was caught up
+            uint64 GetFallbackCount() const;
+            /// Get amount of read only statements sent to the primary to read a recent write of their session
+            uint64 GetSessionReadCount() const;
+
+        private:
+            /// Measure lag of every replica, runs on a task worker
+            void Heartbeat();
+            /// Check a replica may serve reads
+            /// @p_Replica : Replica
+            bool IsAvailable(Replica const& p_Replica) const;
+
+        private:
+            Base* m_Primary;                                                ///< Database writes go to
+            std::vector<std::unique_ptr<Replica>> m_Replicas;               ///< Replicas, fixed once Start returns
+            uint32 m_MaxLag;                                                ///< Milliseconds a replica may trail the primary
+            uint32 m_HeartbeatInterval;                                     ///< Milliseconds between heartbeats
+            std::string m_HeartbeatWrite;                                   ///< Query upserting the heartbeat on the primary
+            std::string m_HeartbeatRead;                                    ///< Query reading the heartbeat on a replica
+            uint32 m_HeartbeatId;                                           ///< Row of the heartbeat table
+            Threading::Task::Ptr m_HeartbeatTask;                           ///< Task running Heartbeat
+
+            std::unique_ptr<std::atomic<uint64>[]> m_LastWrites;            ///< Steady milliseconds of last write of each session slot
+            std::atomic<uint64> m_ReplicaReadCount;                         ///< Reads served by replicas
+            std::atomic<uint64> m_FallbackCount;                            ///< Reads sent to primary, no replica caught up
+            std::atomic<uint64> m_SessionReadCount;                         ///< Reads sent to primary, session wrote recently
+    };
+
+}   ///< namespace Database
+}   ///< namespace Core
+}   ///< namespace SteerStone
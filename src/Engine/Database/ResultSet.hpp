@@ -27,6 +27,7 @@ namespace SteerStone { namespace Core { namespace Database {
     /// MySQLTypeToFieldType
     /// Convert MySQL type to Field Type
     /// @p_Type : MySQL Type we are converting
+    /// @p_UnSigned : Column has UNSIGNED_FLAG
     static FieldType MySQLTypeToFieldType(enum_field_types p_Type, bool p_UnSigned)
     {
         switch (p_Type)
@@ -44,17 +45,17 @@ namespace SteerStone { namespace Core { namespace Database {
         case enum_field_types::MYSQL_TYPE_SHORT:
         {
             if (p_UnSigned)
-                return FieldType::FIELD_I16;
-            else
                 return FieldType::FIELD_UI16;
+            else
+                return FieldType::FIELD_I16;
         }
         case enum_field_types::MYSQL_TYPE_INT24:
         case enum_field_types::MYSQL_TYPE_LONG:
         {
             if (p_UnSigned)
-                return FieldType::FIELD_I32;
-            else
                 return FieldType::FIELD_UI32;
+            else
+                return FieldType::FIELD_I32;
         }
         case enum_field_types::MYSQL_TYPE_LONGLONG:
         case enum_field_types::MYSQL_TYPE_BIT:
@@ -0,0 +1,303 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+#include "Database/MYSQLPreparedStatement.hpp"
+#include "Database/SQLCommon.hpp"
+#include "Logger/Base.hpp"
+#include "Logger/LogDefines.hpp"
+#include "Utility/UtiObjectGuard.hpp"
+
+#include <tuple>
+#include <utility>
+
+#define ROW_MAPPER_STRING_SIZE      256     ///< Initial buffer of string members, grown when a value does not fit
+
+/// Describe members of a row struct in column order, used by Base::Query
+/// struct ItemRow { uint32 Id; std::string Name; DATABASE_ROW_FIELDS(&ItemRow::Id, &ItemRow::Name) };
+#define DATABASE_ROW_FIELDS(...) static constexpr auto Fields() { return std::make_tuple(__VA_ARGS__); }
+
+namespace SteerStone { namespace Core { namespace Database {
+
+    /// Buffer type MySQL converts a column into for a member type, the client library does the conversion on fetch
+    template<typename T> struct RowFieldTraits;
+
+    template<> struct RowFieldTraits<bool>          { static constexpr enum_field_types Type = MYSQL_TYPE_TINY;      static constexpr bool Unsigned = true;  static constexpr bool Numeric = true;  };
+    template<> struct RowFieldTraits<uint8>         { static constexpr enum_field_types Type = MYSQL_TYPE_TINY;      static constexpr bool Unsigned = true;  static constexpr bool Numeric = true;  };
+    template<> struct RowFieldTraits<int8>          { static constexpr enum_field_types Type = MYSQL_TYPE_TINY;      static constexpr bool Unsigned = false; static constexpr bool Numeric = true;  };
+    template<> struct RowFieldTraits<uint16>        { static constexpr enum_field_types Type = MYSQL_TYPE_SHORT;     static constexpr bool Unsigned = true;  static constexpr bool Numeric = true;  };
+    template<> struct RowFieldTraits<int16>         { static constexpr enum_field_types Type = MYSQL_TYPE_SHORT;     static constexpr bool Unsigned = false; static constexpr bool Numeric = true;  };
+    template<> struct RowFieldTraits<uint32>        { static constexpr enum_field_types Type = MYSQL_TYPE_LONG;      static constexpr bool Unsigned = true;  static constexpr bool Numeric = true;  };
+    template<> struct RowFieldTraits<int32>         { static constexpr enum_field_types Type = MYSQL_TYPE_LONG;      static constexpr bool Unsigned = false; static constexpr bool Numeric = true;  };
+    template<> struct RowFieldTraits<uint64>        { static constexpr enum_field_types Type = MYSQL_TYPE_LONGLONG;  static constexpr bool Unsigned = true;  static constexpr bool Numeric = true;  };
+    template<> struct RowFieldTraits<int64>         { static constexpr enum_field_types Type = MYSQL_TYPE_LONGLONG;  static constexpr bool Unsigned = false; static constexpr bool Numeric = true;  };
+    template<> struct RowFieldTraits<float>         { static constexpr enum_field_types Type = MYSQL_TYPE_FLOAT;     static constexpr bool Unsigned = false; static constexpr bool Numeric = true;  };
+    template<> struct RowFieldTraits<double>        { static constexpr enum_field_types Type = MYSQL_TYPE_DOUBLE;    static constexpr bool Unsigned = false; static constexpr bool Numeric = true;  };
+    template<> struct RowFieldTraits<std::string>   { static constexpr enum_field_types Type = MYSQL_TYPE_STRING;    static constexpr bool Unsigned = false; static constexpr bool Numeric = false; };
+
+    /// Decodes rows of a statement straight into a struct described by DATABASE_ROW_FIELDS
+    /// Column types are checked once against the members, numeric members are fetched by MySQL directly into the
+    /// row and converted by the client library, strings are copied from a scratch buffer. Nothing in the row
+    /// loop dispatches on a runtime type or logs
+    template<typename Row> class RowMapper
+    {
+        DISALLOW_COPY_AND_ASSIGN(RowMapper);
+
+        using FieldList = decltype(Row::Fields());
+
+        /// Member type of a field
+        template<std::size_t Index> using MemberType = std::remove_reference_t<decltype(std::declval<Row&>().*std::get<Index>(std::declval<FieldList>()))>;
+
+        static constexpr std::size_t FieldCount = std::tuple_size<FieldList>::value;
+
+        public:
+            /// Execute statement on calling thread and decode every row, the statement is freed
+            /// @p_Statement : Prepared statement
+            /// @p_Rows      : Decoded rows are appended here
+            /// Returns false if the statement failed or its columns do not match the row
+            static bool Execute(PreparedStatement* p_Statement, std::vector<Row>& p_Rows)
+            {
+                bool l_Result = false;
+
+                {
+                    RowMapper l_Mapper(p_Statement);
+                    l_Result = l_Mapper.Run(p_Rows);
+                }
+
+                p_Statement->Clear();
+
+                return l_Result;
+            }
+
+        private:
+            /// Constructor, connection is held until the result is drained
+            /// @p_Statement : Prepared statement
+            explicit RowMapper(PreparedStatement* p_Statement)
+                : m_Guard(p_Statement->GetConnection()), m_Statement(p_Statement), m_Stmt(p_Statement->GetStatement()), m_Bind{}, m_Length{}, m_IsNull{}, m_Error{}
+            {
+            }
+            /// Deconstructor
+            ~RowMapper()
+            {
+                if (m_Stmt)
+                    mysql_stmt_free_result(m_Stmt);
+            }
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Execute, validate and decode
+            /// @p_Rows : Decoded rows are appended here
+            bool Run(std::vector<Row>& p_Rows)
+            {
+                if (!m_Statement->PrepareExecution())
+                    return false;
+
+                if (mysql_stmt_execute(m_Stmt))
+                {
+                    LOG_ERROR("Database", "Failed to execute statement. Error: %0", mysql_stmt_error(m_Stmt));
+                    return false;
+                }
+
+                if (!Validate(std::make_index_sequence<FieldCount>()))
+                    return false;
+
+                Row l_Row{};
+                Bind(l_Row, std::make_index_sequence<FieldCount>());
+
+                if (mysql_stmt_bind_result(m_Stmt, m_Bind))
+                {
+                    LOG_ERROR("Database", "mysql_stmt_bind_result: Cannot bind result from MySQL server. Error: %0", mysql_stmt_error(m_Stmt));
+                    return false;
+                }
+
+                int32 l_Code = 0;
+                while ((l_Code = mysql_stmt_fetch(m_Stmt)) == 0 || l_Code == MYSQL_DATA_TRUNCATED)
+                {
+                    if (l_Code == MYSQL_DATA_TRUNCATED && !FetchTruncated(l_Row, std::make_index_sequence<FieldCount>()))
+                        return false;
+
+                    Decode(l_Row, std::make_index_sequence<FieldCount>());
+                    p_Rows.push_back(l_Row);
+                }
+
+                if (l_Code != MYSQL_NO_DATA)
+                {
+                    LOG_ERROR("Database", "Failed to fetch row. Error: %0", mysql_stmt_error(m_Stmt));
+                    return false;
+                }
+
+                return true;
+            }
+
+            /// Check columns of result against members, once per result
+            template<std::size_t... Indices> bool Validate(std::index_sequence<Indices...>)
+            {
+                MYSQL_RES* l_Result = mysql_stmt_result_metadata(m_Stmt);
+
+                if (!l_Result)
+                {
+                    LOG_ERROR("Database", "Statement returned no result set to map");
+                    return false;
+                }
+
+                const uint32 l_FieldCount = mysql_stmt_field_count(m_Stmt);
+                MYSQL_FIELD* l_Fields = mysql_fetch_fields(l_Result);
+                bool l_Valid = l_FieldCount == FieldCount;
+
+                if (!l_Valid)
+                    LOG_ERROR("Database", "Result has %0 columns but row maps %1", l_FieldCount, FieldCount);
+                else
+                    l_Valid = (ValidateField<Indices>(l_Fields[Indices]) && ...);
+
+                mysql_free_result(l_Result);
+
+                return l_Valid;
+            }
+            /// Check a column can be converted into its member
+            /// @p_Field : Column
+            template<std::size_t Index> bool ValidateField(MYSQL_FIELD const& p_Field)
+            {
+                /// Everything converts to a string, only numbers convert to numbers
+                if (!RowFieldTraits<MemberType<Index>>::Numeric)
+                    return true;
+
+                switch (p_Field.type)
+                {
+                case MYSQL_TYPE_TINY:
+                case MYSQL_TYPE_SHORT:
+                case MYSQL_TYPE_INT24:
+                case MYSQL_TYPE_LONG:
+                case MYSQL_TYPE_LONGLONG:
+                case MYSQL_TYPE_YEAR:
+                case MYSQL_TYPE_BIT:
+                case MYSQL_TYPE_FLOAT:
+                case MYSQL_TYPE_DOUBLE:
+                case MYSQL_TYPE_DECIMAL:
+                case MYSQL_TYPE_NEWDECIMAL:
+                    return true;
+                default:
+                    LOG_ERROR("Database", "Column %0 of type %1 can not be mapped to a numeric member", Index, uint32(p_Field.type));
+                    return false;
+                }
+            }
+
+            /// Point binds at members of the row, or at scratch buffers for strings
+            /// @p_Row : Row values are fetched into
+            template<std::size_t... Indices> void Bind(Row& p_Row, std::index_sequence<Indices...>)
+            {
+                (BindField<Indices>(p_Row), ...);
+            }
+            /// Point bind of a field at its member
+            /// @p_Row : Row values are fetched into
+            template<std::size_t Index> void BindField(Row& p_Row)
+            {
+                using Traits = RowFieldTraits<MemberType<Index>>;
+
+                MYSQL_BIND& l_Bind = m_Bind[Index];
+                l_Bind.buffer_type = Traits::Type;
+                l_Bind.is_unsigned = Traits::Unsigned;
+                l_Bind.length = &m_Length[Index];
+                l_Bind.is_null = &m_IsNull[Index];
+                l_Bind.error = &m_Error[Index];
+
+                if constexpr (Traits::Numeric)
+                {
+                    l_Bind.buffer = &(p_Row.*std::get<Index>(Row::Fields()));
+                    l_Bind.buffer_length = sizeof(MemberType<Index>);
+                }
+                else
+                {
+                    m_Scratch[Index].resize(ROW_MAPPER_STRING_SIZE);
+                    l_Bind.buffer = m_Scratch[Index].data();
+                    l_Bind.buffer_length = static_cast<unsigned long>(m_Scratch[Index].size());
+                }
+            }
+
+            /// Grow scratch buffers of strings which did not fit and fetch them again
+            /// @p_Row : Row values are fetched into
+            template<std::size_t... Indices> bool FetchTruncated(Row& p_Row, std::index_sequence<Indices...>)
+            {
+                bool l_Grown = false;
+
+                if (!(FetchTruncatedField<Indices>(l_Grown) && ...))
+                    return false;
+
+                /// Rows after this one are fetched straight into the grown buffers
+                return !l_Grown || !mysql_stmt_bind_result(m_Stmt, m_Bind);
+            }
+            /// Fetch a string field again if it did not fit, numbers out of range are kept as converted by MySQL
+            /// @p_Grown : Set if the buffer was grown
+            template<std::size_t Index> bool FetchTruncatedField(bool& p_Grown)
+            {
+                if constexpr (!RowFieldTraits<MemberType<Index>>::Numeric)
+                {
+                    if (!m_Error[Index] || m_Length[Index] <= m_Bind[Index].buffer_length)
+                        return true;
+
+                    m_Scratch[Index].resize(m_Length[Index]);
+                    m_Bind[Index].buffer = m_Scratch[Index].data();
+                    m_Bind[Index].buffer_length = static_cast<unsigned long>(m_Scratch[Index].size());
+
+                    if (mysql_stmt_fetch_column(m_Stmt, &m_Bind[Index], static_cast<uint32>(Index), 0))
+                    {
+                        LOG_ERROR("Database", "Failed to fetch column %0. Error: %1", Index, mysql_stmt_error(m_Stmt));
+                        return false;
+                    }
+
+                    p_Grown = true;
+                }
+
+                return true;
+            }
+
+            /// Finish decoding a fetched row, copies strings and resets null members
+            /// @p_Row : Row values were fetched into
+            template<std::size_t... Indices> void Decode(Row& p_Row, std::index_sequence<Indices...>)
+            {
+                (DecodeField<Indices>(p_Row), ...);
+            }
+            /// Finish decoding a field
+            /// @p_Row : Row values were fetched into
+            template<std::size_t Index> void DecodeField(Row& p_Row)
+            {
+                MemberType<Index>& l_Member = p_Row.*std::get<Index>(Row::Fields());
+
+                if (m_IsNull[Index])
+                    l_Member = MemberType<Index>();
+                else if constexpr (!RowFieldTraits<MemberType<Index>>::Numeric)
+                    l_Member.assign(m_Scratch[Index].data(), m_Length[Index]);
+            }
+
+        private:
+            Utils::ObjectGuard<MYSQLPreparedStatement> m_Guard;     ///< Connection is busy until the result is drained
+            PreparedStatement* m_Statement;                         ///< Prepared statement
+            MYSQL_STMT* m_Stmt;                                     ///< Handle of statement
+            MYSQL_BIND m_Bind[FieldCount];                          ///< Bind of each field
+            unsigned long m_Length[FieldCount];                     ///< Length of each value
+            my_bool m_IsNull[FieldCount];                           ///< Null flag of each value
+            my_bool m_Error[FieldCount];                            ///< Truncation flag of each value
+            std::vector<char> m_Scratch[FieldCount];                ///< Scratch buffers of string fields
+    };
+
+}   ///< namespace Database
+}   ///< namespace Core
+}   ///< namespace SteerStone
@@ -18,6 +18,7 @@
 
 #pragma once
 #include <PCH/Precompiled.hpp>
+#include <mysql.h>
 
 #include "Logger/Base.hpp"
 
@@ -61,7 +62,31 @@ static uint32 SizeForType(MYSQL_FIELD* p_Field)
     }
 }
 
+#define RESULT_ARENA_ALIGNMENT 16    ///< Alignment of each block of a result arena, enough for any column value
+
+/// Round size of an arena block up so the block following it is aligned for any type
+static inline std::size_t ArenaAlign(std::size_t p_Size)
+{
+    return (p_Size + RESULT_ARENA_ALIGNMENT - 1) & ~std::size_t(RESULT_ARENA_ALIGNMENT - 1);
+}
+
 #define MIN_CONNECTION_POOL_SIZE 1
-#define MAX_CONNECTION_POOL_SIZE 5
-#define MAX_PREPARED_STATEMENTS 10
-#define MAX_QUERY_LENGTH  (32*1024)
\ No newline at end of file
+#define MAX_CONNECTION_POOL_SIZE 64
+#define MIN_PREPARED_STATEMENTS 1
+#define MAX_PREPARED_STATEMENTS 256
+#define DEFAULT_PREPARED_STATEMENTS 10      ///< Prepared statements per connection
+#define DEFAULT_POOL_WAIT_TIMEOUT 5000      ///< Milliseconds a caller waits for an idle statement, 0 waits forever
+#define DEFAULT_CONNECT_TIMEOUT 5000        ///< Milliseconds a connection attempt may take
+#define DEFAULT_CONNECT_RETRIES 3           ///< Attempts of each connection at start before it is left to the background
+#define DEFAULT_RECONNECT_INTERVAL 5000     ///< Milliseconds between background attempts of connections which failed at start
+#define DEFAULT_REPLICA_MAX_LAG 1000        ///< Milliseconds a replica may trail the primary and still serve reads
+#define DEFAULT_REPLICA_HEARTBEAT 1000      ///< Milliseconds between heartbeats measuring replica lag
+#define REPLICA_SESSION_SLOTS 4096          ///< Slots last writes of sessions are hashed into for read your writes
+#define STATEMENT_CACHE_SIZE 32            ///< Idle prepared handles kept per connection for reuse
+#define MAX_QUERY_LENGTH  (32*1024)
+
+/// MariaDB Connector/C ships the non blocking API (mysql_*_start / mysql_*_cont),
+/// the event loop waits on the connection socket through a posix descriptor
+#if defined(MYSQL_WAIT_READ) && defined(linux)
+    #define DATABASE_NONBLOCKING
+#endif
\ No newline at end of file
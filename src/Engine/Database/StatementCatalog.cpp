@@ -0,0 +1,151 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "StatementCatalog.hpp"
+#include "Logger/Base.hpp"
+#include "Logger/LogDefines.hpp"
+
+namespace SteerStone { namespace Core { namespace Database {
+
+    /// Constructor
+    StatementCatalog::StatementCatalog()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Register statement, checks the declared parameters against the placeholders of the query
+    /// @p_Id         : Id of statement
+    /// @p_Name       : Name of statement
+    /// @p_Query      : Query
+    /// @p_Parameters : Type of each placeholder
+    /// @p_ReadOnly   : Statement only reads, may be routed to a replica
+    /// Returns false if id is already taken or parameters do not match the query
+    bool StatementCatalog::Register(uint32 p_Id, char const* p_Name, char const* p_Query, std::initializer_list<FieldType> p_Parameters, bool p_ReadOnly)
+    {
+        if (p_Id < m_Statements.size() && m_Statements[p_Id])
+        {
+            LOG_ASSERT(false, "Database", "Statement %0 is registered twice (%1 and %2)", p_Id, m_Statements[p_Id]->Name, p_Name);
+            return false;
+        }
+
+        const uint32 l_Placeholders = CountPlaceholders(p_Query);
+
+        if (l_Placeholders != p_Parameters.size())
+        {
+            LOG_ASSERT(false, "Database", "Statement %0 declares %1 parameters but its query has %2 placeholders", p_Name, static_cast<uint32>(p_Parameters.size()), l_Placeholders);
+            return false;
+        }
+
+        for (FieldType l_Type : p_Parameters)
+        {
+            /// Types SQLBindData can not be set with
+            if (l_Type == FieldType::FIELD_NONE || l_Type == FieldType::FIELD_DECIMAL || l_Type == FieldType::FIELD_DATE)
+            {
+                LOG_ASSERT(false, "Database", "Statement %0 declares a parameter type which can not be bound", p_Name);
+                return false;
+            }
+        }
+
+        if (p_Id >= m_Statements.size())
+            m_Statements.resize(p_Id + 1);
+
+        m_Statements[p_Id].reset(new CatalogStatement{ p_Id, p_Name, p_Query, p_Parameters, p_ReadOnly });
+
+        return true;
+    }
+
+    /// Get statement
+    /// @p_Id : Id of statement
+    /// Returns nullptr if id has not been registered
+    CatalogStatement const* StatementCatalog::Get(uint32 p_Id) const
+    {
+        return p_Id < m_Statements.size() ? m_Statements[p_Id].get() : nullptr;
+    }
+    /// Get highest registered id + 1
+    uint32 StatementCatalog::GetSize() const
+    {
+        return static_cast<uint32>(m_Statements.size());
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Count placeholders of a query, ignores quoted text and comments
+    /// @p_Query : Query
+    uint32 StatementCatalog::CountPlaceholders(char const* p_Query)
+    {
+        uint32 l_Count = 0;
+        char l_Quote = 0;
+
+        for (char const* l_Itr = p_Query; *l_Itr; l_Itr++)
+        {
+            if (l_Quote)
+            {
+                if (*l_Itr == '\\' && l_Itr[1])
+                    l_Itr++;
+                else if (*l_Itr == l_Quote)
+                    l_Quote = 0;
+
+                continue;
+            }
+
+            switch (*l_Itr)
+            {
+                case '\'':
+                case '"':
+                case '`':
+                    l_Quote = *l_Itr;
+                    break;
+                case '-':
+                case '#':
+                    /// Line comment, "--" must be followed by a blank
+                    if (*l_Itr == '#' || (l_Itr[1] == '-' && (l_Itr[2] == ' ' || l_Itr[2] == '\t')))
+                    {
+                        while (l_Itr[1] && l_Itr[1] != '\n')
+                            l_Itr++;
+                    }
+                    break;
+                case '/':
+                    if (l_Itr[1] == '*')
+                    {
+                        for (l_Itr += 2; *l_Itr && !(l_Itr[0] == '*' && l_Itr[1] == '/'); l_Itr++)
+                        {
+                        }
+
+                        if (!*l_Itr)
+                            return l_Count;
+
+                        l_Itr++;
+                    }
+                    break;
+                case '?':
+                    l_Count++;
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        return l_Count;
+    }
+
+}   ///< namespace Database
+}   ///< namespace Core
+}   ///< namespace SteerStone
@@ -0,0 +1,85 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+#include "Database/BindData.hpp"
+
+#include <memory>
+
+/// Register a statement under its enum name
+#define REGISTER_STATEMENT(p_Catalog, p_Id, p_Query, ...) (p_Catalog).Register(p_Id, #p_Id, p_Query, { __VA_ARGS__ })
+/// Register a statement which only reads, it may be served by a replica
+#define REGISTER_READ_STATEMENT(p_Catalog, p_Id, p_Query, ...) (p_Catalog).Register(p_Id, #p_Id, p_Query, { __VA_ARGS__ }, true)
+
+namespace SteerStone { namespace Core { namespace Database {
+
+    /// Statement registered in a catalog
+    struct CatalogStatement
+    {
+        uint32 Id;                          ///< Id, index in catalog
+        std::string Name;                   ///< Name, used in logs
+        std::string Query;                  ///< Query
+        std::vector<FieldType> Parameters;  ///< Type of each placeholder, binds are checked against it
+        bool ReadOnly;                      ///< Statement only reads, may be routed to a replica
+    };
+
+    /// Statements of a database addressed by an enum id
+    /// Every connection prepares all of them once on connect, so SQL errors show up at boot
+    /// and the hot path never waits on a prepare
+    class StatementCatalog
+    {
+        DISALLOW_COPY_AND_ASSIGN(StatementCatalog);
+
+        public:
+            /// Constructor
+            StatementCatalog();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Register statement, checks the declared parameters against the placeholders of the query
+            /// @p_Id         : Id of statement
+            /// @p_Name       : Name of statement
+            /// @p_Query      : Query
+            /// @p_Parameters : Type of each placeholder
+            /// @p_ReadOnly   : Statement only reads, may be routed to a replica
+            /// Returns false if id is already taken or parameters do not match the query
+            bool Register(uint32 p_Id, char const* p_Name, char const* p_Query, std::initializer_list<FieldType> p_Parameters, bool p_ReadOnly = false);
+
+            /// Get statement
+            /// @p_Id : Id of statement
+            /// Returns nullptr if id has not been registered
+            CatalogStatement const* Get(uint32 p_Id) const;
+            /// Get highest registered id + 1
+            uint32 GetSize() const;
+
+        private:
+            /// Count placeholders of a query, ignores quoted text and comments
+            /// @p_Query : Query
+            static uint32 CountPlaceholders(char const* p_Query);
+
+        private:
+            std::vector<std::unique_ptr<CatalogStatement>> m_Statements;    ///< Statements by id
+    };
+
+}   ///< namespace Database
+}   ///< namespace Core
+}   ///< namespace SteerStone
@@ -0,0 +1,79 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Database/Transaction.hpp"
+#include "Database/MYSQLPreparedStatement.hpp"
+#include "Database/Database.hpp"
+
+namespace SteerStone { namespace Core { namespace Database {
+
+    /// Constructor
+    /// @p_Reservation : Statement checked out of the pool, pins the connection
+    Transaction::Transaction(PreparedStatement* p_Reservation)
+        : m_Reservation(p_Reservation)
+    {
+    }
+    /// Deconstructor, gives the reservation back to the pool
+    Transaction::~Transaction()
+    {
+        /// Steps give their handles back to the statement cache of the connection
+        m_Statements.clear();
+
+        m_Reservation->GetConnection()->GetDatabase()->FreePrepareStatement(m_Reservation);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Add a step, returned statement is used to set its parameters
+    /// @p_Query : Query of step
+    PreparedStatement* Transaction::AddStatement(char const* p_Query)
+    {
+        m_Statements.push_back(std::make_unique<PreparedStatement>(m_Reservation->GetConnection()->shared_from_this()));
+        m_Statements.back()->PrepareStatement(p_Query);
+
+        return m_Statements.back().get();
+    }
+    /// Add a step of the catalog, returned statement is used to set its parameters
+    /// @p_StatementId : Id of statement in catalog
+    PreparedStatement* Transaction::AddStatement(uint32 p_StatementId)
+    {
+        m_Statements.push_back(std::make_unique<PreparedStatement>(m_Reservation->GetConnection()->shared_from_this()));
+        m_Statements.back()->PrepareCatalogStatement(p_StatementId);
+
+        return m_Statements.back().get();
+    }
+    /// Get amount of steps
+    std::size_t Transaction::GetSize() const
+    {
+        return m_Statements.size();
+    }
+
+    /// Execute every step, rolled back if any of them fails, called on database worker thread
+    /// Returns true if committed
+    bool Transaction::Execute()
+    {
+        if (m_Statements.empty())
+            return true;
+
+        return m_Reservation->GetConnection()->ExecuteTransaction(m_Statements);
+    }
+
+}   ///< namespace Database
+}   ///< namespace Core
+}   ///< namespace SteerStone
@@ -0,0 +1,64 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+#include "Database/PreparedStatement.hpp"
+
+namespace SteerStone { namespace Core { namespace Database {
+
+    /// Statements executed atomically on one connection between BEGIN and COMMIT
+    /// Holds one statement of the pool for its whole life, the connection of that statement is the one
+    /// every step is prepared and executed on. Results of steps are discarded, only the outcome is reported
+    class Transaction
+    {
+        DISALLOW_COPY_AND_ASSIGN(Transaction);
+
+    public:
+        /// Constructor
+        /// @p_Reservation : Statement checked out of the pool, pins the connection
+        explicit Transaction(PreparedStatement* p_Reservation);
+        /// Deconstructor, gives the reservation back to the pool
+        ~Transaction();
+
+        //////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////////////////////////////////////
+
+        /// Add a step, returned statement is used to set its parameters
+        /// @p_Query : Query of step
+        PreparedStatement* AddStatement(char const* p_Query);
+        /// Add a step of the catalog, returned statement is used to set its parameters
+        /// @p_StatementId : Id of statement in catalog
+        PreparedStatement* AddStatement(uint32 p_StatementId);
+        /// Get amount of steps
+        std::size_t GetSize() const;
+
+        /// Execute every step, rolled back if any of them fails, called on database worker thread
+        /// Returns true if committed
+        bool Execute();
+
+    private:
+        PreparedStatement* m_Reservation;                               ///< Statement of the pool held until we are done
+        std::vector<std::unique_ptr<PreparedStatement>> m_Statements;   ///< Steps in execution order, prepared on the connection of m_Reservation
+    };
+
+}   ///< namespace Database
+}   ///< namespace Core
+}   ///< namespace SteerStone
@@ -0,0 +1,89 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Database/TransactionOperator.hpp"
+
+namespace SteerStone { namespace Core { namespace Database {
+
+    /// Constructor
+    /// @p_Transaction : Transaction to execute
+    TransactionOperator::TransactionOperator(std::unique_ptr<Transaction> p_Transaction)
+        : m_Transaction(std::move(p_Transaction)), m_Queue(nullptr)
+    {
+    }
+    /// Constructor, outcome is posted to a completion queue instead of a future
+    /// @p_Transaction : Transaction to execute
+    /// @p_Queue : Queue of the owner the callback runs on
+    /// @p_Callback : Called with true once committed
+    TransactionOperator::TransactionOperator(std::unique_ptr<Transaction> p_Transaction, CompletionQueue* p_Queue, std::function<void(bool)> p_Callback)
+        : m_Transaction(std::move(p_Transaction)), m_Queue(p_Queue), m_Callback(std::move(p_Callback))
+    {
+    }
+    /// Deconstructor
+    TransactionOperator::~TransactionOperator()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get Future set, true once committed
+    std::future<bool> TransactionOperator::GetFuture()
+    {
+        return m_Promise.get_future();
+    }
+    /// Execute Transaction
+    bool TransactionOperator::Execute()
+    {
+        Deliver(m_Transaction->Execute());
+
+        return true;
+    }
+    /// Complete operator without executing it, the reservation is freed with the transaction
+    /// @p_Notify : Deliver failure to the caller, callbacks are skipped otherwise
+    void TransactionOperator::Reject(bool p_Notify)
+    {
+        m_Transaction.reset();
+
+        /// Futures are always set, a promise going away unset would throw on the caller
+        if (p_Notify || !m_Queue)
+            Deliver(false);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Hand outcome to future or completion queue
+    /// @p_Committed : Transaction committed
+    void TransactionOperator::Deliver(bool p_Committed)
+    {
+        if (!p_Committed)
+            SetFailed();
+
+        if (m_Queue)
+        {
+            std::function<void(bool)> l_Callback = std::move(m_Callback);
+            m_Queue->Post([l_Callback, p_Committed]() { l_Callback(p_Committed); });
+        }
+        else
+            m_Promise.set_value(p_Committed);
+    }
+
+}   ///< namespace Database
+}   ///< namespace Core
+}   ///< namespace SteerStone
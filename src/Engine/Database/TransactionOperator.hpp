@@ -0,0 +1,72 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include "Core/Core.hpp"
+#include "Database/Operator.hpp"
+#include "Memory/MemObjectPool.hpp"
+#include "Database/Transaction.hpp"
+#include "Database/CompletionQueue.hpp"
+#include <future>
+
+namespace SteerStone { namespace Core { namespace Database {
+
+    class TransactionOperator : public Operator
+    {
+    public:
+        /// Operators come from a pool, the database worker deletes them once executed
+        MEMORY_POOL_OPERATORS(TransactionOperator)
+
+        /// Constructor
+        /// @p_Transaction : Transaction to execute
+        explicit TransactionOperator(std::unique_ptr<Transaction> p_Transaction);
+        /// Constructor, outcome is posted to a completion queue instead of a future
+        /// @p_Transaction : Transaction to execute
+        /// @p_Queue : Queue of the owner the callback runs on
+        /// @p_Callback : Called with true once committed
+        TransactionOperator(std::unique_ptr<Transaction> p_Transaction, CompletionQueue* p_Queue, std::function<void(bool)> p_Callback);
+        /// Deconstructor
+        ~TransactionOperator() override;
+
+        //////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////////////////////////////////////
+
+        /// Get Future set, true once committed
+        std::future<bool> GetFuture();
+        /// Execute Transaction
+        virtual bool Execute() override;
+        /// Complete operator without executing it, the reservation is freed with the transaction
+        /// @p_Notify : Deliver failure to the caller, callbacks are skipped otherwise
+        void Reject(bool p_Notify) override;
+
+    private:
+        /// Hand outcome to future or completion queue
+        /// @p_Committed : Transaction committed
+        void Deliver(bool p_Committed);
+
+    private:
+        std::unique_ptr<Transaction> m_Transaction;     ///< Transaction, released with the operator
+        std::promise<bool> m_Promise;                   ///< Promise kept by the database worker thread, caller holds the future
+        CompletionQueue* m_Queue;                       ///< Queue outcome is posted to, nullptr if delivered through the promise
+        std::function<void(bool)> m_Callback;           ///< Callback posted with the outcome
+    };
+
+}   ///< namespace Database
+}   ///< namespace Core
+}   ///< namespace SteerStone
@@ -0,0 +1,381 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "WorkloadCapture.hpp"
+#include "PreparedStatement.hpp"
+#include "StatementCatalog.hpp"
+#include "Logger/Base.hpp"
+#include "Logger/LogDefines.hpp"
+
+namespace SteerStone { namespace Core { namespace Database {
+
+    /// Append value to buffer
+    /// @p_Buffer : Buffer
+    /// @p_Value  : Value
+    template<typename T> static void AppendValue(std::string& p_Buffer, T p_Value)
+    {
+        p_Buffer.append(reinterpret_cast<char const*>(&p_Value), sizeof(T));
+    }
+    /// Append length prefixed bytes to buffer
+    /// @p_Buffer : Buffer
+    /// @p_Data   : Bytes
+    /// @p_Length : Amount of bytes
+    static void AppendBytes(std::string& p_Buffer, char const* p_Data, std::size_t p_Length)
+    {
+        AppendValue<uint32>(p_Buffer, static_cast<uint32>(p_Length));
+        p_Buffer.append(p_Data, p_Length);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    WorkloadCapture::WorkloadCapture()
+        : m_Enabled(false), m_Executions(0), m_Size(0), m_MaxSize(0)
+    {
+    }
+    /// Deconstructor
+    WorkloadCapture::~WorkloadCapture()
+    {
+        Stop();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Start capturing, a capture already running is stopped first
+    /// @p_FileName : File records are written to, truncated
+    /// @p_MaxSize  : Megabytes after which capturing stops, 0 for no limit
+    /// Returns false if file could not be opened
+    bool WorkloadCapture::Start(std::string const& p_FileName, uint32 p_MaxSize)
+    {
+        Stop();
+
+        std::lock_guard<std::mutex> l_Guard(m_Mutex);
+
+        m_File.open(p_FileName, std::ios::binary | std::ios::trunc);
+        if (!m_File)
+        {
+            LOG_ERROR("Database", "Cannot open workload capture file %0", p_FileName);
+            return false;
+        }
+
+        WorkloadCaptureHeader l_Header;
+        l_Header.Magic      = WORKLOAD_CAPTURE_MAGIC;
+        l_Header.Format     = WORKLOAD_CAPTURE_FORMAT;
+        l_Header.StartTime  = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+        m_File.write(reinterpret_cast<char const*>(&l_Header), sizeof(l_Header));
+
+        m_Buffer.clear();
+        m_Buffer.reserve(WORKLOAD_CAPTURE_FLUSH_SIZE * 2);
+        m_Statements.clear();
+        m_StartTime = std::chrono::steady_clock::now();
+        m_Size      = sizeof(l_Header);
+        m_MaxSize   = static_cast<uint64>(p_MaxSize) * 1024 * 1024;
+        m_Executions.store(0, std::memory_order_relaxed);
+        m_Enabled.store(true, std::memory_order_release);
+
+        LOG_INFO("Database", "Capturing database workload to %0", p_FileName);
+
+        return true;
+    }
+    /// Stop capturing and write out buffered records
+    void WorkloadCapture::Stop()
+    {
+        std::lock_guard<std::mutex> l_Guard(m_Mutex);
+
+        if (!m_File.is_open())
+            return;
+
+        m_Enabled.store(false, std::memory_order_relaxed);
+
+        Flush();
+        m_File.close();
+
+        LOG_INFO("Database", "Stopped database workload capture, %0 executions of %1 statements captured",
+            m_Executions.load(std::memory_order_relaxed), static_cast<uint32>(m_Statements.size()));
+    }
+
+    /// Record statement being queued, must be called before the operator is queued
+    /// @p_Statement : Statement with its parameters bound
+    /// @p_Route     : Worker it is queued on
+    /// @p_ShardKey  : Shard key, 0 unless keyed
+    void WorkloadCapture::Record(PreparedStatement const* p_Statement, WorkloadRoute p_Route, uint64 p_ShardKey)
+    {
+        std::lock_guard<std::mutex> l_Guard(m_Mutex);
+
+        /// Stopped while we waited on the lock
+        if (!m_Enabled.load(std::memory_order_relaxed))
+            return;
+
+        const uint32 l_Statement = GetStatementIndex(p_Statement);
+        const std::size_t l_Start = m_Buffer.size();
+
+        AppendValue<uint8>(m_Buffer, static_cast<uint8>(WorkloadRecordType::Execution));
+        AppendValue<uint64>(m_Buffer, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_StartTime).count());
+        AppendValue<uint32>(m_Buffer, l_Statement);
+        AppendValue<uint8>(m_Buffer, static_cast<uint8>(p_Route));
+
+        if (p_Route == WorkloadRoute::Keyed)
+            AppendValue<uint64>(m_Buffer, p_ShardKey);
+
+        AppendValue<uint16>(m_Buffer, static_cast<uint16>(p_Statement->m_Binds.size()));
+
+        for (SQLBindData const& l_Bind : p_Statement->m_Binds)
+        {
+            const FieldType l_Type = l_Bind.GetType();
+
+            AppendValue<uint8>(m_Buffer, static_cast<uint8>(l_Type));
+
+            if (l_Type == FieldType::FIELD_STRING || l_Type == FieldType::FIELD_BINARY)
+                AppendBytes(m_Buffer, static_cast<char const*>(l_Bind.GetBuffer()), l_Bind.GetSize());
+            else if (l_Type != FieldType::FIELD_NONE)
+                m_Buffer.append(static_cast<char const*>(l_Bind.GetBuffer()), l_Bind.GetSize());
+        }
+
+        m_Size += m_Buffer.size() - l_Start;
+        m_Executions.fetch_add(1, std::memory_order_relaxed);
+
+        if (m_Buffer.size() >= WORKLOAD_CAPTURE_FLUSH_SIZE)
+            Flush();
+
+        if (m_MaxSize && m_Size >= m_MaxSize)
+        {
+            m_Enabled.store(false, std::memory_order_relaxed);
+
+            Flush();
+            m_File.close();
+
+            LOG_WARNING("Database", "Database workload capture reached its size limit, %0 executions captured", m_Executions.load(std::memory_order_relaxed));
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get index of statement, writes its record the first time it is seen
+    /// @p_Statement : Statement
+    uint32 WorkloadCapture::GetStatementIndex(PreparedStatement const* p_Statement)
+    {
+        const uint32 l_CatalogId = p_Statement->m_CatalogStatement ? p_Statement->m_CatalogStatement->Id : WORKLOAD_CAPTURE_AD_HOC;
+
+        /// A catalog statement and a query of the same text are kept apart, they are prepared differently
+        std::string l_Key(reinterpret_cast<char const*>(&l_CatalogId), sizeof(l_CatalogId));
+        l_Key += p_Statement->m_Query;
+
+        auto l_Itr = m_Statements.find(l_Key);
+        if (l_Itr != m_Statements.end())
+            return l_Itr->second;
+
+        const uint32 l_Index = static_cast<uint32>(m_Statements.size());
+        const std::size_t l_Start = m_Buffer.size();
+
+        AppendValue<uint8>(m_Buffer, static_cast<uint8>(WorkloadRecordType::Statement));
+        AppendValue<uint32>(m_Buffer, l_CatalogId);
+        AppendBytes(m_Buffer, p_Statement->m_Query.data(), p_Statement->m_Query.size());
+
+        m_Size += m_Buffer.size() - l_Start;
+        m_Statements.emplace(std::move(l_Key), l_Index);
+
+        return l_Index;
+    }
+    /// Write out buffered records
+    void WorkloadCapture::Flush()
+    {
+        if (m_Buffer.empty())
+            return;
+
+        m_File.write(m_Buffer.data(), m_Buffer.size());
+        m_Buffer.clear();
+
+        if (!m_File)
+        {
+            m_Enabled.store(false, std::memory_order_relaxed);
+            LOG_ERROR("Database", "Failed to write database workload capture, capture stopped");
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    WorkloadReader::WorkloadReader()
+        : m_Header{}, m_Error(false)
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Open capture file, checks its header
+    /// @p_FileName : Capture file
+    bool WorkloadReader::Open(std::string const& p_FileName)
+    {
+        m_File.open(p_FileName, std::ios::binary);
+        m_Statements.clear();
+        m_Error = false;
+
+        if (!m_File)
+        {
+            LOG_ERROR("Database", "Cannot open workload capture file %0", p_FileName);
+            return false;
+        }
+
+        if (!Read(m_Header) || m_Header.Magic != WORKLOAD_CAPTURE_MAGIC || m_Header.Format != WORKLOAD_CAPTURE_FORMAT)
+        {
+            LOG_ERROR("Database", "%0 is not a workload capture of format %1", p_FileName, WORKLOAD_CAPTURE_FORMAT);
+            return false;
+        }
+
+        return true;
+    }
+    /// Read next execution, statements up to it are added to the statement list
+    /// @p_Execution : Execution read
+    /// Returns false at end of file or if the file is malformed, see HasError
+    bool WorkloadReader::Next(WorkloadExecution& p_Execution)
+    {
+        for (;;)
+        {
+            uint8 l_Type = 0;
+
+            /// Running out of file where a record would start is a clean end
+            if (!Read(l_Type))
+            {
+                m_Error = m_File.gcount() != 0 || !m_File.eof();
+                return false;
+            }
+
+            if (l_Type == static_cast<uint8>(WorkloadRecordType::Statement))
+            {
+                WorkloadStatement l_Statement;
+
+                if (!Read(l_Statement.CatalogId) || !ReadBytes(l_Statement.Query))
+                    break;
+
+                m_Statements.push_back(std::move(l_Statement));
+                continue;
+            }
+
+            if (l_Type != static_cast<uint8>(WorkloadRecordType::Execution))
+                break;
+
+            uint8 l_Route = 0;
+            uint16 l_Count = 0;
+
+            p_Execution.ShardKey = 0;
+            p_Execution.Parameters.clear();
+            p_Execution.Buffers.clear();
+
+            if (!Read(p_Execution.Offset) || !Read(p_Execution.Statement) || !Read(l_Route))
+                break;
+
+            p_Execution.Route = static_cast<WorkloadRoute>(l_Route);
+
+            if (p_Execution.Route == WorkloadRoute::Keyed && !Read(p_Execution.ShardKey))
+                break;
+
+            if (p_Execution.Statement >= m_Statements.size() || !Read(l_Count))
+                break;
+
+            bool l_Valid = true;
+            for (uint16 l_I = 0; l_I < l_Count && l_Valid; l_I++)
+                l_Valid = ReadParameter(p_Execution);
+
+            if (!l_Valid)
+                break;
+
+            return true;
+        }
+
+        m_Error = true;
+        return false;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Read length prefixed bytes
+    /// @p_Data : Bytes read
+    template<typename T> bool WorkloadReader::ReadBytes(T& p_Data)
+    {
+        uint32 l_Length = 0;
+
+        if (!Read(l_Length))
+            return false;
+
+        p_Data.resize(l_Length);
+        return l_Length == 0 || static_cast<bool>(m_File.read(&p_Data[0], l_Length));
+    }
+    /// Read parameter of an execution
+    /// @p_Execution : Execution the parameter is appended to
+    bool WorkloadReader::ReadParameter(WorkloadExecution& p_Execution)
+    {
+        uint8 l_Type = 0;
+
+        if (!Read(l_Type))
+            return false;
+
+        std::vector<SQLBindData>& l_Parameters = p_Execution.Parameters;
+
+        switch (static_cast<FieldType>(l_Type))
+        {
+            case FieldType::FIELD_BOOL:   { bool l_Value;   if (!Read(l_Value)) return false; l_Parameters.emplace_back(l_Value); } break;
+            case FieldType::FIELD_UI8:    { uint8 l_Value;  if (!Read(l_Value)) return false; l_Parameters.emplace_back(l_Value); } break;
+            case FieldType::FIELD_UI16:   { uint16 l_Value; if (!Read(l_Value)) return false; l_Parameters.emplace_back(l_Value); } break;
+            case FieldType::FIELD_UI32:   { uint32 l_Value; if (!Read(l_Value)) return false; l_Parameters.emplace_back(l_Value); } break;
+            case FieldType::FIELD_UI64:   { uint64 l_Value; if (!Read(l_Value)) return false; l_Parameters.emplace_back(l_Value); } break;
+            case FieldType::FIELD_I8:     { int8 l_Value;   if (!Read(l_Value)) return false; l_Parameters.emplace_back(l_Value); } break;
+            case FieldType::FIELD_I16:    { int16 l_Value;  if (!Read(l_Value)) return false; l_Parameters.emplace_back(l_Value); } break;
+            case FieldType::FIELD_I32:    { int32 l_Value;  if (!Read(l_Value)) return false; l_Parameters.emplace_back(l_Value); } break;
+            case FieldType::FIELD_I64:    { int64 l_Value;  if (!Read(l_Value)) return false; l_Parameters.emplace_back(l_Value); } break;
+            case FieldType::FIELD_FLOAT:  { float l_Value;  if (!Read(l_Value)) return false; l_Parameters.emplace_back(l_Value); } break;
+            case FieldType::FIELD_DOUBLE: { double l_Value; if (!Read(l_Value)) return false; l_Parameters.emplace_back(l_Value); } break;
+            case FieldType::FIELD_STRING:
+            {
+                std::string l_Value;
+                if (!ReadBytes(l_Value))
+                    return false;
+
+                l_Parameters.emplace_back(std::move(l_Value));
+            }
+            break;
+            case FieldType::FIELD_BINARY:
+            {
+                /// Moving the buffer list keeps the bytes where the parameter points
+                p_Execution.Buffers.emplace_back();
+                if (!ReadBytes(p_Execution.Buffers.back()))
+                    return false;
+
+                l_Parameters.push_back(SQLBindData::Binary(p_Execution.Buffers.back().data(), p_Execution.Buffers.back().size()));
+            }
+            break;
+            case FieldType::FIELD_NONE:
+                l_Parameters.emplace_back();
+                break;
+            default:
+                return false;
+        }
+
+        return true;
+    }
+
+}   ///< namespace Database
+}   ///< namespace Core
+}   ///< namespace SteerStone
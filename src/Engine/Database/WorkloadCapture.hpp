@@ -0,0 +1,188 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <PCH/Precompiled.hpp>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+#include "Core/Core.hpp"
+#include "Database/BindData.hpp"
+
+#define WORKLOAD_CAPTURE_MAGIC          0x43575353      ///< "SSWC", reads differently on a machine of other byte order
+#define WORKLOAD_CAPTURE_FORMAT         1               ///< Version of the file layout
+#define WORKLOAD_CAPTURE_AD_HOC         0xFFFFFFFF      ///< Catalog id of statements prepared from a query
+#define WORKLOAD_CAPTURE_FLUSH_SIZE     65536           ///< Bytes of records buffered before they are written out
+
+namespace SteerStone { namespace Core { namespace Database {
+
+    class PreparedStatement;
+
+    /// Start of a capture file
+    struct WorkloadCaptureHeader
+    {
+        uint32 Magic;                       ///< WORKLOAD_CAPTURE_MAGIC
+        uint32 Format;                      ///< WORKLOAD_CAPTURE_FORMAT
+        uint64 StartTime;                   ///< Milliseconds since epoch the capture started at
+    };
+
+    /// Kind of record following the header
+    enum class WorkloadRecordType : uint8
+    {
+        Statement   = 1,                    ///< Query of a statement, written before its first execution
+        Execution   = 2                     ///< Statement queued with its parameters
+    };
+
+    /// Worker a captured statement was queued on
+    enum class WorkloadRoute : uint8
+    {
+        Load        = 0,                    ///< Least busy worker
+        Keyed       = 1                     ///< Worker owning the shard key
+    };
+
+    /// Statement of a capture
+    struct WorkloadStatement
+    {
+        uint32 CatalogId;                   ///< Id in catalog, WORKLOAD_CAPTURE_AD_HOC if prepared from a query
+        std::string Query;                  ///< Query
+    };
+
+    /// Execution of a capture
+    struct WorkloadExecution
+    {
+        uint64 Offset;                              ///< Nanoseconds since the capture started
+        uint32 Statement;                           ///< Index of statement in capture
+        WorkloadRoute Route;                        ///< Worker it was queued on
+        uint64 ShardKey;                            ///< Shard key, 0 unless keyed
+        std::vector<SQLBindData> Parameters;        ///< Value of each parameter
+        std::vector<std::vector<char>> Buffers;     ///< Bytes binary parameters point into
+    };
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Records every statement queued through Base::PrepareOperator with its parameters and the time it was
+    /// queued at, so a workload seen in production can be replayed against a test database
+    /// Statements are written once, executions refer to them by index. Capturing takes a lock per statement,
+    /// it is meant to run for a while on one server and costs an atomic load when stopped
+    class WorkloadCapture
+    {
+        DISALLOW_COPY_AND_ASSIGN(WorkloadCapture);
+
+        public:
+            /// Constructor
+            WorkloadCapture();
+            /// Deconstructor
+            ~WorkloadCapture();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Start capturing, a capture already running is stopped first
+            /// @p_FileName : File records are written to, truncated
+            /// @p_MaxSize  : Megabytes after which capturing stops, 0 for no limit
+            /// Returns false if file could not be opened
+            bool Start(std::string const& p_FileName, uint32 p_MaxSize = 0);
+            /// Stop capturing and write out buffered records
+            void Stop();
+            /// Check capture is running
+            bool IsEnabled() const { return m_Enabled.load(std::memory_order_relaxed); }
+            /// Get amount of executions captured
+            uint64 GetExecutionCount() const { return m_Executions.load(std::memory_order_relaxed); }
+
+            /// Record statement being queued, must be called before the operator is queued
+            /// @p_Statement : Statement with its parameters bound
+            /// @p_Route     : Worker it is queued on
+            /// @p_ShardKey  : Shard key, 0 unless keyed
+            void Record(PreparedStatement const* p_Statement, WorkloadRoute p_Route, uint64 p_ShardKey = 0);
+
+        private:
+            /// Get index of statement, writes its record the first time it is seen
+            /// @p_Statement : Statement
+            uint32 GetStatementIndex(PreparedStatement const* p_Statement);
+            /// Write out buffered records
+            void Flush();
+
+        private:
+            std::atomic<bool> m_Enabled;                                ///< Capture is running
+            std::atomic<uint64> m_Executions;                           ///< Executions captured
+            std::mutex m_Mutex;                                         ///< Guards everything below
+            std::ofstream m_File;                                       ///< Capture file
+            std::string m_Buffer;                                       ///< Records not written yet
+            std::chrono::steady_clock::time_point m_StartTime;          ///< Time capture started, offsets are taken from it
+            std::unordered_map<std::string, uint32> m_Statements;       ///< Index of each statement, by query
+            uint64 m_Size;                                              ///< Bytes captured
+            uint64 m_MaxSize;                                           ///< Bytes after which capturing stops, 0 for no limit
+    };
+
+    /// Reads a file written by WorkloadCapture
+    class WorkloadReader
+    {
+        DISALLOW_COPY_AND_ASSIGN(WorkloadReader);
+
+        public:
+            /// Constructor
+            WorkloadReader();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Open capture file, checks its header
+            /// @p_FileName : Capture file
+            bool Open(std::string const& p_FileName);
+            /// Read next execution, statements up to it are added to the statement list
+            /// @p_Execution : Execution read
+            /// Returns false at end of file or if the file is malformed, see HasError
+            bool Next(WorkloadExecution& p_Execution);
+            /// Check reading stopped on a malformed record
+            bool HasError() const { return m_Error; }
+
+            /// Get header of file
+            WorkloadCaptureHeader const& GetHeader() const { return m_Header; }
+            /// Get statements read so far, executions index into it
+            std::vector<WorkloadStatement> const& GetStatements() const { return m_Statements; }
+
+        private:
+            /// Read value
+            /// @p_Value : Value read
+            template<typename T> bool Read(T& p_Value)
+            {
+                return static_cast<bool>(m_File.read(reinterpret_cast<char*>(&p_Value), sizeof(T)));
+            }
+            /// Read length prefixed bytes
+            /// @p_Data : Bytes read
+            template<typename T> bool ReadBytes(T& p_Data);
+            /// Read parameter of an execution
+            /// @p_Execution : Execution the parameter is appended to
+            bool ReadParameter(WorkloadExecution& p_Execution);
+
+        private:
+            std::ifstream m_File;                                       ///< Capture file
+            WorkloadCaptureHeader m_Header;                             ///< Header of file
+            std::vector<WorkloadStatement> m_Statements;                ///< Statements read so far
+            bool m_Error;                                               ///< Stopped on a malformed record
+    };
+
+}   ///< namespace Database
+}   ///< namespace Core
+}   ///< namespace SteerStone
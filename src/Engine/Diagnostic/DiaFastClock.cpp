@@ -0,0 +1,126 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <Precompiled.hpp>
+
+#include "DiaFastClock.hpp"
+#include "Logger/Base.hpp"
+
+#if defined(FAST_CLOCK_TSC) && !defined(_MSC_VER)
+#   include <cpuid.h>
+#endif
+
+namespace SteerStone { namespace Core { namespace Diagnostic {
+
+    std::atomic<bool> FastClock::m_UseTsc(false);
+    uint64 FastClock::m_BaseTicks       = 0;
+    int64 FastClock::m_BaseNanoseconds  = 0;
+    uint64 FastClock::m_Multiplier      = 0;
+
+    /// Check if CPU has an invariant TSC, it ticks at a constant rate and does not stop in deep sleep states
+    static bool HasInvariantTsc()
+    {
+#if defined(FAST_CLOCK_TSC) && defined(_MSC_VER)
+        int l_Registers[4] = { 0 };
+
+        __cpuid(l_Registers, 0x80000000);
+        if (static_cast<uint32>(l_Registers[0]) < 0x80000007)
+            return false;
+
+        __cpuid(l_Registers, 0x80000007);
+        return (l_Registers[3] & (1 << 8)) != 0;
+#elif defined(FAST_CLOCK_TSC)
+        unsigned int l_Eax = 0, l_Ebx = 0, l_Ecx = 0, l_Edx = 0;
+
+        if (__get_cpuid_max(0x80000000, nullptr) < 0x80000007)
+            return false;
+
+        __get_cpuid(0x80000007, &l_Eax, &l_Ebx, &l_Ecx, &l_Edx);
+        return (l_Edx & (1 << 8)) != 0;
+#else
+        return false;
+#endif
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Measure TSC frequency against steady_clock, should run once at startup
+    /// Returns true if the TSC is used
+    bool FastClock::Calibrate()
+    {
+        if (m_UseTsc.load())
+            return true;
+
+#ifdef FAST_CLOCK_TSC
+        if (!HasInvariantTsc())
+        {
+            LOG_WARNING("FastClock", "CPU has no invariant TSC, timing falls back to steady_clock");
+            return false;
+        }
+
+        using SteadyClock = std::chrono::steady_clock;
+
+        const SteadyClock::time_point l_Start = SteadyClock::now();
+        const uint64 l_StartTicks = __rdtsc();
+
+        /// Busy wait, a sleep could let the core clock down on CPUs where that would show
+        SteadyClock::time_point l_End;
+        do
+        {
+            l_End = SteadyClock::now();
+        } while (l_End - l_Start < std::chrono::milliseconds(FAST_CLOCK_CALIBRATION_TIME));
+
+        const uint64 l_EndTicks = __rdtsc();
+
+        const uint64 l_Nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(l_End - l_Start).count();
+        const uint64 l_Ticks       = l_EndTicks - l_StartTicks;
+
+        if (l_Ticks == 0 || l_Nanoseconds == 0)
+            return false;
+
+        m_Multiplier        = (l_Nanoseconds << 32) / l_Ticks;
+        m_BaseTicks         = l_EndTicks;
+        m_BaseNanoseconds   = std::chrono::duration_cast<std::chrono::nanoseconds>(l_End.time_since_epoch()).count();
+
+        m_UseTsc.store(true, std::memory_order_release);
+
+        LOG_INFO("FastClock", "Using invariant TSC at %0 MHz", GetTicksPerMicrosecond());
+
+        return true;
+#else
+        return false;
+#endif
+    }
+    /// Is the TSC used
+    bool FastClock::IsUsingTsc()
+    {
+        return m_UseTsc.load(std::memory_order_relaxed);
+    }
+    /// Get measured TSC ticks per microsecond, 0 if the TSC is not used
+    uint64 FastClock::GetTicksPerMicrosecond()
+    {
+        if (!IsUsingTsc() || m_Multiplier == 0)
+            return 0;
+
+        return (uint64(1000) << 32) / m_Multiplier;
+    }
+
+}   ///< namespace Diagnostic
+}   ///< namespace Core
+}   ///< namespace SteerStone
@@ -0,0 +1,97 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "Core/Core.hpp"
+
+#include <atomic>
+#include <chrono>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#   define FAST_CLOCK_TSC 1
+#   if defined(_MSC_VER)
+#       include <intrin.h>
+#   else
+#       include <x86intrin.h>
+#   endif
+#endif
+
+#define FAST_CLOCK_CALIBRATION_TIME 20      ///< Milliseconds the TSC is measured against steady_clock during calibration
+
+namespace SteerStone { namespace Core { namespace Diagnostic {
+
+    /// Steady clock reading the time stamp counter, a handful of cycles instead of a clock call per read
+    /// Meets the std chrono clock requirements, its epoch is the one of steady_clock
+    /// Until Calibrate has run, or on CPUs without invariant TSC, it reads steady_clock instead
+    class FastClock
+    {
+        public:
+            using rep           = int64;
+            using period        = std::nano;
+            using duration      = std::chrono::nanoseconds;
+            using time_point    = std::chrono::time_point<FastClock>;
+
+            static constexpr bool is_steady = true;
+
+        public:
+            /// Measure TSC frequency against steady_clock, should run once at startup
+            /// Returns true if the TSC is used
+            static bool Calibrate();
+            /// Is the TSC used
+            static bool IsUsingTsc();
+            /// Get measured TSC ticks per microsecond, 0 if the TSC is not used
+            static uint64 GetTicksPerMicrosecond();
+
+            /// Get current time
+            static time_point now() noexcept
+            {
+                return time_point(duration(GetNanoseconds()));
+            }
+            /// Get nanoseconds since steady_clock epoch
+            static int64 GetNanoseconds() noexcept
+            {
+#ifdef FAST_CLOCK_TSC
+                if (m_UseTsc.load(std::memory_order_relaxed))
+                    return TicksToNanoseconds(__rdtsc());
+#endif
+                return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+            }
+
+        private:
+            /// Convert TSC ticks to nanoseconds since steady_clock epoch
+            /// @p_Ticks : Ticks read from the TSC
+            static int64 TicksToNanoseconds(uint64 p_Ticks) noexcept
+            {
+                /// 32.32 fixed point multiply, split so it does not overflow for long runs
+                const uint64 l_Delta      = p_Ticks - m_BaseTicks;
+                const uint64 l_Multiplier = m_Multiplier;
+
+                return m_BaseNanoseconds + static_cast<int64>((l_Delta >> 32) * l_Multiplier + (((l_Delta & 0xFFFFFFFFull) * l_Multiplier) >> 32));
+            }
+
+        private:
+            static std::atomic<bool> m_UseTsc;          ///< TSC is calibrated and invariant, written once before the flag is set
+            static uint64 m_BaseTicks;                  ///< TSC at calibration
+            static int64 m_BaseNanoseconds;             ///< steady_clock at calibration
+            static uint64 m_Multiplier;                 ///< Nanoseconds per tick in 32.32 fixed point
+    };
+
+}   ///< namespace Diagnostic
+}   ///< namespace Core
+}   ///< namespace SteerStone
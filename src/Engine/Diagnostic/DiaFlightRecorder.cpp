@@ -0,0 +1,468 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <Precompiled.hpp>
+#include <algorithm>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+
+#if defined(_WIN32)
+#   include <Windows.h>
+#   include <io.h>
+#   include <process.h>
+#else
+#   include <pthread.h>
+#   include <unistd.h>
+#endif
+
+#if defined(__GLIBC__)
+#   include <execinfo.h>
+#endif
+
+#include "DiaFlightRecorder.hpp"
+#include "DiaFastClock.hpp"
+#include "Utility/UtiSystem.hpp"
+
+#define FLIGHT_RECORDER_WRITE_BUFFER    4096        ///< Bytes formatted before they are written to the dump
+
+namespace SteerStone { namespace Core { namespace Diagnostic {
+
+    std::atomic<FlightThread*> FlightRecorder::s_Threads[FLIGHT_RECORDER_MAX_THREADS];
+    std::atomic<uint32> FlightRecorder::s_ThreadCount(0);
+    std::atomic<bool> FlightRecorder::s_Dumped(false);
+    char FlightRecorder::s_OutputPrefix[FLIGHT_RECORDER_OUTPUT_PATH] = "crash";
+    char FlightRecorder::s_DumpPath[FLIGHT_RECORDER_OUTPUT_PATH + 64] = { 0 };
+
+    /// Names of event types written to dumps
+    static char const* const s_EventNames[static_cast<uint32>(FlightEvent::Max)] =
+    {
+        "TaskStart",
+        "TaskEnd",
+        "Opcode",
+        "OperatorStart",
+        "OperatorEnd",
+        "SocketOpen",
+        "SocketClose"
+    };
+
+    /// Hands the ring back when its thread exits
+    struct FlightThreadHolder
+    {
+        /// Constructor
+        /// @p_Thread : Ring of thread, nullptr if none was left
+        explicit FlightThreadHolder(FlightThread* p_Thread)
+            : Thread(p_Thread)
+        {
+        }
+        /// Deconstructor
+        ~FlightThreadHolder()
+        {
+            if (Thread)
+                Thread->InUse.store(false, std::memory_order_release);
+        }
+
+        FlightThread* Thread;           ///< Ring of thread
+    };
+
+    /// Formats dumps into a fixed buffer and writes it with plain system calls, nothing allocates
+    struct FlightWriter
+    {
+        /// Constructor
+        /// @p_File : Descriptor written to
+        explicit FlightWriter(int p_File)
+            : File(p_File), Size(0)
+        {
+        }
+
+        /// Append text
+        /// @p_Text : Text
+        void Append(std::string_view const p_Text)
+        {
+            for (char l_Char : p_Text)
+            {
+                if (Size == sizeof(Buffer))
+                    Flush();
+
+                Buffer[Size++] = l_Char;
+            }
+        }
+        /// Append text padded with spaces
+        /// @p_Text  : Text
+        /// @p_Width : Minimum width
+        void AppendPadded(std::string_view const p_Text, std::size_t p_Width)
+        {
+            Append(p_Text);
+            for (std::size_t l_I = p_Text.size(); l_I < p_Width; l_I++)
+                Append(" ");
+        }
+        /// Append decimal number
+        /// @p_Value : Value
+        /// @p_Width : Minimum width, padded with p_Fill on the left
+        /// @p_Fill  : Padding character
+        void AppendNumber(uint64 p_Value, std::size_t p_Width = 0, char p_Fill = ' ')
+        {
+            char l_Digits[20];
+            std::size_t l_Count = 0;
+
+            do
+            {
+                l_Digits[l_Count++] = static_cast<char>('0' + p_Value % 10);
+                p_Value /= 10;
+            } while (p_Value);
+
+            for (std::size_t l_I = l_Count; l_I < p_Width; l_I++)
+                Append(std::string_view(&p_Fill, 1));
+
+            while (l_Count)
+                Append(std::string_view(&l_Digits[--l_Count], 1));
+        }
+        /// Append hexadecimal number
+        /// @p_Value : Value
+        void AppendHex(uint64 p_Value)
+        {
+            static char const s_Hex[] = "0123456789abcdef";
+
+            Append("0x");
+            for (int32 l_Shift = 60; l_Shift >= 0; l_Shift -= 4)
+                Append(std::string_view(&s_Hex[(p_Value >> l_Shift) & 0xF], 1));
+        }
+        /// Write what is buffered
+        void Flush()
+        {
+            std::size_t l_Written = 0;
+            while (l_Written < Size)
+            {
+#if defined(_WIN32)
+                const int l_Result = _write(File, Buffer + l_Written, static_cast<unsigned int>(Size - l_Written));
+#else
+                const ssize_t l_Result = write(File, Buffer + l_Written, Size - l_Written);
+#endif
+                if (l_Result <= 0)
+                    break;
+
+                l_Written += static_cast<std::size_t>(l_Result);
+            }
+
+            Size = 0;
+        }
+
+        int File;                                           ///< Descriptor written to
+        std::size_t Size;                                   ///< Bytes buffered
+        char Buffer[FLIGHT_RECORDER_WRITE_BUFFER];          ///< Buffered bytes
+    };
+
+    /// Kept out of the stack, the stack of a crashing thread may be nearly exhausted
+    static FlightWriter s_DumpWriter(-1);
+
+    /// Append text to a fixed path buffer, truncated to fit
+    /// @p_Path     : Path buffer
+    /// @p_Capacity : Size of path buffer
+    /// @p_Size     : Length of path, advanced
+    /// @p_Text     : Text
+    static void AppendPath(char* p_Path, std::size_t p_Capacity, std::size_t& p_Size, std::string_view const p_Text)
+    {
+        for (char l_Char : p_Text)
+        {
+            if (p_Size + 1 >= p_Capacity)
+                break;
+
+            p_Path[p_Size++] = l_Char;
+        }
+
+        p_Path[p_Size] = '\0';
+    }
+    /// Append decimal number to a fixed path buffer, truncated to fit
+    /// @p_Path     : Path buffer
+    /// @p_Capacity : Size of path buffer
+    /// @p_Size     : Length of path, advanced
+    /// @p_Value    : Value
+    static void AppendPath(char* p_Path, std::size_t p_Capacity, std::size_t& p_Size, uint64 p_Value)
+    {
+        char l_Digits[20];
+        std::size_t l_Count = 0;
+
+        do
+        {
+            l_Digits[l_Count++] = static_cast<char>('0' + p_Value % 10);
+            p_Value /= 10;
+        } while (p_Value);
+
+        while (l_Count)
+            AppendPath(p_Path, p_Capacity, p_Size, std::string_view(&l_Digits[--l_Count], 1));
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Record event on calling thread
+    /// @p_Type  : Type
+    /// @p_Name  : Name, must have static storage
+    /// @p_Value : Value, meaning depends on type
+    void FlightRecorder::Record(FlightEvent p_Type, std::string_view const p_Name, uint64 p_Value)
+    {
+        FlightThread* l_Thread = GetThread();
+        if (!l_Thread)
+            return;
+
+        const uint64 l_Head = l_Thread->Head.load(std::memory_order_relaxed);
+        FlightThread::Event& l_Event = l_Thread->Events[l_Head & (FLIGHT_RECORDER_RING_SIZE - 1)];
+
+        l_Event.Time.store(static_cast<uint64>(FastClock::GetNanoseconds()), std::memory_order_relaxed);
+        l_Event.Value.store(p_Value, std::memory_order_relaxed);
+        l_Event.Name.store(p_Name.data(), std::memory_order_relaxed);
+        l_Event.Length.store(static_cast<uint32>(p_Name.size()), std::memory_order_relaxed);
+        l_Event.Type.store(p_Type, std::memory_order_relaxed);
+
+        l_Thread->Head.store(l_Head + 1, std::memory_order_release);
+    }
+
+    /// Set where dumps are written
+    /// @p_Prefix : Path prefix, a timestamp, the process id and extension are appended
+    void FlightRecorder::SetOutput(std::string const& p_Prefix)
+    {
+        std::size_t l_Size = 0;
+        AppendPath(s_OutputPrefix, sizeof(s_OutputPrefix), l_Size, p_Prefix);
+    }
+    /// Dump on fatal signals (SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT), the signal is raised again once written
+    void FlightRecorder::InstallCrashHandler()
+    {
+#if defined(__GLIBC__)
+        /// The unwinder is loaded on first use, which allocates, do it now rather than in the handler
+        void* l_Frame = nullptr;
+        backtrace(&l_Frame, 1);
+#endif
+
+#if defined(_WIN32)
+        for (int l_Signal : { SIGSEGV, SIGILL, SIGFPE, SIGABRT })
+            std::signal(l_Signal, &FlightRecorder::OnFatalSignal);
+#else
+        struct sigaction l_Action;
+        std::memset(&l_Action, 0, sizeof(l_Action));
+        l_Action.sa_handler = &FlightRecorder::OnFatalSignal;
+        l_Action.sa_flags   = SA_RESETHAND;
+        sigemptyset(&l_Action.sa_mask);
+
+        for (int l_Signal : { SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT })
+            sigaction(l_Signal, &l_Action, nullptr);
+#endif
+    }
+
+    /// Write events of every thread and a backtrace of the calling thread, only the first dump of the process is written
+    /// Safe to call from a signal handler
+    /// @p_Reason : Why the dump is written
+    /// Returns false if a dump was already written or the file could not be opened
+    bool FlightRecorder::Dump(std::string_view const p_Reason)
+    {
+        if (s_Dumped.exchange(true, std::memory_order_acq_rel))
+            return false;
+
+        const uint64 l_Now  = static_cast<uint64>(FastClock::GetNanoseconds());
+        const uint64 l_Time = static_cast<uint64>(std::time(nullptr));
+#if defined(_WIN32)
+        const uint64 l_Process = static_cast<uint64>(_getpid());
+#else
+        const uint64 l_Process = static_cast<uint64>(getpid());
+#endif
+
+        char l_Path[sizeof(s_DumpPath)];
+        std::size_t l_PathSize = 0;
+        AppendPath(l_Path, sizeof(l_Path), l_PathSize, std::string_view(s_OutputPrefix));
+        AppendPath(l_Path, sizeof(l_Path), l_PathSize, "_");
+        AppendPath(l_Path, sizeof(l_Path), l_PathSize, l_Time);
+        AppendPath(l_Path, sizeof(l_Path), l_PathSize, "_");
+        AppendPath(l_Path, sizeof(l_Path), l_PathSize, l_Process);
+        AppendPath(l_Path, sizeof(l_Path), l_PathSize, ".txt");
+
+#if defined(_WIN32)
+        const int l_File = _open(l_Path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+        const int l_File = open(l_Path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+        if (l_File < 0)
+            return false;
+
+        FlightWriter& l_Writer = s_DumpWriter;
+        l_Writer.File = l_File;
+
+        l_Writer.Append("Flight recorder\nReason   : ");
+        l_Writer.Append(p_Reason);
+        l_Writer.Append("\nTime     : ");
+        l_Writer.AppendNumber(l_Time);
+        l_Writer.Append("\nProcess  : ");
+        l_Writer.AppendNumber(l_Process);
+        l_Writer.Append("\nThread   : ");
+        l_Writer.AppendNumber(Utils::GetThreadId());
+        l_Writer.Append("\n\nBacktrace of dumping thread:\n");
+
+        void* l_Frames[FLIGHT_RECORDER_BACKTRACE];
+#if defined(__GLIBC__)
+        const int l_FrameCount = backtrace(l_Frames, FLIGHT_RECORDER_BACKTRACE);
+        l_Writer.Flush();
+        backtrace_symbols_fd(l_Frames, l_FrameCount, l_File);
+#elif defined(_WIN32)
+        const uint32 l_FrameCount = CaptureStackBackTrace(0, FLIGHT_RECORDER_BACKTRACE, l_Frames, nullptr);
+        for (uint32 l_I = 0; l_I < l_FrameCount; l_I++)
+        {
+            l_Writer.Append("    ");
+            l_Writer.AppendHex(reinterpret_cast<uint64>(l_Frames[l_I]));
+            l_Writer.Append("\n");
+        }
+#else
+        (void)l_Frames;
+        l_Writer.Append("    not available on this platform\n");
+#endif
+
+        /// Times are written relative to the dump, other threads keep recording while we read their rings
+        const uint32 l_ThreadCount = std::min<uint32>(s_ThreadCount.load(std::memory_order_acquire), FLIGHT_RECORDER_MAX_THREADS);
+        for (uint32 l_I = 0; l_I < l_ThreadCount; l_I++)
+        {
+            FlightThread* l_Thread = s_Threads[l_I].load(std::memory_order_acquire);
+            if (!l_Thread)
+                continue;
+
+            const uint64 l_Head  = l_Thread->Head.load(std::memory_order_acquire);
+            const uint64 l_Count = std::min<uint64>(l_Head, FLIGHT_RECORDER_RING_SIZE);
+
+            l_Writer.Append("\nThread ");
+            l_Writer.AppendNumber(l_Thread->Id);
+            l_Writer.Append(" \"");
+            l_Writer.Append(std::string_view(l_Thread->Name, strnlen(l_Thread->Name, sizeof(l_Thread->Name))));
+            l_Writer.Append("\" (system id ");
+            l_Writer.AppendNumber(l_Thread->SystemId);
+            l_Writer.Append(l_Thread->InUse.load(std::memory_order_relaxed) ? "" : ", exited");
+            l_Writer.Append("), ");
+            l_Writer.AppendNumber(l_Head);
+            l_Writer.Append(" events, last ");
+            l_Writer.AppendNumber(l_Count);
+            l_Writer.Append(" oldest first:\n");
+
+            for (uint64 l_Index = l_Head - l_Count; l_Index < l_Head; l_Index++)
+            {
+                FlightThread::Event const& l_Event = l_Thread->Events[l_Index & (FLIGHT_RECORDER_RING_SIZE - 1)];
+
+                const uint64 l_EventTime    = l_Event.Time.load(std::memory_order_relaxed);
+                const uint64 l_Ago          = l_Now > l_EventTime ? l_Now - l_EventTime : 0;
+                const uint32 l_Type         = static_cast<uint32>(l_Event.Type.load(std::memory_order_relaxed));
+                char const* l_Name          = l_Event.Name.load(std::memory_order_relaxed);
+
+                l_Writer.Append("    -");
+                l_Writer.AppendNumber(l_Ago / 1000, 10);
+                l_Writer.Append(".");
+                l_Writer.AppendNumber(l_Ago % 1000, 3, '0');
+                l_Writer.Append(" us  ");
+                l_Writer.AppendPadded(l_Type < static_cast<uint32>(FlightEvent::Max) ? s_EventNames[l_Type] : "Unknown", 15);
+                l_Writer.AppendPadded(l_Name ? std::string_view(l_Name, l_Event.Length.load(std::memory_order_relaxed)) : std::string_view(), 40);
+                l_Writer.AppendNumber(l_Event.Value.load(std::memory_order_relaxed));
+                l_Writer.Append("\n");
+            }
+        }
+
+        l_Writer.Flush();
+
+#if defined(_WIN32)
+        _close(l_File);
+#else
+        close(l_File);
+#endif
+
+        std::memcpy(s_DumpPath, l_Path, l_PathSize + 1);
+
+        return true;
+    }
+    /// Get path of the written dump, empty until one is written
+    char const* FlightRecorder::GetDumpPath()
+    {
+        return s_DumpPath;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get ring of calling thread, registering it on first use
+    FlightThread* FlightRecorder::GetThread()
+    {
+        static thread_local FlightThreadHolder tl_Holder(AcquireThread());
+
+        return tl_Holder.Thread;
+    }
+    /// Take a ring for a new thread, nullptr if every ring is in use
+    FlightThread* FlightRecorder::AcquireThread()
+    {
+        FlightThread* l_Thread = nullptr;
+
+        /// Rings of exited threads are kept for dumps, they are only reused once every ring is taken
+        const uint32 l_Index = s_ThreadCount.load(std::memory_order_relaxed) < FLIGHT_RECORDER_MAX_THREADS ? s_ThreadCount.fetch_add(1, std::memory_order_acq_rel) : FLIGHT_RECORDER_MAX_THREADS;
+        if (l_Index < FLIGHT_RECORDER_MAX_THREADS)
+        {
+            l_Thread        = new FlightThread();
+            l_Thread->Id    = l_Index + 1;
+            l_Thread->InUse.store(true, std::memory_order_relaxed);
+        }
+        else
+        {
+            for (uint32 l_I = 0; l_I < FLIGHT_RECORDER_MAX_THREADS && !l_Thread; l_I++)
+            {
+                FlightThread* l_Existing = s_Threads[l_I].load(std::memory_order_acquire);
+                bool l_InUse = false;
+
+                if (l_Existing && l_Existing->InUse.compare_exchange_strong(l_InUse, true, std::memory_order_acq_rel))
+                    l_Thread = l_Existing;
+            }
+
+            if (!l_Thread)
+                return nullptr;
+        }
+
+        std::memset(l_Thread->Name, 0, sizeof(l_Thread->Name));
+#if !defined(_WIN32)
+        pthread_getname_np(pthread_self(), l_Thread->Name, sizeof(l_Thread->Name));
+#endif
+        l_Thread->SystemId = Utils::GetThreadId();
+        l_Thread->Head.store(0, std::memory_order_release);
+
+        s_Threads[l_Thread->Id - 1].store(l_Thread, std::memory_order_release);
+
+        return l_Thread;
+    }
+
+    /// Dump and raise signal again with its default action
+    /// @p_Signal : Signal
+    void FlightRecorder::OnFatalSignal(int p_Signal)
+    {
+        switch (p_Signal)
+        {
+            case SIGSEGV:   Dump("Fatal signal SIGSEGV");   break;
+            case SIGILL:    Dump("Fatal signal SIGILL");    break;
+            case SIGFPE:    Dump("Fatal signal SIGFPE");    break;
+            case SIGABRT:   Dump("Fatal signal SIGABRT");   break;
+#if !defined(_WIN32)
+            case SIGBUS:    Dump("Fatal signal SIGBUS");    break;
+#endif
+            default:        Dump("Fatal signal");           break;
+        }
+
+        /// Handler was reset to the default action, the signal is delivered again once we return
+        std::signal(p_Signal, SIG_DFL);
+        std::raise(p_Signal);
+    }
+
+}   ///< namespace Diagnostic
+}   ///< namespace Core
+}   ///< namespace SteerStone
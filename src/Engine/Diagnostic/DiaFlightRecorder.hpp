@@ -0,0 +1,119 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <PCH/Precompiled.hpp>
+#include <atomic>
+#include <string>
+#include <string_view>
+
+#include "Core/Core.hpp"
+
+#define FLIGHT_RECORDER_RING_SIZE       256         ///< Events kept per thread, must be a power of two, older events are overwritten
+#define FLIGHT_RECORDER_MAX_THREADS     512         ///< Rings allocated, past it threads reuse rings of exited threads
+#define FLIGHT_RECORDER_THREAD_NAME     32          ///< Bytes kept of a thread name
+#define FLIGHT_RECORDER_OUTPUT_PATH     256         ///< Bytes kept of the output prefix
+#define FLIGHT_RECORDER_BACKTRACE       64          ///< Frames written of the crashing thread
+
+namespace SteerStone { namespace Core { namespace Diagnostic {
+
+    /// Recorded event types
+    enum class FlightEvent : uint8
+    {
+        TaskStart,          ///< Task update started, name is the task
+        TaskEnd,            ///< Task update ended, name is the task
+        Opcode,             ///< Client message dispatched, name is the opcode and value the header id
+        OperatorStart,      ///< Database operator execution started, value is the operator id
+        OperatorEnd,        ///< Database operator execution ended, value is the operator id
+        SocketOpen,         ///< Socket opened, value is the address of the socket, handles are only unique per network thread
+        SocketClose,        ///< Socket closed, value is the address of the socket
+        Max
+    };
+
+    /// Ring of events recorded by one thread
+    /// Only the owning thread writes, a dump reads it from the crashing thread and may see a slot being written
+    struct FlightThread
+    {
+        /// Recorded event, fields are atomics so dumps may read a slot which is being written
+        struct Event
+        {
+            std::atomic<uint64> Time;               ///< FastClock nanoseconds
+            std::atomic<uint64> Value;              ///< Value, meaning depends on type
+            std::atomic<char const*> Name;          ///< Name, has static storage
+            std::atomic<uint32> Length;             ///< Length of name
+            std::atomic<FlightEvent> Type;          ///< Type
+        };
+
+        uint32 Id;                                  ///< Id written to dumps
+        uint64 SystemId;                            ///< OS thread id
+        char Name[FLIGHT_RECORDER_THREAD_NAME];     ///< Name of thread when it registered
+        std::atomic<bool> InUse;                    ///< Thread is alive, ring is reused once it exited
+        std::atomic<uint64> Head;                   ///< Amount of events written
+        Event Events[FLIGHT_RECORDER_RING_SIZE];    ///< Ring
+    };
+
+    /// Keeps the last events of every thread and writes them to a file on assert and fatal signals
+    /// Always recording, an event costs a clock read and a few stores in the ring of the calling thread
+    /// Everything a dump touches is allocated up front so it may run from a signal handler
+    class FlightRecorder
+    {
+        DISALLOW_COPY_AND_ASSIGN(FlightRecorder);
+
+        public:
+            /// Record event on calling thread
+            /// @p_Type  : Type
+            /// @p_Name  : Name, must have static storage
+            /// @p_Value : Value, meaning depends on type
+            static void Record(FlightEvent p_Type, std::string_view const p_Name, uint64 p_Value = 0);
+
+            /// Set where dumps are written
+            /// @p_Prefix : Path prefix, a timestamp, the process id and extension are appended
+            static void SetOutput(std::string const& p_Prefix);
+            /// Dump on fatal signals (SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT), the signal is raised again once written
+            static void InstallCrashHandler();
+
+            /// Write events of every thread and a backtrace of the calling thread, only the first dump of the process is written
+            /// Safe to call from a signal handler
+            /// @p_Reason : Why the dump is written
+            /// Returns false if a dump was already written or the file could not be opened
+            static bool Dump(std::string_view const p_Reason);
+            /// Get path of the written dump, empty until one is written
+            static char const* GetDumpPath();
+
+        private:
+            /// Get ring of calling thread, registering it on first use
+            static FlightThread* GetThread();
+            /// Take a ring for a new thread, nullptr if every ring is in use
+            static FlightThread* AcquireThread();
+
+            /// Dump and raise signal again with its default action
+            /// @p_Signal : Signal
+            static void OnFatalSignal(int p_Signal);
+
+        private:
+            static std::atomic<FlightThread*> s_Threads[FLIGHT_RECORDER_MAX_THREADS];     ///< Rings, never freed so events of exited threads are dumped
+            static std::atomic<uint32> s_ThreadCount;                                     ///< Rings allocated
+            static std::atomic<bool> s_Dumped;                                            ///< A dump was started
+            static char s_OutputPrefix[FLIGHT_RECORDER_OUTPUT_PATH];                      ///< Path prefix of dumps
+            static char s_DumpPath[FLIGHT_RECORDER_OUTPUT_PATH + 64];                     ///< Path of written dump
+    };
+
+}   ///< namespace Diagnostic
+}   ///< namespace Core
+}   ///< namespace SteerStone
@@ -0,0 +1,181 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <Precompiled.hpp>
+
+#include "DiaHistogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace SteerStone { namespace Core { namespace Diagnostic {
+
+    /// Constructor
+    LatencyHistogram::LatencyHistogram()
+        : m_ResetGeneration(0), m_ClearedGeneration(0)
+    {
+        Clear();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Add every sample of another histogram, we are written to like Record
+    /// @p_Other : Histogram, may be recorded to meanwhile
+    void LatencyHistogram::Merge(LatencyHistogram const& p_Other)
+    {
+        const uint32 l_Generation = m_ResetGeneration.load(std::memory_order_acquire);
+        if (l_Generation != m_ClearedGeneration.load(std::memory_order_relaxed))
+        {
+            Clear();
+            m_ClearedGeneration.store(l_Generation, std::memory_order_release);
+        }
+
+        if (p_Other.IsResetPending())
+            return;
+
+        /// Count is the sum of what we copied so percentiles rank against buckets we actually hold
+        uint64 l_Count = 0;
+        for (uint32 l_I = 0; l_I < BucketCount; ++l_I)
+        {
+            const uint64 l_Samples = p_Other.m_Buckets[l_I].load(std::memory_order_relaxed);
+
+            m_Buckets[l_I].store(m_Buckets[l_I].load(std::memory_order_relaxed) + l_Samples, std::memory_order_relaxed);
+            l_Count += l_Samples;
+        }
+
+        m_Count.store(m_Count.load(std::memory_order_relaxed) + l_Count, std::memory_order_relaxed);
+        m_Sum.store(m_Sum.load(std::memory_order_relaxed) + p_Other.m_Sum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+        const uint64 l_Max = p_Other.m_Max.load(std::memory_order_relaxed);
+        if (l_Max > m_Max.load(std::memory_order_relaxed))
+            m_Max.store(l_Max, std::memory_order_relaxed);
+    }
+    /// Clear every sample, for periodic reporting
+    /// Readers see an empty histogram straight away
+    void LatencyHistogram::Reset()
+    {
+        m_ResetGeneration.fetch_add(1, std::memory_order_acq_rel);
+    }
+    /// Clear buckets, writer side of Reset
+    void LatencyHistogram::Clear()
+    {
+        for (auto & l_Bucket : m_Buckets)
+            l_Bucket.store(0, std::memory_order_relaxed);
+
+        m_Count.store(0, std::memory_order_relaxed);
+        m_Sum.store(0, std::memory_order_relaxed);
+        m_Max.store(0, std::memory_order_relaxed);
+    }
+    /// Check if a reset has not been carried out by the writer yet
+    bool LatencyHistogram::IsResetPending() const
+    {
+        return m_ResetGeneration.load(std::memory_order_acquire) != m_ClearedGeneration.load(std::memory_order_acquire);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get amount of samples
+    uint64 LatencyHistogram::GetCount() const
+    {
+        return IsResetPending() ? 0 : m_Count.load(std::memory_order_relaxed);
+    }
+    /// Get mean in nanoseconds
+    uint64 LatencyHistogram::GetMean() const
+    {
+        const uint64 l_Count = GetCount();
+        return (l_Count && !IsResetPending()) ? m_Sum.load(std::memory_order_relaxed) / l_Count : 0;
+    }
+    /// Get largest sample in nanoseconds
+    uint64 LatencyHistogram::GetMax() const
+    {
+        return IsResetPending() ? 0 : m_Max.load(std::memory_order_relaxed);
+    }
+    /// Get value in nanoseconds at or below which a share of samples fall, highest value of its bucket
+    /// @p_Quantile : Share of samples, from 0 to 1
+    uint64 LatencyHistogram::GetPercentile(double p_Quantile) const
+    {
+        /// Buckets are read one by one while writers keep going, their own sum is the count we rank against
+        uint64 l_Counts[BucketCount];
+        uint64 l_Total = 0;
+
+        if (IsResetPending())
+            return 0;
+
+        for (uint32 l_I = 0; l_I < BucketCount; ++l_I)
+        {
+            l_Counts[l_I] = m_Buckets[l_I].load(std::memory_order_relaxed);
+            l_Total += l_Counts[l_I];
+        }
+
+        if (l_Total == 0)
+            return 0;
+
+        const double l_Quantile = p_Quantile < 0.0 ? 0.0 : (p_Quantile > 1.0 ? 1.0 : p_Quantile);
+        const uint64 l_Rank     = std::max<uint64>(1, static_cast<uint64>(std::ceil(l_Quantile * static_cast<double>(l_Total))));
+        const uint64 l_Max      = GetMax();
+
+        uint64 l_Seen = 0;
+        for (uint32 l_I = 0; l_I < BucketCount; ++l_I)
+        {
+            l_Seen += l_Counts[l_I];
+
+            /// Largest sample is exact, no point reporting past it, the last bucket also holds every clamped value
+            if (l_Seen >= l_Rank)
+                return (l_I == BucketCount - 1 || (l_Max && l_Max < GetBucketHighestValue(l_I))) ? l_Max : GetBucketHighestValue(l_I);
+        }
+
+        return l_Max;
+    }
+    /// Get median in nanoseconds
+    uint64 LatencyHistogram::GetP50() const
+    {
+        return GetPercentile(0.5);
+    }
+    /// Get 99th percentile in nanoseconds
+    uint64 LatencyHistogram::GetP99() const
+    {
+        return GetPercentile(0.99);
+    }
+    /// Get 99.9th percentile in nanoseconds
+    uint64 LatencyHistogram::GetP999() const
+    {
+        return GetPercentile(0.999);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get highest value of a bucket
+    /// @p_Index : Bucket index
+    uint64 LatencyHistogram::GetBucketHighestValue(uint32 p_Index)
+    {
+        if (p_Index < SubBucketCount)
+            return p_Index;
+
+        const uint32 l_Shift    = (p_Index >> HISTOGRAM_SUB_BUCKET_BITS) - 1;
+        const uint64 l_Mantissa = SubBucketCount | (p_Index & (SubBucketCount - 1));
+
+        return ((l_Mantissa + 1) << l_Shift) - 1;
+    }
+
+}   ///< namespace Diagnostic
+}   ///< namespace Core
+}   ///< namespace SteerStone
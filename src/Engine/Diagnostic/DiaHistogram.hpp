@@ -0,0 +1,153 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "Core/Core.hpp"
+
+#include <atomic>
+#include <chrono>
+
+#if defined(_MSC_VER)
+#   include <intrin.h>
+#endif
+
+#define HISTOGRAM_SUB_BUCKET_BITS   4       ///< Linear sub buckets per power of two are 1 << bits, values are within 1 / (1 << bits) of their bucket
+#define HISTOGRAM_MAX_VALUE_BITS    40      ///< Values from 1 << bits nanoseconds (about 18 minutes) land in the last bucket
+
+namespace SteerStone { namespace Core { namespace Diagnostic {
+
+    /// Log linear histogram of durations in nanoseconds (HDR style)
+    /// Each power of two is split into linear sub buckets. Samples are recorded by one thread at a time (the thread
+    /// running a task or a worker), so recording is a few relaxed loads and stores with no locked instruction.
+    /// Readers and Reset may run on any thread, Reset is carried out by the writer on its next sample
+    class LatencyHistogram
+    {
+        DISALLOW_COPY_AND_ASSIGN(LatencyHistogram);
+
+        public:
+            static constexpr uint32 SubBucketCount  = 1u << HISTOGRAM_SUB_BUCKET_BITS;
+            static constexpr uint32 BucketCount     = (HISTOGRAM_MAX_VALUE_BITS - HISTOGRAM_SUB_BUCKET_BITS + 1) * SubBucketCount;
+
+        public:
+            /// Constructor
+            LatencyHistogram();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Record sample
+            /// @p_Value : Duration in nanoseconds
+            void Record(uint64 p_Value)
+            {
+                const uint32 l_Generation = m_ResetGeneration.load(std::memory_order_acquire);
+
+                if (l_Generation != m_ClearedGeneration.load(std::memory_order_relaxed))
+                {
+                    Clear();
+                    m_ClearedGeneration.store(l_Generation, std::memory_order_release);
+                }
+
+                std::atomic<uint64> & l_Bucket = m_Buckets[GetBucketIndex(p_Value)];
+
+                l_Bucket.store(l_Bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                m_Count.store(m_Count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                m_Sum.store(m_Sum.load(std::memory_order_relaxed) + p_Value, std::memory_order_relaxed);
+
+                if (p_Value > m_Max.load(std::memory_order_relaxed))
+                    m_Max.store(p_Value, std::memory_order_relaxed);
+            }
+            /// Record sample
+            /// @p_Duration : Duration, negative durations are recorded as 0
+            template<typename Rep, typename Period> void Record(std::chrono::duration<Rep, Period> p_Duration)
+            {
+                const int64 l_Value = static_cast<int64>(std::chrono::duration_cast<std::chrono::nanoseconds>(p_Duration).count());
+                Record(static_cast<uint64>(l_Value > 0 ? l_Value : 0));
+            }
+
+            /// Add every sample of another histogram, we are written to like Record
+            /// @p_Other : Histogram, may be recorded to meanwhile
+            void Merge(LatencyHistogram const& p_Other);
+            /// Clear every sample, for periodic reporting
+            /// Readers see an empty histogram straight away
+            void Reset();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Get amount of samples
+            uint64 GetCount() const;
+            /// Get mean in nanoseconds
+            uint64 GetMean() const;
+            /// Get largest sample in nanoseconds
+            uint64 GetMax() const;
+            /// Get value in nanoseconds at or below which a share of samples fall, highest value of its bucket
+            /// @p_Quantile : Share of samples, from 0 to 1
+            uint64 GetPercentile(double p_Quantile) const;
+            /// Get median in nanoseconds
+            uint64 GetP50() const;
+            /// Get 99th percentile in nanoseconds
+            uint64 GetP99() const;
+            /// Get 99.9th percentile in nanoseconds
+            uint64 GetP999() const;
+
+        private:
+            /// Clear buckets, writer side of Reset
+            void Clear();
+            /// Check if a reset has not been carried out by the writer yet
+            bool IsResetPending() const;
+
+            /// Get bucket of a value
+            /// @p_Value : Value
+            static uint32 GetBucketIndex(uint64 p_Value)
+            {
+                if (p_Value < SubBucketCount)
+                    return static_cast<uint32>(p_Value);
+
+                if (p_Value >> HISTOGRAM_MAX_VALUE_BITS)
+                    return BucketCount - 1;
+
+#if defined(_MSC_VER)
+                unsigned long l_Bit = 0;
+                _BitScanReverse64(&l_Bit, p_Value);
+                const uint32 l_HighBit = static_cast<uint32>(l_Bit);
+#else
+                const uint32 l_HighBit = 63 - static_cast<uint32>(__builtin_clzll(p_Value));
+#endif
+                const uint32 l_Shift = l_HighBit - HISTOGRAM_SUB_BUCKET_BITS;
+
+                return ((l_Shift + 1) << HISTOGRAM_SUB_BUCKET_BITS) | static_cast<uint32>((p_Value >> l_Shift) & (SubBucketCount - 1));
+            }
+            /// Get highest value of a bucket
+            /// @p_Index : Bucket index
+            static uint64 GetBucketHighestValue(uint32 p_Index);
+
+        private:
+            std::atomic<uint64> m_Buckets[BucketCount];     ///< Samples per bucket
+            std::atomic<uint64> m_Count;                    ///< Amount of samples
+            std::atomic<uint64> m_Sum;                      ///< Sum of samples
+            std::atomic<uint64> m_Max;                      ///< Largest sample
+            std::atomic<uint32> m_ResetGeneration;          ///< Amount of resets asked for
+            std::atomic<uint32> m_ClearedGeneration;        ///< Amount of resets carried out by the writer
+
+    };
+
+}   ///< namespace Diagnostic
+}   ///< namespace Core
+}   ///< namespace SteerStone
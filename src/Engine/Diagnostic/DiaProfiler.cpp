@@ -0,0 +1,542 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <Precompiled.hpp>
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+
+#if !defined(_WIN32)
+#   include <pthread.h>
+#endif
+
+#include "DiaProfiler.hpp"
+#include "Logger/Base.hpp"
+#include "Utility/UtiString.hpp"
+
+namespace SteerStone { namespace Core { namespace Diagnostic {
+
+    SINGLETON_P_I(Profiler);
+
+    std::atomic<bool> Profiler::s_Recording(false);
+
+    /// Hands the ring back when its thread exits
+    struct ProfileThreadHolder
+    {
+        /// Constructor
+        /// @p_Thread : Ring of thread
+        explicit ProfileThreadHolder(ProfileThread* p_Thread)
+            : Thread(p_Thread)
+        {
+        }
+        /// Deconstructor
+        ~ProfileThreadHolder()
+        {
+            Thread->InUse.store(false, std::memory_order_release);
+        }
+
+        ProfileThread* Thread;          ///< Ring of thread
+    };
+
+    /// Protobuf encoding helpers for Perfetto traces
+    namespace Proto {
+
+        /// Field numbers of the messages written, from perfetto/trace/*.proto
+        enum Field : uint32
+        {
+            TracePacket                 = 1,        ///< Trace.packet
+            PacketTimestamp             = 8,        ///< TracePacket.timestamp
+            PacketSequenceId            = 10,       ///< TracePacket.trusted_packet_sequence_id
+            PacketTrackEvent            = 11,       ///< TracePacket.track_event
+            PacketSequenceFlags         = 13,       ///< TracePacket.sequence_flags
+            PacketTimestampClock        = 58,       ///< TracePacket.timestamp_clock_id
+            PacketTrackDescriptor       = 60,       ///< TracePacket.track_descriptor
+            TrackUuid                   = 1,        ///< TrackDescriptor.uuid
+            TrackName                   = 2,        ///< TrackDescriptor.name
+            TrackProcess                = 3,        ///< TrackDescriptor.process
+            TrackThread                 = 4,        ///< TrackDescriptor.thread
+            TrackParentUuid             = 5,        ///< TrackDescriptor.parent_uuid
+            ProcessPid                  = 1,        ///< ProcessDescriptor.pid
+            ProcessName                 = 6,        ///< ProcessDescriptor.process_name
+            ThreadPid                   = 1,        ///< ThreadDescriptor.pid
+            ThreadTid                   = 2,        ///< ThreadDescriptor.tid
+            ThreadName                  = 5,        ///< ThreadDescriptor.thread_name
+            EventType                   = 9,        ///< TrackEvent.type
+            EventTrackUuid              = 11,       ///< TrackEvent.track_uuid
+            EventName                   = 23        ///< TrackEvent.name
+        };
+
+        static constexpr uint32 SliceBegin          = 1;    ///< TrackEvent.TYPE_SLICE_BEGIN
+        static constexpr uint32 SliceEnd            = 2;    ///< TrackEvent.TYPE_SLICE_END
+        static constexpr uint32 ClockMonotonic      = 3;    ///< BuiltinClock.BUILTIN_CLOCK_MONOTONIC, the clock steady_clock reads
+        static constexpr uint32 IncrementalCleared  = 1;    ///< TracePacket.SEQ_INCREMENTAL_STATE_CLEARED
+        static constexpr uint32 SequenceId          = 1;    ///< Every packet is on the same sequence
+
+        /// Append varint
+        /// @p_Out   : Output
+        /// @p_Value : Value
+        static void WriteVarint(std::string& p_Out, uint64 p_Value)
+        {
+            while (p_Value >= 0x80)
+            {
+                p_Out.push_back(static_cast<char>((p_Value & 0x7F) | 0x80));
+                p_Value >>= 7;
+            }
+
+            p_Out.push_back(static_cast<char>(p_Value));
+        }
+        /// Append varint field
+        /// @p_Out   : Output
+        /// @p_Field : Field number
+        /// @p_Value : Value
+        static void WriteUInt(std::string& p_Out, uint32 p_Field, uint64 p_Value)
+        {
+            WriteVarint(p_Out, (static_cast<uint64>(p_Field) << 3) | 0);
+            WriteVarint(p_Out, p_Value);
+        }
+        /// Append length delimited field
+        /// @p_Out   : Output
+        /// @p_Field : Field number
+        /// @p_Value : String or encoded message
+        static void WriteBytes(std::string& p_Out, uint32 p_Field, std::string_view const p_Value)
+        {
+            WriteVarint(p_Out, (static_cast<uint64>(p_Field) << 3) | 2);
+            WriteVarint(p_Out, p_Value.size());
+            p_Out.append(p_Value.data(), p_Value.size());
+        }
+
+    }   ///< namespace Proto
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    Profiler::Profiler()
+        : m_Enabled(false), m_OutputPrefix("trace"), m_OutputFormat(TraceFormat::Chrome), m_DumpRequest(false), m_CaptureRequest(0), m_CaptureStart(0), m_CaptureEnd(0)
+    {
+    }
+    /// Deconstructor
+    Profiler::~Profiler()
+    {
+        /// Rings are left alive, threads still running may record into them until they exit
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Record zone on calling thread
+    /// @p_Name  : Name of zone, must have static storage
+    /// @p_Start : Start in FastClock nanoseconds
+    /// @p_End   : End in FastClock nanoseconds
+    void Profiler::Record(std::string_view const p_Name, uint64 p_Start, uint64 p_End)
+    {
+        ProfileThread* l_Thread = GetThread();
+
+        const uint64 l_Head = l_Thread->Head.load(std::memory_order_relaxed);
+        ProfileThread::Zone& l_Zone = l_Thread->Zones[l_Head & (PROFILER_RING_SIZE - 1)];
+
+        l_Zone.Start.store(p_Start, std::memory_order_relaxed);
+        l_Zone.End.store(p_End, std::memory_order_relaxed);
+        l_Zone.Name.store(p_Name.data(), std::memory_order_relaxed);
+        l_Zone.Length.store(static_cast<uint32>(p_Name.size()), std::memory_order_relaxed);
+
+        l_Thread->Head.store(l_Head + 1, std::memory_order_release);
+    }
+    /// Parse trace format name, "chrome" or "perfetto"
+    /// @p_Name   : Name
+    /// @p_Format : Parsed format
+    bool Profiler::ParseFormat(std::string_view const p_Name, TraceFormat& p_Format)
+    {
+        if (p_Name == "chrome" || p_Name == "json")
+            p_Format = TraceFormat::Chrome;
+        else if (p_Name == "perfetto" || p_Name == "protobuf")
+            p_Format = TraceFormat::Perfetto;
+        else
+            return false;
+
+        return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Record zones all the time, dumps then hold the last PROFILER_RING_SIZE zones of every thread
+    /// @p_Enabled : Enabled
+    void Profiler::SetEnabled(bool p_Enabled)
+    {
+        std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+        m_Enabled.store(p_Enabled);
+        s_Recording.store(p_Enabled || m_CaptureStart != 0);
+    }
+    /// Set where requested dumps and captures are written
+    /// @p_Prefix : Path prefix, a timestamp and extension are appended
+    /// @p_Format : Trace format
+    void Profiler::SetOutput(std::string const& p_Prefix, TraceFormat p_Format)
+    {
+        std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+        m_OutputPrefix = p_Prefix;
+        m_OutputFormat = p_Format;
+    }
+
+    /// Request dump of what the rings hold, written on next Update, safe to call from a signal handler
+    void Profiler::RequestDump()
+    {
+        m_DumpRequest.store(true);
+    }
+    /// Request recording for a window, written on next Update once it is over, safe to call from a signal handler
+    /// @p_Milliseconds : Length of window
+    void Profiler::RequestCapture(uint32 p_Milliseconds)
+    {
+        m_CaptureRequest.store(std::max<uint32>(p_Milliseconds, 1));
+    }
+    /// Start requested captures and write finished captures and requested dumps
+    void Profiler::Update()
+    {
+        const uint64 l_Now = static_cast<uint64>(FastClock::GetNanoseconds());
+
+        std::string l_Path;
+        TraceFormat l_Format;
+        uint64 l_Since = 0;
+        bool l_Write = false;
+
+        {
+            std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+            if (m_CaptureStart == 0)
+            {
+                if (const uint32 l_Window = m_CaptureRequest.exchange(0))
+                {
+                    m_CaptureStart  = l_Now;
+                    m_CaptureEnd    = l_Now + static_cast<uint64>(l_Window) * 1000000;
+                    s_Recording.store(true);
+
+                    LOG_INFO("Profiler", "Capturing profile zones for %0 ms", l_Window);
+                }
+            }
+            else if (l_Now >= m_CaptureEnd)
+            {
+                l_Since         = m_CaptureStart;
+                l_Write         = true;
+                m_CaptureStart  = 0;
+                s_Recording.store(m_Enabled.load());
+            }
+
+            if (!l_Write && m_DumpRequest.exchange(false))
+                l_Write = true;
+
+            if (l_Write)
+            {
+                l_Path   = GetOutputPath();
+                l_Format = m_OutputFormat;
+            }
+        }
+
+        if (l_Write && Dump(l_Path, l_Format, l_Since))
+            LOG_INFO("Profiler", "Profile written to %0", l_Path);
+    }
+
+    /// Write zones of every thread to file
+    /// @p_Path   : File path
+    /// @p_Format : Trace format
+    /// @p_Since  : Only zones ending at or after this FastClock nanosecond are written
+    bool Profiler::Dump(std::string const& p_Path, TraceFormat p_Format, uint64 p_Since)
+    {
+        const std::vector<ThreadCopy> l_Threads = CopyThreads(p_Since);
+        const std::string l_Trace = p_Format == TraceFormat::Chrome ? WriteChrome(l_Threads) : WritePerfetto(l_Threads);
+
+        std::ofstream l_File(p_Path, std::ios::binary | std::ios::trunc);
+        if (!l_File.is_open())
+        {
+            LOG_ERROR("Profiler", "Could not create trace %0", p_Path);
+            return false;
+        }
+
+        l_File.write(l_Trace.data(), l_Trace.size());
+        if (!l_File.good())
+        {
+            LOG_ERROR("Profiler", "Could not write trace %0", p_Path);
+            return false;
+        }
+
+        return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get ring of calling thread, registering it on first use
+    ProfileThread* Profiler::GetThread()
+    {
+        static thread_local ProfileThreadHolder tl_Holder(GetSingleton()->AcquireThread());
+
+        return tl_Holder.Thread;
+    }
+    /// Take a ring for a new thread
+    ProfileThread* Profiler::AcquireThread()
+    {
+        std::string l_Name;
+
+#if !defined(_WIN32)
+        char l_Buffer[64] = { 0 };
+        if (pthread_getname_np(pthread_self(), l_Buffer, sizeof(l_Buffer)) == 0)
+            l_Name = l_Buffer;
+#endif
+
+        std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+        ProfileThread* l_Thread = nullptr;
+
+        /// Reuse ring of an exited thread, its zones are lost
+        for (ProfileThread* l_Existing : m_Threads)
+        {
+            if (!l_Existing->InUse.load(std::memory_order_acquire))
+            {
+                l_Thread = l_Existing;
+                break;
+            }
+        }
+
+        if (!l_Thread)
+        {
+            l_Thread        = new ProfileThread();
+            l_Thread->Id    = static_cast<uint32>(m_Threads.size() + 1);
+            m_Threads.push_back(l_Thread);
+        }
+
+        l_Thread->Name = l_Name.empty() ? Utils::StringBuilder("Thread %0", l_Thread->Id) : l_Name;
+        l_Thread->Head.store(0, std::memory_order_relaxed);
+        l_Thread->InUse.store(true, std::memory_order_release);
+
+        return l_Thread;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Copy zones of every thread which are not overwritten while copying
+    /// @p_Since : Only zones ending at or after this FastClock nanosecond are copied
+    std::vector<Profiler::ThreadCopy> Profiler::CopyThreads(uint64 p_Since)
+    {
+        std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+        std::vector<ThreadCopy> l_Copies;
+        l_Copies.reserve(m_Threads.size());
+
+        for (ProfileThread* l_Thread : m_Threads)
+        {
+            ThreadCopy l_Copy;
+            l_Copy.Id   = l_Thread->Id;
+            l_Copy.Name = l_Thread->Name;
+
+            const uint64 l_Head  = l_Thread->Head.load(std::memory_order_acquire);
+            const uint64 l_First = l_Head > PROFILER_RING_SIZE ? l_Head - PROFILER_RING_SIZE : 0;
+
+            l_Copy.Zones.reserve(static_cast<std::size_t>(l_Head - l_First));
+
+            for (uint64 l_I = l_First; l_I < l_Head; l_I++)
+            {
+                ProfileThread::Zone const& l_Zone = l_Thread->Zones[l_I & (PROFILER_RING_SIZE - 1)];
+
+                l_Copy.Zones.push_back({ l_Zone.Start.load(std::memory_order_relaxed), l_Zone.End.load(std::memory_order_relaxed),
+                    std::string_view(l_Zone.Name.load(std::memory_order_relaxed), l_Zone.Length.load(std::memory_order_relaxed)) });
+            }
+
+            /// Slots written while copying may be torn, the writer is at most one slot ahead of what it published
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const uint64 l_HeadAfter = l_Thread->Head.load(std::memory_order_relaxed);
+            const uint64 l_Valid     = l_HeadAfter + 1 > PROFILER_RING_SIZE ? l_HeadAfter + 1 - PROFILER_RING_SIZE : 0;
+
+            if (l_Valid > l_First)
+                l_Copy.Zones.erase(l_Copy.Zones.begin(), l_Copy.Zones.begin() + static_cast<std::ptrdiff_t>(std::min(l_Valid - l_First, l_Head - l_First)));
+
+            l_Copy.Zones.erase(std::remove_if(l_Copy.Zones.begin(), l_Copy.Zones.end(), [p_Since](ZoneCopy const& p_Zone) { return p_Zone.End < p_Since; }), l_Copy.Zones.end());
+
+            if (l_Copy.Zones.empty())
+                continue;
+
+            /// Zones are recorded when they end, so enclosed zones come before the zone enclosing them
+            std::sort(l_Copy.Zones.begin(), l_Copy.Zones.end(),
+                [](ZoneCopy const& p_Left, ZoneCopy const& p_Right)
+                {
+                    return p_Left.Start != p_Right.Start ? p_Left.Start < p_Right.Start : p_Left.End > p_Right.End;
+                });
+
+            l_Copies.push_back(std::move(l_Copy));
+        }
+
+        return l_Copies;
+    }
+    /// Write zones as Chrome trace event JSON
+    /// @p_Threads : Copied threads
+    std::string Profiler::WriteChrome(std::vector<ThreadCopy> const& p_Threads)
+    {
+        std::string l_Out;
+        l_Out.reserve(256 + p_Threads.size() * PROFILER_RING_SIZE * 16);
+
+        /// Names are written between quotes
+        const auto l_AppendString = [&l_Out](std::string_view const p_String)
+        {
+            l_Out.push_back('"');
+
+            for (const char l_Char : p_String)
+            {
+                if (l_Char == '"' || l_Char == '\\')
+                {
+                    l_Out.push_back('\\');
+                    l_Out.push_back(l_Char);
+                }
+                else if (static_cast<unsigned char>(l_Char) < 0x20)
+                    l_Out.push_back(' ');
+                else
+                    l_Out.push_back(l_Char);
+            }
+
+            l_Out.push_back('"');
+        };
+        /// Timestamps are in microseconds, nanoseconds are kept as decimals
+        const auto l_AppendMicroseconds = [&l_Out](uint64 p_Nanoseconds)
+        {
+            char l_Buffer[32];
+            snprintf(l_Buffer, sizeof(l_Buffer), "%llu.%03u", static_cast<unsigned long long>(p_Nanoseconds / 1000), static_cast<uint32>(p_Nanoseconds % 1000));
+            l_Out.append(l_Buffer);
+        };
+
+        l_Out.append("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+
+        bool l_First = true;
+        for (ThreadCopy const& l_Thread : p_Threads)
+        {
+            const std::string l_Ids = Utils::StringBuilder("\"pid\":%0,\"tid\":%1", PROFILER_PROCESS_ID, l_Thread.Id);
+
+            l_Out.append(l_First ? "\n" : ",\n");
+            l_First = false;
+
+            l_Out.append("{\"ph\":\"M\",\"name\":\"thread_name\",").append(l_Ids).append(",\"args\":{\"name\":");
+            l_AppendString(l_Thread.Name);
+            l_Out.append("}}");
+
+            for (ZoneCopy const& l_Zone : l_Thread.Zones)
+            {
+                l_Out.append(",\n{\"ph\":\"X\",\"name\":");
+                l_AppendString(l_Zone.Name);
+                l_Out.append(",").append(l_Ids).append(",\"ts\":");
+                l_AppendMicroseconds(l_Zone.Start);
+                l_Out.append(",\"dur\":");
+                l_AppendMicroseconds(l_Zone.End - l_Zone.Start);
+                l_Out.append("}");
+            }
+        }
+
+        l_Out.append("\n]}\n");
+
+        return l_Out;
+    }
+    /// Write zones as Perfetto protobuf
+    /// @p_Threads : Copied threads
+    std::string Profiler::WritePerfetto(std::vector<ThreadCopy> const& p_Threads)
+    {
+        std::string l_Out;
+        std::string l_Packet;
+        std::string l_Message;
+        std::string l_Nested;
+
+        /// Process track
+        const uint64 l_ProcessUuid = PROFILER_PROCESS_ID;
+
+        Proto::WriteUInt(l_Nested, Proto::ProcessPid, PROFILER_PROCESS_ID);
+        Proto::WriteBytes(l_Nested, Proto::ProcessName, "SteerStone");
+        Proto::WriteUInt(l_Message, Proto::TrackUuid, l_ProcessUuid);
+        Proto::WriteBytes(l_Message, Proto::TrackProcess, l_Nested);
+        Proto::WriteBytes(l_Packet, Proto::PacketTrackDescriptor, l_Message);
+        Proto::WriteUInt(l_Packet, Proto::PacketSequenceId, Proto::SequenceId);
+        Proto::WriteUInt(l_Packet, Proto::PacketSequenceFlags, Proto::IncrementalCleared);
+        Proto::WriteBytes(l_Out, Proto::TracePacket, l_Packet);
+
+        for (ThreadCopy const& l_Thread : p_Threads)
+        {
+            const uint64 l_ThreadUuid = (l_ProcessUuid << 32) | l_Thread.Id;
+
+            /// Thread track
+            l_Packet.clear();
+            l_Message.clear();
+            l_Nested.clear();
+
+            Proto::WriteUInt(l_Nested, Proto::ThreadPid, PROFILER_PROCESS_ID);
+            Proto::WriteUInt(l_Nested, Proto::ThreadTid, l_Thread.Id);
+            Proto::WriteBytes(l_Nested, Proto::ThreadName, l_Thread.Name);
+            Proto::WriteUInt(l_Message, Proto::TrackUuid, l_ThreadUuid);
+            Proto::WriteBytes(l_Message, Proto::TrackName, l_Thread.Name);
+            Proto::WriteBytes(l_Message, Proto::TrackThread, l_Nested);
+            Proto::WriteUInt(l_Message, Proto::TrackParentUuid, l_ProcessUuid);
+            Proto::WriteBytes(l_Packet, Proto::PacketTrackDescriptor, l_Message);
+            Proto::WriteUInt(l_Packet, Proto::PacketSequenceId, Proto::SequenceId);
+            Proto::WriteBytes(l_Out, Proto::TracePacket, l_Packet);
+
+            /// Slice events must be in time order on a track, enclosing zones end after what they enclose
+            const auto l_WriteEvent = [&](uint64 p_Timestamp, uint32 p_Type, std::string_view const p_Name)
+            {
+                l_Packet.clear();
+                l_Message.clear();
+
+                Proto::WriteUInt(l_Message, Proto::EventType, p_Type);
+                Proto::WriteUInt(l_Message, Proto::EventTrackUuid, l_ThreadUuid);
+                if (p_Type == Proto::SliceBegin)
+                    Proto::WriteBytes(l_Message, Proto::EventName, p_Name);
+
+                Proto::WriteUInt(l_Packet, Proto::PacketTimestamp, p_Timestamp);
+                Proto::WriteUInt(l_Packet, Proto::PacketTimestampClock, Proto::ClockMonotonic);
+                Proto::WriteBytes(l_Packet, Proto::PacketTrackEvent, l_Message);
+                Proto::WriteUInt(l_Packet, Proto::PacketSequenceId, Proto::SequenceId);
+                Proto::WriteBytes(l_Out, Proto::TracePacket, l_Packet);
+            };
+
+            std::vector<uint64> l_Open;
+
+            for (ZoneCopy const& l_Zone : l_Thread.Zones)
+            {
+                while (!l_Open.empty() && l_Open.back() <= l_Zone.Start)
+                {
+                    l_WriteEvent(l_Open.back(), Proto::SliceEnd, std::string_view());
+                    l_Open.pop_back();
+                }
+
+                l_WriteEvent(l_Zone.Start, Proto::SliceBegin, l_Zone.Name);
+                l_Open.push_back(l_Zone.End);
+            }
+
+            while (!l_Open.empty())
+            {
+                l_WriteEvent(l_Open.back(), Proto::SliceEnd, std::string_view());
+                l_Open.pop_back();
+            }
+        }
+
+        return l_Out;
+    }
+
+    /// Get path of the next requested dump
+    std::string Profiler::GetOutputPath() const
+    {
+        return Utils::StringBuilder("%0_%1.%2", m_OutputPrefix, static_cast<uint64>(std::time(nullptr)), m_OutputFormat == TraceFormat::Chrome ? "json" : "perfetto-trace");
+    }
+
+}   ///< namespace Diagnostic
+}   ///< namespace Core
+}   ///< namespace SteerStone
@@ -0,0 +1,214 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <PCH/Precompiled.hpp>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Core/Core.hpp"
+#include "Singleton/Singleton.hpp"
+#include "DiaFastClock.hpp"
+
+#define PROFILER_RING_SIZE          8192        ///< Zones kept per thread, must be a power of two, older zones are overwritten
+#define PROFILER_PROCESS_ID         1           ///< Process id written to traces
+
+namespace SteerStone { namespace Core { namespace Diagnostic {
+
+    /// Trace file formats
+    enum class TraceFormat
+    {
+        Chrome,             ///< Chrome trace event JSON (chrome://tracing, ui.perfetto.dev)
+        Perfetto            ///< Perfetto protobuf trace (ui.perfetto.dev, trace_processor)
+    };
+
+    /// Ring of zones recorded by one thread
+    /// Only the owning thread writes, dumps read it from any thread and drop the zones overwritten while reading
+    struct ProfileThread
+    {
+        /// Recorded zone, fields are atomics so dumps may read a slot which is being written
+        struct Zone
+        {
+            std::atomic<uint64> Start;              ///< Start in FastClock nanoseconds
+            std::atomic<uint64> End;                ///< End in FastClock nanoseconds
+            std::atomic<char const*> Name;          ///< Name, has static storage
+            std::atomic<uint32> Length;             ///< Length of name
+        };
+
+        uint32 Id;                                  ///< Id written to traces as thread id
+        std::string Name;                           ///< Name of thread when it registered
+        std::atomic<bool> InUse;                    ///< Thread is alive, ring is reused once it exited
+        std::atomic<uint64> Head;                   ///< Amount of zones written
+        Zone Zones[PROFILER_RING_SIZE];             ///< Ring
+    };
+
+    /// Collects profile zones of every thread and writes them as traces
+    /// Recording is off unless enabled or a capture window is running, a zone then costs two clock reads and a ring store
+    class Profiler
+    {
+        SINGLETON_P_D(Profiler);
+
+        public:
+            /// Are zones being recorded
+            static bool IsRecording()
+            {
+                return s_Recording.load(std::memory_order_relaxed);
+            }
+            /// Record zone on calling thread
+            /// @p_Name  : Name of zone, must have static storage
+            /// @p_Start : Start in FastClock nanoseconds
+            /// @p_End   : End in FastClock nanoseconds
+            static void Record(std::string_view const p_Name, uint64 p_Start, uint64 p_End);
+            /// Record zone on calling thread which ends now, such as time spent in a queue
+            /// @p_Name     : Name of zone, must have static storage
+            /// @p_Duration : Duration in nanoseconds
+            static void RecordElapsed(std::string_view const p_Name, uint64 p_Duration)
+            {
+                if (!IsRecording())
+                    return;
+
+                const uint64 l_Now = static_cast<uint64>(FastClock::GetNanoseconds());
+                Record(p_Name, l_Now - std::min(p_Duration, l_Now - 1), l_Now);
+            }
+
+            /// Parse trace format name, "chrome" or "perfetto"
+            /// @p_Name   : Name
+            /// @p_Format : Parsed format
+            static bool ParseFormat(std::string_view const p_Name, TraceFormat& p_Format);
+
+        public:
+            /// Record zones all the time, dumps then hold the last PROFILER_RING_SIZE zones of every thread
+            /// @p_Enabled : Enabled
+            void SetEnabled(bool p_Enabled);
+            /// Set where requested dumps and captures are written
+            /// @p_Prefix : Path prefix, a timestamp and extension are appended
+            /// @p_Format : Trace format
+            void SetOutput(std::string const& p_Prefix, TraceFormat p_Format);
+
+            /// Request dump of what the rings hold, written on next Update, safe to call from a signal handler
+            void RequestDump();
+            /// Request recording for a window, written on next Update once it is over, safe to call from a signal handler
+            /// @p_Milliseconds : Length of window
+            void RequestCapture(uint32 p_Milliseconds);
+            /// Start requested captures and write finished captures and requested dumps
+            void Update();
+
+            /// Write zones of every thread to file
+            /// @p_Path   : File path
+            /// @p_Format : Trace format
+            /// @p_Since  : Only zones ending at or after this FastClock nanosecond are written
+            bool Dump(std::string const& p_Path, TraceFormat p_Format, uint64 p_Since = 0);
+
+        private:
+            /// Copied zone
+            struct ZoneCopy
+            {
+                uint64 Start;                       ///< Start in FastClock nanoseconds
+                uint64 End;                         ///< End in FastClock nanoseconds
+                std::string_view Name;              ///< Name
+            };
+            /// Copied ring of a thread
+            struct ThreadCopy
+            {
+                uint32 Id;                          ///< Id of thread
+                std::string Name;                   ///< Name of thread
+                std::vector<ZoneCopy> Zones;        ///< Zones sorted by start, enclosing zones first
+            };
+
+            /// Get ring of calling thread, registering it on first use
+            static ProfileThread* GetThread();
+            /// Take a ring for a new thread
+            ProfileThread* AcquireThread();
+
+            /// Copy zones of every thread which are not overwritten while copying
+            /// @p_Since : Only zones ending at or after this FastClock nanosecond are copied
+            std::vector<ThreadCopy> CopyThreads(uint64 p_Since);
+            /// Write zones as Chrome trace event JSON
+            /// @p_Threads : Copied threads
+            static std::string WriteChrome(std::vector<ThreadCopy> const& p_Threads);
+            /// Write zones as Perfetto protobuf
+            /// @p_Threads : Copied threads
+            static std::string WritePerfetto(std::vector<ThreadCopy> const& p_Threads);
+
+            /// Get path of the next requested dump
+            std::string GetOutputPath() const;
+
+        private:
+            static std::atomic<bool> s_Recording;           ///< Zones are recorded
+
+            std::mutex m_Mutex;                             ///< Guards threads and output settings
+            std::vector<ProfileThread*> m_Threads;          ///< Rings, never freed so zones of exited threads can be dumped
+            std::atomic<bool> m_Enabled;                    ///< Record all the time
+            std::string m_OutputPrefix;                     ///< Path prefix of requested dumps
+            TraceFormat m_OutputFormat;                     ///< Format of requested dumps
+            std::atomic<bool> m_DumpRequest;                ///< Dump requested
+            std::atomic<uint32> m_CaptureRequest;           ///< Length of requested capture window, 0 if none
+            uint64 m_CaptureStart;                          ///< Start of running capture, 0 if none
+            uint64 m_CaptureEnd;                            ///< End of running capture
+    };
+
+    /// Records a zone from construction to destruction, does nothing if the profiler is not recording
+    class ProfileZone
+    {
+        DISALLOW_COPY_AND_ASSIGN(ProfileZone);
+
+        public:
+            /// Constructor
+            /// @p_Name : Name of zone, must have static storage
+            explicit ProfileZone(std::string_view const p_Name)
+                : m_Start(0)
+            {
+                if (Profiler::IsRecording())
+                {
+                    m_Name  = p_Name;
+                    m_Start = static_cast<uint64>(FastClock::GetNanoseconds());
+                }
+            }
+            /// Deconstructor
+            ~ProfileZone()
+            {
+                if (m_Start != 0)
+                    Profiler::Record(m_Name, m_Start, static_cast<uint64>(FastClock::GetNanoseconds()));
+            }
+
+        private:
+            std::string_view m_Name;                ///< Name of zone
+            uint64 m_Start;                         ///< Start, 0 if not recording
+    };
+
+}   ///< namespace Diagnostic
+}   ///< namespace Core
+}   ///< namespace SteerStone
+
+#define sProfiler SteerStone::Core::Diagnostic::Profiler::GetSingleton()
+
+/// Profile zones are compiled out unless WITH_PROFILER is set
+#ifdef STEERSTONE_PROFILER
+#   define PROFILE_ZONE_VARIABLE_(p_Line)   l_ProfileZone##p_Line
+#   define PROFILE_ZONE_VARIABLE(p_Line)    PROFILE_ZONE_VARIABLE_(p_Line)
+#   define PROFILE_ZONE(p_Name)             ::SteerStone::Core::Diagnostic::ProfileZone PROFILE_ZONE_VARIABLE(__LINE__)(p_Name)
+#   define PROFILE_ELAPSED(p_Name, p_Ns)    ::SteerStone::Core::Diagnostic::Profiler::RecordElapsed(p_Name, p_Ns)
+#else
+#   define PROFILE_ZONE(p_Name)             ((void)0)
+#   define PROFILE_ELAPSED(p_Name, p_Ns)    ((void)0)
+#endif
@@ -24,7 +24,7 @@ namespace SteerStone { namespace Core { namespace Diagnostic {
 
     /// Constructor
     StopWatch::StopWatch()
-        : m_Start(std::chrono::steady_clock::now())
+        : m_Start(FastClock::now())
     {
         m_Elapsed = 0;
         m_Running = true;
@@ -37,18 +37,18 @@ namespace SteerStone { namespace Core { namespace Diagnostic {
     /// Reset
     void StopWatch::Reset()
     {
-        m_Start = std::chrono::steady_clock::now();
+        m_Start = FastClock::now();
     }
     /// Start
     void StopWatch::Start()
     {
         m_Running   = true;
-        m_Start     = std::chrono::steady_clock::now();
+        m_Start     = FastClock::now();
     }
     /// Stop
     void StopWatch::Stop()
     {
-        TimeStamp l_Stop = std::chrono::steady_clock::now();
+        TimeStamp l_Stop = FastClock::now();
 
         m_Running = false;
         m_Elapsed = static_cast<int64>(std::chrono::duration_cast<std::chrono::milliseconds>(l_Stop - m_Start).count());
@@ -62,7 +62,7 @@ namespace SteerStone { namespace Core { namespace Diagnostic {
     {
         if (m_Running)
         {
-            auto l_CurrentClock = std::chrono::steady_clock::now();
+            auto l_CurrentClock = FastClock::now();
             return static_cast<int64>(std::chrono::duration_cast<std::chrono::milliseconds>(l_CurrentClock - m_Start).count());
         }
 
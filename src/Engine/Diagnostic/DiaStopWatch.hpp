@@ -19,6 +19,7 @@
 #pragma once
 
 #include "Core/Core.hpp"
+#include "DiaFastClock.hpp"
 
 #include <chrono>
 
@@ -27,7 +28,7 @@ namespace SteerStone { namespace Core { namespace Diagnostic {
     /// Time measuring tools
     class StopWatch
     {
-        using TimeStamp = std::chrono::time_point<std::chrono::high_resolution_clock>;
+        using TimeStamp = FastClock::time_point;
 
         public:
             /// Constructor
@@ -17,8 +17,12 @@
 */
 
 #include <Precompiled.hpp>
+#include <algorithm>
+#include <chrono>
 
 #include "Base.hpp"
+#include "Utility/UtiTokenizer.hpp"
+#include "Diagnostic/DiaFlightRecorder.hpp"
 
 #ifdef _WIN32
 #   include <windows.h>
@@ -28,6 +32,8 @@
 #   define COLOR_RED   FOREGROUND_RED                                               | FOREGROUND_INTENSITY
 #   define COLOR_RGB   FOREGROUND_RED   | FOREGROUND_GREEN      | FOREGROUND_BLUE
 #   define SET_COLOR(p_Color) SetConsoleTextAttribute(GetStdHandle(STD_OUTPUT_HANDLE), p_Color);
+    /// Console attributes are not part of the stream, write what is batched before switching
+#   define APPEND_COLOR(p_Batch, p_Color) { std::clog << p_Batch; p_Batch.clear(); SET_COLOR(p_Color); }
 #else
 #   define COLOR_BASE   39
 #   define COLOR_GREEN  32
@@ -35,25 +41,48 @@
 #   define COLOR_RED    31
 #   define COLOR_RGB    39
 #   define SET_COLOR(p_Color) std::cout << "\033[" << p_Color << "m" << std::flush;
+#   define APPEND_COLOR(p_Batch, p_Color) { p_Batch += "\033["; p_Batch += std::to_string(p_Color); p_Batch += "m"; }
 #endif
 #define GET_COLOR(Mode) ((Mode) == LogType::Assert ? COLOR_RED : (Mode) == LogType::Error ? COLOR_RED : ((Mode) == LogType::Warning ? COLOR_BLUE : ((Mode) == LogType::Info ? COLOR_GREEN : COLOR_BASE)))
 
 namespace SteerStone  { namespace Core { namespace Logger {
 
     SINGLETON_P_I(Base)
+
+    std::atomic<int32>  Base::m_EnabledLevel(static_cast<int32>(LogType::Verbose));
+    std::atomic<bool>   Base::m_HasSystemLevels(false);
     
     //////////////////////////////////////////////////////////////////////////
     //////////////////////////////////////////////////////////////////////////
 
     /// Constructor
     Base::Base() 
-        : m_LogLevel(LogType::Verbose), m_LogTime(true), m_LogThreadId(true), m_LogFunction(true)
+        : m_LogLevel(LogType::Verbose), m_LogTime(true), m_LogThreadId(true), m_LogFunction(true), m_LogConsole(true), m_TimeCacheSecond(-1),
+        m_Async(false), m_Overflow(LogOverflow::Drop), m_BufferSize(LOG_ASYNC_BUFFER_SIZE), m_Dropped(0), m_DroppedReported(0), m_Stopping(false)
     {
+        m_AnchorSteady = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        m_AnchorSystem = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
     }
 
     /// Deconstructor
     Base::~Base() 
     {
+        if (m_Writer.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> l_Guard(m_WriterMutex);
+                m_Stopping.store(true);
+            }
+
+            m_WriterCondition.notify_one();
+            m_Writer.join();
+
+            m_Async.store(false);
+        }
+
+        /// Messages reported while the writer was exiting
+        Flush();
+
         RemoveAllAppenders();
     }
 
@@ -66,59 +95,82 @@ namespace SteerStone  { namespace Core { namespace Logger {
     /// @p_Function     : Function name of caller
     /// @p_FunctionLine : Function line of caller
     /// @p_Message      : Message to report
-    void Base::Report(LogType p_LogType, std::string const& p_System, std::string_view const p_Function, int32 const p_FunctionLine, std::string const& p_Message)
+    void Base::Report(LogType p_LogType, std::string_view const p_System, std::string_view const p_Function, int32 const p_FunctionLine, std::string const& p_Message)
     {
-        if (p_LogType > m_LogLevel)
+        const Utils::Symbol l_System = Utils::Intern(p_System);
+
+        if (p_LogType != LogType::Assert && !IsEnabled(p_LogType, l_System))
             return;
 
-        std::lock_guard<std::recursive_mutex> l_Lock(m_Mutex);
+        LogRecord l_Record;
+        l_Record.Type       = p_LogType;
+        l_Record.System     = l_System;
+        l_Record.Function   = p_Function;
+        l_Record.Line       = p_FunctionLine;
+        l_Record.Message    = p_Message;
 
-        if (p_LogType == LogType::Assert)
+        ReportRecord(std::move(l_Record));
+    }
+    /// Report a captured message
+    /// @p_Record : Record of message, time and thread are filled in
+    void Base::ReportRecord(LogRecord&& p_Record)
+    {
+        if (p_Record.Type == LogType::Assert)
         {
-            ReportAssert(p_System, p_Function, p_FunctionLine, p_Message);
+            std::lock_guard<std::recursive_mutex> l_Lock(m_Mutex);
+
+            if (p_Record.Format)
+                p_Record.Arguments.Format(*p_Record.Format, p_Record.Message);
+
+            /// Buffered messages lead up to the assert, write them before crashing
+            DrainBuffers();
+            ReportAssert(Utils::GetSymbolString(p_Record.System), p_Record.Function, p_Record.Line, p_Record.Message);
             return;
         }
 
-        /// Constant always true variables
-        const std::string l_Time      = GetServerTime();
-        const std::string l_System    = "[" + p_System + "]";
-        const std::string l_Message   = " << " + p_Message;
-        const std::string l_LogLevel  = (p_LogType == LogType::Verbose ? "[VERBOSE]" : (p_LogType == LogType::Error) ? "[ERROR]"
-                                       : p_LogType == LogType::Warning ? "[WARNING]" : "[INFO]");
+        /// Thread id is a syscall on some platforms
+        thread_local const uint64 tl_ThreadId = Utils::GetThreadId();
 
-        /// Message Output
-        {
-            SET_COLOR(COLOR_BASE);
+        p_Record.ThreadId   = tl_ThreadId;
+        p_Record.Timestamp  = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
 
-            if (m_LogTime)
-                std::clog << l_Time + " | ";
+        if (m_Async.load(std::memory_order_acquire))
+        {
+            LogBuffer* l_Buffer = GetThreadBuffer();
 
-            if (m_LogThreadId)
-                std::clog << "Thread Id: " << Utils::GetThreadId() << " | ";
+            if (m_Overflow == LogOverflow::Block)
+            {
+                l_Buffer->Push(std::move(p_Record));
+                return;
+            }
 
-            if (m_LogFunction)
-                std::clog << p_Function << "::" << p_FunctionLine << " | ";
+            if (!l_Buffer->TryPush(std::move(p_Record)))
+                m_Dropped.fetch_add(1, std::memory_order_relaxed);
 
-            SET_COLOR(GET_COLOR(p_LogType));
-            std::clog << l_LogLevel;
-            std::clog << l_System;
-            std::clog << l_Message << std::endl;
-            SET_COLOR(COLOR_RGB);
+            return;
         }
 
+        std::lock_guard<std::recursive_mutex> l_Lock(m_Mutex);
+
+        std::string l_Batch;
+        OutputRecord(p_Record, l_Batch);
+
+        if (!l_Batch.empty())
+            std::clog << l_Batch << std::flush;
+
         for (auto l_Appender : m_Appenders)
-            l_Appender->OnReport(this, l_Time, p_LogType, p_System, p_Message);
+            l_Appender->OnFlush();
     }
     /// Report assert message
     /// @p_System       : Message sender
     /// @p_Function     : Function name of caller
     /// @p_FunctionLine : Function line of caller
     /// @p_Message      : Message to report
-    void Base::ReportAssert(std::string const& p_System, std::string_view const p_Function, int32 const p_FunctionLine, std::string const& p_Message)
+    void Base::ReportAssert(std::string_view const p_System, std::string_view const p_Function, int32 const p_FunctionLine, std::string const& p_Message)
     {
         /// Constant always true variables
         const std::string l_Time = GetServerTime();
-        const std::string l_System = "[" + p_System + "]";
+        const std::string l_System = "[" + std::string(p_System) + "]";
         const std::string l_Message = " << " + p_Message;
 
         /// Message Output
@@ -141,6 +193,10 @@ namespace SteerStone  { namespace Core { namespace Logger {
             SET_COLOR(COLOR_RGB);
         }
 
+        /// Last events of every thread, the crash below does not dump again
+        if (Diagnostic::FlightRecorder::Dump("Assert " + l_System + " " + std::string(p_Function) + "::" + std::to_string(p_FunctionLine) + l_Message))
+            std::clog << "Flight recorder written to " << Diagnostic::FlightRecorder::GetDumpPath() << std::endl;
+
         /// Crash
         *((volatile int*)nullptr) = 0;
         exit(1);
@@ -182,6 +238,108 @@ namespace SteerStone  { namespace Core { namespace Logger {
     {
         m_LogFunction = p_Enabler;
     }
+    /// Enable/Disable console output, appenders still get every message
+    /// @p_Enabler  : Enable/Disable output to console
+    void Base::LogConsoleEnabler(bool const p_Enabler)
+    {
+        m_LogConsole = p_Enabler;
+    }
+
+    /// Get a steady clock and a wall clock reading taken at the same time, record timestamps are on the steady clock
+    /// @p_Steady : Steady clock nanoseconds
+    /// @p_System : Wall clock nanoseconds since epoch
+    void Base::GetClockAnchor(uint64& p_Steady, uint64& p_System) const
+    {
+        p_Steady = m_AnchorSteady;
+        p_System = m_AnchorSystem;
+    }
+
+    /// Set level of messages to report
+    /// @p_Level : New log level
+    void Base::SetLogLevel(LogType p_Level)
+    {
+        SetLogMode(p_Level);
+    }
+    /// Set level of messages to report for a system, overrides the log level
+    /// @p_System : Message sender
+    /// @p_Level  : New log level of system
+    void Base::SetSystemLogLevel(std::string const& p_System, LogType p_Level)
+    {
+        std::lock_guard<std::recursive_mutex> l_Lock(m_Mutex);
+        {
+            std::unique_lock<std::shared_mutex> l_Guard(m_SystemLevelMutex);
+            m_SystemLevels[Utils::Intern(p_System)] = p_Level;
+        }
+
+        UpdateEnabledLevel();
+    }
+    /// Set levels from configuration
+    /// @p_Level        : Log level name, "info", "warning", "error" or "verbose"
+    /// @p_SystemLevels : Comma separated system=level pairs
+    void Base::SetLogLevels(std::string const& p_Level, std::string const& p_SystemLevels)
+    {
+        static auto const sl_ParseLevel = [](std::string p_Name, LogType& p_Level) -> bool
+        {
+            std::transform(p_Name.begin(), p_Name.end(), p_Name.begin(), [](unsigned char p_Char) { return static_cast<char>(std::tolower(p_Char)); });
+
+            if (p_Name == "info")           p_Level = LogType::Info;
+            else if (p_Name == "warning")   p_Level = LogType::Warning;
+            else if (p_Name == "error")     p_Level = LogType::Error;
+            else if (p_Name == "verbose")   p_Level = LogType::Verbose;
+            else
+                return false;
+
+            return true;
+        };
+
+        LogType l_Level;
+        if (sl_ParseLevel(p_Level, l_Level))
+            SetLogLevel(l_Level);
+        else
+            LOG_WARNING("Logger", "Unknown log level \"%0\", keeping current level", p_Level);
+
+        for (std::string_view const l_Pair : Utils::Split(p_SystemLevels, ","))
+        {
+            std::string_view l_System;
+            std::string_view l_SystemLevel;
+
+            if (!Utils::SplitPair(l_Pair, "=", l_System, l_SystemLevel) || !sl_ParseLevel(std::string(Utils::Trim(l_SystemLevel)), l_Level))
+            {
+                LOG_WARNING("Logger", "Invalid system log level \"%0\", expected system=level", l_Pair);
+                continue;
+            }
+
+            SetSystemLogLevel(std::string(Utils::Trim(l_System)), l_Level);
+        }
+    }
+
+    /// Report messages through per thread buffers drained by a writer thread
+    /// @p_BufferSize : Records each thread can buffer
+    /// @p_Overflow   : What a thread does when its buffer is full
+    void Base::EnableAsync(uint32 const p_BufferSize, LogOverflow const p_Overflow)
+    {
+        if (m_Async.load())
+            return;
+
+        m_BufferSize = std::max<uint32>(p_BufferSize, 2);
+        m_Overflow   = p_Overflow;
+
+        m_Writer = std::thread(&Base::WriterLoop, this);
+        m_Async.store(true, std::memory_order_release);
+
+        LOG_INFO("Logger", "Asynchronous logging enabled, %0 records per thread, %1 on overflow", m_BufferSize, p_Overflow == LogOverflow::Block ? "block" : "drop");
+    }
+    /// Write all buffered messages now
+    void Base::Flush()
+    {
+        std::lock_guard<std::recursive_mutex> l_Lock(m_Mutex);
+        DrainBuffers();
+    }
+    /// Get amount of messages dropped because a buffer was full
+    uint64 Base::GetDroppedCount() const
+    {
+        return m_Dropped.load(std::memory_order_relaxed);
+    }
 
     //////////////////////////////////////////////////////////////////////////
     //////////////////////////////////////////////////////////////////////////
@@ -192,6 +350,30 @@ namespace SteerStone  { namespace Core { namespace Logger {
     {
         std::lock_guard<std::recursive_mutex> l_Lock(m_Mutex);
         m_LogLevel = p_Level;
+
+        UpdateEnabledLevel();
+    }
+    /// Check level of a system which has its own level
+    /// @p_Type   : Log type
+    /// @p_System : Message sender
+    bool Base::IsSystemEnabled(LogType p_Type, Utils::Symbol const p_System)
+    {
+        std::shared_lock<std::shared_mutex> l_Guard(m_SystemLevelMutex);
+
+        auto const l_Itr = m_SystemLevels.find(p_System);
+        return p_Type <= (l_Itr != m_SystemLevels.end() ? l_Itr->second : m_LogLevel);
+    }
+    /// Recompute highest level any system reports
+    void Base::UpdateEnabledLevel()
+    {
+        std::shared_lock<std::shared_mutex> l_Guard(m_SystemLevelMutex);
+
+        LogType l_Level = m_LogLevel;
+        for (auto const& l_Itr : m_SystemLevels)
+            l_Level = std::max(l_Level, l_Itr.second);
+
+        m_EnabledLevel.store(static_cast<int32>(l_Level), std::memory_order_relaxed);
+        m_HasSystemLevels.store(!m_SystemLevels.empty(), std::memory_order_relaxed);
     }
 
     //////////////////////////////////////////////////////////////////////////
@@ -216,6 +398,27 @@ namespace SteerStone  { namespace Core { namespace Logger {
 
         return l_Time;
     }
+    /// Return wall clock time of a record timestamp, valid until the next call
+    /// @p_Timestamp : Steady clock nanoseconds
+    std::string const& Base::GetRecordTime(uint64 const p_Timestamp)
+    {
+        const int64 l_Second = static_cast<int64>((m_AnchorSystem + (p_Timestamp - m_AnchorSteady)) / 1000000000ull);
+
+        /// Records of a batch mostly share the same second
+        if (l_Second != m_TimeCacheSecond)
+        {
+            time_t l_RawTime = static_cast<time_t>(l_Second);
+            struct tm* l_TimeInfo = localtime(&l_RawTime);
+
+            char l_Time[14];
+            sprintf_s(l_Time, "%02d:%02d:%02d", l_TimeInfo->tm_hour, l_TimeInfo->tm_min, l_TimeInfo->tm_sec);
+
+            m_TimeCache         = l_Time;
+            m_TimeCacheSecond   = l_Second;
+        }
+
+        return m_TimeCache;
+    }
 
     //////////////////////////////////////////////////////////////////////////
     //////////////////////////////////////////////////////////////////////////
@@ -239,6 +442,174 @@ namespace SteerStone  { namespace Core { namespace Logger {
         m_Appenders.clear();
     }
 
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get buffer of calling thread, registered on first use
+    LogBuffer* Base::GetThreadBuffer()
+    {
+        /// Writer keeps its own reference, records of an exited thread are still written
+        thread_local std::shared_ptr<LogBuffer> tl_Buffer;
+
+        if (!tl_Buffer)
+        {
+            tl_Buffer = std::make_shared<LogBuffer>(m_BufferSize);
+
+            std::lock_guard<std::mutex> l_Guard(m_BufferMutex);
+            m_Buffers.push_back(tl_Buffer);
+        }
+
+        return tl_Buffer.get();
+    }
+    /// Write records of all buffers
+    /// Returns amount of written records
+    std::size_t Base::DrainBuffers()
+    {
+        std::vector<std::shared_ptr<LogBuffer>> l_Buffers;
+        {
+            std::lock_guard<std::mutex> l_Guard(m_BufferMutex);
+            l_Buffers = m_Buffers;
+        }
+
+        std::string l_Batch;
+        std::size_t l_Written = 0;
+        LogRecord l_Records[LOG_ASYNC_BATCH_SIZE];
+
+        for (auto const& l_Buffer : l_Buffers)
+        {
+            while (const std::size_t l_Count = l_Buffer->TryPopBatch(l_Records, LOG_ASYNC_BATCH_SIZE))
+            {
+                for (std::size_t l_I = 0; l_I < l_Count; l_I++)
+                    OutputRecord(l_Records[l_I], l_Batch);
+
+                l_Written += l_Count;
+            }
+        }
+
+        const uint64 l_Dropped = m_Dropped.load(std::memory_order_relaxed);
+        if (l_Dropped != m_DroppedReported)
+        {
+            static const Utils::Symbol sl_LoggerSystem = Utils::Intern("Logger");
+
+            LogRecord l_Record;
+            l_Record.Type       = LogType::Warning;
+            l_Record.System     = sl_LoggerSystem;
+            l_Record.Function   = LOG_GET_FUNCTION();
+            l_Record.Line       = LOG_GET_FUNCTION_LINE();
+            l_Record.ThreadId   = Utils::GetThreadId();
+            l_Record.Timestamp  = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+            l_Record.Message    = Utils::StringBuilder("Dropped %0 messages, log buffers were full", l_Dropped - m_DroppedReported);
+
+            OutputRecord(l_Record, l_Batch);
+            m_DroppedReported = l_Dropped;
+            l_Written++;
+        }
+
+        if (!l_Written)
+            return 0;
+
+        if (!l_Batch.empty())
+            std::clog << l_Batch << std::flush;
+
+        for (auto l_Appender : m_Appenders)
+            l_Appender->OnFlush();
+
+        {
+            /// Forget buffers of exited threads once they are drained
+            std::lock_guard<std::mutex> l_Guard(m_BufferMutex);
+
+            m_Buffers.erase(std::remove_if(m_Buffers.begin(), m_Buffers.end(), [](std::shared_ptr<LogBuffer> const& p_Buffer)
+            {
+                return p_Buffer.use_count() == 1 && p_Buffer->GetSize() == 0;
+            }), m_Buffers.end());
+        }
+
+        return l_Written;
+    }
+    /// Output a record to console batch and appenders
+    /// @p_Record : Record to output
+    /// @p_Batch  : Console output
+    void Base::OutputRecord(LogRecord const& p_Record, std::string& p_Batch)
+    {
+        bool l_NeedText = m_LogConsole;
+
+        for (auto l_Appender : m_Appenders)
+        {
+            if (l_Appender->IsBinary())
+                l_Appender->OnRecord(this, p_Record);
+            else
+                l_NeedText = true;
+        }
+
+        /// Binary appenders only, nothing to format
+        if (!l_NeedText)
+            return;
+
+        std::string const& l_Time = GetRecordTime(p_Record.Timestamp);
+
+        std::string l_Formatted;
+        if (p_Record.Format)
+            p_Record.Arguments.Format(*p_Record.Format, l_Formatted);
+
+        std::string const& l_Message = p_Record.Format ? l_Formatted : p_Record.Message;
+        std::string_view const l_System = Utils::GetSymbolString(p_Record.System);
+
+        if (m_LogConsole)
+        {
+            const char* l_LogLevel = (p_Record.Type == LogType::Verbose ? "[VERBOSE]" : (p_Record.Type == LogType::Error) ? "[ERROR]"
+                                    : p_Record.Type == LogType::Warning ? "[WARNING]" : "[INFO]");
+
+            APPEND_COLOR(p_Batch, COLOR_BASE);
+
+            if (m_LogTime)
+            {
+                p_Batch += l_Time;
+                p_Batch += " | ";
+            }
+
+            if (m_LogThreadId)
+            {
+                p_Batch += "Thread Id: ";
+                p_Batch += std::to_string(p_Record.ThreadId);
+                p_Batch += " | ";
+            }
+
+            if (m_LogFunction)
+            {
+                p_Batch += p_Record.Function;
+                p_Batch += "::";
+                p_Batch += std::to_string(p_Record.Line);
+                p_Batch += " | ";
+            }
+
+            APPEND_COLOR(p_Batch, GET_COLOR(p_Record.Type));
+            p_Batch += l_LogLevel;
+            p_Batch += "[";
+            p_Batch += l_System;
+            p_Batch += "] << ";
+            p_Batch += l_Message;
+            p_Batch += "\n";
+            APPEND_COLOR(p_Batch, COLOR_RGB);
+        }
+
+        for (auto l_Appender : m_Appenders)
+        {
+            if (!l_Appender->IsBinary())
+                l_Appender->OnReport(this, l_Time, p_Record.Type, l_System, l_Message);
+        }
+    }
+    /// Writer thread entry point
+    void Base::WriterLoop()
+    {
+        while (!m_Stopping.load())
+        {
+            Flush();
+
+            std::unique_lock<std::mutex> l_Guard(m_WriterMutex);
+            m_WriterCondition.wait_for(l_Guard, std::chrono::milliseconds(LOG_ASYNC_FLUSH_INTERVAL), [this]() { return m_Stopping.load(); });
+        }
+    }
+
 } ///< Logger
 } ///< COre
 } ///< SteerStone
\ No newline at end of file
@@ -18,13 +18,47 @@
 */
 
 #pragma once
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <condition_variable>
+#include <shared_mutex>
+
 #include "Singleton/Singleton.hpp"
 #include "Utility/UtiString.hpp"
 #include "Utility/UtiSystem.hpp"
+#include "Utility/UtiBoundedQueue.hpp"
+#include "Utility/UtiSymbolTable.hpp"
 #include "Logger/LogFileAppender.hpp"
+#include "Logger/LogBinaryAppender.hpp"
+#include "Logger/LogFormat.hpp"
 
 namespace SteerStone { namespace Core { namespace Logger { 
 
+    /// What a thread does when its log buffer is full
+    enum class LogOverflow
+    {
+        Drop,                   ///< Message is dropped and counted
+        Block                   ///< Thread waits until the writer made room
+    };
+
+    /// Message captured by the reporting thread
+    struct LogRecord
+    {
+        LogType             Type;           ///< Log type
+        Utils::Symbol       System;         ///< Message sender, interned in the default symbol table
+        std::string_view    Function;       ///< Function name of caller, a literal
+        int32               Line;           ///< Function line of caller
+        uint64              ThreadId;       ///< Thread which reported the message
+        uint64              Timestamp;      ///< Steady clock nanoseconds message has been reported at
+        std::string         Message;        ///< Message, when it has been formatted by the reporting thread
+        LogFormat const*    Format = nullptr;   ///< Format of message, formatted with Arguments by the writer
+        LogArguments        Arguments;          ///< Arguments of Format
+    };
+
+    /// Buffer of one reporting thread, only the writer thread pops
+    using LogBuffer = Utils::MPSCQueue<LogRecord>;
+
     /// Main entry point
     class Base
     {
@@ -34,6 +68,36 @@ namespace SteerStone { namespace Core { namespace Logger {
     //////////////////////////////////////////////////////////////////////////
 
     public:
+        /// Check if a message would be reported, the LOG_* macros check it before evaluating their arguments
+        /// @p_Type   : Log type
+        /// @p_System : Message sender
+        static bool IsEnabled(LogType p_Type, Utils::Symbol const p_System)
+        {
+            if (static_cast<int32>(p_Type) > m_EnabledLevel.load(std::memory_order_relaxed))
+                return false;
+
+            return !m_HasSystemLevels.load(std::memory_order_relaxed) || GetSingleton()->IsSystemEnabled(p_Type, p_System);
+        }
+
+        /// Report a message, arguments are captured and formatted by whoever writes the message
+        /// @p_Type         : Log type
+        /// @p_System       : Message sender
+        /// @p_Function     : Function name of caller
+        /// @p_FunctionLine : Function line of caller
+        /// @p_Format       : Format parsed at compile time
+        /// @p_Args...      : Message arguments
+        template<class... Args> void Report(LogType p_Type, Utils::Symbol const p_System, std::string_view const p_Function, int32 const p_FunctionLine, LogFormat const* p_Format, Args const&... p_Args)
+        {
+            LogRecord l_Record;
+            l_Record.Type       = p_Type;
+            l_Record.System     = p_System;
+            l_Record.Function   = p_Function;
+            l_Record.Line       = p_FunctionLine;
+            l_Record.Format     = p_Format;
+            l_Record.Arguments.Capture(p_Args...);
+
+            ReportRecord(std::move(l_Record));
+        }
         /// Report a message
         /// @p_Type         : Log type
         /// @p_System       : Message sender
@@ -41,7 +105,7 @@ namespace SteerStone { namespace Core { namespace Logger {
         /// @p_FunctionLine : Function line of caller
         /// @p_Message      : Message to report
         /// @p_Args...      : Message arguments
-        template<class... Args> void Report(LogType p_Type, const std::string& p_System, std::string_view const p_Function, int32 const p_FunctionLine, const std::string& p_Message, Args ...p_Args)
+        template<class... Args> void Report(LogType p_Type, std::string_view const p_System, std::string_view const p_Function, int32 const p_FunctionLine, const std::string& p_Message, Args ...p_Args)
         {
             Report(p_Type, p_System, p_Function, p_FunctionLine, Utils::StringBuilder(p_Message, p_Args...));
         }
@@ -51,13 +115,16 @@ namespace SteerStone { namespace Core { namespace Logger {
         /// @p_Function     : Function name of caller
         /// @p_FunctionLine : Function line of caller
         /// @p_Message      : Message to report
-        void Report(LogType p_LogType, std::string const& p_System, std::string_view const p_Function, int32 const p_FunctionLine, std::string const& p_Message);
+        void Report(LogType p_LogType, std::string_view const p_System, std::string_view const p_Function, int32 const p_FunctionLine, std::string const& p_Message);
+        /// Report a captured message
+        /// @p_Record : Record of message, time and thread are filled in
+        void ReportRecord(LogRecord&& p_Record);
         /// Report assert message
         /// @p_System       : Message sender
         /// @p_Function     : Function name of caller
         /// @p_FunctionLine : Function line of caller
         /// @p_Message      : Message to report
-        void ReportAssert(std::string const& p_System, std::string_view const p_Function, int32 const p_FunctionLine, std::string const& p_Message);
+        void ReportAssert(std::string_view const p_System, std::string_view const p_Function, int32 const p_FunctionLine, std::string const& p_Message);
 
         /// Output Server Banner
         /// @p_ExtraInfo : Extra info to output
@@ -75,19 +142,57 @@ namespace SteerStone { namespace Core { namespace Logger {
         /// Enable/Disable Function output to console
         /// @p_Enabler  : Enable/Disable output to console
         void LogFunctionEnabler(bool const p_Enabler);
+        /// Enable/Disable console output, appenders still get every message
+        /// @p_Enabler  : Enable/Disable output to console
+        void LogConsoleEnabler(bool const p_Enabler);
+
+        /// Get a steady clock and a wall clock reading taken at the same time, record timestamps are on the steady clock
+        /// @p_Steady : Steady clock nanoseconds
+        /// @p_System : Wall clock nanoseconds since epoch
+        void GetClockAnchor(uint64& p_Steady, uint64& p_System) const;
+
+        /// Report messages through per thread buffers drained by a writer thread
+        /// @p_BufferSize : Records each thread can buffer
+        /// @p_Overflow   : What a thread does when its buffer is full
+        void EnableAsync(uint32 const p_BufferSize, LogOverflow const p_Overflow);
+        /// Write all buffered messages now
+        void Flush();
+        /// Get amount of messages dropped because a buffer was full
+        uint64 GetDroppedCount() const;
 
     //////////////////////////////////////////////////////////////////////////
     //////////////////////////////////////////////////////////////////////////
 
+        /// Set level of messages to report
+        /// @p_Level : New log level
+        void SetLogLevel(LogType p_Level);
+        /// Set level of messages to report for a system, overrides the log level
+        /// @p_System : Message sender
+        /// @p_Level  : New log level of system
+        void SetSystemLogLevel(std::string const& p_System, LogType p_Level);
+        /// Set levels from configuration
+        /// @p_Level        : Log level name, "info", "warning", "error" or "verbose"
+        /// @p_SystemLevels : Comma separated system=level pairs
+        void SetLogLevels(std::string const& p_Level, std::string const& p_SystemLevels);
+
     private:
         /// Set log mode
         /// @p_Level : New log level
         void SetLogMode(LogType p_Level);
+        /// Check level of a system which has its own level
+        /// @p_Type   : Log type
+        /// @p_System : Message sender
+        bool IsSystemEnabled(LogType p_Type, Utils::Symbol const p_System);
+        /// Recompute highest level any system reports
+        void UpdateEnabledLevel();
 
         /// Get log mode
         LogType GetLogLevel();
         /// Return current time
         std::string GetServerTime();
+        /// Return wall clock time of a record timestamp, valid until the next call
+        /// @p_Timestamp : Steady clock nanoseconds
+        std::string const& GetRecordTime(uint64 const p_Timestamp);
 
     public:
         /// Add appender to the logger
@@ -97,14 +202,50 @@ namespace SteerStone { namespace Core { namespace Logger {
         /// Remove all appenders
         void RemoveAllAppenders();
 
+        /// Get buffer of calling thread, registered on first use
+        LogBuffer* GetThreadBuffer();
+        /// Write records of all buffers
+        /// Returns amount of written records
+        std::size_t DrainBuffers();
+        /// Output a record to console batch and appenders
+        /// @p_Record : Record to output
+        /// @p_Batch  : Console output
+        void OutputRecord(LogRecord const& p_Record, std::string& p_Batch);
+        /// Writer thread entry point
+        void WriterLoop();
+
     private:
+        static std::atomic<int32>   m_EnabledLevel;     ///< Highest level any system reports
+        static std::atomic<bool>    m_HasSystemLevels;  ///< A system has its own level
+
         LogType                 m_LogLevel;             ///< Log Mode
+        std::shared_mutex                               m_SystemLevelMutex; ///< Guards m_SystemLevels
+        std::unordered_map<Utils::Symbol, LogType>      m_SystemLevels;     ///< Level of systems which have their own
         std::recursive_mutex    m_Mutex;                ///< Global Mutex
         std::vector<Appender*>  m_Appenders; ///< All appenders
 
         bool                    m_LogTime;              ///< Output Time
         bool                    m_LogThreadId;          ///< Output Thread Id
         bool                    m_LogFunction;          ///< Output Function Name
+        bool                    m_LogConsole;           ///< Output to console
+
+        uint64                  m_AnchorSteady;         ///< Steady clock nanoseconds at startup
+        uint64                  m_AnchorSystem;         ///< Wall clock nanoseconds at startup
+        int64                   m_TimeCacheSecond;      ///< Wall clock second m_TimeCache is for
+        std::string             m_TimeCache;            ///< Formatted wall clock second
+
+        std::atomic<bool>       m_Async;                ///< Messages are written by the writer thread
+        LogOverflow             m_Overflow;             ///< What a thread does when its buffer is full
+        uint32                  m_BufferSize;           ///< Records each thread can buffer
+        std::atomic<uint64>     m_Dropped;              ///< Messages dropped because a buffer was full
+        uint64                  m_DroppedReported;      ///< Dropped messages already warned about
+
+        std::mutex                              m_BufferMutex;      ///< Guards m_Buffers
+        std::vector<std::shared_ptr<LogBuffer>> m_Buffers;          ///< Buffers of reporting threads
+        std::thread                             m_Writer;           ///< Writer thread
+        std::atomic<bool>                       m_Stopping;         ///< Writer thread must exit
+        std::mutex                              m_WriterMutex;      ///< Writer condition mutex
+        std::condition_variable                 m_WriterCondition;  ///< Writer waits for the next flush
     };
 } ///< SteerStone 
 } ///< Core
@@ -27,6 +27,8 @@ namespace SteerStone { namespace Core { namespace Logger {
 
     /// Logger class
     class Base;
+    /// Captured message
+    struct LogRecord;
 
     /// Logger appender class
     class Appender
@@ -44,7 +46,15 @@ namespace SteerStone { namespace Core { namespace Logger {
             /// @p_Type     : Log type
             /// @p_System   : Message sender
             /// @p_Message  : Message to report
-            virtual void OnReport(Base* p_Logger, const std::string & p_Time, LogType p_Type, const std::string & p_System, const std::string & p_Message) = 0;
+            virtual void OnReport(Base* p_Logger, const std::string & p_Time, LogType p_Type, std::string_view const p_System, const std::string & p_Message) = 0;
+            /// Check if the appender takes records as captured instead of formatted messages
+            virtual bool IsBinary() const { return false; }
+            /// On report a captured message, only called when IsBinary
+            /// @p_Logger   : Logger instance
+            /// @p_Record   : Captured message
+            virtual void OnRecord(Base* p_Logger, LogRecord const& p_Record) { }
+            /// On reported messages written, once per message or once per batch when logging asynchronously
+            virtual void OnFlush() { }
     };
 
 }   ///< namespace Logger
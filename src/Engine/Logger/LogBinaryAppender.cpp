@@ -0,0 +1,193 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <Precompiled.hpp>
+
+#include "LogBinaryAppender.hpp"
+#include "Base.hpp"
+
+namespace SteerStone { namespace Core { namespace Logger {
+
+    /// Constructor
+    /// @p_FileName : Output file name
+    BinaryAppender::BinaryAppender(const std::string & p_FileName)
+        : m_File(nullptr), m_NextId(1)
+    {
+        std::lock_guard<std::recursive_mutex> l_Lock(m_Mutex);
+
+        m_File = fopen(p_FileName.c_str(), "ab");
+
+        if (!m_File)
+        {
+            LOG_ERROR("LogBinaryAppender", "Can't open file \"%0\" in append mode", p_FileName);
+            exit(-1);
+            return;
+        }
+
+        /// Every run starts with its own header, ids restart with it
+        uint64 l_Steady = 0;
+        uint64 l_System = 0;
+        Base::GetSingleton()->GetClockAnchor(l_Steady, l_System);
+
+        m_Buffer.reserve(LOG_BINARY_BUFFER_SIZE);
+        Append(LOG_BINARY_MAGIC, LOG_BINARY_MAGIC_SIZE);
+        Append(l_Steady);
+        Append(l_System);
+        WriteBuffer();
+
+        LOG_INFO("LogBinaryAppender", "Created...");
+    }
+    /// Destructor
+    BinaryAppender::~BinaryAppender()
+    {
+        std::lock_guard<std::recursive_mutex> l_Lock(m_Mutex);
+
+        if (m_File)
+        {
+            WriteBuffer();
+
+            fflush(m_File);
+            fclose(m_File);
+
+            m_File = nullptr;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Check if the appender takes records as captured instead of formatted messages
+    bool BinaryAppender::IsBinary() const
+    {
+        return true;
+    }
+    /// On report a message, unused
+    /// @p_Logger   : Logger instance
+    /// @p_Type     : Log type
+    /// @p_System   : Message sender
+    /// @p_Message  : Message to report
+    void BinaryAppender::OnReport(Base * p_Logger, const std::string & p_Time, LogType p_Type, std::string_view const p_System, const std::string & p_Message)
+    {
+    }
+    /// On report a captured message
+    /// @p_Logger   : Logger instance
+    /// @p_Record   : Captured message
+    void BinaryAppender::OnRecord(Base * p_Logger, LogRecord const& p_Record)
+    {
+        /// Messages formatted by the caller are stored as the only argument of this format
+        static constexpr LogFormat sl_MessageFormat("%0");
+
+        LogArguments l_Message;
+        LogFormat const* l_Format      = p_Record.Format;
+        LogArguments const* l_Arguments = &p_Record.Arguments;
+
+        if (!l_Format)
+        {
+            l_Message.Capture(p_Record.Message);
+
+            l_Format    = &sl_MessageFormat;
+            l_Arguments = &l_Message;
+        }
+
+        std::lock_guard<std::recursive_mutex> l_Lock(m_Mutex);
+
+        if (!m_File)
+            return;
+
+        const uint32 l_System   = Intern<uint32>(m_Systems, p_Record.System.GetId(), LogBinaryString::System, Utils::GetSymbolString(p_Record.System));
+        const uint32 l_FormatId = Intern<void const*>(m_Formats, l_Format, LogBinaryString::Format, l_Format->GetFormat());
+        const uint32 l_Function = Intern<void const*>(m_Functions, p_Record.Function.data(), LogBinaryString::Function, p_Record.Function);
+
+        Append(LogBinaryTag::Record);
+        Append(p_Record.Timestamp);
+        Append(p_Record.ThreadId);
+        Append(static_cast<uint8>(p_Record.Type));
+        Append(l_System);
+        Append(l_FormatId);
+        Append(l_Function);
+        Append(p_Record.Line);
+        Append(l_Arguments->GetCount());
+        Append(l_Arguments->GetSize());
+        Append(l_Arguments->GetData(), l_Arguments->GetSize());
+
+        if (m_Buffer.size() >= LOG_BINARY_BUFFER_SIZE)
+            WriteBuffer();
+    }
+    /// On reported messages written
+    void BinaryAppender::OnFlush()
+    {
+        std::lock_guard<std::recursive_mutex> l_Lock(m_Mutex);
+
+        if (!m_File)
+            return;
+
+        WriteBuffer();
+        fflush(m_File);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get id of a string, written to file the first time it is seen
+    /// @p_Ids    : Ids of strings of this kind
+    /// @p_Key    : Key of string
+    /// @p_Kind   : What the string is
+    /// @p_String : String
+    template<typename Key> uint32 BinaryAppender::Intern(std::unordered_map<Key, uint32>& p_Ids, Key const& p_Key, LogBinaryString p_Kind, std::string_view const p_String)
+    {
+        auto const l_Itr = p_Ids.find(p_Key);
+        if (l_Itr != p_Ids.end())
+            return l_Itr->second;
+
+        const uint32 l_Id = m_NextId++;
+        p_Ids.emplace(p_Key, l_Id);
+
+        Append(LogBinaryTag::String);
+        Append(p_Kind);
+        Append(l_Id);
+        Append(static_cast<uint32>(p_String.size()));
+        Append(p_String.data(), p_String.size());
+
+        return l_Id;
+    }
+    /// Append a value to the buffer
+    /// @p_Value : Value
+    template<typename T> void BinaryAppender::Append(T const& p_Value)
+    {
+        Append(&p_Value, sizeof(T));
+    }
+    /// Append bytes to the buffer
+    /// @p_Data : Bytes
+    /// @p_Size : Amount of bytes
+    void BinaryAppender::Append(void const* p_Data, std::size_t p_Size)
+    {
+        m_Buffer.append(static_cast<const char*>(p_Data), p_Size);
+    }
+    /// Write buffer to file
+    void BinaryAppender::WriteBuffer()
+    {
+        if (m_Buffer.empty())
+            return;
+
+        fwrite(m_Buffer.data(), m_Buffer.size(), 1, m_File);
+        m_Buffer.clear();
+    }
+
+}   ///< namespace Logger
+}   ///< namespace Core
+}   ///< namespace SteerStone
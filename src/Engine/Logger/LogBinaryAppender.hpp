@@ -0,0 +1,117 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <mutex>
+
+#include "Core/Core.hpp"
+#include "LogAppender.hpp"
+
+#define LOG_BINARY_MAGIC            "SSBLOG01"      ///< First bytes of a binary log
+#define LOG_BINARY_MAGIC_SIZE       8               ///< Size of LOG_BINARY_MAGIC
+#define LOG_BINARY_BUFFER_SIZE      65536           ///< Bytes buffered before they are written to file
+
+namespace SteerStone { namespace Core { namespace Logger {
+
+    /// Entries of a binary log
+    ///
+    /// Header  : magic, uint64 steady clock anchor, uint64 wall clock anchor (nanoseconds)
+    /// String  : uint8 tag, uint8 kind, uint32 id, uint32 length, characters, written before the first record using it
+    /// Record  : uint8 tag, uint64 steady timestamp, uint64 thread id, uint8 log type, uint32 system id, uint32 format id,
+    ///           uint32 function id, int32 line, uint32 argument count, uint32 argument size, arguments as captured
+    /// Integers are in host byte order
+    enum class LogBinaryTag : uint8
+    {
+        String = 1,
+        Record = 2
+    };
+
+    /// What an interned string is
+    enum class LogBinaryString : uint8
+    {
+        System      = 0,
+        Format      = 1,
+        Function    = 2
+    };
+
+    /// Appender writing captured records without formatting them, see the LogDecoder tool to read them
+    class BinaryAppender : public Appender
+    {
+        DISALLOW_COPY_AND_ASSIGN(BinaryAppender);
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    public:
+        /// Constructor
+        /// @p_FileName : Output file name
+        BinaryAppender(const std::string & p_FileName);
+        /// Destructor
+        ~BinaryAppender();
+
+        /// Check if the appender takes records as captured instead of formatted messages
+        bool IsBinary() const override final;
+        /// On report a message, unused
+        /// @p_Logger   : Logger instance
+        /// @p_Type     : Log type
+        /// @p_System   : Message sender
+        /// @p_Message  : Message to report
+        void OnReport(Base * p_Logger, const std::string & p_Time, LogType p_Type, std::string_view const p_System, const std::string & p_Message) override final;
+        /// On report a captured message
+        /// @p_Logger   : Logger instance
+        /// @p_Record   : Captured message
+        void OnRecord(Base * p_Logger, LogRecord const& p_Record) override final;
+        /// On reported messages written
+        void OnFlush() override final;
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    private:
+        /// Get id of a string, written to file the first time it is seen
+        /// @p_Ids    : Ids of strings of this kind
+        /// @p_Key    : Key of string
+        /// @p_Kind   : What the string is
+        /// @p_String : String
+        template<typename Key> uint32 Intern(std::unordered_map<Key, uint32>& p_Ids, Key const& p_Key, LogBinaryString p_Kind, std::string_view const p_String);
+        /// Append a value to the buffer
+        /// @p_Value : Value
+        template<typename T> void Append(T const& p_Value);
+        /// Append bytes to the buffer
+        /// @p_Data : Bytes
+        /// @p_Size : Amount of bytes
+        void Append(void const* p_Data, std::size_t p_Size);
+        /// Write buffer to file
+        void WriteBuffer();
+
+    private:
+        FILE *                                          m_File;         ///< Output file
+        std::string                                     m_Buffer;       ///< Bytes not written yet
+        uint32                                          m_NextId;       ///< Next string id
+
+        std::unordered_map<uint32, uint32>              m_Systems;      ///< Ids of systems, keyed by symbol
+        std::unordered_map<void const*, uint32>         m_Formats;      ///< Ids of formats, they are static
+        std::unordered_map<void const*, uint32>         m_Functions;    ///< Ids of function names, they are literals
+
+        std::recursive_mutex m_Mutex;                                   ///< File mutex
+    };
+
+}   ///< namespace Logger
+}   ///< namespace Core
+}   ///< namespace SteerStone
@@ -20,17 +20,31 @@
 #pragma once
 
 /// Console Output
+/// Level is checked before any argument is evaluated, format is parsed at compile time and arguments are formatted by whoever writes the message
+/// System is interned once per call site, so records carry an integer instead of a copy of its name
+#define LOG_SYSTEM(p_System)                                                                                                                        \
+    []() { static const ::SteerStone::Core::Utils::Symbol sl_System = ::SteerStone::Core::Utils::Intern(p_System); return sl_System; }()
+/// Expands to a single statement, safe as the body of an unbraced if / else
+#define LOG_REPORT(p_Type, p_System, p_Format, ...)                                                                                                 \
+    do                                                                                                                                              \
+    {                                                                                                                                               \
+        const ::SteerStone::Core::Utils::Symbol l_LogSystem = LOG_SYSTEM(p_System);                                                                 \
+        if (::SteerStone::Core::Logger::Base::IsEnabled(p_Type, l_LogSystem))                                                                       \
+            ::SteerStone::Core::Logger::Base::GetSingleton()->Report(p_Type, l_LogSystem, LOG_GET_FUNCTION(), LOG_GET_FUNCTION_LINE(),              \
+                []() { static constexpr ::SteerStone::Core::Logger::LogFormat sl_Format(p_Format); return &sl_Format; }(), ##__VA_ARGS__);         \
+    } while (0)
+
 #ifdef _DEBUG
-#define LOG_INFO(p_System,      ...)        ::SteerStone::Core::Logger::Base::GetSingleton()->Report(SteerStone::Core::Logger::LogType::Info,    p_System, LOG_GET_FUNCTION(), LOG_GET_FUNCTION_LINE(), __VA_ARGS__)
-#define LOG_WARNING(p_System,   ...)        ::SteerStone::Core::Logger::Base::GetSingleton()->Report(SteerStone::Core::Logger::LogType::Warning, p_System, LOG_GET_FUNCTION(), LOG_GET_FUNCTION_LINE(), __VA_ARGS__)
-#define LOG_ERROR(p_System,     ...)        ::SteerStone::Core::Logger::Base::GetSingleton()->Report(SteerStone::Core::Logger::LogType::Error,   p_System, LOG_GET_FUNCTION(), LOG_GET_FUNCTION_LINE(), __VA_ARGS__)
-#define LOG_VERBOSE(p_System,   ...)        ::SteerStone::Core::Logger::Base::GetSingleton()->Report(SteerStone::Core::Logger::LogType::Verbose, p_System, LOG_GET_FUNCTION(), LOG_GET_FUNCTION_LINE(), __VA_ARGS__)
+#define LOG_INFO(p_System,      ...)        LOG_REPORT(SteerStone::Core::Logger::LogType::Info,    p_System, __VA_ARGS__)
+#define LOG_WARNING(p_System,   ...)        LOG_REPORT(SteerStone::Core::Logger::LogType::Warning, p_System, __VA_ARGS__)
+#define LOG_ERROR(p_System,     ...)        LOG_REPORT(SteerStone::Core::Logger::LogType::Error,   p_System, __VA_ARGS__)
+#define LOG_VERBOSE(p_System,   ...)        LOG_REPORT(SteerStone::Core::Logger::LogType::Verbose, p_System, __VA_ARGS__)
 #define LOG_ASSERT(p_Condition, p_System, ...) if (!(p_Condition)) ::SteerStone::Core::Logger::Base::GetSingleton()->Report(SteerStone::Core::Logger::LogType::Assert, p_System, LOG_GET_FUNCTION(), LOG_GET_FUNCTION_LINE(), __VA_ARGS__)
 #else
-#define LOG_INFO(p_System,      ...)        ::SteerStone::Core::Logger::Base::GetSingleton()->Report(SteerStone::Core::Logger::LogType::Info,    p_System, LOG_GET_FUNCTION(), LOG_GET_FUNCTION_LINE(), __VA_ARGS__)
-#define LOG_WARNING(p_System,   ...)        ::SteerStone::Core::Logger::Base::GetSingleton()->Report(SteerStone::Core::Logger::LogType::Warning, p_System, LOG_GET_FUNCTION(), LOG_GET_FUNCTION_LINE(), __VA_ARGS__)
-#define LOG_ERROR(p_System,     ...)        ::SteerStone::Core::Logger::Base::GetSingleton()->Report(SteerStone::Core::Logger::LogType::Error,   p_System, LOG_GET_FUNCTION(), LOG_GET_FUNCTION_LINE(), __VA_ARGS__)
-#define LOG_VERBOSE(p_System,   ...)
+#define LOG_INFO(p_System,      ...)        LOG_REPORT(SteerStone::Core::Logger::LogType::Info,    p_System, __VA_ARGS__)
+#define LOG_WARNING(p_System,   ...)        LOG_REPORT(SteerStone::Core::Logger::LogType::Warning, p_System, __VA_ARGS__)
+#define LOG_ERROR(p_System,     ...)        LOG_REPORT(SteerStone::Core::Logger::LogType::Error,   p_System, __VA_ARGS__)
+#define LOG_VERBOSE(p_System,   ...)        ((void)0)
 #define LOG_ASSERT(p_Condition, p_System, ...) if (!(p_Condition)) ::SteerStone::Core::Logger::Base::GetSingleton()->Report(SteerStone::Core::Logger::LogType::Assert, p_System, LOG_GET_FUNCTION(), LOG_GET_FUNCTION_LINE(), __VA_ARGS__)
 #endif
 
@@ -38,7 +52,17 @@
 #define LOG_ENABLE_TIME(p_Enable)           ::SteerStone::Core::Logger::Base::GetSingleton()->LogTimeEnabler(p_Enable)
 #define LOG_ENABLE_THREAD_ID(p_Enable)      ::SteerStone::Core::Logger::Base::GetSingleton()->LogThreadIdEnabler(p_Enable)
 #define LOG_ENABLE_FUNCTION(p_Enable)       ::SteerStone::Core::Logger::Base::GetSingleton()->LogFunctionEnabler(p_Enable)
+#define LOG_ENABLE_CONSOLE(p_Enable)        ::SteerStone::Core::Logger::Base::GetSingleton()->LogConsoleEnabler(p_Enable)
 #define LOG_ADD_APPENDER(p_Appender)        ::SteerStone::Core::Logger::Base::GetSingleton()->AddAppender(p_Appender)
+#define LOG_ENABLE_ASYNC(p_Size, p_Policy)  ::SteerStone::Core::Logger::Base::GetSingleton()->EnableAsync(p_Size, p_Policy)
+#define LOG_SET_LEVEL(p_Level)              ::SteerStone::Core::Logger::Base::GetSingleton()->SetLogLevel(p_Level)
+#define LOG_SET_SYSTEM_LEVEL(p_System, p_Level) ::SteerStone::Core::Logger::Base::GetSingleton()->SetSystemLogLevel(p_System, p_Level)
+#define LOG_FLUSH()                         ::SteerStone::Core::Logger::Base::GetSingleton()->Flush()
+
+/// Asynchronous Logger
+#define LOG_ASYNC_BUFFER_SIZE       4096    ///< Default records each thread can buffer
+#define LOG_ASYNC_BATCH_SIZE        64      ///< Records popped from a buffer at once
+#define LOG_ASYNC_FLUSH_INTERVAL    10      ///< Milliseconds the writer sleeps once everything is written
 
 /// Internal Logger Helpers
 #ifdef _MSC_VER
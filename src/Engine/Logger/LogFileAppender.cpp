@@ -85,10 +85,10 @@ namespace SteerStone { namespace Core { namespace Logger {
     /// @p_Type     : Log type
     /// @p_System   : Message sender
     /// @p_Message  : Message to report
-    void FileAppender::OnReport(Base * p_Logger, const std::string & p_Time, LogType p_Type, const std::string & p_System, const std::string & p_Message)
+    void FileAppender::OnReport(Base * p_Logger, const std::string & p_Time, LogType p_Type, std::string_view const p_System, const std::string & p_Message)
     {
-        std::string l_TypeStr   = "";
-        std::string l_HTMLColor = "";
+        const char* l_TypeStr   = "";
+        const char* l_HTMLColor = "";
 
         switch (p_Type)
         {
@@ -103,13 +103,13 @@ namespace SteerStone { namespace Core { namespace Logger {
 
         if (m_HTML)
         {
-            static const char * sl_Template = R"TPL(<tr valign="top"><td>%0</td><td></td><td style="color:%1">%2</td><td></td><td>%3</td><td></td><td style="color:%1">%4</td>)TPL";
-            l_ToWrite = Utils::StringBuilder<std::string>(sl_Template, p_Time, l_HTMLColor, l_TypeStr, p_System, p_Message);
+            static constexpr Utils::StringFormat sl_Template(R"TPL(<tr valign="top"><td>%0</td><td></td><td style="color:%1">%2</td><td></td><td>%3</td><td></td><td style="color:%1">%4</td>)TPL");
+            Utils::StringBuilderTo(l_ToWrite, sl_Template, p_Time, l_HTMLColor, l_TypeStr, p_System, p_Message);
         }
         else
         {
-            static const char * sl_Template = R"TPL([%0] %1 "%2" > %3\n)TPL";
-            l_ToWrite = Utils::StringBuilder<std::string>(sl_Template, p_Time, l_TypeStr, p_System, p_Message);
+            static constexpr Utils::StringFormat sl_Template(R"TPL([%0] %1 "%2" > %3\n)TPL");
+            Utils::StringBuilderTo(l_ToWrite, sl_Template, p_Time, l_TypeStr, p_System, p_Message);
         }
 
         std::lock_guard<std::recursive_mutex> l_Lock(m_Mutex);
@@ -118,7 +118,14 @@ namespace SteerStone { namespace Core { namespace Logger {
             return;
 
         fwrite(l_ToWrite.c_str(), l_ToWrite.length(), 1, m_File);
-        fflush(m_File);
+    }
+    /// On reported messages written
+    void FileAppender::OnFlush()
+    {
+        std::lock_guard<std::recursive_mutex> l_Lock(m_Mutex);
+
+        if (m_File)
+            fflush(m_File);
     }
 
 }   ///< namespace Logger
@@ -47,7 +47,9 @@ namespace SteerStone { namespace Core { namespace Logger {
         /// @p_Type     : Log type
         /// @p_System   : Message sender
         /// @p_Message  : Message to report
-        void OnReport(Base * p_Logger, const std::string & p_Time, LogType p_Type, const std::string & p_System, const std::string & p_Message) override final;
+        void OnReport(Base * p_Logger, const std::string & p_Time, LogType p_Type, std::string_view const p_System, const std::string & p_Message) override final;
+        /// On reported messages written
+        void OnFlush() override final;
 
     //////////////////////////////////////////////////////////////////////////
     //////////////////////////////////////////////////////////////////////////
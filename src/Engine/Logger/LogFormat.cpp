@@ -0,0 +1,219 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <Precompiled.hpp>
+#include <algorithm>
+
+#include "LogFormat.hpp"
+
+namespace SteerStone { namespace Core { namespace Logger {
+
+    /// Get amount of captured arguments
+    uint32 LogArguments::GetCount() const
+    {
+        return m_Count;
+    }
+    /// Get amount of captured bytes
+    uint32 LogArguments::GetSize() const
+    {
+        return m_Size;
+    }
+    /// Get captured bytes
+    uint8 const* LogArguments::GetData() const
+    {
+        return m_Heap.empty() ? m_Inline : m_Heap.data();
+    }
+    /// Replace arguments by bytes captured elsewhere
+    /// @p_Data  : Captured bytes
+    /// @p_Size  : Amount of captured bytes
+    /// @p_Count : Amount of captured arguments
+    void LogArguments::Load(void const* p_Data, uint32 p_Size, uint32 p_Count)
+    {
+        m_Heap.clear();
+        m_Size = 0;
+
+        Write(p_Data, p_Size);
+        m_Count = p_Count;
+    }
+
+    /// Write format with arguments in place of its tokens, tokens without argument are kept
+    /// @p_Format : Format
+    /// @p_Output : Output
+    void LogArguments::Format(LogFormat const& p_Format, std::string& p_Output) const
+    {
+        /// Offsets of arguments, tokens can refer to them in any order
+        std::size_t l_Offsets[STRING_FORMAT_MAX_SEGMENTS];
+        const uint32 l_Count = std::min<uint32>(m_Count, STRING_FORMAT_MAX_SEGMENTS);
+
+        std::size_t l_Offset = 0;
+        for (uint32 l_I = 0; l_I < l_Count; l_I++)
+        {
+            l_Offsets[l_I] = l_Offset;
+            l_Offset += GetArgumentSize(l_Offset);
+        }
+
+        const std::string_view l_Format = p_Format.GetFormat();
+
+        for (uint32 l_I = 0; l_I < p_Format.GetSegmentCount(); l_I++)
+        {
+            LogFormat::Segment const& l_Segment = p_Format.GetSegment(l_I);
+
+            if (l_Segment.Argument >= 0 && static_cast<uint32>(l_Segment.Argument) < l_Count)
+                Append(l_Offsets[l_Segment.Argument], p_Output);
+            else
+                p_Output.append(l_Format.data() + l_Segment.Offset, l_Segment.Length);
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Capture a string argument
+    /// @p_Value : Argument
+    void LogArguments::AddString(std::string_view const p_Value)
+    {
+        const uint32 l_Length = static_cast<uint32>(p_Value.size());
+
+        Write(LogArgumentType::String, &l_Length, sizeof(uint32));
+        Write(p_Value.data(), l_Length);
+    }
+    /// Append an argument
+    /// @p_Type : Argument type
+    /// @p_Data : Argument value
+    /// @p_Size : Size of value
+    void LogArguments::Write(LogArgumentType p_Type, void const* p_Data, std::size_t p_Size)
+    {
+        Write(&p_Type, sizeof(LogArgumentType));
+        Write(p_Data, p_Size);
+
+        m_Count++;
+    }
+    /// Append bytes
+    /// @p_Data : Bytes
+    /// @p_Size : Amount of bytes
+    void LogArguments::Write(void const* p_Data, std::size_t p_Size)
+    {
+        if (m_Heap.empty() && m_Size + p_Size <= LOG_ARGUMENTS_INLINE_SIZE)
+            memcpy(m_Inline + m_Size, p_Data, p_Size);
+        else
+        {
+            if (m_Heap.empty())
+                m_Heap.assign(m_Inline, m_Inline + m_Size);
+
+            m_Heap.insert(m_Heap.end(), static_cast<uint8 const*>(p_Data), static_cast<uint8 const*>(p_Data) + p_Size);
+        }
+
+        m_Size += static_cast<uint32>(p_Size);
+    }
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Write an argument
+    /// @p_Offset : Offset of argument in captured bytes
+    /// @p_Output : Output
+    void LogArguments::Append(std::size_t p_Offset, std::string& p_Output) const
+    {
+        uint8 const* l_Data = GetData() + p_Offset;
+
+        LogArgumentType l_Type;
+        memcpy(&l_Type, l_Data, sizeof(LogArgumentType));
+        l_Data += sizeof(LogArgumentType);
+
+        switch (l_Type)
+        {
+            case LogArgumentType::Signed:
+            {
+                int64 l_Value;
+                memcpy(&l_Value, l_Data, sizeof(int64));
+                p_Output += std::to_string(l_Value);
+                break;
+            }
+            case LogArgumentType::Unsigned:
+            {
+                uint64 l_Value;
+                memcpy(&l_Value, l_Data, sizeof(uint64));
+                p_Output += std::to_string(l_Value);
+                break;
+            }
+            case LogArgumentType::Double:
+            {
+                double l_Value;
+                memcpy(&l_Value, l_Data, sizeof(double));
+
+                /// Same output as the default stream precision
+                char l_Buffer[32];
+                snprintf(l_Buffer, sizeof(l_Buffer), "%g", l_Value);
+                p_Output += l_Buffer;
+                break;
+            }
+            case LogArgumentType::Bool:
+                p_Output += *l_Data ? '1' : '0';
+                break;
+            case LogArgumentType::Char:
+                p_Output += static_cast<char>(*l_Data);
+                break;
+            case LogArgumentType::Pointer:
+            {
+                uintptr_t l_Value;
+                memcpy(&l_Value, l_Data, sizeof(uintptr_t));
+
+                char l_Buffer[32];
+                snprintf(l_Buffer, sizeof(l_Buffer), "0x%llx", static_cast<unsigned long long>(l_Value));
+                p_Output += l_Buffer;
+                break;
+            }
+            case LogArgumentType::String:
+            {
+                uint32 l_Length;
+                memcpy(&l_Length, l_Data, sizeof(uint32));
+                p_Output.append(reinterpret_cast<const char*>(l_Data + sizeof(uint32)), l_Length);
+                break;
+            }
+        }
+    }
+    /// Get size of an argument
+    /// @p_Offset : Offset of argument in captured bytes
+    std::size_t LogArguments::GetArgumentSize(std::size_t p_Offset) const
+    {
+        uint8 const* l_Data = GetData() + p_Offset;
+
+        LogArgumentType l_Type;
+        memcpy(&l_Type, l_Data, sizeof(LogArgumentType));
+
+        switch (l_Type)
+        {
+            case LogArgumentType::Signed:   return sizeof(LogArgumentType) + sizeof(int64);
+            case LogArgumentType::Unsigned: return sizeof(LogArgumentType) + sizeof(uint64);
+            case LogArgumentType::Double:   return sizeof(LogArgumentType) + sizeof(double);
+            case LogArgumentType::Bool:     return sizeof(LogArgumentType) + sizeof(bool);
+            case LogArgumentType::Char:     return sizeof(LogArgumentType) + sizeof(char);
+            case LogArgumentType::Pointer:  return sizeof(LogArgumentType) + sizeof(uintptr_t);
+            case LogArgumentType::String:
+            {
+                uint32 l_Length;
+                memcpy(&l_Length, l_Data + sizeof(LogArgumentType), sizeof(uint32));
+                return sizeof(LogArgumentType) + sizeof(uint32) + l_Length;
+            }
+        }
+
+        return sizeof(LogArgumentType);
+    }
+
+}   ///< namespace Logger
+}   ///< namespace Core
+}   ///< namespace SteerStone
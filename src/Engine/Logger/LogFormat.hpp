@@ -0,0 +1,151 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <cstring>
+#include <type_traits>
+
+#include "Core/Core.hpp"
+#include "Utility/UtiString.hpp"
+
+#define LOG_ARGUMENTS_INLINE_SIZE   128     ///< Argument bytes a record holds before allocating
+
+namespace SteerStone { namespace Core { namespace Logger {
+
+    /// Format string split in literal parts and %N tokens, the LOG_* macros build it at compile time
+    using LogFormat = Utils::StringFormat;
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Type of a captured argument
+    enum class LogArgumentType : uint8
+    {
+        Signed,                 ///< int64
+        Unsigned,               ///< uint64
+        Double,                 ///< double
+        Bool,                   ///< bool
+        Char,                   ///< char
+        Pointer,                ///< uintptr_t, written in hexadecimal
+        String                  ///< uint32 length followed by characters
+    };
+
+    /// Arguments of a message captured in binary, formatting is left to whoever writes the message
+    class LogArguments
+    {
+        public:
+            /// Constructor
+            LogArguments()
+                : m_Size(0), m_Count(0)
+            {
+            }
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Capture arguments
+            /// @p_Args : Arguments
+            template<typename... Args> void Capture(Args const&... p_Args)
+            {
+                (Add(p_Args), ...);
+            }
+            /// Capture an argument
+            /// @p_Value : Argument
+            template<typename T> void Add(T const& p_Value)
+            {
+                if constexpr (std::is_same<T, bool>::value)
+                    Write(LogArgumentType::Bool, &p_Value, sizeof(bool));
+                else if constexpr (std::is_same<T, char>::value)
+                    Write(LogArgumentType::Char, &p_Value, sizeof(char));
+                else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value)
+                {
+                    const int64 l_Value = p_Value;
+                    Write(LogArgumentType::Signed, &l_Value, sizeof(int64));
+                }
+                else if constexpr (std::is_integral<T>::value)
+                {
+                    const uint64 l_Value = p_Value;
+                    Write(LogArgumentType::Unsigned, &l_Value, sizeof(uint64));
+                }
+                else if constexpr (std::is_floating_point<T>::value)
+                {
+                    const double l_Value = p_Value;
+                    Write(LogArgumentType::Double, &l_Value, sizeof(double));
+                }
+                else if constexpr (std::is_convertible<T const&, std::string_view>::value)
+                    AddString(std::string_view(p_Value));
+                else if constexpr (std::is_pointer<T>::value && !std::is_convertible<T, const wchar_t*>::value)
+                {
+                    const uintptr_t l_Value = reinterpret_cast<uintptr_t>(p_Value);
+                    Write(LogArgumentType::Pointer, &l_Value, sizeof(uintptr_t));
+                }
+                /// Anything else is streamed right away, like StringBuilder does
+                else
+                    AddString(Utils::Converter<std::string>::ToString(p_Value));
+            }
+
+            /// Get amount of captured arguments
+            uint32 GetCount() const;
+            /// Get amount of captured bytes
+            uint32 GetSize() const;
+            /// Get captured bytes
+            uint8 const* GetData() const;
+            /// Replace arguments by bytes captured elsewhere
+            /// @p_Data  : Captured bytes
+            /// @p_Size  : Amount of captured bytes
+            /// @p_Count : Amount of captured arguments
+            void Load(void const* p_Data, uint32 p_Size, uint32 p_Count);
+
+            /// Write format with arguments in place of its tokens, tokens without argument are kept
+            /// @p_Format : Format
+            /// @p_Output : Output
+            void Format(LogFormat const& p_Format, std::string& p_Output) const;
+
+        private:
+            /// Capture a string argument
+            /// @p_Value : Argument
+            void AddString(std::string_view const p_Value);
+            /// Append an argument
+            /// @p_Type : Argument type
+            /// @p_Data : Argument value
+            /// @p_Size : Size of value
+            void Write(LogArgumentType p_Type, void const* p_Data, std::size_t p_Size);
+            /// Append bytes
+            /// @p_Data : Bytes
+            /// @p_Size : Amount of bytes
+            void Write(void const* p_Data, std::size_t p_Size);
+
+            /// Write an argument
+            /// @p_Offset : Offset of argument in captured bytes
+            /// @p_Output : Output
+            void Append(std::size_t p_Offset, std::string& p_Output) const;
+            /// Get size of an argument
+            /// @p_Offset : Offset of argument in captured bytes
+            std::size_t GetArgumentSize(std::size_t p_Offset) const;
+
+        private:
+            uint8               m_Inline[LOG_ARGUMENTS_INLINE_SIZE];    ///< Captured bytes while they fit
+            std::vector<uint8>  m_Heap;                                 ///< Captured bytes once they did not fit
+            uint32              m_Size;                                 ///< Amount of captured bytes
+            uint32              m_Count;                                ///< Amount of captured arguments
+    };
+
+}   ///< namespace Logger
+}   ///< namespace Core
+}   ///< namespace SteerStone
@@ -0,0 +1,130 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "MemArena.hpp"
+#include "MemPoolResource.hpp"
+
+namespace SteerStone { namespace Core { namespace Memory {
+
+    /// Constructor
+    /// @p_BlockSize : Size of blocks the arena grows by
+    Arena::Arena(std::size_t p_BlockSize)
+        : Arena(nullptr, 0, p_BlockSize)
+    {
+    }
+    /// Constructor, the initial buffer is used before any block is allocated, usually on the stack
+    /// @p_Buffer    : Initial buffer
+    /// @p_Size      : Size of initial buffer
+    /// @p_BlockSize : Size of blocks the arena grows by
+    Arena::Arena(void* p_Buffer, std::size_t p_Size, std::size_t p_BlockSize)
+        : m_InitialBuffer(static_cast<char*>(p_Buffer)), m_InitialSize(p_Size), m_BlockSize(p_BlockSize), m_Blocks(nullptr),
+        m_Current(m_InitialBuffer), m_End(m_InitialBuffer + p_Size), m_Used(0)
+    {
+    }
+    /// Deconstructor
+    Arena::~Arena()
+    {
+        Reset();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Allocate memory
+    /// @p_Size      : Size of allocation
+    /// @p_Alignment : Alignment of allocation
+    void* Arena::Allocate(std::size_t p_Size, std::size_t p_Alignment)
+    {
+        std::uintptr_t l_Address = (reinterpret_cast<std::uintptr_t>(m_Current) + p_Alignment - 1) & ~(std::uintptr_t(p_Alignment) - 1);
+
+        if (!m_Current || l_Address + p_Size > reinterpret_cast<std::uintptr_t>(m_End))
+        {
+            Grow(p_Size, p_Alignment);
+            l_Address = (reinterpret_cast<std::uintptr_t>(m_Current) + p_Alignment - 1) & ~(std::uintptr_t(p_Alignment) - 1);
+        }
+
+        m_Current = reinterpret_cast<char*>(l_Address + p_Size);
+        m_Used += p_Size;
+
+        return reinterpret_cast<void*>(l_Address);
+    }
+    /// Release every allocation, the initial buffer is reused afterwards
+    void Arena::Reset()
+    {
+        while (m_Blocks)
+        {
+            Block* l_Block = m_Blocks;
+            m_Blocks = l_Block->Next;
+
+            PoolResource::GetDefault()->deallocate(l_Block, l_Block->Size);
+        }
+
+        m_Current   = m_InitialBuffer;
+        m_End       = m_InitialBuffer + m_InitialSize;
+        m_Used      = 0;
+    }
+
+    /// Get amount of bytes handed out since last reset
+    std::size_t Arena::GetUsed() const
+    {
+        return m_Used;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Allocate
+    /// @p_Size      : Size of allocation
+    /// @p_Alignment : Alignment of allocation
+    void* Arena::do_allocate(std::size_t p_Size, std::size_t p_Alignment)
+    {
+        return Allocate(p_Size, p_Alignment);
+    }
+    /// Deallocate, does nothing until the arena is reset
+    void Arena::do_deallocate(void*, std::size_t, std::size_t)
+    {
+    }
+    /// Compare resources
+    /// @p_Other : Other resource
+    bool Arena::do_is_equal(std::pmr::memory_resource const& p_Other) const noexcept
+    {
+        return this == &p_Other;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Allocate a new block big enough for an allocation
+    /// @p_Size      : Size of allocation
+    /// @p_Alignment : Alignment of allocation
+    void Arena::Grow(std::size_t p_Size, std::size_t p_Alignment)
+    {
+        const std::size_t l_Size = std::max(m_BlockSize, sizeof(Block) + p_Size + p_Alignment);
+
+        Block* l_Block = static_cast<Block*>(PoolResource::GetDefault()->allocate(l_Size));
+        l_Block->Next = m_Blocks;
+        l_Block->Size = l_Size;
+        m_Blocks = l_Block;
+
+        m_Current   = reinterpret_cast<char*>(l_Block + 1);
+        m_End       = reinterpret_cast<char*>(l_Block) + l_Size;
+    }
+
+}   ///< namespace Memory
+}   ///< namespace Core
+}   ///< namespace Steerstone
@@ -0,0 +1,102 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <memory_resource>
+#include <type_traits>
+
+#include "Core/Core.hpp"
+
+#define MEMORY_ARENA_BLOCK_SIZE     4096        ///< Size of blocks the arena grows by, taken from the default pool resource
+
+namespace SteerStone { namespace Core { namespace Memory {
+
+    /// Monotonic arena for allocations which all die at the end of a request
+    /// Allocation is a pointer bump, nothing is released before Reset or destruction
+    /// Can be handed to pmr containers as their memory resource
+    class Arena : public std::pmr::memory_resource
+    {
+        DISALLOW_COPY_AND_ASSIGN(Arena);
+
+        public:
+            /// Constructor
+            /// @p_BlockSize : Size of blocks the arena grows by
+            explicit Arena(std::size_t p_BlockSize = MEMORY_ARENA_BLOCK_SIZE);
+            /// Constructor, the initial buffer is used before any block is allocated, usually on the stack
+            /// @p_Buffer    : Initial buffer
+            /// @p_Size      : Size of initial buffer
+            /// @p_BlockSize : Size of blocks the arena grows by
+            Arena(void* p_Buffer, std::size_t p_Size, std::size_t p_BlockSize = MEMORY_ARENA_BLOCK_SIZE);
+            /// Deconstructor
+            ~Arena();
+
+            /// Allocate memory
+            /// @p_Size      : Size of allocation
+            /// @p_Alignment : Alignment of allocation
+            void* Allocate(std::size_t p_Size, std::size_t p_Alignment = alignof(std::max_align_t));
+            /// Create an object, its destructor is never called
+            /// @p_Args : Arguments forwarded to the constructor
+            template<typename T, typename... t_Args> T* Create(t_Args&&... p_Args)
+            {
+                static_assert(std::is_trivially_destructible<T>::value, "Arena never calls destructors");
+                return ::new (Allocate(sizeof(T), alignof(T))) T(std::forward<t_Args>(p_Args)...);
+            }
+            /// Release every allocation, the initial buffer is reused afterwards
+            void Reset();
+
+            /// Get amount of bytes handed out since last reset
+            std::size_t GetUsed() const;
+
+        protected:
+            /// Allocate
+            /// @p_Size      : Size of allocation
+            /// @p_Alignment : Alignment of allocation
+            void* do_allocate(std::size_t p_Size, std::size_t p_Alignment) override;
+            /// Deallocate, does nothing until the arena is reset
+            void do_deallocate(void*, std::size_t, std::size_t) override;
+            /// Compare resources
+            /// @p_Other : Other resource
+            bool do_is_equal(std::pmr::memory_resource const& p_Other) const noexcept override;
+
+        private:
+            /// Block header, the allocations follow it
+            struct Block
+            {
+                Block* Next;                    ///< Previously allocated block
+                std::size_t Size;               ///< Size of block including header
+            };
+
+            /// Allocate a new block big enough for an allocation
+            /// @p_Size      : Size of allocation
+            /// @p_Alignment : Alignment of allocation
+            void Grow(std::size_t p_Size, std::size_t p_Alignment);
+
+        private:
+            char* m_InitialBuffer;              ///< Initial buffer, not owned
+            std::size_t m_InitialSize;          ///< Size of initial buffer
+            std::size_t m_BlockSize;            ///< Size of blocks the arena grows by
+            Block* m_Blocks;                    ///< Allocated blocks
+            char* m_Current;                    ///< Next free byte
+            char* m_End;                        ///< End of current buffer
+            std::size_t m_Used;                 ///< Bytes handed out since last reset
+    };
+
+}   ///< namespace Memory
+}   ///< namespace Core
+}   ///< namespace SteerStone
@@ -0,0 +1,373 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <new>
+#if defined(__GNUC__)
+    #include <cxxabi.h>
+#endif
+
+#include "MemObjectPool.hpp"
+
+namespace SteerStone { namespace Core { namespace Memory {
+
+    /// Free list of a single pool in a thread
+    struct PoolCacheSlot
+    {
+        PoolBlock* FreeList;                    ///< Free blocks
+        std::atomic<uint32> Count;              ///< Only written by owning thread
+        std::atomic<uint64> Acquired;           ///< Only written by owning thread
+        std::atomic<uint64> Released;           ///< Only written by owning thread
+        std::atomic<uint64> Allocated;          ///< Only written by owning thread
+    };
+
+    /// Free lists of a single thread
+    struct PoolThreadCache
+    {
+        /// Constructor
+        PoolThreadCache();
+        /// Deconstructor
+        ~PoolThreadCache();
+
+        PoolCacheSlot Slots[MEMORY_POOL_MAX_POOLS];     ///< Free list per pool
+    };
+
+    /// Counters of threads which exited
+    struct PoolExitedCounters
+    {
+        uint64 Acquired;                        ///< Blocks handed out
+        uint64 Released;                        ///< Blocks returned
+        uint64 Allocated;                       ///< Blocks allocated from the heap
+    };
+
+    /// Every pool and thread cache, used to gather statistics and flush exiting threads
+    static std::mutex s_RegistryMutex;
+    static FixedPool* s_Pools[MEMORY_POOL_MAX_POOLS];
+    static uint32 s_PoolCount = 0;
+    static std::vector<PoolThreadCache*> s_Caches;
+    static PoolExitedCounters s_Exited[MEMORY_POOL_MAX_POOLS];
+    /// Cache of calling thread has been destroyed, objects released by later thread_local or static destructors go to the depot
+    static thread_local bool tl_CacheDestroyed = false;
+
+    /// Constructor
+    PoolThreadCache::PoolThreadCache()
+    {
+        for (PoolCacheSlot& l_Slot : Slots)
+        {
+            l_Slot.FreeList = nullptr;
+            l_Slot.Count.store(0, std::memory_order_relaxed);
+            l_Slot.Acquired.store(0, std::memory_order_relaxed);
+            l_Slot.Released.store(0, std::memory_order_relaxed);
+            l_Slot.Allocated.store(0, std::memory_order_relaxed);
+        }
+
+        std::lock_guard<std::mutex> l_Guard(s_RegistryMutex);
+        s_Caches.push_back(this);
+    }
+    /// Deconstructor
+    PoolThreadCache::~PoolThreadCache()
+    {
+        tl_CacheDestroyed = true;
+
+        std::lock_guard<std::mutex> l_Guard(s_RegistryMutex);
+        s_Caches.erase(std::remove(s_Caches.begin(), s_Caches.end(), this), s_Caches.end());
+
+        for (uint32 l_I = 0; l_I < s_PoolCount; l_I++)
+        {
+            PoolCacheSlot& l_Slot = Slots[l_I];
+
+            /// Blocks stay usable by other threads
+            if (l_Slot.FreeList)
+                s_Pools[l_I]->ReturnToDepot(l_Slot.FreeList, l_Slot.Count.load(std::memory_order_relaxed));
+
+            s_Exited[l_I].Acquired  += l_Slot.Acquired.load(std::memory_order_relaxed);
+            s_Exited[l_I].Released  += l_Slot.Released.load(std::memory_order_relaxed);
+            s_Exited[l_I].Allocated += l_Slot.Allocated.load(std::memory_order_relaxed);
+        }
+    }
+
+    /// Free lists of calling thread
+    static thread_local PoolThreadCache tl_Cache;
+
+    /// Increment counter only written by the owning thread
+    /// @p_Counter : Counter to increment
+    /// @p_Value   : Value to add
+    template<typename T> static inline void Increment(std::atomic<T>& p_Counter, T p_Value = 1)
+    {
+        p_Counter.store(p_Counter.load(std::memory_order_relaxed) + p_Value, std::memory_order_relaxed);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get statistics of every pool
+    std::vector<PoolStatistics> FixedPool::GetAllStatistics()
+    {
+        std::vector<FixedPool*> l_Pools;
+
+        {
+            std::lock_guard<std::mutex> l_Guard(s_RegistryMutex);
+            l_Pools.assign(s_Pools, s_Pools + s_PoolCount);
+        }
+
+        std::vector<PoolStatistics> l_Statistics;
+        l_Statistics.reserve(l_Pools.size());
+
+        for (FixedPool const* l_Pool : l_Pools)
+            l_Statistics.push_back(l_Pool->GetStatistics());
+
+        return l_Statistics;
+    }
+    /// Get readable name of a type
+    /// @p_Type : Type
+    std::string FixedPool::GetTypeName(std::type_info const& p_Type)
+    {
+#if defined(__GNUC__)
+        int l_Status = 0;
+        char* l_Demangled = abi::__cxa_demangle(p_Type.name(), nullptr, nullptr, &l_Status);
+
+        if (l_Demangled)
+        {
+            std::string l_Name(l_Demangled);
+            std::free(l_Demangled);
+            return l_Name;
+        }
+#endif
+        std::string l_Name(p_Type.name());
+
+        for (std::string_view l_Prefix : { std::string_view("class "), std::string_view("struct ") })
+        {
+            if (l_Name.compare(0, l_Prefix.size(), l_Prefix) == 0)
+                return l_Name.substr(l_Prefix.size());
+        }
+
+        return l_Name;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor, pools are never destroyed as thread caches return their blocks on thread exit
+    /// @p_Name      : Name of pool
+    /// @p_BlockSize : Size of blocks
+    FixedPool::FixedPool(std::string const& p_Name, std::size_t p_BlockSize)
+        : m_Name(p_Name), m_BlockSize(std::max(p_BlockSize, sizeof(PoolBlock))), m_Index(MEMORY_POOL_MAX_POOLS),
+        m_Depot(nullptr), m_DepotCount(0), m_Acquired(0), m_Released(0), m_Allocated(0)
+    {
+        std::lock_guard<std::mutex> l_Guard(s_RegistryMutex);
+
+        if (s_PoolCount < MEMORY_POOL_MAX_POOLS)
+        {
+            m_Index = s_PoolCount;
+            s_Pools[s_PoolCount++] = this;
+        }
+    }
+
+    /// Acquire a block
+    void* FixedPool::Allocate()
+    {
+        /// Pools without thread cache share the depot directly
+        if (m_Index == MEMORY_POOL_MAX_POOLS || tl_CacheDestroyed)
+        {
+            m_Acquired.fetch_add(1, std::memory_order_relaxed);
+
+            {
+                std::lock_guard<std::mutex> l_Guard(m_DepotMutex);
+
+                if (PoolBlock* l_Block = m_Depot)
+                {
+                    m_Depot = l_Block->Next;
+                    m_DepotCount--;
+                    return l_Block;
+                }
+            }
+
+            m_Allocated.fetch_add(1, std::memory_order_relaxed);
+            return ::operator new(m_BlockSize);
+        }
+
+        PoolCacheSlot& l_Slot = tl_Cache.Slots[m_Index];
+        Increment<uint64>(l_Slot.Acquired);
+
+        if (!l_Slot.FreeList)
+            l_Slot.Count.store(TakeFromDepot(l_Slot.FreeList), std::memory_order_relaxed);
+
+        if (PoolBlock* l_Block = l_Slot.FreeList)
+        {
+            l_Slot.FreeList = l_Block->Next;
+            Increment<uint32>(l_Slot.Count, uint32(-1));
+            return l_Block;
+        }
+
+        Increment<uint64>(l_Slot.Allocated);
+        return ::operator new(m_BlockSize);
+    }
+    /// Return a block to the pool
+    /// @p_Block : Block to return
+    void FixedPool::Release(void* p_Block)
+    {
+        if (!p_Block)
+            return;
+
+        PoolBlock* l_Block = static_cast<PoolBlock*>(p_Block);
+
+        if (m_Index == MEMORY_POOL_MAX_POOLS || tl_CacheDestroyed)
+        {
+            m_Released.fetch_add(1, std::memory_order_relaxed);
+            l_Block->Next = nullptr;
+            ReturnToDepot(l_Block, 1);
+            return;
+        }
+
+        PoolCacheSlot& l_Slot = tl_Cache.Slots[m_Index];
+        Increment<uint64>(l_Slot.Released);
+
+        l_Block->Next = l_Slot.FreeList;
+        l_Slot.FreeList = l_Block;
+        Increment<uint32>(l_Slot.Count);
+
+        if (l_Slot.Count.load(std::memory_order_relaxed) <= MEMORY_POOL_CACHE_SIZE)
+            return;
+
+        /// Hand a batch over to the depot so threads which only release do not hoard blocks
+        PoolBlock* l_Batch = l_Slot.FreeList;
+        PoolBlock* l_Last  = l_Batch;
+
+        for (uint32 l_I = 1; l_I < MEMORY_POOL_BATCH_SIZE; l_I++)
+            l_Last = l_Last->Next;
+
+        l_Slot.FreeList = l_Last->Next;
+        l_Last->Next = nullptr;
+        Increment<uint32>(l_Slot.Count, uint32(-MEMORY_POOL_BATCH_SIZE));
+
+        ReturnToDepot(l_Batch, MEMORY_POOL_BATCH_SIZE);
+    }
+
+    /// Get name of pool
+    std::string const& FixedPool::GetName() const
+    {
+        return m_Name;
+    }
+    /// Get size of blocks
+    std::size_t FixedPool::GetBlockSize() const
+    {
+        return m_BlockSize;
+    }
+    /// Get statistics of pool
+    PoolStatistics FixedPool::GetStatistics() const
+    {
+        uint64 l_Acquired   = m_Acquired.load(std::memory_order_relaxed);
+        uint64 l_Released   = m_Released.load(std::memory_order_relaxed);
+        uint64 l_Allocated  = m_Allocated.load(std::memory_order_relaxed);
+        uint64 l_Cached     = 0;
+
+        {
+            std::lock_guard<std::mutex> l_Guard(s_RegistryMutex);
+
+            if (m_Index != MEMORY_POOL_MAX_POOLS)
+            {
+                l_Acquired  += s_Exited[m_Index].Acquired;
+                l_Released  += s_Exited[m_Index].Released;
+                l_Allocated += s_Exited[m_Index].Allocated;
+
+                for (PoolThreadCache const* l_Cache : s_Caches)
+                {
+                    PoolCacheSlot const& l_Slot = l_Cache->Slots[m_Index];
+
+                    l_Acquired  += l_Slot.Acquired.load(std::memory_order_relaxed);
+                    l_Released  += l_Slot.Released.load(std::memory_order_relaxed);
+                    l_Allocated += l_Slot.Allocated.load(std::memory_order_relaxed);
+                    l_Cached    += l_Slot.Count.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> l_Guard(m_DepotMutex);
+            l_Cached += m_DepotCount;
+        }
+
+        PoolStatistics l_Statistics;
+        l_Statistics.Name       = m_Name;
+        l_Statistics.BlockSize  = m_BlockSize;
+        l_Statistics.Acquired   = l_Acquired;
+        l_Statistics.Allocated  = l_Allocated;
+        l_Statistics.InUse      = l_Acquired > l_Released ? l_Acquired - l_Released : 0;
+        l_Statistics.Cached     = l_Cached;
+
+        return l_Statistics;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Take a batch of blocks from the depot
+    /// @p_List : Taken blocks
+    uint32 FixedPool::TakeFromDepot(PoolBlock*& p_List)
+    {
+        std::lock_guard<std::mutex> l_Guard(m_DepotMutex);
+
+        PoolBlock* l_Last = m_Depot;
+        if (!l_Last)
+            return 0;
+
+        uint32 l_Count = 1;
+        while (l_Count < MEMORY_POOL_BATCH_SIZE && l_Last->Next)
+        {
+            l_Last = l_Last->Next;
+            l_Count++;
+        }
+
+        p_List  = m_Depot;
+        m_Depot = l_Last->Next;
+        l_Last->Next = nullptr;
+        m_DepotCount -= l_Count;
+
+        return l_Count;
+    }
+    /// Give blocks back to the depot
+    /// @p_List  : Blocks to give back
+    /// @p_Count : Amount of blocks in list
+    void FixedPool::ReturnToDepot(PoolBlock* p_List, uint32 p_Count)
+    {
+        {
+            std::lock_guard<std::mutex> l_Guard(m_DepotMutex);
+
+            if (m_DepotCount + p_Count <= MEMORY_POOL_DEPOT_SIZE)
+            {
+                PoolBlock* l_Last = p_List;
+                while (l_Last->Next)
+                    l_Last = l_Last->Next;
+
+                l_Last->Next = m_Depot;
+                m_Depot = p_List;
+                m_DepotCount += p_Count;
+                return;
+            }
+        }
+
+        while (p_List)
+        {
+            PoolBlock* l_Block = p_List;
+            p_List = l_Block->Next;
+            ::operator delete(l_Block);
+        }
+    }
+
+}   ///< namespace Memory
+}   ///< namespace Core
+}   ///< namespace Steerstone
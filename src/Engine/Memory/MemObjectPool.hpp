@@ -0,0 +1,225 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <typeinfo>
+
+#include "Core/Core.hpp"
+
+#define MEMORY_POOL_MAX_POOLS       64          ///< Pools with a thread cache, pools registered after that go straight to the depot
+#define MEMORY_POOL_CACHE_SIZE      64          ///< Blocks kept per pool and thread, half of them go to the depot when exceeded
+#define MEMORY_POOL_BATCH_SIZE      32          ///< Blocks moved between a thread cache and the depot at once
+#define MEMORY_POOL_DEPOT_SIZE      4096        ///< Blocks kept in the depot, the rest goes back to the heap
+
+namespace SteerStone { namespace Core { namespace Memory {
+
+    /// Pool statistics
+    struct PoolStatistics
+    {
+        std::string Name;                       ///< Name of pool
+        std::size_t BlockSize;                  ///< Size of blocks
+        uint64 Acquired;                        ///< Blocks handed out
+        uint64 Allocated;                       ///< Blocks which had to be allocated from the heap
+        uint64 InUse;                           ///< Blocks currently handed out
+        uint64 Cached;                          ///< Blocks currently held in thread caches and the depot
+    };
+
+    /// Free block, stored inside the released memory itself
+    struct PoolBlock
+    {
+        PoolBlock* Next;                        ///< Next free block
+    };
+
+    /// Pool of fixed size blocks
+    /// Every thread keeps a free list per pool which is used without locking, blocks
+    /// released on another thread than the one which acquired them flow back through the depot
+    class FixedPool
+    {
+        DISALLOW_COPY_AND_ASSIGN(FixedPool);
+
+        public:
+            /// Get statistics of every pool
+            static std::vector<PoolStatistics> GetAllStatistics();
+            /// Get readable name of a type
+            /// @p_Type : Type
+            static std::string GetTypeName(std::type_info const& p_Type);
+
+        public:
+            /// Constructor, pools are never destroyed as thread caches return their blocks on thread exit
+            /// @p_Name      : Name of pool
+            /// @p_BlockSize : Size of blocks
+            FixedPool(std::string const& p_Name, std::size_t p_BlockSize);
+
+            /// Acquire a block
+            void* Allocate();
+            /// Return a block to the pool
+            /// @p_Block : Block to return
+            void Release(void* p_Block);
+
+            /// Get name of pool
+            std::string const& GetName() const;
+            /// Get size of blocks
+            std::size_t GetBlockSize() const;
+            /// Get statistics of pool
+            PoolStatistics GetStatistics() const;
+
+            /// Take a batch of blocks from the depot
+            /// @p_List : Taken blocks
+            uint32 TakeFromDepot(PoolBlock*& p_List);
+            /// Give blocks back to the depot
+            /// @p_List  : Blocks to give back
+            /// @p_Count : Amount of blocks in list
+            void ReturnToDepot(PoolBlock* p_List, uint32 p_Count);
+
+        private:
+            std::string m_Name;                     ///< Name of pool
+            std::size_t m_BlockSize;                ///< Size of blocks
+            uint32 m_Index;                         ///< Slot in thread caches, MEMORY_POOL_MAX_POOLS if the pool has none
+            mutable std::mutex m_DepotMutex;        ///< Protects depot
+            PoolBlock* m_Depot;                     ///< Free blocks shared by every thread
+            uint32 m_DepotCount;                    ///< Blocks in depot
+            std::atomic<uint64> m_Acquired;         ///< Blocks handed out by a pool without thread cache
+            std::atomic<uint64> m_Released;         ///< Blocks returned to a pool without thread cache
+            std::atomic<uint64> m_Allocated;        ///< Blocks allocated by a pool without thread cache
+    };
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Typed pool of objects
+    /// @t_Owner : Type the pool is named after, types allocated on behalf of it like shared_ptr control blocks get their own pool
+    template<typename T, typename t_Owner = T> class ObjectPool
+    {
+        public:
+            /// Get pool holding objects of this type
+            static FixedPool& GetPool()
+            {
+                static_assert(alignof(T) <= alignof(std::max_align_t), "Pooled objects can not be over aligned");
+
+                static FixedPool* s_Pool = new FixedPool(std::is_same<T, t_Owner>::value ? FixedPool::GetTypeName(typeid(t_Owner)) : FixedPool::GetTypeName(typeid(t_Owner)) + " (shared)", sizeof(T));
+                return *s_Pool;
+            }
+
+            /// Create an object
+            /// @p_Args : Arguments forwarded to the constructor
+            template<typename... t_Args> static T* Create(t_Args&&... p_Args)
+            {
+                void* l_Memory = GetPool().Allocate();
+
+                try
+                {
+                    return ::new (l_Memory) T(std::forward<t_Args>(p_Args)...);
+                }
+                catch (...)
+                {
+                    GetPool().Release(l_Memory);
+                    throw;
+                }
+            }
+            /// Destroy an object created by Create
+            /// @p_Object : Object to destroy
+            static void Destroy(T* p_Object)
+            {
+                if (!p_Object)
+                    return;
+
+                p_Object->~T();
+                GetPool().Release(p_Object);
+            }
+
+            /// Create a shared object, the object and its control block come from pools
+            /// @p_Args : Arguments forwarded to the constructor
+            template<typename... t_Args> static std::shared_ptr<T> MakeShared(t_Args&&... p_Args);
+    };
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Standard allocator over ObjectPool, single objects come from the pool and arrays from the heap
+    template<typename T, typename t_Owner = T> class PoolAllocator
+    {
+        public:
+            using value_type = T;
+
+            template<typename U> struct rebind
+            {
+                using other = PoolAllocator<U, t_Owner>;
+            };
+
+        public:
+            /// Constructor
+            PoolAllocator() noexcept = default;
+            /// Constructor
+            template<typename U> PoolAllocator(PoolAllocator<U, t_Owner> const&) noexcept {}
+
+            /// Allocate
+            /// @p_Count : Amount of objects
+            T* allocate(std::size_t p_Count)
+            {
+                if (p_Count == 1)
+                    return static_cast<T*>(ObjectPool<T, t_Owner>::GetPool().Allocate());
+
+                return static_cast<T*>(::operator new(p_Count * sizeof(T)));
+            }
+            /// Deallocate
+            /// @p_Pointer : Objects to release
+            /// @p_Count   : Amount of objects
+            void deallocate(T* p_Pointer, std::size_t p_Count)
+            {
+                if (p_Count == 1)
+                    ObjectPool<T, t_Owner>::GetPool().Release(p_Pointer);
+                else
+                    ::operator delete(p_Pointer);
+            }
+
+            /// Compare allocators, all of them share the same pools
+            template<typename U> bool operator==(PoolAllocator<U, t_Owner> const&) const noexcept { return true; }
+            /// Compare allocators, all of them share the same pools
+            template<typename U> bool operator!=(PoolAllocator<U, t_Owner> const&) const noexcept { return false; }
+    };
+
+    /// Create a shared object, the object and its control block come from pools
+    /// @p_Args : Arguments forwarded to the constructor
+    template<typename T, typename t_Owner> template<typename... t_Args> std::shared_ptr<T> ObjectPool<T, t_Owner>::MakeShared(t_Args&&... p_Args)
+    {
+        return std::allocate_shared<T>(PoolAllocator<T, t_Owner>(), std::forward<t_Args>(p_Args)...);
+    }
+
+}   ///< namespace Memory
+}   ///< namespace Core
+}   ///< namespace SteerStone
+
+/// Route new and delete of a class through its object pool, derived classes of another size use the heap
+#define MEMORY_POOL_OPERATORS(p_Type)                                                                                   \
+    static void* operator new(std::size_t p_Size)                                                                       \
+    {                                                                                                                   \
+        if (p_Size != sizeof(p_Type))                                                                                   \
+            return ::operator new(p_Size);                                                                              \
+        return ::SteerStone::Core::Memory::ObjectPool<p_Type>::GetPool().Allocate();                                    \
+    }                                                                                                                   \
+    static void operator delete(void* p_Pointer, std::size_t p_Size)                                                    \
+    {                                                                                                                   \
+        if (p_Size != sizeof(p_Type))                                                                                   \
+            ::operator delete(p_Pointer);                                                                               \
+        else                                                                                                            \
+            ::SteerStone::Core::Memory::ObjectPool<p_Type>::GetPool().Release(p_Pointer);                               \
+    }
@@ -0,0 +1,98 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <new>
+
+#include "MemPoolResource.hpp"
+
+namespace SteerStone { namespace Core { namespace Memory {
+
+    /// Get size class of allocation, MEMORY_RESOURCE_CLASSES if too big
+    /// @p_Size : Size of allocation
+    static inline uint32 GetSizeClass(std::size_t p_Size)
+    {
+        uint32 l_Class = 0;
+
+        while (l_Class < MEMORY_RESOURCE_CLASSES && p_Size > (std::size_t(1) << (MEMORY_RESOURCE_MIN_SHIFT + l_Class)))
+            l_Class++;
+
+        return l_Class;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get resource shared by the engine
+    PoolResource* PoolResource::GetDefault()
+    {
+        /// Never destroyed, buffers may be released by static destructors
+        static PoolResource* s_Resource = new PoolResource();
+        return s_Resource;
+    }
+
+    /// Constructor
+    PoolResource::PoolResource()
+    {
+        for (uint32 l_I = 0; l_I < MEMORY_RESOURCE_CLASSES; l_I++)
+        {
+            const std::size_t l_Size = std::size_t(1) << (MEMORY_RESOURCE_MIN_SHIFT + l_I);
+            m_Classes[l_I] = new FixedPool("PoolResource " + std::to_string(l_Size), l_Size);
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Allocate
+    /// @p_Size      : Size of allocation
+    /// @p_Alignment : Alignment of allocation
+    void* PoolResource::do_allocate(std::size_t p_Size, std::size_t p_Alignment)
+    {
+        const uint32 l_Class = GetSizeClass(p_Size);
+
+        if (l_Class == MEMORY_RESOURCE_CLASSES || p_Alignment > alignof(std::max_align_t))
+            return std::pmr::new_delete_resource()->allocate(p_Size, p_Alignment);
+
+        return m_Classes[l_Class]->Allocate();
+    }
+    /// Deallocate
+    /// @p_Pointer   : Allocation to release
+    /// @p_Size      : Size of allocation
+    /// @p_Alignment : Alignment of allocation
+    void PoolResource::do_deallocate(void* p_Pointer, std::size_t p_Size, std::size_t p_Alignment)
+    {
+        const uint32 l_Class = GetSizeClass(p_Size);
+
+        if (l_Class == MEMORY_RESOURCE_CLASSES || p_Alignment > alignof(std::max_align_t))
+        {
+            std::pmr::new_delete_resource()->deallocate(p_Pointer, p_Size, p_Alignment);
+            return;
+        }
+
+        m_Classes[l_Class]->Release(p_Pointer);
+    }
+    /// Compare resources
+    /// @p_Other : Other resource
+    bool PoolResource::do_is_equal(std::pmr::memory_resource const& p_Other) const noexcept
+    {
+        return this == &p_Other;
+    }
+
+}   ///< namespace Memory
+}   ///< namespace Core
+}   ///< namespace Steerstone
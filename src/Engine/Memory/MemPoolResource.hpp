@@ -0,0 +1,92 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <memory>
+#include <memory_resource>
+
+#include "Core/Core.hpp"
+#include "Memory/MemObjectPool.hpp"
+
+#define MEMORY_RESOURCE_CLASSES     11          ///< 64 B up to 64 KB
+#define MEMORY_RESOURCE_MIN_SHIFT   6           ///< Smallest class is 1 << 6 bytes
+
+namespace SteerStone { namespace Core { namespace Memory {
+
+    /// Memory resource routing allocations to size classed FixedPools, bigger or over aligned allocations go to the heap
+    class PoolResource : public std::pmr::memory_resource
+    {
+        DISALLOW_COPY_AND_ASSIGN(PoolResource);
+
+        public:
+            /// Get resource shared by the engine
+            static PoolResource* GetDefault();
+
+        private:
+            /// Constructor
+            PoolResource();
+
+        protected:
+            /// Allocate
+            /// @p_Size      : Size of allocation
+            /// @p_Alignment : Alignment of allocation
+            void* do_allocate(std::size_t p_Size, std::size_t p_Alignment) override;
+            /// Deallocate
+            /// @p_Pointer   : Allocation to release
+            /// @p_Size      : Size of allocation
+            /// @p_Alignment : Alignment of allocation
+            void do_deallocate(void* p_Pointer, std::size_t p_Size, std::size_t p_Alignment) override;
+            /// Compare resources
+            /// @p_Other : Other resource
+            bool do_is_equal(std::pmr::memory_resource const& p_Other) const noexcept override;
+
+        private:
+            FixedPool* m_Classes[MEMORY_RESOURCE_CLASSES];      ///< Pool per size class
+    };
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Deleter of buffers allocated from the default pool resource
+    struct PoolBufferDeleter
+    {
+        std::size_t Size = 0;                   ///< Size of buffer
+
+        /// Release buffer
+        /// @p_Buffer : Buffer to release
+        void operator()(char* p_Buffer) const
+        {
+            if (p_Buffer)
+                PoolResource::GetDefault()->deallocate(p_Buffer, Size);
+        }
+    };
+
+    /// Raw buffer allocated from the default pool resource
+    using PoolBuffer = std::unique_ptr<char[], PoolBufferDeleter>;
+
+    /// Allocate raw buffer from the default pool resource
+    /// @p_Size : Size of buffer
+    inline PoolBuffer AllocatePoolBuffer(std::size_t p_Size)
+    {
+        return PoolBuffer(static_cast<char*>(PoolResource::GetDefault()->allocate(p_Size)), PoolBufferDeleter{ p_Size });
+    }
+
+}   ///< namespace Memory
+}   ///< namespace Core
+}   ///< namespace SteerStone
@@ -0,0 +1,127 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "MetHttpListener.hpp"
+#include "MetRegistry.hpp"
+
+namespace SteerStone { namespace Core { namespace Metrics {
+
+    /// Constructor
+    /// @p_Service      : Boost Service
+    /// @p_Owner        : Owner told once we are closed
+    MetricsSocket::MetricsSocket(boost::asio::io_service& p_Service, Network::SocketOwner* p_Owner)
+        : Socket(p_Service, p_Owner)
+    {
+        /// A scrape is a single response, send it right away
+        Network::FlushPolicySettings l_FlushPolicy;
+        l_FlushPolicy.Policy        = Network::FlushPolicy::Immediate;
+        l_FlushPolicy.ByteThreshold = 0;
+        l_FlushPolicy.Timeout       = 0;
+        SetFlushPolicy(l_FlushPolicy);
+
+        SetIdleTimeout(METRICS_HTTP_IDLE_TIMEOUT);
+        SetBufferReleaseDelay(1000);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Handle incoming requests
+    Network::ProcessState MetricsSocket::ProcessIncomingData()
+    {
+        for (;;)
+        {
+            const std::string_view l_Data = InView().ToStringView();
+            const std::size_t l_HeadEnd = l_Data.find("\r\n\r\n");
+
+            if (l_HeadEnd == std::string_view::npos)
+                return l_Data.size() > METRICS_HTTP_MAX_REQUEST ? Network::ProcessState::Error : Network::ProcessState::Successful;
+
+            /// Request line is "METHOD TARGET VERSION", headers are not needed and requests have no body
+            const std::string_view l_Line = l_Data.substr(0, l_Data.find("\r\n"));
+            const std::size_t l_MethodEnd = l_Line.find(' ');
+            const std::size_t l_TargetEnd = l_MethodEnd == std::string_view::npos ? std::string_view::npos : l_Line.find(' ', l_MethodEnd + 1);
+
+            if (l_TargetEnd == std::string_view::npos)
+            {
+                SendResponse("400 Bad Request", "text/plain", "Bad Request\n");
+                return Network::ProcessState::Error;
+            }
+
+            if (!HandleRequest(l_Line.substr(0, l_MethodEnd), l_Line.substr(l_MethodEnd + 1, l_TargetEnd - l_MethodEnd - 1)))
+                return Network::ProcessState::Error;
+
+            ReadSkip(l_HeadEnd + 4);
+        }
+    }
+
+    /// Answer request
+    /// @p_Method : Request method
+    /// @p_Target : Request target
+    /// Returns false if connection must be closed
+    bool MetricsSocket::HandleRequest(std::string_view const p_Method, std::string_view const p_Target)
+    {
+        if (p_Method != "GET")
+        {
+            SendResponse("405 Method Not Allowed", "text/plain", "Method Not Allowed\n");
+            return true;
+        }
+
+        const std::string_view l_Path = p_Target.substr(0, p_Target.find('?'));
+
+        if (l_Path != "/metrics")
+        {
+            SendResponse("404 Not Found", "text/plain", "Not Found\n");
+            return true;
+        }
+
+        SendResponse("200 OK", "text/plain; version=0.0.4; charset=utf-8", sMetrics->Scrape());
+        return true;
+    }
+    /// Send response
+    /// @p_Status      : Status line such as "200 OK"
+    /// @p_ContentType : Content type
+    /// @p_Body        : Body
+    void MetricsSocket::SendResponse(std::string_view const p_Status, std::string_view const p_ContentType, std::string_view const p_Body)
+    {
+        std::string l_Response;
+        l_Response.reserve(128 + p_Body.size());
+
+        l_Response.append("HTTP/1.1 ").append(p_Status).append("\r\n");
+        l_Response.append("Content-Type: ").append(p_ContentType).append("\r\n");
+        l_Response.append("Content-Length: ").append(std::to_string(p_Body.size())).append("\r\n\r\n");
+        l_Response.append(p_Body);
+
+        Write(l_Response.data(), l_Response.size());
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    /// @p_Address : IP Address
+    /// @p_Port    : Port
+    /// @p_Pool    : Network threads our sockets are served by, must outlive us
+    MetricsListener::MetricsListener(std::string const& p_Address, uint16 p_Port, Network::NetworkThreadPool& p_Pool)
+        : Listener<MetricsSocket>(p_Address, p_Port, p_Pool)
+    {
+    }
+
+}   ///< namespace Metrics
+}   ///< namespace Core
+}   ///< namespace SteerStone
@@ -0,0 +1,72 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <string_view>
+
+#include "Core/Core.hpp"
+#include "Network/Listener.hpp"
+#include "Network/Socket.hpp"
+
+#define METRICS_HTTP_MAX_REQUEST    8192        ///< Longest request head, bigger requests close the connection
+#define METRICS_HTTP_IDLE_TIMEOUT   60000       ///< Milliseconds a scraper may keep its connection open without a request
+
+namespace SteerStone { namespace Core { namespace Metrics {
+
+    /// Minimal HTTP/1.1 server socket answering GET /metrics with a scrape of the registry
+    /// Connections are kept alive between scrapes and closed once idle, every response carries a Content-Length
+    class MetricsSocket : public Network::Socket
+    {
+        public:
+            /// Constructor
+            /// @p_Service      : Boost Service
+            /// @p_Owner        : Owner told once we are closed
+            MetricsSocket(boost::asio::io_service& p_Service, Network::SocketOwner* p_Owner);
+
+        protected:
+            /// Handle incoming requests
+            Network::ProcessState ProcessIncomingData() override;
+
+        private:
+            /// Answer request
+            /// @p_Method : Request method
+            /// @p_Target : Request target
+            /// Returns false if connection must be closed
+            bool HandleRequest(std::string_view const p_Method, std::string_view const p_Target);
+            /// Send response
+            /// @p_Status      : Status line such as "200 OK"
+            /// @p_ContentType : Content type
+            /// @p_Body        : Body
+            void SendResponse(std::string_view const p_Status, std::string_view const p_ContentType, std::string_view const p_Body);
+    };
+
+    /// Listener of the metrics endpoint, served by the network threads of the game
+    class MetricsListener : public Network::Listener<MetricsSocket>
+    {
+        public:
+            /// Constructor
+            /// @p_Address : IP Address
+            /// @p_Port    : Port
+            /// @p_Pool    : Network threads our sockets are served by, must outlive us
+            MetricsListener(std::string const& p_Address, uint16 p_Port, Network::NetworkThreadPool& p_Pool);
+    };
+
+}   ///< namespace Metrics
+}   ///< namespace Core
+}   ///< namespace SteerStone
@@ -0,0 +1,500 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cstdio>
+
+#include "MetRegistry.hpp"
+#include "Logger/Base.hpp"
+
+namespace SteerStone { namespace Core { namespace Metrics {
+
+    /// Format floating point value the way Prometheus parses it
+    /// @p_Buffer : Output
+    /// @p_Size   : Size of output
+    /// @p_Value  : Value
+    static void FormatDouble(char* p_Buffer, std::size_t p_Size, double p_Value)
+    {
+        if (p_Value != p_Value)
+            snprintf(p_Buffer, p_Size, "NaN");
+        else if (p_Value > 1.7976931348623157e308)
+            snprintf(p_Buffer, p_Size, "+Inf");
+        else if (p_Value < -1.7976931348623157e308)
+            snprintf(p_Buffer, p_Size, "-Inf");
+        else
+            snprintf(p_Buffer, p_Size, "%.12g", p_Value);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    Counter::Counter()
+    {
+        for (Cell& l_Cell : m_Cells)
+            l_Cell.Value.store(0, std::memory_order_relaxed);
+    }
+    /// Get sum of every cell
+    uint64 Counter::GetValue() const
+    {
+        uint64 l_Value = 0;
+
+        for (Cell const& l_Cell : m_Cells)
+            l_Value += l_Cell.Value.load(std::memory_order_relaxed);
+
+        return l_Value;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    Gauge::Gauge()
+        : m_Value(0)
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    /// @p_Bounds : Inclusive upper bounds of buckets in ascending order, at most METRICS_HISTOGRAM_BUCKETS
+    /// @p_Unit   : Scrapes report values multiplied by this, such as 1e-9 for nanoseconds written as seconds
+    Histogram::Histogram(std::vector<uint64> const& p_Bounds, double p_Unit)
+        : m_BoundCount(static_cast<uint32>(std::min<std::size_t>(p_Bounds.size(), METRICS_HISTOGRAM_BUCKETS))), m_Unit(p_Unit)
+    {
+        for (uint32 l_I = 0; l_I < m_BoundCount; ++l_I)
+            m_Bounds[l_I] = p_Bounds[l_I];
+
+        for (Cell& l_Cell : m_Cells)
+        {
+            for (std::atomic<uint64>& l_Bucket : l_Cell.Buckets)
+                l_Bucket.store(0, std::memory_order_relaxed);
+
+            l_Cell.Sum.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /// Get amount of bucket bounds
+    uint32 Histogram::GetBoundCount() const
+    {
+        return m_BoundCount;
+    }
+    /// Get bound of bucket
+    /// @p_Bucket : Bucket index
+    uint64 Histogram::GetBound(uint32 p_Bucket) const
+    {
+        return m_Bounds[p_Bucket];
+    }
+    /// Get unit values are reported in
+    double Histogram::GetUnit() const
+    {
+        return m_Unit;
+    }
+    /// Get observations of every bucket summed over every cell, the last bucket holds values above every bound
+    /// @p_Counts : Output, GetBoundCount() + 1 counts
+    /// Returns sum of observations
+    uint64 Histogram::GetCounts(uint64* p_Counts) const
+    {
+        uint64 l_Sum = 0;
+
+        for (uint32 l_I = 0; l_I <= m_BoundCount; ++l_I)
+            p_Counts[l_I] = 0;
+
+        for (Cell const& l_Cell : m_Cells)
+        {
+            for (uint32 l_I = 0; l_I <= m_BoundCount; ++l_I)
+                p_Counts[l_I] += l_Cell.Buckets[l_I].load(std::memory_order_relaxed);
+
+            l_Sum += l_Cell.Sum.load(std::memory_order_relaxed);
+        }
+
+        return l_Sum;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    /// @p_Output : Text is appended to it
+    MetricWriter::MetricWriter(std::string& p_Output)
+        : m_Output(p_Output)
+    {
+    }
+
+    /// Write help and type of a family, once before its samples
+    /// @p_Name : Family name
+    /// @p_Help : Description
+    /// @p_Type : Type
+    void MetricWriter::WriteFamily(std::string_view const p_Name, std::string_view const p_Help, MetricType p_Type)
+    {
+        m_Output.append("# HELP ").append(p_Name).append(" ");
+
+        for (const char l_Char : p_Help)
+        {
+            if (l_Char == '\\')
+                m_Output.append("\\\\");
+            else if (l_Char == '\n')
+                m_Output.append("\\n");
+            else
+                m_Output.push_back(l_Char);
+        }
+
+        m_Output.append("\n# TYPE ").append(p_Name);
+
+        switch (p_Type)
+        {
+            case MetricType::Counter:
+                m_Output.append(" counter\n");
+                break;
+            case MetricType::Gauge:
+                m_Output.append(" gauge\n");
+                break;
+            case MetricType::Histogram:
+                m_Output.append(" histogram\n");
+                break;
+        }
+    }
+    /// Write integer sample
+    /// @p_Name   : Sample name
+    /// @p_Labels : Labels
+    /// @p_Value  : Value
+    void MetricWriter::WriteSample(std::string_view const p_Name, MetricLabels const& p_Labels, uint64 p_Value)
+    {
+        WriteSeries(p_Name, p_Labels);
+        m_Output.append(" ").append(std::to_string(p_Value)).append("\n");
+    }
+    /// Write signed sample
+    /// @p_Name   : Sample name
+    /// @p_Labels : Labels
+    /// @p_Value  : Value
+    void MetricWriter::WriteSample(std::string_view const p_Name, MetricLabels const& p_Labels, int64 p_Value)
+    {
+        WriteSeries(p_Name, p_Labels);
+        m_Output.append(" ").append(std::to_string(p_Value)).append("\n");
+    }
+    /// Write floating point sample
+    /// @p_Name   : Sample name
+    /// @p_Labels : Labels
+    /// @p_Value  : Value
+    void MetricWriter::WriteSample(std::string_view const p_Name, MetricLabels const& p_Labels, double p_Value)
+    {
+        WriteSeries(p_Name, p_Labels);
+        m_Output.append(" ");
+        WriteDouble(p_Value);
+        m_Output.append("\n");
+    }
+    /// Write samples of a histogram, buckets are cumulative
+    /// @p_Name      : Family name
+    /// @p_Labels    : Labels
+    /// @p_Histogram : Histogram
+    void MetricWriter::WriteHistogram(std::string_view const p_Name, MetricLabels const& p_Labels, Histogram const& p_Histogram)
+    {
+        uint64 l_Counts[METRICS_HISTOGRAM_BUCKETS + 1];
+        const uint64 l_Sum = p_Histogram.GetCounts(l_Counts);
+        const std::string l_Bucket = std::string(p_Name) + "_bucket";
+
+        uint64 l_Cumulative = 0;
+        char l_Bound[32];
+
+        for (uint32 l_I = 0; l_I <= p_Histogram.GetBoundCount(); ++l_I)
+        {
+            l_Cumulative += l_Counts[l_I];
+
+            if (l_I < p_Histogram.GetBoundCount())
+                FormatDouble(l_Bound, sizeof(l_Bound), static_cast<double>(p_Histogram.GetBound(l_I)) * p_Histogram.GetUnit());
+            else
+                snprintf(l_Bound, sizeof(l_Bound), "+Inf");
+
+            WriteSeries(l_Bucket, p_Labels, "le", l_Bound);
+            m_Output.append(" ").append(std::to_string(l_Cumulative)).append("\n");
+        }
+
+        WriteSample(std::string(p_Name) + "_sum", p_Labels, static_cast<double>(l_Sum) * p_Histogram.GetUnit());
+        WriteSample(std::string(p_Name) + "_count", p_Labels, l_Cumulative);
+    }
+
+    /// Write name and labels of a sample
+    /// @p_Name   : Sample name
+    /// @p_Labels : Labels
+    /// @p_Extra  : Additional label written last, such as le of histogram buckets, empty if none
+    /// @p_Value  : Value of additional label
+    void MetricWriter::WriteSeries(std::string_view const p_Name, MetricLabels const& p_Labels, std::string_view const p_Extra, std::string_view const p_Value)
+    {
+        m_Output.append(p_Name);
+
+        if (p_Labels.empty() && p_Extra.empty())
+            return;
+
+        const auto l_WriteLabel = [this](std::string_view const p_Label, std::string_view const p_LabelValue)
+        {
+            m_Output.append(p_Label).append("=\"");
+
+            for (const char l_Char : p_LabelValue)
+            {
+                if (l_Char == '\\' || l_Char == '"')
+                {
+                    m_Output.push_back('\\');
+                    m_Output.push_back(l_Char);
+                }
+                else if (l_Char == '\n')
+                    m_Output.append("\\n");
+                else
+                    m_Output.push_back(l_Char);
+            }
+
+            m_Output.push_back('"');
+        };
+
+        m_Output.push_back('{');
+
+        for (std::size_t l_I = 0; l_I < p_Labels.size(); ++l_I)
+        {
+            if (l_I != 0)
+                m_Output.push_back(',');
+
+            l_WriteLabel(p_Labels[l_I].first, p_Labels[l_I].second);
+        }
+
+        if (!p_Extra.empty())
+        {
+            if (!p_Labels.empty())
+                m_Output.push_back(',');
+
+            l_WriteLabel(p_Extra, p_Value);
+        }
+
+        m_Output.push_back('}');
+    }
+    /// Write floating point value
+    /// @p_Value : Value
+    void MetricWriter::WriteDouble(double p_Value)
+    {
+        char l_Buffer[32];
+        FormatDouble(l_Buffer, sizeof(l_Buffer), p_Value);
+        m_Output.append(l_Buffer);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get registry shared by the engine, never destroyed so singletons may remove their collectors when they go
+    Registry* Registry::GetSingleton()
+    {
+        static Registry* sl_Registry = new Registry();
+        return sl_Registry;
+    }
+
+    /// Constructor
+    Registry::Registry()
+        : m_NextId(1)
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get counter, created on first use
+    /// @p_Name   : Family name, by convention ending in _total
+    /// @p_Help   : Description
+    /// @p_Labels : Labels of series
+    Counter& Registry::GetCounter(std::string const& p_Name, std::string const& p_Help, MetricLabels const& p_Labels)
+    {
+        std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+        Series& l_Series = GetSeries(p_Name, p_Help, MetricType::Counter, p_Labels);
+        if (!l_Series.CounterValue)
+            l_Series.CounterValue.reset(new Counter());
+
+        return *l_Series.CounterValue;
+    }
+    /// Get gauge, created on first use
+    /// @p_Name   : Family name
+    /// @p_Help   : Description
+    /// @p_Labels : Labels of series
+    Gauge& Registry::GetGauge(std::string const& p_Name, std::string const& p_Help, MetricLabels const& p_Labels)
+    {
+        std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+        Series& l_Series = GetSeries(p_Name, p_Help, MetricType::Gauge, p_Labels);
+        if (!l_Series.GaugeValue)
+            l_Series.GaugeValue.reset(new Gauge());
+
+        return *l_Series.GaugeValue;
+    }
+    /// Get histogram, created on first use
+    /// @p_Name   : Family name
+    /// @p_Help   : Description
+    /// @p_Bounds : Inclusive upper bounds of buckets in ascending order
+    /// @p_Unit   : Scrapes report values multiplied by this, such as 1e-9 for nanoseconds written as seconds
+    /// @p_Labels : Labels of series
+    Histogram& Registry::GetHistogram(std::string const& p_Name, std::string const& p_Help, std::vector<uint64> const& p_Bounds, double p_Unit, MetricLabels const& p_Labels)
+    {
+        std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+        Series& l_Series = GetSeries(p_Name, p_Help, MetricType::Histogram, p_Labels);
+        if (!l_Series.HistogramValue)
+            l_Series.HistogramValue.reset(new Histogram(p_Bounds, p_Unit));
+
+        return *l_Series.HistogramValue;
+    }
+
+    /// Add series whose value is read on every scrape, for values kept by an object (queue depth...)
+    /// @p_Name     : Family name
+    /// @p_Help     : Description
+    /// @p_Type     : Counter or gauge
+    /// @p_Labels   : Labels of series
+    /// @p_Callback : Reads value, must not use the registry
+    /// Returns id to remove it with
+    uint64 Registry::AddCallback(std::string const& p_Name, std::string const& p_Help, MetricType p_Type, MetricLabels const& p_Labels, std::function<double()> const& p_Callback)
+    {
+        std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+        const uint64 l_Id = m_NextId++;
+
+        /// Callback series are not shared, two objects with the same labels both show up
+        Family& l_Family = GetFamily(p_Name, p_Help, p_Type);
+        l_Family.Entries.emplace_back(new Series());
+        l_Family.Entries.back()->Labels      = p_Labels;
+        l_Family.Entries.back()->Callback    = p_Callback;
+        l_Family.Entries.back()->CallbackId  = l_Id;
+
+        m_Callbacks[l_Id] = p_Name;
+
+        return l_Id;
+    }
+    /// Remove series added by AddCallback, must be done before what it reads is destroyed
+    /// @p_Id : Id returned by AddCallback
+    void Registry::RemoveCallback(uint64 p_Id)
+    {
+        std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+        auto l_It = m_Callbacks.find(p_Id);
+        if (l_It == m_Callbacks.end())
+            return;
+
+        std::vector<std::unique_ptr<Series>>& l_Entries = m_Families[l_It->second].Entries;
+        l_Entries.erase(std::remove_if(l_Entries.begin(), l_Entries.end(), [p_Id](std::unique_ptr<Series> const& p_Series) { return p_Series->Callback && p_Series->CallbackId == p_Id; }), l_Entries.end());
+
+        m_Callbacks.erase(l_It);
+    }
+
+    /// Add collector writing whole families on every scrape, its family names must not be used by anything else
+    /// @p_Collector : Collector, must not use the registry
+    /// Returns id to remove it with
+    uint64 Registry::AddCollector(MetricCollector const& p_Collector)
+    {
+        std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+        const uint64 l_Id = m_NextId++;
+        m_Collectors[l_Id] = p_Collector;
+
+        return l_Id;
+    }
+    /// Remove collector, must be done before what it reads is destroyed
+    /// @p_Id : Id returned by AddCollector
+    void Registry::RemoveCollector(uint64 p_Id)
+    {
+        std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+        m_Collectors.erase(p_Id);
+    }
+
+    /// Write every metric in the Prometheus text exposition format
+    std::string Registry::Scrape()
+    {
+        std::string l_Output;
+        MetricWriter l_Writer(l_Output);
+
+        std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+        for (auto const& l_Pair : m_Families)
+        {
+            Family const& l_Family = l_Pair.second;
+
+            if (l_Family.Entries.empty())
+                continue;
+
+            l_Writer.WriteFamily(l_Pair.first, l_Family.Help, l_Family.Type);
+
+            for (std::unique_ptr<Series> const& l_Series : l_Family.Entries)
+            {
+                if (l_Series->CounterValue)
+                    l_Writer.WriteSample(l_Pair.first, l_Series->Labels, l_Series->CounterValue->GetValue());
+                else if (l_Series->GaugeValue)
+                    l_Writer.WriteSample(l_Pair.first, l_Series->Labels, l_Series->GaugeValue->GetValue());
+                else if (l_Series->HistogramValue)
+                    l_Writer.WriteHistogram(l_Pair.first, l_Series->Labels, *l_Series->HistogramValue);
+                else if (l_Series->Callback)
+                    l_Writer.WriteSample(l_Pair.first, l_Series->Labels, l_Series->Callback());
+            }
+        }
+
+        /// Collectors are removed under our lock, so what they read is alive while they run
+        for (auto const& l_Pair : m_Collectors)
+            l_Pair.second(l_Writer);
+
+        return l_Output;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get family, created on first use
+    /// @p_Name : Family name
+    /// @p_Help : Description
+    /// @p_Type : Type, must match the family if it exists
+    Registry::Family& Registry::GetFamily(std::string const& p_Name, std::string const& p_Help, MetricType p_Type)
+    {
+        auto l_Result = m_Families.emplace(p_Name, Family());
+        Family& l_Family = l_Result.first->second;
+
+        if (l_Result.second)
+        {
+            l_Family.Help = p_Help;
+            l_Family.Type = p_Type;
+        }
+        else if (l_Family.Type != p_Type)
+            LOG_ERROR("Metrics", "Metric %0 is registered with two different types", p_Name);
+
+        return l_Family;
+    }
+    /// Get series, created on first use
+    /// @p_Name   : Family name
+    /// @p_Help   : Description
+    /// @p_Type   : Type, must match the family if it exists
+    /// @p_Labels : Labels of series
+    Registry::Series& Registry::GetSeries(std::string const& p_Name, std::string const& p_Help, MetricType p_Type, MetricLabels const& p_Labels)
+    {
+        Family& l_Family = GetFamily(p_Name, p_Help, p_Type);
+
+        for (std::unique_ptr<Series>& l_Series : l_Family.Entries)
+        {
+            if (!l_Series->Callback && l_Series->Labels == p_Labels)
+                return *l_Series;
+        }
+
+        l_Family.Entries.emplace_back(new Series());
+        l_Family.Entries.back()->Labels = p_Labels;
+
+        return *l_Family.Entries.back();
+    }
+
+}   ///< namespace Metrics
+}   ///< namespace Core
+}   ///< namespace SteerStone
@@ -0,0 +1,327 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Core/Core.hpp"
+
+#define METRICS_SLOTS               32          ///< Counter cells per metric, threads are spread over them so they rarely share a cache line
+#define METRICS_CACHE_LINE          64          ///< Cells are padded to this size
+#define METRICS_HISTOGRAM_BUCKETS   16          ///< Maximum amount of bucket bounds of a histogram
+
+namespace SteerStone { namespace Core { namespace Metrics {
+
+    /// Metric types
+    enum class MetricType
+    {
+        Counter,            ///< Monotonic total
+        Gauge,              ///< Value which goes up and down
+        Histogram           ///< Distribution of observations over buckets
+    };
+
+    /// Label name and value pairs of a series
+    typedef std::vector<std::pair<std::string, std::string>> MetricLabels;
+
+    /// Get counter cell of calling thread
+    inline uint32 GetMetricSlot()
+    {
+        static std::atomic<uint32> sl_NextSlot(0);
+        static thread_local const uint32 tl_Slot = sl_NextSlot.fetch_add(1, std::memory_order_relaxed) % METRICS_SLOTS;
+
+        return tl_Slot;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Monotonic counter, each thread adds to its own cell and cells are summed on scrape
+    class Counter
+    {
+        DISALLOW_COPY_AND_ASSIGN(Counter);
+
+        public:
+            /// Constructor
+            Counter();
+
+            /// Add to counter
+            /// @p_Value : Amount to add
+            void Increment(uint64 p_Value = 1)
+            {
+                m_Cells[GetMetricSlot()].Value.fetch_add(p_Value, std::memory_order_relaxed);
+            }
+            /// Get sum of every cell
+            uint64 GetValue() const;
+
+        private:
+            /// Cell of a group of threads, on its own cache line
+            struct alignas(METRICS_CACHE_LINE) Cell
+            {
+                std::atomic<uint64> Value;          ///< Total
+            };
+
+            Cell m_Cells[METRICS_SLOTS];            ///< Cells
+    };
+
+    /// Gauge holding the last value set, or a sum of what threads added
+    class Gauge
+    {
+        DISALLOW_COPY_AND_ASSIGN(Gauge);
+
+        public:
+            /// Constructor
+            Gauge();
+
+            /// Set value
+            /// @p_Value : Value
+            void Set(int64 p_Value)
+            {
+                m_Value.store(p_Value, std::memory_order_relaxed);
+            }
+            /// Add to value
+            /// @p_Value : Amount to add, may be negative
+            void Add(int64 p_Value)
+            {
+                m_Value.fetch_add(p_Value, std::memory_order_relaxed);
+            }
+            /// Get value
+            int64 GetValue() const
+            {
+                return m_Value.load(std::memory_order_relaxed);
+            }
+
+        private:
+            alignas(METRICS_CACHE_LINE) std::atomic<int64> m_Value;    ///< Value, on its own cache line
+    };
+
+    /// Histogram of integer observations (nanoseconds, bytes...) over fixed buckets
+    class Histogram
+    {
+        DISALLOW_COPY_AND_ASSIGN(Histogram);
+
+        public:
+            /// Constructor
+            /// @p_Bounds : Inclusive upper bounds of buckets in ascending order, at most METRICS_HISTOGRAM_BUCKETS
+            /// @p_Unit   : Scrapes report values multiplied by this, such as 1e-9 for nanoseconds written as seconds
+            Histogram(std::vector<uint64> const& p_Bounds, double p_Unit);
+
+            /// Record observation
+            /// @p_Value : Value
+            void Observe(uint64 p_Value)
+            {
+                uint32 l_Bucket = 0;
+                while (l_Bucket < m_BoundCount && p_Value > m_Bounds[l_Bucket])
+                    ++l_Bucket;
+
+                Cell& l_Cell = m_Cells[GetMetricSlot()];
+                l_Cell.Buckets[l_Bucket].fetch_add(1, std::memory_order_relaxed);
+                l_Cell.Sum.fetch_add(p_Value, std::memory_order_relaxed);
+            }
+
+            /// Get amount of bucket bounds
+            uint32 GetBoundCount() const;
+            /// Get bound of bucket
+            /// @p_Bucket : Bucket index
+            uint64 GetBound(uint32 p_Bucket) const;
+            /// Get unit values are reported in
+            double GetUnit() const;
+            /// Get observations of every bucket summed over every cell, the last bucket holds values above every bound
+            /// @p_Counts : Output, GetBoundCount() + 1 counts
+            /// Returns sum of observations
+            uint64 GetCounts(uint64* p_Counts) const;
+
+        private:
+            /// Cell of a group of threads, on its own cache lines
+            struct alignas(METRICS_CACHE_LINE) Cell
+            {
+                std::atomic<uint64> Buckets[METRICS_HISTOGRAM_BUCKETS + 1];     ///< Observations per bucket
+                std::atomic<uint64> Sum;                                        ///< Sum of observations
+            };
+
+            uint64 m_Bounds[METRICS_HISTOGRAM_BUCKETS];     ///< Inclusive upper bounds
+            uint32 m_BoundCount;                            ///< Amount of bounds
+            double m_Unit;                                  ///< Reported unit
+            Cell m_Cells[METRICS_SLOTS];                    ///< Cells
+    };
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Writes the Prometheus text exposition format (version 0.0.4)
+    class MetricWriter
+    {
+        public:
+            /// Constructor
+            /// @p_Output : Text is appended to it
+            explicit MetricWriter(std::string& p_Output);
+
+            /// Write help and type of a family, once before its samples
+            /// @p_Name : Family name
+            /// @p_Help : Description
+            /// @p_Type : Type
+            void WriteFamily(std::string_view const p_Name, std::string_view const p_Help, MetricType p_Type);
+            /// Write integer sample
+            /// @p_Name   : Sample name
+            /// @p_Labels : Labels
+            /// @p_Value  : Value
+            void WriteSample(std::string_view const p_Name, MetricLabels const& p_Labels, uint64 p_Value);
+            /// Write signed sample
+            /// @p_Name   : Sample name
+            /// @p_Labels : Labels
+            /// @p_Value  : Value
+            void WriteSample(std::string_view const p_Name, MetricLabels const& p_Labels, int64 p_Value);
+            /// Write floating point sample
+            /// @p_Name   : Sample name
+            /// @p_Labels : Labels
+            /// @p_Value  : Value
+            void WriteSample(std::string_view const p_Name, MetricLabels const& p_Labels, double p_Value);
+            /// Write samples of a histogram, buckets are cumulative
+            /// @p_Name      : Family name
+            /// @p_Labels    : Labels
+            /// @p_Histogram : Histogram
+            void WriteHistogram(std::string_view const p_Name, MetricLabels const& p_Labels, Histogram const& p_Histogram);
+
+        private:
+            /// Write name and labels of a sample
+            /// @p_Name   : Sample name
+            /// @p_Labels : Labels
+            /// @p_Extra  : Additional label written last, such as le of histogram buckets, empty if none
+            /// @p_Value  : Value of additional label
+            void WriteSeries(std::string_view const p_Name, MetricLabels const& p_Labels, std::string_view const p_Extra = std::string_view(), std::string_view const p_Value = std::string_view());
+            /// Write floating point value
+            /// @p_Value : Value
+            void WriteDouble(double p_Value);
+
+        private:
+            std::string& m_Output;              ///< Output
+    };
+
+    /// Callback writing whole families on scrape, for values kept elsewhere
+    typedef std::function<void(MetricWriter&)> MetricCollector;
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Metrics of every subsystem, aggregated when scraped
+    /// Metrics returned by Get* live as long as the process, call sites keep a reference instead of looking them up again
+    class Registry
+    {
+        DISALLOW_COPY_AND_ASSIGN(Registry);
+
+        public:
+            /// Get registry shared by the engine, never destroyed so singletons may remove their collectors when they go
+            static Registry* GetSingleton();
+
+        private:
+            /// Constructor
+            Registry();
+
+        public:
+            /// Get counter, created on first use
+            /// @p_Name   : Family name, by convention ending in _total
+            /// @p_Help   : Description
+            /// @p_Labels : Labels of series
+            Counter& GetCounter(std::string const& p_Name, std::string const& p_Help, MetricLabels const& p_Labels = MetricLabels());
+            /// Get gauge, created on first use
+            /// @p_Name   : Family name
+            /// @p_Help   : Description
+            /// @p_Labels : Labels of series
+            Gauge& GetGauge(std::string const& p_Name, std::string const& p_Help, MetricLabels const& p_Labels = MetricLabels());
+            /// Get histogram, created on first use
+            /// @p_Name   : Family name
+            /// @p_Help   : Description
+            /// @p_Bounds : Inclusive upper bounds of buckets in ascending order
+            /// @p_Unit   : Scrapes report values multiplied by this, such as 1e-9 for nanoseconds written as seconds
+            /// @p_Labels : Labels of series
+            Histogram& GetHistogram(std::string const& p_Name, std::string const& p_Help, std::vector<uint64> const& p_Bounds, double p_Unit, MetricLabels const& p_Labels = MetricLabels());
+
+            /// Add series whose value is read on every scrape, for values kept by an object (queue depth...)
+            /// @p_Name     : Family name
+            /// @p_Help     : Description
+            /// @p_Type     : Counter or gauge
+            /// @p_Labels   : Labels of series
+            /// @p_Callback : Reads value, must not use the registry
+            /// Returns id to remove it with
+            uint64 AddCallback(std::string const& p_Name, std::string const& p_Help, MetricType p_Type, MetricLabels const& p_Labels, std::function<double()> const& p_Callback);
+            /// Remove series added by AddCallback, must be done before what it reads is destroyed
+            /// @p_Id : Id returned by AddCallback
+            void RemoveCallback(uint64 p_Id);
+
+            /// Add collector writing whole families on every scrape, its family names must not be used by anything else
+            /// @p_Collector : Collector, must not use the registry
+            /// Returns id to remove it with
+            uint64 AddCollector(MetricCollector const& p_Collector);
+            /// Remove collector, must be done before what it reads is destroyed
+            /// @p_Id : Id returned by AddCollector
+            void RemoveCollector(uint64 p_Id);
+
+            /// Write every metric in the Prometheus text exposition format
+            std::string Scrape();
+
+        private:
+            /// Series of a family
+            struct Series
+            {
+                MetricLabels Labels;                        ///< Labels
+                std::unique_ptr<Counter> CounterValue;      ///< Set if family is a counter
+                std::unique_ptr<Gauge> GaugeValue;          ///< Set if family is a gauge
+                std::unique_ptr<Histogram> HistogramValue;  ///< Set if family is a histogram
+                std::function<double()> Callback;           ///< Set if series is read from a callback
+                uint64 CallbackId;                          ///< Id of callback
+            };
+            /// Metrics sharing a name
+            struct Family
+            {
+                std::string Help;                           ///< Description
+                MetricType Type;                            ///< Type
+                std::vector<std::unique_ptr<Series>> Entries;   ///< Series, only callback series are removed
+            };
+
+            /// Get family, created on first use
+            /// @p_Name : Family name
+            /// @p_Help : Description
+            /// @p_Type : Type, must match the family if it exists
+            Family& GetFamily(std::string const& p_Name, std::string const& p_Help, MetricType p_Type);
+            /// Get series, created on first use
+            /// @p_Name   : Family name
+            /// @p_Help   : Description
+            /// @p_Type   : Type, must match the family if it exists
+            /// @p_Labels : Labels of series
+            Series& GetSeries(std::string const& p_Name, std::string const& p_Help, MetricType p_Type, MetricLabels const& p_Labels);
+
+        private:
+            std::mutex m_Mutex;                             ///< Guards families and collectors
+            std::map<std::string, Family> m_Families;       ///< Families by name, sorted so scrapes are stable
+            std::map<uint64, std::string> m_Callbacks;      ///< Family name of callback series by id
+            std::map<uint64, MetricCollector> m_Collectors; ///< Collectors by id
+            uint64 m_NextId;                                ///< Id of the next callback or collector
+    };
+
+}   ///< namespace Metrics
+}   ///< namespace Core
+}   ///< namespace SteerStone
+
+#define sMetrics SteerStone::Core::Metrics::Registry::GetSingleton()
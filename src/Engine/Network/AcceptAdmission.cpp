@@ -0,0 +1,221 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "AcceptAdmission.hpp"
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Build key of address
+    /// @p_Address : Address
+    AdmissionKey AcceptAdmission::MakeKey(boost::asio::ip::address const& p_Address)
+    {
+        if (p_Address.is_v4())
+            return boost::asio::ip::make_address_v6(boost::asio::ip::v4_mapped, p_Address.to_v4()).to_bytes();
+
+        return p_Address.to_v6().to_bytes();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    AcceptAdmission::AcceptAdmission()
+        : m_Entries(ACCEPT_ADMISSION_TABLE_SIZE), m_GlobalTokens(0.0), m_GlobalRefill(std::chrono::steady_clock::now()),
+        m_Accepted(0), m_RateLimited(0), m_GlobalLimited(0), m_ConnectionLimited(0), m_Untracked(0)
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Set limits
+    /// @p_Policy : Limits
+    void AcceptAdmission::SetPolicy(AdmissionPolicy const& p_Policy)
+    {
+        Utils::ObjectGuard l_Guard(this);
+
+        m_Policy        = p_Policy;
+        m_GlobalTokens  = p_Policy.MaxAcceptsPerSecond;
+        m_GlobalRefill  = std::chrono::steady_clock::now();
+    }
+    /// Check if connection of address may be opened
+    /// @p_Key     : Address key
+    /// @p_Tracked : Set if the connection is counted and must be released once closed
+    AdmissionResult AcceptAdmission::Admit(AdmissionKey const& p_Key, bool& p_Tracked)
+    {
+        p_Tracked = false;
+
+        Utils::ObjectGuard l_Guard(this);
+
+        const std::chrono::steady_clock::time_point l_Now = std::chrono::steady_clock::now();
+
+        Entry* l_Entry = nullptr;
+        if (m_Policy.IpRate > 0.0 || m_Policy.MaxConnectionsPerIp)
+        {
+            l_Entry = Find(p_Key, l_Now, true);
+
+            if (!l_Entry)
+                m_Untracked.fetch_add(1, std::memory_order_relaxed);
+            else
+            {
+                if (m_Policy.MaxConnectionsPerIp && l_Entry->Connections >= m_Policy.MaxConnectionsPerIp)
+                {
+                    m_ConnectionLimited.fetch_add(1, std::memory_order_relaxed);
+                    return AdmissionResult::ConnectionLimited;
+                }
+
+                if (m_Policy.IpRate > 0.0)
+                {
+                    Refill(*l_Entry, l_Now);
+
+                    if (l_Entry->Tokens < 1.0)
+                    {
+                        m_RateLimited.fetch_add(1, std::memory_order_relaxed);
+                        return AdmissionResult::RateLimited;
+                    }
+                }
+            }
+        }
+
+        if (m_Policy.MaxAcceptsPerSecond)
+        {
+            const double l_Elapsed = std::chrono::duration<double>(l_Now - m_GlobalRefill).count();
+            m_GlobalTokens = std::min<double>(m_Policy.MaxAcceptsPerSecond, m_GlobalTokens + l_Elapsed * m_Policy.MaxAcceptsPerSecond);
+            m_GlobalRefill = l_Now;
+
+            if (m_GlobalTokens < 1.0)
+            {
+                m_GlobalLimited.fetch_add(1, std::memory_order_relaxed);
+                return AdmissionResult::GlobalLimited;
+            }
+
+            m_GlobalTokens -= 1.0;
+        }
+
+        /// Tokens of the address are only taken once the connection is really admitted
+        if (l_Entry)
+        {
+            if (m_Policy.IpRate > 0.0)
+                l_Entry->Tokens -= 1.0;
+
+            l_Entry->Connections++;
+            p_Tracked = true;
+        }
+
+        m_Accepted.fetch_add(1, std::memory_order_relaxed);
+        return AdmissionResult::Accepted;
+    }
+    /// Release tracked connection of address
+    /// @p_Key : Address key
+    void AcceptAdmission::Release(AdmissionKey const& p_Key)
+    {
+        Utils::ObjectGuard l_Guard(this);
+
+        Entry* l_Entry = Find(p_Key, std::chrono::steady_clock::now(), false);
+        if (l_Entry && l_Entry->Connections > 0)
+            l_Entry->Connections--;
+    }
+
+    /// Get statistics
+    AdmissionStatistics AcceptAdmission::GetStatistics() const
+    {
+        AdmissionStatistics l_Statistics;
+        l_Statistics.Accepted           = m_Accepted.load(std::memory_order_relaxed);
+        l_Statistics.RateLimited        = m_RateLimited.load(std::memory_order_relaxed);
+        l_Statistics.GlobalLimited      = m_GlobalLimited.load(std::memory_order_relaxed);
+        l_Statistics.ConnectionLimited  = m_ConnectionLimited.load(std::memory_order_relaxed);
+        l_Statistics.Untracked          = m_Untracked.load(std::memory_order_relaxed);
+
+        return l_Statistics;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get hash of address key
+    /// @p_Key : Address key
+    uint32 AcceptAdmission::Hash(AdmissionKey const& p_Key)
+    {
+        /// FNV-1a
+        uint32 l_Hash = 2166136261u;
+
+        for (uint8 l_Byte : p_Key)
+            l_Hash = (l_Hash ^ l_Byte) * 16777619u;
+
+        return l_Hash;
+    }
+
+    /// Find entry of address, must be called while holding our lock
+    /// @p_Key    : Address key
+    /// @p_Now    : Current time
+    /// @p_Insert : Claim an entry if address is not tracked yet
+    AcceptAdmission::Entry* AcceptAdmission::Find(AdmissionKey const& p_Key, std::chrono::steady_clock::time_point p_Now, bool p_Insert)
+    {
+        const uint32 l_Start = Hash(p_Key);
+        Entry* l_Reusable = nullptr;
+
+        for (uint32 l_I = 0; l_I < ACCEPT_ADMISSION_MAX_PROBE; l_I++)
+        {
+            Entry& l_Entry = m_Entries[(l_Start + l_I) & (ACCEPT_ADMISSION_TABLE_SIZE - 1)];
+
+            /// Nothing has ever been stored behind an unused entry
+            if (!l_Entry.Used)
+            {
+                if (!l_Reusable)
+                    l_Reusable = &l_Entry;
+                break;
+            }
+
+            if (l_Entry.Key == p_Key)
+                return &l_Entry;
+
+            if (!l_Reusable && p_Insert && l_Entry.Connections == 0)
+            {
+                /// Address would be admitted as if it was never seen, we can forget about it
+                Refill(l_Entry, p_Now);
+                if (m_Policy.IpRate <= 0.0 || l_Entry.Tokens >= std::max<double>(m_Policy.IpBurst, 1.0))
+                    l_Reusable = &l_Entry;
+            }
+        }
+
+        if (!p_Insert || !l_Reusable)
+            return nullptr;
+
+        l_Reusable->Key         = p_Key;
+        l_Reusable->Used        = true;
+        l_Reusable->Tokens      = std::max<double>(m_Policy.IpBurst, 1.0);
+        l_Reusable->LastRefill  = p_Now;
+        l_Reusable->Connections = 0;
+
+        return l_Reusable;
+    }
+    /// Refill tokens of entry, must be called while holding our lock
+    /// @p_Entry : Entry to refill
+    /// @p_Now   : Current time
+    void AcceptAdmission::Refill(Entry& p_Entry, std::chrono::steady_clock::time_point p_Now) const
+    {
+        const double l_Elapsed = std::chrono::duration<double>(p_Now - p_Entry.LastRefill).count();
+
+        p_Entry.Tokens      = std::min<double>(std::max<double>(m_Policy.IpBurst, 1.0), p_Entry.Tokens + l_Elapsed * m_Policy.IpRate);
+        p_Entry.LastRefill  = p_Now;
+    }
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
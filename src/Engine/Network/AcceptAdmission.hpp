@@ -0,0 +1,152 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <boost/asio/ip/address.hpp>
+
+#include "Core/Core.hpp"
+#include "Utility/UtiObjectGuard.hpp"
+#include "Utility/UtiLockable.hpp"
+
+#define ACCEPT_ADMISSION_TABLE_SIZE     4096        ///< Tracked addresses, must be a power of 2
+#define ACCEPT_ADMISSION_MAX_PROBE      16          ///< Slots looked at before an address is admitted untracked
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Limits of accepted connections, 0 disables a limit
+    struct AdmissionPolicy
+    {
+        AdmissionPolicy()
+            : IpRate(0.0), IpBurst(0), MaxAcceptsPerSecond(0), MaxConnectionsPerIp(0)
+        {
+        }
+
+        double IpRate;                          ///< Connections per second an address may open
+        uint32 IpBurst;                         ///< Connections an address may open at once
+        uint32 MaxAcceptsPerSecond;             ///< Connections per second accepted over all addresses
+        uint32 MaxConnectionsPerIp;             ///< Open connections per address
+    };
+
+    /// Admission results
+    enum class AdmissionResult
+    {
+        Accepted,                               ///< Connection may be opened
+        RateLimited,                            ///< Address opens connections too fast
+        GlobalLimited,                          ///< Server accepts connections too fast
+        ConnectionLimited                       ///< Address has too many open connections
+    };
+
+    /// Admission statistics
+    struct AdmissionStatistics
+    {
+        uint64 Accepted;                        ///< Connections admitted
+        uint64 RateLimited;                     ///< Connections rejected by the per address rate
+        uint64 GlobalLimited;                   ///< Connections rejected by the global rate
+        uint64 ConnectionLimited;               ///< Connections rejected by the per address connection limit
+        uint64 Untracked;                       ///< Connections admitted without limits because the table was full
+    };
+
+    /// Address key, IPv4 addresses are stored IPv4 mapped
+    typedef std::array<uint8, 16> AdmissionKey;
+
+    /// Cheap admission control of accepted connections, runs before a socket allocates anything
+    /// Addresses are held in a fixed size open addressing table, entries are never removed but
+    /// replaced once they have no open connections and a full bucket, so probe chains stay intact
+    class AcceptAdmission : private Utils::Lockable
+    {
+        /// Allow access to lock / unlock methods
+        friend class Utils::ObjectGuard<AcceptAdmission>;
+
+        DISALLOW_COPY_AND_ASSIGN(AcceptAdmission);
+
+        public:
+            /// Build key of address
+            /// @p_Address : Address
+            static AdmissionKey MakeKey(boost::asio::ip::address const& p_Address);
+
+        public:
+            /// Constructor
+            AcceptAdmission();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Set limits
+            /// @p_Policy : Limits
+            void SetPolicy(AdmissionPolicy const& p_Policy);
+            /// Check if connection of address may be opened
+            /// @p_Key     : Address key
+            /// @p_Tracked : Set if the connection is counted and must be released once closed
+            AdmissionResult Admit(AdmissionKey const& p_Key, bool& p_Tracked);
+            /// Release tracked connection of address
+            /// @p_Key : Address key
+            void Release(AdmissionKey const& p_Key);
+
+            /// Get statistics
+            AdmissionStatistics GetStatistics() const;
+
+        private:
+            /// Tracked address
+            struct Entry
+            {
+                Entry()
+                    : Used(false), Tokens(0.0), Connections(0)
+                {
+                }
+
+                AdmissionKey Key;                                   ///< Address key
+                bool Used;                                          ///< Entry holds an address
+                double Tokens;                                      ///< Connections the address may still open
+                std::chrono::steady_clock::time_point LastRefill;   ///< Time tokens were refilled
+                uint32 Connections;                                 ///< Open connections
+            };
+
+            /// Get hash of address key
+            /// @p_Key : Address key
+            static uint32 Hash(AdmissionKey const& p_Key);
+
+            /// Find entry of address, must be called while holding our lock
+            /// @p_Key    : Address key
+            /// @p_Now    : Current time
+            /// @p_Insert : Claim an entry if address is not tracked yet
+            Entry* Find(AdmissionKey const& p_Key, std::chrono::steady_clock::time_point p_Now, bool p_Insert);
+            /// Refill tokens of entry, must be called while holding our lock
+            /// @p_Entry : Entry to refill
+            /// @p_Now   : Current time
+            void Refill(Entry& p_Entry, std::chrono::steady_clock::time_point p_Now) const;
+
+        private:
+            AdmissionPolicy m_Policy;                                           ///< Limits
+            std::vector<Entry> m_Entries;                                       ///< Open addressing table
+            double m_GlobalTokens;                                              ///< Connections the server may still accept
+            std::chrono::steady_clock::time_point m_GlobalRefill;               ///< Time global tokens were refilled
+            std::atomic<uint64> m_Accepted;                                     ///< Connections admitted
+            std::atomic<uint64> m_RateLimited;                                  ///< Connections rejected by the per address rate
+            std::atomic<uint64> m_GlobalLimited;                                ///< Connections rejected by the global rate
+            std::atomic<uint64> m_ConnectionLimited;                            ///< Connections rejected by the per address connection limit
+            std::atomic<uint64> m_Untracked;                                    ///< Connections admitted untracked
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
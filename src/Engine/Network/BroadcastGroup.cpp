@@ -0,0 +1,125 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+
+#include "BroadcastGroup.hpp"
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Constructor
+    BroadcastGroup::BroadcastGroup()
+        : m_Members(std::make_shared<Members const>()), m_Size(0)
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Add member
+    /// @p_Socket : Socket to add
+    void BroadcastGroup::Add(std::shared_ptr<Socket> const& p_Socket)
+    {
+        Utils::ObjectWriteGuard l_Guard(this);
+
+        std::shared_ptr<Members> l_Members = std::make_shared<Members>(*m_Members);
+        boost::asio::io_context* l_Service = &static_cast<boost::asio::io_context&>(p_Socket->GetAsioSocket().get_executor().context());
+
+        auto l_Itr = std::find_if(l_Members->begin(), l_Members->end(), [l_Service](ServiceGroup const& p_Group) { return p_Group.Service == l_Service; });
+        if (l_Itr == l_Members->end())
+            l_Itr = l_Members->insert(l_Members->end(), ServiceGroup{ l_Service, {} });
+
+        if (std::find(l_Itr->Sockets.begin(), l_Itr->Sockets.end(), p_Socket) != l_Itr->Sockets.end())
+            return;
+
+        l_Itr->Sockets.push_back(p_Socket);
+
+        m_Members = std::move(l_Members);
+        m_Size++;
+    }
+    /// Remove member
+    /// @p_Socket : Socket to remove
+    void BroadcastGroup::Remove(Socket const* p_Socket)
+    {
+        Utils::ObjectWriteGuard l_Guard(this);
+
+        std::shared_ptr<Members> l_Members = std::make_shared<Members>(*m_Members);
+
+        for (auto l_Itr = l_Members->begin(); l_Itr != l_Members->end(); l_Itr++)
+        {
+            auto l_SocketItr = std::find_if(l_Itr->Sockets.begin(), l_Itr->Sockets.end(), [p_Socket](std::shared_ptr<Socket> const& p_Member) { return p_Member.get() == p_Socket; });
+            if (l_SocketItr == l_Itr->Sockets.end())
+                continue;
+
+            l_Itr->Sockets.erase(l_SocketItr);
+
+            if (l_Itr->Sockets.empty())
+                l_Members->erase(l_Itr);
+
+            m_Members = std::move(l_Members);
+            m_Size--;
+            return;
+        }
+    }
+    /// Remove all members
+    void BroadcastGroup::Clear()
+    {
+        Utils::ObjectWriteGuard l_Guard(this);
+
+        m_Members = std::make_shared<Members const>();
+        m_Size = 0;
+    }
+
+    /// Get amount of members
+    std::size_t BroadcastGroup::GetSize() const
+    {
+        return m_Size;
+    }
+
+    /// Send packet to every member, packet is serialized once and shared
+    /// @p_Packet : Packet to send
+    /// @p_Except : Member which does not recieve the packet (sender of chat...)
+    void BroadcastGroup::Broadcast(SharedPacket const& p_Packet, Socket const* p_Except)
+    {
+        if (p_Packet.IsEmpty())
+            return;
+
+        MembersPtr l_Members;
+
+        {
+            Utils::ObjectReadGuard l_Guard(this);
+            l_Members = m_Members;
+        }
+
+        for (std::size_t l_I = 0; l_I < l_Members->size(); l_I++)
+        {
+            /// Every member of this group is written from its own network thread, one post per io service
+            boost::asio::post(*(*l_Members)[l_I].Service, MakeAllocHandler([l_Members, l_I, p_Packet, p_Except]()
+            {
+                for (std::shared_ptr<Socket> const& l_Socket : (*l_Members)[l_I].Sockets)
+                {
+                    if (l_Socket.get() != p_Except && !l_Socket->IsClosed())
+                        l_Socket->Write(p_Packet);
+                }
+            }));
+        }
+    }
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
@@ -0,0 +1,90 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <boost/asio.hpp>
+
+#include "Core/Core.hpp"
+#include "Utility/UtiObjectGuard.hpp"
+#include "Utility/UtiLockable.hpp"
+#include "SharedPacket.hpp"
+#include "Socket.hpp"
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Group of sockets which recieve the same packets (room, hotel alert...)
+    /// Members are grouped by the io service of their network thread, a broadcast posts once per io service
+    /// and every member of that io service gets the same shared packet queued
+    class BroadcastGroup : private Utils::LockableReadWrite
+    {
+        DISALLOW_COPY_AND_ASSIGN(BroadcastGroup);
+
+        /// Allow access to lock / unlock methods
+        friend class Utils::ObjectGuard<BroadcastGroup>;
+        friend class Utils::ObjectReadGuard<BroadcastGroup>;
+        friend class Utils::ObjectWriteGuard<BroadcastGroup>;
+
+        /// Members which run on the same io service
+        struct ServiceGroup
+        {
+            boost::asio::io_context* Service;                       ///< IO Service of network thread
+            std::vector<std::shared_ptr<Socket>> Sockets;           ///< Members
+        };
+
+        /// Immutable members snapshot, rebuilt when members change so broadcasts never copy member lists
+        typedef std::vector<ServiceGroup> Members;
+        typedef std::shared_ptr<Members const> MembersPtr;
+
+        //////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////////////////////////////////////
+
+        public:
+            /// Constructor
+            BroadcastGroup();
+            /// Deconstructor
+            ~BroadcastGroup() = default;
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Add member
+            /// @p_Socket : Socket to add
+            void Add(std::shared_ptr<Socket> const& p_Socket);
+            /// Remove member
+            /// @p_Socket : Socket to remove
+            void Remove(Socket const* p_Socket);
+            /// Remove all members
+            void Clear();
+
+            /// Get amount of members
+            std::size_t GetSize() const;
+
+            /// Send packet to every member, packet is serialized once and shared
+            /// @p_Packet : Packet to send
+            /// @p_Except : Member which does not recieve the packet (sender of chat...)
+            void Broadcast(SharedPacket const& p_Packet, Socket const* p_Except = nullptr);
+
+        private:
+            MembersPtr m_Members;                                   ///< Current members
+            std::size_t m_Size;                                     ///< Amount of members
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
@@ -0,0 +1,166 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <new>
+
+#include "BufferPool.hpp"
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Free chunk, stored inside the released storage itself
+    struct BufferPoolChunk
+    {
+        BufferPoolChunk* Next;              ///< Next free chunk
+    };
+
+    /// Free list of a single tier
+    struct BufferPoolTier
+    {
+        std::size_t const Size;             ///< Size of chunks
+        std::size_t const MaxCached;        ///< Chunks kept in free list, the rest goes back to the heap
+        std::mutex Mutex;                   ///< Protects free list
+        BufferPoolChunk* FreeList;          ///< Free chunks
+        std::size_t Count;                  ///< Chunks in free list
+        std::atomic<uint64> Acquired;       ///< Chunks handed out
+        std::atomic<uint64> Allocated;      ///< Chunks allocated from the heap
+        std::atomic<uint64> InUse;          ///< Chunks currently handed out
+    };
+
+    /// Tiers, most clients only ever need the smallest one
+    static BufferPoolTier s_Tiers[BUFFER_POOL_TIERS] =
+    {
+        { 512,          16384,  {}, nullptr, 0, {0}, {0}, {0} },
+        { 4096,         4096,   {}, nullptr, 0, {0}, {0}, {0} },
+        { 64 * 1024,    64,     {}, nullptr, 0, {0}, {0}, {0} }
+    };
+    /// Chunks too big for any tier
+    static std::atomic<uint64> s_Oversized(0);
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get size of tier
+    /// @p_Tier : Tier
+    std::size_t BufferPool::GetTierSize(uint8 p_Tier)
+    {
+        return p_Tier < BUFFER_POOL_TIERS ? s_Tiers[p_Tier].Size : 0;
+    }
+
+    /// Acquire storage of at least p_Size bytes
+    /// @p_Size     : Minimum size of storage
+    /// @p_Capacity : Real size of storage
+    /// @p_Tier     : Tier of storage, needed to release it
+    uint8* BufferPool::Acquire(std::size_t p_Size, std::size_t& p_Capacity, uint8& p_Tier)
+    {
+        uint8 l_Tier = 0;
+        while (l_Tier < BUFFER_POOL_TIERS && s_Tiers[l_Tier].Size < p_Size)
+            l_Tier++;
+
+        if (l_Tier == BUFFER_POOL_TIERS)
+        {
+            s_Oversized.fetch_add(1, std::memory_order_relaxed);
+
+            p_Capacity  = p_Size;
+            p_Tier      = BUFFER_POOL_HEAP_TIER;
+            return static_cast<uint8*>(::operator new(p_Size));
+        }
+
+        BufferPoolTier& l_PoolTier = s_Tiers[l_Tier];
+
+        p_Capacity  = l_PoolTier.Size;
+        p_Tier      = l_Tier;
+
+        l_PoolTier.Acquired.fetch_add(1, std::memory_order_relaxed);
+        l_PoolTier.InUse.fetch_add(1, std::memory_order_relaxed);
+
+        {
+            std::lock_guard<std::mutex> l_Guard(l_PoolTier.Mutex);
+
+            if (BufferPoolChunk* l_Chunk = l_PoolTier.FreeList)
+            {
+                l_PoolTier.FreeList = l_Chunk->Next;
+                l_PoolTier.Count--;
+
+                return reinterpret_cast<uint8*>(l_Chunk);
+            }
+        }
+
+        l_PoolTier.Allocated.fetch_add(1, std::memory_order_relaxed);
+
+        return static_cast<uint8*>(::operator new(l_PoolTier.Size));
+    }
+    /// Return storage to the pool
+    /// @p_Storage : Storage to return
+    /// @p_Tier    : Tier of storage
+    void BufferPool::Release(uint8* p_Storage, uint8 p_Tier)
+    {
+        if (!p_Storage)
+            return;
+
+        if (p_Tier >= BUFFER_POOL_TIERS)
+        {
+            ::operator delete(p_Storage);
+            return;
+        }
+
+        BufferPoolTier& l_PoolTier = s_Tiers[p_Tier];
+        l_PoolTier.InUse.fetch_sub(1, std::memory_order_relaxed);
+
+        {
+            std::lock_guard<std::mutex> l_Guard(l_PoolTier.Mutex);
+
+            if (l_PoolTier.Count < l_PoolTier.MaxCached)
+            {
+                BufferPoolChunk* l_Chunk = reinterpret_cast<BufferPoolChunk*>(p_Storage);
+                l_Chunk->Next = l_PoolTier.FreeList;
+
+                l_PoolTier.FreeList = l_Chunk;
+                l_PoolTier.Count++;
+                return;
+            }
+        }
+
+        ::operator delete(p_Storage);
+    }
+
+    /// Get statistics of pool
+    BufferPoolStatistics BufferPool::GetStatistics()
+    {
+        BufferPoolStatistics l_Statistics;
+
+        for (uint32 l_I = 0; l_I < BUFFER_POOL_TIERS; l_I++)
+        {
+            BufferPoolTier& l_PoolTier = s_Tiers[l_I];
+
+            l_Statistics.Acquired[l_I]  = l_PoolTier.Acquired.load(std::memory_order_relaxed);
+            l_Statistics.Allocated[l_I] = l_PoolTier.Allocated.load(std::memory_order_relaxed);
+            l_Statistics.InUse[l_I]     = l_PoolTier.InUse.load(std::memory_order_relaxed);
+
+            std::lock_guard<std::mutex> l_Guard(l_PoolTier.Mutex);
+            l_Statistics.Cached[l_I]    = l_PoolTier.Count;
+        }
+
+        l_Statistics.Oversized = s_Oversized.load(std::memory_order_relaxed);
+
+        return l_Statistics;
+    }
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
@@ -0,0 +1,66 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <atomic>
+
+#include "Core/Core.hpp"
+
+#define BUFFER_POOL_TIERS           3           ///< 512 B, 4 KB and 64 KB chunks
+#define BUFFER_POOL_HEAP_TIER       0xFF        ///< Tier of chunks which are bigger than the biggest tier
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Buffer pool statistics
+    struct BufferPoolStatistics
+    {
+        uint64 Acquired[BUFFER_POOL_TIERS];     ///< Chunks handed out per tier
+        uint64 Allocated[BUFFER_POOL_TIERS];    ///< Chunks which had to be allocated per tier
+        uint64 InUse[BUFFER_POOL_TIERS];        ///< Chunks currently handed out per tier
+        uint64 Cached[BUFFER_POOL_TIERS];       ///< Chunks currently held in free lists per tier
+        uint64 Oversized;                       ///< Chunks bigger than the biggest tier, allocated from the heap
+    };
+
+    /// Global tiered pool of raw storage for PacketBuffer
+    /// Chunks are not zero filled, a free chunk is reused by any thread
+    class BufferPool
+    {
+        public:
+            /// Get size of tier
+            /// @p_Tier : Tier
+            static std::size_t GetTierSize(uint8 p_Tier);
+
+            /// Acquire storage of at least p_Size bytes
+            /// @p_Size     : Minimum size of storage
+            /// @p_Capacity : Real size of storage
+            /// @p_Tier     : Tier of storage, needed to release it
+            static uint8* Acquire(std::size_t p_Size, std::size_t& p_Capacity, uint8& p_Tier);
+            /// Return storage to the pool
+            /// @p_Storage : Storage to return
+            /// @p_Tier    : Tier of storage
+            static void Release(uint8* p_Storage, uint8 p_Tier);
+
+            /// Get statistics of pool
+            static BufferPoolStatistics GetStatistics();
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
@@ -0,0 +1,185 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <new>
+
+#include "HandlerMemory.hpp"
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Free block, stored inside the released memory itself
+    struct HandlerMemoryBlock
+    {
+        HandlerMemoryBlock* Next;       ///< Next free block
+    };
+
+    /// Free lists of a single thread
+    struct HandlerMemoryCache
+    {
+        /// Constructor
+        HandlerMemoryCache();
+        /// Deconstructor
+        ~HandlerMemoryCache();
+
+        HandlerMemoryBlock* FreeLists[HANDLER_MEMORY_CLASSES];      ///< Free list per size class
+        uint32 Count[HANDLER_MEMORY_CLASSES];                       ///< Blocks in each free list
+        std::atomic<uint64> Hits;                                   ///< Only written by owning thread
+        std::atomic<uint64> Misses;                                 ///< Only written by owning thread
+        std::atomic<uint64> Oversized;                              ///< Only written by owning thread
+        std::atomic<uint64> Cached;                                 ///< Only written by owning thread
+    };
+
+    /// Every cache, used to gather statistics
+    static std::mutex s_CachesMutex;
+    static std::vector<HandlerMemoryCache*> s_Caches;
+    /// Statistics of caches of threads which exited
+    static HandlerMemoryStatistics s_ExitedStatistics = { 0, 0, 0, 0 };
+
+    /// Constructor
+    HandlerMemoryCache::HandlerMemoryCache()
+        : Hits(0), Misses(0), Oversized(0), Cached(0)
+    {
+        for (uint32 l_I = 0; l_I < HANDLER_MEMORY_CLASSES; l_I++)
+        {
+            FreeLists[l_I]  = nullptr;
+            Count[l_I]      = 0;
+        }
+
+        std::lock_guard<std::mutex> l_Guard(s_CachesMutex);
+        s_Caches.push_back(this);
+    }
+    /// Deconstructor
+    HandlerMemoryCache::~HandlerMemoryCache()
+    {
+        for (uint32 l_I = 0; l_I < HANDLER_MEMORY_CLASSES; l_I++)
+        {
+            while (FreeLists[l_I])
+            {
+                HandlerMemoryBlock* l_Block = FreeLists[l_I];
+                FreeLists[l_I] = l_Block->Next;
+                ::operator delete(l_Block);
+            }
+        }
+
+        std::lock_guard<std::mutex> l_Guard(s_CachesMutex);
+        s_Caches.erase(std::remove(s_Caches.begin(), s_Caches.end(), this), s_Caches.end());
+
+        s_ExitedStatistics.Hits         += Hits.load(std::memory_order_relaxed);
+        s_ExitedStatistics.Misses       += Misses.load(std::memory_order_relaxed);
+        s_ExitedStatistics.Oversized    += Oversized.load(std::memory_order_relaxed);
+    }
+
+    /// Free lists of calling thread
+    static thread_local HandlerMemoryCache tl_Cache;
+
+    /// Get size class of allocation, HANDLER_MEMORY_CLASSES if too big
+    /// @p_Size : Size of allocation
+    static inline uint32 GetSizeClass(std::size_t p_Size)
+    {
+        uint32 l_Class = 0;
+
+        while (l_Class < HANDLER_MEMORY_CLASSES && p_Size > (std::size_t(1) << (HANDLER_MEMORY_MIN_SHIFT + l_Class)))
+            l_Class++;
+
+        return l_Class;
+    }
+    /// Increment counter only written by the owning thread
+    /// @p_Counter : Counter to increment
+    static inline void Increment(std::atomic<uint64>& p_Counter, int64 p_Value = 1)
+    {
+        p_Counter.store(p_Counter.load(std::memory_order_relaxed) + p_Value, std::memory_order_relaxed);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Allocate handler memory
+    /// @p_Size : Size of handler
+    void* HandlerMemoryPool::Allocate(std::size_t p_Size)
+    {
+        HandlerMemoryCache& l_Cache = tl_Cache;
+        const uint32 l_Class = GetSizeClass(p_Size);
+
+        if (l_Class == HANDLER_MEMORY_CLASSES)
+        {
+            Increment(l_Cache.Oversized);
+            return ::operator new(p_Size);
+        }
+
+        if (HandlerMemoryBlock* l_Block = l_Cache.FreeLists[l_Class])
+        {
+            l_Cache.FreeLists[l_Class] = l_Block->Next;
+            l_Cache.Count[l_Class]--;
+
+            Increment(l_Cache.Hits);
+            Increment(l_Cache.Cached, -1);
+            return l_Block;
+        }
+
+        Increment(l_Cache.Misses);
+
+        /// Allocate the full class size so the block can be reused by any handler of this class
+        return ::operator new(std::size_t(1) << (HANDLER_MEMORY_MIN_SHIFT + l_Class));
+    }
+    /// Release handler memory
+    /// @p_Pointer : Memory to release
+    /// @p_Size    : Size of handler
+    void HandlerMemoryPool::Deallocate(void* p_Pointer, std::size_t p_Size)
+    {
+        if (!p_Pointer)
+            return;
+
+        HandlerMemoryCache& l_Cache = tl_Cache;
+        const uint32 l_Class = GetSizeClass(p_Size);
+
+        if (l_Class == HANDLER_MEMORY_CLASSES || l_Cache.Count[l_Class] >= HANDLER_MEMORY_MAX_CACHED)
+        {
+            ::operator delete(p_Pointer);
+            return;
+        }
+
+        HandlerMemoryBlock* l_Block = static_cast<HandlerMemoryBlock*>(p_Pointer);
+        l_Block->Next = l_Cache.FreeLists[l_Class];
+
+        l_Cache.FreeLists[l_Class] = l_Block;
+        l_Cache.Count[l_Class]++;
+
+        Increment(l_Cache.Cached);
+    }
+
+    /// Get statistics of every thread
+    HandlerMemoryStatistics HandlerMemoryPool::GetStatistics()
+    {
+        std::lock_guard<std::mutex> l_Guard(s_CachesMutex);
+
+        HandlerMemoryStatistics l_Statistics = s_ExitedStatistics;
+
+        for (HandlerMemoryCache const* l_Cache : s_Caches)
+        {
+            l_Statistics.Hits       += l_Cache->Hits.load(std::memory_order_relaxed);
+            l_Statistics.Misses     += l_Cache->Misses.load(std::memory_order_relaxed);
+            l_Statistics.Oversized  += l_Cache->Oversized.load(std::memory_order_relaxed);
+            l_Statistics.Cached     += l_Cache->Cached.load(std::memory_order_relaxed);
+        }
+
+        return l_Statistics;
+    }
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
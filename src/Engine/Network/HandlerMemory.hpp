@@ -0,0 +1,144 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <atomic>
+
+#include "Core/Core.hpp"
+
+#define HANDLER_MEMORY_CLASSES          5       ///< 64, 128, 256, 512 and 1024 bytes
+#define HANDLER_MEMORY_MIN_SHIFT        6       ///< Smallest class is 1 << 6 bytes
+#define HANDLER_MEMORY_MAX_CACHED       256     ///< Blocks kept per class and thread, the rest goes back to the heap
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Handler memory statistics
+    struct HandlerMemoryStatistics
+    {
+        uint64 Hits;                ///< Allocations served from a free list
+        uint64 Misses;              ///< Allocations which went to the heap
+        uint64 Oversized;           ///< Allocations too big for any size class
+        uint64 Cached;              ///< Blocks currently held in free lists
+    };
+
+    /// Recycling memory pool for asio completion handlers
+    /// Every thread running an io service keeps size classed free lists, handler memory is
+    /// taken from and returned to the free lists of the calling thread without locking
+    class HandlerMemoryPool
+    {
+        public:
+            /// Allocate handler memory
+            /// @p_Size : Size of handler
+            static void* Allocate(std::size_t p_Size);
+            /// Release handler memory
+            /// @p_Pointer : Memory to release
+            /// @p_Size    : Size of handler
+            static void Deallocate(void* p_Pointer, std::size_t p_Size);
+
+            /// Get statistics of every thread
+            static HandlerMemoryStatistics GetStatistics();
+    };
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Standard allocator over HandlerMemoryPool, used as associated allocator of handlers
+    template<typename T> class HandlerAllocator
+    {
+        public:
+            using value_type = T;
+
+        public:
+            /// Constructor
+            HandlerAllocator() noexcept = default;
+            /// Constructor
+            template<typename U> HandlerAllocator(HandlerAllocator<U> const&) noexcept {}
+
+            /// Allocate
+            /// @p_Count : Amount of objects
+            T* allocate(std::size_t p_Count)
+            {
+                return static_cast<T*>(HandlerMemoryPool::Allocate(p_Count * sizeof(T)));
+            }
+            /// Deallocate
+            /// @p_Pointer : Objects to release
+            /// @p_Count   : Amount of objects
+            void deallocate(T* p_Pointer, std::size_t p_Count)
+            {
+                HandlerMemoryPool::Deallocate(p_Pointer, p_Count * sizeof(T));
+            }
+
+            /// Compare allocators, all of them share the same pool
+            template<typename U> bool operator==(HandlerAllocator<U> const&) const noexcept { return true; }
+            /// Compare allocators, all of them share the same pool
+            template<typename U> bool operator!=(HandlerAllocator<U> const&) const noexcept { return false; }
+    };
+
+    /// Wrapper of handler objects which allocates their memory from HandlerMemoryPool,
+    /// calls to operator() are forwarded to the encapsulated handler
+    template<typename Handler> class AllocHandler
+    {
+        public:
+            using allocator_type = HandlerAllocator<Handler>;
+
+        public:
+            /// Constructor
+            /// @p_Handler : Handler to wrap
+            explicit AllocHandler(Handler p_Handler)
+                : m_Handler(std::move(p_Handler))
+            {
+            }
+
+            /// Get associated allocator
+            allocator_type get_allocator() const noexcept
+            {
+                return allocator_type();
+            }
+
+            /// Call handler
+            template<typename ...Args> void operator()(Args&& ... p_Args)
+            {
+                m_Handler(std::forward<Args>(p_Args)...);
+            }
+
+            /// Allocation hook for operations which do not use associated allocators
+            friend void* asio_handler_allocate(std::size_t p_Size, AllocHandler<Handler>* /*p_This*/)
+            {
+                return HandlerMemoryPool::Allocate(p_Size);
+            }
+            /// Deallocation hook for operations which do not use associated allocators
+            friend void asio_handler_deallocate(void* p_Pointer, std::size_t p_Size, AllocHandler<Handler>* /*p_This*/)
+            {
+                HandlerMemoryPool::Deallocate(p_Pointer, p_Size);
+            }
+
+        private:
+            Handler m_Handler;      ///< Wrapped handler
+    };
+
+    /// Wrap handler so its memory comes from HandlerMemoryPool
+    /// @p_Handler : Handler to wrap
+    template<typename Handler> inline AllocHandler<typename std::decay<Handler>::type> MakeAllocHandler(Handler&& p_Handler)
+    {
+        return AllocHandler<typename std::decay<Handler>::type>(std::forward<Handler>(p_Handler));
+    }
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
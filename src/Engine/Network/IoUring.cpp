@@ -0,0 +1,396 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "IoUring.hpp"
+
+#ifdef STEERSTONE_IO_URING
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "BufferPool.hpp"
+#include "HandlerMemory.hpp"
+#include "Logger/Base.hpp"
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Constructor
+    /// @p_Service : IO service of our network thread
+    IoUring::IoUring(boost::asio::io_service& p_Service)
+        : m_Service(p_Service), m_EventDescriptor(p_Service), m_RingDescriptor(-1),
+        m_SqMap(MAP_FAILED), m_SqMapSize(0), m_Sqes(nullptr), m_SqesSize(0), m_SqHead(nullptr), m_SqTail(nullptr), m_SqMask(0), m_SqEntries(0), m_SqArray(nullptr),
+        m_ToSubmit(0), m_SubmitPending(false),
+        m_CqMap(MAP_FAILED), m_CqMapSize(0), m_CqHead(nullptr), m_CqTail(nullptr), m_CqMask(0), m_Cqes(nullptr),
+        m_BufferRing(nullptr), m_BufferRingSize(0), m_BufferTail(0), m_BufferMask(0),
+        m_SubmitCalls(0), m_Completions(0)
+    {
+    }
+    /// Deconstructor
+    IoUring::~IoUring()
+    {
+        boost::system::error_code l_ErrorCode;
+        m_EventDescriptor.close(l_ErrorCode);
+
+        /// Closing the ring cancels everything still in flight
+        if (m_RingDescriptor >= 0)
+            close(m_RingDescriptor);
+
+        if (m_BufferRing)
+            munmap(m_BufferRing, m_BufferRingSize);
+        if (m_Sqes)
+            munmap(m_Sqes, m_SqesSize);
+        if (m_CqMap != MAP_FAILED && m_CqMap != m_SqMap)
+            munmap(m_CqMap, m_CqMapSize);
+        if (m_SqMap != MAP_FAILED)
+            munmap(m_SqMap, m_SqMapSize);
+
+        for (std::size_t l_I = 0; l_I < m_Buffers.size(); l_I++)
+            BufferPool::Release(m_Buffers[l_I], m_BufferTiers[l_I]);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Set up ring and provided buffers, fails on kernels without multishot recv (< 6.0)
+    /// @p_Entries     : Submission queue size
+    /// @p_BufferCount : Amount of provided receive buffers, must be a power of 2
+    bool IoUring::Initialize(uint32 p_Entries, uint32 p_BufferCount)
+    {
+        io_uring_params l_Params;
+        memset(&l_Params, 0, sizeof(l_Params));
+
+        m_RingDescriptor = static_cast<int>(syscall(__NR_io_uring_setup, p_Entries, &l_Params));
+        if (m_RingDescriptor < 0)
+        {
+            LOG_WARNING("IoUring", "io_uring_setup failed: %0", strerror(errno));
+            return false;
+        }
+
+        /// Map rings, newer kernels share a single mapping for both
+        m_SqMapSize = l_Params.sq_off.array + l_Params.sq_entries * sizeof(uint32);
+        m_CqMapSize = l_Params.cq_off.cqes + l_Params.cq_entries * sizeof(io_uring_cqe);
+
+        if (l_Params.features & IORING_FEAT_SINGLE_MMAP)
+            m_SqMapSize = m_CqMapSize = std::max(m_SqMapSize, m_CqMapSize);
+
+        m_SqMap = mmap(nullptr, m_SqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_RingDescriptor, IORING_OFF_SQ_RING);
+        if (m_SqMap == MAP_FAILED)
+            return false;
+
+        if (l_Params.features & IORING_FEAT_SINGLE_MMAP)
+            m_CqMap = m_SqMap;
+        else
+        {
+            m_CqMap = mmap(nullptr, m_CqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_RingDescriptor, IORING_OFF_CQ_RING);
+            if (m_CqMap == MAP_FAILED)
+                return false;
+        }
+
+        m_SqesSize  = l_Params.sq_entries * sizeof(io_uring_sqe);
+        void* l_Sqes = mmap(nullptr, m_SqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_RingDescriptor, IORING_OFF_SQES);
+        if (l_Sqes == MAP_FAILED)
+            return false;
+
+        m_Sqes = static_cast<io_uring_sqe*>(l_Sqes);
+
+        uint8* l_Sq = static_cast<uint8*>(m_SqMap);
+        m_SqHead    = reinterpret_cast<uint32*>(l_Sq + l_Params.sq_off.head);
+        m_SqTail    = reinterpret_cast<uint32*>(l_Sq + l_Params.sq_off.tail);
+        m_SqMask    = *reinterpret_cast<uint32*>(l_Sq + l_Params.sq_off.ring_mask);
+        m_SqEntries = *reinterpret_cast<uint32*>(l_Sq + l_Params.sq_off.ring_entries);
+        m_SqArray   = reinterpret_cast<uint32*>(l_Sq + l_Params.sq_off.array);
+
+        uint8* l_Cq = static_cast<uint8*>(m_CqMap);
+        m_CqHead    = reinterpret_cast<uint32*>(l_Cq + l_Params.cq_off.head);
+        m_CqTail    = reinterpret_cast<uint32*>(l_Cq + l_Params.cq_off.tail);
+        m_CqMask    = *reinterpret_cast<uint32*>(l_Cq + l_Params.cq_off.ring_mask);
+        m_Cqes      = reinterpret_cast<io_uring_cqe*>(l_Cq + l_Params.cq_off.cqes);
+
+        /// Provided buffer ring, buffers come from our global pool
+        m_BufferRingSize = p_BufferCount * sizeof(io_uring_buf);
+        void* l_BufferRing = mmap(nullptr, m_BufferRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (l_BufferRing == MAP_FAILED)
+        {
+            m_BufferRing = nullptr;
+            return false;
+        }
+
+        m_BufferRing = static_cast<io_uring_buf_ring*>(l_BufferRing);
+        m_BufferMask = static_cast<uint16>(p_BufferCount - 1);
+
+        io_uring_buf_reg l_Registration;
+        memset(&l_Registration, 0, sizeof(l_Registration));
+        l_Registration.ring_addr    = reinterpret_cast<uint64>(m_BufferRing);
+        l_Registration.ring_entries = p_BufferCount;
+        l_Registration.bgid         = IO_URING_BUFFER_GROUP;
+
+        if (syscall(__NR_io_uring_register, m_RingDescriptor, IORING_REGISTER_PBUF_RING, &l_Registration, 1) < 0)
+        {
+            LOG_WARNING("IoUring", "Failed to register provided buffer ring: %0", strerror(errno));
+            return false;
+        }
+
+        m_Buffers.resize(p_BufferCount);
+        m_BufferTiers.resize(p_BufferCount);
+
+        for (uint32 l_I = 0; l_I < p_BufferCount; l_I++)
+        {
+            std::size_t l_Capacity = 0;
+            m_Buffers[l_I] = BufferPool::Acquire(IO_URING_BUFFER_SIZE, l_Capacity, m_BufferTiers[l_I]);
+
+            io_uring_buf& l_Buffer = GetBufferEntry(m_BufferTail);
+            l_Buffer.addr   = reinterpret_cast<uint64>(m_Buffers[l_I]);
+            l_Buffer.len    = IO_URING_BUFFER_SIZE;
+            l_Buffer.bid    = static_cast<uint16>(l_I);
+            m_BufferTail++;
+        }
+
+        __atomic_store_n(&m_BufferRing->tail, m_BufferTail, __ATOMIC_RELEASE);
+
+        /// Completions wake up our io service through an eventfd
+        const int l_EventDescriptor = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (l_EventDescriptor < 0)
+            return false;
+
+        if (syscall(__NR_io_uring_register, m_RingDescriptor, IORING_REGISTER_EVENTFD, &l_EventDescriptor, 1) < 0)
+        {
+            close(l_EventDescriptor);
+            return false;
+        }
+
+        m_EventDescriptor.assign(l_EventDescriptor);
+        StartWait();
+
+        return true;
+    }
+
+    /// Queue multishot receive, completes once for every recieved packet until it finishes without IORING_CQE_F_MORE
+    /// @p_Descriptor : Socket descriptor
+    /// @p_Operation  : Operation to complete
+    void IoUring::QueueReceive(int p_Descriptor, IoUringOperation* p_Operation)
+    {
+        Utils::ObjectGuard l_Guard(this);
+
+        io_uring_sqe* l_Sqe = GetSqe();
+        l_Sqe->opcode       = IORING_OP_RECV;
+        l_Sqe->fd           = p_Descriptor;
+        l_Sqe->ioprio       = IORING_RECV_MULTISHOT;
+        l_Sqe->flags        = IOSQE_BUFFER_SELECT;
+        l_Sqe->buf_group    = IO_URING_BUFFER_GROUP;
+        l_Sqe->user_data    = reinterpret_cast<uint64>(p_Operation);
+
+        p_Operation->Pending = true;
+
+        ScheduleSubmit();
+    }
+    /// Queue vectored send of p_Operation->Vectors
+    /// @p_Descriptor : Socket descriptor
+    /// @p_Operation  : Operation to complete
+    /// @p_Count      : Amount of vectors
+    void IoUring::QueueSend(int p_Descriptor, IoUringSendOperation* p_Operation, std::size_t p_Count)
+    {
+        memset(&p_Operation->Message, 0, sizeof(p_Operation->Message));
+        p_Operation->Message.msg_iov    = p_Operation->Vectors;
+        p_Operation->Message.msg_iovlen = p_Count;
+
+        Utils::ObjectGuard l_Guard(this);
+
+        io_uring_sqe* l_Sqe = GetSqe();
+        l_Sqe->opcode       = IORING_OP_SENDMSG;
+        l_Sqe->fd           = p_Descriptor;
+        l_Sqe->addr         = reinterpret_cast<uint64>(&p_Operation->Message);
+        l_Sqe->len          = 1;
+        l_Sqe->msg_flags    = MSG_NOSIGNAL;
+        l_Sqe->user_data    = reinterpret_cast<uint64>(p_Operation);
+
+        p_Operation->Pending = true;
+
+        ScheduleSubmit();
+    }
+    /// Cancel operation, it completes with -ECANCELED
+    /// @p_Operation : Operation to cancel
+    void IoUring::Cancel(IoUringOperation* p_Operation)
+    {
+        Utils::ObjectGuard l_Guard(this);
+
+        /// Completion of the cancel request itself is ignored
+        io_uring_sqe* l_Sqe = GetSqe();
+        l_Sqe->opcode       = IORING_OP_ASYNC_CANCEL;
+        l_Sqe->fd           = -1;
+        l_Sqe->addr         = reinterpret_cast<uint64>(p_Operation);
+        l_Sqe->user_data    = 0;
+
+        ScheduleSubmit();
+    }
+
+    /// Get provided buffer of a completed receive
+    /// @p_Flags : Completion flags
+    uint8 const* IoUring::GetBuffer(uint32 p_Flags) const
+    {
+        return m_Buffers[(p_Flags >> IORING_CQE_BUFFER_SHIFT) & m_BufferMask];
+    }
+    /// Give provided buffer of a completed receive back to the kernel
+    /// @p_Flags : Completion flags
+    void IoUring::RecycleBuffer(uint32 p_Flags)
+    {
+        const uint16 l_Id = static_cast<uint16>((p_Flags >> IORING_CQE_BUFFER_SHIFT) & m_BufferMask);
+
+        /// Only called from our network thread
+        io_uring_buf& l_Buffer = GetBufferEntry(m_BufferTail);
+        l_Buffer.addr   = reinterpret_cast<uint64>(m_Buffers[l_Id]);
+        l_Buffer.len    = IO_URING_BUFFER_SIZE;
+        l_Buffer.bid    = l_Id;
+        m_BufferTail++;
+
+        __atomic_store_n(&m_BufferRing->tail, m_BufferTail, __ATOMIC_RELEASE);
+    }
+
+    /// Get amount of io_uring_enter calls
+    uint64 IoUring::GetSubmitCalls() const
+    {
+        return m_SubmitCalls.load(std::memory_order_relaxed);
+    }
+    /// Get amount of reaped completions
+    uint64 IoUring::GetCompletions() const
+    {
+        return m_Completions.load(std::memory_order_relaxed);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get free submission entry, must be called while holding our lock
+    io_uring_sqe* IoUring::GetSqe()
+    {
+        /// Ring is full, hand what we have to the kernel first
+        if (*m_SqTail - __atomic_load_n(m_SqHead, __ATOMIC_ACQUIRE) >= m_SqEntries)
+            SubmitLocked();
+
+        const uint32 l_Tail  = *m_SqTail;
+        const uint32 l_Index = l_Tail & m_SqMask;
+
+        io_uring_sqe* l_Sqe = &m_Sqes[l_Index];
+        memset(l_Sqe, 0, sizeof(io_uring_sqe));
+
+        m_SqArray[l_Index] = l_Index;
+        __atomic_store_n(m_SqTail, l_Tail + 1, __ATOMIC_RELEASE);
+
+        m_ToSubmit++;
+
+        return l_Sqe;
+    }
+    /// Get buffer ring entry
+    /// @p_Position : Position in ring, wraps around
+    io_uring_buf& IoUring::GetBufferEntry(uint16 p_Position)
+    {
+        /// Entries start at the beginning of the ring, the first one overlaps the tail. We do not use bufs here,
+        /// it is declared behind an empty struct which takes up space in C++ and would shift every entry
+        return reinterpret_cast<io_uring_buf*>(m_BufferRing)[p_Position & m_BufferMask];
+    }
+    /// Make sure our queued entries are submitted once the current handler batch is done, must be called while holding our lock
+    void IoUring::ScheduleSubmit()
+    {
+        if (m_SubmitPending)
+            return;
+
+        m_SubmitPending = true;
+        boost::asio::post(m_Service, MakeAllocHandler([this]() { this->Submit(); }));
+    }
+    /// Submit queued entries, must be called while holding our lock
+    void IoUring::SubmitLocked()
+    {
+        while (m_ToSubmit > 0)
+        {
+            const int l_Submitted = static_cast<int>(syscall(__NR_io_uring_enter, m_RingDescriptor, m_ToSubmit, 0, 0, nullptr, 0));
+            m_SubmitCalls.fetch_add(1, std::memory_order_relaxed);
+
+            if (l_Submitted < 0)
+            {
+                if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+                    continue;
+
+                LOG_ERROR("IoUring", "io_uring_enter failed: %0", strerror(errno));
+                break;
+            }
+
+            m_ToSubmit -= std::min<uint32>(m_ToSubmit, static_cast<uint32>(l_Submitted));
+        }
+    }
+    /// Submit queued entries
+    void IoUring::Submit()
+    {
+        Utils::ObjectGuard l_Guard(this);
+
+        m_SubmitPending = false;
+        SubmitLocked();
+    }
+
+    /// Wait for our completion event
+    void IoUring::StartWait()
+    {
+        m_EventDescriptor.async_wait(boost::asio::posix::stream_descriptor::wait_read, MakeAllocHandler([this](boost::system::error_code const& p_ErrorCode)
+        {
+            if (p_ErrorCode)
+                return;
+
+            uint64 l_Value = 0;
+            if (read(m_EventDescriptor.native_handle(), &l_Value, sizeof(l_Value)) < 0 && errno != EAGAIN)
+                LOG_ERROR("IoUring", "Failed to read completion event: %0", strerror(errno));
+
+            Reap();
+            StartWait();
+        }));
+    }
+    /// Reap all completions
+    void IoUring::Reap()
+    {
+        uint32 l_Head = *m_CqHead;
+
+        for (;;)
+        {
+            const uint32 l_Tail = __atomic_load_n(m_CqTail, __ATOMIC_ACQUIRE);
+            if (l_Head == l_Tail)
+                break;
+
+            const io_uring_cqe l_Cqe = m_Cqes[l_Head & m_CqMask];
+
+            /// Free the entry before calling the handler, handlers may queue more work
+            l_Head++;
+            __atomic_store_n(m_CqHead, l_Head, __ATOMIC_RELEASE);
+
+            m_Completions.fetch_add(1, std::memory_order_relaxed);
+
+            IoUringOperation* l_Operation = reinterpret_cast<IoUringOperation*>(l_Cqe.user_data);
+            if (!l_Operation)
+                continue;
+
+            if (!(l_Cqe.flags & IORING_CQE_F_MORE))
+                l_Operation->Pending = false;
+
+            l_Operation->Handler(l_Cqe.res, l_Cqe.flags);
+        }
+    }
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
+
+#endif
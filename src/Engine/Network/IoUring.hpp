@@ -0,0 +1,170 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#ifdef STEERSTONE_IO_URING
+
+#include <boost/asio.hpp>
+#include <linux/io_uring.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "Core/Core.hpp"
+#include "Utility/UtiObjectGuard.hpp"
+#include "Utility/UtiLockable.hpp"
+
+#define IO_URING_ENTRIES            1024        ///< Submission queue size of each network thread
+#define IO_URING_BUFFER_COUNT       256         ///< Provided receive buffers of each network thread, must be a power of 2
+#define IO_URING_BUFFER_SIZE        4096        ///< Size of provided receive buffers, taken from BufferPool
+#define IO_URING_BUFFER_GROUP       0           ///< Buffer group of provided receive buffers
+#define IO_URING_MAX_SEND_VECTORS   16          ///< Chunks sent with a single sendmsg
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Operation in flight on an io_uring, owned by the socket which queued it
+    struct IoUringOperation
+    {
+        /// Constructor
+        IoUringOperation()
+            : Pending(false)
+        {
+        }
+
+        std::function<void(int32, uint32)> Handler;     ///< Called on our network thread with result and completion flags, set once
+        std::shared_ptr<void> Keep;                     ///< Keeps owner alive while operation is in flight
+        bool Pending;                                   ///< Operation has been queued and has not finished yet
+    };
+    /// Send operation, message and vectors must stay valid until completion
+    struct IoUringSendOperation : public IoUringOperation
+    {
+        msghdr Message;                                 ///< Message passed to sendmsg
+        iovec Vectors[IO_URING_MAX_SEND_VECTORS];       ///< Chunks being sent
+    };
+
+    /// Per network thread io_uring, completions are reaped on the io service of the network thread
+    /// Receives use multishot recv into provided buffers from BufferPool, so a readable socket costs
+    /// no readiness notification and no recv syscall. Submissions are batched, one io_uring_enter
+    /// is done for every operation queued while the io service runs a batch of handlers
+    class IoUring : private Utils::Lockable
+    {
+        DISALLOW_COPY_AND_ASSIGN(IoUring);
+
+        /// Allow access to lock / unlock methods
+        friend class Utils::ObjectGuard<IoUring>;
+
+        public:
+            /// Constructor
+            /// @p_Service : IO service of our network thread
+            explicit IoUring(boost::asio::io_service& p_Service);
+            /// Deconstructor
+            ~IoUring();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Set up ring and provided buffers, fails on kernels without multishot recv (< 6.0)
+            /// @p_Entries     : Submission queue size
+            /// @p_BufferCount : Amount of provided receive buffers, must be a power of 2
+            bool Initialize(uint32 p_Entries, uint32 p_BufferCount);
+
+            /// Queue multishot receive, completes once for every recieved packet until it finishes without IORING_CQE_F_MORE
+            /// @p_Descriptor : Socket descriptor
+            /// @p_Operation  : Operation to complete
+            void QueueReceive(int p_Descriptor, IoUringOperation* p_Operation);
+            /// Queue vectored send of p_Operation->Vectors
+            /// @p_Descriptor : Socket descriptor
+            /// @p_Operation  : Operation to complete
+            /// @p_Count      : Amount of vectors
+            void QueueSend(int p_Descriptor, IoUringSendOperation* p_Operation, std::size_t p_Count);
+            /// Cancel operation, it completes with -ECANCELED
+            /// @p_Operation : Operation to cancel
+            void Cancel(IoUringOperation* p_Operation);
+
+            /// Get provided buffer of a completed receive
+            /// @p_Flags : Completion flags
+            uint8 const* GetBuffer(uint32 p_Flags) const;
+            /// Give provided buffer of a completed receive back to the kernel
+            /// @p_Flags : Completion flags
+            void RecycleBuffer(uint32 p_Flags);
+
+            /// Get amount of io_uring_enter calls
+            uint64 GetSubmitCalls() const;
+            /// Get amount of reaped completions
+            uint64 GetCompletions() const;
+
+        private:
+            /// Get free submission entry, must be called while holding our lock
+            io_uring_sqe* GetSqe();
+            /// Get buffer ring entry
+            /// @p_Position : Position in ring, wraps around
+            io_uring_buf& GetBufferEntry(uint16 p_Position);
+            /// Make sure our queued entries are submitted once the current handler batch is done, must be called while holding our lock
+            void ScheduleSubmit();
+            /// Submit queued entries, must be called while holding our lock
+            void SubmitLocked();
+            /// Submit queued entries
+            void Submit();
+
+            /// Wait for our completion event
+            void StartWait();
+            /// Reap all completions
+            void Reap();
+
+        private:
+            boost::asio::io_service& m_Service;                     ///< IO Service of our network thread
+            boost::asio::posix::stream_descriptor m_EventDescriptor;///< Completion eventfd
+            int m_RingDescriptor;                                   ///< Ring descriptor
+            /// Submission queue
+            void* m_SqMap;                                          ///< Submission ring mapping
+            std::size_t m_SqMapSize;                                ///< Size of submission ring mapping
+            io_uring_sqe* m_Sqes;                                   ///< Submission entries
+            std::size_t m_SqesSize;                                 ///< Size of submission entries mapping
+            uint32* m_SqHead;                                       ///< Head, advanced by the kernel
+            uint32* m_SqTail;                                       ///< Tail, advanced by us
+            uint32 m_SqMask;                                        ///< Ring mask
+            uint32 m_SqEntries;                                     ///< Ring size
+            uint32* m_SqArray;                                      ///< Index array
+            uint32 m_ToSubmit;                                      ///< Entries queued since last submit
+            bool m_SubmitPending;                                   ///< Submit has been posted
+            /// Completion queue
+            void* m_CqMap;                                          ///< Completion ring mapping, may be the submission mapping
+            std::size_t m_CqMapSize;                                ///< Size of completion ring mapping
+            uint32* m_CqHead;                                       ///< Head, advanced by us
+            uint32* m_CqTail;                                       ///< Tail, advanced by the kernel
+            uint32 m_CqMask;                                        ///< Ring mask
+            io_uring_cqe* m_Cqes;                                   ///< Completion entries
+            /// Provided buffers
+            io_uring_buf_ring* m_BufferRing;                        ///< Buffer ring shared with the kernel
+            std::size_t m_BufferRingSize;                           ///< Size of buffer ring mapping
+            std::vector<uint8*> m_Buffers;                          ///< Buffers, index is buffer id
+            std::vector<uint8> m_BufferTiers;                       ///< Pool tier of each buffer
+            uint16 m_BufferTail;                                    ///< Tail of buffer ring
+            uint16 m_BufferMask;                                    ///< Buffer ring mask
+            /// Statistics
+            std::atomic<uint64> m_SubmitCalls;                      ///< io_uring_enter calls
+            std::atomic<uint64> m_Completions;                      ///< Reaped completions
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
+
+#endif
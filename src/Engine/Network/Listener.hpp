@@ -18,15 +18,24 @@
 
 #pragma once
 #include "PCH/Precompiled.hpp"
+#include <future>
 
 #include "Core/Core.hpp"
 #include "Threading/ThrTaskManager.hpp"
-#include "NetworkThread.hpp"
+#include "NetworkThreadPool.hpp"
 #include "Socket.hpp"
+#include "SocketHandoff.hpp"
 #include "Logger/LogDefines.hpp"
+#include "Metrics/MetRegistry.hpp"
+
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+#include <unistd.h>
+#endif
 
 namespace SteerStone { namespace Core { namespace Network {
 
+    /// Accepts connections of socket type T on a single port
+    /// Several listeners with different socket types may share one network thread pool
     template<typename T> class Listener
     {
         DISALLOW_COPY_AND_ASSIGN(Listener);
@@ -35,90 +44,271 @@ namespace SteerStone { namespace Core { namespace Network {
         //////////////////////////////////////////////////////////////////////////
 
         public:
-            /// Constructor
+            /// Constructor, spawns network threads used by this listener only
             /// @p_Address       : IP Address
             /// @p_Port          : Port
             /// @p_WorkerThreads : Amount of services to spawn
-            Listener(std::string const& p_Address, const uint16& p_Port, const uint8& p_WorkerThreads) 
-                : m_Service(new boost::asio::io_service()),
-                  m_Acceptor(new boost::asio::ip::tcp::acceptor(*m_Service, boost::asio::ip::tcp::endpoint(boost::asio::ip::address::from_string(p_Address), p_Port)))
+            /// @p_ReusePort     : Each worker thread accepts on its own SO_REUSEPORT acceptor instead of a shared listener thread
+            /// @p_Handoff       : Descriptors received from the previous process, nullptr to bind a new listener
+            Listener(std::string const& p_Address, const uint16& p_Port, const uint8& p_WorkerThreads, bool p_ReusePort = false, SocketHandoff* p_Handoff = nullptr)
+                : m_OwnedPool(new NetworkThreadPool(p_WorkerThreads)), m_Pool(m_OwnedPool.get()), m_Admission(std::make_shared<AcceptAdmission>()), m_Port(p_Port),
+                m_Accepting(false), m_Stopped(nullptr)
+            {
+                Start(p_Address, p_ReusePort, p_Handoff);
+                RegisterMetrics();
+            }
+            /// Constructor
+            /// @p_Address   : IP Address
+            /// @p_Port      : Port
+            /// @p_Pool      : Network threads our sockets are served by, must outlive us
+            /// @p_ReusePort : Each worker thread accepts on its own SO_REUSEPORT acceptor instead of a shared listener thread
+            /// @p_Handoff   : Descriptors received from the previous process, nullptr to bind a new listener
+            Listener(std::string const& p_Address, const uint16& p_Port, NetworkThreadPool& p_Pool, bool p_ReusePort = false, SocketHandoff* p_Handoff = nullptr)
+                : m_Pool(&p_Pool), m_Admission(std::make_shared<AcceptAdmission>()), m_Port(p_Port), m_Accepting(false), m_Stopped(nullptr)
             {
-                for (uint8 l_I = 0; l_I < p_WorkerThreads; l_I++)
-                    m_NetworkThreads.push_back(std::unique_ptr<NetworkThread<T>>(new NetworkThread<T>(l_I)));
+                Start(p_Address, p_ReusePort, p_Handoff);
+                RegisterMetrics();
+            }
+            /// Deconstructor
+            ~Listener()
+            {
+                for (const uint64 l_Callback : m_MetricsCallbacks)
+                    sMetrics->RemoveCallback(l_Callback);
 
-                std::function<bool()> l_Service = [this]() -> bool {
-                    this->m_Service->run();
-                    return true;
-                };
+                StopAccepting();
+            }
 
-                BeginAccept();
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
 
-                m_AcceptorTask = sThreadManager->PushTask("LISTENER_THREAD", Threading::TaskType::Moderate, 0, l_Service);
+            /// Periodically move quiet sockets from the busiest network thread to the quietest one
+            /// @p_Interval  : Milliseconds between checks
+            /// @p_BatchSize : Maximum amount of sockets moved per check
+            void EnableMigration(uint32 p_Interval, uint32 p_BatchSize)
+            {
+                m_Pool->EnableMigration(p_Interval, p_BatchSize);
             }
-            /// Deconstructor
-            ~Listener()
+            /// Set limits of accepted connections, rejected connections are closed before they allocate anything
+            /// @p_Policy : Limits
+            void SetAdmissionPolicy(AdmissionPolicy const& p_Policy)
+            {
+                m_Admission->SetPolicy(p_Policy);
+            }
+            /// Get admission statistics
+            AdmissionStatistics GetAdmissionStatistics() const
             {
-                m_Acceptor->close();
+                return m_Admission->GetStatistics();
+            }
+            /// Stop accepting and hand our listening descriptor over to a new process, see SocketHandoff::Serve
+            /// SO_REUSEPORT acceptors are closed instead, the new process binds its own next to them
+            /// @p_Handoff     : Handoff collecting descriptors
+            /// @p_Connections : Also hand over established connections which have nothing in flight
+            void Handoff(SocketHandoff& p_Handoff, bool p_Connections)
+            {
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+                /// Our duplicate keeps the listening socket and its backlog alive once we have closed our acceptor
+                const int l_Descriptor = m_Acceptor ? dup(m_Acceptor->native_handle()) : -1;
+
+                StopAccepting();
+
+                if (l_Descriptor >= 0)
+                    p_Handoff.AddListener(m_Port, l_Descriptor);
+
+                if (!p_Connections)
+                    return;
+
+                std::size_t l_Count = 0;
+                for (std::size_t l_I = 0; l_I < m_Pool->GetThreadCount(); l_I++)
+                {
+                    for (HandoffConnection& l_Connection : m_Pool->GetThread(l_I)->ReleaseSockets(m_Port))
+                    {
+                        p_Handoff.AddConnection(std::move(l_Connection));
+                        l_Count++;
+                    }
+                }
+
+                LOG_INFO("Listener", "Handing over %0 connections on port %1", l_Count, m_Port);
+#else
+                LOG_ERROR("Listener", "Socket handoff is not supported on this platform");
+#endif
+            }
+
+        private:
+            /// Register admission statistics of our port into the metrics registry
+            void RegisterMetrics()
+            {
+                const Metrics::MetricLabels l_Labels = { { "port", std::to_string(m_Port) } };
+                AcceptAdmission const* l_Admission = m_Admission.get();
+
+                m_MetricsCallbacks.push_back(sMetrics->AddCallback("steerstone_listener_accepted_total", "Connections admitted", Metrics::MetricType::Counter, l_Labels,
+                    [l_Admission]() { return static_cast<double>(l_Admission->GetStatistics().Accepted); }));
+                m_MetricsCallbacks.push_back(sMetrics->AddCallback("steerstone_listener_rejected_total", "Connections rejected by admission control", Metrics::MetricType::Counter, l_Labels,
+                    [l_Admission]()
+                    {
+                        const AdmissionStatistics l_Statistics = l_Admission->GetStatistics();
+                        return static_cast<double>(l_Statistics.RateLimited + l_Statistics.GlobalLimited + l_Statistics.ConnectionLimited);
+                    }));
+            }
+            /// Stop accepting connections, sockets which have been accepted already stay open
+            void StopAccepting()
+            {
+                /// Worker threads own their acceptors in SO_REUSEPORT mode
+                if (!m_Acceptor)
+                {
+                    for (std::size_t l_I = 0; l_I < m_Pool->GetThreadCount(); l_I++)
+                        m_Pool->GetThread(l_I)->StopAccept(m_Port);
+
+                    return;
+                }
+
+                /// Close our acceptor on its own thread and wait until the socket of the pending accept
+                /// has been removed, it would stay in the shared network threads otherwise
+                std::promise<void> l_Stopped;
+                std::future<void> l_Future = l_Stopped.get_future();
+
+                boost::asio::post(*m_Service, [this, &l_Stopped]()
+                {
+                    m_Stopped = &l_Stopped;
+
+                    if (!m_Accepting)
+                        l_Stopped.set_value();
+
+                    boost::system::error_code l_ErrorCode;
+                    m_Acceptor->close(l_ErrorCode);
+                });
+
+                l_Future.wait();
+
                 m_Service->stop();
                 sThreadManager->PopTask(m_AcceptorTask);
                 m_Acceptor.reset();
                 m_Service.reset();
             }
+            /// Start accepting connections
+            /// @p_Address   : IP Address
+            /// @p_ReusePort : Each worker thread accepts on its own SO_REUSEPORT acceptor instead of a shared listener thread
+            /// @p_Handoff   : Descriptors received from the previous process, nullptr to bind a new listener
+            void Start(std::string const& p_Address, bool p_ReusePort, SocketHandoff* p_Handoff)
+            {
+                if (p_Handoff)
+                    AdoptConnections(*p_Handoff);
 
-            //////////////////////////////////////////////////////////////////////////
-            //////////////////////////////////////////////////////////////////////////
+                /// A handed over listener keeps the backlog of the previous process, we do not bind at all
+                const int l_Listener = p_Handoff ? p_Handoff->TakeListener(m_Port) : -1;
 
-        private:
-            /// Select the worker with lowest storage size (equal distrubition)
-            NetworkThread<T>* SelectWorker() const
-            {
-                std::size_t l_MinimumSize = m_NetworkThreads.size();
-                std::size_t l_Index = 0;
+                if (p_ReusePort && l_Listener < 0)
+                {
+                    bool l_Bound = true;
+                    for (std::size_t l_I = 0; l_I < m_Pool->GetThreadCount(); l_I++)
+                        l_Bound = m_Pool->GetThread(l_I)->template StartAccept<T>(p_Address, m_Port, m_Admission) && l_Bound;
+
+                    if (l_Bound)
+                    {
+                        LOG_INFO("Listener", "Accepting connections on %0:%1 with %2 SO_REUSEPORT acceptors", p_Address, m_Port, m_Pool->GetThreadCount());
+                        return;
+                    }
 
-                for (std::size_t l_I = 0; l_I < m_NetworkThreads.size(); l_I++)
+                    LOG_ERROR("Listener", "Failed to start SO_REUSEPORT acceptors, falling back to single listener thread");
+
+                    for (std::size_t l_I = 0; l_I < m_Pool->GetThreadCount(); l_I++)
+                        m_Pool->GetThread(l_I)->StopAccept(m_Port);
+                }
+
+                m_Service.reset(new boost::asio::io_service());
+
+                if (l_Listener >= 0)
                 {
-                    const std::size_t l_Size = m_NetworkThreads[l_I]->GetSize();
+                    m_Acceptor.reset(new boost::asio::ip::tcp::acceptor(*m_Service));
+                    m_Acceptor->assign(SocketHandoff::GetProtocol(l_Listener), l_Listener);
 
-                    if (l_Size < l_MinimumSize)
+                    LOG_INFO("Listener", "Accepting connections on port %0 with listener of previous process", m_Port);
+                }
+                else
+                    m_Acceptor.reset(new boost::asio::ip::tcp::acceptor(*m_Service, boost::asio::ip::tcp::endpoint(boost::asio::ip::address::from_string(p_Address), m_Port)));
+
+                std::function<bool()> l_Service = [this]() -> bool {
+                    this->m_Service->run();
+                    return true;
+                };
+
+                BeginAccept();
+
+                m_AcceptorTask = sThreadManager->PushTask(Utils::StringBuilder("LISTENER_THREAD_%0", m_Port), Threading::TaskType::Dedicated, 0, l_Service);
+            }
+            /// Continue connections of our port handed over by the previous process
+            /// @p_Handoff : Descriptors received from the previous process
+            void AdoptConnections(SocketHandoff& p_Handoff)
+            {
+                std::vector<HandoffConnection> l_Connections = p_Handoff.TakeConnections(m_Port);
+                std::size_t l_Adopted = 0;
+
+                for (HandoffConnection& l_Connection : l_Connections)
+                {
+                    if (m_Pool->SelectWorker()->template AdoptSocket<T>(l_Connection))
+                        l_Adopted++;
+                    else if (l_Connection.Descriptor >= 0)
                     {
-                        l_MinimumSize = l_Size;
-                        l_Index = l_I;
+                        boost::system::error_code l_ErrorCode;
+                        boost::asio::detail::socket_ops::state_type l_State = 0;
+                        boost::asio::detail::socket_ops::close(l_Connection.Descriptor, l_State, true, l_ErrorCode);
                     }
                 }
 
-                return m_NetworkThreads[l_Index].get();
+                if (!l_Connections.empty())
+                    LOG_INFO("Listener", "Adopted %0 of %1 connections on port %2 from previous process", l_Adopted, l_Connections.size(), m_Port);
             }
             /// Accept incoming connections
-            void Listener<T>::BeginAccept()
+            void BeginAccept()
             {
-                auto l_Worker = SelectWorker();
-                auto l_Socket = l_Worker->CreateSocket();
+                auto l_Worker = m_Pool->SelectWorker();
+                auto l_Socket = l_Worker->template CreateSocket<T>();
+                if (!l_Socket)
+                {
+                    LOG_ERROR("Listener", "Failed to create socket, no longer accepting connections");
+                    return;
+                }
 
+                m_Accepting = true;
                 m_Acceptor->async_accept(l_Socket->GetAsioSocket(),
-                    [this, l_Worker, l_Socket](const boost::system::error_code& p_ErrorCode)
+                    MakeAllocHandler([this, l_Worker, l_Socket](const boost::system::error_code& p_ErrorCode)
                     {
                         this->OnAccept(l_Worker, l_Socket, p_ErrorCode);
-                    });
+                    }));
             }
             /// Accept new connection and create socket
-            void Listener<T>::OnAccept(NetworkThread<T>* p_Worker, std::shared_ptr<T> const& p_Socket, const boost::system::error_code& p_ErrorCode)
+            void OnAccept(PoolNetworkThread* p_Worker, std::shared_ptr<T> const& p_Socket, const boost::system::error_code& p_ErrorCode)
             {
+                m_Accepting = false;
+
                 if (p_ErrorCode)
                     p_Worker->RemoveSocket(p_Socket.get());
-                else
-                    p_Socket->Open();
+                else if (!p_Worker->AdmitSocket(p_Socket, m_Admission) || !p_Socket->Open())
+                    p_Worker->RemoveSocket(p_Socket.get());
+
+                /// Acceptor has been closed, we are shutting down
+                if (m_Stopped)
+                {
+                    m_Stopped->set_value();
+                    return;
+                }
 
                 /// Return back and accept any more incoming connections
                 BeginAccept();
             }
 
         private:
+            std::unique_ptr<NetworkThreadPool> m_OwnedPool;                         ///< Network threads, only set if we do not share a pool
+            NetworkThreadPool* m_Pool;                                              ///< Network threads serving our sockets
+            std::shared_ptr<AcceptAdmission> m_Admission;                           ///< Admission control, shared with the sockets it counts
+            uint16 m_Port;                                                          ///< Port
             std::unique_ptr<boost::asio::io_service> m_Service;                     ///< IO Service
-            std::vector<std::unique_ptr<NetworkThread<T>>> m_NetworkThreads;        ///< Worker threads
             std::unique_ptr<boost::asio::ip::tcp::acceptor> m_Acceptor;             ///< IO Acceptor
             Threading::Task::Ptr m_AcceptorTask;                                    ///< Acceptor Task
+            bool m_Accepting;                                                       ///< An accept is pending, only touched from our acceptor thread
+            std::promise<void>* m_Stopped;                                          ///< Set once we are shutting down, only touched from our acceptor thread
+            std::vector<uint64> m_MetricsCallbacks;                                 ///< Ids of our metrics series
     };
 
 }   ///< namespace Network
 }   ///< namespace Core
-}   ///< namespace Steerstone
\ No newline at end of file
+}   ///< namespace Steerstone
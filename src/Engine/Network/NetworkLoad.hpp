@@ -0,0 +1,102 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <atomic>
+
+#include "Core/Core.hpp"
+
+#define NETWORK_LOAD_SAMPLE_INTERVAL    1000        ///< Milliseconds between load samples
+#define NETWORK_LOAD_EWMA_ALPHA         0.3         ///< Weight of the newest sample
+#define NETWORK_LOAD_BYTES_PER_EVENT    1024.0      ///< Bytes transferred which cost about as much as a single handler
+#define NETWORK_LOAD_SOCKET_WEIGHT      0.05        ///< Cost of an idle socket (pings, timers) in handlers per second
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Measured load of a network thread
+    /// Counters are only written by the network thread itself, rates are read by the listener
+    class NetworkThreadLoad
+    {
+        public:
+            /// Constructor
+            NetworkThreadLoad()
+                : m_Events(0), m_Bytes(0), m_SampledEvents(0), m_SampledBytes(0), m_EventRate(0.0), m_ByteRate(0.0)
+            {
+            }
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Account a completed handler, only called from our network thread
+            /// @p_Bytes : Bytes transferred by handler
+            void AddEvent(std::size_t p_Bytes)
+            {
+                m_Events.store(m_Events.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                m_Bytes.store(m_Bytes.load(std::memory_order_relaxed) + p_Bytes, std::memory_order_relaxed);
+            }
+            /// Fold counters since last sample into our rates, only called from our network thread
+            /// @p_Elapsed : Seconds since last sample
+            void Sample(double p_Elapsed)
+            {
+                if (p_Elapsed <= 0.0)
+                    return;
+
+                const uint64 l_Events   = m_Events.load(std::memory_order_relaxed);
+                const uint64 l_Bytes    = m_Bytes.load(std::memory_order_relaxed);
+
+                const double l_EventRate    = static_cast<double>(l_Events - m_SampledEvents) / p_Elapsed;
+                const double l_ByteRate     = static_cast<double>(l_Bytes - m_SampledBytes) / p_Elapsed;
+
+                m_SampledEvents = l_Events;
+                m_SampledBytes  = l_Bytes;
+
+                m_EventRate.store(NETWORK_LOAD_EWMA_ALPHA * l_EventRate + (1.0 - NETWORK_LOAD_EWMA_ALPHA) * m_EventRate.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                m_ByteRate.store(NETWORK_LOAD_EWMA_ALPHA * l_ByteRate + (1.0 - NETWORK_LOAD_EWMA_ALPHA) * m_ByteRate.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+
+            /// Get smoothed handlers per second
+            double GetEventRate() const
+            {
+                return m_EventRate.load(std::memory_order_relaxed);
+            }
+            /// Get smoothed bytes per second
+            double GetByteRate() const
+            {
+                return m_ByteRate.load(std::memory_order_relaxed);
+            }
+            /// Get load score in handlers per second, used to place and migrate sockets
+            /// @p_Sockets : Amount of sockets on network thread
+            double GetScore(std::size_t p_Sockets) const
+            {
+                return GetEventRate() + GetByteRate() / NETWORK_LOAD_BYTES_PER_EVENT + static_cast<double>(p_Sockets) * NETWORK_LOAD_SOCKET_WEIGHT;
+            }
+
+        private:
+            std::atomic<uint64> m_Events;           ///< Handlers completed
+            std::atomic<uint64> m_Bytes;            ///< Bytes transferred
+            uint64 m_SampledEvents;                 ///< Handlers completed at last sample
+            uint64 m_SampledBytes;                  ///< Bytes transferred at last sample
+            std::atomic<double> m_EventRate;        ///< Smoothed handlers per second
+            std::atomic<double> m_ByteRate;         ///< Smoothed bytes per second
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
@@ -24,12 +24,24 @@
 #include "Utility/UtiString.hpp"
 #include "Utility/UtiObjectGuard.hpp"
 #include "Utility/UtiLockable.hpp"
+#include "Memory/MemObjectPool.hpp"
 #include "Logger/LogDefines.hpp"
 #include "Socket.hpp"
+#include "TimerWheel.hpp"
+#include "NetworkLoad.hpp"
+#include "IoUring.hpp"
+
+#include <atomic>
+#include <algorithm>
+#include <future>
+
+#define NETWORK_THREAD_SOCKET_RESERVE           1024
+#define NETWORK_THREAD_CONTROL_BLOCK_SIZE       (2 * sizeof(void*))     ///< Vtable and use counts of the pooled shared_ptr control block of a socket
+#define NETWORK_THREAD_MEMORY_SAMPLE_INTERVAL   10000                   ///< Milliseconds between two samples of the memory held by our sockets
 
 namespace SteerStone { namespace Core { namespace Network {
 
-    template<typename T> class NetworkThread : private Utils::LockableReadWrite
+    template<typename T> class NetworkThread : public SocketOwner, private Utils::Lockable
     {
         DISALLOW_COPY_AND_ASSIGN(NetworkThread);
 
@@ -41,31 +53,70 @@ namespace SteerStone { namespace Core { namespace Network {
         friend class Utils::ObjectReadGuard<NetworkThread>;
         friend class Utils::ObjectWriteGuard<NetworkThread>;
 
+        struct Acceptor;
+
         public:
             /// Constructor
             /// @p_WorkerThread : Worker thread number spawned
             NetworkThread(uint8 const& p_WorkerThread) 
-                : m_Worker(new boost::asio::io_service::work(m_Service))
+                : m_Worker(new boost::asio::io_service::work(m_Service)), m_TimerWheel(std::make_shared<TimerWheel>()), m_TimerWheelTimer(m_Service),
+                m_LastLoadSample(std::chrono::steady_clock::now()), m_LastMemorySample(m_LastLoadSample), m_MemoryUsage(), m_FreeSlot(InvalidSlot), m_Size(0),
+                m_PlacementGroup(p_WorkerThread)
             {
+                m_Slots.reserve(NETWORK_THREAD_SOCKET_RESERVE);
+                m_Active.reserve(NETWORK_THREAD_SOCKET_RESERVE);
+                m_ActiveSlots.reserve(NETWORK_THREAD_SOCKET_RESERVE);
+
                 std::function<bool()> l_Service = [this]() -> bool {
                     this->m_Service.run();
                     return true;
                 };
 
-                 l_Task = sThreadManager->PushTask(Utils::StringBuilder("NETWORK_SERVER_WORKER_THREAD_%0", p_WorkerThread), Threading::TaskType::Moderate, -1, l_Service);
+#ifdef STEERSTONE_IO_URING
+                m_Ring.reset(new IoUring(m_Service));
+                if (!m_Ring->Initialize(IO_URING_ENTRIES, IO_URING_BUFFER_COUNT))
+                {
+                    LOG_WARNING("NetworkThread", "io_uring is not available, worker thread %0 falls back to the asio reactor", p_WorkerThread);
+                    m_Ring.reset();
+                }
+#endif
+
+                 StartTimerWheelTimer();
+
+                 l_Task = sThreadManager->PushTask(Utils::StringBuilder("NETWORK_SERVER_WORKER_THREAD_%0", p_WorkerThread), Threading::TaskType::Dedicated, -1, l_Service, m_PlacementGroup);
             }
             /// Deconstructor
             ~NetworkThread()
             {
+                /// Stop accepting new connections
+                for (auto& l_Acceptor : m_Acceptors)
+                {
+                    boost::system::error_code l_ErrorCode;
+                    l_Acceptor->Socket.close(l_ErrorCode);
+                }
+
                 /// Allow IO Service to exit
+                boost::system::error_code l_TimerError;
+                m_TimerWheelTimer.cancel(l_TimerError);
                 m_Worker.reset();
                 m_Service.stop();
 
-                /// Close all active sockets
-                for (auto l_Itr = m_Sockets.begin(); l_Itr != m_Sockets.end(); l_Itr++)
+                /// Close all active sockets, take ownership first as closing removes them from our storage
+                std::vector<std::shared_ptr<T>> l_Sockets;
+                l_Sockets.reserve(m_Active.size());
+
+                for (uint32 l_SlotIndex : m_ActiveSlots)
+                    l_Sockets.push_back(std::move(m_Slots[l_SlotIndex].Socket));
+
+                m_Slots.clear();
+                m_Active.clear();
+                m_ActiveSlots.clear();
+                m_FreeSlot = InvalidSlot;
+
+                for (auto& l_Socket : l_Sockets)
                 {
-                    if (!(*l_Itr)->IsClosed())
-                        (*l_Itr)->CloseSocket();
+                    if (!l_Socket->IsClosed())
+                        l_Socket->CloseSocket();
                 }
 
                 sThreadManager->PopTask(l_Task);
@@ -74,35 +125,542 @@ namespace SteerStone { namespace Core { namespace Network {
             //////////////////////////////////////////////////////////////////////////
             //////////////////////////////////////////////////////////////////////////
 
-            /// Get size of Socket storage
+            /// Get size of Socket storage, safe to call from any thread
             std::size_t GetSize() const
             {
-                return m_Sockets.size();
+                return m_Size.load(std::memory_order_relaxed);
+            }
+            /// Get placement group of our worker, tasks of our sockets pushed with it run on the same NUMA node
+            int32 GetPlacementGroup() const
+            {
+                return m_PlacementGroup;
+            }
+            /// Get measured load
+            NetworkThreadLoad const& GetLoad() const
+            {
+                return m_Load;
+            }
+            /// Get memory held by our sockets at the last sample, safe to call from any thread
+            /// Object also counts the slot of every socket in our storage
+            SocketMemoryUsage GetMemoryUsage() const
+            {
+                Utils::ObjectGuard l_Guard(const_cast<NetworkThread*>(this));
+                return m_MemoryUsage;
+            }
+            /// Get load score used to place new sockets, safe to call from any thread
+            double GetScore() const
+            {
+                return m_Load.GetScore(GetSize());
+            }
+            /// Get IO service, usable as executor of future continuations and coroutines (see Threading::Future)
+            boost::asio::io_service& GetIOService()
+            {
+                return m_Service;
             }
 
-            /// Create socket
-            std::shared_ptr<T> NetworkThread<T>::CreateSocket()
+            /// Create socket, a shared network thread of T = Socket holds sockets of any type
+            template<typename U = T> std::shared_ptr<U> CreateSocket()
             {
-                Utils::ObjectGuard l_Guard(this);
+                static_assert(std::is_base_of<T, U>::value, "Socket type must derive from the socket type of our network thread");
+
+                std::shared_ptr<U> l_Socket = Memory::ObjectPool<U>::MakeShared(m_Service, this);
+                l_Socket->m_Cold->ObjectSize = sizeof(U) + NETWORK_THREAD_CONTROL_BLOCK_SIZE;
+                l_Socket->m_TimerWheel  = m_TimerWheel;
+                l_Socket->m_Load        = &m_Load;
+#ifdef STEERSTONE_IO_URING
+                l_Socket->m_Ring        = m_Ring.get();
+#endif
 
-                m_Sockets.emplace(std::make_shared<T>(m_Service, [this](Socket* p_Socket) { this->RemoveSocket(p_Socket); }));
-                
-                return *m_Sockets.begin();
+                if (!AttachSocket(l_Socket))
+                    return nullptr;
+
+                return l_Socket;
             }
             /// Remove socket from storage
             /// @p_Socket : Socket being removed
-            void RemoveSocket(Socket* p_Socket)
+            virtual void RemoveSocket(Socket* p_Socket) override
+            {
+                std::shared_ptr<T> l_Socket = DetachSocket(p_Socket);
+                if (!l_Socket)
+                    return;
+
+                /// We are usually called from within the socket itself, release our reference once it has returned
+                boost::asio::post(m_Service, MakeAllocHandler([l_Socket]() {}));
+            }
+            /// Get socket from handle
+            /// @p_Handle : Handle of socket
+            /// Returns nullptr if socket has been removed
+            std::shared_ptr<T> GetSocket(SocketHandle const& p_Handle)
+            {
+                Utils::ObjectGuard l_Guard(this);
+
+                if (!IsValidHandle(p_Handle))
+                    return nullptr;
+
+                return m_Slots[p_Handle.GetIndex()].Socket;
+            }
+            /// Call function for each active socket, sockets are stored contiguous
+            /// @p_Function : Function to call, must not create or remove sockets
+            void ForEachSocket(std::function<void(T*)> const& p_Function)
+            {
+                Utils::ObjectGuard l_Guard(this);
+
+                for (T* l_Socket : m_Active)
+                    p_Function(l_Socket);
+            }
+
+            /// Run admission control on an accepted socket before it is opened, rejected sockets are closed
+            /// @p_Socket    : Accepted socket
+            /// @p_Admission : Admission control, nullptr to admit everything
+            /// Returns false if socket must be removed
+            bool AdmitSocket(std::shared_ptr<T> const& p_Socket, std::shared_ptr<AcceptAdmission> const& p_Admission)
+            {
+                if (!p_Admission)
+                    return true;
+
+                boost::system::error_code l_ErrorCode;
+                const boost::asio::ip::tcp::endpoint l_EndPoint = p_Socket->GetAsioSocket().remote_endpoint(l_ErrorCode);
+                if (l_ErrorCode)
+                    return false;
+
+                const AdmissionKey l_Key = AcceptAdmission::MakeKey(l_EndPoint.address());
+
+                bool l_Tracked = false;
+                if (p_Admission->Admit(l_Key, l_Tracked) != AdmissionResult::Accepted)
+                {
+                    p_Socket->GetAsioSocket().close(l_ErrorCode);
+                    return false;
+                }
+
+                if (l_Tracked)
+                {
+                    p_Socket->m_Cold->Admission         = p_Admission;
+                    p_Socket->m_Cold->AdmissionAddress  = l_Key;
+                }
+
+                return true;
+            }
+
+            /// Accept connections on our own acceptor, bound with SO_REUSEPORT so the kernel spreads
+            /// incoming connections over every network thread listening on the same port
+            /// Sockets are accepted on the io service which will handle them, no connection crosses threads
+            /// A network thread may accept on several ports, each with its own socket type
+            /// @p_Address   : IP Address
+            /// @p_Port      : Port
+            /// @p_Admission : Admission control of accepted connections, nullptr to admit everything
+            template<typename U = T> bool StartAccept(std::string const& p_Address, uint16 const& p_Port, std::shared_ptr<AcceptAdmission> const& p_Admission = nullptr)
+            {
+#ifdef SO_REUSEPORT
+                typedef boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT> ReusePort;
+
+                std::unique_ptr<Acceptor> l_Acceptor(new Acceptor(m_Service));
+                l_Acceptor->Port         = p_Port;
+                l_Acceptor->Admission    = p_Admission;
+                l_Acceptor->CreateSocket = [this]() -> std::shared_ptr<T> { return this->template CreateSocket<U>(); };
+
+                try
+                {
+                    boost::asio::ip::tcp::endpoint l_EndPoint(boost::asio::ip::address::from_string(p_Address), p_Port);
+
+                    l_Acceptor->Socket.open(l_EndPoint.protocol());
+                    l_Acceptor->Socket.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
+                    l_Acceptor->Socket.set_option(ReusePort(true));
+                    l_Acceptor->Socket.bind(l_EndPoint);
+                    l_Acceptor->Socket.listen();
+                }
+                catch (boost::system::system_error const& p_Error)
+                {
+                    LOG_ERROR("NetworkThread", "Failed to bind acceptor on %0:%1 with SO_REUSEPORT: %2", p_Address, p_Port, p_Error.what());
+                    return false;
+                }
+
+                Acceptor* l_Started = l_Acceptor.get();
+
+                {
+                    Utils::ObjectGuard l_Guard(this);
+                    m_Acceptors.push_back(std::move(l_Acceptor));
+                }
+
+                /// Acceptors are only touched from our own thread once they accept
+                boost::asio::post(m_Service, MakeAllocHandler([this, l_Started]() { this->BeginAccept(l_Started); }));
+
+                return true;
+#else
+                LOG_ERROR("NetworkThread", "SO_REUSEPORT is not supported on this platform");
+                return false;
+#endif
+            }
+
+            /// Stop accepting connections on port, sockets which have been accepted already stay open
+            /// @p_Port : Port
+            void StopAccept(uint16 p_Port)
+            {
+                Utils::ObjectGuard l_Guard(this);
+
+                for (auto& l_Acceptor : m_Acceptors)
+                {
+                    if (l_Acceptor->Port != p_Port)
+                        continue;
+
+                    /// Pending accepts complete with operation_aborted, the acceptor itself is kept until we are destroyed
+                    Acceptor* l_Stopped = l_Acceptor.get();
+                    boost::asio::post(m_Service, MakeAllocHandler([l_Stopped]()
+                    {
+                        boost::system::error_code l_ErrorCode;
+                        l_Stopped->Socket.close(l_ErrorCode);
+                    }));
+                }
+            }
+
+            /// Move up to p_Count quiet sockets to another network thread, the busiest sockets are moved first
+            /// Their descriptors are handed over to the io service of the target, no data is lost
+            /// @p_Target : Network thread to move sockets to
+            /// @p_Count  : Maximum amount of sockets to move
+            void MigrateSockets(NetworkThread<T>* p_Target, uint32 p_Count)
+            {
+                if (p_Target == this || p_Count == 0)
+                    return;
+
+                /// Sockets may only be inspected from our own thread
+                boost::asio::post(m_Service, MakeAllocHandler([this, p_Target, p_Count]() { this->OnMigrateSockets(p_Target, p_Count); }));
+            }
+
+            /// Hand over every connection accepted on port which has nothing in flight, see SocketHandoff
+            /// Blocks until our thread has released them, must not be called from our own thread
+            /// @p_Port : Local port of connections
+            std::vector<HandoffConnection> ReleaseSockets(uint16 p_Port)
+            {
+                std::promise<std::vector<HandoffConnection>> l_Promise;
+                std::future<std::vector<HandoffConnection>> l_Future = l_Promise.get_future();
+
+                /// Sockets may only be inspected from our own thread
+                boost::asio::post(m_Service, [this, p_Port, &l_Promise]() { l_Promise.set_value(this->OnReleaseSockets(p_Port)); });
+
+                return l_Future.get();
+            }
+            /// Continue a connection handed over by the previous process
+            /// @p_Connection : Handed over connection, its descriptor is taken on success
+            /// Returns nullptr if connection could not be adopted
+            template<typename U = T> std::shared_ptr<U> AdoptSocket(HandoffConnection& p_Connection)
+            {
+                std::shared_ptr<U> l_Socket = CreateSocket<U>();
+                if (!l_Socket)
+                    return nullptr;
+
+                boost::system::error_code l_ErrorCode;
+                l_Socket->GetAsioSocket().assign(SocketHandoff::GetProtocol(p_Connection.Descriptor), p_Connection.Descriptor, l_ErrorCode);
+                if (l_ErrorCode)
+                {
+                    LOG_ERROR("NetworkThread", "Failed to adopt handed over connection: %0", l_ErrorCode.message());
+                    RemoveSocket(l_Socket.get());
+                    return nullptr;
+                }
+
+                p_Connection.Descriptor = -1;
+                l_Socket->Adopt(p_Connection);
+
+                return l_Socket;
+            }
+
+        private:
+            /// Add socket to our storage
+            /// @p_Socket : Socket to add
+            bool AttachSocket(std::shared_ptr<T> const& p_Socket)
+            {
+                Utils::ObjectGuard l_Guard(this);
+
+                uint32 l_SlotIndex = m_FreeSlot;
+
+                if (l_SlotIndex != InvalidSlot)
+                    m_FreeSlot = m_Slots[l_SlotIndex].NextFree;
+                else
+                {
+                    if (m_Slots.size() > SocketHandle::MaxIndex)
+                    {
+                        LOG_ERROR("NetworkThread", "Socket storage is full (%0 sockets)", m_Slots.size());
+                        return false;
+                    }
+
+                    l_SlotIndex = static_cast<uint32>(m_Slots.size());
+                    m_Slots.emplace_back();
+                }
+
+                Slot& l_Slot = m_Slots[l_SlotIndex];
+                l_Slot.Socket       = p_Socket;
+                l_Slot.ActiveIndex  = static_cast<uint32>(m_Active.size());
+                l_Slot.Socket->m_Handle = SocketHandle(l_SlotIndex, l_Slot.Generation);
+
+                m_Active.push_back(l_Slot.Socket.get());
+                m_ActiveSlots.push_back(l_SlotIndex);
+                m_Size.store(m_Active.size(), std::memory_order_relaxed);
+
+                return true;
+            }
+            /// Remove socket from our storage without releasing it
+            /// @p_Socket : Socket to remove
+            /// Returns nullptr if socket is not in our storage
+            std::shared_ptr<T> DetachSocket(Socket* p_Socket)
+            {
+                Utils::ObjectGuard l_Guard(this);
+
+                const SocketHandle l_Handle = p_Socket->GetHandle();
+
+                if (!IsValidHandle(l_Handle) || m_Slots[l_Handle.GetIndex()].Socket.get() != p_Socket)
+                    return nullptr;
+
+                Slot& l_Slot = m_Slots[l_Handle.GetIndex()];
+                std::shared_ptr<T> l_Socket = std::move(l_Slot.Socket);
+
+                /// Keep active sockets contiguous, move the last one into the hole
+                const uint32 l_ActiveIndex = l_Slot.ActiveIndex;
+                m_Active[l_ActiveIndex]      = m_Active.back();
+                m_ActiveSlots[l_ActiveIndex] = m_ActiveSlots.back();
+                m_Slots[m_ActiveSlots[l_ActiveIndex]].ActiveIndex = l_ActiveIndex;
+                m_Active.pop_back();
+                m_ActiveSlots.pop_back();
+                m_Size.store(m_Active.size(), std::memory_order_relaxed);
+
+                /// Bump the generation so old handles no longer match, skip 0 which is reserved for invalid handles
+                l_Slot.Generation   = l_Slot.Generation == SocketHandle::MaxGeneration ? 1 : l_Slot.Generation + 1;
+                l_Slot.NextFree     = m_FreeSlot;
+                m_FreeSlot          = l_Handle.GetIndex();
+
+                return l_Socket;
+            }
+            /// Move quiet sockets to another network thread, called from our own thread
+            /// @p_Target : Network thread to move sockets to
+            /// @p_Count  : Maximum amount of sockets to move
+            void OnMigrateSockets(NetworkThread<T>* p_Target, uint32 p_Count)
+            {
+                std::vector<std::shared_ptr<T>> l_Candidates;
+
+                {
+                    Utils::ObjectGuard l_Guard(this);
+
+                    l_Candidates.reserve(m_ActiveSlots.size());
+                    for (uint32 l_SlotIndex : m_ActiveSlots)
+                        l_Candidates.push_back(m_Slots[l_SlotIndex].Socket);
+                }
+
+                /// Sockets which were busy recently but have nothing in flight right now move the most load
+                std::sort(l_Candidates.begin(), l_Candidates.end(), [](std::shared_ptr<T> const& p_Left, std::shared_ptr<T> const& p_Right)
+                {
+                    return p_Left->m_LoadEvents > p_Right->m_LoadEvents;
+                });
+
+                uint32 l_Migrated = 0;
+
+                for (std::shared_ptr<T> const& l_Socket : l_Candidates)
+                {
+                    if (l_Migrated < p_Count && l_Socket->MigrateTo(p_Target->m_Service, p_Target->m_TimerWheel, &p_Target->m_Load, p_Target))
+                    {
+                        DetachSocket(l_Socket.get());
+
+                        if (!p_Target->AttachSocket(l_Socket) || l_Socket->IsClosed())
+                        {
+                            if (!l_Socket->IsClosed())
+                                l_Socket->CloseSocket();
+
+                            p_Target->RemoveSocket(l_Socket.get());
+                        }
+
+                        l_Migrated++;
+                    }
+
+                    l_Socket->m_LoadEvents = 0;
+                }
+
+                if (l_Migrated)
+                    LOG_VERBOSE("NetworkThread", "Migrated %0 sockets to less loaded network thread", l_Migrated);
+            }
+            /// Hand over connections accepted on port, called from our own thread
+            /// @p_Port : Local port of connections
+            std::vector<HandoffConnection> OnReleaseSockets(uint16 p_Port)
+            {
+                std::vector<std::shared_ptr<T>> l_Candidates;
+
+                {
+                    Utils::ObjectGuard l_Guard(this);
+
+                    l_Candidates.reserve(m_ActiveSlots.size());
+                    for (uint32 l_SlotIndex : m_ActiveSlots)
+                        l_Candidates.push_back(m_Slots[l_SlotIndex].Socket);
+                }
+
+                std::vector<HandoffConnection> l_Connections;
+
+                for (std::shared_ptr<T> const& l_Socket : l_Candidates)
+                {
+                    HandoffConnection l_Connection;
+
+                    /// Released sockets are closed without notifying our close handler
+                    if (l_Socket->ReleaseForHandoff(p_Port, l_Connection))
+                    {
+                        DetachSocket(l_Socket.get());
+                        l_Connections.push_back(std::move(l_Connection));
+                    }
+                }
+
+                return l_Connections;
+            }
+            /// Drive our timer wheel, one io service timer for flush, ping and idle timers of every socket
+            void StartTimerWheelTimer()
+            {
+                m_TimerWheelTimer.expires_after(std::chrono::milliseconds(m_TimerWheel->GetTick()));
+                m_TimerWheelTimer.async_wait(MakeAllocHandler([this](boost::system::error_code const& p_ErrorCode)
+                {
+                    if (p_ErrorCode)
+                        return;
+
+                    m_TimerWheel->Update();
+
+                    /// Sample our load for socket placement
+                    const std::chrono::steady_clock::time_point l_Now = std::chrono::steady_clock::now();
+                    if (l_Now - m_LastLoadSample >= std::chrono::milliseconds(NETWORK_LOAD_SAMPLE_INTERVAL))
+                    {
+                        m_Load.Sample(std::chrono::duration<double>(l_Now - m_LastLoadSample).count());
+                        m_LastLoadSample = l_Now;
+                    }
+
+                    if (l_Now - m_LastMemorySample >= std::chrono::milliseconds(NETWORK_THREAD_MEMORY_SAMPLE_INTERVAL))
+                    {
+                        SampleMemory();
+                        m_LastMemorySample = l_Now;
+                    }
+
+                    StartTimerWheelTimer();
+                }));
+            }
+            /// Sum up memory held by our sockets, called from our own thread
+            void SampleMemory()
             {
+                std::vector<std::shared_ptr<T>> l_Sockets;
+                SocketMemoryUsage l_Usage = {};
+
+                {
+                    Utils::ObjectGuard l_Guard(this);
+
+                    l_Sockets.reserve(m_ActiveSlots.size());
+                    for (uint32 l_SlotIndex : m_ActiveSlots)
+                        l_Sockets.push_back(m_Slots[l_SlotIndex].Socket);
+
+                    l_Usage.Object = m_Slots.capacity() * sizeof(Slot) + m_Active.capacity() * sizeof(T*) + m_ActiveSlots.capacity() * sizeof(uint32);
+                }
+
+                /// Sockets take their own lock, which must not be taken while holding ours
+                for (std::shared_ptr<T> const& l_Socket : l_Sockets)
+                {
+                    const SocketMemoryUsage l_SocketUsage = l_Socket->GetMemoryUsage();
+                    l_Usage.Object      += l_SocketUsage.Object;
+                    l_Usage.InBuffer    += l_SocketUsage.InBuffer;
+                    l_Usage.OutQueue    += l_SocketUsage.OutQueue;
+                    l_Usage.Shared      += l_SocketUsage.Shared;
+                }
+
                 Utils::ObjectGuard l_Guard(this);
+                m_MemoryUsage = l_Usage;
+            }
+            /// Accept incoming connections on our own acceptor
+            /// @p_Acceptor : Acceptor to accept on
+            void BeginAccept(Acceptor* p_Acceptor)
+            {
+                if (!p_Acceptor->Socket.is_open())
+                    return;
 
-                m_Sockets.erase(p_Socket->Shared<T>());
+                std::shared_ptr<T> l_Socket = p_Acceptor->CreateSocket();
+                if (!l_Socket)
+                {
+                    LOG_ERROR("NetworkThread", "Failed to create socket, no longer accepting connections on port %0", p_Acceptor->Port);
+                    return;
+                }
+
+                p_Acceptor->Socket.async_accept(l_Socket->GetAsioSocket(),
+                    MakeAllocHandler([this, p_Acceptor, l_Socket](const boost::system::error_code& p_ErrorCode)
+                    {
+                        this->OnAccept(p_Acceptor, l_Socket, p_ErrorCode);
+                    }));
+            }
+            /// Check if handle points to an active socket, must be called while holding our lock
+            /// @p_Handle : Handle of socket
+            bool IsValidHandle(SocketHandle const& p_Handle) const
+            {
+                return p_Handle.IsValid() && p_Handle.GetIndex() < m_Slots.size()
+                    && m_Slots[p_Handle.GetIndex()].Generation == p_Handle.GetGeneration() && m_Slots[p_Handle.GetIndex()].Socket;
+            }
+            /// Accept new connection and open socket
+            /// @p_Acceptor  : Acceptor socket has been accepted on
+            /// @p_Socket    : Socket which has been accepted
+            /// @p_ErrorCode : Error code
+            void OnAccept(Acceptor* p_Acceptor, std::shared_ptr<T> const& p_Socket, const boost::system::error_code& p_ErrorCode)
+            {
+                if (p_ErrorCode)
+                {
+                    RemoveSocket(p_Socket.get());
+
+                    /// Acceptor has been closed, we are shutting down
+                    if (p_ErrorCode == boost::asio::error::operation_aborted)
+                        return;
+                }
+                else if (!AdmitSocket(p_Socket, p_Acceptor->Admission) || !p_Socket->Open())
+                    RemoveSocket(p_Socket.get());
+
+                /// Return back and accept any more incoming connections
+                BeginAccept(p_Acceptor);
             }
 
+        private:
+            /// Slot in our socket storage
+            struct Slot
+            {
+                Slot()
+                    : Generation(1), ActiveIndex(0), NextFree(InvalidSlot)
+                {
+                }
+
+                std::shared_ptr<T> Socket;                              ///< Socket, empty when slot is free
+                uint32 Generation;                                      ///< Generation, bumped when socket is removed
+                uint32 ActiveIndex;                                     ///< Index in active storage
+                uint32 NextFree;                                        ///< Next free slot
+            };
+
+            /// Acceptor bound with SO_REUSEPORT
+            struct Acceptor
+            {
+                /// Constructor
+                /// @p_Service : IO Service of our network thread
+                explicit Acceptor(boost::asio::io_service& p_Service)
+                    : Socket(p_Service), Port(0)
+                {
+                }
+
+                boost::asio::ip::tcp::acceptor Socket;                  ///< Acceptor
+                uint16 Port;                                            ///< Port we accept on
+                std::shared_ptr<AcceptAdmission> Admission;             ///< Admission control of accepted connections
+                std::function<std::shared_ptr<T>()> CreateSocket;       ///< Create socket of the type served on our port
+            };
+
+            static constexpr uint32 InvalidSlot = ~0u;
+
         private:
             boost::asio::io_service m_Service;                          ///< IO Service
             std::unique_ptr<boost::asio::io_service::work> m_Worker;    ///< Worker of IO Service
-            std::unordered_set<std::shared_ptr<T>> m_Sockets;           ///< Storage of socket classes
+            std::shared_ptr<TimerWheel> m_TimerWheel;                   ///< Flush, ping and idle timers of our sockets
+#ifdef STEERSTONE_IO_URING
+            std::unique_ptr<IoUring> m_Ring;                            ///< Socket reads and writes, nullptr if not supported by the kernel
+#endif
+            boost::asio::steady_timer m_TimerWheelTimer;                ///< Timer driving our timer wheel
+            NetworkThreadLoad m_Load;                                   ///< Measured load of our sockets
+            std::chrono::steady_clock::time_point m_LastLoadSample;     ///< Time of last load sample
+            std::chrono::steady_clock::time_point m_LastMemorySample;   ///< Time of last memory sample
+            SocketMemoryUsage m_MemoryUsage;                            ///< Memory held by our sockets at the last sample
+            std::vector<Slot> m_Slots;                                  ///< Storage of socket classes
+            std::vector<T*> m_Active;                                   ///< Active sockets, contiguous for iteration
+            std::vector<uint32> m_ActiveSlots;                          ///< Slot index of each active socket
+            uint32 m_FreeSlot;                                          ///< Head of free slot list
+            std::atomic<std::size_t> m_Size;                            ///< Amount of active sockets, read without our lock
+            std::vector<std::unique_ptr<Acceptor>> m_Acceptors;         ///< Acceptors, only used in SO_REUSEPORT mode
             Threading::Task::Ptr l_Task;                                ///< Worker task
+            int32 m_PlacementGroup;                                     ///< Placement group of worker task
     };
 
 }   ///< namespace Network
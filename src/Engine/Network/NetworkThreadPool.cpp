@@ -0,0 +1,213 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <limits>
+#include <thread>
+
+#include "NetworkThreadPool.hpp"
+#include "Metrics/MetRegistry.hpp"
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Constructor
+    /// @p_WorkerThreads : Amount of network threads to spawn, 0 spawns one per core
+    NetworkThreadPool::NetworkThreadPool(uint8 p_WorkerThreads)
+    {
+        std::size_t l_Count = p_WorkerThreads;
+
+        if (!l_Count)
+            l_Count = std::min<std::size_t>(std::max(std::thread::hardware_concurrency(), 1u), std::numeric_limits<uint8>::max());
+
+        for (std::size_t l_I = 0; l_I < l_Count; l_I++)
+            m_NetworkThreads.push_back(std::unique_ptr<PoolNetworkThread>(new PoolNetworkThread(static_cast<uint8>(l_I))));
+
+        LOG_INFO("NetworkThreadPool", "Started %0 network threads", m_NetworkThreads.size());
+
+        RegisterMetrics();
+    }
+    /// Deconstructor
+    NetworkThreadPool::~NetworkThreadPool()
+    {
+        for (const uint64 l_Callback : m_MetricsCallbacks)
+            sMetrics->RemoveCallback(l_Callback);
+
+        if (m_MigrationTask)
+            sThreadManager->PopTask(m_MigrationTask);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get amount of network threads
+    std::size_t NetworkThreadPool::GetThreadCount() const
+    {
+        return m_NetworkThreads.size();
+    }
+    /// Get network thread
+    /// @p_Index : Index of network thread
+    PoolNetworkThread* NetworkThreadPool::GetThread(std::size_t p_Index) const
+    {
+        return m_NetworkThreads[p_Index].get();
+    }
+    /// Get amount of sockets over all network threads
+    std::size_t NetworkThreadPool::GetSize() const
+    {
+        std::size_t l_Size = 0;
+
+        for (auto const& l_NetworkThread : m_NetworkThreads)
+            l_Size += l_NetworkThread->GetSize();
+
+        return l_Size;
+    }
+
+    /// Select the network thread with lowest measured load
+    PoolNetworkThread* NetworkThreadPool::SelectWorker() const
+    {
+        double l_MinimumScore = std::numeric_limits<double>::max();
+        std::size_t l_Index = 0;
+
+        for (std::size_t l_I = 0; l_I < m_NetworkThreads.size(); l_I++)
+        {
+            const double l_Score = m_NetworkThreads[l_I]->GetScore();
+
+            if (l_Score < l_MinimumScore)
+            {
+                l_MinimumScore = l_Score;
+                l_Index = l_I;
+            }
+        }
+
+        return m_NetworkThreads[l_Index].get();
+    }
+
+    /// Periodically move quiet sockets from the busiest network thread to the quietest one
+    /// @p_Interval  : Milliseconds between checks
+    /// @p_BatchSize : Maximum amount of sockets moved per check
+    void NetworkThreadPool::EnableMigration(uint32 p_Interval, uint32 p_BatchSize)
+    {
+        if (m_MigrationTask || m_NetworkThreads.size() < 2 || p_Interval == 0 || p_BatchSize == 0)
+            return;
+
+        m_MigrationTask = sThreadManager->PushTask("NETWORK_POOL_MIGRATION", Threading::TaskType::Moderate, p_Interval, [this, p_BatchSize]() -> bool
+        {
+            this->Rebalance(p_BatchSize);
+            return true;
+        });
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Move quiet sockets from the busiest network thread to the quietest one
+    /// @p_BatchSize : Maximum amount of sockets moved
+    void NetworkThreadPool::Rebalance(uint32 p_BatchSize)
+    {
+        std::size_t l_Busiest = 0;
+        std::size_t l_Quietest = 0;
+
+        for (std::size_t l_I = 1; l_I < m_NetworkThreads.size(); l_I++)
+        {
+            if (m_NetworkThreads[l_I]->GetScore() > m_NetworkThreads[l_Busiest]->GetScore())
+                l_Busiest = l_I;
+            if (m_NetworkThreads[l_I]->GetScore() < m_NetworkThreads[l_Quietest]->GetScore())
+                l_Quietest = l_I;
+        }
+
+        const double l_BusiestScore  = m_NetworkThreads[l_Busiest]->GetScore();
+        const double l_QuietestScore = m_NetworkThreads[l_Quietest]->GetScore();
+
+        if (l_BusiestScore - l_QuietestScore < NETWORK_POOL_MIGRATION_MIN_SCORE || l_BusiestScore < l_QuietestScore * NETWORK_POOL_MIGRATION_IMBALANCE)
+            return;
+
+        m_NetworkThreads[l_Busiest]->MigrateSockets(m_NetworkThreads[l_Quietest].get(), p_BatchSize);
+    }
+    /// Register sockets and load of every network thread into the metrics registry
+    void NetworkThreadPool::RegisterMetrics()
+    {
+        for (std::size_t l_I = 0; l_I < m_NetworkThreads.size(); l_I++)
+        {
+            PoolNetworkThread const* l_Thread = m_NetworkThreads[l_I].get();
+            const Metrics::MetricLabels l_Labels = { { "thread", std::to_string(l_I) } };
+
+            m_MetricsCallbacks.push_back(sMetrics->AddCallback("steerstone_network_thread_sockets", "Sockets served by network thread", Metrics::MetricType::Gauge, l_Labels,
+                [l_Thread]() { return static_cast<double>(l_Thread->GetSize()); }));
+            m_MetricsCallbacks.push_back(sMetrics->AddCallback("steerstone_network_thread_handlers_per_second", "Smoothed completed handlers per second of network thread", Metrics::MetricType::Gauge, l_Labels,
+                [l_Thread]() { return l_Thread->GetLoad().GetEventRate(); }));
+            m_MetricsCallbacks.push_back(sMetrics->AddCallback("steerstone_network_thread_bytes_per_second", "Smoothed bytes transferred per second by network thread", Metrics::MetricType::Gauge, l_Labels,
+                [l_Thread]() { return l_Thread->GetLoad().GetByteRate(); }));
+
+            /// Sampled by the network thread itself, see NETWORK_THREAD_MEMORY_SAMPLE_INTERVAL
+            static const std::pair<char const*, std::size_t SocketMemoryUsage::*> sl_Kinds[] =
+            {
+                { "object",     &SocketMemoryUsage::Object      },
+                { "in_buffer",  &SocketMemoryUsage::InBuffer    },
+                { "out_queue",  &SocketMemoryUsage::OutQueue    },
+                { "shared",     &SocketMemoryUsage::Shared      }
+            };
+
+            for (auto const& l_Kind : sl_Kinds)
+            {
+                const Metrics::MetricLabels l_KindLabels = { { "thread", std::to_string(l_I) }, { "kind", l_Kind.first } };
+                const std::size_t SocketMemoryUsage::* l_Field = l_Kind.second;
+
+                m_MetricsCallbacks.push_back(sMetrics->AddCallback("steerstone_network_socket_memory_bytes", "Memory held by sockets of network thread", Metrics::MetricType::Gauge, l_KindLabels,
+                    [l_Thread, l_Field]() { return static_cast<double>(l_Thread->GetMemoryUsage().*l_Field); }));
+            }
+        }
+
+        /// Shared chunks are left out, they are held once for all of their recipients
+        m_MetricsCallbacks.push_back(sMetrics->AddCallback("steerstone_network_bytes_per_socket", "Memory owned per connected socket over all network threads", Metrics::MetricType::Gauge, {},
+            [this]()
+            {
+                std::size_t l_Bytes = 0;
+                std::size_t l_Sockets = 0;
+
+                for (auto const& l_NetworkThread : m_NetworkThreads)
+                {
+                    const SocketMemoryUsage l_Usage = l_NetworkThread->GetMemoryUsage();
+                    l_Bytes   += l_Usage.Object + l_Usage.InBuffer + l_Usage.OutQueue;
+                    l_Sockets += l_NetworkThread->GetSize();
+                }
+
+                return l_Sockets ? static_cast<double>(l_Bytes) / static_cast<double>(l_Sockets) : 0.0;
+            }));
+
+        /// Backpressure statistics are shared by every socket, they are registered once and never removed
+        static const bool sl_Backpressure = []()
+        {
+            BackpressureStatistics const& l_Statistics = Socket::GetBackpressureStatistics();
+
+            sMetrics->AddCallback("steerstone_network_congested_total", "Times a socket crossed its out queue high water mark", Metrics::MetricType::Counter, {},
+                [&l_Statistics]() { return static_cast<double>(l_Statistics.Congested.load(std::memory_order_relaxed)); });
+            sMetrics->AddCallback("steerstone_network_dropped_writes_total", "Non essential writes dropped while congested", Metrics::MetricType::Counter, {},
+                [&l_Statistics]() { return static_cast<double>(l_Statistics.DroppedWrites.load(std::memory_order_relaxed)); });
+            sMetrics->AddCallback("steerstone_network_dropped_bytes_total", "Non essential bytes dropped while congested", Metrics::MetricType::Counter, {},
+                [&l_Statistics]() { return static_cast<double>(l_Statistics.DroppedBytes.load(std::memory_order_relaxed)); });
+            sMetrics->AddCallback("steerstone_network_evicted_total", "Sockets closed for staying above their out queue hard limit", Metrics::MetricType::Counter, {},
+                [&l_Statistics]() { return static_cast<double>(l_Statistics.Evicted.load(std::memory_order_relaxed)); });
+
+            return true;
+        }();
+
+        (void)sl_Backpressure;
+    }
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
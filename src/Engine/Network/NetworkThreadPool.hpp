@@ -0,0 +1,82 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+#include "Threading/ThrTaskManager.hpp"
+#include "NetworkThread.hpp"
+
+#define NETWORK_POOL_MIGRATION_IMBALANCE    1.5         ///< Busiest network thread must have this much more load than the quietest one
+#define NETWORK_POOL_MIGRATION_MIN_SCORE    100.0       ///< Minimum load difference before sockets are migrated, in handlers per second
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Network thread holding sockets of any type
+    typedef NetworkThread<Socket> PoolNetworkThread;
+
+    /// Network threads shared by every listener, so the amount of threads follows the amount of cores
+    /// instead of the amount of ports we listen on
+    class NetworkThreadPool
+    {
+        DISALLOW_COPY_AND_ASSIGN(NetworkThreadPool);
+
+        public:
+            /// Constructor
+            /// @p_WorkerThreads : Amount of network threads to spawn, 0 spawns one per core
+            explicit NetworkThreadPool(uint8 p_WorkerThreads);
+            /// Deconstructor
+            ~NetworkThreadPool();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Get amount of network threads
+            std::size_t GetThreadCount() const;
+            /// Get network thread
+            /// @p_Index : Index of network thread
+            PoolNetworkThread* GetThread(std::size_t p_Index) const;
+            /// Get amount of sockets over all network threads
+            std::size_t GetSize() const;
+
+            /// Select the network thread with lowest measured load
+            PoolNetworkThread* SelectWorker() const;
+
+            /// Periodically move quiet sockets from the busiest network thread to the quietest one
+            /// @p_Interval  : Milliseconds between checks
+            /// @p_BatchSize : Maximum amount of sockets moved per check
+            void EnableMigration(uint32 p_Interval, uint32 p_BatchSize);
+
+        private:
+            /// Move quiet sockets from the busiest network thread to the quietest one
+            /// @p_BatchSize : Maximum amount of sockets moved
+            void Rebalance(uint32 p_BatchSize);
+            /// Register sockets and load of every network thread into the metrics registry
+            void RegisterMetrics();
+
+        private:
+            std::vector<std::unique_ptr<PoolNetworkThread>> m_NetworkThreads;      ///< Worker threads
+            Threading::Task::Ptr m_MigrationTask;                                   ///< Socket migration Task
+            std::vector<uint64> m_MetricsCallbacks;                                 ///< Ids of our metrics series
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
@@ -17,17 +17,24 @@
 */
 
 #include <cassert>
+#include <cstring>
 
 #include "PacketBuffer.hpp"
 
 namespace SteerStone { namespace Core { namespace Network {
 
     /// Constructor
-    /// @p_InitializeSize : Reserve size for our m_Storage
-    PacketBuffer::PacketBuffer(uint32 p_InitializeSize) 
-        : m_WritePosition(0), m_ReadPosition(0), m_Buffer(p_InitializeSize, 0)
+    /// @p_InitializeSize : Size of our m_Storage once it is needed, nothing is allocated yet
+    /// @p_Mode           : Storage mode, ring mode never resizes m_Storage
+    PacketBuffer::PacketBuffer(uint32 p_InitializeSize, PacketBufferMode p_Mode) 
+        : m_WritePosition(0), m_ReadPosition(0), m_Buffer(nullptr), m_Capacity(0), m_InitialSize(p_InitializeSize), m_Tier(0), m_Mode(p_Mode)
     {
     }
+    /// Deconstructor
+    PacketBuffer::~PacketBuffer()
+    {
+        BufferPool::Release(m_Buffer, m_Tier);
+    }
 
     //////////////////////////////////////////////////////////////////////////
     //////////////////////////////////////////////////////////////////////////
@@ -43,20 +50,28 @@ namespace SteerStone { namespace Core { namespace Network {
             memcpy(p_Buffer, &m_Buffer[m_ReadPosition], p_Length);
 
         m_ReadPosition += p_Length;
+
+        /// Everything has been read, we can start at the beginning again without moving any data
+        if (m_Mode == PacketBufferMode::Ring && m_ReadPosition == m_WritePosition)
+            Reset();
     }
     /// Write the data to be sent
     /// @p_Buffer : Buffer which holds the data
     /// @p_Length : The length of the data
-    void PacketBuffer::Write(char const* p_Buffer, std::size_t const& p_Length)
+    /// Returns false if ring storage has not enough free space, nothing is written
+    bool PacketBuffer::Write(char const* p_Buffer, std::size_t const& p_Length)
     {
-        const size_t l_NewLength = m_WritePosition + p_Length;
+        if (p_Length == 0)
+            return true;
 
-        if (m_Buffer.size() < l_NewLength)
-            m_Buffer.resize(l_NewLength);
+        uint8* l_Output = Reserve(p_Length);
+        if (!l_Output)
+            return false;
 
-        memcpy(&m_Buffer[m_WritePosition], p_Buffer, p_Length);
+        memcpy(l_Output, p_Buffer, p_Length);
 
         m_WritePosition += p_Length;
+        return true;
     }
 
     /// Get the total read length of the packet
@@ -70,11 +85,159 @@ namespace SteerStone { namespace Core { namespace Network {
         return m_Buffer[m_ReadPosition];
     }
     /// Get the total read length of the packet
-    std::size_t const PacketBuffer::ReadLengthRemaining()
+    std::size_t PacketBuffer::ReadLengthRemaining() const
     {
         return m_WritePosition - m_ReadPosition;
     }
 
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get a view of all unread data
+    PacketView PacketBuffer::Peek() const
+    {
+        if (!m_Buffer)
+            return PacketView();
+
+        return PacketView(m_Buffer + m_ReadPosition, m_WritePosition - m_ReadPosition);
+    }
+    /// Get a view of unread data
+    /// @p_Length : Length of the view, returns empty view if not enough data has been recieved
+    PacketView PacketBuffer::Peek(std::size_t p_Length) const
+    {
+        if (m_WritePosition - m_ReadPosition < p_Length)
+            return PacketView();
+
+        return PacketView(m_Buffer + m_ReadPosition, p_Length);
+    }
+
+    /// Get pointer to the free space at the end of storage
+    uint8* PacketBuffer::GetWritePointer()
+    {
+        AcquireStorage();
+
+        return m_Buffer + m_WritePosition;
+    }
+    /// Get contiguous free space at the end of storage
+    std::size_t PacketBuffer::GetWriteSpace() const
+    {
+        /// Storage is acquired by GetWritePointer, it is at least our initial size
+        if (!m_Buffer)
+            return m_InitialSize;
+
+        return m_Capacity - m_WritePosition;
+    }
+    /// Make sure enough contiguous free space follows our write position, linear storage grows
+    /// @p_Length : Amount of bytes about to be written
+    /// Returns pointer to the free space, nullptr if ring storage has not enough free space
+    uint8* PacketBuffer::Reserve(std::size_t p_Length)
+    {
+        AcquireStorage();
+
+        if (m_Mode == PacketBufferMode::Ring)
+        {
+            if (GetWriteSpace() < p_Length)
+                Normalize();
+
+            /// Ring storage never grows, the caller decides what to do with data that does not fit
+            if (GetWriteSpace() < p_Length)
+                return nullptr;
+        }
+        else if (m_Capacity - m_WritePosition < p_Length)
+            GrowStorage(m_WritePosition + p_Length);
+
+        return m_Buffer + m_WritePosition;
+    }
+    /// Mark data as written after writing directly into GetWritePointer
+    /// @p_Length : Length of data written
+    void PacketBuffer::WriteCompleted(std::size_t p_Length)
+    {
+        assert(GetWriteSpace() >= p_Length);
+
+        m_WritePosition += p_Length;
+    }
+
+    /// Move unread data to the start of storage so free space is contiguous
+    /// Only the unread bytes (usually a partial frame) are moved
+    void PacketBuffer::Normalize()
+    {
+        if (m_ReadPosition == 0)
+            return;
+
+        const std::size_t l_Remaining = m_WritePosition - m_ReadPosition;
+
+        if (l_Remaining > 0)
+            memmove(m_Buffer, m_Buffer + m_ReadPosition, l_Remaining);
+
+        m_ReadPosition  = 0;
+        m_WritePosition = l_Remaining;
+    }
+    /// Discard all data
+    void PacketBuffer::Reset()
+    {
+        m_ReadPosition  = 0;
+        m_WritePosition = 0;
+    }
+
+    /// Return storage to the pool if there is no unread data, storage is acquired again on next write
+    /// Returns false if unread data is kept
+    bool PacketBuffer::Release()
+    {
+        if (m_ReadPosition != m_WritePosition)
+            return false;
+
+        BufferPool::Release(m_Buffer, m_Tier);
+
+        m_Buffer    = nullptr;
+        m_Capacity  = 0;
+
+        Reset();
+        return true;
+    }
+    /// Check if storage has been acquired from the pool
+    bool PacketBuffer::HasStorage() const
+    {
+        return m_Buffer != nullptr;
+    }
+
+    /// Get storage mode
+    PacketBufferMode PacketBuffer::GetMode() const
+    {
+        return m_Mode;
+    }
+    /// Get storage capacity
+    std::size_t PacketBuffer::GetCapacity() const
+    {
+        return m_Buffer ? m_Capacity : m_InitialSize;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Acquire storage from pool if we have none
+    void PacketBuffer::AcquireStorage()
+    {
+        if (!m_Buffer)
+            m_Buffer = BufferPool::Acquire(m_InitialSize, m_Capacity, m_Tier);
+    }
+    /// Grow linear storage to hold at least p_Size bytes
+    /// @p_Size : Required size
+    void PacketBuffer::GrowStorage(std::size_t p_Size)
+    {
+        std::size_t l_Capacity = 0;
+        uint8 l_Tier = 0;
+        uint8* l_Buffer = BufferPool::Acquire(std::max(p_Size, m_Capacity * 2), l_Capacity, l_Tier);
+
+        if (m_WritePosition > 0)
+            memcpy(l_Buffer, m_Buffer, m_WritePosition);
+
+        BufferPool::Release(m_Buffer, m_Tier);
+
+        m_Buffer    = l_Buffer;
+        m_Capacity  = l_Capacity;
+        m_Tier      = l_Tier;
+    }
+
 }   ///< namespace Network
 }   ///< namespace Core
 }   ///< namespace Steerstone
\ No newline at end of file
@@ -20,12 +20,22 @@
 #include <PCH/Precompiled.hpp>
 #include <boost/asio.hpp>
 #include "Core/Core.hpp"
+#include "PacketView.hpp"
+#include "BufferPool.hpp"
 
 #define STORAGE_INITIAL_SIZE 4096
 
 namespace SteerStone { namespace Core { namespace Network {
 
+    /// Storage modes of PacketBuffer
+    enum class PacketBufferMode
+    {
+        Linear,                     ///< Storage grows on write, positions are reset by owner
+        Ring                        ///< Fixed capacity, unread data is kept between reads
+    };
+
     /// Buffer class to send/recieve packets
+    /// Storage is taken from BufferPool on first use and returned on destruction or Release
     class PacketBuffer
     {
         DISALLOW_COPY_AND_ASSIGN(PacketBuffer);
@@ -38,8 +48,11 @@ namespace SteerStone { namespace Core { namespace Network {
 
         public:
             /// Constructor
-            /// @p_InitializeSize : Reserve size for our m_Storage
-            explicit PacketBuffer(uint32 p_InitializeSize = STORAGE_INITIAL_SIZE);
+            /// @p_InitializeSize : Size of our m_Storage once it is needed, nothing is allocated yet
+            /// @p_Mode           : Storage mode, ring mode never resizes m_Storage
+            explicit PacketBuffer(uint32 p_InitializeSize = STORAGE_INITIAL_SIZE, PacketBufferMode p_Mode = PacketBufferMode::Linear);
+            /// Deconstructor
+            ~PacketBuffer();
 
             //////////////////////////////////////////////////////////////////////////
             //////////////////////////////////////////////////////////////////////////
@@ -51,20 +64,69 @@ namespace SteerStone { namespace Core { namespace Network {
             /// Write the data to be sent
             /// @p_Buffer : Buffer which holds the data
             /// @p_Length : The length of the data
-            void Write(char const* p_Buffer, std::size_t const& p_Length);
+            /// Returns false if ring storage has not enough free space, nothing is written
+            bool Write(char const* p_Buffer, std::size_t const& p_Length);
 
             /// Get the total read length of the packet
             std::size_t const ReadLength();
             /// Get the total read length of the packet
-            std::size_t const ReadLengthRemaining();
+            std::size_t ReadLengthRemaining() const;
             /// Get the current read position
             std::size_t const ReadPosition();
 
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Get a view of all unread data
+            PacketView Peek() const;
+            /// Get a view of unread data
+            /// @p_Length : Length of the view, returns empty view if not enough data has been recieved
+            PacketView Peek(std::size_t p_Length) const;
+
+            /// Get pointer to the free space at the end of storage
+            uint8* GetWritePointer();
+            /// Get contiguous free space at the end of storage
+            std::size_t GetWriteSpace() const;
+            /// Make sure enough contiguous free space follows our write position, linear storage grows
+            /// @p_Length : Amount of bytes about to be written
+            /// Returns pointer to the free space, nullptr if ring storage has not enough free space
+            uint8* Reserve(std::size_t p_Length);
+            /// Mark data as written after writing directly into GetWritePointer
+            /// @p_Length : Length of data written
+            void WriteCompleted(std::size_t p_Length);
+
+            /// Move unread data to the start of storage so free space is contiguous
+            /// Only the unread bytes (usually a partial frame) are moved
+            void Normalize();
+            /// Discard all data
+            void Reset();
+            /// Return storage to the pool if there is no unread data, storage is acquired again on next write
+            /// Returns false if unread data is kept
+            bool Release();
+            /// Check if storage has been acquired from the pool
+            bool HasStorage() const;
+
+            /// Get storage mode
+            PacketBufferMode GetMode() const;
+            /// Get storage capacity
+            std::size_t GetCapacity() const;
+
+        private:
+            /// Acquire storage from pool if we have none
+            void AcquireStorage();
+            /// Grow linear storage to hold at least p_Size bytes
+            /// @p_Size : Required size
+            void GrowStorage(std::size_t p_Size);
+
         private:
             /// Storage
             std::size_t m_WritePosition;  ///< Write position in our storage
             std::size_t m_ReadPosition;   ///< Read position in our storage
-            std::vector<uint8> m_Buffer;  ///< Vector Storage
+            uint8* m_Buffer;              ///< Pooled storage, nullptr until first use
+            std::size_t m_Capacity;       ///< Size of pooled storage
+            uint32 m_InitialSize;         ///< Size to acquire on first use
+            uint8 m_Tier;                 ///< Pool tier of storage
+            PacketBufferMode m_Mode;      ///< Storage mode
     };
 
 }   ///< namespace Network
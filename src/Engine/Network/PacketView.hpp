@@ -0,0 +1,95 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <cassert>
+
+#include "Core/Core.hpp"
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Non owning view over bytes held by a PacketBuffer
+    /// The view is only valid until the owning buffer is read, written or normalized
+    class PacketView
+    {
+        public:
+            /// Constructor
+            PacketView()
+                : m_Data(nullptr), m_Length(0)
+            {
+            }
+            /// Constructor
+            /// @p_Data   : Start of the viewed data
+            /// @p_Length : Length of the viewed data
+            PacketView(uint8 const* p_Data, std::size_t p_Length)
+                : m_Data(p_Data), m_Length(p_Length)
+            {
+            }
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Get start of the viewed data
+            uint8 const* GetData() const
+            {
+                return m_Data;
+            }
+            /// Get length of the viewed data
+            std::size_t GetLength() const
+            {
+                return m_Length;
+            }
+            /// Check if view has no data
+            bool IsEmpty() const
+            {
+                return m_Length == 0;
+            }
+
+            /// Get a part of the view
+            /// @p_Offset : Offset from start of the view
+            /// @p_Length : Length of the sub view
+            PacketView SubView(std::size_t p_Offset, std::size_t p_Length) const
+            {
+                assert(p_Offset + p_Length <= m_Length);
+
+                return PacketView(m_Data + p_Offset, p_Length);
+            }
+            /// Get the view as a string view, used for text based protocols
+            std::string_view ToStringView() const
+            {
+                return std::string_view(reinterpret_cast<char const*>(m_Data), m_Length);
+            }
+
+            /// Access byte at position
+            /// @p_Index : Position of byte
+            uint8 operator[](std::size_t p_Index) const
+            {
+                assert(p_Index < m_Length);
+
+                return m_Data[p_Index];
+            }
+
+        private:
+            uint8 const* m_Data;        ///< Start of viewed data
+            std::size_t m_Length;       ///< Length of viewed data
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
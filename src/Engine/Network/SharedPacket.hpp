@@ -0,0 +1,77 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+#include "PacketBuffer.hpp"
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Refcounted immutable packet, serialized once and queued as is into the out queue of every recipient
+    class SharedPacket
+    {
+        public:
+            /// Create packet by copying data once
+            /// @p_Buffer : Buffer which holds the data
+            /// @p_Length : The length of the data
+            static SharedPacket Create(char const* p_Buffer, std::size_t const& p_Length)
+            {
+                std::shared_ptr<PacketBuffer> l_Buffer = std::make_shared<PacketBuffer>(static_cast<uint32>(p_Length));
+                l_Buffer->Write(p_Buffer, p_Length);
+
+                return SharedPacket(std::move(l_Buffer));
+            }
+
+        public:
+            /// Constructor
+            SharedPacket() = default;
+            /// Constructor
+            /// @p_Buffer : Buffer to share, must not be modified afterwards
+            explicit SharedPacket(std::shared_ptr<PacketBuffer const> p_Buffer)
+                : m_Buffer(std::move(p_Buffer))
+            {
+            }
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Get shared buffer
+            std::shared_ptr<PacketBuffer const> const& GetBuffer() const
+            {
+                return m_Buffer;
+            }
+            /// Get view of packet data
+            PacketView GetView() const
+            {
+                return m_Buffer ? m_Buffer->Peek() : PacketView();
+            }
+            /// Check if packet holds any data
+            bool IsEmpty() const
+            {
+                return GetView().IsEmpty();
+            }
+
+        private:
+            std::shared_ptr<PacketBuffer const> m_Buffer;      ///< Shared buffer
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
@@ -17,20 +17,87 @@
 * along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-#include <boost/lexical_cast.hpp>
 
 #include "Socket.hpp"
 #include "Utility/UtiObjectGuard.hpp"
+#include "Diagnostic/DiaProfiler.hpp"
+#include "Diagnostic/DiaFlightRecorder.hpp"
+#include "Metrics/MetRegistry.hpp"
 
 namespace SteerStone { namespace Core { namespace Network {
 
+    BackpressureStatistics Socket::s_BackpressureStatistics;
+
     /// Constructor
     /// @p_Service : Socket to pass
-    /// @p_CloseHandler : Custom Handler to handle our function
-    Socket::Socket(boost::asio::io_service& p_Service, std::function<void(Socket*)> p_CloseHandler)
-        : m_WriteState(WriteState::Idle), m_ReadState(ReadState::Idle), m_Socket(p_Service),
-        m_CloseHandler(std::move(p_CloseHandler)), m_OutBufferFlushTimer(p_Service), m_Address("0.0.0.0") 
+    /// @p_Owner : Owner told once we are closed, nullptr if none
+    Socket::Socket(boost::asio::io_service& p_Service, SocketOwner* p_Owner)
+        : m_Socket(p_Service), m_Owner(p_Owner), m_Cold(new ColdState()), m_InBuffer(STORAGE_INITIAL_SIZE, PacketBufferMode::Ring),
+        m_OutChunkOffset(0), m_OutChunksSending(0), m_OutQueueSize(0), m_OutChunksEncrypted(0),
+        m_IdleTimeout(0), m_LoadEvents(0), m_Load(nullptr), m_WriteState(WriteState::Idle), m_ReadState(ReadState::Idle), m_Congested(false)
+    {
+        m_FlushPolicy.Policy        = FlushPolicy::TimeBounded;
+        m_FlushPolicy.ByteThreshold = 0;
+        m_FlushPolicy.Timeout       = m_BufferTimeout;
+
+        m_Backpressure.LowWaterMark     = 0;
+        m_Backpressure.HighWaterMark    = 0;
+        m_Backpressure.HardLimit        = 0;
+        m_Backpressure.HardLimitTimeout = 0;
+
+        /// Timers fire on our network thread, they keep a strong reference to us while running
+        m_FlushTimer.SetCallback([this]() { FlushOut(); });
+        m_Cold->PingTimer.SetCallback([this]()
+        {
+            if (IsClosed())
+                return;
+
+            OnPingTimer();
+            ScheduleTimer(m_Cold->PingTimer, m_Cold->PingInterval);
+        });
+#ifdef STEERSTONE_IO_URING
+        m_Ring = nullptr;
+        m_RingReceive.Handler   = [this](int32 p_Result, uint32 p_Flags) { OnRingReceive(p_Result, p_Flags); };
+        m_RingSend.Handler      = [this](int32 p_Result, uint32 p_Flags) { OnRingSend(p_Result, p_Flags); };
+#endif
+        m_Cold->BufferReleaseTimer.SetCallback([this]()
+        {
+            /// Keeps a partially recieved frame, storage is acquired again once the client sends something
+            m_InBuffer.Release();
+
+            /// Blocks of an empty out queue are allocated again on the next write
+            Utils::ObjectGuard l_Guard(this);
+
+            if (m_OutQueue.empty() && m_WriteState == WriteState::Idle)
+                m_OutQueue = OutQueue();
+        });
+        m_IdleTimer.SetCallback([this]()
+        {
+            if (!IsClosed())
+                OnIdleTimeout();
+        });
+        /// A stalled consumer is not written to anymore, it has to be closed without waiting for our next write
+        m_Cold->HardLimitTimer.SetCallback([this]()
+        {
+            {
+                Utils::ObjectGuard l_Guard(this);
+
+                if (IsClosed() || m_Cold->HardLimitSince == std::chrono::steady_clock::time_point())
+                    return;
+            }
+
+            LOG_WARNING("Socket", "%0 stayed above %1 queued bytes for %2 ms, closing slow consumer", GetRemoteEndpoint(), m_Backpressure.HardLimit, m_Backpressure.HardLimitTimeout);
+            s_BackpressureStatistics.Evicted.fetch_add(1, std::memory_order_relaxed);
+
+            CloseSocket();
+        });
+    }
+
+    /// Deconstructor
+    Socket::~Socket()
     {
+        /// Sockets which failed to open are never closed
+        ReleaseAdmission();
     }
 
     //////////////////////////////////////////////////////////////////////////
@@ -41,18 +108,32 @@ namespace SteerStone { namespace Core { namespace Network {
     {
         try
         {
-            const_cast<std::string&>(m_Address)         = m_Socket.remote_endpoint().address().to_string();
-            const_cast<std::string&>(m_RemoteEndPoint)  = boost::lexical_cast<std::string>(m_Socket.remote_endpoint());
+            m_Cold->RemoteEndPoint = m_Socket.remote_endpoint();
         }
-        catch (boost::system::error_code&)
+        catch (boost::system::system_error const&)
         {
             LOG_ERROR("Socket", "Failed to initialize socket address");
             return false;
         }
 
-        m_OutBuffer.reset(new PacketBuffer);
-        m_SecondaryOutBuffer.reset(new PacketBuffer);
-        m_InBuffer.reset(new PacketBuffer);
+        /// Storage is acquired once the client sends something
+        m_InBuffer.Reset();
+
+        /// We read into our in buffer ourself once the socket is readable
+        boost::system::error_code l_ErrorCode;
+        m_Socket.non_blocking(true, l_ErrorCode);
+        if (l_ErrorCode)
+        {
+            LOG_ERROR("Socket", "Failed to set socket %0 non blocking", GetRemoteEndpoint());
+            return false;
+        }
+
+        if (m_Cold->PingInterval)
+            ScheduleTimer(m_Cold->PingTimer, m_Cold->PingInterval);
+        if (m_IdleTimeout)
+            ScheduleTimer(m_IdleTimer, m_IdleTimeout);
+
+        Diagnostic::FlightRecorder::Record(Diagnostic::FlightEvent::SocketOpen, "Socket::Open", reinterpret_cast<uintptr_t>(this));
 
         StartAsyncRead();
 
@@ -68,10 +149,21 @@ namespace SteerStone { namespace Core { namespace Network {
 
         boost::system::error_code l_ErrorCode;
         m_Socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, l_ErrorCode);
+
+#ifdef STEERSTONE_IO_URING
+        /// The ring holds its own reference to our descriptor, closing it does not stop a multishot receive
+        if (m_Ring && m_RingReceive.Pending)
+            m_Ring->Cancel(&m_RingReceive);
+#endif
+
         m_Socket.close();
 
-        if (m_CloseHandler)
-            m_CloseHandler(this);
+        Diagnostic::FlightRecorder::Record(Diagnostic::FlightEvent::SocketClose, "Socket::CloseSocket", reinterpret_cast<uintptr_t>(this));
+
+        ReleaseAdmission();
+
+        if (m_Owner)
+            m_Owner->RemoveSocket(this);
     }
     /// Close our socket to stop recieving incoming packets
     bool Socket::IsClosed() const
@@ -95,7 +187,7 @@ namespace SteerStone { namespace Core { namespace Network {
         if (ReadLengthRemaining() < p_Length)
             return false;
 
-        m_InBuffer->Read(p_Buffer, p_Length);
+        m_InBuffer.Read(p_Buffer, p_Length);
 
         return true;
     }
@@ -103,37 +195,129 @@ namespace SteerStone { namespace Core { namespace Network {
     /// @p_Length : The length of the data to skip
     void Socket::ReadSkip(std::size_t const& p_Length)
     {
-        m_InBuffer->Read(nullptr, p_Length);
+        m_InBuffer.Read(nullptr, p_Length);
     }
     /// Write the data to be sent
-    /// @p_Buffer : Buffer which holds the data
-    /// @p_Length : The length of the data
-    void Socket::Write(const char* p_Buffer, std::size_t const& p_Length)
+    /// @p_Buffer   : Buffer which holds the data
+    /// @p_Length   : The length of the data
+    /// @p_Priority : Non essential data is dropped while congested
+    /// Returns false if data has been dropped
+    bool Socket::Write(const char* p_Buffer, std::size_t const& p_Length, WritePriority p_Priority)
     {
-        Utils::ObjectGuard l_Guard(this);
+        bool l_Evict = false;
 
-        /// Get the correct buffer depending on the current writing state
-        /// We do this because we don't want to be writing in our buffer while we are sending it out
-        /// it will cause corrupt data
-        /// BOOST_ASIO_ENABLE_BUFFER_DEBUGGING tells us about it
-        PacketBuffer* l_OutBuffer = m_WriteState == WriteState::Sending ? m_SecondaryOutBuffer.get() : m_OutBuffer.get();
+        {
+            Utils::ObjectGuard l_Guard(this);
+
+            if (IsClosed())
+                return false;
 
-        /// Write the header
-        m_OutBuffer->Write(p_Buffer, p_Length);
+            if (ShouldDrop(p_Priority, p_Length))
+                return false;
 
-        /// Flush data if need
-        if (m_WriteState == WriteState::Idle)
-            StartWriteFlushTimer();
+            /// Append to the last chunk if we own it, it fits and it is not being sent right now,
+            /// chunks which are being sent must not be touched until the write has completed
+            if (m_OutQueue.size() > m_OutChunksSending && m_OutQueue.back().Writable && m_OutQueue.back().Writable->GetWriteSpace() >= p_Length)
+                m_OutQueue.back().Writable->Write(p_Buffer, p_Length);
+            else
+            {
+                std::shared_ptr<PacketBuffer> l_Chunk = std::make_shared<PacketBuffer>(static_cast<uint32>(std::max<std::size_t>(p_Length, STORAGE_INITIAL_SIZE)));
+                l_Chunk->Write(p_Buffer, p_Length);
+
+                m_OutQueue.push_back({ l_Chunk, l_Chunk.get() });
+            }
+
+            m_OutQueueSize += p_Length;
+            l_Evict = UpdateBackpressure();
+
+            /// Flush data if need
+            StartWriteFlush();
+        }
+
+        if (l_Evict)
+            CloseSocket();
+
+        return !l_Evict;
+    }
+    /// Queue a chunk to be sent, the chunk is not copied and may be shared between sockets
+    /// @p_Chunk    : Chunk which holds the data, must not be modified after being queued
+    /// @p_Priority : Non essential data is dropped while congested
+    /// Returns false if data has been dropped
+    bool Socket::Write(std::shared_ptr<PacketBuffer const> const& p_Chunk, WritePriority p_Priority)
+    {
+        if (!p_Chunk || p_Chunk->Peek().IsEmpty())
+            return true;
+
+        bool l_Evict = false;
+
+        {
+            Utils::ObjectGuard l_Guard(this);
+
+            if (IsClosed())
+                return false;
+
+            if (ShouldDrop(p_Priority, p_Chunk->Peek().GetLength()))
+                return false;
+
+            m_OutQueue.push_back({ p_Chunk, nullptr });
+
+            m_OutQueueSize += p_Chunk->Peek().GetLength();
+            l_Evict = UpdateBackpressure();
+
+            /// Flush data if need
+            StartWriteFlush();
+        }
+
+        if (l_Evict)
+            CloseSocket();
+
+        return !l_Evict;
+    }
+    /// Queue a shared packet to be sent, the packet is not copied
+    /// @p_Packet   : Packet serialized once for every recipient
+    /// @p_Priority : Non essential data is dropped while congested
+    /// Returns false if data has been dropped
+    bool Socket::Write(SharedPacket const& p_Packet, WritePriority p_Priority)
+    {
+        return Write(p_Packet.GetBuffer(), p_Priority);
     }
     /// Get the total read length of the packet
     std::size_t const Socket::ReadLength()
     {
-        return m_InBuffer->ReadLength();
+        return m_InBuffer.ReadLength();
     }
     /// Get the length remaining to read
     std::size_t const Socket::ReadLengthRemaining()
     {
-        return m_InBuffer->ReadLengthRemaining();
+        return m_InBuffer.ReadLengthRemaining();
+    }
+
+    /// Get flush policy of our out queue
+    FlushPolicySettings const& Socket::GetFlushPolicy() const
+    {
+        return m_FlushPolicy;
+    }
+
+    /// Get our handle in storage of our current network thread, see SocketHandle
+    SocketHandle Socket::GetHandle() const
+    {
+        return m_Handle;
+    }
+
+    /// Check if our out queue is above its high water mark, game layer should skip non essential updates
+    bool Socket::IsCongested() const
+    {
+        return m_Congested.load(std::memory_order_relaxed);
+    }
+    /// Get amount of bytes waiting in our out queue
+    std::size_t Socket::GetOutQueueSize() const
+    {
+        return m_OutQueueSize;
+    }
+    /// Get backpressure statistics of all sockets
+    BackpressureStatistics const& Socket::GetBackpressureStatistics()
+    {
+        return s_BackpressureStatistics;
     }
 
     /// Get our AsioSocket
@@ -141,15 +325,43 @@ namespace SteerStone { namespace Core { namespace Network {
     {
         return m_Socket;
     }
-    /// Get our EndPoint
-    std::string const& Socket::GetRemoteEndpoint()
+    /// Get our EndPoint, formatted on every call
+    std::string Socket::GetRemoteEndpoint() const
     {
-        return m_RemoteEndPoint;
+        const boost::asio::ip::address l_Address = m_Cold->RemoteEndPoint.address();
+        const std::string l_Port = std::to_string(m_Cold->RemoteEndPoint.port());
+
+        return l_Address.is_v6() ? "[" + l_Address.to_string() + "]:" + l_Port : l_Address.to_string() + ":" + l_Port;
     }
-    /// Get our Remote Address
-    std::string const& Socket::GetRemoteAddress()
+    /// Get our Remote Address, formatted on every call
+    std::string Socket::GetRemoteAddress() const
     {
-        return m_Address;
+        return m_Cold->RemoteEndPoint.address().to_string();
+    }
+    /// Get memory we hold, must be called from our network thread
+    SocketMemoryUsage Socket::GetMemoryUsage() const
+    {
+        SocketMemoryUsage l_Usage;
+        l_Usage.Object   = m_Cold->ObjectSize + sizeof(ColdState) + (m_Cipher ? sizeof(SocketCipher) : 0);
+        l_Usage.InBuffer = m_InBuffer.HasStorage() ? m_InBuffer.GetCapacity() : 0;
+        l_Usage.OutQueue = 0;
+        l_Usage.Shared   = 0;
+
+        Utils::ObjectGuard l_Guard(const_cast<Socket*>(this));
+
+        /// A block holds MAX_OUT_BUFFER_SEQUENCE chunks, an empty queue keeps its last block until it is released along with our in buffer storage
+        if (!m_OutQueue.empty() || l_Usage.InBuffer)
+            l_Usage.OutQueue += ((m_OutQueue.size() / MAX_OUT_BUFFER_SEQUENCE) + 1) * MAX_OUT_BUFFER_SEQUENCE * sizeof(OutChunk);
+
+        for (OutChunk const& l_Chunk : m_OutQueue)
+        {
+            if (l_Chunk.Buffer.use_count() == 1)
+                l_Usage.OutQueue += sizeof(PacketBuffer) + l_Chunk.Buffer->GetCapacity();
+            else
+                l_Usage.Shared += l_Chunk.Buffer->Peek().GetLength();
+        }
+
+        return l_Usage;
     }
 
     //////////////////////////////////////////////////////////////////////////
@@ -158,21 +370,95 @@ namespace SteerStone { namespace Core { namespace Network {
     /// Get the current read position
     uint8 const* Socket::InPeak()
     {
-        return &m_InBuffer->m_Buffer[m_InBuffer->m_ReadPosition];
+        return m_InBuffer.Peek().GetData();
+    }
+    /// Get a view of all unread incoming data, no data is copied
+    PacketView Socket::InView() const
+    {
+        return m_InBuffer.Peek();
+    }
+    /// Get a view of unread incoming data, no data is copied
+    /// @p_Length : Length of the view, returns empty view if the frame is not fully recieved yet
+    PacketView Socket::InView(std::size_t p_Length) const
+    {
+        return m_InBuffer.Peek(p_Length);
     }
     /// ForceFlushOut - Send our current data in our buffer
     /// If the write state is idle, this will do nothing, which is correct
     /// If the write state is sending, this will do nothing, which is correct
-    /// If the write state is buffering, this will cancel the running timer, which will immediately trigger FlushOut()
+    /// If the write state is buffering, this will cancel the running timer and trigger FlushOut() immediately
+    /// Policies which do not use the timer already have a flush pending, so there is nothing to do
     void Socket::ForceFlushOut()
     {
-        m_OutBufferFlushTimer.cancel();
+        if (m_FlushPolicy.Policy == FlushPolicy::TimeBounded || m_FlushPolicy.Policy == FlushPolicy::ByteThreshold)
+            CancelWriteFlushTimer();
+    }
+    /// Set flush policy of our out queue, should be called from the constructor of derived class
+    /// @p_FlushPolicy : Policy settings
+    void Socket::SetFlushPolicy(FlushPolicySettings const& p_FlushPolicy)
+    {
+        m_FlushPolicy = p_FlushPolicy;
+    }
+    /// Set backpressure limits of our out queue, should be called from the constructor of derived class
+    /// @p_Backpressure : Backpressure settings
+    void Socket::SetBackpressure(BackpressureSettings const& p_Backpressure)
+    {
+        m_Backpressure = p_Backpressure;
+    }
+    /// Set interval of OnPingTimer, should be called from the constructor of derived class
+    /// @p_Interval : Milliseconds between pings, 0 to disable
+    void Socket::SetPingInterval(uint32 p_Interval)
+    {
+        m_Cold->PingInterval = p_Interval;
+    }
+    /// Set time without incoming data after which OnIdleTimeout is called, should be called from the constructor of derived class
+    /// @p_Timeout : Milliseconds, 0 to disable
+    void Socket::SetIdleTimeout(uint32 p_Timeout)
+    {
+        m_IdleTimeout = p_Timeout;
+    }
+    /// Set time without incoming data after which our in buffer storage is returned to the pool, should be called from the constructor of derived class
+    /// @p_Delay : Milliseconds, 0 to keep storage for the lifetime of the socket
+    void Socket::SetBufferReleaseDelay(uint32 p_Delay)
+    {
+        m_Cold->BufferReleaseDelay = p_Delay;
+    }
+    /// Encrypt all traffic from now on, must be called from our network thread
+    /// Data queued before is sent as it is, data recieved afterwards is decrypted before ProcessIncomingData
+    /// @p_InKey  : Key of incoming data, SocketCipher::GetKeyLength bytes
+    /// @p_OutKey : Key of outgoing data, SocketCipher::GetKeyLength bytes
+    /// Returns false if no cipher is configured or it is already enabled
+    bool Socket::EnableCipher(uint8 const* p_InKey, uint8 const* p_OutKey)
+    {
+        if (m_Cipher)
+            return false;
+
+        std::unique_ptr<SocketCipher> l_Cipher = SocketCipher::Create(p_InKey, p_OutKey);
+        if (!l_Cipher)
+            return false;
+
+        Utils::ObjectGuard l_Guard(this);
+
+        /// Everything queued so far goes out plain, nothing may be appended to it any more
+        for (OutChunk& l_Chunk : m_OutQueue)
+            l_Chunk.Writable = nullptr;
+
+        m_OutChunksEncrypted = m_OutQueue.size();
+        m_Cipher             = std::move(l_Cipher);
+
+        return true;
+    }
+    /// Called when nothing has been recieved within our idle timeout, see SetIdleTimeout
+    void Socket::OnIdleTimeout()
+    {
+        LOG_INFO("Socket", "%0 has not sent anything for %1 ms, closing socket", GetRemoteEndpoint(), m_IdleTimeout);
+        CloseSocket();
     }
 
     //////////////////////////////////////////////////////////////////////////
     //////////////////////////////////////////////////////////////////////////
 
-    /// Read incoming packets
+    /// Wait for incoming packets, no storage is held while waiting
     void Socket::StartAsyncRead()
     {
         if (IsClosed())
@@ -181,17 +467,76 @@ namespace SteerStone { namespace Core { namespace Network {
             return;
         }
 
+#ifdef STEERSTONE_IO_URING
+        if (m_Ring)
+        {
+            StartRingReceive();
+            return;
+        }
+#endif
+
         std::shared_ptr<Socket> l_Ptr = Shared<Socket>();
         m_ReadState = ReadState::Reading;
-        m_Socket.async_read_some(boost::asio::buffer(&m_InBuffer->m_Buffer[m_InBuffer->m_WritePosition], m_InBuffer->m_Buffer.size() - m_InBuffer->m_WritePosition),
-            make_custom_alloc_handler(m_allocator,
-                [l_Ptr](boost::system::error_code const& p_ErrorCode, std::size_t const& p_Length) { l_Ptr->OnRead(p_ErrorCode, p_Length); }));
+        m_Socket.async_wait(boost::asio::ip::tcp::socket::wait_read,
+            MakeAllocHandler(
+                [l_Ptr](boost::system::error_code const& p_ErrorCode) { l_Ptr->OnReadable(p_ErrorCode); }));
+    }
+    /// Read incoming packets into our in buffer once our socket is readable
+    /// @p_ErrorCode : Error code
+    void Socket::OnReadable(boost::system::error_code const& p_ErrorCode)
+    {
+        /// Our wait has been cancelled by MigrateTo, we are waiting on our new io service already
+        if (p_ErrorCode == boost::asio::error::operation_aborted && !IsClosed())
+            return;
+
+        if (p_ErrorCode)
+        {
+            m_ReadState = ReadState::Idle;
+            OnError(p_ErrorCode);
+            return;
+        }
+
+        if (IsClosed())
+        {
+            m_ReadState = ReadState::Idle;
+            return;
+        }
+
+        /// Keep any partial frame, but make sure the free space behind it is contiguous
+        if (m_InBuffer.GetWriteSpace() == 0)
+            m_InBuffer.Normalize();
+
+        /// A single frame is bigger than our storage, we cannot make progress
+        if (m_InBuffer.GetWriteSpace() == 0)
+        {
+            LOG_WARNING("Socket", "Incoming frame from %0 exceeds buffer capacity of %1 bytes, closing socket", GetRemoteEndpoint(), m_InBuffer.GetCapacity());
+            m_ReadState = ReadState::Idle;
+            CloseSocket();
+            return;
+        }
+
+        /// Acquires storage from the pool if it has been released
+        uint8* l_WritePointer = m_InBuffer.GetWritePointer();
+
+        boost::system::error_code l_ErrorCode;
+        const std::size_t l_Length = m_Socket.read_some(boost::asio::buffer(l_WritePointer, m_InBuffer.GetWriteSpace()), l_ErrorCode);
+
+        /// Spurious wake up, nothing to read yet
+        if (l_ErrorCode == boost::asio::error::would_block || l_ErrorCode == boost::asio::error::try_again)
+        {
+            StartAsyncRead();
+            return;
+        }
+
+        OnRead(l_ErrorCode, l_Length);
     }
     /// OnRead - Handle the incoming packet
     /// @p_Error : Error code
     /// @p_Length : Length of failed buffer
     void Socket::OnRead(const boost::system::error_code& p_ErrorCode, const std::size_t& p_Length)
     {
+        PROFILE_ZONE("Socket::OnRead");
+
         if (p_ErrorCode)
         {
             m_ReadState = ReadState::Idle;
@@ -205,49 +550,91 @@ namespace SteerStone { namespace Core { namespace Network {
             return;
         }
 
-        m_InBuffer->m_WritePosition += p_Length;
+        if (OnReceived(p_Length))
+            StartAsyncRead();
+    }
+    /// Process data written into our in buffer
+    /// @p_Length : Length of data written
+    /// Returns false if socket has been closed
+    bool Socket::OnReceived(std::size_t p_Length)
+    {
+        /// Decrypted where it has been recieved, ProcessIncomingData only ever sees plain data
+        if (m_Cipher)
+            m_Cipher->Decrypt(m_InBuffer.GetWritePointer(), p_Length);
 
-        const size_t l_Available = m_Socket.available();
+        m_InBuffer.WriteCompleted(p_Length);
+        AccountLoad(p_Length);
 
-        /// If there is still data to read, increase the buffer size and do so (if necessary)
-        if (l_Available > 0 && (p_Length + l_Available) > m_InBuffer->m_Buffer.size())
+        static Metrics::Counter& sl_Received = sMetrics->GetCounter("steerstone_network_received_bytes_total", "Bytes recieved by every socket");
+        sl_Received.Increment(p_Length);
+
+        /// Client is alive
+        if (m_IdleTimeout)
+            ScheduleTimer(m_IdleTimer, m_IdleTimeout);
+
+        ProcessState l_ProcessState = ProcessIncomingData();
+
+        if (l_ProcessState == ProcessState::Error)
         {
-            m_InBuffer->m_Buffer.resize(m_InBuffer->m_Buffer.size() + l_Available);
-            StartAsyncRead();
-            return;
+            /// Bad data read - close down socket
+            if (!IsClosed())
+                CloseSocket();
+
+            m_ReadState = ReadState::Idle;
+            return false;
         }
 
-        ProcessState l_ProcessState = ProcessIncomingData();
+        /// Discard what is left, otherwise unread data (a partially recieved frame) is kept for the next read
+        if (l_ProcessState == ProcessState::Skip)
+            m_InBuffer.Reset();
+
+        /// Give our storage back to the pool if the client goes quiet
+        if (m_Cold->BufferReleaseDelay)
+            ScheduleTimer(m_Cold->BufferReleaseTimer, m_Cold->BufferReleaseDelay);
 
-        if (l_ProcessState != ProcessState::Successful)
+        return true;
+    }
+    /// Copy data recieved outside our in buffer into it and process it
+    /// @p_Data   : Recieved data
+    /// @p_Length : Length of recieved data
+    /// Returns false if socket has been closed
+    bool Socket::OnReceivedData(uint8 const* p_Data, std::size_t p_Length)
+    {
+        while (p_Length > 0)
         {
-            if (l_ProcessState == ProcessState::Skip)
-            {
-                /// Reset buffer
-                m_InBuffer->m_WritePosition = 0;
-                m_InBuffer->m_ReadPosition = 0;
+            /// Keep any partial frame, but make sure the free space behind it is contiguous
+            if (m_InBuffer.GetWriteSpace() == 0)
+                m_InBuffer.Normalize();
 
-                StartAsyncRead();
-            }
-            else
+            const std::size_t l_Space = m_InBuffer.GetWriteSpace();
+
+            /// A single frame is bigger than our storage, we cannot make progress
+            if (l_Space == 0)
             {
-                /// Bad data read - close down socket
-                if (!IsClosed())
-                    CloseSocket();
+                LOG_WARNING("Socket", "Incoming frame from %0 exceeds buffer capacity of %1 bytes, closing socket", GetRemoteEndpoint(), m_InBuffer.GetCapacity());
+                CloseSocket();
+                return false;
             }
-        }
 
-        /// Reset buffer
-        m_InBuffer->m_WritePosition = 0;
-        m_InBuffer->m_ReadPosition = 0;
+            const std::size_t l_Length = std::min(l_Space, p_Length);
+            memcpy(m_InBuffer.GetWritePointer(), p_Data, l_Length);
 
-        StartAsyncRead();
+            p_Data   += l_Length;
+            p_Length -= l_Length;
+
+            if (!OnReceived(l_Length))
+                return false;
+        }
+
+        return true;
     }
     /// OnWriteComplete - Finished sending out our buffer
     /// @p_Error : Error code
     /// @p_Length : Length of failed buffer
     void Socket::OnWriteComplete(boost::system::error_code const& p_ErrorCode, std::size_t const& p_Length)
     {
+        PROFILE_ZONE("Socket::OnWriteComplete");
+
         /// We must check this before locking the mutex because the connection will be closed,
         /// which leads to a locked mutex being destroyed.  not good!
         if (p_ErrorCode)
@@ -264,40 +651,53 @@ namespace SteerStone { namespace Core { namespace Network {
 
         Utils::ObjectGuard l_Guard(this);
 
+        AccountLoad(p_Length);
+
+        static Metrics::Counter& sl_Sent = sMetrics->GetCounter("steerstone_network_sent_bytes_total", "Bytes sent by every socket");
+        sl_Sent.Increment(p_Length);
+
         LOG_ASSERT(m_WriteState == WriteState::Sending, "Socket", "Flushed out packet, but write state is not set to sending!");
-        LOG_ASSERT(p_Length <= m_OutBuffer->m_WritePosition, "Socket", "Sent length is more than OutBuffer length!");
 
-        /// If there is data left to write, move it to the start of the buffer
-        if (p_Length < m_OutBuffer->m_WritePosition)
+        /// Release every chunk which has been fully sent, a partially sent chunk stays at the front
+        /// and we remember how much of it went out, no data is moved
+        m_OutQueueSize -= p_Length;
+
+        /// Client is catching up again
+        if (m_Congested.load(std::memory_order_relaxed) && m_OutQueueSize <= m_Backpressure.LowWaterMark)
+            m_Congested.store(false, std::memory_order_relaxed);
+
+        if (m_Backpressure.HardLimit && m_OutQueueSize <= m_Backpressure.HardLimit && m_Cold->HardLimitSince != std::chrono::steady_clock::time_point())
         {
-            memcpy(&(m_OutBuffer->m_Buffer[0]), &(m_OutBuffer->m_Buffer[p_Length]), (m_OutBuffer->m_WritePosition - p_Length) * sizeof(m_OutBuffer->m_Buffer[0]));
-            m_OutBuffer->m_WritePosition -= p_Length;
+            m_Cold->HardLimitSince = std::chrono::steady_clock::time_point();
+
+            if (m_TimerWheel)
+                m_TimerWheel->Cancel(m_Cold->HardLimitTimer);
         }
-        /// If not, reset the write pointer
-        else
-            m_OutBuffer->m_WritePosition = 0;
 
-        /// If there is data in the secondary buffer, append it to the primary buffer
-        if (m_SecondaryOutBuffer->m_WritePosition > 0)
+        std::size_t l_Sent = p_Length + m_OutChunkOffset;
+        while (m_OutChunksSending > 0)
         {
-            /// Do we have enough space? if not, resize
-            if (m_OutBuffer->m_Buffer.size() < (m_OutBuffer->m_WritePosition + m_SecondaryOutBuffer->m_WritePosition))
-                m_OutBuffer->m_Buffer.resize(m_OutBuffer->m_WritePosition + m_SecondaryOutBuffer->m_WritePosition);
+            const std::size_t l_ChunkLength = m_OutQueue.front().Buffer->Peek().GetLength();
+
+            if (l_Sent < l_ChunkLength)
+                break;
 
-            memcpy(&(m_OutBuffer->m_Buffer[m_OutBuffer->m_WritePosition]), &(m_SecondaryOutBuffer->m_Buffer[0]), (m_SecondaryOutBuffer->m_WritePosition) * sizeof(m_SecondaryOutBuffer->m_Buffer[0]));
+            l_Sent -= l_ChunkLength;
+            m_OutQueue.pop_front();
+            m_OutChunksSending--;
 
-            m_OutBuffer->m_WritePosition += m_SecondaryOutBuffer->m_WritePosition;
-            m_SecondaryOutBuffer->m_WritePosition = 0;
+            if (m_OutChunksEncrypted)
+                m_OutChunksEncrypted--;
         }
 
+        LOG_ASSERT(m_OutChunksSending > 0 || l_Sent == 0, "Socket", "Sent length is more than queued length!");
+
+        m_OutChunkOffset   = l_Sent;
+        m_OutChunksSending = 0;
+
         /// If there is any data to write, do so immediately
-        if (m_OutBuffer->m_WritePosition > 0)
-        {
-            std::shared_ptr<Socket> l_Ptr = Shared<Socket>();
-            m_Socket.async_write_some(boost::asio::buffer(m_OutBuffer->m_Buffer, m_OutBuffer->m_WritePosition),
-                make_custom_alloc_handler(m_allocator,
-                    [l_Ptr](boost::system::error_code const& p_ErrorCode, std::size_t const& p_Length) { l_Ptr->OnWriteComplete(p_ErrorCode, p_Length); }));
-        }
+        if (!m_OutQueue.empty())
+            StartAsyncWrite();
         else
             m_WriteState = WriteState::Idle;
     }
@@ -313,16 +713,184 @@ namespace SteerStone { namespace Core { namespace Network {
 
         Utils::ObjectGuard l_Guard(this);
 
-        LOG_ASSERT(m_WriteState == WriteState::Buffering, "Socket", "Flushing out packet but write state is not set to buffering!");
+        /// Flush timer and a forced flush may both trigger, only the first one sends
+        if (m_WriteState != WriteState::Buffering)
+            return;
 
-        /// At this point we are guarunteed that there is data to send in the primary buffer.  send it.
+        /// At this point we are guarunteed that there is data to send in the out queue.  send it.
         m_WriteState = WriteState::Sending;
 
+        StartAsyncWrite();
+    }
+    /// Send queued chunks with a single vectored write
+    void Socket::StartAsyncWrite()
+    {
+        if (m_Cipher)
+            EncryptOutChunks();
+
+        OutBufferSequence l_Buffers;
+
+        /// Gather as many chunks as our sequence can hold, the first chunk may have been partially sent
+        for (auto l_Itr = m_OutQueue.begin(); l_Itr != m_OutQueue.end() && l_Buffers.size() < l_Buffers.capacity(); l_Itr++)
+        {
+            const PacketView l_View = l_Itr->Buffer->Peek();
+
+            if (l_Buffers.empty())
+                l_Buffers.push_back(boost::asio::const_buffer(l_View.GetData() + m_OutChunkOffset, l_View.GetLength() - m_OutChunkOffset));
+            else
+                l_Buffers.push_back(boost::asio::const_buffer(l_View.GetData(), l_View.GetLength()));
+        }
+
+        m_OutChunksSending = l_Buffers.size();
+
+#ifdef STEERSTONE_IO_URING
+        if (m_Ring)
+        {
+            StartRingSend(l_Buffers);
+            return;
+        }
+#endif
+
         std::shared_ptr<Socket> l_Ptr = Shared<Socket>();
-        m_Socket.async_write_some(boost::asio::buffer(m_OutBuffer->m_Buffer, m_OutBuffer->m_WritePosition),
-            make_custom_alloc_handler(m_allocator,
+        m_Socket.async_write_some(l_Buffers,
+            MakeAllocHandler(
                 [l_Ptr](boost::system::error_code const& p_ErrorCode, std::size_t const& p_Length) { l_Ptr->OnWriteComplete(p_ErrorCode, p_Length); }));
     }
+    /// Encrypt chunks about to be gathered which have not been encrypted yet, must be called while holding our lock
+    /// Chunks we own are encrypted in place, chunks shared with other sockets are replaced by an encrypted copy
+    void Socket::EncryptOutChunks()
+    {
+        static Metrics::Counter& sl_Copied = sMetrics->GetCounter("steerstone_network_cipher_copied_bytes_total", "Bytes of shared chunks copied to be encrypted");
+
+        /// Chunks are encrypted in the order they are sent, our keystream must not skip ahead
+        const std::size_t l_End = std::min<std::size_t>(m_OutQueue.size(), MAX_OUT_BUFFER_SEQUENCE);
+
+        for (; m_OutChunksEncrypted < l_End; m_OutChunksEncrypted++)
+        {
+            OutChunk& l_Chunk = m_OutQueue[m_OutChunksEncrypted];
+            const PacketView l_View = l_Chunk.Buffer->Peek();
+
+            if (l_Chunk.Writable)
+            {
+                /// Our own chunk, nothing may be appended to it once its data is encrypted
+                m_Cipher->Encrypt(const_cast<uint8*>(l_View.GetData()), l_View.GetLength());
+                l_Chunk.Writable = nullptr;
+                continue;
+            }
+
+            /// Every socket has its own keystream, a shared chunk needs a copy of its own
+            std::shared_ptr<PacketBuffer> l_Encrypted = std::make_shared<PacketBuffer>(static_cast<uint32>(std::max<std::size_t>(l_View.GetLength(), STORAGE_INITIAL_SIZE)));
+            m_Cipher->Encrypt(l_View.GetData(), l_Encrypted->Reserve(l_View.GetLength()), l_View.GetLength());
+            l_Encrypted->WriteCompleted(l_View.GetLength());
+
+            l_Chunk.Buffer = std::move(l_Encrypted);
+            sl_Copied.Increment(l_View.GetLength());
+        }
+    }
+    /// Schedule sending out our data depending on our flush policy
+    /// Must be called while holding our lock
+    void Socket::StartWriteFlush()
+    {
+        switch (m_WriteState)
+        {
+            case WriteState::Idle:
+            {
+                switch (m_FlushPolicy.Policy)
+                {
+                    case FlushPolicy::Immediate:
+                    {
+                        if (IsClosed())
+                            return;
+
+                        m_WriteState = WriteState::Sending;
+                        StartAsyncWrite();
+                    }
+                    break;
+                    case FlushPolicy::Tick:
+                    {
+                        if (IsClosed())
+                            return;
+
+                        /// Handlers which are already queued on our io service run first, so anything
+                        /// they write is sent with this flush
+                        m_WriteState = WriteState::Buffering;
+
+                        std::shared_ptr<Socket> l_Ptr = Shared<Socket>();
+                        boost::asio::post(m_Socket.get_executor(), MakeAllocHandler([l_Ptr]() { l_Ptr->FlushOut(); }));
+                    }
+                    break;
+                    case FlushPolicy::ByteThreshold:
+                    {
+                        StartWriteFlushTimer();
+
+                        if (m_OutQueueSize >= m_FlushPolicy.ByteThreshold)
+                            CancelWriteFlushTimer();
+                    }
+                    break;
+                    case FlushPolicy::TimeBounded:
+                        StartWriteFlushTimer();
+                        break;
+                }
+            }
+            break;
+            case WriteState::Buffering:
+            {
+                /// Enough data is waiting, don't wait for the timer
+                if (m_FlushPolicy.Policy == FlushPolicy::ByteThreshold && m_OutQueueSize >= m_FlushPolicy.ByteThreshold)
+                    CancelWriteFlushTimer();
+            }
+            break;
+            /// Data will be picked up once the current write has completed
+            case WriteState::Sending:
+                break;
+        }
+    }
+    /// Check whether data must be dropped, non essential data while congested and everything while above our hard limit
+    /// @p_Priority : Priority of data being written
+    /// @p_Length   : Length of data being written
+    bool Socket::ShouldDrop(WritePriority p_Priority, std::size_t p_Length)
+    {
+        /// Our queue stays bounded until our hard limit timer closes us
+        const bool l_AboveHardLimit = m_Backpressure.HardLimit && m_OutQueueSize > m_Backpressure.HardLimit;
+
+        if (!l_AboveHardLimit && (p_Priority != WritePriority::NonEssential || !m_Congested.load(std::memory_order_relaxed)))
+            return false;
+
+        s_BackpressureStatistics.DroppedWrites.fetch_add(1, std::memory_order_relaxed);
+        s_BackpressureStatistics.DroppedBytes.fetch_add(p_Length, std::memory_order_relaxed);
+
+        return true;
+    }
+    /// Update congestion state after data has been queued, going above our hard limit starts our hard limit timer
+    /// Returns true if socket stayed above its hard limit for too long and must be closed
+    bool Socket::UpdateBackpressure()
+    {
+        if (m_Backpressure.HighWaterMark && m_OutQueueSize >= m_Backpressure.HighWaterMark && !m_Congested.load(std::memory_order_relaxed))
+        {
+            m_Congested.store(true, std::memory_order_relaxed);
+            s_BackpressureStatistics.Congested.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (!m_Backpressure.HardLimit || m_OutQueueSize <= m_Backpressure.HardLimit)
+            return false;
+
+        const auto l_Now = std::chrono::steady_clock::now();
+
+        if (m_Cold->HardLimitSince == std::chrono::steady_clock::time_point())
+        {
+            m_Cold->HardLimitSince = l_Now;
+            ScheduleTimer(m_Cold->HardLimitTimer, m_Backpressure.HardLimitTimeout);
+            return false;
+        }
+
+        if (std::chrono::duration_cast<std::chrono::milliseconds>(l_Now - m_Cold->HardLimitSince).count() < m_Backpressure.HardLimitTimeout)
+            return false;
+
+        LOG_WARNING("Socket", "%0 stayed above %1 queued bytes for %2 ms, closing slow consumer", GetRemoteEndpoint(), m_Backpressure.HardLimit, m_Backpressure.HardLimitTimeout);
+        s_BackpressureStatistics.Evicted.fetch_add(1, std::memory_order_relaxed);
+
+        return true;
+    }
     /// Start the time to send out our data in interval
     void Socket::StartWriteFlushTimer()
     {
@@ -337,10 +905,294 @@ namespace SteerStone { namespace Core { namespace Network {
 
         m_WriteState = WriteState::Buffering;
 
+        if (m_TimerWheel)
+            ScheduleTimer(m_FlushTimer, m_FlushPolicy.Timeout);
+        else
+        {
+            /// Not owned by a network thread, nothing to time our flush with
+            std::shared_ptr<Socket> l_Ptr = Shared<Socket>();
+            boost::asio::post(m_Socket.get_executor(), MakeAllocHandler([l_Ptr]() { l_Ptr->FlushOut(); }));
+        }
+    }
+    /// Stop the flush timer and send out our data right away
+    void Socket::CancelWriteFlushTimer()
+    {
+        if (!m_TimerWheel || !m_TimerWheel->Cancel(m_FlushTimer))
+            return;
+
+        std::shared_ptr<Socket> l_Ptr = Shared<Socket>();
+        boost::asio::post(m_Socket.get_executor(), MakeAllocHandler([l_Ptr]() { l_Ptr->FlushOut(); }));
+    }
+    /// Schedule timer in the timer wheel of our network thread
+    /// @p_Entry : Timer to schedule
+    /// @p_Delay : Milliseconds until timer expires
+    void Socket::ScheduleTimer(TimerWheelEntry& p_Entry, uint32 p_Delay)
+    {
+        if (m_TimerWheel)
+            m_TimerWheel->Schedule(p_Entry, p_Delay, weak_from_this());
+    }
+    /// Give our connection back to the admission control which counted us
+    void Socket::ReleaseAdmission()
+    {
+        if (!m_Cold->Admission)
+            return;
+
+        m_Cold->Admission->Release(m_Cold->AdmissionAddress);
+        m_Cold->Admission.reset();
+    }
+    /// Account a completed handler to our network thread load
+    /// @p_Bytes : Bytes transferred by handler
+    void Socket::AccountLoad(std::size_t p_Bytes)
+    {
+        m_LoadEvents++;
+
+        if (m_Load)
+            m_Load->AddEvent(p_Bytes);
+    }
+    /// Check if we have no data in flight and only wait for incoming packets, must be called from our network thread
+    bool Socket::IsQuiet() const
+    {
+#ifdef STEERSTONE_IO_URING
+        /// Our multishot receive is bound to the ring of our network thread
+        if (m_Ring)
+            return false;
+#endif
+
+        return !IsClosed() && m_ReadState == ReadState::Reading && m_WriteState == WriteState::Idle
+            && m_OutQueue.empty() && m_InBuffer.ReadLengthRemaining() == 0;
+    }
+    /// Move our descriptor to the io service of another network thread, only possible while quiet
+    /// Must be called from our network thread, pending incoming data stays in the kernel
+    /// @p_Service      : IO service we are moved to
+    /// @p_TimerWheel   : Timer wheel of target network thread
+    /// @p_Load         : Load of target network thread
+    /// @p_Owner      : Target network thread
+    bool Socket::MigrateTo(boost::asio::io_service& p_Service, std::shared_ptr<TimerWheel> const& p_TimerWheel, NetworkThreadLoad* p_Load, SocketOwner* p_Owner)
+    {
+        Utils::ObjectGuard l_Guard(this);
+
+        /// Writers hold our lock, nothing can be queued while we move
+        if (!IsQuiet())
+            return false;
+
+        boost::system::error_code l_ErrorCode;
+        const boost::asio::ip::tcp::endpoint l_LocalEndPoint = m_Socket.local_endpoint(l_ErrorCode);
+        if (l_ErrorCode)
+            return false;
+
+        /// Cancels our pending wait, not supported by every platform
+        const boost::asio::ip::tcp::socket::native_handle_type l_Descriptor = m_Socket.release(l_ErrorCode);
+        if (l_ErrorCode)
+        {
+            LOG_VERBOSE("Socket", "Cannot migrate %0: %1", GetRemoteEndpoint(), l_ErrorCode.message());
+            return false;
+        }
+
+        boost::asio::ip::tcp::socket l_Socket(p_Service);
+        l_Socket.assign(l_LocalEndPoint.protocol(), l_Descriptor, l_ErrorCode);
+        if (!l_ErrorCode)
+            l_Socket.non_blocking(true, l_ErrorCode);
+
+        /// Timers are restarted on the timer wheel of our new network thread
+        const bool l_PingScheduled          = m_TimerWheel && m_TimerWheel->Cancel(m_Cold->PingTimer);
+        const bool l_IdleScheduled          = m_TimerWheel && m_TimerWheel->Cancel(m_IdleTimer);
+        const bool l_BufferReleaseScheduled = m_TimerWheel && m_TimerWheel->Cancel(m_Cold->BufferReleaseTimer);
+
+        m_Socket        = std::move(l_Socket);
+        m_TimerWheel    = p_TimerWheel;
+        m_Load          = p_Load;
+        m_Owner         = p_Owner;
+
+        if (l_ErrorCode)
+        {
+            LOG_ERROR("Socket", "Failed to migrate %0: %1", GetRemoteEndpoint(), l_ErrorCode.message());
+
+            boost::asio::detail::socket_ops::state_type l_State = 0;
+            boost::asio::detail::socket_ops::close(l_Descriptor, l_State, true, l_ErrorCode);
+
+            /// We are closed now, our new network thread removes us once we have been handed over
+            return true;
+        }
+
+        if (l_PingScheduled)
+            ScheduleTimer(m_Cold->PingTimer, m_Cold->PingInterval);
+        if (l_IdleScheduled)
+            ScheduleTimer(m_IdleTimer, m_IdleTimeout);
+        if (l_BufferReleaseScheduled)
+            ScheduleTimer(m_Cold->BufferReleaseTimer, m_Cold->BufferReleaseDelay);
+
+        std::shared_ptr<Socket> l_Ptr = Shared<Socket>();
+        boost::asio::post(m_Socket.get_executor(), MakeAllocHandler([l_Ptr]() { l_Ptr->StartAsyncRead(); }));
+
+        return true;
+    }
+
+    /// Give up our descriptor so another process can continue our connection, only possible while nothing is being sent
+    /// Must be called from our network thread, we are closed afterwards without shutting down the connection
+    /// @p_Port       : Local port our connection must have been accepted on
+    /// @p_Connection : Output, descriptor, unread incoming data and session state
+    bool Socket::ReleaseForHandoff(uint16 p_Port, HandoffConnection& p_Connection)
+    {
+        Utils::ObjectGuard l_Guard(this);
+
+#ifdef STEERSTONE_IO_URING
+        /// Our multishot receive would keep on consuming data of the handed over descriptor
+        if (m_Ring)
+            return false;
+#endif
+
+        /// Our keystream cannot be handed over
+        if (m_Cipher)
+            return false;
+
+        /// Data in flight cannot be handed over, the client would miss part of a frame
+        if (IsClosed() || m_WriteState != WriteState::Idle || !m_OutQueue.empty())
+            return false;
+
+        boost::system::error_code l_ErrorCode;
+        const boost::asio::ip::tcp::endpoint l_LocalEndPoint = m_Socket.local_endpoint(l_ErrorCode);
+        if (l_ErrorCode || l_LocalEndPoint.port() != p_Port)
+            return false;
+
+        p_Connection.State.clear();
+        if (!SaveHandoffState(p_Connection.State) || p_Connection.State.size() > SOCKET_HANDOFF_MAX_STATE)
+            return false;
+
+        /// A partially recieved frame is completed by the new process
+        const PacketView l_Unread = InView();
+        p_Connection.InData.assign(l_Unread.GetData(), l_Unread.GetData() + l_Unread.GetLength());
+
+        /// Cancels our pending wait, not supported by every platform
+        const boost::asio::ip::tcp::socket::native_handle_type l_Descriptor = m_Socket.release(l_ErrorCode);
+        if (l_ErrorCode)
+        {
+            LOG_VERBOSE("Socket", "Cannot hand over %0: %1", GetRemoteEndpoint(), l_ErrorCode.message());
+            return false;
+        }
+
+        if (m_TimerWheel)
+        {
+            m_TimerWheel->Cancel(m_FlushTimer);
+            m_TimerWheel->Cancel(m_Cold->PingTimer);
+            m_TimerWheel->Cancel(m_IdleTimer);
+            m_TimerWheel->Cancel(m_Cold->BufferReleaseTimer);
+        }
+
+        p_Connection.Port       = p_Port;
+        p_Connection.Descriptor = l_Descriptor;
+
+        /// The new process does not count adopted connections
+        ReleaseAdmission();
+
+        return true;
+    }
+    /// Continue a connection handed over by the previous process, our descriptor must be assigned already
+    /// @p_Connection : Handed over connection, its data is moved
+    void Socket::Adopt(HandoffConnection& p_Connection)
+    {
         std::shared_ptr<Socket> l_Ptr = Shared<Socket>();
-        m_OutBufferFlushTimer.expires_from_now(boost::posix_time::milliseconds(int32(m_BufferTimeout)));
-        m_OutBufferFlushTimer.async_wait([l_Ptr](const boost::system::error_code& p_Error) { l_Ptr->FlushOut(); });
+        std::shared_ptr<HandoffConnection> l_Connection = std::make_shared<HandoffConnection>(std::move(p_Connection));
+
+        boost::asio::post(m_Socket.get_executor(), [l_Ptr, l_Connection]() { l_Ptr->OnAdopted(l_Connection->InData, l_Connection->State); });
+    }
+    /// Restore state and open adopted connection, called from our network thread
+    /// @p_InData : Unread incoming data
+    /// @p_State  : Saved session state
+    void Socket::OnAdopted(std::vector<uint8> const& p_InData, std::vector<uint8> const& p_State)
+    {
+        if (!LoadHandoffState(p_State.data(), p_State.size()) || !Open())
+        {
+            LOG_ERROR("Socket", "Failed to adopt handed over connection");
+
+            if (!IsClosed())
+                CloseSocket();
+
+            return;
+        }
+
+        /// Our read has been started already, its handler runs once we have returned
+        if (!p_InData.empty())
+            OnReceivedData(p_InData.data(), p_InData.size());
+    }
+
+#ifdef STEERSTONE_IO_URING
+    static_assert(IO_URING_MAX_SEND_VECTORS >= MAX_OUT_BUFFER_SEQUENCE, "Send operation cannot hold our whole buffer sequence");
+
+    /// Arm multishot receive on the ring of our network thread
+    void Socket::StartRingReceive()
+    {
+        m_ReadState = ReadState::Reading;
+
+        /// Still armed, completions keep on coming
+        if (m_RingReceive.Pending)
+            return;
+
+        m_RingReceive.Keep = shared_from_this();
+        m_Ring->QueueReceive(m_Socket.native_handle(), &m_RingReceive);
+    }
+    /// Handle a completion of our multishot receive
+    /// @p_Result : Bytes recieved or negative error
+    /// @p_Flags  : Completion flags
+    void Socket::OnRingReceive(int32 p_Result, uint32 p_Flags)
+    {
+        /// Last completion of this receive, keep ourself alive until we are done
+        std::shared_ptr<void> l_Keep = (p_Flags & IORING_CQE_F_MORE) ? m_RingReceive.Keep : std::move(m_RingReceive.Keep);
+
+        if (p_Result > 0 && (p_Flags & IORING_CQE_F_BUFFER))
+        {
+            const bool l_Open = !IsClosed() && OnReceivedData(m_Ring->GetBuffer(p_Flags), static_cast<std::size_t>(p_Result));
+            m_Ring->RecycleBuffer(p_Flags);
+
+            if (!l_Open)
+            {
+                m_ReadState = ReadState::Idle;
+                return;
+            }
+        }
+        /// Provided buffers ran out, the receive has finished and is armed again below
+        else if (p_Result != -ENOBUFS)
+        {
+            m_ReadState = ReadState::Idle;
+
+            if (p_Result < 0 && p_Result != -ECANCELED)
+                LOG_VERBOSE("Socket", "Receive from %0 failed: %1", GetRemoteEndpoint(), strerror(-p_Result));
+
+            if (!IsClosed())
+                CloseSocket();
+
+            return;
+        }
+
+        if (!(p_Flags & IORING_CQE_F_MORE))
+            StartAsyncRead();
+    }
+    /// Send gathered chunks with a single sendmsg on the ring of our network thread, must be called while holding our lock
+    /// @p_Buffers : Chunks to send
+    void Socket::StartRingSend(OutBufferSequence const& p_Buffers)
+    {
+        for (std::size_t l_I = 0; l_I < p_Buffers.size(); l_I++)
+        {
+            m_RingSend.Vectors[l_I].iov_base   = const_cast<void*>(p_Buffers[l_I].data());
+            m_RingSend.Vectors[l_I].iov_len    = p_Buffers[l_I].size();
+        }
+
+        m_RingSend.Keep = shared_from_this();
+        m_Ring->QueueSend(m_Socket.native_handle(), &m_RingSend, p_Buffers.size());
     }
+    /// Handle completion of our send
+    /// @p_Result : Bytes sent or negative error
+    /// @p_Flags  : Completion flags
+    void Socket::OnRingSend(int32 p_Result, uint32 /*p_Flags*/)
+    {
+        std::shared_ptr<void> l_Keep = std::move(m_RingSend.Keep);
+
+        if (p_Result < 0)
+            OnWriteComplete(boost::system::error_code(-p_Result, boost::system::system_category()), 0);
+        else
+            OnWriteComplete(boost::system::error_code(), static_cast<std::size_t>(p_Result));
+    }
+#endif
+
     /// Catch an error if packet is corrupted
     /// @p_Error : Error code
     void Socket::OnError(const boost::system::error_code& p_Error)
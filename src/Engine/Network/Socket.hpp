@@ -18,16 +18,32 @@
 
 #pragma once
 #include <PCH/Precompiled.hpp>
-
+#include <boost/container/deque.hpp>
+#include <boost/container/static_vector.hpp>
+#include <atomic>
+#include <chrono>
+
+#include "AcceptAdmission.hpp"
+#include "HandlerMemory.hpp"
+#include "IoUring.hpp"
+#include "NetworkLoad.hpp"
 #include "PacketBuffer.hpp"
+#include "SocketCipher.hpp"
+#include "SharedPacket.hpp"
+#include "SocketHandle.hpp"
+#include "SocketHandoff.hpp"
+#include "TimerWheel.hpp"
 #include "Logger/Base.hpp"
+#include "Memory/MemObjectPool.hpp"
 #include "Utility/UtiObjectGuard.hpp"
 #include "Utility/UtiLockable.hpp"
 
+#define MAX_OUT_BUFFER_SEQUENCE 16
+
 namespace SteerStone { namespace Core { namespace Network {
 
     /// Write States
-    enum class WriteState
+    enum class WriteState : uint8
     {
         Idle,                       ///< Idling
         Buffering,                  ///< In progress of writing packet
@@ -35,12 +51,77 @@ namespace SteerStone { namespace Core { namespace Network {
     };
 
     /// Read States
-    enum class ReadState
+    enum class ReadState : uint8
     {
         Idle,                       ///< Idling
         Reading                     ///< In progress of reading packet
     };
 
+    /// Flush Policies
+    enum class FlushPolicy
+    {
+        Immediate,                  ///< Send as soon as data is written
+        Tick,                       ///< Send once the current batch of handlers on the io service has run
+        ByteThreshold,              ///< Send once enough data is queued, or when the timeout expires
+        TimeBounded                 ///< Send once the timeout expires
+    };
+
+    /// Flush Policy Settings
+    struct FlushPolicySettings
+    {
+        FlushPolicy Policy;         ///< Policy
+        std::size_t ByteThreshold;  ///< Queued bytes which trigger a flush (ByteThreshold)
+        int32 Timeout;              ///< Milliseconds data may wait before being sent (ByteThreshold, TimeBounded)
+    };
+
+    /// Write Priorities
+    enum class WritePriority
+    {
+        Essential,                  ///< Always queued
+        NonEssential                ///< Dropped while socket is congested (intermediate movement frames...)
+    };
+
+    /// Backpressure Settings, a limit of 0 disables it
+    struct BackpressureSettings
+    {
+        std::size_t LowWaterMark;   ///< Queued bytes at which socket is no longer congested
+        std::size_t HighWaterMark;  ///< Queued bytes at which socket becomes congested
+        std::size_t HardLimit;      ///< Queued bytes which may not be exceeded for longer than HardLimitTimeout, writes are dropped while above
+        uint32 HardLimitTimeout;    ///< Milliseconds socket may stay above HardLimit before being closed
+    };
+
+    /// Backpressure Statistics, shared by all sockets
+    struct BackpressureStatistics
+    {
+        std::atomic<uint64> Congested;              ///< Amount of times a socket crossed its high water mark
+        std::atomic<uint64> DroppedWrites;          ///< Non essential writes dropped while congested
+        std::atomic<uint64> DroppedBytes;           ///< Non essential bytes dropped while congested
+        std::atomic<uint64> Evicted;                ///< Sockets closed for staying above their hard limit
+    };
+
+    /// Memory held by a socket, see Socket::GetMemoryUsage
+    struct SocketMemoryUsage
+    {
+        std::size_t Object;         ///< Socket object, its control block, cold state and cipher
+        std::size_t InBuffer;       ///< Storage of our in buffer, 0 while released
+        std::size_t OutQueue;       ///< Chunks only we reference and the blocks of our out queue
+        std::size_t Shared;         ///< Queued chunks shared with other sockets, not owned by us
+    };
+
+    class Socket;
+
+    /// Owner of sockets, told once a socket has been closed so it can release it
+    class SocketOwner
+    {
+        public:
+            /// Deconstructor
+            virtual ~SocketOwner() {}
+
+            /// Remove socket from storage
+            /// @p_Socket : Socket being removed
+            virtual void RemoveSocket(Socket* p_Socket) = 0;
+    };
+
     /// Process States
     enum class ProcessState
     {
@@ -49,20 +130,59 @@ namespace SteerStone { namespace Core { namespace Network {
         Error                       ///< Error in data, close down socket
     };
 
-    class Socket : public std::enable_shared_from_this<Socket>, private Utils::LockableReadWrite
+    class Socket : public std::enable_shared_from_this<Socket>, private Utils::Lockable
     {
         /// Allow access to lock / unlock methods
         friend class Utils::ObjectGuard<Socket>;
         friend class Utils::ObjectReadGuard<Socket>;
         friend class Utils::ObjectWriteGuard<Socket>;
 
+        /// Allow our network thread to assign our handle
+        template<typename T> friend class NetworkThread;
+
+        /// Chunk queued to be sent
+        struct OutChunk
+        {
+            std::shared_ptr<PacketBuffer const> Buffer;                             ///< Data to be sent
+            PacketBuffer* Writable;                                                 ///< Set if we own the chunk and can still append to it
+        };
+
+        /// Buffer sequence for a single vectored write, fixed size so no allocation is needed
+        typedef boost::container::static_vector<boost::asio::const_buffer, MAX_OUT_BUFFER_SEQUENCE> OutBufferSequence;
+
+        /// Out queue, blocks hold one write worth of chunks and nothing is allocated until something is queued
+        typedef boost::container::deque<OutChunk, void, boost::container::deque_options<boost::container::block_size<MAX_OUT_BUFFER_SEQUENCE>>::type> OutQueue;
+
+        /// Fields rarely touched after Open, kept apart so our hot fields share fewer cache lines
+        struct ColdState
+        {
+            MEMORY_POOL_OPERATORS(ColdState)
+
+            /// Constructor
+            ColdState()
+                : ObjectSize(0), PingInterval(0), BufferReleaseDelay(0)
+            {
+            }
+
+            boost::asio::ip::tcp::endpoint RemoteEndPoint;                          ///< End point of our client, formatted only when asked for
+            std::shared_ptr<AcceptAdmission> Admission;                             ///< Admission control counting our connection, nullptr if untracked
+            AdmissionKey AdmissionAddress;                                          ///< Our address in admission control
+            std::chrono::steady_clock::time_point HardLimitSince;                   ///< Time out queue went above hard limit
+            TimerWheelEntry PingTimer;                                              ///< Time to ping
+            TimerWheelEntry BufferReleaseTimer;                                     ///< Time to return idle storage
+            TimerWheelEntry HardLimitTimer;                                         ///< Time to close us if we are still above our hard limit
+            std::size_t ObjectSize;                                                 ///< Bytes of our object and its control block, set by our network thread
+            uint32 PingInterval;                                                    ///< Milliseconds between pings
+            uint32 BufferReleaseDelay;                                              ///< Milliseconds without incoming data before releasing storage
+        };
+
         public:
             /// Constructor
             /// @p_Service : Socket to pass
-            /// @p_CloseHandler : Custom Handler to handle our function
-            Socket(boost::asio::io_service& p_Service, std::function<void(Socket*)> p_CloseHandler);
+            /// @p_Owner : Owner told once we are closed, nullptr if none
+            Socket(boost::asio::io_service& p_Service, SocketOwner* p_Owner);
             /// Virtual Deconstructor
-            virtual ~Socket() = default;
+            virtual ~Socket();
 
             //////////////////////////////////////////////////////////////////////////
             //////////////////////////////////////////////////////////////////////////
@@ -84,20 +204,46 @@ namespace SteerStone { namespace Core { namespace Network {
             /// @p_Length : The length of the data to skip
             void ReadSkip(std::size_t const& p_Length);
             /// Write the data to be sent
-            /// @p_Buffer : Buffer which holds the data
-            /// @p_Length : The length of the data
-            void Write(const char* p_Buffer, std::size_t const& p_Length);
+            /// @p_Buffer   : Buffer which holds the data
+            /// @p_Length   : The length of the data
+            /// @p_Priority : Non essential data is dropped while congested
+            /// Returns false if data has been dropped
+            bool Write(const char* p_Buffer, std::size_t const& p_Length, WritePriority p_Priority = WritePriority::Essential);
+            /// Queue a chunk to be sent, the chunk is not copied and may be shared between sockets
+            /// @p_Chunk    : Chunk which holds the data, must not be modified after being queued
+            /// @p_Priority : Non essential data is dropped while congested
+            /// Returns false if data has been dropped
+            bool Write(std::shared_ptr<PacketBuffer const> const& p_Chunk, WritePriority p_Priority = WritePriority::Essential);
+            /// Queue a shared packet to be sent, the packet is not copied
+            /// @p_Packet   : Packet serialized once for every recipient
+            /// @p_Priority : Non essential data is dropped while congested
+            /// Returns false if data has been dropped
+            bool Write(SharedPacket const& p_Packet, WritePriority p_Priority = WritePriority::Essential);
             /// Get the total read length of the packet
             std::size_t const ReadLength();
             /// Get the length remaining to read
             std::size_t const ReadLengthRemaining();
 
+            /// Get flush policy of our out queue
+            FlushPolicySettings const& GetFlushPolicy() const;
+            /// Check if our out queue is above its high water mark, game layer should skip non essential updates
+            bool IsCongested() const;
+            /// Get amount of bytes waiting in our out queue
+            std::size_t GetOutQueueSize() const;
+            /// Get backpressure statistics of all sockets
+            static BackpressureStatistics const& GetBackpressureStatistics();
+
+            /// Get our handle in storage of our current network thread, see SocketHandle
+            SocketHandle GetHandle() const;
+
             /// Get our AsioSocket
             boost::asio::ip::tcp::socket& GetAsioSocket();
-            /// Get our EndPoint
-            std::string const& GetRemoteEndpoint();
-            /// Get our Remote Address
-            std::string const& GetRemoteAddress();
+            /// Get our EndPoint, formatted on every call
+            std::string GetRemoteEndpoint() const;
+            /// Get our Remote Address, formatted on every call
+            std::string GetRemoteAddress() const;
+            /// Get memory we hold, must be called from our network thread
+            SocketMemoryUsage GetMemoryUsage() const;
 
             /// Shared Pointer
             /// @param T Class which derives from Socket class
@@ -110,31 +256,148 @@ namespace SteerStone { namespace Core { namespace Network {
         protected:
             /// Virtual Function which passes into our derived class Socket
             virtual ProcessState ProcessIncomingData() = 0;
+            /// Called every ping interval, see SetPingInterval
+            virtual void OnPingTimer() {}
+            /// Called when nothing has been recieved within our idle timeout, see SetIdleTimeout
+            virtual void OnIdleTimeout();
+            /// Save session state so another process can continue our connection, see SocketHandoff
+            /// @p_State : Output, restored by LoadHandoffState of the new process
+            /// Returns false if our connection cannot be handed over right now
+            virtual bool SaveHandoffState(std::vector<uint8>& /*p_State*/) { return true; }
+            /// Restore session state saved by SaveHandoffState of the previous process, called before Open
+            /// @p_State  : Saved state
+            /// @p_Length : Length of saved state
+            /// Returns false if socket must be closed
+            virtual bool LoadHandoffState(uint8 const* /*p_State*/, std::size_t /*p_Length*/) { return true; }
 
             /// Get the current read position
             uint8 const* InPeak();
+            /// Get a view of all unread incoming data, no data is copied
+            PacketView InView() const;
+            /// Get a view of unread incoming data, no data is copied
+            /// @p_Length : Length of the view, returns empty view if the frame is not fully recieved yet
+            PacketView InView(std::size_t p_Length) const;
 
             /// Send our current data in our buffer
             void ForceFlushOut();
 
+            /// Set flush policy of our out queue, should be called from the constructor of derived class
+            /// @p_FlushPolicy : Policy settings
+            void SetFlushPolicy(FlushPolicySettings const& p_FlushPolicy);
+            /// Set backpressure limits of our out queue, should be called from the constructor of derived class
+            /// @p_Backpressure : Backpressure settings
+            void SetBackpressure(BackpressureSettings const& p_Backpressure);
+            /// Set interval of OnPingTimer, should be called from the constructor of derived class
+            /// @p_Interval : Milliseconds between pings, 0 to disable
+            void SetPingInterval(uint32 p_Interval);
+            /// Set time without incoming data after which OnIdleTimeout is called, should be called from the constructor of derived class
+            /// @p_Timeout : Milliseconds, 0 to disable
+            void SetIdleTimeout(uint32 p_Timeout);
+            /// Set time without incoming data after which our in buffer storage is returned to the pool and the blocks of our empty out queue are freed,
+            /// should be called from the constructor of derived class
+            /// @p_Delay : Milliseconds, 0 to keep storage for the lifetime of the socket
+            void SetBufferReleaseDelay(uint32 p_Delay);
+            /// Encrypt all traffic from now on, must be called from our network thread
+            /// Data queued before is sent as it is, data recieved afterwards is decrypted before ProcessIncomingData
+            /// @p_InKey  : Key of incoming data, SocketCipher::GetKeyLength bytes
+            /// @p_OutKey : Key of outgoing data, SocketCipher::GetKeyLength bytes
+            /// Returns false if no cipher is configured or it is already enabled
+            bool EnableCipher(uint8 const* p_InKey, uint8 const* p_OutKey);
+            /// Check our traffic is encrypted
+            bool IsCipherEnabled() const { return m_Cipher != nullptr; }
+
         //////////////////////////////////////////////////////////////////////////
         //////////////////////////////////////////////////////////////////////////
 
         private:
-            /// Read incoming packets
+            /// Give our connection back to the admission control which counted us
+            void ReleaseAdmission();
+            /// Account a completed handler to our network thread load
+            /// @p_Bytes : Bytes transferred by handler
+            void AccountLoad(std::size_t p_Bytes);
+            /// Check if we have no data in flight and only wait for incoming packets, must be called from our network thread
+            bool IsQuiet() const;
+            /// Move our descriptor to the io service of another network thread, only possible while quiet
+            /// Must be called from our network thread, pending incoming data stays in the kernel
+            /// @p_Service      : IO service we are moved to
+            /// @p_TimerWheel   : Timer wheel of target network thread
+            /// @p_Load         : Load of target network thread
+            /// @p_Owner      : Target network thread
+            bool MigrateTo(boost::asio::io_service& p_Service, std::shared_ptr<TimerWheel> const& p_TimerWheel, NetworkThreadLoad* p_Load, SocketOwner* p_Owner);
+            /// Give up our descriptor so another process can continue our connection, only possible while nothing is being sent
+            /// Must be called from our network thread, we are closed afterwards without shutting down the connection
+            /// @p_Port       : Local port our connection must have been accepted on
+            /// @p_Connection : Output, descriptor, unread incoming data and session state
+            bool ReleaseForHandoff(uint16 p_Port, HandoffConnection& p_Connection);
+            /// Continue a connection handed over by the previous process, our descriptor must be assigned already
+            /// @p_Connection : Handed over connection, its data is moved
+            void Adopt(HandoffConnection& p_Connection);
+            /// Restore state and open adopted connection, called from our network thread
+            /// @p_InData : Unread incoming data
+            /// @p_State  : Saved session state
+            void OnAdopted(std::vector<uint8> const& p_InData, std::vector<uint8> const& p_State);
+
+            /// Wait for incoming packets, no storage is held while waiting
             void StartAsyncRead();
+            /// Read incoming packets into our in buffer once our socket is readable
+            /// @p_ErrorCode : Error code
+            void OnReadable(boost::system::error_code const& p_ErrorCode);
             /// Handle the incoming packet
             /// @p_Error : Error code
             /// @p_Length : Length of failed buffer
             void OnRead(boost::system::error_code const& p_ErrorCode, std::size_t const& p_Length);
+            /// Process data written into our in buffer
+            /// @p_Length : Length of data written
+            /// Returns false if socket has been closed
+            bool OnReceived(std::size_t p_Length);
+            /// Copy data recieved outside our in buffer into it and process it
+            /// @p_Data   : Recieved data
+            /// @p_Length : Length of recieved data
+            /// Returns false if socket has been closed
+            bool OnReceivedData(uint8 const* p_Data, std::size_t p_Length);
+#ifdef STEERSTONE_IO_URING
+            /// Arm multishot receive on the ring of our network thread
+            void StartRingReceive();
+            /// Handle a completion of our multishot receive
+            /// @p_Result : Bytes recieved or negative error
+            /// @p_Flags  : Completion flags
+            void OnRingReceive(int32 p_Result, uint32 p_Flags);
+            /// Send gathered chunks with a single sendmsg on the ring of our network thread, must be called while holding our lock
+            /// @p_Buffers : Chunks to send
+            void StartRingSend(OutBufferSequence const& p_Buffers);
+            /// Handle completion of our send
+            /// @p_Result : Bytes sent or negative error
+            /// @p_Flags  : Completion flags
+            void OnRingSend(int32 p_Result, uint32 p_Flags);
+#endif
             /// Finished sending out our buffer
             /// @p_Error : Error code
             /// @p_Length : Length of failed buffer
             void OnWriteComplete(boost::system::error_code const& p_ErrorCode, std::size_t const& p_Length);
             /// Begin to send out our data in our buffer
             void FlushOut();
+            /// Send queued chunks with a single vectored write
+            void StartAsyncWrite();
+            /// Encrypt chunks about to be gathered which have not been encrypted yet, must be called while holding our lock
+            /// Chunks we own are encrypted in place, chunks shared with other sockets are replaced by an encrypted copy
+            void EncryptOutChunks();
+            /// Schedule sending out our data depending on our flush policy
+            void StartWriteFlush();
+            /// Check whether data must be dropped, non essential data while congested and everything while above our hard limit
+            /// @p_Priority : Priority of data being written
+            /// @p_Length   : Length of data being written
+            bool ShouldDrop(WritePriority p_Priority, std::size_t p_Length);
+            /// Update congestion state after data has been queued, going above our hard limit starts our hard limit timer
+            /// Returns true if socket stayed above its hard limit for too long and must be closed
+            bool UpdateBackpressure();
             /// Start the time to send out our data in interval
             void StartWriteFlushTimer();
+            /// Stop the flush timer and send out our data right away
+            void CancelWriteFlushTimer();
+            /// Schedule timer in the timer wheel of our network thread
+            /// @p_Entry : Timer to schedule
+            /// @p_Delay : Milliseconds until timer expires
+            void ScheduleTimer(TimerWheelEntry& p_Entry, uint32 p_Delay);
             /// Catch an error if packet is corrupted
             /// @p_Error : Error code
             void OnError(boost::system::error_code const& p_ErrorCode);
@@ -142,102 +405,39 @@ namespace SteerStone { namespace Core { namespace Network {
         private:
             /// Socket
             boost::asio::ip::tcp::socket m_Socket;                                    ///< Socket
-            std::function<void(Socket*)> m_CloseHandler;                              ///< Socket Handler         
-            std::string const m_Address;                                              ///< Address of our Listener                           
-            std::string const m_RemoteEndPoint;                                       ///< End point of our Listener
+            SocketOwner* m_Owner;                                                     ///< Owner told once we are closed, nullptr if none
+            SocketHandle m_Handle;                                                    ///< Handle in network thread storage
+            std::unique_ptr<ColdState> m_Cold;                                        ///< Fields rarely touched after Open
             /// Buffer
-            std::unique_ptr<PacketBuffer> m_InBuffer;                                 ///< In Buffer - recieving incoming packets
-            std::unique_ptr<PacketBuffer> m_OutBuffer;                                ///< Out Buffer - sending our packets
-            std::unique_ptr<PacketBuffer> m_SecondaryOutBuffer;                       ///< Secondary Out Buffer - sending our packets
-            boost::asio::deadline_timer m_OutBufferFlushTimer;                        ///< Time to send out packets
-            static int32 const m_BufferTimeout = 60;                                  ///< Interval of our flush out timer
+            PacketBuffer m_InBuffer;                                                  ///< In Buffer - recieving incoming packets
+            OutQueue m_OutQueue;                                                      ///< Out Queue - chunks waiting to be sent or being sent
+            std::size_t m_OutChunkOffset;                                             ///< Bytes of the front chunk already sent
+            std::size_t m_OutChunksSending;                                           ///< Chunks at the front of the queue being sent
+            std::size_t m_OutQueueSize;                                               ///< Bytes queued in our out queue
+            std::unique_ptr<SocketCipher> m_Cipher;                                   ///< Stream cipher of our traffic, nullptr if plain
+            std::size_t m_OutChunksEncrypted;                                         ///< Chunks at the front of the queue which must not be encrypted again
+            FlushPolicySettings m_FlushPolicy;                                        ///< When to send out packets
+            BackpressureSettings m_Backpressure;                                      ///< Limits of our out queue
+            static BackpressureStatistics s_BackpressureStatistics;                   ///< Statistics of all sockets
+#ifdef STEERSTONE_IO_URING
+            /// io_uring
+            IoUring* m_Ring;                                                          ///< Ring of our network thread, nullptr to use asio reactor
+            IoUringOperation m_RingReceive;                                           ///< Multishot receive
+            IoUringSendOperation m_RingSend;                                          ///< Vectored send
+#endif
+            /// Timers
+            std::shared_ptr<TimerWheel> m_TimerWheel;                                 ///< Timer wheel of our network thread
+            TimerWheelEntry m_FlushTimer;                                             ///< Time to send out packets
+            TimerWheelEntry m_IdleTimer;                                              ///< Time to give up on an idle client
+            uint32 m_IdleTimeout;                                                     ///< Milliseconds without incoming data before idling out
+            static int32 const m_BufferTimeout = 60;                                  ///< Default interval of our flush out timer
+            /// Load
+            uint32 m_LoadEvents;                                                      ///< Handlers since last migration pass of our network thread
+            NetworkThreadLoad* m_Load;                                                ///< Load of our network thread
             /// States
             WriteState m_WriteState;                                                  ///< State of where are at; idle, reading
             ReadState m_ReadState;                                                    ///< State of where are at; idle, reading, buffering
-
-#pragma region
-    private:
-        // custom allocator based on example from http://www.boost.org/doc/libs/1_62_0/doc/html/boost_asio/example/cpp11/allocation/server.cpp
-
-        // Class to manage the memory to be used for handler-based custom allocation.
-        // It contains a single block of memory which may be returned for allocation
-        // requests. If the memory is in use when an allocation request is made, the
-        // allocator delegates allocation to the global heap.
-        class handler_allocator
-        {
-        private:
-            static const size_t BufferSize = 512;
-
-            // Storage space used for handler-based custom memory allocation.
-            std::aligned_storage<BufferSize>::type mBuffer;
-
-            // Whether the handler-based custom allocation storage has been used.
-            bool m_inUse;
-
-        public:
-            handler_allocator() : m_inUse(false) {}
-
-            handler_allocator(const handler_allocator&) = delete;
-            handler_allocator& operator=(const handler_allocator&) = delete;
-
-            void* allocate(std::size_t size)
-            {
-                if (!m_inUse && size <= sizeof(mBuffer))
-                {
-                    m_inUse = true;
-                    return &mBuffer;
-                }
-
-                return ::operator new(size);
-            }
-
-            void deallocate(void* pointer)
-            {
-                if (pointer == &mBuffer)
-                    m_inUse = false;
-                else
-                    ::operator delete(pointer);
-            }
-        };
-
-        // Wrapper class template for handler objects to allow handler memory
-        // allocation to be customised. Calls to operator() are forwarded to the
-        // encapsulated handler.
-        template <typename Handler>
-        class custom_alloc_handler
-        {
-        private:
-            handler_allocator& m_allocator;
-            Handler m_handler;
-
-        public:
-            custom_alloc_handler(handler_allocator& a, Handler h) : m_allocator(a), m_handler(h) {}
-
-            template <typename ...Args>
-            void operator()(Args&& ... args)
-            {
-                m_handler(std::forward<Args>(args)...);
-            }
-
-            friend void* asio_handler_allocate(std::size_t size, custom_alloc_handler<Handler>* this_handler)
-            {
-                return this_handler->m_allocator.allocate(size);
-            }
-
-            friend void asio_handler_deallocate(void* pointer, std::size_t /*size*/, custom_alloc_handler<Handler>* this_handler)
-            {
-                this_handler->m_allocator.deallocate(pointer);
-            }
-        };
-
-        // Helper function to wrap a handler object to add custom allocation.
-        template <typename Handler>
-        static custom_alloc_handler<Handler> make_custom_alloc_handler(handler_allocator& a, Handler h)
-        {
-            return custom_alloc_handler<Handler>(a, h);
-        }
-
-        handler_allocator m_allocator;
+            std::atomic<bool> m_Congested;                                            ///< Out queue is above high water mark
     };
 
     template<typename T>
@@ -245,7 +445,6 @@ namespace SteerStone { namespace Core { namespace Network {
     {
         return std::static_pointer_cast<T>(shared_from_this());
     }
-#pragma endregion CustomHandler; TODO
 }   ///< Network
 }   ///< Core
 }   ///< Steerstone
\ No newline at end of file
@@ -0,0 +1,209 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <openssl/evp.h>
+
+#include "SocketCipher.hpp"
+#include "Logger/Base.hpp"
+
+#include <climits>
+#include <mutex>
+#include <vector>
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    static EVP_CIPHER const* s_Cipher = nullptr;            ///< Cipher of every socket, nullptr if disabled
+    static std::mutex s_PoolMutex;                          ///< Guards pool
+    static std::vector<EVP_CIPHER_CTX*> s_Pool;             ///< Released contexts
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Select cipher every socket uses, called once on start up
+    /// @p_Name : OpenSSL name of a stream cipher ("rc4", "chacha20"), empty to disable
+    /// Returns false if OpenSSL does not provide it as a stream cipher
+    bool SocketCipher::SetCipher(std::string const& p_Name)
+    {
+        s_Cipher = nullptr;
+
+        if (p_Name.empty())
+            return true;
+
+        EVP_CIPHER const* l_Cipher = EVP_get_cipherbyname(p_Name.c_str());
+        if (!l_Cipher || EVP_CIPHER_block_size(l_Cipher) != 1 || EVP_CIPHER_key_length(l_Cipher) > SOCKET_CIPHER_MAX_KEY_LENGTH)
+        {
+            LOG_ERROR("SocketCipher", "%0 is not a stream cipher provided by OpenSSL", p_Name);
+            return false;
+        }
+
+        /// Providers load lazily, a cipher which is listed may still be unusable (rc4 needs the legacy provider)
+        const uint8 l_Key[SOCKET_CIPHER_MAX_KEY_LENGTH] = {};
+        const uint8 l_IV[EVP_MAX_IV_LENGTH] = {};
+
+        EVP_CIPHER_CTX* l_Context = EVP_CIPHER_CTX_new();
+        const bool l_Usable = l_Context && EVP_EncryptInit_ex(l_Context, l_Cipher, nullptr, l_Key, l_IV) == 1;
+        EVP_CIPHER_CTX_free(l_Context);
+
+        if (!l_Usable)
+        {
+            LOG_ERROR("SocketCipher", "OpenSSL cannot initialize %0", p_Name);
+            return false;
+        }
+
+        s_Cipher = l_Cipher;
+
+        LOG_INFO("SocketCipher", "Traffic of sockets which exchanged keys is encrypted with %0", p_Name);
+        return true;
+    }
+    /// Check a cipher has been selected
+    bool SocketCipher::IsEnabled()
+    {
+        return s_Cipher != nullptr;
+    }
+    /// Get key length of selected cipher
+    std::size_t SocketCipher::GetKeyLength()
+    {
+        return s_Cipher ? static_cast<std::size_t>(EVP_CIPHER_key_length(s_Cipher)) : 0;
+    }
+    /// Create cipher
+    /// @p_InKey  : Key of incoming data, GetKeyLength bytes
+    /// @p_OutKey : Key of outgoing data, GetKeyLength bytes
+    /// Returns nullptr if no cipher is selected or OpenSSL refused the keys
+    std::unique_ptr<SocketCipher> SocketCipher::Create(uint8 const* p_InKey, uint8 const* p_OutKey)
+    {
+        if (!s_Cipher)
+            return nullptr;
+
+        /// Every key is used once, in one direction of one connection, so a zero IV does not repeat a keystream
+        const uint8 l_IV[EVP_MAX_IV_LENGTH] = {};
+
+        std::unique_ptr<SocketCipher> l_Cipher(new SocketCipher(AcquireContext(), AcquireContext()));
+
+        if (!l_Cipher->m_In || !l_Cipher->m_Out
+            || EVP_DecryptInit_ex(l_Cipher->m_In, s_Cipher, nullptr, p_InKey, l_IV) != 1
+            || EVP_EncryptInit_ex(l_Cipher->m_Out, s_Cipher, nullptr, p_OutKey, l_IV) != 1)
+            return nullptr;
+
+        return l_Cipher;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    /// @p_In  : Context of incoming data
+    /// @p_Out : Context of outgoing data
+    SocketCipher::SocketCipher(EVP_CIPHER_CTX* p_In, EVP_CIPHER_CTX* p_Out)
+        : m_In(p_In), m_Out(p_Out)
+    {
+    }
+    /// Deconstructor, contexts go back to the pool
+    SocketCipher::~SocketCipher()
+    {
+        ReleaseContext(m_In);
+        ReleaseContext(m_Out);
+    }
+
+    /// Decrypt incoming data in place
+    /// @p_Data   : Data
+    /// @p_Length : Length of data
+    void SocketCipher::Decrypt(uint8* p_Data, std::size_t p_Length)
+    {
+        int l_Written = 0;
+
+        while (p_Length > 0)
+        {
+            const int l_Length = static_cast<int>(std::min<std::size_t>(p_Length, INT_MAX));
+            EVP_DecryptUpdate(m_In, p_Data, &l_Written, p_Data, l_Length);
+
+            p_Data   += l_Length;
+            p_Length -= l_Length;
+        }
+    }
+    /// Encrypt outgoing data in place
+    /// @p_Data   : Data
+    /// @p_Length : Length of data
+    void SocketCipher::Encrypt(uint8* p_Data, std::size_t p_Length)
+    {
+        Encrypt(p_Data, p_Data, p_Length);
+    }
+    /// Encrypt outgoing data into another buffer, used for chunks shared with other sockets
+    /// @p_Input  : Data
+    /// @p_Output : Output, at least p_Length bytes
+    /// @p_Length : Length of data
+    void SocketCipher::Encrypt(uint8 const* p_Input, uint8* p_Output, std::size_t p_Length)
+    {
+        int l_Written = 0;
+
+        while (p_Length > 0)
+        {
+            const int l_Length = static_cast<int>(std::min<std::size_t>(p_Length, INT_MAX));
+            EVP_EncryptUpdate(m_Out, p_Output, &l_Written, p_Input, l_Length);
+
+            p_Input  += l_Length;
+            p_Output += l_Length;
+            p_Length -= l_Length;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Take context from the pool, allocated if the pool is empty
+    EVP_CIPHER_CTX* SocketCipher::AcquireContext()
+    {
+        {
+            std::lock_guard<std::mutex> l_Lock(s_PoolMutex);
+
+            if (!s_Pool.empty())
+            {
+                EVP_CIPHER_CTX* l_Context = s_Pool.back();
+                s_Pool.pop_back();
+                return l_Context;
+            }
+        }
+
+        return EVP_CIPHER_CTX_new();
+    }
+    /// Reset context and give it back to the pool
+    /// @p_Context : Context
+    void SocketCipher::ReleaseContext(EVP_CIPHER_CTX* p_Context)
+    {
+        if (!p_Context)
+            return;
+
+        /// Reset keeps the allocation of the context, key material is wiped
+        EVP_CIPHER_CTX_reset(p_Context);
+
+        {
+            std::lock_guard<std::mutex> l_Lock(s_PoolMutex);
+
+            if (s_Pool.size() < SOCKET_CIPHER_POOL_SIZE)
+            {
+                s_Pool.push_back(p_Context);
+                return;
+            }
+        }
+
+        EVP_CIPHER_CTX_free(p_Context);
+    }
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
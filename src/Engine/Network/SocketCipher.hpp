@@ -0,0 +1,94 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+
+#include <memory>
+#include <string>
+
+#define SOCKET_CIPHER_MAX_KEY_LENGTH    32          ///< Longest key of a stream cipher we accept
+#define SOCKET_CIPHER_POOL_SIZE         4096        ///< EVP contexts kept in the pool once released
+
+typedef struct evp_cipher_ctx_st EVP_CIPHER_CTX;
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Stream cipher of a socket, one EVP context per direction
+    /// Data is transformed a whole chunk at a time, the EVP implementation picks the vectorized code path of the cpu
+    /// Contexts come from a global pool, a socket enabling its cipher does not allocate once the pool is warm
+    class SocketCipher
+    {
+        DISALLOW_COPY_AND_ASSIGN(SocketCipher);
+
+        public:
+            /// Select cipher every socket uses, called once on start up
+            /// @p_Name : OpenSSL name of a stream cipher ("rc4", "chacha20"), empty to disable
+            /// Returns false if OpenSSL does not provide it as a stream cipher
+            static bool SetCipher(std::string const& p_Name);
+            /// Check a cipher has been selected
+            static bool IsEnabled();
+            /// Get key length of selected cipher
+            static std::size_t GetKeyLength();
+            /// Create cipher
+            /// @p_InKey  : Key of incoming data, GetKeyLength bytes
+            /// @p_OutKey : Key of outgoing data, GetKeyLength bytes
+            /// Returns nullptr if no cipher is selected or OpenSSL refused the keys
+            static std::unique_ptr<SocketCipher> Create(uint8 const* p_InKey, uint8 const* p_OutKey);
+
+        public:
+            /// Deconstructor, contexts go back to the pool
+            ~SocketCipher();
+
+            /// Decrypt incoming data in place
+            /// @p_Data   : Data
+            /// @p_Length : Length of data
+            void Decrypt(uint8* p_Data, std::size_t p_Length);
+            /// Encrypt outgoing data in place
+            /// @p_Data   : Data
+            /// @p_Length : Length of data
+            void Encrypt(uint8* p_Data, std::size_t p_Length);
+            /// Encrypt outgoing data into another buffer, used for chunks shared with other sockets
+            /// @p_Input  : Data
+            /// @p_Output : Output, at least p_Length bytes
+            /// @p_Length : Length of data
+            void Encrypt(uint8 const* p_Input, uint8* p_Output, std::size_t p_Length);
+
+        private:
+            /// Constructor
+            /// @p_In  : Context of incoming data
+            /// @p_Out : Context of outgoing data
+            SocketCipher(EVP_CIPHER_CTX* p_In, EVP_CIPHER_CTX* p_Out);
+
+            /// Take context from the pool, allocated if the pool is empty
+            static EVP_CIPHER_CTX* AcquireContext();
+            /// Reset context and give it back to the pool
+            /// @p_Context : Context
+            static void ReleaseContext(EVP_CIPHER_CTX* p_Context);
+
+        private:
+            EVP_CIPHER_CTX* m_In;                   ///< Context of incoming data
+            EVP_CIPHER_CTX* m_Out;                  ///< Context of outgoing data
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
@@ -0,0 +1,95 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+
+#define SOCKET_HANDLE_INDEX_BITS        20
+#define SOCKET_HANDLE_GENERATION_BITS   (32 - SOCKET_HANDLE_INDEX_BITS)
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Handle of a socket inside a NetworkThread slot storage
+    /// Lower bits are the slot index, upper bits the generation of the slot,
+    /// a handle to a removed socket never matches the socket which reuses the slot
+    /// Only unique within the network thread which issued it, another thread may issue the same value and
+    /// a connection gets a new handle once it migrates or is handed over, it is not a connection id
+    class SocketHandle
+    {
+        public:
+            static constexpr uint32 MaxIndex        = (1u << SOCKET_HANDLE_INDEX_BITS) - 1;
+            static constexpr uint32 MaxGeneration   = (1u << SOCKET_HANDLE_GENERATION_BITS) - 1;
+
+        public:
+            /// Constructor
+            constexpr SocketHandle()
+                : m_Value(0)
+            {
+            }
+            /// Constructor
+            /// @p_Index      : Slot index
+            /// @p_Generation : Slot generation, 0 is reserved for invalid handles
+            constexpr SocketHandle(uint32 p_Index, uint32 p_Generation)
+                : m_Value((p_Generation << SOCKET_HANDLE_INDEX_BITS) | (p_Index & MaxIndex))
+            {
+            }
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Get slot index
+            constexpr uint32 GetIndex() const
+            {
+                return m_Value & MaxIndex;
+            }
+            /// Get slot generation
+            constexpr uint32 GetGeneration() const
+            {
+                return m_Value >> SOCKET_HANDLE_INDEX_BITS;
+            }
+            /// Get raw value, only meaningful to the network thread which issued it
+            constexpr uint32 GetValue() const
+            {
+                return m_Value;
+            }
+            /// Check if handle has been assigned
+            constexpr bool IsValid() const
+            {
+                return GetGeneration() != 0;
+            }
+
+            /// Compare handles
+            constexpr bool operator==(SocketHandle const& p_Other) const
+            {
+                return m_Value == p_Other.m_Value;
+            }
+            /// Compare handles
+            constexpr bool operator!=(SocketHandle const& p_Other) const
+            {
+                return m_Value != p_Other.m_Value;
+            }
+
+        private:
+            uint32 m_Value;         ///< Index and generation
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
@@ -0,0 +1,601 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "SocketHandoff.hpp"
+#include "Logger/Base.hpp"
+
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define SOCKET_HANDOFF_LISTENER         1           ///< Message holds a listening descriptor
+#define SOCKET_HANDOFF_CONNECTION       2           ///< Message holds a connection
+#define SOCKET_HANDOFF_END              3           ///< Everything has been sent
+
+namespace SteerStone { namespace Core { namespace Network {
+
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+    /// Header of every handoff message, both processes run on the same machine so no byte order is applied
+    struct HandoffHeader
+    {
+        uint32 Type;                            ///< Message type
+        uint32 Port;                            ///< Port of listener or connection
+        uint32 InLength;                        ///< Length of unread incoming data following the header
+        uint32 StateLength;                     ///< Length of session state following the incoming data
+    };
+
+    /// Write all bytes to blocking descriptor
+    /// @p_Descriptor : Descriptor
+    /// @p_Data       : Data to write
+    /// @p_Length     : Length of data
+    static bool WriteAll(int p_Descriptor, uint8 const* p_Data, std::size_t p_Length)
+    {
+        while (p_Length > 0)
+        {
+            const ssize_t l_Written = send(p_Descriptor, p_Data, p_Length, MSG_NOSIGNAL);
+
+            if (l_Written < 0 && errno == EINTR)
+                continue;
+            if (l_Written <= 0)
+                return false;
+
+            p_Data   += l_Written;
+            p_Length -= static_cast<std::size_t>(l_Written);
+        }
+
+        return true;
+    }
+    /// Read all bytes from blocking descriptor
+    /// @p_Descriptor : Descriptor
+    /// @p_Data       : Output
+    /// @p_Length     : Amount of bytes to read
+    static bool ReadAll(int p_Descriptor, uint8* p_Data, std::size_t p_Length)
+    {
+        while (p_Length > 0)
+        {
+            const ssize_t l_Read = recv(p_Descriptor, p_Data, p_Length, 0);
+
+            if (l_Read < 0 && errno == EINTR)
+                continue;
+            if (l_Read <= 0)
+                return false;
+
+            p_Data   += l_Read;
+            p_Length -= static_cast<std::size_t>(l_Read);
+        }
+
+        return true;
+    }
+    /// Check process on the other end of unix socket runs as our user, nobody else may get our descriptors
+    /// @p_Socket : Connected unix socket
+    static bool IsPeerTrusted(int p_Socket)
+    {
+#ifdef SO_PEERCRED
+        ucred l_Credentials;
+        socklen_t l_Length = sizeof(l_Credentials);
+
+        if (getsockopt(p_Socket, SOL_SOCKET, SO_PEERCRED, &l_Credentials, &l_Length) != 0)
+            return false;
+
+        return l_Credentials.uid == getuid();
+#else
+        uid_t l_User;
+        gid_t l_Group;
+
+        if (getpeereid(p_Socket, &l_User, &l_Group) != 0)
+            return false;
+
+        return l_User == getuid();
+#endif
+    }
+    /// Send message, the descriptor travels with the first byte of the header
+    /// @p_Socket     : Connected unix socket
+    /// @p_Header     : Header
+    /// @p_Descriptor : Descriptor to pass, -1 for none
+    static bool SendMessage(int p_Socket, HandoffHeader const& p_Header, int p_Descriptor)
+    {
+        iovec l_Vector;
+        l_Vector.iov_base   = const_cast<HandoffHeader*>(&p_Header);
+        l_Vector.iov_len    = sizeof(HandoffHeader);
+
+        union
+        {
+            cmsghdr Header;
+            uint8 Buffer[CMSG_SPACE(sizeof(int))];
+        } l_Control;
+        memset(&l_Control, 0, sizeof(l_Control));
+
+        msghdr l_Message;
+        memset(&l_Message, 0, sizeof(l_Message));
+        l_Message.msg_iov       = &l_Vector;
+        l_Message.msg_iovlen    = 1;
+
+        if (p_Descriptor >= 0)
+        {
+            l_Message.msg_control       = l_Control.Buffer;
+            l_Message.msg_controllen    = sizeof(l_Control.Buffer);
+
+            cmsghdr* l_ControlHeader = CMSG_FIRSTHDR(&l_Message);
+            l_ControlHeader->cmsg_level = SOL_SOCKET;
+            l_ControlHeader->cmsg_type  = SCM_RIGHTS;
+            l_ControlHeader->cmsg_len   = CMSG_LEN(sizeof(int));
+            memcpy(CMSG_DATA(l_ControlHeader), &p_Descriptor, sizeof(int));
+        }
+
+        ssize_t l_Sent;
+        do
+        {
+            l_Sent = sendmsg(p_Socket, &l_Message, MSG_NOSIGNAL);
+        } while (l_Sent < 0 && errno == EINTR);
+
+        if (l_Sent <= 0)
+            return false;
+
+        return WriteAll(p_Socket, reinterpret_cast<uint8 const*>(&p_Header) + l_Sent, sizeof(HandoffHeader) - static_cast<std::size_t>(l_Sent));
+    }
+    /// Recieve message header and its descriptor
+    /// @p_Socket     : Connected unix socket
+    /// @p_Header     : Header
+    /// @p_Descriptor : Descriptor passed, -1 for none
+    static bool RecieveMessage(int p_Socket, HandoffHeader& p_Header, int& p_Descriptor)
+    {
+        p_Descriptor = -1;
+
+        iovec l_Vector;
+        l_Vector.iov_base   = &p_Header;
+        l_Vector.iov_len    = sizeof(HandoffHeader);
+
+        union
+        {
+            cmsghdr Header;
+            uint8 Buffer[CMSG_SPACE(sizeof(int))];
+        } l_Control;
+        memset(&l_Control, 0, sizeof(l_Control));
+
+        msghdr l_Message;
+        memset(&l_Message, 0, sizeof(l_Message));
+        l_Message.msg_iov           = &l_Vector;
+        l_Message.msg_iovlen        = 1;
+        l_Message.msg_control       = l_Control.Buffer;
+        l_Message.msg_controllen    = sizeof(l_Control.Buffer);
+
+        int l_Flags = 0;
+#ifdef MSG_CMSG_CLOEXEC
+        l_Flags |= MSG_CMSG_CLOEXEC;
+#endif
+
+        ssize_t l_Read;
+        do
+        {
+            l_Read = recvmsg(p_Socket, &l_Message, l_Flags);
+        } while (l_Read < 0 && errno == EINTR);
+
+        if (l_Read <= 0)
+            return false;
+
+        for (cmsghdr* l_ControlHeader = CMSG_FIRSTHDR(&l_Message); l_ControlHeader; l_ControlHeader = CMSG_NXTHDR(&l_Message, l_ControlHeader))
+        {
+            if (l_ControlHeader->cmsg_level == SOL_SOCKET && l_ControlHeader->cmsg_type == SCM_RIGHTS)
+                memcpy(&p_Descriptor, CMSG_DATA(l_ControlHeader), sizeof(int));
+        }
+
+        if (!ReadAll(p_Socket, reinterpret_cast<uint8*>(&p_Header) + l_Read, sizeof(HandoffHeader) - static_cast<std::size_t>(l_Read)))
+        {
+            if (p_Descriptor >= 0)
+                close(p_Descriptor);
+
+            p_Descriptor = -1;
+            return false;
+        }
+
+        return true;
+    }
+#endif
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get protocol of descriptor
+    /// @p_Descriptor : Socket descriptor
+    boost::asio::ip::tcp SocketHandoff::GetProtocol(int p_Descriptor)
+    {
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+        sockaddr_storage l_Address;
+        socklen_t l_Length = sizeof(l_Address);
+
+        if (getsockname(p_Descriptor, reinterpret_cast<sockaddr*>(&l_Address), &l_Length) == 0 && l_Address.ss_family == AF_INET6)
+            return boost::asio::ip::tcp::v6();
+#endif
+
+        return boost::asio::ip::tcp::v4();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    SocketHandoff::SocketHandoff()
+    {
+    }
+    /// Deconstructor, closes every descriptor which has not been taken
+    SocketHandoff::~SocketHandoff()
+    {
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+        std::future<void> l_Stopped;
+
+        {
+            Utils::ObjectGuard l_Guard(this);
+
+            if (m_Task)
+                l_Stopped = m_Stopped.get_future();
+        }
+
+        if (l_Stopped.valid())
+        {
+            boost::asio::post(*m_Service, [this]()
+            {
+                boost::system::error_code l_ErrorCode;
+                m_Acceptor->close(l_ErrorCode);
+            });
+
+            /// Our task retires its worker itself once the event loop returned
+            m_Service->stop();
+            l_Stopped.wait();
+        }
+#endif
+
+        CloseAll();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Receive descriptors from the process serving on path, blocks until everything has been received
+    /// @p_Path : Path of unix socket
+    /// Returns false if no process is serving on path
+    bool SocketHandoff::Receive(std::string const& p_Path)
+    {
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+        boost::asio::io_service l_Service;
+        boost::asio::local::stream_protocol::socket l_Socket(l_Service);
+
+        boost::system::error_code l_ErrorCode;
+        l_Socket.connect(boost::asio::local::stream_protocol::endpoint(p_Path), l_ErrorCode);
+        if (l_ErrorCode)
+            return false;
+
+        if (!IsPeerTrusted(l_Socket.native_handle()))
+        {
+            LOG_ERROR("SocketHandoff", "Process serving on %0 runs as another user, not taking its descriptors", p_Path);
+            return false;
+        }
+
+        LOG_INFO("SocketHandoff", "Receiving descriptors from previous process on %0", p_Path);
+
+        Utils::ObjectGuard l_Guard(this);
+
+        for (;;)
+        {
+            HandoffHeader l_Header;
+            int l_Descriptor = -1;
+
+            if (!RecieveMessage(l_Socket.native_handle(), l_Header, l_Descriptor))
+            {
+                LOG_ERROR("SocketHandoff", "Handoff from previous process ended early, got %0 listeners and %1 connections", m_Listeners.size(), m_Connections.size());
+                return !m_Listeners.empty();
+            }
+
+            switch (l_Header.Type)
+            {
+                case SOCKET_HANDOFF_LISTENER:
+                {
+                    if (l_Descriptor >= 0)
+                        m_Listeners.push_back(std::make_pair(static_cast<uint16>(l_Header.Port), l_Descriptor));
+                }
+                break;
+                case SOCKET_HANDOFF_CONNECTION:
+                {
+                    HandoffConnection l_Connection;
+                    l_Connection.Port       = static_cast<uint16>(l_Header.Port);
+                    l_Connection.Descriptor = l_Descriptor;
+
+                    if (l_Header.InLength > SOCKET_HANDOFF_MAX_IN_DATA || l_Header.StateLength > SOCKET_HANDOFF_MAX_STATE)
+                    {
+                        LOG_ERROR("SocketHandoff", "Handed over connection is too big (%0 / %1 bytes)", l_Header.InLength, l_Header.StateLength);
+                        if (l_Descriptor >= 0)
+                            close(l_Descriptor);
+                        return !m_Listeners.empty();
+                    }
+
+                    l_Connection.InData.resize(l_Header.InLength);
+                    l_Connection.State.resize(l_Header.StateLength);
+
+                    if (!ReadAll(l_Socket.native_handle(), l_Connection.InData.data(), l_Connection.InData.size())
+                        || !ReadAll(l_Socket.native_handle(), l_Connection.State.data(), l_Connection.State.size()))
+                    {
+                        if (l_Descriptor >= 0)
+                            close(l_Descriptor);
+                        return !m_Listeners.empty();
+                    }
+
+                    if (l_Descriptor >= 0)
+                        m_Connections.push_back(std::move(l_Connection));
+                }
+                break;
+                case SOCKET_HANDOFF_END:
+                {
+                    LOG_INFO("SocketHandoff", "Received %0 listeners and %1 connections from previous process", m_Listeners.size(), m_Connections.size());
+                    return true;
+                }
+                default:
+                {
+                    if (l_Descriptor >= 0)
+                        close(l_Descriptor);
+                }
+                break;
+            }
+        }
+#else
+        LOG_ERROR("SocketHandoff", "Socket handoff is not supported on this platform");
+        return false;
+#endif
+    }
+    /// Take listening descriptor of port
+    /// @p_Port : Port
+    /// Returns -1 if port has not been handed over
+    int SocketHandoff::TakeListener(uint16 p_Port)
+    {
+        Utils::ObjectGuard l_Guard(this);
+
+        for (auto l_Itr = m_Listeners.begin(); l_Itr != m_Listeners.end(); ++l_Itr)
+        {
+            if (l_Itr->first != p_Port)
+                continue;
+
+            const int l_Descriptor = l_Itr->second;
+            m_Listeners.erase(l_Itr);
+
+            return l_Descriptor;
+        }
+
+        return -1;
+    }
+    /// Take connections accepted on port
+    /// @p_Port : Port
+    std::vector<HandoffConnection> SocketHandoff::TakeConnections(uint16 p_Port)
+    {
+        Utils::ObjectGuard l_Guard(this);
+
+        std::vector<HandoffConnection> l_Connections;
+
+        for (auto l_Itr = m_Connections.begin(); l_Itr != m_Connections.end();)
+        {
+            if (l_Itr->Port != p_Port)
+            {
+                ++l_Itr;
+                continue;
+            }
+
+            l_Connections.push_back(std::move(*l_Itr));
+            l_Itr = m_Connections.erase(l_Itr);
+        }
+
+        return l_Connections;
+    }
+
+    /// Wait for a new process on path, once it connects p_Collect fills us and everything is sent over
+    /// @p_Path    : Path of unix socket
+    /// @p_Collect : Add listeners and connections to hand over
+    /// @p_Done    : Called once everything has been sent, the old process should shut down
+    bool SocketHandoff::Serve(std::string const& p_Path, std::function<void(SocketHandoff&)> p_Collect, std::function<void()> p_Done)
+    {
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+        /// Held until our task is pushed, it must not end before m_Task has been set
+        Utils::ObjectGuard l_Guard(this);
+
+        if (m_Task)
+            return false;
+
+        /// A previous process may have left its socket behind, it is still served on its own descriptor if it is alive
+        unlink(p_Path.c_str());
+
+        /// A previous run of ours belongs to the old IO service
+        m_Peer.reset();
+        m_Acceptor.reset();
+        m_Service.reset(new boost::asio::io_service());
+        m_Peer.reset(new boost::asio::local::stream_protocol::socket(*m_Service));
+
+        try
+        {
+            const boost::asio::local::stream_protocol::endpoint l_EndPoint(p_Path);
+
+            /// Only our user may connect, the path is restricted before anyone can connect to it
+            m_Acceptor.reset(new boost::asio::local::stream_protocol::acceptor(*m_Service));
+            m_Acceptor->open(l_EndPoint.protocol());
+            m_Acceptor->bind(l_EndPoint);
+
+            if (chmod(p_Path.c_str(), S_IRUSR | S_IWUSR) != 0)
+                throw boost::system::system_error(errno, boost::system::system_category(), "chmod");
+
+            m_Acceptor->listen();
+        }
+        catch (boost::system::system_error const& p_Error)
+        {
+            LOG_ERROR("SocketHandoff", "Failed to serve handoff on %0: %1", p_Path, p_Error.what());
+            m_Acceptor.reset();
+            m_Peer.reset();
+            m_Service.reset();
+            unlink(p_Path.c_str());
+            return false;
+        }
+
+        Accept(p_Collect, p_Done);
+
+        m_Stopped = std::promise<void>();
+        m_Task = sThreadManager->PushTask("SOCKET_HANDOFF", Threading::TaskType::Dedicated, 0, [this]() -> bool
+        {
+            this->m_Service->run();
+
+            /// Nothing is left to serve, ending the task retires our worker from its own thread and Serve may be called again
+            Utils::ObjectGuard l_Guard(this);
+
+            m_Task.reset();
+            m_Stopped.set_value();
+            return false;
+        });
+
+        return true;
+#else
+        LOG_ERROR("SocketHandoff", "Socket handoff is not supported on this platform");
+        return false;
+#endif
+    }
+    /// Add listening descriptor to hand over, we take ownership
+    /// @p_Port       : Port
+    /// @p_Descriptor : Listening descriptor
+    void SocketHandoff::AddListener(uint16 p_Port, int p_Descriptor)
+    {
+        Utils::ObjectGuard l_Guard(this);
+
+        m_Listeners.push_back(std::make_pair(p_Port, p_Descriptor));
+    }
+    /// Add connection to hand over, we take ownership of its descriptor
+    /// @p_Connection : Connection
+    void SocketHandoff::AddConnection(HandoffConnection&& p_Connection)
+    {
+        Utils::ObjectGuard l_Guard(this);
+
+        m_Connections.push_back(std::move(p_Connection));
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Wait for the new process, a process running as another user is refused and we keep waiting
+    /// @p_Collect : Add listeners and connections to hand over
+    /// @p_Done    : Called once everything has been sent
+    void SocketHandoff::Accept(std::function<void(SocketHandoff&)> p_Collect, std::function<void()> p_Done)
+    {
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+        m_Acceptor->async_accept(*m_Peer, [this, p_Collect, p_Done](boost::system::error_code const& p_ErrorCode)
+        {
+            if (p_ErrorCode)
+            {
+                if (p_ErrorCode != boost::asio::error::operation_aborted)
+                    LOG_ERROR("SocketHandoff", "Failed to accept new process: %0", p_ErrorCode.message());
+
+                return;
+            }
+
+            boost::system::error_code l_ErrorCode;
+
+            if (!IsPeerTrusted(m_Peer->native_handle()))
+            {
+                LOG_ERROR("SocketHandoff", "Refused handoff to a process running as another user");
+                m_Peer->close(l_ErrorCode);
+                Accept(p_Collect, p_Done);
+                return;
+            }
+
+            m_Acceptor->close(l_ErrorCode);
+
+            LOG_INFO("SocketHandoff", "New process connected, handing over descriptors");
+
+            p_Collect(*this);
+
+            /// The kernel has duplicated every descriptor into the new process once it has been sent
+            const bool l_Sent = SendAll(m_Peer->native_handle());
+            CloseAll();
+            m_Peer->close(l_ErrorCode);
+
+            if (!l_Sent)
+            {
+                LOG_ERROR("SocketHandoff", "Failed to hand over descriptors, new process has gone away");
+                return;
+            }
+
+            if (p_Done)
+                p_Done();
+        });
+#endif
+    }
+    /// Send everything we hold
+    /// @p_Descriptor : Connected unix socket
+    bool SocketHandoff::SendAll(int p_Descriptor)
+    {
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+        Utils::ObjectGuard l_Guard(this);
+
+        /// Our peer reads blocking
+        boost::system::error_code l_ErrorCode;
+        m_Peer->non_blocking(false, l_ErrorCode);
+
+        for (auto const& l_Listener : m_Listeners)
+        {
+            HandoffHeader l_Header = { SOCKET_HANDOFF_LISTENER, l_Listener.first, 0, 0 };
+
+            if (!SendMessage(p_Descriptor, l_Header, l_Listener.second))
+                return false;
+        }
+
+        for (HandoffConnection const& l_Connection : m_Connections)
+        {
+            HandoffHeader l_Header = { SOCKET_HANDOFF_CONNECTION, l_Connection.Port, static_cast<uint32>(l_Connection.InData.size()), static_cast<uint32>(l_Connection.State.size()) };
+
+            if (!SendMessage(p_Descriptor, l_Header, l_Connection.Descriptor)
+                || !WriteAll(p_Descriptor, l_Connection.InData.data(), l_Connection.InData.size())
+                || !WriteAll(p_Descriptor, l_Connection.State.data(), l_Connection.State.size()))
+                return false;
+        }
+
+        HandoffHeader l_Header = { SOCKET_HANDOFF_END, 0, 0, 0 };
+        if (!SendMessage(p_Descriptor, l_Header, -1))
+            return false;
+
+        LOG_INFO("SocketHandoff", "Handed over %0 listeners and %1 connections", m_Listeners.size(), m_Connections.size());
+        return true;
+#else
+        return false;
+#endif
+    }
+    /// Close every descriptor we hold
+    void SocketHandoff::CloseAll()
+    {
+        Utils::ObjectGuard l_Guard(this);
+
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+        for (auto const& l_Listener : m_Listeners)
+            close(l_Listener.second);
+
+        for (HandoffConnection const& l_Connection : m_Connections)
+        {
+            if (l_Connection.Descriptor >= 0)
+                close(l_Connection.Descriptor);
+        }
+#endif
+
+        m_Listeners.clear();
+        m_Connections.clear();
+    }
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
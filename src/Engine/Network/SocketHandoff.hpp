@@ -0,0 +1,126 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <boost/asio.hpp>
+#include <functional>
+#include <future>
+
+#include "Core/Core.hpp"
+#include "Threading/ThrTaskManager.hpp"
+#include "Utility/UtiObjectGuard.hpp"
+#include "Utility/UtiLockable.hpp"
+
+#define SOCKET_HANDOFF_MAX_IN_DATA      (1024 * 1024)   ///< Maximum unread incoming data of a handed over connection
+#define SOCKET_HANDOFF_MAX_STATE        (64 * 1024)     ///< Maximum session state of a handed over connection
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Connection handed over to a new process
+    struct HandoffConnection
+    {
+        HandoffConnection()
+            : Port(0), Descriptor(-1)
+        {
+        }
+
+        uint16 Port;                            ///< Local port connection has been accepted on
+        int Descriptor;                         ///< Descriptor, -1 once it has been taken
+        std::vector<uint8> InData;              ///< Unread incoming data, usually a partially recieved frame
+        std::vector<uint8> State;               ///< Session state saved by the socket
+    };
+
+    /// Zero downtime restart, the old process hands its listening descriptors and optionally its
+    /// established connections to the new process over a unix socket with SCM_RIGHTS
+    ///
+    /// New process : Receive() before listeners are created, listeners take their descriptors
+    /// Old process : Serve() waits for the new process, collects descriptors and sends them over
+    class SocketHandoff : private Utils::Lockable
+    {
+        /// Allow access to lock / unlock methods
+        friend class Utils::ObjectGuard<SocketHandoff>;
+
+        DISALLOW_COPY_AND_ASSIGN(SocketHandoff);
+
+        public:
+            /// Get protocol of descriptor
+            /// @p_Descriptor : Socket descriptor
+            static boost::asio::ip::tcp GetProtocol(int p_Descriptor);
+
+        public:
+            /// Constructor
+            SocketHandoff();
+            /// Deconstructor, closes every descriptor which has not been taken
+            ~SocketHandoff();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Receive descriptors from the process serving on path, blocks until everything has been received
+            /// @p_Path : Path of unix socket
+            /// Returns false if no process is serving on path
+            bool Receive(std::string const& p_Path);
+            /// Take listening descriptor of port
+            /// @p_Port : Port
+            /// Returns -1 if port has not been handed over
+            int TakeListener(uint16 p_Port);
+            /// Take connections accepted on port
+            /// @p_Port : Port
+            std::vector<HandoffConnection> TakeConnections(uint16 p_Port);
+
+            /// Wait for a new process on path, once it connects p_Collect fills us and everything is sent over
+            /// @p_Path    : Path of unix socket
+            /// @p_Collect : Add listeners and connections to hand over
+            /// @p_Done    : Called once everything has been sent, the old process should shut down
+            bool Serve(std::string const& p_Path, std::function<void(SocketHandoff&)> p_Collect, std::function<void()> p_Done);
+            /// Add listening descriptor to hand over, we take ownership
+            /// @p_Port       : Port
+            /// @p_Descriptor : Listening descriptor
+            void AddListener(uint16 p_Port, int p_Descriptor);
+            /// Add connection to hand over, we take ownership of its descriptor
+            /// @p_Connection : Connection
+            void AddConnection(HandoffConnection&& p_Connection);
+
+        private:
+            /// Wait for the new process, a process running as another user is refused and we keep waiting
+            /// @p_Collect : Add listeners and connections to hand over
+            /// @p_Done    : Called once everything has been sent
+            void Accept(std::function<void(SocketHandoff&)> p_Collect, std::function<void()> p_Done);
+            /// Send everything we hold
+            /// @p_Descriptor : Connected unix socket
+            bool SendAll(int p_Descriptor);
+            /// Close every descriptor we hold
+            void CloseAll();
+
+        private:
+            std::vector<std::pair<uint16, int>> m_Listeners;                        ///< Listening descriptors by port
+            std::vector<HandoffConnection> m_Connections;                           ///< Connections
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+            std::unique_ptr<boost::asio::io_service> m_Service;                     ///< IO Service of our serving task
+            std::unique_ptr<boost::asio::local::stream_protocol::acceptor> m_Acceptor; ///< Acceptor of new process
+            std::unique_ptr<boost::asio::local::stream_protocol::socket> m_Peer;    ///< New process
+            Threading::Task::Ptr m_Task;                                            ///< Serving task, nullptr once it ended
+            std::promise<void> m_Stopped;                                           ///< Set once our serving task ended
+#endif
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
@@ -0,0 +1,261 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <chrono>
+
+#include "TimerWheel.hpp"
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Constructor
+    TimerWheelEntry::TimerWheelEntry()
+        : m_Prev(nullptr), m_Next(nullptr), m_Head(nullptr), m_Wheel(nullptr), m_Expiry(0)
+    {
+    }
+    /// Deconstructor
+    TimerWheelEntry::~TimerWheelEntry()
+    {
+        if (m_Wheel)
+            m_Wheel->Cancel(*this);
+    }
+
+    /// Set function called when timer expires, called on the thread driving the wheel
+    /// @p_Callback : Function to call
+    void TimerWheelEntry::SetCallback(std::function<void()> p_Callback)
+    {
+        m_Callback = std::move(p_Callback);
+    }
+    /// Check if timer is scheduled
+    bool TimerWheelEntry::IsScheduled() const
+    {
+        return m_Wheel != nullptr;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    /// @p_Tick : Resolution in milliseconds
+    TimerWheel::TimerWheel(uint32 p_Tick)
+        : m_Tick(0), m_Resolution(p_Tick ? p_Tick : 1), m_Start(std::chrono::steady_clock::now()), m_Size(0)
+    {
+        for (uint32 l_Level = 0; l_Level < TIMER_WHEEL_LEVELS; l_Level++)
+            for (uint32 l_Slot = 0; l_Slot < TIMER_WHEEL_SLOTS; l_Slot++)
+                m_Slots[l_Level][l_Slot] = nullptr;
+    }
+    /// Deconstructor
+    TimerWheel::~TimerWheel()
+    {
+        Utils::ObjectGuard l_Guard(this);
+
+        /// Detach remaining entries so they don't try to cancel themselves later on
+        for (uint32 l_Level = 0; l_Level < TIMER_WHEEL_LEVELS; l_Level++)
+        {
+            for (uint32 l_Slot = 0; l_Slot < TIMER_WHEEL_SLOTS; l_Slot++)
+            {
+                while (m_Slots[l_Level][l_Slot])
+                    Unlink(*m_Slots[l_Level][l_Slot]);
+            }
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Schedule timer, reschedules if already scheduled
+    /// @p_Entry : Timer to schedule
+    /// @p_Delay : Milliseconds until timer expires, rounded up to our resolution
+    /// @p_Owner : Owner of timer, timer does not fire once owner has been destroyed
+    void TimerWheel::Schedule(TimerWheelEntry& p_Entry, uint32 p_Delay, std::weak_ptr<void> p_Owner)
+    {
+        Utils::ObjectGuard l_Guard(this);
+
+        if (p_Entry.m_Wheel)
+            Unlink(p_Entry);
+
+        const uint64 l_Ticks = std::max<uint64>(1, (static_cast<uint64>(p_Delay) + m_Resolution - 1) / m_Resolution);
+
+        p_Entry.m_Expiry    = m_Tick + l_Ticks;
+        p_Entry.m_Owner     = std::move(p_Owner);
+
+        Link(p_Entry);
+    }
+    /// Cancel timer
+    /// @p_Entry : Timer to cancel
+    /// Returns true if timer was scheduled
+    bool TimerWheel::Cancel(TimerWheelEntry& p_Entry)
+    {
+        Utils::ObjectGuard l_Guard(this);
+
+        if (p_Entry.m_Wheel != this)
+            return false;
+
+        Unlink(p_Entry);
+        return true;
+    }
+
+    /// Fire every timer which expired, must be called every tick
+    void TimerWheel::Update()
+    {
+        const uint64 l_Target = GetCurrentTick();
+
+        /// Expired timers hold a strong reference to their owner so they can't be destroyed while firing,
+        /// callbacks run without our lock as they usually schedule again
+        std::vector<std::pair<TimerWheelEntry*, std::shared_ptr<void>>>& l_Expired = m_Expired;
+
+        {
+            Utils::ObjectGuard l_Guard(this);
+
+            while (m_Tick < l_Target)
+            {
+                m_Tick++;
+
+                const uint32 l_Slot = m_Tick & (TIMER_WHEEL_SLOTS - 1);
+
+                /// Lowest level wrapped, bring timers of higher levels closer
+                if (l_Slot == 0)
+                {
+                    for (uint32 l_Level = 1; l_Level < TIMER_WHEEL_LEVELS; l_Level++)
+                    {
+                        const uint32 l_LevelSlot = (m_Tick >> (TIMER_WHEEL_SLOT_BITS * l_Level)) & (TIMER_WHEEL_SLOTS - 1);
+
+                        Cascade(l_Level, l_LevelSlot);
+
+                        if (l_LevelSlot != 0)
+                            break;
+                    }
+                }
+
+                while (m_Slots[0][l_Slot])
+                {
+                    TimerWheelEntry* l_Entry = m_Slots[0][l_Slot];
+                    Unlink(*l_Entry);
+
+                    std::shared_ptr<void> l_Owner = l_Entry->m_Owner.lock();
+                    if (l_Owner)
+                        l_Expired.emplace_back(l_Entry, std::move(l_Owner));
+                }
+            }
+        }
+
+        for (auto& l_Timer : l_Expired)
+        {
+            if (l_Timer.first->m_Callback)
+                l_Timer.first->m_Callback();
+        }
+
+        l_Expired.clear();
+    }
+
+    /// Get resolution in milliseconds
+    uint32 TimerWheel::GetTick() const
+    {
+        return m_Resolution;
+    }
+    /// Get amount of scheduled timers
+    std::size_t TimerWheel::GetSize() const
+    {
+        return m_Size;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Link entry into slot of its expiry, must be called while holding our lock
+    /// @p_Entry : Timer to link
+    void TimerWheel::Link(TimerWheelEntry& p_Entry)
+    {
+        /// Cascaded timers may expire on the tick being processed, it is fired right after cascading
+        const uint64 l_Expiry = std::max(p_Entry.m_Expiry, m_Tick);
+
+        /// Pick the lowest level whose current rotation still contains the expiry,
+        /// the slot is then always ahead of the current position of that level
+        uint32 l_Level = 0;
+        while (l_Level < TIMER_WHEEL_LEVELS && (l_Expiry >> (TIMER_WHEEL_SLOT_BITS * (l_Level + 1))) != (m_Tick >> (TIMER_WHEEL_SLOT_BITS * (l_Level + 1))))
+            l_Level++;
+
+        uint32 l_Slot = 0;
+
+        if (l_Level < TIMER_WHEEL_LEVELS)
+            l_Slot = (l_Expiry >> (TIMER_WHEEL_SLOT_BITS * l_Level)) & (TIMER_WHEEL_SLOTS - 1);
+        else
+        {
+            /// Further away than our wheel covers, park it in the last slot of the highest level, it is linked again once cascaded
+            l_Level = TIMER_WHEEL_LEVELS - 1;
+            l_Slot  = TIMER_WHEEL_SLOTS - 1;
+        }
+
+        TimerWheelEntry*& l_Head = m_Slots[l_Level][l_Slot];
+
+        p_Entry.m_Prev  = nullptr;
+        p_Entry.m_Next  = l_Head;
+        p_Entry.m_Head  = &l_Head;
+        p_Entry.m_Wheel = this;
+
+        if (l_Head)
+            l_Head->m_Prev = &p_Entry;
+
+        l_Head = &p_Entry;
+        m_Size++;
+    }
+    /// Unlink entry from its slot, must be called while holding our lock
+    /// @p_Entry : Timer to unlink
+    void TimerWheel::Unlink(TimerWheelEntry& p_Entry)
+    {
+        if (p_Entry.m_Prev)
+            p_Entry.m_Prev->m_Next = p_Entry.m_Next;
+        else
+            *p_Entry.m_Head = p_Entry.m_Next;
+
+        if (p_Entry.m_Next)
+            p_Entry.m_Next->m_Prev = p_Entry.m_Prev;
+
+        p_Entry.m_Prev  = nullptr;
+        p_Entry.m_Next  = nullptr;
+        p_Entry.m_Head  = nullptr;
+        p_Entry.m_Wheel = nullptr;
+        m_Size--;
+    }
+    /// Move entries of a higher level slot down to lower levels
+    /// @p_Level : Level of slot
+    /// @p_Slot  : Slot index
+    void TimerWheel::Cascade(uint32 p_Level, uint32 p_Slot)
+    {
+        TimerWheelEntry* l_Entry = m_Slots[p_Level][p_Slot];
+        m_Slots[p_Level][p_Slot] = nullptr;
+
+        while (l_Entry)
+        {
+            TimerWheelEntry* l_Next = l_Entry->m_Next;
+
+            m_Size--;
+            l_Entry->m_Wheel = nullptr;
+            Link(*l_Entry);
+
+            l_Entry = l_Next;
+        }
+    }
+    /// Get current tick from steady clock
+    uint64 TimerWheel::GetCurrentTick() const
+    {
+        return static_cast<uint64>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_Start).count()) / m_Resolution;
+    }
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
@@ -0,0 +1,130 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include <chrono>
+#include <memory>
+
+#include "Core/Core.hpp"
+#include "Utility/UtiObjectGuard.hpp"
+#include "Utility/UtiLockable.hpp"
+
+#define TIMER_WHEEL_LEVELS      4
+#define TIMER_WHEEL_SLOT_BITS   6
+#define TIMER_WHEEL_SLOTS       (1 << TIMER_WHEEL_SLOT_BITS)
+#define TIMER_WHEEL_TICK        10      ///< Default resolution in milliseconds
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    class TimerWheel;
+
+    /// Timer registered in a TimerWheel, usually a member of its owner
+    /// Scheduling and cancelling does not allocate, the entry is linked into a wheel slot
+    class TimerWheelEntry
+    {
+        DISALLOW_COPY_AND_ASSIGN(TimerWheelEntry);
+
+        friend class TimerWheel;
+
+        public:
+            /// Constructor
+            TimerWheelEntry();
+            /// Deconstructor
+            ~TimerWheelEntry();
+
+            /// Set function called when timer expires, called on the thread driving the wheel
+            /// @p_Callback : Function to call
+            void SetCallback(std::function<void()> p_Callback);
+            /// Check if timer is scheduled
+            bool IsScheduled() const;
+
+        private:
+            TimerWheelEntry* m_Prev;                    ///< Previous entry in slot
+            TimerWheelEntry* m_Next;                    ///< Next entry in slot
+            TimerWheelEntry** m_Head;                   ///< Head of slot we are linked in
+            TimerWheel* m_Wheel;                        ///< Wheel we are scheduled in
+            uint64 m_Expiry;                            ///< Tick at which timer expires
+            std::weak_ptr<void> m_Owner;                ///< Owner, kept alive while callback runs
+            std::function<void()> m_Callback;           ///< Function called when timer expires
+    };
+
+    /// Hierarchical timer wheel, O(1) schedule and cancel
+    /// Driven by a single periodic timer of the thread which owns it
+    class TimerWheel : private Utils::Lockable
+    {
+        DISALLOW_COPY_AND_ASSIGN(TimerWheel);
+
+        /// Allow access to lock / unlock methods
+        friend class Utils::ObjectGuard<TimerWheel>;
+
+        public:
+            /// Constructor
+            /// @p_Tick : Resolution in milliseconds
+            explicit TimerWheel(uint32 p_Tick = TIMER_WHEEL_TICK);
+            /// Deconstructor
+            ~TimerWheel();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Schedule timer, reschedules if already scheduled
+            /// @p_Entry : Timer to schedule
+            /// @p_Delay : Milliseconds until timer expires, rounded up to our resolution
+            /// @p_Owner : Owner of timer, timer does not fire once owner has been destroyed
+            void Schedule(TimerWheelEntry& p_Entry, uint32 p_Delay, std::weak_ptr<void> p_Owner);
+            /// Cancel timer
+            /// @p_Entry : Timer to cancel
+            /// Returns true if timer was scheduled
+            bool Cancel(TimerWheelEntry& p_Entry);
+
+            /// Fire every timer which expired, must be called every tick
+            void Update();
+
+            /// Get resolution in milliseconds
+            uint32 GetTick() const;
+            /// Get amount of scheduled timers
+            std::size_t GetSize() const;
+
+        private:
+            /// Link entry into slot of its expiry, must be called while holding our lock
+            /// @p_Entry : Timer to link
+            void Link(TimerWheelEntry& p_Entry);
+            /// Unlink entry from its slot, must be called while holding our lock
+            /// @p_Entry : Timer to unlink
+            void Unlink(TimerWheelEntry& p_Entry);
+            /// Move entries of a higher level slot down to lower levels
+            /// @p_Level : Level of slot
+            /// @p_Slot  : Slot index
+            void Cascade(uint32 p_Level, uint32 p_Slot);
+            /// Get current tick from steady clock
+            uint64 GetCurrentTick() const;
+
+        private:
+            TimerWheelEntry* m_Slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];        ///< Slots, head of each entry list
+            uint64 m_Tick;                                                          ///< Last processed tick
+            uint32 const m_Resolution;                                              ///< Resolution in milliseconds
+            std::chrono::steady_clock::time_point const m_Start;                    ///< Time wheel was created
+            std::size_t m_Size;                                                     ///< Amount of scheduled timers
+            std::vector<std::pair<TimerWheelEntry*, std::shared_ptr<void>>> m_Expired; ///< Timers being fired, reused between updates
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
@@ -0,0 +1,480 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <PCH/Precompiled.hpp>
+
+#include "Threading/ThrCPUTopology.hpp"
+
+#include "Logger/Base.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <thread>
+
+#if defined(_WIN32)
+#   include <windows.h>
+#elif defined(linux)
+#   include <sched.h>
+#   include <dirent.h>
+#endif
+
+namespace SteerStone { namespace Core { namespace Threading {
+
+    SINGLETON_P_I(CPUTopology);
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+#if defined(linux)
+    /// Read first line of a sysfs file
+    /// @p_Path : File path
+    /// @p_Line : Line read
+    static bool ReadSysFile(std::string const& p_Path, std::string& p_Line)
+    {
+        std::ifstream l_File(p_Path);
+
+        if (!l_File.is_open() || !std::getline(l_File, p_Line))
+            return false;
+
+        return true;
+    }
+    /// Read integer from a sysfs file
+    /// @p_Path    : File path
+    /// @p_Default : Value returned if file cannot be read
+    static uint32 ReadSysInt(std::string const& p_Path, uint32 p_Default)
+    {
+        std::string l_Line;
+
+        if (!ReadSysFile(p_Path, l_Line))
+            return p_Default;
+
+        char* l_End = nullptr;
+        const long l_Value = std::strtol(l_Line.c_str(), &l_End, 10);
+
+        /// Offline or virtual CPUs report -1
+        return (l_End == l_Line.c_str() || l_Value < 0) ? p_Default : static_cast<uint32>(l_Value);
+    }
+#endif
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    CPUTopology::CPUTopology()
+        : m_PackageCount(0), m_NodeCount(0), m_CoreCount(0), m_CPUQuota(0)
+    {
+        Discover();
+        BuildPlacementOrder();
+        DiscoverQuota();
+
+        LOG_INFO("ThrCPUTopology", "%0 logical CPUs (%1) on %2 physical cores, %3 packages and %4 NUMA nodes",
+            m_CPUs.size(), FormatCPUList(m_PlacementOrder), m_CoreCount, m_PackageCount, m_NodeCount);
+
+        if (m_CPUQuota)
+            LOG_INFO("ThrCPUTopology", "CPU quota of %0 CPUs", m_CPUQuota);
+    }
+    /// Destructor
+    CPUTopology::~CPUTopology()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Parse CPU list in "0-3,8,10-11" format
+    /// @p_List : CPU list
+    /// @p_CPUs : Parsed CPU ids, sorted and unique
+    /// Returns false if list is malformed
+    bool CPUTopology::ParseCPUList(std::string const& p_List, std::vector<uint32>& p_CPUs)
+    {
+        p_CPUs.clear();
+
+        const char* l_Cursor = p_List.c_str();
+
+        while (*l_Cursor)
+        {
+            while (*l_Cursor == ' ')
+                ++l_Cursor;
+
+            char* l_End = nullptr;
+            const unsigned long l_First = std::strtoul(l_Cursor, &l_End, 10);
+
+            if (l_End == l_Cursor)
+                return false;
+
+            unsigned long l_Last = l_First;
+            l_Cursor = l_End;
+
+            if (*l_Cursor == '-')
+            {
+                ++l_Cursor;
+                l_Last = std::strtoul(l_Cursor, &l_End, 10);
+
+                if (l_End == l_Cursor || l_Last < l_First)
+                    return false;
+
+                l_Cursor = l_End;
+            }
+
+            for (unsigned long l_CPU = l_First; l_CPU <= l_Last; ++l_CPU)
+                p_CPUs.push_back(static_cast<uint32>(l_CPU));
+
+            while (*l_Cursor == ' ')
+                ++l_Cursor;
+
+            if (*l_Cursor == ',')
+                ++l_Cursor;
+            else if (*l_Cursor)
+                return false;
+        }
+
+        std::sort(p_CPUs.begin(), p_CPUs.end());
+        p_CPUs.erase(std::unique(p_CPUs.begin(), p_CPUs.end()), p_CPUs.end());
+
+        return !p_CPUs.empty();
+    }
+    /// Format CPU ids in "0-3,8,10-11" format
+    /// @p_CPUs : CPU ids
+    std::string CPUTopology::FormatCPUList(std::vector<uint32> p_CPUs)
+    {
+        std::sort(p_CPUs.begin(), p_CPUs.end());
+        p_CPUs.erase(std::unique(p_CPUs.begin(), p_CPUs.end()), p_CPUs.end());
+
+        std::string l_List;
+
+        for (std::size_t l_I = 0; l_I < p_CPUs.size();)
+        {
+            std::size_t l_Last = l_I;
+            while (l_Last + 1 < p_CPUs.size() && p_CPUs[l_Last + 1] == p_CPUs[l_Last] + 1)
+                ++l_Last;
+
+            if (!l_List.empty())
+                l_List += ',';
+
+            l_List += std::to_string(p_CPUs[l_I]);
+            if (l_Last != l_I)
+                l_List += '-' + std::to_string(p_CPUs[l_Last]);
+
+            l_I = l_Last + 1;
+        }
+
+        return l_List;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get logical CPUs
+    std::vector<LogicalCPU> const& CPUTopology::GetCPUs() const
+    {
+        return m_CPUs;
+    }
+    /// Get logical CPU
+    /// @p_Id : CPU id, nullptr if process may not run on it
+    LogicalCPU const* CPUTopology::GetCPU(uint32 p_Id) const
+    {
+        auto l_It = std::lower_bound(m_CPUs.begin(), m_CPUs.end(), p_Id, [](LogicalCPU const& p_CPU, uint32 p_Value) -> bool {
+            return p_CPU.Id < p_Value;
+        });
+
+        return (l_It != m_CPUs.end() && l_It->Id == p_Id) ? &(*l_It) : nullptr;
+    }
+    /// Get amount of physical packages
+    uint32 CPUTopology::GetPackageCount() const
+    {
+        return m_PackageCount;
+    }
+    /// Get amount of NUMA nodes
+    uint32 CPUTopology::GetNodeCount() const
+    {
+        return m_NodeCount;
+    }
+    /// Get amount of physical cores
+    uint32 CPUTopology::GetCoreCount() const
+    {
+        return m_CoreCount;
+    }
+    /// Get CPUs granted by the cgroup CPU quota of the process rounded up, 0 if it has no quota
+    uint32 CPUTopology::GetCPUQuota() const
+    {
+        return m_CPUQuota;
+    }
+    /// Get amount of CPUs the process can keep busy : CPUs it may run on, capped by its CPU quota
+    uint32 CPUTopology::GetUsableCPUCount() const
+    {
+        const uint32 l_Count = static_cast<uint32>(m_CPUs.size());
+
+        return m_CPUQuota ? std::min(l_Count, m_CPUQuota) : l_Count;
+    }
+
+    /// Get ids of the CPUs of a NUMA node
+    /// @p_Node : Node index
+    std::vector<uint32> CPUTopology::GetNodeCPUs(uint32 p_Node) const
+    {
+        std::vector<uint32> l_CPUs;
+
+        for (auto const& l_CPU : m_CPUs)
+        {
+            if (l_CPU.Node == p_Node)
+                l_CPUs.push_back(l_CPU.Id);
+        }
+
+        return l_CPUs;
+    }
+    /// Get node every CPU of the set belongs to
+    /// @p_CPUs : CPU ids
+    /// Returns -1 if set is empty or spans several nodes
+    int32 CPUTopology::GetNodeOf(std::vector<uint32> const& p_CPUs) const
+    {
+        int32 l_Node = -1;
+
+        for (uint32 l_Id : p_CPUs)
+        {
+            LogicalCPU const* l_CPU = GetCPU(l_Id);
+
+            if (!l_CPU || (l_Node != -1 && l_Node != static_cast<int32>(l_CPU->Node)))
+                return -1;
+
+            l_Node = static_cast<int32>(l_CPU->Node);
+        }
+
+        return l_Node;
+    }
+    /// Get CPU ids in placement order : one hardware thread per physical core first, then their SMT siblings,
+    /// nodes are interleaved so consecutive placements spread over memory controllers
+    std::vector<uint32> const& CPUTopology::GetPlacementOrder() const
+    {
+        return m_PlacementOrder;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Discover topology of the host, fall back to one node of independent cores when it cannot be read
+    void CPUTopology::Discover()
+    {
+        m_CPUs.clear();
+
+        /// Raw ids reported by the OS, made dense once every CPU is known
+        struct RawCPU
+        {
+            uint32 Id;
+            uint32 Package;
+            uint32 Node;
+            uint64 Core;
+        };
+        std::vector<RawCPU> l_RawCPUs;
+
+#if defined(_WIN32)
+        DWORD l_Length = 0;
+        GetLogicalProcessorInformation(nullptr, &l_Length);
+
+        std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> l_Infos(l_Length / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+
+        DWORD_PTR l_ProcessMask = 0;
+        DWORD_PTR l_SystemMask  = 0;
+
+        if (!l_Infos.empty() && GetLogicalProcessorInformation(l_Infos.data(), &l_Length) && GetProcessAffinityMask(GetCurrentProcess(), &l_ProcessMask, &l_SystemMask))
+        {
+            std::map<uint32, RawCPU> l_ById;
+            uint32 l_CoreIndex      = 0;
+            uint32 l_PackageIndex   = 0;
+
+            for (uint32 l_Bit = 0; l_Bit < sizeof(DWORD_PTR) * 8; ++l_Bit)
+            {
+                if (l_ProcessMask & (static_cast<DWORD_PTR>(1) << l_Bit))
+                    l_ById[l_Bit] = { l_Bit, 0, 0, l_Bit };
+            }
+
+            for (auto const& l_Info : l_Infos)
+            {
+                for (auto& l_Pair : l_ById)
+                {
+                    if (!(l_Info.ProcessorMask & (static_cast<DWORD_PTR>(1) << l_Pair.first)))
+                        continue;
+
+                    if (l_Info.Relationship == RelationProcessorCore)
+                        l_Pair.second.Core = l_CoreIndex;
+                    else if (l_Info.Relationship == RelationProcessorPackage)
+                        l_Pair.second.Package = l_PackageIndex;
+                    else if (l_Info.Relationship == RelationNumaNode)
+                        l_Pair.second.Node = l_Info.NumaNode.NodeNumber;
+                }
+
+                if (l_Info.Relationship == RelationProcessorCore)
+                    ++l_CoreIndex;
+                else if (l_Info.Relationship == RelationProcessorPackage)
+                    ++l_PackageIndex;
+            }
+
+            for (auto const& l_Pair : l_ById)
+                l_RawCPUs.push_back(l_Pair.second);
+        }
+#elif defined(linux)
+        cpu_set_t l_Allowed;
+        CPU_ZERO(&l_Allowed);
+
+        if (sched_getaffinity(0, sizeof(cpu_set_t), &l_Allowed) == 0)
+        {
+            /// NUMA node of each CPU, kernels without NUMA support have no node directory
+            std::map<uint32, uint32> l_NodeOf;
+
+            if (DIR* l_Directory = opendir("/sys/devices/system/node"))
+            {
+                while (dirent* l_Entry = readdir(l_Directory))
+                {
+                    uint32 l_Node = 0;
+                    std::string l_List;
+                    std::vector<uint32> l_NodeCPUs;
+
+                    if (std::sscanf(l_Entry->d_name, "node%u", &l_Node) != 1)
+                        continue;
+
+                    if (!ReadSysFile(Utils::StringBuilder("/sys/devices/system/node/%0/cpulist", l_Entry->d_name), l_List) || !ParseCPUList(l_List, l_NodeCPUs))
+                        continue;
+
+                    for (uint32 l_CPU : l_NodeCPUs)
+                        l_NodeOf[l_CPU] = l_Node;
+                }
+
+                closedir(l_Directory);
+            }
+
+            for (uint32 l_Id = 0; l_Id < CPU_SETSIZE; ++l_Id)
+            {
+                if (!CPU_ISSET(l_Id, &l_Allowed))
+                    continue;
+
+                const std::string l_Path = Utils::StringBuilder("/sys/devices/system/cpu/cpu%0/topology/", l_Id);
+                const uint32 l_Package   = ReadSysInt(l_Path + "physical_package_id", 0);
+                const uint32 l_Core      = ReadSysInt(l_Path + "core_id", l_Id);
+
+                auto l_Node = l_NodeOf.find(l_Id);
+
+                /// Core ids are only unique inside a package
+                l_RawCPUs.push_back({ l_Id, l_Package, l_Node != l_NodeOf.end() ? l_Node->second : 0, (static_cast<uint64>(l_Package) << 32) | l_Core });
+            }
+        }
+#endif
+
+        if (l_RawCPUs.empty())
+        {
+            const uint32 l_Count = std::max<uint32>(std::thread::hardware_concurrency(), 1);
+
+            for (uint32 l_Id = 0; l_Id < l_Count; ++l_Id)
+                l_RawCPUs.push_back({ l_Id, 0, 0, l_Id });
+        }
+
+        std::map<uint32, uint32> l_Packages;
+        std::map<uint32, uint32> l_Nodes;
+        std::map<uint64, uint32> l_Cores;
+        std::map<uint32, uint32> l_Siblings;
+
+        for (auto const& l_Raw : l_RawCPUs)
+        {
+            l_Packages.emplace(l_Raw.Package, static_cast<uint32>(l_Packages.size()));
+            l_Nodes.emplace(l_Raw.Node, static_cast<uint32>(l_Nodes.size()));
+            l_Cores.emplace(l_Raw.Core, static_cast<uint32>(l_Cores.size()));
+        }
+
+        /// Raw CPUs are sorted by id, siblings are numbered in id order
+        for (auto const& l_Raw : l_RawCPUs)
+        {
+            const uint32 l_Core = l_Cores[l_Raw.Core];
+            m_CPUs.push_back({ l_Raw.Id, l_Packages[l_Raw.Package], l_Nodes[l_Raw.Node], l_Core, l_Siblings[l_Core]++ });
+        }
+
+        m_PackageCount  = static_cast<uint32>(l_Packages.size());
+        m_NodeCount     = static_cast<uint32>(l_Nodes.size());
+        m_CoreCount     = static_cast<uint32>(l_Cores.size());
+    }
+    /// Build placement order from our CPUs
+    void CPUTopology::BuildPlacementOrder()
+    {
+        m_PlacementOrder.clear();
+
+        uint32 l_MaxSibling = 0;
+        for (auto const& l_CPU : m_CPUs)
+            l_MaxSibling = std::max(l_MaxSibling, l_CPU.Sibling);
+
+        for (uint32 l_Sibling = 0; l_Sibling <= l_MaxSibling; ++l_Sibling)
+        {
+            std::vector<std::vector<uint32>> l_PerNode(m_NodeCount);
+
+            for (auto const& l_CPU : m_CPUs)
+            {
+                if (l_CPU.Sibling == l_Sibling)
+                    l_PerNode[l_CPU.Node].push_back(l_CPU.Id);
+            }
+
+            for (std::size_t l_Index = 0; ; ++l_Index)
+            {
+                bool l_Any = false;
+
+                for (auto const& l_NodeCPUs : l_PerNode)
+                {
+                    if (l_Index < l_NodeCPUs.size())
+                    {
+                        m_PlacementOrder.push_back(l_NodeCPUs[l_Index]);
+                        l_Any = true;
+                    }
+                }
+
+                if (!l_Any)
+                    break;
+            }
+        }
+    }
+
+    /// Read cgroup CPU quota of the process, containers are often given less CPU time than CPUs
+    void CPUTopology::DiscoverQuota()
+    {
+        m_CPUQuota = 0;
+
+#if defined(linux)
+        int64 l_Quota  = -1;
+        int64 l_Period = 0;
+        std::string l_Line;
+
+        /// cgroup v2 : "max 100000" or "<quota> <period>"
+        if (ReadSysFile("/sys/fs/cgroup/cpu.max", l_Line))
+        {
+            std::istringstream l_Stream(l_Line);
+            std::string l_Max;
+
+            if ((l_Stream >> l_Max >> l_Period) && l_Max != "max")
+                l_Quota = std::strtoll(l_Max.c_str(), nullptr, 10);
+        }
+        /// cgroup v1 : quota of -1 is unlimited
+        else if (ReadSysFile("/sys/fs/cgroup/cpu/cpu.cfs_quota_us", l_Line))
+        {
+            l_Quota  = std::strtoll(l_Line.c_str(), nullptr, 10);
+            l_Period = ReadSysInt("/sys/fs/cgroup/cpu/cpu.cfs_period_us", 0);
+        }
+
+        if (l_Quota > 0 && l_Period > 0)
+            m_CPUQuota = static_cast<uint32>((l_Quota + l_Period - 1) / l_Period);
+#endif
+    }
+
+}   ///< namespace Threading
+}   ///< namespace Core
+}   ///< namespace SteerStone
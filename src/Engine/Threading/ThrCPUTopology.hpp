@@ -0,0 +1,109 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "Core/Core.hpp"
+#include "Singleton/Singleton.hpp"
+
+#include <vector>
+#include <string>
+
+namespace SteerStone { namespace Core { namespace Threading {
+
+    /// Logical CPU the process may run on
+    struct LogicalCPU
+    {
+        uint32 Id;          ///< CPU id as known by the OS
+        uint32 Package;     ///< Index of physical package (socket)
+        uint32 Node;        ///< Index of NUMA node, dense from 0
+        uint32 Core;        ///< Index of physical core, dense from 0 across packages
+        uint32 Sibling;     ///< Index among SMT siblings of its core, 0 is the first hardware thread
+    };
+
+    /// Packages, NUMA nodes and physical cores of the CPUs the process may run on
+    /// Only CPUs of the process affinity mask are listed, a process started under taskset or a cpuset sees its own share
+    class CPUTopology
+    {
+        SINGLETON_P_D(CPUTopology);
+
+        //////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////////////////////////////////////
+
+        public:
+            /// Parse CPU list in "0-3,8,10-11" format
+            /// @p_List : CPU list
+            /// @p_CPUs : Parsed CPU ids, sorted and unique
+            /// Returns false if list is malformed
+            static bool ParseCPUList(std::string const& p_List, std::vector<uint32>& p_CPUs);
+            /// Format CPU ids in "0-3,8,10-11" format
+            /// @p_CPUs : CPU ids
+            static std::string FormatCPUList(std::vector<uint32> p_CPUs);
+
+        public:
+            /// Get logical CPUs
+            std::vector<LogicalCPU> const& GetCPUs() const;
+            /// Get logical CPU
+            /// @p_Id : CPU id, nullptr if process may not run on it
+            LogicalCPU const* GetCPU(uint32 p_Id) const;
+            /// Get amount of physical packages
+            uint32 GetPackageCount() const;
+            /// Get amount of NUMA nodes
+            uint32 GetNodeCount() const;
+            /// Get amount of physical cores
+            uint32 GetCoreCount() const;
+            /// Get CPUs granted by the cgroup CPU quota of the process rounded up, 0 if it has no quota
+            uint32 GetCPUQuota() const;
+            /// Get amount of CPUs the process can keep busy : CPUs it may run on, capped by its CPU quota
+            uint32 GetUsableCPUCount() const;
+
+            /// Get ids of the CPUs of a NUMA node
+            /// @p_Node : Node index
+            std::vector<uint32> GetNodeCPUs(uint32 p_Node) const;
+            /// Get node every CPU of the set belongs to
+            /// @p_CPUs : CPU ids
+            /// Returns -1 if set is empty or spans several nodes
+            int32 GetNodeOf(std::vector<uint32> const& p_CPUs) const;
+            /// Get CPU ids in placement order : one hardware thread per physical core first, then their SMT siblings,
+            /// nodes are interleaved so consecutive placements spread over memory controllers
+            std::vector<uint32> const& GetPlacementOrder() const;
+
+        private:
+            /// Discover topology of the host, fall back to one node of independent cores when it cannot be read
+            void Discover();
+            /// Build placement order from our CPUs
+            void BuildPlacementOrder();
+            /// Read cgroup CPU quota of the process, containers are often given less CPU time than CPUs
+            void DiscoverQuota();
+
+        private:
+            std::vector<LogicalCPU> m_CPUs;             ///< Logical CPUs sorted by id
+            std::vector<uint32>     m_PlacementOrder;   ///< CPU ids in placement order
+            uint32                  m_PackageCount;     ///< Amount of physical packages
+            uint32                  m_NodeCount;        ///< Amount of NUMA nodes
+            uint32                  m_CoreCount;        ///< Amount of physical cores
+            uint32                  m_CPUQuota;         ///< CPUs granted by the cgroup CPU quota rounded up, 0 if none
+
+    };
+
+}   ///< namespace Threading
+}   ///< namespace Core
+}   ///< namespace SteerStone
+
+#define sCPUTopology SteerStone::Core::Threading::CPUTopology::GetSingleton()
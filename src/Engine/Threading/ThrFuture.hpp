@@ -0,0 +1,678 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "Core/Core.hpp"
+#include "Threading/ThrTask.hpp"
+#include "Network/HandlerMemory.hpp"
+
+#include <boost/asio/post.hpp>
+
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <future>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <type_traits>
+
+#if defined(__cpp_impl_coroutine)
+    #include <coroutine>
+#endif
+
+namespace SteerStone { namespace Core { namespace Threading {
+
+    template<typename T> class Future;
+    template<typename T> class Promise;
+
+    /// Executor running jobs right away on the thread which makes the future ready
+    struct InlineExecutor
+    {
+    };
+
+    /// Detect executors taking jobs through Schedule (TaskScheduler)
+    template<typename Executor, typename = void> struct HasSchedule : std::false_type {};
+    template<typename Executor> struct HasSchedule<Executor, std::void_t<decltype(std::declval<Executor&>().Schedule(std::function<void()>()))>> : std::true_type {};
+
+    /// Detect executors taking jobs through PushRunOnceTask (TaskManager)
+    template<typename Executor, typename = void> struct HasPushRunOnceTask : std::false_type {};
+    template<typename Executor> struct HasPushRunOnceTask<Executor, std::void_t<decltype(std::declval<Executor&>().PushRunOnceTask(TaskType::Normal, std::function<void()>()))>> : std::true_type {};
+
+    /// Run job on executor
+    /// Supports InlineExecutor, TaskScheduler, TaskManager and anything boost::asio::post accepts (io_service, strand)
+    /// @p_Executor : Executor
+    /// @p_Job      : Job
+    template<typename Executor> inline void PostToExecutor(Executor& p_Executor, std::function<void()> p_Job)
+    {
+        using Type = typename std::decay<Executor>::type;
+
+        if constexpr (std::is_same<Type, InlineExecutor>::value)
+            p_Job();
+        else if constexpr (HasSchedule<Type>::value)
+            p_Executor.Schedule(std::move(p_Job));
+        else if constexpr (HasPushRunOnceTask<Type>::value)
+            p_Executor.PushRunOnceTask(TaskType::Normal, std::move(p_Job));
+        else
+            boost::asio::post(p_Executor, std::move(p_Job));
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Value held by futures of void
+    struct FutureVoid
+    {
+    };
+
+    /// Value stored in the state of a Future<T>
+    template<typename T> using FutureValue = typename std::conditional<std::is_void<T>::value, FutureVoid, T>::type;
+
+    /// Work attached to a future, runs once the future is ready
+    /// Memory comes from HandlerMemoryPool, chaining does not touch the heap once the pool is warm
+    class FutureContinuation
+    {
+        public:
+            /// Deconstructor
+            virtual ~FutureContinuation() {}
+
+            /// Future became ready, its value or exception may be read
+            /// The continuation releases itself once it has run
+            virtual void OnReady() = 0;
+
+            /// Allocate from handler memory pool
+            /// @p_Size : Size of continuation
+            static void* operator new(std::size_t p_Size)
+            {
+                return Network::HandlerMemoryPool::Allocate(p_Size);
+            }
+            /// Release to handler memory pool
+            /// @p_Pointer : Continuation
+            /// @p_Size    : Size of continuation
+            static void operator delete(void* p_Pointer, std::size_t p_Size)
+            {
+                Network::HandlerMemoryPool::Deallocate(p_Pointer, p_Size);
+            }
+    };
+
+    /// Shared state between a promise and its future
+    template<typename T> class FutureState
+    {
+        DISALLOW_COPY_AND_ASSIGN(FutureState);
+
+        public:
+            using Ptr = std::shared_ptr<FutureState<T>>;
+
+            /// Create state, state and control block share one block from handler memory pool
+            static Ptr Create()
+            {
+                return std::allocate_shared<FutureState<T>>(Network::HandlerAllocator<FutureState<T>>());
+            }
+
+        public:
+            /// Constructor
+            FutureState()
+                : m_Ready(false), m_Continuation(nullptr)
+            {
+            }
+            /// Deconstructor
+            ~FutureState()
+            {
+                /// Never became ready, nothing will run it
+                delete m_Continuation;
+            }
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Store value and run continuation, ignored if state is already ready
+            /// @p_Value : Value
+            void SetValue(FutureValue<T> p_Value)
+            {
+                std::unique_lock<std::mutex> l_Lock(m_Mutex);
+
+                if (m_Ready)
+                    return;
+
+                m_Value.emplace(std::move(p_Value));
+                Complete(l_Lock);
+            }
+            /// Store exception and run continuation, ignored if state is already ready
+            /// @p_Exception : Exception
+            void SetException(std::exception_ptr p_Exception)
+            {
+                std::unique_lock<std::mutex> l_Lock(m_Mutex);
+
+                if (m_Ready)
+                    return;
+
+                m_Exception = p_Exception;
+                Complete(l_Lock);
+            }
+
+            /// Check if value or exception has been stored
+            bool IsReady()
+            {
+                std::lock_guard<std::mutex> l_Lock(m_Mutex);
+                return m_Ready;
+            }
+            /// Block until value or exception has been stored
+            void Wait()
+            {
+                std::unique_lock<std::mutex> l_Lock(m_Mutex);
+                m_Condition.wait(l_Lock, [this]() { return m_Ready; });
+            }
+            /// Get exception, only valid once ready
+            std::exception_ptr GetException() const
+            {
+                return m_Exception;
+            }
+            /// Get value, only valid once ready without exception
+            FutureValue<T>& GetValue()
+            {
+                return *m_Value;
+            }
+
+            /// Attach continuation, runs right away if state is already ready
+            /// @p_Continuation : Continuation, owned by state until it runs
+            void Attach(FutureContinuation* p_Continuation)
+            {
+                std::unique_lock<std::mutex> l_Lock(m_Mutex);
+
+                if (!m_Ready)
+                {
+                    m_Continuation = p_Continuation;
+                    return;
+                }
+
+                l_Lock.unlock();
+                p_Continuation->OnReady();
+            }
+
+        private:
+            /// Mark as ready, wake waiters and run continuation outside of our lock
+            /// @p_Lock : Lock of our mutex
+            void Complete(std::unique_lock<std::mutex>& p_Lock)
+            {
+                FutureContinuation* l_Continuation = m_Continuation;
+
+                m_Ready         = true;
+                m_Continuation  = nullptr;
+
+                m_Condition.notify_all();
+                p_Lock.unlock();
+
+                if (l_Continuation)
+                    l_Continuation->OnReady();
+            }
+
+        private:
+            std::mutex                      m_Mutex;            ///< Mutex
+            std::condition_variable         m_Condition;        ///< Wakes threads in Wait
+            bool                            m_Ready;            ///< Value or exception has been stored
+            std::optional<FutureValue<T>>   m_Value;            ///< Value
+            std::exception_ptr              m_Exception;        ///< Exception
+            FutureContinuation*             m_Continuation;     ///< Work to run once ready
+    };
+
+    /// Run function and store its result, or the exception it threw, into state
+    /// @p_State    : State
+    /// @p_Function : Function
+    template<typename T, typename Function> inline void FulfilFutureState(FutureState<T>& p_State, Function& p_Function)
+    {
+        std::optional<FutureValue<T>> l_Value;
+
+        try
+        {
+            if constexpr (std::is_void<T>::value)
+            {
+                p_Function();
+                l_Value.emplace();
+            }
+            else
+                l_Value.emplace(p_Function());
+        }
+        catch (...)
+        {
+            p_State.SetException(std::current_exception());
+            return;
+        }
+
+        /// Outside of try, exceptions of continuations running inline are not the ones of this function
+        p_State.SetValue(std::move(*l_Value));
+    }
+
+    /// Result of a continuation attached to a Future<T>
+    template<typename T, typename Function> struct FutureThenResult
+    {
+        using Type = typename std::invoke_result<Function, T>::type;
+    };
+    /// Result of a continuation attached to a Future<void>
+    template<typename Function> struct FutureThenResult<void, Function>
+    {
+        using Type = typename std::invoke_result<Function>::type;
+    };
+
+    /// Continuation running a function on an executor with the value of a future
+    /// An exception of the source is passed on without running the function
+    template<typename T, typename Executor, typename Function> class FutureThenContinuation : public FutureContinuation
+    {
+        using Result = typename FutureThenResult<T, Function>::Type;
+
+        public:
+            /// Constructor
+            /// @p_Executor : Executor function runs on, kept by reference if given as lvalue
+            /// @p_Function : Function
+            /// @p_Source   : State of future we wait for
+            /// @p_Target   : State of future holding result of function
+            FutureThenContinuation(Executor&& p_Executor, Function&& p_Function, typename FutureState<T>::Ptr p_Source, typename FutureState<Result>::Ptr p_Target)
+                : m_Executor(std::forward<Executor>(p_Executor)), m_Function(std::move(p_Function)), m_Source(std::move(p_Source)), m_Target(std::move(p_Target))
+            {
+            }
+
+            /// Future became ready, its value or exception may be read
+            void OnReady() override
+            {
+                /// Only a pointer is captured, the job fits in the small buffer of std::function
+                PostToExecutor(m_Executor, [this]() { Run(); });
+            }
+
+        private:
+            /// Run function on executor and release ourself
+            void Run()
+            {
+                if (std::exception_ptr l_Exception = m_Source->GetException())
+                    m_Target->SetException(l_Exception);
+                else
+                {
+                    auto l_Call = [this]() -> Result
+                    {
+                        if constexpr (std::is_void<T>::value)
+                            return m_Function();
+                        else
+                            return m_Function(std::move(m_Source->GetValue()));
+                    };
+
+                    FulfilFutureState(*m_Target, l_Call);
+                }
+
+                delete this;
+            }
+
+        private:
+            Executor                            m_Executor;     ///< Executor, a reference unless given as rvalue
+            Function                            m_Function;     ///< Function
+            typename FutureState<T>::Ptr        m_Source;       ///< State of future we wait for
+            typename FutureState<Result>::Ptr   m_Target;       ///< State of future holding result of function
+    };
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+#if defined(__cpp_impl_coroutine)
+    /// Continuation resuming a coroutine awaiting a future, on the thread which made the future ready
+    class FutureResumeContinuation : public FutureContinuation
+    {
+        public:
+            /// Constructor
+            /// @p_Handle : Awaiting coroutine
+            explicit FutureResumeContinuation(std::coroutine_handle<> p_Handle)
+                : m_Handle(p_Handle)
+            {
+            }
+
+            /// Future became ready, its value or exception may be read
+            void OnReady() override
+            {
+                std::coroutine_handle<> l_Handle = m_Handle;
+
+                delete this;
+                l_Handle.resume();
+            }
+
+        private:
+            std::coroutine_handle<> m_Handle;       ///< Awaiting coroutine
+    };
+
+    /// Awaiter of co_await on a future, use ResumeOn afterwards to move to a chosen executor
+    template<typename T> class FutureAwaiter
+    {
+        public:
+            /// Constructor
+            /// @p_Future : Awaited future
+            explicit FutureAwaiter(Future<T>& p_Future)
+                : m_Future(p_Future)
+            {
+            }
+
+            /// Check if coroutine can go on without suspending
+            bool await_ready() const
+            {
+                return m_Future.IsReady();
+            }
+            /// Suspend coroutine until future is ready
+            /// @p_Handle : Awaiting coroutine
+            void await_suspend(std::coroutine_handle<> p_Handle)
+            {
+                m_Future.m_State->Attach(new FutureResumeContinuation(p_Handle));
+            }
+            /// Get value of future, rethrows its exception
+            T await_resume()
+            {
+                return m_Future.Get();
+            }
+
+        private:
+            Future<T>& m_Future;        ///< Awaited future
+    };
+
+    /// Awaiter moving a coroutine onto an executor
+    template<typename Executor> class ResumeOnAwaiter
+    {
+        public:
+            /// Constructor
+            /// @p_Executor : Executor, kept by reference if given as lvalue
+            explicit ResumeOnAwaiter(Executor&& p_Executor)
+                : m_Executor(std::forward<Executor>(p_Executor))
+            {
+            }
+
+            /// Always suspend, even when already on executor, jobs queued before us run first
+            bool await_ready() const
+            {
+                return false;
+            }
+            /// Resume coroutine on executor
+            /// @p_Handle : Awaiting coroutine
+            void await_suspend(std::coroutine_handle<> p_Handle)
+            {
+                PostToExecutor(m_Executor, [p_Handle]() { p_Handle.resume(); });
+            }
+            /// Nothing to return
+            void await_resume()
+            {
+            }
+
+        private:
+            Executor m_Executor;        ///< Executor, a reference unless given as rvalue
+    };
+
+    /// co_await ResumeOn(executor) continues the coroutine on executor
+    /// @p_Executor : Executor, kept by reference if given as lvalue
+    template<typename Executor> inline ResumeOnAwaiter<Executor> ResumeOn(Executor&& p_Executor)
+    {
+        return ResumeOnAwaiter<Executor>(std::forward<Executor>(p_Executor));
+    }
+
+    /// Promise of coroutines returning Future<T>, stores returned value
+    template<typename T> class FutureCoroutinePromiseBase
+    {
+        public:
+            /// Store returned value
+            /// @p_Value : Value
+            void return_value(T p_Value)
+            {
+                m_State->SetValue(std::move(p_Value));
+            }
+
+        protected:
+            typename FutureState<T>::Ptr m_State = FutureState<T>::Create();     ///< State of returned future
+    };
+    /// Promise of coroutines returning Future<void>
+    template<> class FutureCoroutinePromiseBase<void>
+    {
+        public:
+            /// Coroutine returned
+            void return_void()
+            {
+                m_State->SetValue(FutureVoid());
+            }
+
+        protected:
+            FutureState<void>::Ptr m_State = FutureState<void>::Create();         ///< State of returned future
+    };
+
+    /// Promise of coroutines returning Future<T>, coroutines start right away and their frame comes from handler memory pool
+    template<typename T> class FutureCoroutinePromise : public FutureCoroutinePromiseBase<T>
+    {
+        public:
+            /// Get future handed to caller
+            Future<T> get_return_object()
+            {
+                return Future<T>(this->m_State);
+            }
+            /// Run coroutine until its first suspension
+            std::suspend_never initial_suspend() noexcept
+            {
+                return {};
+            }
+            /// Release frame once coroutine returned
+            std::suspend_never final_suspend() noexcept
+            {
+                return {};
+            }
+            /// Store exception which escaped coroutine
+            void unhandled_exception()
+            {
+                this->m_State->SetException(std::current_exception());
+            }
+
+            /// Allocate coroutine frame from handler memory pool
+            /// @p_Size : Size of frame
+            static void* operator new(std::size_t p_Size)
+            {
+                return Network::HandlerMemoryPool::Allocate(p_Size);
+            }
+            /// Release coroutine frame to handler memory pool
+            /// @p_Pointer : Frame
+            /// @p_Size    : Size of frame
+            static void operator delete(void* p_Pointer, std::size_t p_Size)
+            {
+                Network::HandlerMemoryPool::Deallocate(p_Pointer, p_Size);
+            }
+    };
+#endif
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Result of asynchronous work, holds a single value or exception
+    /// A future is consumed by Get or Then, moving it around is cheap
+    template<typename T> class Future
+    {
+        template<typename U> friend class Promise;
+    #if defined(__cpp_impl_coroutine)
+        template<typename U> friend class FutureAwaiter;
+    #endif
+
+        public:
+        #if defined(__cpp_impl_coroutine)
+            /// Functions returning Future<T> may be coroutines
+            using promise_type = FutureCoroutinePromise<T>;
+        #endif
+
+        public:
+            /// Constructor, future is not valid
+            Future() = default;
+            /// Constructor
+            /// @p_State : Shared state
+            explicit Future(typename FutureState<T>::Ptr p_State)
+                : m_State(std::move(p_State))
+            {
+            }
+
+            Future(Future const&) = delete;
+            Future& operator=(Future const&) = delete;
+            Future(Future&&) = default;
+            Future& operator=(Future&&) = default;
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Check if future holds a state, false once consumed
+            bool IsValid() const
+            {
+                return m_State != nullptr;
+            }
+            /// Check if value or exception is available
+            bool IsReady() const
+            {
+                return m_State->IsReady();
+            }
+            /// Block until value or exception is available
+            /// Blocking a worker which has to make the future ready dead locks, prefer Then
+            void Wait() const
+            {
+                m_State->Wait();
+            }
+            /// Block until value is available and take it, rethrows exception
+            T Get()
+            {
+                typename FutureState<T>::Ptr l_State = std::move(m_State);
+                l_State->Wait();
+
+                if (std::exception_ptr l_Exception = l_State->GetException())
+                    std::rethrow_exception(l_Exception);
+
+                if constexpr (!std::is_void<T>::value)
+                    return std::move(l_State->GetValue());
+            }
+
+            /// Run function on executor once value is available, consumes this future
+            /// Function takes the value (nothing for Future<void>), an exception skips it and is passed on
+            /// @p_Executor : Executor (see PostToExecutor), kept by reference if given as lvalue
+            /// @p_Function : Function
+            template<typename Executor, typename Function> auto Then(Executor&& p_Executor, Function&& p_Function)
+                -> Future<typename FutureThenResult<T, typename std::decay<Function>::type>::Type>
+            {
+                using DecayedFunction   = typename std::decay<Function>::type;
+                using Result            = typename FutureThenResult<T, DecayedFunction>::Type;
+
+                typename FutureState<Result>::Ptr l_Target = FutureState<Result>::Create();
+                typename FutureState<T>::Ptr      l_Source = std::move(m_State);
+
+                l_Source->Attach(new FutureThenContinuation<T, Executor, DecayedFunction>(std::forward<Executor>(p_Executor), DecayedFunction(std::forward<Function>(p_Function)), l_Source, l_Target));
+
+                return Future<Result>(std::move(l_Target));
+            }
+
+        #if defined(__cpp_impl_coroutine)
+            /// Await future in a coroutine, coroutine resumes on the thread which makes the future ready
+            FutureAwaiter<T> operator co_await()
+            {
+                return FutureAwaiter<T>(*this);
+            }
+        #endif
+
+        private:
+            typename FutureState<T>::Ptr m_State;       ///< Shared state
+    };
+
+    /// Producer side of a future
+    /// Destroying a promise which has not been fulfilled makes its future throw std::future_errc::broken_promise
+    template<typename T> class Promise
+    {
+        public:
+            /// Constructor
+            Promise()
+                : m_State(FutureState<T>::Create())
+            {
+            }
+            /// Deconstructor
+            ~Promise()
+            {
+                Abandon();
+            }
+
+            Promise(Promise const&) = delete;
+            Promise& operator=(Promise const&) = delete;
+            Promise(Promise&&) = default;
+            /// Move assignment, the replaced promise is abandoned
+            Promise& operator=(Promise&& p_Other)
+            {
+                if (this != &p_Other)
+                {
+                    Abandon();
+                    m_State = std::move(p_Other.m_State);
+                }
+
+                return *this;
+            }
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Get future, call only once
+            Future<T> GetFuture()
+            {
+                return Future<T>(m_State);
+            }
+
+            /// Fulfil promise with value
+            /// @p_Value : Value
+            template<typename U = T> typename std::enable_if<!std::is_void<U>::value>::type SetValue(FutureValue<U> p_Value)
+            {
+                m_State->SetValue(std::move(p_Value));
+            }
+            /// Fulfil promise of void
+            template<typename U = T> typename std::enable_if<std::is_void<U>::value>::type SetValue()
+            {
+                m_State->SetValue(FutureVoid());
+            }
+            /// Fulfil promise with exception
+            /// @p_Exception : Exception
+            void SetException(std::exception_ptr p_Exception)
+            {
+                m_State->SetException(p_Exception);
+            }
+
+        private:
+            /// Break future if we have not been fulfilled
+            void Abandon()
+            {
+                if (m_State)
+                    m_State->SetException(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+            }
+
+        private:
+            typename FutureState<T>::Ptr m_State;       ///< Shared state
+    };
+
+    /// Run function on executor
+    /// @p_Executor : Executor (see PostToExecutor), kept by reference if given as lvalue
+    /// @p_Function : Function, must be copyable
+    template<typename Executor, typename Function> inline auto Async(Executor&& p_Executor, Function&& p_Function)
+        -> Future<typename std::invoke_result<typename std::decay<Function>::type>::type>
+    {
+        using Result = typename std::invoke_result<typename std::decay<Function>::type>::type;
+
+        typename FutureState<Result>::Ptr l_State = FutureState<Result>::Create();
+
+        PostToExecutor(p_Executor, [l_State, l_Function = typename std::decay<Function>::type(std::forward<Function>(p_Function))]() mutable
+        {
+            FulfilFutureState(*l_State, l_Function);
+        });
+
+        return Future<Result>(l_State);
+    }
+
+}   ///< namespace Threading
+}   ///< namespace Core
+}   ///< namespace SteerStone
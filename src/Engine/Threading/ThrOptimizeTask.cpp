@@ -56,6 +56,7 @@ namespace SteerStone { namespace Core { namespace Threading {
     bool OptimizeTask::TaskExecute()
     {
         TaskManager::GetSingleton()->Optimize();
+        TaskManager::GetSingleton()->ScaleWorkers();
 
         return true;
     }
@@ -0,0 +1,290 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "Core/Core.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+#define PARALLEL_CHUNKS_PER_WORKER  4       ///< Chunks per worker when no grain is given, leaves room for balancing uneven items
+
+namespace SteerStone { namespace Core { namespace Threading {
+
+    /// Detect executors telling how many workers run their jobs (TaskManager)
+    template<typename Executor, typename = void> struct HasGetConcurrency : std::false_type {};
+    template<typename Executor> struct HasGetConcurrency<Executor, std::void_t<decltype(std::declval<Executor&>().GetConcurrency())>> : std::true_type {};
+
+    /// Get amount of workers of executor
+    /// Supports TaskManager and TaskScheduler
+    /// @p_Executor : Executor
+    template<typename Executor> inline uint32 GetExecutorConcurrency(Executor& p_Executor)
+    {
+        if constexpr (HasGetConcurrency<Executor>::value)
+            return p_Executor.GetConcurrency();
+        else
+            return p_Executor.GetWorkerCount();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Range split in chunks, claimed one at a time by the caller and the helpers it schedules
+    /// The caller keeps claiming chunks until none is left, so the loop finishes even if no helper ever runs
+    /// (helpers queued behind the caller on its own worker cannot deadlock it). Helpers starting late find no chunk and leave
+    template<typename Index> class ParallelLoop
+    {
+        DISALLOW_COPY_AND_ASSIGN(ParallelLoop);
+
+        public:
+            using Ptr = std::shared_ptr<ParallelLoop>;
+
+            /// Chunk body
+            /// @p_Context : Caller function
+            /// @p_Begin   : First index of chunk
+            /// @p_End     : Index past the end of chunk
+            /// @p_Chunk   : Chunk number
+            using ChunkFunction = void(*)(void* p_Context, Index p_Begin, Index p_End, std::size_t p_Chunk);
+
+        public:
+            /// Constructor
+            /// @p_Begin    : First index
+            /// @p_End      : Index past the end
+            /// @p_Grain    : Indices per chunk
+            /// @p_Function : Chunk body
+            /// @p_Context  : Caller function, must outlive Wait
+            ParallelLoop(Index p_Begin, Index p_End, Index p_Grain, ChunkFunction p_Function, void* p_Context)
+                : m_Begin(p_Begin), m_End(p_End), m_Grain(p_Grain), m_ChunkCount(GetChunkCount(p_Begin, p_End, p_Grain)),
+                m_Function(p_Function), m_Context(p_Context), m_NextChunk(0), m_DoneChunks(0)
+            {
+            }
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Get amount of chunks of a range
+            /// @p_Begin : First index
+            /// @p_End   : Index past the end
+            /// @p_Grain : Indices per chunk
+            static std::size_t GetChunkCount(Index p_Begin, Index p_End, Index p_Grain)
+            {
+                if (p_End <= p_Begin)
+                    return 0;
+
+                return static_cast<std::size_t>((p_End - p_Begin - 1) / p_Grain) + 1;
+            }
+
+            /// Claim chunks and run them until none is left
+            void Run()
+            {
+                for (;;)
+                {
+                    const std::size_t l_Chunk = m_NextChunk.fetch_add(1, std::memory_order_relaxed);
+
+                    if (l_Chunk >= m_ChunkCount)
+                        return;
+
+                    /// After a failure remaining chunks are only counted
+                    if (!m_Failed.load(std::memory_order_relaxed))
+                    {
+                        const Index l_Begin = m_Begin + static_cast<Index>(l_Chunk) * m_Grain;
+                        const Index l_End   = (m_End - l_Begin) > m_Grain ? l_Begin + m_Grain : m_End;
+
+                        try
+                        {
+                            m_Function(m_Context, l_Begin, l_End, l_Chunk);
+                        }
+                        catch (...)
+                        {
+                            std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+                            if (!m_Exception)
+                                m_Exception = std::current_exception();
+
+                            m_Failed.store(true, std::memory_order_relaxed);
+                        }
+                    }
+
+                    if (m_DoneChunks.fetch_add(1, std::memory_order_acq_rel) + 1 == m_ChunkCount)
+                    {
+                        std::lock_guard<std::mutex> l_Lock(m_Mutex);
+                        m_Condition.notify_all();
+                    }
+                }
+            }
+            /// Wait until every chunk has run, rethrows the first exception thrown by a chunk
+            void Wait()
+            {
+                std::unique_lock<std::mutex> l_Lock(m_Mutex);
+
+                m_Condition.wait(l_Lock, [this]() -> bool {
+                    return m_DoneChunks.load(std::memory_order_acquire) == m_ChunkCount;
+                });
+
+                if (m_Exception)
+                    std::rethrow_exception(m_Exception);
+            }
+
+        private:
+            const Index         m_Begin;        ///< First index
+            const Index         m_End;          ///< Index past the end
+            const Index         m_Grain;        ///< Indices per chunk
+            const std::size_t   m_ChunkCount;   ///< Amount of chunks
+            ChunkFunction       m_Function;     ///< Chunk body
+            void*               m_Context;      ///< Caller function
+
+            std::atomic<std::size_t>    m_NextChunk;        ///< Next chunk to claim
+            std::atomic<std::size_t>    m_DoneChunks;       ///< Chunks which have run
+            std::atomic<bool>           m_Failed{ false };  ///< A chunk has thrown
+
+            std::mutex              m_Mutex;        ///< Guards exception and wake up
+            std::condition_variable m_Condition;    ///< Signaled once the last chunk has run
+            std::exception_ptr      m_Exception;    ///< First exception thrown by a chunk
+    };
+
+    /// Run chunk body over a range on executor and the calling thread
+    /// One job per helper worker is scheduled, nothing is allocated per index
+    /// @p_Executor : Executor with Schedule
+    /// @p_Begin    : First index
+    /// @p_End      : Index past the end
+    /// @p_Grain    : Indices per chunk, 0 to split the range in PARALLEL_CHUNKS_PER_WORKER chunks per worker
+    /// @p_Function : Chunk body
+    /// @p_Context  : Caller function
+    template<typename Executor, typename Index> inline void RunParallelLoop(Executor& p_Executor, Index p_Begin, Index p_End, Index p_Grain,
+        typename ParallelLoop<Index>::ChunkFunction p_Function, void* p_Context)
+    {
+        static_assert(std::is_integral<Index>::value, "ParallelFor needs an integral index");
+
+        if (p_End <= p_Begin)
+            return;
+
+        const uint32 l_Concurrency = std::max<uint32>(1, GetExecutorConcurrency(p_Executor));
+
+        if (p_Grain <= 0)
+        {
+            const std::size_t l_Chunks = static_cast<std::size_t>(l_Concurrency) * PARALLEL_CHUNKS_PER_WORKER;
+            p_Grain = static_cast<Index>(std::max<std::size_t>(1, (static_cast<std::size_t>(p_End - p_Begin) + l_Chunks - 1) / l_Chunks));
+        }
+
+        const std::size_t l_ChunkCount = ParallelLoop<Index>::GetChunkCount(p_Begin, p_End, p_Grain);
+
+        /// A single chunk is not worth waking anybody up
+        if (l_ChunkCount == 1)
+        {
+            p_Function(p_Context, p_Begin, p_End, 0);
+            return;
+        }
+
+        typename ParallelLoop<Index>::Ptr l_Loop = std::make_shared<ParallelLoop<Index>>(p_Begin, p_End, p_Grain, p_Function, p_Context);
+
+        const std::size_t l_HelperCount = std::min<std::size_t>(l_Concurrency, l_ChunkCount - 1);
+        for (std::size_t l_I = 0; l_I < l_HelperCount; ++l_I)
+            p_Executor.Schedule([l_Loop]() { l_Loop->Run(); });
+
+        l_Loop->Run();
+        l_Loop->Wait();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Call function for every index of [p_Begin, p_End) on executor and the calling thread, returns once all calls are done
+    /// Indices run in chunks of p_Grain, in order inside a chunk, chunks in no given order
+    /// Rethrows the first exception thrown, remaining chunks are skipped
+    /// Index type is taken from p_End, so ParallelFor(Executor, 0, Vector.size(), ...) works
+    /// @p_Executor : Executor with Schedule (TaskManager, TaskScheduler)
+    /// @p_Begin    : First index
+    /// @p_End      : Index past the end
+    /// @p_Grain    : Indices per chunk, 0 to pick one from the worker count
+    /// @p_Function : Called as p_Function(Index)
+    template<typename Executor, typename Index, typename Function> inline void ParallelFor(Executor& p_Executor, typename std::common_type<Index>::type p_Begin, Index p_End, typename std::common_type<Index>::type p_Grain, Function&& p_Function)
+    {
+        using FunctionType = typename std::remove_reference<Function>::type;
+
+        RunParallelLoop<Executor, Index>(p_Executor, p_Begin, p_End, p_Grain, [](void* p_Context, Index p_ChunkBegin, Index p_ChunkEnd, std::size_t) {
+            FunctionType& l_Function = *static_cast<FunctionType*>(p_Context);
+
+            for (Index l_I = p_ChunkBegin; l_I < p_ChunkEnd; ++l_I)
+                l_Function(l_I);
+        }, const_cast<void*>(static_cast<void const*>(std::addressof(p_Function))));
+    }
+
+    /// Reduce every index of [p_Begin, p_End) on executor and the calling thread
+    /// Each chunk accumulates into its own copy of p_Identity, partials are combined in chunk order on the calling thread,
+    /// so the result does not depend on scheduling even if p_Combine is not commutative
+    /// Rethrows the first exception thrown, index type is taken from p_End
+    /// @p_Executor   : Executor with Schedule (TaskManager, TaskScheduler)
+    /// @p_Begin      : First index
+    /// @p_End        : Index past the end
+    /// @p_Grain      : Indices per chunk, 0 to pick one from the worker count
+    /// @p_Identity   : Start value of every chunk
+    /// @p_Accumulate : Called as p_Accumulate(T& Partial, Index)
+    /// @p_Combine    : Called as p_Combine(T Left, T Right) -> T
+    template<typename Executor, typename Index, typename T, typename Accumulate, typename Combine>
+    inline T ParallelReduce(Executor& p_Executor, typename std::common_type<Index>::type p_Begin, Index p_End, typename std::common_type<Index>::type p_Grain, T const& p_Identity, Accumulate&& p_Accumulate, Combine&& p_Combine)
+    {
+        using AccumulateType = typename std::remove_reference<Accumulate>::type;
+
+        if (p_End <= p_Begin)
+            return p_Identity;
+
+        const uint32 l_Concurrency = std::max<uint32>(1, GetExecutorConcurrency(p_Executor));
+
+        /// Grain is picked here, partials are sized from it
+        if (p_Grain <= 0)
+        {
+            const std::size_t l_Chunks = static_cast<std::size_t>(l_Concurrency) * PARALLEL_CHUNKS_PER_WORKER;
+            p_Grain = static_cast<Index>(std::max<std::size_t>(1, (static_cast<std::size_t>(p_End - p_Begin) + l_Chunks - 1) / l_Chunks));
+        }
+
+        /// Accumulate and partials of every chunk
+        struct Context
+        {
+            AccumulateType*     Function;       ///< Accumulate of caller
+            std::vector<T>      Partials;       ///< Partial result of every chunk
+        };
+
+        Context l_Context{ std::addressof(p_Accumulate), std::vector<T>(ParallelLoop<Index>::GetChunkCount(p_Begin, p_End, p_Grain), p_Identity) };
+
+        RunParallelLoop<Executor, Index>(p_Executor, p_Begin, p_End, p_Grain, [](void* p_Context, Index p_ChunkBegin, Index p_ChunkEnd, std::size_t p_Chunk) {
+            Context& l_Context = *static_cast<Context*>(p_Context);
+            T& l_Partial = l_Context.Partials[p_Chunk];
+
+            for (Index l_I = p_ChunkBegin; l_I < p_ChunkEnd; ++l_I)
+                (*l_Context.Function)(l_Partial, l_I);
+        }, &l_Context);
+
+        T l_Result = std::move(l_Context.Partials[0]);
+        for (std::size_t l_I = 1; l_I < l_Context.Partials.size(); ++l_I)
+            l_Result = p_Combine(std::move(l_Result), std::move(l_Context.Partials[l_I]));
+
+        return l_Result;
+    }
+
+}   ///< namespace Threading
+}   ///< namespace Core
+}   ///< namespace SteerStone
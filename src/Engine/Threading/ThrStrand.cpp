@@ -0,0 +1,192 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <PCH/Precompiled.hpp>
+
+#include "Threading/ThrStrand.hpp"
+#include "Threading/ThrTaskManager.hpp"
+
+#include <thread>
+
+namespace SteerStone { namespace Core { namespace Threading {
+
+    /// Strand whose messages this thread is running, nullptr if none
+    static thread_local Strand const* s_CurrentStrand = nullptr;
+
+    /// Create strand
+    Strand::Ptr Strand::Create()
+    {
+        return Ptr(new Strand());
+    }
+    /// Constructor
+    Strand::Strand()
+        : m_Head(&m_Stub), m_Tail(&m_Stub), m_Pending(0)
+    {
+        m_Stub.Next.store(nullptr, std::memory_order_relaxed);
+    }
+    /// Deconstructor, messages which have not run are dropped
+    Strand::~Strand()
+    {
+        /// Nobody posts to a strand being destroyed, every message is linked
+        while (Message* l_Message = Pop())
+            delete l_Message;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Post message, safe from any thread
+    /// @p_Function : Message
+    void Strand::Post(std::function<void()> p_Function)
+    {
+        Message* l_Message  = new Message();
+        l_Message->Function = std::move(p_Function);
+
+        Push(l_Message);
+
+        if (m_Pending.fetch_add(1, std::memory_order_acq_rel) == 0)
+            Launch();
+    }
+    /// Run message right away if called from this strand, post it otherwise
+    /// @p_Function : Message
+    void Strand::Dispatch(std::function<void()> p_Function)
+    {
+        if (RunningInThisThread())
+        {
+            p_Function();
+            return;
+        }
+
+        Post(std::move(p_Function));
+    }
+    /// Post message, executor interface of futures
+    /// @p_Function : Message
+    void Strand::Schedule(std::function<void()> p_Function)
+    {
+        Post(std::move(p_Function));
+    }
+
+    /// Check if the calling thread is running a message of this strand
+    bool Strand::RunningInThisThread() const
+    {
+        return s_CurrentStrand == this;
+    }
+    /// Get amount of messages posted and not run yet
+    uint32 Strand::GetPendingCount() const
+    {
+        return m_Pending.load(std::memory_order_relaxed);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Link message at the head of our inbox, safe from any thread
+    /// @p_Message : Message
+    void Strand::Push(Message* p_Message)
+    {
+        p_Message->Next.store(nullptr, std::memory_order_relaxed);
+
+        Message* l_Previous = m_Head.exchange(p_Message, std::memory_order_acq_rel);
+        l_Previous->Next.store(p_Message, std::memory_order_release);
+    }
+    /// Unlink message at the tail of our inbox, only from the thread draining us
+    /// Returns nullptr if inbox is empty or a producer has not linked its message yet
+    Strand::Message* Strand::Pop()
+    {
+        Message* l_Tail = m_Tail;
+        Message* l_Next = l_Tail->Next.load(std::memory_order_acquire);
+
+        if (l_Tail == &m_Stub)
+        {
+            if (!l_Next)
+                return nullptr;
+
+            m_Tail = l_Next;
+            l_Tail = l_Next;
+            l_Next = l_Next->Next.load(std::memory_order_acquire);
+        }
+
+        if (l_Next)
+        {
+            m_Tail = l_Next;
+            return l_Tail;
+        }
+
+        /// A producer swapped the head but has not linked its message yet
+        if (l_Tail != m_Head.load(std::memory_order_acquire))
+            return nullptr;
+
+        /// Last message, put the stub behind it so the inbox never runs dry while we take it
+        Push(&m_Stub);
+
+        l_Next = l_Tail->Next.load(std::memory_order_acquire);
+        if (l_Next)
+        {
+            m_Tail = l_Next;
+            return l_Tail;
+        }
+
+        return nullptr;
+    }
+    /// Hand our inbox to a task worker
+    void Strand::Launch()
+    {
+        Ptr l_Self = shared_from_this();
+        sThreadManager->Schedule([l_Self]() { l_Self->Drain(); });
+    }
+    /// Run a batch of messages, launch again if more are pending
+    void Strand::Drain()
+    {
+        Strand const* l_Previous = s_CurrentStrand;
+        s_CurrentStrand = this;
+
+        uint32 l_Ran = 0;
+
+        while (l_Ran < STRAND_MAX_BATCH)
+        {
+            Message* l_Message = Pop();
+
+            if (!l_Message)
+            {
+                /// Counted messages are all pushed, one is being linked right now
+                if (l_Ran < m_Pending.load(std::memory_order_acquire))
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                break;
+            }
+
+            l_Message->Function();
+            delete l_Message;
+
+            ++l_Ran;
+        }
+
+        s_CurrentStrand = l_Previous;
+
+        /// Posts seeing a non zero count left launching to us, a busy strand goes to the back of the line between batches
+        if (m_Pending.fetch_sub(l_Ran, std::memory_order_acq_rel) != l_Ran)
+            Launch();
+    }
+
+}   ///< namespace Threading
+}   ///< namespace Core
+}   ///< namespace SteerStone
@@ -0,0 +1,115 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "Core/Core.hpp"
+#include "Network/HandlerMemory.hpp"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#define STRAND_MAX_BATCH    64      ///< Messages run per turn before a strand hands its worker back
+
+namespace SteerStone { namespace Core { namespace Threading {
+
+    /// Serial executor on top of the task manager (actor inbox)
+    /// Messages posted from any thread go to a lock free MPSC inbox and run one at a time, in posting order of each thread,
+    /// on whatever task worker picks the strand up. State only touched from a strand needs no lock.
+    /// Has Schedule, so Future::Then and ResumeOn accept a strand as executor
+    class Strand : public std::enable_shared_from_this<Strand>
+    {
+        DISALLOW_COPY_AND_ASSIGN(Strand);
+
+        public:
+            /// Shared ptr type for strands, a scheduled strand keeps itself alive until its inbox is empty
+            using Ptr = std::shared_ptr<Strand>;
+
+        public:
+            /// Create strand
+            static Ptr Create();
+            /// Deconstructor, messages which have not run are dropped
+            ~Strand();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Post message, safe from any thread
+            /// @p_Function : Message
+            void Post(std::function<void()> p_Function);
+            /// Run message right away if called from this strand, post it otherwise
+            /// @p_Function : Message
+            void Dispatch(std::function<void()> p_Function);
+            /// Post message, executor interface of futures
+            /// @p_Function : Message
+            void Schedule(std::function<void()> p_Function);
+
+            /// Check if the calling thread is running a message of this strand
+            bool RunningInThisThread() const;
+            /// Get amount of messages posted and not run yet
+            uint32 GetPendingCount() const;
+
+        private:
+            /// Inbox node
+            struct Message
+            {
+                std::atomic<Message*>   Next;       ///< Next message
+                std::function<void()>   Function;   ///< Message, empty for the stub
+
+                /// Allocate from handler memory pool
+                /// @p_Size : Size of message
+                static void* operator new(std::size_t p_Size)
+                {
+                    return Network::HandlerMemoryPool::Allocate(p_Size);
+                }
+                /// Release to handler memory pool
+                /// @p_Pointer : Message
+                /// @p_Size    : Size of message
+                static void operator delete(void* p_Pointer, std::size_t p_Size)
+                {
+                    Network::HandlerMemoryPool::Deallocate(p_Pointer, p_Size);
+                }
+            };
+
+            /// Constructor
+            Strand();
+
+            /// Link message at the head of our inbox, safe from any thread
+            /// @p_Message : Message
+            void Push(Message* p_Message);
+            /// Unlink message at the tail of our inbox, only from the thread draining us
+            /// Returns nullptr if inbox is empty or a producer has not linked its message yet
+            Message* Pop();
+            /// Hand our inbox to a task worker
+            void Launch();
+            /// Run a batch of messages, launch again if more are pending
+            void Drain();
+
+        private:
+            std::atomic<Message*>   m_Head;         ///< Newest message, producers swap it
+            Message*                m_Tail;         ///< Oldest message, consumer only
+            Message                 m_Stub;         ///< Placeholder keeping the inbox linked when empty
+            std::atomic<uint32>     m_Pending;      ///< Messages posted and not run yet, the post making it leave 0 launches us
+
+    };
+
+}   ///< namespace Threading
+}   ///< namespace Core
+}   ///< namespace SteerStone
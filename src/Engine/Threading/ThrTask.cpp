@@ -22,6 +22,11 @@
 #include "Threading/ThrTask.hpp"
 
 #include "Logger/Base.hpp"
+#include "Diagnostic/DiaProfiler.hpp"
+#include "Diagnostic/DiaFlightRecorder.hpp"
+#include "Utility/UtiSymbolTable.hpp"
+
+#include <algorithm>
 
 namespace SteerStone { namespace Core { namespace Threading {
 
@@ -29,9 +34,11 @@ namespace SteerStone { namespace Core { namespace Threading {
     /// @p_Name     : Task name
     /// @p_TaskType : Task type
     Task::Task(const std::string & p_Name, TaskType p_TaskType)
-        : m_TaskName(p_Name), m_TaskType(p_TaskType), m_TaskTimer(-1), m_TaskTotalRunTime(0), m_TaskTotalRunCount(0), m_TaskAverageRunTime(0), m_TaskLastDiffTime(0)
+        : m_TaskName(p_Name), m_TaskType(p_TaskType), m_TaskGroup(TASK_NO_PLACEMENT_GROUP), m_TaskLogging(true), m_TaskNextRunTime(Clock::now()), m_TaskLastRunTime(m_TaskNextRunTime), m_TaskTotalRunTime(0), m_TaskTotalRunCount(0), m_TaskAverageRunTime(0), m_TaskLastDiffTime(0), m_TaskDecayedRunTime(0)
     {
         m_TaskStopWatch.Start();
+
+        m_TaskInternedName = Utils::GetSymbolString(Utils::Intern(p_Name));
     }
     /// Destructor
     Task::~Task()
@@ -48,6 +55,19 @@ namespace SteerStone { namespace Core { namespace Threading {
     {
         m_TaskType = p_TaskType;
     }
+    /// Set placement group, tasks of a group run on the same NUMA node (group modulo node count)
+    /// Must be set before the task is pushed
+    /// @p_Group : Placement group, TASK_NO_PLACEMENT_GROUP to run on any node
+    void Task::SetTaskPlacementGroup(int32 p_Group)
+    {
+        m_TaskGroup = p_Group < 0 ? TASK_NO_PLACEMENT_GROUP : p_Group;
+    }
+    /// Set if the task manager logs start and end of the task
+    /// @p_Logging : Log start and end
+    void Task::SetTaskLogging(bool p_Logging)
+    {
+        m_TaskLogging = p_Logging;
+    }
 
     /// Get name
     const std::string& Task::GetTaskName()
@@ -59,6 +79,16 @@ namespace SteerStone { namespace Core { namespace Threading {
     {
         return m_TaskType;
     }
+    /// Get placement group, TASK_NO_PLACEMENT_GROUP if task may run on any node
+    int32 Task::GetTaskPlacementGroup() const
+    {
+        return m_TaskGroup;
+    }
+    /// Check if the task manager logs start and end of the task
+    bool Task::IsTaskLogging() const
+    {
+        return m_TaskLogging;
+    }
     /// Get flags
     uint64 Task::GetTaskTotalRunTime() const
     {
@@ -79,28 +109,52 @@ namespace SteerStone { namespace Core { namespace Threading {
     {
         return m_TaskLastDiffTime;
     }
+    /// Get decayed execution time in microseconds
+    uint64 Task::GetTaskDecayedUpdateTime() const
+    {
+        return m_TaskDecayedRunTime;
+    }
+    /// Get decayed execution time per second in microseconds, the share of a worker the task uses
+    uint64 Task::GetTaskLoad() const
+    {
+        return m_TaskDecayedRunTime * 1000 / std::max<uint64>(GetTaskPeriod(), TASK_MINIMUM_PERIOD);
+    }
+    /// Get histogram of execution time
+    Diagnostic::LatencyHistogram & Task::GetTaskExecutionHistogram()
+    {
+        return m_TaskExecutionHistogram;
+    }
+    /// Get histogram of lateness, start of execution minus its deadline
+    Diagnostic::LatencyHistogram & Task::GetTaskLatenessHistogram()
+    {
+        return m_TaskLatenessHistogram;
+    }
 
     //////////////////////////////////////////////////////////////////////////
     //////////////////////////////////////////////////////////////////////////
 
-    /// Update
-    /// @p_Diff : Delta time between to run
-    bool Task::UpdateTaskTime(uint64 p_Diff)
+    /// Get time of next execution
+    Task::Clock::time_point Task::GetTaskNextRunTime() const
     {
-        int64 l_Elapsed = m_TaskStopWatch.GetElapsed();
-
-        //LOG_INFO("task", "timer %0, internval %1, diff %2", m_TaskTimer, GetTaskPeriod(), l_Elapsed);
-
-        m_TaskTimer       -= l_Elapsed;
-        m_TaskLastDiffTime = l_Elapsed;
-
-        m_TaskStopWatch.Reset();
-
-        return m_TaskTimer <= 0;
+        return m_TaskNextRunTime;
+    }
+    /// Check if task is due
+    /// @p_Now : Current time
+    bool Task::IsTaskDue(Clock::time_point p_Now) const
+    {
+        return m_TaskNextRunTime <= p_Now;
     }
-    /// Update
+    /// Update, next execution is one period after the deadline of this one
     bool Task::UpdateTask()
     {
+        PROFILE_ZONE(m_TaskInternedName);
+        Diagnostic::FlightRecorder::Record(Diagnostic::FlightEvent::TaskStart, m_TaskInternedName);
+
+        const Clock::time_point l_Start = Clock::now();
+
+        m_TaskLastDiffTime = std::chrono::duration_cast<std::chrono::milliseconds>(l_Start - m_TaskLastRunTime).count();
+        m_TaskLastRunTime  = l_Start;
+
         m_TaskStopWatch.Reset();
         bool l_Result = true;
 
@@ -117,12 +171,30 @@ namespace SteerStone { namespace Core { namespace Threading {
        //     LOG_ERROR("TheTask", R"LOG(UNKWNOWN Exception in task "%0")LOG", m_TaskName);
       //  }
 
+        Diagnostic::FlightRecorder::Record(Diagnostic::FlightEvent::TaskEnd, m_TaskInternedName);
+
         m_TaskTotalRunTime += m_TaskStopWatch.GetElapsed();
         m_TaskTotalRunCount++;
 
-        m_TaskAverageRunTime = static_cast<uint32>(m_TaskTotalRunTime / m_TaskTotalRunCount);
+        m_TaskAverageRunTime = m_TaskTotalRunTime / m_TaskTotalRunCount;
+
+        const Clock::time_point l_Now = Clock::now();
+
+        m_TaskExecutionHistogram.Record(l_Now - l_Start);
+        m_TaskLatenessHistogram.Record(l_Start - m_TaskNextRunTime);
+
+        /// Recent runs weigh more, a task which became expensive is noticed within a few runs
+        const int64 l_RunTime = std::chrono::duration_cast<std::chrono::microseconds>(l_Now - l_Start).count();
+        const int64 l_Decayed = static_cast<int64>(m_TaskDecayedRunTime.load());
+        m_TaskDecayedRunTime  = static_cast<uint64>(l_Decayed + ((l_RunTime - l_Decayed) / (1 << TASK_COST_DECAY_SHIFT)));
+
+        /// Deadlines advance by whole periods so ticks do not drift, missed ticks are skipped rather than run back to back
+        const Clock::duration l_Period = std::chrono::milliseconds(std::min<uint64>(std::max<uint64>(GetTaskPeriod(), TASK_MINIMUM_PERIOD), TASK_MAXIMUM_PERIOD));
+
+        m_TaskNextRunTime += l_Period;
 
-        m_TaskTimer = static_cast<float>(GetTaskPeriod()) * 0.80f;
+        if (m_TaskNextRunTime <= l_Now)
+            m_TaskNextRunTime += l_Period * ((l_Now - m_TaskNextRunTime) / l_Period + 1);
 
         return l_Result;
     }
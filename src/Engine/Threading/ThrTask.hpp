@@ -21,9 +21,17 @@
 
 #include "Core/Core.hpp"
 #include "Diagnostic/DiaStopWatch.hpp"
+#include "Diagnostic/DiaFastClock.hpp"
+#include "Diagnostic/DiaHistogram.hpp"
 
 #include <memory>
 #include <atomic>
+#include <chrono>
+
+#define TASK_MINIMUM_PERIOD     1                       ///< Tasks with a shorter period in MS run at most this often
+#define TASK_MAXIMUM_PERIOD     (24 * 60 * 60 * 1000)   ///< Longer periods (such as -1 for tasks which never return) are clamped to this
+#define TASK_COST_DECAY_SHIFT   3                       ///< Decayed execution time moves by 1 / (1 << shift) of the difference on each run
+#define TASK_NO_PLACEMENT_GROUP -1                      ///< Task may run on any NUMA node
 
 namespace SteerStone { namespace Core { namespace Threading {
 
@@ -32,7 +40,8 @@ namespace SteerStone { namespace Core { namespace Threading {
     {
         Normal,         ///< Support multiple tasks
         Moderate,       ///< Execute one and only task
-        Critical        ///< Execute task regardless of hardware concurrency
+        Critical,       ///< Execute task regardless of hardware concurrency
+        Dedicated       ///< Long running loop on a thread of its own, outside of the worker pool
     };
 
     //////////////////////////////////////////////////////////////////////////
@@ -49,6 +58,8 @@ namespace SteerStone { namespace Core { namespace Threading {
         public:
             /// Shared ptr type for tasks
             using Ptr = std::shared_ptr<Task>;
+            /// Clock of run deadlines, read at every execution so it uses the TSC
+            using Clock = Diagnostic::FastClock;
 
         public:
             /// Constructor
@@ -61,11 +72,22 @@ namespace SteerStone { namespace Core { namespace Threading {
             /// Set Task
             /// @p_TaskType : Task type
             void SetTaskType(TaskType p_TaskType);
+            /// Set placement group, tasks of a group run on the same NUMA node (group modulo node count)
+            /// Must be set before the task is pushed
+            /// @p_Group : Placement group, TASK_NO_PLACEMENT_GROUP to run on any node
+            void SetTaskPlacementGroup(int32 p_Group);
+            /// Set if the task manager logs start and end of the task
+            /// @p_Logging : Log start and end
+            void SetTaskLogging(bool p_Logging);
 
             /// Get name
             const std::string & GetTaskName();
             /// Get flags
             TaskType GetTaskType() const;
+            /// Get placement group, TASK_NO_PLACEMENT_GROUP if task may run on any node
+            int32 GetTaskPlacementGroup() const;
+            /// Check if the task manager logs start and end of the task
+            bool IsTaskLogging() const;
             /// Get flags
             uint64 GetTaskTotalRunTime() const;
             /// Get flags
@@ -74,11 +96,22 @@ namespace SteerStone { namespace Core { namespace Threading {
             uint64 GetTaskAverageUpdateTime() const;
             /// Get last diff time
             uint64 GetTaskLastDiffTime() const;
-
-            /// Update
-            /// @p_Diff : Delta time between to run
-            bool UpdateTaskTime(uint64 p_Diff);
-            /// Update
+            /// Get decayed execution time in microseconds
+            uint64 GetTaskDecayedUpdateTime() const;
+            /// Get decayed execution time per second in microseconds, the share of a worker the task uses
+            uint64 GetTaskLoad() const;
+            /// Get histogram of execution time
+            Diagnostic::LatencyHistogram & GetTaskExecutionHistogram();
+            /// Get histogram of lateness, start of execution minus its deadline
+            Diagnostic::LatencyHistogram & GetTaskLatenessHistogram();
+
+            /// Get time of next execution
+            Clock::time_point GetTaskNextRunTime() const;
+            /// Check if task is due
+            /// @p_Now : Current time
+            bool IsTaskDue(Clock::time_point p_Now) const;
+
+            /// Update, next execution is one period after the deadline of this one
             bool UpdateTask();
 
             /// Get period
@@ -90,14 +123,22 @@ namespace SteerStone { namespace Core { namespace Threading {
         private:
             std::string m_TaskName;     ///< Name
             TaskType    m_TaskType;     ///< Type
-            int64       m_TaskTimer;    ///< Time until next execution in MS
+            int32       m_TaskGroup;    ///< Placement group
+            bool        m_TaskLogging;  ///< Log start and end
+            std::string_view m_TaskInternedName;        ///< Interned name, profile zones and the flight recorder keep it past the task
+
+            Clock::time_point m_TaskNextRunTime;        ///< Deadline of next execution
+            Clock::time_point m_TaskLastRunTime;        ///< Start of last execution
 
             std::atomic_uint64_t m_TaskTotalRunTime;    ///< Total run time
             std::atomic_uint64_t m_TaskTotalRunCount;   ///< Total run count
             std::atomic_uint64_t m_TaskAverageRunTime;  ///< Avg execution time
             std::atomic_uint64_t m_TaskLastDiffTime;    ///< Last diff time
+            std::atomic_uint64_t m_TaskDecayedRunTime;  ///< Decayed execution time in microseconds
 
             Diagnostic::StopWatch m_TaskStopWatch;      ///< Stop watch
+            Diagnostic::LatencyHistogram m_TaskExecutionHistogram;  ///< Execution time
+            Diagnostic::LatencyHistogram m_TaskLatenessHistogram;   ///< Start of execution minus its deadline
     };
 
 }   ///< namespace Threading
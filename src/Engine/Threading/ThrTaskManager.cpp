@@ -23,20 +23,59 @@
 #include "Threading/ThrLambdaTask.hpp"
 
 #include "Logger/Base.hpp"
+#include "Memory/MemObjectPool.hpp"
+#include "Metrics/MetRegistry.hpp"
 
 #include <algorithm>
+#include <limits>
 #include <math.h>
 
 namespace SteerStone { namespace Core { namespace Threading {
 
     SINGLETON_P_I(TaskManager);
 
+    /// Write cost model of every polling worker on scrape
+    /// @p_Writer : Metric writer
+    /// @p_Stats  : Cost model of every polling worker
+    static void WriteMetrics(Metrics::MetricWriter& p_Writer, std::vector<TaskWorkerStats> const& p_Stats)
+    {
+        std::vector<Metrics::MetricLabels> l_Labels;
+        l_Labels.reserve(p_Stats.size());
+
+        for (TaskWorkerStats const& l_Stats : p_Stats)
+            l_Labels.push_back({ { "worker", l_Stats.Name } });
+
+        p_Writer.WriteFamily("steerstone_task_worker_tasks", "Tasks placed on worker", Metrics::MetricType::Gauge);
+        for (std::size_t l_I = 0; l_I < p_Stats.size(); ++l_I)
+            p_Writer.WriteSample("steerstone_task_worker_tasks", l_Labels[l_I], static_cast<uint64>(p_Stats[l_I].TaskCount));
+
+        p_Writer.WriteFamily("steerstone_task_worker_utilization", "Decayed share of time worker spends executing, from 0 to 1", Metrics::MetricType::Gauge);
+        for (std::size_t l_I = 0; l_I < p_Stats.size(); ++l_I)
+            p_Writer.WriteSample("steerstone_task_worker_utilization", l_Labels[l_I], static_cast<double>(p_Stats[l_I].Utilization));
+
+        p_Writer.WriteFamily("steerstone_task_worker_average_update_seconds", "Average execution time of a worker update since start", Metrics::MetricType::Gauge);
+        for (std::size_t l_I = 0; l_I < p_Stats.size(); ++l_I)
+            p_Writer.WriteSample("steerstone_task_worker_average_update_seconds", l_Labels[l_I], static_cast<double>(p_Stats[l_I].AverageUpdateTime) * 1e-3);
+
+        p_Writer.WriteFamily("steerstone_task_worker_decayed_update_seconds", "Decayed execution time of a worker update", Metrics::MetricType::Gauge);
+        for (std::size_t l_I = 0; l_I < p_Stats.size(); ++l_I)
+            p_Writer.WriteSample("steerstone_task_worker_decayed_update_seconds", l_Labels[l_I], static_cast<double>(p_Stats[l_I].DecayedUpdateTime) * 1e-6);
+
+        p_Writer.WriteFamily("steerstone_task_worker_execution_p99_seconds", "99th percentile of task run time on worker since last report", Metrics::MetricType::Gauge);
+        for (std::size_t l_I = 0; l_I < p_Stats.size(); ++l_I)
+            p_Writer.WriteSample("steerstone_task_worker_execution_p99_seconds", l_Labels[l_I], static_cast<double>(p_Stats[l_I].ExecutionP99) * 1e-9);
+
+        p_Writer.WriteFamily("steerstone_task_worker_lateness_p99_seconds", "99th percentile of task start past its deadline on worker since last report", Metrics::MetricType::Gauge);
+        for (std::size_t l_I = 0; l_I < p_Stats.size(); ++l_I)
+            p_Writer.WriteSample("steerstone_task_worker_lateness_p99_seconds", l_Labels[l_I], static_cast<double>(p_Stats[l_I].LatenessP99) * 1e-9);
+    }
+
     //////////////////////////////////////////////////////////////////////////
     //////////////////////////////////////////////////////////////////////////
 
     /// Constructor
     TaskManager::TaskManager()
-        : m_LogTasks(true)
+        : m_LogTasks(true), m_WorkerSequence(0), m_MinWorkerCount(0), m_MaxWorkerCount(0), m_NextNode(0), m_Mode(SchedulerMode::Polling)
     {
         #ifdef STEERSTONE_CORE_DEBUG
             LOG_INFO("ThrTaskManager", "Initialized");
@@ -45,13 +84,29 @@ namespace SteerStone { namespace Core { namespace Threading {
         /// Default interval is 2 minutes
         m_OptimizeTask = std::make_shared<OptimizeTask>(10 * 1000);
 
-        /// By default we are using all CPU cores but not the first one
-        SetWorkerCount(std::thread::hardware_concurrency() - 1);
+        for (auto & l_Setting : m_Affinity)
+            l_Setting.Policy = AffinityPolicy::Core;
+
+        /// First CPU is picked last, to save some CPU for the kernel
+        m_CPUUsage[sCPUTopology->GetCPUs().front().Id] = 1;
+
+        /// By default we are using all usable CPU cores but one
+        SetWorkerCount(GetWorkerLimit());
         PushTask(m_OptimizeTask);
+
+        m_MetricsCollector = sMetrics->AddCollector([this](Metrics::MetricWriter& p_Writer) { WriteMetrics(p_Writer, GetWorkerStats()); });
     }
     /// Destructor
     TaskManager::~TaskManager()
     {
+        sMetrics->RemoveCollector(m_MetricsCollector);
+
+        /// Scheduler workers run our tasks, stop them first
+        for (auto & l_Scheduled : m_ScheduledTasks)
+            l_Scheduled.second->Active = false;
+
+        m_Scheduler.reset();
+
         LOG_INFO("ThrTaskManager", "Destroyed");
     }
 
@@ -62,55 +117,70 @@ namespace SteerStone { namespace Core { namespace Threading {
     /// @p_Task : Task to push
     void TaskManager::PushTask(const Task::Ptr & p_Task)
     {
-        if (m_LogTasks)
+        if (m_LogTasks && p_Task->IsTaskLogging())
             LOG_INFO("ThrTaskManager", "Task %0 started", p_Task->GetTaskName());
 
         std::lock_guard<std::recursive_mutex> l_Lock(m_Mutex);
 
-        if (p_Task->GetTaskType() == TaskType::Critical)
+        if (p_Task->GetTaskType() == TaskType::Critical || p_Task->GetTaskType() == TaskType::Dedicated)
         {
-            TaskWorker * l_CriticalWorker = new TaskWorker(WorkerType::Exclusive);
+            const bool                  l_Critical  = p_Task->GetTaskType() == TaskType::Critical;
+            std::vector<TaskWorker*>&   l_Workers   = l_Critical ? m_CriticalTaskWorkers : m_DedicatedTaskWorkers;
+            TaskWorker *                l_Worker    = new TaskWorker(WorkerType::Exclusive);
 
-            /// Skip CPU 0 at first iteration, to save some CPU for the kernel
-            l_CriticalWorker->SetCPUAffinty((m_CriticalTaskWorkers.size() + 1) % std::thread::hardware_concurrency());
-            l_CriticalWorker->SetName(Utils::StringBuilder("CriticalTaskWorker_%0", m_CriticalTaskWorkers.size()));
-            l_CriticalWorker->PushTask(p_Task);
+            /// Dedicated threads are pinned like exclusive workers, they take over their job
+            PinWorker(l_Worker, l_Critical ? AffinityClass::Critical : AffinityClass::Exclusive, GetGroupNode(p_Task->GetTaskPlacementGroup()));
+            l_Worker->SetName(Utils::StringBuilder(l_Critical ? "CriticalTaskWorker_%0" : "DedicatedTaskWorker_%0", l_Workers.size()));
+            l_Worker->PushTask(p_Task);
 
-            m_CriticalTaskWorkers.push_back(l_CriticalWorker);
+            l_Workers.push_back(l_Worker);
         }
         else if (p_Task->GetTaskType() == TaskType::Moderate)
         {
+            const int32 l_Node      = GetGroupNode(p_Task->GetTaskPlacementGroup());
+            TaskWorker* l_FreeWorker = nullptr;
+
+            /// Prefer a free worker already on the node of the group
             for (std::size_t l_I = 0; l_I < m_ExclusiveTaskWorkers.size(); l_I++)
             {
                 TaskWorker* l_CurrentWorker = m_ExclusiveTaskWorkers[l_I];
 
-                if (l_CurrentWorker->GetTaskSize() == 0)
+                if (l_CurrentWorker->GetTaskSize() != 0)
+                    continue;
+
+                if (!l_FreeWorker)
+                    l_FreeWorker = l_CurrentWorker;
+
+                if (l_Node == -1 || GetWorkerNode(l_CurrentWorker) == l_Node)
                 {
-                    l_CurrentWorker->PushTask(p_Task);
-                    return;
+                    l_FreeWorker = l_CurrentWorker;
+                    break;
                 }
             }
 
-            p_Task->SetTaskType(TaskType::Critical);
+            if (l_FreeWorker)
+            {
+                if (l_Node != -1 && GetWorkerNode(l_FreeWorker) != l_Node)
+                    PinWorker(l_FreeWorker, AffinityClass::Exclusive, l_Node);
+
+                l_FreeWorker->PushTask(p_Task);
+                return;
+            }
+
+            p_Task->SetTaskType(TaskType::Dedicated);
             PushTask(p_Task);
 
-            LOG_WARNING("ThrTaskManager", "Could not add exclusive task %0. Re-adding task as Critical", p_Task->GetTaskName());
+            LOG_WARNING("ThrTaskManager", "Could not add exclusive task %0. Re-adding task as Dedicated", p_Task->GetTaskName());
+        }
+        else if (m_Mode == SchedulerMode::WorkStealing)
+        {
+            m_Tasks.push_back(p_Task);
+            ScheduleTask(p_Task);
         }
         else
         {
-            if (!m_InclusiveTaskWorkers.empty())
-            {
-                TaskWorker *    l_CurrentWorker         = m_InclusiveTaskWorkers.at(0);
-                uint64          l_MinAverageUpdateTime  = l_CurrentWorker->GetAverageUpdateTime();
-
-                for (std::size_t l_I = 1; l_I < m_InclusiveTaskWorkers.size(); ++l_I)
-                {
-                    if (m_InclusiveTaskWorkers[l_I]->GetAverageUpdateTime() < l_MinAverageUpdateTime)
-                        l_CurrentWorker = m_InclusiveTaskWorkers[l_I];
-                }
-
-                l_CurrentWorker->PushTask(p_Task);
-            }
+            if (TaskWorker* l_Worker = PickInclusiveWorker(GetGroupNode(p_Task->GetTaskPlacementGroup())))
+                l_Worker->PushTask(p_Task);
 
             m_Tasks.push_back(p_Task);
 
@@ -123,9 +193,11 @@ namespace SteerStone { namespace Core { namespace Threading {
     /// @p_TaskType : Task Type
     /// @p_Period   : Task interval
     /// @p_Function : Task
-    Task::Ptr TaskManager::PushTask(const std::string & p_Name, const TaskType p_TaskType, uint64 p_Period, const std::function<bool()> & p_Function)
+    /// @p_Group    : Placement group, TASK_NO_PLACEMENT_GROUP to run on any NUMA node
+    Task::Ptr TaskManager::PushTask(const std::string & p_Name, const TaskType p_TaskType, uint64 p_Period, const std::function<bool()> & p_Function, int32 p_Group)
     {
-        const Task::Ptr l_Task = std::make_shared<LambdaTask>(p_Name, p_TaskType, p_Period, p_Function);
+        const Task::Ptr l_Task = Memory::ObjectPool<LambdaTask>::MakeShared(p_Name, p_TaskType, p_Period, p_Function);
+        l_Task->SetTaskPlacementGroup(p_Group);
 
         PushTask(l_Task);
 
@@ -146,11 +218,26 @@ namespace SteerStone { namespace Core { namespace Threading {
     /// @p_Function : Task
     Task::Ptr TaskManager::PushRunOnceTask(const std::string & p_Name, const TaskType p_TaskType, const std::function<void()> & p_Function)
     {
-        const Task::Ptr l_Task = std::make_shared<LambdaTask>(p_Name, p_TaskType, 0, [p_Function]() -> bool {
+        const Task::Ptr l_Task = Memory::ObjectPool<LambdaTask>::MakeShared(p_Name, p_TaskType, 0, [p_Function]() -> bool {
             p_Function();
             return false;
         });
 
+        /// Jobs come and go all the time, logging each one floods the log
+        l_Task->SetTaskLogging(false);
+
+        /// Goes straight onto a deque, it is never polled
+        if (p_TaskType == TaskType::Normal)
+        {
+            std::lock_guard<std::recursive_mutex> l_Lock(m_Mutex);
+
+            if (m_Mode == SchedulerMode::WorkStealing)
+            {
+                m_Scheduler->Schedule([l_Task]() { l_Task->UpdateTask(); });
+                return l_Task;
+            }
+        }
+
         PushTask(l_Task);
 
         return l_Task;
@@ -163,31 +250,82 @@ namespace SteerStone { namespace Core { namespace Threading {
         const std::string l_TaskName = Utils::StringBuilder("ANONYMOUS_RUN_ONCE_LAMBDA_%0", clock());
         return PushRunOnceTask(l_TaskName, p_TaskType, p_Function);
     }
+    /// Run job once on a worker running normal tasks, no task name is built
+    /// Executor interface of futures, strands and parallel loops
+    /// @p_Function : Job
+    void TaskManager::Schedule(std::function<void()> p_Function)
+    {
+        {
+            std::lock_guard<std::recursive_mutex> l_Lock(m_Mutex);
+
+            if (m_Mode == SchedulerMode::WorkStealing)
+            {
+                m_Scheduler->Schedule(std::move(p_Function));
+                return;
+            }
+        }
+
+        /// Short enough to stay in the small string buffer of the task name
+        static const std::string s_JobName = "RUN_ONCE_JOB";
+
+        const Task::Ptr l_Task = Memory::ObjectPool<LambdaTask>::MakeShared(s_JobName, TaskType::Normal, 0, [l_Function = std::move(p_Function)]() -> bool {
+            l_Function();
+            return false;
+        });
+
+        l_Task->SetTaskLogging(false);
+
+        PushTask(l_Task);
+    }
+    /// Get amount of workers running normal tasks
+    uint32 TaskManager::GetConcurrency()
+    {
+        std::lock_guard<std::recursive_mutex> l_Lock(m_Mutex);
+
+        if (m_Mode == SchedulerMode::WorkStealing)
+            return m_Scheduler->GetWorkerCount();
+
+        return static_cast<uint32>(m_InclusiveTaskWorkers.size());
+    }
     /// Pop task
     /// @p_Task : Task to pop
     void TaskManager::PopTask(const Task::Ptr & p_Task)
     {
-        if (m_LogTasks)
+        if (m_LogTasks && p_Task->IsTaskLogging())
             LOG_WARNING("ThrTaskManager", "Task %0 ended", p_Task->GetTaskName());
 
         std::lock_guard<std::recursive_mutex> l_Lock(m_Mutex);
 
-        if (p_Task->GetTaskType() == TaskType::Critical)
+        if (p_Task->GetTaskType() == TaskType::Critical || p_Task->GetTaskType() == TaskType::Dedicated)
         {
-            auto l_It = std::find_if(m_CriticalTaskWorkers.begin(), m_CriticalTaskWorkers.end(), [&p_Task](TaskWorker * p_Worker) -> bool {
+            std::vector<TaskWorker*>& l_Workers = p_Task->GetTaskType() == TaskType::Critical ? m_CriticalTaskWorkers : m_DedicatedTaskWorkers;
+
+            auto l_It = std::find_if(l_Workers.begin(), l_Workers.end(), [&p_Task](TaskWorker * p_Worker) -> bool {
                 return p_Worker->HaveTask(p_Task);
             });
 
-            if (l_It == m_CriticalTaskWorkers.end())
+            if (l_It == l_Workers.end())
                 return;
 
             TaskWorker * l_Worker = *l_It;
+            l_Workers.erase(l_It);
+
+            ReleaseCPUs(l_Worker->GetCPUAffinity());
+
+            /// A task ending itself runs on the thread we would join, the thread stops once the task returns
+            if (l_Worker->IsCurrentThread())
+            {
+                l_Worker->PreSuspend();
+                l_Worker->PopAll();
+
+                m_RetiredTaskWorkers.push_back(l_Worker);
+                return;
+            }
+
             l_Worker->Suspend();
             l_Worker->PopAll();
 
             delete l_Worker;
-
-            m_CriticalTaskWorkers.erase(l_It);
         }
         else if (p_Task->GetTaskType() == TaskType::Moderate)
         {
@@ -196,6 +334,13 @@ namespace SteerStone { namespace Core { namespace Threading {
         }
         else
         {
+            auto l_Scheduled = m_ScheduledTasks.find(p_Task.get());
+            if (l_Scheduled != m_ScheduledTasks.end())
+            {
+                l_Scheduled->second->Active = false;
+                m_ScheduledTasks.erase(l_Scheduled);
+            }
+
             auto l_It = std::find(m_Tasks.begin(), m_Tasks.end(), p_Task);
 
             if (l_It == m_Tasks.end())
@@ -218,90 +363,252 @@ namespace SteerStone { namespace Core { namespace Threading {
 
         return m_Tasks;
     }
+    /// Get cost model of every polling worker, critical workers included
+    std::vector<TaskWorkerStats> TaskManager::GetWorkerStats()
+    {
+        std::lock_guard<std::recursive_mutex> l_Lock(m_Mutex);
+
+        std::vector<TaskWorkerStats> l_Stats;
+        l_Stats.reserve(m_InclusiveTaskWorkers.size() + m_ExclusiveTaskWorkers.size() + m_CriticalTaskWorkers.size() + m_DedicatedTaskWorkers.size());
+
+        for (auto l_Workers : { &m_InclusiveTaskWorkers, &m_ExclusiveTaskWorkers, &m_CriticalTaskWorkers, &m_DedicatedTaskWorkers })
+        {
+            for (auto l_Worker : *l_Workers)
+            {
+                Diagnostic::LatencyHistogram const& l_Execution    = l_Worker->GetExecutionHistogram();
+                Diagnostic::LatencyHistogram const& l_Lateness     = l_Worker->GetLatenessHistogram();
+
+                l_Stats.push_back({ l_Worker->GetName(), l_Worker->GetWorkerType(), l_Worker->GetTaskSize(), l_Worker->GetLoad(), l_Worker->GetDecayedUpdateTime(), l_Worker->GetAverageUpdateTime(), l_Worker->GetUtilization(),
+                    l_Execution.GetP99(), l_Execution.GetMax(), l_Lateness.GetP99(), l_Lateness.GetMax() });
+            }
+        }
+
+        return l_Stats;
+    }
+    /// Clear latency histograms of every task and polling worker, for periodic reporting
+    void TaskManager::ResetLatencyHistograms()
+    {
+        std::lock_guard<std::recursive_mutex> l_Lock(m_Mutex);
+
+        for (auto l_Workers : { &m_InclusiveTaskWorkers, &m_ExclusiveTaskWorkers, &m_CriticalTaskWorkers, &m_DedicatedTaskWorkers })
+        {
+            for (auto l_Worker : *l_Workers)
+            {
+                l_Worker->GetExecutionHistogram().Reset();
+                l_Worker->GetLatenessHistogram().Reset();
+
+                /// Moderate and critical tasks are only known by their worker
+                for (auto & l_Task : l_Worker->GetTasks())
+                {
+                    l_Task->GetTaskExecutionHistogram().Reset();
+                    l_Task->GetTaskLatenessHistogram().Reset();
+                }
+            }
+        }
+
+        for (auto & l_Task : m_Tasks)
+        {
+            l_Task->GetTaskExecutionHistogram().Reset();
+            l_Task->GetTaskLatenessHistogram().Reset();
+        }
+    }
 
     //////////////////////////////////////////////////////////////////////////
     //////////////////////////////////////////////////////////////////////////
 
-    /// Set worker count
+    /// Set amount of pool workers (inclusive and exclusive), safe at runtime
+    /// Tasks of removed inclusive workers are drained onto the remaining ones, only idle exclusive workers are removed,
+    /// a worker does not remove itself. Dedicated and critical workers are not part of the pool
     /// @p_Count : Worker count
     void TaskManager::SetWorkerCount(uint32 p_Count)
     {
-        std::lock_guard<std::recursive_mutex> l_Lock(m_Mutex);
+        std::unique_lock<std::recursive_mutex> l_Lock(m_Mutex);
 
-        const uint32 l_TaskWorkerCount = m_InclusiveTaskWorkers.size() + m_ExclusiveTaskWorkers.size();
+        if (p_Count == m_InclusiveTaskWorkers.size() + m_ExclusiveTaskWorkers.size())
+            return;
 
-        if (p_Count == l_TaskWorkerCount)
+        if (p_Count == 0 || p_Count > GetWorkerLimit())
+        {
+            LOG_ERROR("ThrTaskManager", "Cannot run %0 workers, at most %1 fit on %2 usable CPUs", p_Count, GetWorkerLimit(), sCPUTopology->GetUsableCPUCount());
             return;
+        }
 
-        if (p_Count >= std::thread::hardware_concurrency())
+        /// Scheduler threads stand in for our inclusive workers, the scheduler is built again on the new pool
+        if (m_Mode == SchedulerMode::WorkStealing)
         {
-            LOG_ERROR("ThrTaskManager", "To many workers for actual CPU unit", p_Count);
+            if (m_Scheduler->IsWorkerThread())
+            {
+                LOG_ERROR("ThrTaskManager", "Work stealing pool cannot be resized from one of its workers");
+                return;
+            }
+
+            l_Lock.unlock();
+
+            SetSchedulerMode(SchedulerMode::Polling);
+            SetWorkerCount(p_Count);
+            SetSchedulerMode(SchedulerMode::WorkStealing);
             return;
         }
 
-        if (p_Count < l_TaskWorkerCount)
+        const uint32 l_ExclusiveCount = GetExclusiveCount(p_Count);
+        const uint32 l_InclusiveCount = p_Count - l_ExclusiveCount;
+
+        std::vector<TaskWorker*> l_Removed;
+
+        /// Moderate tasks never move, only idle exclusive workers go
+        for (std::size_t l_I = m_ExclusiveTaskWorkers.size(); l_I-- > 0 && m_ExclusiveTaskWorkers.size() > l_ExclusiveCount;)
         {
-            const std::size_t l_ExclusiveCount = std::floor(p_Count * EXLUSIVE_CURRENCY_COUNT);
-            const std::size_t l_InclusiveCount = p_Count - l_ExclusiveCount;
+            if (m_ExclusiveTaskWorkers[l_I]->GetTaskSize() != 0)
+                continue;
 
-            auto l_WorkersCopy = m_InclusiveTaskWorkers;
-            m_InclusiveTaskWorkers.resize(l_InclusiveCount);
+            l_Removed.push_back(m_ExclusiveTaskWorkers[l_I]);
+            m_ExclusiveTaskWorkers.erase(m_ExclusiveTaskWorkers.begin() + l_I);
+        }
 
-            for (size_t l_I = l_InclusiveCount; l_I < l_WorkersCopy.size(); ++l_I)
-            {
-                TaskWorker* l_Worker = l_WorkersCopy[l_I];
-                l_Worker->Suspend();
+        /// A worker cannot join itself, it stays
+        for (std::size_t l_I = m_InclusiveTaskWorkers.size(); l_I-- > 0 && m_InclusiveTaskWorkers.size() > l_InclusiveCount;)
+        {
+            if (m_InclusiveTaskWorkers[l_I]->IsCurrentThread())
+                continue;
 
-                delete l_Worker;
-            }
+            l_Removed.push_back(m_InclusiveTaskWorkers[l_I]);
+            m_InclusiveTaskWorkers.erase(m_InclusiveTaskWorkers.begin() + l_I);
+        }
 
-            l_WorkersCopy = m_ExclusiveTaskWorkers;
-            m_InclusiveTaskWorkers.resize(l_InclusiveCount);
+        while (m_ExclusiveTaskWorkers.size() < l_ExclusiveCount)
+        {
+            TaskWorker* l_Worker = new TaskWorker(WorkerType::Exclusive);
 
-            for (size_t l_I = l_ExclusiveCount; l_I < l_WorkersCopy.size(); ++l_I)
-            {
-                TaskWorker* l_Worker = l_WorkersCopy[l_I];
-                l_Worker->Suspend();
+            PinWorker(l_Worker, AffinityClass::Exclusive, -1);
+            l_Worker->SetName(Utils::StringBuilder("TaskWorker_%0", m_WorkerSequence++));
 
-                delete l_Worker;
-            }
+            m_ExclusiveTaskWorkers.push_back(l_Worker);
+        }
 
-            LOG_INFO("ThrTaskManager", "Set to %0 Exclusive Workers", l_ExclusiveCount);
-            LOG_INFO("ThrTaskManager", "Set to %0 Inclusive Workers", l_InclusiveCount);
+        while (m_InclusiveTaskWorkers.size() < l_InclusiveCount)
+        {
+            TaskWorker * l_Worker = new TaskWorker(WorkerType::Inclusive);
+
+            PinWorker(l_Worker, AffinityClass::Inclusive, -1);
+            l_Worker->SetName(Utils::StringBuilder("TaskWorker_%0", m_WorkerSequence++));
+
+            m_InclusiveTaskWorkers.push_back(l_Worker);
         }
-        else if (p_Count > l_TaskWorkerCount)
+
+        if (!l_Removed.empty())
         {
-            const uint32 l_HardwareConcurency = std::thread::hardware_concurrency() - 1;
-            const uint32 l_ExclusiveCount     = std::floor(p_Count * EXLUSIVE_CURRENCY_COUNT);
+            for (auto l_Worker : l_Removed)
+                l_Worker->PreSuspend();
+
+            /// Tasks being executed may need our mutex to finish
+            l_Lock.unlock();
 
-            LOG_ASSERT(l_ExclusiveCount, "ThrTaskManager", "ERROR: MONGOOSE. Please refer to SteerStone Documentation.");
+            for (auto l_Worker : l_Removed)
+                l_Worker->Suspend();
+
+            l_Lock.lock();
 
-            for (size_t l_I = m_ExclusiveTaskWorkers.size(); l_I < l_ExclusiveCount; ++l_I)
+            for (auto l_Worker : l_Removed)
             {
-                TaskWorker* l_Worker = new TaskWorker(WorkerType::Exclusive);
+                /// Tasks popped while we waited are gone for good
+                for (auto & l_Task : l_Worker->GetTasks())
+                {
+                    if (std::find(m_Tasks.begin(), m_Tasks.end(), l_Task) == m_Tasks.end())
+                        continue;
+
+                    if (TaskWorker* l_Target = PickInclusiveWorker(GetGroupNode(l_Task->GetTaskPlacementGroup())))
+                        l_Target->PushTask(l_Task);
+                }
 
-                /// Skip CPU 0 at first iteration, to save some CPU for the kernel
-                l_Worker->SetCPUAffinty(static_cast<int32>((l_I + 1) % l_HardwareConcurency));
-                l_Worker->SetName(Utils::StringBuilder("TaskWorker_%0", l_I));
+                l_Worker->PopAll();
 
-                m_ExclusiveTaskWorkers.push_back(l_Worker);
+                ReleaseCPUs(l_Worker->GetCPUAffinity());
+                delete l_Worker;
             }
+        }
+
+        LOG_INFO("ThrTaskManager", "Set to %0 Exclusive Workers", m_ExclusiveTaskWorkers.size());
+        LOG_INFO("ThrTaskManager", "Set to %0 Inclusive Workers", m_InclusiveTaskWorkers.size());
+    }
+    /// Get amount of pool workers (inclusive and exclusive)
+    uint32 TaskManager::GetWorkerCount()
+    {
+        std::lock_guard<std::recursive_mutex> l_Lock(m_Mutex);
 
-            const std::size_t l_InclusiveCount = (p_Count - l_ExclusiveCount) + m_ExclusiveTaskWorkers.size();
+        return static_cast<uint32>(m_InclusiveTaskWorkers.size() + m_ExclusiveTaskWorkers.size());
+    }
+    /// Get maximum amount of pool workers : usable CPUs but one, left to the kernel and dedicated threads
+    uint32 TaskManager::GetWorkerLimit() const
+    {
+        const uint32 l_Usable = sCPUTopology->GetUsableCPUCount();
 
-            for (size_t l_I = m_InclusiveTaskWorkers.size() + m_ExclusiveTaskWorkers.size(); l_I < l_InclusiveCount; ++l_I)
-            {
-                TaskWorker * l_Worker = new TaskWorker(WorkerType::Inclusive);
+        return l_Usable > 1 ? l_Usable - 1 : 1;
+    }
+    /// Let the pool follow load between p_Min and p_Max workers, safe at runtime
+    /// @p_Min : Minimum worker count
+    /// @p_Max : Maximum worker count, 0 to disable load driven resizing
+    void TaskManager::SetWorkerScaling(uint32 p_Min, uint32 p_Max)
+    {
+        std::lock_guard<std::recursive_mutex> l_Lock(m_Mutex);
+
+        if (p_Max == 0)
+        {
+            m_MinWorkerCount = 0;
+            m_MaxWorkerCount = 0;
+            return;
+        }
 
-                l_Worker->SetCPUAffinty(static_cast<int32>((l_I + 1) % l_HardwareConcurency));
-                l_Worker->SetName(Utils::StringBuilder("TaskWorker_%0", l_I));
+        m_MaxWorkerCount = std::min(p_Max, GetWorkerLimit());
+        m_MinWorkerCount = std::max<uint32>(1, std::min(p_Min, m_MaxWorkerCount));
 
-                m_InclusiveTaskWorkers.push_back(l_Worker);
-            }
+        /// Next pass moves a pool out of range right away
+        m_LastScale = std::chrono::steady_clock::time_point();
+
+        LOG_INFO("ThrTaskManager", "Pool follows load between %0 and %1 workers", m_MinWorkerCount, m_MaxWorkerCount);
+    }
+    /// Grow or shrink the pool by one worker from measured utilization of inclusive workers, run by the optimize task
+    /// Polling mode only, parked work stealing workers cost nothing. Must not be called while holding our mutex
+    void TaskManager::ScaleWorkers()
+    {
+        ReapWorkers();
 
-            LOG_INFO("ThrTaskManager", "Set to %0 Exclusive Workers", l_ExclusiveCount);
-            LOG_INFO("ThrTaskManager", "Set to %0 Inclusive Workers", (p_Count - l_ExclusiveCount));
+        std::unique_lock<std::recursive_mutex> l_Lock(m_Mutex);
+
+        if (m_MaxWorkerCount == 0 || m_Mode == SchedulerMode::WorkStealing || m_InclusiveTaskWorkers.empty())
+            return;
+
+        const auto l_Now = std::chrono::steady_clock::now();
+
+        if (l_Now - m_LastScale < std::chrono::milliseconds(WORKER_SCALE_COOLDOWN))
+            return;
+
+        float l_Utilization = 0.0f;
+        for (auto l_Worker : m_InclusiveTaskWorkers)
+            l_Utilization += l_Worker->GetUtilization();
+
+        l_Utilization /= static_cast<float>(m_InclusiveTaskWorkers.size());
+
+        const uint32 l_Count  = static_cast<uint32>(m_InclusiveTaskWorkers.size() + m_ExclusiveTaskWorkers.size());
+        uint32       l_Target = std::min(std::max(l_Count, m_MinWorkerCount), m_MaxWorkerCount);
+
+        if (l_Target == l_Count)
+        {
+            if (l_Utilization > WORKER_SCALE_UP_UTILIZATION && l_Count < m_MaxWorkerCount)
+                ++l_Target;
+            else if (l_Utilization < WORKER_SCALE_DOWN_UTILIZATION && l_Count > m_MinWorkerCount)
+                --l_Target;
         }
+
+        if (l_Target == l_Count)
+            return;
+
+        m_LastScale = l_Now;
+
+        LOG_INFO("ThrTaskManager", "Resizing pool from %0 to %1 workers, inclusive workers are %2% busy", l_Count, l_Target, static_cast<uint32>(l_Utilization * 100.0f));
+
+        l_Lock.unlock();
+
+        SetWorkerCount(l_Target);
     }
     /// Set optimize task period
     /// @p_Period : New period
@@ -309,56 +616,439 @@ namespace SteerStone { namespace Core { namespace Threading {
     {
         m_OptimizeTask->SetTaskPeriod(p_Period);
     }
+    /// Set affinity of a class of threads, threads already running are pinned again
+    /// @p_Class    : Affinity class
+    /// @p_Affinity : "none", "core", "node" or a CPU list such as "2-7,10"
+    /// Returns false if affinity is malformed, the class keeps its setting
+    bool TaskManager::SetAffinity(AffinityClass p_Class, std::string const& p_Affinity)
+    {
+        AffinitySetting l_Setting;
+
+        if (p_Affinity == "none")
+            l_Setting.Policy = AffinityPolicy::None;
+        else if (p_Affinity == "core")
+            l_Setting.Policy = AffinityPolicy::Core;
+        else if (p_Affinity == "node")
+            l_Setting.Policy = AffinityPolicy::Node;
+        else
+        {
+            std::vector<uint32> l_CPUs;
+            if (!CPUTopology::ParseCPUList(p_Affinity, l_CPUs))
+            {
+                LOG_ERROR("ThrTaskManager", "Invalid CPU affinity \"%0\"", p_Affinity);
+                return false;
+            }
+
+            /// Keep placement order so the list is filled one physical core at a time
+            l_Setting.Policy = AffinityPolicy::List;
+            for (uint32 l_CPU : sCPUTopology->GetPlacementOrder())
+            {
+                if (std::binary_search(l_CPUs.begin(), l_CPUs.end(), l_CPU))
+                    l_Setting.CPUs.push_back(l_CPU);
+            }
+
+            if (l_Setting.CPUs.empty())
+            {
+                LOG_ERROR("ThrTaskManager", "CPU affinity \"%0\" holds no CPU the process may run on", p_Affinity);
+                return false;
+            }
+        }
+
+        std::lock_guard<std::recursive_mutex> l_Lock(m_Mutex);
+
+        m_Affinity[static_cast<std::size_t>(p_Class)] = l_Setting;
+
+        std::vector<TaskWorker*> l_Workers = p_Class == AffinityClass::Inclusive ? m_InclusiveTaskWorkers
+                                           : p_Class == AffinityClass::Exclusive ? m_ExclusiveTaskWorkers : m_CriticalTaskWorkers;
+
+        if (p_Class == AffinityClass::Exclusive)
+            l_Workers.insert(l_Workers.end(), m_DedicatedTaskWorkers.begin(), m_DedicatedTaskWorkers.end());
+
+        /// Give every CPU back first, workers are spread over the whole class again
+        for (auto l_Worker : l_Workers)
+        {
+            ReleaseCPUs(l_Worker->GetCPUAffinity());
+            l_Worker->SetCPUAffinity({});
+        }
+
+        for (auto l_Worker : l_Workers)
+        {
+            int32 l_Node = -1;
+
+            /// Exclusive, dedicated and critical workers follow the group of the task they run
+            if (p_Class != AffinityClass::Inclusive)
+            {
+                for (auto const& l_Task : l_Worker->GetTasks())
+                    l_Node = GetGroupNode(l_Task->GetTaskPlacementGroup());
+            }
+
+            PinWorker(l_Worker, p_Class, l_Node);
+        }
+
+        if (p_Class == AffinityClass::Inclusive && m_Scheduler)
+            PinScheduler();
+
+        LOG_INFO("ThrTaskManager", "CPU affinity of %0 workers set to \"%1\"", l_Workers.size(), p_Affinity);
+
+        return true;
+    }
 
     //////////////////////////////////////////////////////////////////////////
     //////////////////////////////////////////////////////////////////////////
 
     /// Optimize
     /// Only for Inclusive workers
+    /// Moves a few tasks from the busiest to the idlest worker, workers keep running and untouched tasks are not paused
     void TaskManager::Optimize()
     {
-        m_Mutex.lock();
+        std::lock_guard<std::recursive_mutex> l_Lock(m_Mutex);
+
+        /// Idle scheduler workers steal from busy ones, there is nothing to balance
+        if (m_InclusiveTaskWorkers.size() < 2 || m_Tasks.empty() || m_Mode == SchedulerMode::WorkStealing)
+            return;
+
+        /// Workers spending most of their time asleep gain nothing from moving tasks around
+        float l_MaxUtilization = 0.0f;
+        for (auto l_Worker : m_InclusiveTaskWorkers)
+            l_MaxUtilization = std::max(l_MaxUtilization, l_Worker->GetUtilization());
 
-        if (m_InclusiveTaskWorkers.empty() || m_Tasks.empty())
+        if (l_MaxUtilization < OPTIMIZE_MIN_UTILIZATION)
+            return;
+
+        std::size_t l_Moved = 0;
+
+        for (; l_Moved < OPTIMIZE_MAX_TASK_MOVES; ++l_Moved)
         {
-            m_Mutex.unlock();
+            TaskWorker* l_Busiest   = nullptr;
+            TaskWorker* l_Idlest    = nullptr;
+            uint64      l_MaxLoad   = 0;
+            uint64      l_MinLoad   = std::numeric_limits<uint64>::max();
+
+            for (auto l_Worker : m_InclusiveTaskWorkers)
+            {
+                const uint64 l_Load = l_Worker->GetLoad();
+
+                if (!l_Busiest || l_Load > l_MaxLoad)
+                {
+                    l_Busiest = l_Worker;
+                    l_MaxLoad = l_Load;
+                }
+                if (!l_Idlest || l_Load < l_MinLoad)
+                {
+                    l_Idlest  = l_Worker;
+                    l_MinLoad = l_Load;
+                }
+            }
+
+            const uint64 l_Gap = l_MaxLoad - l_MinLoad;
+
+            /// Moving a task lighter than the gap always narrows it, the best one weighs half the gap
+            Task::Ptr   l_Candidate;
+            uint64      l_CandidateDistance = std::numeric_limits<uint64>::max();
+
+            for (auto & l_Task : l_Busiest->GetTasks())
+            {
+                const uint64 l_Load = l_Task->GetTaskLoad();
+
+                if (l_Load == 0 || l_Load >= l_Gap)
+                    continue;
+
+                /// Tasks of a placement group stay on its node
+                const int32 l_Node = GetGroupNode(l_Task->GetTaskPlacementGroup());
+                if (l_Node != -1 && GetWorkerNode(l_Idlest) != l_Node)
+                    continue;
+
+                const uint64 l_Distance = (2 * l_Load > l_Gap) ? (2 * l_Load - l_Gap) : (l_Gap - 2 * l_Load);
+
+                if (l_Distance < l_CandidateDistance)
+                {
+                    l_Candidate         = l_Task;
+                    l_CandidateDistance = l_Distance;
+                }
+            }
+
+            /// A task being executed is moved on a later pass
+            if (!l_Candidate || !l_Busiest->TryPopTask(l_Candidate))
+                break;
+
+            l_Idlest->PushTask(l_Candidate);
+        }
+
+        if (l_Moved)
+            LOG_INFO("ThrTaskManager", "Optimized : moved %0 tasks between %1 inclusive workers", l_Moved, m_InclusiveTaskWorkers.size());
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Set how normal and run once tasks are executed, moderate and critical tasks keep their own workers
+    /// Must not be called from a task
+    /// @p_Mode : Mode
+    void TaskManager::SetSchedulerMode(SchedulerMode p_Mode)
+    {
+        std::unique_lock<std::recursive_mutex> l_Lock(m_Mutex);
+
+        if (p_Mode == m_Mode)
+            return;
+
+        if (p_Mode == SchedulerMode::WorkStealing)
+        {
+            /// Scheduler threads take the cores of our inclusive workers
+            for (auto l_Worker : m_InclusiveTaskWorkers)
+                l_Worker->PreSuspend();
+
+            for (auto l_Worker : m_InclusiveTaskWorkers)
+            {
+                l_Worker->Suspend();
+                l_Worker->PopAll();
+            }
+
+            m_Scheduler.reset(new TaskScheduler(static_cast<uint32>(m_InclusiveTaskWorkers.size())));
+            m_Mode = SchedulerMode::WorkStealing;
+
+            PinScheduler();
+
+            for (auto & l_Task : m_Tasks)
+                ScheduleTask(l_Task);
+
+            LOG_INFO("ThrTaskManager", "Work stealing scheduler : %0 tasks on %1 workers", m_Tasks.size(), m_Scheduler->GetWorkerCount());
             return;
         }
 
-        std::vector<TaskWorker*> l_TaskWorkers = m_InclusiveTaskWorkers;
-        m_Mutex.unlock();
+        for (auto & l_Scheduled : m_ScheduledTasks)
+            l_Scheduled.second->Active = false;
+
+        m_ScheduledTasks.clear();
+        m_Mode = SchedulerMode::Polling;
+
+        /// Running tasks may pop themselves, they need our mutex to do so
+        std::unique_ptr<TaskScheduler> l_Scheduler = std::move(m_Scheduler);
+        l_Lock.unlock();
+        l_Scheduler.reset();
+        l_Lock.lock();
+
+        if (m_InclusiveTaskWorkers.empty())
+            return;
+
+        for (std::size_t l_I = 0; l_I < m_Tasks.size(); ++l_I)
+            m_InclusiveTaskWorkers[l_I % m_InclusiveTaskWorkers.size()]->PushTask(m_Tasks[l_I]);
+
+        for (auto l_Worker : m_InclusiveTaskWorkers)
+            l_Worker->Resume();
+    }
+    /// Get how normal and run once tasks are executed
+    SchedulerMode TaskManager::GetSchedulerMode() const
+    {
+        return m_Mode;
+    }
 
-        for (auto l_Worker : l_TaskWorkers)
-            l_Worker->PreSuspend();
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Run scheduled task and schedule its next run
+    /// @p_Scheduler : Scheduler task runs on
+    /// @p_Entry     : Scheduled task
+    void TaskManager::RunScheduledTask(TaskScheduler* p_Scheduler, std::shared_ptr<ScheduledTask> const& p_Entry)
+    {
+        if (!p_Entry->Active)
+            return;
 
-        for (auto l_Worker : l_TaskWorkers)
+        if (!p_Entry->TaskPtr->UpdateTask())
         {
-            l_Worker->Suspend();
-            l_Worker->PopAll();
+            PopTask(p_Entry->TaskPtr);
+            return;
+        }
+
+        if (!p_Entry->Active)
+            return;
+
+        /// Due tasks go through the injection queue, a task with no period does not starve the deque of its worker
+        std::shared_ptr<ScheduledTask> l_Entry = p_Entry;
+        p_Scheduler->ScheduleAfter(p_Entry->TaskPtr->GetTaskPeriod(), [this, p_Scheduler, l_Entry]() { RunScheduledTask(p_Scheduler, l_Entry); });
+    }
+    /// Move task onto our scheduler, must be called while holding our mutex
+    /// @p_Task : Task
+    void TaskManager::ScheduleTask(const Task::Ptr & p_Task)
+    {
+        std::shared_ptr<ScheduledTask> l_Entry = std::make_shared<ScheduledTask>();
+        l_Entry->TaskPtr = p_Task;
+        l_Entry->Active  = true;
+
+        m_ScheduledTasks[p_Task.get()] = l_Entry;
+
+        TaskScheduler* l_Scheduler = m_Scheduler.get();
+        l_Scheduler->Schedule([this, l_Scheduler, l_Entry]() { RunScheduledTask(l_Scheduler, l_Entry); });
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get NUMA node of a placement group, -1 for no group, must be called while holding our mutex
+    /// @p_Group : Placement group
+    int32 TaskManager::GetGroupNode(int32 p_Group) const
+    {
+        const uint32 l_NodeCount = sCPUTopology->GetNodeCount();
+
+        /// Every CPU is local on a single node host
+        if (p_Group == TASK_NO_PLACEMENT_GROUP || l_NodeCount < 2)
+            return -1;
+
+        return static_cast<int32>(static_cast<uint32>(p_Group) % l_NodeCount);
+    }
+    /// Get NUMA node a worker is pinned to, -1 if it is not pinned to a single node
+    /// @p_Worker : Worker
+    int32 TaskManager::GetWorkerNode(TaskWorker * p_Worker) const
+    {
+        return sCPUTopology->GetNodeOf(p_Worker->GetCPUAffinity());
+    }
+    /// Pick CPUs for a thread and account for them, must be called while holding our mutex
+    /// @p_Class : Affinity class of thread
+    /// @p_Node  : NUMA node thread must run on, -1 for any
+    std::vector<uint32> TaskManager::AcquireCPUs(AffinityClass p_Class, int32 p_Node)
+    {
+        AffinitySetting const& l_Setting = m_Affinity[static_cast<std::size_t>(p_Class)];
+        std::vector<uint32> l_CPUs;
+
+        switch (l_Setting.Policy)
+        {
+            case AffinityPolicy::None:
+                if (p_Node != -1)
+                    l_CPUs = sCPUTopology->GetNodeCPUs(static_cast<uint32>(p_Node));
+                break;
+            case AffinityPolicy::Node:
+                if (p_Node == -1)
+                    p_Node = static_cast<int32>(m_NextNode++ % sCPUTopology->GetNodeCount());
+
+                l_CPUs = sCPUTopology->GetNodeCPUs(static_cast<uint32>(p_Node));
+                break;
+            case AffinityPolicy::Core:
+            case AffinityPolicy::List:
+            {
+                std::vector<uint32> const& l_Order = l_Setting.Policy == AffinityPolicy::Core ? sCPUTopology->GetPlacementOrder() : l_Setting.CPUs;
+
+                uint32  l_Best      = 0;
+                uint32  l_BestUsage = std::numeric_limits<uint32>::max();
+
+                /// Least used CPU, earliest in placement order on ties so physical cores fill up before SMT siblings
+                for (int32 l_Pass = 0; l_Pass < 2 && l_BestUsage == std::numeric_limits<uint32>::max(); ++l_Pass)
+                {
+                    for (uint32 l_CPU : l_Order)
+                    {
+                        /// Second pass ignores the node, the setting holds no CPU of it
+                        if (l_Pass == 0 && p_Node != -1 && static_cast<int32>(sCPUTopology->GetCPU(l_CPU)->Node) != p_Node)
+                            continue;
+
+                        auto l_Usage = m_CPUUsage.find(l_CPU);
+                        const uint32 l_Count = l_Usage != m_CPUUsage.end() ? l_Usage->second : 0;
+
+                        if (l_Count < l_BestUsage)
+                        {
+                            l_Best      = l_CPU;
+                            l_BestUsage = l_Count;
+                        }
+                    }
+                }
+
+                l_CPUs.push_back(l_Best);
+                break;
+            }
+            default:
+                break;
         }
 
-        m_Mutex.lock();
+        /// Threads sharing a node do not take a CPU of their own
+        if (l_CPUs.size() == 1)
+            ++m_CPUUsage[l_CPUs[0]];
+
+        return l_CPUs;
+    }
+    /// Give back CPUs picked by AcquireCPUs, must be called while holding our mutex
+    /// @p_CPUs : CPUs
+    void TaskManager::ReleaseCPUs(std::vector<uint32> const& p_CPUs)
+    {
+        if (p_CPUs.size() != 1)
+            return;
+
+        auto l_Usage = m_CPUUsage.find(p_CPUs[0]);
+        if (l_Usage != m_CPUUsage.end() && l_Usage->second)
+            --l_Usage->second;
+    }
+    /// Pin worker again, must be called while holding our mutex
+    /// @p_Worker : Worker
+    /// @p_Class  : Affinity class of worker
+    /// @p_Node   : NUMA node worker must run on, -1 for any
+    void TaskManager::PinWorker(TaskWorker * p_Worker, AffinityClass p_Class, int32 p_Node)
+    {
+        ReleaseCPUs(p_Worker->GetCPUAffinity());
+        p_Worker->SetCPUAffinity(AcquireCPUs(p_Class, p_Node));
+    }
+    /// Pin threads of our work stealing scheduler on the CPUs of our inclusive workers, must be called while holding our mutex
+    void TaskManager::PinScheduler()
+    {
+        for (uint32 l_I = 0; l_I < m_Scheduler->GetWorkerCount() && l_I < m_InclusiveTaskWorkers.size(); ++l_I)
+            m_Scheduler->SetWorkerCPUAffinity(l_I, m_InclusiveTaskWorkers[l_I]->GetCPUAffinity());
+    }
+
+    /// Get least loaded inclusive worker preferring the node of a placement group, nullptr if there is none, must be called while holding our mutex
+    /// @p_Node : NUMA node, -1 for any
+    TaskWorker* TaskManager::PickInclusiveWorker(int32 p_Node)
+    {
+        if (m_InclusiveTaskWorkers.empty())
+            return nullptr;
 
-        std::sort(m_Tasks.begin(), m_Tasks.end(), [](const Task::Ptr & p_A, const Task::Ptr & p_B)
+        std::vector<TaskWorker*> l_Candidates;
+        for (auto l_Worker : m_InclusiveTaskWorkers)
         {
-            return (p_A->GetTaskAverageUpdateTime() < p_B->GetTaskAverageUpdateTime());
-        });
+            if (p_Node == -1 || GetWorkerNode(l_Worker) == p_Node)
+                l_Candidates.push_back(l_Worker);
+        }
 
-        std::size_t l_WorkerCount       = m_InclusiveTaskWorkers.size();
-        std::size_t l_CurrentWorker     = 0;
+        /// No worker on the node of the group, run anywhere
+        if (l_Candidates.empty())
+            l_Candidates = m_InclusiveTaskWorkers;
 
-        for (auto & l_Task : m_Tasks)
+        TaskWorker *    l_CurrentWorker     = l_Candidates.at(0);
+        uint64          l_MinLoad           = l_CurrentWorker->GetLoad();
+        float           l_MinUtilization    = l_CurrentWorker->GetUtilization();
+
+        /// Least loaded worker, measured utilization breaks ties between workers of new tasks with no cost yet
+        for (std::size_t l_I = 1; l_I < l_Candidates.size(); ++l_I)
         {
-            m_InclusiveTaskWorkers[l_CurrentWorker % l_WorkerCount]->PushTask(l_Task);
-            l_CurrentWorker++;
+            const uint64 l_Load         = l_Candidates[l_I]->GetLoad();
+            const float  l_Utilization  = l_Candidates[l_I]->GetUtilization();
+
+            if (l_Load < l_MinLoad || (l_Load == l_MinLoad && l_Utilization < l_MinUtilization))
+            {
+                l_CurrentWorker     = l_Candidates[l_I];
+                l_MinLoad           = l_Load;
+                l_MinUtilization    = l_Utilization;
+            }
         }
 
-        for (std::size_t l_I = 0; l_I < m_InclusiveTaskWorkers.size(); ++l_I)
-            m_InclusiveTaskWorkers[l_I]->Resume();
+        return l_CurrentWorker;
+    }
+    /// Get amount of exclusive workers of a pool
+    /// @p_Count : Pool worker count
+    uint32 TaskManager::GetExclusiveCount(uint32 p_Count)
+    {
+        const uint32 l_Count = static_cast<uint32>(std::floor(p_Count * EXLUSIVE_CURRENCY_COUNT));
+
+        /// Small containers still get an exclusive worker, as long as one inclusive worker is left
+        return (l_Count == 0 && p_Count > 1) ? 1 : l_Count;
+    }
+    /// Delete workers whose task popped itself from their own thread, must not be called while holding our mutex
+    void TaskManager::ReapWorkers()
+    {
+        std::vector<TaskWorker*> l_Retired;
 
-        LOG_INFO("ThrTaskManager", "Optimized : %0 tasks on %1 inclusive workers", m_Tasks.size(), m_InclusiveTaskWorkers.size());
+        {
+            std::lock_guard<std::recursive_mutex> l_Lock(m_Mutex);
+            l_Retired.swap(m_RetiredTaskWorkers);
+        }
 
-        m_Mutex.unlock();
+        /// Their threads stop right after their last run, which may need our mutex
+        for (auto l_Worker : l_Retired)
+            delete l_Worker;
     }
 
 }   ///< namespace Threading
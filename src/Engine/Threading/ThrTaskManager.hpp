@@ -22,15 +22,74 @@
 #include "Singleton/Singleton.hpp"
 #include "Threading/ThrTaskWorker.hpp"
 #include "Threading/ThrOptimizeTask.hpp"
+#include "Threading/ThrTaskScheduler.hpp"
+#include "Threading/ThrFuture.hpp"
+#include "Threading/ThrParallel.hpp"
+#include "Threading/ThrCPUTopology.hpp"
 
 #include <vector>
 #include <functional>
 #include <string>
+#include <unordered_map>
+#include <chrono>
 
 #define EXLUSIVE_CURRENCY_COUNT 0.30f
+#define OPTIMIZE_MAX_TASK_MOVES 4       ///< Maximum amount of tasks moved between inclusive workers per optimize pass
+#define OPTIMIZE_MIN_UTILIZATION 0.05f  ///< Inclusive workers are not rebalanced while none of them is busier than this
+#define WORKER_SCALE_UP_UTILIZATION     0.75f   ///< Pool grows by a worker while inclusive workers are busier than this on average
+#define WORKER_SCALE_DOWN_UTILIZATION   0.25f   ///< Pool shrinks by a worker while inclusive workers are idler than this on average
+#define WORKER_SCALE_COOLDOWN           30000   ///< Minimum MS between two load driven resizes, utilization needs time to settle
 
 namespace SteerStone { namespace Core { namespace Threading {
 
+    /// How normal and run once tasks are executed
+    enum class SchedulerMode
+    {
+        Polling,        ///< Inclusive workers poll their tasks every millisecond
+        WorkStealing    ///< Tasks are jobs on a work stealing scheduler, run when due
+    };
+
+    /// Threads sharing an affinity setting
+    enum class AffinityClass
+    {
+        Inclusive,      ///< Inclusive workers and work stealing scheduler threads
+        Exclusive,      ///< Exclusive and dedicated workers (network threads, database workers...)
+        Critical,       ///< Critical workers
+        Max
+    };
+
+    /// How threads of an affinity class are pinned
+    enum class AffinityPolicy
+    {
+        None,           ///< Not pinned, the OS places the thread (restricted to the node of its placement group)
+        Core,           ///< One logical CPU each, one per physical core first then their SMT siblings
+        Node,           ///< Every CPU of a NUMA node, the node of its placement group or the next one in turn
+        List            ///< One logical CPU each out of a configured CPU list
+    };
+
+    /// Affinity setting of an affinity class
+    struct AffinitySetting
+    {
+        AffinityPolicy      Policy;     ///< Policy
+        std::vector<uint32> CPUs;       ///< CPU ids sorted in placement order, List policy only
+    };
+
+    /// Snapshot of the cost model of a task worker
+    struct TaskWorkerStats
+    {
+        std::string Name;               ///< Worker name
+        WorkerType  Type;               ///< Worker type
+        std::size_t TaskCount;          ///< Amount of tasks on worker
+        uint64      Load;               ///< Sum of decayed execution time per second of its tasks in microseconds
+        uint64      DecayedUpdateTime;  ///< Decayed execution time per run in microseconds
+        uint64      AverageUpdateTime;  ///< Average execution time per run in milliseconds since start
+        float       Utilization;        ///< Decayed share of time spent executing rather than sleeping, from 0 to 1
+        uint64      ExecutionP99;       ///< 99th percentile of execution time of a task run in nanoseconds, since last reset
+        uint64      ExecutionMax;       ///< Longest task run in nanoseconds, since last reset
+        uint64      LatenessP99;        ///< 99th percentile of start of a task run minus its deadline in nanoseconds, since last reset
+        uint64      LatenessMax;        ///< Latest start of a task run in nanoseconds, since last reset
+    };
+
     /// TaskWorker
     class TaskManager
     {
@@ -49,7 +108,8 @@ namespace SteerStone { namespace Core { namespace Threading {
             /// @p_TaskType : Task Type
             /// @p_Period   : Task interval
             /// @p_Function : Task
-            Task::Ptr PushTask(const std::string & p_Name, const TaskType p_TaskType, const uint64 p_Period, const std::function<bool()> & p_Function);
+            /// @p_Group    : Placement group, TASK_NO_PLACEMENT_GROUP to run on any NUMA node
+            Task::Ptr PushTask(const std::string & p_Name, const TaskType p_TaskType, const uint64 p_Period, const std::function<bool()> & p_Function, int32 p_Group = TASK_NO_PLACEMENT_GROUP);
             /// Push a lambda task
             /// @p_TaskType : Task Type
             /// @p_Period   : Task interval
@@ -65,27 +125,139 @@ namespace SteerStone { namespace Core { namespace Threading {
             /// @p_Function : Task
             Task::Ptr PushRunOnceTask(const TaskType p_TaskType, const std::function<void()> & p_Function);
 
+            /// Run function as a run once task, the future holds its result
+            /// Continuations pick their own executor with Future::Then
+            /// @p_Function : Function, must be copyable
+            template<typename Function> auto Async(Function&& p_Function)
+                -> Future<typename std::invoke_result<typename std::decay<Function>::type>::type>
+            {
+                return Threading::Async(*this, std::forward<Function>(p_Function));
+            }
+            /// Run job once on a worker running normal tasks, no task name is built
+            /// Executor interface of futures, strands and parallel loops
+            /// @p_Function : Job
+            void Schedule(std::function<void()> p_Function);
+            /// Get amount of workers running normal tasks
+            uint32 GetConcurrency();
+
+            /// Call function for every index of [p_Begin, p_End) on our workers and the calling thread, returns once all calls are done
+            /// @p_Begin    : First index
+            /// @p_End      : Index past the end
+            /// @p_Grain    : Indices per chunk, 0 to pick one from the worker count
+            /// @p_Function : Called as p_Function(Index)
+            template<typename Index, typename Function> void ParallelFor(typename std::common_type<Index>::type p_Begin, Index p_End, typename std::common_type<Index>::type p_Grain, Function&& p_Function)
+            {
+                Threading::ParallelFor<TaskManager, Index>(*this, p_Begin, p_End, p_Grain, std::forward<Function>(p_Function));
+            }
+            /// Reduce every index of [p_Begin, p_End) on our workers and the calling thread
+            /// @p_Begin      : First index
+            /// @p_End        : Index past the end
+            /// @p_Grain      : Indices per chunk, 0 to pick one from the worker count
+            /// @p_Identity   : Start value of every chunk
+            /// @p_Accumulate : Called as p_Accumulate(T& Partial, Index)
+            /// @p_Combine    : Called as p_Combine(T Left, T Right) -> T
+            template<typename Index, typename T, typename Accumulate, typename Combine>
+            T ParallelReduce(typename std::common_type<Index>::type p_Begin, Index p_End, typename std::common_type<Index>::type p_Grain, T const& p_Identity, Accumulate&& p_Accumulate, Combine&& p_Combine)
+            {
+                return Threading::ParallelReduce<TaskManager, Index>(*this, p_Begin, p_End, p_Grain, p_Identity, std::forward<Accumulate>(p_Accumulate), std::forward<Combine>(p_Combine));
+            }
+
             /// Pop task
             /// @p_Task : Task to pop
             void PopTask(const Task::Ptr & p_Task);
 
             /// Get all tasks
             std::vector<Task::Ptr> GetTasks();
+            /// Get cost model of every polling worker, critical workers included
+            std::vector<TaskWorkerStats> GetWorkerStats();
+            /// Clear latency histograms of every task and polling worker, for periodic reporting
+            void ResetLatencyHistograms();
 
-            /// Set worker count
+            /// Set amount of pool workers (inclusive and exclusive), safe at runtime
+            /// Tasks of removed inclusive workers are drained onto the remaining ones, only idle exclusive workers are removed,
+            /// a worker does not remove itself. Dedicated and critical workers are not part of the pool
             /// @p_Count : Worker count
             void SetWorkerCount(uint32 p_Count);
+            /// Get amount of pool workers (inclusive and exclusive)
+            uint32 GetWorkerCount();
+            /// Get maximum amount of pool workers : usable CPUs but one, left to the kernel and dedicated threads
+            uint32 GetWorkerLimit() const;
+            /// Let the pool follow load between p_Min and p_Max workers, safe at runtime
+            /// @p_Min : Minimum worker count
+            /// @p_Max : Maximum worker count, 0 to disable load driven resizing
+            void SetWorkerScaling(uint32 p_Min, uint32 p_Max);
+            /// Grow or shrink the pool by one worker from measured utilization of inclusive workers, run by the optimize task
+            /// Polling mode only, parked work stealing workers cost nothing. Must not be called while holding our mutex
+            void ScaleWorkers();
             /// Set optimize task period
             /// @p_Period : New period
             void SetOptimizePeriod(uint64 p_Period);
+            /// Set affinity of a class of threads, threads already running are pinned again
+            /// @p_Class    : Affinity class
+            /// @p_Affinity : "none", "core", "node" or a CPU list such as "2-7,10"
+            /// Returns false if affinity is malformed, the class keeps its setting
+            bool SetAffinity(AffinityClass p_Class, std::string const& p_Affinity);
 
             /// Optimize
             /// Only for Inclusive Workers
+            /// Moves a few tasks from the busiest to the idlest worker, workers keep running and untouched tasks are not paused
             void Optimize();
 
+            /// Set how normal and run once tasks are executed, moderate and critical tasks keep their own workers
+            /// Must not be called from a task
+            /// @p_Mode : Mode
+            void SetSchedulerMode(SchedulerMode p_Mode);
+            /// Get how normal and run once tasks are executed
+            SchedulerMode GetSchedulerMode() const;
+
         //////////////////////////////////////////////////////////////////////////
         //////////////////////////////////////////////////////////////////////////
 
+        private:
+            /// Normal task running on our scheduler
+            struct ScheduledTask
+            {
+                Task::Ptr           TaskPtr;    ///< Task
+                std::atomic<bool>   Active;     ///< Cleared once task has been popped
+            };
+
+            /// Run scheduled task and schedule its next run
+            /// @p_Scheduler : Scheduler task runs on
+            /// @p_Entry     : Scheduled task
+            void RunScheduledTask(TaskScheduler* p_Scheduler, std::shared_ptr<ScheduledTask> const& p_Entry);
+            /// Move task onto our scheduler, must be called while holding our mutex
+            /// @p_Task : Task
+            void ScheduleTask(const Task::Ptr & p_Task);
+
+            /// Get NUMA node of a placement group, -1 for no group, must be called while holding our mutex
+            /// @p_Group : Placement group
+            int32 GetGroupNode(int32 p_Group) const;
+            /// Get NUMA node a worker is pinned to, -1 if it is not pinned to a single node
+            /// @p_Worker : Worker
+            int32 GetWorkerNode(TaskWorker * p_Worker) const;
+            /// Pick CPUs for a thread and account for them, must be called while holding our mutex
+            /// @p_Class : Affinity class of thread
+            /// @p_Node  : NUMA node thread must run on, -1 for any
+            std::vector<uint32> AcquireCPUs(AffinityClass p_Class, int32 p_Node);
+            /// Give back CPUs picked by AcquireCPUs, must be called while holding our mutex
+            /// @p_CPUs : CPUs
+            void ReleaseCPUs(std::vector<uint32> const& p_CPUs);
+            /// Pin worker again, must be called while holding our mutex
+            /// @p_Worker : Worker
+            /// @p_Class  : Affinity class of worker
+            /// @p_Node   : NUMA node worker must run on, -1 for any
+            void PinWorker(TaskWorker * p_Worker, AffinityClass p_Class, int32 p_Node);
+            /// Pin threads of our work stealing scheduler on the CPUs of our inclusive workers, must be called while holding our mutex
+            void PinScheduler();
+            /// Get least loaded inclusive worker preferring the node of a placement group, nullptr if there is none, must be called while holding our mutex
+            /// @p_Node : NUMA node, -1 for any
+            TaskWorker* PickInclusiveWorker(int32 p_Node);
+            /// Get amount of exclusive workers of a pool
+            /// @p_Count : Pool worker count
+            static uint32 GetExclusiveCount(uint32 p_Count);
+            /// Delete workers whose task popped itself from their own thread, must not be called while holding our mutex
+            void ReapWorkers();
+
         private:
             std::recursive_mutex    m_Mutex;        ///< Global mutex
             bool                    m_LogTasks;     ///< Should log tasks
@@ -95,6 +267,23 @@ namespace SteerStone { namespace Core { namespace Threading {
             std::vector<TaskWorker*>    m_InclusiveTaskWorkers; ///< Workers
             std::vector<TaskWorker*>    m_ExclusiveTaskWorkers; ///< Workers
             std::vector<TaskWorker*>    m_CriticalTaskWorkers;  ///< Workers
+            std::vector<TaskWorker*>    m_DedicatedTaskWorkers; ///< Workers
+            std::vector<TaskWorker*>    m_RetiredTaskWorkers;   ///< Workers stopping after their task popped itself, deleted by ReapWorkers
+            uint32                      m_WorkerSequence;       ///< Number of next pool worker, keeps thread names unique across resizes
+
+            uint32                                  m_MinWorkerCount;   ///< Minimum pool workers of load driven resizing
+            uint32                                  m_MaxWorkerCount;   ///< Maximum pool workers of load driven resizing, 0 if disabled
+            std::chrono::steady_clock::time_point   m_LastScale;        ///< Last load driven resize
+
+            AffinitySetting                     m_Affinity[static_cast<std::size_t>(AffinityClass::Max)];  ///< Affinity of each class
+            std::unordered_map<uint32, uint32>  m_CPUUsage;     ///< Amount of threads pinned on each single CPU
+            uint32                              m_NextNode;     ///< Next NUMA node of Node policy threads with no placement group
+
+            SchedulerMode                                               m_Mode;             ///< How normal and run once tasks are executed
+            std::unique_ptr<TaskScheduler>                              m_Scheduler;        ///< Work stealing scheduler, WorkStealing mode only
+            std::unordered_map<Task*, std::shared_ptr<ScheduledTask>>   m_ScheduledTasks;   ///< Normal tasks on our scheduler
+
+            uint64                                                      m_MetricsCollector; ///< Id of our metrics collector
 
     };
 
@@ -0,0 +1,293 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <PCH/Precompiled.hpp>
+
+#include "Threading/ThrTaskScheduler.hpp"
+#include "Threading/ThrThread.hpp"
+#include "Utility/UtiString.hpp"
+
+#include <limits>
+
+namespace SteerStone { namespace Core { namespace Threading {
+
+    /// Worker running on this thread, nullptr if this thread is not a worker
+    static thread_local void* s_CurrentWorker = nullptr;
+
+    /// Constructor
+    /// @p_WorkerCount : Amount of worker threads, at least 1
+    TaskScheduler::TaskScheduler(uint32 p_WorkerCount)
+        : m_InjectedSize(0), m_NextDeadline(std::numeric_limits<int64>::max()), m_TimerSequence(0), m_Parked(0), m_Running(true)
+    {
+        const uint32 l_WorkerCount = std::max<uint32>(p_WorkerCount, 1);
+
+        /// Every deque must exist before any worker starts stealing
+        for (uint32 l_I = 0; l_I < l_WorkerCount; l_I++)
+        {
+            m_Workers.emplace_back(new Worker());
+            m_Workers.back()->Owner = this;
+            m_Workers.back()->Index = l_I;
+        }
+
+        for (auto& l_Worker : m_Workers)
+        {
+            Worker* l_Current = l_Worker.get();
+            l_Worker->Thread = std::thread([this, l_Current]() { Run(l_Current); });
+
+            Thread::SetThreadName(l_Worker->Thread.native_handle(), Utils::StringBuilder("TaskScheduler_%0", l_Worker->Index));
+        }
+    }
+    /// Deconstructor, jobs which have not run yet are dropped
+    TaskScheduler::~TaskScheduler()
+    {
+        {
+            std::lock_guard<std::mutex> l_Lock(m_Mutex);
+            m_Running = false;
+        }
+
+        m_Wake.notify_all();
+
+        for (auto& l_Worker : m_Workers)
+        {
+            if (l_Worker->Thread.joinable())
+                l_Worker->Thread.join();
+        }
+
+        /// Workers are gone, we are the only thread left touching their deques
+        for (auto& l_Worker : m_Workers)
+        {
+            Job* l_Job = nullptr;
+            while (l_Worker->Deque.Steal(l_Job))
+                delete l_Job;
+        }
+
+        for (Job* l_Job : m_Injected)
+            delete l_Job;
+
+        for (; !m_Timers.empty(); m_Timers.pop())
+            delete m_Timers.top().Scheduled;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Run function as soon as a worker is available
+    /// @p_Function : Function
+    void TaskScheduler::Schedule(std::function<void()> p_Function)
+    {
+        Job* l_Job = new Job{ std::move(p_Function) };
+
+        Worker* l_Worker = static_cast<Worker*>(s_CurrentWorker);
+        if (l_Worker && l_Worker->Owner == this)
+            l_Worker->Deque.Push(l_Job);
+        else
+        {
+            std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+            m_Injected.push_back(l_Job);
+            m_InjectedSize.store(m_Injected.size(), std::memory_order_relaxed);
+        }
+
+        Unpark();
+    }
+    /// Run function once delay has passed, jobs with the same deadline run in order
+    /// @p_Milliseconds : Delay
+    /// @p_Function     : Function
+    void TaskScheduler::ScheduleAfter(uint64 p_Milliseconds, std::function<void()> p_Function)
+    {
+        const std::chrono::steady_clock::time_point l_Deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(p_Milliseconds);
+        bool l_First = false;
+
+        {
+            std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+            m_Timers.push({ l_Deadline, m_TimerSequence++, new Job{ std::move(p_Function) } });
+
+            l_First = m_Timers.top().Deadline == l_Deadline;
+            m_NextDeadline.store(m_Timers.top().Deadline.time_since_epoch().count(), std::memory_order_relaxed);
+        }
+
+        /// A parked worker may be waiting for a later deadline
+        if (l_First)
+            Unpark();
+    }
+
+    /// Get amount of worker threads
+    uint32 TaskScheduler::GetWorkerCount() const
+    {
+        return static_cast<uint32>(m_Workers.size());
+    }
+    /// Set CPU affinity of a worker thread
+    /// @p_Worker : Worker index
+    /// @p_CPUs   : CPU ids the thread may run on, empty to let it run anywhere
+    void TaskScheduler::SetWorkerCPUAffinity(uint32 p_Worker, std::vector<uint32> const& p_CPUs)
+    {
+        if (p_Worker >= m_Workers.size())
+            return;
+
+        Thread::SetThreadCPUAffinity(m_Workers[p_Worker]->Thread.native_handle(), p_CPUs);
+    }
+    /// Check if we are called from one of our workers
+    bool TaskScheduler::IsWorkerThread() const
+    {
+        Worker const* l_Worker = static_cast<Worker const*>(s_CurrentWorker);
+
+        return l_Worker && l_Worker->Owner == this;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Worker loop
+    /// @p_Worker : Worker
+    void TaskScheduler::Run(Worker* p_Worker)
+    {
+        s_CurrentWorker = p_Worker;
+
+        while (m_Running.load(std::memory_order_relaxed))
+        {
+            if (std::chrono::steady_clock::now().time_since_epoch().count() >= m_NextDeadline.load(std::memory_order_relaxed))
+                ExpireTimers();
+
+            if (Job* l_Job = FindJob(p_Worker))
+            {
+                l_Job->Function();
+                delete l_Job;
+
+                continue;
+            }
+
+            Park();
+        }
+
+        s_CurrentWorker = nullptr;
+    }
+    /// Find next job, own deque first, then injection queue, then other workers
+    /// @p_Worker : Worker looking for a job
+    TaskScheduler::Job* TaskScheduler::FindJob(Worker* p_Worker)
+    {
+        Job* l_Job = nullptr;
+
+        if (p_Worker->Deque.Pop(l_Job))
+            return l_Job;
+
+        if (m_InjectedSize.load(std::memory_order_relaxed) > 0)
+        {
+            std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+            if (!m_Injected.empty())
+            {
+                l_Job = m_Injected.front();
+                m_Injected.pop_front();
+                m_InjectedSize.store(m_Injected.size(), std::memory_order_relaxed);
+
+                return l_Job;
+            }
+        }
+
+        /// Start with our neighbour so workers do not all hit the same victim
+        const std::size_t l_Count = m_Workers.size();
+        for (std::size_t l_Attempt = 0; l_Attempt < TASK_SCHEDULER_STEAL_ATTEMPTS * l_Count; l_Attempt++)
+        {
+            Worker* l_Victim = m_Workers[(p_Worker->Index + 1 + l_Attempt) % l_Count].get();
+
+            if (l_Victim != p_Worker && l_Victim->Deque.Steal(l_Job))
+                return l_Job;
+        }
+
+        return nullptr;
+    }
+    /// Sleep until a job is scheduled or the next timer expires
+    void TaskScheduler::Park()
+    {
+        std::unique_lock<std::mutex> l_Lock(m_Mutex);
+
+        /// Announce ourself before checking for work, a job pushed right after our check sees us and wakes us up
+        m_Parked.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (m_Running && !HasWork())
+        {
+            if (m_Timers.empty())
+                m_Wake.wait(l_Lock);
+            else
+                m_Wake.wait_until(l_Lock, m_Timers.top().Deadline);
+        }
+
+        m_Parked.fetch_sub(1, std::memory_order_relaxed);
+    }
+    /// Check if any job is runnable, must be called while holding m_Mutex
+    bool TaskScheduler::HasWork() const
+    {
+        if (!m_Injected.empty())
+            return true;
+
+        if (!m_Timers.empty() && m_Timers.top().Deadline <= std::chrono::steady_clock::now())
+            return true;
+
+        for (auto const& l_Worker : m_Workers)
+        {
+            if (!l_Worker->Deque.IsEmpty())
+                return true;
+        }
+
+        return false;
+    }
+    /// Wake up a parked worker if there is one
+    void TaskScheduler::Unpark()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (m_Parked.load(std::memory_order_relaxed) == 0)
+            return;
+
+        /// Taking the lock makes sure a worker which is about to wait has started waiting
+        {
+            std::lock_guard<std::mutex> l_Lock(m_Mutex);
+        }
+
+        m_Wake.notify_one();
+    }
+    /// Move expired timers to the injection queue
+    void TaskScheduler::ExpireTimers()
+    {
+        const std::chrono::steady_clock::time_point l_Now = std::chrono::steady_clock::now();
+        std::size_t l_Expired = 0;
+
+        {
+            std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+            for (; !m_Timers.empty() && m_Timers.top().Deadline <= l_Now; m_Timers.pop())
+            {
+                m_Injected.push_back(m_Timers.top().Scheduled);
+                l_Expired++;
+            }
+
+            m_InjectedSize.store(m_Injected.size(), std::memory_order_relaxed);
+            m_NextDeadline.store(m_Timers.empty() ? std::numeric_limits<int64>::max() : m_Timers.top().Deadline.time_since_epoch().count(), std::memory_order_relaxed);
+        }
+
+        /// We run one of them ourself
+        for (std::size_t l_I = 1; l_I < l_Expired; l_I++)
+            Unpark();
+    }
+
+}   ///< namespace Threading
+}   ///< namespace Core
+}   ///< namespace SteerStone
@@ -0,0 +1,135 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "Core/Core.hpp"
+#include "Threading/ThrWorkStealingDeque.hpp"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <queue>
+#include <chrono>
+#include <vector>
+
+#define TASK_SCHEDULER_STEAL_ATTEMPTS 2     ///< Rounds over every other worker before parking
+
+namespace SteerStone { namespace Core { namespace Threading {
+
+    /// Work stealing executor
+    /// Every worker owns a Chase-Lev deque, jobs scheduled from a worker go to its own deque and
+    /// idle workers steal from the others. Jobs scheduled from other threads and expired timers go
+    /// through a shared injection queue. Workers without work park until they are woken up.
+    class TaskScheduler
+    {
+        DISALLOW_COPY_AND_ASSIGN(TaskScheduler);
+
+        /// Scheduled function
+        struct Job
+        {
+            std::function<void()> Function;     ///< Function
+        };
+
+        /// Delayed job
+        struct Timer
+        {
+            std::chrono::steady_clock::time_point Deadline;     ///< Time job becomes runnable
+            uint64 Sequence;                                    ///< Keeps jobs with the same deadline in order
+            Job* Scheduled;                                     ///< Job
+
+            /// Order timers by deadline, for a min heap
+            bool operator>(Timer const& p_Other) const
+            {
+                return Deadline != p_Other.Deadline ? Deadline > p_Other.Deadline : Sequence > p_Other.Sequence;
+            }
+        };
+
+        /// Worker thread
+        struct Worker
+        {
+            TaskScheduler* Owner;               ///< Scheduler we belong to
+            uint32 Index;                       ///< Index in scheduler
+            WorkStealingDeque<Job*> Deque;      ///< Jobs scheduled from this worker
+            std::thread Thread;                 ///< Thread
+        };
+
+        public:
+            /// Constructor
+            /// @p_WorkerCount : Amount of worker threads, at least 1
+            explicit TaskScheduler(uint32 p_WorkerCount);
+            /// Deconstructor, jobs which have not run yet are dropped
+            ~TaskScheduler();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Run function as soon as a worker is available
+            /// @p_Function : Function
+            void Schedule(std::function<void()> p_Function);
+            /// Run function once delay has passed, jobs with the same deadline run in order
+            /// @p_Milliseconds : Delay
+            /// @p_Function     : Function
+            void ScheduleAfter(uint64 p_Milliseconds, std::function<void()> p_Function);
+
+            /// Get amount of worker threads
+            uint32 GetWorkerCount() const;
+            /// Set CPU affinity of a worker thread
+            /// @p_Worker : Worker index
+            /// @p_CPUs   : CPU ids the thread may run on, empty to let it run anywhere
+            void SetWorkerCPUAffinity(uint32 p_Worker, std::vector<uint32> const& p_CPUs);
+            /// Check if we are called from one of our workers
+            bool IsWorkerThread() const;
+
+        private:
+            /// Worker loop
+            /// @p_Worker : Worker
+            void Run(Worker* p_Worker);
+            /// Find next job, own deque first, then injection queue, then other workers
+            /// @p_Worker : Worker looking for a job
+            Job* FindJob(Worker* p_Worker);
+            /// Sleep until a job is scheduled or the next timer expires
+            void Park();
+            /// Check if any job is runnable, must be called while holding m_Mutex
+            bool HasWork() const;
+            /// Wake up a parked worker if there is one
+            void Unpark();
+            /// Move expired timers to the injection queue
+            void ExpireTimers();
+
+        private:
+            std::vector<std::unique_ptr<Worker>> m_Workers;                                 ///< Workers
+
+            std::mutex m_Mutex;                                                             ///< Protects injection queue and timers, parking
+            std::condition_variable m_Wake;                                                 ///< Parked workers wait on this
+            std::deque<Job*> m_Injected;                                                    ///< Jobs scheduled from other threads
+            std::atomic<std::size_t> m_InjectedSize;                                        ///< Size of injection queue, read without lock
+            std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> m_Timers;   ///< Delayed jobs
+            std::atomic<int64> m_NextDeadline;                                              ///< Deadline of first timer (steady clock ticks), read without lock
+            uint64 m_TimerSequence;                                                         ///< Sequence of next timer
+
+            std::atomic<uint32> m_Parked;                                                   ///< Amount of parked workers
+            std::atomic<bool> m_Running;                                                    ///< Workers keep on running
+    };
+
+}   ///< namespace Threading
+}   ///< namespace Core
+}   ///< namespace SteerStone
@@ -26,13 +26,16 @@
 #include "Logger/Base.hpp"
 
 #include <chrono>
+#include <algorithm>
+#include <cmath>
 
 namespace SteerStone { namespace Core { namespace Threading {
 
     /// Constructor
     /// @p_WorkerType : Type of Worker
     TaskWorker::TaskWorker(WorkerType p_WorkerType)
-        : m_Name("ThrTaskWorker"), m_CPUAffinity(0), m_IsRunning(true), m_TotalRunTime(0), m_TotalRunCount(0), m_AverageRunTime(0), m_WorkerType(p_WorkerType)
+        : m_Name("ThrTaskWorker"), m_IsRunning(true), m_TotalRunTime(0), m_TotalRunCount(0), m_AverageRunTime(0), m_WorkerType(p_WorkerType),
+        m_WindowStart(Task::Clock::now()), m_WindowBusyTime(0), m_Utilization(0.0f), m_DecayedRunTime(0)
     {
         m_Thread = new std::thread([this]() { UpdateThread(); });
     }
@@ -41,6 +44,7 @@ namespace SteerStone { namespace Core { namespace Threading {
     {
         m_Mutex.lock();
         m_IsRunning = false;
+        m_Condition.notify_all();
         m_Mutex.unlock();
 
         PopAll();
@@ -64,6 +68,9 @@ namespace SteerStone { namespace Core { namespace Threading {
         std::lock_guard<std::recursive_mutex> l_Lock(m_Mutex);
 
         m_Tasks.push_back(p_Task);
+        PushDeadline(p_Task);
+
+        m_Condition.notify_all();
     }
     /// Pop task
     void TaskWorker::PopTask(const Task::Ptr & p_Task)
@@ -74,12 +81,35 @@ namespace SteerStone { namespace Core { namespace Threading {
 
         if (l_It != m_Tasks.end())
             m_Tasks.erase(l_It);
+
+        auto l_Deadline = std::find_if(m_Deadlines.begin(), m_Deadlines.end(), [&p_Task](Deadline const& p_Deadline) -> bool {
+            return p_Deadline.TaskPtr == p_Task;
+        });
+
+        if (l_Deadline != m_Deadlines.end())
+        {
+            m_Deadlines.erase(l_Deadline);
+            std::make_heap(m_Deadlines.begin(), m_Deadlines.end());
+        }
+    }
+    /// Pop task unless it is being executed right now
+    /// Returns false if task is being executed
+    bool TaskWorker::TryPopTask(const Task::Ptr & p_Task)
+    {
+        std::lock_guard<std::recursive_mutex> l_Lock(m_Mutex);
+
+        if (m_Executing == p_Task)
+            return false;
+
+        PopTask(p_Task);
+        return true;
     }
     /// Pop all
     void TaskWorker::PopAll()
     {
         std::lock_guard<std::recursive_mutex> l_Lock(m_Mutex);
         m_Tasks.clear();
+        m_Deadlines.clear();
     }
 
     //////////////////////////////////////////////////////////////////////////
@@ -92,6 +122,24 @@ namespace SteerStone { namespace Core { namespace Threading {
 
         return std::find(m_Tasks.begin(), m_Tasks.end(), p_Task) != m_Tasks.end();
     }
+    /// Get copy of our tasks
+    std::vector<Task::Ptr> TaskWorker::GetTasks()
+    {
+        std::lock_guard<std::recursive_mutex> l_Lock(m_Mutex);
+
+        return m_Tasks;
+    }
+    /// Get sum of decayed execution time per second of our tasks in microseconds
+    uint64 TaskWorker::GetLoad()
+    {
+        std::lock_guard<std::recursive_mutex> l_Lock(m_Mutex);
+
+        uint64 l_Load = 0;
+        for (auto & l_Task : m_Tasks)
+            l_Load += l_Task->GetTaskLoad();
+
+        return l_Load;
+    }
 
     //////////////////////////////////////////////////////////////////////////
     //////////////////////////////////////////////////////////////////////////
@@ -111,6 +159,30 @@ namespace SteerStone { namespace Core { namespace Threading {
     {
         return m_AverageRunTime;
     }
+    /// Get decayed execution time per run in microseconds
+    uint64 TaskWorker::GetDecayedUpdateTime() const
+    {
+        return m_DecayedRunTime;
+    }
+    /// Get decayed share of time spent executing tasks rather than sleeping, from 0 to 1
+    float TaskWorker::GetUtilization()
+    {
+        std::lock_guard<std::recursive_mutex> l_Lock(m_Mutex);
+
+        UpdateUtilization(Task::Clock::now());
+
+        return m_Utilization;
+    }
+    /// Get histogram of execution time of our task runs
+    Diagnostic::LatencyHistogram & TaskWorker::GetExecutionHistogram()
+    {
+        return m_ExecutionHistogram;
+    }
+    /// Get histogram of lateness of our task runs, start of execution minus its deadline
+    Diagnostic::LatencyHistogram & TaskWorker::GetLatenessHistogram()
+    {
+        return m_LatenessHistogram;
+    }
     /// Get Task Size
     std::size_t TaskWorker::GetTaskSize() const
     {
@@ -135,7 +207,10 @@ namespace SteerStone { namespace Core { namespace Threading {
         if (!m_Thread)
             return;
 
+        std::lock_guard<std::recursive_mutex> l_Lock(m_Mutex);
+
         m_IsRunning = false;
+        m_Condition.notify_all();
     }
     /// Suspend the worker
     void TaskWorker::Suspend()
@@ -148,6 +223,7 @@ namespace SteerStone { namespace Core { namespace Threading {
         m_AverageRunTime    = 0;
         m_TotalRunTime      = 0;
         m_TotalRunCount     = 0;
+        m_Condition.notify_all();
         m_Mutex.unlock();
 
         if (m_Thread->joinable())
@@ -168,23 +244,28 @@ namespace SteerStone { namespace Core { namespace Threading {
         m_Thread    = new std::thread([this]() { UpdateThread(); });
         m_Mutex.unlock();
 
-        SetCPUAffinty(m_CPUAffinity);
+        SetCPUAffinity(m_CPUAffinity);
         SetName(m_Name);
     }
 
     //////////////////////////////////////////////////////////////////////////
     //////////////////////////////////////////////////////////////////////////
 
-    /// Set thread CPU affinity
-    /// @p_Affinity : Affinity
-    void TaskWorker::SetCPUAffinty(int32 p_Affinity)
+    /// Set thread CPU affinity, kept across suspend and resume
+    /// @p_CPUs : CPU ids the thread may run on, empty to let it run anywhere
+    void TaskWorker::SetCPUAffinity(std::vector<uint32> const& p_CPUs)
     {
-        m_CPUAffinity = p_Affinity;
+        m_CPUAffinity = p_CPUs;
 
         if (!m_Thread)
             return;
 
-        Thread::SetThreadCPUAffinity(m_Thread->native_handle(), p_Affinity);
+        Thread::SetThreadCPUAffinity(m_Thread->native_handle(), m_CPUAffinity);
+    }
+    /// Get CPU ids the thread may run on, empty if it is not pinned
+    std::vector<uint32> const& TaskWorker::GetCPUAffinity() const
+    {
+        return m_CPUAffinity;
     }
     /// Set task worker name
     /// @p_Name : New name
@@ -197,52 +278,125 @@ namespace SteerStone { namespace Core { namespace Threading {
 
         Thread::SetThreadName(m_Thread->native_handle(), m_Name);
     }
+    /// Get task worker name
+    const std::string & TaskWorker::GetName() const
+    {
+        return m_Name;
+    }
+    /// Get type of worker
+    WorkerType TaskWorker::GetWorkerType() const
+    {
+        return m_WorkerType;
+    }
+    /// Check if calling thread is our thread
+    bool TaskWorker::IsCurrentThread() const
+    {
+        return m_Thread && m_Thread->get_id() == std::this_thread::get_id();
+    }
 
     //////////////////////////////////////////////////////////////////////////
     //////////////////////////////////////////////////////////////////////////
 
     /// Update thread
+    /// Sleeps until the earliest deadline or until a task is pushed, tasks are never polled
     void TaskWorker::UpdateThread()
     {
-        Diagnostic::StopWatch l_TasksMonitor;
-        Diagnostic::StopWatch l_DiffTimer;
+        std::unique_lock<std::recursive_mutex> l_Lock(m_Mutex);
 
-        l_DiffTimer.Start();
         while (m_IsRunning)
         {
-            l_TasksMonitor.Start();
+            if (m_Deadlines.empty())
+            {
+                m_Condition.wait(l_Lock);
+                continue;
+            }
 
-            m_Mutex.lock();
-            std::vector<Task::Ptr> l_Copy(m_Tasks);
-            m_Mutex.unlock();
+            const Task::Clock::time_point l_Time = m_Deadlines.front().Time;
 
-            uint64 l_DiffTime = l_DiffTimer.GetElapsed();
-            for (auto & l_Task : l_Copy)
+            if (Task::Clock::now() < l_Time)
             {
-                if (!m_IsRunning)
-                    break;
-
-                if (l_Task->UpdateTaskTime(l_DiffTime))
-                    if (!l_Task->UpdateTask())
-                        TaskManager::GetSingleton()->PopTask(l_Task);
+                m_Condition.wait_until(l_Lock, l_Time);
+                continue;
             }
 
-            l_DiffTimer.Reset();
+            std::pop_heap(m_Deadlines.begin(), m_Deadlines.end());
+            Task::Ptr l_Task = std::move(m_Deadlines.back().TaskPtr);
+            m_Deadlines.pop_back();
+
+            m_Executing         = l_Task;
+            m_ExecutionStart    = Task::Clock::now();
+            l_Lock.unlock();
 
-            /// Fast exit
-            if (!m_IsRunning)
-                return;
+            m_LatenessHistogram.Record(m_ExecutionStart - l_Time);
 
-            l_TasksMonitor.Stop();
+            const bool l_Continue = l_Task->UpdateTask();
 
-            m_TotalRunTime += l_TasksMonitor.GetElapsed();
+            const Task::Clock::time_point l_End = Task::Clock::now();
+            const int64 l_RunTime = std::chrono::duration_cast<std::chrono::microseconds>(l_End - m_ExecutionStart).count();
+
+            m_ExecutionHistogram.Record(l_End - m_ExecutionStart);
+
+            m_TotalRunTime += l_RunTime / 1000;
             m_TotalRunCount++;
 
-            m_AverageRunTime = static_cast<uint32>(m_TotalRunTime / m_TotalRunCount);
+            m_AverageRunTime = m_TotalRunTime / m_TotalRunCount;
+
+            const int64 l_Decayed = static_cast<int64>(m_DecayedRunTime.load());
+            m_DecayedRunTime = static_cast<uint64>(l_Decayed + ((l_RunTime - l_Decayed) / (1 << TASK_COST_DECAY_SHIFT)));
+
+            if (!l_Continue)
+                TaskManager::GetSingleton()->PopTask(l_Task);
 
-            ThisThread::SleepFor(std::chrono::milliseconds(1));
+            l_Lock.lock();
+
+            m_WindowBusyTime += std::chrono::duration_cast<std::chrono::microseconds>(l_End - std::max(m_ExecutionStart, m_WindowStart)).count();
+            m_Executing = nullptr;
+
+            UpdateUtilization(l_End);
+
+            /// Task may have been popped, or popped and pushed again, while it was executed
+            if (l_Continue && std::find(m_Tasks.begin(), m_Tasks.end(), l_Task) != m_Tasks.end())
+            {
+                auto l_Deadline = std::find_if(m_Deadlines.begin(), m_Deadlines.end(), [&l_Task](Deadline const& p_Deadline) -> bool {
+                    return p_Deadline.TaskPtr == l_Task;
+                });
+
+                if (l_Deadline == m_Deadlines.end())
+                    PushDeadline(l_Task);
+            }
         }
     }
+    /// Add task to our deadline heap, must be called while holding our mutex
+    /// @p_Task : Task
+    void TaskWorker::PushDeadline(const Task::Ptr & p_Task)
+    {
+        m_Deadlines.push_back({ p_Task->GetTaskNextRunTime(), p_Task });
+        std::push_heap(m_Deadlines.begin(), m_Deadlines.end());
+    }
+    /// Fold busy time into utilization once a window has elapsed, must be called while holding our mutex
+    /// @p_Now : Current time
+    void TaskWorker::UpdateUtilization(Task::Clock::time_point p_Now)
+    {
+        const int64 l_Elapsed = std::chrono::duration_cast<std::chrono::microseconds>(p_Now - m_WindowStart).count();
+
+        if (l_Elapsed < WORKER_UTILIZATION_WINDOW * 1000)
+            return;
+
+        uint64 l_BusyTime = m_WindowBusyTime;
+
+        /// Task still being executed counts as busy up to now
+        if (m_Executing)
+            l_BusyTime += std::chrono::duration_cast<std::chrono::microseconds>(p_Now - std::max(m_ExecutionStart, m_WindowStart)).count();
+
+        /// A worker nobody asked about for a while folds several windows at once, each one decays the old value
+        const float l_Sample  = std::min(1.0f, static_cast<float>(l_BusyTime) / static_cast<float>(l_Elapsed));
+        const float l_Windows = static_cast<float>(std::min<int64>(l_Elapsed / (WORKER_UTILIZATION_WINDOW * 1000), 32));
+        const float l_Weight  = 1.0f - std::pow(1.0f - 1.0f / (1 << TASK_COST_DECAY_SHIFT), l_Windows);
+
+        m_Utilization   += (l_Sample - m_Utilization) * l_Weight;
+        m_WindowStart    = p_Now;
+        m_WindowBusyTime = 0;
+    }
 
 //     /// Update thread
 //     void TaskWorker::UpdateThread()
@@ -23,6 +23,9 @@
 
 #include <thread>
 #include <shared_mutex>
+#include <condition_variable>
+
+#define WORKER_UTILIZATION_WINDOW   100     ///< Utilization is sampled over at least this many MS
 
 namespace SteerStone { namespace Core { namespace Threading {
 
@@ -51,11 +54,18 @@ namespace SteerStone { namespace Core { namespace Threading {
             void PushTask(const Task::Ptr & p_Task);
             /// Pop task
             void PopTask(const Task::Ptr & p_Task);
+            /// Pop task unless it is being executed right now
+            /// Returns false if task is being executed
+            bool TryPopTask(const Task::Ptr & p_Task);
             /// Pop all
             void PopAll();
 
             /// Have task
             bool HaveTask(const Task::Ptr & p_Task);
+            /// Get copy of our tasks
+            std::vector<Task::Ptr> GetTasks();
+            /// Get sum of decayed execution time per second of our tasks in microseconds
+            uint64 GetLoad();
 
             /// Get flags
             uint64 GetTotalRunTime() const;
@@ -63,6 +73,14 @@ namespace SteerStone { namespace Core { namespace Threading {
             uint64 GetTotalRunCount() const;
             /// Get average execution time
             uint64 GetAverageUpdateTime() const;
+            /// Get decayed execution time per run in microseconds
+            uint64 GetDecayedUpdateTime() const;
+            /// Get decayed share of time spent executing tasks rather than sleeping, from 0 to 1
+            float GetUtilization();
+            /// Get histogram of execution time of our task runs
+            Diagnostic::LatencyHistogram & GetExecutionHistogram();
+            /// Get histogram of lateness of our task runs, start of execution minus its deadline
+            Diagnostic::LatencyHistogram & GetLatenessHistogram();
             /// Get Task Size
             std::size_t GetTaskSize() const;
             /// Reset avg update time
@@ -75,30 +93,69 @@ namespace SteerStone { namespace Core { namespace Threading {
             /// Resume the worker
             void Resume();
 
-            /// Set thread CPU affinity
-            /// @p_Affinity : Affinity
-            void SetCPUAffinty(int32 p_Affinity);
+            /// Set thread CPU affinity, kept across suspend and resume
+            /// @p_CPUs : CPU ids the thread may run on, empty to let it run anywhere
+            void SetCPUAffinity(std::vector<uint32> const& p_CPUs);
+            /// Get CPU ids the thread may run on, empty if it is not pinned
+            std::vector<uint32> const& GetCPUAffinity() const;
             /// Set task worker name
             /// @p_Name : New name
             void SetName(const std::string & p_Name);
+            /// Get task worker name
+            const std::string & GetName() const;
+            /// Get type of worker
+            WorkerType GetWorkerType() const;
+            /// Check if calling thread is our thread
+            bool IsCurrentThread() const;
 
         private:
+            /// Task waiting for its deadline
+            struct Deadline
+            {
+                Task::Clock::time_point Time;       ///< Next execution
+                Task::Ptr               TaskPtr;    ///< Task
+
+                /// Order deadlines so the earliest is on top of our heap
+                bool operator<(Deadline const& p_Other) const
+                {
+                    return Time > p_Other.Time;
+                }
+            };
+
             /// Update thread
             void UpdateThread();
+            /// Add task to our deadline heap, must be called while holding our mutex
+            /// @p_Task : Task
+            void PushDeadline(const Task::Ptr & p_Task);
+            /// Fold busy time into utilization once a window has elapsed, must be called while holding our mutex
+            /// @p_Now : Current time
+            void UpdateUtilization(Task::Clock::time_point p_Now);
 
         private:
-            std::recursive_mutex    m_Mutex;        ///< Mutex
+            std::recursive_mutex            m_Mutex;        ///< Mutex
+            std::condition_variable_any     m_Condition;    ///< Wakes thread on new task, stop or earlier deadline
             std::string             m_Name;         ///< Name
             std::thread *           m_Thread;       ///< Thread
-            int32                   m_CPUAffinity;  ///< CPU affinity
+            std::vector<uint32>     m_CPUAffinity;  ///< CPU affinity
             bool                    m_IsRunning;    ///< Thread run condition
             WorkerType              m_WorkerType;   ///< Type
 
-            std::vector<Task::Ptr> m_Tasks; ///< Tasks
+            std::vector<Task::Ptr> m_Tasks;         ///< Tasks
+            std::vector<Deadline>  m_Deadlines;     ///< Min heap of tasks by next execution, task being executed is not in it
+            Task::Ptr              m_Executing;     ///< Task being executed
+            Task::Clock::time_point m_ExecutionStart;   ///< Start of execution of m_Executing
+
+            Task::Clock::time_point m_WindowStart;      ///< Start of current utilization window
+            uint64                  m_WindowBusyTime;   ///< Time spent executing in current window in microseconds
+            float                   m_Utilization;      ///< Decayed share of time spent executing
 
             std::atomic<uint64> m_TotalRunTime;      ///< Total run time
             std::atomic<uint64> m_TotalRunCount;     ///< Total run count
             std::atomic<uint64> m_AverageRunTime;    ///< Avg execution time
+            std::atomic<uint64> m_DecayedRunTime;    ///< Decayed execution time per run in microseconds
+
+            Diagnostic::LatencyHistogram m_ExecutionHistogram;  ///< Execution time of our task runs
+            Diagnostic::LatencyHistogram m_LatenessHistogram;   ///< Start of execution minus its deadline
 
     };
 
@@ -20,6 +20,7 @@
 #include <PCH/Precompiled.hpp>
 
 #include "Threading/ThrThread.hpp"
+#include "Threading/ThrCPUTopology.hpp"
 
 #include "Logger/Base.hpp"
 
@@ -204,6 +205,51 @@ namespace SteerStone { namespace Core { namespace Threading {
             LOG_ERROR("ThrThread", R"LOG(Failed to set thread "%0" CPU affinity to %1)LOG", GetThreadName(p_Handle), p_CPU);
             return;
         }
+#endif
+    }
+    /// Set thread CPU affinity
+    /// @p_Handle   : Thread CPU
+    /// @p_CPUs     : CPU IDs from 0 the thread may run on, empty to let it run on every CPU of the process
+    void Thread::SetThreadCPUAffinity(std::thread::native_handle_type p_Handle, std::vector<uint32> const& p_CPUs)
+    {
+        std::vector<uint32> l_CPUs = p_CPUs;
+
+        /// Undo a previous pinning
+        if (l_CPUs.empty())
+        {
+            for (auto const& l_CPU : sCPUTopology->GetCPUs())
+                l_CPUs.push_back(l_CPU.Id);
+        }
+
+#ifdef WIN32
+        DWORD_PTR l_Mask = 0;
+        for (uint32 l_CPU : l_CPUs)
+        {
+            if (l_CPU < sizeof(DWORD_PTR) * 8)
+                l_Mask |= static_cast<DWORD_PTR>(1) << l_CPU;
+        }
+
+        if (!l_Mask || !SetThreadAffinityMask(p_Handle, l_Mask))
+        {
+            LOG_ERROR("ThrThread", R"LOG(Failed to set thread "%0" CPU affinity to %1)LOG", GetThreadName(p_Handle), CPUTopology::FormatCPUList(l_CPUs));
+            return;
+        }
+#else
+        cpu_set_t l_CPUSet;
+        CPU_ZERO(&l_CPUSet);
+
+        for (uint32 l_CPU : l_CPUs)
+        {
+            if (l_CPU < 8 * sizeof(cpu_set_t))
+                CPU_SET(l_CPU, &l_CPUSet);
+        }
+
+        /// MacOS only takes the first CPU of the set as a "recommendation", see above
+        if (pthread_setaffinity_np(p_Handle, sizeof(cpu_set_t), &l_CPUSet))
+        {
+            LOG_ERROR("ThrThread", R"LOG(Failed to set thread "%0" CPU affinity to %1)LOG", GetThreadName(p_Handle), CPUTopology::FormatCPUList(l_CPUs));
+            return;
+        }
 #endif
     }
 
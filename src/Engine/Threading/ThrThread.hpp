@@ -24,6 +24,7 @@
 #include <thread>
 #include <mutex>
 #include <map>
+#include <vector>
 
 namespace SteerStone { namespace Core { namespace Threading {
 
@@ -46,6 +47,10 @@ namespace SteerStone { namespace Core { namespace Threading {
             /// @p_Handle   : Thread CPU
             /// @p_CPU      : CPU ID from 0
             static void SetThreadCPUAffinity(std::thread::native_handle_type p_Handle, uint32 p_CPU);
+            /// Set thread CPU affinity
+            /// @p_Handle   : Thread CPU
+            /// @p_CPUs     : CPU IDs from 0 the thread may run on, empty to let it run on every CPU of the process
+            static void SetThreadCPUAffinity(std::thread::native_handle_type p_Handle, std::vector<uint32> const& p_CPUs);
 
         private:
             static std::mutex                       m_Mutex;          ///< Global mutex
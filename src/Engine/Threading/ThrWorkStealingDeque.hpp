@@ -0,0 +1,190 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "Core/Core.hpp"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <type_traits>
+
+#define WORK_STEALING_DEQUE_INITIAL_CAPACITY 256
+
+namespace SteerStone { namespace Core { namespace Threading {
+
+    /// Chase-Lev work stealing deque
+    /// Only the owner thread may Push and Pop (LIFO, bottom), any thread may Steal (FIFO, top)
+    /// Storage grows when full, replaced arrays are kept until destruction as stealers may still read them
+    template<typename T> class WorkStealingDeque
+    {
+        DISALLOW_COPY_AND_ASSIGN(WorkStealingDeque);
+
+        static_assert(std::is_trivially_copyable<T>::value, "Items are copied without synchronization, use pointers");
+
+        /// Circular storage, capacity is a power of 2
+        struct Array
+        {
+            /// Constructor
+            /// @p_Capacity : Capacity, must be a power of 2
+            explicit Array(int64 p_Capacity)
+                : Capacity(p_Capacity), Mask(p_Capacity - 1), Items(new std::atomic<T>[p_Capacity])
+            {
+            }
+
+            /// Get item
+            /// @p_Index : Unmasked index
+            T Get(int64 p_Index) const
+            {
+                return Items[p_Index & Mask].load(std::memory_order_relaxed);
+            }
+            /// Put item
+            /// @p_Index : Unmasked index
+            /// @p_Item  : Item
+            void Put(int64 p_Index, T p_Item)
+            {
+                Items[p_Index & Mask].store(p_Item, std::memory_order_relaxed);
+            }
+            /// Copy items between top and bottom into new array of twice our capacity
+            /// @p_Bottom : Bottom index
+            /// @p_Top    : Top index
+            Array* Grow(int64 p_Bottom, int64 p_Top) const
+            {
+                Array* l_Array = new Array(Capacity * 2);
+
+                for (int64 l_I = p_Top; l_I < p_Bottom; l_I++)
+                    l_Array->Put(l_I, Get(l_I));
+
+                return l_Array;
+            }
+
+            int64 Capacity;                             ///< Capacity
+            int64 Mask;                                 ///< Capacity - 1
+            std::unique_ptr<std::atomic<T>[]> Items;    ///< Items
+        };
+
+        public:
+            /// Constructor
+            /// @p_Capacity : Initial capacity, must be a power of 2
+            explicit WorkStealingDeque(int64 p_Capacity = WORK_STEALING_DEQUE_INITIAL_CAPACITY)
+                : m_Top(0), m_Bottom(0), m_Array(new Array(p_Capacity))
+            {
+            }
+            /// Deconstructor
+            ~WorkStealingDeque()
+            {
+                delete m_Array.load(std::memory_order_relaxed);
+
+                for (Array* l_Array : m_Retired)
+                    delete l_Array;
+            }
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Push item to the bottom, owner thread only
+            /// @p_Item : Item
+            void Push(T p_Item)
+            {
+                const int64 l_Bottom = m_Bottom.load(std::memory_order_relaxed);
+                const int64 l_Top    = m_Top.load(std::memory_order_acquire);
+                Array* l_Array       = m_Array.load(std::memory_order_relaxed);
+
+                if (l_Bottom - l_Top > l_Array->Capacity - 1)
+                {
+                    m_Retired.push_back(l_Array);
+
+                    l_Array = l_Array->Grow(l_Bottom, l_Top);
+                    m_Array.store(l_Array, std::memory_order_release);
+                }
+
+                l_Array->Put(l_Bottom, p_Item);
+
+                std::atomic_thread_fence(std::memory_order_release);
+                m_Bottom.store(l_Bottom + 1, std::memory_order_relaxed);
+            }
+            /// Pop most recently pushed item from the bottom, owner thread only
+            /// @p_Item : Output
+            /// Returns false if deque is empty
+            bool Pop(T& p_Item)
+            {
+                const int64 l_Bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+                Array* l_Array       = m_Array.load(std::memory_order_relaxed);
+
+                m_Bottom.store(l_Bottom, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+
+                int64 l_Top = m_Top.load(std::memory_order_relaxed);
+
+                if (l_Top > l_Bottom)
+                {
+                    m_Bottom.store(l_Bottom + 1, std::memory_order_relaxed);
+                    return false;
+                }
+
+                p_Item = l_Array->Get(l_Bottom);
+
+                /// Last item, race against stealers
+                if (l_Top == l_Bottom)
+                {
+                    const bool l_Won = m_Top.compare_exchange_strong(l_Top, l_Top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                    m_Bottom.store(l_Bottom + 1, std::memory_order_relaxed);
+
+                    return l_Won;
+                }
+
+                return true;
+            }
+            /// Steal oldest item from the top, any thread
+            /// @p_Item : Output
+            /// Returns false if deque is empty or another thread took the item first
+            bool Steal(T& p_Item)
+            {
+                int64 l_Top = m_Top.load(std::memory_order_acquire);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                const int64 l_Bottom = m_Bottom.load(std::memory_order_acquire);
+
+                if (l_Top >= l_Bottom)
+                    return false;
+
+                const T l_Item = m_Array.load(std::memory_order_acquire)->Get(l_Top);
+
+                if (!m_Top.compare_exchange_strong(l_Top, l_Top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    return false;
+
+                p_Item = l_Item;
+                return true;
+            }
+            /// Check if deque looks empty, the result may be outdated right away
+            bool IsEmpty() const
+            {
+                return m_Bottom.load(std::memory_order_relaxed) <= m_Top.load(std::memory_order_relaxed);
+            }
+
+        private:
+            alignas(64) std::atomic<int64> m_Top;       ///< Index stealers take from
+            alignas(64) std::atomic<int64> m_Bottom;    ///< Index owner pushes to and pops from
+            std::atomic<Array*> m_Array;                ///< Current storage
+            std::vector<Array*> m_Retired;              ///< Replaced storage, owner only
+    };
+
+}   ///< namespace Threading
+}   ///< namespace Core
+}   ///< namespace SteerStone
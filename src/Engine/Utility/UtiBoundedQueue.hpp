@@ -0,0 +1,297 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "Core/Core.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <new>
+#include <type_traits>
+
+#define BOUNDED_QUEUE_SPIN_COUNT    64      ///< Empty polls before a waiting consumer starts yielding
+#define BOUNDED_QUEUE_YIELD_COUNT   16      ///< Yields before a waiting consumer parks
+
+namespace SteerStone { namespace Core { namespace Utils {
+
+    /// Bounded lock free ring (Vyukov), every cell carries a sequence number telling producers and
+    /// consumers whose turn it is. Producers claim a cell with a single CAS, consumers are lock free too
+    /// and with MultiConsumer false they do not even CAS.
+    ///
+    /// Waiting consumers spin, then yield, then park. Producers only take the park mutex when a
+    /// consumer is parked, a busy consumer costs producers no syscall.
+    template<typename T, bool MultiConsumer> class BoundedQueue
+    {
+        DISALLOW_COPY_AND_ASSIGN(BoundedQueue);
+
+        /// Ring cell
+        struct Cell
+        {
+            std::atomic<uint64> Sequence;                                               ///< Position cell is ready for
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type Storage;         ///< Item
+        };
+
+        public:
+            /// Constructor
+            /// @p_Capacity : Capacity, rounded up to a power of 2
+            explicit BoundedQueue(std::size_t p_Capacity)
+                : m_Closed(false), m_Parked(0), m_Head(0), m_Tail(0)
+            {
+                std::size_t l_Capacity = 2;
+                while (l_Capacity < p_Capacity)
+                    l_Capacity <<= 1;
+
+                m_Mask  = l_Capacity - 1;
+                m_Cells.reset(new Cell[l_Capacity]);
+
+                for (std::size_t l_I = 0; l_I < l_Capacity; l_I++)
+                    m_Cells[l_I].Sequence.store(l_I, std::memory_order_relaxed);
+            }
+            /// Deconstructor, items left are destroyed
+            ~BoundedQueue()
+            {
+                T l_Item;
+                while (TryPop(l_Item))
+                {
+                }
+            }
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Push item, fails if queue is full, item is only moved from on success
+            /// @p_Item : Item
+            template<typename U> bool TryPush(U&& p_Item)
+            {
+                uint64 l_Position = m_Tail.load(std::memory_order_relaxed);
+                Cell* l_Cell = nullptr;
+
+                while (true)
+                {
+                    l_Cell = &m_Cells[l_Position & m_Mask];
+
+                    const uint64 l_Sequence = l_Cell->Sequence.load(std::memory_order_acquire);
+                    const int64 l_Difference = static_cast<int64>(l_Sequence) - static_cast<int64>(l_Position);
+
+                    if (l_Difference == 0)
+                    {
+                        if (m_Tail.compare_exchange_weak(l_Position, l_Position + 1, std::memory_order_relaxed))
+                            break;
+                    }
+                    /// Cell still holds an item of the previous lap
+                    else if (l_Difference < 0)
+                        return false;
+                    else
+                        l_Position = m_Tail.load(std::memory_order_relaxed);
+                }
+
+                new (&l_Cell->Storage) T(std::forward<U>(p_Item));
+                l_Cell->Sequence.store(l_Position + 1, std::memory_order_release);
+
+                WakeConsumer();
+                return true;
+            }
+            /// Push item, waits for room if queue is full so producers are slowed down to the pace of consumers
+            /// @p_Item : Item
+            template<typename U> void Push(U&& p_Item)
+            {
+                uint32 l_Attempts = 0;
+
+                while (!TryPush(std::forward<U>(p_Item)))
+                {
+                    if (++l_Attempts > BOUNDED_QUEUE_SPIN_COUNT)
+                        std::this_thread::yield();
+                }
+            }
+
+            /// Pop item, fails if queue is empty
+            /// @p_Item : Popped item
+            bool TryPop(T& p_Item)
+            {
+                uint64 l_Position = m_Head.load(std::memory_order_relaxed);
+                Cell* l_Cell = nullptr;
+
+                while (true)
+                {
+                    l_Cell = &m_Cells[l_Position & m_Mask];
+
+                    const uint64 l_Sequence = l_Cell->Sequence.load(std::memory_order_acquire);
+                    const int64 l_Difference = static_cast<int64>(l_Sequence) - static_cast<int64>(l_Position + 1);
+
+                    if (l_Difference == 0)
+                    {
+                        if (!MultiConsumer)
+                        {
+                            m_Head.store(l_Position + 1, std::memory_order_relaxed);
+                            break;
+                        }
+
+                        if (m_Head.compare_exchange_weak(l_Position, l_Position + 1, std::memory_order_relaxed))
+                            break;
+                    }
+                    /// Cell has not been written yet
+                    else if (l_Difference < 0)
+                        return false;
+                    else
+                        l_Position = m_Head.load(std::memory_order_relaxed);
+                }
+
+                T* l_Stored = std::launder(reinterpret_cast<T*>(&l_Cell->Storage));
+                p_Item = std::move(*l_Stored);
+                l_Stored->~T();
+
+                /// Cell is free for the producer of the next lap
+                l_Cell->Sequence.store(l_Position + m_Mask + 1, std::memory_order_release);
+                return true;
+            }
+            /// Pop up to p_Max items
+            /// @p_Items : Output, must hold p_Max items
+            /// @p_Max   : Maximum amount of items
+            /// Returns amount of popped items
+            std::size_t TryPopBatch(T* p_Items, std::size_t p_Max)
+            {
+                std::size_t l_Count = 0;
+
+                while (l_Count < p_Max && TryPop(p_Items[l_Count]))
+                    l_Count++;
+
+                return l_Count;
+            }
+
+            /// Pop up to p_Max items, waits until at least one is available
+            /// @p_Items : Output, must hold p_Max items
+            /// @p_Max   : Maximum amount of items
+            /// Returns amount of popped items, 0 once queue is closed and drained
+            std::size_t WaitPopBatch(T* p_Items, std::size_t p_Max)
+            {
+                uint32 l_Attempts = 0;
+
+                while (true)
+                {
+                    if (const std::size_t l_Count = TryPopBatch(p_Items, p_Max))
+                        return l_Count;
+
+                    if (m_Closed.load(std::memory_order_acquire))
+                    {
+                        /// Items pushed right before closing
+                        return TryPopBatch(p_Items, p_Max);
+                    }
+
+                    l_Attempts++;
+
+                    if (l_Attempts <= BOUNDED_QUEUE_SPIN_COUNT)
+                        continue;
+
+                    if (l_Attempts <= BOUNDED_QUEUE_SPIN_COUNT + BOUNDED_QUEUE_YIELD_COUNT)
+                    {
+                        std::this_thread::yield();
+                        continue;
+                    }
+
+                    Park();
+                    l_Attempts = 0;
+                }
+            }
+            /// Pop item, waits until one is available
+            /// @p_Item : Popped item
+            /// Returns false once queue is closed and drained
+            bool WaitPop(T& p_Item)
+            {
+                return WaitPopBatch(&p_Item, 1) != 0;
+            }
+
+            /// Close queue, waiting consumers return once it is drained
+            void Close()
+            {
+                m_Closed.store(true, std::memory_order_seq_cst);
+
+                std::lock_guard<std::mutex> l_Guard(m_ParkMutex);
+                m_ParkCondition.notify_all();
+            }
+
+            /// Get approximate amount of queued items
+            std::size_t GetSize() const
+            {
+                const uint64 l_Tail = m_Tail.load(std::memory_order_relaxed);
+                const uint64 l_Head = m_Head.load(std::memory_order_relaxed);
+
+                return l_Tail > l_Head ? static_cast<std::size_t>(l_Tail - l_Head) : 0;
+            }
+            /// Get capacity
+            std::size_t GetCapacity() const
+            {
+                return m_Mask + 1;
+            }
+
+        private:
+            /// Check if the next cell for consumers has been written
+            bool HasItem() const
+            {
+                const uint64 l_Position = m_Head.load(std::memory_order_seq_cst);
+                return m_Cells[l_Position & m_Mask].Sequence.load(std::memory_order_seq_cst) == l_Position + 1;
+            }
+            /// Sleep until an item is pushed or queue is closed
+            void Park()
+            {
+                std::unique_lock<std::mutex> l_Guard(m_ParkMutex);
+
+                /// Announce ourself before checking, a producer publishing after our check sees us
+                m_Parked.fetch_add(1, std::memory_order_seq_cst);
+
+                while (!HasItem() && !m_Closed.load(std::memory_order_seq_cst))
+                    m_ParkCondition.wait(l_Guard);
+
+                m_Parked.fetch_sub(1, std::memory_order_relaxed);
+            }
+            /// Wake a parked consumer, if any
+            void WakeConsumer()
+            {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+
+                if (m_Parked.load(std::memory_order_seq_cst) == 0)
+                    return;
+
+                std::lock_guard<std::mutex> l_Guard(m_ParkMutex);
+                m_ParkCondition.notify_one();
+            }
+
+        private:
+            std::unique_ptr<Cell[]>     m_Cells;            ///< Ring
+            std::size_t                 m_Mask;             ///< Capacity - 1
+            std::atomic<bool>           m_Closed;           ///< No more items will be pushed
+            std::atomic<uint32>         m_Parked;           ///< Consumers sleeping in Park
+            std::mutex                  m_ParkMutex;        ///< Mutex of parked consumers
+            std::condition_variable     m_ParkCondition;    ///< Parked consumers
+
+            alignas(64) std::atomic<uint64> m_Head;         ///< Next position consumers read, own cache line
+            alignas(64) std::atomic<uint64> m_Tail;         ///< Next position producers write, own cache line
+    };
+
+    /// Bounded lock free queue with many producers and a single consumer, such as a worker inbox
+    template<typename T> using MPSCQueue = BoundedQueue<T, false>;
+    /// Bounded lock free queue with many producers and many consumers
+    template<typename T> using MPMCQueue = BoundedQueue<T, true>;
+
+}   ///< namespace Utils
+}   ///< namespace Core
+}   ///< namespace SteerStone
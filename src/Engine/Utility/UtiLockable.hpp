@@ -21,95 +21,157 @@
 
 #include "Core/Core.hpp"
 
+#include <atomic>
 #include <mutex>
 #include <shared_mutex>
+#include <thread>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+    #include <immintrin.h>
+    #define LOCKABLE_CPU_RELAX() _mm_pause()
+#else
+    #define LOCKABLE_CPU_RELAX() std::this_thread::yield()
+#endif
+
+/// Attempts made on a contended lock before parking the thread
+#define LOCKABLE_SPIN_COUNT 64
 
 namespace SteerStone { namespace Core { namespace Utils {
 
-    /// Base lock object
-    class LockableBase
+    /// Mutex which spins for a short while before parking the thread in the kernel
+    /// Critical sections guarded by it are a few instructions long, so the owner usually releases before we park
+    class SpinMutex
     {
+        DISALLOW_COPY_AND_ASSIGN(SpinMutex);
+
         public:
-            /// Lock
-            virtual void Lock() = 0;
-            /// Lock read
-            virtual void LockRead();
-            /// Lock write
-            virtual void LockWrite();
-            /// TryLock
-            virtual bool TryLock() = 0;
-            /// Try lock read
-            virtual bool TryLockRead();
-            /// Try lock write
-            virtual bool TryLockWrite();
+            /// Constructor
+            SpinMutex() = default;
 
+            /// Lock
+            void lock()
+            {
+                for (uint32 l_I = 0; l_I < LOCKABLE_SPIN_COUNT; ++l_I)
+                {
+                    if (m_Mutex.try_lock())
+                        return;
+
+                    LOCKABLE_CPU_RELAX();
+                }
+
+                m_Mutex.lock();
+            }
+            /// Try lock
+            bool try_lock()
+            {
+                return m_Mutex.try_lock();
+            }
             /// Unlock
-            virtual void Unlock() = 0;
+            void unlock()
+            {
+                m_Mutex.unlock();
+            }
 
-    };
+        private:
+            std::mutex m_Mutex;     ///< Parking mutex
 
-    //////////////////////////////////////////////////////////////////////////
-    //////////////////////////////////////////////////////////////////////////
+    };
 
-    /// Simple lock object
-    class Lockable : public LockableBase
+    /// Mutex which does nothing, for objects only touched by a single thread
+    class NullMutex
     {
         public:
             /// Lock
-            void Lock() override final;
-            /// TryLock
-            bool TryLock() override final;
-
+            void lock() { }
+            /// Try lock
+            bool try_lock() { return true; }
             /// Unlock
-            void Unlock() override final;
-
-        private:
-            std::mutex m_Lock;      ///< Mutex
-
+            void unlock() { }
+            /// Lock shared
+            void lock_shared() { }
+            /// Try lock shared
+            bool try_lock_shared() { return true; }
+            /// Unlock shared
+            void unlock_shared() { }
     };
 
     //////////////////////////////////////////////////////////////////////////
     //////////////////////////////////////////////////////////////////////////
 
-    /// RW lock object
-    class LockableReadWrite : public LockableBase
+    /// Detect if mutex policy supports shared locking
+    template<typename t_Mutex, typename = void> struct IsSharedMutex : std::false_type { };
+    template<typename t_Mutex> struct IsSharedMutex<t_Mutex, std::void_t<decltype(std::declval<t_Mutex&>().lock_shared())>> : std::true_type { };
+
+    /// Lock object over a mutex policy, methods are not virtual so guards inline down to the mutex atomics
+    /// Read locks fall back to exclusive locks when the policy has no shared mode
+    template<typename t_Mutex> class LockablePolicy
     {
         public:
             /// Lock
-            void Lock() override final;
-            /// TryLock
-            bool TryLock() override final;
+            void Lock()
+            {
+                m_Lock.lock();
+            }
             /// Lock read
-            void LockRead() override final;
+            void LockRead()
+            {
+                if constexpr (IsSharedMutex<t_Mutex>::value)
+                    m_Lock.lock_shared();
+                else
+                    m_Lock.lock();
+            }
             /// Lock write
-            void LockWrite() override final;
+            void LockWrite()
+            {
+                m_Lock.lock();
+            }
+            /// TryLock
+            bool TryLock()
+            {
+                return m_Lock.try_lock();
+            }
             /// Try lock read
-            bool TryLockRead() override final;
+            bool TryLockRead()
+            {
+                if constexpr (IsSharedMutex<t_Mutex>::value)
+                    return m_Lock.try_lock_shared();
+                else
+                    return m_Lock.try_lock();
+            }
             /// Try lock write
-            bool TryLockWrite() override final;
+            bool TryLockWrite()
+            {
+                return m_Lock.try_lock();
+            }
 
             /// Unlock
-            virtual void Unlock() override final;
+            void Unlock()
+            {
+                m_Lock.unlock();
+            }
+            /// Unlock read
+            void UnlockRead()
+            {
+                if constexpr (IsSharedMutex<t_Mutex>::value)
+                    m_Lock.unlock_shared();
+                else
+                    m_Lock.unlock();
+            }
 
         private:
-            std::shared_mutex m_Lock;   ///< Mutex
+            t_Mutex m_Lock;     ///< Mutex
 
     };
 
     //////////////////////////////////////////////////////////////////////////
     //////////////////////////////////////////////////////////////////////////
 
-    class NullLockable : public LockableBase
-    {
-        public:
-            /// Lock
-            void Lock() override final;
-            /// TryLock
-            bool TryLock() override final;
-
-            /// Unlock
-            void Unlock() override final;
-    };
+    /// Simple lock object
+    using Lockable          = LockablePolicy<SpinMutex>;
+    /// RW lock object
+    using LockableReadWrite = LockablePolicy<std::shared_mutex>;
+    /// Lock object which does nothing
+    using NullLockable      = LockablePolicy<NullMutex>;
 
 }   ///< namespace Utils
 }   ///< namespace Core
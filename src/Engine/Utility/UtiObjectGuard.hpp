@@ -20,6 +20,7 @@
 #include <PCH/Precompiled.hpp>
 
 #include "Core/Core.hpp"
+#include "Utility/UtiLockable.hpp"
 
 namespace SteerStone { namespace Core { namespace Utils {
 
@@ -165,7 +166,7 @@ namespace SteerStone { namespace Core { namespace Utils {
         if (m_Flags & ObjectGuardFlags_Ignore)
             return;
 
-        m_Object->Unlock();
+        m_Object->UnlockRead();
     }
 
     //////////////////////////////////////////////////////////////////////////
@@ -220,6 +221,86 @@ namespace SteerStone { namespace Core { namespace Utils {
         return m_Object;
     }
 
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Value which can only be reached while its lock is held
+    /// @t_Mutex : Mutex policy, SpinMutex, std::shared_mutex or NullMutex
+    template<typename T, typename t_Mutex = SpinMutex> class Guarded
+    {
+        DISALLOW_COPY_AND_ASSIGN(Guarded);
+
+        public:
+            /// Access to the value, lock is released when it goes out of scope
+            template<bool t_Shared> class Access
+            {
+                DISALLOW_COPY_AND_ASSIGN(Access);
+
+                public:
+                    /// Constructor
+                    /// @p_Guarded : Guarded value to lock
+                    explicit Access(Guarded* p_Guarded)
+                        : m_Guarded(p_Guarded)
+                    {
+                        if constexpr (t_Shared)
+                            m_Guarded->m_Lock.LockRead();
+                        else
+                            m_Guarded->m_Lock.Lock();
+                    }
+                    /// Move constructor
+                    /// @p_Other : Access to take over
+                    Access(Access&& p_Other)
+                        : m_Guarded(p_Other.m_Guarded)
+                    {
+                        p_Other.m_Guarded = nullptr;
+                    }
+                    /// Destructor
+                    ~Access()
+                    {
+                        if (!m_Guarded)
+                            return;
+
+                        if constexpr (t_Shared)
+                            m_Guarded->m_Lock.UnlockRead();
+                        else
+                            m_Guarded->m_Lock.Unlock();
+                    }
+
+                    /// Overload indirection operator
+                    std::conditional_t<t_Shared, T const*, T*> operator-> () const { return &m_Guarded->m_Value; }
+                    /// Overload deference operator
+                    std::conditional_t<t_Shared, T const&, T&> operator* () const { return m_Guarded->m_Value; }
+
+                private:
+                    Guarded* m_Guarded;     ///< Guarded value, null once moved from
+
+            };
+
+        public:
+            /// Constructor
+            /// @p_Args : Arguments forwarded to the value
+            template<typename... t_Args> explicit Guarded(t_Args&&... p_Args)
+                : m_Value(std::forward<t_Args>(p_Args)...)
+            {
+            }
+
+            /// Lock value for writing
+            Access<false> Lock()
+            {
+                return Access<false>(this);
+            }
+            /// Lock value for reading, value is const while shared
+            Access<true> LockRead()
+            {
+                return Access<true>(this);
+            }
+
+        private:
+            T m_Value;                          ///< Value
+            LockablePolicy<t_Mutex> m_Lock;     ///< Lock guarding value
+
+    };
+
 }   ///< namespace Utils
 }   ///< namespace Core
 }   ///< namespace SteerStone
@@ -24,6 +24,13 @@
 #include <vector>
 #include <tuple>
 #include <sstream>
+#include <string_view>
+#include <charconv>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+
+#define STRING_FORMAT_MAX_SEGMENTS  32      ///< Literal parts and tokens a parsed format can hold
 
 namespace SteerStone { namespace Core { namespace Utils {
 
@@ -91,6 +98,302 @@ namespace SteerStone { namespace Core { namespace Utils {
     //////////////////////////////////////////////////////////////////////////
     //////////////////////////////////////////////////////////////////////////
 
+    /// Format string split in literal parts and %N tokens, parsed at compile time when declared constexpr
+    class StringFormat
+    {
+        public:
+            /// Part of a format string
+            struct Segment
+            {
+                uint32 Offset   = 0;        ///< Offset in format string
+                uint32 Length   = 0;        ///< Length in format string
+                int32  Argument = -1;       ///< Argument of a token, -1 for literal text
+            };
+
+        public:
+            /// Constructor
+            /// @p_Format : Format string, must outlive the format
+            constexpr explicit StringFormat(const char* p_Format)
+                : m_Format(p_Format), m_Length(0), m_SegmentCount(0), m_Segments()
+            {
+                while (p_Format[m_Length])
+                    m_Length++;
+
+                uint32 l_Start  = 0;
+                uint32 l_I      = 0;
+
+                while (l_I < m_Length)
+                {
+                    if (p_Format[l_I] != '%' || l_I + 1 >= m_Length || p_Format[l_I + 1] < '0' || p_Format[l_I + 1] > '9')
+                    {
+                        l_I++;
+                        continue;
+                    }
+
+                    /// Rest of the string stays literal
+                    if (m_SegmentCount + 3 > STRING_FORMAT_MAX_SEGMENTS)
+                        break;
+
+                    uint32 l_End      = l_I + 1;
+                    int32  l_Argument = 0;
+
+                    while (l_End < m_Length && p_Format[l_End] >= '0' && p_Format[l_End] <= '9')
+                        l_Argument = l_Argument * 10 + (p_Format[l_End++] - '0');
+
+                    if (l_I > l_Start)
+                        AddSegment(l_Start, l_I - l_Start, -1);
+
+                    AddSegment(l_I, l_End - l_I, l_Argument);
+
+                    l_Start = l_End;
+                    l_I     = l_End;
+                }
+
+                if (l_Start < m_Length)
+                    AddSegment(l_Start, m_Length - l_Start, -1);
+            }
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Get format string
+            constexpr std::string_view GetFormat() const
+            {
+                return std::string_view(m_Format, m_Length);
+            }
+            /// Get amount of segments
+            constexpr uint32 GetSegmentCount() const
+            {
+                return m_SegmentCount;
+            }
+            /// Get segment
+            /// @p_Index : Segment index
+            constexpr Segment const& GetSegment(uint32 p_Index) const
+            {
+                return m_Segments[p_Index];
+            }
+
+        private:
+            /// Append a segment
+            /// @p_Offset   : Offset in format string
+            /// @p_Length   : Length in format string
+            /// @p_Argument : Argument of a token, -1 for literal text
+            constexpr void AddSegment(uint32 p_Offset, uint32 p_Length, int32 p_Argument)
+            {
+                m_Segments[m_SegmentCount].Offset   = p_Offset;
+                m_Segments[m_SegmentCount].Length   = p_Length;
+                m_Segments[m_SegmentCount].Argument = p_Argument;
+                m_SegmentCount++;
+            }
+
+        private:
+            const char* m_Format;                                   ///< Format string
+            uint32      m_Length;                                   ///< Length of format string
+            uint32      m_SegmentCount;                             ///< Amount of segments
+            Segment     m_Segments[STRING_FORMAT_MAX_SEGMENTS];     ///< Segments
+    };
+
+    /// Caller supplied buffer for StringBuilderBuffer, characters which do not fit are dropped
+    /// Exposes the part of the std::string interface the builder writes through
+    class FixedStringBuffer
+    {
+        public:
+            /// Constructor
+            /// @p_Buffer   : Buffer
+            /// @p_Capacity : Size of buffer
+            FixedStringBuffer(char* p_Buffer, std::size_t p_Capacity)
+                : m_Buffer(p_Buffer), m_Capacity(p_Capacity), m_Size(0)
+            {
+            }
+
+            /// Append characters
+            /// @p_Data : Characters
+            /// @p_Size : Amount of characters
+            void append(const char* p_Data, std::size_t p_Size)
+            {
+                const std::size_t l_Size = std::min(p_Size, m_Capacity - m_Size);
+
+                memcpy(m_Buffer + m_Size, p_Data, l_Size);
+                m_Size += l_Size;
+            }
+            /// Append a character
+            /// @p_Char : Character
+            void push_back(char p_Char)
+            {
+                if (m_Size < m_Capacity)
+                    m_Buffer[m_Size++] = p_Char;
+            }
+            /// Get amount of written characters
+            std::size_t size() const
+            {
+                return m_Size;
+            }
+
+        private:
+            char*       m_Buffer;       ///< Buffer
+            std::size_t m_Capacity;     ///< Size of buffer
+            std::size_t m_Size;         ///< Written characters
+    };
+
+    /// Append an argument of StringBuilder
+    /// @p_Output : Output
+    /// @p_Value  : Value to append
+    template<class O, class T> void StringBuilderAppend(O& p_Output, const T& p_Value)
+    {
+        if constexpr (std::is_same<T, bool>::value)
+            p_Output.push_back(p_Value ? '1' : '0');
+        else if constexpr (std::is_same<T, char>::value)
+            p_Output.push_back(p_Value);
+        /// uint8 and int8 are written as numbers like Converter does
+        else if constexpr (std::is_integral<T>::value)
+        {
+            char l_Buffer[24];
+            const auto l_Result = std::to_chars(l_Buffer, l_Buffer + sizeof(l_Buffer), static_cast<typename std::conditional<std::is_signed<T>::value, int64, uint64>::type>(p_Value));
+            p_Output.append(l_Buffer, static_cast<std::size_t>(l_Result.ptr - l_Buffer));
+        }
+        /// Same output as the default stream precision
+        else if constexpr (std::is_floating_point<T>::value)
+        {
+            char l_Buffer[32];
+            const int l_Length = snprintf(l_Buffer, sizeof(l_Buffer), "%g", static_cast<double>(p_Value));
+
+            if (l_Length > 0)
+                p_Output.append(l_Buffer, std::min<std::size_t>(l_Length, sizeof(l_Buffer) - 1));
+        }
+        else if constexpr (std::is_convertible<const T&, std::string_view>::value)
+        {
+            const std::string_view l_View(p_Value);
+            p_Output.append(l_View.data(), l_View.size());
+        }
+        /// Anything else goes through a stream
+        else
+        {
+            const std::string l_String = Converter<std::string>::ToString(p_Value);
+            p_Output.append(l_String.data(), l_String.size());
+        }
+    }
+    /// Append a type erased argument of StringBuilder
+    /// @p_Output : Output
+    /// @p_Value  : Pointer to value
+    template<class O, class T> void StringBuilderAppendErased(O& p_Output, const void* p_Value)
+    {
+        StringBuilderAppend(p_Output, *static_cast<const T*>(p_Value));
+    }
+
+    /// Append a string replacing all %x by corresponding argument in a single pass, tokens without argument are kept
+    /// @p_Output : Output, std::string or FixedStringBuffer
+    /// @p_Str    : Subject
+    /// @p_Args   : Arguments
+    template<class O, typename... Args> void StringBuilderTo(O& p_Output, std::string_view const p_Str, const Args&... p_Args)
+    {
+        using Appender = void(*)(O&, const void*);
+
+        const Appender l_Appenders[sizeof...(Args) + 1] = { &StringBuilderAppendErased<O, Args>..., nullptr };
+        const void* l_Values[sizeof...(Args) + 1]       = { static_cast<const void*>(&p_Args)..., nullptr };
+
+        std::size_t l_Start = 0;
+        std::size_t l_I     = 0;
+
+        while (l_I < p_Str.size())
+        {
+            if (p_Str[l_I] != '%' || l_I + 1 >= p_Str.size() || p_Str[l_I + 1] < '0' || p_Str[l_I + 1] > '9')
+            {
+                l_I++;
+                continue;
+            }
+
+            std::size_t l_End   = l_I + 1;
+            std::size_t l_Index = 0;
+
+            while (l_End < p_Str.size() && p_Str[l_End] >= '0' && p_Str[l_End] <= '9')
+                l_Index = l_Index * 10 + (p_Str[l_End++] - '0');
+
+            if (l_Index < sizeof...(Args))
+            {
+                p_Output.append(p_Str.data() + l_Start, l_I - l_Start);
+                l_Appenders[l_Index](p_Output, l_Values[l_Index]);
+                l_Start = l_End;
+            }
+
+            l_I = l_End;
+        }
+
+        p_Output.append(p_Str.data() + l_Start, p_Str.size() - l_Start);
+    }
+    /// Append a string replacing all %x by corresponding argument, format has been parsed at compile time
+    /// @p_Output : Output, std::string or FixedStringBuffer
+    /// @p_Format : Parsed format
+    /// @p_Args   : Arguments
+    template<class O, typename... Args> void StringBuilderTo(O& p_Output, StringFormat const& p_Format, const Args&... p_Args)
+    {
+        using Appender = void(*)(O&, const void*);
+
+        const Appender l_Appenders[sizeof...(Args) + 1] = { &StringBuilderAppendErased<O, Args>..., nullptr };
+        const void* l_Values[sizeof...(Args) + 1]       = { static_cast<const void*>(&p_Args)..., nullptr };
+
+        const std::string_view l_Format = p_Format.GetFormat();
+
+        for (uint32 l_I = 0; l_I < p_Format.GetSegmentCount(); l_I++)
+        {
+            StringFormat::Segment const& l_Segment = p_Format.GetSegment(l_I);
+
+            if (l_Segment.Argument >= 0 && static_cast<std::size_t>(l_Segment.Argument) < sizeof...(Args))
+                l_Appenders[l_Segment.Argument](p_Output, l_Values[l_Segment.Argument]);
+            else
+                p_Output.append(l_Format.data() + l_Segment.Offset, l_Segment.Length);
+        }
+    }
+    /// Build a string replacing all %x by corresponding argument into a caller supplied buffer, result is truncated to the buffer
+    /// @p_Buffer : Buffer
+    /// @p_Str    : Subject, string or parsed format
+    /// @p_Args   : Arguments
+    template<std::size_t N, class S, typename... Args> std::string_view StringBuilderBuffer(char (&p_Buffer)[N], const S& p_Str, const Args&... p_Args)
+    {
+        FixedStringBuffer l_Output(p_Buffer, N);
+        StringBuilderTo(l_Output, p_Str, p_Args...);
+
+        return std::string_view(p_Buffer, l_Output.size());
+    }
+
+    /// Build a string replacing all %x by corresponding argument
+    /// @p_Str  : Subject
+    /// @p_Args : Arguments
+    template<typename... Args> std::string StringBuilder(const std::string& p_Str, const Args&... p_Args)
+    {
+        std::string l_Result;
+        l_Result.reserve(p_Str.size() + sizeof...(Args) * 8);
+
+        StringBuilderTo(l_Result, std::string_view(p_Str), p_Args...);
+        return l_Result;
+    }
+    /// Build a string replacing all %x by corresponding argument
+    /// @p_Str  : Subject
+    /// @p_Args : Arguments
+    template<typename... Args> std::string StringBuilder(const char* p_Str, const Args&... p_Args)
+    {
+        const std::string_view l_Str(p_Str);
+
+        std::string l_Result;
+        l_Result.reserve(l_Str.size() + sizeof...(Args) * 8);
+
+        StringBuilderTo(l_Result, l_Str, p_Args...);
+        return l_Result;
+    }
+    /// Build a string replacing all %x by corresponding argument, format has been parsed at compile time
+    /// @p_Format : Parsed format
+    /// @p_Args   : Arguments
+    template<typename... Args> std::string StringBuilder(StringFormat const& p_Format, const Args&... p_Args)
+    {
+        std::string l_Result;
+        l_Result.reserve(p_Format.GetFormat().size() + sizeof...(Args) * 8);
+
+        StringBuilderTo(l_Result, p_Format, p_Args...);
+        return l_Result;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
     /// Build string builder token
     /// @p_Index : Token index
     template<class T> inline T StringBuilderToken(int p_Index);
@@ -111,36 +414,29 @@ namespace SteerStone { namespace Core { namespace Utils {
     {
         template<class T, typename... TupleArgs> static void UnpackTuple(std::vector<T>& p_Vector, const std::tuple<TupleArgs...>& p_Tuple) { }
     };
-    /// Build a string replacing all %x by corresponding argument
+    /// Build a wide string replacing all %x by corresponding argument
     /// @p_Str  : Subject
     /// @p_Args : Arguments
-    template<class T, typename... Args> T StringBuilder(const T& p_Str, Args ...p_Args)
+    template<typename... Args> std::wstring StringBuilder(const std::wstring& p_Str, Args ...p_Args)
     {
         auto l_ArgsTuple = std::make_tuple(p_Args...);
 
-        std::vector<T> l_Args;
-        std::vector<T> l_Tokens;
+        std::vector<std::wstring> l_Args;
+        std::vector<std::wstring> l_Tokens;
 
         auto l_ArgsCount = std::tuple_size<decltype(l_ArgsTuple)>::value;
 
         l_Args.reserve(l_ArgsCount);
         l_Tokens.resize(l_ArgsCount);
 
-        _SBU<sizeof...(Args), sizeof...(Args)>::template UnpackTuple<std::string, Args...>(l_Args, l_ArgsTuple);
+        _SBU<sizeof...(Args), sizeof...(Args)>::template UnpackTuple<std::wstring, Args...>(l_Args, l_ArgsTuple);
 
         for (std::size_t l_I = 0; l_I < l_ArgsCount; ++l_I)
-            l_Tokens[l_I] = StringBuilderToken<T>(l_I);
+            l_Tokens[l_I] = StringBuilderToken<std::wstring>(l_I);
 
         return String::ReplaceAll(p_Str, l_Tokens, l_Args);
     }
-    /// Build a string replacing all %x by corresponding argument
-    /// @p_Str  : Subject
-    /// @p_Args : Arguments
-    template<typename... Args> std::string StringBuilder(const char* p_Str, Args ...p_Args)
-    {
-        return StringBuilder(std::string(p_Str), p_Args...);
-    }
-    /// Build a string replacing all %x by corresponding argument
+    /// Build a wide string replacing all %x by corresponding argument
     /// @p_Str  : Subject
     /// @p_Args : Arguments
     template<typename... Args> std::wstring StringBuilder(const wchar_t* p_Str, Args ...p_Args)
@@ -266,11 +562,11 @@ namespace SteerStone { namespace Core { namespace Utils {
     //////////////////////////////////////////////////////////////////////////
     //////////////////////////////////////////////////////////////////////////
 
-    /// Split a sentence by a delimiter
+    /// Split a sentence by a delimiter, every token is copied; Utils::Split iterates views instead
     /// @p_Str              : Sentence
     /// @p_Delimiter        : Split artifact
     /// @p_KeepEmptyElement : Should keep empty element
-    static std::vector<std::string> SplitAll(const std::string& p_Str, const std::string p_Delimiter, const bool p_KeepEmptyElement)
+    static std::vector<std::string> SplitAll(const std::string& p_Str, const std::string& p_Delimiter, const bool p_KeepEmptyElement)
     {
         std::vector<std::string> l_Result;
 
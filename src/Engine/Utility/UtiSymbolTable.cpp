@@ -0,0 +1,215 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <Precompiled.hpp>
+#include <cstring>
+
+#include "UtiSymbolTable.hpp"
+
+namespace SteerStone { namespace Core { namespace Utils {
+
+    /// Fold ASCII character to lower case
+    /// @p_Char : Character
+    static inline char FoldCase(char const p_Char)
+    {
+        return (p_Char >= 'A' && p_Char <= 'Z') ? static_cast<char>(p_Char - 'A' + 'a') : p_Char;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Hash key
+    /// @p_Key : Key
+    std::size_t SymbolTable::KeyHash::operator()(std::string_view const p_Key) const
+    {
+        /// FNV-1a
+        uint64 l_Hash = 14695981039346656037ULL;
+
+        for (char const l_Char : p_Key)
+        {
+            l_Hash ^= static_cast<uint8>(CaseInsensitive ? FoldCase(l_Char) : l_Char);
+            l_Hash *= 1099511628211ULL;
+        }
+
+        return static_cast<std::size_t>(l_Hash);
+    }
+    /// Compare keys
+    /// @p_Left  : Left key
+    /// @p_Right : Right key
+    bool SymbolTable::KeyEqual::operator()(std::string_view const p_Left, std::string_view const p_Right) const
+    {
+        if (p_Left.size() != p_Right.size())
+            return false;
+
+        if (!CaseInsensitive)
+            return p_Left == p_Right;
+
+        for (std::size_t l_I = 0; l_I < p_Left.size(); ++l_I)
+        {
+            if (FoldCase(p_Left[l_I]) != FoldCase(p_Right[l_I]))
+                return false;
+        }
+
+        return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get case sensitive table shared by the engine, log systems and task names
+    SymbolTable* SymbolTable::GetDefault()
+    {
+        /// Never destroyed, symbols are resolved by static destructors
+        static SymbolTable* s_Table = new SymbolTable(false);
+        return s_Table;
+    }
+    /// Get case insensitive table shared by the engine, user and room names
+    SymbolTable* SymbolTable::GetNames()
+    {
+        static SymbolTable* s_Table = new SymbolTable(true);
+        return s_Table;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    /// @p_CaseInsensitive : Strings differing only in ASCII case map to the same symbol, the first spelling is kept
+    SymbolTable::SymbolTable(bool p_CaseInsensitive)
+        : m_CaseInsensitive(p_CaseInsensitive), m_Lookup(64, KeyHash{ p_CaseInsensitive }, KeyEqual{ p_CaseInsensitive }),
+        m_Count(0), m_StorageCurrent(nullptr), m_StorageLeft(0)
+    {
+        for (std::atomic<std::string_view*>& l_Page : m_Pages)
+            l_Page.store(nullptr, std::memory_order_relaxed);
+    }
+    /// Deconstructor
+    SymbolTable::~SymbolTable()
+    {
+        for (std::atomic<std::string_view*>& l_Page : m_Pages)
+            delete[] l_Page.load(std::memory_order_relaxed);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get symbol of string, interning it if unknown
+    /// @p_String : String
+    Symbol SymbolTable::Intern(std::string_view const p_String)
+    {
+        {
+            std::shared_lock<std::shared_mutex> l_Guard(m_Mutex);
+
+            auto const l_Itr = m_Lookup.find(p_String);
+            if (l_Itr != m_Lookup.end())
+                return Symbol(l_Itr->second);
+        }
+
+        std::unique_lock<std::shared_mutex> l_Guard(m_Mutex);
+
+        /// Another thread may have interned it while we waited
+        auto const l_Itr = m_Lookup.find(p_String);
+        if (l_Itr != m_Lookup.end())
+            return Symbol(l_Itr->second);
+
+        const uint32 l_Index = m_Count.load(std::memory_order_relaxed);
+        const uint32 l_Page  = l_Index >> SYMBOL_TABLE_PAGE_SHIFT;
+
+        if (l_Page >= SYMBOL_TABLE_MAX_PAGES)
+            return Symbol();
+
+        std::string_view* l_Strings = m_Pages[l_Page].load(std::memory_order_relaxed);
+        if (!l_Strings)
+        {
+            l_Strings = new std::string_view[std::size_t(1) << SYMBOL_TABLE_PAGE_SHIFT];
+            m_Pages[l_Page].store(l_Strings, std::memory_order_release);
+        }
+
+        const std::string_view l_Stored = Store(p_String);
+        l_Strings[l_Index & ((1u << SYMBOL_TABLE_PAGE_SHIFT) - 1)] = l_Stored;
+
+        /// Ids start at 1, 0 is the invalid symbol
+        m_Lookup.emplace(l_Stored, l_Index + 1);
+        m_Count.store(l_Index + 1, std::memory_order_release);
+
+        return Symbol(l_Index + 1);
+    }
+    /// Get symbol of string without interning it, invalid if unknown
+    /// @p_String : String
+    Symbol SymbolTable::Find(std::string_view const p_String) const
+    {
+        std::shared_lock<std::shared_mutex> l_Guard(m_Mutex);
+
+        auto const l_Itr = m_Lookup.find(p_String);
+        return l_Itr != m_Lookup.end() ? Symbol(l_Itr->second) : Symbol();
+    }
+    /// Get string of symbol, empty if not from this table
+    /// @p_Symbol : Symbol
+    std::string_view SymbolTable::GetString(Symbol const p_Symbol) const
+    {
+        if (!p_Symbol.IsValid() || p_Symbol.GetId() > m_Count.load(std::memory_order_acquire))
+            return std::string_view();
+
+        const uint32 l_Index = p_Symbol.GetId() - 1;
+        std::string_view const* l_Strings = m_Pages[l_Index >> SYMBOL_TABLE_PAGE_SHIFT].load(std::memory_order_acquire);
+
+        return l_Strings[l_Index & ((1u << SYMBOL_TABLE_PAGE_SHIFT) - 1)];
+    }
+
+    /// Get amount of interned strings
+    uint32 SymbolTable::GetCount() const
+    {
+        return m_Count.load(std::memory_order_relaxed);
+    }
+    /// Is table case insensitive
+    bool SymbolTable::IsCaseInsensitive() const
+    {
+        return m_CaseInsensitive;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Copy string into storage
+    /// @p_String : String to copy
+    std::string_view SymbolTable::Store(std::string_view const p_String)
+    {
+        /// Strings are null terminated so they can be handed to C APIs
+        const std::size_t l_Size = p_String.size() + 1;
+
+        if (l_Size > m_StorageLeft)
+        {
+            const std::size_t l_BlockSize = std::max<std::size_t>(SYMBOL_TABLE_STORAGE_SIZE, l_Size);
+
+            m_Storage.emplace_back(new char[l_BlockSize]);
+            m_StorageCurrent = m_Storage.back().get();
+            m_StorageLeft    = l_BlockSize;
+        }
+
+        char* l_String = m_StorageCurrent;
+        std::memcpy(l_String, p_String.data(), p_String.size());
+        l_String[p_String.size()] = '\0';
+
+        m_StorageCurrent += l_Size;
+        m_StorageLeft    -= l_Size;
+
+        return std::string_view(l_String, p_String.size());
+    }
+
+}   ///< namespace Utils
+}   ///< namespace Core
+}   ///< namespace SteerStone
@@ -0,0 +1,169 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <atomic>
+#include <memory>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+
+#include "Core/Core.hpp"
+
+#define SYMBOL_TABLE_PAGE_SHIFT     10          ///< 1024 symbols per page
+#define SYMBOL_TABLE_MAX_PAGES      1024        ///< Up to 1M symbols per table
+#define SYMBOL_TABLE_STORAGE_SIZE   16384       ///< Size of blocks strings are copied into
+
+namespace SteerStone { namespace Core { namespace Utils {
+
+    /// Interned string, comparing two symbols of the same table is an integer compare
+    class Symbol
+    {
+        public:
+            /// Constructor, invalid symbol
+            constexpr Symbol()
+                : m_Id(0)
+            {
+            }
+            /// Constructor
+            /// @p_Id : Id of symbol in its table
+            constexpr explicit Symbol(uint32 p_Id)
+                : m_Id(p_Id)
+            {
+            }
+
+            /// Get id of symbol in its table
+            constexpr uint32 GetId() const { return m_Id; }
+            /// Is symbol valid
+            constexpr bool IsValid() const { return m_Id != 0; }
+
+            /// Compare symbols
+            constexpr bool operator==(Symbol const& p_Other) const { return m_Id == p_Other.m_Id; }
+            /// Compare symbols
+            constexpr bool operator!=(Symbol const& p_Other) const { return m_Id != p_Other.m_Id; }
+            /// Order symbols by id, not alphabetically
+            constexpr bool operator<(Symbol const& p_Other) const { return m_Id < p_Other.m_Id; }
+
+        private:
+            uint32 m_Id;        ///< Id in table, 0 if invalid
+    };
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Concurrent string interner
+    /// Every string is copied once and never freed, so views of it stay valid for the lifetime of the table
+    /// Lookups take a shared lock, resolving a symbol back to its string takes none
+    class SymbolTable
+    {
+        DISALLOW_COPY_AND_ASSIGN(SymbolTable);
+
+        public:
+            /// Get case sensitive table shared by the engine, log systems and task names
+            static SymbolTable* GetDefault();
+            /// Get case insensitive table shared by the engine, user and room names
+            static SymbolTable* GetNames();
+
+        public:
+            /// Constructor
+            /// @p_CaseInsensitive : Strings differing only in ASCII case map to the same symbol, the first spelling is kept
+            explicit SymbolTable(bool p_CaseInsensitive);
+            /// Deconstructor
+            ~SymbolTable();
+
+            /// Get symbol of string, interning it if unknown
+            /// @p_String : String
+            Symbol Intern(std::string_view const p_String);
+            /// Get symbol of string without interning it, invalid if unknown
+            /// @p_String : String
+            Symbol Find(std::string_view const p_String) const;
+            /// Get string of symbol, empty if not from this table
+            /// @p_Symbol : Symbol
+            std::string_view GetString(Symbol const p_Symbol) const;
+
+            /// Get amount of interned strings
+            uint32 GetCount() const;
+            /// Is table case insensitive
+            bool IsCaseInsensitive() const;
+
+        private:
+            /// Hash of keys, folds case if table is case insensitive
+            struct KeyHash
+            {
+                bool CaseInsensitive;           ///< Fold case
+
+                /// Hash key
+                /// @p_Key : Key
+                std::size_t operator()(std::string_view const p_Key) const;
+            };
+            /// Compare keys, folds case if table is case insensitive
+            struct KeyEqual
+            {
+                bool CaseInsensitive;           ///< Fold case
+
+                /// Compare keys
+                /// @p_Left  : Left key
+                /// @p_Right : Right key
+                bool operator()(std::string_view const p_Left, std::string_view const p_Right) const;
+            };
+
+            /// Copy string into storage
+            /// @p_String : String to copy
+            std::string_view Store(std::string_view const p_String);
+
+        private:
+            bool m_CaseInsensitive;                                         ///< Strings differing only in case are the same symbol
+            mutable std::shared_mutex m_Mutex;                              ///< Guards lookup and storage
+            std::unordered_map<std::string_view, uint32, KeyHash, KeyEqual> m_Lookup;  ///< Id of strings, keys point into storage
+            std::atomic<std::string_view*> m_Pages[SYMBOL_TABLE_MAX_PAGES];  ///< String of every id, pages are never moved
+            std::atomic<uint32> m_Count;                                    ///< Interned strings
+            std::vector<std::unique_ptr<char[]>> m_Storage;                 ///< Blocks holding strings
+            char* m_StorageCurrent;                                         ///< Free space in last block
+            std::size_t m_StorageLeft;                                      ///< Bytes left in last block
+    };
+
+    /// Intern string in the default table
+    /// @p_String : String
+    inline Symbol Intern(std::string_view const p_String)
+    {
+        return SymbolTable::GetDefault()->Intern(p_String);
+    }
+    /// Get string of a symbol of the default table
+    /// @p_Symbol : Symbol
+    inline std::string_view GetSymbolString(Symbol const p_Symbol)
+    {
+        return SymbolTable::GetDefault()->GetString(p_Symbol);
+    }
+
+}   ///< namespace Utils
+}   ///< namespace Core
+}   ///< namespace SteerStone
+
+namespace std {
+
+    /// Hash of symbols, so they can key unordered containers
+    template<> struct hash<SteerStone::Core::Utils::Symbol>
+    {
+        std::size_t operator()(SteerStone::Core::Utils::Symbol const p_Symbol) const noexcept
+        {
+            return std::hash<uint32>()(p_Symbol.GetId());
+        }
+    };
+
+}   ///< namespace std
@@ -0,0 +1,278 @@
+#pragma once
+/*
+* Liam Ashdown
+* HardCPP (Merydwin)
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "Core/Core.hpp"
+
+#include <array>
+#include <charconv>
+#include <iterator>
+#include <string_view>
+#include <type_traits>
+
+namespace SteerStone { namespace Core { namespace Utils {
+
+    class TokenIterator;
+
+    /// Range over the tokens of a string split by a delimiter
+    /// Tokens are views of the source string, nothing is allocated
+    class Tokenizer
+    {
+        public:
+            /// Constructor, empty range
+            Tokenizer()
+                : m_Done(true), m_KeepEmptyElement(false)
+            {
+            }
+            /// Constructor
+            /// @p_String           : Sentence, must outlive the tokenizer
+            /// @p_Delimiter        : Split artifact
+            /// @p_KeepEmptyElement : Should keep empty element
+            Tokenizer(std::string_view const p_String, std::string_view const p_Delimiter, bool const p_KeepEmptyElement = false)
+                : m_Rest(p_String), m_Delimiter(p_Delimiter), m_Done(false), m_KeepEmptyElement(p_KeepEmptyElement)
+            {
+            }
+
+            /// Get next token
+            /// @p_Token : Token, set if there was one left
+            bool Next(std::string_view& p_Token)
+            {
+                while (!m_Done)
+                {
+                    const std::size_t l_End = m_Delimiter.empty() ? std::string_view::npos : m_Rest.find(m_Delimiter);
+
+                    if (l_End == std::string_view::npos)
+                    {
+                        p_Token = m_Rest;
+                        m_Rest  = std::string_view();
+                        m_Done  = true;
+                    }
+                    else
+                    {
+                        p_Token = m_Rest.substr(0, l_End);
+                        m_Rest.remove_prefix(l_End + m_Delimiter.size());
+                    }
+
+                    if (m_KeepEmptyElement || !p_Token.empty())
+                        return true;
+                }
+
+                return false;
+            }
+            /// Get part of the string which has not been split yet
+            std::string_view GetRest() const
+            {
+                return m_Rest;
+            }
+
+            /// Get first token
+            TokenIterator begin() const;
+            /// Get end of tokens
+            TokenIterator end() const;
+
+        private:
+            std::string_view m_Rest;                    ///< Part of the string not split yet
+            std::string_view m_Delimiter;               ///< Split artifact
+            bool m_Done;                                ///< Last token has been returned
+            bool m_KeepEmptyElement;                    ///< Should keep empty element
+    };
+
+    /// Forward iterator over the tokens of a Tokenizer
+    class TokenIterator
+    {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = std::string_view;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = std::string_view const*;
+            using reference         = std::string_view const&;
+
+        public:
+            /// Constructor, end iterator
+            TokenIterator()
+                : m_Tokenizer(), m_Done(true)
+            {
+            }
+            /// Constructor
+            /// @p_Tokenizer : Tokens left to iterate
+            explicit TokenIterator(Tokenizer const& p_Tokenizer)
+                : m_Tokenizer(p_Tokenizer), m_Done(false)
+            {
+                ++(*this);
+            }
+
+            /// Get current token
+            reference operator*() const { return m_Token; }
+            /// Get current token
+            pointer operator->() const { return &m_Token; }
+
+            /// Move to next token
+            TokenIterator& operator++()
+            {
+                m_Done = !m_Tokenizer.Next(m_Token);
+                return *this;
+            }
+            /// Move to next token
+            TokenIterator operator++(int)
+            {
+                TokenIterator l_Copy = *this;
+                ++(*this);
+                return l_Copy;
+            }
+
+            /// Compare iterators, only end iterators compare equal
+            bool operator==(TokenIterator const& p_Other) const { return m_Done && p_Other.m_Done; }
+            /// Compare iterators, only end iterators compare equal
+            bool operator!=(TokenIterator const& p_Other) const { return !(*this == p_Other); }
+
+        private:
+            Tokenizer m_Tokenizer;              ///< Tokens left
+            std::string_view m_Token;           ///< Current token
+            bool m_Done;                        ///< No tokens left
+    };
+
+    /// Get first token
+    inline TokenIterator Tokenizer::begin() const
+    {
+        return TokenIterator(*this);
+    }
+    /// Get end of tokens
+    inline TokenIterator Tokenizer::end() const
+    {
+        return TokenIterator();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Split a sentence by a delimiter, tokens are views of the sentence
+    /// @p_Str              : Sentence, must outlive the returned range
+    /// @p_Delimiter        : Split artifact
+    /// @p_KeepEmptyElement : Should keep empty element
+    inline Tokenizer Split(std::string_view const p_Str, std::string_view const p_Delimiter, bool const p_KeepEmptyElement = false)
+    {
+        return Tokenizer(p_Str, p_Delimiter, p_KeepEmptyElement);
+    }
+    /// Split the first tokens of a sentence into a fixed size array, further tokens are ignored
+    /// @p_Str              : Sentence
+    /// @p_Delimiter        : Split artifact
+    /// @p_Tokens           : Tokens, views of the sentence
+    /// @p_KeepEmptyElement : Should keep empty element
+    /// Returns amount of tokens written
+    template<std::size_t t_Count> std::size_t SplitInto(std::string_view const p_Str, std::string_view const p_Delimiter, std::array<std::string_view, t_Count>& p_Tokens, bool const p_KeepEmptyElement = false)
+    {
+        Tokenizer l_Tokenizer(p_Str, p_Delimiter, p_KeepEmptyElement);
+        std::size_t l_Count = 0;
+
+        while (l_Count < t_Count && l_Tokenizer.Next(p_Tokens[l_Count]))
+            l_Count++;
+
+        return l_Count;
+    }
+    /// Split a sentence at the first delimiter
+    /// @p_Str       : Sentence
+    /// @p_Delimiter : Split artifact
+    /// @p_Left      : Part before the delimiter
+    /// @p_Right     : Part after the delimiter
+    /// Returns false and leaves outputs untouched if the delimiter is not found
+    inline bool SplitPair(std::string_view const p_Str, std::string_view const p_Delimiter, std::string_view& p_Left, std::string_view& p_Right)
+    {
+        const std::size_t l_Position = p_Str.find(p_Delimiter);
+
+        if (l_Position == std::string_view::npos)
+            return false;
+
+        p_Left  = p_Str.substr(0, l_Position);
+        p_Right = p_Str.substr(l_Position + p_Delimiter.size());
+
+        return true;
+    }
+    /// Remove leading and trailing whitespace
+    /// @p_Str : Sentence
+    inline std::string_view Trim(std::string_view p_Str)
+    {
+        static constexpr std::string_view sl_Whitespace(" \t\r\n");
+
+        const std::size_t l_Begin = p_Str.find_first_not_of(sl_Whitespace);
+        if (l_Begin == std::string_view::npos)
+            return std::string_view();
+
+        return p_Str.substr(l_Begin, p_Str.find_last_not_of(sl_Whitespace) - l_Begin + 1);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Parse a number at the start of a string and move past it
+    /// @p_Str   : String, advanced past the number on success
+    /// @p_Value : Parsed number
+    /// @p_Base  : Base of integers
+    template<typename T> bool ConsumeNumber(std::string_view& p_Str, T& p_Value, int const p_Base = 10)
+    {
+        static_assert(std::is_arithmetic<T>::value && !std::is_same<T, bool>::value, "Only numbers can be parsed");
+
+        const char* l_Begin = p_Str.data();
+        const char* l_End   = p_Str.data() + p_Str.size();
+
+        /// from_chars rejects a leading plus sign
+        if (l_Begin != l_End && *l_Begin == '+')
+            l_Begin++;
+
+        std::from_chars_result l_Result;
+
+        if constexpr (std::is_floating_point<T>::value)
+            l_Result = std::from_chars(l_Begin, l_End, p_Value);
+        else
+            l_Result = std::from_chars(l_Begin, l_End, p_Value, p_Base);
+
+        if (l_Result.ec != std::errc())
+            return false;
+
+        p_Str.remove_prefix(static_cast<std::size_t>(l_Result.ptr - p_Str.data()));
+        return true;
+    }
+    /// Parse a string holding only a number
+    /// @p_Str   : String
+    /// @p_Value : Parsed number, untouched on failure
+    /// @p_Base  : Base of integers
+    template<typename T> bool ParseNumber(std::string_view p_Str, T& p_Value, int const p_Base = 10)
+    {
+        T l_Value;
+
+        if (!ConsumeNumber(p_Str, l_Value, p_Base) || !p_Str.empty())
+            return false;
+
+        p_Value = l_Value;
+        return true;
+    }
+    /// Parse a string holding only a number
+    /// @p_Str     : String
+    /// @p_Default : Returned if the string is not a number
+    template<typename T> T ParseNumberOr(std::string_view const p_Str, T const p_Default)
+    {
+        T l_Value = p_Default;
+        ParseNumber(p_Str, l_Value);
+        return l_Value;
+    }
+
+}   ///< namespace Utils
+}   ///< namespace Core
+}   ///< namespace SteerStone
@@ -0,0 +1,248 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <Precompiled.hpp>
+#include <cstring>
+
+#include "UtiWordFilter.hpp"
+
+namespace SteerStone { namespace Core { namespace Utils {
+
+    /// Fold ASCII character to lower case
+    /// @p_Char : Character
+    static inline uint8 FoldCase(uint8 const p_Char)
+    {
+        return (p_Char >= 'A' && p_Char <= 'Z') ? static_cast<uint8>(p_Char - 'A' + 'a') : p_Char;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor, compiles the automaton
+    /// @p_Words         : Banned words, matched anywhere regardless of case
+    /// @p_Substitutions : Pairs of characters, the first one is read as the second one ("4a@a0o" matches "b4d" and "b@d" as "bad")
+    /// @p_Separators    : Characters skipped inside a word ("b.a.d" matches "bad")
+    WordFilter::WordFilter(std::vector<std::string> const& p_Words, std::string_view const p_Substitutions, std::string_view const p_Separators)
+        : m_ClassCount(1), m_WordCount(0)
+    {
+        /// Every byte is folded and substituted before it is looked up
+        uint8 l_Fold[256];
+        bool l_Separator[256] = {};
+
+        for (uint32 l_I = 0; l_I < 256; l_I++)
+            l_Fold[l_I] = FoldCase(static_cast<uint8>(l_I));
+
+        for (std::size_t l_I = 0; l_I + 1 < p_Substitutions.size(); l_I += 2)
+        {
+            const uint8 l_From = static_cast<uint8>(p_Substitutions[l_I]);
+            const uint8 l_To   = FoldCase(static_cast<uint8>(p_Substitutions[l_I + 1]));
+
+            l_Fold[l_From] = l_To;
+            if (l_From >= 'a' && l_From <= 'z')
+                l_Fold[l_From - 'a' + 'A'] = l_To;
+        }
+
+        for (char const l_Char : p_Separators)
+            l_Separator[static_cast<uint8>(l_Char)] = true;
+
+        /// Alphabet holds only the characters words use, anything else is class 0 and leads back to the root
+        uint8 l_ClassOf[256] = {};
+        std::vector<std::string> l_Words;
+        std::vector<std::string const*> l_Sources;
+        l_Words.reserve(p_Words.size());
+        l_Sources.reserve(p_Words.size());
+
+        for (std::string const& l_Word : p_Words)
+        {
+            std::string l_Folded;
+            for (char const l_Char : l_Word)
+                if (!l_Separator[static_cast<uint8>(l_Char)])
+                    l_Folded += static_cast<char>(l_Fold[static_cast<uint8>(l_Char)]);
+
+            if (l_Folded.empty())
+                continue;
+
+            if (l_Folded.size() > WORD_FILTER_MAX_WORD_LENGTH)
+            {
+                m_Dropped.push_back(l_Word);
+                continue;
+            }
+
+            bool l_Fits = true;
+            for (char const l_Char : l_Folded)
+            {
+                uint8& l_Class = l_ClassOf[static_cast<uint8>(l_Char)];
+                if (l_Class)
+                    continue;
+
+                if (m_ClassCount == WORD_FILTER_SKIP)
+                {
+                    l_Fits = false;
+                    break;
+                }
+
+                l_Class = static_cast<uint8>(m_ClassCount++);
+            }
+
+            if (!l_Fits)
+            {
+                m_Dropped.push_back(l_Word);
+                continue;
+            }
+
+            l_Words.push_back(std::move(l_Folded));
+            l_Sources.push_back(&l_Word);
+        }
+
+        for (uint32 l_I = 0; l_I < 256; l_I++)
+            m_Classes[l_I] = l_Separator[l_I] ? WORD_FILTER_SKIP : l_ClassOf[l_Fold[l_I]];
+
+        /// Trie, state 0 is the root and a transition of 0 means no child until the automaton is completed
+        m_Transitions.assign(m_ClassCount, 0);
+        m_Match.assign(1, 0);
+
+        for (std::size_t l_I = 0; l_I < l_Words.size(); l_I++)
+        {
+            std::string const& l_Word = l_Words[l_I];
+
+            /// Transitions carry row offsets in 24 bits, a shorter word further on may still fit
+            if (m_Transitions.size() + l_Word.size() * m_ClassCount > WORD_FILTER_MAX_TRANSITIONS)
+            {
+                m_Dropped.push_back(*l_Sources[l_I]);
+                continue;
+            }
+
+            uint32 l_State = 0;
+            for (char const l_Char : l_Word)
+            {
+                const std::size_t l_Index = l_State * m_ClassCount + l_ClassOf[static_cast<uint8>(l_Char)];
+                if (!m_Transitions[l_Index])
+                {
+                    m_Transitions[l_Index] = static_cast<uint32>(m_Match.size());
+                    m_Transitions.resize(m_Transitions.size() + m_ClassCount, 0);
+                    m_Match.push_back(0);
+                }
+
+                l_State = m_Transitions[l_Index];
+            }
+
+            if (!m_Match[l_State])
+                m_WordCount++;
+
+            m_Match[l_State] = static_cast<uint8>(l_Word.size());
+        }
+
+        /// Breadth first, the fail state of a state is always shallower and completed before it.
+        /// Missing transitions take the one of the fail state, a state matches the longest word ending in it
+        std::vector<uint32> l_Fail(m_Match.size(), 0);
+        std::vector<uint32> l_Queue;
+        l_Queue.reserve(m_Match.size());
+
+        for (uint32 l_Class = 1; l_Class < m_ClassCount; l_Class++)
+            if (const uint32 l_Child = m_Transitions[l_Class])
+                l_Queue.push_back(l_Child);
+
+        for (std::size_t l_I = 0; l_I < l_Queue.size(); l_I++)
+        {
+            const uint32 l_State = l_Queue[l_I];
+            const uint32 l_Fallback = l_Fail[l_State];
+
+            if (!m_Match[l_State])
+                m_Match[l_State] = m_Match[l_Fallback];
+
+            for (uint32 l_Class = 0; l_Class < m_ClassCount; l_Class++)
+            {
+                uint32& l_Transition = m_Transitions[l_State * m_ClassCount + l_Class];
+                const uint32 l_Next = m_Transitions[l_Fallback * m_ClassCount + l_Class];
+
+                if (l_Transition)
+                {
+                    l_Fail[l_Transition] = l_Next;
+                    l_Queue.push_back(l_Transition);
+                }
+                else
+                    l_Transition = l_Next;
+            }
+        }
+
+        /// A scan reads the row offset of the next state and whether it matches from a single load
+        for (uint32& l_Transition : m_Transitions)
+            l_Transition = ((l_Transition * m_ClassCount) << 8) | m_Match[l_Transition];
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Replace every matched word with WORD_FILTER_MASK in place, separators inside a match are masked too
+    /// @p_Text   : Text
+    /// @p_Length : Length of text
+    /// Returns amount of matches
+    uint32 WordFilter::Censor(char* p_Text, std::size_t p_Length) const
+    {
+        /// Offsets of the last characters which were not skipped, a match is never longer than this
+        std::size_t l_Offsets[WORD_FILTER_MAX_WORD_LENGTH];
+        uint32 l_Read    = 0;
+        uint32 l_Row     = 0;
+        uint32 l_Matches = 0;
+
+        for (std::size_t l_I = 0; l_I < p_Length; l_I++)
+        {
+            const uint8 l_Class = m_Classes[static_cast<uint8>(p_Text[l_I])];
+            if (l_Class == WORD_FILTER_SKIP)
+                continue;
+
+            const uint32 l_Transition = m_Transitions[l_Row + l_Class];
+            l_Row = l_Transition >> 8;
+            l_Offsets[l_Read++ % WORD_FILTER_MAX_WORD_LENGTH] = l_I;
+
+            if (const uint8 l_Length = static_cast<uint8>(l_Transition))
+            {
+                const std::size_t l_Start = l_Offsets[(l_Read - l_Length) % WORD_FILTER_MAX_WORD_LENGTH];
+                std::memset(p_Text + l_Start, WORD_FILTER_MASK, l_I - l_Start + 1);
+                l_Matches++;
+            }
+        }
+
+        return l_Matches;
+    }
+    /// Check text holds a banned word
+    /// @p_Text : Text
+    bool WordFilter::Contains(std::string_view const p_Text) const
+    {
+        uint32 l_Row = 0;
+
+        for (char const l_Char : p_Text)
+        {
+            const uint8 l_Class = m_Classes[static_cast<uint8>(l_Char)];
+            if (l_Class == WORD_FILTER_SKIP)
+                continue;
+
+            const uint32 l_Transition = m_Transitions[l_Row + l_Class];
+            if (l_Transition & 0xFF)
+                return true;
+
+            l_Row = l_Transition >> 8;
+        }
+
+        return false;
+    }
+
+}   ///< namespace Utils
+}   ///< namespace Core
+}   ///< namespace SteerStone
@@ -0,0 +1,84 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Core/Core.hpp"
+
+#define WORD_FILTER_MAX_WORD_LENGTH     64          ///< Longer words are not compiled, this bounds the positions a scan remembers
+#define WORD_FILTER_MAX_TRANSITIONS     (1 << 24)   ///< Transitions of every state together, words past this are dropped
+#define WORD_FILTER_SKIP                0xFF        ///< Class of separators, they are skipped inside a word
+#define WORD_FILTER_MASK                '*'         ///< Character matched words are replaced with
+
+namespace SteerStone { namespace Core { namespace Utils {
+
+    /// Banned words compiled into a flat Aho-Corasick automaton
+    /// Bytes are folded to lower case, substituted and mapped to a small alphabet of the characters words use,
+    /// every state has a row of transitions for that alphabet so a scan is two table lookups per byte.
+    /// Immutable once built, a scan never allocates and may run on any amount of threads at once
+    class WordFilter
+    {
+        DISALLOW_COPY_AND_ASSIGN(WordFilter);
+
+        public:
+            /// Constructor, compiles the automaton
+            /// @p_Words         : Banned words, matched anywhere regardless of case
+            /// @p_Substitutions : Pairs of characters, the first one is read as the second one ("4a@a0o" matches "b4d" and "b@d" as "bad")
+            /// @p_Separators    : Characters skipped inside a word ("b.a.d" matches "bad")
+            WordFilter(std::vector<std::string> const& p_Words, std::string_view const p_Substitutions = std::string_view(), std::string_view const p_Separators = std::string_view());
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Replace every matched word with WORD_FILTER_MASK in place, separators inside a match are masked too
+            /// @p_Text   : Text
+            /// @p_Length : Length of text
+            /// Returns amount of matches
+            uint32 Censor(char* p_Text, std::size_t p_Length) const;
+            /// Replace every matched word with WORD_FILTER_MASK in place
+            /// @p_Text : Text
+            /// Returns amount of matches
+            uint32 Censor(std::string& p_Text) const { return Censor(&p_Text[0], p_Text.size()); }
+            /// Check text holds a banned word
+            /// @p_Text : Text
+            bool Contains(std::string_view const p_Text) const;
+
+            /// Get amount of compiled words
+            uint32 GetWordCount() const { return m_WordCount; }
+            /// Get amount of states
+            uint32 GetStateCount() const { return static_cast<uint32>(m_Match.size()); }
+            /// Get words which did not fit (too long, alphabet full or past WORD_FILTER_MAX_TRANSITIONS), they are not matched
+            std::vector<std::string> const& GetDroppedWords() const { return m_Dropped; }
+
+        private:
+            uint8 m_Classes[256];                   ///< Class of every byte, 0 if no word uses it, WORD_FILTER_SKIP for separators
+            uint32 m_ClassCount;                    ///< Size of alphabet, including class 0
+            std::vector<uint32> m_Transitions;      ///< By row of state + class, row of next state in the upper 24 bits and its match length in the lower 8
+            std::vector<uint8> m_Match;             ///< Length of longest word ending in state, 0 if none
+            uint32 m_WordCount;                     ///< Compiled words
+            std::vector<std::string> m_Dropped;     ///< Words which did not fit
+    };
+
+}   ///< namespace Utils
+}   ///< namespace Core
+}   ///< namespace SteerStone
@@ -19,7 +19,9 @@
 
 #include "UtilRandom.hpp"
 #include "SFMT.h"
-#include <boost/thread/tss.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <random>
 #include <assert.h>
 
@@ -43,18 +45,56 @@ namespace SteerStone { namespace Core { namespace Utils {
     //////////////////////////////////////////////////////////////////////////
     //////////////////////////////////////////////////////////////////////////
 
+    /// Threads which have created their generator, keeps seeds of threads started together apart
+    static std::atomic<uint32> s_GeneratorSequence(0);
+
+    /// Generator of calling thread, each thread owns one so no state is shared between workers
     static SFMTRand* GetRng()
     {
-        static boost::thread_specific_ptr<SFMTRand> l_SfmtRand;
-        SFMTRand* l_Random = l_SfmtRand.get();
+        thread_local std::unique_ptr<SFMTRand> tl_Random;
 
-        if (!l_Random)
+        if (!tl_Random)
         {
-            l_Random = new SFMTRand();
-            l_SfmtRand.reset(l_Random);
+            /// SFMTRand seeds with time(0), threads created in the same second would share a sequence
+            std::random_device l_Device;
+            const uint32 l_Sequence = s_GeneratorSequence.fetch_add(1, std::memory_order_relaxed);
+            const uint32 l_Clock    = static_cast<uint32>(std::chrono::steady_clock::now().time_since_epoch().count());
+
+            tl_Random.reset(new SFMTRand());
+            tl_Random->RandomInit(static_cast<int>(l_Device() ^ (l_Sequence * 0x9E3779B9u) ^ l_Clock));
         }
 
-        return l_Random;
+        return tl_Random.get();
+    }
+
+    /// Seed generator of calling thread, its sequence can then be replayed
+    /// @p_Seed : Seed
+    void SeedRandom(uint32 p_Seed)
+    {
+        GetRng()->RandomInit(static_cast<int>(p_Seed));
+    }
+    /// Fill an array with random numbers in the range 0 .. UINT32_MAX
+    /// @p_Output : Output
+    /// @p_Count  : Amount of numbers
+    void Rand32Array(uint32* p_Output, std::size_t p_Count)
+    {
+        /// State array is regenerated with SSE2 in bulk, each number is a pop from it
+        SFMTRand* l_Random = GetRng();
+
+        for (std::size_t l_I = 0; l_I < p_Count; ++l_I)
+            p_Output[l_I] = l_Random->BRandom();
+    }
+    /// Fill an array with random numbers in the range min..max (inclusive)
+    /// @p_Output : Output
+    /// @p_Count  : Amount of numbers
+    /// @p_Min    : Minimum
+    /// @p_Max    : Maximum
+    void UInt32RandomArray(uint32* p_Output, std::size_t p_Count, uint32 p_Min, uint32 p_Max)
+    {
+        SFMTRand* l_Random = GetRng();
+
+        for (std::size_t l_I = 0; l_I < p_Count; ++l_I)
+            p_Output[l_I] = p_Max <= p_Min ? p_Min : l_Random->URandom(p_Min, p_Max);
     }
 
     /// Return a random number in the range min..max.
@@ -43,6 +43,20 @@ namespace SteerStone { namespace Core { namespace Utils {
     /// Return true if a random roll fits in the specified chance (range 0-100)
     bool RollChanceInterger32(int32 p_Chance);
 
+    /// Seed generator of calling thread, its sequence can then be replayed
+    /// @p_Seed : Seed
+    void SeedRandom(uint32 p_Seed);
+    /// Fill an array with random numbers in the range 0 .. UINT32_MAX
+    /// @p_Output : Output
+    /// @p_Count  : Amount of numbers
+    void Rand32Array(uint32* p_Output, std::size_t p_Count);
+    /// Fill an array with random numbers in the range min..max (inclusive)
+    /// @p_Output : Output
+    /// @p_Count  : Amount of numbers
+    /// @p_Min    : Minimum
+    /// @p_Max    : Maximum
+    void UInt32RandomArray(uint32* p_Output, std::size_t p_Count, uint32 p_Min, uint32 p_Max);
+
     class SFMTEngine
     {
         SINGLETON_P_D(SFMTEngine);
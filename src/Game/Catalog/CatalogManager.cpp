@@ -0,0 +1,269 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "CatalogManager.hpp"
+#include "Database/DatabaseTypes.hpp"
+#include "Database/GameStatements.hpp"
+#include "Server/ServerMessage.hpp"
+
+#include <algorithm>
+
+namespace SteerStone { namespace Game { namespace Catalog {
+
+    SINGLETON_P_I(CatalogManager);
+
+    /// Replace control characters, they would end the string inside a server message
+    /// @p_String : String
+    static void Sanitize(std::string& p_String)
+    {
+        std::replace_if(p_String.begin(), p_String.end(), [](unsigned char p_Char) { return p_Char < 0x20; }, ' ');
+    }
+    /// Load every row of a statement
+    /// @p_StatementId : Statement
+    /// @p_Rows        : Rows
+    template<typename Row> static bool LoadRows(uint32 p_StatementId, std::vector<Row>& p_Rows)
+    {
+        Core::Database::PreparedStatement* l_Statement = GameDatabase.GetPrepareStatement(p_StatementId);
+        if (!l_Statement)
+            return false;
+
+        return GameDatabase.Query(l_Statement, p_Rows);
+    }
+
+    /// Constructor
+    CatalogManager::CatalogManager()
+        : m_Generation(0)
+    {
+        std::atomic_store_explicit(&m_Snapshot, std::shared_ptr<CatalogSnapshot const>(std::make_shared<CatalogSnapshot>()), std::memory_order_release);
+    }
+    /// Deconstructor
+    CatalogManager::~CatalogManager()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Load catalog, called once the game database is up
+    bool CatalogManager::Initialize()
+    {
+        return Reload();
+    }
+    /// Load catalog again, readers keep using the previous snapshot until the new one is published
+    bool CatalogManager::Reload()
+    {
+        /// Readers never take this, only concurrent reloads wait
+        std::lock_guard<std::mutex> l_Guard(m_ReloadMutex);
+
+        std::vector<CatalogPageRow> l_Pages;
+        std::vector<CatalogItemRow> l_Items;
+        std::vector<FurniDefinitionRow> l_Definitions;
+
+        if (!LoadRows(GAME_SEL_CATALOG_PAGES, l_Pages) || !LoadRows(GAME_SEL_CATALOG_ITEMS, l_Items) || !LoadRows(GAME_SEL_FURNI_DEFINITIONS, l_Definitions))
+        {
+            LOG_ERROR("Catalog", "Failed to load catalog, keeping the previous one");
+            return false;
+        }
+
+        std::shared_ptr<CatalogSnapshot> l_Snapshot = Build(l_Pages, l_Items, l_Definitions, m_Generation.load(std::memory_order_relaxed) + 1);
+
+        LOG_INFO("Catalog", "Loaded %0 catalog pages, %1 items and %2 furniture definitions", l_Snapshot->PageIds.size(), l_Snapshot->ItemIds.size(), l_Snapshot->DefinitionIds.size());
+
+        std::atomic_store_explicit(&m_Snapshot, std::shared_ptr<CatalogSnapshot const>(std::move(l_Snapshot)), std::memory_order_release);
+        m_Generation.fetch_add(1, std::memory_order_acq_rel);
+
+        return true;
+    }
+
+    /// Get current catalog, it never changes once published
+    std::shared_ptr<CatalogSnapshot const> CatalogManager::GetSnapshot() const
+    {
+        return std::atomic_load_explicit(&m_Snapshot, std::memory_order_acquire);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Build snapshot from catalog rows
+    /// @p_Pages       : Pages
+    /// @p_Items       : Items
+    /// @p_Definitions : Furniture definitions
+    /// @p_Generation  : Reload building the snapshot
+    std::shared_ptr<CatalogSnapshot> CatalogManager::Build(std::vector<CatalogPageRow>& p_Pages, std::vector<CatalogItemRow>& p_Items, std::vector<FurniDefinitionRow>& p_Definitions, uint32 p_Generation)
+    {
+        std::shared_ptr<CatalogSnapshot> l_Snapshot = std::make_shared<CatalogSnapshot>();
+        CatalogSnapshot& l_Catalog = *l_Snapshot;
+        l_Catalog.Generation = p_Generation;
+
+        /// Definitions
+        l_Catalog.DefinitionIds.reserve(p_Definitions.size());
+        for (FurniDefinitionRow& l_Row : p_Definitions)
+        {
+            if (!l_Catalog.DefinitionIndex.emplace(l_Row.Id, static_cast<uint32>(l_Catalog.DefinitionIds.size())).second)
+                continue;
+
+            Sanitize(l_Row.Sprite);
+            Sanitize(l_Row.Name);
+            Sanitize(l_Row.Description);
+            Sanitize(l_Row.Colour);
+
+            l_Catalog.DefinitionIds.push_back(l_Row.Id);
+            l_Catalog.DefinitionSprites.push_back(std::move(l_Row.Sprite));
+            l_Catalog.DefinitionNames.push_back(std::move(l_Row.Name));
+            l_Catalog.DefinitionDescriptions.push_back(std::move(l_Row.Description));
+            l_Catalog.DefinitionColours.push_back(std::move(l_Row.Colour));
+            l_Catalog.DefinitionWidths.push_back(static_cast<uint8>(std::min<uint32>(l_Row.Width, 0xFF)));
+            l_Catalog.DefinitionLengths.push_back(static_cast<uint8>(std::min<uint32>(l_Row.Length, 0xFF)));
+        }
+
+        /// Pages, in the order they were queried
+        l_Catalog.PageIds.reserve(p_Pages.size());
+        for (CatalogPageRow& l_Row : p_Pages)
+        {
+            if (!l_Catalog.PageIndex.emplace(l_Row.Id, static_cast<uint32>(l_Catalog.PageIds.size())).second)
+                continue;
+
+            Sanitize(l_Row.Name);
+            Sanitize(l_Row.Layout);
+
+            l_Catalog.PageIds.push_back(l_Row.Id);
+            l_Catalog.PageParentIds.push_back(l_Row.ParentId);
+            l_Catalog.PageMinRanks.push_back(l_Row.MinRank);
+            l_Catalog.PageNames.push_back(std::move(l_Row.Name));
+            l_Catalog.PageLayouts.push_back(std::move(l_Row.Layout));
+        }
+
+        /// Items, grouped by page in the order they were queried
+        const std::size_t l_PageCount = l_Catalog.PageIds.size();
+        std::vector<uint32> l_ItemPage(p_Items.size(), ~uint32(0));
+        std::vector<uint32> l_ItemDefinition(p_Items.size(), 0);
+        std::vector<uint32> l_Offsets(l_PageCount + 1, 0);
+
+        for (std::size_t l_I = 0; l_I < p_Items.size(); l_I++)
+        {
+            auto l_Page       = l_Catalog.PageIndex.find(p_Items[l_I].PageId);
+            auto l_Definition = l_Catalog.DefinitionIndex.find(p_Items[l_I].DefinitionId);
+
+            if (l_Page == l_Catalog.PageIndex.end() || l_Definition == l_Catalog.DefinitionIndex.end())
+            {
+                LOG_WARNING("Catalog", "Catalog item %0 is on an unknown page or sells an unknown definition, skipping", p_Items[l_I].Id);
+                continue;
+            }
+
+            l_ItemPage[l_I]       = l_Page->second;
+            l_ItemDefinition[l_I] = l_Definition->second;
+            l_Offsets[l_Page->second + 1]++;
+        }
+
+        for (std::size_t l_I = 0; l_I < l_PageCount; l_I++)
+            l_Offsets[l_I + 1] += l_Offsets[l_I];
+
+        const uint32 l_ItemCount = l_Offsets[l_PageCount];
+        l_Catalog.ItemIds.resize(l_ItemCount);
+        l_Catalog.ItemPages.resize(l_ItemCount);
+        l_Catalog.ItemDefinitions.resize(l_ItemCount);
+        l_Catalog.ItemCosts.resize(l_ItemCount);
+        l_Catalog.ItemAmounts.resize(l_ItemCount);
+
+        l_Catalog.PageItemBegin.assign(l_Offsets.begin(), l_Offsets.end() - 1);
+        l_Catalog.PageItemEnd.assign(l_Offsets.begin() + 1, l_Offsets.end());
+
+        std::vector<uint32>& l_Next = l_Offsets;
+        for (std::size_t l_I = 0; l_I < p_Items.size(); l_I++)
+        {
+            if (l_ItemPage[l_I] == ~uint32(0))
+                continue;
+
+            const uint32 l_Index = l_Next[l_ItemPage[l_I]]++;
+            l_Catalog.ItemIds[l_Index]         = p_Items[l_I].Id;
+            l_Catalog.ItemPages[l_Index]       = l_ItemPage[l_I];
+            l_Catalog.ItemDefinitions[l_Index] = l_ItemDefinition[l_I];
+            l_Catalog.ItemCosts[l_Index]       = p_Items[l_I].Cost;
+            l_Catalog.ItemAmounts[l_Index]     = p_Items[l_I].Amount;
+            l_Catalog.ItemIndex.emplace(p_Items[l_I].Id, l_Index);
+        }
+
+        /// Payloads, every open of the catalog gets one of these as is
+        l_Catalog.PagePayloads.reserve(l_PageCount);
+        for (uint32 l_I = 0; l_I < l_PageCount; l_I++)
+            l_Catalog.PagePayloads.push_back(SerializePage(l_Catalog, l_I));
+
+        for (uint32 l_Rank = 0; l_Rank <= CATALOG_MAX_RANK; l_Rank++)
+            l_Catalog.IndexPayloads[l_Rank] = SerializeIndex(l_Catalog, l_Rank);
+
+        return l_Snapshot;
+    }
+    /// Serialize page
+    /// @p_Snapshot : Snapshot
+    /// @p_Page     : Index of page
+    Core::Network::SharedPacket CatalogManager::SerializePage(CatalogSnapshot const& p_Snapshot, uint32 p_Page)
+    {
+        const uint32 l_Begin = p_Snapshot.PageItemBegin[p_Page];
+        const uint32 l_End   = p_Snapshot.PageItemEnd[p_Page];
+
+        Server::ServerMessage l_Message(Server::SERVER_CATALOG_PAGE);
+        l_Message.AppendInt(static_cast<int32>(p_Snapshot.PageIds[p_Page]));
+        l_Message.AppendString(p_Snapshot.PageNames[p_Page]);
+        l_Message.AppendString(p_Snapshot.PageLayouts[p_Page]);
+        l_Message.AppendInt(static_cast<int32>(l_End - l_Begin));
+
+        for (uint32 l_I = l_Begin; l_I < l_End; l_I++)
+        {
+            const uint32 l_Definition = p_Snapshot.ItemDefinitions[l_I];
+
+            l_Message.AppendInt(static_cast<int32>(p_Snapshot.ItemIds[l_I]));
+            l_Message.AppendInt(static_cast<int32>(p_Snapshot.ItemCosts[l_I]));
+            l_Message.AppendInt(static_cast<int32>(p_Snapshot.ItemAmounts[l_I]));
+            l_Message.AppendString(p_Snapshot.DefinitionSprites[l_Definition]);
+            l_Message.AppendString(p_Snapshot.DefinitionNames[l_Definition]);
+            l_Message.AppendString(p_Snapshot.DefinitionDescriptions[l_Definition]);
+            l_Message.AppendInt(p_Snapshot.DefinitionWidths[l_Definition]);
+            l_Message.AppendInt(p_Snapshot.DefinitionLengths[l_Definition]);
+            l_Message.AppendString(p_Snapshot.DefinitionColours[l_Definition]);
+        }
+
+        return l_Message.Finalize();
+    }
+    /// Serialize index of pages a rank sees
+    /// @p_Snapshot : Snapshot
+    /// @p_Rank     : Rank
+    Core::Network::SharedPacket CatalogManager::SerializeIndex(CatalogSnapshot const& p_Snapshot, uint32 p_Rank)
+    {
+        const std::size_t l_PageCount = p_Snapshot.PageIds.size();
+        const uint32 l_Visible = static_cast<uint32>(std::count_if(p_Snapshot.PageMinRanks.begin(), p_Snapshot.PageMinRanks.end(), [p_Rank](uint32 p_MinRank) { return p_MinRank <= p_Rank; }));
+
+        Server::ServerMessage l_Message(Server::SERVER_CATALOG_INDEX);
+        l_Message.AppendInt(static_cast<int32>(l_Visible));
+
+        for (std::size_t l_I = 0; l_I < l_PageCount; l_I++)
+        {
+            if (p_Snapshot.PageMinRanks[l_I] > p_Rank)
+                continue;
+
+            l_Message.AppendInt(static_cast<int32>(p_Snapshot.PageIds[l_I]));
+            l_Message.AppendInt(static_cast<int32>(p_Snapshot.PageParentIds[l_I]));
+            l_Message.AppendString(p_Snapshot.PageNames[l_I]);
+        }
+
+        return l_Message.Finalize();
+    }
+
+}   ///< namespace Catalog
+}   ///< namespace Game
+}   ///< namespace Steerstone
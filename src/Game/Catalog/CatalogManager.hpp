@@ -0,0 +1,190 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+#include "Singleton/Singleton.hpp"
+#include "Database/RowMapper.hpp"
+#include "Network/SharedPacket.hpp"
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define CATALOG_MAX_RANK        7       ///< Highest rank with its own catalog index, higher ranks see its index
+
+namespace SteerStone { namespace Game { namespace Catalog {
+
+    /// Row of GAME_SEL_CATALOG_PAGES
+    struct CatalogPageRow
+    {
+        uint32 Id;                  ///< Id of page
+        uint32 ParentId;            ///< Id of parent page, 0 for a root page
+        std::string Name;           ///< Caption
+        std::string Layout;         ///< Layout the client renders the page with
+        uint32 MinRank;             ///< Lowest rank seeing the page
+
+        DATABASE_ROW_FIELDS(&CatalogPageRow::Id, &CatalogPageRow::ParentId, &CatalogPageRow::Name, &CatalogPageRow::Layout, &CatalogPageRow::MinRank)
+    };
+
+    /// Row of GAME_SEL_CATALOG_ITEMS
+    struct CatalogItemRow
+    {
+        uint32 Id;                  ///< Id of item
+        uint32 PageId;              ///< Page item is sold on
+        uint32 DefinitionId;        ///< Furniture sold
+        uint32 Cost;                ///< Price in credits
+        uint32 Amount;              ///< Furniture given per purchase
+
+        DATABASE_ROW_FIELDS(&CatalogItemRow::Id, &CatalogItemRow::PageId, &CatalogItemRow::DefinitionId, &CatalogItemRow::Cost, &CatalogItemRow::Amount)
+    };
+
+    /// Row of GAME_SEL_FURNI_DEFINITIONS
+    struct FurniDefinitionRow
+    {
+        uint32 Id;                  ///< Id of definition
+        std::string Sprite;         ///< Sprite
+        std::string Name;           ///< Name
+        std::string Description;    ///< Description
+        uint32 Width;               ///< Tiles along X
+        uint32 Length;              ///< Tiles along Y
+        std::string Colour;         ///< Colour of sprite
+
+        DATABASE_ROW_FIELDS(&FurniDefinitionRow::Id, &FurniDefinitionRow::Sprite, &FurniDefinitionRow::Name, &FurniDefinitionRow::Description,
+            &FurniDefinitionRow::Width, &FurniDefinitionRow::Length, &FurniDefinitionRow::Colour)
+    };
+
+    /// Immutable catalog, one load of the database
+    /// Columns are stored as parallel arrays indexed by page, item or definition. Items of a page are contiguous,
+    /// every page and every rank's index is serialized once while loading, opening the catalog copies a packet
+    struct CatalogSnapshot
+    {
+        /// Pages
+        std::vector<uint32> PageIds;                                    ///< Id of page
+        std::vector<uint32> PageParentIds;                              ///< Id of parent page
+        std::vector<uint32> PageMinRanks;                               ///< Lowest rank seeing the page
+        std::vector<std::string> PageNames;                             ///< Caption
+        std::vector<std::string> PageLayouts;                           ///< Layout
+        std::vector<uint32> PageItemBegin;                              ///< First item of page
+        std::vector<uint32> PageItemEnd;                                ///< End of items of page
+        std::vector<Core::Network::SharedPacket> PagePayloads;          ///< Serialized page
+        std::unordered_map<uint32, uint32> PageIndex;                   ///< Page by id
+
+        /// Items, grouped by page
+        std::vector<uint32> ItemIds;                                    ///< Id of item
+        std::vector<uint32> ItemPages;                                  ///< Page of item
+        std::vector<uint32> ItemDefinitions;                            ///< Definition of item
+        std::vector<uint32> ItemCosts;                                  ///< Price in credits
+        std::vector<uint32> ItemAmounts;                                ///< Furniture given per purchase
+        std::unordered_map<uint32, uint32> ItemIndex;                   ///< Item by id
+
+        /// Furniture definitions
+        std::vector<uint32> DefinitionIds;                              ///< Id of definition
+        std::vector<std::string> DefinitionSprites;                     ///< Sprite
+        std::vector<std::string> DefinitionNames;                       ///< Name
+        std::vector<std::string> DefinitionDescriptions;                ///< Description
+        std::vector<std::string> DefinitionColours;                     ///< Colour
+        std::vector<uint8> DefinitionWidths;                            ///< Tiles along X
+        std::vector<uint8> DefinitionLengths;                           ///< Tiles along Y
+        std::unordered_map<uint32, uint32> DefinitionIndex;             ///< Definition by id
+
+        /// Serialized index of pages each rank sees
+        std::array<Core::Network::SharedPacket, CATALOG_MAX_RANK + 1> IndexPayloads;
+        uint32 Generation;                                              ///< Reload which built the snapshot
+
+        /// Get serialized page, nullptr if it does not exist or rank does not see it
+        /// @p_PageId : Id of page
+        /// @p_Rank   : Rank of user
+        Core::Network::SharedPacket const* GetPagePayload(uint32 p_PageId, uint32 p_Rank) const
+        {
+            auto l_Itr = PageIndex.find(p_PageId);
+            if (l_Itr == PageIndex.end() || PageMinRanks[l_Itr->second] > p_Rank)
+                return nullptr;
+
+            return &PagePayloads[l_Itr->second];
+        }
+        /// Get serialized index of pages a rank sees
+        /// @p_Rank : Rank of user
+        Core::Network::SharedPacket const& GetIndexPayload(uint32 p_Rank) const
+        {
+            return IndexPayloads[p_Rank < CATALOG_MAX_RANK ? p_Rank : CATALOG_MAX_RANK];
+        }
+        /// Find item
+        /// @p_ItemId : Id of item
+        /// @p_Index  : Index of item
+        /// Returns false if item is not sold
+        bool FindItem(uint32 p_ItemId, uint32& p_Index) const
+        {
+            auto l_Itr = ItemIndex.find(p_ItemId);
+            if (l_Itr == ItemIndex.end())
+                return false;
+
+            p_Index = l_Itr->second;
+            return true;
+        }
+    };
+
+    /// Loads the catalog and publishes it as an immutable snapshot
+    /// Readers hold the snapshot they got, a reload builds a new one off to the side and swaps it in atomically
+    class CatalogManager
+    {
+        SINGLETON_P_D(CatalogManager);
+
+        public:
+            /// Load catalog, called once the game database is up
+            bool Initialize();
+            /// Load catalog again, readers keep using the previous snapshot until the new one is published
+            bool Reload();
+
+            /// Get current catalog, it never changes once published
+            std::shared_ptr<CatalogSnapshot const> GetSnapshot() const;
+
+        private:
+            /// Build snapshot from catalog rows
+            /// @p_Pages       : Pages
+            /// @p_Items       : Items
+            /// @p_Definitions : Furniture definitions
+            /// @p_Generation  : Reload building the snapshot
+            static std::shared_ptr<CatalogSnapshot> Build(std::vector<CatalogPageRow>& p_Pages, std::vector<CatalogItemRow>& p_Items, std::vector<FurniDefinitionRow>& p_Definitions, uint32 p_Generation);
+            /// Serialize page
+            /// @p_Snapshot : Snapshot
+            /// @p_Page     : Index of page
+            static Core::Network::SharedPacket SerializePage(CatalogSnapshot const& p_Snapshot, uint32 p_Page);
+            /// Serialize index of pages a rank sees
+            /// @p_Snapshot : Snapshot
+            /// @p_Rank     : Rank
+            static Core::Network::SharedPacket SerializeIndex(CatalogSnapshot const& p_Snapshot, uint32 p_Rank);
+
+        private:
+            std::shared_ptr<CatalogSnapshot const> m_Snapshot;      ///< Published catalog, accessed atomically
+            std::atomic<uint32> m_Generation;                       ///< Generation of published catalog
+            std::mutex m_ReloadMutex;                               ///< One reload at a time
+    };
+
+}   ///< namespace Catalog
+}   ///< namespace Game
+}   ///< namespace Steerstone
+
+#define sCatalogManager SteerStone::Game::Catalog::CatalogManager::GetSingleton()
@@ -0,0 +1,87 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "WordFilterManager.hpp"
+#include "Config/Config.hpp"
+#include "Database/DatabaseTypes.hpp"
+#include "Database/GameStatements.hpp"
+
+namespace SteerStone { namespace Game { namespace Chat {
+
+    SINGLETON_P_I(WordFilterManager);
+
+    /// Constructor
+    WordFilterManager::WordFilterManager()
+    {
+        std::atomic_store_explicit(&m_Filter, std::shared_ptr<Core::Utils::WordFilter const>(std::make_shared<Core::Utils::WordFilter>(std::vector<std::string>())), std::memory_order_release);
+    }
+    /// Deconstructor
+    WordFilterManager::~WordFilterManager()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Load banned words, called once the game database is up
+    bool WordFilterManager::Initialize()
+    {
+        return Reload();
+    }
+    /// Load banned words again and publish a new filter
+    bool WordFilterManager::Reload()
+    {
+        /// Readers never take this, only concurrent reloads wait
+        std::lock_guard<std::mutex> l_Guard(m_ReloadMutex);
+
+        std::vector<WordFilterRow> l_Rows;
+
+        Core::Database::PreparedStatement* l_Statement = GameDatabase.GetPrepareStatement(GAME_SEL_WORD_FILTER);
+        if (!l_Statement || !GameDatabase.Query(l_Statement, l_Rows))
+        {
+            LOG_ERROR("WordFilter", "Failed to load banned words, keeping the previous filter");
+            return false;
+        }
+
+        std::vector<std::string> l_Words;
+        l_Words.reserve(l_Rows.size());
+        for (WordFilterRow& l_Row : l_Rows)
+            l_Words.push_back(std::move(l_Row.Word));
+
+        std::shared_ptr<Core::Utils::WordFilter const> l_Filter = std::make_shared<Core::Utils::WordFilter>(l_Words,
+            sConfigManager->GetString("WordFilterSubstitutions", WORD_FILTER_SUBSTITUTIONS), sConfigManager->GetString("WordFilterSeparators", WORD_FILTER_SEPARATORS));
+
+        LOG_INFO("WordFilter", "Compiled %0 of %1 banned words into %2 states", l_Filter->GetWordCount(), l_Words.size(), l_Filter->GetStateCount());
+
+        for (std::string const& l_Word : l_Filter->GetDroppedWords())
+            LOG_WARNING("WordFilter", "Banned word \"%0\" does not fit into the filter and is not enforced", l_Word);
+
+        std::atomic_store_explicit(&m_Filter, std::move(l_Filter), std::memory_order_release);
+        return true;
+    }
+
+    /// Get current filter, it never changes once published
+    std::shared_ptr<Core::Utils::WordFilter const> WordFilterManager::GetFilter() const
+    {
+        return std::atomic_load_explicit(&m_Filter, std::memory_order_acquire);
+    }
+
+}   ///< namespace Chat
+}   ///< namespace Game
+}   ///< namespace Steerstone
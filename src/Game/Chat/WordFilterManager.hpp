@@ -0,0 +1,75 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+#include "Singleton/Singleton.hpp"
+#include "Database/RowMapper.hpp"
+#include "Utility/UtiWordFilter.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#define WORD_FILTER_SUBSTITUTIONS   "4a@a3e1i!i0o$s5s7t"    ///< Default characters read as letters, in pairs
+#define WORD_FILTER_SEPARATORS      ".-_"                   ///< Default characters skipped inside a word
+
+namespace SteerStone { namespace Game { namespace Chat {
+
+    /// Row of GAME_SEL_WORD_FILTER
+    struct WordFilterRow
+    {
+        std::string Word;           ///< Banned word
+
+        DATABASE_ROW_FIELDS(&WordFilterRow::Word)
+    };
+
+    /// Compiles the banned words and publishes the automaton
+    /// Chat, mottos and room names are censored with the published filter, a reload compiles a new one
+    /// off to the side and swaps it in atomically, scans running meanwhile finish on the previous one
+    class WordFilterManager
+    {
+        SINGLETON_P_D(WordFilterManager);
+
+        public:
+            /// Load banned words, called once the game database is up
+            bool Initialize();
+            /// Load banned words again and publish a new filter
+            bool Reload();
+
+            /// Get current filter, it never changes once published
+            std::shared_ptr<Core::Utils::WordFilter const> GetFilter() const;
+            /// Replace banned words of text with WORD_FILTER_MASK in place
+            /// @p_Text : Text
+            /// Returns amount of matches
+            uint32 Censor(std::string& p_Text) const { return GetFilter()->Censor(p_Text); }
+
+        private:
+            std::shared_ptr<Core::Utils::WordFilter const> m_Filter;    ///< Published filter, accessed atomically
+            std::mutex m_ReloadMutex;                                   ///< One reload at a time
+    };
+
+}   ///< namespace Chat
+}   ///< namespace Game
+}   ///< namespace Steerstone
+
+#define sWordFilter SteerStone::Game::Chat::WordFilterManager::GetSingleton()
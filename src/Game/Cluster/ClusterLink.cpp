@@ -0,0 +1,542 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "ClusterLink.hpp"
+#include "ClusterManager.hpp"
+#include "Config/Config.hpp"
+#include "Server/Socket.hpp"
+
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+
+namespace SteerStone { namespace Game { namespace Cluster {
+
+    /// Constructor
+    /// @p_Service      : Boost Service
+    /// @p_Owner        : Owner told once we are closed
+    ClusterLink::ClusterLink(boost::asio::io_service& p_Service, Core::Network::SocketOwner* p_Owner)
+        : Socket(p_Service, p_Owner)
+    {
+        /// Frames of every session on this link are coalesced, a flush sends the whole batch with one syscall
+        static const Core::Network::FlushPolicySettings sl_FlushPolicy =
+        {
+            Core::Network::FlushPolicy::ByteThreshold,
+            static_cast<std::size_t>(sConfigManager->GetInt("ClusterFlushBytes", CLUSTER_FLUSH_BYTES)),
+            std::max<int32>(sConfigManager->GetInt("ClusterFlushTimeout", CLUSTER_FLUSH_TIMEOUT), 1)
+        };
+        SetFlushPolicy(sl_FlushPolicy);
+    }
+
+    /// Queue frame, safe from any thread
+    /// @p_Opcode  : Opcode
+    /// @p_Session : Session frame belongs to, 0 for the link itself
+    /// @p_Payload : Payload, at most CLUSTER_FRAME_MAX_PAYLOAD bytes
+    /// @p_Length  : Length of payload
+    bool ClusterLink::SendFrame(ClusterOpcode p_Opcode, uint32 p_Session, uint8 const* p_Payload, std::size_t p_Length)
+    {
+        assert(p_Length <= CLUSTER_FRAME_MAX_PAYLOAD);
+
+        /// A frame is queued with a single write so frames of different threads never interleave
+        static thread_local std::vector<uint8> sl_Frame;
+        sl_Frame.clear();
+
+        Protocol::AppendFrameHeader(sl_Frame, p_Opcode, p_Session, p_Length);
+        sl_Frame.insert(sl_Frame.end(), p_Payload, p_Payload + p_Length);
+
+        return Write(reinterpret_cast<char const*>(sl_Frame.data()), sl_Frame.size());
+    }
+
+    /// Decode every complete frame of our in buffer
+    Core::Network::ProcessState ClusterLink::ProcessIncomingData()
+    {
+        for (;;)
+        {
+            ClusterFrame l_Frame;
+            std::size_t l_FrameLength = 0;
+
+            switch (Protocol::DecodeFrame(InView(), l_Frame, l_FrameLength))
+            {
+                case Server::FrameState::Incomplete:
+                    return Core::Network::ProcessState::Successful;
+                case Server::FrameState::Malformed:
+                {
+                    LOG_WARNING("Cluster", "Recieved malformed frame from %0, closing link", GetRemoteEndpoint());
+                    return Core::Network::ProcessState::Error;
+                }
+                case Server::FrameState::Complete:
+                    break;
+            }
+
+            if (!OnFrame(l_Frame))
+                return Core::Network::ProcessState::Error;
+
+            ReadSkip(l_FrameLength);
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    /// @p_Service      : Boost Service
+    /// @p_Owner        : Owner told once we are closed
+    GameNodeLink::GameNodeLink(boost::asio::io_service& p_Service, Core::Network::SocketOwner* p_Owner)
+        : ClusterLink(p_Service, p_Owner), m_NodeId(0), m_Ready(false), m_NextSession(1)
+    {
+    }
+
+    /// Connect to game node and say hello once connected
+    /// @p_NodeId   : Id of node
+    /// @p_EndPoint : Cluster end point of node
+    /// Returns false if connecting could not be started, we must be removed from our network thread
+    bool GameNodeLink::Connect(uint32 p_NodeId, boost::asio::ip::tcp::endpoint const& p_EndPoint)
+    {
+        m_NodeId = p_NodeId;
+
+        /// Opened up front so a failed attempt can be closed, which removes us from our network thread
+        boost::system::error_code l_ErrorCode;
+        GetAsioSocket().open(p_EndPoint.protocol(), l_ErrorCode);
+        if (l_ErrorCode)
+        {
+            LOG_ERROR("Cluster", "Failed to open link to game node %0: %1", p_NodeId, l_ErrorCode.message());
+            return false;
+        }
+
+        GetAsioSocket().async_connect(p_EndPoint, [l_Link = Shared<GameNodeLink>(), p_EndPoint](boost::system::error_code const& p_ErrorCode)
+        {
+            if (p_ErrorCode)
+            {
+                LOG_VERBOSE("Cluster", "Failed to reach game node %0 at %1:%2: %3", l_Link->m_NodeId, p_EndPoint.address().to_string(), p_EndPoint.port(), p_ErrorCode.message());
+                l_Link->CloseSocket();
+                return;
+            }
+
+            boost::system::error_code l_OptionError;
+            l_Link->GetAsioSocket().set_option(boost::asio::ip::tcp::no_delay(true), l_OptionError);
+
+            if (!l_Link->Open())
+            {
+                l_Link->CloseSocket();
+                return;
+            }
+
+            std::vector<uint8> l_Hello;
+            Protocol::AppendUInt32(l_Hello, CLUSTER_PROTOCOL_VERSION);
+            l_Link->SendFrame(CLUSTER_HELLO, 0, l_Hello.data(), l_Hello.size());
+
+            l_Link->m_Ready.store(true, std::memory_order_release);
+
+            LOG_INFO("Cluster", "Connected to game node %0 at %1", l_Link->m_NodeId, l_Link->GetRemoteEndpoint());
+            sCluster->OnNodeUp(l_Link->m_NodeId);
+        });
+
+        return true;
+    }
+
+    /// Open session for client socket, safe from any thread
+    /// @p_Socket : Client socket
+    /// @p_UserId : Id of user, 0 if not logged in
+    /// Returns id of session
+    uint32 GameNodeLink::OpenSession(std::shared_ptr<Server::GameSocket> const& p_Socket, uint32 p_UserId)
+    {
+        const uint32 l_Session = m_NextSession.fetch_add(1, std::memory_order_relaxed);
+
+        {
+            std::unique_lock<std::shared_mutex> l_Lock(m_Mutex);
+            m_Sessions[l_Session] = p_Socket;
+        }
+
+        std::vector<uint8> l_Payload;
+        Protocol::AppendUInt32(l_Payload, p_UserId);
+        SendFrame(CLUSTER_SESSION_OPEN, l_Session, l_Payload.data(), l_Payload.size());
+
+        return l_Session;
+    }
+    /// Close session, safe from any thread
+    /// @p_Session : Id of session
+    void GameNodeLink::CloseSession(uint32 p_Session)
+    {
+        {
+            std::unique_lock<std::shared_mutex> l_Lock(m_Mutex);
+            if (!m_Sessions.erase(p_Session))
+                return;
+        }
+
+        if (!IsClosed())
+            SendFrame(CLUSTER_SESSION_CLOSE, p_Session);
+    }
+    /// Forward client message to the session on the node, safe from any thread
+    /// @p_Session : Id of session
+    /// @p_Header  : Header id of message
+    /// @p_Body    : Body of message
+    void GameNodeLink::Forward(uint32 p_Session, uint16 p_Header, Core::Network::PacketView const& p_Body)
+    {
+        /// The node decodes the message exactly as the client framed it
+        const std::size_t l_Length = B64_LENGTH_SIZE + B64_HEADER_SIZE + p_Body.GetLength();
+        if (l_Length > CLUSTER_FRAME_MAX_PAYLOAD)
+        {
+            LOG_WARNING("Cluster", "Message %0 of %1 bytes does not fit in a frame, dropping it", p_Header, p_Body.GetLength());
+            return;
+        }
+
+        static thread_local std::vector<uint8> sl_Frame;
+        sl_Frame.clear();
+
+        Protocol::AppendFrameHeader(sl_Frame, CLUSTER_CLIENT_DATA, p_Session, l_Length);
+
+        const std::size_t l_Offset = sl_Frame.size();
+        sl_Frame.resize(l_Offset + B64_LENGTH_SIZE + B64_HEADER_SIZE);
+        Server::Encoding::EncodeB64(static_cast<uint32>(B64_HEADER_SIZE + p_Body.GetLength()), &sl_Frame[l_Offset], B64_LENGTH_SIZE);
+        Server::Encoding::EncodeB64(p_Header, &sl_Frame[l_Offset + B64_LENGTH_SIZE], B64_HEADER_SIZE);
+        sl_Frame.insert(sl_Frame.end(), p_Body.GetData(), p_Body.GetData() + p_Body.GetLength());
+
+        Write(reinterpret_cast<char const*>(sl_Frame.data()), sl_Frame.size());
+    }
+    /// Make every client socket with a session on us check its room still belongs to us, safe from any thread
+    void GameNodeLink::RefreshSessions()
+    {
+        std::vector<std::shared_ptr<Server::GameSocket>> l_Sockets;
+
+        {
+            std::shared_lock<std::shared_mutex> l_Lock(m_Mutex);
+            l_Sockets.reserve(m_Sessions.size());
+
+            for (auto const& l_Pair : m_Sessions)
+            {
+                if (std::shared_ptr<Server::GameSocket> l_Socket = l_Pair.second.lock())
+                    l_Sockets.push_back(std::move(l_Socket));
+            }
+        }
+
+        for (std::shared_ptr<Server::GameSocket>& l_Socket : l_Sockets)
+        {
+            Server::GameSocket* l_Raw = l_Socket.get();
+            boost::asio::post(l_Raw->GetAsioSocket().get_executor(), [l_Socket = std::move(l_Socket)]() { l_Socket->RefreshRemoteRoom(); });
+        }
+    }
+
+    /// Handle frame of node
+    /// @p_Frame : Frame
+    bool GameNodeLink::OnFrame(ClusterFrame const& p_Frame)
+    {
+        switch (p_Frame.Opcode)
+        {
+            case CLUSTER_SERVER_DATA:
+            {
+                std::shared_ptr<Server::GameSocket> l_Socket;
+
+                {
+                    std::shared_lock<std::shared_mutex> l_Lock(m_Mutex);
+
+                    auto l_Itr = m_Sessions.find(p_Frame.Session);
+                    if (l_Itr != m_Sessions.end())
+                        l_Socket = l_Itr->second.lock();
+                }
+
+                /// Server messages are written to the client as the node serialized them
+                if (l_Socket)
+                    l_Socket->Write(reinterpret_cast<char const*>(p_Frame.Payload.GetData()), p_Frame.Payload.GetLength());
+
+                return true;
+            }
+            case CLUSTER_SESSION_CLOSE:
+            {
+                std::shared_ptr<Server::GameSocket> l_Socket;
+
+                {
+                    std::unique_lock<std::shared_mutex> l_Lock(m_Mutex);
+
+                    auto l_Itr = m_Sessions.find(p_Frame.Session);
+                    if (l_Itr == m_Sessions.end())
+                        return true;
+
+                    l_Socket = l_Itr->second.lock();
+                    m_Sessions.erase(l_Itr);
+                }
+
+                if (l_Socket)
+                {
+                    Server::GameSocket* l_Raw = l_Socket.get();
+                    boost::asio::post(l_Raw->GetAsioSocket().get_executor(), [l_Socket = std::move(l_Socket), l_Session = p_Frame.Session]()
+                    {
+                        l_Socket->OnRemoteSessionClosed(l_Session);
+                    });
+                }
+
+                return true;
+            }
+            case CLUSTER_ROOM_MOVED:
+            {
+                if (p_Frame.Payload.GetLength() != 8)
+                    return false;
+
+                sCluster->OnRoomMoved(Protocol::ReadUInt32(p_Frame.Payload.GetData()), Protocol::ReadUInt32(p_Frame.Payload.GetData() + 4));
+                return true;
+            }
+            default:
+                LOG_WARNING("Cluster", "Unexpected frame %0 from game node %1, ignoring", static_cast<uint32>(p_Frame.Opcode), m_NodeId);
+                return true;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    /// @p_Service      : Boost Service
+    /// @p_Owner        : Owner told once we are closed
+    GatewayLink::GatewayLink(boost::asio::io_service& p_Service, Core::Network::SocketOwner* p_Owner)
+        : ClusterLink(p_Service, p_Owner), m_Hello(false)
+    {
+    }
+    /// Deconstructor, closes the pipe of every session
+    GatewayLink::~GatewayLink()
+    {
+        std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+        for (auto const& l_Pair : m_Sessions)
+        {
+            if (std::shared_ptr<SessionPipe> l_Pipe = l_Pair.second.lock())
+            {
+                SessionPipe* l_Raw = l_Pipe.get();
+                boost::asio::post(l_Raw->GetAsioSocket().get_executor(), [l_Pipe = std::move(l_Pipe)]()
+                {
+                    if (!l_Pipe->IsClosed())
+                        l_Pipe->CloseSocket();
+                });
+            }
+        }
+    }
+
+    /// Handle frame of gateway
+    /// @p_Frame : Frame
+    bool GatewayLink::OnFrame(ClusterFrame const& p_Frame)
+    {
+        if (!m_Hello)
+        {
+            if (p_Frame.Opcode != CLUSTER_HELLO || p_Frame.Payload.GetLength() != 4 || Protocol::ReadUInt32(p_Frame.Payload.GetData()) != CLUSTER_PROTOCOL_VERSION)
+            {
+                LOG_WARNING("Cluster", "Gateway %0 did not say hello with protocol version %1, closing link", GetRemoteEndpoint(), CLUSTER_PROTOCOL_VERSION);
+                return false;
+            }
+
+            m_Hello = true;
+            sCluster->AddGateway(Shared<GatewayLink>());
+
+            LOG_INFO("Cluster", "Gateway %0 connected", GetRemoteEndpoint());
+            return true;
+        }
+
+        switch (p_Frame.Opcode)
+        {
+            case CLUSTER_CLIENT_DATA:
+            {
+                std::shared_ptr<SessionPipe> l_Pipe;
+
+                {
+                    std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+                    auto l_Itr = m_Sessions.find(p_Frame.Session);
+                    if (l_Itr != m_Sessions.end())
+                        l_Pipe = l_Itr->second.lock();
+                }
+
+                if (l_Pipe)
+                    l_Pipe->Write(reinterpret_cast<char const*>(p_Frame.Payload.GetData()), p_Frame.Payload.GetLength());
+
+                return true;
+            }
+            case CLUSTER_SESSION_OPEN:
+            {
+                if (p_Frame.Payload.GetLength() != 4)
+                    return false;
+
+                OpenSession(p_Frame.Session, Protocol::ReadUInt32(p_Frame.Payload.GetData()));
+                return true;
+            }
+            case CLUSTER_SESSION_CLOSE:
+            {
+                std::shared_ptr<SessionPipe> l_Pipe;
+
+                {
+                    std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+                    auto l_Itr = m_Sessions.find(p_Frame.Session);
+                    if (l_Itr == m_Sessions.end())
+                        return true;
+
+                    l_Pipe = l_Itr->second.lock();
+                    m_Sessions.erase(l_Itr);
+                }
+
+                /// The game socket reads the end of its pipe and leaves its room like any client going away
+                if (l_Pipe)
+                {
+                    SessionPipe* l_Raw = l_Pipe.get();
+                    boost::asio::post(l_Raw->GetAsioSocket().get_executor(), [l_Pipe = std::move(l_Pipe)]()
+                    {
+                        if (!l_Pipe->IsClosed())
+                            l_Pipe->CloseSocket();
+                    });
+                }
+
+                return true;
+            }
+            default:
+                LOG_WARNING("Cluster", "Unexpected frame %0 from gateway %1, ignoring", static_cast<uint32>(p_Frame.Opcode), GetRemoteEndpoint());
+                return true;
+        }
+    }
+
+    /// Create game socket and pipe of session
+    /// @p_Session : Id of session
+    /// @p_UserId  : Id of user
+    void GatewayLink::OpenSession(uint32 p_Session, uint32 p_UserId)
+    {
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+        int l_Pair[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, l_Pair) != 0)
+        {
+            LOG_ERROR("Cluster", "Failed to create socket pair of session %0", p_Session);
+            SendFrame(CLUSTER_SESSION_CLOSE, p_Session);
+            return;
+        }
+
+        /// Both ends are served by the same network thread, bytes cross it without waking another one
+        Core::Network::PoolNetworkThread* l_Thread = sCluster->GetPool()->SelectWorker();
+
+        std::shared_ptr<SessionPipe> l_Pipe = l_Thread->CreateSocket<SessionPipe>();
+        boost::system::error_code l_ErrorCode;
+
+        if (l_Pipe)
+            l_Pipe->GetAsioSocket().assign(boost::asio::ip::tcp::v4(), l_Pair[0], l_ErrorCode);
+
+        if (!l_Pipe || l_ErrorCode)
+        {
+            LOG_ERROR("Cluster", "Failed to create pipe of session %0", p_Session);
+
+            if (l_Pipe)
+                l_Thread->RemoveSocket(l_Pipe.get());
+
+            close(l_Pair[0]);
+            close(l_Pair[1]);
+            SendFrame(CLUSTER_SESSION_CLOSE, p_Session);
+            return;
+        }
+
+        l_Pipe->m_Link      = Shared<GatewayLink>();
+        l_Pipe->m_Session   = p_Session;
+
+        /// The gateway authenticated the user already
+        Core::Network::HandoffConnection l_Connection;
+        l_Connection.Descriptor = l_Pair[1];
+        l_Connection.State.push_back(static_cast<uint8>(Server::Authenticated::Authenticed));
+
+        if (!l_Thread->AdoptSocket<Server::GameSocket>(l_Connection))
+        {
+            if (l_Connection.Descriptor >= 0)
+                close(l_Connection.Descriptor);
+
+            l_Pipe->CloseSocket();
+            SendFrame(CLUSTER_SESSION_CLOSE, p_Session);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> l_Lock(m_Mutex);
+            m_Sessions[p_Session] = l_Pipe;
+        }
+
+        boost::asio::post(l_Pipe->GetAsioSocket().get_executor(), [l_Pipe]()
+        {
+            if (!l_Pipe->Open() && !l_Pipe->IsClosed())
+                l_Pipe->CloseSocket();
+        });
+
+        LOG_VERBOSE("Cluster", "Opened session %0 of user %1 for gateway %2", p_Session, p_UserId, GetRemoteEndpoint());
+#else
+        LOG_ERROR("Cluster", "Sessions of gateways are not supported on this platform");
+        SendFrame(CLUSTER_SESSION_CLOSE, p_Session);
+#endif
+    }
+    /// Pipe of session closed, tell the gateway
+    /// @p_Session : Id of session
+    void GatewayLink::OnPipeClosed(uint32 p_Session)
+    {
+        {
+            std::lock_guard<std::mutex> l_Lock(m_Mutex);
+            if (!m_Sessions.erase(p_Session))
+                return;
+        }
+
+        if (!IsClosed())
+            SendFrame(CLUSTER_SESSION_CLOSE, p_Session);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    /// @p_Service      : Boost Service
+    /// @p_Owner        : Owner told once we are closed
+    SessionPipe::SessionPipe(boost::asio::io_service& p_Service, Core::Network::SocketOwner* p_Owner)
+        : Socket(p_Service, p_Owner), m_Session(0)
+    {
+        /// Client frames written by our link in one batch are handed to the game socket together
+        Core::Network::FlushPolicySettings l_FlushPolicy;
+        l_FlushPolicy.Policy        = Core::Network::FlushPolicy::Tick;
+        l_FlushPolicy.ByteThreshold = 0;
+        l_FlushPolicy.Timeout       = 0;
+        SetFlushPolicy(l_FlushPolicy);
+    }
+    /// Deconstructor, tells our link the session is gone
+    SessionPipe::~SessionPipe()
+    {
+        if (std::shared_ptr<GatewayLink> l_Link = m_Link.lock())
+            l_Link->OnPipeClosed(m_Session);
+    }
+
+    /// Forward everything the game socket sent to the gateway
+    Core::Network::ProcessState SessionPipe::ProcessIncomingData()
+    {
+        std::shared_ptr<GatewayLink> l_Link = m_Link.lock();
+        if (!l_Link || l_Link->IsClosed())
+            return Core::Network::ProcessState::Error;
+
+        /// Server messages need no framing of ours, the gateway writes the bytes to its client in order
+        const Core::Network::PacketView l_Data = InView();
+
+        for (std::size_t l_Offset = 0; l_Offset < l_Data.GetLength(); l_Offset += CLUSTER_FRAME_MAX_PAYLOAD)
+        {
+            const std::size_t l_Length = std::min<std::size_t>(CLUSTER_FRAME_MAX_PAYLOAD, l_Data.GetLength() - l_Offset);
+            l_Link->SendFrame(CLUSTER_SERVER_DATA, m_Session, l_Data.GetData() + l_Offset, l_Length);
+        }
+
+        ReadSkip(l_Data.GetLength());
+
+        return Core::Network::ProcessState::Successful;
+    }
+
+}   ///< namespace Cluster
+}   ///< namespace Game
+}   ///< namespace Steerstone
@@ -0,0 +1,187 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <boost/asio.hpp>
+
+#include "Core/Core.hpp"
+#include "Network/Socket.hpp"
+#include "ClusterProtocol.hpp"
+
+#include <atomic>
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace SteerStone { namespace Game {
+
+    namespace Server { class GameSocket; }
+
+namespace Cluster {
+
+    class SessionPipe;
+
+    /// Connection between a gateway and a game node, carries the frames of every session between them
+    /// Frames are written whole from any thread and coalesced by our flush policy, so many sessions share one syscall
+    class ClusterLink : public Core::Network::Socket
+    {
+        public:
+            /// Constructor
+            /// @p_Service      : Boost Service
+            /// @p_Owner        : Owner told once we are closed
+            ClusterLink(boost::asio::io_service& p_Service, Core::Network::SocketOwner* p_Owner);
+
+            /// Queue frame, safe from any thread
+            /// @p_Opcode  : Opcode
+            /// @p_Session : Session frame belongs to, 0 for the link itself
+            /// @p_Payload : Payload, at most CLUSTER_FRAME_MAX_PAYLOAD bytes
+            /// @p_Length  : Length of payload
+            bool SendFrame(ClusterOpcode p_Opcode, uint32 p_Session, uint8 const* p_Payload = nullptr, std::size_t p_Length = 0);
+
+        protected:
+            /// Handle frame, called from our network thread
+            /// @p_Frame : Frame
+            /// Returns false if link must be closed
+            virtual bool OnFrame(ClusterFrame const& p_Frame) = 0;
+
+        private:
+            /// Decode every complete frame of our in buffer
+            virtual Core::Network::ProcessState ProcessIncomingData() override;
+    };
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Gateway side, outbound link to one game node
+    /// Client sockets of the gateway open a session on the node owning their room and forward their room messages,
+    /// whatever the node answers is written to the client socket as is
+    class GameNodeLink : public ClusterLink
+    {
+        public:
+            /// Constructor
+            /// @p_Service      : Boost Service
+            /// @p_Owner        : Owner told once we are closed
+            GameNodeLink(boost::asio::io_service& p_Service, Core::Network::SocketOwner* p_Owner);
+
+            /// Connect to game node and say hello once connected
+            /// @p_NodeId   : Id of node
+            /// @p_EndPoint : Cluster end point of node
+            /// Returns false if connecting could not be started, we must be removed from our network thread
+            bool Connect(uint32 p_NodeId, boost::asio::ip::tcp::endpoint const& p_EndPoint);
+            /// Get id of node
+            uint32 GetNodeId() const { return m_NodeId; }
+            /// Check node can take sessions
+            bool IsReady() const { return m_Ready.load(std::memory_order_acquire) && !IsClosed(); }
+
+            /// Open session for client socket, safe from any thread
+            /// @p_Socket : Client socket
+            /// @p_UserId : Id of user, 0 if not logged in
+            /// Returns id of session
+            uint32 OpenSession(std::shared_ptr<Server::GameSocket> const& p_Socket, uint32 p_UserId);
+            /// Close session, safe from any thread
+            /// @p_Session : Id of session
+            void CloseSession(uint32 p_Session);
+            /// Forward client message to the session on the node, safe from any thread
+            /// @p_Session : Id of session
+            /// @p_Header  : Header id of message
+            /// @p_Body    : Body of message
+            void Forward(uint32 p_Session, uint16 p_Header, Core::Network::PacketView const& p_Body);
+            /// Make every client socket with a session on us check its room still belongs to us, safe from any thread
+            void RefreshSessions();
+
+        protected:
+            /// Handle frame of node
+            /// @p_Frame : Frame
+            virtual bool OnFrame(ClusterFrame const& p_Frame) override;
+
+        private:
+            uint32 m_NodeId;                                                                ///< Id of node
+            std::atomic<bool> m_Ready;                                                      ///< Connected and said hello
+            std::atomic<uint32> m_NextSession;                                              ///< Id of next session
+            mutable std::shared_mutex m_Mutex;                                              ///< Guards sessions
+            std::unordered_map<uint32, std::weak_ptr<Server::GameSocket>> m_Sessions;       ///< Client sockets by id of session
+    };
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Game node side, inbound link of one gateway
+    /// Every session gets a game socket of its own, adopted as authenticated on one end of a socket pair, so rooms and
+    /// handlers serve it exactly like a client connected to us; a session pipe on the other end carries its bytes
+    class GatewayLink : public ClusterLink
+    {
+        /// Allow pipes to tell us they closed
+        friend class SessionPipe;
+
+        public:
+            /// Constructor
+            /// @p_Service      : Boost Service
+            /// @p_Owner        : Owner told once we are closed
+            GatewayLink(boost::asio::io_service& p_Service, Core::Network::SocketOwner* p_Owner);
+            /// Deconstructor, closes the pipe of every session
+            ~GatewayLink();
+
+        protected:
+            /// Handle frame of gateway
+            /// @p_Frame : Frame
+            virtual bool OnFrame(ClusterFrame const& p_Frame) override;
+
+        private:
+            /// Create game socket and pipe of session
+            /// @p_Session : Id of session
+            /// @p_UserId  : Id of user
+            void OpenSession(uint32 p_Session, uint32 p_UserId);
+            /// Pipe of session closed, tell the gateway
+            /// @p_Session : Id of session
+            void OnPipeClosed(uint32 p_Session);
+
+        private:
+            bool m_Hello;                                                                   ///< Gateway said hello, network thread only
+            std::mutex m_Mutex;                                                             ///< Guards sessions
+            std::unordered_map<uint32, std::weak_ptr<SessionPipe>> m_Sessions;              ///< Pipes by id of session
+    };
+
+    /// Game node side, our end of the socket pair of a session
+    /// Whatever the game socket of the session sends is forwarded to the gateway, and the gateway writes client frames to us
+    class SessionPipe : public Core::Network::Socket
+    {
+        /// Allow our link to attach us
+        friend class GatewayLink;
+
+        public:
+            /// Constructor
+            /// @p_Service      : Boost Service
+            /// @p_Owner        : Owner told once we are closed
+            SessionPipe(boost::asio::io_service& p_Service, Core::Network::SocketOwner* p_Owner);
+            /// Deconstructor, tells our link the session is gone
+            ~SessionPipe();
+
+        private:
+            /// Forward everything the game socket sent to the gateway
+            virtual Core::Network::ProcessState ProcessIncomingData() override;
+
+        private:
+            std::weak_ptr<GatewayLink> m_Link;                                              ///< Link of gateway
+            uint32 m_Session;                                                               ///< Id of session
+    };
+
+}   ///< namespace Cluster
+}   ///< namespace Game
+}   ///< namespace Steerstone
@@ -0,0 +1,316 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "ClusterManager.hpp"
+#include "ClusterLink.hpp"
+#include "Config/Config.hpp"
+#include "Utility/UtiString.hpp"
+
+#include <algorithm>
+
+namespace SteerStone { namespace Game { namespace Cluster {
+
+    SINGLETON_P_I(ClusterManager);
+
+    /// Constructor
+    ClusterManager::ClusterManager()
+        : m_Role(ClusterRole::Standalone), m_NodeId(0), m_Pool(nullptr)
+    {
+    }
+    /// Deconstructor
+    ClusterManager::~ClusterManager()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Read settings, a gateway starts connecting to every game node
+    /// @p_Pool : Network threads links and sessions are served by, must outlive us
+    void ClusterManager::Initialize(Core::Network::NetworkThreadPool* p_Pool)
+    {
+        m_Pool = p_Pool;
+
+        const std::string l_Mode = sConfigManager->GetString("ClusterMode", "standalone");
+        if (l_Mode == "gateway")
+            m_Role = ClusterRole::Gateway;
+        else if (l_Mode == "gamenode")
+            m_Role = ClusterRole::GameNode;
+        else if (l_Mode != "standalone")
+            LOG_WARNING("Cluster", "Unknown ClusterMode %0, running standalone", l_Mode);
+
+        if (m_Role == ClusterRole::Standalone)
+            return;
+
+        m_NodeId = sConfigManager->GetInt("ClusterNodeId", 0);
+
+        if (!ParseGameNodes(sConfigManager->GetString("ClusterGameNodes", "")) || m_Nodes.empty())
+        {
+            LOG_ERROR("Cluster", "ClusterGameNodes is not valid, running standalone");
+            m_Role = ClusterRole::Standalone;
+            m_Nodes.clear();
+            return;
+        }
+
+        for (GameNode const& l_Node : m_Nodes)
+            m_Directory.AddNode(l_Node.Id);
+
+        if (m_Role == ClusterRole::GameNode)
+        {
+            /// Other nodes are assumed up, we only pick one when handing a room over
+            for (GameNode const& l_Node : m_Nodes)
+                m_Directory.SetNodeUp(l_Node.Id, l_Node.Id != m_NodeId);
+
+            LOG_INFO("Cluster", "Running as game node %0 of %1", m_NodeId, m_Nodes.size());
+            return;
+        }
+
+        const uint32 l_Interval = std::max<int32>(sConfigManager->GetInt("ClusterReconnectInterval", CLUSTER_RECONNECT_INTERVAL), 1);
+
+        Reconnect();
+
+        m_ReconnectTask = sThreadManager->PushTask("CLUSTER_RECONNECT", Core::Threading::TaskType::Normal, l_Interval, [this]() -> bool
+        {
+            Reconnect();
+            return true;
+        });
+
+        LOG_INFO("Cluster", "Running as gateway of %0 game nodes", m_Nodes.size());
+    }
+    /// Stop reconnecting
+    void ClusterManager::Shutdown()
+    {
+        if (m_ReconnectTask)
+        {
+            sThreadManager->PopTask(m_ReconnectTask);
+            m_ReconnectTask.reset();
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Gateway only, get link of the node owning room
+    /// @p_RoomId : Id of room
+    /// Returns nullptr if no node is up
+    std::shared_ptr<GameNodeLink> ClusterManager::GetRoomOwner(uint32 p_RoomId)
+    {
+        std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+        /// A link which closed since our last reconnect pass is still up in the directory, skip it as it will be marked down
+        uint32 l_Exclude = 0;
+        for (uint32 l_Attempt = 0; l_Attempt < 2; l_Attempt++)
+        {
+            const uint32 l_NodeId = m_Directory.GetOwner(p_RoomId, l_Exclude);
+            if (!l_NodeId)
+                return nullptr;
+
+            for (GameNode const& l_Node : m_Nodes)
+            {
+                if (l_Node.Id == l_NodeId && l_Node.Link && l_Node.Link->IsReady())
+                    return l_Node.Link;
+            }
+
+            l_Exclude = l_NodeId;
+        }
+
+        return nullptr;
+    }
+    /// Gateway only, a node moved room, its sessions follow
+    /// @p_RoomId : Id of room
+    /// @p_NodeId : Id of node now owning it
+    void ClusterManager::OnRoomMoved(uint32 p_RoomId, uint32 p_NodeId)
+    {
+        m_Directory.Move(p_RoomId, p_NodeId);
+
+        LOG_INFO("Cluster", "Room %0 moved to game node %1", p_RoomId, p_NodeId);
+
+        RefreshSessions();
+    }
+    /// Gateway only, link of node said hello
+    /// @p_NodeId : Id of node
+    void ClusterManager::OnNodeUp(uint32 p_NodeId)
+    {
+        {
+            std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+            for (GameNode& l_Node : m_Nodes)
+            {
+                if (l_Node.Id == p_NodeId)
+                    l_Node.Up = true;
+            }
+        }
+
+        m_Directory.SetNodeUp(p_NodeId, true);
+
+        /// Rooms hashed to the node while it was down come back to it
+        RefreshSessions();
+    }
+
+    /// Game node only, gateway said hello
+    /// @p_Link : Link of gateway
+    void ClusterManager::AddGateway(std::shared_ptr<GatewayLink> const& p_Link)
+    {
+        std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+        m_Gateways.erase(std::remove_if(m_Gateways.begin(), m_Gateways.end(), [](std::weak_ptr<GatewayLink> const& p_Gateway) { return p_Gateway.expired(); }), m_Gateways.end());
+        m_Gateways.push_back(p_Link);
+    }
+    /// Game node only, hand room over to another node, users in it re-enter it there without reconnecting
+    /// Rooms hold nothing which is not rebuilt on entry, users simply land at the door of the new room
+    /// @p_RoomId : Id of room
+    /// @p_NodeId : Id of node taking it, 0 to let the directory pick one
+    void ClusterManager::MigrateRoom(uint32 p_RoomId, uint32 p_NodeId)
+    {
+        if (m_Role != ClusterRole::GameNode)
+            return;
+
+        if (!p_NodeId)
+            p_NodeId = m_Directory.GetOwner(p_RoomId, m_NodeId);
+
+        if (!p_NodeId || p_NodeId == m_NodeId)
+        {
+            LOG_WARNING("Cluster", "No other game node can take room %0", p_RoomId);
+            return;
+        }
+
+        std::vector<uint8> l_Payload;
+        Protocol::AppendUInt32(l_Payload, p_RoomId);
+        Protocol::AppendUInt32(l_Payload, p_NodeId);
+
+        std::vector<std::shared_ptr<GatewayLink>> l_Gateways;
+
+        {
+            std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+            for (std::weak_ptr<GatewayLink> const& l_Gateway : m_Gateways)
+            {
+                if (std::shared_ptr<GatewayLink> l_Link = l_Gateway.lock())
+                    l_Gateways.push_back(std::move(l_Link));
+            }
+        }
+
+        /// Every gateway moves the sessions of its clients, our room unloads once they all left
+        for (std::shared_ptr<GatewayLink> const& l_Link : l_Gateways)
+            l_Link->SendFrame(CLUSTER_ROOM_MOVED, 0, l_Payload.data(), l_Payload.size());
+
+        LOG_INFO("Cluster", "Moving room %0 to game node %1 through %2 gateways", p_RoomId, p_NodeId, l_Gateways.size());
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Parse "id@address:port,..."
+    /// @p_Nodes : Setting
+    bool ClusterManager::ParseGameNodes(std::string const& p_Nodes)
+    {
+        for (std::string const& l_Entry : Core::Utils::SplitAll(p_Nodes, ",", false))
+        {
+            const std::size_t l_At      = l_Entry.find('@');
+            const std::size_t l_Colon   = l_Entry.rfind(':');
+
+            if (l_At == std::string::npos || l_Colon == std::string::npos || l_Colon < l_At)
+                return false;
+
+            GameNode l_Node;
+            l_Node.Id   = static_cast<uint32>(std::strtoul(l_Entry.substr(0, l_At).c_str(), nullptr, 10));
+            l_Node.Up   = false;
+
+            boost::system::error_code l_ErrorCode;
+            const boost::asio::ip::address l_Address = boost::asio::ip::make_address(l_Entry.substr(l_At + 1, l_Colon - l_At - 1), l_ErrorCode);
+            const uint32 l_Port = static_cast<uint32>(std::strtoul(l_Entry.substr(l_Colon + 1).c_str(), nullptr, 10));
+
+            if (!l_Node.Id || l_ErrorCode || !l_Port || l_Port > 0xFFFF)
+                return false;
+
+            l_Node.EndPoint = boost::asio::ip::tcp::endpoint(l_Address, static_cast<uint16>(l_Port));
+            m_Nodes.push_back(std::move(l_Node));
+        }
+
+        return true;
+    }
+    /// Gateway only, replace closed links and move sessions off nodes which went down
+    void ClusterManager::Reconnect()
+    {
+        std::vector<std::shared_ptr<GameNodeLink>> l_Lost;
+
+        {
+            std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+            for (GameNode& l_Node : m_Nodes)
+            {
+                /// Connecting or connected
+                if (l_Node.Link && !l_Node.Link->IsClosed())
+                    continue;
+
+                if (l_Node.Link)
+                {
+                    if (l_Node.Up)
+                    {
+                        LOG_WARNING("Cluster", "Lost game node %0, its rooms move to the other nodes", l_Node.Id);
+
+                        l_Node.Up = false;
+                        m_Directory.SetNodeUp(l_Node.Id, false);
+                    }
+
+                    l_Lost.push_back(std::move(l_Node.Link));
+                }
+
+                Core::Network::PoolNetworkThread* l_Thread = m_Pool->SelectWorker();
+
+                std::shared_ptr<GameNodeLink> l_Link = l_Thread->CreateSocket<GameNodeLink>();
+                if (!l_Link)
+                    continue;
+
+                if (!l_Link->Connect(l_Node.Id, l_Node.EndPoint))
+                {
+                    l_Thread->RemoveSocket(l_Link.get());
+                    continue;
+                }
+
+                l_Node.Link = std::move(l_Link);
+            }
+        }
+
+        /// Sessions on a lost node re-enter their room on its new owner
+        for (std::shared_ptr<GameNodeLink> const& l_Link : l_Lost)
+            l_Link->RefreshSessions();
+    }
+    /// Gateway only, make every session check the node owning its room
+    void ClusterManager::RefreshSessions()
+    {
+        std::vector<std::shared_ptr<GameNodeLink>> l_Links;
+
+        {
+            std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+            for (GameNode const& l_Node : m_Nodes)
+            {
+                if (l_Node.Link)
+                    l_Links.push_back(l_Node.Link);
+            }
+        }
+
+        for (std::shared_ptr<GameNodeLink> const& l_Link : l_Links)
+            l_Link->RefreshSessions();
+    }
+
+}   ///< namespace Cluster
+}   ///< namespace Game
+}   ///< namespace Steerstone
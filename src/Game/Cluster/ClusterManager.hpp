@@ -0,0 +1,131 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <boost/asio.hpp>
+
+#include "Core/Core.hpp"
+#include "Singleton/Singleton.hpp"
+#include "Threading/ThrTaskManager.hpp"
+#include "Network/NetworkThreadPool.hpp"
+#include "RoomDirectory.hpp"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define CLUSTER_RECONNECT_INTERVAL  1000    ///< Default MS between two attempts to reach a game node which is down
+#define CLUSTER_FLUSH_BYTES         16384   ///< Default queued bytes which make a link flush
+#define CLUSTER_FLUSH_TIMEOUT       2       ///< Default MS frames may wait on a link before being sent
+
+namespace SteerStone { namespace Game { namespace Cluster {
+
+    class GameNodeLink;
+    class GatewayLink;
+
+    /// Role of this process
+    enum class ClusterRole
+    {
+        Standalone,                 ///< Terminates clients and owns every room
+        Gateway,                    ///< Terminates clients, rooms are owned by game nodes
+        GameNode                    ///< Owns rooms, clients reach it through gateways
+    };
+
+    /// Clustered mode, gateways terminate client sockets and forward the room traffic of every client to the game node
+    /// owning its room; a client moving to a room of another node, or whose room migrates, keeps its connection to the
+    /// gateway and only its session moves
+    class ClusterManager
+    {
+        SINGLETON_P_D(ClusterManager);
+
+        public:
+            /// Read settings, a gateway starts connecting to every game node
+            /// @p_Pool : Network threads links and sessions are served by, must outlive us
+            void Initialize(Core::Network::NetworkThreadPool* p_Pool);
+            /// Stop reconnecting
+            void Shutdown();
+
+            /// Get role of this process
+            ClusterRole GetRole() const { return m_Role; }
+            /// Check we forward rooms to game nodes
+            bool IsGateway() const { return m_Role == ClusterRole::Gateway; }
+            /// Get id of this process in ClusterGameNodes
+            uint32 GetNodeId() const { return m_NodeId; }
+            /// Get network threads
+            Core::Network::NetworkThreadPool* GetPool() const { return m_Pool; }
+
+            /// Gateway only, get link of the node owning room
+            /// @p_RoomId : Id of room
+            /// Returns nullptr if no node is up
+            std::shared_ptr<GameNodeLink> GetRoomOwner(uint32 p_RoomId);
+            /// Gateway only, a node moved room, its sessions follow
+            /// @p_RoomId : Id of room
+            /// @p_NodeId : Id of node now owning it
+            void OnRoomMoved(uint32 p_RoomId, uint32 p_NodeId);
+            /// Gateway only, link of node said hello
+            /// @p_NodeId : Id of node
+            void OnNodeUp(uint32 p_NodeId);
+
+            /// Game node only, gateway said hello
+            /// @p_Link : Link of gateway
+            void AddGateway(std::shared_ptr<GatewayLink> const& p_Link);
+            /// Game node only, hand room over to another node, users in it re-enter it there without reconnecting
+            /// Rooms hold nothing which is not rebuilt on entry, users simply land at the door of the new room
+            /// @p_RoomId : Id of room
+            /// @p_NodeId : Id of node taking it, 0 to let the directory pick one
+            void MigrateRoom(uint32 p_RoomId, uint32 p_NodeId = 0);
+
+        private:
+            /// Configured game node
+            struct GameNode
+            {
+                uint32 Id;                                          ///< Id of node
+                boost::asio::ip::tcp::endpoint EndPoint;            ///< Cluster end point of node
+                std::shared_ptr<GameNodeLink> Link;                 ///< Current link, nullptr if none
+                bool Up;                                            ///< Link said hello
+            };
+
+            /// Parse "id@address:port,..."
+            /// @p_Nodes : Setting
+            bool ParseGameNodes(std::string const& p_Nodes);
+            /// Gateway only, replace closed links and move sessions off nodes which went down
+            void Reconnect();
+            /// Gateway only, make every session check the node owning its room
+            void RefreshSessions();
+
+        private:
+            ClusterRole m_Role;                                     ///< Role of this process
+            uint32 m_NodeId;                                        ///< Id of this process
+            Core::Network::NetworkThreadPool* m_Pool;               ///< Network threads
+            RoomDirectory m_Directory;                              ///< Owner of every room
+
+            std::mutex m_Mutex;                                     ///< Guards nodes and gateways
+            std::vector<GameNode> m_Nodes;                          ///< Game nodes
+            std::vector<std::weak_ptr<GatewayLink>> m_Gateways;     ///< Links of gateways, game node only
+
+            Core::Threading::Task::Ptr m_ReconnectTask;             ///< Task replacing closed links
+    };
+
+}   ///< namespace Cluster
+}   ///< namespace Game
+}   ///< namespace Steerstone
+
+#define sCluster SteerStone::Game::Cluster::ClusterManager::GetSingleton()
@@ -0,0 +1,116 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+#include "Network/PacketBuffer.hpp"
+#include "Network/PacketView.hpp"
+#include "Server/ClientMessage.hpp"
+
+#include <vector>
+
+#define CLUSTER_PROTOCOL_VERSION    1       ///< Version sent in CLUSTER_HELLO, both ends must match
+#define CLUSTER_FRAME_HEADER_SIZE   9       ///< Payload length, opcode and session of a frame
+#define CLUSTER_FRAME_MAX_PAYLOAD   (STORAGE_INITIAL_SIZE - CLUSTER_FRAME_HEADER_SIZE)
+
+namespace SteerStone { namespace Game { namespace Cluster {
+
+    /// Internal protocol between gateways and game nodes
+    ///
+    /// Frame : uint32 payload length, uint8 opcode, uint32 session, payload, integers are little endian
+    /// Frames are never acknowledged, any amount of them is in flight and they are coalesced by the flush policy of the link
+    enum ClusterOpcode : uint8
+    {
+        CLUSTER_HELLO           = 1,        ///< Gateway -> node, session 0, uint32 protocol version
+        CLUSTER_SESSION_OPEN    = 2,        ///< Gateway -> node, uint32 id of user
+        CLUSTER_SESSION_CLOSE   = 3,        ///< Both ways, no payload
+        CLUSTER_CLIENT_DATA     = 4,        ///< Gateway -> node, client frames exactly as a client sends them
+        CLUSTER_SERVER_DATA     = 5,        ///< Node -> gateway, server messages exactly as they are sent to the client
+        CLUSTER_ROOM_MOVED      = 6,        ///< Node -> gateway, session 0, uint32 id of room, uint32 id of node now owning it
+    };
+
+    /// Decoded frame, its payload points into the in buffer of the link
+    struct ClusterFrame
+    {
+        ClusterOpcode Opcode;                       ///< Opcode
+        uint32 Session;                             ///< Session frame belongs to, 0 for the link itself
+        Core::Network::PacketView Payload;          ///< Payload
+    };
+
+namespace Protocol {
+
+    /// Append little endian uint32
+    /// @p_Output : Output
+    /// @p_Value  : Value
+    inline void AppendUInt32(std::vector<uint8>& p_Output, uint32 p_Value)
+    {
+        p_Output.push_back(static_cast<uint8>(p_Value));
+        p_Output.push_back(static_cast<uint8>(p_Value >> 8));
+        p_Output.push_back(static_cast<uint8>(p_Value >> 16));
+        p_Output.push_back(static_cast<uint8>(p_Value >> 24));
+    }
+    /// Read little endian uint32
+    /// @p_Data : Data, must hold at least 4 bytes
+    inline uint32 ReadUInt32(uint8 const* p_Data)
+    {
+        return static_cast<uint32>(p_Data[0]) | (static_cast<uint32>(p_Data[1]) << 8) | (static_cast<uint32>(p_Data[2]) << 16) | (static_cast<uint32>(p_Data[3]) << 24);
+    }
+
+    /// Append frame header, the payload must be appended right after
+    /// @p_Output        : Output
+    /// @p_Opcode        : Opcode
+    /// @p_Session       : Session frame belongs to
+    /// @p_PayloadLength : Length of payload
+    inline void AppendFrameHeader(std::vector<uint8>& p_Output, ClusterOpcode p_Opcode, uint32 p_Session, std::size_t p_PayloadLength)
+    {
+        AppendUInt32(p_Output, static_cast<uint32>(p_PayloadLength));
+        p_Output.push_back(p_Opcode);
+        AppendUInt32(p_Output, p_Session);
+    }
+
+    /// Decode frame at the start of data
+    /// @p_Data        : Unread incoming data
+    /// @p_Frame       : Output, valid while data is
+    /// @p_FrameLength : Output, bytes to skip once handled
+    inline Server::FrameState DecodeFrame(Core::Network::PacketView const& p_Data, ClusterFrame& p_Frame, std::size_t& p_FrameLength)
+    {
+        if (p_Data.GetLength() < CLUSTER_FRAME_HEADER_SIZE)
+            return Server::FrameState::Incomplete;
+
+        const uint32 l_Length = ReadUInt32(p_Data.GetData());
+        if (l_Length > CLUSTER_FRAME_MAX_PAYLOAD)
+            return Server::FrameState::Malformed;
+
+        if (p_Data.GetLength() < CLUSTER_FRAME_HEADER_SIZE + l_Length)
+            return Server::FrameState::Incomplete;
+
+        p_Frame.Opcode  = static_cast<ClusterOpcode>(p_Data.GetData()[4]);
+        p_Frame.Session = ReadUInt32(p_Data.GetData() + 5);
+        p_Frame.Payload = p_Data.SubView(CLUSTER_FRAME_HEADER_SIZE, l_Length);
+        p_FrameLength   = CLUSTER_FRAME_HEADER_SIZE + l_Length;
+
+        return Server::FrameState::Complete;
+    }
+
+}   ///< namespace Protocol
+}   ///< namespace Cluster
+}   ///< namespace Game
+}   ///< namespace Steerstone
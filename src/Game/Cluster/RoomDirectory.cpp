@@ -0,0 +1,113 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "RoomDirectory.hpp"
+
+#include <mutex>
+
+namespace SteerStone { namespace Game { namespace Cluster {
+
+    /// Add game node, down until told otherwise
+    /// @p_NodeId : Id of node, not 0
+    void RoomDirectory::AddNode(uint32 p_NodeId)
+    {
+        std::unique_lock<std::shared_mutex> l_Lock(m_Mutex);
+
+        for (Node const& l_Node : m_Nodes)
+        {
+            if (l_Node.Id == p_NodeId)
+                return;
+        }
+
+        m_Nodes.push_back({ p_NodeId, false });
+    }
+    /// Mark game node up or down
+    /// @p_NodeId : Id of node
+    /// @p_Up     : Node is reachable
+    void RoomDirectory::SetNodeUp(uint32 p_NodeId, bool p_Up)
+    {
+        std::unique_lock<std::shared_mutex> l_Lock(m_Mutex);
+
+        for (Node& l_Node : m_Nodes)
+        {
+            if (l_Node.Id == p_NodeId)
+                l_Node.Up = p_Up;
+        }
+    }
+    /// Pin room to node
+    /// @p_RoomId : Id of room
+    /// @p_NodeId : Id of node
+    void RoomDirectory::Move(uint32 p_RoomId, uint32 p_NodeId)
+    {
+        std::unique_lock<std::shared_mutex> l_Lock(m_Mutex);
+        m_Pinned[p_RoomId] = p_NodeId;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get node owning room
+    /// @p_RoomId  : Id of room
+    /// @p_Exclude : Id of node which may not be picked, 0 if none
+    /// Returns 0 if no node is up
+    uint32 RoomDirectory::GetOwner(uint32 p_RoomId, uint32 p_Exclude) const
+    {
+        std::shared_lock<std::shared_mutex> l_Lock(m_Mutex);
+
+        uint32 l_Pinned = 0;
+        if (auto l_Itr = m_Pinned.find(p_RoomId); l_Itr != m_Pinned.end() && l_Itr->second != p_Exclude)
+            l_Pinned = l_Itr->second;
+
+        uint32 l_Owner = 0;
+        uint64 l_BestScore = 0;
+
+        for (Node const& l_Node : m_Nodes)
+        {
+            if (!l_Node.Up || l_Node.Id == p_Exclude)
+                continue;
+
+            if (l_Node.Id == l_Pinned)
+                return l_Pinned;
+
+            const uint64 l_Score = Score(p_RoomId, l_Node.Id);
+            if (!l_Owner || l_Score > l_BestScore)
+            {
+                l_Owner     = l_Node.Id;
+                l_BestScore = l_Score;
+            }
+        }
+
+        return l_Owner;
+    }
+
+    /// Score of a node for a room, the node with the highest score owns the room
+    /// @p_RoomId : Id of room
+    /// @p_NodeId : Id of node
+    uint64 RoomDirectory::Score(uint32 p_RoomId, uint32 p_NodeId)
+    {
+        /// SplitMix64 finalizer, consecutive room ids land on unrelated nodes
+        uint64 l_Value = (static_cast<uint64>(p_NodeId) << 32) | p_RoomId;
+        l_Value = (l_Value ^ (l_Value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        l_Value = (l_Value ^ (l_Value >> 27)) * 0x94D049BB133111EBULL;
+        return l_Value ^ (l_Value >> 31);
+    }
+
+}   ///< namespace Cluster
+}   ///< namespace Game
+}   ///< namespace Steerstone
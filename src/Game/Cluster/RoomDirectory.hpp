@@ -0,0 +1,82 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace SteerStone { namespace Game { namespace Cluster {
+
+    /// Room id -> game node id
+    /// Rooms are spread with rendezvous hashing over the game nodes which are up, so every gateway configured with
+    /// the same nodes picks the same owner without asking anyone, and only the rooms of a node which goes down move
+    /// A migrated room is pinned to its new node until we are restarted, falling back to hashing while that node is down
+    class RoomDirectory
+    {
+        DISALLOW_COPY_AND_ASSIGN(RoomDirectory);
+
+        public:
+            /// Constructor
+            RoomDirectory() = default;
+
+            /// Add game node, down until told otherwise
+            /// @p_NodeId : Id of node, not 0
+            void AddNode(uint32 p_NodeId);
+            /// Mark game node up or down
+            /// @p_NodeId : Id of node
+            /// @p_Up     : Node is reachable
+            void SetNodeUp(uint32 p_NodeId, bool p_Up);
+            /// Pin room to node
+            /// @p_RoomId : Id of room
+            /// @p_NodeId : Id of node
+            void Move(uint32 p_RoomId, uint32 p_NodeId);
+
+            /// Get node owning room
+            /// @p_RoomId  : Id of room
+            /// @p_Exclude : Id of node which may not be picked, 0 if none
+            /// Returns 0 if no node is up
+            uint32 GetOwner(uint32 p_RoomId, uint32 p_Exclude = 0) const;
+
+        private:
+            /// Score of a node for a room, the node with the highest score owns the room
+            /// @p_RoomId : Id of room
+            /// @p_NodeId : Id of node
+            static uint64 Score(uint32 p_RoomId, uint32 p_NodeId);
+
+        private:
+            /// Game node
+            struct Node
+            {
+                uint32 Id;                                      ///< Id of node
+                bool Up;                                        ///< Node is reachable
+            };
+
+            mutable std::shared_mutex m_Mutex;                  ///< Guards nodes and pinned rooms
+            std::vector<Node> m_Nodes;                          ///< Game nodes
+            std::unordered_map<uint32, uint32> m_Pinned;        ///< Migrated rooms, node id by room id
+    };
+
+}   ///< namespace Cluster
+}   ///< namespace Game
+}   ///< namespace Steerstone
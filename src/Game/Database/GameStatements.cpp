@@ -0,0 +1,56 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "GameStatements.hpp"
+
+namespace SteerStone { namespace Game {
+
+    /// Register every game statement
+    /// @p_Catalog : Catalog to fill
+    void RegisterGameStatements(Core::Database::StatementCatalog& p_Catalog)
+    {
+        /// REGISTER_STATEMENT(p_Catalog, STATEMENT_ID, "SELECT ... WHERE id = ?", Core::Database::FIELD_UI32);
+        /// REGISTER_READ_STATEMENT(p_Catalog, STATEMENT_ID, "SELECT ... WHERE id = ?", Core::Database::FIELD_UI32);
+
+        /// Tickets are written by the website just before the client connects, a replica may not have them yet
+        REGISTER_STATEMENT(p_Catalog, GAME_SEL_USER_BY_TICKET, "SELECT id FROM users WHERE sso_ticket = ?", Core::Database::FIELD_STRING);
+        REGISTER_STATEMENT(p_Catalog, GAME_UPD_USER_CLEAR_TICKET, "UPDATE users SET sso_ticket = NULL WHERE id = ?", Core::Database::FIELD_UI32);
+        REGISTER_READ_STATEMENT(p_Catalog, GAME_SEL_USER_PROFILE, "SELECT id, username, figure, sex, mission, credits, rank FROM users WHERE id = ?", Core::Database::FIELD_UI32);
+
+        /// Loaded once at boot, the navigator keeps its lists in memory afterwards
+        REGISTER_READ_STATEMENT(p_Catalog, GAME_SEL_NAVIGATOR_ROOMS, "SELECT id, name, owner, category, visitors_max FROM rooms");
+        REGISTER_READ_STATEMENT(p_Catalog, GAME_SEL_NAVIGATOR_CATEGORIES, "SELECT id, name FROM room_categories");
+
+        /// Loaded at boot and on reload, pages and items come in display order
+        REGISTER_READ_STATEMENT(p_Catalog, GAME_SEL_CATALOG_PAGES, "SELECT id, parent_id, caption, layout, min_rank FROM catalog_pages ORDER BY order_id, id");
+        REGISTER_READ_STATEMENT(p_Catalog, GAME_SEL_CATALOG_ITEMS, "SELECT id, page_id, definition_id, cost, amount FROM catalog_items ORDER BY page_id, order_id, id");
+        REGISTER_READ_STATEMENT(p_Catalog, GAME_SEL_FURNI_DEFINITIONS, "SELECT id, sprite, name, description, width, length, colour FROM furniture_definitions");
+
+        /// Streamed with a cursor when a user opens their hand, paged by keyset on id
+        REGISTER_READ_STATEMENT(p_Catalog, GAME_SEL_INVENTORY_ITEMS, "SELECT id, definition_id, extra_data FROM items WHERE owner_id = ? AND room_id = 0 AND id > ? ORDER BY id LIMIT ?",
+            Core::Database::FIELD_UI32, Core::Database::FIELD_UI32, Core::Database::FIELD_UI32);
+
+        /// Loaded at boot and on reload, compiled into the word filter
+        REGISTER_READ_STATEMENT(p_Catalog, GAME_SEL_WORD_FILTER, "SELECT word FROM wordfilter");
+
+        /// Loaded on login, friends are told about every presence change of the user
+        REGISTER_READ_STATEMENT(p_Catalog, GAME_SEL_MESSENGER_FRIENDS, "SELECT friend_id FROM messenger_friendships WHERE user_id = ?", Core::Database::FIELD_UI32);
+    }
+
+}   ///< namespace Game
+}   ///< namespace Steerstone
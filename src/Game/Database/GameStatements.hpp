@@ -0,0 +1,51 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+#include "Database/StatementCatalog.hpp"
+
+namespace SteerStone { namespace Game {
+
+    /// Statements of the game database, prepared on every connection at boot
+    /// Add the id here and its query in RegisterGameStatements, then use GameDatabase.GetPrepareStatement(id)
+    enum GameStatements : uint32
+    {
+        GAME_SEL_USER_BY_TICKET,            ///< Id of user owning an SSO ticket
+        GAME_UPD_USER_CLEAR_TICKET,         ///< Consume SSO ticket of user
+        GAME_SEL_USER_PROFILE,              ///< Profile of user
+        GAME_SEL_NAVIGATOR_ROOMS,           ///< Every room listed in the navigator
+        GAME_SEL_NAVIGATOR_CATEGORIES,      ///< Every navigator category
+        GAME_SEL_CATALOG_PAGES,             ///< Every catalog page
+        GAME_SEL_CATALOG_ITEMS,             ///< Every catalog item
+        GAME_SEL_FURNI_DEFINITIONS,         ///< Every furniture definition
+        GAME_SEL_INVENTORY_ITEMS,           ///< Items in the hand of a user after an id, streamed
+        GAME_SEL_WORD_FILTER,               ///< Every banned word
+        GAME_SEL_MESSENGER_FRIENDS,         ///< Ids of friends of a user
+
+        MAX_GAME_STATEMENTS
+    };
+
+    /// Register every game statement
+    /// @p_Catalog : Catalog to fill
+    void RegisterGameStatements(Core::Database::StatementCatalog& p_Catalog);
+
+}   ///< namespace Game
+}   ///< namespace Steerstone
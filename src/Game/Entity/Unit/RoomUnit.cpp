@@ -0,0 +1,191 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "RoomUnit.hpp"
+#include "Map/RoomGrid.hpp"
+#include "Map/Pathfinder.hpp"
+
+#include <charconv>
+#include <cstdlib>
+
+namespace SteerStone { namespace Game { namespace Entity {
+
+    /// Rotation facing a neighbour, indexed by (Y offset + 1) * 3 + X offset + 1, 0 is north and 2 east
+    static constexpr uint8 s_Rotations[] = { 7, 0, 1, 6, 2, 2, 5, 4, 3 };
+
+    /// Append integer
+    /// @p_Output : Output
+    /// @p_Value  : Value
+    static void AppendNumber(std::string& p_Output, int32 p_Value)
+    {
+        char l_Buffer[12];
+        const std::to_chars_result l_Result = std::to_chars(l_Buffer, l_Buffer + sizeof(l_Buffer), p_Value);
+        p_Output.append(l_Buffer, l_Result.ptr);
+    }
+    /// Append height, whole tiles are written without decimals
+    /// @p_Output : Output
+    /// @p_Height : Height in hundredths of a tile
+    static void AppendHeight(std::string& p_Output, int16 p_Height)
+    {
+        AppendNumber(p_Output, p_Height / ROOM_GRID_HEIGHT_SCALE);
+
+        if (const int32 l_Fraction = std::abs(p_Height % ROOM_GRID_HEIGHT_SCALE))
+        {
+            p_Output.push_back('.');
+            p_Output.push_back(static_cast<char>('0' + l_Fraction / 10));
+            if (l_Fraction % 10)
+                p_Output.push_back(static_cast<char>('0' + l_Fraction % 10));
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    /// @p_Id     : Id of unit in room
+    /// @p_Socket : Socket of avatar, nullptr for bots
+    /// @p_X      : X of tile
+    /// @p_Y      : Y of tile
+    /// @p_Z      : Height unit stands at in hundredths of a tile
+    RoomUnit::RoomUnit(uint32 p_Id, std::shared_ptr<Server::GameSocket> const& p_Socket, int16 p_X, int16 p_Y, int16 p_Z)
+        : m_Id(p_Id), m_Socket(p_Socket), m_X(p_X), m_Y(p_Y), m_Z(p_Z), m_NextX(p_X), m_NextY(p_Y), m_NextZ(p_Z),
+        m_GoalX(p_X), m_GoalY(p_Y), m_HeadRotation(2), m_BodyRotation(2), m_PathVersion(0), m_Walking(false), m_Dirty(true)
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Set tile to walk to, the path to a goal which did not change is kept
+    /// @p_X : X of tile
+    /// @p_Y : Y of tile
+    void RoomUnit::SetGoal(int16 p_X, int16 p_Y)
+    {
+        if (p_X == m_GoalX && p_Y == m_GoalY)
+            return;
+
+        m_GoalX = p_X;
+        m_GoalY = p_Y;
+        m_Path.clear();
+    }
+    /// Set tile to walk to along a path already searched, it is walked as long as the grid does not change
+    /// @p_X       : X of tile
+    /// @p_Y       : Y of tile
+    /// @p_Path    : Path from FindPath, swapped with ours
+    /// @p_Version : Grid version path was searched on
+    void RoomUnit::SetPath(int16 p_X, int16 p_Y, std::vector<uint32>& p_Path, uint32 p_Version)
+    {
+        m_GoalX       = p_X;
+        m_GoalY       = p_Y;
+        m_PathVersion = p_Version;
+        m_Path.swap(p_Path);
+    }
+    /// Advance one walk step, arrives on the tile of the previous step and picks the next one
+    /// @p_Grid : Grid of room, the unit occupies the tile it stands on and the one it walks onto
+    void RoomUnit::Step(Map::RoomGrid& p_Grid)
+    {
+        if (m_Walking)
+        {
+            p_Grid.RemoveOccupant(p_Grid.GetIndex(m_X, m_Y));
+
+            m_X       = m_NextX;
+            m_Y       = m_NextY;
+            m_Z       = m_NextZ;
+            m_Walking = false;
+            m_Dirty   = true;
+        }
+
+        if (m_GoalX == m_X && m_GoalY == m_Y)
+        {
+            m_Path.clear();
+            return;
+        }
+
+        const uint32 l_Current = p_Grid.GetIndex(m_X, m_Y);
+
+        /// Clicking the same tile again or walking on keeps the path, it is only searched again
+        /// once furni moved or a unit stepped onto our next tile
+        if (m_Path.empty() || m_PathVersion != p_Grid.GetVersion() || !p_Grid.IsFree(m_Path.back()))
+        {
+            if (!Map::Pathfinder::FindPath(p_Grid, l_Current, p_Grid.GetIndex(m_GoalX, m_GoalY), m_Path))
+            {
+                /// Unreachable, give up rather than search again every tick
+                m_GoalX = m_X;
+                m_GoalY = m_Y;
+                return;
+            }
+
+            m_PathVersion = p_Grid.GetVersion();
+        }
+
+        const uint32 l_Next = m_Path.back();
+        m_Path.pop_back();
+
+        m_NextX        = p_Grid.GetX(l_Next);
+        m_NextY        = p_Grid.GetY(l_Next);
+        m_NextZ        = p_Grid.GetStandHeight(l_Next);
+        m_HeadRotation = s_Rotations[(m_NextY - m_Y + 1) * 3 + m_NextX - m_X + 1];
+        m_BodyRotation = m_HeadRotation;
+        m_Walking      = true;
+        m_Dirty        = true;
+
+        p_Grid.AddOccupant(l_Next);
+    }
+
+    /// Append status line (id x,y,z,head,body/mv x,y,z/)
+    /// @p_Output : Output
+    void RoomUnit::WriteStatus(std::string& p_Output) const
+    {
+        AppendNumber(p_Output, m_Id);
+        p_Output.push_back(' ');
+        AppendNumber(p_Output, m_X);
+        p_Output.push_back(',');
+        AppendNumber(p_Output, m_Y);
+        p_Output.push_back(',');
+        AppendHeight(p_Output, m_Z);
+        p_Output.push_back(',');
+        AppendNumber(p_Output, m_HeadRotation);
+        p_Output.push_back(',');
+        AppendNumber(p_Output, m_BodyRotation);
+        p_Output.push_back('/');
+
+        if (m_Walking)
+        {
+            p_Output.append("mv ");
+            AppendNumber(p_Output, m_NextX);
+            p_Output.push_back(',');
+            AppendNumber(p_Output, m_NextY);
+            p_Output.push_back(',');
+            AppendHeight(p_Output, m_NextZ);
+            p_Output.push_back('/');
+        }
+
+        p_Output.push_back('\r');
+    }
+    /// Append status line and clear dirty flag
+    /// @p_Output : Output
+    void RoomUnit::FlushStatus(std::string& p_Output)
+    {
+        WriteStatus(p_Output);
+        m_Dirty = false;
+    }
+
+}   ///< namespace Entity
+}   ///< namespace Game
+}   ///< namespace Steerstone
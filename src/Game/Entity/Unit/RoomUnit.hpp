@@ -0,0 +1,114 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace SteerStone { namespace Game {
+
+    namespace Server { class GameSocket; }
+    namespace Map    { class RoomGrid;   }
+
+namespace Entity {
+
+    /// Avatar or bot standing in a room, only touched from the strand of its room
+    class RoomUnit
+    {
+        public:
+            /// Constructor
+            /// @p_Id     : Id of unit in room
+            /// @p_Socket : Socket of avatar, nullptr for bots
+            /// @p_X      : X of tile
+            /// @p_Y      : Y of tile
+            /// @p_Z      : Height unit stands at in hundredths of a tile
+            RoomUnit(uint32 p_Id, std::shared_ptr<Server::GameSocket> const& p_Socket, int16 p_X, int16 p_Y, int16 p_Z);
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Get id of unit in room
+            uint32 GetId() const { return m_Id; }
+            /// Get socket of avatar, nullptr for bots
+            std::shared_ptr<Server::GameSocket> const& GetSocket() const { return m_Socket; }
+            /// Check unit is a bot
+            bool IsBot() const { return m_Socket == nullptr; }
+            /// Get X of tile
+            int16 GetX() const { return m_X; }
+            /// Get Y of tile
+            int16 GetY() const { return m_Y; }
+            /// Get X of tile being walked onto
+            int16 GetNextX() const { return m_NextX; }
+            /// Get Y of tile being walked onto
+            int16 GetNextY() const { return m_NextY; }
+            /// Check unit is on its way onto the next tile
+            bool IsWalkingOntoNext() const { return m_Walking; }
+            /// Check unit is walking or has a goal left
+            bool IsWalking() const { return m_Walking || m_GoalX != m_X || m_GoalY != m_Y; }
+
+            /// Set tile to walk to, the path to a goal which did not change is kept
+            /// @p_X : X of tile
+            /// @p_Y : Y of tile
+            void SetGoal(int16 p_X, int16 p_Y);
+            /// Set tile to walk to along a path already searched, it is walked as long as the grid does not change
+            /// @p_X       : X of tile
+            /// @p_Y       : Y of tile
+            /// @p_Path    : Path from FindPath, swapped with ours
+            /// @p_Version : Grid version path was searched on
+            void SetPath(int16 p_X, int16 p_Y, std::vector<uint32>& p_Path, uint32 p_Version);
+            /// Advance one walk step, arrives on the tile of the previous step and picks the next one
+            /// @p_Grid : Grid of room, the unit occupies the tile it stands on and the one it walks onto
+            void Step(Map::RoomGrid& p_Grid);
+
+            /// Check status changed since it was last written
+            bool IsDirty() const { return m_Dirty; }
+            /// Append status line (id x,y,z,head,body/mv x,y,z/)
+            /// @p_Output : Output
+            void WriteStatus(std::string& p_Output) const;
+            /// Append status line and clear dirty flag
+            /// @p_Output : Output
+            void FlushStatus(std::string& p_Output);
+
+        private:
+            uint32 m_Id;                                    ///< Id of unit in room
+            std::shared_ptr<Server::GameSocket> m_Socket;   ///< Socket of avatar, nullptr for bots
+            int16 m_X;                                      ///< X of tile
+            int16 m_Y;                                      ///< Y of tile
+            int16 m_Z;                                      ///< Height stood at in hundredths
+            int16 m_NextX;                                  ///< X of tile being walked onto
+            int16 m_NextY;                                  ///< Y of tile being walked onto
+            int16 m_NextZ;                                  ///< Height of tile being walked onto in hundredths
+            int16 m_GoalX;                                  ///< X of tile to walk to
+            int16 m_GoalY;                                  ///< Y of tile to walk to
+            uint8 m_HeadRotation;                           ///< Rotation of head, 0 is north and 2 east
+            uint8 m_BodyRotation;                           ///< Rotation of body
+            std::vector<uint32> m_Path;                     ///< Tiles left to walk to goal, next one at the back
+            uint32 m_PathVersion;                           ///< Grid version path was searched on
+            bool m_Walking;                                 ///< Walking onto next tile
+            bool m_Dirty;                                   ///< Status changed since last written
+    };
+
+}   ///< namespace Entity
+}   ///< namespace Game
+}   ///< namespace Steerstone
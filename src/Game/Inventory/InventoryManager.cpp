@@ -0,0 +1,171 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "InventoryManager.hpp"
+#include "Config/Config.hpp"
+#include "Threading/ThrTaskManager.hpp"
+#include "Server/Socket.hpp"
+
+#include <algorithm>
+
+namespace SteerStone { namespace Game { namespace Inventory {
+
+    SINGLETON_P_I(InventoryManager);
+
+    /// Constructor
+    InventoryManager::InventoryManager()
+        : m_ExtraData(false), m_Clock(0), m_Bytes(0), m_Budget(INVENTORY_MEMORY_BUDGET), m_PruneAt(64)
+    {
+    }
+    /// Deconstructor
+    InventoryManager::~InventoryManager()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Read settings
+    void InventoryManager::Initialize()
+    {
+        m_Budget = static_cast<std::size_t>(sConfigManager->GetInt("InventoryMemoryBudget", INVENTORY_MEMORY_BUDGET));
+
+        LOG_INFO("Inventory", "Inventories are loaded on open, %0 bytes of pages are kept in memory", m_Budget);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Create inventory of user, nothing is loaded until it is opened
+    /// @p_UserId : Id of user
+    std::shared_ptr<UserInventory> InventoryManager::Create(uint32 p_UserId)
+    {
+        std::shared_ptr<UserInventory> l_Inventory = std::make_shared<UserInventory>(p_UserId);
+
+        std::lock_guard<std::mutex> l_Guard(m_Mutex);
+
+        /// Inventories of users gone are removed once the list doubled
+        if (m_Inventories.size() >= m_PruneAt)
+        {
+            m_Inventories.erase(std::remove_if(m_Inventories.begin(), m_Inventories.end(), [](std::weak_ptr<UserInventory> const& p_Inventory)
+            {
+                return p_Inventory.expired();
+            }), m_Inventories.end());
+
+            m_PruneAt = std::max<std::size_t>(64, m_Inventories.size() * 2);
+        }
+
+        m_Inventories.push_back(l_Inventory);
+        return l_Inventory;
+    }
+    /// Send page of inventory, loaded on a task worker if it is not in memory
+    /// @p_Inventory : Inventory
+    /// @p_Socket    : Socket to send page to
+    /// @p_Page      : Index of page
+    void InventoryManager::Open(std::shared_ptr<UserInventory> const& p_Inventory, std::shared_ptr<Server::GameSocket> const& p_Socket, uint32 p_Page)
+    {
+        Core::Network::SharedPacket l_Packet = p_Inventory->GetPage(p_Page);
+        if (l_Packet.GetBuffer())
+        {
+            p_Socket->Write(l_Packet);
+            return;
+        }
+
+        /// A loader already running picks the page up once it sent the one it is loading
+        if (!p_Inventory->RequestPage(p_Page))
+            return;
+
+        std::weak_ptr<Server::GameSocket> l_Socket = p_Socket;
+        sThreadManager->PushRunOnceTask(Core::Threading::TaskType::Normal, [this, p_Inventory, l_Socket, p_Page]()
+        {
+            Load(p_Inventory, l_Socket, p_Page);
+        });
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Load pages the user requested and send them, task worker only
+    /// @p_Inventory : Inventory
+    /// @p_Socket    : Socket to send pages to
+    /// @p_Page      : Index of first page
+    void InventoryManager::Load(std::shared_ptr<UserInventory> const& p_Inventory, std::weak_ptr<Server::GameSocket> const& p_Socket, uint32 p_Page)
+    {
+        uint32 l_Page = p_Page;
+
+        do
+        {
+            Core::Network::SharedPacket l_Packet = p_Inventory->LoadPage(l_Page);
+            if (l_Packet.GetBuffer())
+                if (std::shared_ptr<Server::GameSocket> l_Socket = p_Socket.lock())
+                    l_Socket->Write(l_Packet);
+
+            Trim();
+        } while (p_Inventory->TakeRequest(l_Page));
+    }
+    /// Evict least recently used pages of every inventory while over budget
+    void InventoryManager::Trim()
+    {
+        if (GetBytes() <= m_Budget)
+            return;
+
+        /// Another worker is trimming already
+        std::unique_lock<std::mutex> l_TrimGuard(m_TrimMutex, std::try_to_lock);
+        if (!l_TrimGuard.owns_lock())
+            return;
+
+        std::vector<std::shared_ptr<UserInventory>> l_Inventories;
+        {
+            std::lock_guard<std::mutex> l_Guard(m_Mutex);
+
+            l_Inventories.reserve(m_Inventories.size());
+            for (std::weak_ptr<UserInventory> const& l_Inventory : m_Inventories)
+                if (std::shared_ptr<UserInventory> l_Alive = l_Inventory.lock())
+                    l_Inventories.push_back(std::move(l_Alive));
+        }
+
+        /// Inventories are locked one at a time, a page used after being collected keeps its memory
+        std::vector<InventoryPageUse> l_Pages;
+        for (uint32 l_I = 0; l_I < l_Inventories.size(); l_I++)
+            l_Inventories[l_I]->CollectPages(l_I, l_Pages);
+
+        std::sort(l_Pages.begin(), l_Pages.end(), [](InventoryPageUse const& p_Left, InventoryPageUse const& p_Right)
+        {
+            return p_Left.LastUse < p_Right.LastUse;
+        });
+
+        /// Evict below the budget so the next loads do not trim again straight away
+        const std::size_t l_Target = m_Budget / 100 * INVENTORY_TRIM_TARGET;
+
+        uint32 l_Evicted = 0;
+        for (InventoryPageUse const& l_Page : l_Pages)
+        {
+            if (GetBytes() <= l_Target)
+                break;
+
+            l_Inventories[l_Page.Inventory]->Evict(l_Page.Page, l_Page.LastUse);
+            l_Evicted++;
+        }
+
+        LOG_VERBOSE("Inventory", "Evicted %0 inventory pages, %1 bytes of pages loaded", l_Evicted, GetBytes());
+    }
+
+}   ///< namespace Inventory
+}   ///< namespace Game
+}   ///< namespace Steerstone
@@ -0,0 +1,99 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+#include "Singleton/Singleton.hpp"
+#include "Utility/UtiSymbolTable.hpp"
+#include "UserInventory.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#define INVENTORY_MEMORY_BUDGET     (64 * 1024 * 1024)  ///< Default memory of loaded inventory pages of every user
+#define INVENTORY_TRIM_TARGET       90                  ///< Percent of the budget a trim evicts down to
+
+namespace SteerStone { namespace Game {
+
+    namespace Server { class GameSocket; }
+
+namespace Inventory {
+
+    /// Owns the memory budget shared by the inventories of every user
+    /// Inventories are loaded on task workers, never on a network thread nor during login. Once loaded pages
+    /// go over budget the least recently used pages of any user are evicted until usage is back under the trim target
+    class InventoryManager
+    {
+        SINGLETON_P_D(InventoryManager);
+
+        public:
+            /// Read settings
+            void Initialize();
+
+            /// Create inventory of user, nothing is loaded until it is opened
+            /// @p_UserId : Id of user
+            std::shared_ptr<UserInventory> Create(uint32 p_UserId);
+            /// Send page of inventory, loaded on a task worker if it is not in memory
+            /// @p_Inventory : Inventory
+            /// @p_Socket    : Socket to send page to
+            /// @p_Page      : Index of page
+            void Open(std::shared_ptr<UserInventory> const& p_Inventory, std::shared_ptr<Server::GameSocket> const& p_Socket, uint32 p_Page);
+
+            /// Get table extra data of items is interned in, item states repeat a lot across hands
+            Core::Utils::SymbolTable& GetExtraData() { return m_ExtraData; }
+            /// Get stamp of an access, later accesses get higher stamps
+            uint64 NextStamp() { return m_Clock.fetch_add(1, std::memory_order_relaxed) + 1; }
+            /// Account memory of loaded pages
+            /// @p_Bytes : Bytes
+            void OnPageLoaded(std::size_t p_Bytes) { m_Bytes.fetch_add(p_Bytes, std::memory_order_relaxed); }
+            /// Account memory of dropped pages
+            /// @p_Bytes : Bytes
+            void OnPageDropped(std::size_t p_Bytes) { m_Bytes.fetch_sub(p_Bytes, std::memory_order_relaxed); }
+            /// Get memory of loaded pages
+            std::size_t GetBytes() const { return m_Bytes.load(std::memory_order_relaxed); }
+
+        private:
+            /// Load pages the user requested and send them, task worker only
+            /// @p_Inventory : Inventory
+            /// @p_Socket    : Socket to send pages to
+            /// @p_Page      : Index of first page
+            void Load(std::shared_ptr<UserInventory> const& p_Inventory, std::weak_ptr<Server::GameSocket> const& p_Socket, uint32 p_Page);
+            /// Evict least recently used pages of every inventory while over budget
+            void Trim();
+
+        private:
+            Core::Utils::SymbolTable m_ExtraData;                       ///< Extra data of items
+            std::atomic<uint64> m_Clock;                                ///< Stamp of last access
+            std::atomic<std::size_t> m_Bytes;                           ///< Memory of loaded pages
+            std::size_t m_Budget;                                       ///< Memory loaded pages may use
+            std::mutex m_Mutex;                                         ///< Guards inventories
+            std::vector<std::weak_ptr<UserInventory>> m_Inventories;    ///< Inventories of online users
+            std::size_t m_PruneAt;                                      ///< Inventories held before gone ones are removed
+            std::mutex m_TrimMutex;                                     ///< One trim at a time
+    };
+
+}   ///< namespace Inventory
+}   ///< namespace Game
+}   ///< namespace Steerstone
+
+#define sInventoryManager SteerStone::Game::Inventory::InventoryManager::GetSingleton()
@@ -0,0 +1,278 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "UserInventory.hpp"
+#include "InventoryManager.hpp"
+#include "Database/DatabaseTypes.hpp"
+#include "Database/GameStatements.hpp"
+#include "Database/PreparedResultCursor.hpp"
+#include "Server/ServerMessage.hpp"
+
+#include <algorithm>
+
+namespace SteerStone { namespace Game { namespace Inventory {
+
+    /// Constructor
+    /// @p_UserId : Id of user
+    UserInventory::UserInventory(uint32 p_UserId)
+        : m_UserId(p_UserId), m_PageStarts(1, 0), m_Complete(false), m_LoadedCount(0), m_Bytes(0),
+        m_RequestedPage(0), m_LoadPending(false)
+    {
+    }
+    /// Deconstructor, returns the memory of loaded pages to the inventory manager
+    UserInventory::~UserInventory()
+    {
+        if (m_Bytes)
+            sInventoryManager->OnPageDropped(m_Bytes);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Serialize page if it is loaded, empty otherwise
+    /// @p_Page : Index of page
+    Core::Network::SharedPacket UserInventory::GetPage(uint32 p_Page)
+    {
+        std::lock_guard<std::mutex> l_Guard(m_Mutex);
+
+        if (p_Page < m_Pages.size() && m_Pages[p_Page].LastUse)
+        {
+            m_Pages[p_Page].LastUse = sInventoryManager->NextStamp();
+            return Serialize(p_Page);
+        }
+
+        /// Known not to exist, answered without reading anything
+        if (m_Complete && p_Page >= m_PageStarts.size())
+            return Serialize(p_Page);
+
+        return Core::Network::SharedPacket();
+    }
+    /// Serialize page, streaming it from the database if it is not loaded, blocks on the database
+    /// @p_Page : Index of page
+    Core::Network::SharedPacket UserInventory::LoadPage(uint32 p_Page)
+    {
+        std::lock_guard<std::mutex> l_Guard(m_Mutex);
+
+        if (p_Page < m_Pages.size() && m_Pages[p_Page].LastUse)
+        {
+            m_Pages[p_Page].LastUse = sInventoryManager->NextStamp();
+            return Serialize(p_Page);
+        }
+
+        if ((p_Page < m_PageStarts.size() || !m_Complete) && !Stream(p_Page))
+            return Core::Network::SharedPacket();
+
+        return Serialize(p_Page);
+    }
+    /// Drop loaded pages, they are loaded again when next opened
+    void UserInventory::Invalidate()
+    {
+        std::lock_guard<std::mutex> l_Guard(m_Mutex);
+
+        for (uint32 l_I = 0; l_I < m_Pages.size(); l_I++)
+            if (m_Pages[l_I].LastUse)
+                Drop(l_I);
+
+        /// Items may have been added or removed anywhere, every boundary is stale
+        m_PageStarts.assign(1, 0);
+        m_Complete = false;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Add loaded pages to eviction candidates
+    /// @p_Inventory : Index of inventory in the collecting list
+    /// @p_Pages     : Candidates
+    void UserInventory::CollectPages(uint32 p_Inventory, std::vector<InventoryPageUse>& p_Pages)
+    {
+        std::lock_guard<std::mutex> l_Guard(m_Mutex);
+
+        for (uint32 l_I = 0; l_I < m_Pages.size(); l_I++)
+            if (m_Pages[l_I].LastUse)
+                p_Pages.push_back({ m_Pages[l_I].LastUse, p_Inventory, l_I });
+    }
+    /// Evict page if it has not been used since collected
+    /// @p_Page    : Index of page
+    /// @p_LastUse : Stamp of last access when collected
+    void UserInventory::Evict(uint32 p_Page, uint64 p_LastUse)
+    {
+        std::lock_guard<std::mutex> l_Guard(m_Mutex);
+
+        if (p_Page < m_Pages.size() && m_Pages[p_Page].LastUse == p_LastUse)
+            Drop(p_Page);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Request page for the loader, returns true if no loader is running and one must be started
+    /// @p_Page : Index of page
+    bool UserInventory::RequestPage(uint32 p_Page)
+    {
+        m_RequestedPage.store(p_Page, std::memory_order_release);
+        return !m_LoadPending.exchange(true, std::memory_order_acq_rel);
+    }
+    /// Take requested page once the loader sent the previous one
+    /// @p_Page : Page sent, set to the page requested meanwhile
+    /// Returns false once no other page has been requested
+    bool UserInventory::TakeRequest(uint32& p_Page)
+    {
+        m_LoadPending.store(false, std::memory_order_release);
+
+        /// A request made after this point starts its own loader
+        const uint32 l_Requested = m_RequestedPage.load(std::memory_order_acquire);
+        if (l_Requested == p_Page || m_LoadPending.exchange(true, std::memory_order_acq_rel))
+            return false;
+
+        p_Page = l_Requested;
+        return true;
+    }
+    /// Stream page and the ones before it since the last known boundary, caller holds the lock
+    /// @p_Page : Index of page
+    bool UserInventory::Stream(uint32 p_Page)
+    {
+        /// Pages between the closest known boundary and ours are read for their boundaries only,
+        /// one row past our page tells whether another page follows
+        const uint32 l_From  = std::min<uint32>(p_Page, static_cast<uint32>(m_PageStarts.size() - 1));
+        const uint32 l_Limit = (p_Page - l_From + 1) * INVENTORY_PAGE_SIZE + 1;
+
+        Core::Database::PreparedStatement* l_Statement = GameDatabase.GetPrepareStatement(GAME_SEL_INVENTORY_ITEMS);
+        if (!l_Statement)
+            return false;
+
+        l_Statement->SetUint32(0, m_UserId);
+        l_Statement->SetUint32(1, m_PageStarts[l_From]);
+        l_Statement->SetUint32(2, l_Limit);
+
+        /// Rows are streamed, only the items of our page are kept
+        std::unique_ptr<Core::Database::PreparedResultCursor> l_Cursor = l_Statement->ExecuteCursor();
+        if (!l_Cursor)
+        {
+            LOG_ERROR("Inventory", "Failed to load page %0 of inventory of user %1", p_Page, m_UserId);
+            return false;
+        }
+
+        Core::Utils::SymbolTable& l_ExtraData = sInventoryManager->GetExtraData();
+
+        std::vector<InventoryItem> l_Items;
+        uint32 l_Row    = 0;
+        uint32 l_LastId = m_PageStarts[l_From];
+
+        while (l_Cursor->Next())
+        {
+            const uint32 l_Id   = (*l_Cursor)[0].GetUInt32();
+            const uint32 l_Page = l_From + l_Row / INVENTORY_PAGE_SIZE;
+
+            /// First item of a page we did not know of, it starts after the last item of the page before
+            if (l_Row % INVENTORY_PAGE_SIZE == 0 && l_Page == m_PageStarts.size())
+                m_PageStarts.push_back(l_LastId);
+
+            if (l_Page == p_Page)
+            {
+                /// Control characters would end the string inside a server message
+                std::string l_State = (*l_Cursor)[2].GetString();
+                std::replace_if(l_State.begin(), l_State.end(), [](unsigned char p_Char) { return p_Char < 0x20; }, ' ');
+
+                l_Items.push_back({ l_Id, (*l_Cursor)[1].GetUInt32(), l_ExtraData.Intern(l_State) });
+            }
+
+            l_LastId = l_Id;
+            l_Row++;
+        }
+
+        /// Fewer rows than asked for, no item follows the last one read
+        if (l_Row < l_Limit)
+            m_Complete = true;
+
+        /// Page lies past the last item
+        if (p_Page >= m_PageStarts.size())
+            return true;
+
+        if (m_Pages.size() <= p_Page)
+            m_Pages.resize(p_Page + 1);
+
+        l_Items.shrink_to_fit();
+
+        const std::size_t l_Bytes = l_Items.capacity() * sizeof(InventoryItem);
+
+        m_Pages[p_Page].Items   = std::move(l_Items);
+        m_Pages[p_Page].LastUse = sInventoryManager->NextStamp();
+        m_LoadedCount++;
+        m_Bytes += l_Bytes;
+        sInventoryManager->OnPageLoaded(l_Bytes);
+
+        /// A user paging through a huge hand keeps a bounded amount of it in memory
+        if (m_LoadedCount > INVENTORY_MAX_PAGES)
+        {
+            uint32 l_Oldest = p_Page;
+            for (uint32 l_I = 0; l_I < m_Pages.size(); l_I++)
+                if (m_Pages[l_I].LastUse && m_Pages[l_I].LastUse < m_Pages[l_Oldest].LastUse)
+                    l_Oldest = l_I;
+
+            Drop(l_Oldest);
+        }
+
+        return true;
+    }
+    /// Drop page, caller holds the lock
+    /// @p_Page : Index of page
+    void UserInventory::Drop(uint32 p_Page)
+    {
+        Page& l_Page = m_Pages[p_Page];
+
+        const std::size_t l_Bytes = l_Page.Items.capacity() * sizeof(InventoryItem);
+
+        std::vector<InventoryItem>().swap(l_Page.Items);
+        l_Page.LastUse = 0;
+        m_LoadedCount--;
+        m_Bytes -= l_Bytes;
+        sInventoryManager->OnPageDropped(l_Bytes);
+    }
+    /// Serialize loaded page, caller holds the lock
+    /// @p_Page : Index of page
+    Core::Network::SharedPacket UserInventory::Serialize(uint32 p_Page) const
+    {
+        Server::ServerMessage l_Message(Server::SERVER_INVENTORY);
+        l_Message.AppendInt(static_cast<int32>(p_Page));
+        l_Message.AppendBool(p_Page + 1 < m_PageStarts.size());
+
+        if (p_Page >= m_Pages.size() || !m_Pages[p_Page].LastUse)
+        {
+            l_Message.AppendInt(0);
+            return l_Message.Finalize();
+        }
+
+        Core::Utils::SymbolTable const& l_ExtraData = sInventoryManager->GetExtraData();
+        std::vector<InventoryItem> const& l_Items = m_Pages[p_Page].Items;
+
+        l_Message.AppendInt(static_cast<int32>(l_Items.size()));
+        for (InventoryItem const& l_Item : l_Items)
+        {
+            l_Message.AppendInt(static_cast<int32>(l_Item.Id));
+            l_Message.AppendInt(static_cast<int32>(l_Item.DefinitionId));
+            l_Message.AppendString(l_ExtraData.GetString(l_Item.ExtraData));
+        }
+
+        return l_Message.Finalize();
+    }
+
+}   ///< namespace Inventory
+}   ///< namespace Game
+}   ///< namespace Steerstone
@@ -0,0 +1,134 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+#include "Network/SharedPacket.hpp"
+#include "Utility/UtiSymbolTable.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#define INVENTORY_PAGE_SIZE         250     ///< Items per inventory page
+#define INVENTORY_MAX_PAGES         16      ///< Pages of one user loaded at once, the least recently used is evicted first
+
+namespace SteerStone { namespace Game { namespace Inventory {
+
+    /// Item in the hand of a user, 12 bytes per item whatever its extra data
+    struct InventoryItem
+    {
+        uint32 Id;                          ///< Id of item
+        uint32 DefinitionId;                ///< Furniture definition
+        Core::Utils::Symbol ExtraData;      ///< State of item, interned in the extra data table of the inventory manager
+    };
+
+    /// Candidate page for eviction, collected by the inventory manager
+    struct InventoryPageUse
+    {
+        uint64 LastUse;                     ///< Stamp of last access
+        uint32 Inventory;                   ///< Index of inventory in the collecting list
+        uint32 Page;                        ///< Index of page
+    };
+
+    /// Hand of a user, nothing is loaded until the user opens it
+    /// Pages are streamed from the database with a cursor and paged by keyset: the id of the last item of every page
+    /// reached so far is kept, so an evicted page is loaded again on its own without reading the pages before it
+    class UserInventory
+    {
+        DISALLOW_COPY_AND_ASSIGN(UserInventory);
+
+        /// Allow access to page requests
+        friend class InventoryManager;
+
+        public:
+            /// Constructor
+            /// @p_UserId : Id of user
+            explicit UserInventory(uint32 p_UserId);
+            /// Deconstructor, returns the memory of loaded pages to the inventory manager
+            ~UserInventory();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Get id of user
+            uint32 GetUserId() const { return m_UserId; }
+
+            /// Serialize page if it is loaded, empty otherwise
+            /// @p_Page : Index of page
+            Core::Network::SharedPacket GetPage(uint32 p_Page);
+            /// Serialize page, streaming it from the database if it is not loaded, blocks on the database
+            /// @p_Page : Index of page
+            Core::Network::SharedPacket LoadPage(uint32 p_Page);
+            /// Drop loaded pages, they are loaded again when next opened
+            void Invalidate();
+
+            /// Add loaded pages to eviction candidates
+            /// @p_Inventory : Index of inventory in the collecting list
+            /// @p_Pages     : Candidates
+            void CollectPages(uint32 p_Inventory, std::vector<InventoryPageUse>& p_Pages);
+            /// Evict page if it has not been used since collected
+            /// @p_Page    : Index of page
+            /// @p_LastUse : Stamp of last access when collected
+            void Evict(uint32 p_Page, uint64 p_LastUse);
+
+        private:
+            /// Loaded page
+            struct Page
+            {
+                std::vector<InventoryItem> Items;   ///< Items, ordered by id
+                uint64 LastUse = 0;                 ///< Stamp of last access, 0 if not loaded
+            };
+
+            /// Request page for the loader, returns true if no loader is running and one must be started
+            /// @p_Page : Index of page
+            bool RequestPage(uint32 p_Page);
+            /// Take requested page once the loader sent the previous one
+            /// @p_Page : Page sent, set to the page requested meanwhile
+            /// Returns false once no other page has been requested
+            bool TakeRequest(uint32& p_Page);
+            /// Stream page and the ones before it since the last known boundary, caller holds the lock
+            /// @p_Page : Index of page
+            bool Stream(uint32 p_Page);
+            /// Drop page, caller holds the lock
+            /// @p_Page : Index of page
+            void Drop(uint32 p_Page);
+            /// Serialize loaded page, caller holds the lock
+            /// @p_Page : Index of page
+            Core::Network::SharedPacket Serialize(uint32 p_Page) const;
+
+        private:
+            uint32 m_UserId;                                ///< Id of user
+            std::mutex m_Mutex;                             ///< Guards pages, loads of one inventory run one at a time
+            std::vector<Page> m_Pages;                      ///< Pages, by index
+            std::vector<uint32> m_PageStarts;               ///< Id the items of a page follow, for every page known to exist
+            bool m_Complete;                                ///< Last page has been reached, no page exists after m_PageStarts
+            uint32 m_LoadedCount;                           ///< Pages loaded
+            std::size_t m_Bytes;                            ///< Memory of loaded pages
+
+            std::atomic<uint32> m_RequestedPage;            ///< Page the user opened last
+            std::atomic<bool> m_LoadPending;                ///< A loader is running for us
+    };
+
+}   ///< namespace Inventory
+}   ///< namespace Game
+}   ///< namespace Steerstone
@@ -0,0 +1,204 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "Pathfinder.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace SteerStone { namespace Game { namespace Map {
+
+    /// Offset and cost of the 8 neighbours of a tile, straight ones first
+    /// Diagonals name the two straight neighbours whose corner they would cut
+    struct PathDirection
+    {
+        int16 X;            ///< X offset
+        int16 Y;            ///< Y offset
+        uint32 Cost;        ///< Cost of step
+        uint8 SideA;        ///< Straight neighbour sharing the corner, diagonals only
+        uint8 SideB;        ///< Other straight neighbour sharing the corner, diagonals only
+    };
+
+    static constexpr PathDirection s_PathDirections[] =
+    {
+        {  0, -1, PATHFINDER_STRAIGHT_COST, 0, 0 }, {  1,  0, PATHFINDER_STRAIGHT_COST, 0, 0 }, {  0,  1, PATHFINDER_STRAIGHT_COST, 0, 0 }, { -1,  0, PATHFINDER_STRAIGHT_COST, 0, 0 },
+        {  1, -1, PATHFINDER_DIAGONAL_COST, 0, 1 }, {  1,  1, PATHFINDER_DIAGONAL_COST, 1, 2 }, { -1,  1, PATHFINDER_DIAGONAL_COST, 2, 3 }, { -1, -1, PATHFINDER_DIAGONAL_COST, 3, 0 }
+    };
+
+    /// Octile distance, exact on a grid without obstacles
+    /// @p_DeltaX : Tiles apart on X
+    /// @p_DeltaY : Tiles apart on Y
+    static inline uint32 GetHeuristic(uint32 p_DeltaX, uint32 p_DeltaY)
+    {
+        const uint32 l_Min = std::min(p_DeltaX, p_DeltaY);
+        const uint32 l_Max = std::max(p_DeltaX, p_DeltaY);
+        return PATHFINDER_STRAIGHT_COST * l_Max + (PATHFINDER_DIAGONAL_COST - PATHFINDER_STRAIGHT_COST) * l_Min;
+    }
+
+    /// Heap order, lowest estimate on top and the node closest to the goal first on ties
+    struct NodeOrder
+    {
+        template<typename t_Node> bool operator()(t_Node const& p_Left, t_Node const& p_Right) const
+        {
+            return p_Left.Estimate > p_Right.Estimate || (p_Left.Estimate == p_Right.Estimate && p_Left.Cost < p_Right.Cost);
+        }
+    };
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Find path walking one tile per step
+    /// Diagonals do not cut corners of tiles which can not be walked, like the client. Tiles with units are avoided
+    /// @p_Grid  : Grid of room
+    /// @p_Start : Index of tile walked from
+    /// @p_Goal  : Index of tile to walk to
+    /// @p_Path  : Output, tiles from the goal back to the first step so the next step is at the back
+    /// Returns false if goal can not be reached
+    bool Pathfinder::FindPath(RoomGrid const& p_Grid, uint32 p_Start, uint32 p_Goal, std::vector<uint32>& p_Path)
+    {
+        p_Path.clear();
+
+        if (p_Start >= p_Grid.GetSize() || p_Goal >= p_Grid.GetSize() || p_Start == p_Goal || !p_Grid.IsFree(p_Goal))
+            return false;
+
+        Workspace& l_Workspace = GetWorkspace(p_Grid.GetSize());
+        const uint32 l_Search = l_Workspace.Search;
+
+        const int16 l_GoalX = p_Grid.GetX(p_Goal);
+        const int16 l_GoalY = p_Grid.GetY(p_Goal);
+
+        l_Workspace.Open.clear();
+        l_Workspace.Cost[p_Start]  = 0;
+        l_Workspace.Stamp[p_Start] = l_Search;
+        const int16 l_StartX = p_Grid.GetX(p_Start);
+        const int16 l_StartY = p_Grid.GetY(p_Start);
+        l_Workspace.Open.push_back({ GetHeuristic(std::abs(l_StartX - l_GoalX), std::abs(l_StartY - l_GoalY)), 0, p_Start, l_StartX, l_StartY });
+
+        uint32 l_Expansions = 0;
+
+        while (!l_Workspace.Open.empty())
+        {
+            std::pop_heap(l_Workspace.Open.begin(), l_Workspace.Open.end(), NodeOrder());
+            const Node l_Node = l_Workspace.Open.back();
+            l_Workspace.Open.pop_back();
+
+            uint64& l_ClosedWord = l_Workspace.Closed[l_Node.Index >> 6];
+            const uint64 l_ClosedBit = uint64(1) << (l_Node.Index & 63);
+
+            if (l_ClosedWord & l_ClosedBit)
+                continue;
+
+            l_ClosedWord |= l_ClosedBit;
+
+            if (l_Node.Index == p_Goal)
+            {
+                for (uint32 l_Index = p_Goal; l_Index != p_Start; l_Index = l_Workspace.Parent[l_Index])
+                    p_Path.push_back(l_Index);
+
+                return true;
+            }
+
+            if (++l_Expansions > PATHFINDER_MAX_EXPANSIONS)
+                return false;
+
+            const int16 l_X = l_Node.X;
+            const int16 l_Y = l_Node.Y;
+
+            /// Straight neighbours come first, diagonals look up whether they cut one of their corners
+            bool l_SideWalkable[4] = {};
+
+            for (uint32 l_I = 0; l_I < 8; l_I++)
+            {
+                PathDirection const& l_Direction = s_PathDirections[l_I];
+
+                const int16 l_NextX = l_X + l_Direction.X;
+                const int16 l_NextY = l_Y + l_Direction.Y;
+
+                if (!p_Grid.IsValid(l_NextX, l_NextY))
+                    continue;
+
+                const uint32 l_Next = l_Node.Index + l_Direction.Y * p_Grid.GetWidth() + l_Direction.X;
+
+                if (l_I < 4)
+                    l_SideWalkable[l_I] = p_Grid.IsWalkable(l_Next);
+                else if (!l_SideWalkable[l_Direction.SideA] || !l_SideWalkable[l_Direction.SideB])
+                    continue;
+
+                if (!p_Grid.IsFree(l_Next) || !p_Grid.CanStep(l_Node.Index, l_Next)
+                    || (l_Workspace.Closed[l_Next >> 6] >> (l_Next & 63)) & 1)
+                    continue;
+
+                const uint32 l_Cost = l_Node.Cost + l_Direction.Cost;
+
+                if (l_Workspace.Stamp[l_Next] == l_Search && l_Workspace.Cost[l_Next] <= l_Cost)
+                    continue;
+
+                l_Workspace.Stamp[l_Next]  = l_Search;
+                l_Workspace.Cost[l_Next]   = l_Cost;
+                l_Workspace.Parent[l_Next] = l_Node.Index;
+
+                l_Workspace.Open.push_back({ l_Cost + GetHeuristic(std::abs(l_NextX - l_GoalX), std::abs(l_NextY - l_GoalY)), l_Cost, l_Next, l_NextX, l_NextY });
+                std::push_heap(l_Workspace.Open.begin(), l_Workspace.Open.end(), NodeOrder());
+            }
+        }
+
+        return false;
+    }
+    /// Run searches of a batch back to back, the grid and the workspace stay in cache between them
+    /// @p_Grid     : Grid of room
+    /// @p_Requests : Searches
+    void Pathfinder::FindPaths(RoomGrid const& p_Grid, std::vector<Request>& p_Requests)
+    {
+        for (Request& l_Request : p_Requests)
+            l_Request.Found = FindPath(p_Grid, l_Request.Start, l_Request.Goal, *l_Request.Path);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get workspace of calling thread, sized for grid
+    /// @p_Size : Amount of tiles
+    Pathfinder::Workspace& Pathfinder::GetWorkspace(uint32 p_Size)
+    {
+        static thread_local Workspace tl_Workspace = { {}, {}, {}, {}, {}, 0 };
+
+        if (tl_Workspace.Stamp.size() < p_Size)
+        {
+            tl_Workspace.Cost.resize(p_Size);
+            tl_Workspace.Parent.resize(p_Size);
+            tl_Workspace.Stamp.assign(p_Size, 0);
+            tl_Workspace.Open.reserve(p_Size);
+            tl_Workspace.Search = 0;
+        }
+
+        /// Stamps make costs of earlier searches stale without clearing them, they are only cleared on wrap around
+        if (++tl_Workspace.Search == 0)
+        {
+            std::fill(tl_Workspace.Stamp.begin(), tl_Workspace.Stamp.end(), 0);
+            tl_Workspace.Search = 1;
+        }
+
+        tl_Workspace.Closed.assign((p_Size + 63) / 64, 0);
+
+        return tl_Workspace;
+    }
+
+}   ///< namespace Map
+}   ///< namespace Game
+}   ///< namespace Steerstone
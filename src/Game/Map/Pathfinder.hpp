@@ -0,0 +1,92 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+#include "RoomGrid.hpp"
+
+#include <vector>
+
+#define PATHFINDER_STRAIGHT_COST    10          ///< Cost of a straight step
+#define PATHFINDER_DIAGONAL_COST    14          ///< Cost of a diagonal step
+#define PATHFINDER_MAX_EXPANSIONS   16384       ///< Tiles a search may close before it gives up
+
+namespace SteerStone { namespace Game { namespace Map {
+
+    /// A* search over a room grid
+    /// Open heap, costs and closed bitmap live in a workspace of the calling thread and are reused, a search allocates nothing
+    /// once the workspace has grown to the largest room searched on that thread
+    class Pathfinder
+    {
+        public:
+            /// Path search queued in a batch
+            struct Request
+            {
+                uint32 Start;                       ///< Index of tile walked from
+                uint32 Goal;                        ///< Index of tile to walk to
+                std::vector<uint32>* Path;          ///< Output, same order as FindPath
+                bool Found;                         ///< Output, goal can be reached
+            };
+
+        public:
+            /// Find path walking one tile per step
+            /// Diagonals do not cut corners of tiles which can not be walked, like the client. Tiles with units are avoided
+            /// @p_Grid  : Grid of room
+            /// @p_Start : Index of tile walked from
+            /// @p_Goal  : Index of tile to walk to
+            /// @p_Path  : Output, tiles from the goal back to the first step so the next step is at the back
+            /// Returns false if goal can not be reached
+            static bool FindPath(RoomGrid const& p_Grid, uint32 p_Start, uint32 p_Goal, std::vector<uint32>& p_Path);
+            /// Run searches of a batch back to back, the grid and the workspace stay in cache between them
+            /// @p_Grid     : Grid of room
+            /// @p_Requests : Searches
+            static void FindPaths(RoomGrid const& p_Grid, std::vector<Request>& p_Requests);
+
+        private:
+            /// Open heap entry, stale entries are skipped once their tile is closed
+            struct Node
+            {
+                uint32 Estimate;                    ///< Cost so far plus heuristic
+                uint32 Cost;                        ///< Cost so far
+                uint32 Index;                       ///< Index of tile
+                int16 X;                            ///< X of tile
+                int16 Y;                            ///< Y of tile
+            };
+
+            /// Search state of a thread
+            struct Workspace
+            {
+                std::vector<Node> Open;             ///< Binary min heap on estimate
+                std::vector<uint32> Cost;           ///< Best cost of every tile, valid if stamped by this search
+                std::vector<uint32> Parent;         ///< Tile every tile was reached from
+                std::vector<uint32> Stamp;          ///< Search which last touched every tile
+                std::vector<uint64> Closed;         ///< Tiles expanded by this search, one bit each
+                uint32 Search;                      ///< Current search
+            };
+
+            /// Get workspace of calling thread, sized for grid
+            /// @p_Size : Amount of tiles
+            static Workspace& GetWorkspace(uint32 p_Size);
+    };
+
+}   ///< namespace Map
+}   ///< namespace Game
+}   ///< namespace Steerstone
@@ -0,0 +1,454 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "Room.hpp"
+#include "RoomManager.hpp"
+#include "Navigator/NavigatorManager.hpp"
+#include "Server/Socket.hpp"
+#include "Diagnostic/DiaServerWatch.hpp"
+
+#include <algorithm>
+
+namespace SteerStone { namespace Game { namespace Map {
+
+    /// Room whose strand is running on this thread
+    static thread_local Room* tl_CurrentRoom = nullptr;
+
+    /// Get room whose strand is running on the calling thread, nullptr if none
+    Room* Room::GetCurrent()
+    {
+        return tl_CurrentRoom;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    /// @p_Id            : Id of room
+    /// @p_Model         : Floor of room
+    /// @p_UnloadTimeout : MS the room may stay empty before it unloads
+    Room::Room(uint32 p_Id, std::shared_ptr<RoomModel const> const& p_Model, uint32 p_UnloadTimeout)
+        : m_Id(p_Id), m_Model(p_Model), m_Strand(Core::Threading::Strand::Create()), m_UserCount(0), m_NextUnitId(1),
+        m_EmptySince(sServerTimeManager->GetServerTime()), m_UnloadTimeout(p_UnloadTimeout), m_TickPending(false), m_Unloaded(false), m_Reservations(0), m_Grid(*p_Model), m_Items(*p_Model), m_Wired(m_EmptySince)
+    {
+        m_HeightmapPayload = BuildHeightmapPayload();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Run message on our strand, safe from any thread
+    /// @p_Function : Message
+    void Room::Post(std::function<void()> p_Function)
+    {
+        m_Strand->Post([l_Room = shared_from_this(), l_Function = std::move(p_Function)]()
+        {
+            Room* l_Previous = tl_CurrentRoom;
+            tl_CurrentRoom = l_Room.get();
+            l_Function();
+            tl_CurrentRoom = l_Previous;
+        });
+    }
+    /// Post a tick to our strand, called by the world updater
+    /// @p_Diff : Time since last update in MS
+    /// Returns false once unloaded
+    bool Room::Update(uint32 const p_Diff)
+    {
+        if (IsUnloaded())
+            return false;
+
+        /// A room which is behind skips ticks rather than queueing them up
+        if (!m_TickPending.exchange(true, std::memory_order_acq_rel))
+            Post([this]() { Tick(); });
+
+        return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Add avatar at the door, it gets the status of every unit already in the room
+    /// @p_Socket : Socket of avatar
+    void Room::AddUser(std::shared_ptr<Server::GameSocket> const& p_Socket)
+    {
+        sRoomManager->ReleaseReservation(this);
+
+        if (p_Socket->IsClosed() || FindUser(p_Socket.get()) != m_Units.end())
+            return;
+
+        SendEntryPayloads(*p_Socket);
+
+        /// Snapshot of everyone already here, our own status goes out with the next tick
+        if (!m_Units.empty())
+        {
+            m_StatusBuffer.clear();
+            for (Entity::RoomUnit const& l_Unit : m_Units)
+                l_Unit.WriteStatus(m_StatusBuffer);
+
+            Server::ServerMessage l_Snapshot(Server::SERVER_USER_STATUS);
+            l_Snapshot.AppendRaw(m_StatusBuffer);
+            p_Socket->Send(l_Snapshot);
+        }
+
+        const uint32 l_Door = m_Grid.GetIndex(m_Model->GetDoorX(), m_Model->GetDoorY());
+
+        m_Units.emplace_back(m_NextUnitId++, p_Socket, m_Grid.GetX(l_Door), m_Grid.GetY(l_Door), m_Grid.GetStandHeight(l_Door));
+        m_Grid.AddOccupant(l_Door);
+        m_Users.Add(p_Socket);
+        m_UserCount++;
+
+        sNavigatorManager->OnUserEnter(m_Id);
+    }
+    /// Remove avatar
+    /// @p_Socket : Socket of avatar
+    void Room::RemoveUser(Server::GameSocket const* p_Socket)
+    {
+        auto l_Itr = FindUser(p_Socket);
+        if (l_Itr != m_Units.end())
+            RemoveUnit(l_Itr);
+    }
+    /// Make avatar walk to tile
+    /// @p_Socket : Socket of avatar
+    /// @p_X      : X of tile
+    /// @p_Y      : Y of tile
+    void Room::MoveUser(Server::GameSocket const* p_Socket, int16 p_X, int16 p_Y)
+    {
+        if (!m_Grid.IsValid(p_X, p_Y) || !m_Grid.IsWalkable(m_Grid.GetIndex(p_X, p_Y)))
+            return;
+
+        auto l_Itr = FindUser(p_Socket);
+        if (l_Itr != m_Units.end())
+            l_Itr->SetGoal(p_X, p_Y);
+    }
+    /// Make unit walk to tile
+    /// @p_UnitId : Id of unit
+    /// @p_X      : X of tile
+    /// @p_Y      : Y of tile
+    void Room::MoveUnit(uint32 p_UnitId, int16 p_X, int16 p_Y)
+    {
+        if (!m_Grid.IsValid(p_X, p_Y) || !m_Grid.IsWalkable(m_Grid.GetIndex(p_X, p_Y)))
+            return;
+
+        auto l_Itr = std::find_if(m_Units.begin(), m_Units.end(), [p_UnitId](Entity::RoomUnit const& p_Unit) { return p_Unit.GetId() == p_UnitId; });
+        if (l_Itr != m_Units.end())
+            l_Itr->SetGoal(p_X, p_Y);
+    }
+    /// Avatar said something, chat triggers listen to it
+    /// @p_Socket  : Socket of avatar
+    /// @p_Message : Message
+    void Room::OnUserChat(Server::GameSocket const* p_Socket, std::string_view p_Message)
+    {
+        auto l_Itr = FindUser(p_Socket);
+        if (l_Itr != m_Units.end())
+            m_Wired.OnChat(p_Message, l_Itr->GetId());
+    }
+    /// Add bot at the door
+    /// @p_Behaviour : What the bot does
+    /// @p_Owner     : Socket of avatar a following bot follows, nullptr if none
+    void Room::AddBot(BotBehaviour p_Behaviour, Server::GameSocket const* p_Owner)
+    {
+        const uint32 l_Door = m_Grid.GetIndex(m_Model->GetDoorX(), m_Model->GetDoorY());
+
+        auto l_Owner = p_Owner ? FindUser(p_Owner) : m_Units.end();
+        const uint32 l_OwnerIndex = l_Owner != m_Units.end() ? static_cast<uint32>(l_Owner - m_Units.begin()) : ROOM_BOT_NO_OWNER;
+
+        m_Bots.Add(static_cast<uint32>(m_Units.size()), p_Behaviour, l_OwnerIndex, sServerTimeManager->GetServerTime());
+
+        m_Units.emplace_back(m_NextUnitId++, nullptr, m_Grid.GetX(l_Door), m_Grid.GetY(l_Door), m_Grid.GetStandHeight(l_Door));
+        m_Grid.AddOccupant(l_Door);
+    }
+
+    /// Place floor item, on top of the stack already on its tiles
+    /// @p_Item : Item
+    bool Room::PlaceItem(RoomItem const& p_Item)
+    {
+        if (!p_Item.IsWalkable() && !IsFootprintEmpty(p_Item.X, p_Item.Y, p_Item.GetFootprintWidth(), p_Item.GetFootprintLength()))
+            return false;
+
+        const TileIndex::Handle l_Handle = m_Items.Place(p_Item);
+        if (l_Handle == TILE_INDEX_INVALID_HANDLE)
+            return false;
+
+        SyncFootprint(*m_Items.Get(l_Handle));
+        return true;
+    }
+    /// Move or rotate floor item
+    /// @p_Id       : Id of item
+    /// @p_X        : X of tile the footprint starts on
+    /// @p_Y        : Y of tile the footprint starts on
+    /// @p_Rotation : Rotation
+    bool Room::MoveItem(uint32 p_Id, int16 p_X, int16 p_Y, uint8 p_Rotation)
+    {
+        const TileIndex::Handle l_Handle = m_Items.Find(p_Id);
+        if (l_Handle == TILE_INDEX_INVALID_HANDLE)
+            return false;
+
+        const RoomItem l_Previous = *m_Items.Get(l_Handle);
+
+        RoomItem l_Moved = l_Previous;
+        l_Moved.X        = p_X;
+        l_Moved.Y        = p_Y;
+        l_Moved.Rotation = p_Rotation;
+
+        if (!l_Moved.IsWalkable() && !IsFootprintEmpty(l_Moved.X, l_Moved.Y, l_Moved.GetFootprintWidth(), l_Moved.GetFootprintLength()))
+            return false;
+
+        if (!m_Items.Move(l_Handle, p_X, p_Y, p_Rotation))
+            return false;
+
+        SyncFootprint(l_Previous);
+        SyncFootprint(*m_Items.Get(l_Handle));
+        return true;
+    }
+    /// Pick up floor item
+    /// @p_Id : Id of item
+    void Room::PickupItem(uint32 p_Id)
+    {
+        const TileIndex::Handle l_Handle = m_Items.Find(p_Id);
+        if (l_Handle == TILE_INDEX_INVALID_HANDLE)
+            return;
+
+        const RoomItem l_Item = *m_Items.Get(l_Handle);
+        m_Items.Remove(l_Handle);
+        SyncFootprint(l_Item);
+
+        m_Wired.Remove(p_Id);
+    }
+    /// Change state of floor item, state change triggers watching it run
+    /// @p_Id     : Id of item
+    /// @p_State  : State
+    /// @p_UnitId : Id of unit which caused it, 0 if none
+    void Room::SetItemState(uint32 p_Id, uint8 p_State, uint32 p_UnitId)
+    {
+        if (m_Items.SetState(m_Items.Find(p_Id), p_State))
+            m_Wired.OnStateChange(p_Id, p_UnitId);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Advance walking units, send batched statuses and unload once empty for long enough, strand only
+    void Room::Tick()
+    {
+        m_TickPending.store(false, std::memory_order_release);
+
+        /// Sockets do not tell us when they close, drop their avatars on the next tick
+        for (std::size_t l_I = 0; l_I < m_Units.size();)
+        {
+            if (!m_Units[l_I].IsBot() && m_Units[l_I].GetSocket()->IsClosed())
+                RemoveUnit(m_Units.begin() + l_I);
+            else
+                l_I++;
+        }
+
+        const uint32 l_Now = sServerTimeManager->GetServerTime();
+
+        if (m_UserCount == 0)
+        {
+            if (sServerTimeManager->GetTimeDifference(m_EmptySince, l_Now) >= m_UnloadTimeout)
+                sRoomManager->TryUnload(this);
+
+            return;
+        }
+
+        m_EmptySince = l_Now;
+
+        m_Bots.Update(m_Units, m_Grid, l_Now);
+
+        /// Stacks triggered on the previous tick run before units step, bounded so wired can not hold the strand
+        m_Wired.Update(*this, l_Now);
+
+        /// Every status which changed on this tick goes out in one message, serialized once for all users
+        m_StatusBuffer.clear();
+        for (Entity::RoomUnit& l_Unit : m_Units)
+        {
+            if (l_Unit.IsWalking())
+            {
+                const int16 l_X = l_Unit.GetX();
+                const int16 l_Y = l_Unit.GetY();
+
+                l_Unit.Step(m_Grid);
+
+                if (l_X != l_Unit.GetX() || l_Y != l_Unit.GetY())
+                {
+                    m_Wired.OnWalkOff(m_Items, l_X, l_Y, l_Unit.GetId());
+                    m_Wired.OnWalkOn(m_Items, l_Unit.GetX(), l_Unit.GetY(), l_Unit.GetId());
+                }
+            }
+
+            if (l_Unit.IsDirty())
+                l_Unit.FlushStatus(m_StatusBuffer);
+        }
+
+        if (m_StatusBuffer.empty())
+            return;
+
+        Server::ServerMessage l_Status(Server::SERVER_USER_STATUS);
+        l_Status.AppendRaw(m_StatusBuffer);
+        m_Users.Broadcast(l_Status.Finalize());
+    }
+    /// Find unit of avatar
+    /// @p_Socket : Socket of avatar
+    std::vector<Entity::RoomUnit>::iterator Room::FindUser(Server::GameSocket const* p_Socket)
+    {
+        return std::find_if(m_Units.begin(), m_Units.end(), [p_Socket](Entity::RoomUnit const& p_Unit) { return p_Unit.GetSocket().get() == p_Socket; });
+    }
+    /// Check no unit stands on footprint
+    /// @p_X      : X of tile the footprint starts on
+    /// @p_Y      : Y of tile the footprint starts on
+    /// @p_Width  : Tiles covered on X
+    /// @p_Length : Tiles covered on Y
+    bool Room::IsFootprintEmpty(int16 p_X, int16 p_Y, uint8 p_Width, uint8 p_Length) const
+    {
+        for (int16 l_Y = p_Y; l_Y < p_Y + p_Length; l_Y++)
+        {
+            for (int16 l_X = p_X; l_X < p_X + p_Width; l_X++)
+            {
+                if (m_Grid.IsValid(l_X, l_Y) && m_Grid.IsOccupied(m_Grid.GetIndex(l_X, l_Y)))
+                    return false;
+            }
+        }
+
+        return true;
+    }
+    /// Copy stack height and blocking state of footprint tiles to the walkability grid
+    /// @p_Item : Item whose footprint changed
+    void Room::SyncFootprint(RoomItem const& p_Item)
+    {
+        for (int16 l_Y = p_Item.Y; l_Y < p_Item.Y + p_Item.GetFootprintLength(); l_Y++)
+        {
+            for (int16 l_X = p_Item.X; l_X < p_Item.X + p_Item.GetFootprintWidth(); l_X++)
+            {
+                if (!m_Grid.IsValid(l_X, l_Y))
+                    continue;
+
+                const int32 l_Stack = m_Items.GetStackHeight(l_X, l_Y) - m_Grid.GetFloorHeight(m_Grid.GetIndex(l_X, l_Y));
+                m_Grid.SetFurni(l_X, l_Y, static_cast<uint16>(std::max(l_Stack, 0)), m_Items.IsBlocking(l_X, l_Y));
+            }
+        }
+    }
+    /// Remove unit, releases the tiles it stands on
+    /// @p_Itr : Unit
+    void Room::RemoveUnit(std::vector<Entity::RoomUnit>::iterator p_Itr)
+    {
+        m_Grid.RemoveOccupant(m_Grid.GetIndex(p_Itr->GetX(), p_Itr->GetY()));
+        if (p_Itr->IsWalkingOntoNext())
+            m_Grid.RemoveOccupant(m_Grid.GetIndex(p_Itr->GetNextX(), p_Itr->GetNextY()));
+
+        if (!p_Itr->IsBot())
+        {
+            m_Users.Remove(p_Itr->GetSocket().get());
+            m_UserCount--;
+
+            sNavigatorManager->OnUserLeave(m_Id);
+        }
+
+        Server::ServerMessage l_Remove(Server::SERVER_USER_REMOVE);
+        l_Remove.AppendRaw(std::to_string(p_Itr->GetId()));
+        m_Users.Broadcast(l_Remove.Finalize());
+
+        /// Order of units does not matter, swap with the last one
+        const uint32 l_Index = static_cast<uint32>(p_Itr - m_Units.begin());
+        const uint32 l_Last  = static_cast<uint32>(m_Units.size() - 1);
+
+        m_Bots.OnUnitRemoved(l_Index);
+
+        if (l_Index != l_Last)
+        {
+            *p_Itr = std::move(m_Units.back());
+            m_Bots.OnUnitMoved(l_Last, l_Index);
+        }
+        m_Units.pop_back();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Serialize floor of room, sent to every avatar entering
+    Core::Network::SharedPacket Room::BuildHeightmapPayload() const
+    {
+        std::string l_Heightmap;
+        l_Heightmap.reserve(static_cast<std::size_t>(m_Model->GetWidth() + 1) * m_Model->GetHeight());
+
+        for (int16 l_Y = 0; l_Y < m_Model->GetHeight(); l_Y++)
+        {
+            for (int16 l_X = 0; l_X < m_Model->GetWidth(); l_X++)
+            {
+                const int8 l_Height = m_Model->GetTileHeight(l_X, l_Y);
+                l_Heightmap.push_back(l_Height == ROOM_MODEL_BLOCKED ? 'x' : static_cast<char>('0' + l_Height));
+            }
+
+            l_Heightmap.push_back('\r');
+        }
+
+        Server::ServerMessage l_Message(Server::SERVER_HEIGHTMAP);
+        l_Message.AppendRaw(l_Heightmap);
+        return l_Message.Finalize();
+    }
+    /// Serialize floor items of a segment of the tile index, empty if the segment holds none
+    /// @p_Segment : Segment
+    Core::Network::SharedPacket Room::BuildItemPayload(uint32 p_Segment) const
+    {
+        uint32 l_Count = 0;
+        m_Items.ForEachInSegment(p_Segment, [&l_Count](TileIndex::Handle, RoomItem const&) { l_Count++; });
+
+        if (l_Count == 0)
+            return Core::Network::SharedPacket();
+
+        Server::ServerMessage l_Message(Server::SERVER_FLOOR_ITEMS);
+        l_Message.AppendInt(static_cast<int32>(l_Count));
+
+        m_Items.ForEachInSegment(p_Segment, [&l_Message](TileIndex::Handle, RoomItem const& p_Item)
+        {
+            l_Message.AppendInt(static_cast<int32>(p_Item.Id));
+            l_Message.AppendInt(p_Item.X);
+            l_Message.AppendInt(p_Item.Y);
+            l_Message.AppendInt(p_Item.Z);
+            l_Message.AppendInt(p_Item.Rotation);
+            l_Message.AppendInt(p_Item.Width);
+            l_Message.AppendInt(p_Item.Length);
+            l_Message.AppendInt(p_Item.State);
+        });
+
+        return l_Message.Finalize();
+    }
+    /// Send floor and floor items to an entering avatar, segments changed since the last entry are serialized again
+    /// @p_Socket : Socket of avatar
+    void Room::SendEntryPayloads(Server::GameSocket& p_Socket)
+    {
+        /// Items change far less often than users enter, only what changed in between is serialized again
+        m_ItemPayloads.resize(m_Items.GetSegmentCount());
+        m_Items.ConsumeDirtySegments([this](uint32 p_Segment)
+        {
+            if (p_Segment < m_ItemPayloads.size())
+                m_ItemPayloads[p_Segment] = BuildItemPayload(p_Segment);
+        });
+
+        p_Socket.Write(m_HeightmapPayload);
+
+        for (Core::Network::SharedPacket const& l_Payload : m_ItemPayloads)
+        {
+            if (l_Payload.GetBuffer())
+                p_Socket.Write(l_Payload);
+        }
+    }
+
+}   ///< namespace Map
+}   ///< namespace Game
+}   ///< namespace Steerstone
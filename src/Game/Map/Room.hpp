@@ -0,0 +1,190 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+#include "Threading/ThrStrand.hpp"
+#include "Network/BroadcastGroup.hpp"
+#include "Network/SharedPacket.hpp"
+#include "World/WorldUpdater.hpp"
+#include "Entity/Unit/RoomUnit.hpp"
+#include "RoomBots.hpp"
+#include "RoomModel.hpp"
+#include "RoomGrid.hpp"
+#include "TileIndex.hpp"
+#include "WiredEngine.hpp"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace SteerStone { namespace Game {
+
+    namespace Server { class GameSocket; }
+
+namespace Map {
+
+    /// Loaded room, simulated on its own strand
+    /// Every tick advances walking units one step and sends the changed statuses
+    /// as one batched message, serialized once for every user in the room
+    class Room : public World::Updatable, public std::enable_shared_from_this<Room>
+    {
+        DISALLOW_COPY_AND_ASSIGN(Room);
+
+        /// Allow access to reservations and unload state
+        friend class RoomManager;
+
+        public:
+            /// Get room whose strand is running on the calling thread, nullptr if none
+            static Room* GetCurrent();
+
+        public:
+            /// Constructor
+            /// @p_Id            : Id of room
+            /// @p_Model         : Floor of room
+            /// @p_UnloadTimeout : MS the room may stay empty before it unloads
+            Room(uint32 p_Id, std::shared_ptr<RoomModel const> const& p_Model, uint32 p_UnloadTimeout);
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Get id of room
+            uint32 GetId() const { return m_Id; }
+            /// Check room has been unloaded, a new room is loaded for users entering afterwards
+            bool IsUnloaded() const { return m_Unloaded.load(std::memory_order_acquire); }
+
+            /// Run message on our strand, safe from any thread
+            /// @p_Function : Message
+            void Post(std::function<void()> p_Function);
+            /// Post a tick to our strand, called by the world updater
+            /// @p_Diff : Time since last update in MS
+            /// Returns false once unloaded
+            virtual bool Update(uint32 const p_Diff) override;
+
+            /// Strand only
+            /// Add avatar at the door, it gets the floor, the items and the status of every unit already in the room
+            /// @p_Socket : Socket of avatar
+            void AddUser(std::shared_ptr<Server::GameSocket> const& p_Socket);
+            /// Remove avatar
+            /// @p_Socket : Socket of avatar
+            void RemoveUser(Server::GameSocket const* p_Socket);
+            /// Make avatar walk to tile
+            /// @p_Socket : Socket of avatar
+            /// @p_X      : X of tile
+            /// @p_Y      : Y of tile
+            void MoveUser(Server::GameSocket const* p_Socket, int16 p_X, int16 p_Y);
+            /// Make unit walk to tile
+            /// @p_UnitId : Id of unit
+            /// @p_X      : X of tile
+            /// @p_Y      : Y of tile
+            void MoveUnit(uint32 p_UnitId, int16 p_X, int16 p_Y);
+            /// Avatar said something, chat triggers listen to it
+            /// @p_Socket  : Socket of avatar
+            /// @p_Message : Message
+            void OnUserChat(Server::GameSocket const* p_Socket, std::string_view p_Message);
+            /// Add bot at the door
+            /// @p_Behaviour : What the bot does
+            /// @p_Owner     : Socket of avatar a following bot follows, nullptr if none
+            void AddBot(BotBehaviour p_Behaviour = BotBehaviour::Wander, Server::GameSocket const* p_Owner = nullptr);
+
+            /// Place floor item, on top of the stack already on its tiles
+            /// @p_Item : Item
+            bool PlaceItem(RoomItem const& p_Item);
+            /// Move or rotate floor item
+            /// @p_Id       : Id of item
+            /// @p_X        : X of tile the footprint starts on
+            /// @p_Y        : Y of tile the footprint starts on
+            /// @p_Rotation : Rotation
+            bool MoveItem(uint32 p_Id, int16 p_X, int16 p_Y, uint8 p_Rotation);
+            /// Pick up floor item, a wired stack it triggers is removed along
+            /// @p_Id : Id of item
+            void PickupItem(uint32 p_Id);
+            /// Change state of floor item, state change triggers watching it run
+            /// @p_Id     : Id of item
+            /// @p_State  : State
+            /// @p_UnitId : Id of unit which caused it, 0 if none
+            void SetItemState(uint32 p_Id, uint8 p_State, uint32 p_UnitId = 0);
+            /// Get floor items, tile and footprint queries
+            TileIndex const& GetItems() const { return m_Items; }
+
+            /// Get wired stacks, add and remove them through it
+            WiredEngine& GetWired() { return m_Wired; }
+
+            /// Get amount of avatars
+            std::size_t GetUserCount() const { return m_UserCount; }
+
+        private:
+            /// Advance walking units, send batched statuses and unload once empty for long enough, strand only
+            void Tick();
+            /// Find unit of avatar
+            /// @p_Socket : Socket of avatar
+            std::vector<Entity::RoomUnit>::iterator FindUser(Server::GameSocket const* p_Socket);
+            /// Check no unit stands on footprint
+            /// @p_X      : X of tile the footprint starts on
+            /// @p_Y      : Y of tile the footprint starts on
+            /// @p_Width  : Tiles covered on X
+            /// @p_Length : Tiles covered on Y
+            bool IsFootprintEmpty(int16 p_X, int16 p_Y, uint8 p_Width, uint8 p_Length) const;
+            /// Copy stack height and blocking state of footprint tiles to the walkability grid
+            /// @p_Item : Item whose footprint changed
+            void SyncFootprint(RoomItem const& p_Item);
+            /// Remove unit, releases the tiles it stands on
+            /// @p_Itr : Unit
+            void RemoveUnit(std::vector<Entity::RoomUnit>::iterator p_Itr);
+            /// Serialize floor of room, sent to every avatar entering
+            Core::Network::SharedPacket BuildHeightmapPayload() const;
+            /// Serialize floor items of a segment of the tile index, empty if the segment holds none
+            /// @p_Segment : Segment
+            Core::Network::SharedPacket BuildItemPayload(uint32 p_Segment) const;
+            /// Send floor and floor items to an entering avatar, segments changed since the last entry are serialized again
+            /// @p_Socket : Socket of avatar
+            void SendEntryPayloads(Server::GameSocket& p_Socket);
+
+        private:
+            uint32 m_Id;                                        ///< Id of room
+            std::shared_ptr<RoomModel const> m_Model;           ///< Floor of room
+            Core::Threading::Strand::Ptr m_Strand;              ///< Strand every room message runs on
+            Core::Network::BroadcastGroup m_Users;              ///< Sockets of avatars in room
+
+            std::vector<Entity::RoomUnit> m_Units;              ///< Avatars and bots, strand only
+            std::string m_StatusBuffer;                         ///< Status lines of current tick, strand only
+            std::size_t m_UserCount;                            ///< Avatars in room, strand only
+            uint32 m_NextUnitId;                                ///< Id of next unit, strand only
+            uint32 m_EmptySince;                                ///< Server time room became empty, strand only
+            uint32 m_UnloadTimeout;                             ///< MS the room may stay empty
+
+            std::atomic<bool> m_TickPending;                    ///< A tick is posted and has not run yet
+            std::atomic<bool> m_Unloaded;                       ///< Set by the room manager once unloaded
+            uint32 m_Reservations;                              ///< Users on their way in, guarded by the room manager
+            RoomGrid m_Grid;                                    ///< Walkability of tiles, strand only
+            TileIndex m_Items;                                  ///< Floor items by tile, strand only
+            WiredEngine m_Wired;                                ///< Wired stacks, strand only
+            RoomBots m_Bots;                                    ///< Decision state of bots, strand only
+            Core::Network::SharedPacket m_HeightmapPayload;     ///< Serialized floor
+            std::vector<Core::Network::SharedPacket> m_ItemPayloads;    ///< Serialized floor items of every tile index segment, strand only
+    };
+
+}   ///< namespace Map
+}   ///< namespace Game
+}   ///< namespace Steerstone
@@ -0,0 +1,212 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include "RoomBots.hpp"
+#include "Entity/Unit/RoomUnit.hpp"
+#include "Utility/UtilRandom.hpp"
+
+#include <cstdlib>
+
+namespace SteerStone { namespace Game { namespace Map {
+
+    /// Offsets of the 8 neighbours of a tile, a following bot walks to one of the neighbours of its owner
+    static constexpr int16 s_NeighbourX[] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+    static constexpr int16 s_NeighbourY[] = { -1, -1, 0, 1, 1, 1, 0, -1 };
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    RoomBots::RoomBots()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Add bot
+    /// @p_Unit      : Index of unit of bot in the units of room
+    /// @p_Behaviour : Behaviour
+    /// @p_Owner     : Index of unit followed, ROOM_BOT_NO_OWNER if none
+    /// @p_Now       : Server time, first action is taken on the next update
+    void RoomBots::Add(uint32 p_Unit, BotBehaviour p_Behaviour, uint32 p_Owner, uint32 p_Now)
+    {
+        if (p_Behaviour == BotBehaviour::Follow && p_Owner == ROOM_BOT_NO_OWNER)
+            p_Behaviour = BotBehaviour::Wander;
+
+        m_Unit.push_back(p_Unit);
+        m_NextAction.push_back(p_Now);
+        m_TargetX.push_back(0);
+        m_TargetY.push_back(0);
+        m_Behaviour.push_back(p_Behaviour);
+        m_Owner.push_back(p_Owner);
+    }
+    /// Unit was removed, its bot is removed and bots following it wander instead
+    /// @p_Unit : Index of unit
+    void RoomBots::OnUnitRemoved(uint32 p_Unit)
+    {
+        for (uint32 l_Row = 0; l_Row < m_Unit.size();)
+        {
+            if (m_Unit[l_Row] == p_Unit)
+            {
+                RemoveRow(l_Row);
+                continue;
+            }
+
+            if (m_Owner[l_Row] == p_Unit)
+            {
+                m_Owner[l_Row]     = ROOM_BOT_NO_OWNER;
+                m_Behaviour[l_Row] = BotBehaviour::Wander;
+            }
+
+            l_Row++;
+        }
+    }
+    /// Unit moved to another index of the units of room
+    /// @p_From : Previous index
+    /// @p_To   : New index
+    void RoomBots::OnUnitMoved(uint32 p_From, uint32 p_To)
+    {
+        for (uint32 l_Row = 0; l_Row < m_Unit.size(); l_Row++)
+        {
+            if (m_Unit[l_Row] == p_From)
+                m_Unit[l_Row] = p_To;
+
+            if (m_Owner[l_Row] == p_From)
+                m_Owner[l_Row] = p_To;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Take the actions which are due
+    /// @p_Units : Units of room
+    /// @p_Grid  : Grid of room
+    /// @p_Now   : Server time
+    void RoomBots::Update(std::vector<Entity::RoomUnit>& p_Units, RoomGrid const& p_Grid, uint32 p_Now)
+    {
+        m_Due.clear();
+        for (uint32 l_Row = 0; l_Row < m_NextAction.size(); l_Row++)
+        {
+            if (static_cast<int32>(p_Now - m_NextAction[l_Row]) >= 0)
+                m_Due.push_back(l_Row);
+        }
+
+        if (m_Due.empty())
+            return;
+
+        /// Two numbers per bot, one picks the tile and the other the delay until the next action
+        m_Random.resize(m_Due.size() * 2);
+        Core::Utils::Rand32Array(m_Random.data(), m_Random.size());
+
+        if (m_Paths.size() < m_Due.size())
+            m_Paths.resize(m_Due.size());
+
+        m_Requests.clear();
+        m_Searched.clear();
+
+        for (uint32 l_I = 0; l_I < m_Due.size(); l_I++)
+        {
+            const uint32 l_Row   = m_Due[l_I];
+            const uint32 l_Tile  = m_Random[l_I * 2];
+            const uint32 l_Delay = m_Random[l_I * 2 + 1];
+
+            Entity::RoomUnit const& l_Unit = p_Units[m_Unit[l_Row]];
+
+            switch (m_Behaviour[l_Row])
+            {
+                case BotBehaviour::Idle:
+                    m_NextAction[l_Row] = p_Now + ROOM_BOT_ACTION_MAX;
+                    continue;
+                case BotBehaviour::Wander:
+                    m_NextAction[l_Row] = p_Now + ROOM_BOT_ACTION_MIN + l_Delay % (ROOM_BOT_ACTION_MAX - ROOM_BOT_ACTION_MIN + 1);
+                    if (l_Unit.IsWalking())
+                        continue;
+
+                    m_TargetX[l_Row] = l_Unit.GetX() + static_cast<int16>((l_Tile & 0xFFFF) % (ROOM_BOT_WANDER_RADIUS * 2 + 1)) - ROOM_BOT_WANDER_RADIUS;
+                    m_TargetY[l_Row] = l_Unit.GetY() + static_cast<int16>((l_Tile >> 16) % (ROOM_BOT_WANDER_RADIUS * 2 + 1)) - ROOM_BOT_WANDER_RADIUS;
+                    break;
+                case BotBehaviour::Follow:
+                {
+                    m_NextAction[l_Row] = p_Now + ROOM_BOT_FOLLOW_INTERVAL;
+                    if (l_Unit.IsWalking())
+                        continue;
+
+                    Entity::RoomUnit const& l_Owner = p_Units[m_Owner[l_Row]];
+                    if (std::abs(l_Owner.GetX() - l_Unit.GetX()) <= 1 && std::abs(l_Owner.GetY() - l_Unit.GetY()) <= 1)
+                        continue;
+
+                    /// The owner stands on their own tile, a random neighbour of it is walked to
+                    m_TargetX[l_Row] = l_Owner.GetX() + s_NeighbourX[l_Tile % 8];
+                    m_TargetY[l_Row] = l_Owner.GetY() + s_NeighbourY[l_Tile % 8];
+                    break;
+                }
+            }
+
+            if (!p_Grid.IsValid(m_TargetX[l_Row], m_TargetY[l_Row]) || !p_Grid.IsFree(p_Grid.GetIndex(m_TargetX[l_Row], m_TargetY[l_Row])))
+                continue;
+
+            m_Requests.push_back({ p_Grid.GetIndex(l_Unit.GetX(), l_Unit.GetY()), p_Grid.GetIndex(m_TargetX[l_Row], m_TargetY[l_Row]), &m_Paths[m_Requests.size()], false });
+            m_Searched.push_back(l_Row);
+        }
+
+        if (m_Requests.empty())
+            return;
+
+        Pathfinder::FindPaths(p_Grid, m_Requests);
+
+        for (uint32 l_I = 0; l_I < m_Requests.size(); l_I++)
+        {
+            if (!m_Requests[l_I].Found)
+                continue;
+
+            const uint32 l_Row = m_Searched[l_I];
+            p_Units[m_Unit[l_Row]].SetPath(m_TargetX[l_Row], m_TargetY[l_Row], *m_Requests[l_I].Path, p_Grid.GetVersion());
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Remove row, the last one takes its place
+    /// @p_Row : Row
+    void RoomBots::RemoveRow(uint32 p_Row)
+    {
+        const uint32 l_Last = static_cast<uint32>(m_Unit.size() - 1);
+
+        m_Unit[p_Row]        = m_Unit[l_Last];
+        m_NextAction[p_Row]  = m_NextAction[l_Last];
+        m_TargetX[p_Row]     = m_TargetX[l_Last];
+        m_TargetY[p_Row]     = m_TargetY[l_Last];
+        m_Behaviour[p_Row]   = m_Behaviour[l_Last];
+        m_Owner[p_Row]       = m_Owner[l_Last];
+
+        m_Unit.pop_back();
+        m_NextAction.pop_back();
+        m_TargetX.pop_back();
+        m_TargetY.pop_back();
+        m_Behaviour.pop_back();
+        m_Owner.pop_back();
+    }
+
+}   ///< namespace Map
+}   ///< namespace Game
+}   ///< namespace Steerstone
@@ -0,0 +1,108 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+#include "Pathfinder.hpp"
+
+#include <vector>
+
+#define ROOM_BOT_ACTION_MIN         2000        ///< Least MS between two walks of a wandering bot
+#define ROOM_BOT_ACTION_MAX         10000       ///< Most MS between two walks of a wandering bot
+#define ROOM_BOT_WANDER_RADIUS      6           ///< Most tiles a wandering bot walks away on X and Y, keeps its path searches short
+#define ROOM_BOT_FOLLOW_INTERVAL    1000        ///< MS between two checks of a following bot on its owner
+#define ROOM_BOT_NO_OWNER           0xFFFFFFFF  ///< Owner of bots which do not follow anyone
+
+namespace SteerStone { namespace Game {
+
+    namespace Entity { class RoomUnit; }
+
+namespace Map {
+
+    /// What a bot does once its next action is due
+    enum class BotBehaviour : uint8
+    {
+        Idle,                   ///< Stands still
+        Wander,                 ///< Walks to a random free tile
+        Follow                  ///< Walks next to its owner once they are more than a tile away
+    };
+
+    /// Decision state of every bot of a room, stored as one array per field
+    /// Rows are only visited when their next action is due, which only reads the next action array. Due rows get
+    /// their random numbers from one batch of the SFMT of the thread and their paths searched in one batch, the
+    /// units then step and send their status with everyone else. Strand of room only
+    class RoomBots
+    {
+        DISALLOW_COPY_AND_ASSIGN(RoomBots);
+
+        public:
+            /// Constructor
+            RoomBots();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Add bot
+            /// @p_Unit      : Index of unit of bot in the units of room
+            /// @p_Behaviour : Behaviour
+            /// @p_Owner     : Index of unit followed, ROOM_BOT_NO_OWNER if none
+            /// @p_Now       : Server time, first action is taken on the next update
+            void Add(uint32 p_Unit, BotBehaviour p_Behaviour, uint32 p_Owner, uint32 p_Now);
+            /// Unit was removed, its bot is removed and bots following it wander instead
+            /// @p_Unit : Index of unit
+            void OnUnitRemoved(uint32 p_Unit);
+            /// Unit moved to another index of the units of room
+            /// @p_From : Previous index
+            /// @p_To   : New index
+            void OnUnitMoved(uint32 p_From, uint32 p_To);
+            /// Get amount of bots
+            std::size_t GetSize() const { return m_Unit.size(); }
+
+            /// Take the actions which are due
+            /// @p_Units : Units of room
+            /// @p_Grid  : Grid of room
+            /// @p_Now   : Server time
+            void Update(std::vector<Entity::RoomUnit>& p_Units, RoomGrid const& p_Grid, uint32 p_Now);
+
+        private:
+            /// Remove row, the last one takes its place
+            /// @p_Row : Row
+            void RemoveRow(uint32 p_Row);
+
+        private:
+            std::vector<uint32> m_Unit;                             ///< Index of unit of every bot
+            std::vector<uint32> m_NextAction;                       ///< Server time every bot takes its next action
+            std::vector<int16> m_TargetX;                           ///< X of tile every bot walks to
+            std::vector<int16> m_TargetY;                           ///< Y of tile every bot walks to
+            std::vector<BotBehaviour> m_Behaviour;                  ///< Behaviour of every bot
+            std::vector<uint32> m_Owner;                            ///< Index of unit every bot follows
+
+            std::vector<uint32> m_Due;                              ///< Rows due on current update
+            std::vector<uint32> m_Random;                           ///< Random numbers of current update
+            std::vector<uint32> m_Searched;                         ///< Row of every path search of current update
+            std::vector<Pathfinder::Request> m_Requests;            ///< Path searches of current update
+            std::vector<std::vector<uint32>> m_Paths;               ///< Paths of current update, kept for their capacity
+    };
+
+}   ///< namespace Map
+}   ///< namespace Game
+}   ///< namespace Steerstone
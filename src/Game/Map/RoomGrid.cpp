@@ -0,0 +1,97 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "RoomGrid.hpp"
+#include "RoomModel.hpp"
+
+namespace SteerStone { namespace Game { namespace Map {
+
+    /// Constructor
+    /// @p_Model : Floor of room
+    RoomGrid::RoomGrid(RoomModel const& p_Model)
+        : m_Width(p_Model.GetWidth()), m_Height(p_Model.GetHeight()), m_Version(0)
+    {
+        /// Padded to whole words, bits past the last tile stay clear
+        const std::size_t l_Words = (GetSize() + 63) / 64;
+
+        m_FloorHeight.assign(GetSize(), 0);
+        m_StackHeight.assign(GetSize(), 0);
+        m_Occupants.assign(GetSize(), 0);
+        m_Floor.assign(l_Words, 0);
+        m_Occupied.assign(l_Words, 0);
+
+        for (int16 l_Y = 0; l_Y < m_Height; l_Y++)
+        {
+            for (int16 l_X = 0; l_X < m_Width; l_X++)
+            {
+                if (!p_Model.IsWalkable(l_X, l_Y))
+                    continue;
+
+                const uint32 l_Index = GetIndex(l_X, l_Y);
+                m_FloorHeight[l_Index] = static_cast<int16>(p_Model.GetTileHeight(l_X, l_Y) * ROOM_GRID_HEIGHT_SCALE);
+                m_Floor[l_Index >> 6] |= uint64(1) << (l_Index & 63);
+            }
+        }
+
+        m_Walkable = m_Floor;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Mark a unit on tile
+    /// @p_Index : Index of tile
+    void RoomGrid::AddOccupant(uint32 p_Index)
+    {
+        if (m_Occupants[p_Index]++ == 0)
+            m_Occupied[p_Index >> 6] |= uint64(1) << (p_Index & 63);
+    }
+    /// Unmark a unit on tile
+    /// @p_Index : Index of tile
+    void RoomGrid::RemoveOccupant(uint32 p_Index)
+    {
+        if (m_Occupants[p_Index] && --m_Occupants[p_Index] == 0)
+            m_Occupied[p_Index >> 6] &= ~(uint64(1) << (p_Index & 63));
+    }
+    /// Update tile a furni was placed on, moved from or picked up from
+    /// @p_X           : X of tile
+    /// @p_Y           : Y of tile
+    /// @p_StackHeight : Height of the topmost furni in hundredths of a tile, units stand on top
+    /// @p_Blocking    : Furni can not be walked on
+    void RoomGrid::SetFurni(int16 p_X, int16 p_Y, uint16 p_StackHeight, bool p_Blocking)
+    {
+        if (!IsValid(p_X, p_Y))
+            return;
+
+        const uint32 l_Index = GetIndex(p_X, p_Y);
+        const uint64 l_Bit   = uint64(1) << (l_Index & 63);
+
+        m_StackHeight[l_Index] = p_StackHeight;
+
+        if (!p_Blocking && (m_Floor[l_Index >> 6] & l_Bit))
+            m_Walkable[l_Index >> 6] |= l_Bit;
+        else
+            m_Walkable[l_Index >> 6] &= ~l_Bit;
+
+        m_Version++;
+    }
+
+}   ///< namespace Map
+}   ///< namespace Game
+}   ///< namespace Steerstone
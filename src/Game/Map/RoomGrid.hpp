@@ -0,0 +1,124 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+
+#include <vector>
+
+#define ROOM_GRID_HEIGHT_SCALE      100     ///< Heights are stored in hundredths of a tile
+#define ROOM_GRID_MAX_STEP_UP       150     ///< Highest step up a unit can walk, in hundredths of a tile
+#define ROOM_GRID_MAX_STEP_DOWN     400     ///< Deepest step down a unit can walk, in hundredths of a tile
+
+namespace SteerStone { namespace Game { namespace Map {
+
+    class RoomModel;
+
+    /// Walkability grid of a loaded room, flat arrays indexed by tile so a search only touches a few cache lines per row
+    /// Floor heights come from the room model, furni and units update their tiles as they move. Strand of room only
+    class RoomGrid
+    {
+        DISALLOW_COPY_AND_ASSIGN(RoomGrid);
+
+        public:
+            /// Constructor
+            /// @p_Model : Floor of room
+            explicit RoomGrid(RoomModel const& p_Model);
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Get width in tiles
+            int16 GetWidth() const { return m_Width; }
+            /// Get height in tiles
+            int16 GetHeight() const { return m_Height; }
+            /// Get amount of tiles
+            uint32 GetSize() const { return static_cast<uint32>(m_Width) * m_Height; }
+            /// Get version, bumped every time furni change which tiles can be walked
+            uint32 GetVersion() const { return m_Version; }
+
+            /// Check tile is within the grid
+            /// @p_X : X of tile
+            /// @p_Y : Y of tile
+            bool IsValid(int16 p_X, int16 p_Y) const { return p_X >= 0 && p_Y >= 0 && p_X < m_Width && p_Y < m_Height; }
+            /// Get index of tile
+            /// @p_X : X of tile
+            /// @p_Y : Y of tile
+            uint32 GetIndex(int16 p_X, int16 p_Y) const { return static_cast<uint32>(p_Y) * m_Width + p_X; }
+            /// Get X of tile
+            /// @p_Index : Index of tile
+            int16 GetX(uint32 p_Index) const { return static_cast<int16>(p_Index % m_Width); }
+            /// Get Y of tile
+            /// @p_Index : Index of tile
+            int16 GetY(uint32 p_Index) const { return static_cast<int16>(p_Index / m_Width); }
+
+            /// Check tile is floor without blocking furni
+            /// @p_Index : Index of tile
+            bool IsWalkable(uint32 p_Index) const { return (m_Walkable[p_Index >> 6] >> (p_Index & 63)) & 1; }
+            /// Check a unit stands on or walks onto tile
+            /// @p_Index : Index of tile
+            bool IsOccupied(uint32 p_Index) const { return (m_Occupied[p_Index >> 6] >> (p_Index & 63)) & 1; }
+            /// Check tile is walkable and nobody is on it
+            /// @p_Index : Index of tile
+            bool IsFree(uint32 p_Index) const { return ((m_Walkable[p_Index >> 6] & ~m_Occupied[p_Index >> 6]) >> (p_Index & 63)) & 1; }
+            /// Get floor height in hundredths of a tile
+            /// @p_Index : Index of tile
+            int16 GetFloorHeight(uint32 p_Index) const { return m_FloorHeight[p_Index]; }
+            /// Get height a unit stands at, floor plus furni, in hundredths of a tile
+            /// @p_Index : Index of tile
+            int16 GetStandHeight(uint32 p_Index) const { return m_FloorHeight[p_Index] + m_StackHeight[p_Index]; }
+            /// Check a unit can step between two neighbouring tiles, ignoring units
+            /// @p_From : Index of tile walked from
+            /// @p_To   : Index of tile walked onto
+            bool CanStep(uint32 p_From, uint32 p_To) const
+            {
+                const int32 l_Difference = GetStandHeight(p_To) - GetStandHeight(p_From);
+                return IsWalkable(p_To) && l_Difference <= ROOM_GRID_MAX_STEP_UP && -l_Difference <= ROOM_GRID_MAX_STEP_DOWN;
+            }
+
+            /// Mark a unit on tile
+            /// @p_Index : Index of tile
+            void AddOccupant(uint32 p_Index);
+            /// Unmark a unit on tile
+            /// @p_Index : Index of tile
+            void RemoveOccupant(uint32 p_Index);
+            /// Update tile a furni was placed on, moved from or picked up from
+            /// @p_X           : X of tile
+            /// @p_Y           : Y of tile
+            /// @p_StackHeight : Height of the topmost furni in hundredths of a tile, units stand on top
+            /// @p_Blocking    : Furni can not be walked on
+            void SetFurni(int16 p_X, int16 p_Y, uint16 p_StackHeight, bool p_Blocking);
+
+        private:
+            int16 m_Width;                              ///< Width in tiles
+            int16 m_Height;                             ///< Height in tiles
+            uint32 m_Version;                           ///< Bumped when walkable tiles change
+            std::vector<int16> m_FloorHeight;           ///< Floor height of every tile in hundredths
+            std::vector<uint16> m_StackHeight;          ///< Furni height of every tile in hundredths
+            std::vector<uint8> m_Occupants;             ///< Units on every tile
+            std::vector<uint64> m_Floor;                ///< Tiles which are floor, one bit each
+            std::vector<uint64> m_Walkable;             ///< Floor tiles without blocking furni, one bit each
+            std::vector<uint64> m_Occupied;             ///< Tiles with at least one unit, one bit each
+    };
+
+}   ///< namespace Map
+}   ///< namespace Game
+}   ///< namespace Steerstone
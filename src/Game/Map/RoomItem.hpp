@@ -0,0 +1,66 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+
+namespace SteerStone { namespace Game { namespace Map {
+
+    /// Behaviour of a furni on the tiles it covers
+    enum RoomItemFlags : uint8
+    {
+        ROOM_ITEM_FLAG_NONE         = 0x00,
+        ROOM_ITEM_FLAG_CAN_STACK    = 0x01,     ///< Other furni can be placed on top
+        ROOM_ITEM_FLAG_CAN_WALK     = 0x02,     ///< Units can walk over it (rugs, gates which are open)
+        ROOM_ITEM_FLAG_CAN_SIT      = 0x04,     ///< Units sit on it once they stop on it
+        ROOM_ITEM_FLAG_CAN_LAY      = 0x08      ///< Units lay on it once they stop on it
+    };
+
+    /// Floor furni placed in a room
+    struct RoomItem
+    {
+        uint32 Id;              ///< Id of item
+        int16 X;                ///< X of tile the footprint starts on
+        int16 Y;                ///< Y of tile the footprint starts on
+        uint16 Z;               ///< Height the item is placed at in hundredths of a tile, set on placement
+        uint8 Width;            ///< Tiles covered on X at rotation 0
+        uint8 Length;           ///< Tiles covered on Y at rotation 0
+        uint8 Rotation;         ///< Rotation, 2 and 6 swap width and length
+        uint16 Height;          ///< Height of the item itself in hundredths of a tile
+        uint8 Flags;            ///< RoomItemFlags
+        uint8 State;            ///< State shown by the client (switched on, colour...), 0 by default
+
+        /// Get tiles covered on X at current rotation
+        uint8 GetFootprintWidth() const { return (Rotation == 2 || Rotation == 6) ? Length : Width; }
+        /// Get tiles covered on Y at current rotation
+        uint8 GetFootprintLength() const { return (Rotation == 2 || Rotation == 6) ? Width : Length; }
+        /// Get height of the top of the item
+        uint16 GetTopHeight() const { return Z + Height; }
+        /// Check flag is set
+        /// @p_Flag : Flag
+        bool HasFlag(RoomItemFlags p_Flag) const { return (Flags & p_Flag) != 0; }
+        /// Check units can end up on the tiles it covers
+        bool IsWalkable() const { return (Flags & (ROOM_ITEM_FLAG_CAN_WALK | ROOM_ITEM_FLAG_CAN_SIT | ROOM_ITEM_FLAG_CAN_LAY)) != 0; }
+    };
+
+}   ///< namespace Map
+}   ///< namespace Game
+}   ///< namespace Steerstone
@@ -0,0 +1,137 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "RoomManager.hpp"
+#include "Config/Config.hpp"
+#include "Logger/Base.hpp"
+
+namespace SteerStone { namespace Game { namespace Map {
+
+    SINGLETON_P_I(RoomManager);
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    RoomManager::RoomManager()
+        : m_World(nullptr), m_TickInterval(ROOM_TICK_INTERVAL), m_UnloadTimeout(ROOM_UNLOAD_TIMEOUT), m_BotCount(0)
+    {
+    }
+    /// Deconstructor
+    RoomManager::~RoomManager()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Read settings and keep world updater rooms are registered on, called once on start up
+    /// @p_World : World updater
+    void RoomManager::Initialize(World::WorldUpdater* p_World)
+    {
+        std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+        m_World         = p_World;
+        m_TickInterval  = static_cast<uint32>(std::max(1, sConfigManager->GetInt("RoomTickInterval", ROOM_TICK_INTERVAL)));
+        m_UnloadTimeout = static_cast<uint32>(std::max(0, sConfigManager->GetInt("RoomUnloadTimeout", ROOM_UNLOAD_TIMEOUT)));
+        m_BotCount      = static_cast<uint32>(std::max(0, sConfigManager->GetInt("RoomBotCount", 0)));
+
+        /// Rooms have no model of their own yet, every room is loaded with the configured one
+        m_Model = std::make_shared<RoomModel const>(sConfigManager->GetString("RoomModel.Heightmap", ROOM_DEFAULT_HEIGHTMAP),
+            static_cast<int16>(sConfigManager->GetInt("RoomModel.DoorX", 0)), static_cast<int16>(sConfigManager->GetInt("RoomModel.DoorY", 0)));
+
+        LOG_INFO("Room", "Rooms tick every %0 ms on a %1x%2 model, empty rooms unload after %3 ms", m_TickInterval, m_Model->GetWidth(), m_Model->GetHeight(), m_UnloadTimeout);
+    }
+
+    /// Get room, loading it if needed, and reserve a spot so it is not unloaded before the user is added
+    /// The caller must post Room::AddUser, which releases the reservation
+    /// @p_Id : Id of room
+    std::shared_ptr<Room> RoomManager::EnterRoom(uint32 p_Id)
+    {
+        std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+        if (!m_World || m_Model->GetWidth() == 0)
+            return nullptr;
+
+        std::shared_ptr<Room>& l_Room = m_Rooms[p_Id];
+
+        if (!l_Room)
+        {
+            l_Room = std::make_shared<Room>(p_Id, m_Model, m_UnloadTimeout);
+
+            if (m_BotCount)
+            {
+                Room* l_Loaded = l_Room.get();
+                l_Room->Post([l_Loaded, l_BotCount = m_BotCount]()
+                {
+                    for (uint32 l_I = 0; l_I < l_BotCount; l_I++)
+                        l_Loaded->AddBot();
+                });
+            }
+
+            m_World->Register("Room " + std::to_string(p_Id), l_Room, m_TickInterval);
+
+            LOG_VERBOSE("Room", "Loaded room %0", p_Id);
+        }
+
+        l_Room->m_Reservations++;
+        return l_Room;
+    }
+
+    /// Get amount of loaded rooms
+    std::size_t RoomManager::GetRoomCount()
+    {
+        std::lock_guard<std::mutex> l_Lock(m_Mutex);
+        return m_Rooms.size();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Release reservation taken by EnterRoom, room strand only
+    /// @p_Room : Room
+    void RoomManager::ReleaseReservation(Room* p_Room)
+    {
+        std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+        if (p_Room->m_Reservations)
+            p_Room->m_Reservations--;
+    }
+    /// Unload room unless a user is on their way in, room strand only
+    /// @p_Room : Room
+    void RoomManager::TryUnload(Room* p_Room)
+    {
+        std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+        if (p_Room->m_Reservations || p_Room->IsUnloaded())
+            return;
+
+        /// The world updater drops the room on its next update, the last posted message keeps it alive until then
+        p_Room->m_Unloaded.store(true, std::memory_order_release);
+
+        auto l_Itr = m_Rooms.find(p_Room->GetId());
+        if (l_Itr != m_Rooms.end() && l_Itr->second.get() == p_Room)
+            m_Rooms.erase(l_Itr);
+
+        LOG_VERBOSE("Room", "Unloaded room %0", p_Room->GetId());
+    }
+
+}   ///< namespace Map
+}   ///< namespace Game
+}   ///< namespace Steerstone
@@ -0,0 +1,81 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+#include "Singleton/Singleton.hpp"
+#include "World/WorldUpdater.hpp"
+#include "Room.hpp"
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#define ROOM_TICK_INTERVAL          500         ///< Default MS between two room ticks (one walk step)
+#define ROOM_UNLOAD_TIMEOUT         60000       ///< Default MS a room may stay empty before it unloads
+#define ROOM_DEFAULT_HEIGHTMAP      "0000000000|0000000000|0000000000|0000000000|0000000000|0000000000|0000000000|0000000000|0000000000|0000000000"
+
+namespace SteerStone { namespace Game { namespace Map {
+
+    /// Loads rooms on first entry, registers them on the world updater and unloads them once they stay empty
+    class RoomManager
+    {
+        SINGLETON_P_D(RoomManager);
+
+        /// Allow rooms to release reservations and ask to be unloaded
+        friend class Room;
+
+        public:
+            /// Read settings and keep world updater rooms are registered on, called once on start up
+            /// @p_World : World updater
+            void Initialize(World::WorldUpdater* p_World);
+
+            /// Get room, loading it if needed, and reserve a spot so it is not unloaded before the user is added
+            /// The caller must post Room::AddUser, which releases the reservation
+            /// @p_Id : Id of room
+            std::shared_ptr<Room> EnterRoom(uint32 p_Id);
+
+            /// Get amount of loaded rooms
+            std::size_t GetRoomCount();
+
+        private:
+            /// Release reservation taken by EnterRoom, room strand only
+            /// @p_Room : Room
+            void ReleaseReservation(Room* p_Room);
+            /// Unload room unless a user is on their way in, room strand only
+            /// @p_Room : Room
+            void TryUnload(Room* p_Room);
+
+        private:
+            std::mutex m_Mutex;                                                 ///< Guards rooms and reservations
+            std::unordered_map<uint32, std::shared_ptr<Room>> m_Rooms;          ///< Loaded rooms
+            World::WorldUpdater* m_World;                                       ///< World updater rooms are registered on
+            std::shared_ptr<RoomModel const> m_Model;                           ///< Floor every room is loaded with
+            uint32 m_TickInterval;                                              ///< MS between two room ticks
+            uint32 m_UnloadTimeout;                                             ///< MS a room may stay empty
+            uint32 m_BotCount;                                                  ///< Bots added to every loaded room
+    };
+
+}   ///< namespace Map
+}   ///< namespace Game
+}   ///< namespace Steerstone
+
+#define sRoomManager SteerStone::Game::Map::RoomManager::GetSingleton()
@@ -0,0 +1,81 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "RoomModel.hpp"
+#include "Logger/Base.hpp"
+
+#include <algorithm>
+
+namespace SteerStone { namespace Game { namespace Map {
+
+    /// Constructor
+    /// @p_Heightmap : Heightmap
+    /// @p_DoorX     : X of tile units enter on
+    /// @p_DoorY     : Y of tile units enter on
+    RoomModel::RoomModel(std::string const& p_Heightmap, int16 p_DoorX, int16 p_DoorY)
+        : m_Width(0), m_Height(0), m_DoorX(p_DoorX), m_DoorY(p_DoorY)
+    {
+        std::vector<std::string> l_Rows(1);
+
+        for (char l_Char : p_Heightmap)
+        {
+            if (l_Char == '\r' || l_Char == '\n' || l_Char == '|')
+            {
+                if (!l_Rows.back().empty())
+                    l_Rows.emplace_back();
+            }
+            else if (l_Char != ' ')
+                l_Rows.back().push_back(l_Char);
+        }
+
+        if (l_Rows.back().empty())
+            l_Rows.pop_back();
+
+        for (std::string const& l_Row : l_Rows)
+            m_Width = std::max<int16>(m_Width, static_cast<int16>(l_Row.size()));
+
+        m_Height = static_cast<int16>(l_Rows.size());
+        m_Tiles.assign(static_cast<std::size_t>(m_Width) * m_Height, ROOM_MODEL_BLOCKED);
+
+        /// Short rows are padded with blocked tiles
+        for (int16 l_Y = 0; l_Y < m_Height; l_Y++)
+        {
+            for (int16 l_X = 0; l_X < static_cast<int16>(l_Rows[l_Y].size()); l_X++)
+            {
+                const char l_Char = l_Rows[l_Y][l_X];
+                if (l_Char >= '0' && l_Char <= '9')
+                    m_Tiles[GetIndex(l_X, l_Y)] = static_cast<int8>(l_Char - '0');
+            }
+        }
+
+        if (!IsWalkable(m_DoorX, m_DoorY))
+        {
+            LOG_WARNING("Room", "Door %0,%1 of room model is not walkable, units enter on the first walkable tile", m_DoorX, m_DoorY);
+
+            auto l_Itr = std::find_if(m_Tiles.begin(), m_Tiles.end(), [](int8 p_Height) { return p_Height != ROOM_MODEL_BLOCKED; });
+            const std::size_t l_Index = l_Itr != m_Tiles.end() ? static_cast<std::size_t>(l_Itr - m_Tiles.begin()) : 0;
+
+            m_DoorX = m_Width ? static_cast<int16>(l_Index % m_Width) : 0;
+            m_DoorY = m_Width ? static_cast<int16>(l_Index / m_Width) : 0;
+        }
+    }
+
+}   ///< namespace Map
+}   ///< namespace Game
+}   ///< namespace Steerstone
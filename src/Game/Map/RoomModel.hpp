@@ -0,0 +1,82 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+
+#include <string>
+#include <vector>
+
+#define ROOM_MODEL_BLOCKED      -1      ///< Height of a tile which can not be walked on
+
+namespace SteerStone { namespace Game { namespace Map {
+
+    /// Floor of a room, a grid of tile heights parsed from a heightmap
+    /// Rows are separated by a line break or '|', 'x' is a blocked tile and a digit the height of a walkable one
+    class RoomModel
+    {
+        public:
+            /// Constructor
+            /// @p_Heightmap : Heightmap
+            /// @p_DoorX     : X of tile units enter on
+            /// @p_DoorY     : Y of tile units enter on
+            RoomModel(std::string const& p_Heightmap, int16 p_DoorX, int16 p_DoorY);
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Get width in tiles
+            int16 GetWidth() const { return m_Width; }
+            /// Get height in tiles
+            int16 GetHeight() const { return m_Height; }
+            /// Get X of door
+            int16 GetDoorX() const { return m_DoorX; }
+            /// Get Y of door
+            int16 GetDoorY() const { return m_DoorY; }
+
+            /// Check tile is within the grid
+            /// @p_X : X of tile
+            /// @p_Y : Y of tile
+            bool IsValid(int16 p_X, int16 p_Y) const { return p_X >= 0 && p_Y >= 0 && p_X < m_Width && p_Y < m_Height; }
+            /// Check tile can be walked on
+            /// @p_X : X of tile
+            /// @p_Y : Y of tile
+            bool IsWalkable(int16 p_X, int16 p_Y) const { return IsValid(p_X, p_Y) && m_Tiles[GetIndex(p_X, p_Y)] != ROOM_MODEL_BLOCKED; }
+            /// Get height of tile, ROOM_MODEL_BLOCKED if it can not be walked on
+            /// @p_X : X of tile
+            /// @p_Y : Y of tile
+            int8 GetTileHeight(int16 p_X, int16 p_Y) const { return IsValid(p_X, p_Y) ? m_Tiles[GetIndex(p_X, p_Y)] : ROOM_MODEL_BLOCKED; }
+            /// Get index of tile in grid
+            /// @p_X : X of tile
+            /// @p_Y : Y of tile
+            std::size_t GetIndex(int16 p_X, int16 p_Y) const { return static_cast<std::size_t>(p_Y) * m_Width + p_X; }
+
+        private:
+            std::vector<int8> m_Tiles;              ///< Height of every tile, row by row
+            int16 m_Width;                          ///< Width in tiles
+            int16 m_Height;                         ///< Height in tiles
+            int16 m_DoorX;                          ///< X of door
+            int16 m_DoorY;                          ///< Y of door
+    };
+
+}   ///< namespace Map
+}   ///< namespace Game
+}   ///< namespace Steerstone
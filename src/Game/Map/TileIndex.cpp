@@ -0,0 +1,322 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "TileIndex.hpp"
+#include "RoomModel.hpp"
+#include "RoomGrid.hpp"
+
+#include <algorithm>
+
+namespace SteerStone { namespace Game { namespace Map {
+
+    /// Bucket of tiles which are not on the grid
+    static const std::vector<TileIndex::Handle> s_EmptyTile;
+
+    /// Constructor
+    /// @p_Model : Floor of room
+    TileIndex::TileIndex(RoomModel const& p_Model)
+        : m_Width(p_Model.GetWidth()), m_Height(p_Model.GetHeight()), m_QueryStamp(0)
+    {
+        const std::size_t l_Size = static_cast<std::size_t>(m_Width) * m_Height;
+
+        m_Floor.assign(l_Size, 0);
+        m_FloorHeight.assign(l_Size, 0);
+        m_Tiles.resize(l_Size);
+        m_TopItem.assign(l_Size, TILE_INDEX_INVALID_HANDLE);
+
+        for (int16 l_Y = 0; l_Y < m_Height; l_Y++)
+        {
+            for (int16 l_X = 0; l_X < m_Width; l_X++)
+            {
+                if (!p_Model.IsWalkable(l_X, l_Y))
+                    continue;
+
+                m_Floor[GetIndex(l_X, l_Y)]       = 1;
+                m_FloorHeight[GetIndex(l_X, l_Y)] = static_cast<uint16>(p_Model.GetTileHeight(l_X, l_Y) * ROOM_GRID_HEIGHT_SCALE);
+            }
+        }
+
+        m_StackHeight = m_FloorHeight;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Place item on the tiles of its footprint, on top of the stack already there
+    /// @p_Item : Item, Z is set to the height it is placed at
+    /// Returns TILE_INDEX_INVALID_HANDLE if footprint is off the floor, already indexed or a tile can not be stacked on
+    TileIndex::Handle TileIndex::Place(RoomItem const& p_Item)
+    {
+        uint16 l_Height = 0;
+
+        if (m_ById.count(p_Item.Id) || !CanPlace(p_Item.X, p_Item.Y, p_Item.GetFootprintWidth(), p_Item.GetFootprintLength(), l_Height))
+            return TILE_INDEX_INVALID_HANDLE;
+
+        Handle l_Handle;
+        if (!m_FreeSlots.empty())
+        {
+            l_Handle = m_FreeSlots.back();
+            m_FreeSlots.pop_back();
+        }
+        else
+        {
+            l_Handle = static_cast<Handle>(m_Slots.size());
+            m_Slots.emplace_back();
+        }
+
+        Slot& l_Slot = m_Slots[l_Handle];
+        l_Slot.Item       = p_Item;
+        l_Slot.Item.Z     = l_Height;
+        l_Slot.Used       = true;
+        l_Slot.QueryStamp = 0;
+
+        m_ById[p_Item.Id] = l_Handle;
+        Link(l_Handle);
+        MarkDirty(l_Handle);
+
+        return l_Handle;
+    }
+    /// Move item, it stays where it was if it does not fit on its new tiles
+    /// @p_Handle   : Item
+    /// @p_X        : X of tile the footprint starts on
+    /// @p_Y        : Y of tile the footprint starts on
+    /// @p_Rotation : Rotation
+    bool TileIndex::Move(Handle p_Handle, int16 p_X, int16 p_Y, uint8 p_Rotation)
+    {
+        if (!Get(p_Handle))
+            return false;
+
+        RoomItem& l_Item = m_Slots[p_Handle].Item;
+
+        /// Unlinked first so the item does not stack on itself
+        Unlink(p_Handle);
+
+        RoomItem l_Moved = l_Item;
+        l_Moved.X        = p_X;
+        l_Moved.Y        = p_Y;
+        l_Moved.Rotation = p_Rotation;
+
+        uint16 l_Height = 0;
+        const bool l_Fits = CanPlace(l_Moved.X, l_Moved.Y, l_Moved.GetFootprintWidth(), l_Moved.GetFootprintLength(), l_Height);
+
+        if (l_Fits)
+        {
+            l_Moved.Z = l_Height;
+            l_Item    = l_Moved;
+            MarkDirty(p_Handle);
+        }
+
+        Link(p_Handle);
+        return l_Fits;
+    }
+    /// Pick up item
+    /// @p_Handle : Item
+    void TileIndex::Remove(Handle p_Handle)
+    {
+        if (!Get(p_Handle))
+            return;
+
+        Unlink(p_Handle);
+
+        m_ById.erase(m_Slots[p_Handle].Item.Id);
+        m_Slots[p_Handle].Used = false;
+        m_FreeSlots.push_back(p_Handle);
+        MarkDirty(p_Handle);
+    }
+    /// Change state of item, its tiles are left as they are
+    /// @p_Handle : Item
+    /// @p_State  : State
+    /// Returns false if item is not placed or already in state
+    bool TileIndex::SetState(Handle p_Handle, uint8 p_State)
+    {
+        if (!Get(p_Handle) || m_Slots[p_Handle].Item.State == p_State)
+            return false;
+
+        m_Slots[p_Handle].Item.State = p_State;
+        MarkDirty(p_Handle);
+        return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get item
+    /// @p_Handle : Item
+    RoomItem const* TileIndex::Get(Handle p_Handle) const
+    {
+        return p_Handle < m_Slots.size() && m_Slots[p_Handle].Used ? &m_Slots[p_Handle].Item : nullptr;
+    }
+    /// Get handle of item, TILE_INDEX_INVALID_HANDLE if not placed
+    /// @p_Id : Id of item
+    TileIndex::Handle TileIndex::Find(uint32 p_Id) const
+    {
+        auto l_Itr = m_ById.find(p_Id);
+        return l_Itr != m_ById.end() ? l_Itr->second : TILE_INDEX_INVALID_HANDLE;
+    }
+
+    /// Get items covering tile, bottom to top
+    /// @p_X : X of tile
+    /// @p_Y : Y of tile
+    std::vector<TileIndex::Handle> const& TileIndex::GetItemsOnTile(int16 p_X, int16 p_Y) const
+    {
+        if (p_X < 0 || p_Y < 0 || p_X >= m_Width || p_Y >= m_Height)
+            return s_EmptyTile;
+
+        return m_Tiles[GetIndex(p_X, p_Y)];
+    }
+    /// Get topmost item of tile, TILE_INDEX_INVALID_HANDLE if none
+    /// @p_X : X of tile
+    /// @p_Y : Y of tile
+    TileIndex::Handle TileIndex::GetTopItem(int16 p_X, int16 p_Y) const
+    {
+        if (p_X < 0 || p_Y < 0 || p_X >= m_Width || p_Y >= m_Height)
+            return TILE_INDEX_INVALID_HANDLE;
+
+        return m_TopItem[GetIndex(p_X, p_Y)];
+    }
+    /// Get height an item placed on tile would be placed at, floor height if tile is empty
+    /// @p_X : X of tile
+    /// @p_Y : Y of tile
+    uint16 TileIndex::GetStackHeight(int16 p_X, int16 p_Y) const
+    {
+        if (p_X < 0 || p_Y < 0 || p_X >= m_Width || p_Y >= m_Height)
+            return 0;
+
+        return m_StackHeight[GetIndex(p_X, p_Y)];
+    }
+    /// Check units can not end up on tile because of its topmost item
+    /// @p_X : X of tile
+    /// @p_Y : Y of tile
+    bool TileIndex::IsBlocking(int16 p_X, int16 p_Y) const
+    {
+        const Handle l_Top = GetTopItem(p_X, p_Y);
+        return l_Top != TILE_INDEX_INVALID_HANDLE && !m_Slots[l_Top].Item.IsWalkable();
+    }
+
+    /// Check an item fits on footprint and get the height it would be placed at
+    /// @p_X      : X of tile the footprint starts on
+    /// @p_Y      : Y of tile the footprint starts on
+    /// @p_Width  : Tiles covered on X
+    /// @p_Length : Tiles covered on Y
+    /// @p_Height : Output, height item would be placed at
+    bool TileIndex::CanPlace(int16 p_X, int16 p_Y, uint8 p_Width, uint8 p_Length, uint16& p_Height) const
+    {
+        if (p_Width == 0 || p_Length == 0 || p_X < 0 || p_Y < 0 || p_X + p_Width > m_Width || p_Y + p_Length > m_Height)
+            return false;
+
+        p_Height = 0;
+
+        for (int16 l_Y = p_Y; l_Y < p_Y + p_Length; l_Y++)
+        {
+            for (int16 l_X = p_X; l_X < p_X + p_Width; l_X++)
+            {
+                const uint32 l_Index = GetIndex(l_X, l_Y);
+
+                if (!m_Floor[l_Index])
+                    return false;
+
+                const Handle l_Top = m_TopItem[l_Index];
+                if (l_Top != TILE_INDEX_INVALID_HANDLE && !m_Slots[l_Top].Item.HasFlag(ROOM_ITEM_FLAG_CAN_STACK))
+                    return false;
+
+                p_Height = std::max(p_Height, m_StackHeight[l_Index]);
+            }
+        }
+
+        return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Link item into the tiles of its footprint, ordered by height
+    /// @p_Handle : Item
+    void TileIndex::Link(Handle p_Handle)
+    {
+        RoomItem const& l_Item = m_Slots[p_Handle].Item;
+
+        for (int16 l_Y = l_Item.Y; l_Y < l_Item.Y + l_Item.GetFootprintLength(); l_Y++)
+        {
+            for (int16 l_X = l_Item.X; l_X < l_Item.X + l_Item.GetFootprintWidth(); l_X++)
+            {
+                const uint32 l_Index = GetIndex(l_X, l_Y);
+                std::vector<Handle>& l_Tile = m_Tiles[l_Index];
+
+                auto l_Position = std::upper_bound(l_Tile.begin(), l_Tile.end(), l_Item.Z, [this](uint16 p_Z, Handle p_Other) { return p_Z < m_Slots[p_Other].Item.Z; });
+                l_Tile.insert(l_Position, p_Handle);
+
+                Refresh(l_Index);
+            }
+        }
+    }
+    /// Unlink item from the tiles of its footprint
+    /// @p_Handle : Item
+    void TileIndex::Unlink(Handle p_Handle)
+    {
+        RoomItem const& l_Item = m_Slots[p_Handle].Item;
+
+        for (int16 l_Y = l_Item.Y; l_Y < l_Item.Y + l_Item.GetFootprintLength(); l_Y++)
+        {
+            for (int16 l_X = l_Item.X; l_X < l_Item.X + l_Item.GetFootprintWidth(); l_X++)
+            {
+                const uint32 l_Index = GetIndex(l_X, l_Y);
+                std::vector<Handle>& l_Tile = m_Tiles[l_Index];
+
+                /// Buckets keep their capacity, dragging an item around does not allocate once warmed up
+                l_Tile.erase(std::remove(l_Tile.begin(), l_Tile.end(), p_Handle), l_Tile.end());
+
+                Refresh(l_Index);
+            }
+        }
+    }
+    /// Recompute stack height and topmost item of tile
+    /// @p_Index : Index of tile
+    void TileIndex::Refresh(uint32 p_Index)
+    {
+        m_StackHeight[p_Index] = m_FloorHeight[p_Index];
+        m_TopItem[p_Index]     = TILE_INDEX_INVALID_HANDLE;
+
+        for (Handle l_Handle : m_Tiles[p_Index])
+        {
+            const uint16 l_Top = m_Slots[l_Handle].Item.GetTopHeight();
+            if (l_Top >= m_StackHeight[p_Index])
+            {
+                m_StackHeight[p_Index] = l_Top;
+                m_TopItem[p_Index]     = l_Handle;
+            }
+        }
+    }
+    /// Mark segment of item dirty
+    /// @p_Handle : Item
+    void TileIndex::MarkDirty(Handle p_Handle)
+    {
+        const uint32 l_Segment = p_Handle / TILE_INDEX_SEGMENT_SIZE;
+        if (l_Segment >= m_SegmentDirty.size())
+            m_SegmentDirty.resize(l_Segment + 1, 0);
+
+        if (m_SegmentDirty[l_Segment])
+            return;
+
+        m_SegmentDirty[l_Segment] = 1;
+        m_DirtySegments.push_back(l_Segment);
+    }
+
+}   ///< namespace Map
+}   ///< namespace Game
+}   ///< namespace Steerstone
@@ -0,0 +1,216 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+#include "RoomItem.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#define TILE_INDEX_INVALID_HANDLE   0xFFFFFFFF      ///< Handle of no item
+#define TILE_INDEX_SEGMENT_SIZE     64              ///< Handles per segment, the unit cached room entry payloads are serialized in
+
+namespace SteerStone { namespace Game { namespace Map {
+
+    class RoomModel;
+
+    /// Spatial index of the floor furni of a room
+    /// Every tile keeps the handles of the items covering it ordered bottom to top, along with a cached stack height
+    /// and topmost item, so tile and footprint queries never scan the item list. Place, move and pickup only touch
+    /// the tiles of the footprints involved. Handles are grouped in segments which are marked dirty whenever one
+    /// of their items changes, so serialized copies of the items only rebuild what changed. Strand of room only
+    class TileIndex
+    {
+        DISALLOW_COPY_AND_ASSIGN(TileIndex);
+
+        public:
+            /// Handle of an indexed item, stable until the item is removed
+            using Handle = uint32;
+
+        public:
+            /// Constructor
+            /// @p_Model : Floor of room
+            explicit TileIndex(RoomModel const& p_Model);
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Place item on the tiles of its footprint, on top of the stack already there
+            /// @p_Item : Item, Z is set to the height it is placed at
+            /// Returns TILE_INDEX_INVALID_HANDLE if footprint is off the floor, already indexed or a tile can not be stacked on
+            Handle Place(RoomItem const& p_Item);
+            /// Move item, it stays where it was if it does not fit on its new tiles
+            /// @p_Handle   : Item
+            /// @p_X        : X of tile the footprint starts on
+            /// @p_Y        : Y of tile the footprint starts on
+            /// @p_Rotation : Rotation
+            bool Move(Handle p_Handle, int16 p_X, int16 p_Y, uint8 p_Rotation);
+            /// Pick up item
+            /// @p_Handle : Item
+            void Remove(Handle p_Handle);
+            /// Change state of item, its tiles are left as they are
+            /// @p_Handle : Item
+            /// @p_State  : State
+            /// Returns false if item is not placed or already in state
+            bool SetState(Handle p_Handle, uint8 p_State);
+
+            /// Get item
+            /// @p_Handle : Item
+            RoomItem const* Get(Handle p_Handle) const;
+            /// Get handle of item, TILE_INDEX_INVALID_HANDLE if not placed
+            /// @p_Id : Id of item
+            Handle Find(uint32 p_Id) const;
+            /// Get amount of placed items
+            std::size_t GetSize() const { return m_ById.size(); }
+
+            /// Get amount of segments handles are grouped in
+            uint32 GetSegmentCount() const { return static_cast<uint32>((m_Slots.size() + TILE_INDEX_SEGMENT_SIZE - 1) / TILE_INDEX_SEGMENT_SIZE); }
+            /// Call function for every segment changed since the last call and mark them clean
+            /// @p_Function : Called with segment
+            template<typename t_Function> void ConsumeDirtySegments(t_Function p_Function)
+            {
+                for (uint32 l_Segment : m_DirtySegments)
+                {
+                    m_SegmentDirty[l_Segment] = 0;
+                    p_Function(l_Segment);
+                }
+
+                m_DirtySegments.clear();
+            }
+            /// Call function for every item of a segment
+            /// @p_Segment  : Segment
+            /// @p_Function : Called with handle and item
+            template<typename t_Function> void ForEachInSegment(uint32 p_Segment, t_Function p_Function) const
+            {
+                const std::size_t l_End = std::min<std::size_t>((static_cast<std::size_t>(p_Segment) + 1) * TILE_INDEX_SEGMENT_SIZE, m_Slots.size());
+
+                for (std::size_t l_Handle = static_cast<std::size_t>(p_Segment) * TILE_INDEX_SEGMENT_SIZE; l_Handle < l_End; l_Handle++)
+                {
+                    if (m_Slots[l_Handle].Used)
+                        p_Function(static_cast<Handle>(l_Handle), m_Slots[l_Handle].Item);
+                }
+            }
+
+            /// Get items covering tile, bottom to top
+            /// @p_X : X of tile
+            /// @p_Y : Y of tile
+            std::vector<Handle> const& GetItemsOnTile(int16 p_X, int16 p_Y) const;
+            /// Get topmost item of tile, TILE_INDEX_INVALID_HANDLE if none
+            /// @p_X : X of tile
+            /// @p_Y : Y of tile
+            Handle GetTopItem(int16 p_X, int16 p_Y) const;
+            /// Get height an item placed on tile would be placed at, floor height if tile is empty
+            /// @p_X : X of tile
+            /// @p_Y : Y of tile
+            uint16 GetStackHeight(int16 p_X, int16 p_Y) const;
+            /// Check units can not end up on tile because of its topmost item
+            /// @p_X : X of tile
+            /// @p_Y : Y of tile
+            bool IsBlocking(int16 p_X, int16 p_Y) const;
+
+            /// Check an item fits on footprint and get the height it would be placed at
+            /// @p_X      : X of tile the footprint starts on
+            /// @p_Y      : Y of tile the footprint starts on
+            /// @p_Width  : Tiles covered on X
+            /// @p_Length : Tiles covered on Y
+            /// @p_Height : Output, height item would be placed at
+            bool CanPlace(int16 p_X, int16 p_Y, uint8 p_Width, uint8 p_Length, uint16& p_Height) const;
+
+            /// Call function once for every item overlapping footprint
+            /// @p_X        : X of tile the footprint starts on
+            /// @p_Y        : Y of tile the footprint starts on
+            /// @p_Width    : Tiles covered on X
+            /// @p_Length   : Tiles covered on Y
+            /// @p_Function : Called with handle and item
+            template<typename t_Function> void ForEachInFootprint(int16 p_X, int16 p_Y, uint8 p_Width, uint8 p_Length, t_Function p_Function)
+            {
+                /// Items covering several tiles of the footprint are only reported on the first one
+                if (++m_QueryStamp == 0)
+                {
+                    for (Slot& l_Slot : m_Slots)
+                        l_Slot.QueryStamp = 0;
+                    m_QueryStamp = 1;
+                }
+
+                for (int16 l_Y = std::max<int16>(p_Y, 0); l_Y < std::min<int32>(p_Y + p_Length, m_Height); l_Y++)
+                {
+                    for (int16 l_X = std::max<int16>(p_X, 0); l_X < std::min<int32>(p_X + p_Width, m_Width); l_X++)
+                    {
+                        for (Handle l_Handle : m_Tiles[GetIndex(l_X, l_Y)])
+                        {
+                            Slot& l_Slot = m_Slots[l_Handle];
+                            if (l_Slot.QueryStamp == m_QueryStamp)
+                                continue;
+
+                            l_Slot.QueryStamp = m_QueryStamp;
+                            p_Function(l_Handle, static_cast<RoomItem const&>(l_Slot.Item));
+                        }
+                    }
+                }
+            }
+
+        private:
+            /// Storage of an item
+            struct Slot
+            {
+                RoomItem Item;                      ///< Item
+                bool Used;                          ///< Slot holds an item
+                uint32 QueryStamp;                  ///< Last footprint query which reported the item
+            };
+
+            /// Get index of tile
+            /// @p_X : X of tile
+            /// @p_Y : Y of tile
+            uint32 GetIndex(int16 p_X, int16 p_Y) const { return static_cast<uint32>(p_Y) * m_Width + p_X; }
+            /// Link item into the tiles of its footprint, ordered by height
+            /// @p_Handle : Item
+            void Link(Handle p_Handle);
+            /// Unlink item from the tiles of its footprint
+            /// @p_Handle : Item
+            void Unlink(Handle p_Handle);
+            /// Recompute stack height and topmost item of tile
+            /// @p_Index : Index of tile
+            void Refresh(uint32 p_Index);
+            /// Mark segment of item dirty
+            /// @p_Handle : Item
+            void MarkDirty(Handle p_Handle);
+
+        private:
+            int16 m_Width;                                  ///< Width in tiles
+            int16 m_Height;                                 ///< Height in tiles
+            std::vector<uint8> m_Floor;                     ///< Tile is floor
+            std::vector<uint16> m_FloorHeight;              ///< Floor height of every tile in hundredths
+            std::vector<std::vector<Handle>> m_Tiles;       ///< Items covering every tile, bottom to top
+            std::vector<uint16> m_StackHeight;              ///< Top of the stack of every tile in hundredths
+            std::vector<Handle> m_TopItem;                  ///< Topmost item of every tile
+            std::vector<Slot> m_Slots;                      ///< Item storage indexed by handle
+            std::vector<Handle> m_FreeSlots;                ///< Slots of removed items
+            std::unordered_map<uint32, Handle> m_ById;      ///< Handle of every placed item id
+            uint32 m_QueryStamp;                            ///< Current footprint query
+            std::vector<uint8> m_SegmentDirty;              ///< Segment has changed since it was last consumed
+            std::vector<uint32> m_DirtySegments;            ///< Segments changed since they were last consumed
+    };
+
+}   ///< namespace Map
+}   ///< namespace Game
+}   ///< namespace Steerstone
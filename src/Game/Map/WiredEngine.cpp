@@ -0,0 +1,461 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include "WiredEngine.hpp"
+#include "Room.hpp"
+#include "TileIndex.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+namespace SteerStone { namespace Game { namespace Map {
+
+    /// Check character is part of a word, keywords only match whole words
+    /// @p_Char : Character
+    static bool IsWordCharacter(char p_Char)
+    {
+        return std::isalnum(static_cast<unsigned char>(p_Char)) != 0;
+    }
+    /// Lower case character
+    /// @p_Char : Character
+    static char ToLower(char p_Char)
+    {
+        return static_cast<char>(std::tolower(static_cast<unsigned char>(p_Char)));
+    }
+    /// Remove stack from an item index
+    /// @p_Index : Index
+    /// @p_Item  : Id of watched item
+    /// @p_Id    : Id of trigger item
+    static void UnlinkItem(std::unordered_map<uint32, std::vector<uint32>>& p_Index, uint32 p_Item, uint32 p_Id)
+    {
+        auto l_Itr = p_Index.find(p_Item);
+        if (l_Itr == p_Index.end())
+            return;
+
+        l_Itr->second.erase(std::remove(l_Itr->second.begin(), l_Itr->second.end(), p_Id), l_Itr->second.end());
+        if (l_Itr->second.empty())
+            p_Index.erase(l_Itr);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    /// @p_Now : Server time
+    WiredEngine::WiredEngine(uint32 p_Now)
+        : m_Generation(0), m_TrieDirty(false), m_WheelTick(p_Now / WIRED_TIMER_RESOLUTION), m_Dropped(0)
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Add stack, replaces the stack of the same trigger item
+    /// @p_Stack : Stack
+    /// @p_Now   : Server time, timers first run one interval after
+    /// Returns false if stack holds too many conditions or effects or its keyword is empty or too long
+    bool WiredEngine::Add(WiredStack p_Stack, uint32 p_Now)
+    {
+        if (p_Stack.Conditions.size() > WIRED_MAX_CONDITIONS || p_Stack.Effects.size() > WIRED_MAX_EFFECTS)
+            return false;
+
+        if (p_Stack.Trigger == WiredTriggerType::Chat)
+        {
+            if (p_Stack.Keyword.empty() || p_Stack.Keyword.size() > WIRED_MAX_KEYWORD_LENGTH)
+                return false;
+
+            std::transform(p_Stack.Keyword.begin(), p_Stack.Keyword.end(), p_Stack.Keyword.begin(), ToLower);
+        }
+
+        /// Timers are rounded up to the slots of the wheel
+        if (p_Stack.Trigger == WiredTriggerType::Timer)
+            p_Stack.Interval = std::max<uint32>(p_Stack.Interval, WIRED_TIMER_RESOLUTION);
+
+        Remove(p_Stack.Id);
+
+        const uint32 l_Id = p_Stack.Id;
+        Entry& l_Entry = m_Stacks[l_Id];
+        l_Entry.Stack       = std::move(p_Stack);
+        l_Entry.Generation  = m_Generation++;
+
+        Link(l_Entry, p_Now);
+        return true;
+    }
+    /// Remove stack
+    /// @p_Id : Id of trigger item
+    void WiredEngine::Remove(uint32 p_Id)
+    {
+        auto l_Itr = m_Stacks.find(p_Id);
+        if (l_Itr == m_Stacks.end())
+            return;
+
+        Unlink(l_Itr->second.Stack);
+        m_Stacks.erase(l_Itr);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Unit arrived on tile
+    /// @p_Items  : Floor items of room
+    /// @p_X      : X of tile
+    /// @p_Y      : Y of tile
+    /// @p_UnitId : Id of unit
+    void WiredEngine::OnWalkOn(TileIndex const& p_Items, int16 p_X, int16 p_Y, uint32 p_UnitId)
+    {
+        if (!m_WalkOn.empty())
+            QueueTile(m_WalkOn, p_Items, p_X, p_Y, p_UnitId);
+    }
+    /// Unit left tile
+    /// @p_Items  : Floor items of room
+    /// @p_X      : X of tile
+    /// @p_Y      : Y of tile
+    /// @p_UnitId : Id of unit
+    void WiredEngine::OnWalkOff(TileIndex const& p_Items, int16 p_X, int16 p_Y, uint32 p_UnitId)
+    {
+        if (!m_WalkOff.empty())
+            QueueTile(m_WalkOff, p_Items, p_X, p_Y, p_UnitId);
+    }
+    /// User said something
+    /// @p_Message : Message
+    /// @p_UnitId  : Id of unit of user
+    void WiredEngine::OnChat(std::string_view p_Message, uint32 p_UnitId)
+    {
+        if (m_ChatStacks.empty())
+            return;
+
+        if (m_TrieDirty)
+            BuildTrie();
+
+        /// Walk the trie from the start of every word, a keyword matches if a word ends where it does
+        std::vector<uint32> l_Matched;
+        for (std::size_t l_Start = 0; l_Start < p_Message.size(); l_Start++)
+        {
+            if (l_Start > 0 && IsWordCharacter(p_Message[l_Start - 1]))
+                continue;
+
+            uint32 l_Node = 0;
+            for (std::size_t l_I = l_Start; l_I < p_Message.size(); l_I++)
+            {
+                const char l_Char = ToLower(p_Message[l_I]);
+
+                auto const& l_Children = m_Trie[l_Node].Children;
+                auto l_Child = std::find_if(l_Children.begin(), l_Children.end(), [l_Char](std::pair<char, uint32> const& p_Child) { return p_Child.first == l_Char; });
+                if (l_Child == l_Children.end())
+                    break;
+
+                l_Node = l_Child->second;
+
+                if (!m_Trie[l_Node].Stacks.empty() && (l_I + 1 == p_Message.size() || !IsWordCharacter(p_Message[l_I + 1])))
+                    l_Matched.insert(l_Matched.end(), m_Trie[l_Node].Stacks.begin(), m_Trie[l_Node].Stacks.end());
+            }
+        }
+
+        std::sort(l_Matched.begin(), l_Matched.end());
+        l_Matched.erase(std::unique(l_Matched.begin(), l_Matched.end()), l_Matched.end());
+
+        for (uint32 l_Id : l_Matched)
+            Queue(l_Id, p_UnitId);
+    }
+    /// Item changed state
+    /// @p_ItemId : Id of item
+    /// @p_UnitId : Id of unit which caused it, 0 if none
+    void WiredEngine::OnStateChange(uint32 p_ItemId, uint32 p_UnitId)
+    {
+        auto l_Itr = m_StateChange.find(p_ItemId);
+        if (l_Itr == m_StateChange.end())
+            return;
+
+        for (uint32 l_Id : l_Itr->second)
+            Queue(l_Id, p_UnitId);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Fire elapsed timers and run queued stacks, bounded per call
+    /// @p_Room : Room effects apply to
+    /// @p_Now  : Server time
+    void WiredEngine::Update(Room& p_Room, uint32 p_Now)
+    {
+        AdvanceTimers(p_Now);
+
+        /// Stacks triggered by our effects are queued behind, they run on this tick only while budget is left
+        for (uint32 l_Run = 0; l_Run < WIRED_MAX_ACTIVATIONS_PER_TICK && !m_Pending.empty(); l_Run++)
+        {
+            const Activation l_Activation = m_Pending.front();
+            m_Pending.pop_front();
+
+            auto l_Itr = m_Stacks.find(l_Activation.Id);
+            if (l_Itr == m_Stacks.end() || !CheckConditions(p_Room, l_Itr->second.Stack))
+                continue;
+
+            RunEffects(p_Room, l_Itr->second.Stack, l_Activation);
+        }
+
+        if (m_Dropped)
+        {
+            LOG_VERBOSE("Room", "Room %0 dropped %1 wired activations, %2 are waiting", p_Room.GetId(), m_Dropped, static_cast<uint32>(m_Pending.size()));
+            m_Dropped = 0;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Link stack into the index of its trigger
+    /// @p_Entry : Stack
+    /// @p_Now   : Server time
+    void WiredEngine::Link(Entry const& p_Entry, uint32 p_Now)
+    {
+        WiredStack const& l_Stack = p_Entry.Stack;
+
+        switch (l_Stack.Trigger)
+        {
+            case WiredTriggerType::WalkOn:
+                for (uint32 l_Item : l_Stack.Items)
+                    m_WalkOn[l_Item].push_back(l_Stack.Id);
+                break;
+            case WiredTriggerType::WalkOff:
+                for (uint32 l_Item : l_Stack.Items)
+                    m_WalkOff[l_Item].push_back(l_Stack.Id);
+                break;
+            case WiredTriggerType::StateChange:
+                for (uint32 l_Item : l_Stack.Items)
+                    m_StateChange[l_Item].push_back(l_Stack.Id);
+                break;
+            case WiredTriggerType::Chat:
+                m_ChatStacks.push_back(l_Stack.Id);
+                m_TrieDirty = true;
+                break;
+            case WiredTriggerType::Timer:
+                Arm({ l_Stack.Id, p_Entry.Generation, p_Now + l_Stack.Interval });
+                break;
+        }
+    }
+    /// Unlink stack from the index of its trigger
+    /// @p_Stack : Stack
+    void WiredEngine::Unlink(WiredStack const& p_Stack)
+    {
+        switch (p_Stack.Trigger)
+        {
+            case WiredTriggerType::WalkOn:
+                for (uint32 l_Item : p_Stack.Items)
+                    UnlinkItem(m_WalkOn, l_Item, p_Stack.Id);
+                break;
+            case WiredTriggerType::WalkOff:
+                for (uint32 l_Item : p_Stack.Items)
+                    UnlinkItem(m_WalkOff, l_Item, p_Stack.Id);
+                break;
+            case WiredTriggerType::StateChange:
+                for (uint32 l_Item : p_Stack.Items)
+                    UnlinkItem(m_StateChange, l_Item, p_Stack.Id);
+                break;
+            case WiredTriggerType::Chat:
+                m_ChatStacks.erase(std::remove(m_ChatStacks.begin(), m_ChatStacks.end(), p_Stack.Id), m_ChatStacks.end());
+                m_TrieDirty = true;
+                break;
+            case WiredTriggerType::Timer:
+                /// Armed timers are skipped once their generation is gone
+                break;
+        }
+    }
+    /// Queue stacks watching items covering tile
+    /// @p_Index  : Walk trigger index
+    /// @p_Items  : Floor items of room
+    /// @p_X      : X of tile
+    /// @p_Y      : Y of tile
+    /// @p_UnitId : Id of unit
+    void WiredEngine::QueueTile(std::unordered_map<uint32, std::vector<uint32>> const& p_Index, TileIndex const& p_Items, int16 p_X, int16 p_Y, uint32 p_UnitId)
+    {
+        for (TileIndex::Handle l_Handle : p_Items.GetItemsOnTile(p_X, p_Y))
+        {
+            auto l_Itr = p_Index.find(p_Items.Get(l_Handle)->Id);
+            if (l_Itr == p_Index.end())
+                continue;
+
+            for (uint32 l_Id : l_Itr->second)
+                Queue(l_Id, p_UnitId);
+        }
+    }
+    /// Queue stack
+    /// @p_Id     : Id of trigger item
+    /// @p_UnitId : Id of unit which triggered it, 0 if none
+    void WiredEngine::Queue(uint32 p_Id, uint32 p_UnitId)
+    {
+        if (m_Pending.size() >= WIRED_MAX_PENDING)
+        {
+            m_Dropped++;
+            return;
+        }
+
+        m_Pending.push_back({ p_Id, p_UnitId });
+    }
+    /// Arm timer in the wheel
+    /// @p_Timer : Timer
+    void WiredEngine::Arm(Timer const& p_Timer)
+    {
+        /// A slot already passed would only be visited on the next turn
+        uint32 l_Tick = (p_Timer.Due + WIRED_TIMER_RESOLUTION - 1) / WIRED_TIMER_RESOLUTION;
+        if (static_cast<int32>(l_Tick - m_WheelTick) <= 0)
+            l_Tick = m_WheelTick + 1;
+
+        m_Wheel[l_Tick % WIRED_TIMER_SLOTS].push_back(p_Timer);
+    }
+    /// Fire timers of wheel slots elapsed since the last call
+    /// @p_Now : Server time
+    void WiredEngine::AdvanceTimers(uint32 p_Now)
+    {
+        const uint32 l_Target = p_Now / WIRED_TIMER_RESOLUTION;
+        const int32 l_Elapsed = static_cast<int32>(l_Target - m_WheelTick);
+        if (l_Elapsed <= 0)
+            return;
+
+        /// Behind by a full turn or more, every slot is visited once
+        const uint32 l_Steps = std::min<uint32>(static_cast<uint32>(l_Elapsed), WIRED_TIMER_SLOTS);
+
+        std::vector<Timer> l_Rearm;
+        for (uint32 l_Step = 1; l_Step <= l_Steps; l_Step++)
+        {
+            std::vector<Timer>& l_Slot = m_Wheel[(m_WheelTick + l_Step) % WIRED_TIMER_SLOTS];
+
+            for (std::size_t l_I = 0; l_I < l_Slot.size();)
+            {
+                Timer const& l_Timer = l_Slot[l_I];
+
+                /// Due on a later turn of the wheel
+                if (static_cast<int32>(l_Timer.Due - p_Now) > 0)
+                {
+                    l_I++;
+                    continue;
+                }
+
+                auto l_Itr = m_Stacks.find(l_Timer.Id);
+                if (l_Itr != m_Stacks.end() && l_Itr->second.Generation == l_Timer.Generation)
+                {
+                    Queue(l_Timer.Id, 0);
+
+                    /// Intervals missed while behind are not made up for
+                    Timer l_Next = l_Timer;
+                    l_Next.Due += l_Itr->second.Stack.Interval;
+                    if (static_cast<int32>(l_Next.Due - p_Now) <= 0)
+                        l_Next.Due = p_Now + l_Itr->second.Stack.Interval;
+
+                    l_Rearm.push_back(l_Next);
+                }
+
+                l_Slot[l_I] = l_Slot.back();
+                l_Slot.pop_back();
+            }
+        }
+
+        m_WheelTick = l_Target;
+
+        for (Timer const& l_Timer : l_Rearm)
+            Arm(l_Timer);
+    }
+    /// Build keyword trie of chat stacks
+    void WiredEngine::BuildTrie()
+    {
+        m_Trie.assign(1, TrieNode());
+
+        for (uint32 l_Id : m_ChatStacks)
+        {
+            uint32 l_Node = 0;
+            for (char l_Char : m_Stacks[l_Id].Stack.Keyword)
+            {
+                auto& l_Children = m_Trie[l_Node].Children;
+                auto l_Child = std::find_if(l_Children.begin(), l_Children.end(), [l_Char](std::pair<char, uint32> const& p_Child) { return p_Child.first == l_Char; });
+
+                if (l_Child != l_Children.end())
+                {
+                    l_Node = l_Child->second;
+                    continue;
+                }
+
+                const uint32 l_New = static_cast<uint32>(m_Trie.size());
+                l_Children.emplace_back(l_Char, l_New);
+                m_Trie.emplace_back();
+                l_Node = l_New;
+            }
+
+            m_Trie[l_Node].Stacks.push_back(l_Id);
+        }
+
+        m_TrieDirty = false;
+    }
+    /// Check every condition of stack passes
+    /// @p_Room  : Room
+    /// @p_Stack : Stack
+    bool WiredEngine::CheckConditions(Room& p_Room, WiredStack const& p_Stack) const
+    {
+        for (WiredCondition const& l_Condition : p_Stack.Conditions)
+        {
+            RoomItem const* l_Item = p_Room.GetItems().Get(p_Room.GetItems().Find(l_Condition.ItemId));
+            if (!l_Item)
+                return false;
+
+            switch (l_Condition.Type)
+            {
+                case WiredConditionType::ItemState:
+                    if (l_Item->State != l_Condition.State)
+                        return false;
+                    break;
+                case WiredConditionType::ItemNotState:
+                    if (l_Item->State == l_Condition.State)
+                        return false;
+                    break;
+            }
+        }
+
+        return true;
+    }
+    /// Run effects of stack
+    /// @p_Room       : Room
+    /// @p_Stack      : Stack
+    /// @p_Activation : Activation
+    void WiredEngine::RunEffects(Room& p_Room, WiredStack const& p_Stack, Activation const& p_Activation)
+    {
+        /// Effects only queue further stacks, the stack we run is not touched meanwhile
+        for (WiredEffect const& l_Effect : p_Stack.Effects)
+        {
+            switch (l_Effect.Type)
+            {
+                case WiredEffectType::SetState:
+                    p_Room.SetItemState(l_Effect.ItemId, l_Effect.State, p_Activation.UnitId);
+                    break;
+                case WiredEffectType::ToggleState:
+                {
+                    RoomItem const* l_Item = p_Room.GetItems().Get(p_Room.GetItems().Find(l_Effect.ItemId));
+                    if (l_Item)
+                        p_Room.SetItemState(l_Effect.ItemId, l_Item->State ? 0 : 1, p_Activation.UnitId);
+                    break;
+                }
+                case WiredEffectType::WalkTo:
+                    if (p_Activation.UnitId)
+                        p_Room.MoveUnit(p_Activation.UnitId, l_Effect.X, l_Effect.Y);
+                    break;
+            }
+        }
+    }
+
+}   ///< namespace Map
+}   ///< namespace Game
+}   ///< namespace Steerstone
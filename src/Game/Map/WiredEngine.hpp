@@ -0,0 +1,239 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+
+#include <array>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#define WIRED_TIMER_SLOTS               64      ///< Slots of the timer wheel
+#define WIRED_TIMER_RESOLUTION          500     ///< MS covered by a slot of the timer wheel, timers are rounded up to it
+#define WIRED_MAX_ACTIVATIONS_PER_TICK  32      ///< Triggered stacks run on one tick, the rest wait for the next ones
+#define WIRED_MAX_PENDING               256     ///< Triggered stacks waiting to run, later activations are dropped
+#define WIRED_MAX_CONDITIONS            8       ///< Conditions of a stack
+#define WIRED_MAX_EFFECTS               16      ///< Effects of a stack
+#define WIRED_MAX_KEYWORD_LENGTH        64      ///< Length of a chat keyword
+
+namespace SteerStone { namespace Game { namespace Map {
+
+    class Room;
+    class TileIndex;
+
+    /// Event a wired stack reacts to
+    enum class WiredTriggerType : uint8
+    {
+        WalkOn,                 ///< A unit arrived on a tile covered by a watched item
+        WalkOff,                ///< A unit left a tile covered by a watched item
+        Chat,                   ///< A user said the keyword as a whole word
+        StateChange,            ///< A watched item changed state
+        Timer                   ///< Interval elapsed, repeats
+    };
+
+    /// Check made before the effects of a triggered stack run
+    enum class WiredConditionType : uint8
+    {
+        ItemState,              ///< Item is in state
+        ItemNotState            ///< Item is not in state
+    };
+
+    /// Action of a triggered stack
+    enum class WiredEffectType : uint8
+    {
+        SetState,               ///< Put item in state
+        ToggleState,            ///< Switch item between state 0 and 1
+        WalkTo                  ///< Make the unit which triggered the stack walk to a tile
+    };
+
+    /// Condition of a wired stack
+    struct WiredCondition
+    {
+        WiredConditionType Type;    ///< Type
+        uint32 ItemId;              ///< Item checked
+        uint8 State;                ///< State compared to
+    };
+
+    /// Effect of a wired stack
+    struct WiredEffect
+    {
+        WiredEffectType Type;       ///< Type
+        uint32 ItemId;              ///< Item changed, state effects only
+        uint8 State;                ///< State set, SetState only
+        int16 X;                    ///< X of tile, WalkTo only
+        int16 Y;                    ///< Y of tile, WalkTo only
+    };
+
+    /// Trigger placed in a room along with the conditions and effects stacked on it
+    struct WiredStack
+    {
+        uint32 Id;                                  ///< Id of trigger item
+        WiredTriggerType Trigger;                   ///< Event reacted to
+        std::vector<uint32> Items;                  ///< Items watched, walk and state triggers only
+        std::string Keyword;                        ///< Keyword, chat triggers only
+        uint32 Interval;                            ///< MS between two activations, timer triggers only
+        std::vector<WiredCondition> Conditions;     ///< Conditions, all must pass
+        std::vector<WiredEffect> Effects;           ///< Effects, run in order
+    };
+
+    /// Wired stacks of a room, indexed by the event they react to
+    /// Walk triggers are found through the items covering the tile walked on, chat triggers through a keyword trie
+    /// and timers through a timer wheel, so an event only touches the stacks it concerns. Triggered stacks are
+    /// queued and at most WIRED_MAX_ACTIVATIONS_PER_TICK run per tick, effects triggering further stacks included,
+    /// so a stack which triggers itself can not hold the strand. Strand of room only
+    class WiredEngine
+    {
+        DISALLOW_COPY_AND_ASSIGN(WiredEngine);
+
+        public:
+            /// Constructor
+            /// @p_Now : Server time
+            explicit WiredEngine(uint32 p_Now);
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Add stack, replaces the stack of the same trigger item
+            /// @p_Stack : Stack
+            /// @p_Now   : Server time, timers first run one interval after
+            /// Returns false if stack holds too many conditions or effects or its keyword is empty or too long
+            bool Add(WiredStack p_Stack, uint32 p_Now);
+            /// Remove stack
+            /// @p_Id : Id of trigger item
+            void Remove(uint32 p_Id);
+            /// Get amount of stacks
+            std::size_t GetSize() const { return m_Stacks.size(); }
+
+            /// Unit arrived on tile
+            /// @p_Items  : Floor items of room
+            /// @p_X      : X of tile
+            /// @p_Y      : Y of tile
+            /// @p_UnitId : Id of unit
+            void OnWalkOn(TileIndex const& p_Items, int16 p_X, int16 p_Y, uint32 p_UnitId);
+            /// Unit left tile
+            /// @p_Items  : Floor items of room
+            /// @p_X      : X of tile
+            /// @p_Y      : Y of tile
+            /// @p_UnitId : Id of unit
+            void OnWalkOff(TileIndex const& p_Items, int16 p_X, int16 p_Y, uint32 p_UnitId);
+            /// User said something
+            /// @p_Message : Message
+            /// @p_UnitId  : Id of unit of user
+            void OnChat(std::string_view p_Message, uint32 p_UnitId);
+            /// Item changed state
+            /// @p_ItemId : Id of item
+            /// @p_UnitId : Id of unit which caused it, 0 if none
+            void OnStateChange(uint32 p_ItemId, uint32 p_UnitId);
+
+            /// Fire elapsed timers and run queued stacks, bounded per call
+            /// @p_Room : Room effects apply to
+            /// @p_Now  : Server time
+            void Update(Room& p_Room, uint32 p_Now);
+
+        private:
+            /// Stack along with the generation its timers were armed with
+            struct Entry
+            {
+                WiredStack Stack;                   ///< Stack
+                uint32 Generation;                  ///< Bumped every time the stack is added, stale timers are skipped
+            };
+            /// Stack waiting to run
+            struct Activation
+            {
+                uint32 Id;                          ///< Id of trigger item
+                uint32 UnitId;                      ///< Id of unit which triggered it, 0 if none
+            };
+            /// Timer armed in the wheel
+            struct Timer
+            {
+                uint32 Id;                          ///< Id of trigger item
+                uint32 Generation;                  ///< Generation of stack when armed
+                uint32 Due;                         ///< Server time it fires at
+            };
+            /// Node of the keyword trie
+            struct TrieNode
+            {
+                std::vector<std::pair<char, uint32>> Children;     ///< Next character and node
+                std::vector<uint32> Stacks;                         ///< Stacks whose keyword ends here
+            };
+
+            /// Link stack into the index of its trigger
+            /// @p_Entry : Stack
+            /// @p_Now   : Server time
+            void Link(Entry const& p_Entry, uint32 p_Now);
+            /// Unlink stack from the index of its trigger
+            /// @p_Stack : Stack
+            void Unlink(WiredStack const& p_Stack);
+            /// Queue stacks watching items covering tile
+            /// @p_Index  : Walk trigger index
+            /// @p_Items  : Floor items of room
+            /// @p_X      : X of tile
+            /// @p_Y      : Y of tile
+            /// @p_UnitId : Id of unit
+            void QueueTile(std::unordered_map<uint32, std::vector<uint32>> const& p_Index, TileIndex const& p_Items, int16 p_X, int16 p_Y, uint32 p_UnitId);
+            /// Queue stack
+            /// @p_Id     : Id of trigger item
+            /// @p_UnitId : Id of unit which triggered it, 0 if none
+            void Queue(uint32 p_Id, uint32 p_UnitId);
+            /// Arm timer in the wheel
+            /// @p_Timer : Timer
+            void Arm(Timer const& p_Timer);
+            /// Fire timers of wheel slots elapsed since the last call
+            /// @p_Now : Server time
+            void AdvanceTimers(uint32 p_Now);
+            /// Build keyword trie of chat stacks
+            void BuildTrie();
+            /// Check every condition of stack passes
+            /// @p_Room  : Room
+            /// @p_Stack : Stack
+            bool CheckConditions(Room& p_Room, WiredStack const& p_Stack) const;
+            /// Run effects of stack
+            /// @p_Room       : Room
+            /// @p_Stack      : Stack
+            /// @p_Activation : Activation
+            void RunEffects(Room& p_Room, WiredStack const& p_Stack, Activation const& p_Activation);
+
+        private:
+            std::unordered_map<uint32, Entry> m_Stacks;                             ///< Stacks by id of trigger item
+            uint32 m_Generation;                                                    ///< Generation of the next stack added
+
+            std::unordered_map<uint32, std::vector<uint32>> m_WalkOn;               ///< Walk on stacks by id of watched item
+            std::unordered_map<uint32, std::vector<uint32>> m_WalkOff;              ///< Walk off stacks by id of watched item
+            std::unordered_map<uint32, std::vector<uint32>> m_StateChange;          ///< State change stacks by id of watched item
+
+            std::vector<uint32> m_ChatStacks;                                       ///< Chat stacks, the trie is built from
+            std::vector<TrieNode> m_Trie;                                           ///< Keyword trie, root first
+            bool m_TrieDirty;                                                       ///< Chat stacks changed since the trie was built
+
+            std::array<std::vector<Timer>, WIRED_TIMER_SLOTS> m_Wheel;              ///< Timers by slot of due time
+            uint32 m_WheelTick;                                                     ///< Last slot tick fired
+
+            std::deque<Activation> m_Pending;                                       ///< Stacks waiting to run
+            uint32 m_Dropped;                                                       ///< Activations dropped since last logged
+    };
+
+}   ///< namespace Map
+}   ///< namespace Game
+}   ///< namespace Steerstone
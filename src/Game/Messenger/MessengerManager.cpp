@@ -0,0 +1,337 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include "MessengerManager.hpp"
+#include "Config/Config.hpp"
+#include "Database/DatabaseTypes.hpp"
+#include "Database/GameStatements.hpp"
+#include "Server/Socket.hpp"
+#include "Session/SessionRegistry.hpp"
+
+#include <algorithm>
+#include <tuple>
+
+namespace SteerStone { namespace Game { namespace Messenger {
+
+    SINGLETON_P_I(MessengerManager);
+
+    /// Constructor
+    MessengerManager::MessengerManager()
+    {
+    }
+    /// Deconstructor
+    MessengerManager::~MessengerManager()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Read settings and start flushing pending updates
+    void MessengerManager::Initialize()
+    {
+        const uint32 l_Interval = std::max<int32>(sConfigManager->GetInt("MessengerFlushInterval", MESSENGER_FLUSH_INTERVAL), 1);
+
+        m_FlushTask = sThreadManager->PushTask("MESSENGER_FLUSH", Core::Threading::TaskType::Normal, l_Interval, [this]() -> bool
+        {
+            Flush();
+            return true;
+        });
+
+        LOG_INFO("Messenger", "Friend updates are flushed every %0 ms", l_Interval);
+    }
+    /// Stop flushing
+    void MessengerManager::Shutdown()
+    {
+        if (m_FlushTask)
+        {
+            sThreadManager->PopTask(m_FlushTask);
+            m_FlushTask.reset();
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// User logged in, friends are loaded on a task worker before anyone is told, network thread of socket only
+    /// @p_Session : Session of user
+    /// @p_Socket  : Socket of user
+    void MessengerManager::OnLogin(std::shared_ptr<Session::UserSession> const& p_Session, std::shared_ptr<Server::GameSocket> const& p_Socket)
+    {
+        NetworkExecutor l_Executor = p_Socket->GetAsioSocket().get_executor();
+        std::weak_ptr<Server::GameSocket> l_Socket = p_Socket;
+
+        sThreadManager->PushRunOnceTask(Core::Threading::TaskType::Normal, [this, p_Session, l_Socket, l_Executor]()
+        {
+            std::shared_ptr<std::vector<uint32>> l_Friends = std::make_shared<std::vector<uint32>>();
+
+            if (Core::Database::PreparedStatement* l_Statement = GameDatabase.GetPrepareStatement(GAME_SEL_MESSENGER_FRIENDS))
+            {
+                l_Statement->SetUint32(0, p_Session->GetUserId());
+
+                std::vector<MessengerFriendRow> l_Rows;
+                if (GameDatabase.Query(l_Statement, l_Rows))
+                {
+                    l_Friends->reserve(l_Rows.size());
+                    for (MessengerFriendRow const& l_Row : l_Rows)
+                        l_Friends->push_back(l_Row.FriendId);
+                }
+            }
+
+            std::sort(l_Friends->begin(), l_Friends->end());
+            l_Friends->erase(std::unique(l_Friends->begin(), l_Friends->end()), l_Friends->end());
+
+            std::unique_ptr<Presence> l_Presence = std::make_unique<Presence>();
+            l_Presence->UserId  = p_Session->GetUserId();
+            l_Presence->Session = p_Session.get();
+            l_Presence->Socket  = l_Socket;
+            l_Presence->Group   = GetGroup(l_Executor);
+            l_Presence->Friends = l_Friends;
+            l_Presence->RoomId  = 0;
+            l_Presence->Figure  = p_Session->GetProfile()->Figure;
+            l_Presence->Motto   = p_Session->GetProfile()->Motto;
+
+            FlushGroup* l_Group = l_Presence->Group;
+
+            {
+                /// Holding the socket keeps its logout after us, it is released once the presence lock is
+                std::shared_ptr<Server::GameSocket> l_Alive = l_Socket.lock();
+                if (!l_Alive || l_Alive->IsClosed())
+                    return;
+
+                /// Logged in again meanwhile, the newer login registers its own presence
+                if (sSessionRegistry->FindById(p_Session->GetUserId()).get() != p_Session.get())
+                    return;
+
+                std::unique_lock<std::shared_mutex> l_Guard(m_Mutex);
+                m_Presences[p_Session->GetUserId()] = std::move(l_Presence);
+            }
+
+            /// The user gets the status of every friend on the first flush, friends get ours
+            if (!l_Friends->empty())
+            {
+                std::lock_guard<std::mutex> l_Guard(l_Group->Mutex);
+
+                PendingUpdate& l_Pending = l_Group->Pending[p_Session->GetUserId()];
+                l_Pending.Socket = l_Socket;
+                l_Pending.Friends.insert(l_Pending.Friends.end(), l_Friends->begin(), l_Friends->end());
+            }
+
+            Notify(p_Session->GetUserId(), *l_Friends);
+        });
+    }
+    /// User logged out, a session replaced by a newer login of the same user is ignored
+    /// @p_Session : Session of user
+    void MessengerManager::OnLogout(Session::UserSession const* p_Session)
+    {
+        if (!p_Session)
+            return;
+
+        std::shared_ptr<std::vector<uint32> const> l_Friends;
+        {
+            std::unique_lock<std::shared_mutex> l_Guard(m_Mutex);
+
+            auto l_Itr = m_Presences.find(p_Session->GetUserId());
+            if (l_Itr == m_Presences.end() || l_Itr->second->Session != p_Session)
+                return;
+
+            l_Friends = std::move(l_Itr->second->Friends);
+            m_Presences.erase(l_Itr);
+        }
+
+        Notify(p_Session->GetUserId(), *l_Friends);
+    }
+    /// User entered or left a room
+    /// @p_UserId : Id of user
+    /// @p_RoomId : Id of room, 0 if none
+    void MessengerManager::OnRoomChange(uint32 p_UserId, uint32 p_RoomId)
+    {
+        std::shared_ptr<std::vector<uint32> const> l_Friends;
+        {
+            std::unique_lock<std::shared_mutex> l_Guard(m_Mutex);
+
+            auto l_Itr = m_Presences.find(p_UserId);
+            if (l_Itr == m_Presences.end() || l_Itr->second->RoomId == p_RoomId)
+                return;
+
+            l_Itr->second->RoomId = p_RoomId;
+            l_Friends = l_Itr->second->Friends;
+        }
+
+        Notify(p_UserId, *l_Friends);
+    }
+    /// User changed figure or motto
+    /// @p_UserId : Id of user
+    /// @p_Figure : Figure
+    /// @p_Motto  : Motto
+    void MessengerManager::OnProfileChange(uint32 p_UserId, std::string const& p_Figure, std::string const& p_Motto)
+    {
+        std::shared_ptr<std::vector<uint32> const> l_Friends;
+        {
+            std::unique_lock<std::shared_mutex> l_Guard(m_Mutex);
+
+            auto l_Itr = m_Presences.find(p_UserId);
+            if (l_Itr == m_Presences.end() || (l_Itr->second->Figure == p_Figure && l_Itr->second->Motto == p_Motto))
+                return;
+
+            l_Itr->second->Figure = p_Figure;
+            l_Itr->second->Motto  = p_Motto;
+            l_Friends = l_Itr->second->Friends;
+        }
+
+        Notify(p_UserId, *l_Friends);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Add user to the pending set of every online friend of theirs
+    /// @p_UserId  : Id of user
+    /// @p_Friends : Ids of friends
+    void MessengerManager::Notify(uint32 p_UserId, std::vector<uint32> const& p_Friends)
+    {
+        if (p_Friends.empty())
+            return;
+
+        /// Recipients are collected first so each group is locked once instead of once per friend
+        std::vector<std::tuple<FlushGroup*, uint32, std::weak_ptr<Server::GameSocket>>> l_Recipients;
+        {
+            std::shared_lock<std::shared_mutex> l_Guard(m_Mutex);
+
+            l_Recipients.reserve(std::min(p_Friends.size(), m_Presences.size()));
+            for (uint32 l_FriendId : p_Friends)
+            {
+                auto l_Itr = m_Presences.find(l_FriendId);
+                if (l_Itr != m_Presences.end())
+                    l_Recipients.emplace_back(l_Itr->second->Group, l_FriendId, l_Itr->second->Socket);
+            }
+        }
+
+        std::sort(l_Recipients.begin(), l_Recipients.end(), [](auto const& p_Left, auto const& p_Right)
+        {
+            return std::get<0>(p_Left) < std::get<0>(p_Right);
+        });
+
+        for (std::size_t l_I = 0; l_I < l_Recipients.size();)
+        {
+            FlushGroup* l_Group = std::get<0>(l_Recipients[l_I]);
+
+            std::lock_guard<std::mutex> l_Guard(l_Group->Mutex);
+            for (; l_I < l_Recipients.size() && std::get<0>(l_Recipients[l_I]) == l_Group; l_I++)
+            {
+                PendingUpdate& l_Pending = l_Group->Pending[std::get<1>(l_Recipients[l_I])];
+                l_Pending.Socket = std::move(std::get<2>(l_Recipients[l_I]));
+                l_Pending.Friends.push_back(p_UserId);
+            }
+        }
+    }
+    /// Get flush group of a network thread, created on first use
+    /// @p_Executor : Executor of network thread
+    MessengerManager::FlushGroup* MessengerManager::GetGroup(NetworkExecutor const& p_Executor)
+    {
+        std::lock_guard<std::mutex> l_Guard(m_GroupMutex);
+
+        for (std::unique_ptr<FlushGroup> const& l_Group : m_Groups)
+            if (l_Group->Executor == p_Executor)
+                return l_Group.get();
+
+        m_Groups.push_back(std::make_unique<FlushGroup>(p_Executor));
+        return m_Groups.back().get();
+    }
+    /// Post pending updates of every group to its network thread
+    void MessengerManager::Flush()
+    {
+        std::vector<FlushGroup*> l_Groups;
+        {
+            std::lock_guard<std::mutex> l_Guard(m_GroupMutex);
+
+            l_Groups.reserve(m_Groups.size());
+            for (std::unique_ptr<FlushGroup> const& l_Group : m_Groups)
+                l_Groups.push_back(l_Group.get());
+        }
+
+        for (FlushGroup* l_Group : l_Groups)
+        {
+            std::shared_ptr<std::unordered_map<uint32, PendingUpdate>> l_Pending = std::make_shared<std::unordered_map<uint32, PendingUpdate>>();
+            {
+                std::lock_guard<std::mutex> l_Guard(l_Group->Mutex);
+                if (l_Group->Pending.empty())
+                    continue;
+
+                l_Pending->swap(l_Group->Pending);
+            }
+
+            /// One post per network thread, however many recipients it handles
+            boost::asio::post(l_Group->Executor, [this, l_Pending]()
+            {
+                Send(*l_Pending);
+            });
+        }
+    }
+    /// Write pending updates of a group, network thread of group only
+    /// @p_Pending : Pending updates by id of recipient
+    void MessengerManager::Send(std::unordered_map<uint32, PendingUpdate>& p_Pending)
+    {
+        for (auto& l_Itr : p_Pending)
+        {
+            /// Released after the presence lock, a last reference runs the logout of the socket
+            std::shared_ptr<Server::GameSocket> l_Socket = l_Itr.second.Socket.lock();
+            if (!l_Socket || l_Socket->IsClosed())
+                continue;
+
+            std::vector<uint32>& l_Friends = l_Itr.second.Friends;
+            std::sort(l_Friends.begin(), l_Friends.end());
+            l_Friends.erase(std::unique(l_Friends.begin(), l_Friends.end()), l_Friends.end());
+
+            Server::ServerMessage l_Message(Server::SERVER_FRIEND_UPDATE);
+            l_Message.AppendInt(static_cast<int32>(l_Friends.size()));
+            {
+                std::shared_lock<std::shared_mutex> l_Guard(m_Mutex);
+
+                /// The current status is sent, changes in between collapse into one entry
+                for (uint32 l_FriendId : l_Friends)
+                {
+                    l_Message.AppendInt(l_FriendId);
+
+                    auto l_Presence = m_Presences.find(l_FriendId);
+                    if (l_Presence != m_Presences.end())
+                    {
+                        l_Message.AppendBool(true);
+                        l_Message.AppendInt(l_Presence->second->RoomId);
+                        l_Message.AppendString(l_Presence->second->Figure);
+                        l_Message.AppendString(l_Presence->second->Motto);
+                    }
+                    else
+                    {
+                        l_Message.AppendBool(false);
+                        l_Message.AppendInt(0);
+                        l_Message.AppendString("");
+                        l_Message.AppendString("");
+                    }
+                }
+            }
+
+            l_Socket->Send(l_Message);
+        }
+    }
+
+}   ///< namespace Messenger
+}   ///< namespace Game
+}   ///< namespace Steerstone
@@ -0,0 +1,152 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <boost/asio.hpp>
+
+#include "Core/Core.hpp"
+#include "Singleton/Singleton.hpp"
+#include "Threading/ThrTaskManager.hpp"
+#include "Database/RowMapper.hpp"
+
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define MESSENGER_FLUSH_INTERVAL    1000    ///< Default MS between two flushes of pending friend updates
+
+namespace SteerStone { namespace Game {
+
+    namespace Server { class GameSocket; }
+    namespace Session { class UserSession; }
+
+namespace Messenger {
+
+    /// Executor of the network thread a socket is handled on
+    typedef boost::asio::ip::tcp::socket::executor_type NetworkExecutor;
+
+    /// Row of GAME_SEL_MESSENGER_FRIENDS
+    struct MessengerFriendRow
+    {
+        uint32 FriendId;            ///< Id of friend
+
+        DATABASE_ROW_FIELDS(&MessengerFriendRow::FriendId)
+    };
+
+    /// Presence of online users and fan out of their changes to online friends
+    /// A change is not sent right away: the user is added to the pending set of every online friend, and pending sets
+    /// are grouped by the network thread of their recipient. Every flush posts once to each network thread, which
+    /// writes one friend update per recipient holding the current status of every friend which changed meanwhile
+    class MessengerManager
+    {
+        SINGLETON_P_D(MessengerManager);
+
+        public:
+            /// Read settings and start flushing pending updates
+            void Initialize();
+            /// Stop flushing
+            void Shutdown();
+
+            /// User logged in, friends are loaded on a task worker before anyone is told, network thread of socket only
+            /// @p_Session : Session of user
+            /// @p_Socket  : Socket of user
+            void OnLogin(std::shared_ptr<Session::UserSession> const& p_Session, std::shared_ptr<Server::GameSocket> const& p_Socket);
+            /// User logged out, a session replaced by a newer login of the same user is ignored
+            /// @p_Session : Session of user
+            void OnLogout(Session::UserSession const* p_Session);
+            /// User entered or left a room
+            /// @p_UserId : Id of user
+            /// @p_RoomId : Id of room, 0 if none
+            void OnRoomChange(uint32 p_UserId, uint32 p_RoomId);
+            /// User changed figure or motto
+            /// @p_UserId : Id of user
+            /// @p_Figure : Figure
+            /// @p_Motto  : Motto
+            void OnProfileChange(uint32 p_UserId, std::string const& p_Figure, std::string const& p_Motto);
+
+        private:
+            struct FlushGroup;
+
+            /// Status of an online user
+            struct Presence
+            {
+                uint32 UserId;                                          ///< Id of user
+                Session::UserSession const* Session;                    ///< Session presence belongs to
+                std::weak_ptr<Server::GameSocket> Socket;               ///< Socket of user
+                FlushGroup* Group;                                      ///< Flush group of the network thread of socket
+                std::shared_ptr<std::vector<uint32> const> Friends;     ///< Ids of friends, never modified once loaded
+                uint32 RoomId;                                          ///< Room user is in, 0 if none
+                std::string Figure;                                     ///< Figure
+                std::string Motto;                                      ///< Motto
+            };
+
+            /// Friends which changed since the last flush, for one recipient
+            struct PendingUpdate
+            {
+                std::weak_ptr<Server::GameSocket> Socket;   ///< Socket of recipient
+                std::vector<uint32> Friends;                ///< Ids of friends which changed, may repeat
+            };
+
+            /// Pending updates of recipients handled by one network thread
+            struct FlushGroup
+            {
+                /// Constructor
+                /// @p_Executor : Executor of network thread
+                explicit FlushGroup(NetworkExecutor const& p_Executor)
+                    : Executor(p_Executor)
+                {
+                }
+
+                NetworkExecutor Executor;                                   ///< Executor of network thread
+                std::mutex Mutex;                                           ///< Guards pending updates
+                std::unordered_map<uint32, PendingUpdate> Pending;          ///< Pending updates by id of recipient
+            };
+
+            /// Add user to the pending set of every online friend of theirs
+            /// @p_UserId  : Id of user
+            /// @p_Friends : Ids of friends
+            void Notify(uint32 p_UserId, std::vector<uint32> const& p_Friends);
+            /// Get flush group of a network thread, created on first use
+            /// @p_Executor : Executor of network thread
+            FlushGroup* GetGroup(NetworkExecutor const& p_Executor);
+            /// Post pending updates of every group to its network thread
+            void Flush();
+            /// Write pending updates of a group, network thread of group only
+            /// @p_Pending : Pending updates by id of recipient
+            void Send(std::unordered_map<uint32, PendingUpdate>& p_Pending);
+
+        private:
+            mutable std::shared_mutex m_Mutex;                                      ///< Guards presences
+            std::unordered_map<uint32, std::unique_ptr<Presence>> m_Presences;      ///< Presences by id of user
+
+            std::mutex m_GroupMutex;                                                ///< Guards creation of groups
+            std::vector<std::unique_ptr<FlushGroup>> m_Groups;                      ///< Flush groups, one per network thread, never removed
+
+            Core::Threading::Task::Ptr m_FlushTask;                                 ///< Task flushing pending updates
+    };
+
+}   ///< namespace Messenger
+}   ///< namespace Game
+}   ///< namespace Steerstone
+
+#define sMessenger SteerStone::Game::Messenger::MessengerManager::GetSingleton()
@@ -0,0 +1,511 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "NavigatorManager.hpp"
+#include "Chat/WordFilterManager.hpp"
+#include "Database/DatabaseTypes.hpp"
+#include "Database/GameStatements.hpp"
+#include "Server/ServerMessage.hpp"
+
+#include <algorithm>
+
+namespace SteerStone { namespace Game { namespace Navigator {
+
+    SINGLETON_P_I(NavigatorManager);
+
+    /// Lower case copy of a string
+    /// @p_String : String
+    static std::string ToLower(std::string_view p_String)
+    {
+        std::string l_Lower(p_String);
+        std::transform(l_Lower.begin(), l_Lower.end(), l_Lower.begin(), [](unsigned char p_Char) { return static_cast<char>(std::tolower(p_Char)); });
+        return l_Lower;
+    }
+    /// Replace control characters, they would end the string inside a server message
+    /// @p_String : String
+    static void Sanitize(std::string& p_String)
+    {
+        std::replace_if(p_String.begin(), p_String.end(), [](unsigned char p_Char) { return p_Char < 0x20; }, ' ');
+    }
+
+    /// Constructor
+    NavigatorManager::NavigatorManager()
+    {
+    }
+    /// Deconstructor
+    NavigatorManager::~NavigatorManager()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Load rooms and categories, called once the game database is up
+    void NavigatorManager::Initialize()
+    {
+        std::vector<NavigatorCategoryInfo> l_Categories;
+        if (Core::Database::PreparedStatement* l_Statement = GameDatabase.GetPrepareStatement(GAME_SEL_NAVIGATOR_CATEGORIES))
+            GameDatabase.Query(l_Statement, l_Categories);
+
+        std::vector<NavigatorRoomInfo> l_Rooms;
+        if (Core::Database::PreparedStatement* l_Statement = GameDatabase.GetPrepareStatement(GAME_SEL_NAVIGATOR_ROOMS))
+            GameDatabase.Query(l_Statement, l_Rooms);
+
+        {
+            std::unique_lock<std::shared_mutex> l_Guard(m_Mutex);
+
+            for (NavigatorCategoryInfo& l_Category : l_Categories)
+            {
+                if (l_Category.Id == NAVIGATOR_POPULAR_CATEGORY)
+                    continue;
+
+                Sanitize(l_Category.Name);
+                GetOrCreateList(l_Category.Id).Name = std::move(l_Category.Name);
+            }
+        }
+
+        for (NavigatorRoomInfo const& l_Room : l_Rooms)
+            AddRoom(l_Room);
+
+        LOG_INFO("Navigator", "Loaded %0 rooms in %1 categories", l_Rooms.size(), l_Categories.size());
+    }
+
+    /// List room, a room already listed is replaced
+    /// @p_Info : Room
+    void NavigatorManager::AddRoom(NavigatorRoomInfo const& p_Info)
+    {
+        std::unique_ptr<Entry> l_Room = std::make_unique<Entry>();
+        l_Room->Info        = p_Info;
+        l_Room->UserCount   = 0;
+
+        Sanitize(l_Room->Info.Name);
+        Sanitize(l_Room->Info.Owner);
+        sWordFilter->Censor(l_Room->Info.Name);
+        l_Room->LowerName   = ToLower(l_Room->Info.Name);
+
+        std::unique_lock<std::shared_mutex> l_Guard(m_Mutex);
+
+        /// Users already inside stay counted
+        auto l_Itr = m_Rooms.find(p_Info.Id);
+        if (l_Itr != m_Rooms.end())
+        {
+            l_Room->UserCount = l_Itr->second->UserCount.load(std::memory_order_relaxed);
+            Unlist(l_Itr->second.get());
+            m_Rooms.erase(l_Itr);
+        }
+
+        Entry* l_Entry = l_Room.get();
+        m_Rooms.emplace(p_Info.Id, std::move(l_Room));
+
+        if (p_Info.CategoryId != NAVIGATOR_POPULAR_CATEGORY)
+            Insert(GetOrCreateList(p_Info.CategoryId), l_Entry);
+
+        Insert(GetOrCreateList(NAVIGATOR_POPULAR_CATEGORY), l_Entry);
+
+        IndexName(l_Entry);
+
+        auto l_Name = std::lower_bound(m_Names.begin(), m_Names.end(), l_Entry, [](Entry const* p_Left, Entry const* p_Right) { return p_Left->LowerName < p_Right->LowerName; });
+        m_Names.insert(l_Name, l_Entry);
+    }
+    /// Unlist room
+    /// @p_Id : Id of room
+    void NavigatorManager::RemoveRoom(uint32 p_Id)
+    {
+        std::unique_lock<std::shared_mutex> l_Guard(m_Mutex);
+
+        auto l_Itr = m_Rooms.find(p_Id);
+        if (l_Itr == m_Rooms.end())
+            return;
+
+        Unlist(l_Itr->second.get());
+        m_Rooms.erase(l_Itr);
+    }
+
+    /// User entered room, room strand
+    /// @p_Id : Id of room
+    void NavigatorManager::OnUserEnter(uint32 p_Id)
+    {
+        std::shared_lock<std::shared_mutex> l_Guard(m_Mutex);
+
+        auto l_Itr = m_Rooms.find(p_Id);
+        if (l_Itr == m_Rooms.end())
+            return;
+
+        Entry* l_Room = l_Itr->second.get();
+        l_Room->UserCount.fetch_add(1, std::memory_order_relaxed);
+
+        if (l_Room->Info.CategoryId != NAVIGATOR_POPULAR_CATEGORY)
+            AdjustUserCount(*m_Lists.at(l_Room->Info.CategoryId), l_Room, true);
+
+        AdjustUserCount(*m_Lists.at(NAVIGATOR_POPULAR_CATEGORY), l_Room, true);
+    }
+    /// User left room, room strand
+    /// @p_Id : Id of room
+    void NavigatorManager::OnUserLeave(uint32 p_Id)
+    {
+        std::shared_lock<std::shared_mutex> l_Guard(m_Mutex);
+
+        auto l_Itr = m_Rooms.find(p_Id);
+        if (l_Itr == m_Rooms.end())
+            return;
+
+        /// Only the strand of the room changes its count, a user who entered before the room was listed was not counted
+        Entry* l_Room = l_Itr->second.get();
+        if (l_Room->UserCount.load(std::memory_order_relaxed) == 0)
+            return;
+
+        l_Room->UserCount.fetch_sub(1, std::memory_order_relaxed);
+
+        if (l_Room->Info.CategoryId != NAVIGATOR_POPULAR_CATEGORY)
+            AdjustUserCount(*m_Lists.at(l_Room->Info.CategoryId), l_Room, false);
+
+        AdjustUserCount(*m_Lists.at(NAVIGATOR_POPULAR_CATEGORY), l_Room, false);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get serialized page of a tab, empty if the category does not exist
+    /// @p_CategoryId : Category, NAVIGATOR_POPULAR_CATEGORY for the popular tab
+    /// @p_Page       : Page, clamped to the last page
+    Core::Network::SharedPacket NavigatorManager::GetPage(uint32 p_CategoryId, uint32 p_Page)
+    {
+        std::shared_lock<std::shared_mutex> l_Guard(m_Mutex);
+
+        auto l_Itr = m_Lists.find(p_CategoryId);
+        if (l_Itr == m_Lists.end())
+            return Core::Network::SharedPacket();
+
+        RoomList& l_List = *l_Itr->second;
+        std::lock_guard<std::mutex> l_ListGuard(l_List.Mutex);
+
+        const std::size_t l_Visible   = l_List.OccupiedOnly ? l_List.Occupied : l_List.Order.size();
+        const uint32      l_PageCount = std::max<uint32>(1, static_cast<uint32>((l_Visible + NAVIGATOR_PAGE_SIZE - 1) / NAVIGATOR_PAGE_SIZE));
+
+        /// Every page tells the amount of pages, a change rebuilds all of them
+        if (l_PageCount != l_List.PageCount)
+        {
+            l_List.Pages.assign(l_PageCount, Core::Network::SharedPacket());
+            l_List.PageCount = l_PageCount;
+        }
+
+        const uint32 l_Page = std::min(p_Page, l_PageCount - 1);
+
+        Core::Network::SharedPacket& l_Cached = l_List.Pages[l_Page];
+        if (!l_Cached.GetBuffer())
+            l_Cached = BuildPage(l_List, l_Page, l_PageCount);
+
+        return l_Cached;
+    }
+    /// Search rooms by name regardless of case
+    /// @p_Query : Part of a room name
+    Core::Network::SharedPacket NavigatorManager::Search(std::string_view p_Query)
+    {
+        const std::string l_Query = ToLower(p_Query);
+
+        std::vector<std::pair<uint32, Entry const*>> l_Matches;
+
+        std::shared_lock<std::shared_mutex> l_Guard(m_Mutex);
+
+        if (l_Query.empty())
+        {
+            /// Nothing to match
+        }
+        else if (l_Query.size() < NAVIGATOR_TRIGRAM_LENGTH)
+        {
+            auto l_Itr = std::lower_bound(m_Names.begin(), m_Names.end(), l_Query, [](Entry const* p_Room, std::string const& p_Prefix) { return p_Room->LowerName < p_Prefix; });
+            for (; l_Itr != m_Names.end() && (*l_Itr)->LowerName.compare(0, l_Query.size(), l_Query) == 0; ++l_Itr)
+                l_Matches.emplace_back((*l_Itr)->UserCount.load(std::memory_order_relaxed), *l_Itr);
+        }
+        else
+        {
+            /// Rooms containing the rarest trigram of the query are the only candidates
+            std::vector<Entry*> const* l_Candidates = nullptr;
+            for (uint32 l_Trigram : GetTrigrams(l_Query))
+            {
+                auto l_Itr = m_Trigrams.find(l_Trigram);
+                if (l_Itr == m_Trigrams.end())
+                {
+                    l_Candidates = nullptr;
+                    break;
+                }
+
+                if (!l_Candidates || l_Itr->second.size() < l_Candidates->size())
+                    l_Candidates = &l_Itr->second;
+            }
+
+            if (l_Candidates)
+            {
+                for (Entry const* l_Room : *l_Candidates)
+                    if (l_Room->LowerName.find(l_Query) != std::string::npos)
+                        l_Matches.emplace_back(l_Room->UserCount.load(std::memory_order_relaxed), l_Room);
+            }
+        }
+
+        const std::size_t l_Count = std::min<std::size_t>(l_Matches.size(), NAVIGATOR_SEARCH_MAX_RESULTS);
+        std::partial_sort(l_Matches.begin(), l_Matches.begin() + l_Count, l_Matches.end(), [](auto const& p_Left, auto const& p_Right) { return p_Left.first > p_Right.first; });
+
+        Server::ServerMessage l_Message(Server::SERVER_FLAT_RESULTS);
+        l_Message.AppendInt(static_cast<int32>(l_Count));
+
+        for (std::size_t l_I = 0; l_I < l_Count; l_I++)
+            WriteRoom(l_Message, *l_Matches[l_I].second, l_Matches[l_I].first);
+
+        return l_Message.Finalize();
+    }
+
+    /// Get amount of listed rooms
+    std::size_t NavigatorManager::GetRoomCount() const
+    {
+        std::shared_lock<std::shared_mutex> l_Guard(m_Mutex);
+        return m_Rooms.size();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Remove room from its lists and the search index, rooms lock held exclusively
+    /// @p_Room : Room
+    void NavigatorManager::Unlist(Entry* p_Room)
+    {
+        if (p_Room->Info.CategoryId != NAVIGATOR_POPULAR_CATEGORY)
+            Erase(*m_Lists.at(p_Room->Info.CategoryId), p_Room);
+
+        Erase(*m_Lists.at(NAVIGATOR_POPULAR_CATEGORY), p_Room);
+
+        UnindexName(p_Room);
+
+        auto l_Name = std::lower_bound(m_Names.begin(), m_Names.end(), p_Room, [](Entry const* p_Left, Entry const* p_Right) { return p_Left->LowerName < p_Right->LowerName; });
+        while (l_Name != m_Names.end() && *l_Name != p_Room)
+            ++l_Name;
+
+        if (l_Name != m_Names.end())
+            m_Names.erase(l_Name);
+    }
+    /// Get list of category, created if needed, rooms lock held exclusively
+    /// @p_CategoryId : Category
+    NavigatorManager::RoomList& NavigatorManager::GetOrCreateList(uint32 p_CategoryId)
+    {
+        std::unique_ptr<RoomList>& l_List = m_Lists[p_CategoryId];
+        if (!l_List)
+        {
+            const bool l_Popular = p_CategoryId == NAVIGATOR_POPULAR_CATEGORY;
+
+            l_List = std::make_unique<RoomList>();
+            l_List->CategoryId      = p_CategoryId;
+            l_List->Name            = l_Popular ? "Popular" : "";
+            l_List->PositionSlot    = l_Popular ? LIST_SLOT_POPULAR : LIST_SLOT_CATEGORY;
+            l_List->OccupiedOnly    = l_Popular;
+            l_List->Occupied        = 0;
+            l_List->PageCount       = 0;
+        }
+
+        return *l_List;
+    }
+    /// Move room by a user in a list
+    /// @p_List  : List
+    /// @p_Room  : Room
+    /// @p_Enter : User entered, left otherwise
+    void NavigatorManager::AdjustUserCount(RoomList& p_List, Entry* p_Room, bool p_Enter)
+    {
+        std::lock_guard<std::mutex> l_Guard(p_List.Mutex);
+
+        std::vector<Slot>& l_Order = p_List.Order;
+        const std::size_t l_Position = p_Room->Position[p_List.PositionSlot];
+        const uint32 l_Count = l_Order[l_Position].UserCount;
+
+        /// Swapping with the edge of the run of rooms with the same count keeps the list sorted, only the two
+        /// positions change
+        std::size_t l_Target;
+        if (p_Enter)
+        {
+            l_Target = std::partition_point(l_Order.begin(), l_Order.begin() + l_Position, [l_Count](Slot const& p_Slot) { return p_Slot.UserCount > l_Count; }) - l_Order.begin();
+        }
+        else
+        {
+            if (l_Count == 0)
+                return;
+
+            l_Target = std::partition_point(l_Order.begin() + l_Position, l_Order.end(), [l_Count](Slot const& p_Slot) { return p_Slot.UserCount >= l_Count; }) - l_Order.begin() - 1;
+        }
+
+        if (l_Target != l_Position)
+        {
+            std::swap(l_Order[l_Target], l_Order[l_Position]);
+            l_Order[l_Position].Room->Position[p_List.PositionSlot] = static_cast<uint32>(l_Position);
+            l_Order[l_Target].Room->Position[p_List.PositionSlot]   = static_cast<uint32>(l_Target);
+            Invalidate(p_List, l_Position);
+        }
+
+        if (p_Enter)
+        {
+            if (l_Order[l_Target].UserCount++ == 0)
+                p_List.Occupied++;
+        }
+        else
+        {
+            if (--l_Order[l_Target].UserCount == 0)
+                p_List.Occupied--;
+        }
+
+        Invalidate(p_List, l_Target);
+    }
+    /// Add room to a list, rooms lock held exclusively
+    /// @p_List : List
+    /// @p_Room : Room
+    void NavigatorManager::Insert(RoomList& p_List, Entry* p_Room)
+    {
+        std::lock_guard<std::mutex> l_Guard(p_List.Mutex);
+
+        const uint32 l_Count = p_Room->UserCount.load(std::memory_order_relaxed);
+
+        std::vector<Slot>& l_Order = p_List.Order;
+        auto l_Itr = std::partition_point(l_Order.begin(), l_Order.end(), [l_Count](Slot const& p_Slot) { return p_Slot.UserCount >= l_Count; });
+        const std::size_t l_Position = l_Itr - l_Order.begin();
+
+        l_Order.insert(l_Itr, Slot{ p_Room, l_Count });
+        for (std::size_t l_I = l_Position; l_I < l_Order.size(); l_I++)
+            l_Order[l_I].Room->Position[p_List.PositionSlot] = static_cast<uint32>(l_I);
+
+        if (l_Count)
+            p_List.Occupied++;
+
+        /// Rooms shift down a spot, rooms are listed rarely enough to rebuild every page
+        p_List.PageCount = 0;
+    }
+    /// Remove room from a list, rooms lock held exclusively
+    /// @p_List : List
+    /// @p_Room : Room
+    void NavigatorManager::Erase(RoomList& p_List, Entry* p_Room)
+    {
+        std::lock_guard<std::mutex> l_Guard(p_List.Mutex);
+
+        std::vector<Slot>& l_Order = p_List.Order;
+        const std::size_t l_Position = p_Room->Position[p_List.PositionSlot];
+
+        if (l_Order[l_Position].UserCount)
+            p_List.Occupied--;
+
+        l_Order.erase(l_Order.begin() + l_Position);
+        for (std::size_t l_I = l_Position; l_I < l_Order.size(); l_I++)
+            l_Order[l_I].Room->Position[p_List.PositionSlot] = static_cast<uint32>(l_I);
+
+        p_List.PageCount = 0;
+    }
+    /// Drop cached pages showing a position, list lock held
+    /// @p_List     : List
+    /// @p_Position : Position in list which changed
+    void NavigatorManager::Invalidate(RoomList& p_List, std::size_t p_Position)
+    {
+        const std::size_t l_Page = p_Position / NAVIGATOR_PAGE_SIZE;
+        if (l_Page < p_List.Pages.size())
+            p_List.Pages[l_Page] = Core::Network::SharedPacket();
+    }
+    /// Serialize page, list lock held
+    /// @p_List      : List
+    /// @p_Page      : Page
+    /// @p_PageCount : Amount of pages of list
+    Core::Network::SharedPacket NavigatorManager::BuildPage(RoomList const& p_List, uint32 p_Page, uint32 p_PageCount)
+    {
+        const std::size_t l_Visible = p_List.OccupiedOnly ? p_List.Occupied : p_List.Order.size();
+        const std::size_t l_Begin   = std::min<std::size_t>(static_cast<std::size_t>(p_Page) * NAVIGATOR_PAGE_SIZE, l_Visible);
+        const std::size_t l_End     = std::min<std::size_t>(l_Begin + NAVIGATOR_PAGE_SIZE, l_Visible);
+
+        Server::ServerMessage l_Message(Server::SERVER_NAVIGATE_NODE);
+        l_Message.AppendInt(static_cast<int32>(p_List.CategoryId));
+        l_Message.AppendString(p_List.Name);
+        l_Message.AppendInt(static_cast<int32>(p_Page));
+        l_Message.AppendInt(static_cast<int32>(p_PageCount));
+        l_Message.AppendInt(static_cast<int32>(l_End - l_Begin));
+
+        for (std::size_t l_I = l_Begin; l_I < l_End; l_I++)
+            WriteRoom(l_Message, *p_List.Order[l_I].Room, p_List.Order[l_I].UserCount);
+
+        return l_Message.Finalize();
+    }
+    /// Append room to a page or search result
+    /// @p_Message   : Message
+    /// @p_Room      : Room
+    /// @p_UserCount : Users in room
+    void NavigatorManager::WriteRoom(Server::ServerMessage& p_Message, Entry const& p_Room, uint32 p_UserCount)
+    {
+        p_Message.AppendInt(static_cast<int32>(p_Room.Info.Id));
+        p_Message.AppendString(p_Room.Info.Name);
+        p_Message.AppendString(p_Room.Info.Owner);
+        p_Message.AppendInt(static_cast<int32>(p_UserCount));
+        p_Message.AppendInt(static_cast<int32>(p_Room.Info.MaxUsers));
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Add trigrams of room to the search index, rooms lock held exclusively
+    /// @p_Room : Room
+    void NavigatorManager::IndexName(Entry* p_Room)
+    {
+        for (uint32 l_Trigram : GetTrigrams(p_Room->LowerName))
+            m_Trigrams[l_Trigram].push_back(p_Room);
+    }
+    /// Remove trigrams of room from the search index, rooms lock held exclusively
+    /// @p_Room : Room
+    void NavigatorManager::UnindexName(Entry* p_Room)
+    {
+        for (uint32 l_Trigram : GetTrigrams(p_Room->LowerName))
+        {
+            auto l_Itr = m_Trigrams.find(l_Trigram);
+            if (l_Itr == m_Trigrams.end())
+                continue;
+
+            std::vector<Entry*>& l_Rooms = l_Itr->second;
+            auto l_Room = std::find(l_Rooms.begin(), l_Rooms.end(), p_Room);
+            if (l_Room != l_Rooms.end())
+            {
+                *l_Room = l_Rooms.back();
+                l_Rooms.pop_back();
+            }
+
+            if (l_Rooms.empty())
+                m_Trigrams.erase(l_Itr);
+        }
+    }
+    /// Get distinct trigrams of a lower case string
+    /// @p_String : String
+    std::vector<uint32> NavigatorManager::GetTrigrams(std::string_view p_String)
+    {
+        std::vector<uint32> l_Trigrams;
+        if (p_String.size() < NAVIGATOR_TRIGRAM_LENGTH)
+            return l_Trigrams;
+
+        l_Trigrams.reserve(p_String.size() - NAVIGATOR_TRIGRAM_LENGTH + 1);
+        for (std::size_t l_I = 0; l_I + NAVIGATOR_TRIGRAM_LENGTH <= p_String.size(); l_I++)
+        {
+            l_Trigrams.push_back((static_cast<uint32>(static_cast<uint8>(p_String[l_I])) << 16)
+                | (static_cast<uint32>(static_cast<uint8>(p_String[l_I + 1])) << 8)
+                | static_cast<uint32>(static_cast<uint8>(p_String[l_I + 2])));
+        }
+
+        std::sort(l_Trigrams.begin(), l_Trigrams.end());
+        l_Trigrams.erase(std::unique(l_Trigrams.begin(), l_Trigrams.end()), l_Trigrams.end());
+
+        return l_Trigrams;
+    }
+
+}   ///< namespace Navigator
+}   ///< namespace Game
+}   ///< namespace Steerstone
@@ -0,0 +1,201 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+#include "Singleton/Singleton.hpp"
+#include "Database/RowMapper.hpp"
+#include "Network/SharedPacket.hpp"
+
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define NAVIGATOR_PAGE_SIZE             30      ///< Rooms on one navigator page
+#define NAVIGATOR_SEARCH_MAX_RESULTS    50      ///< Rooms returned by a search, the most occupied ones
+#define NAVIGATOR_POPULAR_CATEGORY      0       ///< Category id of the popular tab, every occupied room
+#define NAVIGATOR_TRIGRAM_LENGTH        3       ///< Searches shorter than this match name prefixes instead
+
+namespace SteerStone { namespace Game {
+
+    namespace Server { class ServerMessage; }
+
+namespace Navigator {
+
+    /// Room listed in the navigator
+    struct NavigatorRoomInfo
+    {
+        uint32 Id;                  ///< Id of room
+        std::string Name;           ///< Name
+        std::string Owner;          ///< Name of owner
+        uint32 CategoryId;          ///< Category of room
+        uint32 MaxUsers;            ///< Most users allowed in
+
+        DATABASE_ROW_FIELDS(&NavigatorRoomInfo::Id, &NavigatorRoomInfo::Name, &NavigatorRoomInfo::Owner, &NavigatorRoomInfo::CategoryId, &NavigatorRoomInfo::MaxUsers)
+    };
+
+    /// Category of the navigator
+    struct NavigatorCategoryInfo
+    {
+        uint32 Id;                  ///< Id of category
+        std::string Name;           ///< Name
+
+        DATABASE_ROW_FIELDS(&NavigatorCategoryInfo::Id, &NavigatorCategoryInfo::Name)
+    };
+
+    /// In memory room lists of the navigator, opening a tab never queries the database
+    /// Every category keeps its rooms sorted by occupancy. A user entering or leaving moves one room to the edge
+    /// of its run of rooms with the same count, a binary search and a swap, so the lists stay sorted without
+    /// sorting. Pages are serialized once and served to every client until a room on them changes.
+    /// Names are indexed by trigram for searches, shorter searches match prefixes of the sorted names
+    class NavigatorManager
+    {
+        SINGLETON_P_D(NavigatorManager);
+
+        private:
+            /// Lists a room is in
+            enum ListSlot : uint8
+            {
+                LIST_SLOT_CATEGORY,         ///< List of its category
+                LIST_SLOT_POPULAR,          ///< Popular list
+                LIST_SLOT_MAX
+            };
+
+            /// Listed room
+            struct Entry
+            {
+                NavigatorRoomInfo Info;                     ///< Room, immutable once listed
+                std::string LowerName;                      ///< Name in lower case, for searching
+                std::atomic<uint32> UserCount;              ///< Users in room, for ordering search results
+                uint32 Position[LIST_SLOT_MAX];             ///< Index in each list, guarded by the list
+            };
+
+            /// Room of a list, with its count as the list has seen it
+            struct Slot
+            {
+                Entry* Room;                                ///< Room
+                uint32 UserCount;                           ///< Users in room
+            };
+
+            /// Rooms of a tab sorted by occupancy, most occupied first
+            struct RoomList
+            {
+                std::mutex Mutex;                           ///< Guards the list and its pages
+                uint32 CategoryId;                          ///< Category id
+                std::string Name;                           ///< Name of category
+                ListSlot PositionSlot;                      ///< Position of rooms in this list
+                bool OccupiedOnly;                          ///< Only rooms with users are listed
+                std::vector<Slot> Order;                    ///< Rooms, most occupied first
+                uint32 Occupied;                            ///< Rooms with users, leading Order
+                uint32 PageCount;                           ///< Pages the cached pages were built for
+                std::vector<Core::Network::SharedPacket> Pages;     ///< Serialized pages, empty until built
+            };
+
+        public:
+            /// Load rooms and categories, called once the game database is up
+            void Initialize();
+
+            /// List room, a room already listed is replaced
+            /// @p_Info : Room
+            void AddRoom(NavigatorRoomInfo const& p_Info);
+            /// Unlist room
+            /// @p_Id : Id of room
+            void RemoveRoom(uint32 p_Id);
+
+            /// User entered room, room strand
+            /// @p_Id : Id of room
+            void OnUserEnter(uint32 p_Id);
+            /// User left room, room strand
+            /// @p_Id : Id of room
+            void OnUserLeave(uint32 p_Id);
+
+            /// Get serialized page of a tab, empty if the category does not exist
+            /// @p_CategoryId : Category, NAVIGATOR_POPULAR_CATEGORY for the popular tab
+            /// @p_Page       : Page, clamped to the last page
+            Core::Network::SharedPacket GetPage(uint32 p_CategoryId, uint32 p_Page);
+            /// Search rooms by name regardless of case
+            /// @p_Query : Part of a room name
+            Core::Network::SharedPacket Search(std::string_view p_Query);
+
+            /// Get amount of listed rooms
+            std::size_t GetRoomCount() const;
+
+        private:
+            /// Remove room from its lists and the search index, rooms lock held exclusively
+            /// @p_Room : Room
+            void Unlist(Entry* p_Room);
+            /// Get list of category, created if needed, rooms lock held exclusively
+            /// @p_CategoryId : Category
+            RoomList& GetOrCreateList(uint32 p_CategoryId);
+            /// Move room by a user in a list
+            /// @p_List  : List
+            /// @p_Room  : Room
+            /// @p_Enter : User entered, left otherwise
+            static void AdjustUserCount(RoomList& p_List, Entry* p_Room, bool p_Enter);
+            /// Add room to a list, rooms lock held exclusively
+            /// @p_List : List
+            /// @p_Room : Room
+            static void Insert(RoomList& p_List, Entry* p_Room);
+            /// Remove room from a list, rooms lock held exclusively
+            /// @p_List : List
+            /// @p_Room : Room
+            static void Erase(RoomList& p_List, Entry* p_Room);
+            /// Drop cached pages showing a position, list lock held
+            /// @p_List     : List
+            /// @p_Position : Position in list which changed
+            static void Invalidate(RoomList& p_List, std::size_t p_Position);
+            /// Serialize page, list lock held
+            /// @p_List      : List
+            /// @p_Page      : Page
+            /// @p_PageCount : Amount of pages of list
+            static Core::Network::SharedPacket BuildPage(RoomList const& p_List, uint32 p_Page, uint32 p_PageCount);
+            /// Append room to a page or search result
+            /// @p_Message   : Message
+            /// @p_Room      : Room
+            /// @p_UserCount : Users in room
+            static void WriteRoom(Server::ServerMessage& p_Message, Entry const& p_Room, uint32 p_UserCount);
+
+            /// Add trigrams of room to the search index, rooms lock held exclusively
+            /// @p_Room : Room
+            void IndexName(Entry* p_Room);
+            /// Remove trigrams of room from the search index, rooms lock held exclusively
+            /// @p_Room : Room
+            void UnindexName(Entry* p_Room);
+            /// Get distinct trigrams of a lower case string
+            /// @p_String : String
+            static std::vector<uint32> GetTrigrams(std::string_view p_String);
+
+        private:
+            mutable std::shared_mutex m_Mutex;                                  ///< Guards rooms, lists and search index, lists lock on their own for counts
+            std::unordered_map<uint32, std::unique_ptr<Entry>> m_Rooms;         ///< Listed rooms by id
+            std::unordered_map<uint32, std::unique_ptr<RoomList>> m_Lists;      ///< Lists by category id, popular included
+            std::unordered_map<uint32, std::vector<Entry*>> m_Trigrams;         ///< Rooms by trigram of their name
+            std::vector<Entry*> m_Names;                                        ///< Rooms sorted by lower case name, for prefix searches
+    };
+
+}   ///< namespace Navigator
+}   ///< namespace Game
+}   ///< namespace Steerstone
+
+#define sNavigatorManager SteerStone::Game::Navigator::NavigatorManager::GetSingleton()
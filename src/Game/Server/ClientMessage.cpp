@@ -0,0 +1,156 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ClientMessage.hpp"
+
+namespace SteerStone { namespace Game { namespace Server {
+
+    /// Decode frame from start of data
+    /// @p_Data        : Data recieved from client
+    /// @p_MaxLength   : Maximum allowed body length
+    /// @p_Message     : Decoded message, set if frame is complete
+    /// @p_FrameLength : Total length of frame including length header, set if frame is complete
+    FrameState ClientMessage::DecodeFrame(Core::Network::PacketView const& p_Data, std::size_t p_MaxLength, ClientMessage& p_Message, std::size_t& p_FrameLength)
+    {
+        if (p_Data.GetLength() < B64_LENGTH_SIZE)
+            return FrameState::Incomplete;
+
+        uint32 l_Length = 0;
+        if (!Encoding::DecodeB64(p_Data.GetData(), B64_LENGTH_SIZE, l_Length))
+            return FrameState::Malformed;
+
+        /// Every message has at least a header id
+        if (l_Length < B64_HEADER_SIZE || l_Length > p_MaxLength)
+            return FrameState::Malformed;
+
+        if (p_Data.GetLength() < B64_LENGTH_SIZE + l_Length)
+            return FrameState::Incomplete;
+
+        uint32 l_Header = 0;
+        if (!Encoding::DecodeB64(p_Data.GetData() + B64_LENGTH_SIZE, B64_HEADER_SIZE, l_Header))
+            return FrameState::Malformed;
+
+        p_Message       = ClientMessage(static_cast<uint16>(l_Header), p_Data.SubView(B64_LENGTH_SIZE + B64_HEADER_SIZE, l_Length - B64_HEADER_SIZE));
+        p_FrameLength   = B64_LENGTH_SIZE + l_Length;
+
+        return FrameState::Complete;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    ClientMessage::ClientMessage()
+        : m_Header(0), m_Position(0), m_Error(false)
+    {
+    }
+    /// Constructor
+    /// @p_Header : Header id
+    /// @p_Body   : Body of message
+    ClientMessage::ClientMessage(uint16 p_Header, Core::Network::PacketView const& p_Body)
+        : m_Header(p_Header), m_Body(p_Body), m_Position(0), m_Error(false)
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get header id
+    uint16 ClientMessage::GetHeader() const
+    {
+        return m_Header;
+    }
+    /// Get body of message
+    Core::Network::PacketView const& ClientMessage::GetBody() const
+    {
+        return m_Body;
+    }
+    /// Get amount of bytes left to read
+    std::size_t ClientMessage::GetRemaining() const
+    {
+        return m_Body.GetLength() - m_Position;
+    }
+    /// Check if any read failed because the data was malformed
+    bool ClientMessage::HasError() const
+    {
+        return m_Error;
+    }
+
+    /// Read VL64 integer
+    int32 ClientMessage::ReadInt()
+    {
+        int32 l_Value = 0;
+        const std::size_t l_Size = Encoding::DecodeVL64(m_Body.GetData() + m_Position, GetRemaining(), l_Value);
+
+        if (l_Size == 0)
+        {
+            m_Error = true;
+            return 0;
+        }
+
+        m_Position += l_Size;
+        return l_Value;
+    }
+    /// Read VL64 boolean
+    bool ClientMessage::ReadBool()
+    {
+        return ReadInt() != 0;
+    }
+    /// Read 2 byte B64 integer
+    uint32 ClientMessage::ReadB64()
+    {
+        uint32 l_Value = 0;
+
+        if (GetRemaining() < B64_HEADER_SIZE || !Encoding::DecodeB64(m_Body.GetData() + m_Position, B64_HEADER_SIZE, l_Value))
+        {
+            m_Error = true;
+            return 0;
+        }
+
+        m_Position += B64_HEADER_SIZE;
+        return l_Value;
+    }
+    /// Read B64 length prefixed string, the view borrows the socket in buffer
+    std::string_view ClientMessage::ReadString()
+    {
+        uint32 l_Length = 0;
+
+        if (GetRemaining() < B64_STRING_LENGTH_SIZE || !Encoding::DecodeB64(m_Body.GetData() + m_Position, B64_STRING_LENGTH_SIZE, l_Length)
+            || GetRemaining() - B64_STRING_LENGTH_SIZE < l_Length)
+        {
+            m_Error = true;
+            return std::string_view();
+        }
+
+        std::string_view l_String = m_Body.SubView(m_Position + B64_STRING_LENGTH_SIZE, l_Length).ToStringView();
+        m_Position += B64_STRING_LENGTH_SIZE + l_Length;
+
+        return l_String;
+    }
+    /// Read rest of the body, the view borrows the socket in buffer
+    std::string_view ClientMessage::ReadRemaining()
+    {
+        std::string_view l_String = m_Body.SubView(m_Position, GetRemaining()).ToStringView();
+        m_Position = m_Body.GetLength();
+
+        return l_String;
+    }
+
+}   ///< namespace Server
+}   ///< namespace Game
+}   ///< namespace Steerstone
@@ -0,0 +1,88 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+#include "Network/PacketView.hpp"
+#include "Encoding.hpp"
+
+namespace SteerStone { namespace Game { namespace Server {
+
+    /// Frame decoding results
+    enum class FrameState
+    {
+        Complete,               ///< Frame has been fully recieved
+        Incomplete,             ///< Frame has not been fully recieved yet
+        Malformed               ///< Frame is not valid, close down socket
+    };
+
+    /// Incoming message from client
+    /// Borrows the socket in buffer, only valid during ProcessIncomingData
+    class ClientMessage
+    {
+        public:
+            /// Decode frame from start of data
+            /// @p_Data        : Data recieved from client
+            /// @p_MaxLength   : Maximum allowed body length
+            /// @p_Message     : Decoded message, set if frame is complete
+            /// @p_FrameLength : Total length of frame including length header, set if frame is complete
+            static FrameState DecodeFrame(Core::Network::PacketView const& p_Data, std::size_t p_MaxLength, ClientMessage& p_Message, std::size_t& p_FrameLength);
+
+        public:
+            /// Constructor
+            ClientMessage();
+            /// Constructor
+            /// @p_Header : Header id
+            /// @p_Body   : Body of message
+            ClientMessage(uint16 p_Header, Core::Network::PacketView const& p_Body);
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Get header id
+            uint16 GetHeader() const;
+            /// Get body of message
+            Core::Network::PacketView const& GetBody() const;
+            /// Get amount of bytes left to read
+            std::size_t GetRemaining() const;
+            /// Check if any read failed because the data was malformed
+            bool HasError() const;
+
+            /// Read VL64 integer
+            int32 ReadInt();
+            /// Read VL64 boolean
+            bool ReadBool();
+            /// Read 2 byte B64 integer
+            uint32 ReadB64();
+            /// Read B64 length prefixed string, the view borrows the socket in buffer
+            std::string_view ReadString();
+            /// Read rest of the body, the view borrows the socket in buffer
+            std::string_view ReadRemaining();
+
+        private:
+            uint16 m_Header;                        ///< Header id
+            Core::Network::PacketView m_Body;       ///< Body of message
+            std::size_t m_Position;                 ///< Read position in body
+            bool m_Error;                           ///< Malformed data has been read
+    };
+
+}   ///< namespace Server
+}   ///< namespace Game
+}   ///< namespace Steerstone
@@ -0,0 +1,149 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <openssl/bn.h>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+
+#include "CryptoHandshake.hpp"
+#include "Network/SocketCipher.hpp"
+
+#include <memory>
+
+namespace SteerStone { namespace Game { namespace Server {
+
+    /// Owner of a BIGNUM
+    struct BignumDeleter
+    {
+        void operator()(BIGNUM* p_Number) const { BN_clear_free(p_Number); }
+    };
+    typedef std::unique_ptr<BIGNUM, BignumDeleter> Bignum;
+
+    /// Owner of OpenSSL allocated memory
+    struct OpenSslDeleter
+    {
+        void operator()(char* p_Memory) const { OPENSSL_free(p_Memory); }
+    };
+
+    /// Get prime of group, never freed
+    static BIGNUM const* GetPrimeNumber()
+    {
+        static BIGNUM const* s_Prime = BN_get_rfc3526_prime_2048(nullptr);
+        return s_Prime;
+    }
+    /// Convert number to hex
+    /// @p_Number : Number
+    static std::string ToHex(BIGNUM const* p_Number)
+    {
+        std::unique_ptr<char, OpenSslDeleter> l_Hex(BN_bn2hex(p_Number));
+        return l_Hex ? std::string(l_Hex.get()) : std::string();
+    }
+    /// Derive key of one direction, SHA-256 of the shared secret followed by a label
+    /// @p_Secret : Shared secret
+    /// @p_Label  : Direction
+    /// @p_Key    : Output, SocketCipher::GetKeyLength bytes
+    static bool DeriveKey(std::vector<uint8> const& p_Secret, char p_Label, std::vector<uint8>& p_Key)
+    {
+        std::vector<uint8> l_Input(p_Secret);
+        l_Input.push_back(static_cast<uint8>(p_Label));
+
+        uint8 l_Digest[EVP_MAX_MD_SIZE];
+        uint32 l_DigestLength = 0;
+        if (EVP_Digest(l_Input.data(), l_Input.size(), l_Digest, &l_DigestLength, EVP_sha256(), nullptr) != 1)
+            return false;
+
+        OPENSSL_cleanse(l_Input.data(), l_Input.size());
+
+        const std::size_t l_KeyLength = Core::Network::SocketCipher::GetKeyLength();
+        if (l_KeyLength > l_DigestLength)
+            return false;
+
+        p_Key.assign(l_Digest, l_Digest + l_KeyLength);
+        OPENSSL_cleanse(l_Digest, sizeof(l_Digest));
+        return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get prime of group in hex, sent to the client
+    std::string const& CryptoHandshake::GetPrime()
+    {
+        static std::string const s_Prime = ToHex(GetPrimeNumber());
+        return s_Prime;
+    }
+    /// Get generator of group in hex, sent to the client
+    std::string const& CryptoHandshake::GetGenerator()
+    {
+        static std::string const s_Generator = "2";
+        return s_Generator;
+    }
+
+    /// Compute our half of the exchange and the keys of the socket cipher, task worker only
+    /// @p_ClientPublic : Public key of client in hex
+    /// @p_ServerPublic : Output, our public key in hex, sent to the client
+    /// @p_ClientKey    : Output, key of data sent by the client
+    /// @p_ServerKey    : Output, key of data sent by us
+    /// Returns false if the public key of the client is not valid
+    bool CryptoHandshake::Compute(std::string_view p_ClientPublic, std::string& p_ServerPublic, std::vector<uint8>& p_ClientKey, std::vector<uint8>& p_ServerKey)
+    {
+        if (p_ClientPublic.empty() || p_ClientPublic.size() > CRYPTO_PUBLIC_KEY_MAX_LENGTH)
+            return false;
+
+        BIGNUM const* l_Prime = GetPrimeNumber();
+        if (!l_Prime)
+            return false;
+
+        std::unique_ptr<BN_CTX, decltype(&BN_CTX_free)> l_Context(BN_CTX_new(), &BN_CTX_free);
+        Bignum l_ClientPublic(BN_new()), l_Private(BN_new()), l_Public(BN_new()), l_Secret(BN_new()), l_Generator(BN_new()), l_Limit(BN_new());
+        if (!l_Context || !l_ClientPublic || !l_Private || !l_Public || !l_Secret || !l_Generator || !l_Limit)
+            return false;
+
+        /// BN_hex2bn allocates when handed a null pointer, parse into our own number instead
+        BIGNUM* l_Parsed = l_ClientPublic.get();
+        const std::string l_Hex(p_ClientPublic);
+        if (BN_hex2bn(&l_Parsed, l_Hex.c_str()) != static_cast<int>(l_Hex.size()))
+            return false;
+
+        /// 1 < A < p - 1, anything else would force a known secret
+        if (!BN_sub(l_Limit.get(), l_Prime, BN_value_one()) || BN_cmp(l_ClientPublic.get(), BN_value_one()) <= 0 || BN_cmp(l_ClientPublic.get(), l_Limit.get()) >= 0)
+            return false;
+
+        if (!BN_set_word(l_Generator.get(), 2)
+            || !BN_priv_rand(l_Private.get(), CRYPTO_PRIVATE_KEY_BITS, BN_RAND_TOP_ONE, BN_RAND_BOTTOM_ANY)
+            || !BN_mod_exp(l_Public.get(), l_Generator.get(), l_Private.get(), l_Prime, l_Context.get())
+            || !BN_mod_exp(l_Secret.get(), l_ClientPublic.get(), l_Private.get(), l_Prime, l_Context.get()))
+            return false;
+
+        std::vector<uint8> l_SecretBytes(BN_num_bytes(l_Secret.get()));
+        BN_bn2bin(l_Secret.get(), l_SecretBytes.data());
+
+        const bool l_Derived = DeriveKey(l_SecretBytes, 'C', p_ClientKey) && DeriveKey(l_SecretBytes, 'S', p_ServerKey);
+        OPENSSL_cleanse(l_SecretBytes.data(), l_SecretBytes.size());
+
+        if (!l_Derived)
+            return false;
+
+        p_ServerPublic = ToHex(l_Public.get());
+        return true;
+    }
+
+}   ///< namespace Server
+}   ///< namespace Game
+}   ///< namespace Steerstone
@@ -0,0 +1,55 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#define CRYPTO_PUBLIC_KEY_MAX_LENGTH    512     ///< Longest hex public key we accept from a client
+#define CRYPTO_PRIVATE_KEY_BITS         256     ///< Bits of our private exponent, twice the strength of the group as RFC 3526 advises
+
+namespace SteerStone { namespace Game { namespace Server {
+
+    /// Diffie Hellman key exchange of the handshake, keys of the socket cipher are derived from the shared secret
+    /// Group is the 2048 bit MODP group of RFC 3526, a modular exponentiation of it takes long enough to run on a task worker
+    class CryptoHandshake
+    {
+        public:
+            /// Get prime of group in hex, sent to the client
+            static std::string const& GetPrime();
+            /// Get generator of group in hex, sent to the client
+            static std::string const& GetGenerator();
+
+            /// Compute our half of the exchange and the keys of the socket cipher, task worker only
+            /// @p_ClientPublic : Public key of client in hex
+            /// @p_ServerPublic : Output, our public key in hex, sent to the client
+            /// @p_ClientKey    : Output, key of data sent by the client
+            /// @p_ServerKey    : Output, key of data sent by us
+            /// Returns false if the public key of the client is not valid
+            static bool Compute(std::string_view p_ClientPublic, std::string& p_ServerPublic, std::vector<uint8>& p_ClientKey, std::vector<uint8>& p_ServerKey);
+    };
+
+}   ///< namespace Server
+}   ///< namespace Game
+}   ///< namespace Steerstone
@@ -0,0 +1,171 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <array>
+
+#include "Core/Core.hpp"
+
+#define B64_LENGTH_SIZE             3       ///< Size of length header of client messages
+#define B64_HEADER_SIZE             2       ///< Size of header id of client and server messages
+#define B64_STRING_LENGTH_SIZE      2       ///< Size of length prefix of client strings
+#define VL64_MAX_SIZE               6       ///< Maximum size of an encoded VL64 integer
+
+#define SERVER_MESSAGE_TERMINATOR   0x01    ///< End of server message
+#define SERVER_STRING_TERMINATOR    0x02    ///< End of string inside server message
+
+namespace SteerStone { namespace Game { namespace Server { namespace Encoding {
+
+    /// Habbo wire encodings
+    ///
+    /// B64   : Fixed width, big endian, 6 bits per byte with 0x40 added to each byte
+    /// VL64  : Variable width (1 - 6 bytes), first byte holds 0x40 | (size << 3) | (negative << 2) | (2 lowest bits),
+    ///         following bytes hold 0x40 | next 6 bits, least significant first
+
+    /// Value returned by lookup tables for bytes which are not part of the encoding
+    static constexpr uint8 InvalidByte = 0xFF;
+
+    /// Build lookup table from wire byte to B64 value
+    constexpr std::array<uint8, 256> BuildB64DecodeTable()
+    {
+        std::array<uint8, 256> l_Table = {};
+
+        for (uint32 l_I = 0; l_I < 256; l_I++)
+            l_Table[l_I] = (l_I >= 0x40 && l_I < 0x80) ? static_cast<uint8>(l_I - 0x40) : InvalidByte;
+
+        return l_Table;
+    }
+    /// Build lookup table from first VL64 wire byte to encoded size
+    constexpr std::array<uint8, 256> BuildVL64SizeTable()
+    {
+        std::array<uint8, 256> l_Table = {};
+
+        for (uint32 l_I = 0; l_I < 256; l_I++)
+        {
+            const uint32 l_Size = (l_I >> 3) & 7;
+            l_Table[l_I] = (l_I >= 0x40 && l_I < 0x80 && l_Size >= 1 && l_Size <= VL64_MAX_SIZE) ? static_cast<uint8>(l_Size) : InvalidByte;
+        }
+
+        return l_Table;
+    }
+
+    static constexpr std::array<uint8, 256> B64DecodeTable  = BuildB64DecodeTable();
+    static constexpr std::array<uint8, 256> VL64SizeTable   = BuildVL64SizeTable();
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Decode B64 value
+    /// @p_Data   : Encoded data
+    /// @p_Length : Amount of bytes to decode (at most 5)
+    /// @p_Value  : Decoded value
+    /// Returns false if data is not B64 encoded
+    inline bool DecodeB64(uint8 const* p_Data, std::size_t p_Length, uint32& p_Value)
+    {
+        uint32 l_Value = 0;
+
+        for (std::size_t l_I = 0; l_I < p_Length; l_I++)
+        {
+            const uint8 l_Byte = B64DecodeTable[p_Data[l_I]];
+
+            if (l_Byte == InvalidByte)
+                return false;
+
+            l_Value = (l_Value << 6) | l_Byte;
+        }
+
+        p_Value = l_Value;
+        return true;
+    }
+    /// Encode B64 value
+    /// @p_Value  : Value to encode
+    /// @p_Output : Output, must hold at least p_Length bytes
+    /// @p_Length : Amount of bytes to encode into
+    inline void EncodeB64(uint32 p_Value, uint8* p_Output, std::size_t p_Length)
+    {
+        for (std::size_t l_I = 0; l_I < p_Length; l_I++)
+            p_Output[l_I] = static_cast<uint8>(0x40 | ((p_Value >> (6 * (p_Length - 1 - l_I))) & 0x3F));
+    }
+
+    /// Decode VL64 value
+    /// @p_Data   : Encoded data
+    /// @p_Length : Amount of bytes available
+    /// @p_Value  : Decoded value
+    /// Returns amount of bytes consumed, 0 if data is not VL64 encoded or is incomplete
+    inline std::size_t DecodeVL64(uint8 const* p_Data, std::size_t p_Length, int32& p_Value)
+    {
+        if (p_Length == 0)
+            return 0;
+
+        const uint8 l_First = p_Data[0];
+        const std::size_t l_Size = VL64SizeTable[l_First];
+
+        if (l_Size == InvalidByte || l_Size > p_Length)
+            return 0;
+
+        uint32 l_Value = l_First & 3;
+
+        for (std::size_t l_I = 1; l_I < l_Size; l_I++)
+        {
+            const uint8 l_Byte = B64DecodeTable[p_Data[l_I]];
+
+            if (l_Byte == InvalidByte)
+                return 0;
+
+            l_Value |= static_cast<uint32>(l_Byte) << (2 + 6 * (l_I - 1));
+        }
+
+        p_Value = (l_First & 4) ? -static_cast<int32>(l_Value) : static_cast<int32>(l_Value);
+        return l_Size;
+    }
+    /// Encode VL64 value
+    /// @p_Value  : Value to encode
+    /// @p_Output : Output, must hold at least VL64_MAX_SIZE bytes
+    /// Returns amount of bytes written
+    inline std::size_t EncodeVL64(int32 p_Value, uint8* p_Output)
+    {
+        uint32 l_Value = p_Value < 0 ? 0u - static_cast<uint32>(p_Value) : static_cast<uint32>(p_Value);
+        std::size_t l_Size = 1;
+
+        p_Output[0] = static_cast<uint8>(0x40 | (l_Value & 3));
+
+        for (l_Value >>= 2; l_Value != 0; l_Value >>= 6)
+            p_Output[l_Size++] = static_cast<uint8>(0x40 | (l_Value & 0x3F));
+
+        p_Output[0] |= static_cast<uint8>((l_Size << 3) | (p_Value < 0 ? 4 : 0));
+
+        return l_Size;
+    }
+    /// Get encoded size of VL64 value without encoding it
+    /// @p_Value : Value to encode
+    inline std::size_t SizeOfVL64(int32 p_Value)
+    {
+        uint32 l_Value = (p_Value < 0 ? 0u - static_cast<uint32>(p_Value) : static_cast<uint32>(p_Value)) >> 2;
+        std::size_t l_Size = 1;
+
+        for (; l_Value != 0; l_Value >>= 6)
+            l_Size++;
+
+        return l_Size;
+    }
+
+}   ///< namespace Encoding
+}   ///< namespace Server
+}   ///< namespace Game
+}   ///< namespace Steerstone
@@ -0,0 +1,176 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <array>
+#include <chrono>
+
+#include "Opcodes.hpp"
+#include "Server/Socket.hpp"
+#include "Diagnostic/DiaProfiler.hpp"
+#include "Diagnostic/DiaFlightRecorder.hpp"
+#include "Metrics/MetRegistry.hpp"
+
+namespace SteerStone { namespace Game { namespace Server {
+
+    /// Opcode registration
+    struct OpcodeRegistration
+    {
+        uint16 Header;              ///< Header id
+        OpcodeHandler Handler;      ///< Handler entry
+    };
+
+    /// Registered opcodes
+    static constexpr OpcodeRegistration s_Registrations[] =
+    {
+        { CLIENT_SEARCH_FLATS, { "CLIENT_SEARCH_FLATS", PacketStatus::Authenticated, ExecutionTarget::NetworkThread, RateClass::Lookup, &GameSocket::HandleSearchFlats } },
+        { CLIENT_GOTO_FLAT, { "CLIENT_GOTO_FLAT", PacketStatus::Any, ExecutionTarget::Session, RateClass::Movement, &GameSocket::HandleGotoFlat } },
+        { CLIENT_GET_INVENTORY, { "CLIENT_GET_INVENTORY", PacketStatus::Authenticated, ExecutionTarget::NetworkThread, RateClass::Lookup, &GameSocket::HandleGetInventory } },
+        { CLIENT_MOVE, { "CLIENT_MOVE", PacketStatus::Any, ExecutionTarget::Room, RateClass::Movement, &GameSocket::HandleMove } },
+        { CLIENT_GET_CATALOG_INDEX, { "CLIENT_GET_CATALOG_INDEX", PacketStatus::Authenticated, ExecutionTarget::NetworkThread, RateClass::Lookup, &GameSocket::HandleGetCatalogIndex } },
+        { CLIENT_GET_CATALOG_PAGE, { "CLIENT_GET_CATALOG_PAGE", PacketStatus::Authenticated, ExecutionTarget::NetworkThread, RateClass::Lookup, &GameSocket::HandleGetCatalogPage } },
+        { CLIENT_NAVIGATE, { "CLIENT_NAVIGATE", PacketStatus::Authenticated, ExecutionTarget::NetworkThread, RateClass::Lookup, &GameSocket::HandleNavigate } },
+        { CLIENT_PONG, { "CLIENT_PONG", PacketStatus::Any, ExecutionTarget::NetworkThread, RateClass::None, &GameSocket::HandlePong } },
+        { CLIENT_GENERATE_KEY, { "CLIENT_GENERATE_KEY", PacketStatus::NotAuthenticated, ExecutionTarget::NetworkThread, RateClass::General, &GameSocket::HandleGenerateKey } },
+        { CLIENT_SSO, { "CLIENT_SSO", PacketStatus::NotAuthenticated, ExecutionTarget::NetworkThread, RateClass::General, &GameSocket::HandleSSO } },
+        { CLIENT_INIT_CRYPTO, { "CLIENT_INIT_CRYPTO", PacketStatus::NotAuthenticated, ExecutionTarget::NetworkThread, RateClass::General, &GameSocket::HandleInitCrypto } },
+    };
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Check registrations are within range and registered only once
+    /// @p_Registrations : Registered opcodes
+    template<std::size_t t_Size> constexpr bool IsValidRegistration(OpcodeRegistration const (&p_Registrations)[t_Size])
+    {
+        for (std::size_t l_I = 0; l_I < t_Size; l_I++)
+        {
+            if (p_Registrations[l_I].Header >= MAX_CLIENT_OPCODE || p_Registrations[l_I].Handler.Handler == nullptr)
+                return false;
+
+            for (std::size_t l_J = l_I + 1; l_J < t_Size; l_J++)
+            {
+                if (p_Registrations[l_I].Header == p_Registrations[l_J].Header)
+                    return false;
+            }
+        }
+
+        return true;
+    }
+    /// Build dense dispatch table indexed by header id
+    /// @p_Registrations : Registered opcodes
+    template<std::size_t t_Size> constexpr std::array<OpcodeHandler, MAX_CLIENT_OPCODE> BuildOpcodeTable(OpcodeRegistration const (&p_Registrations)[t_Size])
+    {
+        std::array<OpcodeHandler, MAX_CLIENT_OPCODE> l_Table = {};
+
+        for (std::size_t l_I = 0; l_I < t_Size; l_I++)
+            l_Table[p_Registrations[l_I].Header] = p_Registrations[l_I].Handler;
+
+        return l_Table;
+    }
+
+    static_assert(IsValidRegistration(s_Registrations), "Opcode registered twice, out of range or without handler");
+
+    static constexpr std::array<OpcodeHandler, MAX_CLIENT_OPCODE> s_OpcodeTable = BuildOpcodeTable(s_Registrations);
+    static OpcodeStatistics s_OpcodeStatistics[MAX_CLIENT_OPCODE];
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get handler entry
+    /// @p_Header : Header id
+    OpcodeHandler const& OpcodeTable::GetHandler(uint16 p_Header)
+    {
+        return s_OpcodeTable[p_Header & (MAX_CLIENT_OPCODE - 1)];
+    }
+    /// Get statistics of opcode
+    /// @p_Header : Header id
+    OpcodeStatistics const& OpcodeTable::GetStatistics(uint16 p_Header)
+    {
+        return s_OpcodeStatistics[p_Header & (MAX_CLIENT_OPCODE - 1)];
+    }
+
+    /// Run handler of message and account the time spent
+    /// @p_Handler : Handler entry of message
+    /// @p_Socket  : Socket which recieved message
+    /// @p_Message : Message to handle
+    void OpcodeTable::Execute(OpcodeHandler const& p_Handler, GameSocket* p_Socket, ClientMessage& p_Message)
+    {
+        PROFILE_ZONE(p_Handler.Name);
+        Core::Diagnostic::FlightRecorder::Record(Core::Diagnostic::FlightEvent::Opcode, p_Handler.Name, p_Message.GetHeader());
+
+        const auto l_Start = std::chrono::steady_clock::now();
+
+        (p_Socket->*p_Handler.Handler)(p_Message);
+
+        const uint64 l_Elapsed = static_cast<uint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - l_Start).count());
+
+        OpcodeStatistics& l_Statistics = s_OpcodeStatistics[p_Message.GetHeader() & (MAX_CLIENT_OPCODE - 1)];
+        l_Statistics.Count.fetch_add(1, std::memory_order_relaxed);
+        l_Statistics.TotalTime.fetch_add(l_Elapsed, std::memory_order_relaxed);
+
+        uint64 l_MaxTime = l_Statistics.MaxTime.load(std::memory_order_relaxed);
+        while (l_Elapsed > l_MaxTime && !l_Statistics.MaxTime.compare_exchange_weak(l_MaxTime, l_Elapsed, std::memory_order_relaxed));
+    }
+
+    /// Log statistics of every handled opcode
+    void OpcodeTable::LogStatistics()
+    {
+        for (uint16 l_I = 0; l_I < MAX_CLIENT_OPCODE; l_I++)
+        {
+            OpcodeStatistics const& l_Statistics = s_OpcodeStatistics[l_I];
+            const uint64 l_Count = l_Statistics.Count.load(std::memory_order_relaxed);
+
+            if (l_Count == 0)
+                continue;
+
+            LOG_INFO("Opcodes", "%0 (%1): %2 handled, %3 ns average, %4 ns max", s_OpcodeTable[l_I].Name, l_I, l_Count,
+                l_Statistics.TotalTime.load(std::memory_order_relaxed) / l_Count, l_Statistics.MaxTime.load(std::memory_order_relaxed));
+        }
+    }
+    /// Export statistics of every handled opcode on metrics scrapes, called once on start up
+    void OpcodeTable::RegisterMetrics()
+    {
+        /// Statistics live as long as the process, the collector is never removed
+        sMetrics->AddCollector([](Core::Metrics::MetricWriter& p_Writer)
+        {
+            p_Writer.WriteFamily("steerstone_opcode_handled_total", "Messages handled per opcode", Core::Metrics::MetricType::Counter);
+            for (uint16 l_I = 0; l_I < MAX_CLIENT_OPCODE; l_I++)
+            {
+                if (const uint64 l_Count = s_OpcodeStatistics[l_I].Count.load(std::memory_order_relaxed))
+                    p_Writer.WriteSample("steerstone_opcode_handled_total", { { "opcode", s_OpcodeTable[l_I].Name } }, l_Count);
+            }
+
+            p_Writer.WriteFamily("steerstone_opcode_handler_seconds_total", "Time spent in handler per opcode", Core::Metrics::MetricType::Counter);
+            for (uint16 l_I = 0; l_I < MAX_CLIENT_OPCODE; l_I++)
+            {
+                if (s_OpcodeStatistics[l_I].Count.load(std::memory_order_relaxed))
+                    p_Writer.WriteSample("steerstone_opcode_handler_seconds_total", { { "opcode", s_OpcodeTable[l_I].Name } }, s_OpcodeStatistics[l_I].TotalTime.load(std::memory_order_relaxed) * 1e-9);
+            }
+
+            p_Writer.WriteFamily("steerstone_opcode_handler_max_seconds", "Longest time spent in handler per opcode", Core::Metrics::MetricType::Gauge);
+            for (uint16 l_I = 0; l_I < MAX_CLIENT_OPCODE; l_I++)
+            {
+                if (s_OpcodeStatistics[l_I].Count.load(std::memory_order_relaxed))
+                    p_Writer.WriteSample("steerstone_opcode_handler_max_seconds", { { "opcode", s_OpcodeTable[l_I].Name } }, s_OpcodeStatistics[l_I].MaxTime.load(std::memory_order_relaxed) * 1e-9);
+            }
+        });
+    }
+
+}   ///< namespace Server
+}   ///< namespace Game
+}   ///< namespace Steerstone
@@ -0,0 +1,146 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <atomic>
+
+#include "Core/Core.hpp"
+
+#define MAX_CLIENT_OPCODE 4096      ///< Header ids are 2 B64 bytes
+#define MAX_SERVER_OPCODE 4096      ///< Header ids are 2 B64 bytes
+
+namespace SteerStone { namespace Game { namespace Server {
+
+    class GameSocket;
+    class ClientMessage;
+
+    /// Client header ids
+    enum ClientOpcodes : uint16
+    {
+        CLIENT_GET_INFO             = 7,
+        CLIENT_GET_CREDITS          = 8,
+        CLIENT_SEARCH_FLATS         = 17,
+        CLIENT_CHAT                 = 52,
+        CLIENT_SHOUT                = 55,
+        CLIENT_WHISPER              = 56,
+        CLIENT_GOTO_FLAT            = 59,
+        CLIENT_GET_INVENTORY        = 65,
+        CLIENT_TRADE_OPEN           = 71,
+        CLIENT_MOVE                 = 75,
+        CLIENT_GET_CATALOG_INDEX    = 101,
+        CLIENT_GET_CATALOG_PAGE     = 102,
+        CLIENT_NAVIGATE             = 150,
+        CLIENT_PONG                 = 196,
+        CLIENT_GENERATE_KEY         = 202,
+        CLIENT_SSO                  = 204,
+        CLIENT_INIT_CRYPTO          = 206
+    };
+
+    /// Server header ids
+    enum ServerOpcodes : uint16
+    {
+        SERVER_SECRET_KEY           = 1,
+        SERVER_LOGIN_OK             = 3,
+        SERVER_FRIEND_UPDATE        = 13,
+        SERVER_FLAT_RESULTS         = 16,
+        SERVER_USER_REMOVE          = 29,
+        SERVER_HEIGHTMAP            = 31,
+        SERVER_FLOOR_ITEMS          = 32,
+        SERVER_ERROR                = 33,
+        SERVER_USER_STATUS          = 34,
+        SERVER_PING                 = 50,
+        SERVER_CATALOG_INDEX        = 126,
+        SERVER_CATALOG_PAGE         = 127,
+        SERVER_INVENTORY            = 140,
+        SERVER_NAVIGATE_NODE        = 220,
+        SERVER_CRYPTO_PARAMETERS    = 277
+    };
+
+    /// Authentication state required to handle opcode
+    enum class PacketStatus : uint8
+    {
+        Any,                        ///< Handled regardless of authentication state
+        NotAuthenticated,           ///< Only handled before authentication (login)
+        Authenticated               ///< Only handled once authenticated
+    };
+
+    /// Where opcode is handled
+    enum class ExecutionTarget : uint8
+    {
+        NetworkThread,              ///< Inline on the network thread, straight from the in buffer
+        Session,                    ///< Posted to the session of the socket
+        Room                        ///< Posted to the room the session is in
+    };
+
+    /// Rate limit bucket opcode is charged to, every limited opcode is charged to the session bucket as well
+    enum class RateClass : uint8
+    {
+        None,                       ///< Not limited, such as answers to our own pings
+        General,                    ///< Anything not in a class of its own
+        Movement,                   ///< Walking and entering rooms
+        Chat,                       ///< Talking
+        Item,                       ///< Moving and using furniture
+        Lookup,                     ///< Navigator, catalog and inventory pages, they may reach the database
+        Max
+    };
+
+    /// Opcode handler entry
+    struct OpcodeHandler
+    {
+        char const* Name;                                   ///< Name of opcode, nullptr if not handled
+        PacketStatus Status;                                ///< Required authentication state
+        ExecutionTarget Target;                             ///< Where opcode is handled
+        RateClass Rate;                                     ///< Rate limit bucket
+        void (GameSocket::*Handler)(ClientMessage&);        ///< Handler
+    };
+
+    /// Opcode statistics, updated on every handled message
+    struct OpcodeStatistics
+    {
+        std::atomic<uint64> Count;                          ///< Amount of messages handled
+        std::atomic<uint64> TotalTime;                      ///< Total time spent in handler (nanoseconds)
+        std::atomic<uint64> MaxTime;                        ///< Longest time spent in handler (nanoseconds)
+    };
+
+    /// Opcode dispatch table, built at compile time and indexed by header id
+    class OpcodeTable
+    {
+        public:
+            /// Get handler entry
+            /// @p_Header : Header id
+            static OpcodeHandler const& GetHandler(uint16 p_Header);
+            /// Get statistics of opcode
+            /// @p_Header : Header id
+            static OpcodeStatistics const& GetStatistics(uint16 p_Header);
+
+            /// Run handler of message and account the time spent
+            /// @p_Handler : Handler entry of message
+            /// @p_Socket  : Socket which recieved message
+            /// @p_Message : Message to handle
+            static void Execute(OpcodeHandler const& p_Handler, GameSocket* p_Socket, ClientMessage& p_Message);
+
+            /// Log statistics of every handled opcode
+            static void LogStatistics();
+            /// Export statistics of every handled opcode on metrics scrapes, called once on start up
+            static void RegisterMetrics();
+    };
+
+}   ///< namespace Server
+}   ///< namespace Game
+}   ///< namespace Steerstone
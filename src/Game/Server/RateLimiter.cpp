@@ -0,0 +1,239 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "RateLimiter.hpp"
+#include "Config/Config.hpp"
+#include "Diagnostic/DiaServerWatch.hpp"
+#include "Metrics/MetRegistry.hpp"
+
+#include <algorithm>
+#include <mutex>
+
+#define RATE_LIMIT_BUCKETS  (static_cast<uint32>(SteerStone::Game::Server::RateClass::Max) + 1)
+#define RATE_LIMIT_SESSION  static_cast<uint32>(SteerStone::Game::Server::RateClass::Max)
+
+namespace SteerStone { namespace Game { namespace Server {
+
+    /// Names of buckets, config keys are RateLimit<Name>Rate, RateLimit<Name>Burst and RateLimit<Name>Action
+    static char const* const s_BucketNames[RATE_LIMIT_BUCKETS] = { "None", "General", "Movement", "Chat", "Item", "Lookup", "Session" };
+    /// Names of actions, as written in the config
+    static char const* const s_ActionNames[] = { "drop", "delay", "disconnect" };
+
+    /// Limits of buckets not set in the config
+    static const RateLimitSettings s_DefaultSettings[RATE_LIMIT_BUCKETS] =
+    {
+        { 0,  0,   RateAction::Drop },          ///< None
+        { 10, 20,  RateAction::Drop },          ///< General
+        { 10, 20,  RateAction::Drop },          ///< Movement
+        { 2,  5,   RateAction::Delay },         ///< Chat
+        { 5,  10,  RateAction::Drop },          ///< Item
+        { 5,  15,  RateAction::Delay },         ///< Lookup
+        { 50, 100, RateAction::Disconnect }     ///< Session
+    };
+
+    /// Limits of the last config generation read, shared by every socket
+    struct RateLimitTable
+    {
+        RateLimitSettings Settings[RATE_LIMIT_BUCKETS];     ///< Limits by bucket
+        uint32 Generation;                                  ///< Config generation read
+        bool Loaded;                                        ///< Read at least once
+    };
+
+    static std::mutex s_TableMutex;
+    static RateLimitTable s_Table = {};
+
+    /// Messages over their limit, by bucket and action
+    struct RateLimitCounters
+    {
+        /// Constructor
+        RateLimitCounters()
+        {
+            for (uint32 l_Bucket = 0; l_Bucket < RATE_LIMIT_BUCKETS; l_Bucket++)
+                for (uint32 l_Action = 0; l_Action < 3; l_Action++)
+                    Counters[l_Bucket][l_Action] = &sMetrics->GetCounter("steerstone_rate_limited_total", "Messages over their rate limit per bucket and action",
+                        { { "bucket", s_BucketNames[l_Bucket] }, { "action", s_ActionNames[l_Action] } });
+        }
+
+        Core::Metrics::Counter* Counters[RATE_LIMIT_BUCKETS][3];    ///< Counters
+    };
+
+    /// Count message over its limit
+    /// @p_Bucket : Index of bucket
+    /// @p_Action : Action taken
+    static void CountLimited(uint32 p_Bucket, RateAction p_Action)
+    {
+        static const RateLimitCounters sl_Counters;
+        sl_Counters.Counters[p_Bucket][static_cast<uint32>(p_Action)]->Increment();
+    }
+    /// Read limits of buckets from a config snapshot
+    /// @p_Snapshot : Snapshot, nullptr if no config is loaded
+    /// @p_Settings : Output
+    static void ReadSettings(Core::Configuration::ConfigSnapshot const* p_Snapshot, RateLimitSettings (&p_Settings)[RATE_LIMIT_BUCKETS])
+    {
+        for (uint32 l_I = 0; l_I < RATE_LIMIT_BUCKETS; l_I++)
+        {
+            RateLimitSettings& l_Settings = p_Settings[l_I];
+            l_Settings = s_DefaultSettings[l_I];
+
+            if (!p_Snapshot || l_I == static_cast<uint32>(RateClass::None))
+                continue;
+
+            const std::string l_Prefix = std::string("RateLimit") + s_BucketNames[l_I];
+
+            if (Core::Configuration::ConfigValue const* l_Rate = Core::Configuration::Base::Find(*p_Snapshot, l_Prefix + "Rate"))
+                if (l_Rate->IsInt && l_Rate->Int >= 0)
+                    l_Settings.Rate = static_cast<uint32>(l_Rate->Int);
+
+            if (Core::Configuration::ConfigValue const* l_Burst = Core::Configuration::Base::Find(*p_Snapshot, l_Prefix + "Burst"))
+                if (l_Burst->IsInt && l_Burst->Int > 0)
+                    l_Settings.Burst = static_cast<uint32>(l_Burst->Int);
+
+            if (Core::Configuration::ConfigValue const* l_Action = Core::Configuration::Base::Find(*p_Snapshot, l_Prefix + "Action"))
+            {
+                std::string l_Name = l_Action->String;
+                std::transform(l_Name.begin(), l_Name.end(), l_Name.begin(), [](unsigned char p_Char) { return static_cast<char>(std::tolower(p_Char)); });
+
+                for (uint32 l_Action = 0; l_Action < 3; l_Action++)
+                    if (l_Name == s_ActionNames[l_Action])
+                        l_Settings.Action = static_cast<RateAction>(l_Action);
+            }
+
+            l_Settings.Burst = std::max<uint32>(l_Settings.Burst, 1);
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    RateLimiter::RateLimiter()
+        : m_Generation(0)
+    {
+        Refresh();
+
+        const uint32 l_Now = sServerTimeManager->GetServerTime();
+        for (uint32 l_I = 0; l_I < RATE_LIMIT_BUCKETS; l_I++)
+        {
+            m_Buckets[l_I].Tokens     = static_cast<int64>(m_Settings[l_I].Burst) * RATE_LIMIT_TOKEN;
+            m_Buckets[l_I].LastRefill = l_Now;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Charge message to the session bucket and the bucket of its class
+    /// @p_Class : Rate class of message
+    /// @p_Now   : Server time
+    /// @p_Delay : MS to wait before handling the message when delayed
+    RateVerdict RateLimiter::Charge(RateClass p_Class, uint32 p_Now, uint32& p_Delay)
+    {
+        p_Delay = 0;
+
+        if (p_Class == RateClass::None)
+            return RateVerdict::Pass;
+
+        if (sConfigManager->GetGeneration() != m_Generation)
+            Refresh();
+
+        const RateVerdict l_Session = Charge(RATE_LIMIT_SESSION, p_Now, p_Delay);
+        if (l_Session > RateVerdict::Delay)
+            return l_Session;
+
+        uint32 l_ClassDelay = 0;
+        const RateVerdict l_Class = Charge(static_cast<uint32>(p_Class), p_Now, l_ClassDelay);
+
+        p_Delay = std::max(p_Delay, l_ClassDelay);
+        return std::max(l_Session, l_Class);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Charge one message to a bucket
+    /// @p_Index : Index of bucket
+    /// @p_Now   : Server time
+    /// @p_Delay : MS to wait before handling the message when delayed
+    RateVerdict RateLimiter::Charge(uint32 p_Index, uint32 p_Now, uint32& p_Delay)
+    {
+        RateLimitSettings const& l_Settings = m_Settings[p_Index];
+        Bucket& l_Bucket = m_Buckets[p_Index];
+
+        if (!l_Settings.Rate)
+            return RateVerdict::Pass;
+
+        /// Rate is in messages per second, which is thousandths of tokens per MS
+        const int64 l_Capacity = static_cast<int64>(l_Settings.Burst) * RATE_LIMIT_TOKEN;
+        l_Bucket.Tokens     = std::min(l_Capacity, l_Bucket.Tokens + static_cast<int64>(p_Now - l_Bucket.LastRefill) * l_Settings.Rate);
+        l_Bucket.LastRefill = p_Now;
+
+        if (l_Bucket.Tokens >= RATE_LIMIT_TOKEN)
+        {
+            l_Bucket.Tokens -= RATE_LIMIT_TOKEN;
+            return RateVerdict::Pass;
+        }
+
+        switch (l_Settings.Action)
+        {
+            case RateAction::Delay:
+            {
+                /// At most a burst of messages is owed, later ones are dropped
+                if (l_Bucket.Tokens - RATE_LIMIT_TOKEN < -l_Capacity)
+                    break;
+
+                l_Bucket.Tokens -= RATE_LIMIT_TOKEN;
+                p_Delay = static_cast<uint32>((-l_Bucket.Tokens + l_Settings.Rate - 1) / l_Settings.Rate);
+
+                CountLimited(p_Index, RateAction::Delay);
+                return RateVerdict::Delay;
+            }
+            case RateAction::Disconnect:
+                CountLimited(p_Index, RateAction::Disconnect);
+                return RateVerdict::Disconnect;
+            default:
+                break;
+        }
+
+        CountLimited(p_Index, RateAction::Drop);
+        return RateVerdict::Drop;
+    }
+    /// Copy settings of current config snapshot
+    void RateLimiter::Refresh()
+    {
+        const uint32 l_Generation = sConfigManager->GetGeneration();
+
+        std::lock_guard<std::mutex> l_Guard(s_TableMutex);
+
+        /// The first socket to see a new generation reads it for every other one
+        if (!s_Table.Loaded || s_Table.Generation != l_Generation)
+        {
+            const std::shared_ptr<Core::Configuration::ConfigSnapshot const> l_Snapshot = sConfigManager->GetSnapshot();
+            ReadSettings(l_Snapshot.get(), s_Table.Settings);
+
+            s_Table.Generation = l_Generation;
+            s_Table.Loaded     = true;
+        }
+
+        std::copy(std::begin(s_Table.Settings), std::end(s_Table.Settings), std::begin(m_Settings));
+        m_Generation = l_Generation;
+    }
+
+}   ///< namespace Server
+}   ///< namespace Game
+}   ///< namespace Steerstone
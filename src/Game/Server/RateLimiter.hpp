@@ -0,0 +1,96 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+#include "Opcodes/Opcodes.hpp"
+
+#define RATE_LIMIT_TOKEN    1000    ///< Tokens are counted in thousandths, a message costs one token
+
+namespace SteerStone { namespace Game { namespace Server {
+
+    /// What happens to a message once its bucket is empty
+    enum class RateAction : uint8
+    {
+        Drop,                       ///< Message is ignored
+        Delay,                      ///< Message is handled once the bucket refilled, dropped if the bucket owes more than its burst
+        Disconnect                  ///< Socket is closed
+    };
+
+    /// Outcome of charging a message, ordered from least to most severe
+    enum class RateVerdict : uint8
+    {
+        Pass,                       ///< Handle message now
+        Delay,                      ///< Handle message later
+        Drop,                       ///< Ignore message
+        Disconnect                  ///< Close socket
+    };
+
+    /// Limit of a bucket
+    struct RateLimitSettings
+    {
+        uint32 Rate;                ///< Messages per second, 0 if not limited
+        uint32 Burst;               ///< Messages allowed at once
+        RateAction Action;          ///< What happens once the bucket is empty
+    };
+
+    /// Token buckets of a socket, one per rate class and one for the whole session
+    /// Settings are copied out of the config snapshot whenever a reload publishes a new one,
+    /// charging a message is then a generation compare and a few integer operations
+    class RateLimiter
+    {
+        DISALLOW_COPY_AND_ASSIGN(RateLimiter);
+
+        public:
+            /// Constructor
+            RateLimiter();
+
+            /// Charge message to the session bucket and the bucket of its class
+            /// @p_Class : Rate class of message
+            /// @p_Now   : Server time
+            /// @p_Delay : MS to wait before handling the message when delayed
+            RateVerdict Charge(RateClass p_Class, uint32 p_Now, uint32& p_Delay);
+
+        private:
+            /// Bucket of tokens, full buckets hold Burst tokens
+            struct Bucket
+            {
+                int64 Tokens;               ///< Thousandths of tokens left, negative while delayed messages are owed
+                uint32 LastRefill;          ///< Server time of last refill
+            };
+
+            /// Charge one message to a bucket
+            /// @p_Index : Index of bucket
+            /// @p_Now   : Server time
+            /// @p_Delay : MS to wait before handling the message when delayed
+            RateVerdict Charge(uint32 p_Index, uint32 p_Now, uint32& p_Delay);
+            /// Copy settings of current config snapshot
+            void Refresh();
+
+        private:
+            Bucket m_Buckets[static_cast<uint32>(RateClass::Max) + 1];              ///< Buckets by rate class, the last one is the session bucket
+            RateLimitSettings m_Settings[static_cast<uint32>(RateClass::Max) + 1];  ///< Limits of buckets
+            uint32 m_Generation;                                                    ///< Config generation settings were copied from
+    };
+
+}   ///< namespace Server
+}   ///< namespace Game
+}   ///< namespace Steerstone
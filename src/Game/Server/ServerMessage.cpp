@@ -0,0 +1,135 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <cassert>
+
+#include "ServerMessage.hpp"
+
+namespace SteerStone { namespace Game { namespace Server {
+
+    /// Running size estimate of every opcode, updated without locking
+    static std::atomic<uint32> s_SizeEstimates[MAX_SERVER_OPCODE];
+
+    /// Get current size estimate of opcode
+    /// @p_Header : Header id
+    uint32 ServerMessage::GetSizeEstimate(uint16 p_Header)
+    {
+        const uint32 l_Estimate = s_SizeEstimates[p_Header % MAX_SERVER_OPCODE].load(std::memory_order_relaxed);
+
+        return l_Estimate ? l_Estimate : SERVER_MESSAGE_INITIAL_ESTIMATE;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    /// @p_Header : Header id
+    ServerMessage::ServerMessage(uint16 p_Header)
+        : m_Header(p_Header), m_Buffer(std::make_shared<Core::Network::PacketBuffer>(GetSizeEstimate(p_Header)))
+    {
+        Encoding::EncodeB64(p_Header, m_Buffer->Reserve(B64_HEADER_SIZE), B64_HEADER_SIZE);
+        m_Buffer->WriteCompleted(B64_HEADER_SIZE);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get header id
+    uint16 ServerMessage::GetHeader() const
+    {
+        return m_Header;
+    }
+    /// Get length of message written so far, including header
+    std::size_t ServerMessage::GetLength() const
+    {
+        return m_Buffer ? m_Buffer->Peek().GetLength() : 0;
+    }
+
+    /// Append VL64 integer
+    /// @p_Value : Value
+    ServerMessage& ServerMessage::AppendInt(int32 p_Value)
+    {
+        assert(m_Buffer);
+
+        m_Buffer->WriteCompleted(Encoding::EncodeVL64(p_Value, m_Buffer->Reserve(VL64_MAX_SIZE)));
+        return *this;
+    }
+    /// Append VL64 boolean
+    /// @p_Value : Value
+    ServerMessage& ServerMessage::AppendBool(bool p_Value)
+    {
+        return AppendInt(p_Value ? 1 : 0);
+    }
+    /// Append B64 integer
+    /// @p_Value  : Value
+    /// @p_Length : Amount of bytes to encode into
+    ServerMessage& ServerMessage::AppendB64(uint32 p_Value, std::size_t p_Length)
+    {
+        assert(m_Buffer);
+
+        Encoding::EncodeB64(p_Value, m_Buffer->Reserve(p_Length), p_Length);
+        m_Buffer->WriteCompleted(p_Length);
+        return *this;
+    }
+    /// Append string followed by string terminator
+    /// @p_String : String, must not contain the terminator
+    ServerMessage& ServerMessage::AppendString(std::string_view p_String)
+    {
+        assert(m_Buffer);
+
+        uint8* l_Output = m_Buffer->Reserve(p_String.size() + 1);
+        memcpy(l_Output, p_String.data(), p_String.size());
+        l_Output[p_String.size()] = SERVER_STRING_TERMINATOR;
+
+        m_Buffer->WriteCompleted(p_String.size() + 1);
+        return *this;
+    }
+    /// Append raw bytes without terminator
+    /// @p_Data : Data
+    ServerMessage& ServerMessage::AppendRaw(std::string_view p_Data)
+    {
+        assert(m_Buffer);
+
+        m_Buffer->Write(p_Data.data(), p_Data.size());
+        return *this;
+    }
+
+    /// Terminate message and give up our chunk, the message must not be used afterwards
+    /// The result can be queued to a single socket or shared between every recipient
+    Core::Network::SharedPacket ServerMessage::Finalize()
+    {
+        assert(m_Buffer);
+
+        *m_Buffer->Reserve(1) = SERVER_MESSAGE_TERMINATOR;
+        m_Buffer->WriteCompleted(1);
+
+        /// Grow right away so the next message fits, shrink slowly so a single small message does not cause reallocations
+        const uint32 l_Length   = static_cast<uint32>(m_Buffer->Peek().GetLength());
+        const uint32 l_Estimate = GetSizeEstimate(m_Header);
+        const uint32 l_Updated  = l_Length >= l_Estimate ? l_Length : l_Estimate - (l_Estimate - l_Length) / SERVER_MESSAGE_ESTIMATE_DECAY;
+
+        if (l_Updated != l_Estimate)
+            s_SizeEstimates[m_Header % MAX_SERVER_OPCODE].store(l_Updated, std::memory_order_relaxed);
+
+        return Core::Network::SharedPacket(std::move(m_Buffer));
+    }
+
+}   ///< namespace Server
+}   ///< namespace Game
+}   ///< namespace Steerstone
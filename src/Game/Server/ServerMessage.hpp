@@ -0,0 +1,88 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <atomic>
+
+#include "Core/Core.hpp"
+#include "Network/PacketBuffer.hpp"
+#include "Network/SharedPacket.hpp"
+#include "Opcodes/Opcodes.hpp"
+#include "Encoding.hpp"
+
+#define SERVER_MESSAGE_INITIAL_ESTIMATE     64      ///< Size reserved for opcodes which have not been sent yet
+#define SERVER_MESSAGE_ESTIMATE_DECAY       16      ///< Estimates shrink by 1/16 of the difference per smaller message
+
+namespace SteerStone { namespace Game { namespace Server {
+
+    /// Outgoing message to client
+    /// Encodes straight into a pooled chunk sized by a running estimate of its opcode,
+    /// the chunk is handed to the out queue of the socket without being copied
+    class ServerMessage
+    {
+        DISALLOW_COPY_AND_ASSIGN(ServerMessage);
+
+        public:
+            /// Get current size estimate of opcode
+            /// @p_Header : Header id
+            static uint32 GetSizeEstimate(uint16 p_Header);
+
+        public:
+            /// Constructor
+            /// @p_Header : Header id
+            explicit ServerMessage(uint16 p_Header);
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Get header id
+            uint16 GetHeader() const;
+            /// Get length of message written so far, including header
+            std::size_t GetLength() const;
+
+            /// Append VL64 integer
+            /// @p_Value : Value
+            ServerMessage& AppendInt(int32 p_Value);
+            /// Append VL64 boolean
+            /// @p_Value : Value
+            ServerMessage& AppendBool(bool p_Value);
+            /// Append B64 integer
+            /// @p_Value  : Value
+            /// @p_Length : Amount of bytes to encode into
+            ServerMessage& AppendB64(uint32 p_Value, std::size_t p_Length = B64_HEADER_SIZE);
+            /// Append string followed by string terminator
+            /// @p_String : String, must not contain the terminator
+            ServerMessage& AppendString(std::string_view p_String);
+            /// Append raw bytes without terminator
+            /// @p_Data : Data
+            ServerMessage& AppendRaw(std::string_view p_Data);
+
+            /// Terminate message and give up our chunk, the message must not be used afterwards
+            /// The result can be queued to a single socket or shared between every recipient
+            Core::Network::SharedPacket Finalize();
+
+        private:
+            uint16 m_Header;                                        ///< Header id
+            std::shared_ptr<Core::Network::PacketBuffer> m_Buffer;  ///< Pooled chunk we encode into
+    };
+
+}   ///< namespace Server
+}   ///< namespace Game
+}   ///< namespace Steerstone
@@ -17,16 +17,76 @@
 */
 
 #include "Socket.hpp"
+#include "Diagnostic/DiaServerWatch.hpp"
+#include "Config/Config.hpp"
+#include "Threading/ThrTaskManager.hpp"
+#include "CryptoHandshake.hpp"
+#include "Cluster/ClusterLink.hpp"
+#include "Cluster/ClusterManager.hpp"
+#include "Map/RoomManager.hpp"
+#include "Messenger/MessengerManager.hpp"
+#include "Catalog/CatalogManager.hpp"
+#include "Inventory/InventoryManager.hpp"
+#include "Navigator/NavigatorManager.hpp"
+#include "Session/LoginPipeline.hpp"
+#include "Session/SessionRegistry.hpp"
 
 namespace SteerStone { namespace Game { namespace Server {
 
     /// Constructor 
     /// @p_Service : Boost Service
-    /// @p_CloseHandler : Close Handler Custom function
-    GameSocket::GameSocket(boost::asio::io_service& p_Service, std::function<void(Socket*)> p_CloseHandler)
-        : Socket(p_Service, std::move(p_CloseHandler))
+    /// @p_Owner : Owner told once we are closed
+    GameSocket::GameSocket(boost::asio::io_service& p_Service, Core::Network::SocketOwner* p_Owner)
+        : Socket(p_Service, p_Owner)
     {
-        m_AuthenticateState = Authenticated::NotAuthenticated;
+        m_AuthenticateState  = Authenticated::NotAuthenticated;
+        m_LastPong           = sServerTimeManager->GetServerTime();
+        m_LoginPending       = false;
+        m_KeyExchangePending = false;
+        m_RemoteSession      = 0;
+        m_RemoteRoomId       = 0;
+
+        /// Responses are sent once the handlers which produced them have run,
+        /// this keeps movement latency low while anything written in the same batch is still coalesced
+        Core::Network::FlushPolicySettings l_FlushPolicy;
+        l_FlushPolicy.Policy        = Core::Network::FlushPolicy::Tick;
+        l_FlushPolicy.ByteThreshold = 0;
+        l_FlushPolicy.Timeout       = 0;
+        SetFlushPolicy(l_FlushPolicy);
+
+        /// Slow consumers must not grow our memory without bound
+        static const Core::Network::BackpressureSettings sl_Backpressure =
+        {
+            static_cast<std::size_t>(sConfigManager->GetInt("OutQueueLowWaterMark",    64 * 1024)),
+            static_cast<std::size_t>(sConfigManager->GetInt("OutQueueHighWaterMark",   256 * 1024)),
+            static_cast<std::size_t>(sConfigManager->GetInt("OutQueueHardLimit",       1024 * 1024)),
+            static_cast<uint32>(sConfigManager->GetInt("OutQueueHardLimitTimeout",     10000))
+        };
+        SetBackpressure(sl_Backpressure);
+
+        /// Clients answer our ping, a client which sends nothing at all is gone
+        /// Handles pick up reloaded values for sockets accepted afterwards
+        static const Core::Configuration::ConfigHandle<uint32> sl_PingInterval("PingInterval", 30000);
+        static const Core::Configuration::ConfigHandle<uint32> sl_IdleTimeout("IdleTimeout", 90000);
+        SetPingInterval(sl_PingInterval.Get());
+        SetIdleTimeout(sl_IdleTimeout.Get());
+
+        /// Most clients sit idle in a room, their in buffer goes back to the pool until they talk again
+        static const Core::Configuration::ConfigHandle<uint32> sl_BufferReleaseDelay("BufferReleaseDelay", 5000);
+        SetBufferReleaseDelay(sl_BufferReleaseDelay.Get());
+    }
+    /// Deconstructor
+    GameSocket::~GameSocket()
+    {
+        /// A session replaced by a newer login of the same user is left in the registry
+        if (m_Session)
+        {
+            sSessionRegistry->Unregister(m_Session.get());
+            sMessenger->OnLogout(m_Session.get());
+        }
+
+        if (m_RemoteNode)
+            m_RemoteNode->CloseSession(m_RemoteSession);
     }
 
     //////////////////////////////////////////////////////////////////////////
@@ -35,18 +95,484 @@ namespace SteerStone { namespace Game { namespace Server {
     /// Handle incoming data
     Core::Network::ProcessState GameSocket::ProcessIncomingData()
     {
-        std::vector<uint8> l_BufferVec;
-        l_BufferVec.resize(ReadLengthRemaining());
+        /// Every message of a batch is charged to the rate limits at the same time
+        const uint32 l_Now = sServerTimeManager->GetServerTime();
+
+        /// Decode every complete frame straight from our in buffer, a partially recieved
+        /// frame is left in the buffer until the rest of it has arrived
+        for (;;)
+        {
+            ClientMessage l_Message;
+            std::size_t l_FrameLength = 0;
+
+            switch (ClientMessage::DecodeFrame(InView(), CLIENT_MESSAGE_MAX_LENGTH, l_Message, l_FrameLength))
+            {
+                case FrameState::Incomplete:
+                    return Core::Network::ProcessState::Successful;
+                case FrameState::Malformed:
+                {
+                    LOG_WARNING("GameSocket", "Recieved malformed frame from %0, closing socket", GetRemoteEndpoint());
+                    return Core::Network::ProcessState::Error;
+                }
+                case FrameState::Complete:
+                    break;
+            }
+
+            if (!ProcessClientMessage(l_Message, l_Now))
+                return Core::Network::ProcessState::Error;
+
+            ReadSkip(l_FrameLength);
+        }
+    }
+    /// Handle decoded message
+    /// @p_Message : Message recieved from client
+    /// @p_Now     : Server time the message is charged to its rate limits at
+    bool GameSocket::ProcessClientMessage(ClientMessage& p_Message, uint32 p_Now)
+    {
+        OpcodeHandler const& l_Handler = OpcodeTable::GetHandler(p_Message.GetHeader());
+
+        if (!l_Handler.Handler)
+        {
+            LOG_VERBOSE("GameSocket", "Unhandled message %0 (%1 bytes) from %2", p_Message.GetHeader(), p_Message.GetBody().GetLength(), GetRemoteEndpoint());
+            return true;
+        }
+
+        if ((l_Handler.Status == PacketStatus::Authenticated && m_AuthenticateState != Authenticated::Authenticed)
+            || (l_Handler.Status == PacketStatus::NotAuthenticated && m_AuthenticateState != Authenticated::NotAuthenticated))
+        {
+            LOG_WARNING("GameSocket", "Recieved %0 from %1 in wrong authentication state, ignoring", l_Handler.Name, GetRemoteEndpoint());
+            return true;
+        }
+
+        /// Flooded messages cost nothing past this point
+        uint32 l_Delay = 0;
+        switch (m_RateLimiter.Charge(l_Handler.Rate, p_Now, l_Delay))
+        {
+            case RateVerdict::Pass:
+                break;
+            case RateVerdict::Delay:
+                DelayClientMessage(l_Handler, p_Message, l_Delay);
+                return true;
+            case RateVerdict::Drop:
+                return true;
+            case RateVerdict::Disconnect:
+            {
+                LOG_WARNING("GameSocket", "%0 from %1 is over its rate limit, closing socket", l_Handler.Name, GetRemoteEndpoint());
+                return false;
+            }
+        }
+
+        DispatchClientMessage(l_Handler, p_Message);
+
+        return true;
+    }
+    /// Handle message on its execution target, its rate limits have been charged already
+    /// @p_Handler : Handler entry of message
+    /// @p_Message : Message recieved from client
+    void GameSocket::DispatchClientMessage(OpcodeHandler const& p_Handler, ClientMessage& p_Message)
+    {
+        /// Our room lives on a game node, pongs also keep our socket there alive
+        if (m_RemoteNode && (p_Handler.Target == ExecutionTarget::Room || p_Message.GetHeader() == CLIENT_PONG))
+        {
+            m_RemoteNode->Forward(m_RemoteSession, p_Message.GetHeader(), p_Message.GetBody());
+
+            if (p_Handler.Target == ExecutionTarget::Room)
+                return;
+        }
+
+        if (p_Handler.Target != ExecutionTarget::NetworkThread)
+        {
+            DeferClientMessage(p_Handler, p_Message);
+            return;
+        }
+
+        OpcodeTable::Execute(p_Handler, this, p_Message);
+    }
+    /// Copy message out of our in buffer and dispatch it once its rate limits refilled
+    /// @p_Handler : Handler entry of message
+    /// @p_Message : Message recieved from client
+    /// @p_Delay   : MS to wait
+    void GameSocket::DelayClientMessage(OpcodeHandler const& p_Handler, ClientMessage const& p_Message, uint32 p_Delay)
+    {
+        Core::Network::PacketView const& l_Body = p_Message.GetBody();
+
+        std::shared_ptr<std::vector<uint8>> l_Storage = std::make_shared<std::vector<uint8>>(l_Body.GetData(), l_Body.GetData() + l_Body.GetLength());
+        std::shared_ptr<GameSocket> l_Socket = Shared<GameSocket>();
+        const uint16 l_Header = p_Message.GetHeader();
+
+        /// Delayed messages are bounded by the burst of their bucket, the timer keeps its message alive
+        std::shared_ptr<boost::asio::steady_timer> l_Timer = std::make_shared<boost::asio::steady_timer>(GetAsioSocket().get_executor(), std::chrono::milliseconds(p_Delay));
+        l_Timer->async_wait([l_Timer, l_Socket, l_Storage, l_Header, &p_Handler](boost::system::error_code const& p_ErrorCode)
+        {
+            if (p_ErrorCode || l_Socket->IsClosed())
+                return;
+
+            ClientMessage l_Message(l_Header, Core::Network::PacketView(l_Storage->data(), l_Storage->size()));
+            l_Socket->DispatchClientMessage(p_Handler, l_Message);
+        });
+    }
+    /// Copy message out of our in buffer and handle it later on its execution target
+    /// @p_Handler : Handler entry of message
+    /// @p_Message : Message recieved from client
+    void GameSocket::DeferClientMessage(OpcodeHandler const& p_Handler, ClientMessage const& p_Message)
+    {
+        Core::Network::PacketView const& l_Body = p_Message.GetBody();
+
+        std::shared_ptr<std::vector<uint8>> l_Storage = std::make_shared<std::vector<uint8>>(l_Body.GetData(), l_Body.GetData() + l_Body.GetLength());
+        std::shared_ptr<GameSocket> l_Socket = Shared<GameSocket>();
+        const uint16 l_Header = p_Message.GetHeader();
+
+        auto l_Execute = [l_Socket, l_Storage, l_Header, &p_Handler]()
+        {
+            if (l_Socket->IsClosed())
+                return;
+
+            ClientMessage l_Message(l_Header, Core::Network::PacketView(l_Storage->data(), l_Storage->size()));
+            OpcodeTable::Execute(p_Handler, l_Socket.get(), l_Message);
+        };
+
+        /// Room messages run on the strand of our room, outside of a room there is nobody to handle them
+        if (p_Handler.Target == ExecutionTarget::Room)
+        {
+            if (m_Room)
+                m_Room->Post(std::move(l_Execute));
+
+            return;
+        }
+
+        /// Sessions run on our network thread until they have their own executors,
+        /// posting keeps messages of this socket in order
+        boost::asio::post(GetAsioSocket().get_executor(), std::move(l_Execute));
+    }
+    /// Gateway only, enter room on the game node owning it, opening a session there if we have none yet
+    /// @p_RoomId : Id of room
+    void GameSocket::EnterRemoteRoom(uint32 p_RoomId)
+    {
+        std::shared_ptr<Cluster::GameNodeLink> l_Owner = sCluster->GetRoomOwner(p_RoomId);
+
+        if (m_RemoteNode && m_RemoteNode != l_Owner)
+            LeaveRemoteRoom();
+
+        m_RemoteRoomId = l_Owner ? p_RoomId : 0;
+        if (!l_Owner)
+            return;
 
-        /// Read the entire buffer
-        if (Read((char*)& l_BufferVec[0], ReadLengthRemaining()))
+        if (!m_RemoteNode)
         {
-            /// Remove junk data
-            l_BufferVec.resize(l_BufferVec.size() + 1);
-            l_BufferVec[l_BufferVec.size() - 1] = 0;
+            m_RemoteNode    = std::move(l_Owner);
+            m_RemoteSession = m_RemoteNode->OpenSession(Shared<GameSocket>(), m_Session ? m_Session->GetUserId() : 0);
         }
 
-        return Core::Network::ProcessState::Successful;
+        /// The node enters the room as if its socket of ours sent CLIENT_GOTO_FLAT, leaving the one it is in
+        uint8 l_Body[VL64_MAX_SIZE];
+        const std::size_t l_Length = Encoding::EncodeVL64(static_cast<int32>(p_RoomId), l_Body);
+        m_RemoteNode->Forward(m_RemoteSession, CLIENT_GOTO_FLAT, Core::Network::PacketView(l_Body, l_Length));
+    }
+    /// Gateway only, close our session on its game node
+    void GameSocket::LeaveRemoteRoom()
+    {
+        m_RemoteNode->CloseSession(m_RemoteSession);
+        m_RemoteNode.reset();
+        m_RemoteSession = 0;
+    }
+
+    /// Ping client, client answers with CLIENT_PONG
+    void GameSocket::OnPingTimer()
+    {
+        ServerMessage l_Ping(SERVER_PING);
+        Send(l_Ping);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get authentication state
+    Authenticated GameSocket::GetAuthenticateState() const
+    {
+        return m_AuthenticateState;
+    }
+
+    /// Queue message to be sent, its chunk is not copied
+    /// @p_Message  : Message, finalized by us and must not be used afterwards
+    /// @p_Priority : Non essential messages are dropped while congested
+    /// Returns false if message has been dropped
+    bool GameSocket::Send(ServerMessage& p_Message, Core::Network::WritePriority p_Priority)
+    {
+        return Write(p_Message.Finalize(), p_Priority);
+    }
+
+    /// Login finished, safe from any thread, handled on our network thread
+    /// @p_Session : Session of user, nullptr if login failed
+    void GameSocket::OnLoginResult(std::shared_ptr<Session::UserSession> p_Session)
+    {
+        boost::asio::post(GetAsioSocket().get_executor(), [l_Socket = Shared<GameSocket>(), l_Session = std::move(p_Session)]() mutable
+        {
+            l_Socket->m_LoginPending = false;
+
+            if (!l_Session)
+            {
+                if (l_Socket->IsClosed())
+                    return;
+
+                ServerMessage l_Error(SERVER_ERROR);
+                l_Error.AppendString("login incorrect");
+                l_Socket->Send(l_Error);
+                return;
+            }
+
+            /// Socket went away while logging in, the registry must not keep pointing at it
+            if (l_Socket->IsClosed())
+            {
+                sSessionRegistry->Unregister(l_Session.get());
+                return;
+            }
+
+            l_Socket->m_Session             = std::move(l_Session);
+            l_Socket->m_AuthenticateState   = Authenticated::Authenticed;
+
+            ServerMessage l_LoginOk(SERVER_LOGIN_OK);
+            l_Socket->Send(l_LoginOk);
+
+            sMessenger->OnLogin(l_Socket->m_Session, l_Socket);
+        });
+    }
+
+    /// Gateway only, check the node owning our room is still the one our session is on, a room which moved
+    /// or whose node went down is entered again on its new owner, network thread only
+    void GameSocket::RefreshRemoteRoom()
+    {
+        if (!m_RemoteRoomId || IsClosed())
+            return;
+
+        if (m_RemoteNode && !m_RemoteNode->IsClosed() && sCluster->GetRoomOwner(m_RemoteRoomId) == m_RemoteNode)
+            return;
+
+        /// The client stays connected to us, it lands at the door of the same room on the new node
+        EnterRemoteRoom(m_RemoteRoomId);
+
+        if (!m_RemoteRoomId && m_Session)
+            sMessenger->OnRoomChange(m_Session->GetUserId(), 0);
+    }
+    /// Gateway only, node closed our session, network thread only
+    /// @p_Session : Id of session
+    void GameSocket::OnRemoteSessionClosed(uint32 p_Session)
+    {
+        if (!m_RemoteNode || p_Session != m_RemoteSession)
+            return;
+
+        m_RemoteNode.reset();
+        m_RemoteSession = 0;
+        m_RemoteRoomId  = 0;
+
+        if (m_Session)
+            sMessenger->OnRoomChange(m_Session->GetUserId(), 0);
+    }
+
+    /// Save authentication state so a new process can continue our session
+    /// @p_State : Output
+    bool GameSocket::SaveHandoffState(std::vector<uint8>& p_State)
+    {
+        p_State.push_back(static_cast<uint8>(m_AuthenticateState));
+        return true;
+    }
+    /// Restore authentication state saved by the previous process
+    /// @p_State  : Saved state
+    /// @p_Length : Length of saved state
+    bool GameSocket::LoadHandoffState(uint8 const* p_State, std::size_t p_Length)
+    {
+        if (p_Length != 1 || p_State[0] > static_cast<uint8>(Authenticated::NotAuthenticated))
+            return false;
+
+        m_AuthenticateState = static_cast<Authenticated>(p_State[0]);
+        return true;
+    }
+
+    /// Client replied to our ping, connection is still alive
+    /// @p_Message : Message recieved from client
+    void GameSocket::HandlePong(ClientMessage& p_Message)
+    {
+        m_LastPong = sServerTimeManager->GetServerTime();
+    }
+    /// Enter room, leaving the one we are in
+    /// @p_Message : Message recieved from client
+    void GameSocket::HandleGotoFlat(ClientMessage& p_Message)
+    {
+        const int32 l_RoomId = p_Message.ReadInt();
+        if (p_Message.HasError() || l_RoomId < 0)
+            return;
+
+        /// Rooms of a gateway live on game nodes, only our session follows us between them
+        if (sCluster->IsGateway())
+        {
+            EnterRemoteRoom(static_cast<uint32>(l_RoomId));
+
+            if (m_Session)
+                sMessenger->OnRoomChange(m_Session->GetUserId(), m_RemoteRoomId);
+
+            return;
+        }
+
+        if (m_Room)
+        {
+            std::shared_ptr<Map::Room> l_Room = std::move(m_Room);
+            l_Room->Post([l_Room, l_Socket = this]() { l_Room->RemoveUser(l_Socket); });
+        }
+
+        m_Room = sRoomManager->EnterRoom(static_cast<uint32>(l_RoomId));
+        if (m_Room)
+        {
+            std::shared_ptr<GameSocket> l_Socket = Shared<GameSocket>();
+            Map::Room* l_Room = m_Room.get();
+            m_Room->Post([l_Room, l_Socket]() { l_Room->AddUser(l_Socket); });
+        }
+
+        if (m_Session)
+            sMessenger->OnRoomChange(m_Session->GetUserId(), m_Room ? m_Room->GetId() : 0);
+    }
+    /// Walk to tile, runs on the strand of our room
+    /// @p_Message : Message recieved from client
+    void GameSocket::HandleMove(ClientMessage& p_Message)
+    {
+        const uint32 l_X = p_Message.ReadB64();
+        const uint32 l_Y = p_Message.ReadB64();
+        if (p_Message.HasError())
+            return;
+
+        if (Map::Room* l_Room = Map::Room::GetCurrent())
+            l_Room->MoveUser(this, static_cast<int16>(l_X), static_cast<int16>(l_Y));
+    }
+    /// Log in with an SSO ticket, the database work is done by the login pipeline
+    /// @p_Message : Message recieved from client
+    void GameSocket::HandleSSO(ClientMessage& p_Message)
+    {
+        std::string l_Ticket(p_Message.ReadString());
+        if (p_Message.HasError() || m_LoginPending)
+            return;
+
+        m_LoginPending = true;
+        sLoginPipeline->Login(Shared<GameSocket>(), std::move(l_Ticket));
+    }
+    /// Open navigator tab, pages are served from the navigator cache
+    /// @p_Message : Message recieved from client
+    void GameSocket::HandleNavigate(ClientMessage& p_Message)
+    {
+        const int32 l_CategoryId = p_Message.ReadInt();
+        const int32 l_Page       = p_Message.ReadInt();
+        if (p_Message.HasError() || l_CategoryId < 0 || l_Page < 0)
+            return;
+
+        Core::Network::SharedPacket l_Packet = sNavigatorManager->GetPage(static_cast<uint32>(l_CategoryId), static_cast<uint32>(l_Page));
+        if (l_Packet.GetBuffer())
+            Write(l_Packet);
+    }
+    /// Search rooms by name
+    /// @p_Message : Message recieved from client
+    void GameSocket::HandleSearchFlats(ClientMessage& p_Message)
+    {
+        const std::string_view l_Query = p_Message.ReadString();
+        if (p_Message.HasError())
+            return;
+
+        Write(sNavigatorManager->Search(l_Query));
+    }
+    /// Open catalog, the index of our rank is serialized once per catalog load
+    /// @p_Message : Message recieved from client
+    void GameSocket::HandleGetCatalogIndex(ClientMessage& p_Message)
+    {
+        std::shared_ptr<Catalog::CatalogSnapshot const> l_Catalog = sCatalogManager->GetSnapshot();
+
+        Core::Network::SharedPacket const& l_Index = l_Catalog->GetIndexPayload(m_Session ? m_Session->GetProfile()->Rank : 0);
+        if (l_Index.GetBuffer())
+            Write(l_Index);
+    }
+    /// Open catalog page, pages are serialized once per catalog load
+    /// @p_Message : Message recieved from client
+    void GameSocket::HandleGetCatalogPage(ClientMessage& p_Message)
+    {
+        const int32 l_PageId = p_Message.ReadInt();
+        if (p_Message.HasError() || l_PageId < 0)
+            return;
+
+        std::shared_ptr<Catalog::CatalogSnapshot const> l_Catalog = sCatalogManager->GetSnapshot();
+
+        if (Core::Network::SharedPacket const* l_Page = l_Catalog->GetPagePayload(static_cast<uint32>(l_PageId), m_Session ? m_Session->GetProfile()->Rank : 0))
+            Write(*l_Page);
+    }
+    /// Open page of hand, pages not in memory are loaded on a task worker and sent once loaded
+    /// @p_Message : Message recieved from client
+    void GameSocket::HandleGetInventory(ClientMessage& p_Message)
+    {
+        const int32 l_Page = p_Message.ReadInt();
+        if (p_Message.HasError() || l_Page < 0 || !m_Session)
+            return;
+
+        /// Nothing of the hand is read at login, only once the user opens it
+        if (!m_Inventory)
+            m_Inventory = sInventoryManager->Create(m_Session->GetUserId());
+
+        sInventoryManager->Open(m_Inventory, Shared<GameSocket>(), static_cast<uint32>(l_Page));
+    }
+    /// Client asks whether traffic is encrypted, parameters of the key exchange are sent along
+    /// @p_Message : Message recieved from client
+    void GameSocket::HandleInitCrypto(ClientMessage& /*p_Message*/)
+    {
+        const bool l_Enabled = Core::Network::SocketCipher::IsEnabled() && !IsCipherEnabled();
+
+        ServerMessage l_Parameters(SERVER_CRYPTO_PARAMETERS);
+        l_Parameters.AppendInt(l_Enabled ? 1 : 0);
+        if (l_Enabled)
+        {
+            l_Parameters.AppendString(CryptoHandshake::GetPrime());
+            l_Parameters.AppendString(CryptoHandshake::GetGenerator());
+        }
+        Send(l_Parameters);
+    }
+    /// Client sent its public key, the exchange is computed on a task worker and traffic is encrypted once
+    /// our public key has been queued, the client does not send anything else until it recieved it
+    /// @p_Message : Message recieved from client
+    void GameSocket::HandleGenerateKey(ClientMessage& p_Message)
+    {
+        std::string l_ClientPublic(p_Message.ReadString());
+        if (p_Message.HasError() || m_KeyExchangePending || IsCipherEnabled() || !Core::Network::SocketCipher::IsEnabled())
+            return;
+
+        m_KeyExchangePending = true;
+
+        std::weak_ptr<GameSocket> l_Socket = Shared<GameSocket>();
+        sThreadManager->PushRunOnceTask(Core::Threading::TaskType::Normal, [l_Socket, l_ClientPublic = std::move(l_ClientPublic)]()
+        {
+            std::shared_ptr<GameSocket> l_Strong = l_Socket.lock();
+            if (!l_Strong || l_Strong->IsClosed())
+                return;
+
+            std::string l_ServerPublic;
+            std::vector<uint8> l_ClientKey, l_ServerKey;
+            const bool l_Computed = CryptoHandshake::Compute(l_ClientPublic, l_ServerPublic, l_ClientKey, l_ServerKey);
+
+            boost::asio::post(l_Strong->GetAsioSocket().get_executor(), [l_Strong, l_Computed, l_ServerPublic = std::move(l_ServerPublic),
+                l_ClientKey = std::move(l_ClientKey), l_ServerKey = std::move(l_ServerKey)]()
+            {
+                l_Strong->m_KeyExchangePending = false;
+
+                if (l_Strong->IsClosed())
+                    return;
+
+                if (!l_Computed)
+                {
+                    LOG_WARNING("GameSocket", "%0 sent an invalid public key, closing socket", l_Strong->GetRemoteEndpoint());
+                    l_Strong->CloseSocket();
+                    return;
+                }
+
+                /// Our public key is queued before the cipher is enabled, so it is the last message sent plain
+                ServerMessage l_SecretKey(SERVER_SECRET_KEY);
+                l_SecretKey.AppendString(l_ServerPublic);
+                l_Strong->Send(l_SecretKey);
+
+                if (!l_Strong->EnableCipher(l_ClientKey.data(), l_ServerKey.data()))
+                    l_Strong->CloseSocket();
+            });
+        });
     }
 }   ///< namespace Server
 }   ///< namespace Game
@@ -19,8 +19,21 @@
 #pragma once
 #include "Network/Listener.hpp"
 #include "Diagnostic/DiaStopWatch.hpp"
+#include "ClientMessage.hpp"
+#include "ServerMessage.hpp"
+#include "Opcodes/Opcodes.hpp"
+#include "RateLimiter.hpp"
 
-namespace SteerStone { namespace Game { namespace Server {
+#define CLIENT_MESSAGE_MAX_LENGTH (STORAGE_INITIAL_SIZE - B64_LENGTH_SIZE)
+
+namespace SteerStone { namespace Game {
+
+    namespace Cluster { class GameNodeLink; }
+    namespace Inventory { class UserInventory; }
+    namespace Map { class Room; }
+    namespace Session { class UserSession; }
+
+namespace Server {
 
     enum class Authenticated
     {
@@ -38,14 +51,49 @@ namespace SteerStone { namespace Game { namespace Server {
         public:
             /// Constructor 
             /// @p_Service : Boost Service
-            /// @p_CloseHandler : Close Handler Custom function
-            GameSocket(boost::asio::io_service& p_Service, std::function<void(Socket*)> p_CloseHandler);
+            /// @p_Owner : Owner told once we are closed
+            GameSocket(boost::asio::io_service& p_Service, Core::Network::SocketOwner* p_Owner);
             /// Deconstructor
-            ~GameSocket() {}
+            ~GameSocket();
 
         //////////////////////////////////////////////////////////////////////////
         //////////////////////////////////////////////////////////////////////////
 
+        public:
+            /// Get authentication state
+            Authenticated GetAuthenticateState() const;
+
+            /// Queue message to be sent, its chunk is not copied
+            /// @p_Message  : Message, finalized by us and must not be used afterwards
+            /// @p_Priority : Non essential messages are dropped while congested
+            /// Returns false if message has been dropped
+            bool Send(ServerMessage& p_Message, Core::Network::WritePriority p_Priority = Core::Network::WritePriority::Essential);
+
+            /// Login finished, safe from any thread, handled on our network thread
+            /// @p_Session : Session of user, nullptr if login failed
+            void OnLoginResult(std::shared_ptr<Session::UserSession> p_Session);
+            /// Get session of logged in user, nullptr before login, network thread only
+            std::shared_ptr<Session::UserSession> const& GetSession() const { return m_Session; }
+
+            /// Gateway only, check the node owning our room is still the one our session is on, a room which moved
+            /// or whose node went down is entered again on its new owner, network thread only
+            void RefreshRemoteRoom();
+            /// Gateway only, node closed our session, network thread only
+            /// @p_Session : Id of session
+            void OnRemoteSessionClosed(uint32 p_Session);
+
+            /// Handlers
+            void HandlePong(ClientMessage& p_Message);
+            void HandleGotoFlat(ClientMessage& p_Message);
+            void HandleMove(ClientMessage& p_Message);
+            void HandleSSO(ClientMessage& p_Message);
+            void HandleNavigate(ClientMessage& p_Message);
+            void HandleSearchFlats(ClientMessage& p_Message);
+            void HandleGetCatalogIndex(ClientMessage& p_Message);
+            void HandleGetCatalogPage(ClientMessage& p_Message);
+            void HandleGetInventory(ClientMessage& p_Message);
+            void HandleInitCrypto(ClientMessage& p_Message);
+            void HandleGenerateKey(ClientMessage& p_Message);
 
         //////////////////////////////////////////////////////////////////////////
         //////////////////////////////////////////////////////////////////////////
@@ -53,9 +101,50 @@ namespace SteerStone { namespace Game { namespace Server {
         private:
             /// Handle incoming data
             virtual Core::Network::ProcessState ProcessIncomingData() override;
+            /// Ping client, client answers with CLIENT_PONG
+            virtual void OnPingTimer() override;
+            /// Save authentication state so a new process can continue our session
+            /// @p_State : Output
+            virtual bool SaveHandoffState(std::vector<uint8>& p_State) override;
+            /// Restore authentication state saved by the previous process
+            /// @p_State  : Saved state
+            /// @p_Length : Length of saved state
+            virtual bool LoadHandoffState(uint8 const* p_State, std::size_t p_Length) override;
+            /// Handle decoded message
+            /// @p_Message : Message recieved from client
+            /// @p_Now     : Server time the message is charged to its rate limits at
+            bool ProcessClientMessage(ClientMessage& p_Message, uint32 p_Now);
+            /// Handle message on its execution target, its rate limits have been charged already
+            /// @p_Handler : Handler entry of message
+            /// @p_Message : Message recieved from client
+            void DispatchClientMessage(OpcodeHandler const& p_Handler, ClientMessage& p_Message);
+            /// Copy message out of our in buffer and dispatch it once its rate limits refilled
+            /// @p_Handler : Handler entry of message
+            /// @p_Message : Message recieved from client
+            /// @p_Delay   : MS to wait
+            void DelayClientMessage(OpcodeHandler const& p_Handler, ClientMessage const& p_Message, uint32 p_Delay);
+            /// Copy message out of our in buffer and handle it later on its execution target
+            /// @p_Handler : Handler entry of message
+            /// @p_Message : Message recieved from client
+            void DeferClientMessage(OpcodeHandler const& p_Handler, ClientMessage const& p_Message);
+            /// Gateway only, enter room on the game node owning it, opening a session there if we have none yet
+            /// @p_RoomId : Id of room
+            void EnterRemoteRoom(uint32 p_RoomId);
+            /// Gateway only, close our session on its game node
+            void LeaveRemoteRoom();
 
         private:
-            Authenticated m_AuthenticateState;
+            Authenticated m_AuthenticateState;                ///< Authentication state
+            uint32 m_LastPong;                                ///< Server time of last pong
+            std::shared_ptr<Map::Room> m_Room;                ///< Room we are in, network thread only
+            std::shared_ptr<Session::UserSession> m_Session;  ///< Session of logged in user, network thread only
+            bool m_LoginPending;                              ///< Login has been handed to the login pipeline
+            bool m_KeyExchangePending;                        ///< Key exchange has been handed to a task worker
+            std::shared_ptr<Inventory::UserInventory> m_Inventory;  ///< Hand of logged in user, created when first opened, network thread only
+            RateLimiter m_RateLimiter;                        ///< Token buckets of our messages, network thread only
+            std::shared_ptr<Cluster::GameNodeLink> m_RemoteNode;    ///< Game node our session is on, gateway only, network thread only
+            uint32 m_RemoteSession;                           ///< Id of our session on its game node
+            uint32 m_RemoteRoomId;                            ///< Room we are in on its game node, 0 if none
     };
 
 }   ///< namespace Server
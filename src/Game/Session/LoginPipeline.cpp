@@ -0,0 +1,326 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "LoginPipeline.hpp"
+#include "SessionRegistry.hpp"
+#include "Config/Config.hpp"
+#include "Database/DatabaseTypes.hpp"
+#include "Database/GameStatements.hpp"
+#include "Server/Socket.hpp"
+
+namespace SteerStone { namespace Game { namespace Session {
+
+    SINGLETON_P_I(LoginPipeline);
+
+    /// Constructor
+    LoginPipeline::LoginPipeline()
+        : m_MaxInFlight(LOGIN_MAX_IN_FLIGHT), m_MaxQueued(LOGIN_MAX_QUEUED),
+        m_InFlightCount(0), m_QueuedCount(0), m_SuccessCount(0), m_FailureCount(0)
+    {
+    }
+    /// Deconstructor
+    LoginPipeline::~LoginPipeline()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Create caches and read settings, called once the game database is up
+    void LoginPipeline::Initialize()
+    {
+        m_MaxInFlight   = std::max<uint32>(1, sConfigManager->GetInt("LoginMaxInFlight", LOGIN_MAX_IN_FLIGHT));
+        m_MaxQueued     = sConfigManager->GetInt("LoginMaxQueued", LOGIN_MAX_QUEUED);
+
+        m_Strand = Core::Threading::Strand::Create();
+
+        /// Results are processed on our strand, posting once per batch of completions instead of once per result
+        m_Queue = std::make_unique<Core::Database::CompletionQueue>([this]()
+        {
+            m_Strand->Post([this]() { m_Queue->Process(); });
+        });
+
+        /// Each field group upserts its own columns keyed on id, a look change never rewrites credits
+        m_LookWriter    = std::make_unique<Core::Database::BatchWriter>(&GameDatabase, "users", std::vector<std::string>{ "id", "figure", "sex", "mission" }, 256, 1000, 1);
+        m_CreditsWriter = std::make_unique<Core::Database::BatchWriter>(&GameDatabase, "users", std::vector<std::string>{ "id", "credits" }, 256, 1000, 1);
+
+        m_Users = std::make_unique<UserCache>("Users", &LoginPipeline::LoadProfile,
+            static_cast<std::size_t>(sConfigManager->GetInt("UserCacheCapacity", USER_CACHE_CAPACITY)),
+            static_cast<uint32>(sConfigManager->GetInt("UserCacheFlushInterval", USER_CACHE_FLUSH_INTERVAL)));
+
+        m_Users->SetFieldGroup(USER_FIELD_LOOK, m_LookWriter.get(), [](uint32 const& p_Id, UserProfile const& p_Profile)
+        {
+            return Core::Database::BatchWriter::Row{ p_Id, p_Profile.Figure, p_Profile.Gender, p_Profile.Motto };
+        });
+        m_Users->SetFieldGroup(USER_FIELD_CREDITS, m_CreditsWriter.get(), [](uint32 const& p_Id, UserProfile const& p_Profile)
+        {
+            return Core::Database::BatchWriter::Row{ p_Id, p_Profile.Credits };
+        });
+
+        LOG_INFO("LoginPipeline", "Login pipeline started, %0 logins in flight, %1 queued", m_MaxInFlight, m_MaxQueued);
+    }
+    /// Write modified profiles and drop caches, called before the game database stops
+    void LoginPipeline::Shutdown()
+    {
+        /// The user cache flushes into the writers as it goes, writers go after it
+        m_Users.reset();
+        m_LookWriter.reset();
+        m_CreditsWriter.reset();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Log socket in, safe from any thread, the socket is told the result on its network thread
+    /// @p_Socket : Socket
+    /// @p_Ticket : SSO ticket
+    void LoginPipeline::Login(std::shared_ptr<Server::GameSocket> const& p_Socket, std::string p_Ticket)
+    {
+        if (!m_Strand || p_Ticket.empty() || p_Ticket.size() > LOGIN_TICKET_MAX_LENGTH)
+        {
+            m_FailureCount.fetch_add(1, std::memory_order_relaxed);
+            p_Socket->OnLoginResult(nullptr);
+            return;
+        }
+
+        m_Strand->Post([this, l_Request = LoginRequest{ p_Socket, std::move(p_Ticket), 0 }]() mutable
+        {
+            Admit(std::move(l_Request));
+        });
+    }
+
+    /// Admit login or queue it, strand only
+    /// @p_Request : Login
+    void LoginPipeline::Admit(LoginRequest&& p_Request)
+    {
+        if (m_InFlightCount.load(std::memory_order_relaxed) < m_MaxInFlight)
+        {
+            m_InFlightCount.fetch_add(1, std::memory_order_relaxed);
+            Start(std::make_shared<LoginRequest>(std::move(p_Request)));
+            return;
+        }
+
+        if (m_Waiting.size() >= m_MaxQueued)
+        {
+            LOG_WARNING("LoginPipeline", "Login queue is full (%0), refusing login", m_Waiting.size());
+            m_FailureCount.fetch_add(1, std::memory_order_relaxed);
+            p_Request.Socket->OnLoginResult(nullptr);
+            return;
+        }
+
+        m_Waiting.push_back(std::move(p_Request));
+        m_QueuedCount.store(static_cast<uint32>(m_Waiting.size()), std::memory_order_relaxed);
+    }
+    /// Look up ticket, strand only
+    /// @p_Request : Login
+    void LoginPipeline::Start(std::shared_ptr<LoginRequest> const& p_Request)
+    {
+        /// Client gave up while queued
+        if (p_Request->Socket->IsClosed())
+        {
+            m_InFlightCount.fetch_sub(1, std::memory_order_relaxed);
+            Release();
+            return;
+        }
+
+        /// Tickets are single use, the lookup is never cached and goes to the primary
+        Core::Database::PreparedStatement* l_Statement = GameDatabase.GetPrepareStatement(GAME_SEL_USER_BY_TICKET);
+        if (!l_Statement)
+        {
+            Fail(p_Request, "no statement available");
+            return;
+        }
+
+        l_Statement->SetString(0, p_Request->Ticket);
+
+        GameDatabase.PrepareOperator(l_Statement, m_Queue.get(), [this, p_Request](std::unique_ptr<Core::Database::PreparedResultSet> p_Result)
+        {
+            OnTicket(p_Request, std::move(p_Result));
+        }, Core::Database::QueuePolicy::FailFast);
+    }
+    /// Ticket looked up, consume it, strand only
+    /// @p_Request : Login
+    /// @p_Result  : Id of user owning the ticket, nullptr or empty if none
+    void LoginPipeline::OnTicket(std::shared_ptr<LoginRequest> const& p_Request, std::unique_ptr<Core::Database::PreparedResultSet> p_Result)
+    {
+        if (!p_Result || p_Result->GetRowCount() == 0)
+        {
+            Fail(p_Request, "ticket not found");
+            return;
+        }
+
+        p_Request->UserId = p_Result->Get(0, 0).GetUInt32();
+
+        /// Consume ticket on the worker of the user, queued after any write of a previous session
+        Core::Database::PreparedStatement* l_Statement = GameDatabase.GetPrepareStatement(GAME_UPD_USER_CLEAR_TICKET);
+        if (!l_Statement)
+        {
+            Fail(p_Request, "no statement available");
+            return;
+        }
+
+        l_Statement->SetUint32(0, p_Request->UserId);
+
+        GameDatabase.PrepareOperator(l_Statement, p_Request->UserId, m_Queue.get(), [this, p_Request](std::unique_ptr<Core::Database::PreparedResultSet> p_Cleared)
+        {
+            OnTicketCleared(p_Request, std::move(p_Cleared));
+        }, Core::Database::QueuePolicy::FailFast);
+    }
+    /// Ticket consumed, get profile, strand only
+    /// @p_Request : Login
+    /// @p_Result  : Result of the update, nullptr if it was rejected or failed
+    void LoginPipeline::OnTicketCleared(std::shared_ptr<LoginRequest> const& p_Request, std::unique_ptr<Core::Database::PreparedResultSet> p_Result)
+    {
+        /// A ticket still set could be replayed, the login only goes through once it is gone
+        if (!p_Result)
+        {
+            Fail(p_Request, "ticket not consumed");
+            return;
+        }
+
+        /// A user logging in again is often still cached from the last session, with writes not flushed yet
+        if (std::shared_ptr<UserProfile> l_Profile = m_Users->Find(p_Request->UserId))
+        {
+            Complete(p_Request, l_Profile);
+            return;
+        }
+
+        /// The user cache is the only copy kept, a profile it evicted or modified is read back from the primary
+        Core::Database::PreparedStatement* l_Statement = GameDatabase.GetPrepareStatement(GAME_SEL_USER_PROFILE);
+        if (!l_Statement)
+        {
+            Fail(p_Request, "no statement available");
+            return;
+        }
+
+        l_Statement->SetUint32(0, p_Request->UserId);
+
+        GameDatabase.PrepareOperator(l_Statement, p_Request->UserId, m_Queue.get(), [this, p_Request](std::unique_ptr<Core::Database::PreparedResultSet> p_Profile)
+        {
+            OnProfile(p_Request, std::move(p_Profile));
+        }, Core::Database::QueuePolicy::FailFast);
+    }
+    /// Profile fetched, cache it and log in, strand only
+    /// @p_Request : Login
+    /// @p_Result  : Profile row, nullptr or empty if none
+    void LoginPipeline::OnProfile(std::shared_ptr<LoginRequest> const& p_Request, std::unique_ptr<Core::Database::PreparedResultSet> p_Result)
+    {
+        if (!p_Result || p_Result->GetRowCount() == 0)
+        {
+            Fail(p_Request, "profile not found");
+            return;
+        }
+
+        Complete(p_Request, m_Users->Add(p_Request->UserId, ReadProfile(*p_Result)));
+    }
+    /// Register session and hand it to the socket, strand only
+    /// @p_Request : Login
+    /// @p_Profile : Profile of user
+    void LoginPipeline::Complete(std::shared_ptr<LoginRequest> const& p_Request, std::shared_ptr<UserProfile> const& p_Profile)
+    {
+        m_InFlightCount.fetch_sub(1, std::memory_order_relaxed);
+
+        if (p_Request->Socket->IsClosed())
+        {
+            Release();
+            return;
+        }
+
+        std::shared_ptr<UserSession> l_Session = std::make_shared<UserSession>(p_Profile, p_Request->Socket);
+
+        /// Only one session per user, the older one is kicked
+        if (std::shared_ptr<UserSession> l_Replaced = sSessionRegistry->Register(l_Session))
+        {
+            LOG_INFO("LoginPipeline", "User %0 logged in again, closing previous session", l_Session->GetUserId());
+
+            if (std::shared_ptr<Server::GameSocket> l_Socket = l_Replaced->GetSocket())
+                l_Socket->CloseSocket();
+        }
+
+        m_SuccessCount.fetch_add(1, std::memory_order_relaxed);
+        p_Request->Socket->OnLoginResult(l_Session);
+
+        Release();
+    }
+    /// Tell the socket login failed, strand only
+    /// @p_Request : Login
+    /// @p_Reason  : Reason logged
+    void LoginPipeline::Fail(std::shared_ptr<LoginRequest> const& p_Request, char const* p_Reason)
+    {
+        LOG_VERBOSE("LoginPipeline", "Login of %0 failed, %1", p_Request->Socket->GetRemoteEndpoint(), p_Reason);
+
+        m_InFlightCount.fetch_sub(1, std::memory_order_relaxed);
+        m_FailureCount.fetch_add(1, std::memory_order_relaxed);
+        p_Request->Socket->OnLoginResult(nullptr);
+
+        Release();
+    }
+    /// Free spot of a finished login and start the next queued one, strand only
+    void LoginPipeline::Release()
+    {
+        while (!m_Waiting.empty() && m_InFlightCount.load(std::memory_order_relaxed) < m_MaxInFlight)
+        {
+            std::shared_ptr<LoginRequest> l_Request = std::make_shared<LoginRequest>(std::move(m_Waiting.front()));
+            m_Waiting.pop_front();
+
+            m_InFlightCount.fetch_add(1, std::memory_order_relaxed);
+            Start(l_Request);
+        }
+
+        m_QueuedCount.store(static_cast<uint32>(m_Waiting.size()), std::memory_order_relaxed);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Read profile from a profile row
+    /// @p_Result : Result of GAME_SEL_USER_PROFILE
+    std::shared_ptr<UserProfile> LoginPipeline::ReadProfile(Core::Database::PreparedResultSet const& p_Result)
+    {
+        std::shared_ptr<UserProfile> l_Profile = std::make_shared<UserProfile>();
+        l_Profile->Id       = p_Result.Get(0, 0).GetUInt32();
+        l_Profile->Name     = p_Result.Get(0, 1).GetString();
+        l_Profile->Figure   = p_Result.Get(0, 2).GetString();
+        l_Profile->Gender   = p_Result.Get(0, 3).GetString();
+        l_Profile->Motto    = p_Result.Get(0, 4).GetString();
+        l_Profile->Credits  = p_Result.Get(0, 5).GetUInt32();
+        l_Profile->Rank     = p_Result.Get(0, 6).GetUInt32();
+
+        return l_Profile;
+    }
+    /// Load profile on the calling thread, user cache misses outside of a login
+    /// @p_UserId : Id of user
+    std::shared_ptr<UserProfile> LoginPipeline::LoadProfile(uint32 const& p_UserId)
+    {
+        Core::Database::PreparedStatement* l_Statement = GameDatabase.GetPrepareStatement(GAME_SEL_USER_PROFILE);
+        if (!l_Statement)
+            return nullptr;
+
+        l_Statement->SetUint32(0, p_UserId);
+
+        std::vector<UserProfile> l_Rows;
+        if (!GameDatabase.Query(l_Statement, l_Rows) || l_Rows.empty())
+            return nullptr;
+
+        return std::make_shared<UserProfile>(std::move(l_Rows.front()));
+    }
+
+}   ///< namespace Session
+}   ///< namespace Game
+}   ///< namespace Steerstone
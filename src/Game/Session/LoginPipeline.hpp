@@ -0,0 +1,150 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+#include "Singleton/Singleton.hpp"
+#include "Threading/ThrStrand.hpp"
+#include "Database/CompletionQueue.hpp"
+#include "Database/PersistentCache.hpp"
+#include "Database/BatchWriter.hpp"
+#include "UserSession.hpp"
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <string>
+
+#define LOGIN_MAX_IN_FLIGHT             64                  ///< Default logins waiting on the database at once
+#define LOGIN_MAX_QUEUED                4096                ///< Default logins waiting for a free spot, later ones are refused
+#define LOGIN_TICKET_MAX_LENGTH         128                 ///< Longest SSO ticket accepted
+#define USER_CACHE_CAPACITY             20000               ///< Default profiles kept in the user cache
+#define USER_CACHE_FLUSH_INTERVAL       30000               ///< Default MS between two writes of modified profiles
+
+namespace SteerStone { namespace Game {
+
+    namespace Server { class GameSocket; }
+
+namespace Session {
+
+    /// Moves sockets from NotAuthenticated to Authenticed with an SSO ticket
+    /// A login never runs on a network thread: the ticket is looked up asynchronously, the profile is read from
+    /// the primary and kept in the write behind user cache, the result is posted back to the socket. Callbacks
+    /// run on the strand of the pipeline, only a bounded amount of logins wait on the database at once so a login
+    /// storm queues up here instead of filling the database queues other users need
+    class LoginPipeline
+    {
+        SINGLETON_P_D(LoginPipeline);
+
+        public:
+            /// Write behind cache of profiles by user id
+            using UserCache = Core::Database::PersistentCache<uint32, UserProfile>;
+
+        private:
+            /// Login waiting or in flight
+            struct LoginRequest
+            {
+                std::shared_ptr<Server::GameSocket> Socket;         ///< Socket logging in
+                std::string Ticket;                                 ///< SSO ticket
+                uint32 UserId;                                      ///< Id of user, set once the ticket is found
+            };
+
+        public:
+            /// Create caches and read settings, called once the game database is up
+            void Initialize();
+            /// Write modified profiles and drop caches, called before the game database stops
+            void Shutdown();
+
+            /// Log socket in, safe from any thread, the socket is told the result on its network thread
+            /// @p_Socket : Socket
+            /// @p_Ticket : SSO ticket
+            void Login(std::shared_ptr<Server::GameSocket> const& p_Socket, std::string p_Ticket);
+
+            /// Get write behind cache of profiles, nullptr before Initialize
+            UserCache* GetUserCache() { return m_Users.get(); }
+            /// Get amount of logins waiting on the database
+            uint32 GetInFlightCount() const { return m_InFlightCount.load(std::memory_order_relaxed); }
+            /// Get amount of logins waiting for a free spot
+            uint32 GetQueuedCount() const { return m_QueuedCount.load(std::memory_order_relaxed); }
+            /// Get amount of successful logins
+            uint64 GetSuccessCount() const { return m_SuccessCount.load(std::memory_order_relaxed); }
+            /// Get amount of failed logins
+            uint64 GetFailureCount() const { return m_FailureCount.load(std::memory_order_relaxed); }
+
+        private:
+            /// Admit login or queue it, strand only
+            /// @p_Request : Login
+            void Admit(LoginRequest&& p_Request);
+            /// Look up ticket, strand only
+            /// @p_Request : Login
+            void Start(std::shared_ptr<LoginRequest> const& p_Request);
+            /// Ticket looked up, consume it, strand only
+            /// @p_Request : Login
+            /// @p_Result  : Id of user owning the ticket, nullptr or empty if none
+            void OnTicket(std::shared_ptr<LoginRequest> const& p_Request, std::unique_ptr<Core::Database::PreparedResultSet> p_Result);
+            /// Ticket consumed, get profile, strand only
+            /// @p_Request : Login
+            /// @p_Result  : Result of the update, nullptr if it was rejected or failed
+            void OnTicketCleared(std::shared_ptr<LoginRequest> const& p_Request, std::unique_ptr<Core::Database::PreparedResultSet> p_Result);
+            /// Profile fetched, cache it and log in, strand only
+            /// @p_Request : Login
+            /// @p_Result  : Profile row, nullptr or empty if none
+            void OnProfile(std::shared_ptr<LoginRequest> const& p_Request, std::unique_ptr<Core::Database::PreparedResultSet> p_Result);
+            /// Register session and hand it to the socket, strand only
+            /// @p_Request : Login
+            /// @p_Profile : Profile of user
+            void Complete(std::shared_ptr<LoginRequest> const& p_Request, std::shared_ptr<UserProfile> const& p_Profile);
+            /// Tell the socket login failed, strand only
+            /// @p_Request : Login
+            /// @p_Reason  : Reason logged
+            void Fail(std::shared_ptr<LoginRequest> const& p_Request, char const* p_Reason);
+            /// Free spot of a finished login and start the next queued one, strand only
+            void Release();
+
+            /// Read profile from a profile row
+            /// @p_Result : Result of GAME_SEL_USER_PROFILE
+            static std::shared_ptr<UserProfile> ReadProfile(Core::Database::PreparedResultSet const& p_Result);
+            /// Load profile on the calling thread, user cache misses outside of a login
+            /// @p_UserId : Id of user
+            static std::shared_ptr<UserProfile> LoadProfile(uint32 const& p_UserId);
+
+        private:
+            Core::Threading::Strand::Ptr m_Strand;                              ///< Strand callbacks run on
+            std::unique_ptr<Core::Database::CompletionQueue> m_Queue;           ///< Database results, processed on our strand
+            std::unique_ptr<Core::Database::BatchWriter> m_LookWriter;          ///< Writes USER_FIELD_LOOK
+            std::unique_ptr<Core::Database::BatchWriter> m_CreditsWriter;       ///< Writes USER_FIELD_CREDITS
+            std::unique_ptr<UserCache> m_Users;                                 ///< Profiles of users, written behind
+
+            std::deque<LoginRequest> m_Waiting;                                 ///< Logins waiting for a free spot, strand only
+            uint32 m_MaxInFlight;                                               ///< Logins waiting on the database at once
+            uint32 m_MaxQueued;                                                 ///< Logins waiting for a free spot
+
+            std::atomic<uint32> m_InFlightCount;                                ///< Logins waiting on the database
+            std::atomic<uint32> m_QueuedCount;                                  ///< Logins waiting for a free spot
+            std::atomic<uint64> m_SuccessCount;                                 ///< Successful logins
+            std::atomic<uint64> m_FailureCount;                                 ///< Failed logins
+    };
+
+}   ///< namespace Session
+}   ///< namespace Game
+}   ///< namespace Steerstone
+
+#define sLoginPipeline SteerStone::Game::Session::LoginPipeline::GetSingleton()
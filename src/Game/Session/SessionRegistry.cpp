@@ -0,0 +1,175 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "SessionRegistry.hpp"
+
+#include <mutex>
+
+namespace SteerStone { namespace Game { namespace Session {
+
+    SINGLETON_P_I(SessionRegistry);
+
+    static_assert((SESSION_REGISTRY_SHARDS & (SESSION_REGISTRY_SHARDS - 1)) == 0, "SESSION_REGISTRY_SHARDS must be a power of 2");
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    SessionRegistry::SessionRegistry()
+        : m_Count(0)
+    {
+    }
+    /// Deconstructor
+    SessionRegistry::~SessionRegistry()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Register session, replacing the one of a user logging in again
+    /// @p_Session : Session
+    /// Returns the replaced session, its socket must be closed, nullptr if user was not online
+    std::shared_ptr<UserSession> SessionRegistry::Register(std::shared_ptr<UserSession> const& p_Session)
+    {
+        std::shared_ptr<UserSession> l_Replaced;
+
+        {
+            Shard& l_Shard = GetShard(m_ById, p_Session->GetUserId());
+            std::unique_lock<std::shared_mutex> l_Lock(l_Shard.Mutex);
+
+            std::shared_ptr<UserSession>& l_Slot = l_Shard.Sessions[p_Session->GetUserId()];
+            l_Replaced = std::move(l_Slot);
+            l_Slot = p_Session;
+        }
+
+        /// Name of the replaced session is overwritten below unless the user was renamed in between
+        if (l_Replaced && l_Replaced->GetName() != p_Session->GetName())
+        {
+            Shard& l_Shard = GetShard(m_ByName, l_Replaced->GetName().GetId());
+            std::unique_lock<std::shared_mutex> l_Lock(l_Shard.Mutex);
+
+            auto l_Itr = l_Shard.Sessions.find(l_Replaced->GetName().GetId());
+            if (l_Itr != l_Shard.Sessions.end() && l_Itr->second == l_Replaced)
+                l_Shard.Sessions.erase(l_Itr);
+        }
+
+        {
+            Shard& l_Shard = GetShard(m_ByName, p_Session->GetName().GetId());
+            std::unique_lock<std::shared_mutex> l_Lock(l_Shard.Mutex);
+            l_Shard.Sessions[p_Session->GetName().GetId()] = p_Session;
+        }
+
+        if (!l_Replaced)
+            m_Count.fetch_add(1, std::memory_order_relaxed);
+
+        return l_Replaced;
+    }
+    /// Unregister session, a session which has been replaced in the meantime is left alone
+    /// @p_Session : Session
+    void SessionRegistry::Unregister(UserSession const* p_Session)
+    {
+        {
+            Shard& l_Shard = GetShard(m_ById, p_Session->GetUserId());
+            std::unique_lock<std::shared_mutex> l_Lock(l_Shard.Mutex);
+
+            auto l_Itr = l_Shard.Sessions.find(p_Session->GetUserId());
+            if (l_Itr == l_Shard.Sessions.end() || l_Itr->second.get() != p_Session)
+                return;
+
+            l_Shard.Sessions.erase(l_Itr);
+        }
+
+        {
+            Shard& l_Shard = GetShard(m_ByName, p_Session->GetName().GetId());
+            std::unique_lock<std::shared_mutex> l_Lock(l_Shard.Mutex);
+
+            auto l_Itr = l_Shard.Sessions.find(p_Session->GetName().GetId());
+            if (l_Itr != l_Shard.Sessions.end() && l_Itr->second.get() == p_Session)
+                l_Shard.Sessions.erase(l_Itr);
+        }
+
+        m_Count.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get session of user, nullptr if offline
+    /// @p_UserId : Id of user
+    std::shared_ptr<UserSession> SessionRegistry::FindById(uint32 p_UserId) const
+    {
+        Shard const& l_Shard = GetShard(m_ById, p_UserId);
+        std::shared_lock<std::shared_mutex> l_Lock(l_Shard.Mutex);
+
+        auto l_Itr = l_Shard.Sessions.find(p_UserId);
+        return l_Itr != l_Shard.Sessions.end() ? l_Itr->second : nullptr;
+    }
+    /// Get session of user by name regardless of case, nullptr if offline
+    /// @p_Name : Name of user
+    std::shared_ptr<UserSession> SessionRegistry::FindByName(std::string_view p_Name) const
+    {
+        /// A name which has never been interned can not be online, unknown names are not interned by lookups
+        const Core::Utils::Symbol l_Name = Core::Utils::SymbolTable::GetNames()->Find(p_Name);
+        if (!l_Name.IsValid())
+            return nullptr;
+
+        Shard const& l_Shard = GetShard(m_ByName, l_Name.GetId());
+        std::shared_lock<std::shared_mutex> l_Lock(l_Shard.Mutex);
+
+        auto l_Itr = l_Shard.Sessions.find(l_Name.GetId());
+        return l_Itr != l_Shard.Sessions.end() ? l_Itr->second : nullptr;
+    }
+    /// Check user is online
+    /// @p_UserId : Id of user
+    bool SessionRegistry::IsOnline(uint32 p_UserId) const
+    {
+        Shard const& l_Shard = GetShard(m_ById, p_UserId);
+        std::shared_lock<std::shared_mutex> l_Lock(l_Shard.Mutex);
+
+        return l_Shard.Sessions.count(p_UserId) != 0;
+    }
+    /// Get amount of online users
+    uint32 SessionRegistry::GetCount() const
+    {
+        return m_Count.load(std::memory_order_relaxed);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get shard of index
+    /// @p_Shards : Index
+    /// @p_Key    : User id or name symbol
+    SessionRegistry::Shard& SessionRegistry::GetShard(Shard (&p_Shards)[SESSION_REGISTRY_SHARDS], uint32 p_Key)
+    {
+        /// Ids and symbols are handed out sequentially, mixing spreads neighbours over every shard
+        return p_Shards[(static_cast<uint32>(p_Key * 2654435761u) >> 16) & (SESSION_REGISTRY_SHARDS - 1)];
+    }
+    /// Get shard of index
+    /// @p_Shards : Index
+    /// @p_Key    : User id or name symbol
+    SessionRegistry::Shard const& SessionRegistry::GetShard(Shard const (&p_Shards)[SESSION_REGISTRY_SHARDS], uint32 p_Key)
+    {
+        return p_Shards[(static_cast<uint32>(p_Key * 2654435761u) >> 16) & (SESSION_REGISTRY_SHARDS - 1)];
+    }
+
+}   ///< namespace Session
+}   ///< namespace Game
+}   ///< namespace Steerstone
@@ -0,0 +1,93 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+#include "Singleton/Singleton.hpp"
+#include "UserSession.hpp"
+
+#include <atomic>
+#include <memory>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+
+#define SESSION_REGISTRY_SHARDS     32      ///< Shards of each index, a power of 2, each has its own lock
+
+namespace SteerStone { namespace Game { namespace Session {
+
+    /// Logged in users by id and by name, looked up from every thread (whispers, messenger, moderation)
+    /// Both indexes are lock striped, a lookup takes the shared lock of a single shard and never waits on logins
+    /// of users hashing to other shards. Names are interned in the case insensitive name table so a name shard
+    /// is keyed by symbol and comparing names is an integer compare
+    class SessionRegistry
+    {
+        SINGLETON_P_D(SessionRegistry);
+
+        /// Part of an index
+        struct Shard
+        {
+            mutable std::shared_mutex Mutex;                                    ///< Guards sessions
+            std::unordered_map<uint32, std::shared_ptr<UserSession>> Sessions;  ///< Sessions by user id or name symbol
+        };
+
+        public:
+            /// Register session, replacing the one of a user logging in again
+            /// @p_Session : Session
+            /// Returns the replaced session, its socket must be closed, nullptr if user was not online
+            std::shared_ptr<UserSession> Register(std::shared_ptr<UserSession> const& p_Session);
+            /// Unregister session, a session which has been replaced in the meantime is left alone
+            /// @p_Session : Session
+            void Unregister(UserSession const* p_Session);
+
+            /// Get session of user, nullptr if offline
+            /// @p_UserId : Id of user
+            std::shared_ptr<UserSession> FindById(uint32 p_UserId) const;
+            /// Get session of user by name regardless of case, nullptr if offline
+            /// @p_Name : Name of user
+            std::shared_ptr<UserSession> FindByName(std::string_view p_Name) const;
+            /// Check user is online
+            /// @p_UserId : Id of user
+            bool IsOnline(uint32 p_UserId) const;
+            /// Get amount of online users
+            uint32 GetCount() const;
+
+        private:
+            /// Get shard of index
+            /// @p_Shards : Index
+            /// @p_Key    : User id or name symbol
+            static Shard& GetShard(Shard (&p_Shards)[SESSION_REGISTRY_SHARDS], uint32 p_Key);
+            /// Get shard of index
+            /// @p_Shards : Index
+            /// @p_Key    : User id or name symbol
+            static Shard const& GetShard(Shard const (&p_Shards)[SESSION_REGISTRY_SHARDS], uint32 p_Key);
+
+        private:
+            Shard m_ById[SESSION_REGISTRY_SHARDS];                  ///< Sessions by user id
+            Shard m_ByName[SESSION_REGISTRY_SHARDS];                ///< Sessions by name symbol
+            std::atomic<uint32> m_Count;                            ///< Online users
+    };
+
+}   ///< namespace Session
+}   ///< namespace Game
+}   ///< namespace Steerstone
+
+#define sSessionRegistry SteerStone::Game::Session::SessionRegistry::GetSingleton()
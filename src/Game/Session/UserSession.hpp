@@ -0,0 +1,94 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+#include "Database/RowMapper.hpp"
+#include "Utility/UtiSymbolTable.hpp"
+
+#include <memory>
+#include <string>
+
+namespace SteerStone { namespace Game {
+
+    namespace Server { class GameSocket; }
+
+namespace Session {
+
+    /// Field groups of a user, each written by its own batch writer
+    enum UserFieldGroup : uint32
+    {
+        USER_FIELD_LOOK,            ///< Figure, gender and motto
+        USER_FIELD_CREDITS          ///< Credits
+    };
+
+    /// Profile of a user, owned by the user cache and written behind
+    struct UserProfile
+    {
+        uint32 Id;                  ///< Id of user
+        std::string Name;           ///< Name
+        std::string Figure;         ///< Figure
+        std::string Gender;         ///< Gender, M or F
+        std::string Motto;          ///< Motto
+        uint32 Credits;             ///< Credits
+        uint32 Rank;                ///< Rank
+
+        DATABASE_ROW_FIELDS(&UserProfile::Id, &UserProfile::Name, &UserProfile::Figure, &UserProfile::Gender, &UserProfile::Motto, &UserProfile::Credits, &UserProfile::Rank)
+    };
+
+    /// Logged in user, shared between the registry and the socket of the user
+    class UserSession
+    {
+        DISALLOW_COPY_AND_ASSIGN(UserSession);
+
+        public:
+            /// Constructor
+            /// @p_Profile : Profile of user
+            /// @p_Socket  : Socket user logged in on
+            UserSession(std::shared_ptr<UserProfile> const& p_Profile, std::shared_ptr<Server::GameSocket> const& p_Socket)
+                : m_UserId(p_Profile->Id), m_Name(Core::Utils::SymbolTable::GetNames()->Intern(p_Profile->Name)), m_Profile(p_Profile), m_Socket(p_Socket)
+            {
+            }
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Get id of user
+            uint32 GetUserId() const { return m_UserId; }
+            /// Get interned name of user, from the case insensitive name table
+            Core::Utils::Symbol GetName() const { return m_Name; }
+            /// Get name of user
+            std::string_view GetNameString() const { return Core::Utils::SymbolTable::GetNames()->GetString(m_Name); }
+            /// Get profile of user, modify it through the user cache
+            std::shared_ptr<UserProfile> const& GetProfile() const { return m_Profile; }
+            /// Get socket of user, nullptr once it is gone
+            std::shared_ptr<Server::GameSocket> GetSocket() const { return m_Socket.lock(); }
+
+        private:
+            uint32 m_UserId;                                ///< Id of user
+            Core::Utils::Symbol m_Name;                     ///< Interned name
+            std::shared_ptr<UserProfile> m_Profile;         ///< Profile
+            std::weak_ptr<Server::GameSocket> m_Socket;     ///< Socket user logged in on
+    };
+
+}   ///< namespace Session
+}   ///< namespace Game
+}   ///< namespace Steerstone
@@ -0,0 +1,245 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "WorldUpdater.hpp"
+#include "Threading/ThrTaskManager.hpp"
+#include "Threading/ThrThisThread.hpp"
+#include "Diagnostic/DiaServerWatch.hpp"
+#include "Logger/Base.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace SteerStone { namespace Game { namespace World {
+
+    /// Constructor
+    /// @p_TickRate        : MS between two ticks
+    /// @p_MaxCatchUpTicks : Amount of late ticks run back to back before the rest are dropped
+    /// @p_TickBudget      : MS a tick may take before it counts as an overrun
+    WorldUpdater::WorldUpdater(uint32 p_TickRate, uint32 p_MaxCatchUpTicks, uint32 p_TickBudget)
+        : m_TickRate(std::max<uint32>(p_TickRate, 1)), m_MaxCatchUpTicks(std::max<uint32>(p_MaxCatchUpTicks, 1)), m_TickBudget(std::max<uint32>(p_TickBudget, 1)), m_Running(false),
+        m_TickCount(0), m_CatchUpTicks(0), m_DroppedTicks(0), m_OverrunCount(0), m_LoggedOverruns(0), m_LastOverrunLog(0), m_BudgetUsage(0.0f), m_LastUpdateCount(0), m_SlowestTime(0)
+    {
+    }
+    /// Deconstructor
+    WorldUpdater::~WorldUpdater()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Register updatable, safe from any thread
+    /// @p_Name      : Name reported in overrun telemetry
+    /// @p_Updatable : Updatable, kept alive while registered
+    /// @p_Interval  : MS between two updates, rounded up to whole ticks
+    WorldUpdater::Handle WorldUpdater::Register(std::string const& p_Name, std::shared_ptr<Updatable> const& p_Updatable, uint32 p_Interval)
+    {
+        Handle l_Entry = std::make_shared<Entry>();
+        l_Entry->Name       = p_Name;
+        l_Entry->Object     = p_Updatable;
+        l_Entry->Elapsed    = 0;
+        l_Entry->UpdateTime = 0;
+        l_Entry->Active     = true;
+
+        /// Ticks are fixed steps, an interval between two of them would drift
+        l_Entry->Timer.SetInterval(std::max<uint32>(1, (p_Interval + m_TickRate - 1) / m_TickRate) * m_TickRate);
+
+        std::lock_guard<std::mutex> l_Lock(m_Mutex);
+        m_Entries.push_back(l_Entry);
+
+        return l_Entry;
+    }
+    /// Unregister updatable, safe from any thread, an update in flight still finishes
+    /// @p_Handle : Handle returned by Register
+    void WorldUpdater::Unregister(Handle const& p_Handle)
+    {
+        /// Entry is dropped by the next tick, a batch in flight may still point to it
+        if (p_Handle)
+            p_Handle->Active = false;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Run ticks on the calling thread until Stop is called
+    void WorldUpdater::Run()
+    {
+        LOG_INFO("WorldUpdater", "World ticks every %0 ms, budget %1 ms, catching up at most %2 ticks", m_TickRate, m_TickBudget, m_MaxCatchUpTicks);
+
+        m_Running = true;
+
+        uint32 l_Accumulator = 0;
+        sServerTimeManager->Tick();
+
+        while (m_Running)
+        {
+            l_Accumulator += sServerTimeManager->Tick();
+
+            uint32 l_Ticks = 0;
+            for (; l_Accumulator >= m_TickRate && l_Ticks < m_MaxCatchUpTicks && m_Running; ++l_Ticks)
+            {
+                Tick(m_TickRate);
+                l_Accumulator -= m_TickRate;
+            }
+
+            /// Running every missed tick back to back would only make us later, the world slows down instead
+            const uint32 l_Dropped = l_Accumulator / m_TickRate;
+            l_Accumulator %= m_TickRate;
+
+            if (l_Ticks > 1 || l_Dropped)
+            {
+                std::lock_guard<std::mutex> l_Lock(m_Mutex);
+                m_CatchUpTicks += l_Ticks > 1 ? l_Ticks - 1 : 0;
+                m_DroppedTicks += l_Dropped;
+            }
+
+            if (l_Dropped)
+                LOG_WARNING("WorldUpdater", "World is %0 ticks behind, dropped them", l_Dropped);
+
+            /// Sleep until next tick is due
+            const uint32 l_Spent = sServerTimeManager->GetTimeDifference(sServerTimeManager->TickTime(), sServerTimeManager->GetServerTime());
+
+            if (l_Accumulator + l_Spent < m_TickRate)
+                Core::Threading::ThisThread::SleepFor(m_TickRate - l_Accumulator - l_Spent);
+        }
+    }
+    /// Make Run return after its current tick, safe from any thread
+    void WorldUpdater::Stop()
+    {
+        m_Running = false;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get MS between two ticks
+    uint32 WorldUpdater::GetTickRate() const
+    {
+        return m_TickRate;
+    }
+    /// Get telemetry
+    WorldUpdaterStats WorldUpdater::GetStats()
+    {
+        std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+        WorldUpdaterStats l_Stats;
+        l_Stats.TickCount       = m_TickCount;
+        l_Stats.CatchUpTicks    = m_CatchUpTicks;
+        l_Stats.DroppedTicks    = m_DroppedTicks;
+        l_Stats.OverrunCount    = m_OverrunCount;
+        l_Stats.TickP99         = m_TickHistogram.GetP99();
+        l_Stats.TickMax         = m_TickHistogram.GetMax();
+        l_Stats.BudgetUsage     = m_BudgetUsage;
+        l_Stats.UpdatableCount  = m_Entries.size();
+        l_Stats.LastUpdateCount = m_LastUpdateCount;
+        l_Stats.SlowestName     = m_SlowestName;
+        l_Stats.SlowestTime     = m_SlowestTime;
+
+        return l_Stats;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Run one tick
+    /// @p_Diff : Tick length in MS
+    void WorldUpdater::Tick(uint32 p_Diff)
+    {
+        const auto l_Start = std::chrono::steady_clock::now();
+
+        m_Due.clear();
+
+        {
+            std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+            /// Only we remove entries, raw pointers to them stay valid until our next tick
+            m_Entries.erase(std::remove_if(m_Entries.begin(), m_Entries.end(), [](Handle const& p_Entry) -> bool {
+                return !p_Entry->Active;
+            }), m_Entries.end());
+
+            for (auto const& l_Entry : m_Entries)
+            {
+                l_Entry->Elapsed += p_Diff;
+                l_Entry->Timer.Update(p_Diff);
+
+                if (l_Entry->Timer.Passed())
+                    m_Due.push_back(l_Entry.get());
+            }
+        }
+
+        /// Chunks go to the task workers, we update chunks ourself while they run
+        sThreadManager->ParallelFor(0, m_Due.size(), WORLD_UPDATE_BATCH_SIZE, [this](std::size_t p_I) {
+            UpdateEntry(m_Due[p_I]);
+        });
+
+        const auto   l_Duration = std::chrono::steady_clock::now() - l_Start;
+        const uint64 l_Micro    = std::chrono::duration_cast<std::chrono::microseconds>(l_Duration).count();
+
+        m_TickHistogram.Record(l_Duration);
+
+        std::lock_guard<std::mutex> l_Lock(m_Mutex);
+
+        ++m_TickCount;
+        m_LastUpdateCount = m_Due.size();
+        m_BudgetUsage += (static_cast<float>(l_Micro) / (m_TickBudget * 1000.0f) - m_BudgetUsage) / 8.0f;
+
+        if (l_Micro <= m_TickBudget * 1000ull)
+            return;
+
+        ++m_OverrunCount;
+
+        auto l_Slowest = std::max_element(m_Due.begin(), m_Due.end(), [](Entry* p_Left, Entry* p_Right) -> bool {
+            return p_Left->UpdateTime < p_Right->UpdateTime;
+        });
+
+        m_SlowestName = l_Slowest != m_Due.end() ? (*l_Slowest)->Name : std::string();
+        m_SlowestTime = l_Slowest != m_Due.end() ? (*l_Slowest)->UpdateTime : 0;
+
+        const uint32 l_Now = sServerTimeManager->GetServerTime();
+        if (m_LoggedOverruns && sServerTimeManager->GetTimeDifference(m_LastOverrunLog, l_Now) < WORLD_OVERRUN_LOG_INTERVAL)
+            return;
+
+        LOG_WARNING("WorldUpdater", "Tick took %0 us over a budget of %1 ms (%2 overruns since last report), slowest %3 took %4 us",
+            l_Micro, m_TickBudget, m_OverrunCount - m_LoggedOverruns, m_SlowestName, m_SlowestTime);
+
+        m_LoggedOverruns = m_OverrunCount;
+        m_LastOverrunLog = l_Now;
+    }
+    /// Update a due updatable
+    /// @p_Entry : Entry
+    void WorldUpdater::UpdateEntry(Entry* p_Entry)
+    {
+        if (!p_Entry->Active)
+            return;
+
+        const auto   l_Start = std::chrono::steady_clock::now();
+        const uint32 l_Diff  = p_Entry->Elapsed;
+
+        p_Entry->Elapsed = 0;
+
+        if (!p_Entry->Object->Update(l_Diff))
+            p_Entry->Active = false;
+
+        p_Entry->UpdateTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - l_Start).count();
+    }
+
+}   ///< namespace World
+}   ///< namespace Game
+}   ///< namespace Steerstone
@@ -0,0 +1,157 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+
+#include "Core/Core.hpp"
+#include "Diagnostic/DiaIntervalTimer.hpp"
+#include "Diagnostic/DiaHistogram.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define WORLD_TICK_RATE             50      ///< Default MS between two world ticks
+#define WORLD_MAX_CATCH_UP_TICKS    5       ///< Default amount of late ticks run back to back before the rest are dropped
+#define WORLD_TICK_BUDGET           40      ///< Default MS a tick may take before it counts as an overrun
+#define WORLD_UPDATE_BATCH_SIZE     16      ///< Updatables per chunk of the parallel update
+#define WORLD_OVERRUN_LOG_INTERVAL  10000   ///< Minimum MS between two overrun warnings
+
+namespace SteerStone { namespace Game { namespace World {
+
+    /// Part of the world updated at a fixed interval (room walk steps, heartbeats...)
+    class Updatable
+    {
+        public:
+            /// Destructor
+            virtual ~Updatable() {}
+
+            /// Update, called from a task worker, never at the same time for the same updatable
+            /// @p_Diff : Time since last update in MS, a whole number of ticks
+            /// Returns false to be unregistered
+            virtual bool Update(uint32 const p_Diff) = 0;
+    };
+
+    /// Snapshot of world updater telemetry
+    struct WorldUpdaterStats
+    {
+        uint64      TickCount;          ///< Ticks run
+        uint64      CatchUpTicks;       ///< Late ticks run back to back
+        uint64      DroppedTicks;       ///< Late ticks dropped past the catch up limit
+        uint64      OverrunCount;       ///< Ticks which took longer than the budget
+        uint64      TickP99;            ///< 99th percentile of tick duration in nanoseconds
+        uint64      TickMax;            ///< Longest tick in nanoseconds
+        float       BudgetUsage;        ///< Decayed share of the budget used by a tick
+        std::size_t UpdatableCount;     ///< Registered updatables
+        std::size_t LastUpdateCount;    ///< Updatables updated on last tick
+        std::string SlowestName;        ///< Slowest updatable of last overrun
+        uint64      SlowestTime;        ///< Update time of slowest updatable of last overrun in microseconds
+    };
+
+    /// Runs the hotel at a fixed tick rate on the thread calling Run
+    /// Due updatables of a tick are fanned out in batches to the task workers, the tick waits for all of them
+    class WorldUpdater
+    {
+        DISALLOW_COPY_AND_ASSIGN(WorldUpdater);
+
+        struct Entry;
+
+        public:
+            /// Handle of a registered updatable
+            using Handle = std::shared_ptr<Entry>;
+
+        public:
+            /// Constructor
+            /// @p_TickRate        : MS between two ticks
+            /// @p_MaxCatchUpTicks : Amount of late ticks run back to back before the rest are dropped
+            /// @p_TickBudget      : MS a tick may take before it counts as an overrun
+            WorldUpdater(uint32 p_TickRate = WORLD_TICK_RATE, uint32 p_MaxCatchUpTicks = WORLD_MAX_CATCH_UP_TICKS, uint32 p_TickBudget = WORLD_TICK_BUDGET);
+            /// Deconstructor
+            ~WorldUpdater();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Register updatable, safe from any thread
+            /// @p_Name      : Name reported in overrun telemetry
+            /// @p_Updatable : Updatable, kept alive while registered
+            /// @p_Interval  : MS between two updates, rounded up to whole ticks
+            Handle Register(std::string const& p_Name, std::shared_ptr<Updatable> const& p_Updatable, uint32 p_Interval);
+            /// Unregister updatable, safe from any thread, an update in flight still finishes
+            /// @p_Handle : Handle returned by Register
+            void Unregister(Handle const& p_Handle);
+
+            /// Run ticks on the calling thread until Stop is called
+            void Run();
+            /// Make Run return after its current tick, safe from any thread
+            void Stop();
+
+            /// Get MS between two ticks
+            uint32 GetTickRate() const;
+            /// Get telemetry
+            WorldUpdaterStats GetStats();
+
+        private:
+            /// Registered updatable
+            struct Entry
+            {
+                std::string                     Name;           ///< Name
+                std::shared_ptr<Updatable>      Object;         ///< Updatable
+                Core::Diagnostic::IntervalTimer Timer;          ///< Time until next update
+                uint32                          Elapsed;        ///< MS since last update
+                uint64                          UpdateTime;     ///< Duration of last update in microseconds
+                std::atomic<bool>               Active;         ///< Cleared once unregistered
+            };
+
+            /// Run one tick
+            /// @p_Diff : Tick length in MS
+            void Tick(uint32 p_Diff);
+            /// Update a due updatable
+            /// @p_Entry : Entry
+            static void UpdateEntry(Entry* p_Entry);
+
+        private:
+            std::mutex              m_Mutex;                ///< Guards entries and telemetry
+            std::vector<Handle>     m_Entries;              ///< Registered updatables
+            std::vector<Entry*>     m_Due;                  ///< Entries due on current tick, world thread only
+
+            uint32                  m_TickRate;             ///< MS between two ticks
+            uint32                  m_MaxCatchUpTicks;      ///< Late ticks run back to back before the rest are dropped
+            uint32                  m_TickBudget;           ///< MS a tick may take
+            std::atomic<bool>       m_Running;              ///< Run condition
+
+            uint64                  m_TickCount;            ///< Ticks run
+            uint64                  m_CatchUpTicks;         ///< Late ticks run back to back
+            uint64                  m_DroppedTicks;         ///< Late ticks dropped
+            uint64                  m_OverrunCount;         ///< Ticks over budget
+            uint64                  m_LoggedOverruns;       ///< Overruns already reported
+            uint32                  m_LastOverrunLog;       ///< Server time of last overrun warning
+            float                   m_BudgetUsage;          ///< Decayed share of the budget used
+            std::size_t             m_LastUpdateCount;      ///< Updatables updated on last tick
+            std::string             m_SlowestName;          ///< Slowest updatable of last overrun
+            uint64                  m_SlowestTime;          ///< Its update time in microseconds
+            Core::Diagnostic::LatencyHistogram m_TickHistogram;  ///< Tick durations
+    };
+
+}   ///< namespace World
+}   ///< namespace Game
+}   ///< namespace Steerstone
@@ -0,0 +1,99 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <Precompiled.hpp>
+
+#include "Benchmark.hpp"
+#include "Database/ResultSet.hpp"
+
+using namespace SteerStone::Core;
+using namespace SteerStone::Benchmarks;
+
+/// Row of a typical query, filled like a fetched statement fills its fields
+class RowFixture
+{
+    public:
+        /// Constructor
+        RowFixture()
+            : m_Id(4321), m_Credits(-150), m_Rating(4.5f), m_Name("SteerStone")
+        {
+            m_Fields[0].SetValue(&m_Id,        Database::FieldType::FIELD_UI32,     sizeof(m_Id));
+            m_Fields[1].SetValue(&m_Credits,   Database::FieldType::FIELD_I32,      sizeof(m_Credits));
+            m_Fields[2].SetValue(&m_Rating,    Database::FieldType::FIELD_FLOAT,    sizeof(m_Rating));
+            m_Fields[3].SetValue(&m_Name[0],   Database::FieldType::FIELD_BINARY,   static_cast<uint32>(m_Name.size()));
+        }
+
+        /// Get fields
+        Database::ResultSet const* GetFields() const
+        {
+            return m_Fields;
+        }
+
+    private:
+        uint32 m_Id;                            ///< Field 0 storage
+        int32 m_Credits;                        ///< Field 1 storage
+        float m_Rating;                         ///< Field 2 storage
+        std::string m_Name;                     ///< Field 3 storage
+        Database::ResultSet m_Fields[4];        ///< Fields of row
+};
+
+/// Read an unsigned integer field
+static void ResultSetGetUInt32(State& p_State)
+{
+    RowFixture l_Row;
+
+    while (p_State.KeepRunning())
+        DoNotOptimize(l_Row.GetFields()[0].GetUInt32());
+
+    p_State.SetItemsProcessed(p_State.GetIterations());
+}
+BENCHMARK("ResultSet/GetUInt32", ResultSetGetUInt32);
+
+/// Read a string field, a copy is made
+static void ResultSetGetString(State& p_State)
+{
+    RowFixture l_Row;
+
+    while (p_State.KeepRunning())
+    {
+        std::string l_Name = l_Row.GetFields()[3].GetString();
+        DoNotOptimize(l_Name);
+    }
+
+    p_State.SetItemsProcessed(p_State.GetIterations());
+}
+BENCHMARK("ResultSet/GetString", ResultSetGetString);
+
+/// Read every field of a row, as loaders do
+static void ResultSetReadRow(State& p_State)
+{
+    RowFixture l_Row;
+    Database::ResultSet const* l_Fields = l_Row.GetFields();
+
+    while (p_State.KeepRunning())
+    {
+        DoNotOptimize(l_Fields[0].GetUInt32());
+        DoNotOptimize(l_Fields[1].GetInt32());
+        DoNotOptimize(l_Fields[2].GetFloat());
+
+        std::string l_Name = l_Fields[3].GetString();
+        DoNotOptimize(l_Name);
+    }
+
+    p_State.SetItemsProcessed(p_State.GetIterations());
+}
+BENCHMARK("ResultSet/ReadRow", ResultSetReadRow);
@@ -0,0 +1,111 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <Precompiled.hpp>
+
+#include "Benchmark.hpp"
+#include "Encoding.hpp"
+
+using namespace SteerStone::Benchmarks;
+using namespace SteerStone::Game::Server;
+
+/// Values encoded by benchmarks, spread over every VL64 length
+static const int32 s_Values[] = { 0, 3, -3, 60, -60, 1000, -1000, 70000, -70000, 3000000, -300000000, 2147483647 };
+static const std::size_t s_ValueCount = sizeof(s_Values) / sizeof(s_Values[0]);
+
+/// Encode 2 byte B64 headers
+static void EncodingEncodeB64(State& p_State)
+{
+    uint8 l_Output[2];
+    uint32 l_Value = 0;
+
+    while (p_State.KeepRunning())
+    {
+        Encoding::EncodeB64(l_Value++ & 4095, l_Output, sizeof(l_Output));
+        DoNotOptimize(l_Output);
+    }
+
+    p_State.SetItemsProcessed(p_State.GetIterations());
+}
+BENCHMARK("Encoding/EncodeB64", EncodingEncodeB64);
+
+/// Decode 3 byte B64 lengths
+static void EncodingDecodeB64(State& p_State)
+{
+    uint8 l_Input[3];
+    Encoding::EncodeB64(123456, l_Input, sizeof(l_Input));
+
+    uint32 l_Value = 0;
+
+    while (p_State.KeepRunning())
+    {
+        DoNotOptimize(Encoding::DecodeB64(l_Input, sizeof(l_Input), l_Value));
+        DoNotOptimize(l_Value);
+    }
+
+    p_State.SetItemsProcessed(p_State.GetIterations());
+}
+BENCHMARK("Encoding/DecodeB64", EncodingDecodeB64);
+
+/// Encode a spread of VL64 integers
+static void EncodingEncodeVL64(State& p_State)
+{
+    uint8 l_Output[VL64_MAX_SIZE * s_ValueCount];
+
+    while (p_State.KeepRunning())
+    {
+        std::size_t l_Size = 0;
+
+        for (std::size_t l_I = 0; l_I < s_ValueCount; l_I++)
+            l_Size += Encoding::EncodeVL64(s_Values[l_I], l_Output + l_Size);
+
+        DoNotOptimize(l_Output);
+    }
+
+    p_State.SetItemsProcessed(p_State.GetIterations() * s_ValueCount);
+}
+BENCHMARK("Encoding/EncodeVL64", EncodingEncodeVL64);
+
+/// Decode a spread of VL64 integers
+static void EncodingDecodeVL64(State& p_State)
+{
+    uint8 l_Input[VL64_MAX_SIZE * s_ValueCount];
+    std::size_t l_Length = 0;
+
+    for (std::size_t l_I = 0; l_I < s_ValueCount; l_I++)
+        l_Length += Encoding::EncodeVL64(s_Values[l_I], l_Input + l_Length);
+
+    while (p_State.KeepRunning())
+    {
+        std::size_t l_Position = 0;
+        int32 l_Value = 0;
+
+        while (l_Position < l_Length)
+        {
+            const std::size_t l_Size = Encoding::DecodeVL64(l_Input + l_Position, l_Length - l_Position, l_Value);
+            if (l_Size == 0)
+                break;
+
+            l_Position += l_Size;
+            DoNotOptimize(l_Value);
+        }
+    }
+
+    p_State.SetBytesProcessed(p_State.GetIterations() * l_Length);
+    p_State.SetItemsProcessed(p_State.GetIterations() * s_ValueCount);
+}
+BENCHMARK("Encoding/DecodeVL64", EncodingDecodeVL64);
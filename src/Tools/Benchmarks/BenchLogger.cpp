@@ -0,0 +1,51 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <Precompiled.hpp>
+
+#include "Benchmark.hpp"
+#include "Logger/Base.hpp"
+
+using namespace SteerStone::Core;
+using namespace SteerStone::Benchmarks;
+
+/// Report a record the system filter rejects, the cost every disabled log line pays
+static void LoggerReportFiltered(State& p_State)
+{
+    LOG_SET_SYSTEM_LEVEL("Benchmark", Logger::LogType::Info);
+
+    while (p_State.KeepRunning())
+        LOG_WARNING("Benchmark", "Player %0 moved to %1 %2", "SteerStone", 12, 25);
+
+    p_State.SetItemsProcessed(p_State.GetIterations());
+}
+BENCHMARK("Logger/Report/Filtered", LoggerReportFiltered);
+
+/// Report a record which is formatted and queued, console is disabled so the terminal is not measured
+static void LoggerReportEnabled(State& p_State)
+{
+    LOG_SET_SYSTEM_LEVEL("Benchmark", Logger::LogType::Verbose);
+    LOG_ENABLE_CONSOLE(false);
+
+    while (p_State.KeepRunning())
+        LOG_INFO("Benchmark", "Player %0 moved to %1 %2", "SteerStone", 12, 25);
+
+    LOG_ENABLE_CONSOLE(true);
+
+    p_State.SetItemsProcessed(p_State.GetIterations());
+}
+BENCHMARK("Logger/Report/Enabled", LoggerReportEnabled);
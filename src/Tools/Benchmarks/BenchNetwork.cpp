@@ -0,0 +1,196 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <Precompiled.hpp>
+#include <atomic>
+#include <thread>
+
+#include "Benchmark.hpp"
+#include "Network/PacketBuffer.hpp"
+#include "Network/Socket.hpp"
+
+using namespace SteerStone::Core;
+using namespace SteerStone::Benchmarks;
+
+/// Socket which ignores what it recieves
+class BenchmarkSocket : public Network::Socket
+{
+    public:
+        /// Constructor
+        /// @p_Service : Service socket runs on
+        explicit BenchmarkSocket(boost::asio::io_service& p_Service)
+            : Network::Socket(p_Service, nullptr)
+        {
+        }
+
+    protected:
+        /// Discard incoming data
+        Network::ProcessState ProcessIncomingData() override
+        {
+            ReadSkip(ReadLengthRemaining());
+            return Network::ProcessState::Successful;
+        }
+};
+
+/// Connected socket whose peer drains everything on other threads
+class SocketFixture
+{
+    public:
+        /// Constructor
+        SocketFixture()
+            : m_Acceptor(m_Service, boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0)), m_Peer(m_Service)
+        {
+            m_Socket = std::make_shared<BenchmarkSocket>(m_Service);
+
+            m_Peer.connect(m_Acceptor.local_endpoint());
+            m_Acceptor.accept(m_Socket->GetAsioSocket());
+            m_Socket->Open();
+
+            m_IoThread = std::thread([this]() { m_Service.run(); });
+            m_DrainThread = std::thread([this]()
+            {
+                char l_Buffer[64 * 1024];
+                boost::system::error_code l_ErrorCode;
+
+                while (!l_ErrorCode)
+                    m_Peer.read_some(boost::asio::buffer(l_Buffer), l_ErrorCode);
+            });
+        }
+        /// Deconstructor
+        ~SocketFixture()
+        {
+            m_Socket->CloseSocket();
+            m_DrainThread.join();
+
+            m_Service.stop();
+            m_IoThread.join();
+        }
+
+        /// Get socket
+        BenchmarkSocket* GetSocket()
+        {
+            return m_Socket.get();
+        }
+        /// Wait until the kernel took everything queued
+        void WaitDrained()
+        {
+            while (m_Socket->GetOutQueueSize())
+                std::this_thread::yield();
+        }
+
+    private:
+        boost::asio::io_service m_Service;                  ///< Service socket runs on
+        boost::asio::ip::tcp::acceptor m_Acceptor;          ///< Loopback acceptor
+        boost::asio::ip::tcp::socket m_Peer;                ///< Other end of socket
+        std::shared_ptr<BenchmarkSocket> m_Socket;          ///< Socket written to
+        std::thread m_IoThread;                             ///< Runs service
+        std::thread m_DrainThread;                          ///< Reads peer
+};
+
+//////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+
+/// Write then read a message through a linear buffer
+static void PacketBufferWriteRead(State& p_State)
+{
+    const std::size_t l_Length = static_cast<std::size_t>(p_State.GetArgument());
+    std::vector<char> l_In(l_Length, 'x');
+    std::vector<char> l_Out(l_Length);
+
+    Network::PacketBuffer l_Buffer;
+
+    while (p_State.KeepRunning())
+    {
+        l_Buffer.Write(l_In.data(), l_Length);
+        l_Buffer.Read(l_Out.data(), l_Length);
+        DoNotOptimize(l_Out.data());
+    }
+
+    p_State.SetBytesProcessed(p_State.GetIterations() * l_Length);
+}
+BENCHMARK("PacketBuffer/WriteRead", PacketBufferWriteRead, 16, 256, 4096);
+
+/// Fill a buffer with messages before reading them back, storage grows on first runs
+static void PacketBufferBurst(State& p_State)
+{
+    const std::size_t l_Length = static_cast<std::size_t>(p_State.GetArgument());
+    std::vector<char> l_In(l_Length, 'x');
+    std::vector<char> l_Out(l_Length);
+
+    Network::PacketBuffer l_Buffer;
+
+    while (p_State.KeepRunning())
+    {
+        for (uint32 l_I = 0; l_I < 64; l_I++)
+            l_Buffer.Write(l_In.data(), l_Length);
+        for (uint32 l_I = 0; l_I < 64; l_I++)
+            l_Buffer.Read(l_Out.data(), l_Length);
+
+        DoNotOptimize(l_Out.data());
+    }
+
+    p_State.SetBytesProcessed(p_State.GetIterations() * l_Length * 64);
+}
+BENCHMARK("PacketBuffer/Burst64", PacketBufferBurst, 16, 256);
+
+/// Copy messages into the out queue of a connected socket, the last iteration waits until everything is sent
+static void SocketWrite(State& p_State)
+{
+    const std::size_t l_Length = static_cast<std::size_t>(p_State.GetArgument());
+    std::vector<char> l_Message(l_Length, 'x');
+
+    SocketFixture l_Fixture;
+    uint64 l_Written = 0;
+
+    while (p_State.KeepRunning())
+    {
+        l_Fixture.GetSocket()->Write(l_Message.data(), l_Length, Network::WritePriority::Essential);
+
+        if (++l_Written == p_State.GetIterations())
+            l_Fixture.WaitDrained();
+    }
+
+    p_State.SetBytesProcessed(p_State.GetIterations() * l_Length);
+    p_State.SetItemsProcessed(p_State.GetIterations());
+}
+BENCHMARK("Socket/Write", SocketWrite, 64, 1024);
+
+/// Queue a chunk shared by every iteration, as broadcasts do, the last iteration waits until everything is sent
+static void SocketWriteShared(State& p_State)
+{
+    const std::size_t l_Length = static_cast<std::size_t>(p_State.GetArgument());
+    std::vector<char> l_Message(l_Length, 'x');
+
+    auto l_Chunk = std::make_shared<Network::PacketBuffer>(static_cast<uint32>(l_Length));
+    l_Chunk->Write(l_Message.data(), l_Length);
+    const std::shared_ptr<Network::PacketBuffer const> l_Shared = l_Chunk;
+
+    SocketFixture l_Fixture;
+    uint64 l_Written = 0;
+
+    while (p_State.KeepRunning())
+    {
+        l_Fixture.GetSocket()->Write(l_Shared, Network::WritePriority::Essential);
+
+        if (++l_Written == p_State.GetIterations())
+            l_Fixture.WaitDrained();
+    }
+
+    p_State.SetBytesProcessed(p_State.GetIterations() * l_Length);
+    p_State.SetItemsProcessed(p_State.GetIterations());
+}
+BENCHMARK("Socket/WriteShared", SocketWriteShared, 64, 1024);
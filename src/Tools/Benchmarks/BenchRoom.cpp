@@ -0,0 +1,127 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <string>
+#include <vector>
+
+#include "Benchmark.hpp"
+#include "Map/RoomModel.hpp"
+#include "Map/RoomGrid.hpp"
+#include "Map/Pathfinder.hpp"
+#include "Map/RoomBots.hpp"
+#include "Entity/Unit/RoomUnit.hpp"
+
+using namespace SteerStone::Benchmarks;
+using namespace SteerStone::Game::Map;
+
+/// Units standing in room of path benchmarks, a busy public room
+#define BENCH_ROOM_UNITS 100
+
+/// Build flat square heightmap
+/// @p_Size : Width and height in tiles
+static std::string BuildHeightmap(int64 p_Size)
+{
+    std::string l_Heightmap;
+
+    for (int64 l_Y = 0; l_Y < p_Size; l_Y++)
+        l_Heightmap.append(static_cast<std::size_t>(p_Size), '0').push_back('|');
+
+    return l_Heightmap;
+}
+
+/// Search corner to corner through a room with furni walls and units in the way
+static void RoomFindPath(State& p_State)
+{
+    const int16 l_Size = static_cast<int16>(p_State.GetArgument());
+
+    RoomModel l_Model(BuildHeightmap(l_Size), 0, 0);
+    RoomGrid l_Grid(l_Model);
+
+    /// Walls of furni every 8 rows with a gap at alternating ends, the path has to snake through them
+    for (int16 l_Y = 4; l_Y < l_Size - 1; l_Y += 8)
+    {
+        for (int16 l_X = 0; l_X < l_Size - 2; l_X++)
+            l_Grid.SetFurni((l_Y / 8) % 2 ? l_Size - 1 - l_X : l_X, l_Y, 100, true);
+    }
+
+    /// Units spread over the floor on a fixed pattern
+    for (uint32 l_I = 0, l_Placed = 0; l_Placed < BENCH_ROOM_UNITS && l_I < l_Grid.GetSize(); l_I += 37)
+    {
+        const uint32 l_Index = (l_I * 7919) % l_Grid.GetSize();
+        if (l_Index == 0 || l_Index == l_Grid.GetSize() - 1 || !l_Grid.IsFree(l_Index))
+            continue;
+
+        l_Grid.AddOccupant(l_Index);
+        l_Placed++;
+    }
+
+    std::vector<uint32> l_Path;
+    l_Path.reserve(l_Grid.GetSize());
+
+    while (p_State.KeepRunning())
+    {
+        DoNotOptimize(Pathfinder::FindPath(l_Grid, 0, l_Grid.GetSize() - 1, l_Path));
+        DoNotOptimize(l_Path.data());
+    }
+
+    p_State.SetItemsProcessed(p_State.GetIterations());
+}
+BENCHMARK("Room/FindPath", RoomFindPath, 16, 32, 64);
+
+/// Tick of a room full of wandering bots, decisions, batched path searches and steps
+static void RoomBotUpdate(State& p_State)
+{
+    const uint32 l_Count = static_cast<uint32>(p_State.GetArgument());
+
+    RoomModel l_Model(BuildHeightmap(128), 0, 0);
+    RoomGrid l_Grid(l_Model);
+
+    std::vector<SteerStone::Game::Entity::RoomUnit> l_Units;
+    RoomBots l_Bots;
+
+    l_Units.reserve(l_Count);
+    for (uint32 l_I = 0; l_I < l_Count; l_I++)
+    {
+        const uint32 l_Index = (l_I * 7919) % l_Grid.GetSize();
+        if (!l_Grid.IsFree(l_Index))
+            continue;
+
+        l_Bots.Add(static_cast<uint32>(l_Units.size()), BotBehaviour::Wander, ROOM_BOT_NO_OWNER, 0);
+        l_Units.emplace_back(static_cast<uint32>(l_Units.size() + 1), nullptr, l_Grid.GetX(l_Index), l_Grid.GetY(l_Index), 0);
+        l_Grid.AddOccupant(l_Index);
+    }
+
+    /// Rooms tick twice a second
+    uint32 l_Now = 0;
+
+    while (p_State.KeepRunning())
+    {
+        l_Now += 500;
+        l_Bots.Update(l_Units, l_Grid, l_Now);
+
+        for (SteerStone::Game::Entity::RoomUnit& l_Unit : l_Units)
+        {
+            if (l_Unit.IsWalking())
+                l_Unit.Step(l_Grid);
+        }
+    }
+
+    p_State.SetItemsProcessed(p_State.GetIterations() * l_Units.size());
+}
+BENCHMARK("Room/BotUpdate", RoomBotUpdate, 64, 512, 4096);
@@ -0,0 +1,100 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <Precompiled.hpp>
+#include <atomic>
+#include <thread>
+
+#include "Benchmark.hpp"
+#include "Threading/ThrTaskManager.hpp"
+
+using namespace SteerStone::Core;
+using namespace SteerStone::Benchmarks;
+
+/// Wait until a job ran
+/// @p_Done : Set by the job
+static void WaitJob(std::atomic<bool>& p_Done)
+{
+    while (!p_Done.load(std::memory_order_acquire))
+        std::this_thread::yield();
+
+    p_Done.store(false, std::memory_order_relaxed);
+}
+
+/// Round trip of a run once task, from push until it ran on a worker
+static void TaskManagerRunOnceLatency(State& p_State)
+{
+    std::atomic<bool> l_Done(false);
+
+    while (p_State.KeepRunning())
+    {
+        sThreadManager->PushRunOnceTask(Threading::TaskType::Normal, [&l_Done]()
+        {
+            l_Done.store(true, std::memory_order_release);
+        });
+
+        WaitJob(l_Done);
+    }
+
+    p_State.SetItemsProcessed(p_State.GetIterations());
+}
+BENCHMARK("TaskManager/RunOnceLatency", TaskManagerRunOnceLatency);
+
+/// Round trip of a scheduled job, no task name is built
+static void TaskManagerScheduleLatency(State& p_State)
+{
+    std::atomic<bool> l_Done(false);
+
+    while (p_State.KeepRunning())
+    {
+        sThreadManager->Schedule([&l_Done]()
+        {
+            l_Done.store(true, std::memory_order_release);
+        });
+
+        WaitJob(l_Done);
+    }
+
+    p_State.SetItemsProcessed(p_State.GetIterations());
+}
+BENCHMARK("TaskManager/ScheduleLatency", TaskManagerScheduleLatency);
+
+/// Schedule a batch of jobs and wait until all of them ran
+static void TaskManagerScheduleBatch(State& p_State)
+{
+    const int64 l_Batch = p_State.GetArgument();
+    std::atomic<int64> l_Remaining(0);
+
+    while (p_State.KeepRunning())
+    {
+        l_Remaining.store(l_Batch, std::memory_order_relaxed);
+
+        for (int64 l_I = 0; l_I < l_Batch; l_I++)
+        {
+            sThreadManager->Schedule([&l_Remaining]()
+            {
+                l_Remaining.fetch_sub(1, std::memory_order_release);
+            });
+        }
+
+        while (l_Remaining.load(std::memory_order_acquire) != 0)
+            std::this_thread::yield();
+    }
+
+    p_State.SetItemsProcessed(p_State.GetIterations() * l_Batch);
+}
+BENCHMARK("TaskManager/ScheduleBatch", TaskManagerScheduleBatch, 64, 1024);
@@ -0,0 +1,278 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <Precompiled.hpp>
+#include <array>
+#include <atomic>
+#include <thread>
+
+#include "Benchmark.hpp"
+#include "Utility/UtiString.hpp"
+#include "Utility/UtiTokenizer.hpp"
+#include "Utility/UtiLockedQueue.hpp"
+#include "Utility/UtiBoundedQueue.hpp"
+#include "Utility/UtiWordFilter.hpp"
+
+using namespace SteerStone::Core;
+using namespace SteerStone::Benchmarks;
+
+/// Format of string builder benchmarks, typical of a log line
+static constexpr char const* s_BuilderFormat = "Player %0 (%1) moved to %2 %3 in room %4";
+
+/// Build string from a runtime format
+static void StringBuilderRuntime(State& p_State)
+{
+    while (p_State.KeepRunning())
+    {
+        std::string l_Result = Utils::StringBuilder(s_BuilderFormat, "SteerStone", 1234, 12, 25, 100);
+        DoNotOptimize(l_Result);
+    }
+
+    p_State.SetItemsProcessed(p_State.GetIterations());
+}
+BENCHMARK("StringBuilder/Runtime", StringBuilderRuntime);
+
+/// Build string from a format parsed once
+static void StringBuilderParsed(State& p_State)
+{
+    static constexpr Utils::StringFormat sl_Format(s_BuilderFormat);
+
+    while (p_State.KeepRunning())
+    {
+        std::string l_Result = Utils::StringBuilder(sl_Format, "SteerStone", 1234, 12, 25, 100);
+        DoNotOptimize(l_Result);
+    }
+
+    p_State.SetItemsProcessed(p_State.GetIterations());
+}
+BENCHMARK("StringBuilder/Parsed", StringBuilderParsed);
+
+/// Build string into a stack buffer
+static void StringBuilderBuffer(State& p_State)
+{
+    char l_Buffer[128];
+
+    while (p_State.KeepRunning())
+    {
+        std::string_view l_Result = Utils::StringBuilderBuffer(l_Buffer, s_BuilderFormat, "SteerStone", 1234, 12, 25, 100);
+        DoNotOptimize(l_Result);
+    }
+
+    p_State.SetItemsProcessed(p_State.GetIterations());
+}
+BENCHMARK("StringBuilder/Buffer", StringBuilderBuffer);
+
+//////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+
+/// Build comma separated list of tokens
+/// @p_Count : Amount of tokens
+static std::string BuildTokenList(int64 p_Count)
+{
+    std::string l_List;
+
+    for (int64 l_I = 0; l_I < p_Count; l_I++)
+    {
+        if (l_I != 0)
+            l_List += ',';
+
+        l_List += std::to_string(l_I * 37);
+    }
+
+    return l_List;
+}
+
+/// Iterate every token of a list
+static void SplitTokenizer(State& p_State)
+{
+    const std::string l_List = BuildTokenList(p_State.GetArgument());
+
+    while (p_State.KeepRunning())
+    {
+        for (std::string_view l_Token : Utils::Split(l_List, ","))
+            DoNotOptimize(l_Token);
+    }
+
+    p_State.SetBytesProcessed(p_State.GetIterations() * l_List.size());
+    p_State.SetItemsProcessed(p_State.GetIterations() * p_State.GetArgument());
+}
+BENCHMARK("Split/Tokenizer", SplitTokenizer, 4, 16, 64);
+
+/// Split a list into a fixed array, as config and command parsing do
+static void SplitInto(State& p_State)
+{
+    const std::string l_List = BuildTokenList(p_State.GetArgument());
+    std::array<std::string_view, 64> l_Tokens;
+
+    while (p_State.KeepRunning())
+    {
+        std::size_t l_Count = Utils::SplitInto(l_List, ",", l_Tokens);
+        DoNotOptimize(l_Count);
+        DoNotOptimize(l_Tokens);
+    }
+
+    p_State.SetBytesProcessed(p_State.GetIterations() * l_List.size());
+    p_State.SetItemsProcessed(p_State.GetIterations() * p_State.GetArgument());
+}
+BENCHMARK("Split/SplitInto", SplitInto, 4, 16, 64);
+
+//////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+
+/// Start producers pushing an even share of the iterations, they wait until the consumer is timed
+/// @p_Producers  : Amount of producers
+/// @p_Iterations : Items to push in total
+/// @p_Go         : Set once the consumer starts
+/// @p_Push       : Push one item
+template<typename Push> std::vector<std::thread> StartProducers(int64 p_Producers, uint64 p_Iterations, std::atomic<bool>& p_Go, Push p_Push)
+{
+    std::vector<std::thread> l_Producers;
+
+    for (int64 l_I = 0; l_I < p_Producers; l_I++)
+    {
+        uint64 l_Share = p_Iterations / p_Producers;
+        if (l_I == 0)
+            l_Share += p_Iterations % p_Producers;
+
+        l_Producers.emplace_back([l_Share, &p_Go, p_Push]()
+        {
+            while (!p_Go.load(std::memory_order_acquire))
+                std::this_thread::yield();
+
+            for (uint64 l_J = 0; l_J < l_Share; l_J++)
+                p_Push(l_J);
+        });
+    }
+
+    return l_Producers;
+}
+
+/// Drain items pushed by several producers through the mutex queue
+static void QueueLockedQueue(State& p_State)
+{
+    Utils::LockedQueue<uint64> l_Queue;
+    std::atomic<bool> l_Go(false);
+
+    std::vector<std::thread> l_Producers = StartProducers(p_State.GetArgument(), p_State.GetIterations(), l_Go, [&l_Queue](uint64 p_Item)
+    {
+        l_Queue.Add(p_Item);
+    });
+
+    l_Go.store(true, std::memory_order_release);
+
+    uint64 l_Item = 0;
+    while (p_State.KeepRunning())
+    {
+        while (!l_Queue.Next(l_Item))
+            std::this_thread::yield();
+
+        DoNotOptimize(l_Item);
+    }
+
+    for (std::thread& l_Producer : l_Producers)
+        l_Producer.join();
+
+    p_State.SetItemsProcessed(p_State.GetIterations());
+}
+BENCHMARK("Queue/LockedQueue", QueueLockedQueue, 1, 2, 4);
+
+/// Drain items pushed by several producers through the bounded ring
+static void QueueMPSCQueue(State& p_State)
+{
+    Utils::MPSCQueue<uint64> l_Queue(4096);
+    std::atomic<bool> l_Go(false);
+
+    std::vector<std::thread> l_Producers = StartProducers(p_State.GetArgument(), p_State.GetIterations(), l_Go, [&l_Queue](uint64 p_Item)
+    {
+        l_Queue.Push(p_Item);
+    });
+
+    l_Go.store(true, std::memory_order_release);
+
+    uint64 l_Item = 0;
+    while (p_State.KeepRunning())
+    {
+        while (!l_Queue.TryPop(l_Item))
+            std::this_thread::yield();
+
+        DoNotOptimize(l_Item);
+    }
+
+    for (std::thread& l_Producer : l_Producers)
+        l_Producer.join();
+
+    p_State.SetItemsProcessed(p_State.GetIterations());
+}
+BENCHMARK("Queue/MPSCQueue", QueueMPSCQueue, 1, 2, 4);
+
+//////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////
+
+/// Chat message of word filter benchmarks, one banned word in a typical sentence
+static constexpr char const* s_FilterMessage = "hey does anyone want to trade their throne for my dragon lamp, wordf0 is not welcome here";
+
+/// Build list of banned words
+/// @p_Count : Amount of words
+static std::vector<std::string> BuildBannedWords(int64 p_Count)
+{
+    std::vector<std::string> l_Words;
+
+    for (int64 l_I = 0; l_I < p_Count; l_I++)
+        l_Words.push_back("wordf" + std::to_string(l_I));
+
+    return l_Words;
+}
+
+/// Censor message by replacing every banned word one after another
+static void WordFilterReplaceAll(State& p_State)
+{
+    const std::vector<std::string> l_Words = BuildBannedWords(p_State.GetArgument());
+    const std::string l_Message = s_FilterMessage;
+
+    while (p_State.KeepRunning())
+    {
+        std::string l_Result = l_Message;
+        for (std::string const& l_Word : l_Words)
+            l_Result = Utils::String::ReplaceAll(l_Result, l_Word, std::string(l_Word.size(), WORD_FILTER_MASK));
+
+        DoNotOptimize(l_Result);
+    }
+
+    p_State.SetBytesProcessed(p_State.GetIterations() * l_Message.size());
+    p_State.SetItemsProcessed(p_State.GetIterations());
+}
+BENCHMARK("WordFilter/ReplaceAll", WordFilterReplaceAll, 16, 256, 2048);
+
+/// Censor message in place with the compiled automaton
+static void WordFilterAutomaton(State& p_State)
+{
+    const Utils::WordFilter l_Filter(BuildBannedWords(p_State.GetArgument()), "4a@a3e1i!i0o$s5s7t", ".-_");
+    const std::string l_Message = s_FilterMessage;
+    std::string l_Result = l_Message;
+
+    while (p_State.KeepRunning())
+    {
+        l_Result.assign(l_Message);
+        uint32 l_Matches = l_Filter.Censor(l_Result);
+        DoNotOptimize(l_Matches);
+        DoNotOptimize(l_Result);
+    }
+
+    p_State.SetBytesProcessed(p_State.GetIterations() * l_Message.size());
+    p_State.SetItemsProcessed(p_State.GetIterations());
+}
+BENCHMARK("WordFilter/Automaton", WordFilterAutomaton, 16, 256, 2048);
@@ -0,0 +1,516 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <Precompiled.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <regex>
+#include <thread>
+
+#if defined(_WIN32)
+#   include <Windows.h>
+#else
+#   include <time.h>
+#endif
+
+#include "Benchmark.hpp"
+#include "Diagnostic/DiaFastClock.hpp"
+
+namespace SteerStone { namespace Benchmarks {
+
+    /// Registered benchmark
+    struct Benchmark
+    {
+        std::string Name;                   ///< Name
+        BenchmarkFunction Function;         ///< Function
+        std::vector<int64> Arguments;       ///< Arguments, runs once without any if empty
+    };
+
+    /// Result of a run or aggregate of repeated runs
+    struct Result
+    {
+        std::string Name;                   ///< Name written, run name followed by the aggregate
+        std::string RunName;                ///< Name of run
+        std::string Aggregate;              ///< Aggregate name, empty for runs
+        uint32 Repetition;                  ///< Repetition index
+        uint64 Iterations;                  ///< Iterations
+        double RealTime;                    ///< Wall clock nanoseconds per iteration
+        double CPUTime;                     ///< CPU nanoseconds per iteration
+        double BytesPerSecond;              ///< Bytes per second, 0 if not set
+        double ItemsPerSecond;              ///< Items per second, 0 if not set
+    };
+
+    /// Command line settings
+    struct Settings
+    {
+        std::string Filter = ".";           ///< Regular expression run names must match
+        double MinTime = BENCHMARK_MIN_TIME;///< Seconds a run must last
+        uint32 Repetitions = 1;             ///< Runs of each benchmark
+        std::string Output;                 ///< JSON file written, none if empty
+        bool Json = false;                  ///< Write JSON to stdout instead of a table
+        bool List = false;                  ///< Only list run names
+    };
+
+    /// Get registered benchmarks
+    static std::vector<Benchmark>& GetBenchmarks()
+    {
+        static std::vector<Benchmark> sl_Benchmarks;
+        return sl_Benchmarks;
+    }
+
+    /// Get wall clock nanoseconds
+    static uint64 GetRealNanoseconds()
+    {
+        return static_cast<uint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+    /// Get CPU nanoseconds of calling thread
+    static uint64 GetCPUNanoseconds()
+    {
+#if defined(_WIN32)
+        FILETIME l_Creation, l_Exit, l_Kernel, l_User;
+        if (!GetThreadTimes(GetCurrentThread(), &l_Creation, &l_Exit, &l_Kernel, &l_User))
+            return 0;
+
+        const uint64 l_KernelTime = (static_cast<uint64>(l_Kernel.dwHighDateTime) << 32) | l_Kernel.dwLowDateTime;
+        const uint64 l_UserTime   = (static_cast<uint64>(l_User.dwHighDateTime) << 32) | l_User.dwLowDateTime;
+        return (l_KernelTime + l_UserTime) * 100;
+#else
+        timespec l_Time;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &l_Time);
+        return static_cast<uint64>(l_Time.tv_sec) * 1000000000ull + static_cast<uint64>(l_Time.tv_nsec);
+#endif
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    /// @p_Iterations : Iterations to run
+    /// @p_Argument   : Argument of run
+    State::State(uint64 p_Iterations, int64 p_Argument)
+        : m_Iterations(p_Iterations), m_Remaining(p_Iterations), m_Argument(p_Argument), m_Started(false), m_Running(false),
+        m_RealStart(0), m_CPUStart(0), m_RealTime(0), m_CPUTime(0), m_Bytes(0), m_Items(0)
+    {
+    }
+
+    /// Stop timer while setting up
+    void State::PauseTiming()
+    {
+        StopTiming();
+    }
+    /// Restart timer once set up
+    void State::ResumeTiming()
+    {
+        if (m_Running)
+            return;
+
+        m_Running   = true;
+        m_CPUStart  = GetCPUNanoseconds();
+        m_RealStart = GetRealNanoseconds();
+    }
+
+    /// Get iterations of run
+    uint64 State::GetIterations() const
+    {
+        return m_Iterations;
+    }
+    /// Get argument of run
+    int64 State::GetArgument() const
+    {
+        return m_Argument;
+    }
+    /// Set bytes processed by the whole run
+    /// @p_Bytes : Bytes
+    void State::SetBytesProcessed(uint64 p_Bytes)
+    {
+        m_Bytes = p_Bytes;
+    }
+    /// Set items processed by the whole run
+    /// @p_Items : Items
+    void State::SetItemsProcessed(uint64 p_Items)
+    {
+        m_Items = p_Items;
+    }
+
+    /// Get wall clock nanoseconds timed
+    double State::GetRealTime() const
+    {
+        return static_cast<double>(m_RealTime);
+    }
+    /// Get CPU nanoseconds timed on the running thread
+    double State::GetCPUTime() const
+    {
+        return static_cast<double>(m_CPUTime);
+    }
+    /// Get bytes processed
+    uint64 State::GetBytesProcessed() const
+    {
+        return m_Bytes;
+    }
+    /// Get items processed
+    uint64 State::GetItemsProcessed() const
+    {
+        return m_Items;
+    }
+
+    /// Start timer
+    void State::StartTiming()
+    {
+        m_Started = true;
+        ResumeTiming();
+    }
+    /// Stop timer
+    void State::StopTiming()
+    {
+        if (!m_Running)
+            return;
+
+        m_RealTime += GetRealNanoseconds() - m_RealStart;
+        m_CPUTime  += GetCPUNanoseconds() - m_CPUStart;
+        m_Running   = false;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    /// @p_Name      : Name
+    /// @p_Function  : Function
+    /// @p_Arguments : Arguments, the benchmark runs once for each, once without any if empty
+    Registration::Registration(char const* p_Name, BenchmarkFunction p_Function, std::vector<int64> const& p_Arguments)
+    {
+        GetBenchmarks().push_back({ p_Name, p_Function, p_Arguments });
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Run benchmark until it lasts long enough, iterations grow from what the previous attempt took
+    /// @p_Benchmark : Benchmark
+    /// @p_Argument  : Argument of run
+    /// @p_MinTime   : Seconds run must last
+    static Result Run(Benchmark const& p_Benchmark, int64 p_Argument, double p_MinTime)
+    {
+        uint64 l_Iterations = 1;
+
+        while (true)
+        {
+            State l_State(l_Iterations, p_Argument);
+            p_Benchmark.Function(l_State);
+
+            const double l_Seconds = l_State.GetRealTime() / 1e9;
+
+            if (l_Seconds >= p_MinTime || l_Iterations >= BENCHMARK_MAX_ITERATIONS)
+            {
+                Result l_Result;
+                l_Result.Repetition     = 0;
+                l_Result.Iterations     = l_Iterations;
+                l_Result.RealTime       = l_State.GetRealTime() / static_cast<double>(l_Iterations);
+                l_Result.CPUTime        = l_State.GetCPUTime() / static_cast<double>(l_Iterations);
+                l_Result.BytesPerSecond = l_Seconds > 0.0 ? static_cast<double>(l_State.GetBytesProcessed()) / l_Seconds : 0.0;
+                l_Result.ItemsPerSecond = l_Seconds > 0.0 ? static_cast<double>(l_State.GetItemsProcessed()) / l_Seconds : 0.0;
+
+                return l_Result;
+            }
+
+            /// Aim a little past the minimum time, guesses from very short attempts are capped
+            double l_Multiplier = l_Seconds > 0.0 ? p_MinTime * 1.4 / l_Seconds : 10.0;
+            if (l_Seconds / p_MinTime <= 0.1)
+                l_Multiplier = std::min(l_Multiplier, 10.0);
+
+            l_Iterations = std::min<uint64>(std::max<uint64>(static_cast<uint64>(l_Iterations * l_Multiplier), l_Iterations + 1), BENCHMARK_MAX_ITERATIONS);
+        }
+    }
+    /// Add mean, median and standard deviation of repeated runs
+    /// @p_Runs    : Repeated runs of one benchmark
+    /// @p_Results : Results appended to
+    static void Aggregate(std::vector<Result> const& p_Runs, std::vector<Result>& p_Results)
+    {
+        auto l_Collect = [&p_Runs](double Result::*p_Field)
+        {
+            std::vector<double> l_Values;
+            for (Result const& l_Run : p_Runs)
+                l_Values.push_back(l_Run.*p_Field);
+
+            return l_Values;
+        };
+
+        Result l_Mean   = p_Runs.front();
+        Result l_Median = p_Runs.front();
+        Result l_Stddev = p_Runs.front();
+
+        for (double Result::*l_Field : { &Result::RealTime, &Result::CPUTime, &Result::BytesPerSecond, &Result::ItemsPerSecond })
+        {
+            std::vector<double> l_Values = l_Collect(l_Field);
+
+            double l_Sum = 0.0;
+            for (double l_Value : l_Values)
+                l_Sum += l_Value;
+
+            const double l_Average = l_Sum / l_Values.size();
+
+            double l_Deviation = 0.0;
+            for (double l_Value : l_Values)
+                l_Deviation += (l_Value - l_Average) * (l_Value - l_Average);
+
+            std::sort(l_Values.begin(), l_Values.end());
+
+            l_Mean.*l_Field     = l_Average;
+            l_Median.*l_Field   = l_Values.size() % 2 ? l_Values[l_Values.size() / 2] : (l_Values[l_Values.size() / 2 - 1] + l_Values[l_Values.size() / 2]) / 2.0;
+            l_Stddev.*l_Field   = l_Values.size() > 1 ? std::sqrt(l_Deviation / (l_Values.size() - 1)) : 0.0;
+        }
+
+        l_Mean.Aggregate    = "mean";
+        l_Median.Aggregate  = "median";
+        l_Stddev.Aggregate  = "stddev";
+
+        for (Result* l_Result : { &l_Mean, &l_Median, &l_Stddev })
+        {
+            l_Result->Name = l_Result->RunName + "_" + l_Result->Aggregate;
+            p_Results.push_back(*l_Result);
+        }
+    }
+
+    /// Escape string for JSON
+    /// @p_String : String
+    static std::string EscapeJson(std::string const& p_String)
+    {
+        std::string l_Escaped;
+        for (char l_Char : p_String)
+        {
+            if (l_Char == '"' || l_Char == '\\')
+                l_Escaped += '\\';
+
+            l_Escaped += l_Char;
+        }
+
+        return l_Escaped;
+    }
+    /// Write results in the Google Benchmark JSON format
+    /// @p_Executable : Path of executable
+    /// @p_Settings   : Settings
+    /// @p_Results    : Results
+    static std::string WriteJson(std::string const& p_Executable, Settings const& p_Settings, std::vector<Result> const& p_Results)
+    {
+        char l_Date[64] = { 0 };
+        const std::time_t l_Now = std::time(nullptr);
+        std::strftime(l_Date, sizeof(l_Date), "%Y-%m-%dT%H:%M:%S", std::localtime(&l_Now));
+
+        std::string l_Json = "{\n  \"context\": {\n";
+        l_Json += "    \"date\": \"" + std::string(l_Date) + "\",\n";
+        l_Json += "    \"executable\": \"" + EscapeJson(p_Executable) + "\",\n";
+        l_Json += "    \"num_cpus\": " + std::to_string(std::thread::hardware_concurrency()) + ",\n";
+        l_Json += "    \"mhz_per_cpu\": " + std::to_string(Core::Diagnostic::FastClock::GetTicksPerMicrosecond()) + ",\n";
+#ifdef NDEBUG
+        l_Json += "    \"library_build_type\": \"release\"\n";
+#else
+        l_Json += "    \"library_build_type\": \"debug\"\n";
+#endif
+        l_Json += "  },\n  \"benchmarks\": [\n";
+
+        for (std::size_t l_I = 0; l_I < p_Results.size(); l_I++)
+        {
+            Result const& l_Result = p_Results[l_I];
+            char l_Numbers[256];
+
+            l_Json += "    {\n";
+            l_Json += "      \"name\": \"" + EscapeJson(l_Result.Name) + "\",\n";
+            l_Json += "      \"run_name\": \"" + EscapeJson(l_Result.RunName) + "\",\n";
+            l_Json += l_Result.Aggregate.empty() ? "      \"run_type\": \"iteration\",\n" : "      \"run_type\": \"aggregate\",\n";
+            l_Json += "      \"repetitions\": " + std::to_string(p_Settings.Repetitions) + ",\n";
+            l_Json += "      \"repetition_index\": " + std::to_string(l_Result.Repetition) + ",\n";
+            if (!l_Result.Aggregate.empty())
+                l_Json += "      \"aggregate_name\": \"" + l_Result.Aggregate + "\",\n";
+            l_Json += "      \"threads\": 1,\n";
+            l_Json += "      \"iterations\": " + std::to_string(l_Result.Iterations) + ",\n";
+
+            std::snprintf(l_Numbers, sizeof(l_Numbers), "      \"real_time\": %.6e,\n      \"cpu_time\": %.6e,\n      \"time_unit\": \"ns\"", l_Result.RealTime, l_Result.CPUTime);
+            l_Json += l_Numbers;
+
+            if (l_Result.BytesPerSecond > 0.0)
+            {
+                std::snprintf(l_Numbers, sizeof(l_Numbers), ",\n      \"bytes_per_second\": %.6e", l_Result.BytesPerSecond);
+                l_Json += l_Numbers;
+            }
+            if (l_Result.ItemsPerSecond > 0.0)
+            {
+                std::snprintf(l_Numbers, sizeof(l_Numbers), ",\n      \"items_per_second\": %.6e", l_Result.ItemsPerSecond);
+                l_Json += l_Numbers;
+            }
+
+            l_Json += l_I + 1 < p_Results.size() ? "\n    },\n" : "\n    }\n";
+        }
+
+        l_Json += "  ]\n}\n";
+        return l_Json;
+    }
+    /// Write a result as a table row
+    /// @p_Result : Result
+    static void WriteRow(Result const& p_Result)
+    {
+        std::printf("%-48s %14.1f ns %14.1f ns %12llu", p_Result.Name.c_str(), p_Result.RealTime, p_Result.CPUTime, static_cast<unsigned long long>(p_Result.Iterations));
+
+        if (p_Result.BytesPerSecond > 0.0)
+            std::printf("  %10.3f MB/s", p_Result.BytesPerSecond / (1024.0 * 1024.0));
+        if (p_Result.ItemsPerSecond > 0.0)
+            std::printf("  %10.3f M items/s", p_Result.ItemsPerSecond / 1e6);
+
+        std::printf("\n");
+        std::fflush(stdout);
+    }
+
+    /// Parse command line
+    /// @p_ArgumentCount : Amount of command line arguments
+    /// @p_Arguments     : Command line arguments
+    /// @p_Settings      : Parsed settings
+    static bool ParseArguments(int p_ArgumentCount, char** p_Arguments, Settings& p_Settings)
+    {
+        for (int l_I = 1; l_I < p_ArgumentCount; l_I++)
+        {
+            const std::string l_Argument = p_Arguments[l_I];
+            const std::size_t l_Equal = l_Argument.find('=');
+            const std::string l_Flag  = l_Argument.substr(0, l_Equal);
+            const std::string l_Value = l_Equal == std::string::npos ? std::string() : l_Argument.substr(l_Equal + 1);
+
+            if (l_Flag == "--benchmark_filter")
+                p_Settings.Filter = l_Value;
+            else if (l_Flag == "--benchmark_min_time")
+                p_Settings.MinTime = std::max(std::atof(l_Value.c_str()), 0.001);
+            else if (l_Flag == "--benchmark_repetitions")
+                p_Settings.Repetitions = static_cast<uint32>(std::max(std::atoi(l_Value.c_str()), 1));
+            else if (l_Flag == "--benchmark_out")
+                p_Settings.Output = l_Value;
+            else if (l_Flag == "--benchmark_format")
+                p_Settings.Json = l_Value == "json";
+            else if (l_Flag == "--benchmark_list_tests")
+                p_Settings.List = true;
+            else
+            {
+                std::fprintf(stderr, "Unknown argument %s\n"
+                    "Usage: %s [--benchmark_filter=<regex>] [--benchmark_min_time=<seconds>] [--benchmark_repetitions=<n>]\n"
+                    "       [--benchmark_out=<file.json>] [--benchmark_format=console|json] [--benchmark_list_tests]\n", l_Argument.c_str(), p_Arguments[0]);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /// Run registered benchmarks, flags follow Google Benchmark so its tools (compare.py) read our output
+    /// @p_ArgumentCount : Amount of command line arguments
+    /// @p_Arguments     : Command line arguments
+    int RunBenchmarks(int p_ArgumentCount, char** p_Arguments)
+    {
+        Settings l_Settings;
+        if (!ParseArguments(p_ArgumentCount, p_Arguments, l_Settings))
+            return 1;
+
+        std::regex l_Filter;
+        try
+        {
+            l_Filter = std::regex(l_Settings.Filter);
+        }
+        catch (std::regex_error const&)
+        {
+            std::fprintf(stderr, "Invalid filter %s\n", l_Settings.Filter.c_str());
+            return 1;
+        }
+
+        std::vector<Result> l_Results;
+
+        if (!l_Settings.Json && !l_Settings.List)
+            std::printf("%-48s %17s %17s %12s\n", "Benchmark", "Time", "CPU", "Iterations");
+
+        for (Benchmark const& l_Benchmark : GetBenchmarks())
+        {
+            std::vector<int64> l_Arguments = l_Benchmark.Arguments;
+            if (l_Arguments.empty())
+                l_Arguments.push_back(0);
+
+            for (int64 l_Argument : l_Arguments)
+            {
+                const std::string l_RunName = l_Benchmark.Arguments.empty() ? l_Benchmark.Name : l_Benchmark.Name + "/" + std::to_string(l_Argument);
+
+                if (!std::regex_search(l_RunName, l_Filter))
+                    continue;
+
+                if (l_Settings.List)
+                {
+                    std::printf("%s\n", l_RunName.c_str());
+                    continue;
+                }
+
+                std::vector<Result> l_Runs;
+                for (uint32 l_Repetition = 0; l_Repetition < l_Settings.Repetitions; l_Repetition++)
+                {
+                    Result l_Result     = Run(l_Benchmark, l_Argument, l_Settings.MinTime);
+                    l_Result.Name       = l_RunName;
+                    l_Result.RunName    = l_RunName;
+                    l_Result.Repetition = l_Repetition;
+
+                    if (!l_Settings.Json)
+                        WriteRow(l_Result);
+
+                    l_Runs.push_back(l_Result);
+                }
+
+                l_Results.insert(l_Results.end(), l_Runs.begin(), l_Runs.end());
+
+                if (l_Runs.size() > 1)
+                {
+                    const std::size_t l_First = l_Results.size();
+                    Aggregate(l_Runs, l_Results);
+
+                    if (!l_Settings.Json)
+                    {
+                        for (std::size_t l_I = l_First; l_I < l_Results.size(); l_I++)
+                            WriteRow(l_Results[l_I]);
+                    }
+                }
+            }
+        }
+
+        if (l_Settings.List)
+            return 0;
+
+        const std::string l_Json = WriteJson(p_Arguments[0], l_Settings, l_Results);
+
+        if (l_Settings.Json)
+            std::printf("%s", l_Json.c_str());
+
+        if (!l_Settings.Output.empty())
+        {
+            std::ofstream l_File(l_Settings.Output, std::ios::binary | std::ios::trunc);
+            l_File << l_Json;
+
+            if (!l_File.good())
+            {
+                std::fprintf(stderr, "Could not write %s\n", l_Settings.Output.c_str());
+                return 1;
+            }
+        }
+
+        return 0;
+    }
+
+}   ///< namespace Benchmarks
+}   ///< namespace SteerStone
@@ -0,0 +1,152 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <Precompiled.hpp>
+#include <string>
+#include <vector>
+
+#include "Core/Core.hpp"
+
+#define BENCHMARK_MIN_TIME          0.5         ///< Seconds a run must last before its result is kept
+#define BENCHMARK_MAX_ITERATIONS    1000000000  ///< Iterations a run is capped to
+
+namespace SteerStone { namespace Benchmarks {
+
+    /// Iteration state of a running benchmark
+    class State
+    {
+        public:
+            /// Constructor
+            /// @p_Iterations : Iterations to run
+            /// @p_Argument   : Argument of run
+            State(uint64 p_Iterations, int64 p_Argument);
+
+            /// Count an iteration, the timer starts on first call and stops once every iteration ran
+            bool KeepRunning()
+            {
+                if (m_Remaining == 0)
+                {
+                    if (!m_Started)
+                        StartTiming();
+                    else
+                        StopTiming();
+
+                    return false;
+                }
+
+                if (!m_Started)
+                    StartTiming();
+
+                --m_Remaining;
+                return true;
+            }
+
+            /// Stop timer while setting up
+            void PauseTiming();
+            /// Restart timer once set up
+            void ResumeTiming();
+
+            /// Get iterations of run
+            uint64 GetIterations() const;
+            /// Get argument of run
+            int64 GetArgument() const;
+            /// Set bytes processed by the whole run
+            /// @p_Bytes : Bytes
+            void SetBytesProcessed(uint64 p_Bytes);
+            /// Set items processed by the whole run
+            /// @p_Items : Items
+            void SetItemsProcessed(uint64 p_Items);
+
+            /// Get wall clock nanoseconds timed
+            double GetRealTime() const;
+            /// Get CPU nanoseconds timed on the running thread
+            double GetCPUTime() const;
+            /// Get bytes processed
+            uint64 GetBytesProcessed() const;
+            /// Get items processed
+            uint64 GetItemsProcessed() const;
+
+        private:
+            /// Start timer
+            void StartTiming();
+            /// Stop timer
+            void StopTiming();
+
+        private:
+            uint64 m_Iterations;                ///< Iterations to run
+            uint64 m_Remaining;                 ///< Iterations left
+            int64 m_Argument;                   ///< Argument of run
+            bool m_Started;                     ///< Timer was started once
+            bool m_Running;                     ///< Timer is running
+            uint64 m_RealStart;                 ///< Wall clock start of running timer
+            uint64 m_CPUStart;                  ///< CPU start of running timer
+            uint64 m_RealTime;                  ///< Wall clock nanoseconds timed
+            uint64 m_CPUTime;                   ///< CPU nanoseconds timed
+            uint64 m_Bytes;                     ///< Bytes processed
+            uint64 m_Items;                     ///< Items processed
+    };
+
+    /// Benchmark function
+    typedef void (*BenchmarkFunction)(State&);
+
+    /// Registers a benchmark at static initialisation
+    struct Registration
+    {
+        /// Constructor
+        /// @p_Name      : Name
+        /// @p_Function  : Function
+        /// @p_Arguments : Arguments, the benchmark runs once for each, once without any if empty
+        Registration(char const* p_Name, BenchmarkFunction p_Function, std::vector<int64> const& p_Arguments = std::vector<int64>());
+    };
+
+    /// Keep value from being optimized away
+    /// @p_Value : Value
+    template<typename T> inline void DoNotOptimize(T const& p_Value)
+    {
+#if defined(_MSC_VER)
+        const volatile char* l_Sink = reinterpret_cast<const volatile char*>(&p_Value);
+        (void)*l_Sink;
+        _ReadWriteBarrier();
+#else
+        asm volatile("" : : "r,m"(p_Value) : "memory");
+#endif
+    }
+    /// Force pending writes to memory to be performed
+    inline void ClobberMemory()
+    {
+#if defined(_MSC_VER)
+        _ReadWriteBarrier();
+#else
+        asm volatile("" : : : "memory");
+#endif
+    }
+
+    /// Run registered benchmarks, flags follow Google Benchmark so its tools (compare.py) read our output
+    /// @p_ArgumentCount : Amount of command line arguments
+    /// @p_Arguments     : Command line arguments
+    int RunBenchmarks(int p_ArgumentCount, char** p_Arguments);
+
+}   ///< namespace Benchmarks
+}   ///< namespace SteerStone
+
+#define BENCHMARK_REGISTRATION_(p_Function, p_Line)         l_Registration##p_Function##p_Line
+#define BENCHMARK_REGISTRATION(p_Function, p_Line)          BENCHMARK_REGISTRATION_(p_Function, p_Line)
+/// Register benchmark, extra arguments are the arguments it runs with
+#define BENCHMARK(p_Name, p_Function, ...) \
+    static ::SteerStone::Benchmarks::Registration BENCHMARK_REGISTRATION(p_Function, __LINE__)(p_Name, &p_Function, { __VA_ARGS__ })
@@ -0,0 +1,42 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "ReplaySettings.hpp"
+#include "Config/Config.hpp"
+
+namespace SteerStone { namespace Replay {
+
+    /// Read settings from configuration file
+    void ReplaySettings::Load()
+    {
+        CaptureFile             = sConfigManager->GetString("Replay.CaptureFile", "capture.bin");
+        DatabaseInfo            = sConfigManager->GetString("Replay.DatabaseInfo", "127.0.0.1;3306;SteerStone;SteerStone;SteerStone_Replay");
+        Instances               = std::max<int32>(1, sConfigManager->GetInt("Replay.Instances", 5));
+        StatementsPerInstance   = std::max<int32>(1, sConfigManager->GetInt("Replay.StatementsPerInstance", 10));
+        PoolTimeout             = sConfigManager->GetInt("Replay.PoolTimeout", 5000);
+        WorkerThreads           = std::max<int32>(1, sConfigManager->GetInt("Replay.WorkerThreads", 1));
+        NonBlocking             = sConfigManager->GetBool("Replay.NonBlocking", false);
+        Speed                   = std::max<float>(0.0f, sConfigManager->GetFloat("Replay.Speed", 1.0f));
+        MaxInFlight             = sConfigManager->GetInt("Replay.MaxInFlight", 0);
+        ReportInterval          = std::max<int32>(1, sConfigManager->GetInt("Replay.ReportInterval", 10));
+        ReportFile              = sConfigManager->GetString("Replay.ReportFile", "");
+    }
+
+}   ///< namespace Replay
+}   ///< namespace SteerStone
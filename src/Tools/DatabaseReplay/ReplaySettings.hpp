@@ -0,0 +1,48 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <Precompiled.hpp>
+#include <string>
+
+#include "Core/Core.hpp"
+
+namespace SteerStone { namespace Replay {
+
+    /// Behaviour of the replay, read from the configuration file
+    struct ReplaySettings
+    {
+        /// Read settings from configuration file
+        void Load();
+
+        std::string CaptureFile;                ///< Capture written by the game server
+        std::string DatabaseInfo;               ///< Test database; host, port, username, password, database
+        uint32 Instances;                       ///< MySQL instances to spawn
+        uint32 StatementsPerInstance;           ///< Prepared statements each instance adds to the pool
+        uint32 PoolTimeout;                     ///< Milliseconds to wait on a pool statement before the execution counts as failed
+        uint32 WorkerThreads;                   ///< Database workers executing the statements
+        bool NonBlocking;                       ///< Drive connections through the non blocking API
+        float Speed;                            ///< Times faster than captured, 0 queues as fast as the pool allows
+        uint32 MaxInFlight;                     ///< Executions queued and not completed before the replay waits, 0 for no limit
+        uint32 ReportInterval;                  ///< Seconds between periodic reports
+        std::string ReportFile;                 ///< File the final report is written to as JSON, empty to only log it
+    };
+
+}   ///< namespace Replay
+}   ///< namespace SteerStone
@@ -0,0 +1,79 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <Precompiled.hpp>
+#include <atomic>
+
+#include "Core/Core.hpp"
+#include "Diagnostic/DiaHistogram.hpp"
+
+namespace SteerStone { namespace Replay {
+
+    /// Add to a counter which has a single writer, no locked instruction is needed
+    /// @p_Counter : Counter
+    /// @p_Value   : Amount to add
+    inline void AddCounter(std::atomic<uint64>& p_Counter, uint64 p_Value = 1)
+    {
+        p_Counter.store(p_Counter.load(std::memory_order_relaxed) + p_Value, std::memory_order_relaxed);
+    }
+
+    /// Statistics of a captured statement
+    /// Queued and Skipped are written by the replay thread, everything else by the collector thread
+    struct StatementStatistics
+    {
+        /// Constructor
+        /// @p_Name      : Catalog name, or the query
+        /// @p_CatalogId : Id in catalog, WORKLOAD_CAPTURE_AD_HOC if replayed from its query
+        StatementStatistics(std::string const& p_Name, uint32 p_CatalogId)
+            : Name(p_Name), CatalogId(p_CatalogId), Queued(0), Skipped(0), Completed(0), Failed(0)
+        {
+        }
+
+        /// Record completion of an execution
+        /// @p_Latency : Nanoseconds between queueing the statement and its callback
+        /// @p_Success : Statement executed
+        void RecordCompletion(uint64 p_Latency, bool p_Success)
+        {
+            AddCounter(p_Success ? Completed : Failed);
+            Interval.Record(p_Latency);
+            Total.Record(p_Latency);
+        }
+
+        std::string Name;                               ///< Catalog name, or the query
+        uint32 CatalogId;                               ///< Id in catalog, WORKLOAD_CAPTURE_AD_HOC if replayed from its query
+        std::atomic<uint64> Queued;                     ///< Executions queued
+        std::atomic<uint64> Skipped;                    ///< Executions which got no pool statement within the pool timeout
+        std::atomic<uint64> Completed;                  ///< Executions which succeeded
+        std::atomic<uint64> Failed;                     ///< Executions which failed
+        Core::Diagnostic::LatencyHistogram Interval;    ///< Latencies since last periodic report
+        Core::Diagnostic::LatencyHistogram Total;       ///< Latencies since start
+    };
+
+    /// Counters of every statement added together
+    struct ReplayTotals
+    {
+        uint64 Queued;                                  ///< Executions queued
+        uint64 Skipped;                                 ///< Executions which got no pool statement
+        uint64 Completed;                               ///< Executions which succeeded
+        uint64 Failed;                                  ///< Executions which failed
+    };
+
+}   ///< namespace Replay
+}   ///< namespace SteerStone
@@ -0,0 +1,445 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "Replayer.hpp"
+#include "Diagnostic/DiaFastClock.hpp"
+#include "Database/GameStatements.hpp"
+#include "Logger/Base.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+namespace SteerStone { namespace Replay {
+
+    std::atomic<bool> Replayer::s_Stop(false);
+
+    /// Convert nanoseconds to milliseconds for reports
+    /// @p_Nanoseconds : Nanoseconds
+    static double ToMilliseconds(uint64 p_Nanoseconds)
+    {
+        return static_cast<double>(p_Nanoseconds) / 1000000.0;
+    }
+    /// Write string as a JSON string literal
+    /// @p_File   : File
+    /// @p_String : String
+    static void WriteJsonString(std::ofstream& p_File, std::string const& p_String)
+    {
+        p_File << '"';
+
+        for (char l_Char : p_String)
+        {
+            switch (l_Char)
+            {
+                case '"':   p_File << "\\\"";   break;
+                case '\\':  p_File << "\\\\";   break;
+                case '\n':  p_File << "\\n";    break;
+                case '\r':  p_File << "\\r";    break;
+                case '\t':  p_File << "\\t";    break;
+                default:
+                    if (static_cast<uint8>(l_Char) < 0x20)
+                        p_File << ' ';
+                    else
+                        p_File << l_Char;
+                    break;
+            }
+        }
+
+        p_File << '"';
+    }
+
+    /// Stop replay, safe to call from a signal handler
+    void Replayer::Stop()
+    {
+        s_Stop.store(true, std::memory_order_release);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    /// @p_Settings : Settings, must outlive us
+    Replayer::Replayer(ReplaySettings const& p_Settings)
+        : m_Settings(p_Settings), m_Pending(false), m_Collecting(true),
+        m_Completions([this]()
+        {
+            std::lock_guard<std::mutex> l_Guard(m_Mutex);
+            m_Pending = true;
+            m_Condition.notify_one();
+        }),
+        m_InFlight(0), m_LastTotals(), m_LastReport(0)
+    {
+    }
+    /// Deconstructor
+    Replayer::~Replayer()
+    {
+        if (m_Collector.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> l_Guard(m_Mutex);
+                m_Collecting = false;
+                m_Condition.notify_one();
+            }
+
+            m_Collector.join();
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Replay capture, returns once every execution completed or Stop has been called
+    /// Returns false if the capture could not be opened or the database could not be started
+    bool Replayer::Run()
+    {
+        if (!m_Reader.Open(m_Settings.CaptureFile))
+            return false;
+
+        /// Catalog statements are prepared on connect like on the game server, as long as their query did not change
+        Game::RegisterGameStatements(m_Catalog);
+
+        m_Database.SetCatalog(&m_Catalog);
+        m_Database.SetPoolLimits(m_Settings.StatementsPerInstance, m_Settings.PoolTimeout);
+
+        if (!m_Database.Start(m_Settings.DatabaseInfo, m_Settings.Instances, m_Settings.WorkerThreads, m_Settings.NonBlocking))
+        {
+            LOG_ERROR("Replay", "Failed to start test database %0", m_Settings.DatabaseInfo);
+            return false;
+        }
+
+        m_Collector = std::thread(&Replayer::ProcessCompletions, this);
+
+        LOG_INFO("Replay", "Replaying %0 at %1x over %2 workers and %3 connections", m_Settings.CaptureFile, m_Settings.Speed,
+            m_Settings.WorkerThreads, m_Settings.Instances * m_Settings.StatementsPerInstance);
+
+        const int64 l_Start = Core::Diagnostic::FastClock::GetNanoseconds();
+        m_LastReport = l_Start;
+
+        Core::Database::WorkloadExecution l_Execution;
+
+        while (!s_Stop.load(std::memory_order_acquire) && m_Reader.Next(l_Execution))
+        {
+            if (m_Settings.Speed > 0.0f)
+            {
+                const int64 l_Target = l_Start + static_cast<int64>(l_Execution.Offset / m_Settings.Speed);
+                WaitUntil(l_Target);
+
+                const int64 l_Lag = Core::Diagnostic::FastClock::GetNanoseconds() - l_Target;
+                m_LagInterval.Record(static_cast<uint64>(std::max<int64>(0, l_Lag)));
+                m_LagTotal.Record(static_cast<uint64>(std::max<int64>(0, l_Lag)));
+            }
+
+            while (m_Settings.MaxInFlight && m_InFlight.load(std::memory_order_relaxed) >= m_Settings.MaxInFlight && !s_Stop.load(std::memory_order_acquire))
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(REPLAY_IN_FLIGHT_WAIT));
+                UpdateReport(Core::Diagnostic::FastClock::GetNanoseconds());
+            }
+
+            Queue(l_Execution);
+            UpdateReport(Core::Diagnostic::FastClock::GetNanoseconds());
+        }
+
+        if (m_Reader.HasError())
+            LOG_WARNING("Replay", "%0 ends with a malformed record, replay stopped there", m_Settings.CaptureFile);
+
+        /// Interrupting reports what completed so far, executions still in flight are not waited on
+        while (m_InFlight.load(std::memory_order_relaxed) && !s_Stop.load(std::memory_order_acquire))
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(REPLAY_WAIT_STEP));
+            UpdateReport(Core::Diagnostic::FastClock::GetNanoseconds());
+        }
+
+        const int64 l_End = Core::Diagnostic::FastClock::GetNanoseconds();
+
+        {
+            std::lock_guard<std::mutex> l_Guard(m_Mutex);
+            m_Collecting = false;
+            m_Condition.notify_one();
+        }
+
+        m_Collector.join();
+
+        ReportTotal(static_cast<double>(l_End - l_Start) / 1000000000.0);
+
+        return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get statistics of a captured statement, picks how it is prepared the first time it is seen
+    /// @p_Index : Index of statement in capture
+    StatementStatistics* Replayer::GetStatement(uint32 p_Index)
+    {
+        /// Statements are written before their first execution, so they are seen in index order
+        while (m_Statements.size() <= p_Index)
+        {
+            Core::Database::WorkloadStatement const& l_Captured = m_Reader.GetStatements()[m_Statements.size()];
+            Core::Database::CatalogStatement const* l_Catalog = nullptr;
+
+            if (l_Captured.CatalogId != WORKLOAD_CAPTURE_AD_HOC)
+            {
+                l_Catalog = m_Catalog.Get(l_Captured.CatalogId);
+
+                if (!l_Catalog || l_Catalog->Query != l_Captured.Query)
+                {
+                    LOG_WARNING("Replay", "Catalog statement %0 changed since the capture, replaying its captured query instead", l_Captured.CatalogId);
+                    l_Catalog = nullptr;
+                }
+            }
+
+            m_Statements.push_back(std::unique_ptr<StatementStatistics>(l_Catalog ? new StatementStatistics(l_Catalog->Name, l_Catalog->Id)
+                : new StatementStatistics(l_Captured.Query, WORKLOAD_CAPTURE_AD_HOC)));
+        }
+
+        return m_Statements[p_Index].get();
+    }
+    /// Prepare and queue an execution
+    /// @p_Execution : Execution, its parameters are moved out
+    void Replayer::Queue(Core::Database::WorkloadExecution& p_Execution)
+    {
+        StatementStatistics* l_Statistics = GetStatement(p_Execution.Statement);
+
+        Core::Database::PreparedStatement* l_Statement = l_Statistics->CatalogId != WORKLOAD_CAPTURE_AD_HOC
+            ? m_Database.GetPrepareStatement(l_Statistics->CatalogId) : m_Database.GetPrepareStatement();
+
+        if (!l_Statement)
+        {
+            AddCounter(l_Statistics->Skipped);
+            return;
+        }
+
+        if (l_Statistics->CatalogId == WORKLOAD_CAPTURE_AD_HOC)
+            l_Statement->PrepareStatement(m_Reader.GetStatements()[p_Execution.Statement].Query.c_str());
+
+        for (std::size_t l_I = 0; l_I < p_Execution.Parameters.size(); l_I++)
+            l_Statement->SetData(static_cast<uint16>(l_I), std::move(p_Execution.Parameters[l_I]));
+
+        /// Binary parameters point into these, they must live until the statement executed
+        std::shared_ptr<std::vector<std::vector<char>>> l_Buffers;
+        if (!p_Execution.Buffers.empty())
+            l_Buffers = std::make_shared<std::vector<std::vector<char>>>(std::move(p_Execution.Buffers));
+
+        const int64 l_Queued = Core::Diagnostic::FastClock::GetNanoseconds();
+
+        Core::Database::CompletionQueue::ResultCallback l_Callback = [this, l_Statistics, l_Queued, l_Buffers](std::unique_ptr<Core::Database::PreparedResultSet> p_Result)
+        {
+            l_Statistics->RecordCompletion(static_cast<uint64>(Core::Diagnostic::FastClock::GetNanoseconds() - l_Queued), p_Result != nullptr);
+            m_InFlight.fetch_sub(1, std::memory_order_relaxed);
+        };
+
+        AddCounter(l_Statistics->Queued);
+        m_InFlight.fetch_add(1, std::memory_order_relaxed);
+
+        /// Routed like on the game server, keyed executions keep their order on the worker owning the key
+        if (p_Execution.Route == Core::Database::WorkloadRoute::Keyed)
+            m_Database.PrepareOperator(l_Statement, p_Execution.ShardKey, &m_Completions, std::move(l_Callback));
+        else
+            m_Database.PrepareOperator(l_Statement, &m_Completions, std::move(l_Callback));
+    }
+    /// Wait until a point of the schedule, reports periodically while waiting
+    /// @p_Time : Nanoseconds of FastClock
+    void Replayer::WaitUntil(int64 p_Time)
+    {
+        for (;;)
+        {
+            const int64 l_Now = Core::Diagnostic::FastClock::GetNanoseconds();
+            if (l_Now >= p_Time || s_Stop.load(std::memory_order_acquire))
+                return;
+
+            UpdateReport(l_Now);
+            std::this_thread::sleep_for(std::chrono::nanoseconds(std::min<int64>(p_Time - l_Now, REPLAY_WAIT_STEP * 1000000)));
+        }
+    }
+    /// Run callbacks of completed executions until stopped, body of collector thread
+    void Replayer::ProcessCompletions()
+    {
+        for (;;)
+        {
+            bool l_Collecting = true;
+
+            {
+                std::unique_lock<std::mutex> l_Lock(m_Mutex);
+                m_Condition.wait(l_Lock, [this]() { return m_Pending || !m_Collecting; });
+
+                m_Pending    = false;
+                l_Collecting = m_Collecting;
+            }
+
+            m_Completions.Process();
+
+            if (!l_Collecting)
+                return;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Add counters of every statement together
+    /// @p_Totals : Output
+    void Replayer::Collect(ReplayTotals& p_Totals) const
+    {
+        p_Totals = ReplayTotals();
+
+        for (std::unique_ptr<StatementStatistics> const& l_Statistics : m_Statements)
+        {
+            p_Totals.Queued     += l_Statistics->Queued.load(std::memory_order_relaxed);
+            p_Totals.Skipped    += l_Statistics->Skipped.load(std::memory_order_relaxed);
+            p_Totals.Completed  += l_Statistics->Completed.load(std::memory_order_relaxed);
+            p_Totals.Failed     += l_Statistics->Failed.load(std::memory_order_relaxed);
+        }
+    }
+    /// Report if the report interval elapsed
+    /// @p_Now : Nanoseconds of FastClock
+    void Replayer::UpdateReport(int64 p_Now)
+    {
+        const int64 l_Interval = static_cast<int64>(m_Settings.ReportInterval) * 1000000000;
+
+        if (p_Now - m_LastReport < l_Interval)
+            return;
+
+        Report(static_cast<double>(p_Now - m_LastReport) / 1000000000.0);
+        m_LastReport = p_Now;
+    }
+    /// Log what has been measured since last report, interval latencies are reset
+    /// @p_Seconds : Seconds since last report
+    void Replayer::Report(double p_Seconds)
+    {
+        ReplayTotals l_Totals;
+        Collect(l_Totals);
+
+        /// Samples recorded between our merge and the reset are dropped, a handful out of an interval
+        Core::Diagnostic::LatencyHistogram l_Latency;
+        for (std::unique_ptr<StatementStatistics> const& l_Statistics : m_Statements)
+        {
+            l_Latency.Merge(l_Statistics->Interval);
+            l_Statistics->Interval.Reset();
+        }
+
+        LOG_INFO("Replay", "%0 queued/s, %1 completed/s, %2 failed, %3 skipped, %4 in flight, p50 %5 ms, p99 %6 ms, p99.9 %7 ms, max %8 ms, behind schedule p99 %9 ms",
+            (l_Totals.Queued - m_LastTotals.Queued) / p_Seconds, (l_Totals.Completed - m_LastTotals.Completed) / p_Seconds,
+            l_Totals.Failed - m_LastTotals.Failed, l_Totals.Skipped - m_LastTotals.Skipped, m_InFlight.load(std::memory_order_relaxed),
+            ToMilliseconds(l_Latency.GetP50()), ToMilliseconds(l_Latency.GetP99()), ToMilliseconds(l_Latency.GetP999()), ToMilliseconds(l_Latency.GetMax()),
+            ToMilliseconds(m_LagInterval.GetP99()));
+
+        m_LagInterval.Reset();
+        m_LastTotals = l_Totals;
+    }
+    /// Log what has been measured since start and write report file
+    /// @p_Seconds : Seconds since start
+    void Replayer::ReportTotal(double p_Seconds)
+    {
+        ReplayTotals l_Totals;
+        Collect(l_Totals);
+
+        Core::Diagnostic::LatencyHistogram l_Latency;
+        for (std::unique_ptr<StatementStatistics> const& l_Statistics : m_Statements)
+            l_Latency.Merge(l_Statistics->Total);
+
+        const double l_Seconds = std::max(p_Seconds, 0.001);
+
+        LOG_INFO("Replay", "Replayed %0 executions of %1 statements in %2 s, %3 completed/s, %4 failed, %5 skipped",
+            l_Totals.Queued, static_cast<uint32>(m_Statements.size()), p_Seconds, l_Totals.Completed / l_Seconds, l_Totals.Failed, l_Totals.Skipped);
+        LOG_INFO("Replay", "  Latency mean %0 ms, p50 %1 ms, p99 %2 ms, p99.9 %3 ms, max %4 ms, behind schedule p99 %5 ms max %6 ms",
+            ToMilliseconds(l_Latency.GetMean()), ToMilliseconds(l_Latency.GetP50()), ToMilliseconds(l_Latency.GetP99()), ToMilliseconds(l_Latency.GetP999()),
+            ToMilliseconds(l_Latency.GetMax()), ToMilliseconds(m_LagTotal.GetP99()), ToMilliseconds(m_LagTotal.GetMax()));
+
+        /// Statements taking most database time first
+        std::vector<StatementStatistics const*> l_Sorted;
+        for (std::unique_ptr<StatementStatistics> const& l_Statistics : m_Statements)
+            l_Sorted.push_back(l_Statistics.get());
+
+        std::sort(l_Sorted.begin(), l_Sorted.end(), [](StatementStatistics const* p_Left, StatementStatistics const* p_Right)
+        {
+            return p_Left->Total.GetMean() * p_Left->Total.GetCount() > p_Right->Total.GetMean() * p_Right->Total.GetCount();
+        });
+
+        for (std::size_t l_I = 0; l_I < l_Sorted.size() && l_I < REPLAY_REPORT_STATEMENTS; l_I++)
+        {
+            StatementStatistics const* l_Statistics = l_Sorted[l_I];
+
+            LOG_INFO("Replay", "  %0: %1 completed, %2 failed, p50 %3 ms, p99 %4 ms, max %5 ms", l_Statistics->Name,
+                l_Statistics->Completed.load(std::memory_order_relaxed), l_Statistics->Failed.load(std::memory_order_relaxed),
+                ToMilliseconds(l_Statistics->Total.GetP50()), ToMilliseconds(l_Statistics->Total.GetP99()), ToMilliseconds(l_Statistics->Total.GetMax()));
+        }
+
+        if (!m_Settings.ReportFile.empty())
+            WriteReportFile(l_Totals, l_Latency, l_Seconds);
+    }
+    /// Write report as JSON, so runs can be compared against each other
+    /// @p_Totals  : Counters since start
+    /// @p_Latency : Latencies of every statement since start
+    /// @p_Seconds : Seconds since start
+    void Replayer::WriteReportFile(ReplayTotals const& p_Totals, Core::Diagnostic::LatencyHistogram const& p_Latency, double p_Seconds)
+    {
+        std::ofstream l_File(m_Settings.ReportFile, std::ios::out | std::ios::trunc);
+        if (!l_File.is_open())
+        {
+            LOG_ERROR("Replay", "Failed to open report file %0", m_Settings.ReportFile);
+            return;
+        }
+
+        l_File << "{\n";
+        l_File << "  \"capture\": ";                     WriteJsonString(l_File, m_Settings.CaptureFile);    l_File << ",\n";
+        l_File << "  \"speed\": "                       << m_Settings.Speed                                 << ",\n";
+        l_File << "  \"workers\": "                     << m_Settings.WorkerThreads                         << ",\n";
+        l_File << "  \"connections\": "                 << m_Settings.Instances * m_Settings.StatementsPerInstance << ",\n";
+        l_File << "  \"duration_seconds\": "            << p_Seconds                                        << ",\n";
+        l_File << "  \"queued\": "                      << p_Totals.Queued                                  << ",\n";
+        l_File << "  \"completed\": "                   << p_Totals.Completed                               << ",\n";
+        l_File << "  \"failed\": "                      << p_Totals.Failed                                  << ",\n";
+        l_File << "  \"skipped\": "                     << p_Totals.Skipped                                 << ",\n";
+        l_File << "  \"completed_per_second\": "        << p_Totals.Completed / p_Seconds                   << ",\n";
+        l_File << "  \"mean_ms\": "                     << ToMilliseconds(p_Latency.GetMean())              << ",\n";
+        l_File << "  \"p50_ms\": "                      << ToMilliseconds(p_Latency.GetP50())               << ",\n";
+        l_File << "  \"p99_ms\": "                      << ToMilliseconds(p_Latency.GetP99())               << ",\n";
+        l_File << "  \"p999_ms\": "                     << ToMilliseconds(p_Latency.GetP999())              << ",\n";
+        l_File << "  \"max_ms\": "                      << ToMilliseconds(p_Latency.GetMax())               << ",\n";
+        l_File << "  \"behind_schedule_p99_ms\": "      << ToMilliseconds(m_LagTotal.GetP99())              << ",\n";
+        l_File << "  \"behind_schedule_max_ms\": "      << ToMilliseconds(m_LagTotal.GetMax())              << ",\n";
+        l_File << "  \"statements\": [\n";
+
+        for (std::size_t l_I = 0; l_I < m_Statements.size(); l_I++)
+        {
+            StatementStatistics const& l_Statistics = *m_Statements[l_I];
+
+            l_File << "    {";
+            l_File << "\"name\": ";                 WriteJsonString(l_File, l_Statistics.Name);                           l_File << ", ";
+            l_File << "\"catalog\": "               << (l_Statistics.CatalogId != WORKLOAD_CAPTURE_AD_HOC ? "true" : "false") << ", ";
+            l_File << "\"queued\": "                << l_Statistics.Queued.load(std::memory_order_relaxed)                << ", ";
+            l_File << "\"completed\": "             << l_Statistics.Completed.load(std::memory_order_relaxed)             << ", ";
+            l_File << "\"failed\": "                << l_Statistics.Failed.load(std::memory_order_relaxed)                << ", ";
+            l_File << "\"skipped\": "               << l_Statistics.Skipped.load(std::memory_order_relaxed)               << ", ";
+            l_File << "\"mean_ms\": "               << ToMilliseconds(l_Statistics.Total.GetMean())                       << ", ";
+            l_File << "\"p50_ms\": "                << ToMilliseconds(l_Statistics.Total.GetP50())                        << ", ";
+            l_File << "\"p99_ms\": "                << ToMilliseconds(l_Statistics.Total.GetP99())                        << ", ";
+            l_File << "\"p999_ms\": "               << ToMilliseconds(l_Statistics.Total.GetP999())                       << ", ";
+            l_File << "\"max_ms\": "                << ToMilliseconds(l_Statistics.Total.GetMax());
+            l_File << "}" << (l_I + 1 < m_Statements.size() ? "," : "") << "\n";
+        }
+
+        l_File << "  ]\n";
+        l_File << "}\n";
+
+        LOG_INFO("Replay", "Report written to %0", m_Settings.ReportFile);
+    }
+
+}   ///< namespace Replay
+}   ///< namespace SteerStone
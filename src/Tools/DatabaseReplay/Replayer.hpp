@@ -0,0 +1,120 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+#include <Precompiled.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Database/Database.hpp"
+#include "Database/StatementCatalog.hpp"
+#include "Database/WorkloadCapture.hpp"
+#include "ReplaySettings.hpp"
+#include "ReplayStatistics.hpp"
+
+#define REPLAY_WAIT_STEP            1       ///< Milliseconds slept at most between two checks while waiting on the schedule
+#define REPLAY_IN_FLIGHT_WAIT       100     ///< Microseconds slept while too many executions are in flight
+#define REPLAY_REPORT_STATEMENTS    10      ///< Statements listed in the final report, by total time
+
+namespace SteerStone { namespace Replay {
+
+    /// Re-issues a captured workload against a test database through the database workers
+    /// Executions are queued at the pace they were captured at, scaled by the speed. Their callbacks run on a
+    /// collector thread woken by the completion queue, so latencies are measured from queueing until the
+    /// worker handed the result back
+    class Replayer
+    {
+        DISALLOW_COPY_AND_ASSIGN(Replayer);
+
+        public:
+            /// Stop replay, safe to call from a signal handler
+            static void Stop();
+
+        public:
+            /// Constructor
+            /// @p_Settings : Settings, must outlive us
+            explicit Replayer(ReplaySettings const& p_Settings);
+            /// Deconstructor
+            ~Replayer();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Replay capture, returns once every execution completed or Stop has been called
+            /// Returns false if the capture could not be opened or the database could not be started
+            bool Run();
+
+        private:
+            /// Get statistics of a captured statement, picks how it is prepared the first time it is seen
+            /// @p_Index : Index of statement in capture
+            StatementStatistics* GetStatement(uint32 p_Index);
+            /// Prepare and queue an execution
+            /// @p_Execution : Execution, its parameters are moved out
+            void Queue(Core::Database::WorkloadExecution& p_Execution);
+            /// Wait until a point of the schedule, reports periodically while waiting
+            /// @p_Time : Nanoseconds of FastClock
+            void WaitUntil(int64 p_Time);
+            /// Run callbacks of completed executions until stopped, body of collector thread
+            void ProcessCompletions();
+
+            /// Add counters of every statement together
+            /// @p_Totals : Output
+            void Collect(ReplayTotals& p_Totals) const;
+            /// Report if the report interval elapsed
+            /// @p_Now : Nanoseconds of FastClock
+            void UpdateReport(int64 p_Now);
+            /// Log what has been measured since last report, interval latencies are reset
+            /// @p_Seconds : Seconds since last report
+            void Report(double p_Seconds);
+            /// Log what has been measured since start and write report file
+            /// @p_Seconds : Seconds since start
+            void ReportTotal(double p_Seconds);
+            /// Write report as JSON, so runs can be compared against each other
+            /// @p_Totals  : Counters since start
+            /// @p_Latency : Latencies of every statement since start
+            /// @p_Seconds : Seconds since start
+            void WriteReportFile(ReplayTotals const& p_Totals, Core::Diagnostic::LatencyHistogram const& p_Latency, double p_Seconds);
+
+        private:
+            static std::atomic<bool> s_Stop;                                    ///< Stop has been requested
+
+            ReplaySettings const& m_Settings;                                   ///< Settings
+            std::mutex m_Mutex;                                                 ///< Guards m_Pending
+            std::condition_variable m_Condition;                                ///< Wakes the collector thread
+            bool m_Pending;                                                     ///< Completions have been posted since the collector last looked
+            bool m_Collecting;                                                  ///< Collector thread keeps running
+            Core::Database::CompletionQueue m_Completions;                      ///< Callbacks of executions, outlives the workers posting into it
+            Core::Database::StatementCatalog m_Catalog;                         ///< Game statements, outlives the database
+            Core::Database::Base m_Database;                                    ///< Test database
+            Core::Database::WorkloadReader m_Reader;                            ///< Capture
+            std::vector<std::unique_ptr<StatementStatistics>> m_Statements;     ///< Statistics of every captured statement, by index in capture
+            std::thread m_Collector;                                            ///< Runs callbacks of completed executions
+            std::atomic<uint32> m_InFlight;                                     ///< Executions queued and not completed
+            Core::Diagnostic::LatencyHistogram m_LagInterval;                   ///< Time queued behind schedule since last periodic report
+            Core::Diagnostic::LatencyHistogram m_LagTotal;                      ///< Time queued behind schedule since start
+            ReplayTotals m_LastTotals;                                          ///< Counters at last periodic report
+            int64 m_LastReport;                                                 ///< Time of last periodic report
+    };
+
+}   ///< namespace Replay
+}   ///< namespace SteerStone
@@ -0,0 +1,56 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <csignal>
+
+#include "Logger/Base.hpp"
+#include "Config/Config.hpp"
+#include "Diagnostic/DiaFastClock.hpp"
+#include "Replayer.hpp"
+
+int main(int argc, char** argv)
+{
+    /// Log Enablers
+    LOG_ENABLE_TIME(true);
+    LOG_ENABLE_THREAD_ID(false);
+    LOG_ENABLE_FUNCTION(false);
+
+    if (!sConfigManager->SetFile(argc > 1 ? argv[1] : "replay.conf"))
+        return -1;
+
+    SteerStone::Core::Logger::Base::GetSingleton()->SetLogLevels(sConfigManager->GetString("LogLevel", "error"), sConfigManager->GetString("LogSystemLevels", ""));
+
+    /// Latencies are measured with FastClock
+    SteerStone::Core::Diagnostic::FastClock::Calibrate();
+
+    SteerStone::Replay::ReplaySettings l_Settings;
+    l_Settings.Load();
+
+    /// A capture given on the command line overrides the configuration file
+    if (argc > 2)
+        l_Settings.CaptureFile = argv[2];
+
+    SteerStone::Replay::Replayer l_Replayer(l_Settings);
+
+    /// Interrupting still writes the final report
+    std::signal(SIGINT, [](int) { SteerStone::Replay::Replayer::Stop(); });
+    std::signal(SIGTERM, [](int) { SteerStone::Replay::Replayer::Stop(); });
+
+    return l_Replayer.Run() ? 0 : -1;
+}
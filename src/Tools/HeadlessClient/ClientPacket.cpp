@@ -0,0 +1,86 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "ClientPacket.hpp"
+
+#include <algorithm>
+
+namespace SteerStone { namespace Headless {
+
+    /// Constructor
+    /// @p_Header : Header id
+    ClientPacket::ClientPacket(uint16 p_Header)
+        : m_Length(B64_LENGTH_SIZE)
+    {
+        AppendB64(p_Header);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Append VL64 integer
+    /// @p_Value : Value
+    ClientPacket& ClientPacket::AppendInt(int32 p_Value)
+    {
+        if (m_Length + VL64_MAX_SIZE <= sizeof(m_Data))
+            m_Length += Game::Server::Encoding::EncodeVL64(p_Value, m_Data + m_Length);
+
+        return *this;
+    }
+    /// Append B64 integer
+    /// @p_Value  : Value
+    /// @p_Length : Amount of bytes to encode into
+    ClientPacket& ClientPacket::AppendB64(uint32 p_Value, std::size_t p_Length)
+    {
+        if (m_Length + p_Length <= sizeof(m_Data))
+        {
+            Game::Server::Encoding::EncodeB64(p_Value, m_Data + m_Length, p_Length);
+            m_Length += p_Length;
+        }
+
+        return *this;
+    }
+    /// Append B64 length prefixed string, strings which do not fit are cut
+    /// @p_String : String
+    ClientPacket& ClientPacket::AppendString(std::string_view p_String)
+    {
+        if (m_Length + B64_STRING_LENGTH_SIZE > sizeof(m_Data))
+            return *this;
+
+        const std::size_t l_Length = std::min(p_String.size(), sizeof(m_Data) - m_Length - B64_STRING_LENGTH_SIZE);
+
+        AppendB64(static_cast<uint32>(l_Length), B64_STRING_LENGTH_SIZE);
+        std::copy(p_String.begin(), p_String.begin() + l_Length, m_Data + m_Length);
+        m_Length += l_Length;
+
+        return *this;
+    }
+
+    /// Write length header and get frame
+    char const* ClientPacket::GetData()
+    {
+        Game::Server::Encoding::EncodeB64(static_cast<uint32>(m_Length - B64_LENGTH_SIZE), m_Data, B64_LENGTH_SIZE);
+        return reinterpret_cast<char const*>(m_Data);
+    }
+    /// Get length of frame
+    std::size_t ClientPacket::GetLength() const
+    {
+        return m_Length;
+    }
+
+}   ///< namespace Headless
+}   ///< namespace SteerStone
@@ -0,0 +1,65 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include <Precompiled.hpp>
+#include <string_view>
+
+#include "Core/Core.hpp"
+#include "Encoding.hpp"
+
+#define CLIENT_PACKET_MAX_SIZE      512     ///< Largest frame a headless client sends
+
+namespace SteerStone { namespace Headless {
+
+    /// Outgoing client frame, encoded on the stack
+    /// Layout is a 3 byte B64 length, a 2 byte B64 header id and the body, as GameSocket decodes it
+    class ClientPacket
+    {
+        DISALLOW_COPY_AND_ASSIGN(ClientPacket);
+
+        public:
+            /// Constructor
+            /// @p_Header : Header id
+            explicit ClientPacket(uint16 p_Header);
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Append VL64 integer
+            /// @p_Value : Value
+            ClientPacket& AppendInt(int32 p_Value);
+            /// Append B64 integer
+            /// @p_Value  : Value
+            /// @p_Length : Amount of bytes to encode into
+            ClientPacket& AppendB64(uint32 p_Value, std::size_t p_Length = B64_HEADER_SIZE);
+            /// Append B64 length prefixed string, strings which do not fit are cut
+            /// @p_String : String
+            ClientPacket& AppendString(std::string_view p_String);
+
+            /// Write length header and get frame
+            char const* GetData();
+            /// Get length of frame
+            std::size_t GetLength() const;
+
+        private:
+            uint8 m_Data[CLIENT_PACKET_MAX_SIZE];       ///< Frame
+            std::size_t m_Length;                       ///< Length of frame
+    };
+
+}   ///< namespace Headless
+}   ///< namespace SteerStone
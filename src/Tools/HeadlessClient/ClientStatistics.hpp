@@ -0,0 +1,90 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include <Precompiled.hpp>
+#include <atomic>
+
+#include "Core/Core.hpp"
+#include "Diagnostic/DiaHistogram.hpp"
+#include "Scenario.hpp"
+
+namespace SteerStone { namespace Headless {
+
+    /// Add to a counter which has a single writer, no locked instruction is needed
+    /// @p_Counter : Counter
+    /// @p_Value   : Amount to add
+    inline void AddCounter(std::atomic<uint64>& p_Counter, uint64 p_Value = 1)
+    {
+        p_Counter.store(p_Counter.load(std::memory_order_relaxed) + p_Value, std::memory_order_relaxed);
+    }
+
+    /// Statistics of a scripted action
+    struct ActionStatistics
+    {
+        /// Constructor
+        ActionStatistics()
+            : Sent(0), Replied(0), TimedOut(0)
+        {
+        }
+
+        /// Record answer of a message
+        /// @p_Latency : Nanoseconds between sending the message and recieving its answer
+        void RecordReply(uint64 p_Latency)
+        {
+            AddCounter(Replied);
+            Interval.Record(p_Latency);
+            Total.Record(p_Latency);
+        }
+
+        std::atomic<uint64> Sent;                       ///< Messages sent
+        std::atomic<uint64> Replied;                    ///< Messages answered
+        std::atomic<uint64> TimedOut;                   ///< Messages not answered within reply timeout
+        Core::Diagnostic::LatencyHistogram Interval;    ///< Latencies since last periodic report
+        Core::Diagnostic::LatencyHistogram Total;       ///< Latencies since start
+    };
+
+    /// Statistics of every client of a network thread, only written to by that network thread
+    struct ClientStatistics
+    {
+        DISALLOW_COPY_AND_ASSIGN(ClientStatistics);
+
+        /// Constructor
+        ClientStatistics()
+            : Connected(0), ConnectFailed(0), Disconnected(0), MessagesIn(0), BytesIn(0), MessagesOut(0), BytesOut(0)
+        {
+        }
+
+        /// Get statistics of action
+        /// @p_Action : Action
+        ActionStatistics& GetAction(ScriptAction p_Action)
+        {
+            return Actions[static_cast<uint8>(p_Action)];
+        }
+
+        std::atomic<uint64> Connected;                                          ///< Connections established
+        std::atomic<uint64> ConnectFailed;                                      ///< Connections which could not be established
+        std::atomic<uint64> Disconnected;                                       ///< Established connections closed by the server
+        std::atomic<uint64> MessagesIn;                                         ///< Messages recieved
+        std::atomic<uint64> BytesIn;                                            ///< Bytes recieved
+        std::atomic<uint64> MessagesOut;                                        ///< Messages sent, including pongs
+        std::atomic<uint64> BytesOut;                                           ///< Bytes sent
+        ActionStatistics Actions[static_cast<uint8>(ScriptAction::Max)];        ///< Statistics of every action
+    };
+
+}   ///< namespace Headless
+}   ///< namespace SteerStone
@@ -0,0 +1,321 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "HeadlessSocket.hpp"
+#include "Config/Config.hpp"
+#include "Diagnostic/DiaFastClock.hpp"
+#include "Utility/UtilRandom.hpp"
+#include "Opcodes/Opcodes.hpp"
+
+#include <cmath>
+#include <cstring>
+
+namespace SteerStone { namespace Headless {
+
+    std::atomic<bool> HeadlessSocket::s_Stopping(false);
+
+    /// Stop counting closed connections as disconnects, called before clients are shut down
+    void HeadlessSocket::SetStopping()
+    {
+        s_Stopping.store(true, std::memory_order_release);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    /// @p_Service      : Boost Service
+    /// @p_Owner        : Owner told once we are closed
+    HeadlessSocket::HeadlessSocket(boost::asio::io_service& p_Service, Core::Network::SocketOwner* p_Owner)
+        : Socket(p_Service, p_Owner), m_Scenario(nullptr), m_Statistics(nullptr), m_Index(0), m_State(ClientState::Connecting), m_ConnectTime(0)
+    {
+        for (int64& l_Next : m_NextAction)
+            l_Next = 0;
+
+        /// Every action of a step is written before anything is sent, like a real client does on its frame
+        Core::Network::FlushPolicySettings l_FlushPolicy;
+        l_FlushPolicy.Policy        = Core::Network::FlushPolicy::Tick;
+        l_FlushPolicy.ByteThreshold = 0;
+        l_FlushPolicy.Timeout       = 0;
+        SetFlushPolicy(l_FlushPolicy);
+
+        /// Our script runs on the ping timer, so timers of thousands of clients share the timer wheel of our network thread
+        static const Core::Configuration::ConfigHandle<uint32> sl_TickInterval("Headless.TickInterval", HEADLESS_TICK_INTERVAL);
+        SetPingInterval(sl_TickInterval.Get());
+        SetIdleTimeout(0);
+    }
+    /// Deconstructor
+    HeadlessSocket::~HeadlessSocket()
+    {
+        if (m_Statistics && m_State != ClientState::Connecting && !s_Stopping.load(std::memory_order_acquire))
+            AddCounter(m_Statistics->Disconnected);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Connect to server and start script, called once after socket has been created
+    /// @p_Scenario   : Scenario to run, must outlive us
+    /// @p_Statistics : Statistics of our network thread, must outlive us
+    /// @p_Index      : Index of client, used in its SSO ticket
+    /// @p_EndPoint   : Server
+    void HeadlessSocket::Connect(Scenario const* p_Scenario, ClientStatistics* p_Statistics, uint32 p_Index, boost::asio::ip::tcp::endpoint const& p_EndPoint)
+    {
+        m_Scenario      = p_Scenario;
+        m_Statistics    = p_Statistics;
+        m_Index         = p_Index;
+
+        /// Statistics are only written to by our network thread
+        std::shared_ptr<HeadlessSocket> l_Self = Shared<HeadlessSocket>();
+        boost::asio::post(GetAsioSocket().get_executor(), [l_Self, p_EndPoint]()
+        {
+            boost::system::error_code l_ErrorCode;
+            l_Self->GetAsioSocket().open(p_EndPoint.protocol(), l_ErrorCode);
+            if (l_ErrorCode)
+            {
+                AddCounter(l_Self->m_Statistics->ConnectFailed);
+                return;
+            }
+
+            l_Self->m_ConnectTime = Core::Diagnostic::FastClock::GetNanoseconds();
+            l_Self->GetAsioSocket().async_connect(p_EndPoint, [l_Self](boost::system::error_code const& p_ErrorCode)
+            {
+                l_Self->OnConnect(p_ErrorCode);
+            });
+        });
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Connection to server is established or failed
+    /// @p_ErrorCode : Result
+    void HeadlessSocket::OnConnect(boost::system::error_code const& p_ErrorCode)
+    {
+        /// Network thread is shutting down
+        if (p_ErrorCode == boost::asio::error::operation_aborted)
+            return;
+
+        if (p_ErrorCode || !Open())
+        {
+            LOG_VERBOSE("Headless", "Client %0 failed to connect: %1", m_Index, p_ErrorCode.message());
+
+            AddCounter(m_Statistics->ConnectFailed);
+            CloseSocket();
+            return;
+        }
+
+        ActionStatistics& l_Connect = m_Statistics->GetAction(ScriptAction::Connect);
+        AddCounter(l_Connect.Sent);
+        l_Connect.RecordReply(static_cast<uint64>(Core::Diagnostic::FastClock::GetNanoseconds() - m_ConnectTime));
+
+        AddCounter(m_Statistics->Connected);
+
+        m_State = ClientState::LoggingIn;
+
+        ClientPacket l_Packet(m_Scenario->GetAction(ScriptAction::Login).Header);
+        l_Packet.AppendString(Core::Utils::StringBuilder(m_Scenario->TicketFormat, m_Index));
+        SendAction(ScriptAction::Login, l_Packet);
+    }
+    /// Decode server messages, each ends with SERVER_MESSAGE_TERMINATOR
+    Core::Network::ProcessState HeadlessSocket::ProcessIncomingData()
+    {
+        for (;;)
+        {
+            Core::Network::PacketView l_View = InView();
+
+            uint8 const* l_End = static_cast<uint8 const*>(std::memchr(l_View.GetData(), SERVER_MESSAGE_TERMINATOR, l_View.GetLength()));
+            if (!l_End)
+                return Core::Network::ProcessState::Successful;
+
+            const std::size_t l_FrameLength = static_cast<std::size_t>(l_End - l_View.GetData()) + 1;
+
+            uint32 l_Header = 0;
+            if (l_FrameLength <= B64_HEADER_SIZE || !Game::Server::Encoding::DecodeB64(l_View.GetData(), B64_HEADER_SIZE, l_Header))
+            {
+                LOG_WARNING("Headless", "Client %0 recieved malformed message, closing", m_Index);
+                return Core::Network::ProcessState::Error;
+            }
+
+            AddCounter(m_Statistics->MessagesIn);
+            AddCounter(m_Statistics->BytesIn, l_FrameLength);
+
+            ProcessServerMessage(static_cast<uint16>(l_Header));
+
+            ReadSkip(l_FrameLength);
+        }
+    }
+    /// Handle decoded server message
+    /// @p_Header : Header id
+    void HeadlessSocket::ProcessServerMessage(uint16 p_Header)
+    {
+        if (p_Header == Game::Server::SERVER_PING)
+        {
+            ClientPacket l_Pong(Game::Server::CLIENT_PONG);
+            SendPacket(l_Pong);
+        }
+
+        /// Answers of one kind come back in the order their messages were sent
+        for (auto l_Itr = m_PendingReplies.begin(); l_Itr != m_PendingReplies.end(); ++l_Itr)
+        {
+            if (l_Itr->Reply != p_Header)
+                continue;
+
+            const ScriptAction l_Action = l_Itr->Action;
+            m_Statistics->GetAction(l_Action).RecordReply(static_cast<uint64>(Core::Diagnostic::FastClock::GetNanoseconds() - l_Itr->Time));
+            m_PendingReplies.erase(l_Itr);
+
+            OnActionDone(l_Action);
+            break;
+        }
+    }
+    /// Run next step of our script, see HEADLESS_TICK_INTERVAL
+    void HeadlessSocket::OnPingTimer()
+    {
+        const int64 l_Now = Core::Diagnostic::FastClock::GetNanoseconds();
+
+        ExpirePendingReplies(l_Now);
+
+        if (m_State != ClientState::InRoom)
+            return;
+
+        static const ScriptAction sl_Repeated[] = { ScriptAction::Walk, ScriptAction::Chat, ScriptAction::Trade };
+        for (ScriptAction l_Action : sl_Repeated)
+        {
+            if (m_Scenario->GetAction(l_Action).Rate <= 0.0f || l_Now < m_NextAction[static_cast<uint8>(l_Action)])
+                continue;
+
+            SendRepeatedAction(l_Action);
+            ScheduleAction(l_Action, l_Now);
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Send frame
+    /// @p_Packet : Frame
+    void HeadlessSocket::SendPacket(ClientPacket& p_Packet)
+    {
+        Write(p_Packet.GetData(), p_Packet.GetLength());
+
+        AddCounter(m_Statistics->MessagesOut);
+        AddCounter(m_Statistics->BytesOut, p_Packet.GetLength());
+    }
+    /// Send frame of a scripted action and wait for its answer
+    /// @p_Action : Action
+    /// @p_Packet : Frame
+    void HeadlessSocket::SendAction(ScriptAction p_Action, ClientPacket& p_Packet)
+    {
+        SendPacket(p_Packet);
+        AddCounter(m_Statistics->GetAction(p_Action).Sent);
+
+        const uint16 l_Reply = m_Scenario->GetAction(p_Action).Reply;
+        if (!l_Reply)
+        {
+            OnActionDone(p_Action);
+            return;
+        }
+
+        if (m_PendingReplies.size() >= HEADLESS_MAX_PENDING_REPLIES)
+        {
+            AddCounter(m_Statistics->GetAction(m_PendingReplies.front().Action).TimedOut);
+            m_PendingReplies.pop_front();
+        }
+
+        m_PendingReplies.push_back(PendingReply{ p_Action, l_Reply, Core::Diagnostic::FastClock::GetNanoseconds() });
+    }
+    /// Send next message of a repeated action
+    /// @p_Action : Action
+    void HeadlessSocket::SendRepeatedAction(ScriptAction p_Action)
+    {
+        ClientPacket l_Packet(m_Scenario->GetAction(p_Action).Header);
+
+        switch (p_Action)
+        {
+            case ScriptAction::Walk:
+                l_Packet.AppendB64(Core::Utils::UInt32Random(0, m_Scenario->WalkWidth - 1));
+                l_Packet.AppendB64(Core::Utils::UInt32Random(0, m_Scenario->WalkHeight - 1));
+                break;
+            case ScriptAction::Chat:
+                l_Packet.AppendString(m_Scenario->ChatMessage);
+                break;
+            case ScriptAction::Trade:
+                l_Packet.AppendString(Core::Utils::StringBuilder(m_Scenario->TicketFormat, Core::Utils::UInt32Random(0, m_Scenario->Clients - 1)));
+                break;
+            default:
+                return;
+        }
+
+        SendAction(p_Action, l_Packet);
+    }
+    /// Pick when a repeated action is sent next, intervals are exponential so clients do not act in lockstep
+    /// @p_Action : Action
+    /// @p_Now    : Nanoseconds
+    void HeadlessSocket::ScheduleAction(ScriptAction p_Action, int64 p_Now)
+    {
+        const double l_Mean = 60.0 * 1000000000.0 / static_cast<double>(m_Scenario->GetAction(p_Action).Rate);
+        m_NextAction[static_cast<uint8>(p_Action)] = p_Now + static_cast<int64>(-std::log(1.0 - Core::Utils::DoubleRandom()) * l_Mean);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// An action of our script has been answered or timed out
+    /// @p_Action : Action
+    void HeadlessSocket::OnActionDone(ScriptAction p_Action)
+    {
+        if (p_Action == ScriptAction::Login && m_State == ClientState::LoggingIn)
+        {
+            m_State = ClientState::EnteringRoom;
+
+            ClientPacket l_Packet(m_Scenario->GetAction(ScriptAction::EnterRoom).Header);
+            l_Packet.AppendInt(m_Scenario->RoomId);
+            SendAction(ScriptAction::EnterRoom, l_Packet);
+        }
+        else if (p_Action == ScriptAction::EnterRoom && m_State == ClientState::EnteringRoom)
+        {
+            m_State = ClientState::InRoom;
+
+            const int64 l_Now = Core::Diagnostic::FastClock::GetNanoseconds();
+            for (uint8 l_I = 0; l_I < static_cast<uint8>(ScriptAction::Max); l_I++)
+            {
+                if (m_Scenario->Actions[l_I].Rate > 0.0f)
+                    ScheduleAction(static_cast<ScriptAction>(l_I), l_Now);
+            }
+        }
+    }
+    /// Count messages which have not been answered within the reply timeout
+    /// @p_Now : Nanoseconds
+    void HeadlessSocket::ExpirePendingReplies(int64 p_Now)
+    {
+        const int64 l_Timeout = static_cast<int64>(m_Scenario->ReplyTimeout) * 1000000;
+
+        while (!m_PendingReplies.empty() && p_Now - m_PendingReplies.front().Time > l_Timeout)
+        {
+            /// A server which never answers still gets the rest of our script
+            const ScriptAction l_Action = m_PendingReplies.front().Action;
+
+            AddCounter(m_Statistics->GetAction(l_Action).TimedOut);
+            m_PendingReplies.pop_front();
+
+            OnActionDone(l_Action);
+        }
+    }
+
+}   ///< namespace Headless
+}   ///< namespace SteerStone
@@ -0,0 +1,129 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include <Precompiled.hpp>
+#include <atomic>
+#include <deque>
+
+#include "Network/Socket.hpp"
+#include "ClientPacket.hpp"
+#include "ClientStatistics.hpp"
+#include "Scenario.hpp"
+
+#define HEADLESS_MAX_PENDING_REPLIES    64      ///< Messages awaiting their answer per client, the oldest counts as timed out past this
+#define HEADLESS_TICK_INTERVAL          100     ///< Default milliseconds between two steps of the script
+
+namespace SteerStone { namespace Headless {
+
+    /// Where a client is in its script
+    enum class ClientState
+    {
+        Connecting,     ///< TCP connection is not established yet
+        LoggingIn,      ///< SSO ticket sent
+        EnteringRoom,   ///< Room entry sent
+        InRoom          ///< Walking, chatting and trading
+    };
+
+    /// Simulated Habbo client, runs its script on the network thread it was created on
+    class HeadlessSocket : public Core::Network::Socket
+    {
+        DISALLOW_COPY_AND_ASSIGN(HeadlessSocket);
+
+        /// Message awaiting its answer
+        struct PendingReply
+        {
+            ScriptAction Action;        ///< Action which sent message
+            uint16 Reply;               ///< Header id of answer
+            int64 Time;                 ///< Nanoseconds message was sent at
+        };
+
+        public:
+            /// Stop counting closed connections as disconnects, called before clients are shut down
+            static void SetStopping();
+
+        public:
+            /// Constructor
+            /// @p_Service      : Boost Service
+            /// @p_Owner        : Owner told once we are closed
+            HeadlessSocket(boost::asio::io_service& p_Service, Core::Network::SocketOwner* p_Owner);
+            /// Deconstructor
+            ~HeadlessSocket();
+
+        //////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////////////////////////////////////
+
+        public:
+            /// Connect to server and start script, called once after socket has been created
+            /// @p_Scenario   : Scenario to run, must outlive us
+            /// @p_Statistics : Statistics of our network thread, must outlive us
+            /// @p_Index      : Index of client, used in its SSO ticket
+            /// @p_EndPoint   : Server
+            void Connect(Scenario const* p_Scenario, ClientStatistics* p_Statistics, uint32 p_Index, boost::asio::ip::tcp::endpoint const& p_EndPoint);
+
+        //////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////////////////////////////////////
+
+        private:
+            /// Decode server messages, each ends with SERVER_MESSAGE_TERMINATOR
+            virtual Core::Network::ProcessState ProcessIncomingData() override;
+            /// Run next step of our script, see HEADLESS_TICK_INTERVAL
+            virtual void OnPingTimer() override;
+
+            /// Connection to server is established or failed
+            /// @p_ErrorCode : Result
+            void OnConnect(boost::system::error_code const& p_ErrorCode);
+            /// Handle decoded server message
+            /// @p_Header : Header id
+            void ProcessServerMessage(uint16 p_Header);
+
+            /// Send frame
+            /// @p_Packet : Frame
+            void SendPacket(ClientPacket& p_Packet);
+            /// Send frame of a scripted action and wait for its answer
+            /// @p_Action : Action
+            /// @p_Packet : Frame
+            void SendAction(ScriptAction p_Action, ClientPacket& p_Packet);
+            /// Send next message of a repeated action
+            /// @p_Action : Action
+            void SendRepeatedAction(ScriptAction p_Action);
+            /// Pick when a repeated action is sent next, intervals are exponential so clients do not act in lockstep
+            /// @p_Action : Action
+            /// @p_Now    : Nanoseconds
+            void ScheduleAction(ScriptAction p_Action, int64 p_Now);
+
+            /// An action of our script has been answered or timed out
+            /// @p_Action : Action
+            void OnActionDone(ScriptAction p_Action);
+            /// Count messages which have not been answered within the reply timeout
+            /// @p_Now : Nanoseconds
+            void ExpirePendingReplies(int64 p_Now);
+
+        private:
+            static std::atomic<bool> s_Stopping;                                ///< Clients are being shut down
+
+            Scenario const* m_Scenario;                                         ///< Scenario we run
+            ClientStatistics* m_Statistics;                                     ///< Statistics of our network thread
+            uint32 m_Index;                                                     ///< Index of client
+            ClientState m_State;                                                ///< Where we are in our script
+            int64 m_ConnectTime;                                                ///< Nanoseconds connect started at
+            std::deque<PendingReply> m_PendingReplies;                          ///< Messages awaiting their answer, oldest first
+            int64 m_NextAction[static_cast<uint8>(ScriptAction::Max)];          ///< Nanoseconds each repeated action is sent next at
+    };
+
+}   ///< namespace Headless
+}   ///< namespace SteerStone
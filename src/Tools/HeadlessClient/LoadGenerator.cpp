@@ -0,0 +1,302 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "LoadGenerator.hpp"
+#include "HeadlessSocket.hpp"
+#include "Utility/UtilRandom.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+namespace SteerStone { namespace Headless {
+
+    std::atomic<bool> LoadGenerator::s_Stop(false);
+
+    /// Convert nanoseconds to milliseconds for reports
+    /// @p_Nanoseconds : Nanoseconds
+    static double ToMilliseconds(uint64 p_Nanoseconds)
+    {
+        return static_cast<double>(p_Nanoseconds) / 1000000.0;
+    }
+    /// Log measurements of an action
+    /// @p_Settings : Settings of action
+    /// @p_Rate     : Messages sent per second
+    /// @p_Replied  : Messages answered
+    /// @p_TimedOut : Messages timed out
+    /// @p_Latency  : Latencies of answered messages
+    static void LogAction(ActionSettings const& p_Settings, double p_Rate, uint64 p_Replied, uint64 p_TimedOut, Core::Diagnostic::LatencyHistogram const& p_Latency)
+    {
+        if (!p_Settings.Reply && p_Latency.GetCount() == 0)
+        {
+            LOG_INFO("Headless", "  %0: %1/s sent, no answer configured", p_Settings.Name, p_Rate);
+            return;
+        }
+
+        LOG_INFO("Headless", "  %0: %1/s sent, %2 answered, %3 timed out, p50 %4 ms, p99 %5 ms, p99.9 %6 ms, max %7 ms", p_Settings.Name, p_Rate, p_Replied, p_TimedOut,
+            ToMilliseconds(p_Latency.GetP50()), ToMilliseconds(p_Latency.GetP99()), ToMilliseconds(p_Latency.GetP999()), ToMilliseconds(p_Latency.GetMax()));
+    }
+
+    /// Stop run, safe to call from a signal handler
+    void LoadGenerator::Stop()
+    {
+        s_Stop.store(true, std::memory_order_release);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    /// @p_Scenario : Scenario to run, must outlive us
+    LoadGenerator::LoadGenerator(Scenario const& p_Scenario)
+        : m_Scenario(p_Scenario), m_NetworkThreads(static_cast<uint8>(p_Scenario.NetworkThreads))
+    {
+        for (std::size_t l_I = 0; l_I < m_NetworkThreads.GetThreadCount(); l_I++)
+            m_Statistics.push_back(std::unique_ptr<ClientStatistics>(new ClientStatistics()));
+
+        Collect(m_LastTotals);
+    }
+    /// Deconstructor
+    LoadGenerator::~LoadGenerator()
+    {
+        /// Clients closed by our network threads on shut down did not get disconnected
+        HeadlessSocket::SetStopping();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Ramp up clients and run scenario, returns once its duration elapsed or Stop has been called
+    /// Returns false if the server address is malformed
+    bool LoadGenerator::Run()
+    {
+        boost::system::error_code l_ErrorCode;
+        const boost::asio::ip::address l_Address = boost::asio::ip::address::from_string(m_Scenario.Host, l_ErrorCode);
+        if (l_ErrorCode)
+        {
+            LOG_ERROR("Headless", "Headless.Host %0 is not an IP address", m_Scenario.Host);
+            return false;
+        }
+
+        m_EndPoint = boost::asio::ip::tcp::endpoint(l_Address, m_Scenario.Port);
+
+        /// Each network thread draws from its own generator, a fixed seed replays the same walks and trades
+        if (m_Scenario.Seed)
+        {
+            for (std::size_t l_I = 0; l_I < m_NetworkThreads.GetThreadCount(); l_I++)
+            {
+                const uint32 l_Seed = m_Scenario.Seed + static_cast<uint32>(l_I);
+                boost::asio::post(m_NetworkThreads.GetThread(l_I)->GetIOService(), [l_Seed]() { Core::Utils::SeedRandom(l_Seed); });
+            }
+        }
+
+        LOG_INFO("Headless", "Connecting %0 clients to %1:%2 at %3 per second over %4 network threads", m_Scenario.Clients, m_Scenario.Host, m_Scenario.Port, m_Scenario.ConnectRate, m_NetworkThreads.GetThreadCount());
+
+        const std::chrono::steady_clock::time_point l_Start = std::chrono::steady_clock::now();
+        std::chrono::steady_clock::time_point l_LastReport  = l_Start;
+        std::chrono::steady_clock::time_point l_RampedUp    = l_Start;
+
+        uint32 l_Created = 0;
+        bool l_Ramping   = true;
+
+        while (!s_Stop.load(std::memory_order_acquire))
+        {
+            const std::chrono::steady_clock::time_point l_Now = std::chrono::steady_clock::now();
+            const uint64 l_Elapsed = static_cast<uint64>(std::chrono::duration_cast<std::chrono::milliseconds>(l_Now - l_Start).count());
+
+            const uint64 l_Target = std::min<uint64>(m_Scenario.Clients, l_Elapsed * m_Scenario.ConnectRate / 1000 + 1);
+            while (l_Created < l_Target)
+                ConnectClient(l_Created++);
+
+            if (l_Ramping && l_Created == m_Scenario.Clients)
+            {
+                l_Ramping   = false;
+                l_RampedUp  = l_Now;
+
+                LOG_INFO("Headless", "Every client has been created after %0 ms", l_Elapsed);
+            }
+
+            if (l_Now - l_LastReport >= std::chrono::seconds(m_Scenario.ReportInterval))
+            {
+                Report(std::chrono::duration<double>(l_Now - l_LastReport).count());
+                l_LastReport = l_Now;
+            }
+
+            if (!l_Ramping && m_Scenario.Duration && l_Now - l_RampedUp >= std::chrono::seconds(m_Scenario.Duration))
+                break;
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(LOAD_GENERATOR_STEP));
+        }
+
+        ReportTotal(std::chrono::duration<double>(std::chrono::steady_clock::now() - l_Start).count());
+
+        return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Create a client on the next network thread and connect it
+    /// @p_Index : Index of client
+    void LoadGenerator::ConnectClient(uint32 p_Index)
+    {
+        /// Clients are dealt round robin instead of by load, so every run places them the same way
+        const std::size_t l_Thread = p_Index % m_NetworkThreads.GetThreadCount();
+
+        std::shared_ptr<HeadlessSocket> l_Socket = m_NetworkThreads.GetThread(l_Thread)->CreateSocket<HeadlessSocket>();
+        if (!l_Socket)
+        {
+            LOG_WARNING("Headless", "Network thread %0 could not hold client %1", l_Thread, p_Index);
+            return;
+        }
+
+        l_Socket->Connect(&m_Scenario, m_Statistics[l_Thread].get(), p_Index, m_EndPoint);
+    }
+    /// Add counters of every network thread together
+    /// @p_Totals : Output
+    void LoadGenerator::Collect(ClientTotals& p_Totals) const
+    {
+        p_Totals = ClientTotals();
+
+        for (std::unique_ptr<ClientStatistics> const& l_Statistics : m_Statistics)
+        {
+            p_Totals.Connected      += l_Statistics->Connected.load(std::memory_order_relaxed);
+            p_Totals.ConnectFailed  += l_Statistics->ConnectFailed.load(std::memory_order_relaxed);
+            p_Totals.Disconnected   += l_Statistics->Disconnected.load(std::memory_order_relaxed);
+            p_Totals.MessagesIn     += l_Statistics->MessagesIn.load(std::memory_order_relaxed);
+            p_Totals.BytesIn        += l_Statistics->BytesIn.load(std::memory_order_relaxed);
+            p_Totals.MessagesOut    += l_Statistics->MessagesOut.load(std::memory_order_relaxed);
+            p_Totals.BytesOut       += l_Statistics->BytesOut.load(std::memory_order_relaxed);
+
+            for (uint8 l_I = 0; l_I < static_cast<uint8>(ScriptAction::Max); l_I++)
+            {
+                p_Totals.Sent[l_I]      += l_Statistics->Actions[l_I].Sent.load(std::memory_order_relaxed);
+                p_Totals.Replied[l_I]   += l_Statistics->Actions[l_I].Replied.load(std::memory_order_relaxed);
+                p_Totals.TimedOut[l_I]  += l_Statistics->Actions[l_I].TimedOut.load(std::memory_order_relaxed);
+            }
+        }
+    }
+    /// Log what has been measured since last report, interval latencies are reset
+    /// @p_Seconds : Seconds since last report
+    void LoadGenerator::Report(double p_Seconds)
+    {
+        ClientTotals l_Totals;
+        Collect(l_Totals);
+
+        LOG_INFO("Headless", "%0 clients online, %1 failed to connect, %2 disconnected, out %3 msg/s %4 KB/s, in %5 msg/s %6 KB/s",
+            l_Totals.Connected - l_Totals.Disconnected, l_Totals.ConnectFailed, l_Totals.Disconnected,
+            (l_Totals.MessagesOut - m_LastTotals.MessagesOut) / p_Seconds, (l_Totals.BytesOut - m_LastTotals.BytesOut) / p_Seconds / 1024.0,
+            (l_Totals.MessagesIn - m_LastTotals.MessagesIn) / p_Seconds, (l_Totals.BytesIn - m_LastTotals.BytesIn) / p_Seconds / 1024.0);
+
+        for (uint8 l_I = 0; l_I < static_cast<uint8>(ScriptAction::Max); l_I++)
+        {
+            /// Samples recorded between our merge and the reset are dropped, a handful out of an interval
+            Core::Diagnostic::LatencyHistogram l_Latency;
+            for (std::unique_ptr<ClientStatistics> const& l_Statistics : m_Statistics)
+            {
+                l_Latency.Merge(l_Statistics->Actions[l_I].Interval);
+                l_Statistics->Actions[l_I].Interval.Reset();
+            }
+
+            const uint64 l_Sent = l_Totals.Sent[l_I] - m_LastTotals.Sent[l_I];
+            if (!l_Sent && !l_Latency.GetCount())
+                continue;
+
+            LogAction(m_Scenario.Actions[l_I], l_Sent / p_Seconds, l_Totals.Replied[l_I] - m_LastTotals.Replied[l_I], l_Totals.TimedOut[l_I] - m_LastTotals.TimedOut[l_I], l_Latency);
+        }
+
+        m_LastTotals = l_Totals;
+    }
+    /// Log what has been measured since start and write report file
+    /// @p_Seconds : Seconds since start
+    void LoadGenerator::ReportTotal(double p_Seconds)
+    {
+        ClientTotals l_Totals;
+        Collect(l_Totals);
+
+        std::unique_ptr<Core::Diagnostic::LatencyHistogram[]> l_Latencies(new Core::Diagnostic::LatencyHistogram[static_cast<uint8>(ScriptAction::Max)]);
+
+        LOG_INFO("Headless", "Ran for %0 s, %1 of %2 clients connected, %3 failed to connect, %4 disconnected, out %5 msg/s, in %6 msg/s",
+            p_Seconds, l_Totals.Connected, m_Scenario.Clients, l_Totals.ConnectFailed, l_Totals.Disconnected, l_Totals.MessagesOut / p_Seconds, l_Totals.MessagesIn / p_Seconds);
+
+        for (uint8 l_I = 0; l_I < static_cast<uint8>(ScriptAction::Max); l_I++)
+        {
+            for (std::unique_ptr<ClientStatistics> const& l_Statistics : m_Statistics)
+                l_Latencies[l_I].Merge(l_Statistics->Actions[l_I].Total);
+
+            if (l_Totals.Sent[l_I])
+                LogAction(m_Scenario.Actions[l_I], l_Totals.Sent[l_I] / p_Seconds, l_Totals.Replied[l_I], l_Totals.TimedOut[l_I], l_Latencies[l_I]);
+        }
+
+        if (!m_Scenario.ReportFile.empty())
+            WriteReportFile(l_Totals, l_Latencies.get(), p_Seconds);
+    }
+    /// Write report as JSON, so runs can be compared against each other
+    /// @p_Totals    : Counters since start
+    /// @p_Latencies : Latencies since start of every action
+    /// @p_Seconds   : Seconds since start
+    void LoadGenerator::WriteReportFile(ClientTotals const& p_Totals, Core::Diagnostic::LatencyHistogram const* p_Latencies, double p_Seconds)
+    {
+        std::ofstream l_File(m_Scenario.ReportFile, std::ios::out | std::ios::trunc);
+        if (!l_File.is_open())
+        {
+            LOG_ERROR("Headless", "Failed to open report file %0", m_Scenario.ReportFile);
+            return;
+        }
+
+        l_File << "{\n";
+        l_File << "  \"clients\": "                     << m_Scenario.Clients                   << ",\n";
+        l_File << "  \"network_threads\": "             << m_NetworkThreads.GetThreadCount()    << ",\n";
+        l_File << "  \"duration_seconds\": "            << p_Seconds                            << ",\n";
+        l_File << "  \"connected\": "                   << p_Totals.Connected                   << ",\n";
+        l_File << "  \"connect_failed\": "              << p_Totals.ConnectFailed               << ",\n";
+        l_File << "  \"disconnected\": "                << p_Totals.Disconnected                << ",\n";
+        l_File << "  \"messages_out_per_second\": "     << p_Totals.MessagesOut / p_Seconds     << ",\n";
+        l_File << "  \"messages_in_per_second\": "      << p_Totals.MessagesIn / p_Seconds      << ",\n";
+        l_File << "  \"bytes_out\": "                   << p_Totals.BytesOut                    << ",\n";
+        l_File << "  \"bytes_in\": "                    << p_Totals.BytesIn                     << ",\n";
+        l_File << "  \"actions\": [\n";
+
+        for (uint8 l_I = 0; l_I < static_cast<uint8>(ScriptAction::Max); l_I++)
+        {
+            ActionSettings const& l_Settings = m_Scenario.Actions[l_I];
+            Core::Diagnostic::LatencyHistogram const& l_Latency = p_Latencies[l_I];
+
+            l_File << "    {";
+            l_File << "\"name\": \""            << l_Settings.Name                      << "\", ";
+            l_File << "\"header\": "            << l_Settings.Header                    << ", ";
+            l_File << "\"reply\": "             << l_Settings.Reply                     << ", ";
+            l_File << "\"sent\": "              << p_Totals.Sent[l_I]                   << ", ";
+            l_File << "\"sent_per_second\": "   << p_Totals.Sent[l_I] / p_Seconds       << ", ";
+            l_File << "\"replied\": "           << p_Totals.Replied[l_I]                << ", ";
+            l_File << "\"timed_out\": "         << p_Totals.TimedOut[l_I]               << ", ";
+            l_File << "\"mean_ms\": "           << ToMilliseconds(l_Latency.GetMean())  << ", ";
+            l_File << "\"p50_ms\": "            << ToMilliseconds(l_Latency.GetP50())   << ", ";
+            l_File << "\"p99_ms\": "            << ToMilliseconds(l_Latency.GetP99())   << ", ";
+            l_File << "\"p999_ms\": "           << ToMilliseconds(l_Latency.GetP999())  << ", ";
+            l_File << "\"max_ms\": "            << ToMilliseconds(l_Latency.GetMax());
+            l_File << "}" << (l_I + 1 < static_cast<uint8>(ScriptAction::Max) ? "," : "") << "\n";
+        }
+
+        l_File << "  ]\n";
+        l_File << "}\n";
+
+        LOG_INFO("Headless", "Report written to %0", m_Scenario.ReportFile);
+    }
+
+}   ///< namespace Headless
+}   ///< namespace SteerStone
@@ -0,0 +1,100 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include <Precompiled.hpp>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "Network/NetworkThreadPool.hpp"
+#include "ClientStatistics.hpp"
+#include "Scenario.hpp"
+
+#define LOAD_GENERATOR_STEP     10      ///< Milliseconds between two connect batches while ramping up
+
+namespace SteerStone { namespace Headless {
+
+    /// Counters of every network thread added together
+    struct ClientTotals
+    {
+        uint64 Connected;                                                   ///< Connections established
+        uint64 ConnectFailed;                                               ///< Connections which could not be established
+        uint64 Disconnected;                                                ///< Established connections closed by the server
+        uint64 MessagesIn;                                                  ///< Messages recieved
+        uint64 BytesIn;                                                     ///< Bytes recieved
+        uint64 MessagesOut;                                                 ///< Messages sent
+        uint64 BytesOut;                                                    ///< Bytes sent
+        uint64 Sent[static_cast<uint8>(ScriptAction::Max)];                 ///< Messages sent per action
+        uint64 Replied[static_cast<uint8>(ScriptAction::Max)];              ///< Messages answered per action
+        uint64 TimedOut[static_cast<uint8>(ScriptAction::Max)];             ///< Messages timed out per action
+    };
+
+    /// Opens connections of headless clients over the network threads and reports what they measure
+    class LoadGenerator
+    {
+        DISALLOW_COPY_AND_ASSIGN(LoadGenerator);
+
+        public:
+            /// Stop run, safe to call from a signal handler
+            static void Stop();
+
+        public:
+            /// Constructor
+            /// @p_Scenario : Scenario to run, must outlive us
+            explicit LoadGenerator(Scenario const& p_Scenario);
+            /// Deconstructor
+            ~LoadGenerator();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Ramp up clients and run scenario, returns once its duration elapsed or Stop has been called
+            /// Returns false if the server address is malformed
+            bool Run();
+
+        private:
+            /// Create a client on the next network thread and connect it
+            /// @p_Index : Index of client
+            void ConnectClient(uint32 p_Index);
+            /// Add counters of every network thread together
+            /// @p_Totals : Output
+            void Collect(ClientTotals& p_Totals) const;
+            /// Log what has been measured since last report, interval latencies are reset
+            /// @p_Seconds : Seconds since last report
+            void Report(double p_Seconds);
+            /// Log what has been measured since start and write report file
+            /// @p_Seconds : Seconds since start
+            void ReportTotal(double p_Seconds);
+            /// Write report as JSON, so runs can be compared against each other
+            /// @p_Totals    : Counters since start
+            /// @p_Latencies : Latencies since start of every action
+            /// @p_Seconds   : Seconds since start
+            void WriteReportFile(ClientTotals const& p_Totals, Core::Diagnostic::LatencyHistogram const* p_Latencies, double p_Seconds);
+
+        private:
+            static std::atomic<bool> s_Stop;                                    ///< Run must stop
+
+            Scenario const& m_Scenario;                                         ///< Scenario we run
+            boost::asio::ip::tcp::endpoint m_EndPoint;                          ///< Server
+            std::vector<std::unique_ptr<ClientStatistics>> m_Statistics;        ///< Statistics of every network thread, outlives clients
+            Core::Network::NetworkThreadPool m_NetworkThreads;                  ///< Network threads clients run on
+            ClientTotals m_LastTotals;                                          ///< Counters at last report
+    };
+
+}   ///< namespace Headless
+}   ///< namespace SteerStone
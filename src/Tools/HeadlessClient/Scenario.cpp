@@ -0,0 +1,77 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "Scenario.hpp"
+#include "Config/Config.hpp"
+#include "Opcodes/Opcodes.hpp"
+
+namespace SteerStone { namespace Headless {
+
+    /// Read action settings
+    /// @p_Name   : Name in reports and configuration
+    /// @p_Header : Default header id sent
+    /// @p_Rate   : Default messages per client per minute
+    static ActionSettings LoadAction(char const* p_Name, uint16 p_Header, float p_Rate)
+    {
+        const std::string l_Prefix = std::string("Headless.") + p_Name;
+
+        ActionSettings l_Settings;
+        l_Settings.Name     = p_Name;
+        l_Settings.Header   = static_cast<uint16>(sConfigManager->GetInt(l_Prefix + ".Header", p_Header));
+        l_Settings.Reply    = static_cast<uint16>(sConfigManager->GetInt(l_Prefix + ".Reply", 0));
+        l_Settings.Rate     = sConfigManager->GetFloat(l_Prefix + ".Rate", p_Rate);
+
+        return l_Settings;
+    }
+
+    /// Read scenario from configuration file
+    void Scenario::Load()
+    {
+        Host            = sConfigManager->GetString("Headless.Host", "127.0.0.1");
+        Port            = static_cast<uint16>(sConfigManager->GetInt("Headless.Port", 37120));
+        Clients         = sConfigManager->GetInt("Headless.Clients", 1000);
+        ConnectRate     = std::max<int32>(1, sConfigManager->GetInt("Headless.ConnectRate", 200));
+        Duration        = sConfigManager->GetInt("Headless.Duration", 60);
+        NetworkThreads  = sConfigManager->GetInt("Headless.NetworkThreads", 0);
+        ReplyTimeout    = sConfigManager->GetInt("Headless.ReplyTimeout", 5000);
+        ReportInterval  = std::max<int32>(1, sConfigManager->GetInt("Headless.ReportInterval", 10));
+        ReportFile      = sConfigManager->GetString("Headless.ReportFile", "");
+        Seed            = sConfigManager->GetInt("Headless.Seed", 0);
+        TicketFormat    = sConfigManager->GetString("Headless.TicketFormat", "headless_%0");
+        RoomId          = sConfigManager->GetInt("Headless.RoomId", 1);
+        WalkWidth       = std::max<int32>(1, sConfigManager->GetInt("Headless.Walk.Width", 10));
+        WalkHeight      = std::max<int32>(1, sConfigManager->GetInt("Headless.Walk.Height", 10));
+        ChatMessage     = sConfigManager->GetString("Headless.Chat.Message", "Hello from a headless client");
+
+        /// Connect is not sent, it only holds the name of its latency report
+        Actions[static_cast<uint8>(ScriptAction::Connect)]      = ActionSettings{ "Connect", 0, 0, 0.0f };
+        Actions[static_cast<uint8>(ScriptAction::Login)]        = LoadAction("Login", Game::Server::CLIENT_SSO, 0.0f);
+        Actions[static_cast<uint8>(ScriptAction::EnterRoom)]    = LoadAction("EnterRoom", Game::Server::CLIENT_GOTO_FLAT, 0.0f);
+        Actions[static_cast<uint8>(ScriptAction::Walk)]         = LoadAction("Walk", Game::Server::CLIENT_MOVE, 12.0f);
+        Actions[static_cast<uint8>(ScriptAction::Chat)]         = LoadAction("Chat", Game::Server::CLIENT_CHAT, 2.0f);
+        Actions[static_cast<uint8>(ScriptAction::Trade)]        = LoadAction("Trade", Game::Server::CLIENT_TRADE_OPEN, 0.2f);
+    }
+
+    /// Get settings of action
+    /// @p_Action : Action
+    ActionSettings const& Scenario::GetAction(ScriptAction p_Action) const
+    {
+        return Actions[static_cast<uint8>(p_Action)];
+    }
+
+}   ///< namespace Headless
+}   ///< namespace SteerStone
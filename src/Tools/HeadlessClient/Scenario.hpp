@@ -0,0 +1,76 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include <Precompiled.hpp>
+#include <string>
+
+#include "Core/Core.hpp"
+
+namespace SteerStone { namespace Headless {
+
+    /// Scripted actions of a headless client
+    enum class ScriptAction : uint8
+    {
+        Connect,        ///< TCP connect, latency is the time until the connection is established
+        Login,          ///< SSO ticket, sent once connected
+        EnterRoom,      ///< Room entry, sent once logged in
+        Walk,           ///< Move to a random tile, repeated while in room
+        Chat,           ///< Chat message, repeated while in room
+        Trade,          ///< Trade request to another client, repeated while in room
+        Max
+    };
+
+    /// Settings of a scripted action
+    struct ActionSettings
+    {
+        std::string Name;       ///< Name in reports
+        uint16 Header;          ///< Header id sent
+        uint16 Reply;           ///< Header id the server answers with, 0 if no latency is measured
+        float Rate;             ///< Messages per client per minute while in room, repeated actions only
+    };
+
+    /// Behaviour of the load generator, read from the configuration file
+    struct Scenario
+    {
+        /// Read scenario from configuration file
+        void Load();
+
+        /// Get settings of action
+        /// @p_Action : Action
+        ActionSettings const& GetAction(ScriptAction p_Action) const;
+
+        std::string Host;                                                   ///< Address of the server
+        uint16 Port;                                                        ///< Port of the server
+        uint32 Clients;                                                     ///< Amount of clients to connect
+        uint32 ConnectRate;                                                 ///< Connections opened per second while ramping up
+        uint32 Duration;                                                    ///< Seconds to run once every client is connected, 0 to run until interrupted
+        uint32 NetworkThreads;                                              ///< Network threads clients are spread over, 0 for one per core
+        uint32 ReplyTimeout;                                                ///< Milliseconds after which an unanswered message counts as timed out
+        uint32 ReportInterval;                                              ///< Seconds between periodic reports
+        std::string ReportFile;                                             ///< File the final report is written to as JSON, empty to only log it
+        uint32 Seed;                                                        ///< Seed of every network thread, 0 for a random run
+        std::string TicketFormat;                                           ///< SSO ticket, %0 is replaced by the client index
+        int32 RoomId;                                                       ///< Room every client enters
+        uint32 WalkWidth;                                                   ///< Tiles walked to are below this x
+        uint32 WalkHeight;                                                  ///< Tiles walked to are below this y
+        std::string ChatMessage;                                            ///< Message clients chat
+        ActionSettings Actions[static_cast<uint8>(ScriptAction::Max)];      ///< Settings of every action
+    };
+
+}   ///< namespace Headless
+}   ///< namespace SteerStone
@@ -0,0 +1,54 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <Precompiled.hpp>
+#include <csignal>
+
+#include "Logger/Base.hpp"
+#include "Config/Config.hpp"
+#include "Diagnostic/DiaFastClock.hpp"
+#include "LoadGenerator.hpp"
+
+int main(int argc, char** argv)
+{
+    /// Log Enablers
+    LOG_ENABLE_TIME(true);
+    LOG_ENABLE_THREAD_ID(false);
+    LOG_ENABLE_FUNCTION(false);
+
+    if (!sConfigManager->SetFile(argc > 1 ? argv[1] : "headless.conf"))
+        return -1;
+
+    SteerStone::Core::Logger::Base::GetSingleton()->SetLogLevels(sConfigManager->GetString("LogLevel", "error"), sConfigManager->GetString("LogSystemLevels", ""));
+
+    /// Latencies are measured with FastClock
+    SteerStone::Core::Diagnostic::FastClock::Calibrate();
+
+    if (const int32 l_TaskWorkers = sConfigManager->GetInt("TaskWorkers", 0))
+        sThreadManager->SetWorkerCount(l_TaskWorkers);
+
+    SteerStone::Headless::Scenario l_Scenario;
+    l_Scenario.Load();
+
+    SteerStone::Headless::LoadGenerator l_Generator(l_Scenario);
+
+    /// Interrupting still writes the final report
+    std::signal(SIGINT, [](int) { SteerStone::Headless::LoadGenerator::Stop(); });
+    std::signal(SIGTERM, [](int) { SteerStone::Headless::LoadGenerator::Stop(); });
+
+    return l_Generator.Run() ? 0 : -1;
+}
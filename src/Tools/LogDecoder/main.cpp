@@ -0,0 +1,274 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <Precompiled.hpp>
+#include <memory>
+
+#include "Logger/LogBinaryAppender.hpp"
+#include "Logger/LogFormat.hpp"
+
+using namespace SteerStone::Core::Logger;
+
+/// Binary log reader
+class LogDecoder
+{
+    public:
+        /// Constructor
+        /// @p_File : Binary log
+        /// @p_Json : Output one JSON object per line instead of text
+        LogDecoder(FILE* p_File, bool p_Json)
+            : m_File(p_File), m_Json(p_Json), m_AnchorSteady(0), m_AnchorSystem(0)
+        {
+        }
+
+        /// Decode every entry to stdout
+        /// Returns false if the log is malformed
+        bool Run()
+        {
+            if (!ReadHeader())
+                return false;
+
+            uint8 l_Tag = 0;
+            while (Read(l_Tag))
+            {
+                bool l_Result = false;
+
+                switch (static_cast<LogBinaryTag>(l_Tag))
+                {
+                    case LogBinaryTag::String:
+                        l_Result = ReadString();
+                        break;
+                    case LogBinaryTag::Record:
+                        l_Result = ReadRecord();
+                        break;
+                    default:
+                        /// Appended runs start with a new header
+                        l_Result = l_Tag == LOG_BINARY_MAGIC[0] && ReadHeader(true);
+                        break;
+                }
+
+                if (!l_Result)
+                    return false;
+            }
+
+            return true;
+        }
+
+    private:
+        /// Read header of a run
+        /// @p_TagRead : First byte of the magic has already been read
+        bool ReadHeader(bool p_TagRead = false)
+        {
+            char l_Magic[LOG_BINARY_MAGIC_SIZE];
+            l_Magic[0] = LOG_BINARY_MAGIC[0];
+
+            const std::size_t l_Offset = p_TagRead ? 1 : 0;
+            if (fread(l_Magic + l_Offset, LOG_BINARY_MAGIC_SIZE - l_Offset, 1, m_File) != 1 || memcmp(l_Magic, LOG_BINARY_MAGIC, LOG_BINARY_MAGIC_SIZE) != 0)
+                return false;
+
+            /// Ids restart with every run
+            m_Strings.clear();
+            m_Formats.clear();
+
+            return Read(m_AnchorSteady) && Read(m_AnchorSystem);
+        }
+        /// Read an interned string
+        bool ReadString()
+        {
+            uint8 l_Kind = 0;
+            uint32 l_Id = 0;
+            uint32 l_Length = 0;
+
+            if (!Read(l_Kind) || !Read(l_Id) || !Read(l_Length))
+                return false;
+
+            auto l_String = std::make_unique<std::string>(l_Length, '\0');
+            if (l_Length && fread(&(*l_String)[0], l_Length, 1, m_File) != 1)
+                return false;
+
+            /// Formats point in their string, strings are kept where they are
+            if (static_cast<LogBinaryString>(l_Kind) == LogBinaryString::Format)
+                m_Formats.emplace(l_Id, std::make_unique<LogFormat>(l_String->c_str()));
+
+            m_Strings[l_Id] = std::move(l_String);
+            return true;
+        }
+        /// Read and output a record
+        bool ReadRecord()
+        {
+            uint64 l_Timestamp = 0;
+            uint64 l_ThreadId = 0;
+            uint8 l_Type = 0;
+            uint32 l_System = 0;
+            uint32 l_Format = 0;
+            uint32 l_Function = 0;
+            int32 l_Line = 0;
+            uint32 l_Count = 0;
+            uint32 l_Size = 0;
+
+            if (!Read(l_Timestamp) || !Read(l_ThreadId) || !Read(l_Type) || !Read(l_System) || !Read(l_Format)
+                || !Read(l_Function) || !Read(l_Line) || !Read(l_Count) || !Read(l_Size))
+                return false;
+
+            std::vector<uint8> l_Data(l_Size);
+            if (l_Size && fread(l_Data.data(), l_Size, 1, m_File) != 1)
+                return false;
+
+            LogArguments l_Arguments;
+            l_Arguments.Load(l_Data.data(), l_Size, l_Count);
+
+            std::string l_Message;
+            auto const l_Itr = m_Formats.find(l_Format);
+            if (l_Itr != m_Formats.end())
+                l_Arguments.Format(*l_Itr->second, l_Message);
+
+            const uint64 l_Wall = m_AnchorSystem + (l_Timestamp - m_AnchorSteady);
+            const std::string l_Time = FormatTime(l_Wall);
+
+            if (m_Json)
+            {
+                printf("{\"time\":\"%s\",\"timestamp\":%llu,\"thread\":%llu,\"level\":\"%s\",\"system\":\"%s\",\"function\":\"%s\",\"line\":%d,\"message\":\"%s\"}\n",
+                    l_Time.c_str(), static_cast<unsigned long long>(l_Wall), static_cast<unsigned long long>(l_ThreadId), GetLevelName(l_Type),
+                    Escape(GetString(l_System)).c_str(), Escape(GetString(l_Function)).c_str(), l_Line, Escape(l_Message).c_str());
+            }
+            else
+            {
+                printf("%s | Thread Id: %llu | %s::%d | [%s][%s] << %s\n", l_Time.c_str(), static_cast<unsigned long long>(l_ThreadId),
+                    GetString(l_Function).c_str(), l_Line, GetLevelName(l_Type), GetString(l_System).c_str(), l_Message.c_str());
+            }
+
+            return true;
+        }
+
+        //////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////////////////////////////////////
+
+        /// Read a value
+        /// @p_Value : Output
+        template<typename T> bool Read(T& p_Value)
+        {
+            return fread(&p_Value, sizeof(T), 1, m_File) == 1;
+        }
+        /// Get an interned string
+        /// @p_Id : String id
+        std::string const& GetString(uint32 p_Id) const
+        {
+            static const std::string sl_Unknown = "?";
+
+            auto const l_Itr = m_Strings.find(p_Id);
+            return l_Itr != m_Strings.end() ? *l_Itr->second : sl_Unknown;
+        }
+        /// Get name of a log type
+        /// @p_Type : Log type
+        static const char* GetLevelName(uint8 p_Type)
+        {
+            switch (static_cast<LogType>(p_Type))
+            {
+                case LogType::Info:     return "INFO";
+                case LogType::Warning:  return "WARNING";
+                case LogType::Error:    return "ERROR";
+                case LogType::Assert:   return "ASSERT";
+                case LogType::Verbose:  return "VERBOSE";
+            }
+
+            return "UNKNOWN";
+        }
+        /// Format wall clock time with milliseconds
+        /// @p_Wall : Wall clock nanoseconds since epoch
+        static std::string FormatTime(uint64 p_Wall)
+        {
+            time_t l_RawTime = static_cast<time_t>(p_Wall / 1000000000ull);
+            struct tm* l_TimeInfo = localtime(&l_RawTime);
+
+            char l_Time[32];
+            snprintf(l_Time, sizeof(l_Time), "%04d-%02d-%02d %02d:%02d:%02d.%03u", l_TimeInfo->tm_year + 1900, l_TimeInfo->tm_mon + 1, l_TimeInfo->tm_mday,
+                l_TimeInfo->tm_hour, l_TimeInfo->tm_min, l_TimeInfo->tm_sec, static_cast<uint32>(p_Wall / 1000000ull % 1000));
+
+            return l_Time;
+        }
+        /// Escape a string for JSON
+        /// @p_String : String to escape
+        static std::string Escape(std::string const& p_String)
+        {
+            std::string l_Result;
+            l_Result.reserve(p_String.size());
+
+            for (const char l_Char : p_String)
+            {
+                switch (l_Char)
+                {
+                    case '"':   l_Result += "\\\"";  break;
+                    case '\\':  l_Result += "\\\\";  break;
+                    case '\n':  l_Result += "\\n";   break;
+                    case '\r':  l_Result += "\\r";   break;
+                    case '\t':  l_Result += "\\t";   break;
+                    default:
+                        if (static_cast<unsigned char>(l_Char) < 0x20)
+                        {
+                            char l_Code[8];
+                            snprintf(l_Code, sizeof(l_Code), "\\u%04x", l_Char);
+                            l_Result += l_Code;
+                        }
+                        else
+                            l_Result += l_Char;
+                        break;
+                }
+            }
+
+            return l_Result;
+        }
+
+    private:
+        FILE* m_File;                                                       ///< Binary log
+        bool m_Json;                                                        ///< Output JSON
+        uint64 m_AnchorSteady;                                              ///< Steady clock anchor of current run
+        uint64 m_AnchorSystem;                                              ///< Wall clock anchor of current run
+        std::unordered_map<uint32, std::unique_ptr<std::string>> m_Strings; ///< Interned strings
+        std::unordered_map<uint32, std::unique_ptr<LogFormat>> m_Formats;   ///< Parsed formats
+};
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <binary log> [--json]\n", argv[0]);
+        return 1;
+    }
+
+    FILE* l_File = fopen(argv[1], "rb");
+    if (!l_File)
+    {
+        fprintf(stderr, "Can't open file \"%s\"\n", argv[1]);
+        return 1;
+    }
+
+    const bool l_Json = argc > 2 && strcmp(argv[2], "--json") == 0;
+
+    LogDecoder l_Decoder(l_File, l_Json);
+    const bool l_Result = l_Decoder.Run();
+
+    fclose(l_File);
+
+    if (!l_Result)
+    {
+        fprintf(stderr, "Binary log is malformed or truncated\n");
+        return 1;
+    }
+
+    return 0;
+}